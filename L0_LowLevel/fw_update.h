@@ -0,0 +1,113 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief In-application firmware update through a staging region of the flash memory.
+ *
+ * The 448K of flash memory after the bootloader is split in two halves: the program runs
+ * from the active half (see FLASH of loader.ld), and a new image is programmed into the
+ * staging half while the program keeps running.  Once the whole image is written and its
+ * CRC is checked by the caller, fw_update_commit() writes a header at the end of the staging
+ * region, and at the next boot, fw_update_apply() copies the staging region over the active
+ * one and resets the CPU to run the new image.
+ *
+ * @code
+ *      fw_update_begin(size);                  // Erases the staging region
+ *      while (...) {
+ *          fw_update_write(data, len);         // In order, until size bytes are written
+ *      }
+ *      if (fw_update_finish() &&
+ *          expected_crc == crc32_update(0, fw_update_get_image(), size) &&
+ *          fw_update_commit()) {
+ *          sys_reboot();                       // The new image runs after this
+ *      }
+ * @endcode
+ *
+ * The first sector of the program, which holds the startup code and fw_update_apply(), is
+ * copied last from the RAM, so if the power fails before then, the old startup code starts
+ * the copy again at the next boot.  Only a power failure during the copy of the first sector
+ * (about 100ms) leaves a program that does not boot, which can still be fixed by the bootloader.
+ *
+ * @warning The interrupts are disabled while each block is programmed (about 1ms), and
+ *          while each sector is erased by fw_update_begin() (about 100ms per sector).
+ */
+#ifndef FW_UPDATE_H__
+#define FW_UPDATE_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+#define FW_UPDATE_ACTIVE_ADDR       (64 * 1024)     ///< The program runs from here, after the bootloader
+#define FW_UPDATE_REGION_BYTES      (224 * 1024)    ///< The size of the active and the staging regions
+#define FW_UPDATE_STAGING_ADDR      (FW_UPDATE_ACTIVE_ADDR + FW_UPDATE_REGION_BYTES) ///< The new image is written here
+#define FW_UPDATE_WRITE_BYTES       256             ///< The bytes programmed at once
+#define FW_UPDATE_MAX_IMAGE_BYTES   (FW_UPDATE_REGION_BYTES - FW_UPDATE_WRITE_BYTES) ///< The header uses the last block
+
+
+
+/**
+ * Erases the staging region, and any image that was committed but not yet applied.
+ * @param size  The size of the new image in bytes
+ * @returns false if the size is too large, or the staging region could not be erased
+ */
+bool fw_update_begin(uint32_t size);
+
+/**
+ * Writes the next part of the image to the staging region.  The data is programmed
+ * in blocks of FW_UPDATE_WRITE_BYTES, so the last part may be held until fw_update_finish().
+ * @returns false if this is beyond the size given to fw_update_begin(), or the programming failed
+ */
+bool fw_update_write(const void *data, uint32_t len);
+
+/// @returns the bytes given to fw_update_write() since fw_update_begin()
+uint32_t fw_update_get_written(void);
+
+/**
+ * Programs the last part of the image.
+ * @returns false unless the whole image was written
+ */
+bool fw_update_finish(void);
+
+/// @returns the image in the staging region, so the caller can check its CRC after fw_update_finish()
+static inline const void* fw_update_get_image(void) { return (const void*) FW_UPDATE_STAGING_ADDR; }
+
+/**
+ * Checks the vector table of the staged image, and writes the header that makes the next boot
+ * apply the image.  Call this after fw_update_finish(), once the CRC of the image is checked.
+ * @returns false if the image does not look like a program of the active region
+ */
+bool fw_update_commit(void);
+
+/**
+ * Copies the committed image from the staging region to the active region, and resets the CPU.
+ * This returns without doing anything if there is no committed image.
+ * @note This is called by the startup code after the RAM is initialized; do not call it yourself.
+ */
+void fw_update_apply(void);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* FW_UPDATE_H__ */
@@ -1,185 +1,309 @@
-/*
- *     SocialLedge.com - Copyright (C) 2013
- *
- *     This file is part of free software framework for embedded processors.
- *     You can use it and/or distribute it as long as this copyright header
- *     remains unmodified.  The code is free for personal use and requires
- *     permission to use in a commercial product.
- *
- *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
- *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
- *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
- *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
- *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
- *
- *     You can reach the author of this software at :
- *          p r e e t . w i k i @ g m a i l . c o m
- */
-
-/**
- * @file
- * @brief  Provides the following system services :
- *              - Memory info of the system.
- *              - Configure function to use for printf/scanf
- *              - Get boot type and time
- *              - Watchdog
- *
- * 12082013 : Added functionality to see next heap pointer from mem_info_t
- */
-#ifndef LPC_SYS_H__
-#define LPC_SYS_H__
-#ifdef __cplusplus
-extern "C" {
-#endif
-#include <stdint.h>
-#include <stdbool.h>
-
-#include "LPC17xx.h"
-#include "rtc.h"
-#include "sys_config.h"
-
-
-
-/**
- * Enumeration of the reboot type
- */
-typedef enum {
-    boot_unknown  = 0,
-    boot_power_on = 1,      ///< Cold boot (power on)
-    boot_reset    = 2,      ///< Boot after reset condition
-    boot_watchdog = 4,      ///< Boot after watchdog reset (intentional)
-    boot_watchdog_recover,  ///< Boot after watchdog reset after an error (or crash)
-    boot_brown_out          ///< Boot after under-voltage
-} sys_boot_t;
-
-/**
- * This is the memory structure that is returned from sys_get_mem_info()
- * Heap memory obtains pool of memory from System, so the memory pool
- * not obtained by the Heap is listed by the systemAvailable variable.
- */
-typedef struct
-{
-    uint32_t used_global; ///< Global Memory allocated
-    uint32_t used_heap;   ///< Memory granted by Heap (malloc, new etc.)
-    uint32_t avail_heap;  ///< Memory available at Heap
-    uint32_t avail_sys;   ///< Memory available to Heap (from sbrk function)
-
-    uint32_t num_sbrk_calls;  ///< Number of calls to the sbrk() function
-    uint32_t last_sbrk_size;  ///< Last size requested from the sbrk() function
-    void*    last_sbrk_ptr;   ///< Last pointer given by the sbrk() function
-    void*    next_malloc_ptr; ///< The next pointer that will be returned to malloc() from sbrk()
-} sys_mem_t;
-
-/** Void function pointer */
-typedef void (*void_func_t)(void);
-
-/** Function pointer of a function returning a char and taking a char as parameter */
-typedef char (*char_func_t)(char);
-
-
-
-/** @{ Defined at system_init.c */
-sys_boot_t sys_get_boot_type();  ///< @returns the reboot reason as detected during system startup
-rtc_t      sys_get_boot_time();  ///< @returns the boot-time recorded in the system
-/** @} */
-
-
-
-/** @{ Defined at syscalls.c */
-/**
- * Sets the function used to output a char by printf() or stdio output functions
- * @param func  The function pointer to use to output a char
- */
-void sys_set_outchar_func(char_func_t func);
-
-/**
- * Sets the function used to input a char by scanf() or stdio input functions
- * @param func  The function pointer to use to get a char
- */
-void sys_set_inchar_func(char_func_t func);
-/** @} */
-
-
-
-/**
- * Sets up the system timer that drives the time needed to get uptime in ms and us
- * along with some background services.
- * @see SYS_CFG_SYS_TIMER at sys_config.h
- */
-void lpc_sys_setup_system_timer(void);
-
-/// @returns the system up time in microseconds
-uint64_t sys_get_uptime_us(void);
-
-/// @returns the system up time in milliseconds.
-static inline uint64_t sys_get_uptime_ms(void) { return sys_get_uptime_us() / 1000; }
-
-
-
-/**
- * Gets System Memory information
- * The information includes Global Memory usage, and dynamic memory usage.
- * This function is defined at memory.cpp
- * @returns MemoryInfoType structure
- */
-sys_mem_t sys_get_mem_info();
-
-/**
- * Prints memory information to the given buffer
- * The buffer needs to be at least 280 bytes
- */
-void sys_get_mem_info_str(char buffer[280]);
-
-
-
-/**
- * Watchdog feed resets the watchdog timeout.
- * Periodic feeds should keep the system running, if the  watchdog
- * feeds stop, system will reset after watchdog timeout.
- */
-static inline void sys_watchdog_feed()
-{
-    LPC_WDT->WDFEED = 0xAA;
-    LPC_WDT->WDFEED = 0x55;
-}
-
-/**
- * Resets the system immediately.
- */
-static inline void sys_reboot()
-{
-    /**
-     * From the datasheet:
-     * After writing 0xAA to WDFEED, access to any Watchdog register other than writing
-     * 0x55 to WDFEED causes an immediate reset/interrupt when the Watchdog is enabled.
-     */
-    LPC_WDT->WDFEED = 0xAA;
-    LPC_WDT->WDMOD = 0;
-}
-
-/**
- * Enables watchdog with reset mode according to SYS_CFG_WATCHDOG_TIMEOUT_MS macro's value
- */
-static inline void sys_watchdog_enable()
-{
-    /**
-     * 1 / (4Mhz/4) = Watchdog clock by default (WCLK)
-     * Therefore watchdog clock = 1Mhz = 1uS
-     * Each value of WDTC means 1uS
-     */
-    LPC_WDT->WDTC = SYS_CFG_WATCHDOG_TIMEOUT_MS * 1000;
-
-    /**
-     * Enable Watchdog and Watchdog reset enable
-     * Once enabled, this cannot be cleared
-     */
-    LPC_WDT->WDMOD = 3;
-    sys_watchdog_feed();
-}
-
-
-
-#ifdef __cplusplus
-}
-#endif
-#endif /* LPC_SYS_H__ */
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief  Provides the following system services :
+ *              - Memory info of the system.
+ *              - Configure function to use for printf/scanf
+ *              - Get boot type and time
+ *              - Watchdog
+ *
+ * 12082013 : Added functionality to see next heap pointer from mem_info_t
+ */
+#ifndef LPC_SYS_H__
+#define LPC_SYS_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "LPC17xx.h"
+#include "rtc.h"
+#include "sys_config.h"
+
+
+
+/**
+ * Enumeration of the reboot type
+ */
+typedef enum {
+    boot_unknown  = 0,
+    boot_power_on = 1,      ///< Cold boot (power on)
+    boot_reset    = 2,      ///< Boot after reset condition
+    boot_watchdog = 4,      ///< Boot after watchdog reset (intentional)
+    boot_watchdog_recover,  ///< Boot after watchdog reset after an error (or crash)
+    boot_brown_out          ///< Boot after under-voltage
+} sys_boot_t;
+
+/**
+ * This is the memory structure that is returned from sys_get_mem_info()
+ * Heap memory obtains pool of memory from System, so the memory pool
+ * not obtained by the Heap is listed by the systemAvailable variable.
+ */
+typedef struct
+{
+    uint32_t used_global; ///< Global Memory allocated
+    uint32_t used_heap;   ///< Memory granted by Heap (malloc, new etc.)
+    uint32_t avail_heap;  ///< Memory available at Heap
+    uint32_t avail_sys;   ///< Memory available to Heap (from sbrk function)
+
+    uint32_t num_sbrk_calls;  ///< Number of calls to the sbrk() function
+    uint32_t last_sbrk_size;  ///< Last size requested from the sbrk() function
+    void*    last_sbrk_ptr;   ///< Last pointer given by the sbrk() function
+    void*    next_malloc_ptr; ///< The next pointer that will be returned to malloc() from sbrk()
+} sys_mem_t;
+
+/** Void function pointer */
+typedef void (*void_func_t)(void);
+
+/** Function pointer of a function returning a char and taking a char as parameter */
+typedef char (*char_func_t)(char);
+
+/**
+ * Function pointer of a function that outputs a block of chars
+ * @param timeout_ms  The time to wait for the space of the output, or portMAX_DELAY to wait forever
+ * @returns the number of chars that were output
+ */
+typedef int (*block_func_t)(const char *data, int len, unsigned int timeout_ms);
+
+/** What to do with the output of a stream when the output device is full */
+typedef enum {
+    sys_out_drop  = 0,  ///< Drop the output that does not fit
+    sys_out_block = 1,  ///< Wait until all of the output is written
+    sys_out_wait  = 2,  ///< Wait up to the timeout, and then drop the output that does not fit
+} sys_out_policy_t;
+
+/** Counters of a stream written by the tasks through sys_set_outblock_func() */
+typedef struct {
+    uint32_t bytes_written;     ///< Bytes given to the output function
+    uint32_t bytes_dropped;     ///< Bytes dropped due to the policy
+    uint32_t unbuffered;        ///< Writes that were not buffered because all line buffers were in use
+} sys_out_stats_t;
+
+
+
+/** @{ Defined at system_init.c */
+sys_boot_t sys_get_boot_type();  ///< @returns the reboot reason as detected during system startup
+rtc_t      sys_get_boot_time();  ///< @returns the boot-time recorded in the system
+/** @} */
+
+
+
+/** @{ Defined at syscalls.c */
+/**
+ * Sets the function used to output a char by printf() or stdio output functions
+ * @param func  The function pointer to use to output a char
+ */
+void sys_set_outchar_func(char_func_t func);
+
+/**
+ * Sets the function used to input a char by scanf() or stdio input functions
+ * @param func  The function pointer to use to get a char
+ */
+void sys_set_inchar_func(char_func_t func);
+
+/**
+ * Sets the function used to output the blocks of chars written by the tasks to stdout and stderr.
+ * Until this is set, and from an ISR or before the OS starts, the chars are output by the
+ * function given to sys_set_outchar_func() one at a time.
+ */
+void sys_set_outblock_func(block_func_t func);
+
+/**
+ * Sets the overflow policy of stdout or stderr
+ * @param fd          STDOUT_FILENO or STDERR_FILENO
+ * @param timeout_ms  The timeout of sys_out_wait policy
+ */
+void sys_set_out_policy(int fd, sys_out_policy_t policy, unsigned int timeout_ms);
+
+/// @returns the counters of stdout or stderr (@param fd of STDOUT_FILENO or STDERR_FILENO)
+sys_out_stats_t sys_get_out_stats(int fd);
+
+/**
+ * Writes out the incomplete line of the calling task.  The lines are otherwise written out when
+ * they are complete, when the line buffer is full, or when the task reads stdin.
+ */
+void sys_out_flush(void);
+/** @} */
+
+
+
+/** @{ Defined at sys_clock.cpp */
+/**
+ * Callback of a CPU clock change, registered by sys_clock_add_listener().
+ * The drivers use this to re-program their clock dividers to keep their bit rates.
+ * @param arg         The argument given to sys_clock_add_listener()
+ * @param old_cpu_hz  The CPU clock before the change
+ * @param new_cpu_hz  The CPU clock after the change
+ */
+typedef void (*sys_clock_listener_t)(void *arg, unsigned int old_cpu_hz, unsigned int new_cpu_hz);
+
+/**
+ * Registers a function to call when sys_clock_set_cpu_scale() changes the CPU clock.
+ * The listeners are called with the interrupts disabled so they must be quick.
+ * @returns false if there is no more space for listeners (@see SYS_CLOCK_MAX_LISTENERS)
+ * @note Registering the same function and argument again does nothing.
+ */
+bool sys_clock_add_listener(sys_clock_listener_t func, void *arg);
+
+/**
+ * Divides the CPU clock set during boot-up, with the PLL left running.  This can be used to
+ * step down the CPU clock when the system is idle and back up when the system is busy.
+ * The flash accelerator, system timer, FreeRTOS tick and the drivers that registered
+ * with sys_clock_add_listener() (UART, SSP, I2C, ADC) are updated to match.
+ *
+ * @param scale  1 for the full speed, 2 for half of the speed, 4 for a quarter etc.
+ * @returns the new CPU clock, or 0 upon invalid scale (the clock remains unchanged)
+ *
+ * @code
+ *      sys_clock_set_cpu_scale(2);     // 100Mhz -> 50Mhz while idle
+ *      sys_clock_set_cpu_scale(1);     // Back to 100Mhz when busy
+ * @endcode
+ *
+ * @warning A byte being sent or received at the instant of the change may be corrupted, and the
+ *          peripherals without listeners (CAN, PWM, RIT, Timers) need to be initialized again.
+ * @note    The UART divider error grows at slower clocks (3% for 115200bps at 25Mhz).
+ */
+unsigned int sys_clock_set_cpu_scale(unsigned int scale);
+
+/// @returns the scale given to sys_clock_set_cpu_scale(), which is 1 after boot-up
+unsigned int sys_clock_get_cpu_scale(void);
+
+/**
+ * Puts the CPU in the Deep Sleep mode until an interrupt occurs, such as the RTC alarm
+ * (@see rtc_alarm.h) or a pin interrupt.  The oscillator and the PLL are stopped while
+ * sleeping, and started again with the same CPU scale before the interrupt runs.
+ *
+ * @warning The FreeRTOS tick and the timers stop during the sleep, so the OS time does not
+ *          advance.  Use this when only an interrupt has something to do, such as from the
+ *          idle hook of a device that is woken up by its RTC alarms.
+ */
+void sys_clock_deep_sleep(void);
+
+/**
+ * @returns the clock divider that keeps the clock rate of a peripheral at or below its
+ * rate before the CPU clock change.  This is a helper function for sys_clock_listener_t
+ */
+static inline uint32_t sys_clock_scale_divider(uint32_t div, unsigned int old_cpu_hz, unsigned int new_cpu_hz)
+{
+    return (uint32_t) (((uint64_t) div * new_cpu_hz + old_cpu_hz - 1) / old_cpu_hz);
+}
+/** @} */
+
+
+
+/**
+ * Sets up the system timer that drives the time needed to get uptime in ms and us
+ * along with some background services.
+ * @see SYS_CFG_SYS_TIMER at sys_config.h
+ */
+void lpc_sys_setup_system_timer(void);
+
+/// @returns the system up time in microseconds
+uint64_t sys_get_uptime_us(void);
+
+/// @returns the system up time in milliseconds.
+static inline uint64_t sys_get_uptime_ms(void) { return sys_get_uptime_us() / 1000; }
+
+/**
+ * @returns the CPU clock cycles counted by the DWT cycle counter, which is started by
+ * lpc_sys_setup_system_timer().  This is a single register read, but it wraps around every
+ * 2^32 cycles (about 43 seconds at 100Mhz), so only use the difference of two readings.
+ *
+ * @code
+ *      const uint32_t start = sys_get_cycles();
+ *      foo();
+ *      printf("foo() took %u ns\n", (unsigned) sys_cycles_to_ns(sys_get_cycles() - start));
+ * @endcode
+ */
+static inline uint32_t sys_get_cycles(void) { return *(volatile uint32_t*) 0xE0001004; /* DWT CYCCNT */ }
+
+/// @returns the nanoseconds of the CPU cycles, converted using sys_get_cpu_clock()
+uint64_t sys_cycles_to_ns(uint32_t cycles);
+
+
+
+/**
+ * Gets System Memory information
+ * The information includes Global Memory usage, and dynamic memory usage.
+ * This function is defined at memory.cpp
+ * @returns MemoryInfoType structure
+ */
+sys_mem_t sys_get_mem_info();
+
+/**
+ * Prints memory information to the given buffer
+ * The buffer needs to be at least 280 bytes
+ */
+void sys_get_mem_info_str(char buffer[280]);
+
+
+
+/**
+ * Watchdog feed resets the watchdog timeout.
+ * Periodic feeds should keep the system running, if the  watchdog
+ * feeds stop, system will reset after watchdog timeout.
+ */
+static inline void sys_watchdog_feed()
+{
+    LPC_WDT->WDFEED = 0xAA;
+    LPC_WDT->WDFEED = 0x55;
+}
+
+/**
+ * Resets the system immediately.
+ */
+static inline void sys_reboot()
+{
+    /**
+     * From the datasheet:
+     * After writing 0xAA to WDFEED, access to any Watchdog register other than writing
+     * 0x55 to WDFEED causes an immediate reset/interrupt when the Watchdog is enabled.
+     */
+    LPC_WDT->WDFEED = 0xAA;
+    LPC_WDT->WDMOD = 0;
+}
+
+/**
+ * Enables watchdog with reset mode according to SYS_CFG_WATCHDOG_TIMEOUT_MS macro's value
+ */
+static inline void sys_watchdog_enable()
+{
+    /**
+     * 1 / (4Mhz/4) = Watchdog clock by default (WCLK)
+     * Therefore watchdog clock = 1Mhz = 1uS
+     * Each value of WDTC means 1uS
+     */
+    LPC_WDT->WDTC = SYS_CFG_WATCHDOG_TIMEOUT_MS * 1000;
+
+    /**
+     * Enable Watchdog and Watchdog reset enable
+     * Once enabled, this cannot be cleared
+     */
+    LPC_WDT->WDMOD = 3;
+    sys_watchdog_feed();
+}
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* LPC_SYS_H__ */
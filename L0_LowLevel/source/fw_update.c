@@ -0,0 +1,294 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <string.h>
+
+#include "fw_update.h"
+#include "LPC17xx.h"
+#include "lpc_isr.h"    // RAMFUNC
+#include "sys_config.h" // sys_get_cpu_clock()
+
+
+
+/**
+ * @{ The IAP commands of the boot ROM.  The IAP uses the top 32 bytes of the 0x10000000 SRAM,
+ * so they are saved and restored around each command since the heap may use them.
+ */
+#define FW_IAP_ENTRY            0x1FFF1FF1
+#define FW_IAP_RAM_ADDR         0x10007FE0
+#define FW_IAP_RAM_WORDS        8
+#define FW_IAP_PREPARE          50
+#define FW_IAP_COPY_RAM         51
+#define FW_IAP_ERASE            52
+#define FW_IAP_SUCCESS          0
+/** @} */
+
+/// The sectors after the first 64K of the flash memory are 32K each
+#define FW_SECTOR_BYTES         (32 * 1024)
+
+/// Forces the inlining, so the functions used by fw_update_apply() are in the same section as the caller
+#define FW_INLINE               static inline __attribute__ ((always_inline))
+
+/// The header of a committed image, at the last block of the staging region
+typedef struct {
+    uint32_t magic;     ///< FW_UPDATE_MAGIC
+    uint32_t size;      ///< The size of the image
+    uint32_t size_inv;  ///< The inverse of the size
+} fw_update_hdr_t;
+
+#define FW_UPDATE_MAGIC         0x50555746  ///< "FWUP"
+#define FW_UPDATE_HDR           ((const fw_update_hdr_t*) (FW_UPDATE_STAGING_ADDR + FW_UPDATE_MAX_IMAGE_BYTES))
+
+static uint32_t g_fw_block[FW_UPDATE_WRITE_BYTES / 4];  ///< The block being programmed (the IAP copies from the RAM)
+static uint32_t g_fw_block_len = 0;     ///< The bytes of g_fw_block[] that are used
+static uint32_t g_fw_size = 0;          ///< The size of the image given to fw_update_begin()
+static uint32_t g_fw_written = 0;       ///< The bytes given to fw_update_write()
+static uint32_t g_fw_prog_addr = 0;     ///< The address of the next block to program
+static bool g_fw_ok = false;            ///< False if the programming failed
+
+
+
+FW_INLINE uint32_t fw_iap(uint32_t cmd, uint32_t p0, uint32_t p1, uint32_t p2, uint32_t p3)
+{
+    typedef void (*iap_func_t)(uint32_t *command, uint32_t *result);
+    volatile uint32_t *iap_ram = (volatile uint32_t*) FW_IAP_RAM_ADDR;
+    uint32_t command[5], result[5], saved[FW_IAP_RAM_WORDS];
+    uint32_t primask = 0;
+    uint32_t i = 0;
+
+    command[0] = cmd;
+    command[1] = p0;
+    command[2] = p1;
+    command[3] = p2;
+    command[4] = p3;
+
+    /* The flash cannot be read while it is programmed, so no interrupt may run from it */
+    __asm volatile ("mrs %0, primask \n cpsid i" : "=r" (primask) : : "memory");
+    for (i = 0; i < FW_IAP_RAM_WORDS; i++) {
+        saved[i] = iap_ram[i];
+    }
+
+    ((iap_func_t) FW_IAP_ENTRY)(command, result);
+
+    for (i = 0; i < FW_IAP_RAM_WORDS; i++) {
+        iap_ram[i] = saved[i];
+    }
+    __asm volatile ("msr primask, %0" : : "r" (primask) : "memory");
+
+    return result[0];
+}
+
+FW_INLINE uint32_t fw_sector_num(uint32_t addr)
+{
+    return 16 + (addr - FW_UPDATE_ACTIVE_ADDR) / FW_SECTOR_BYTES;
+}
+
+FW_INLINE bool fw_erase_sector(uint32_t sector, uint32_t khz)
+{
+    return (FW_IAP_SUCCESS == fw_iap(FW_IAP_PREPARE, sector, sector, 0, 0) &&
+            FW_IAP_SUCCESS == fw_iap(FW_IAP_ERASE, sector, sector, khz, 0));
+}
+
+FW_INLINE bool fw_program_block(uint32_t addr, const uint32_t *ram, uint32_t khz)
+{
+    const uint32_t sector = fw_sector_num(addr);
+    return (FW_IAP_SUCCESS == fw_iap(FW_IAP_PREPARE, sector, sector, 0, 0) &&
+            FW_IAP_SUCCESS == fw_iap(FW_IAP_COPY_RAM, addr, (uint32_t) ram, FW_UPDATE_WRITE_BYTES, khz));
+}
+
+/// Copies a sector of the staging region to the active region through the RAM block
+FW_INLINE void fw_copy_sector(uint32_t dst, uint32_t src, uint32_t khz)
+{
+    fw_erase_sector(fw_sector_num(dst), khz);
+
+    for (uint32_t offset = 0; offset < FW_SECTOR_BYTES; offset += FW_UPDATE_WRITE_BYTES) {
+        /* Volatile, so the compiler does not turn this into memcpy() which may not be in the first sector */
+        volatile uint32_t *block = g_fw_block;
+        const volatile uint32_t *pSrc = (const volatile uint32_t*) (src + offset);
+        for (uint32_t i = 0; i < FW_UPDATE_WRITE_BYTES / 4; i++) {
+            block[i] = pSrc[i];
+        }
+        fw_program_block(dst + offset, g_fw_block, khz);
+
+        /* Feed the watchdog in case the program before the reset enabled it */
+        LPC_WDT->WDFEED = 0xAA;
+        LPC_WDT->WDFEED = 0x55;
+    }
+}
+
+/// @returns the CPU clock in KHz from the clock registers, since the clock is not set up at boot
+FW_INLINE uint32_t fw_boot_clock_khz(void)
+{
+    const uint32_t clkSrc = LPC_SC->CLKSRCSEL & 0x03;
+    uint32_t khz = (CLOCK_SOURCE_EXTERNAL == clkSrc) ? (EXTERNAL_CLOCK / 1000) :
+                   (CLOCK_SOURCE_RTC == clkSrc)      ? (RTC_CLOCK / 1000 + 1) : (INTERNAL_CLOCK / 1000);
+
+    /* PLL0 is connected */
+    if (LPC_SC->PLL0STAT & (1 << 25)) {
+        const uint32_t m = (LPC_SC->PLL0STAT & 0x7FFF) + 1;
+        const uint32_t n = ((LPC_SC->PLL0STAT >> 16) & 0xFF) + 1;
+        khz = (2 * m * khz) / n;
+    }
+    return khz / ((LPC_SC->CCLKCFG & 0xFF) + 1);
+}
+
+/**
+ * Copies the first sector, which holds the startup code, and then erases the header so the image
+ * is not applied again.  This runs from the RAM since the flash code it would return to changes.
+ */
+RAMFUNC __attribute__ ((noreturn)) static void fw_update_apply_first_sector(uint32_t khz)
+{
+    fw_copy_sector(FW_UPDATE_ACTIVE_ADDR, FW_UPDATE_STAGING_ADDR, khz);
+    fw_erase_sector(fw_sector_num(FW_UPDATE_STAGING_ADDR + FW_UPDATE_REGION_BYTES - 1), khz);
+
+    SCB->AIRCR = (0x5FA << 16) | (1 << 2); // SYSRESETREQ
+    for (;;) {
+        ;
+    }
+}
+
+
+
+bool fw_update_begin(uint32_t size)
+{
+    const uint32_t khz = sys_get_cpu_clock() / 1000;
+    const uint32_t first = fw_sector_num(FW_UPDATE_STAGING_ADDR);
+    const uint32_t last = fw_sector_num(FW_UPDATE_STAGING_ADDR + FW_UPDATE_REGION_BYTES - 1);
+
+    g_fw_size = 0;
+    if (0 == size || size > FW_UPDATE_MAX_IMAGE_BYTES) {
+        return false;
+    }
+
+    /* Erase one sector at a time to keep the interrupts enabled in between */
+    g_fw_ok = true;
+    for (uint32_t sector = first; sector <= last && g_fw_ok; sector++) {
+        g_fw_ok = fw_erase_sector(sector, khz);
+    }
+
+    g_fw_size = size;
+    g_fw_written = 0;
+    g_fw_block_len = 0;
+    g_fw_prog_addr = FW_UPDATE_STAGING_ADDR;
+    return g_fw_ok;
+}
+
+/// Programs g_fw_block[], after filling its unused bytes with the erased value
+static bool fw_update_program(uint32_t addr)
+{
+    memset(((uint8_t*) g_fw_block) + g_fw_block_len, 0xFF, sizeof(g_fw_block) - g_fw_block_len);
+    g_fw_block_len = 0;
+
+    if (g_fw_ok) {
+        g_fw_ok = fw_program_block(addr, g_fw_block, sys_get_cpu_clock() / 1000);
+    }
+    return g_fw_ok;
+}
+
+bool fw_update_write(const void *data, uint32_t len)
+{
+    const uint8_t *bytes = (const uint8_t*) data;
+
+    if (!g_fw_ok || g_fw_written + len > g_fw_size) {
+        return false;
+    }
+
+    while (len > 0)
+    {
+        uint32_t chunk = sizeof(g_fw_block) - g_fw_block_len;
+        if (chunk > len) {
+            chunk = len;
+        }
+
+        memcpy(((uint8_t*) g_fw_block) + g_fw_block_len, bytes, chunk);
+        g_fw_block_len += chunk;
+        g_fw_written += chunk;
+        bytes += chunk;
+        len -= chunk;
+
+        if (sizeof(g_fw_block) == g_fw_block_len) {
+            if (!fw_update_program(g_fw_prog_addr)) {
+                return false;
+            }
+            g_fw_prog_addr += sizeof(g_fw_block);
+        }
+    }
+    return true;
+}
+
+uint32_t fw_update_get_written(void)
+{
+    return g_fw_written;
+}
+
+bool fw_update_finish(void)
+{
+    if (!g_fw_ok || 0 == g_fw_size || g_fw_written != g_fw_size) {
+        return false;
+    }
+    if (g_fw_block_len > 0) {
+        fw_update_program(g_fw_prog_addr);
+        g_fw_prog_addr += sizeof(g_fw_block);
+    }
+    return g_fw_ok;
+}
+
+bool fw_update_commit(void)
+{
+    const uint32_t *vectors = (const uint32_t*) fw_update_get_image();
+    const uint32_t sp = vectors[0];
+    const uint32_t reset = vectors[1];
+
+    if (!g_fw_ok || 0 == g_fw_size || g_fw_written != g_fw_size) {
+        return false;
+    }
+
+    /* The initial stack is in one of the RAMs, and the reset handler is the thumb code of the image */
+    const bool spOk = (sp > 0x10000000 && sp <= 0x10008000) || (sp > 0x2007C000 && sp <= 0x20084000);
+    const bool resetOk = (reset & 1) && reset >= FW_UPDATE_ACTIVE_ADDR && reset < FW_UPDATE_ACTIVE_ADDR + g_fw_size;
+    if (!spOk || !resetOk) {
+        return false;
+    }
+
+    fw_update_hdr_t *hdr = (fw_update_hdr_t*) g_fw_block;
+    memset(g_fw_block, 0xFF, sizeof(g_fw_block));
+    hdr->magic = FW_UPDATE_MAGIC;
+    hdr->size = g_fw_size;
+    hdr->size_inv = ~g_fw_size;
+
+    g_fw_block_len = sizeof(g_fw_block);
+    return fw_update_program((uint32_t) FW_UPDATE_HDR);
+}
+
+__attribute__ ((section(".after_vectors")))
+void fw_update_apply(void)
+{
+    const fw_update_hdr_t *hdr = FW_UPDATE_HDR;
+    if (FW_UPDATE_MAGIC != hdr->magic || hdr->size != ~(hdr->size_inv) ||
+        0 == hdr->size || hdr->size > FW_UPDATE_MAX_IMAGE_BYTES) {
+        return;
+    }
+
+    /* Copy all but the first sector, which holds this code, so this can start over after a power failure */
+    const uint32_t khz = fw_boot_clock_khz();
+    for (uint32_t offset = FW_SECTOR_BYTES; offset < hdr->size; offset += FW_SECTOR_BYTES) {
+        fw_copy_sector(FW_UPDATE_ACTIVE_ADDR + offset, FW_UPDATE_STAGING_ADDR + offset, khz);
+    }
+
+    fw_update_apply_first_sector(khz);
+}
@@ -27,6 +27,12 @@
 
 #include "lpc_sys.h"        // sys_reboot()
 #include "fault_registers.h"// FAULT registers to store upon crash
+#include "fw_update.h"      // fw_update_apply()
+#include "file_logger.h"    // logger_emergency_flush()
+#include "crash_snapshot.h" // crash_snapshot_save()
+#if (SYS_CFG_TRACE_RECORDS > 0)
+#include "os_trace.h"       // os_trace_isr()
+#endif
 
 
 
@@ -268,6 +274,9 @@ void isr_reset(void)
         }
     } while (0) ;
 
+    /* Apply a committed firmware update before any code beyond the first flash sector runs */
+    fw_update_apply();
+
     #if defined (__cplusplus)
         __libc_init_array();    // Call C++ library initialization
     #endif
@@ -360,6 +369,10 @@ static void isr_forwarder_routine(void)
      */
     const unsigned char isr_num = (*((unsigned char*) 0xE000ED04)) - 16; // (SCB->ICSR & 0xFF) - 16;
 
+#if (SYS_CFG_TRACE_RECORDS > 0)
+    os_trace_isr(os_trace_isrs, os_trace_isr_enter, isr_num + 16);
+#endif
+
     /* Lookup the function pointer we want to call and make the call */
     isr_func_t isr_to_service = g_isr_array[isr_num];
 
@@ -376,6 +389,10 @@ static void isr_forwarder_routine(void)
         isr_to_service();
     }
 
+#if (SYS_CFG_TRACE_RECORDS > 0)
+    os_trace_isr(os_trace_isrs, os_trace_isr_exit, isr_num + 16);
+#endif
+
     /* Inform FreeRTOS that we have exited the ISR */
     vRunTimeStatIsrExit();
 }
@@ -397,9 +414,18 @@ void isr_hard_fault(void)
 }
 
 __attribute__ ((section(".after_vectors"))) void isr_nmi(void)        { u0_dbg_put("NMI Fault\n"); while(1); }
-__attribute__ ((section(".after_vectors"))) void isr_mem_fault(void)  { u0_dbg_put("Mem Fault\n"); while(1); }
-__attribute__ ((section(".after_vectors"))) void isr_bus_fault(void)  { u0_dbg_put("BUS Fault\n"); while(1); }
-__attribute__ ((section(".after_vectors"))) void isr_usage_fault(void){ u0_dbg_put("Usage Fault\n"); while(1); }
+__attribute__ ((section(".after_vectors"))) void isr_mem_fault(void)
+{
+#if (1 == configUSE_STACK_GUARD)
+    /* Does not return if a task overflowed its stack */
+    vPortCheckStackGuardFault();
+#endif
+    u0_dbg_put("Mem Fault\n");
+    logger_emergency_flush();
+    while(1);
+}
+__attribute__ ((section(".after_vectors"))) void isr_bus_fault(void)  { u0_dbg_put("BUS Fault\n"); logger_emergency_flush(); while(1); }
+__attribute__ ((section(".after_vectors"))) void isr_usage_fault(void){ u0_dbg_put("Usage Fault\n"); logger_emergency_flush(); while(1); }
 __attribute__ ((section(".after_vectors"))) void isr_debug_mon(void)  { u0_dbg_put("DBGMON Fault\n"); while(1); }
 
 /// If an IRQ is not registered, we end up at this stub function
@@ -409,7 +435,13 @@ __attribute__ ((section(".after_vectors"))) void isr_default_handler(void) { u0_
 __attribute__ ((section(".after_vectors"))) void isr_sys_tick(void)
 {
     vRunTimeStatIsrEntry();
+#if (SYS_CFG_TRACE_RECORDS > 0)
+    os_trace_isr(os_trace_tick, os_trace_isr_enter, SysTick_IRQn + 16);
+#endif
     xPortSysTickHandler();
+#if (SYS_CFG_TRACE_RECORDS > 0)
+    os_trace_isr(os_trace_tick, os_trace_isr_exit, SysTick_IRQn + 16);
+#endif
     vRunTimeStatIsrExit();
 }
 
@@ -444,6 +476,11 @@ void isr_hard_fault_handler(unsigned long *hardfault_args)
     FAULT_LR = stacked_lr - 1;
     FAULT_PSR = stacked_psr;
 
+    /* The snapshot is saved first, before the trace records are changed by the flush */
+    crash_snapshot_save((const uint32_t*) hardfault_args);
+
+    /* Save the logs that are still in the RAM */
+    logger_emergency_flush();
     sys_reboot();
 
     /* Prevent compiler warnings */
@@ -5,13 +5,18 @@
 #include "core_cm3.h"     // __WFI();
 #include "utilities.h"
 #include "lpc_sys.h"
+#include "file_logger.h"    // logger_emergency_flush()
 
 
 void vApplicationIdleHook(void)
 {
 	// THIS FUNCTION MUST NOT BLOCK
+#if (0 == configUSE_TICKLESS_IDLE)
 	// Put CPU to IDLE here. RTOS will wake up CPU from OS timer interrupt.
 	__WFI(); // Wait for Event: Puts the CPU in low powered mode
+#endif
+	// With tickless idle, the IDLE task sleeps the CPU through portSUPPRESS_TICKS_AND_SLEEP()
+	// otherwise we would wake up at every tick here before the OS tick can be stopped.
 }
 
 void vApplicationStackOverflowHook( TaskHandle_t *pxTask, char *pcTaskName )
@@ -19,6 +24,7 @@ void vApplicationStackOverflowHook( TaskHandle_t *pxTask, char *pcTaskName )
     u0_dbg_put("HALTING SYSTEM: Stack overflow by task: ");
     u0_dbg_put((char*)pcTaskName);
     u0_dbg_put("\nTry increasing stack memory of this task.\n");
+    logger_emergency_flush();
 
 	delay_us(3000 * 1000);
 	sys_reboot();
@@ -37,6 +43,7 @@ void vApplicationTickHook( void )
 void vApplicationMallocFailedHook( void )
 {
     u0_dbg_put("HALTING SYSTEM: Your system ran out of memory (RAM)!\n");
+    logger_emergency_flush();
 
     delay_us(3000 * 1000);
     sys_reboot();
@@ -71,6 +71,21 @@
 #define configUSE_TICK_HOOK 		            0   ///< Every timer interrupt calls the tick function
 #define configUSE_MALLOC_FAILED_HOOK            1   ///< If memory runs out, the hook function is called
 
+/**
+ * Tickless idle stops the OS tick when all tasks are blocked, and the CPU sleeps until the
+ * next task timeout or any interrupt (ie: nordic wireless EINT).  The SysTick keeps counting
+ * during sleep mode so the OS time is corrected when the CPU wakes up.
+ * @note Deep-sleep is not used since it stops the PLL and the system timer (SYS_CFG_SYS_TIMER)
+ *       that provides the uptime and feeds the watchdog.
+ * @note The MPU port doesn't implement tickless idle.
+ */
+#if (SYS_CFG_TICKLESS_IDLE && !BUILD_CFG_MPU)
+#define configUSE_TICKLESS_IDLE                 1
+#else
+#define configUSE_TICKLESS_IDLE                 0
+#endif
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP   2   ///< Minimum idle ticks before the OS tick is stopped
+
 #define configCPU_CLOCK_HZ			            (SYS_CFG_DESIRED_CPU_CLK)
 #define configTICK_RATE_HZ			            ( 1000 )
 #define configENABLE_BACKWARD_COMPATIBILITY     0
@@ -102,11 +117,23 @@
  * 2 - Get from the pool defined by configTOTAL_HEAP_SIZE with free()
  * 3 - Just redirect FreeRTOS memory to malloc() and free()
  * 4 - Same as 2, but coalescencent blocks can be combined.
+ * 5 - Same as 4, but across the memory regions given to vPortDefineHeapRegions()
+ * 6 - Scheme 5 across both SRAM banks, with fixed size block pools for the small allocations.
+ *     malloc() and free() are redirected to this scheme too (see heap_6.c.inc)
  *
  * configTOTAL_HEAP_SIZE only matters when scheme 1, 2 or 4 is used above.
+ * configMEM_POOL_BLOCK_SIZES and configMEM_POOL_BLOCK_COUNTS are the block sizes (in ascending order)
+ * and the number of blocks of each pool of scheme 6, and configHEAP_STACK_RESERVE is the memory left
+ * at the end of the AHB SRAM for the main stack used by the interrupts.
+ * configMEM_PROFILE counts the memory of each call site of scheme 6 (see "meminfo detail")
  */
 #define configMEM_MANG_TYPE             3
 #define configTOTAL_HEAP_SIZE           ( ( size_t ) ( 24 * 1024 ) )
+#define configMEM_POOL_BLOCK_SIZES      { 16, 32, 96 }
+#define configMEM_POOL_BLOCK_COUNTS     { 32, 24, 16 }
+#define configHEAP_STACK_RESERVE        ( 1024 )
+#define configMEM_PROFILE               0
+#define configMEM_PROFILE_SITES         32
 /** @} */
 
 /* Stack size and utility functions */
@@ -121,7 +148,21 @@
 #define configMAX_TASK_NAME_LEN		            ( 8 )
 #define configUSE_16_BIT_TICKS                  0       ///< Use 16-bit ticks vs. 32-bits
 #define configIDLE_SHOULD_YIELD                 1       ///< See FreeRTOS documentation
+#define configRECORD_STACK_HIGH_ADDRESS         1       ///< Record the stack end for uxTaskGetStackSize()
+#define configUSE_TASK_NOTIFICATIONS            1       ///< ulTaskNotifyTake() and vTaskNotifyGiveFromISR() (see tasks_mod.h.inc)
+
+/**
+ * The MPU stack guard faults the moment a task writes the bottom of its stack, so the
+ * pattern check of configCHECK_FOR_STACK_OVERFLOW at each context switch is not needed.
+ * The MPU port uses the MPU for its own regions, so it always uses the pattern check.
+ */
+#if (SYS_CFG_STACK_GUARD && !BUILD_CFG_MPU)
+#define configUSE_STACK_GUARD                   1
+#define configCHECK_FOR_STACK_OVERFLOW          0       ///< 0=OFF, 1=Simple, 2=Complex
+#else
+#define configUSE_STACK_GUARD                   0
 #define configCHECK_FOR_STACK_OVERFLOW          2       ///< 0=OFF, 1=Simple, 2=Complex
+#endif
 #define configUSE_ALTERNATIVE_API               0       ///< No need to use deprecated API
 #define configQUEUE_REGISTRY_SIZE               0       ///< See FreeRTOS documentation
 
@@ -140,11 +181,91 @@
  */
 #if (1 == configUSE_TRACE_FACILITY)
 #include "fault_registers.h"
-#define traceTASK_SWITCHED_IN()                                                 \
+#define traceLAST_RUNNING_TASK()                                                \
             do {                                                                \
                 uint32_t *pTaskName = (uint32_t*)(pxCurrentTCB->pcTaskName);    \
                 FAULT_LAST_RUNNING_TASK_NAME = *pTaskName;                      \
             } while (0)
+#else
+#define traceLAST_RUNNING_TASK()
+#endif
+
+/* Move the MPU stack guard to the task being switched in (@see SYS_CFG_STACK_GUARD) */
+#if (1 == configUSE_STACK_GUARD)
+#define traceSTACK_GUARD_SWITCHED_IN()      portSET_STACK_GUARD(pxCurrentTCB->pxStack)
+#else
+#define traceSTACK_GUARD_SWITCHED_IN()
+#endif
+
+#define traceTASK_SWITCHED_IN()                                                 \
+            do {                                                                \
+                traceLAST_RUNNING_TASK();                                       \
+                traceOS_TRACE_SWITCHED_IN();                                    \
+                traceSTACK_GUARD_SWITCHED_IN();                                 \
+            } while (0)
+
+/**
+ * @{ OS trace recorder (@see os_trace.h)
+ * The macros test the mask before the call, so a stopped trace costs a load and a branch.
+ * The queues are numbered when they are created since FreeRTOS leaves their number uninitialized.
+ */
+#if (1 == configUSE_TRACE_FACILITY && SYS_CFG_TRACE_RECORDS > 0)
+#include "os_trace.h"
+#define os_trace_task_event(event, tcb)                                                     \
+            do { if (g_os_trace_mask & os_trace_tasks)                                      \
+                     os_trace_record(os_trace_tasks, event, (tcb)->uxTCBNumber, 0); } while (0)
+#define os_trace_queue_event(event, queue)                                                  \
+            do { if (g_os_trace_mask & os_trace_queues)                                     \
+                     os_trace_record(os_trace_queues, event, g_os_trace_task, (queue)->uxQueueNumber); } while (0)
+#define os_trace_queue_isr_event(event, queue)                                              \
+            do { if (g_os_trace_mask & os_trace_queues)                                     \
+                     os_trace_record(os_trace_queues, event, os_trace_get_exception_num(),  \
+                                     (queue)->uxQueueNumber); } while (0)
+
+#define traceOS_TRACE_SWITCHED_IN()                                                         \
+            do { g_os_trace_task = pxCurrentTCB->uxTCBNumber;                               \
+                 os_trace_task_event(os_trace_task_in, pxCurrentTCB); } while (0)
+#define traceTASK_SWITCHED_OUT()                    os_trace_task_event(os_trace_task_out, pxCurrentTCB)
+#define traceMOVED_TASK_TO_READY_STATE(pxTCB)       os_trace_task_event(os_trace_task_ready, pxTCB);  /* Used without a ';' */
+#define traceQUEUE_CREATE(pxNewQueue)               (pxNewQueue)->uxQueueNumber = os_trace_next_queue_num()
+#define traceCREATE_MUTEX(pxNewQueue)               (pxNewQueue)->uxQueueNumber = os_trace_next_queue_num()
+#define traceQUEUE_SEND(pxQueue)                    os_trace_queue_event(os_trace_queue_send, pxQueue)
+#define traceQUEUE_SEND_FAILED(pxQueue)             os_trace_queue_event(os_trace_queue_send_failed, pxQueue)
+#define traceBLOCKING_ON_QUEUE_SEND(pxQueue)        os_trace_queue_event(os_trace_queue_send_block, pxQueue)
+#define traceQUEUE_RECEIVE(pxQueue)                 os_trace_queue_event(os_trace_queue_recv, pxQueue)
+#define traceQUEUE_RECEIVE_FAILED(pxQueue)          os_trace_queue_event(os_trace_queue_recv_failed, pxQueue)
+#define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue)     os_trace_queue_event(os_trace_queue_recv_block, pxQueue)
+#define traceQUEUE_SEND_FROM_ISR(pxQueue)           os_trace_queue_isr_event(os_trace_queue_send_isr, pxQueue)
+#define traceQUEUE_SEND_FROM_ISR_FAILED(pxQueue)    os_trace_queue_isr_event(os_trace_queue_send_isr_failed, pxQueue)
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue)        os_trace_queue_isr_event(os_trace_queue_recv_isr, pxQueue)
+#define traceQUEUE_RECEIVE_FROM_ISR_FAILED(pxQueue) os_trace_queue_isr_event(os_trace_queue_recv_isr_failed, pxQueue)
+#else
+#define traceOS_TRACE_SWITCHED_IN()
+#endif
+/** @} */
+
+/**
+ * The critical sections and the FromISR API mask the interrupts through os_latency.h, which times
+ * each masking by the caller (@see SYS_CFG_LATENCY_SITES).  The MPU port masks the interrupts inline.
+ */
+#if (SYS_CFG_LATENCY_SITES > 0 && !BUILD_CFG_MPU)
+#define configUSE_LATENCY_STATS                 1
+#else
+#define configUSE_LATENCY_STATS                 0
+#endif
+
+/// The contention statistics of the shared locks (@see os_lock_stats.h)
+#if (SYS_CFG_LOCK_STATS)
+#define configUSE_LOCK_STATS                    1
+#else
+#define configUSE_LOCK_STATS                    0
+#endif
+
+/// The malloc() lock suspends the scheduler rather than masking the interrupts (@see newlib/malloc_lock.c)
+#if (SYS_CFG_MALLOC_LOCK_SCHEDULER)
+#define configMALLOC_LOCK_SCHEDULER             1
+#else
+#define configMALLOC_LOCK_SCHEDULER             0
 #endif
 
 
@@ -155,15 +276,16 @@
 #define configUSE_QUEUE_SETS                1
 #define INCLUDE_vTaskPrioritySet			0
 #define INCLUDE_uxTaskPriorityGet			0
-#define INCLUDE_vTaskDelete					0
+#define INCLUDE_vTaskDelete					1   ///< The boot tasks (SYS_CFG_BOOT_TASKS) exit when done
 #define INCLUDE_vTaskCleanUpResources		0
 #define INCLUDE_vTaskSuspend				1
 #define INCLUDE_vTaskDelayUntil				1
 #define INCLUDE_vTaskDelay					1
 #define INCLUDE_uxTaskGetStackHighWaterMark	1
+#define INCLUDE_pcTaskGetTaskName           1   ///< The stack guard fault reports the task name
 #define INCLUDE_xTaskGetSchedulerState      1
 #define INCLUDE_xTaskGetIdleTaskHandle      1
-#define INCLUDE_xTimerPendFunctionCall      0   ///< Uses timer daemon task, so needs configUSE_TIMERS to 1
+#define INCLUDE_xTimerPendFunctionCall      1   ///< Uses timer daemon task, so needs configUSE_TIMERS to 1 (event_bus_publish() from an ISR)
 
 /* FreeRTOS Timer or daemon task configuration */
 #define configUSE_TIMERS                1
@@ -0,0 +1,100 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief Interrupt latency statistics
+ *
+ * The interrupts used with the FreeRTOS API cannot run while a task is in a critical section, or
+ * while an interrupt or the OS uses a FromISR function, so the longest of these sections adds to the
+ * latency of every such interrupt.  The port macros (see portmacro.h) mask the interrupts through
+ * os_latency_mask() and os_latency_unmask(), which time each masking by the CPU cycle counter, and
+ * keep the longest time of each of SYS_CFG_LATENCY_SITES code sites.  The site is the return address
+ * of the function that masked the interrupts, which is the caller of taskENTER_CRITICAL() or of the
+ * FromISR function; look it up in the map file, or with addr2line:
+ * @code
+ *      arm-none-eabi-addr2line -f -e project.elf 0x00012A34
+ * @endcode
+ * Once all the sites are used, a new site replaces the site with the shortest time if it took longer.
+ *
+ * If SYS_CFG_LATENCY_PROBE is set, the RIT interrupts every 10ms at the IP_RIT priority, and
+ * the time from its match to its callback is the interrupt entry latency, which includes the masked
+ * sections, the interrupts of the same or higher priority, and the common interrupt handler.
+ *
+ * The 'health' terminal command prints both statistics.
+ */
+#ifndef OS_LATENCY_H__
+#define OS_LATENCY_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+
+
+
+/// The longest time with interrupts masked of a code site
+typedef struct {
+    const void *site;       ///< The return address of the function that masked the interrupts
+    uint32_t max_cycles;    ///< The longest time that the site kept the interrupts masked
+    uint32_t count;         ///< The number of times the site masked the interrupts
+} os_latency_site_t;
+
+/// The interrupt entry latency measured by the RIT probe, in CPU cycles
+typedef struct {
+    uint32_t min_cycles;    ///< The shortest latency
+    uint32_t max_cycles;    ///< The longest latency
+    uint64_t sum_cycles;    ///< The sum of the latencies, to get the average
+    uint32_t count;         ///< The number of samples
+} os_latency_probe_t;
+
+/**
+ * Masks the interrupts of the FreeRTOS API, and starts the timing if they were not masked already
+ * @param site  The code site, which is the return address of the caller
+ * @returns the previous mask to give to os_latency_unmask()
+ */
+uint32_t os_latency_mask(const void *site);
+
+/**
+ * Restores the interrupt mask, and records the time of the site if the interrupts are unmasked
+ * @param mask  The value returned by os_latency_mask(), or 0 to unmask the interrupts
+ */
+void os_latency_unmask(uint32_t mask);
+
+/**
+ * Copies the sites, sorted by the longest time first
+ * @param sites  The array to copy the sites to
+ * @param max    The size of the array
+ * @returns the number of sites copied
+ */
+uint32_t os_latency_get_sites(os_latency_site_t *sites, uint32_t max);
+
+/// Starts the RIT probe of the interrupt entry latency (@see SYS_CFG_LATENCY_PROBE)
+void os_latency_probe_start(void);
+
+/// @returns the statistics of the RIT probe; all fields are 0 if the probe is not running
+os_latency_probe_t os_latency_get_probe(void);
+
+/// Clears the sites and the statistics of the probe
+void os_latency_reset(void);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* OS_LATENCY_H__ */
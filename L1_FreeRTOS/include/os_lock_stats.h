@@ -0,0 +1,116 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief Contention statistics of the shared locks
+ *
+ * Each instrumented lock has an os_lock_stats_t that counts its acquisitions, and the
+ * acquisitions that had to wait because another task had the lock, with the total and the longest
+ * wait and the longest hold by the CPU cycle counter.  The owner is the task that has the lock now.
+ * The mutexes use the wrappers of xSemaphoreTake() and xSemaphoreGive():
+ * @code
+ *      static os_lock_stats_t g_foo_lock_stats = OS_LOCK_STATS_INIT("foo");
+ *
+ *      os_lock_take(&g_foo_lock_stats, g_foo_mutex, portMAX_DELAY);
+ *      ...
+ *      os_lock_give(&g_foo_lock_stats, g_foo_mutex);
+ * @endcode
+ * and the other locks call os_lock_acquired() and os_lock_released() themselves, such as the
+ * SSP bus lock of spi1_lock() (@see ssp_bus.h) and the critical section of __malloc_lock().
+ *
+ * The statistics are only changed by the task that has the lock, so they do not need a lock of
+ * their own.  A lock is added to the list of os_lock_get_stats() at its first acquisition.
+ * The 'health' command prints the locks by their total wait, longest first.
+ * Set SYS_CFG_LOCK_STATS to 0 to remove the statistics, and the wrappers only take and give.
+ */
+#ifndef OS_LOCK_STATS_H__
+#define OS_LOCK_STATS_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+
+
+/// The statistics of a lock
+typedef struct os_lock_stats {
+    const char *name;               ///< The name of the lock, which must be a persistent string
+    struct os_lock_stats *pNext;    ///< The next lock of the list, once the lock is added to it
+    bool listed;                    ///< Set once the lock is added to the list
+    uint32_t count;                 ///< The acquisitions
+    uint32_t contended;             ///< The acquisitions that waited for another task
+    uint64_t wait_cycles;           ///< The total time that the acquisitions waited
+    uint32_t max_wait_cycles;       ///< The longest wait
+    uint32_t max_hold_cycles;       ///< The longest time that the lock was held
+    char max_hold_task[configMAX_TASK_NAME_LEN];   ///< The task of the longest hold
+    volatile TaskHandle_t owner;    ///< The task that has the lock, or NULL
+    uint32_t acquired;              ///< The CPU cycles of the acquisition by the owner
+} os_lock_stats_t;
+
+/// The initializer of a static os_lock_stats_t
+#define OS_LOCK_STATS_INIT(name)    { name, NULL, false, 0, 0, 0, 0, 0, { 0 }, NULL, 0 }
+
+#if (configUSE_LOCK_STATS == 1)
+/// @returns the CPU cycles to give to os_lock_acquired(), before waiting for the lock
+uint32_t os_lock_wait_start(void);
+
+/**
+ * Records the acquisition of a lock; called by the task that now has the lock
+ * @param start      The value of os_lock_wait_start() before waiting for the lock
+ * @param contended  true if another task had the lock
+ */
+void os_lock_acquired(os_lock_stats_t *pStats, uint32_t start, bool contended);
+
+/// Records the hold time of a lock; called by the owner before it releases the lock
+void os_lock_released(os_lock_stats_t *pStats);
+
+/// xSemaphoreTake() of a mutex, with the statistics of the acquisition
+BaseType_t os_lock_take(os_lock_stats_t *pStats, SemaphoreHandle_t mutex, TickType_t ticks);
+
+/// xSemaphoreGive() of a mutex taken by os_lock_take()
+BaseType_t os_lock_give(os_lock_stats_t *pStats, SemaphoreHandle_t mutex);
+#else
+static inline uint32_t os_lock_wait_start(void) { return 0; }
+static inline void os_lock_acquired(os_lock_stats_t *pStats, uint32_t start, bool contended) { }
+static inline void os_lock_released(os_lock_stats_t *pStats) { }
+#define os_lock_take(pStats, mutex, ticks)      xSemaphoreTake(mutex, ticks)
+#define os_lock_give(pStats, mutex)             xSemaphoreGive(mutex)
+#endif
+
+/**
+ * Copies the statistics of the locks, sorted by the total wait, longest first
+ * @param pStats  The array to copy the statistics to; pNext of the copies is not used
+ * @param max     The size of the array
+ * @returns the number of locks copied
+ */
+uint32_t os_lock_get_stats(os_lock_stats_t *pStats, uint32_t max);
+
+/// Clears the statistics of every lock, except for their owners
+void os_lock_reset(void);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* OS_LOCK_STATS_H__ */
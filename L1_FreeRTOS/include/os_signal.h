@@ -0,0 +1,130 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief A completion signal between an ISR and a task that uses the task notifications
+ *
+ * A binary semaphore is a queue object of about 80 bytes, and each give and take goes through
+ * the queue code with its event lists.  An os_signal_t is a flag and the handle of the waiting
+ * task: the give sets the flag and notifies the task (see ulTaskNotifyTake()), which only moves
+ * the task to the ready list.  The flag keeps the signal of each os_signal_t, so the same task
+ * can wait for several signals at different times even though they share its notification count;
+ * a notification of another signal only wakes up the task to check its flag again.
+ *
+ * Like a binary semaphore, a give while the task is not waiting is kept until the next wait, and
+ * several gives before the wait are one signal.  Only one task may wait for a signal at a time.
+ * @code
+ *      static os_signal_t done = OS_SIGNAL_INIT;
+ *      void isr(void)  { portEND_SWITCHING_ISR(os_signal_give_from_isr(&done)); }
+ *      void task(void) { os_signal_clear(&done); start(); os_signal_wait(&done, OS_MS(100)); }
+ * @endcode
+ */
+#ifndef OS_SIGNAL_H__
+#define OS_SIGNAL_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+
+
+/// The completion signal, initialize it with OS_SIGNAL_INIT or os_signal_clear()
+typedef struct {
+    volatile TaskHandle_t task;     ///< The task that waits for the signal, or NULL if none yet
+    volatile bool given;            ///< Set by the give, and cleared by the wait that returns it
+} os_signal_t;
+
+/// The initializer of a static os_signal_t
+#define OS_SIGNAL_INIT      { NULL, false }
+
+/// Records the calling task as the waiting task if the OS is running
+static inline void os_signal_set_task(os_signal_t *s)
+{
+    if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        s->task = xTaskGetCurrentTaskHandle();
+    }
+}
+
+/// Clears a stale signal, such as the xSemaphoreTake(sem, 0) before starting the operation
+static inline void os_signal_clear(os_signal_t *s)
+{
+    os_signal_set_task(s);
+    s->given = false;
+}
+
+/**
+ * Waits for the signal, and clears it
+ * @param ticks  The ticks to wait, 0 to poll (also before the OS is running), or portMAX_DELAY
+ * @returns true if the signal was given
+ */
+static inline bool os_signal_wait(os_signal_t *s, TickType_t ticks)
+{
+    TimeOut_t timeout;
+
+    os_signal_set_task(s);
+    if (!s->given && ticks > 0) {
+        vTaskSetTimeOutState(&timeout);
+        do {
+            ulTaskNotifyTake(pdTRUE, ticks);
+        } while (!s->given && !xTaskCheckForTimeOut(&timeout, &ticks));
+    }
+
+    /* A give after the timeout is kept for the next wait */
+    if (!s->given) {
+        return false;
+    }
+    s->given = false;
+    return true;
+}
+
+/// Gives the signal from a task
+static inline void os_signal_give(os_signal_t *s)
+{
+    const TaskHandle_t task = s->task;
+    s->given = true;
+    if (NULL != task) {
+        xTaskNotifyGive(task);
+    }
+}
+
+/**
+ * Gives the signal from an ISR
+ * @returns true if the waiting task has a higher priority than the interrupted task, which
+ *          is the value to give to portEND_SWITCHING_ISR() or to return to the ISR dispatcher
+ */
+static inline BaseType_t os_signal_give_from_isr(os_signal_t *s)
+{
+    const TaskHandle_t task = s->task;
+    BaseType_t woken = pdFALSE;
+
+    s->given = true;
+    if (NULL != task) {
+        vTaskNotifyGiveFromISR(task, &woken);
+    }
+    return woken;
+}
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* OS_SIGNAL_H__ */
@@ -0,0 +1,156 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief OS trace recorder
+ *
+ * The FreeRTOS trace macros (see FreeRTOSConfig.h) and the common interrupt handler write
+ * 8-byte records of the task switches, interrupts and queue operations to a RAM ring of
+ * SYS_CFG_TRACE_RECORDS records.  Each record is timestamped by the CPU cycle counter, so
+ * the time between two records is exact to a cycle (as long as the CPU clock is not scaled
+ * during the trace).  Once the ring is full, the oldest records are overwritten, so stop the
+ * trace soon after the event of interest to keep the records that led to it:
+ * @code
+ *      os_trace_start(os_trace_default);
+ *      ...
+ *      if (ack_timed_out) {
+ *          os_trace_mark(1);
+ *          os_trace_stop();
+ *      }
+ * @endcode
+ *
+ * The tasks are identified by their TCB number (TaskStatus_t::xTaskNumber), the interrupts by
+ * their exception number (16 + IRQn), and the queues, semaphores and mutexes by the queue number
+ * that is given to them in the order they were created.
+ *
+ * The 'trace' terminal command starts and stops the trace, summarises it, or dumps it in binary.
+ */
+#ifndef OS_TRACE_H__
+#define OS_TRACE_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/// The events of the trace records
+typedef enum {
+    os_trace_task_in = 1,       ///< The task (id) was switched in
+    os_trace_task_out,          ///< The task (id) was switched out
+    os_trace_task_ready,        ///< The task (id) was moved to the ready list
+    os_trace_isr_enter,         ///< The interrupt (id) was entered
+    os_trace_isr_exit,          ///< The interrupt (id) returned
+    os_trace_queue_send,        ///< The task (id) sent to the queue (arg)
+    os_trace_queue_send_failed, ///< The task (id) timed out or failed to send to the queue (arg)
+    os_trace_queue_send_block,  ///< The task (id) blocks to send to the queue (arg) since it is full
+    os_trace_queue_recv,        ///< The task (id) received from the queue (arg)
+    os_trace_queue_recv_failed, ///< The task (id) timed out or failed to receive from the queue (arg)
+    os_trace_queue_recv_block,  ///< The task (id) blocks to receive from the queue (arg) since it is empty
+    os_trace_queue_send_isr,    ///< The interrupt (id) sent to the queue (arg)
+    os_trace_queue_send_isr_failed, ///< The interrupt (id) failed to send to the queue (arg) since it is full
+    os_trace_queue_recv_isr,    ///< The interrupt (id) received from the queue (arg)
+    os_trace_queue_recv_isr_failed, ///< The interrupt (id) failed to receive from the queue (arg) since it is empty
+    os_trace_user_mark,         ///< os_trace_mark() was called by the task (id) with the value (arg)
+    os_trace_user_mark_isr,     ///< os_trace_mark() was called by the interrupt (id) with the value (arg)
+    os_trace_event_count
+} os_trace_event_t;
+
+/// The classes of the events that are recorded; used as a bit-mask
+typedef enum {
+    os_trace_tasks   = (1 << 0),    ///< Task switches and tasks made ready
+    os_trace_isrs    = (1 << 1),    ///< Interrupts, except for the OS tick
+    os_trace_tick    = (1 << 2),    ///< the OS tick interrupt (1000 interrupts per second)
+    os_trace_queues  = (1 << 3),    ///< Queue, semaphore and mutex operations
+    os_trace_marks   = (1 << 4),    ///< os_trace_mark()
+    os_trace_default = (os_trace_tasks | os_trace_isrs | os_trace_queues | os_trace_marks),
+    os_trace_all     = (os_trace_default | os_trace_tick),
+} os_trace_class_t;
+
+/// A trace record
+typedef struct {
+    uint32_t cycles;    ///< The CPU cycle counter when the event occurred (@see sys_get_cycles())
+    uint8_t event;      ///< The event (@see os_trace_event_t)
+    uint8_t id;         ///< The task number, or the exception number of the interrupt
+    uint16_t arg;       ///< The queue number, or the value of os_trace_mark()
+} os_trace_record_t;
+
+/// The classes of the events being recorded, or 0 if the trace is stopped
+extern volatile uint8_t g_os_trace_mask;
+
+/// The number of the running task, set when a task is switched in
+extern volatile uint8_t g_os_trace_task;
+
+/**
+ * Clears the trace and starts to record the events of the given classes
+ * @param mask  The classes of the events to record (@see os_trace_class_t)
+ */
+void os_trace_start(uint8_t mask);
+
+/// Stops the trace; this can be called from an interrupt
+void os_trace_stop(void);
+
+/// @returns true if the trace is recording
+static inline bool os_trace_is_running(void) { return (0 != g_os_trace_mask); }
+
+/// @returns the number of records of the trace, up to SYS_CFG_TRACE_RECORDS
+uint32_t os_trace_get_count(void);
+
+/// @returns the number of records that were overwritten because the ring was full
+uint32_t os_trace_get_overwritten(void);
+
+/**
+ * @returns the record of the trace, where 0 is the oldest record
+ * @note The records change while the trace is running, so stop the trace first.
+ */
+const os_trace_record_t* os_trace_get_record(uint32_t index);
+
+/// Records a user event of the current task or interrupt; this can be called from an interrupt
+void os_trace_mark(uint16_t value);
+
+/**
+ * Writes a record if its class is being recorded.  This is used by the trace macros, and
+ * can be called from an interrupt.
+ */
+void os_trace_record(uint8_t event_class, uint8_t event, uint8_t id, uint16_t arg);
+
+/// Records the entry or the exit of an interrupt; used by the interrupt handlers of startup.cpp
+static inline void os_trace_isr(uint8_t event_class, uint8_t event, uint8_t exception)
+{
+    if (g_os_trace_mask & event_class) {
+        os_trace_record(event_class, event, exception, 0);
+    }
+}
+
+/// @returns the exception number of the active interrupt, or 0 if called by a task
+static inline uint8_t os_trace_get_exception_num(void)
+{
+    return (*(volatile uint32_t*) 0xE000ED04) & 0xFF;   /* SCB->ICSR VECTACTIVE */
+}
+
+/// @returns the next queue number, given to the queues when they are created
+uint16_t os_trace_next_queue_num(void);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* OS_TRACE_H__ */
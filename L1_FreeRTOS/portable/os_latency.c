@@ -0,0 +1,186 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "os_latency.h"
+#include "LPC17xx.h"    // LPC_RIT
+#include "lpc_sys.h"    // sys_get_cycles()
+#include "lpc_rit.h"
+
+
+
+/// The period of the RIT probe
+#define OS_LATENCY_PROBE_MS     10
+
+/// Masks the interrupts without timing the masking
+#if (configUSE_LATENCY_STATS == 1)
+#define os_latency_lock()       ulPortSetInterruptMask()
+#define os_latency_unlock(x)    vPortClearInterruptMask(x)
+#else
+#define os_latency_lock()       portSET_INTERRUPT_MASK_FROM_ISR()
+#define os_latency_unlock(x)    portCLEAR_INTERRUPT_MASK_FROM_ISR(x)
+#endif
+
+#if (configUSE_LATENCY_STATS == 1)
+/// The sites, and the site and the start of the current masking (only changed while masked)
+static os_latency_site_t g_os_latency_sites[SYS_CFG_LATENCY_SITES];
+static const void *g_os_latency_site = NULL;
+static uint32_t g_os_latency_start = 0;
+
+/// Records the time of the site; called with the interrupts masked
+static void os_latency_record(const void *site, uint32_t cycles)
+{
+    os_latency_site_t *shortest = &g_os_latency_sites[0];
+
+    for (uint32_t i = 0; i < SYS_CFG_LATENCY_SITES; i++) {
+        os_latency_site_t *s = &g_os_latency_sites[i];
+        if (site == s->site) {
+            s->count++;
+            if (cycles > s->max_cycles) {
+                s->max_cycles = cycles;
+            }
+            return;
+        }
+        if (s->max_cycles < shortest->max_cycles) {
+            shortest = s;
+        }
+    }
+
+    /* An unused site has a time of 0, so it is always the shortest */
+    if (cycles > shortest->max_cycles) {
+        shortest->site = site;
+        shortest->max_cycles = cycles;
+        shortest->count = 1;
+    }
+}
+
+uint32_t os_latency_mask(const void *site)
+{
+    const uint32_t mask = ulPortSetInterruptMask();
+    if (0 == mask) {
+        g_os_latency_site = site;
+        g_os_latency_start = sys_get_cycles();
+    }
+    return mask;
+}
+
+void os_latency_unmask(uint32_t mask)
+{
+    /* The mask was not set by os_latency_mask() if there is no site, such as after a reset */
+    if (0 == mask && NULL != g_os_latency_site) {
+        os_latency_record(g_os_latency_site, sys_get_cycles() - g_os_latency_start);
+        g_os_latency_site = NULL;
+    }
+    vPortClearInterruptMask(mask);
+}
+
+uint32_t os_latency_get_sites(os_latency_site_t *sites, uint32_t max)
+{
+    uint32_t count = 0;
+    const uint32_t mask = os_latency_lock();
+
+    /* Insertion sort of the used sites, longest first */
+    for (uint32_t i = 0; i < SYS_CFG_LATENCY_SITES; i++) {
+        const os_latency_site_t *s = &g_os_latency_sites[i];
+        if (NULL == s->site) {
+            continue;
+        }
+
+        uint32_t j = (count < max) ? count++ : max;
+        while (j > 0 && sites[j - 1].max_cycles < s->max_cycles) {
+            if (j < max) {
+                sites[j] = sites[j - 1];
+            }
+            j--;
+        }
+        if (j < max) {
+            sites[j] = *s;
+        }
+    }
+
+    os_latency_unlock(mask);
+    return count;
+}
+#else
+uint32_t os_latency_get_sites(os_latency_site_t *sites, uint32_t max)
+{
+    (void) sites;
+    (void) max;
+    return 0;
+}
+#endif
+
+#if (SYS_CFG_LATENCY_PROBE)
+static os_latency_probe_t g_os_latency_probe;
+
+/**
+ * The RIT counter is cleared at the match, so its count when the callback runs is the time
+ * from the match to the callback, since the RIT counts the CPU clock (see rit_enable())
+ */
+static void os_latency_probe_isr(void)
+{
+    const uint32_t cycles = LPC_RIT->RICOUNTER;
+
+    if (0 == g_os_latency_probe.count || cycles < g_os_latency_probe.min_cycles) {
+        g_os_latency_probe.min_cycles = cycles;
+    }
+    if (cycles > g_os_latency_probe.max_cycles) {
+        g_os_latency_probe.max_cycles = cycles;
+    }
+    g_os_latency_probe.sum_cycles += cycles;
+    g_os_latency_probe.count++;
+}
+
+void os_latency_probe_start(void)
+{
+    rit_enable(os_latency_probe_isr, OS_LATENCY_PROBE_MS);
+}
+#else
+void os_latency_probe_start(void)
+{
+}
+#endif
+
+os_latency_probe_t os_latency_get_probe(void)
+{
+    os_latency_probe_t probe;
+    memset(&probe, 0, sizeof(probe));
+
+#if (SYS_CFG_LATENCY_PROBE)
+    const uint32_t mask = os_latency_lock();
+    probe = g_os_latency_probe;
+    os_latency_unlock(mask);
+#endif
+
+    return probe;
+}
+
+void os_latency_reset(void)
+{
+    const uint32_t mask = os_latency_lock();
+#if (configUSE_LATENCY_STATS == 1)
+    memset(g_os_latency_sites, 0, sizeof(g_os_latency_sites));
+    g_os_latency_site = NULL;
+#endif
+#if (SYS_CFG_LATENCY_PROBE)
+    memset(&g_os_latency_probe, 0, sizeof(g_os_latency_probe));
+#endif
+    os_latency_unlock(mask);
+}
@@ -0,0 +1,142 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <string.h>
+
+#include "os_lock_stats.h"
+#include "lpc_sys.h"    // sys_get_cycles()
+
+
+
+#if (configUSE_LOCK_STATS == 1)
+/// The locks that were acquired at least once, newest first
+static os_lock_stats_t *g_os_lock_list = NULL;
+
+uint32_t os_lock_wait_start(void)
+{
+    return sys_get_cycles();
+}
+
+void os_lock_acquired(os_lock_stats_t *pStats, uint32_t start, bool contended)
+{
+    const uint32_t now = sys_get_cycles();
+    const uint32_t wait = now - start;
+
+    if (!pStats->listed) {
+        portENTER_CRITICAL();
+        if (!pStats->listed) {
+            pStats->pNext = g_os_lock_list;
+            g_os_lock_list = pStats;
+            pStats->listed = true;
+        }
+        portEXIT_CRITICAL();
+    }
+
+    pStats->owner = xTaskGetCurrentTaskHandle();
+    pStats->acquired = now;
+    ++pStats->count;
+    if (contended) {
+        ++pStats->contended;
+        pStats->wait_cycles += wait;
+        if (wait > pStats->max_wait_cycles) {
+            pStats->max_wait_cycles = wait;
+        }
+    }
+}
+
+void os_lock_released(os_lock_stats_t *pStats)
+{
+    const uint32_t hold = sys_get_cycles() - pStats->acquired;
+    const TaskHandle_t owner = pStats->owner;
+
+    /* There is no task before the first task is created, such as a malloc() during the boot */
+    if (hold > pStats->max_hold_cycles) {
+        pStats->max_hold_cycles = hold;
+        strncpy(pStats->max_hold_task, (NULL == owner) ? "" : pcTaskGetTaskName(owner),
+                sizeof(pStats->max_hold_task));
+    }
+    pStats->owner = NULL;
+}
+
+BaseType_t os_lock_take(os_lock_stats_t *pStats, SemaphoreHandle_t mutex, TickType_t ticks)
+{
+    const uint32_t start = sys_get_cycles();
+
+    /* The mutex is only contended if it cannot be taken right away */
+    if (xSemaphoreTake(mutex, 0)) {
+        os_lock_acquired(pStats, start, false);
+        return pdTRUE;
+    }
+    if (ticks > 0 && xSemaphoreTake(mutex, ticks)) {
+        os_lock_acquired(pStats, start, true);
+        return pdTRUE;
+    }
+    return pdFALSE;
+}
+
+BaseType_t os_lock_give(os_lock_stats_t *pStats, SemaphoreHandle_t mutex)
+{
+    os_lock_released(pStats);
+    return xSemaphoreGive(mutex);
+}
+#endif
+
+uint32_t os_lock_get_stats(os_lock_stats_t *pStats, uint32_t max)
+{
+    uint32_t count = 0;
+
+#if (configUSE_LOCK_STATS == 1)
+    portENTER_CRITICAL();
+    for (const os_lock_stats_t *p = g_os_lock_list; NULL != p; p = p->pNext) {
+        /* Keep the locks of the longest total wait */
+        uint32_t i = (count < max) ? count++ : max;
+        if (i == max) {
+            if (0 == max || p->wait_cycles <= pStats[max - 1].wait_cycles) {
+                continue;
+            }
+            i = max - 1;
+        }
+        for ( ; i > 0 && pStats[i - 1].wait_cycles < p->wait_cycles; i--) {
+            pStats[i] = pStats[i - 1];
+        }
+        pStats[i] = *p;
+    }
+    portEXIT_CRITICAL();
+#else
+    (void) pStats;
+    (void) max;
+#endif
+
+    return count;
+}
+
+void os_lock_reset(void)
+{
+#if (configUSE_LOCK_STATS == 1)
+    portENTER_CRITICAL();
+    for (os_lock_stats_t *p = g_os_lock_list; NULL != p; p = p->pNext) {
+        p->count = 0;
+        p->contended = 0;
+        p->wait_cycles = 0;
+        p->max_wait_cycles = 0;
+        p->max_hold_cycles = 0;
+        p->max_hold_task[0] = '\0';
+    }
+    portEXIT_CRITICAL();
+#endif
+}
@@ -0,0 +1,109 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "os_trace.h"
+#include "LPC17xx.h"    // __disable_irq()
+#include "lpc_sys.h"    // sys_get_cycles()
+#include "lpc_isr.h"    // RAMFUNC
+
+
+
+#if (SYS_CFG_TRACE_RECORDS > 0)
+volatile uint8_t g_os_trace_mask = 0;
+volatile uint8_t g_os_trace_task = 0;
+
+/// The ring of the records, and the number of records ever written since the start
+static os_trace_record_t g_os_trace_ring[SYS_CFG_TRACE_RECORDS];
+static uint32_t g_os_trace_written = 0;
+
+
+
+void os_trace_start(uint8_t mask)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    g_os_trace_written = 0;
+    g_os_trace_mask = mask;
+    __set_PRIMASK(primask);
+}
+
+void os_trace_stop(void)
+{
+    g_os_trace_mask = 0;
+}
+
+uint32_t os_trace_get_count(void)
+{
+    return (g_os_trace_written < SYS_CFG_TRACE_RECORDS) ? g_os_trace_written : SYS_CFG_TRACE_RECORDS;
+}
+
+uint32_t os_trace_get_overwritten(void)
+{
+    return g_os_trace_written - os_trace_get_count();
+}
+
+const os_trace_record_t* os_trace_get_record(uint32_t index)
+{
+    if (index >= os_trace_get_count()) {
+        return NULL;
+    }
+
+    /* The oldest record is at the write position once the ring has wrapped */
+    const uint32_t oldest = (g_os_trace_written > SYS_CFG_TRACE_RECORDS) ? g_os_trace_written : 0;
+    return &g_os_trace_ring[(oldest + index) % SYS_CFG_TRACE_RECORDS];
+}
+
+void os_trace_mark(uint16_t value)
+{
+    const uint8_t exception = os_trace_get_exception_num();
+    if (exception) {
+        os_trace_record(os_trace_marks, os_trace_user_mark_isr, exception, value);
+    }
+    else {
+        os_trace_record(os_trace_marks, os_trace_user_mark, g_os_trace_task, value);
+    }
+}
+
+RAMFUNC void os_trace_record(uint8_t event_class, uint8_t event, uint8_t id, uint16_t arg)
+{
+    /* The kernel calls this with only the BASEPRI interrupts masked, so disable all of them
+     * since the higher priority interrupts can write records too.
+     */
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (g_os_trace_mask & event_class) {
+        os_trace_record_t *rec = &g_os_trace_ring[g_os_trace_written % SYS_CFG_TRACE_RECORDS];
+        rec->cycles = sys_get_cycles();
+        rec->event = event;
+        rec->id = id;
+        rec->arg = arg;
+        ++g_os_trace_written;
+    }
+
+    __set_PRIMASK(primask);
+}
+
+uint16_t os_trace_next_queue_num(void)
+{
+    static uint16_t s_queue_num = 0;
+    return ++s_queue_num;
+}
+#endif /* SYS_CFG_TRACE_RECORDS */
@@ -131,8 +131,8 @@ typedef struct tskTaskControlBlock
 	StackType_t			*pxStack;			/*< Points to the start of the stack. */
 	char				pcTaskName[ configMAX_TASK_NAME_LEN ];/*< Descriptive name given to the task when created.  Facilitates debugging only. */ /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
 
-	#if ( portSTACK_GROWTH > 0 )
-		StackType_t		*pxEndOfStack;		/*< Points to the end of the stack on architectures where the stack grows up from low memory. */
+	#if ( ( portSTACK_GROWTH > 0 ) || ( configRECORD_STACK_HIGH_ADDRESS == 1 ) )
+		StackType_t		*pxEndOfStack;		/*< Points to the end of the stack; the highest address when the stack grows down from high memory. */
 	#endif
 
 	#if ( portCRITICAL_NESTING_IN_TCB == 1 )
@@ -157,6 +157,11 @@ typedef struct tskTaskControlBlock
 		uint32_t		ulRunTimeCounter;	/*< Stores the amount of time the task has spent in the Running state. */
 	#endif
 
+	#if ( configUSE_TASK_NOTIFICATIONS == 1 )
+		volatile uint32_t ulNotifiedValue;	/*< The count of the notifications given to the task (see tasks_mod.c.inc). */
+		volatile uint8_t ucNotifyWaiting;	/*< Set while the task blocks in ulTaskNotifyTake(). */
+	#endif
+
 	#if ( configUSE_NEWLIB_REENTRANT == 1 )
 		/* Allocate a Newlib reent structure that is specific to this task.
 		Note Newlib support has been included by popular demand, but is not
@@ -554,6 +559,14 @@ TCB_t * pxNewTCB;
 
 			/* Check the alignment of the calculated top of stack is correct. */
 			configASSERT( ( ( ( portPOINTER_SIZE_TYPE ) pxTopOfStack & ( portPOINTER_SIZE_TYPE ) portBYTE_ALIGNMENT_MASK ) == 0UL ) );
+
+			#if( configRECORD_STACK_HIGH_ADDRESS == 1 )
+			{
+				/* Also record the stack's high address, which may assist
+				debugging and gives the size of the stack. */
+				pxNewTCB->pxEndOfStack = pxTopOfStack;
+			}
+			#endif /* configRECORD_STACK_HIGH_ADDRESS */
 		}
 		#else /* portSTACK_GROWTH */
 		{
@@ -2744,6 +2757,13 @@ UBaseType_t x;
 	}
 	#endif /* configUSE_MUTEXES */
 
+	#if ( configUSE_TASK_NOTIFICATIONS == 1 )
+	{
+		pxTCB->ulNotifiedValue = 0;
+		pxTCB->ucNotifyWaiting = pdFALSE;
+	}
+	#endif /* configUSE_TASK_NOTIFICATIONS */
+
 	vListInitialiseItem( &( pxTCB->xGenericListItem ) );
 	vListInitialiseItem( &( pxTCB->xEventListItem ) );
 
@@ -20,6 +20,10 @@
  * @file
  * @ingroup Drivers
  *
+ * 20261014 : Added the timed mode that converts a channel on each match of SYS_CFG_ADC_TIMER
+ * 20261014 : The conversion result is given to the task by an os_signal_t instead of a queue
+ * 20261014 : Added oversampling and decimation of the burst mode conversions
+ * 20261014 : Added burst mode that captures conversions continuously using the GPDMA
  * 20131202 : Enclosed adc conversion inside critical section
  * 20131101 : Fix possible divide by zero.  i was set to 0 during loop init
  */
@@ -28,6 +32,10 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
+#include <stdint.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "semphr.h"
 
 
 
@@ -44,6 +52,114 @@ void adc0_init(void);
  */
 uint16_t adc0_get_reading(uint8_t channel_num);
 
+/// The number of ADC channels
+#define ADC0_MAX_CHANNELS   8
+
+/// The number of latest burst mode frames kept in the ring buffer (one conversion of each channel per frame)
+#define ADC0_BURST_FRAMES   32
+
+/// Statistics of a block of burst mode conversions of one channel
+typedef struct {
+    uint16_t avg;       ///< Average of the conversions
+    uint16_t min;       ///< Minimum of the conversions
+    uint16_t max;       ///< Maximum of the conversions
+    uint16_t count;     ///< Number of conversions in the block
+} adc0_stats_t;
+
+/**
+ * Starts burst mode on a set of channels.  The ADC converts the channels continuously,
+ * and the GPDMA copies every round of conversions (a frame) to a ring buffer without
+ * interrupting the CPU.  adc0_get_reading() blocks until adc0_burst_stop() is called.
+ *
+ * @param channel_mask  The bitmask of the channels, such as (1 << 3) for channel 3
+ * @param rate_hz       The approximate frame rate, which is the sample rate of each channel
+ * @returns true if burst mode was started
+ * @note The same task must call adc0_burst_stop() because this holds the ADC mutex.
+ */
+bool adc0_burst_start(uint8_t channel_mask, uint32_t rate_hz);
+
+/**
+ * Gets the statistics of the latest burst mode conversions of a channel.
+ * This reads the ring buffer directly, and can be called from an ISR.
+ *
+ * @param channel_num  The channel number between 0 - 7
+ * @param num_frames   The number of latest frames, or 0 for all ADC0_BURST_FRAMES
+ * @param stats        The statistics are written here
+ * @returns true if there was at least one conversion of the channel
+ */
+bool adc0_burst_get_stats(uint8_t channel_num, uint32_t num_frames, adc0_stats_t *stats);
+
+/**
+ * @returns the average of the latest ADC0_BURST_FRAMES conversions of the channel, or 0 if
+ *          there are no conversions yet.  This can be called from an ISR.
+ */
+uint16_t adc0_burst_get_average(uint8_t channel_num);
+
+/// Stops burst mode (and oversampling), and restores the ADC for adc0_get_reading()
+void adc0_burst_stop(void);
+
+/// The max rate of adc0_timed_start(), which is below the 65 clock conversions at the ADC clock of CPU / 8
+#define ADC0_TIMED_MAX_RATE_HZ  150000
+
+/**
+ * Starts the timed mode of one channel.  The match output of the timer of SYS_CFG_ADC_TIMER
+ * starts each conversion, so the samples are exactly periodic regardless of the task
+ * scheduling, and the GPDMA copies each conversion to the ring buffer of burst mode without
+ * interrupting the CPU.  adc0_burst_get_stats() gets the latest conversions in the same way,
+ * and adc0_burst_stop() stops the timed mode and its timer.
+ *
+ * @param channel_num  The channel number between 0 - 7
+ * @param rate_hz      The sample rate from 1Hz to ADC0_TIMED_MAX_RATE_HZ
+ * @returns true if the timed mode was started
+ * @note The same task must call adc0_burst_stop() because this holds the ADC mutex.
+ */
+bool adc0_timed_start(uint8_t channel_num, uint32_t rate_hz);
+
+/// The max extra bits of oversampling, which sums 4^6 = 4096 conversions to an 18-bit result
+#define ADC0_OVS_MAX_BITS       6
+
+/// The max length of the boxcar (moving average) filter of the oversampled results
+#define ADC0_OVS_MAX_BOXCAR     8
+
+/// The sample rate of adc0_get_oversampled()
+#define ADC0_OVS_RATE_HZ        64000
+
+/**
+ * Starts burst mode with oversampling and decimation.  The DMA interrupts every half of the
+ * ring buffer, and the interrupt accumulates the conversions of each channel.  Every 4^extra_bits
+ * conversions are decimated to one result of 12 + extra_bits bits, so the white noise is reduced
+ * as if the ADC had the extra bits of resolution.  The plain sum and dump is a first order CIC
+ * decimator, and boxcar_len > 1 adds a moving average of the latest results as its second stage.
+ * adc0_burst_get_stats() can still be used, and adc0_burst_stop() stops the oversampling.
+ *
+ * @param channel_mask  The bitmask of the channels, such as (1 << 3) for channel 3
+ * @param rate_hz       The approximate sample rate of each channel
+ * @param extra_bits    The extra bits of each result, up to ADC0_OVS_MAX_BITS
+ * @param boxcar_len    The number of results averaged by the filter, 0 or 1 disables the filter
+ * @param ready_sem     Optional semaphore given from the ISR when there are new results
+ * @returns true if oversampling was started
+ * @note The same task must call adc0_burst_stop() because this holds the ADC mutex.
+ */
+bool adc0_oversample_start(uint8_t channel_mask, uint32_t rate_hz, uint8_t extra_bits,
+                           uint8_t boxcar_len, SemaphoreHandle_t ready_sem);
+
+/**
+ * Gets the latest oversampled result of a channel.  This can be called from an ISR.
+ * @param channel_num  The channel number between 0 - 7
+ * @param value        The result of 12 + extra_bits bits is written here
+ * @param seq          Optional: the number of results of the channel so far is written here
+ * @returns true if there is a result of the channel
+ */
+bool adc0_oversample_get(uint8_t channel_num, uint32_t *value, uint32_t *seq);
+
+/**
+ * Gets one oversampled reading of a channel, which is much faster than averaging the same
+ * number of adc0_get_reading() calls.  If burst mode is in use, this falls back to the sum
+ * of 4^extra_bits single conversions.
+ * @returns the reading of 12 + extra_bits bits
+ */
+uint32_t adc0_get_oversampled(uint8_t channel_num, uint8_t extra_bits);
+
 
 
 #ifdef __cplusplus
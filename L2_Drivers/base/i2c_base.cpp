@@ -35,12 +35,11 @@
 
 
 
-void I2C_Base::handleInterrupt()
+RAMFUNC void I2C_Base::handleInterrupt()
 {
-    /* If transfer finished (not busy), then give the signal */
+    /* If transfer finished (not busy), then continue with the next transaction */
     if (busy != i2cStateMachine()) {
-        long higherPriorityTaskWaiting = 0;
-        xSemaphoreGiveFromISR(mTransferCompleteSignal, &higherPriorityTaskWaiting);
+        const long higherPriorityTaskWaiting = i2cCompleteTransaction(false);
         portEND_SWITCHING_ISR(higherPriorityTaskWaiting);
     }
 }
@@ -79,30 +78,30 @@ bool I2C_Base::transfer(uint8_t deviceAddress, uint8_t firstReg, uint8_t* pData,
     // If scheduler not running, perform polling transaction
     if(taskSCHEDULER_RUNNING != xTaskGetSchedulerState())
     {
-        i2cKickOffTransfer(deviceAddress, firstReg, pData, transferSize);
-
-        // Wait for transfer to finish
-        const uint64_t timeout = sys_get_uptime_ms() + I2C_TIMEOUT_MS;
-        while (!xSemaphoreTake(mTransferCompleteSignal, 0)) {
-            if (sys_get_uptime_ms() > timeout) {
-                break;
+        if (i2cSubmitSyncTransfer(deviceAddress, firstReg, pData, transferSize))
+        {
+            // Wait for transfer to finish
+            const uint64_t timeout = sys_get_uptime_ms() + I2C_TIMEOUT_MS;
+            while (mSyncJob.busy && sys_get_uptime_ms() <= timeout) {
+                ;
             }
-        }
 
-        status = (0 == mTransaction.error);
+            // If the job could be cancelled, it did not finish in time
+            status = !cancel(&mSyncJob) && (0 == mSyncJob.error);
+        }
     }
-    else if (xSemaphoreTake(mI2CMutex, OS_MS(I2C_TIMEOUT_MS)))
+    else if (os_lock_take(&mLockStats, mI2CMutex, OS_MS(I2C_TIMEOUT_MS)))
     {
-        // Clear potential stale signal and start the transfer
-        xSemaphoreTake(mTransferCompleteSignal, 0);
-        i2cKickOffTransfer(deviceAddress, firstReg, pData, transferSize);
-
-        // Wait for transfer to finish and copy the data if it was read mode
-        if (xSemaphoreTake(mTransferCompleteSignal, OS_MS(I2C_TIMEOUT_MS))) {
-            status = (0 == mTransaction.error);
+        // Clear potential stale signal and queue the transfer after the asynchronous jobs
+        os_signal_clear(&mTransferComplete);
+        if (i2cSubmitSyncTransfer(deviceAddress, firstReg, pData, transferSize))
+        {
+            // Wait for transfer to finish, and make sure the ISR no longer uses our data
+            os_signal_wait(&mTransferComplete, OS_MS(I2C_TIMEOUT_MS));
+            status = !cancel(&mSyncJob) && (0 == mSyncJob.error);
         }
 
-        xSemaphoreGive(mI2CMutex);
+        os_lock_give(&mLockStats, mI2CMutex);
     }
 
     return status;
@@ -119,27 +118,139 @@ bool I2C_Base::checkDeviceResponse(uint8_t deviceAddress)
     return readRegisters(deviceAddress, dummyReg, &notUsed, lenZeroToTestDeviceReady);
 }
 
+bool I2C_Base::setDeviceSpeed(uint8_t deviceAddress, uint32_t maxSpeedKhz)
+{
+    const uint8_t addr = I2C_WRITE_ADDR(deviceAddress);
+    const uint16_t speedKhz = (maxSpeedKhz > mMaxKhz) ? mMaxKhz : maxSpeedKhz;
+    uint8_t i = 0;
+
+    if (0 == speedKhz) {
+        return false;
+    }
+
+    for (i = 0; i < mNumDeviceSpeeds; i++) {
+        if (addr == mDeviceSpeedAddr[i]) {
+            mDeviceSpeedKhz[i] = speedKhz;
+            return true;
+        }
+    }
+
+    if (mNumDeviceSpeeds >= I2C_MAX_DEVICE_SPEEDS) {
+        return false;
+    }
+
+    // The I2C interrupt only looks at the entry after it is counted
+    mDeviceSpeedAddr[i] = addr;
+    mDeviceSpeedKhz[i] = speedKhz;
+    ++mNumDeviceSpeeds;
+    return true;
+}
+
+bool I2C_Base::submit(I2C_Job_t *pJob)
+{
+    if (mDisableOperation || !pJob || !pJob->pTrx || 0 == pJob->numTrx || pJob->busy) {
+        return false;
+    }
+    for (uint32_t i = 0; i < pJob->numTrx; i++) {
+        if (!pJob->pTrx[i].pData) {
+            return false;
+        }
+    }
+
+    pJob->error = 0;
+    pJob->trxDone = 0;
+    pJob->pNext = NULL;
+    pJob->busy = true;
+
+    /* The queue is shared with the I2C interrupt, which may also submit jobs from the callbacks */
+    NVIC_DisableIRQ(mIRQ);
+    if (mpJobTail) {
+        mpJobTail->pNext = pJob;
+        mpJobTail = pJob;
+    }
+    else {
+        mpJobHead = mpJobTail = pJob;
+        i2cStartJobTransaction();
+    }
+    NVIC_EnableIRQ(mIRQ);
+
+    return true;
+}
+
+bool I2C_Base::cancel(I2C_Job_t *pJob)
+{
+    bool removed = false;
+    if (!pJob) {
+        return removed;
+    }
+
+    NVIC_DisableIRQ(mIRQ);
+    if (pJob->busy)
+    {
+        if (mpJobHead == pJob) {
+            // Stop the transaction in progress, and start the next job
+            mpI2CRegs->I2CONCLR = 0x20;
+            mpI2CRegs->I2CONSET = 0x10;
+            mpI2CRegs->I2CONCLR = 0x08;
+            i2cCompleteTransaction(true);
+        }
+        else {
+            for (I2C_Job_t *pPrev = mpJobHead; pPrev; pPrev = pPrev->pNext) {
+                if (pPrev->pNext == pJob) {
+                    pPrev->pNext = pJob->pNext;
+                    if (mpJobTail == pJob) {
+                        mpJobTail = pPrev;
+                    }
+                    break;
+                }
+            }
+            pJob->pNext = NULL;
+            pJob->busy = false;
+        }
+        removed = true;
+    }
+    NVIC_EnableIRQ(mIRQ);
+
+    return removed;
+}
+
 I2C_Base::I2C_Base(LPC_I2C_TypeDef* pI2CBaseAddr) :
         mpI2CRegs(pI2CBaseAddr),
-        mDisableOperation(false)
+        mDisableOperation(false),
+        mPclk(0),
+        mBusKhz(100),
+        mMaxKhz(400),
+        mCurrentKhz(0),
+        mNumDeviceSpeeds(0),
+        mpJobHead(NULL),
+        mpJobTail(NULL)
 {
     mI2CMutex = xSemaphoreCreateMutex();
-    mTransferCompleteSignal = xSemaphoreCreateBinary();
+    os_signal_clear(&mTransferComplete);
+    memset(&mLockStats, 0, sizeof(mLockStats));
+    mLockStats.name = "i2c";
 
-    /// Binary semaphore needs to be taken after creating it
-    xSemaphoreTake(mTransferCompleteSignal, 0);
+    /* The synchronous transfers are jobs of a single transaction */
+    memset(&mSyncTrx, 0, sizeof(mSyncTrx));
+    memset(&mSyncJob, 0, sizeof(mSyncJob));
+    mSyncJob.pTrx = &mSyncTrx;
+    mSyncJob.numTrx = 1;
 
     if((unsigned int)mpI2CRegs == LPC_I2C0_BASE)
     {
         mIRQ = I2C0_IRQn;
+        mMaxKhz = 1000; // The I2C0 pins support the Fast-mode Plus
+        mLockStats.name = "i2c0";
     }
     else if((unsigned int)mpI2CRegs == LPC_I2C1_BASE)
     {
         mIRQ = I2C1_IRQn;
+        mLockStats.name = "i2c1";
     }
     else if((unsigned int)mpI2CRegs == LPC_I2C2_BASE)
     {
         mIRQ = I2C2_IRQn;
+        mLockStats.name = "i2c2";
     }
     else {
         mIRQ = (IRQn_Type)99; // Using invalid IRQ on purpose
@@ -151,6 +262,14 @@ I2C_Base::I2C_Base(LPC_I2C_TypeDef* pI2CBaseAddr) :
     slaveBufLen = 0;
     slaveCount = 0;
     slaveIndex = 0;
+    mpSlaveRegs = NULL;
+    mNumSlaveRegs = 0;
+    mSlaveReg = 0;
+    mSlaveRegReceived = false;
+    mSlaveCount = 0;
+    mSlaveTxIndex = 0;
+    mSlaveTxSize = 0;
+    mSlaveWriteQueue = NULL;
 }
 
 bool I2C_Base::init(uint32_t pclk, uint32_t busRateInKhz)
@@ -165,21 +284,14 @@ bool I2C_Base::init(uint32_t pclk, uint32_t busRateInKhz)
 
     mpI2CRegs->I2CONCLR = 0x6C;           // Clear ALL I2C Flags
 
-    /**
-     * Per I2C high speed mode:
-     * HS mode master devices generate a serial clock signal with a HIGH to LOW ratio of 1 to 2.
-     * So to be able to optimize speed, we use different duty cycle for high/low
-     *
-     * Compute the I2C clock dividers.
-     * The LOW period can be longer than the HIGH period because the rise time
-     * of SDA/SCL is an RC curve, whereas the fall time is a sharper curve.
-     */
-    const uint32_t percent_high = 40;
-    const uint32_t percent_low = (100 - percent_high);
-    const uint32_t freq_hz = (busRateInKhz > 1000) ? (100 * 1000) : (busRateInKhz * 1000);
-    const uint32_t half_clock_divider = (pclk / freq_hz) / 2;
-    mpI2CRegs->I2SCLH = (half_clock_divider * percent_high) / 100;
-    mpI2CRegs->I2SCLL = (half_clock_divider * percent_low ) / 100;
+    // Invalid speeds use the standard speed, and the speed is limited to what the pins support
+    mPclk = pclk;
+    mBusKhz = (0 == busRateInKhz || busRateInKhz > 1000) ? 100 : busRateInKhz;
+    if (mBusKhz > mMaxKhz) {
+        mBusKhz = mMaxKhz;
+    }
+    i2cSetClock(mBusKhz);
+    sys_clock_add_listener(cpuClockChanged, this);
 
     // Set I2C slave address and enable I2C
     mpI2CRegs->I2ADR0 = 0;
@@ -202,6 +314,69 @@ bool I2C_Base::initSlave(const uint8_t addr, uint8_t *buf, unsigned int len)
 
     slaveBuf = buf;
     slaveBufLen = len;
+    mpSlaveRegs = NULL;
+
+    return i2cEnableSlave(addr);
+}
+
+bool I2C_Base::initSlaveRegisters(const uint8_t addr, I2C_SlaveReg_t *pRegs, uint8_t numRegs)
+{
+    if (!pRegs || !numRegs) {
+        return false;
+    }
+    for (uint8_t i = 0; i < numRegs; i++) {
+        if (!pRegs[i].pData || pRegs[i].size > I2C_SLAVE_MAX_REG_SIZE) {
+            return false;
+        }
+    }
+
+    if (!mSlaveWriteQueue) {
+        mSlaveWriteQueue = xQueueCreate(I2C_SLAVE_WRITE_QUEUE, sizeof(uint8_t));
+    }
+
+    mSlaveReg = 0;
+    mSlaveRegReceived = false;
+    mSlaveCount = 0;
+    mNumSlaveRegs = numRegs;
+    mpSlaveRegs = pRegs;
+
+    return i2cEnableSlave(addr);
+}
+
+bool I2C_Base::slaveWriteRegister(uint8_t reg, const void *pData, uint8_t len)
+{
+    if (!mpSlaveRegs || reg >= mNumSlaveRegs || !pData || len > mpSlaveRegs[reg].size) {
+        return false;
+    }
+
+    NVIC_DisableIRQ(mIRQ);
+    memcpy(mpSlaveRegs[reg].pData, pData, len);
+    NVIC_EnableIRQ(mIRQ);
+    return true;
+}
+
+bool I2C_Base::slaveReadRegister(uint8_t reg, void *pData, uint8_t len)
+{
+    if (!mpSlaveRegs || reg >= mNumSlaveRegs || !pData || len > mpSlaveRegs[reg].size) {
+        return false;
+    }
+
+    NVIC_DisableIRQ(mIRQ);
+    memcpy(pData, mpSlaveRegs[reg].pData, len);
+    NVIC_EnableIRQ(mIRQ);
+    return true;
+}
+
+bool I2C_Base::slaveWaitForWrite(uint8_t &reg, uint32_t timeoutMs)
+{
+    return mSlaveWriteQueue && xQueueReceive(mSlaveWriteQueue, &reg, OS_MS(timeoutMs));
+}
+
+
+/// Private ///
+
+bool I2C_Base::i2cEnableSlave(const uint8_t addr)
+{
     slave_mode = true;
 
     switch(mIRQ) {
@@ -230,8 +405,122 @@ bool I2C_Base::initSlave(const uint8_t addr, uint8_t *buf, unsigned int len)
     return slave_mode;
 }
 
+bool I2C_Base::i2cSubmitSyncTransfer(uint8_t deviceAddress, uint8_t firstReg, uint8_t* pData, uint32_t transferSize)
+{
+    mSyncTrx.deviceAddress = I2C_WRITE_ADDR(deviceAddress);
+    mSyncTrx.firstReg = firstReg;
+    mSyncTrx.read = I2C_READ_MODE(deviceAddress);
+    mSyncTrx.pData = pData;
+    mSyncTrx.size = transferSize;
 
-/// Private ///
+    return submit(&mSyncJob);
+}
+
+bool I2C_Base::i2cCompleteTransaction(bool aborted)
+{
+    long higherPriorityTaskWaiting = 0;
+    I2C_Job_t *pJob = mpJobHead;
+
+    if (!pJob) {
+        return false;
+    }
+
+    // Continue with the next transaction of the job unless a transaction failed
+    if (!aborted && 0 == mTransaction.error && ++pJob->trxDone < pJob->numTrx) {
+        i2cStartJobTransaction();
+        return false;
+    }
+
+    // Remove the job from the queue before the callback, so the callback may submit it again
+    I2C_Job_t *pNextJob = pJob->pNext;
+    mpJobHead = pNextJob;
+    if (!mpJobHead) {
+        mpJobTail = NULL;
+    }
+    pJob->pNext = NULL;
+    pJob->error = mTransaction.error;
+    pJob->busy = false;
+
+    if (!aborted) {
+        if (pJob->callback) {
+            pJob->callback(pJob);
+        }
+        if (pJob->doneSignal) {
+            xSemaphoreGiveFromISR(pJob->doneSignal, &higherPriorityTaskWaiting);
+        }
+        if (&mSyncJob == pJob && os_signal_give_from_isr(&mTransferComplete)) {
+            higherPriorityTaskWaiting = 1;
+        }
+    }
+
+    // If the queue was empty, a job submitted by the callback has already been started
+    if (pNextJob) {
+        i2cStartJobTransaction();
+    }
+
+    return higherPriorityTaskWaiting;
+}
+
+void I2C_Base::i2cStartJobTransaction(void)
+{
+    const I2C_Trx_t *pTrx = &(mpJobHead->pTrx[mpJobHead->trxDone]);
+    uint8_t addr = pTrx->deviceAddress;
+    uint16_t speedKhz = mBusKhz;
+
+    // The previous transaction has ended, so the clock can be changed for this device
+    for (uint8_t i = 0; i < mNumDeviceSpeeds; i++) {
+        if (I2C_WRITE_ADDR(addr) == mDeviceSpeedAddr[i]) {
+            speedKhz = mDeviceSpeedKhz[i];
+            break;
+        }
+    }
+    if (speedKhz != mCurrentKhz) {
+        i2cSetClock(speedKhz);
+    }
+
+    if (pTrx->read) {
+        I2C_SET_READ_MODE(addr);
+    }
+    else {
+        I2C_SET_WRITE_MODE(addr);
+    }
+    i2cKickOffTransfer(addr, pTrx->firstReg, pTrx->pData, pTrx->size);
+}
+
+void I2C_Base::i2cSetClock(uint16_t speedKhz)
+{
+    /**
+     * Per I2C high speed mode:
+     * HS mode master devices generate a serial clock signal with a HIGH to LOW ratio of 1 to 2.
+     * So to be able to optimize speed, we use different duty cycle for high/low
+     *
+     * Compute the I2C clock dividers, where the bit rate is PCLK / (SCLH + SCLL).
+     * The LOW period can be longer than the HIGH period because the rise time
+     * of SDA/SCL is an RC curve, whereas the fall time is a sharper curve.
+     */
+    const uint32_t percent_high = 40;
+    const uint32_t min_count = 4;   // The smallest SCLH and SCLL the hardware supports
+    const uint32_t clock_divider = mPclk / (speedKhz * 1000);
+    uint32_t high = (clock_divider * percent_high) / 100;
+
+    if (high < min_count) {
+        high = min_count;
+    }
+    mpI2CRegs->I2SCLH = high;
+    mpI2CRegs->I2SCLL = (clock_divider > high + min_count) ? (clock_divider - high) : min_count;
+    mCurrentKhz = speedKhz;
+}
+
+void I2C_Base::cpuClockChanged(void *pI2C, unsigned int oldCpuHz, unsigned int newCpuHz)
+{
+    I2C_Base *pThis = (I2C_Base*) pI2C;
+
+    // The I2C peripheral clock is a fixed divider of the CPU clock
+    pThis->mPclk = ((uint64_t) pThis->mPclk * newCpuHz) / oldCpuHz;
+    if (pThis->mCurrentKhz) {
+        pThis->i2cSetClock(pThis->mCurrentKhz);
+    }
+}
 
 void I2C_Base::i2cKickOffTransfer(uint8_t devAddr, uint8_t regStart, uint8_t* pBytes, uint32_t len)
 {
@@ -259,7 +548,7 @@ void I2C_Base::i2cKickOffTransfer(uint8_t devAddr, uint8_t regStart, uint8_t* pB
  * 0x20 START
  * 0x40 ENABLE
  */
-I2C_Base::mStateMachineStatus_t I2C_Base::i2cStateMachine()
+RAMFUNC I2C_Base::mStateMachineStatus_t I2C_Base::i2cStateMachine()
 {
     enum {
         // General states :
@@ -343,6 +632,11 @@ I2C_Base::mStateMachineStatus_t I2C_Base::i2cStateMachine()
     #define I2C_STATUS_END      0x1
     #define I2C_STATUS_RESTART  0xff
 
+    // The slave register bank handles all the slave states
+    if (mpSlaveRegs && i2cSlaveRegisterState(mpI2CRegs->I2STAT)) {
+        return state;
+    }
+
     switch (mpI2CRegs->I2STAT)
     {
         case ownSLAWAcked:
@@ -499,3 +793,87 @@ I2C_Base::mStateMachineStatus_t I2C_Base::i2cStateMachine()
 
     return state;
 }
+
+bool I2C_Base::i2cSlaveRegisterState(uint32_t status)
+{
+    long higherPriorityTaskWaiting = 0;
+    I2C_SlaveReg_t *pReg = NULL;
+
+    switch (status)
+    {
+        // Own address or the general call for a write, which starts with the register number
+        case 0x68: // no break
+        case 0x78:
+            mpI2CRegs->I2CONSET = 0x20; // Retry our master transfer when the bus is free
+        case 0x60: // no break
+        case 0x70:
+            mSlaveRegReceived = false;
+            mSlaveCount = 0;
+            break;
+
+        case 0x80: // no break
+        case 0x88: // no break
+        case 0x90: // no break
+        case 0x98:
+            if (!mSlaveRegReceived) {
+                mSlaveReg = mpI2CRegs->I2DAT;
+                mSlaveRegReceived = true;
+            }
+            else if (mSlaveCount < sizeof(mSlaveData)) {
+                mSlaveData[mSlaveCount++] = mpI2CRegs->I2DAT;
+            }
+            break;
+
+        // Stop or repeated start: the written data is copied to the register at once
+        case 0xA0:
+            if (mSlaveRegReceived && mSlaveCount > 0 && mSlaveReg < mNumSlaveRegs && mpSlaveRegs[mSlaveReg].writable) {
+                pReg = &mpSlaveRegs[mSlaveReg];
+                const uint8_t len = (mSlaveCount > pReg->size) ? pReg->size : mSlaveCount;
+
+                memcpy(pReg->pData, &mSlaveData[0], len);
+                if (pReg->onWrite) {
+                    pReg->onWrite(mSlaveReg, pReg->pData, len);
+                }
+                if (mSlaveWriteQueue) {
+                    xQueueSendFromISR(mSlaveWriteQueue, &mSlaveReg, &higherPriorityTaskWaiting);
+                }
+            }
+            mSlaveCount = 0;
+            break;
+
+        // Own address for a read: the snapshot of the register is sent to the master
+        case 0xB0:
+            mpI2CRegs->I2CONSET = 0x20; // Retry our master transfer when the bus is free
+        case 0xA8: // no break
+            mSlaveRegReceived = false;
+            mSlaveCount = 0;
+            mSlaveTxIndex = 0;
+            mSlaveTxSize = 0;
+            if (mSlaveReg < mNumSlaveRegs) {
+                pReg = &mpSlaveRegs[mSlaveReg];
+                if (pReg->onRead) {
+                    pReg->onRead(mSlaveReg, pReg->pData, pReg->size);
+                }
+                memcpy(&mSlaveData[0], pReg->pData, pReg->size);
+                mSlaveTxSize = pReg->size;
+            }
+            // no break
+        case 0xB8:
+            mpI2CRegs->I2DAT = (mSlaveTxIndex < mSlaveTxSize) ? mSlaveData[mSlaveTxIndex++] : 0xFF;
+            break;
+
+        case 0xC0: // no break
+        case 0xC8:
+            break;
+
+        default:
+            return false;
+    }
+
+    // Keep acknowledging our address, and clear the interrupt
+    mpI2CRegs->I2CONSET = 0x04;
+    mpI2CRegs->I2CONCLR = 0x08;
+    portEND_SWITCHING_ISR(higherPriorityTaskWaiting);
+
+    return true;
+}
@@ -20,6 +20,11 @@
  * @file  i2c_base.hpp
  * @brief Provides I2C Base class functionality for I2C peripherals
  *
+ * 20261014 : The synchronous transfers wait for an os_signal_t instead of a semaphore.
+ * 20261014 : Added the register bank of the slave mode.
+ * 20261014 : Added the bus speed of each device, which is set before each transaction.
+ * 20261014 : Added the queue of asynchronous jobs, which are lists of transactions chained
+ *            by the I2C interrupt.  The synchronous transfers are queued as jobs too.
  * 20140212 : Improved the driver by not having internal memory to copy the
  *            transaction's data.  The buffer supplied from the user is used directly.
  * 20131211 : Used timeout for read/write semaphore (instead of portMAX_DELAY)
@@ -34,6 +39,9 @@
 #include "FreeRTOS.h"
 #include "task.h"       // xTaskGetSchedulerState()
 #include "semphr.h"     // Semaphores used in I2C
+#include "queue.h"      // Queue of the slave register writes
+#include "os_signal.h"  // Completion of the synchronous transfers
+#include "os_lock_stats.h"  // Contention of the I2C Mutex
 #include "LPC17xx.h"
 
 
@@ -45,6 +53,80 @@
  */
 #define I2C_TIMEOUT_MS          1000
 
+/// The number of devices that can have their own bus speed set by I2C_Base::setDeviceSpeed()
+#define I2C_MAX_DEVICE_SPEEDS   8
+
+/// The maximum size of a register of the slave register bank
+#define I2C_SLAVE_MAX_REG_SIZE  32
+
+/// The number of master writes queued for I2C_Base::slaveWaitForWrite()
+#define I2C_SLAVE_WRITE_QUEUE   8
+
+
+
+/**
+ * A transaction of an I2C job, which reads or writes the registers starting from firstReg
+ */
+typedef struct
+{
+    uint8_t deviceAddress;  ///< The I2C device address
+    uint8_t firstReg;       ///< The first register to read or write
+    bool read;              ///< true to read the registers, false to write them
+    uint8_t *pData;         ///< The data to read or write
+    uint32_t size;          ///< The number of bytes to read or write
+} I2C_Trx_t;
+
+/**
+ * Callback of a slave register, which is called from the I2C interrupt so it should be short.
+ * @param reg    The register number
+ * @param pData  The data of the register
+ * @param len    The number of bytes written by the master, or the size of the register for a read
+ */
+typedef void (*I2C_SlaveRegCallback_t)(uint8_t reg, uint8_t *pData, uint8_t len);
+
+/**
+ * A register of the slave register bank.  The master writes the register number first, followed
+ * by the data to write, or by a repeated start to read the register.
+ *
+ * When the master addresses the register for a read, the register is copied to a snapshot
+ * that is sent to the master, so a multi-byte read is never torn by an update of the application.
+ * The written bytes are also collected before they are copied to the register at the end of the write.
+ */
+typedef struct
+{
+    uint8_t *pData;                 ///< The data of the register
+    uint8_t size;                   ///< The size of the register, up to I2C_SLAVE_MAX_REG_SIZE
+    bool writable;                  ///< The master can write the register
+    I2C_SlaveRegCallback_t onRead;  ///< Optional callback before the snapshot is taken for a read
+    I2C_SlaveRegCallback_t onWrite; ///< Optional callback after the master wrote the register
+} I2C_SlaveReg_t;
+
+struct I2C_Job;
+
+/**
+ * Callback of a completed job, which is called from the I2C interrupt so it
+ * should be short and may only use the FreeRTOS "FromISR" API.
+ */
+typedef void (*I2C_JobCallback_t)(struct I2C_Job *pJob);
+
+/**
+ * An asynchronous I2C job, which is a list of transactions performed back to back by the
+ * I2C interrupt.  The job and its data must exist until the job is completed.
+ */
+typedef struct I2C_Job
+{
+    I2C_Trx_t *pTrx;                ///< The transactions of the job
+    uint32_t numTrx;                ///< The number of transactions
+    I2C_JobCallback_t callback;     ///< Optional callback when the job is completed
+    void *pArg;                     ///< Argument for the callback
+    SemaphoreHandle_t doneSignal;   ///< Optional semaphore given when the job is completed
+
+    volatile bool busy;             ///< The job is queued or in progress
+    volatile uint8_t error;         ///< The I2C status of the failed transaction, or 0 upon success
+    volatile uint32_t trxDone;      ///< The number of transactions completed successfully
+    struct I2C_Job *pNext;          ///< Next job of the queue (private)
+} I2C_Job_t;
+
 
 /**
  * I2C Base class that can be used to write drivers for all I2C peripherals.
@@ -108,6 +190,65 @@ class I2C_Base
          */
         bool checkDeviceResponse(uint8_t deviceAddress);
 
+        /**
+         * Sets the bus speed used for the transactions of a device, so slow and fast devices
+         * can share the bus while the fast ones run at their full rate.  The clock is changed
+         * between the transactions, and devices that are not set use the speed given to init().
+         *
+         * @param deviceAddress  The I2C device address
+         * @param maxSpeedKhz    The maximum speed of the device, which is limited to the
+         *                       speed supported by the I2C pins: 1000Khz (Fast-mode Plus)
+         *                       for I2C0, and 400Khz for I2C1 and I2C2.
+         * @returns false if there is no more room for another device
+         */
+        bool setDeviceSpeed(uint8_t deviceAddress, uint32_t maxSpeedKhz);
+
+        /**
+         * @{ Access to the registers of the slave register bank set by initSlaveRegisters().
+         * The copy is atomic with respect to the I2C interrupt.
+         * @returns false if the register or the length is invalid
+         */
+        bool slaveWriteRegister(uint8_t reg, const void *pData, uint8_t len);
+        bool slaveReadRegister(uint8_t reg, void *pData, uint8_t len);
+        /** @} */
+
+        /**
+         * Waits for the master to write a register of the slave register bank.
+         * @param reg  The register that was written
+         * @returns false if no register was written within the timeout
+         */
+        bool slaveWaitForWrite(uint8_t &reg, uint32_t timeoutMs);
+
+        /**
+         * Queues an asynchronous job, which is started right away if the I2C is idle.
+         * The I2C interrupt performs all the transactions of the job, and of the jobs queued
+         * after it, without any task involvement.  When the job completes, or if any of
+         * its transactions fail, its callback is called and its doneSignal is given.
+         *
+         * For example, all the board sensors can be read with one task wake-up:
+         * @code
+         *      static uint8_t xyz[6], temp[2];
+         *      static I2C_Trx_t trx[] = { { 0x38, 0x01, true, xyz, sizeof(xyz) },
+         *                                 { 0x90, 0x00, true, temp, sizeof(temp) } };
+         *      static I2C_Job_t job = { trx, 2, NULL, NULL, xSemaphoreCreateBinary() };
+         *
+         *      I2C2::getInstance().submit(&job);
+         *      if (xSemaphoreTake(job.doneSignal, OS_MS(100)) && 0 == job.error) {
+         *          // Use xyz[] and temp[]
+         *      }
+         * @endcode
+         *
+         * @returns false if the job is invalid, or is already queued
+         */
+        bool submit(I2C_Job_t *pJob);
+
+        /**
+         * Removes a job from the queue if it has not completed yet.  If the job is in progress,
+         * its current transaction is stopped, and its callback is not called.
+         * @returns true if the job was removed, or false if it had already completed
+         */
+        bool cancel(I2C_Job_t *pJob);
+
 
 
     protected:
@@ -129,6 +270,14 @@ class I2C_Base
          */
         bool initSlave(const uint8_t addr, uint8_t *buf, unsigned int len);
 
+        /**
+         * Configure I2C as Slave mode with a register bank, which is handled by the I2C interrupt.
+         * @param addr     The slave address
+         * @param pRegs    The registers, which must exist as long as the slave mode is used
+         * @param numRegs  The number of registers
+         */
+        bool initSlaveRegisters(const uint8_t addr, I2C_SlaveReg_t *pRegs, uint8_t numRegs);
+
         /**
          * Disables I2C operation
          * This can be used to disable all I2C operations in case of severe I2C Bus Failure
@@ -142,12 +291,33 @@ class I2C_Base
         IRQn_Type        mIRQ;         ///< IRQ of this I2C
         bool mDisableOperation;        ///< Tracks if I2C is disabled by disableOperation()
         SemaphoreHandle_t mI2CMutex;   ///< I2C Mutex used when FreeRTOS is running
-        SemaphoreHandle_t mTransferCompleteSignal; ///< Signal that indicates read is complete
+        os_lock_stats_t mLockStats;    ///< The contention statistics of mI2CMutex
+        os_signal_t mTransferComplete; ///< Signal that indicates the synchronous transfer is complete
+        uint32_t mPclk;                ///< The peripheral clock given to init()
+        uint16_t mBusKhz;              ///< The bus speed given to init()
+        uint16_t mMaxKhz;              ///< The maximum bus speed of the I2C pins
+        uint16_t mCurrentKhz;          ///< The bus speed currently programmed
+        uint8_t mNumDeviceSpeeds;      ///< The number of devices that have their own speed
+        uint8_t mDeviceSpeedAddr[I2C_MAX_DEVICE_SPEEDS];  ///< The addresses of the devices with their own speed
+        uint16_t mDeviceSpeedKhz[I2C_MAX_DEVICE_SPEEDS];  ///< The bus speeds of the devices
+        I2C_Job_t *mpJobHead;          ///< The job in progress, followed by the queued jobs
+        I2C_Job_t *mpJobTail;          ///< The last queued job
+        I2C_Trx_t mSyncTrx;            ///< The transaction of the synchronous transfer()
+        I2C_Job_t mSyncJob;            ///< The job of the synchronous transfer()
         bool slave_mode;               ///< Flag for running in Slave mode
         uint8_t *slaveBuf;             ///< I2C slave buffer when acting in Slave mode
         uint8_t slaveBufLen;           ///< I2C slave buffer length when acting in Slave mode
         uint32_t slaveCount;           ///< I2C slave counter for actual data
         uint32_t slaveIndex;           ///< I2C slave buffer index
+        I2C_SlaveReg_t *mpSlaveRegs;   ///< The slave register bank, or NULL for the slave buffer mode
+        uint8_t mNumSlaveRegs;         ///< The number of registers of the register bank
+        uint8_t mSlaveReg;             ///< The register addressed by the master
+        bool mSlaveRegReceived;        ///< The master has written the register number
+        uint8_t mSlaveCount;           ///< The bytes written by the master
+        uint8_t mSlaveTxIndex;         ///< The next byte of the snapshot to send to the master
+        uint8_t mSlaveTxSize;          ///< The size of the snapshot
+        uint8_t mSlaveData[I2C_SLAVE_MAX_REG_SIZE]; ///< The bytes written by the master, or the snapshot for a read
+        QueueHandle_t mSlaveWriteQueue;///< The registers written by the master
 
         /**
          * The status of I2C is returned from the I2C function that handles state machine
@@ -182,6 +352,15 @@ class I2C_Base
          */
         mStateMachineStatus_t i2cStateMachine();
 
+        /**
+         * Handles the slave states when the slave register bank is used
+         * @returns false if the state is not a slave state
+         */
+        bool i2cSlaveRegisterState(uint32_t status);
+
+        /// Powers on the I2C, and enables it to acknowledge its slave address
+        bool i2cEnableSlave(const uint8_t addr);
+
         /**
          * Read/writes multiple bytes to an I2C device starting from the first register
          * It is assumed that like almost all I2C devices, the register address increments by 1
@@ -194,6 +373,27 @@ class I2C_Base
          */
         bool transfer(uint8_t deviceAddress, uint8_t firstReg, uint8_t* pData, uint32_t transferSize);
 
+        /// Sets the transaction of the synchronous transfer(), and queues its job
+        bool i2cSubmitSyncTransfer(uint8_t deviceAddress, uint8_t firstReg, uint8_t* pData, uint32_t transferSize);
+
+        /**
+         * Completes the current transaction of the job in progress, and starts its next
+         * transaction, or the next job of the queue.  This is called by the I2C interrupt,
+         * or with the I2C interrupt disabled.
+         * @param aborted  The job in progress is cancelled
+         * @returns true if a higher priority task was woken by the doneSignal or mTransferComplete
+         */
+        bool i2cCompleteTransaction(bool aborted);
+
+        /// Starts the current transaction of the job at the head of the queue
+        void i2cStartJobTransaction(void);
+
+        /// Programs the SCL duty cycle registers for the bus speed while the bus is idle
+        void i2cSetClock(uint16_t speedKhz);
+
+        /// Restores the bus speed when sys_clock_set_cpu_scale() changes the CPU clock
+        static void cpuClockChanged(void *pI2C, unsigned int oldCpuHz, unsigned int newCpuHz);
+
         /**
          * This is the entry point for an I2C transaction
          * @param devAddr   The address of the I2C Device
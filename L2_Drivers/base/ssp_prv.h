@@ -32,11 +32,10 @@ extern "C" {
 
 
 /**
- * Sets SSP Clock speed
+ * @returns the SSP prescaler (CPSR) of the SPI clock speed at the current CPU clock
  * @param max_clock_mhz   The maximum speed of this SPI in Megahertz
- * @note The speed may be set lower to max_clock_mhz if it cannot be attained.
  */
-static inline void ssp_set_max_clock(LPC_SSP_TypeDef *pSSP, unsigned int max_clock_mhz)
+static inline unsigned int ssp_get_clock_divider(unsigned int max_clock_mhz)
 {
     unsigned int divider = 2;
     const unsigned int cpuClockMhz = sys_get_cpu_clock() / (1000 * 1000UL);
@@ -51,7 +50,17 @@ static inline void ssp_set_max_clock(LPC_SSP_TypeDef *pSSP, unsigned int max_clo
         divider += 2;
     }
 
-    pSSP->CPSR = divider;
+    return divider;
+}
+
+/**
+ * Sets SSP Clock speed
+ * @param max_clock_mhz   The maximum speed of this SPI in Megahertz
+ * @note The speed may be set lower to max_clock_mhz if it cannot be attained.
+ */
+static inline void ssp_set_max_clock(LPC_SSP_TypeDef *pSSP, unsigned int max_clock_mhz)
+{
+    pSSP->CPSR = ssp_get_clock_divider(max_clock_mhz);
 }
 
 /**
@@ -124,6 +133,39 @@ static inline void ssp_exchange_data(LPC_SSP_TypeDef *pSSP, void* data, int len)
 
 
 
+/**
+ * DMA transfer profile of an SSP port
+ *
+ * @note 16-bit frames are sent MSB first, so the two bytes of each half-word in memory are
+ *       sent (and received) in swapped order.  This is only useful for devices that use
+ *       16-bit words, or data whose byte order does not matter, such as filling a region.
+ */
+typedef struct {
+    uint8_t frame_bits; ///< SPI frame and DMA width: 8 or 16
+    uint8_t burst;      ///< Frames moved per DMA request: 1 or 4 (more than 4 is moved as 4)
+} ssp_dma_profile_t;
+
+/**
+ * Sets up the DMA of an SSP port (SSP0 or SSP1), each of which has its own DMA channels
+ * (@see dma_ch_t) so the transfers of the two ports do not collide.
+ */
+void ssp_dma_init(LPC_SSP_TypeDef *pSSP);
+
+/**
+ * Transfers data over an SSP port using the DMA (@see ssp1_dma_transfer_block())
+ * @param pProfile  The transfer profile, or NULL to use ssp_dma_get_profile()
+ * @note  If FreeRTOS is running and this is not called from an ISR, the calling task sleeps until
+ *        the DMA interrupt signals the completion of the transfer, otherwise the DMA is polled.
+ * @return 0 upon success, or non-zero upon failure.
+ */
+unsigned ssp_dma_transfer(LPC_SSP_TypeDef *pSSP, unsigned char* pBuffer, uint32_t num_bytes, char is_write_op,
+                          const ssp_dma_profile_t *pProfile);
+
+/// @returns the fastest profile that preserves the byte order of the data
+const ssp_dma_profile_t* ssp_dma_get_profile(const unsigned char *pBuffer, uint32_t num_bytes);
+
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -20,6 +20,7 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "uart_dev.hpp"
 #include "LPC17xx.h"
@@ -28,51 +29,222 @@
 
 
 
+/**
+ * Linked list items of the rx DMA of each UART that make the DMA write to the rx buffer in circular
+ * fashion.  These are globals because GPDMA cannot access the heap memory (@see loader.ld)
+ */
+static dma_lli_t g_uart_rx_dma_lli[4][2];
+
+
+
 bool UartDev::getChar(char* pInputChar, unsigned int timeout)
 {
-    if (!pInputChar || !mRxQueue) {
+    if (mpDma) {
+        return pInputChar ? dmaGetBlock(pInputChar, 1, timeout) : false;
+    }
+
+    return getBlock(pInputChar, 1, timeout);
+}
+
+bool UartDev::putChar(char out, unsigned int timeout)
+{
+    /* If OS not running, just send data using polling and return */
+    if (taskSCHEDULER_RUNNING != xTaskGetSchedulerState()) {
+        mpUARTRegBase->THR = out;
+        while(! (mpUARTRegBase->LSR & (1 << 6)));
+        return true;
+    }
+
+    if (mpDma) {
+        return (1 == dmaPutBlock(&out, 1, timeout));
+    }
+
+    return putBlock(&out, 1, timeout);
+}
+
+bool UartDev::putBlock(const void* pData, size_t len, unsigned int timeout)
+{
+    return pData && (len == write(pData, len, timeout));
+}
+
+size_t UartDev::write(const void* pData, size_t len, unsigned int timeout)
+{
+    const char *pChars = (const char*) pData;
+    const TickType_t startTick = xTaskGetTickCount();
+    size_t sent = 0;
+
+    if (!pData) {
+        return 0;
+    }
+    else if (mpDma && taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        return dmaPutBlock(pChars, len, timeout);
+    }
+    else if (!mpTxBuffer || taskSCHEDULER_RUNNING != xTaskGetSchedulerState()) {
+        return CharDev::putBlock(pData, len, timeout) ? len : 0;
+    }
+
+    while (sent < len)
+    {
+        /* Multiple tasks may be writing to this UART, so the producer side of the ring buffer is
+         * serialized by the critical section.  The transmitter is started if it is idle, otherwise
+         * the THRE interrupt will continue to empty the buffer.
+         */
+        vPortEnterCritical();
+        {
+            sent += mpTxBuffer->push(&pChars[sent], len - sent);
+            kickTransmitter();
+        }
+        vPortExitCritical();
+
+        if (mpTxBuffer->size() > mTxQWatermark) {
+            mTxQWatermark = mpTxBuffer->size();
+        }
+
+        /* Only block when the buffer is full; the ISR signals us when it pops from a full buffer */
+        if (sent < len && mpTxBuffer->full()) {
+            if (!xSemaphoreTake(mTxSignal, getRemainingTimeout(startTick, timeout))) {
+                break;
+            }
+        }
+    }
+
+    return sent;
+}
+
+bool UartDev::getBlock(void* pData, size_t len, unsigned int timeout)
+{
+    char *pChars = (char*) pData;
+    size_t received = 0;
+
+    if (mpDma && pData) {
+        return dmaGetBlock(pChars, len, timeout);
+    }
+    else if (!pData || !mpRxBuffer) {
         return false;
     }
     else if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
-        return xQueueReceive(mRxQueue, pInputChar, timeout);
+        const TickType_t startTick = xTaskGetTickCount();
+
+        /* The semaphore is only given when data arrives in the empty buffer, so we
+         * always check the buffer first, and only block when it is empty.
+         */
+        while (received < len)
+        {
+            const uint32_t popped = mpRxBuffer->pop(&pChars[received], len - received);
+            received += popped;
+            mRxPopped += popped;
+            resumeRx();
+            if (received < len && mpRxBuffer->empty()) {
+                if (!xSemaphoreTake(mRxSignal, getRemainingTimeout(startTick, timeout))) {
+                    return false;
+                }
+            }
+        }
     }
     else {
-        unsigned int timeout_of_char = sys_get_uptime_ms() + timeout;
-        while (! xQueueReceive(mRxQueue, pInputChar, 0)) {
-            if (sys_get_uptime_ms() > timeout_of_char) {
+        const uint64_t timeout_ms = sys_get_uptime_ms() + timeout;
+        while (received < len)
+        {
+            const uint32_t popped = mpRxBuffer->pop(&pChars[received], len - received);
+            received += popped;
+            mRxPopped += popped;
+            resumeRx();
+            if (received < len && sys_get_uptime_ms() > timeout_ms) {
                 return false;
             }
         }
     }
+
     return true;
 }
 
-bool UartDev::putChar(char out, unsigned int timeout)
+void UartDev::enableRxFlowControl(void)
 {
-    /* If OS not running, just send data using polling and return */
-    if (taskSCHEDULER_RUNNING != xTaskGetSchedulerState()) {
-        mpUARTRegBase->THR = out;
-        while(! (mpUARTRegBase->LSR & (1 << 6)));
-        return true;
+    const uint32_t hwRxFifoSize = 16;
+
+    if (mpRxBuffer) {
+        const uint32_t capacity = mpRxBuffer->capacity();
+        const uint32_t high = (capacity > 2 * hwRxFifoSize) ? (capacity - hwRxFifoSize) : (capacity / 2);
+        mRxFlowLow = high / 2;
+        mRxFlowHigh = high;
+    }
+}
+
+void UartDev::resumeRx(void)
+{
+    if (mRxThrottled && mpRxBuffer->size() <= mRxFlowLow)
+    {
+        /* The ISR also writes the IER, and the Rx interrupt reads the bytes waiting in the FIFO */
+        vPortEnterCritical();
+        {
+            mRxThrottled = false;
+            mpUARTRegBase->IER |= (1 << 0);
+        }
+        vPortExitCritical();
     }
+}
 
-    /* FreeRTOS running, so send to queue and if queue is full, return false */
-    if(! xQueueSend(mTxQueue, &out, timeout)) {
+bool UartDev::enableFraming(uint8_t maxFrames)
+{
+    if (mpDma || !mpRxBuffer || 0 == maxFrames) {
         return false;
     }
 
-    /* If transmitter is not busy, send out the oldest char from the queue,
-     * and let the transmitter empty interrupt empty out the queue thereafter.
-     */
-    const int uart_tx_is_idle = (1 << 6);
-    if (mpUARTRegBase->LSR & uart_tx_is_idle)
+    if (!mFrameSignal) mFrameSignal = xSemaphoreCreateBinary();
+    if (!mpFrames)     mpFrames = new SpscRingBuffer<frame_end_t>(maxFrames);
+
+    return (0 != mFrameSignal && 0 != mpFrames);
+}
+
+size_t UartDev::getFrame(void* pData, size_t maxLen, uint64_t* pTimestampUs, unsigned int timeout)
+{
+    const TickType_t startTick = xTaskGetTickCount();
+    frame_end_t end;
+
+    if (!mpFrames || !pData || 0 == maxLen) {
+        return 0;
+    }
+
+    /* The frame ends at or before the bytes already read are skipped */
+    for (;;)
     {
-        if (xQueueReceive(mTxQueue, &out, 0)) {
-            mpUARTRegBase->THR = out;
+        while (mpFrames->peek(&end) && (int32_t) (end.end - mRxPopped) <= 0) {
+            mpFrames->pop(&end);
+        }
+        if (mpFrames->peek(&end)) {
+            break;
+        }
+        if (!xSemaphoreTake(mFrameSignal, getRemainingTimeout(startTick, timeout))) {
+            return 0;
         }
     }
 
-    return true;
+    /* The ISR pushed the bytes of the frame before its end, so they are in the Rx buffer */
+    size_t len = end.end - mRxPopped;
+    if (len > maxLen) {
+        len = maxLen;
+    }
+    if (!getBlock(pData, len, 0)) {
+        return 0;
+    }
+
+    if (pTimestampUs) {
+        *pTimestampUs = end.timestampUs;
+    }
+    return len;
+}
+
+bool UartDev::isFrameEnd(void)
+{
+    frame_end_t end;
+
+    if (!mpFrames) {
+        return false;
+    }
+    while (mpFrames->peek(&end) && (int32_t) (end.end - mRxPopped) < 0) {
+        mpFrames->pop(&end);
+    }
+    return (mpFrames->peek(&end) && end.end == mRxPopped);
 }
 
 bool UartDev::flush(void)
@@ -86,6 +258,28 @@ bool UartDev::flush(void)
     return true;
 }
 
+bool UartDev::setRxEvent(SemaphoreHandle_t event)
+{
+    mRxEvent = event;
+    return !mpDma;
+}
+
+unsigned int UartDev::getRxQueueSize() const
+{
+    if (mpDma) {
+        return (dmaGetRxWriteIdx() + mpDma->rxSize - mpDma->rxReadIdx) % mpDma->rxSize;
+    }
+    return mpRxBuffer ? mpRxBuffer->size() : 0;
+}
+
+unsigned int UartDev::getTxQueueSize() const
+{
+    if (mpDma) {
+        return dmaGetTxCount();
+    }
+    return mpTxBuffer ? mpTxBuffer->size() : 0;
+}
+
 bool UartDev::recentlyActive(unsigned int ms) const
 {
     TickType_t lastTimeStampMs = MS_PER_TICK() * mLastActivityTime;
@@ -93,22 +287,82 @@ bool UartDev::recentlyActive(unsigned int ms) const
     return (currentTimeMs - lastTimeStampMs) < ms;
 }
 
-void UartDev::setBaudRate(unsigned int baudRate)
+bool UartDev::solveBaudRate(uint32_t pclk, uint32_t baudRate, uart_baud_t& baud)
 {
-    /* Adding 0.5 to perform rounding correctly since we do not want
-     * 1.9 to round down to 1, but we want it to round-up to 2.
+    uint32_t bestError = UINT32_MAX;
+
+    if (0 == baudRate) {
+        return false;
+    }
+
+    /* MULVAL is 1 - 15 and DIVADDVAL is less than MULVAL.  The DLM:DLL divisor must be
+     * at least 3 if the fractional divider is used.
      */
+    for (uint32_t mul = 1; mul <= 15; mul++)
+    {
+        for (uint32_t div = 0; div < mul; div++)
+        {
+            /* Round to the nearest divisor: baud = pclk * mul / (16 * dl * (mul + div)) */
+            const uint64_t num = (uint64_t) pclk * mul;
+            const uint64_t den = 16ULL * baudRate * (mul + div);
+            const uint64_t dl = (num + den / 2) / den;
+
+            if (dl < ((div > 0) ? 3U : 1U) || dl > 0xFFFF) {
+                continue;
+            }
 
+            const uint64_t actualDen = 16ULL * dl * (mul + div);
+            const uint32_t actual = (num + actualDen / 2) / actualDen;
+            const uint32_t error = (actual > baudRate) ? (actual - baudRate) : (baudRate - actual);
+
+            if (error < bestError) {
+                bestError = error;
+                baud.dl = dl;
+                baud.divAddVal = div;
+                baud.mulVal = mul;
+                baud.actualBaud = actual;
+            }
+        }
+    }
+
+    if (UINT32_MAX == bestError) {
+        return false;
+    }
+    baud.errorPpm = (((int64_t) baud.actualBaud - baudRate) * 1000000) / baudRate;
+    return true;
+}
+
+bool UartDev::setBaudRate(unsigned int baudRate)
+{
+    uart_baud_t baud;
+
+    mBaudRate = baudRate;
+    if (!solveBaudRate(mPeripheralClock, baudRate, baud)) {
+        return false;
+    }
+
+    mBaud = baud;
     mpUARTRegBase->LCR = (1 << 7); // Enable DLAB to access DLM, DLL, and IER
     {
-        uint16_t bd = (mPeripheralClock / (16 * baudRate)) + 0.5;
-        mpUARTRegBase->DLM = (bd >> 8);
-        mpUARTRegBase->DLL = (bd >> 0);
+        mpUARTRegBase->DLM = (baud.dl >> 8);
+        mpUARTRegBase->DLL = (baud.dl >> 0);
     }
     mpUARTRegBase->LCR = 3; // Disable DLAB and set 8bit per char
+    mpUARTRegBase->FDR = (baud.mulVal << 4) | baud.divAddVal;
+
+    return (baud.errorPpm <= UART_BAUD_MAX_ERROR_PPM && baud.errorPpm >= -UART_BAUD_MAX_ERROR_PPM);
+}
+
+void UartDev::cpuClockChanged(void *pUart, unsigned int oldCpuHz, unsigned int newCpuHz)
+{
+    UartDev *pThis = (UartDev*) pUart;
+
+    // The UART peripheral clock is a fixed divider of the CPU clock
+    pThis->mPeripheralClock = ((uint64_t) pThis->mPeripheralClock * newCpuHz) / oldCpuHz;
+    pThis->setBaudRate(pThis->mBaudRate);
 }
 
-void UartDev::handleInterrupt()
+RAMFUNC void UartDev::handleInterrupt()
 {
     /**
      * Bit Masks of IIR register Bits 3:1 that contain interrupt reason.
@@ -119,11 +373,17 @@ void UartDev::handleInterrupt()
     const uint16_t dataTimeout      = (6 << 1);
 
     long higherPriorityTaskWoken = 0;
-    long switchRequired = 0;
     char c = 0;
-    unsigned charsSent = 0;
 
     uint16_t reasonForInterrupt = (mpUARTRegBase->IIR & 0xE);
+
+    /* In DMA mode, only the line status interrupt is enabled */
+    if (mpDma) {
+        /* Read LSR register to clear Line Status Interrupt */
+        (void) mpUARTRegBase->LSR;
+        return;
+    }
+
     {
         /**
          * If multiple sources of interrupt arise, let this interrupt exit, and re-enter
@@ -133,23 +393,19 @@ void UartDev::handleInterrupt()
         {
             case transmitterEmpty:
             {
-                if(uxQueueMessagesWaitingFromISR(mTxQueue) > mTxQWatermark) {
-                    mTxQWatermark = uxQueueMessagesWaitingFromISR(mTxQueue);
-                }
-
                 /**
                  * When THRE (Transmit Holding Register Empty) interrupt occurs,
-                 * we can send as many bytes as the hardware FIFO supports (16)
+                 * we can send as many bytes as the hardware FIFO supports (16).
+                 * The writer task only needs to be signaled if it found the buffer full.
                  */
                 const unsigned char hwTxFifoSize = 16;
-                for(charsSent=0;
-                        charsSent < hwTxFifoSize && xQueueReceiveFromISR(mTxQueue, &c, &higherPriorityTaskWoken);
-                        charsSent++)
-                {
+                const bool wasFull = mpTxBuffer->full();
+                for (unsigned charsSent = 0; charsSent < hwTxFifoSize && mpTxBuffer->pop(&c); charsSent++) {
                     mpUARTRegBase->THR = c;
-                    if(higherPriorityTaskWoken) {
-                        switchRequired = 1;
-                    }
+                }
+
+                if (wasFull && !mpTxBuffer->full()) {
+                    xSemaphoreGiveFromISR(mTxSignal, &higherPriorityTaskWoken);
                 }
             }
             break;
@@ -159,21 +415,57 @@ void UartDev::handleInterrupt()
             {
                 mLastActivityTime = xTaskGetTickCountFromISR();
                 /**
-                 * While receive Hardware FIFO not empty, keep queuing the data.
-                 * Even if xQueueSendFromISR() Fails (Queue is full), we still need to
-                 * read RBR register otherwise interrupt will not clear
+                 * While receive Hardware FIFO not empty, keep buffering the data.
+                 * Even if the buffer is full, we still need to read RBR register
+                 * otherwise interrupt will not clear.  The reader task is signaled
+                 * only once per interrupt, and only if the buffer was empty.
                  */
-                while (0 != (mpUARTRegBase->LSR & (1 << 0)))
+                const bool wasEmpty = mpRxBuffer->empty();
+
+                /* In the framing mode, the data available interrupt leaves one byte in the FIFO
+                 * such that the timeout interrupt occurs once the line is idle.
+                 */
+                uint32_t fifoLevel = 0xFF;
+                if (mpFrames && dataAvailable == reasonForInterrupt) {
+                    fifoLevel = (mpUARTRegBase->FIFOLVL & 0xF) - 1;
+                }
+
+                for ( ; fifoLevel > 0 && (0 != (mpUARTRegBase->LSR & (1 << 0))); fifoLevel--)
                 {
                     c = mpUARTRegBase->RBR;
-                    xQueueSendFromISR(mRxQueue, &c, &higherPriorityTaskWoken);
-                    if(higherPriorityTaskWoken) {
-                        switchRequired = 1;
+                    if (mpRxBuffer->push(c)) {
+                        ++mRxPushed;
+                    }
+                }
+
+                /* If the reader is too slow and the queue of the frame ends is full, the bytes
+                 * become a part of the next frame.
+                 */
+                if (mpFrames && dataTimeout == reasonForInterrupt && mRxPushed != mLastFrameEnd) {
+                    const frame_end_t end = { mRxPushed, sys_get_uptime_us() };
+                    if (mpFrames->push(end)) {
+                        mLastFrameEnd = mRxPushed;
+                        xSemaphoreGiveFromISR(mFrameSignal, &higherPriorityTaskWoken);
                     }
                 }
 
-                if(uxQueueMessagesWaitingFromISR(mRxQueue) > mRxQWatermark) {
-                    mRxQWatermark = uxQueueMessagesWaitingFromISR(mRxQueue);
+                if (wasEmpty && !mpRxBuffer->empty()) {
+                    xSemaphoreGiveFromISR(mRxSignal, &higherPriorityTaskWoken);
+                    if (mRxEvent) {
+                        xSemaphoreGiveFromISR(mRxEvent, &higherPriorityTaskWoken);
+                    }
+                }
+
+                const uint32_t count = mpRxBuffer->size();
+                if (count > mRxQWatermark) {
+                    mRxQWatermark = count;
+                }
+
+                /* Leave the next bytes in the FIFO until the reader drains the buffer */
+                if (mRxFlowHigh && count >= mRxFlowHigh) {
+                    mpUARTRegBase->IER &= ~(1 << 0);
+                    mRxThrottled = true;
+                    ++mRxThrottleCount;
                 }
             }
             break;
@@ -185,7 +477,7 @@ void UartDev::handleInterrupt()
         }
     }
 
-    portEND_SWITCHING_ISR(switchRequired);
+    portEND_SWITCHING_ISR(higherPriorityTaskWoken);
 }
 
 ///////////////
@@ -193,14 +485,28 @@ void UartDev::handleInterrupt()
 ///////////////
 UartDev::UartDev(unsigned int* pUARTBaseAddr) : CharDev(),
         mpUARTRegBase((LPC_UART_TypeDef*) pUARTBaseAddr),
-        mRxQueue(0),
-        mTxQueue(0),
+        mpRxBuffer(0),
+        mpTxBuffer(0),
+        mRxSignal(0),
+        mTxSignal(0),
+        mRxEvent(0),
         mPeripheralClock(0),
+        mBaudRate(0),
         mRxQWatermark(0),
         mTxQWatermark(0),
-        mLastActivityTime(0)
+        mRxFlowHigh(0),
+        mRxFlowLow(0),
+        mRxThrottled(false),
+        mRxThrottleCount(0),
+        mpFrames(0),
+        mFrameSignal(0),
+        mRxPushed(0),
+        mRxPopped(0),
+        mLastFrameEnd(0),
+        mLastActivityTime(0),
+        mpDma(0)
 {
-
+    memset(&mBaud, 0, sizeof(mBaud));
 }
 
 bool UartDev::init(unsigned int pclk, unsigned int baudRate,
@@ -214,13 +520,11 @@ bool UartDev::init(unsigned int pclk, unsigned int baudRate,
         lpc_pconp(pconp_uart0, true);
         NVIC_EnableIRQ(UART0_IRQn);
     }
-    /*
-     else if(LPC_UART1_BASE == (unsigned int)mpUARTRegBase)
-     {
-     lpc_pconp(pconp_uart1, true);
-     NVIC_EnableIRQ(UART1_IRQn);
-     }
-     */
+    else if (LPC_UART1_BASE == (unsigned int) mpUARTRegBase)
+    {
+        lpc_pconp(pconp_uart1, true);
+        NVIC_EnableIRQ(UART1_IRQn);
+    }
     else if (LPC_UART2_BASE == (unsigned int) mpUARTRegBase)
     {
         lpc_pconp(pconp_uart2, true);
@@ -241,17 +545,325 @@ bool UartDev::init(unsigned int pclk, unsigned int baudRate,
     mpUARTRegBase->FCR |= (1 << 1) | (1 << 2);
 
     setBaudRate(baudRate);
+    sys_clock_add_listener(cpuClockChanged, this);
 
     // Set minimum queue size?
     if (rxQSize < 9) rxQSize = 8;
     if (txQSize < 9) txQSize = 8;
 
-    // Create the receive and transmit queues
-    if (!mRxQueue) mRxQueue = xQueueCreate(rxQSize, sizeof(char));
-    if (!mTxQueue) mTxQueue = xQueueCreate(txQSize, sizeof(char));
+    // Create the receive and transmit buffers, and the signals used to block on them
+    if (!mpRxBuffer) mpRxBuffer = new SpscRingBuffer<char>(rxQSize);
+    if (!mpTxBuffer) mpTxBuffer = new SpscRingBuffer<char>(txQSize);
+    if (!mRxSignal)  mRxSignal  = xSemaphoreCreateBinary();
+    if (!mTxSignal)  mTxSignal  = xSemaphoreCreateBinary();
 
     // Enable Rx/Tx and line status Interrupts:
     mpUARTRegBase->IER = (1 << 0) | (1 << 1) | (1 << 2); // B0:Rx, B1: Tx
 
-    return (0 != mRxQueue && 0 != mTxQueue);
+    return (0 != mpRxBuffer && 0 != mpTxBuffer && 0 != mRxSignal && 0 != mTxSignal);
+}
+
+bool UartDev::enableDma(char *pRxBuffer, uint16_t rxSize, char *pTxBuffer, uint16_t txSize,
+                        dma_ch_t txChannel, dma_ch_t rxChannel)
+{
+    const uint16_t minBufferSize = 16;
+    uint8_t uartNum = 0;
+    dma_req_t txReq, rxReq;
+
+    if (mpDma || !pRxBuffer || !pTxBuffer || rxSize < minBufferSize || txSize < minBufferSize ||
+        txChannel >= dma_ch_max || rxChannel >= dma_ch_max || txChannel == rxChannel) {
+        return false;
+    }
+
+    if (LPC_UART0_BASE == (unsigned int) mpUARTRegBase) {
+        uartNum = 0; txReq = dma_req_uart0_tx; rxReq = dma_req_uart0_rx;
+    }
+    else if (LPC_UART2_BASE == (unsigned int) mpUARTRegBase) {
+        uartNum = 2; txReq = dma_req_uart2_tx; rxReq = dma_req_uart2_rx;
+    }
+    else if (LPC_UART3_BASE == (unsigned int) mpUARTRegBase) {
+        uartNum = 3; txReq = dma_req_uart3_tx; rxReq = dma_req_uart3_rx;
+    }
+    else {
+        return false;
+    }
+
+    /* The channels must not be in use by another driver, such as the other UART */
+    if (!dma_channel_claim(txChannel)) {
+        return false;
+    }
+    if (!dma_channel_claim(rxChannel)) {
+        dma_channel_free(txChannel);
+        return false;
+    }
+
+    dma_info_t *pDma = (dma_info_t*) malloc(sizeof(dma_info_t));
+    if (!pDma) {
+        dma_channel_free(txChannel);
+        dma_channel_free(rxChannel);
+        return false;
+    }
+
+    /* Rx DMA uses two halves of the buffer so we get an interrupt at each half */
+    rxSize &= ~1;
+    pDma->pRxLli = &g_uart_rx_dma_lli[uartNum][0];
+    pDma->pRxBuff = pRxBuffer;
+    pDma->pTxBuff = pTxBuffer;
+    pDma->rxSize = rxSize;
+    pDma->txSize = txSize;
+    pDma->rxReadIdx = 0;
+    pDma->txWriteIdx = 0;
+    pDma->txReadIdx = 0;
+    pDma->txDmaLen = 0;
+    pDma->txCh = txChannel;
+    pDma->rxCh = rxChannel;
+
+    /* Wait for the pending data of the buffers to be sent out */
+    flush();
+    while (! (mpUARTRegBase->LSR & (1 << 6)));
+
+    /* Stop the interrupt driven mode, and delete the buffers we no longer need */
+    mpUARTRegBase->IER = 0;
+    vPortEnterCritical();
+    {
+        delete mpRxBuffer;
+        delete mpTxBuffer;
+        mpRxBuffer = 0;
+        mpTxBuffer = 0;
+        mpDma = pDma;
+    }
+    vPortExitCritical();
+
+    /* Enable & Reset FIFOs, select the DMA mode, and use 1 char Rx trigger level for the DMA requests */
+    mpUARTRegBase->FCR = (1 << 0) | (1 << 1) | (1 << 2) | (1 << 3);
+
+    dma_init();
+    dma_register_callback(txChannel, dmaTxCallback, this);
+    dma_register_callback(rxChannel, dmaRxCallback, this);
+
+    /* Setup the circular linked list for the Rx; each half generates terminal count interrupt */
+    const uint32_t halfSize = rxSize / 2;
+    const uint32_t rxCtrl = halfSize | DMA_CTRL_DST_INCR | DMA_CTRL_TC_INTR;
+    dma_lli_t *pLli = pDma->pRxLli;
+    pLli[0].src  = (uint32_t) &(mpUARTRegBase->RBR);
+    pLli[0].dst  = (uint32_t) &(pRxBuffer[0]);
+    pLli[0].next = &pLli[1];
+    pLli[0].ctrl = rxCtrl;
+    pLli[1].src  = (uint32_t) &(mpUARTRegBase->RBR);
+    pLli[1].dst  = (uint32_t) &(pRxBuffer[halfSize]);
+    pLli[1].next = &pLli[0];
+    pLli[1].ctrl = rxCtrl;
+
+    LPC_GPDMACH_TypeDef *pRxCh = dma_get_channel(rxChannel);
+    dma_clear_intr(rxChannel);
+    pRxCh->DMACCSrcAddr  = pLli[0].src;
+    pRxCh->DMACCDestAddr = pLli[0].dst;
+    pRxCh->DMACCLLI      = (uint32_t) pLli[0].next;
+    pRxCh->DMACCControl  = pLli[0].ctrl;
+    pRxCh->DMACCConfig   = DMA_CFG_SRC_PERIPH(rxReq) | DMA_CFG_P_TO_M | DMA_CFG_ERR_INTR | DMA_CFG_TC_INTR;
+    pRxCh->DMACCConfig  |= DMA_CFG_ENABLE;
+
+    /* Tx DMA channel config is setup now, and the DMA is only enabled when we have data to send */
+    LPC_GPDMACH_TypeDef *pTxCh = dma_get_channel(txChannel);
+    pTxCh->DMACCDestAddr = (uint32_t) &(mpUARTRegBase->THR);
+    pTxCh->DMACCLLI = 0;
+    pTxCh->DMACCConfig = DMA_CFG_DST_PERIPH(txReq) | DMA_CFG_M_TO_P | DMA_CFG_ERR_INTR | DMA_CFG_TC_INTR;
+
+    /* Keep only the line status interrupt to clear line errors */
+    mpUARTRegBase->IER = (1 << 2);
+
+    return true;
+}
+
+/////////////
+// Private //
+/////////////
+uint16_t UartDev::dmaGetRxWriteIdx(void) const
+{
+    const uint32_t writeAddr = dma_get_channel(mpDma->rxCh)->DMACCDestAddr;
+    return (writeAddr - (uint32_t) mpDma->pRxBuff) % mpDma->rxSize;
+}
+
+uint16_t UartDev::dmaGetTxCount(void) const
+{
+    return (mpDma->txWriteIdx + mpDma->txSize - mpDma->txReadIdx) % mpDma->txSize;
+}
+
+bool UartDev::dmaGetBlock(char* pData, uint32_t len, unsigned int timeout)
+{
+    const bool osRunning = (taskSCHEDULER_RUNNING == xTaskGetSchedulerState());
+    const uint64_t timeout_ms = sys_get_uptime_ms() + timeout;
+    const TickType_t startTick = xTaskGetTickCount();
+    uint32_t received = 0;
+
+    while (received < len)
+    {
+        const uint16_t available = getRxQueueSize();
+
+        if (0 == available)
+        {
+            if (osRunning) {
+                if (0 == getRemainingTimeout(startTick, timeout)) {
+                    return false;
+                }
+                /* Either DMA will signal us upon half buffer, or we poll after one tick */
+                xSemaphoreTake(mRxSignal, 1);
+            }
+            else if (sys_get_uptime_ms() > timeout_ms) {
+                return false;
+            }
+            continue;
+        }
+
+        if (available > mRxQWatermark) {
+            mRxQWatermark = available;
+        }
+
+        /* Copy the contiguous data until the end of the circular buffer */
+        uint32_t chunk = mpDma->rxSize - mpDma->rxReadIdx;
+        if (chunk > available) {
+            chunk = available;
+        }
+        if (chunk > (len - received)) {
+            chunk = (len - received);
+        }
+
+        memcpy(&pData[received], &(mpDma->pRxBuff[mpDma->rxReadIdx]), chunk);
+        received += chunk;
+        if ((mpDma->rxReadIdx += chunk) >= mpDma->rxSize) {
+            mpDma->rxReadIdx = 0;
+        }
+    }
+
+    if (osRunning) {
+        mLastActivityTime = xTaskGetTickCount();
+    }
+
+    return true;
+}
+
+uint32_t UartDev::dmaPutBlock(const char* pData, uint32_t len, unsigned int timeout)
+{
+    const TickType_t startTick = xTaskGetTickCount();
+    uint32_t sent = 0;
+
+    while (sent < len)
+    {
+        /* We hold critical section because multiple tasks may be writing to this UART. The tx buffer
+         * holds one less than its size to tell the difference between full and empty buffer.
+         */
+        vPortEnterCritical();
+        {
+            const uint32_t space = (mpDma->txSize - 1) - dmaGetTxCount();
+            uint32_t chunk = mpDma->txSize - mpDma->txWriteIdx;
+            if (chunk > space) {
+                chunk = space;
+            }
+            if (chunk > (len - sent)) {
+                chunk = (len - sent);
+            }
+
+            memcpy(&(mpDma->pTxBuff[mpDma->txWriteIdx]), &pData[sent], chunk);
+            sent += chunk;
+            if ((mpDma->txWriteIdx += chunk) >= mpDma->txSize) {
+                mpDma->txWriteIdx = 0;
+            }
+
+            dmaStartTx();
+        }
+        vPortExitCritical();
+
+        if (dmaGetTxCount() > mTxQWatermark) {
+            mTxQWatermark = dmaGetTxCount();
+        }
+
+        /* If the buffer is full, wait for DMA to finish sending a block */
+        if (sent < len && dmaGetTxCount() >= (mpDma->txSize - 1u)) {
+            if (!xSemaphoreTake(mTxSignal, getRemainingTimeout(startTick, timeout))) {
+                break;
+            }
+        }
+    }
+
+    return sent;
+}
+
+void UartDev::dmaStartTx(void)
+{
+    const uint16_t readIdx = mpDma->txReadIdx;
+    const uint16_t writeIdx = mpDma->txWriteIdx;
+
+    /* Nothing to do if DMA is busy sending a block or if there is no data to send */
+    if (0 != mpDma->txDmaLen || readIdx == writeIdx) {
+        return;
+    }
+
+    /* Send the contiguous block of data until the write index, or until the end of the buffer */
+    uint32_t len = (writeIdx > readIdx) ? (writeIdx - readIdx) : (mpDma->txSize - readIdx);
+    if (len > DMA_CTRL_SIZE_MASK) {
+        len = DMA_CTRL_SIZE_MASK;
+    }
+    mpDma->txDmaLen = len;
+
+    LPC_GPDMACH_TypeDef *pTxCh = dma_get_channel(mpDma->txCh);
+    dma_clear_intr(mpDma->txCh);
+    pTxCh->DMACCSrcAddr = (uint32_t) &(mpDma->pTxBuff[readIdx]);
+    pTxCh->DMACCControl = len | DMA_CTRL_SRC_INCR | DMA_CTRL_TC_INTR;
+    pTxCh->DMACCConfig |= DMA_CFG_ENABLE;
+}
+
+void UartDev::kickTransmitter(void)
+{
+    const int uart_tx_is_idle = (1 << 6);
+    char c = 0;
+
+    /* The THRE interrupt will not occur if the transmitter is idle, so send the
+     * oldest char and let the interrupt empty out the rest of the buffer.
+     */
+    if ((mpUARTRegBase->LSR & uart_tx_is_idle) && mpTxBuffer->pop(&c)) {
+        mpUARTRegBase->THR = c;
+    }
+}
+
+void UartDev::dmaTxCallback(void *pUart, bool error)
+{
+    UartDev *pThis = (UartDev*) pUart;
+    dma_info_t *pDma = pThis->mpDma;
+    long higherPriorityTaskWoken = 0;
+
+    /* Even if the DMA had an error, we skip the block and continue with the rest of the data */
+    uint32_t readIdx = pDma->txReadIdx + pDma->txDmaLen;
+    if (readIdx >= pDma->txSize) {
+        readIdx -= pDma->txSize;
+    }
+    pDma->txReadIdx = readIdx;
+    pDma->txDmaLen = 0;
+
+    pThis->dmaStartTx();
+
+    xSemaphoreGiveFromISR(pThis->mTxSignal, &higherPriorityTaskWoken);
+    portEND_SWITCHING_ISR(higherPriorityTaskWoken);
+    (void) error;
+}
+
+void UartDev::dmaRxCallback(void *pUart, bool error)
+{
+    UartDev *pThis = (UartDev*) pUart;
+    long higherPriorityTaskWoken = 0;
+
+    pThis->mLastActivityTime = xTaskGetTickCountFromISR();
+
+    /* DMA error disables the channel, so restart from the beginning of the circular buffer */
+    if (error) {
+        LPC_GPDMACH_TypeDef *pRxCh = dma_get_channel(pThis->mpDma->rxCh);
+        const dma_lli_t *pLli = pThis->mpDma->pRxLli;
+        pRxCh->DMACCDestAddr = pLli[0].dst;
+        pRxCh->DMACCLLI      = (uint32_t) pLli[0].next;
+        pRxCh->DMACCControl  = pLli[0].ctrl;
+        pRxCh->DMACCConfig  |= DMA_CFG_ENABLE;
+        pThis->mpDma->rxReadIdx = 0;
+    }
+
+    xSemaphoreGiveFromISR(pThis->mRxSignal, &higherPriorityTaskWoken);
+    portEND_SWITCHING_ISR(higherPriorityTaskWoken);
 }
@@ -20,6 +20,11 @@
  * @file
  * @brief Provides UART Base class functionality for UART peripherals
  *
+ *  10142026 : Added the idle-line framing mode that delivers the received frames with timestamps
+ *  10142026 : Added the Rx flow control that stops reading the FIFO at the high watermark
+ *  10142026 : Added the fractional baud rate solver that programs the FDR
+ *  10142014 : Replaced the FreeRTOS queues with lock-free SPSC ring buffers in the ISR paths
+ *  10122014 : Added optional GPDMA mode to move data in blocks instead of per-byte queue operations
  *  12012013 : Split functionality to char_dev.hpp and inherited this object
  *  10102013 : Make init() public, and protect from re-init leaking memory through xQueueCreate()
  *  05122013 : Added version history
@@ -28,15 +33,31 @@
 #define UART_DEV_HPP_
 
 #include "FreeRTOS.h"
-#include "queue.h"
 #include "semphr.h"
 #include "task.h"
 
 #include "char_dev.hpp"
+#include "circular_buffer.hpp"
 #include "LPC17xx.h"
+#include "lpc_dma.h"
 
 
 
+/// setBaudRate() returns false if the error of the baud rate is larger than this (1.5%)
+#define UART_BAUD_MAX_ERROR_PPM     15000
+
+/**
+ * The divisors of a baud rate, @see UartDev::solveBaudRate()
+ * Baud rate = Peripheral Clock / (16 * dl * (1 + divAddVal / mulVal))
+ */
+typedef struct {
+    uint16_t dl;            ///< The DLM:DLL divisor
+    uint8_t divAddVal;      ///< The DIVADDVAL of the FDR
+    uint8_t mulVal;         ///< The MULVAL of the FDR
+    uint32_t actualBaud;    ///< The baud rate of the divisors
+    int32_t errorPpm;       ///< The error of actualBaud in parts per million of the requested baud rate
+} uart_baud_t;
+
 /**
  * UART Base class that can be used to write drivers for all UART peripherals.
  * Steps needed to write a UART driver:
@@ -55,15 +76,37 @@
  *   }
  *  @endcode
  *
- *  @warning This class hasn't been tested for UART1 due to different memory map.
+ *  UART1 has the same memory map as the other UARTs for the registers used here, and its
+ *  modem control registers are only used by Uart1 (@see uart1.hpp).
  *  @ingroup Drivers
  */
 class UartDev : public CharDev
 {
     public:
 
-        /// Reset the baud-rate after UART has been initialized
-        void setBaudRate(unsigned int baudRate);
+        /**
+         * Reset the baud-rate after UART has been initialized.
+         * The DLM:DLL divisor and the FDR fractional divider are both programmed, so the rates
+         * such as 921600 and 1.5M are possible with the 96Mhz peripheral clock.
+         * @returns false if the baud rate cannot be set within UART_BAUD_MAX_ERROR_PPM
+         */
+        bool setBaudRate(unsigned int baudRate);
+
+        /// @returns the baud rate of the programmed divisors
+        uint32_t getActualBaudRate(void) const { return mBaud.actualBaud; }
+
+        /// @returns the error of the actual baud rate in parts per million of the requested rate
+        int32_t getBaudErrorPpm(void) const { return mBaud.errorPpm; }
+
+        /**
+         * Searches the DLM:DLL divisor, DIVADDVAL and MULVAL for the minimum error of the baud rate.
+         * The integer divisor (DIVADDVAL = 0) is preferred if the fractional divider is not better.
+         * @param pclk      The peripheral clock of the UART
+         * @param baudRate  The requested baud rate
+         * @param baud      The divisors, the actual baud rate, and its error are written here
+         * @returns false if the baud rate is out of the range of the divisors
+         */
+        static bool solveBaudRate(uint32_t pclk, uint32_t baudRate, uart_baud_t& baud);
 
         /**
          * @returns a character from the UART input
@@ -78,22 +121,110 @@ class UartDev : public CharDev
          * Outputs a char given by @param out
          * @param   timeout Optional parameter which defaults to maximum value that
          *          will allow you to wait forever for a character to be sent
-         * @returns true if the output char was successfully written to Queue, or
-         *          false if the output queue was full within the given timeout
+         * @returns true if the output char was successfully written to the buffer, or
+         *          false if the output buffer was full within the given timeout
          */
         bool putChar(char out, unsigned int timeout=portMAX_DELAY);
 
-        /// Flushed all pending transmission of the uart queue
+        /**
+         * @{ Bulk data transfer.
+         * In DMA mode, the whole block is copied in and out of the DMA buffers at once.
+         * Otherwise, the data is pushed to the ring buffer in bulk, and the transmitter
+         * is started once for the entire block.
+         */
+        bool putBlock(const void* pData, size_t len, unsigned int timeout=portMAX_DELAY);
+        bool getBlock(void* pData, size_t len, unsigned int timeout=portMAX_DELAY);
+        /** @} */
+
+        /**
+         * Same as putBlock() except that the data that does not fit within the timeout is not sent.
+         * @returns the number of bytes written to the output buffer
+         */
+        size_t write(const void* pData, size_t len, unsigned int timeout=portMAX_DELAY);
+
+        /// Flushed all pending transmission of the uart buffer
         bool flush(void);
 
+        /**
+         * Sets the semaphore given when data arrives in the empty rx buffer (@see CharDev::setRxEvent())
+         * @returns false in DMA mode, since the DMA only signals every half rx buffer
+         */
+        bool setRxEvent(SemaphoreHandle_t event);
+
+        /**
+         * Switches this UART to DMA mode.  The UART's receive FIFO is continuously drained
+         * by a DMA channel into a circular buffer, and the transmit data is sent out in blocks
+         * by another DMA channel, so there is no per-byte interrupt or queue operation.
+         * The Rx and Tx ring buffers created by init() are deleted and replaced by the given buffers.
+         *
+         * This must be called after init() and the CharDev API stays the same after this call.
+         *
+         * @param pRxBuffer  The receive buffer, and rxSize is its size (minimum 16 bytes)
+         * @param pTxBuffer  The transmit buffer, and txSize is its size (minimum 16 bytes)
+         * @param txChannel  The DMA channel used for transmission
+         * @param rxChannel  The DMA channel used for reception
+         * @returns false if a channel is already claimed by another driver (@see dma_channel_claim())
+         *
+         * @warning The buffers must be global (or static) memory because GPDMA cannot access
+         *          the 32K local SRAM where the heap memory starts (@see loader.ld)
+         * @note Since the data is received in the background, the task waiting on getChar()
+         *       wakes up on every half-buffer of data, or polls every tick for smaller data.
+         *       If the data is not read, the receive buffer will overwrite the oldest data.
+         *
+         * @code
+         *     static char rxBuffer[512];
+         *     static char txBuffer[512];
+         *     Uart3 &u3 = Uart3::getInstance();
+         *     u3.init(WIFI_BAUD_RATE);
+         *     u3.enableDma(rxBuffer, sizeof(rxBuffer), txBuffer, sizeof(txBuffer));
+         * @endcode
+         */
+        bool enableDma(char *pRxBuffer, uint16_t rxSize, char *pTxBuffer, uint16_t txSize,
+                       dma_ch_t txChannel=dma_ch_uart_tx, dma_ch_t rxChannel=dma_ch_uart_rx);
+
+        /// @returns true if the UART is running in DMA mode
+        inline bool isDmaEnabled(void) const { return (0 != mpDma); }
+
+        /**
+         * Enables the idle-line framing mode of the interrupt mode.  The character timeout
+         * interrupt (the line is idle for 3.5 - 4.5 chars) ends a frame, so the reader knows the
+         * end of a response within a few char times instead of waiting for a getChar() timeout.
+         * The Rx interrupt always leaves one byte in the FIFO such that the timeout interrupt
+         * occurs at the end of every frame.
+         * @param maxFrames  The number of frame ends that are queued for the reader
+         * @returns false in the DMA mode, or before init()
+         * @note The bytes can still be read with getChar() and getBlock(), and the frame ends
+         *       that are read past are skipped.
+         */
+        bool enableFraming(uint8_t maxFrames=8);
+
+        /// @returns true if the idle-line framing mode is enabled
+        inline bool isFramingEnabled(void) const { return (0 != mpFrames); }
+
+        /**
+         * Reads the bytes up to the next frame end, or up to maxLen bytes of it; the rest of a
+         * longer frame is read by the next call.
+         * @param pData         The bytes are written here
+         * @param maxLen        The max number of bytes to read
+         * @param pTimestampUs  Optional: the uptime at which the idle line ended the frame
+         * @param timeout       The time to wait for the frame end
+         * @returns the number of bytes read, or 0 if no frame ended within the timeout
+         */
+        size_t getFrame(void* pData, size_t maxLen, uint64_t* pTimestampUs=0, unsigned int timeout=portMAX_DELAY);
+
+        /// @returns true if the bytes read so far end at a frame end, which means that the line went idle
+        bool isFrameEnd(void);
+
         /**
          * @{ Get the Rx and Tx queue information
          * Watermarks provide the queue's usage to access the capacity usage
          */
-        inline unsigned int getRxQueueSize() const { return uxQueueMessagesWaiting(mRxQueue); }
-        inline unsigned int getTxQueueSize() const { return uxQueueMessagesWaiting(mTxQueue); }
+        unsigned int getRxQueueSize() const;
+        unsigned int getTxQueueSize() const;
         inline unsigned int getRxQueueWatermark() const { return mRxQWatermark; }
         inline unsigned int getTxQueueWatermark() const { return mTxQWatermark; }
+        /// @returns the number of times the Rx was stopped at the high watermark of the flow control
+        inline unsigned int getRxThrottleCount() const { return mRxThrottleCount; }
         /** @} */
 
         /**
@@ -114,17 +245,24 @@ class UartDev : public CharDev
 
     protected:
         /**
-         * Initializes the UART register including Queues, baudrate and hardware.
+         * Initializes the UART register including the buffers, baudrate and hardware.
          * Parent class should call this method before initializing Pin-Connect-Block
          * @param pclk      The system peripheral clock for this UART
          * @param baudRate  The baud rate to set
-         * @param rxQSize   The receive queue size
-         * @param txQSize   The transmit queue size
+         * @param rxQSize   The receive buffer size
+         * @param txQSize   The transmit buffer size
          * @post    Sets 8-bit mode, no parity, no flow control.
          * @warning This will not initialize the PINS, so user needs to do pin
          *          selection because LPC's same UART hardware, such as UART2
          *          is available on multiple pins.
          * @note If the txQSize is too small, functions performing printf will start to block.
+         *
+         * The UART interrupt is the only producer of the Rx buffer, and the only consumer
+         * of the Tx buffer, so these buffers are lock-free SPSC rings rather than FreeRTOS
+         * queues.  The tasks only block on a binary semaphore when the Rx buffer is empty
+         * or the Tx buffer is full, and the interrupt gives the semaphore once per interrupt
+         * upon such transitions.  Multiple tasks writing to the UART are serialized by a
+         * short critical section, and only one task should read from the UART at a time.
          */
         bool init(unsigned int pclk, unsigned int baudRate, int rxQSize=32, int txQSize=32);
 
@@ -133,18 +271,87 @@ class UartDev : public CharDev
          * base register address for which to operate this UART driver
          */
         UartDev(unsigned int* pUARTBaseAddr);
+
+        /**
+         * Enables the Rx flow control of the interrupt mode, which must be called after init().
+         * Once the Rx buffer reaches the high watermark, the interrupt stops reading the hardware
+         * FIFO by disabling the Rx interrupt, and getBlock() enables it again once the buffer is
+         * drained to half of the high watermark.  The bytes wait in the FIFO meanwhile, so this
+         * only avoids losing bytes if the hardware stops the sender before the FIFO overflows,
+         * such as the auto-RTS of UART1.  The high watermark leaves room for one more FIFO of
+         * bytes in the Rx buffer.
+         */
+        void enableRxFlowControl(void);
         ~UartDev() { } /** Nothing to clean up */
 
     private:
         UartDev(); /** Disallowed constructor */
 
+        /// The data used by the DMA mode, this is only allocated if enableDma() is called
+        typedef struct {
+            dma_lli_t *pRxLli;           ///< Linked list items that make the rx DMA circular
+            char *pRxBuff;               ///< Circular receive buffer written in background by the DMA
+            char *pTxBuff;               ///< Circular transmit buffer read by the DMA
+            uint16_t rxSize;             ///< Size of pRxBuff
+            uint16_t txSize;             ///< Size of pTxBuff
+            uint16_t rxReadIdx;          ///< The next index of pRxBuff to read
+            uint16_t txWriteIdx;         ///< The next index of pTxBuff to write
+            volatile uint16_t txReadIdx; ///< The index of pTxBuff being sent by DMA
+            volatile uint16_t txDmaLen;  ///< The number of bytes being sent by DMA
+            dma_ch_t txCh;               ///< DMA channel used for transmission
+            dma_ch_t rxCh;               ///< DMA channel used for reception
+        } dma_info_t;
+
+        /// @returns the index of the rx buffer the DMA will write next
+        uint16_t dmaGetRxWriteIdx(void) const;
+        /// @returns the number of bytes of tx buffer waiting to be sent
+        uint16_t dmaGetTxCount(void) const;
+        bool dmaGetBlock(char* pData, uint32_t len, unsigned int timeout);
+        uint32_t dmaPutBlock(const char* pData, uint32_t len, unsigned int timeout);
+        void dmaStartTx(void);  ///< Must be called from a critical section or the DMA interrupt
+
+        /// Starts the transmitter if it is idle, must be called from a critical section
+        void kickTransmitter(void);
+
+        /// Resumes the Rx interrupt once the Rx buffer is drained to the low watermark
+        void resumeRx(void);
+
+        /// Restores the baud rate when sys_clock_set_cpu_scale() changes the CPU clock
+        static void cpuClockChanged(void *pUart, unsigned int oldCpuHz, unsigned int newCpuHz);
+
+        /// @{ DMA interrupt callbacks registered through dma_register_callback()
+        static void dmaTxCallback(void *pUart, bool error);
+        static void dmaRxCallback(void *pUart, bool error);
+        /// @}
+
         LPC_UART_TypeDef* mpUARTRegBase;///< Pointer to UART's memory map
-        QueueHandle_t mRxQueue;         ///< Queue for UARTs receive buffer
-        QueueHandle_t mTxQueue;         ///< Queue for UARTs transmit buffer
+        SpscRingBuffer<char> *mpRxBuffer;   ///< Ring buffer for UARTs receive data, written by the ISR
+        SpscRingBuffer<char> *mpTxBuffer;   ///< Ring buffer for UARTs transmit data, read by the ISR
+        SemaphoreHandle_t mRxSignal;    ///< Given by the ISR when data arrives in an empty rx buffer (or DMA half buffer)
+        SemaphoreHandle_t mTxSignal;    ///< Given by the ISR when space frees up in a full tx buffer (or DMA block is sent)
+        SemaphoreHandle_t mRxEvent;     ///< Given along with mRxSignal for the task that waits on several devices
         uint32_t mPeripheralClock;      ///< Peripheral clock as given by constructor
-        uint16_t mRxQWatermark;         ///< Watermark of Rx Queue
-        uint16_t mTxQWatermark;         ///< Watermark of Tx Queue
+        uint32_t mBaudRate;             ///< The baud rate given to setBaudRate()
+        uart_baud_t mBaud;              ///< The divisors programmed by setBaudRate()
+        uint16_t mRxQWatermark;         ///< Watermark of Rx buffer
+        uint16_t mTxQWatermark;         ///< Watermark of Tx buffer
+        uint16_t mRxFlowHigh;           ///< The Rx buffer level that stops the Rx, 0 if no flow control
+        uint16_t mRxFlowLow;            ///< The Rx buffer level that resumes the Rx
+        volatile bool mRxThrottled;     ///< Set by the ISR when it disabled the Rx interrupt
+        uint16_t mRxThrottleCount;      ///< The number of times the Rx was stopped
+
+        /// The end of a frame of the idle-line framing mode
+        typedef struct {
+            uint32_t end;               ///< The mRxPushed count at the end of the frame
+            uint64_t timestampUs;       ///< The uptime at the Rx timeout interrupt
+        } frame_end_t;
+        SpscRingBuffer<frame_end_t> *mpFrames;  ///< The frame ends written by the ISR, NULL if not framing
+        SemaphoreHandle_t mFrameSignal; ///< Given by the ISR at each frame end
+        volatile uint32_t mRxPushed;    ///< The bytes pushed to the Rx buffer, only written by the ISR
+        uint32_t mRxPopped;             ///< The bytes popped from the Rx buffer, only written by the reader
+        uint32_t mLastFrameEnd;         ///< The mRxPushed count of the last frame end, only used by the ISR
         TickType_t mLastActivityTime;   ///< updated each time last rx interrupt occurs
+        dma_info_t *mpDma;              ///< DMA mode data, NULL if DMA is not used
 };
 
 
@@ -51,6 +51,15 @@ extern "C" {
 
 
 
+/** @{ Traffic statistics, @see CAN_get_stats() */
+#define CAN_STATS_WINDOW_MS     1000        ///< The bus load and the rates are measured over this window
+#define CAN_STATS_TRACKED_IDS   16          ///< The number of the IDs that are counted in each window
+#define CAN_STATS_TOP_IDS       8           ///< The number of the busiest IDs of the statistics
+#define CAN_STATS_ID_29BIT      (1U << 31)  ///< Set in the can_id_rate_t msg_id of a 29-bit ID
+/** @} */
+
+
+
 /**
  * 8-byte structure accessible by 8-bit, 16-bit, 32-bit or as whole 64-bit
  * DO NOT CHANGE THIS STRUCTURE - it maps to the hardware
@@ -82,6 +91,12 @@ typedef struct {
     can_data_t data; ///< CAN data
 } __attribute__((__packed__)) can_msg_t;
 
+/// A received CAN message with the time it was read from the CAN hardware
+typedef struct {
+    can_msg_t msg;          ///< The CAN message
+    uint64_t timestamp_us;  ///< sys_get_uptime_us() when the CAN interrupt read the message
+} can_rx_msg_t;
+
 /**
  * Typedef of a FullCAN message stored in memory
  * DO NOT CHANGE THIS STRUCTURE - it maps to the hardware
@@ -149,9 +164,22 @@ bool CAN_init(can_t can, uint32_t baudrate_kbps, uint16_t rxq_size, uint16_t txq
  * @param timeout_ms  If FreeRTOS is running, the task will block until a message arrives.
  *                    Otherwise we will poll and wait this timeout to receive a message.
  * @returns true if message was captured within the given timeout.
+ * @note  The received messages are buffered in a lock-free ring that is only read by this
+ *        function, so only one task should receive the messages of a CAN bus.
  */
 bool CAN_rx(can_t can, can_msg_t *msg, uint32_t timeout_ms);
 
+/**
+ * Receives all of the available messages of the CAN BUS, up to max messages, with their timestamps.
+ * This blocks the same way as CAN_rx() until at least one message arrives, and then copies
+ * the received messages without blocking again.
+ *
+ * @param msgs  The array of max messages to copy the received messages to
+ * @returns the number of messages copied to msgs, which is zero if timeout occurred
+ * @note  This reads the same messages as CAN_rx(), so only one of them should be used by one task.
+ */
+uint16_t CAN_rx_batch(can_t can, can_rx_msg_t *msgs, uint16_t max, uint32_t timeout_ms);
+
 /**
  * Send a CAN message over the CAN BUS
  * @param can  The can bus type.  @see can_t
@@ -163,6 +191,8 @@ bool CAN_rx(can_t can, can_msg_t *msg, uint32_t timeout_ms);
  *
  * The transmit queue is only used if all three buffers of the CAN hardware are busy,
  * in which case, the transmission complete interrupt will later send the queued msg.
+ * The transmit queue is ordered by the priority of the message ID, such that the
+ * lower IDs are sent before the higher IDs.  @see CAN_get_id_priority()
  * @return  If CAN message was either sent, or queued, true is returned.  If all the
  *          hardware buffers are full, and the queue is full, then false is returned
  *          if timeout occurs waiting for the queue to empty.
@@ -178,6 +208,23 @@ bool CAN_rx(can_t can, can_msg_t *msg, uint32_t timeout_ms);
  */
 bool CAN_tx(can_t can, can_msg_t *msg, uint32_t timeout_ms);
 
+/**
+ * Sends a CAN message with an explicit priority rather than the priority of its ID.
+ * The queued messages with lower priority value are sent first, and messages of the same
+ * priority are sent in the order of the calls, so urgent messages pass the bulk messages
+ * that are waiting to be sent.  The priority also selects which HW buffer is sent first.
+ *
+ * @param priority  0 is the highest priority, and 255 is the lowest
+ * @note The other parameters are the same as CAN_tx()
+ */
+bool CAN_tx_with_priority(can_t can, can_msg_t *msg, uint8_t priority, uint32_t timeout_ms);
+
+/**
+ * @returns the priority of the message ID used by CAN_tx(), which is the most significant
+ *          8 bits of the 11-bit ID, or of the 11-bit base of a 29-bit ID
+ */
+uint8_t CAN_get_id_priority(const can_msg_t *msg);
+
 /** @{ CAN Bus Error and Reset API
  * If the CAN BUS encounters error(s), it may turn off, in which case no more
  * transmissions will take place.  This must be corrected by the user.
@@ -186,9 +233,19 @@ bool CAN_is_bus_off(can_t can);
 void CAN_reset_bus(can_t can);
 /** @} */
 
+/**
+ * Enables or disables the self-test mode, and resets the bus to apply it.
+ * In the self-test mode, each message sent is also received by the same CAN, and
+ * the message does not need to be acknowledged by another node.
+ * @note You need to either connect a CAN transceiver, or connect RD/TD wires of
+ *       the board with a 1K resistor for the messages to be received.
+ * @pre  CAN_init() and the CAN filter (or CAN_bypass_filter_accept_all_msgs()) is setup
+ */
+void CAN_set_self_test(can_t can, bool enable);
+
 /** @{ Watermark and counter API */
 uint16_t CAN_get_rx_watermark(can_t can); ///< RX FreeRTOS Queue watermark
-uint16_t CAN_get_tx_watermark(can_t can); ///< TX FreeRTOS Queue watermark
+uint16_t CAN_get_tx_watermark(can_t can); ///< TX priority queue watermark
 uint16_t CAN_get_tx_count(can_t can); ///< Number of messages written to the CAN HW
 uint16_t CAN_get_rx_count(can_t can); ///< Number of messages successfully queued from CAN interrupt (not including dropped)
 /** @} */
@@ -200,6 +257,63 @@ uint16_t CAN_get_rx_count(can_t can); ///< Number of messages successfully queue
  */
 uint16_t CAN_get_rx_dropped_count(can_t can);
 
+/// The frames of one ID in the last window of the statistics
+typedef struct {
+    uint32_t msg_id;    ///< The message ID, with CAN_STATS_ID_29BIT set if it is a 29-bit ID
+    uint16_t frames;    ///< The frames of the ID received and sent in the window
+    uint16_t per_sec;   ///< The frames per second
+} can_id_rate_t;
+
+/// The traffic statistics of a CAN, @see CAN_get_stats()
+typedef struct {
+    uint32_t bitrate;               ///< The bit rate of the bit timing register, 0 before CAN_init()
+    uint32_t window_end_ms;         ///< The uptime at the end of the last window
+    uint16_t load_x100;             ///< The bus load of the last window in 1/100 of a percent
+    uint16_t peak_load_x100;        ///< The highest load_x100
+    uint16_t rx_per_sec;            ///< The frames received per second in the last window
+    uint16_t tx_per_sec;            ///< The frames sent per second in the last window
+    uint32_t tx_latency_us;         ///< The time from CAN_tx() to the TX complete interrupt of the last message
+    uint32_t tx_latency_avg_us;     ///< The moving average of tx_latency_us over about 16 messages
+    uint32_t tx_latency_max_us;     ///< The highest tx_latency_us
+    can_id_rate_t top_ids[CAN_STATS_TOP_IDS];   ///< The busiest IDs of the last window, busiest first
+} can_stats_t;
+
+/**
+ * @returns the traffic statistics of the CAN, which stay at the same address so they can be
+ *          registered as a binary telemetry variable.
+ *
+ * The CAN interrupt adds the bits of each frame that is received and sent to the current window,
+ * and computes the statistics at the end of each window of CAN_STATS_WINDOW_MS.  This call also
+ * ends the window if it is due, so the statistics are up to date while the bus is idle.
+ *
+ * The bits of a frame are its worst case length with the stuff bits and the interframe space, so
+ * the load is an upper estimate of the frames that this node sees.  The frames rejected by the
+ * acceptance filter and the FullCAN messages are not seen, so use CAN_bypass_filter_accept_all_msgs()
+ * to measure the whole bus.  In self test mode, each frame that is sent is also counted as received.
+ *
+ * The busiest IDs are counted with the Space-Saving algorithm: an ID that is not one of the
+ * CAN_STATS_TRACKED_IDS takes over the one with the fewest frames, so its count may be too high by
+ * at most the count it took over, but an ID with more than 1/CAN_STATS_TRACKED_IDS of the frames
+ * of the window is always one of them.
+ */
+const can_stats_t* CAN_get_stats(can_t can);
+
+/// Clears the peak load and the latencies of the statistics
+void CAN_reset_stats(can_t can);
+
+/**
+ * The tap of a CAN, which the CAN interrupt calls with each frame that is received, even if the
+ * RX queue is full, and with each frame once it is sent, such as to record the traffic of the bus.
+ * @param pMsg          The frame, which is only valid during the call
+ * @param timestamp_us  The sys_get_uptime_us() of the CAN interrupt that read or sent the frame
+ * @param tx            True if the frame was sent by this CAN
+ * @warning This is called from the CAN interrupt, so it must be short and only use the FromISR API.
+ */
+typedef void (*can_tap_func_t)(can_t can, const can_msg_t *pMsg, uint64_t timestamp_us, bool tx);
+
+/// Sets the tap of the CAN, or NULL to remove it
+void CAN_set_tap(can_t can, can_tap_func_t tap);
+
 /**
  * Enables CAN bypass mode to accept all messages on the bus.
  * Either CAN filters need to be setup or this method should be called to accept
@@ -360,6 +474,61 @@ bool CAN_setup_filter(const can_std_id_t *std_id_list,           uint16_t sid_cn
                       const can_ext_id_t *ext_id_list,           uint16_t eid_cnt,
                       const can_ext_grp_id_t *ext_group_id_list, uint16_t egp_cnt);
 
+/* ---------------------------------------------------------------------------------------
+ * Filter set API : Rather than the raw lists of CAN_setup_filter(), a filter set is a list
+ * of IDs with masks in any order, which is converted to the smallest acceptance filter.
+ * ---------------------------------------------------------------------------------------
+ */
+
+/// Mask of a filter to only accept its ID
+#define CAN_FILTER_EXACT    0xFFFFFFFF
+
+/// A filter of the filter set
+typedef struct {
+    uint32_t id;        ///< The ID to accept
+    uint32_t mask;      ///< The bits of the ID that must match, or CAN_FILTER_EXACT
+    can_t can;          ///< The CAN controller the filter is for
+    bool is_29bit;      ///< true if the filter is for the extended IDs
+} can_filter_t;
+
+/**
+ * Replaces the acceptance filter by the filter set.
+ * The filters are converted to ranges of IDs, which are sorted, and the overlapping or adjacent
+ * ranges are merged.  The ranges of a single ID use individual entries, and the other ranges use
+ * groups.  A mask with "don't care" bits above some of its care bits is split into a range for each
+ * combination of those bits, with up to 8 such bits.
+ *
+ * The new table is built in memory first, and the filter RAM is swapped in a critical section,
+ * so this can be called while the CAN BUS is running, and the FullCAN entries are kept.
+ *
+ * @code
+ *      const can_filter_t filters[] = {
+ *          { 0x100, CAN_FILTER_EXACT, can1, false },   // Only 0x100
+ *          { 0x200, 0x7F0,            can1, false },   // 0x200 - 0x20F
+ *          { 0x3500, 0x1FFFFF00,      can2, true  },   // 0x3500 - 0x35FF
+ *      };
+ *      CAN_filter_set_apply(filters, sizeof(filters) / sizeof(filters[0]));
+ * @endcode
+ *
+ * @returns true if the filters were valid, and fit the filter RAM.  Otherwise the filter is not changed.
+ * @note    The pointers returned by CAN_fullcan_get_entry_ptr() must be obtained again because the
+ *          FullCAN messages are stored after the end of the filter table.
+ * @note    An empty filter set accepts only the FullCAN messages, and this overrides
+ *          CAN_bypass_filter_accept_all_msgs()
+ */
+bool CAN_filter_set_apply(const can_filter_t *filters, uint16_t count);
+
+/**
+ * @returns the bytes of filter RAM that CAN_filter_set_apply() would use for the filters,
+ *          not including the FullCAN entries, or -1 if the filters are invalid
+ */
+int32_t CAN_filter_set_get_ram_bytes(const can_filter_t *filters, uint16_t count);
+
+/**
+ * @returns the bytes of the 2048 byte filter RAM in use, including the FullCAN entries and their messages
+ */
+uint16_t CAN_filter_get_ram_used(void);
+
 
 
 #ifdef __cplusplus
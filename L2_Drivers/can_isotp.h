@@ -0,0 +1,147 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @ingroup Drivers
+ *
+ * ISO-TP (ISO 15765-2) transport of messages up to 4095 bytes over the CAN BUS, with the
+ * normal addressing of classic CAN frames.
+ *
+ * A session sends its frames with its TX ID, and receives the frames of the other node with
+ * its RX ID, so the other node uses the same IDs swapped.  A message of up to 7 bytes is sent
+ * as a single frame, and a larger message is sent as a first frame followed by consecutive
+ * frames, paced by the flow control frames of the receiver with its block size and STmin.
+ *
+ * The CAN messages are received by CAN_isotp_service(), which dispatches them to the sessions.
+ * A task can call CAN_isotp_service() in a loop, but if no task is doing so, the functions that
+ * wait for the frames call it themselves, so any number of sessions can be used at once.
+ * CAN_rx() must not be used by another task, so use CAN_isotp_set_rx_callback() to get
+ * the CAN messages that do not belong to a session.
+ *
+ * @code
+ *      static uint8_t rx_buffer[1024];
+ *      static can_isotp_t session;
+ *      CAN_isotp_init(&session, can1, 0x7E0, 0x7E8, false, rx_buffer, sizeof(rx_buffer));
+ *
+ *      CAN_isotp_send(&session, data, 1000, 1000);
+ *      uint32_t len = CAN_isotp_recv(&session, data, sizeof(data), 1000);
+ * @endcode
+ */
+#ifndef CAN_ISOTP_H__
+#define CAN_ISOTP_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "can.h"
+
+
+
+#define CAN_ISOTP_MAX_LEN       4095    ///< Maximum length of a message
+#define CAN_ISOTP_TIMEOUT_MS    1000    ///< Time to wait for the flow control or consecutive frames of the other node
+
+/// Callback of the CAN messages received by CAN_isotp_service() that do not belong to a session
+typedef void (*can_isotp_rx_callback_t)(can_t can, const can_rx_msg_t *msg);
+
+/// An ISO-TP session; the members are private, and set by CAN_isotp_init()
+typedef struct can_isotp {
+    can_t can;                      ///< The CAN BUS
+    uint32_t tx_id;                 ///< ID of the frames we send
+    uint32_t rx_id;                 ///< ID of the frames we receive
+    bool is_29bit;                  ///< The IDs are 29-bit
+    uint8_t block_size;             ///< Consecutive frames we receive before we send a flow control, 0 for all
+    uint8_t st_min;                 ///< Minimum time between the consecutive frames we receive (ISO-TP encoding)
+
+    uint8_t *rx_buffer;             ///< Buffer of the received message
+    uint16_t rx_size;               ///< Size of the rx_buffer
+    volatile uint16_t rx_len;       ///< Received bytes of the message
+    uint16_t rx_expected;           ///< Length of the message being received
+    volatile uint8_t rx_state;      ///< State of the reception
+    uint8_t rx_sn;                  ///< Expected sequence number of the next consecutive frame
+    uint8_t rx_block_count;         ///< Consecutive frames received in this block
+    bool rx_ff_pending;             ///< A first frame arrived before the last message was read
+    uint8_t rx_ff[8];               ///< The data of the pending first frame
+    uint32_t rx_last_ms;            ///< Uptime of the last frame received
+    SemaphoreHandle_t rx_event;     ///< Given when a message is received
+
+    uint8_t tx_fc[3];               ///< The last flow control frame received
+    SemaphoreHandle_t tx_event;     ///< Given when a flow control frame is received
+
+    struct can_isotp *next;         ///< Next session of the list of sessions
+} can_isotp_t;
+
+/**
+ * Initializes and registers a session.
+ * @param tx_id      ID of the frames we send
+ * @param rx_id      ID of the frames of the other node
+ * @param rx_buffer  Buffer of the received messages, and its size is the longest message we can receive
+ * @returns false if out of memory or invalid parameters
+ * @note The CAN BUS must be initialized, and its filter must accept the RX ID.
+ */
+bool CAN_isotp_init(can_isotp_t *session, can_t can, uint32_t tx_id, uint32_t rx_id, bool is_29bit,
+                    uint8_t *rx_buffer, uint16_t rx_size);
+
+/**
+ * Sets the flow control we send to the other node when we receive a message.
+ * @param block_size  Frames the other node sends before it waits for our next flow control; 0 for no limit
+ * @param st_min      Minimum time between the frames: 0-127 ms, or 0xF1-0xF9 for 100-900 us
+ */
+void CAN_isotp_set_flow_control(can_isotp_t *session, uint8_t block_size, uint8_t st_min);
+
+/**
+ * Sends a message, and blocks until it is sent.  A message larger than 7 bytes is paced
+ * by the flow control frames of the other node.
+ * @param timeout_ms  Time to wait for each CAN frame to be queued
+ * @returns true if the message was sent, or false if the other node did not respond, or overflowed
+ */
+bool CAN_isotp_send(can_isotp_t *session, const void *data, uint16_t len, uint32_t timeout_ms);
+
+/**
+ * Receives a message.
+ * @returns the length of the message copied to data, or 0 if no message was received within the timeout
+ * @note If a message is longer than max, it is truncated.
+ */
+uint16_t CAN_isotp_recv(can_isotp_t *session, void *data, uint16_t max, uint32_t timeout_ms);
+
+/**
+ * Dispatches a received CAN message to the sessions.  This is only needed by an application that
+ * reads the CAN messages itself rather than CAN_isotp_service().
+ * @returns true if the message belongs to a session
+ */
+bool CAN_isotp_dispatch(can_t can, const can_msg_t *msg);
+
+/**
+ * Receives the CAN messages of the CAN BUS, and dispatches them to the sessions.
+ * Other messages are given to the callback set by CAN_isotp_set_rx_callback(), or dropped.
+ * @returns false if no message was received within the timeout
+ */
+bool CAN_isotp_service(can_t can, uint32_t timeout_ms);
+
+/// Sets the callback of the CAN messages that do not belong to a session
+void CAN_isotp_set_rx_callback(can_isotp_rx_callback_t callback);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* CAN_ISOTP_H__ */
@@ -0,0 +1,133 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @ingroup Drivers
+ *
+ * CAN mailboxes and signals on top of the FullCAN.
+ *
+ * A mailbox is a FullCAN entry whose message is written by the CAN hardware without any
+ * interrupt or queue, so it always holds the latest message of its ID.  Signals describe
+ * the fields of the message data, and are decoded from a consistent snapshot of the mailbox.
+ * This is meant for periodic messages, such as sensor values, where only the latest value
+ * matters.
+ *
+ * @code
+ *      // Declare the mailboxes and their signals
+ *      can_mailbox_t g_motor = CAN_MAILBOX(can1, 0x120);
+ *      can_mailbox_t g_sonar = CAN_MAILBOX(can1, 0x140);
+ *      const can_signal_t g_motor_rpm  = CAN_SIGNAL( 0, 16, false, 0.25f, 0);    // LSB at bit 0
+ *      const can_signal_t g_motor_temp = CAN_SIGNAL(16,  8, true,  1.0f, 40);
+ *
+ *      // After CAN_init(), and before CAN_setup_filter() or CAN_filter_set_apply()
+ *      can_mailbox_t *boxes[] = { &g_motor, &g_sonar };
+ *      CAN_mailbox_init(boxes, 2);
+ *      CAN_reset_bus(can1);
+ *
+ *      // Any task can read the latest values
+ *      float rpm = 0;
+ *      if (CAN_mailbox_get_signal(&g_motor, &g_motor_rpm, &rpm) && CAN_mailbox_get_age_ms(&g_motor) < 100) {
+ *          // Use rpm
+ *      }
+ * @endcode
+ */
+#ifndef CAN_MAILBOX_H__
+#define CAN_MAILBOX_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+#include "can.h"
+
+
+
+/**
+ * A signal of the CAN message data, in the little-endian (Intel) bit order where bit 0 is
+ * the LSB of the first data byte.  The value is (raw * scale) + offset.
+ */
+typedef struct {
+    uint8_t start_bit;  ///< Bit of the LSB of the signal (0-63)
+    uint8_t bit_len;    ///< Number of bits of the signal (1-64)
+    bool is_signed;     ///< The signal is a two's complement number
+    float scale;        ///< Scale of the raw value
+    float offset;       ///< Offset added after the scale
+} can_signal_t;
+
+/// A mailbox of a FullCAN message; only modify it through the API
+typedef struct {
+    can_t can;                  ///< The CAN controller of the message
+    uint16_t id;                ///< The 11-bit message ID
+    uint16_t index;             ///< The FullCAN index of the message (set by CAN_mailbox_init())
+    uint32_t rx_count;          ///< Number of new messages found by the readers
+    uint32_t last_rx_ms;        ///< Uptime when a reader found the last new message
+} can_mailbox_t;
+
+/// Initializer of a signal
+#define CAN_SIGNAL(start_bit, bit_len, is_signed, scale, offset)   { start_bit, bit_len, is_signed, scale, offset }
+
+/// Initializer of a mailbox
+#define CAN_MAILBOX(can, id)                                        { can, id, 0, 0, 0 }
+
+/**
+ * Adds the mailboxes as FullCAN entries, in the ascending order of their CAN and ID as
+ * required by the hardware.  This should be called once after CAN_init(), and before
+ * the other filters are set up.  @see CAN_fullcan_add_entry()
+ *
+ * @param boxes  The pointers to the mailboxes, which must exist as long as they are used
+ * @returns true if all the mailboxes were added
+ */
+bool CAN_mailbox_init(can_mailbox_t **boxes, uint16_t count);
+
+/**
+ * Gets a consistent snapshot of the message data of the mailbox.  The semaphore bits of the
+ * FullCAN message are cleared before the data is read, and if the hardware changes them while
+ * the data is read, the data is read again.
+ *
+ * @param data  The data of the message is copied to this pointer; this can be NULL to only check
+ *              for a new message.
+ * @returns true if a message was ever received, and the data is consistent
+ */
+bool CAN_mailbox_read(can_mailbox_t *box, can_data_t *data);
+
+/**
+ * @returns the milliseconds since a reader found the last new message of the mailbox, or
+ *          UINT32_MAX if no message was received.  This is only updated when the mailbox is
+ *          read, so its precision depends on how often the mailbox is read.
+ */
+uint32_t CAN_mailbox_get_age_ms(can_mailbox_t *box);
+
+/** @{ Decoding of the signals from the message data */
+uint64_t CAN_signal_get_raw(const can_signal_t *signal, const can_data_t *data); ///< The raw bits of the signal
+int64_t CAN_signal_get_int(const can_signal_t *signal, const can_data_t *data);  ///< Raw value with the sign
+float CAN_signal_get_value(const can_signal_t *signal, const can_data_t *data);  ///< Scaled value
+/** @} */
+
+/**
+ * Reads a consistent snapshot of the mailbox, and decodes the scaled signal value
+ * @returns false if the mailbox has no message
+ */
+bool CAN_mailbox_get_signal(can_mailbox_t *box, const can_signal_t *signal, float *value);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* CAN_MAILBOX_H__ */
@@ -0,0 +1,112 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @ingroup Drivers
+ *
+ * This API runs any number of one-shot and periodic callbacks with microsecond resolution from
+ * the match interrupt of the timer selected by SYS_CFG_HW_TIMER.  The timers are kept in a list
+ * sorted by their deadline, and the match register is always set to the first deadline, so the
+ * interrupt only occurs when a timer expires.  The timers that are due at the same time (or
+ * become due while the callbacks run) are handled by the same interrupt.
+ *
+ * Unlike the FreeRTOS software timers, the callbacks do not depend on the 1ms OS tick or the
+ * priority of the timer task, but they run in the interrupt context, so they should be short
+ * and only use the FreeRTOS "FromISR" API.
+ *
+ * The hw_timer_t is owned by the caller, so nothing is allocated.
+ * @code
+ *      static hw_timer_t timeout;
+ *      static void timeout_callback(hw_timer_t *timer, void *arg) { ... }
+ *
+ *      hw_timer_init(&timeout, timeout_callback, NULL);
+ *      hw_timer_start(&timeout, 250, 0);       // One-shot after 250us
+ *      hw_timer_start(&timeout, 100, 100);     // Every 100us starting 100us from now
+ *      hw_timer_stop(&timeout);
+ * @endcode
+ *
+ * 20261014: Initial
+ */
+#ifndef HW_TIMER_H__
+#define HW_TIMER_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/// The max delay or period in microseconds, so the deadlines can be compared across the timer rollover
+#define HW_TIMER_MAX_US     (UINT32_C(1) << 31)
+
+struct hw_timer;
+
+/**
+ * Callback function called from the timer interrupt when the timer expires
+ * @param timer  The timer that expired, which can be started again from the callback
+ * @param arg    The argument given to hw_timer_init()
+ */
+typedef void (*hw_timer_callback_t)(struct hw_timer *timer, void *arg);
+
+/// A timer of the timer service; the members are private to hw_timer.c
+typedef struct hw_timer {
+    struct hw_timer *next;          ///< The next timer in the list sorted by the deadline
+    uint32_t deadline;              ///< The timer value when this timer expires
+    uint32_t period_us;             ///< The period, or 0 if one-shot
+    hw_timer_callback_t callback;   ///< The callback when this timer expires
+    void *arg;                      ///< The argument of the callback
+    volatile bool active;           ///< true while this timer is in the list
+} hw_timer_t;
+
+/**
+ * Initializes a timer, and starts the timer service the first time it is called.
+ * This must be called from a task (or before the scheduler starts), but the other
+ * functions can be also used from an interrupt.
+ * @param timer     The timer
+ * @param callback  The callback when the timer expires
+ * @param arg       The argument of the callback
+ */
+void hw_timer_init(hw_timer_t *timer, hw_timer_callback_t callback, void *arg);
+
+/**
+ * Starts (or restarts) a timer
+ * @param timer      The timer initialized by hw_timer_init()
+ * @param delay_us   The time to the first expiry
+ * @param period_us  The period after the first expiry, or 0 for a one-shot timer.  The periodic
+ *                   deadlines advance by the period, so they do not drift with the interrupt latency.
+ * @returns false if the delay or the period is larger than HW_TIMER_MAX_US
+ */
+bool hw_timer_start(hw_timer_t *timer, uint32_t delay_us, uint32_t period_us);
+
+/// Stops a timer; the callback is not called once this returns (unless it is already running)
+void hw_timer_stop(hw_timer_t *timer);
+
+/// @returns true if the timer is started and has not expired (periodic timers stay active)
+static inline bool hw_timer_is_active(const hw_timer_t *timer) { return timer->active; }
+
+/// @returns the microseconds counter of the timer service, which wraps around after 2^32 us
+uint32_t hw_timer_get_us(void);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* HW_TIMER_H__ */
@@ -0,0 +1,270 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @ingroup Drivers
+ *
+ * This API provides the common GPDMA functionality shared by the drivers that use DMA.
+ * There is only one DMA interrupt for all 8 channels, so the drivers register their
+ * channel's callback here instead of defining the DMA_IRQHandler() themselves.
+ *
+ * The drivers claim their channel of dma_ch_t with dma_channel_claim(), and the other users
+ * get a free channel from dma_channel_alloc(), so two users never share a channel.  The
+ * dma_build_lli() builds the linked list of a transfer longer than one item, and
+ * dma_copy_start() or dma_memcpy() copy the memory blocks (scatter-gather) with the DMA.
+ *
+ * 20141012: Initial
+ * 20261014: Added the channel allocation, the linked list builder and the memory copies
+ */
+#ifndef LPC_DMA_H__
+#define LPC_DMA_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+#include "LPC17xx.h"
+
+
+
+/**
+ * DMA channel numbers used by the drivers.
+ * Lower channel number has higher priority, so SSP1 (SD card and flash memory) uses the
+ * first two channels.  The other channels are suggestions for the drivers using DMA.
+ * The ADC burst capture of adc0.h uses dma_ch_adc, and SSP0 (the wireless radio) uses
+ * its own channels so its transfers do not collide with the SSP1 transfers.
+ * A channel is only used by a driver while the driver has claimed it, and the channels
+ * not claimed are given out by dma_channel_alloc().
+ */
+typedef enum {
+    dma_ch_ssp1_tx  = 0,
+    dma_ch_ssp1_rx  = 1,
+    dma_ch_uart_tx  = 2,
+    dma_ch_uart_rx  = 3,
+    dma_ch_adc      = 4,
+    dma_ch_ssp0_tx  = 5,
+    dma_ch_ssp0_rx  = 6,
+    dma_ch_free7    = 7,
+    dma_ch_max      = 8,
+} dma_ch_t;
+
+/**
+ * DMA peripheral request numbers (DMACCConfig source and destination peripheral).
+ * The UART requests are the default selection of the DMAREQSEL register.
+ */
+typedef enum {
+    dma_req_ssp0_tx  = 0,
+    dma_req_ssp0_rx  = 1,
+    dma_req_ssp1_tx  = 2,
+    dma_req_ssp1_rx  = 3,
+    dma_req_adc      = 4,
+    dma_req_uart0_tx = 8,
+    dma_req_uart0_rx = 9,
+    dma_req_uart1_tx = 10,
+    dma_req_uart1_rx = 11,
+    dma_req_uart2_tx = 12,
+    dma_req_uart2_rx = 13,
+    dma_req_uart3_tx = 14,
+    dma_req_uart3_rx = 15,
+} dma_req_t;
+
+/**
+ * @{ Bits of DMACCControl and DMACCConfig registers
+ * Transfer size is B11:B0 of DMACCControl, so a single transfer is limited to 4095 units
+ */
+#define DMA_CTRL_SIZE_MASK      (0xFFF)
+#define DMA_CTRL_SRC_BURST(b)   ((b) << 12) ///< @see dma_burst_t
+#define DMA_CTRL_DST_BURST(b)   ((b) << 15) ///< @see dma_burst_t
+#define DMA_CTRL_SRC_WIDTH(w)   ((w) << 18) ///< @see dma_width_t
+#define DMA_CTRL_DST_WIDTH(w)   ((w) << 21) ///< @see dma_width_t
+#define DMA_CTRL_SRC_INCR       (1 << 26)
+#define DMA_CTRL_DST_INCR       (1 << 27)
+#define DMA_CTRL_TC_INTR        (1 << 31)
+
+#define DMA_CFG_ENABLE          (1 << 0)
+#define DMA_CFG_SRC_PERIPH(p)   ((p) << 1)
+#define DMA_CFG_DST_PERIPH(p)   ((p) << 6)
+#define DMA_CFG_M_TO_M          (0 << 11)
+#define DMA_CFG_M_TO_P          (1 << 11)
+#define DMA_CFG_P_TO_M          (2 << 11)
+#define DMA_CFG_ERR_INTR        (1 << 14)
+#define DMA_CFG_TC_INTR         (1 << 15)
+/** @} */
+
+/// Burst size field of DMACCControl (number of transfers per DMA request)
+typedef enum {
+    dma_burst_1   = 0,
+    dma_burst_4   = 1,
+    dma_burst_8   = 2,
+    dma_burst_16  = 3,
+} dma_burst_t;
+
+/// Width field of DMACCControl
+typedef enum {
+    dma_width_8bit  = 0,
+    dma_width_16bit = 1,
+    dma_width_32bit = 2,
+} dma_width_t;
+
+/**
+ * Linked list item (LLI) of the DMA controller.  The hardware loads the next
+ * item from this structure after the current transfer completes.
+ * @note This must be aligned to 4-bytes and reside in AHB accessible RAM.
+ */
+typedef struct dma_lli {
+    uint32_t src;               ///< Source address
+    uint32_t dst;               ///< Destination address
+    const struct dma_lli *next; ///< Next item or NULL at the end of the list
+    uint32_t ctrl;              ///< DMACCControl value for this item
+} dma_lli_t;
+
+/**
+ * Callback function called from the DMA interrupt
+ * @param arg    The argument given to dma_register_callback()
+ * @param error  true if the channel interrupt was due to a DMA error
+ */
+typedef void (*dma_callback_t)(void *arg, bool error);
+
+/// The priority of dma_channel_alloc(), the lower channel numbers have the higher priority
+typedef enum {
+    dma_prio_high = 0,  ///< The lowest free channel number
+    dma_prio_low  = 1,  ///< The highest free channel number
+} dma_prio_t;
+
+/// A memory block of the scatter-gather copy of dma_copy_start()
+typedef struct {
+    void *dst;
+    const void *src;
+    uint32_t bytes;
+} dma_copy_t;
+
+#define DMA_MEMCPY_MIN_BYTES    256     ///< dma_memcpy() of fewer bytes uses memcpy(), which is faster to set up
+#define DMA_MEMCPY_MAX_LLI      2       ///< The linked list items of each channel for dma_memcpy()
+
+
+
+/**
+ * Powers up and enables the GPDMA controller.
+ * This can be called multiple times, and only the first call will initialize the hardware.
+ */
+void dma_init(void);
+
+/**
+ * @returns the channel registers of the given DMA channel
+ */
+static inline LPC_GPDMACH_TypeDef* dma_get_channel(const dma_ch_t ch)
+{
+    return (LPC_GPDMACH_TypeDef*) (LPC_GPDMACH0_BASE + (ch * 0x20));
+}
+
+/**
+ * @returns true if the memory can be accessed by the DMA.  The DMA can only access the AHB RAM,
+ *          so it cannot access the task stacks allocated from the heap in the CPU RAM (@see loader.ld).
+ */
+static inline bool dma_is_accessible(const void *pMem)
+{
+    const uint32_t addr = (uint32_t) pMem;
+    return (addr >= 0x2007C000 && addr < 0x20084000);
+}
+
+/// @returns true if the DMA channel is enabled (transfer is still in progress)
+static inline bool dma_channel_busy(const dma_ch_t ch)
+{
+    return !!(LPC_GPDMA->DMACEnbldChns & (1 << ch));
+}
+
+/**
+ * Clears the pending interrupts of the channel.
+ * This must be done before enabling a channel otherwise DMA will not start.
+ */
+static inline void dma_clear_intr(const dma_ch_t ch)
+{
+    LPC_GPDMA->DMACIntTCClear = (1 << ch);
+    LPC_GPDMA->DMACIntErrClr  = (1 << ch);
+}
+
+/**
+ * Registers a callback for the terminal count and error interrupt of a DMA channel
+ * and enables the DMA interrupt.  The channel's DMACCConfig must still enable the
+ * interrupts using DMA_CFG_TC_INTR and DMA_CFG_ERR_INTR.
+ *
+ * @param ch    The DMA channel
+ * @param cb    The callback function, or NULL to unregister the callback
+ * @param arg   The argument that will be given to the callback
+ */
+void dma_register_callback(const dma_ch_t ch, dma_callback_t cb, void *arg);
+
+/**
+ * Claims the given channel for a driver that uses a fixed channel of dma_ch_t.
+ * @returns false if the channel is already used by someone else
+ */
+bool dma_channel_claim(const dma_ch_t ch);
+
+/**
+ * Allocates a free channel.
+ * @returns the channel, or dma_ch_max if all channels are in use
+ */
+dma_ch_t dma_channel_alloc(const dma_prio_t prio);
+
+/// Frees the channel of dma_channel_claim() or dma_channel_alloc(), and unregisters its callback
+void dma_channel_free(const dma_ch_t ch);
+
+/**
+ * Builds the linked list to transfer num_units, each item transferring at most DMA_CTRL_SIZE_MASK
+ * units because the DMACCControl's transfer size is only 12-bits.
+ * The items are linked to each other, and the next of the last item is NULL.
+ *
+ * @param ctrl       The DMACCControl bits of each item besides the transfer size.  The addresses are
+ *                   only advanced for the next item if ctrl has DMA_CTRL_SRC_INCR or DMA_CTRL_DST_INCR.
+ * @param unit_size  The bytes of each unit, which is the width of the transfer
+ * @returns the number of linked list items used, which is less than needed if max_lli is too few
+ */
+uint32_t dma_build_lli(dma_lli_t *pLli, uint32_t max_lli, uint32_t src, uint32_t dst,
+                       uint32_t num_units, uint32_t ctrl, uint32_t unit_size);
+
+/// Loads the first linked list item to the channel registers, and starts the channel if config enables it
+void dma_load_channel(const dma_ch_t ch, const dma_lli_t *pLli, uint32_t config);
+
+/**
+ * Starts the scatter-gather copy of the memory blocks.  Each block uses 32-bit transfers if its
+ * addresses and size are word aligned, otherwise 8-bit transfers.
+ *
+ * @param ch       A channel of dma_channel_alloc()
+ * @param pLli     The linked list items in the DMA accessible memory
+ * @param max_lli  The number of pLli items
+ * @param cb       The callback of the DMA interrupt when all blocks are copied, or NULL
+ * @returns false if the channel is busy, or if the blocks need more than max_lli items
+ */
+bool dma_copy_start(const dma_ch_t ch, dma_lli_t *pLli, uint32_t max_lli,
+                    const dma_copy_t *pBlocks, uint32_t count, dma_callback_t cb, void *arg);
+
+/**
+ * Copies the memory like memcpy() using a low priority DMA channel, and the calling task sleeps
+ * until the copy is done, so the CPU runs the other tasks during the copy.  The memcpy()
+ * is used instead if the copy is small or not word aligned, the memory is not accessible by the
+ * DMA, no channel is free, or if this is called from an ISR or before FreeRTOS is running.
+ */
+void dma_memcpy(void *dst, const void *src, uint32_t bytes);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* LPC_DMA_H__ */
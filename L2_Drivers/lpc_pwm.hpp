@@ -1,80 +1,165 @@
-/*
- *     SocialLedge.com - Copyright (C) 2013
- *
- *     This file is part of free software framework for embedded processors.
- *     You can use it and/or distribute it as long as this copyright header
- *     remains unmodified.  The code is free for personal use and requires
- *     permission to use in a commercial product.
- *
- *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
- *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
- *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
- *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
- *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
- *
- *     You can reach the author of this software at :
- *          p r e e t . w i k i @ g m a i l . c o m
- */
-
-/**
- * @file
- * @ingroup Drivers
- */
-#ifndef LPC_PWM_HPP__
-#define LPC_PWM_HPP__
-
-
-
-/**
- * LPC PWM class.
- * Example:
- * @code
- *      PWM pwm2(PWM::pwm2, 50);
- *      pwm2.set(10);
- *      pwm2.set(5.0);
- * @endcode
- */
-class PWM
-{
-    public :
-        typedef enum {
-            pwm1=0, ///< P2.0
-            pwm2=1, ///< P2.1
-            pwm3=2, ///< P2.2
-            pwm4=3, ///< P2.3
-            pwm5=4, ///< P2.4
-            pwm6=5  ///< P2.5
-        } pwmType;
-
-        /**
-         * Initialize a PWM
-         * @param frequencyHz  The frequency of the PWM
-         * @note Frequency is only initialized the first time this class is constructed.
-         *       Once it is initialized, it cannot be set or changed when more objects are constructed.
-         */
-        PWM(pwmType pwm, unsigned int frequencyHz=50);
-
-        /// Destructor that will destroy PWM configuration
-        ~PWM();
-
-        /**
-         * Sets the PWM based on the percentage.
-         * If 50Hz Servo PWM was setup, then you can use the following :
-         *      - Left    : set(5.0);  // 5.0 % of 20ms = 1.0ms
-         *      - Neutral : set(7.5);  // 7.5 % of 20ms = 1.5ms
-         *      - Right   : set(10.0); // 10  % of 20ms = 2.0ms
-         *
-         * You can use micro-steps to position the servo motor by using
-         * set(5.1), set(5.2) ... set(7.4) etc.
-         */
-        bool set(float percent);
-
-    private:
-        PWM();                          ///< Disallow default constructor
-        const pwmType mPwm;             ///< The PWM channel number set by constructor
-        static unsigned int msTcMax;    ///< PWM TC max (this controls the frequency)
-};
-
-
-
-#endif /* LPC_PWM_HPP__ */
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @ingroup Drivers
+ */
+#ifndef LPC_PWM_HPP__
+#define LPC_PWM_HPP__
+
+#include <stdint.h>
+
+
+
+#define PWM_DUTY_MAX    (UINT32_C(1) << 16) ///< The integer duty of 100%, so the duty is a 16-bit fraction
+
+
+
+/**
+ * LPC PWM class.
+ * Example:
+ * @code
+ *      PWM pwm2(PWM::pwm2, 50);
+ *      pwm2.set(10);
+ *      pwm2.set(5.0);
+ *      pwm2.setPercentX100(750);           // 7.5% without any float math
+ *      pwm2.setDuty(PWM_DUTY_MAX / 4);     // 25% without any float math
+ *      pwm2.setPulseUs(1500);              // 1.5ms servo pulse
+ * @endcode
+ *
+ * The match registers of all channels are double buffered: a new duty is written to the match
+ * register, and the LER register latches it at the start of the next period, so a period never
+ * has half of an old and half of a new duty.  setGroup() latches several channels with one write
+ * of LER, so they start their new duties in the same period, such as the phases of a motor.
+ *
+ * startSequence() applies a table of duties one row per period from the PWM interrupt, so the
+ * motor control loops can step the channels at the PWM rate without a task or DMA.
+ * @code
+ *      static const PWM::pwmType phases[] = { PWM::pwm1, PWM::pwm2, PWM::pwm3 };
+ *      static const uint32_t steps[][3] = { { PWM_DUTY_MAX/2, 0, 0 }, { 0, PWM_DUTY_MAX/2, 0 }, { 0, 0, PWM_DUTY_MAX/2 } };
+ *      PWM::startSequence(phases, 3, &steps[0][0], 3, true);
+ * @endcode
+ */
+class PWM
+{
+    public :
+        typedef enum {
+            pwm1=0, ///< P2.0
+            pwm2=1, ///< P2.1
+            pwm3=2, ///< P2.2
+            pwm4=3, ///< P2.3
+            pwm5=4, ///< P2.4
+            pwm6=5  ///< P2.5
+        } pwmType;
+
+        /**
+         * Initialize a PWM
+         * @param frequencyHz  The frequency of the PWM
+         * @note Frequency is only initialized the first time this class is constructed.
+         *       Once it is initialized, it cannot be set or changed when more objects are constructed.
+         */
+        PWM(pwmType pwm, unsigned int frequencyHz=50);
+
+        /// Destructor that will destroy PWM configuration
+        ~PWM();
+
+        /**
+         * Sets the PWM based on the percentage.
+         * If 50Hz Servo PWM was setup, then you can use the following :
+         *      - Left    : set(5.0);  // 5.0 % of 20ms = 1.0ms
+         *      - Neutral : set(7.5);  // 7.5 % of 20ms = 1.5ms
+         *      - Right   : set(10.0); // 10  % of 20ms = 2.0ms
+         *
+         * You can use micro-steps to position the servo motor by using
+         * set(5.1), set(5.2) ... set(7.4) etc.
+         */
+        bool set(float percent);
+
+        /// Sets the PWM based on the hundredths of the percentage, such as 750 for 7.5 %, with integer math
+        bool setPercentX100(uint32_t percentX100);
+
+        /// Sets the duty from 0 to PWM_DUTY_MAX (100%) with integer math
+        bool setDuty(uint32_t duty);
+
+        /// Sets the high time of each period in microseconds, such as 1000-2000 for a servo
+        bool setPulseUs(uint32_t us);
+
+        /// @returns the PWM clock ticks of one period, which is the resolution of the duty
+        static uint32_t getPeriodTicks(void) { return msTcMax; }
+
+        /**
+         * Sets the duty of several channels, which start their new duty in the same period.
+         * @param pChannels  The channels
+         * @param pDuty      The duty of each channel, from 0 to PWM_DUTY_MAX
+         * @param count      The number of channels
+         * @returns false if a duty or a channel is out of range, and then nothing is changed
+         */
+        static bool setGroup(const pwmType *pChannels, const uint32_t *pDuty, uint8_t count);
+
+        /**
+         * Starts applying a table of duties one row per PWM period.  The table is used from the
+         * PWM interrupt until the sequence ends, so it must not be changed meanwhile.
+         * @param pChannels  The channels of each row
+         * @param count      The number of channels, which is the number of duties of each row
+         * @param pDuties    The rows of the duties, from 0 to PWM_DUTY_MAX
+         * @param steps      The number of rows
+         * @param loop       If true, the sequence starts over after the last row until stopped
+         * @returns false if the arguments are not valid or a sequence is already running
+         */
+        static bool startSequence(const pwmType *pChannels, uint8_t count,
+                                  const uint32_t *pDuties, uint32_t steps, bool loop);
+        static void stopSequence(void);         ///< Stops the sequence after the current row
+        static bool isSequenceRunning(void);    ///< @returns true while a sequence is running
+
+        /** @{ Don't use these functions */
+        static void sequenceIsr(void);
+        /** @} */
+
+    private:
+        PWM();                          ///< Disallow default constructor
+
+        /// @returns the match register of the channel
+        static volatile uint32_t* getMatchReg(pwmType pwm);
+
+        /// @returns the match value of the duty, which must be at most PWM_DUTY_MAX
+        static inline uint32_t dutyToTicks(uint32_t duty)
+        {
+            return (uint32_t) (((uint64_t) duty * msTcMax) >> 16);
+        }
+
+        /// Writes the match values of the channels, and latches all of them with one write of LER
+        static void load(const pwmType *pChannels, const uint32_t *pDuty, uint8_t count);
+
+        const pwmType mPwm;             ///< The PWM channel number set by constructor
+        static unsigned int msTcMax;    ///< PWM TC max (this controls the frequency)
+
+        /** @{ The sequence of startSequence() */
+        static const pwmType *mspSeqChannels;
+        static const uint32_t *mspSeqDuties;
+        static uint32_t msSeqSteps;
+        static volatile uint32_t msSeqStep;
+        static uint8_t msSeqCount;
+        static bool msSeqLoop;
+        static volatile bool msSeqRunning;
+        /** @} */
+};
+
+
+
+#endif /* LPC_PWM_HPP__ */
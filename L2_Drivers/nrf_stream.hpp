@@ -1,80 +1,165 @@
-/*
- *     SocialLedge.com - Copyright (C) 2013
- *
- *     This file is part of free software framework for embedded processors.
- *     You can use it and/or distribute it as long as this copyright header
- *     remains unmodified.  The code is free for personal use and requires
- *     permission to use in a commercial product.
- *
- *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
- *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
- *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
- *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
- *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
- *
- *     You can reach the author of this software at :
- *          p r e e t . w i k i @ g m a i l . c o m
- */
-
-/**
- * @file
- * @brief Nordic stream
- * @ingroup Drivers
- */
-#ifndef NRF_STREAM_HPP_
-#define NRF_STREAM_HPP_
-
-#include <stdint.h>
-#include "wireless.h"
-#include "char_dev.hpp"            // Base class
-#include "singleton_template.hpp"  // Singleton Template
-
-
-
-/**
- * Nordic char device driver
- * @ingroup Drivers
- *
- * This class provides a way to use the nordic like a char device.
- * You can use printf(), scanf() etc, and all the data will be sent to the
- * address set by setDestAddr().  If the destination address is not set, then
- * it will be sent to the last source that sent us data on nordic.
- *
- */
-class NordicStream : public CharDev, public SingletonTemplate<NordicStream>
-{
-    public:
-        /**
-         * Set the destination address.
-         * If address is set to zero, then the packets will be sent to the last
-         * source that sent us the packet.
-         */
-        inline void setDestAddr(uint8_t address) { mDestAddr = address; }
-        inline void setPktHops(uint8_t hops)     { mHops = hops;        }
-
-        /// Flush all buffered data or send any pending data immediately.
-        bool flush(void);
-
-        /** @{ Virtual function overrides for the base class to work */
-        bool getChar(char* pInputChar, unsigned int timeout=portMAX_DELAY);
-        bool putChar(char out, unsigned int timeout=portMAX_DELAY);
-        /** @} */
-
-    private:
-        typedef struct {
-            mesh_packet_t pkt;  ///< actual wireless mesh packet
-            uint8_t dataPtr;    ///< The data pointer of pkt.data[]
-        } nrfPktBuffer_t;
-
-        nrfPktBuffer_t mRxBuffer;   ///< The receive buffer
-        nrfPktBuffer_t mTxBuffer;   ///< The transmit buffer
-        uint8_t mDestAddr;          ///< The destination address
-        uint8_t mHops;              ///< The hops to use for sending the data
-
-        NordicStream();                                ///< Private constructor of this Singleton class
-        friend class SingletonTemplate<NordicStream>;  ///< Friend class used for Singleton Template
-};
-
-
-
-#endif /* NRF_STREAM_HPP_ */
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief Nordic stream
+ * @ingroup Drivers
+ */
+#ifndef NRF_STREAM_HPP_
+#define NRF_STREAM_HPP_
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "timers.h"
+#include "wireless.h"
+#include "char_dev.hpp"            // Base class
+#include "singleton_template.hpp"  // Singleton Template
+
+
+
+#define NRF_STREAM_WINDOW_MAX   4   ///< Max payloads in flight of the windowed mode (@see setWindow())
+#define NRF_STREAM_RETRIES      1   ///< Times a payload of the windowed mode is sent again before it fails
+
+
+
+/**
+ * Nordic char device driver
+ * @ingroup Drivers
+ *
+ * This class provides a way to use the nordic like a char device.
+ * You can use printf(), scanf() etc, and all the data will be sent to the
+ * address set by setDestAddr().  If the destination address is not set, then
+ * it will be sent to the last source that sent us data on nordic.
+ *
+ * By default each payload waits for its ACK before the next payload is sent.  In the windowed
+ * mode (@see setWindow()), up to the window of payloads are in flight at a time.  The first data
+ * byte of each payload is its stream sequence number, so the receiver delivers the payloads in
+ * order and drops the duplicates, and the sender sends a payload again if its ACK is lost.  The
+ * writes block while the window is full, so they return false if the ACKs stop coming back.
+ *
+ * The data is sent once a payload is full or flush() is called.  For a terminal, setCoalescing()
+ * also sends the data once nothing was written for a while, or after each newline, so the small
+ * writes share a payload without the output waiting for the next flush().
+ */
+class NordicStream : public CharDev, public SingletonTemplate<NordicStream>
+{
+    public:
+        /**
+         * Set the destination address.
+         * If address is set to zero, then the packets will be sent to the last
+         * source that sent us the packet.
+         */
+        inline void setDestAddr(uint8_t address) { mDestAddr = address; }
+        inline void setPktHops(uint8_t hops)     { mHops = hops;        }
+
+        /**
+         * Sets the payloads in flight, which should be the same at both nodes.
+         * @param window  1 to wait for the ACK of each payload, or up to NRF_STREAM_WINDOW_MAX
+         *                for the windowed mode
+         * @returns false if the window is invalid
+         * @note The pending data is flushed, and the sequence numbers start over.
+         */
+        bool setWindow(uint8_t window);
+
+        /**
+         * Sets when the buffered data is sent, other than when a payload is full or flush() is called.
+         * @param idleMs   The data is sent once nothing was written for this time, or 0 to disable
+         * @param newline  If true, the data up to each newline is sent
+         * @returns false if the idle timer could not be created
+         */
+        bool setCoalescing(uint32_t idleMs, bool newline);
+
+        /// @returns the payloads that were lost because their ACK never came back
+        inline uint32_t getFailedCount(void) const { return mFailed; }
+
+        /// Flush all buffered data or send any pending data immediately.
+        bool flush(void);
+
+        /** @{ Virtual function overrides for the base class to work */
+        bool getChar(char* pInputChar, unsigned int timeout=portMAX_DELAY);
+        bool putChar(char out, unsigned int timeout=portMAX_DELAY);
+        bool putBlock(const void* pData, size_t len, unsigned int timeout=portMAX_DELAY);
+        bool getBlock(void* pData, size_t len, unsigned int timeout=portMAX_DELAY);
+        bool setRxEvent(SemaphoreHandle_t event) { wireless_set_rx_event(event); return true; }
+        /** @} */
+
+    private:
+        typedef struct {
+            mesh_packet_t pkt;  ///< actual wireless mesh packet
+            uint8_t dataPtr;    ///< The data pointer of pkt.data[]
+        } nrfPktBuffer_t;
+
+        /// A payload in flight of the windowed mode
+        typedef struct {
+            mesh_packet_t pkt;      ///< The packet as sent, whose mesh sequence number is in the ACK
+            uint8_t len;            ///< The data bytes of pkt.data[] (including the stream sequence number)
+            uint8_t retries;        ///< The times the payload can be sent again
+            TickType_t sentTick;    ///< The time the payload was last sent
+            bool busy;              ///< Set while the payload waits for its ACK
+        } nrfTxSlot_t;
+
+        /// @returns the destination of the data
+        inline uint8_t getDest(void) const { return (0 == mDestAddr) ? mRxBuffer.pkt.nwk.src : mDestAddr; }
+
+        /// @returns the index of the first data byte of the payloads
+        inline uint8_t getDataStart(void) const { return (mWindow > 1) ? 1 : 0; }
+
+        /// Sends the buffered data, and waits for the ACKs if wait is set (mTxLock must be taken)
+        bool sendBuffered(bool wait);
+
+        /// Sends the buffered data of the idle stream, and handles the ACKs of the windowed mode
+        static void idleTimerCallback(TimerHandle_t timer);
+
+        /// Gets the next packet in order to mRxBuffer
+        bool receive(unsigned int timeout);
+
+        /** @{ Windowed mode */
+        bool sendSlot(nrfTxSlot_t *pSlot);          ///< Sends a payload in flight with a new mesh sequence number
+        bool waitForAck(unsigned int timeout);      ///< Handles one ACK, and the payloads that timed out
+        bool sendWindowed(unsigned int timeout);    ///< Puts mTxBuffer in flight once there is room in the window
+        bool receiveWindowed(unsigned int timeout); ///< Gets the next packet in order of the stream sequence
+        /** @} */
+
+        nrfPktBuffer_t mRxBuffer;   ///< The receive buffer
+        nrfPktBuffer_t mTxBuffer;   ///< The transmit buffer
+        uint8_t mDestAddr;          ///< The destination address
+        uint8_t mHops;              ///< The hops to use for sending the data
+
+        uint8_t mWindow;            ///< The payloads in flight (@see setWindow())
+        uint8_t mTxSeq;             ///< The stream sequence number of the next payload
+        uint8_t mRxSeq;             ///< The stream sequence number of the next payload in order
+        uint8_t mRxHeld;            ///< Bit N is set if mRxWindow[N] holds a payload received early
+        uint32_t mFailed;           ///< @see getFailedCount()
+        nrfTxSlot_t mTxWindow[NRF_STREAM_WINDOW_MAX];       ///< The payloads in flight
+        mesh_packet_t mRxWindow[NRF_STREAM_WINDOW_MAX];     ///< The payloads received early, by their sequence
+
+        SemaphoreHandle_t mTxLock;  ///< Lock of the transmit side, which is shared with the idle timer
+        TimerHandle_t mIdleTimer;   ///< @see setCoalescing()
+        TickType_t mIdleTicks;      ///< The idle time before the buffered data is sent, or 0 if disabled
+        TickType_t mLastWriteTick;  ///< The time of the last write
+        bool mFlushOnNewline;       ///< @see setCoalescing()
+
+        NordicStream();                                ///< Private constructor of this Singleton class
+        friend class SingletonTemplate<NordicStream>;  ///< Friend class used for Singleton Template
+};
+
+
+
+#endif /* NRF_STREAM_HPP_ */
@@ -69,6 +69,21 @@ void rtc_init (void);
 /// @returns the latest time in RTC structure
 rtc_t rtc_gettime (void);
 
+/// The RTC is read again this often by rtc_gettime_cached() until it sees the next second
+#define RTC_CACHE_POLL_US   (10 * 1000)
+
+/**
+ * Gets the RTC time without reading the RTC registers for each call, which are slow peripheral bus
+ * accesses.  The time is cached, and the RTC is only read again once the uptime reaches the next
+ * second, which is predicted from the uptime at which the RTC was seen to change its second.  So the
+ * RTC is read about twice a second, and the time is at most RTC_CACHE_POLL_US behind the RTC, which
+ * is resynced each second such that the calendar roll-overs and the rtc_settime() are followed.
+ *
+ * @param [in] uptime_us  The sys_get_uptime_us() of the caller, which usually needs it as well
+ * @returns the cached time in RTC structure
+ */
+rtc_t rtc_gettime_cached (uint64_t uptime_us);
+
 /**
  * Sets the RTC time
  * @param [in] rtcstruct  The rtc time structure pointer
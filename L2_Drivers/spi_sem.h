@@ -21,17 +21,32 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
+#include <stdint.h>
+#include <stdbool.h>
 
 
 
 /** @{
  * SPI Access should be locked in multi-tasking environment if you are using SPI BUS.
+ * This is the lock of SSP1 of the bus manager (@see ssp_bus.h) at SSP_BUS_DEFAULT_PRIORITY,
+ * and the same task may lock it again while it has it locked.
  * @warning Only use this API if you are running FreeRTOS and scheduler has started.
  */
 void spi1_lock(void);    ///< Lock SPI access
 void spi1_unlock(void);  ///< Unlock SPI access
 /** @} */
 
+/**
+ * Unlocks the SPI for the given time so other tasks can use it, and locks it again.  A device
+ * driver calls this while its device is busy (such as programming) and is not selected.
+ * @returns false without any delay if the scheduler is not running or the caller has not locked
+ *          the SPI, in which case the caller should keep polling its device.
+ */
+bool spi1_yield(uint32_t ms);
+
+/// @returns true if a task has locked the SPI, such as to check if a transfer was interrupted by a fault
+bool spi1_is_locked(void);
+
 
 
 #ifdef __cplusplus
@@ -16,26 +16,143 @@
  *          p r e e t . w i k i @ g m a i l . c o m
  */
 #include "LPC17xx.h"
+#include "lpc_sys.h"
+#include "lpc_dma.h"
+#include "lpc_timers.h"
+#include "adc0.h"
+#include "sys_config.h"
 
 #include "FreeRTOS.h"
 #include "semphr.h"
-#include "queue.h"
 #include "task.h"       /* xTaskGetSchedulerState() */
+#include "os_signal.h"
+#include "os_lock_stats.h"
 
 
 
+#if (SYS_CFG_ADC_TIMER == SYS_CFG_SYS_TIMER) || (SYS_CFG_ADC_TIMER == SYS_CFG_HW_TIMER) || \
+    (SYS_CFG_ADC_TIMER == SYS_CFG_STEPPER_TIMER)
+#error "SYS_CFG_ADC_TIMER cannot be the same timer as SYS_CFG_SYS_TIMER, SYS_CFG_HW_TIMER or SYS_CFG_STEPPER_TIMER"
+#endif
+
 /**
- * Once a conversion is complete, we put the result into a queue.
- * This avoids polling as the conversion routine can just wait
- * until the ISR inputs the value into the queue.
+ * @{ The match of the timed mode.  The match resets the timer and toggles its match output,
+ * and the rising edge of the output starts the conversion, so it matches at twice the rate.
  */
-QueueHandle_t g_adc_result_queue = 0;
+#if (0 == SYS_CFG_ADC_TIMER)
+#define ADC0_TIMED_START        (4 << 24)   ///< ADCR START on the edge of MAT0.1
+#define ADC0_TIMED_MCR          (1 << 4)    ///< Reset on MR1
+#define ADC0_TIMED_EMR          (3 << 6)    ///< Toggle MAT0.1
+#define ADC0_TIMED_MR           MR1
+#elif (1 == SYS_CFG_ADC_TIMER)
+#define ADC0_TIMED_START        (6 << 24)   ///< ADCR START on the edge of MAT1.0
+#define ADC0_TIMED_MCR          (1 << 1)    ///< Reset on MR0
+#define ADC0_TIMED_EMR          (3 << 4)    ///< Toggle MAT1.0
+#define ADC0_TIMED_MR           MR0
+#else
+#error "SYS_CFG_ADC_TIMER must be 0 or 1"
+#endif
+/** @} */
+
+/**
+ * Once a conversion is complete, the ISR stores the result and gives the signal.
+ * This avoids polling as the conversion routine can just wait for the signal.
+ */
+static volatile uint16_t g_adc_result = 0;
+static os_signal_t g_adc_done = OS_SIGNAL_INIT;
 
 /// This is the mutex such that only one ADC conversion is performed at a time
 SemaphoreHandle_t g_adc_mutex = 0;
+static os_lock_stats_t g_adc_lock_stats = OS_LOCK_STATS_INIT("adc0");
+
+/**
+ * Burst mode frames, and the circular list of items that copy one frame per DMA request.
+ * Each frame is the copy of ADDR0 - ADDR7 after the last selected channel is converted.
+ * @note GPDMA cannot access the heap or task stacks, so these are static globals.
+ */
+static uint32_t g_adc_burst_frames[ADC0_BURST_FRAMES][ADC0_MAX_CHANNELS];
+static dma_lli_t g_adc_burst_lli[ADC0_BURST_FRAMES];
+static uint32_t g_adc_saved_adcr = 0;
+static uint8_t g_adc_burst_channels = 0;
+static uint32_t g_adc_timed_rate_hz = 0;    ///< The rate of the timed mode, or 0 if not timed
+
+/**
+ * @{ Oversampling state, which is only written by the DMA interrupt while oversampling.
+ * g_adc_ovs_frame is the next frame of the ring buffer that is not accumulated yet.
+ */
+static uint8_t g_adc_ovs_bits = 0;
+static uint8_t g_adc_ovs_boxcar_len = 0;
+static uint32_t g_adc_ovs_frame = 0;
+static SemaphoreHandle_t g_adc_ovs_ready_sem = 0;
+static SemaphoreHandle_t g_adc_ovs_sem = 0;         ///< ready_sem of adc0_get_oversampled()
+static uint32_t g_adc_ovs_acc[ADC0_MAX_CHANNELS];
+static uint16_t g_adc_ovs_count[ADC0_MAX_CHANNELS];
+static uint32_t g_adc_ovs_boxcar[ADC0_MAX_CHANNELS][ADC0_OVS_MAX_BOXCAR];
+static uint32_t g_adc_ovs_boxcar_sum[ADC0_MAX_CHANNELS];
+static volatile uint32_t g_adc_ovs_value[ADC0_MAX_CHANNELS];
+static volatile uint32_t g_adc_ovs_seq[ADC0_MAX_CHANNELS];
+/** @} */
 
 
 
+/// @returns the ADCR value with its CLKDIV scaled to keep the ADC clock at or below its rate
+static uint32_t adc0_scale_clkdiv(uint32_t adcr, unsigned int old_cpu_hz, unsigned int new_cpu_hz)
+{
+    const uint32_t clkdiv_mask = (0xFF << 8);
+    uint32_t div = sys_clock_scale_divider(((adcr & clkdiv_mask) >> 8) + 1, old_cpu_hz, new_cpu_hz);
+
+    if (div < 1) {
+        div = 1;
+    }
+    else if (div > 256) {
+        div = 256;
+    }
+    return (adcr & ~clkdiv_mask) | ((div - 1) << 8);
+}
+
+/// Keeps the ADC clock (and the burst mode rate) when sys_clock_set_cpu_scale() changes the CPU clock
+static void adc0_cpu_clock_changed(void *arg, unsigned int old_cpu_hz, unsigned int new_cpu_hz)
+{
+    (void) arg;
+    LPC_ADC->ADCR = adc0_scale_clkdiv(LPC_ADC->ADCR, old_cpu_hz, new_cpu_hz);
+    g_adc_saved_adcr = adc0_scale_clkdiv(g_adc_saved_adcr, old_cpu_hz, new_cpu_hz);
+
+    /* Restart the period of the timed mode so the timer does not go past the new match */
+    if (g_adc_timed_rate_hz) {
+        LPC_TIM_TypeDef *pTimer = lpc_timer_get_struct((lpc_timer_t) SYS_CFG_ADC_TIMER);
+        pTimer->ADC0_TIMED_MR = new_cpu_hz / (2 * g_adc_timed_rate_hz) - 1;
+        pTimer->TC = 0;
+    }
+}
+
+/// Starts the timer of the timed mode, which is counting at the CPU clock
+static void adc0_timed_timer_start(uint32_t rate_hz)
+{
+    const lpc_timer_t timer = (lpc_timer_t) SYS_CFG_ADC_TIMER;
+    LPC_TIM_TypeDef *pTimer = lpc_timer_get_struct(timer);
+
+    lpc_timer_enable(timer, 1);
+    pTimer->TCR = (1 << 1);
+    pTimer->PR = 0;
+    pTimer->PC = 0;
+    pTimer->TC = 0;
+    pTimer->ADC0_TIMED_MR = sys_get_cpu_clock() / (2 * rate_hz) - 1;
+    pTimer->MCR = ADC0_TIMED_MCR;
+    pTimer->EMR = ADC0_TIMED_EMR;
+    g_adc_timed_rate_hz = rate_hz;
+    pTimer->TCR = (1 << 0);
+}
+
+static void adc0_timed_timer_stop(void)
+{
+    LPC_TIM_TypeDef *pTimer = lpc_timer_get_struct((lpc_timer_t) SYS_CFG_ADC_TIMER);
+
+    pTimer->TCR = 0;
+    pTimer->MCR = 0;
+    pTimer->EMR = 0;
+    g_adc_timed_rate_hz = 0;
+}
+
 /**
  * This is the ADC interrupt mapped to startup.cpp IRQ name.
  * This is called by the CPU core when ADC interrupt occurs.
@@ -43,12 +160,9 @@ SemaphoreHandle_t g_adc_mutex = 0;
 void ADC_IRQHandler(void)
 {
     const uint16_t twelve_bits = 0x0FFF;
-    BaseType_t switch_required = 0;
-
-    uint16_t result = (LPC_ADC->ADGDR >> 4) & twelve_bits;
-    xQueueSendFromISR(g_adc_result_queue, &result, &switch_required);
 
-    portEND_SWITCHING_ISR(switch_required);
+    g_adc_result = (LPC_ADC->ADGDR >> 4) & twelve_bits;
+    portEND_SWITCHING_ISR(os_signal_give_from_isr(&g_adc_done));
 }
 
 void adc0_init()
@@ -71,7 +185,8 @@ void adc0_init()
     }
 
     g_adc_mutex = xSemaphoreCreateMutex();
-    g_adc_result_queue = xQueueCreate(1, sizeof(uint16_t));
+    g_adc_ovs_sem = xSemaphoreCreateBinary();
+    sys_clock_add_listener(adc0_cpu_clock_changed, NULL);
     NVIC_EnableIRQ(ADC_IRQn);
 }
 
@@ -98,21 +213,375 @@ uint16_t adc0_get_reading(uint8_t channel_num)
     }
     else if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState())
     {
-        xSemaphoreTake(g_adc_mutex, portMAX_DELAY);
+        os_lock_take(&g_adc_lock_stats, g_adc_mutex, portMAX_DELAY);
         {
+            os_signal_clear(&g_adc_done);
             adc0_start_conversion(channel_num);
-            xQueueReceive(g_adc_result_queue, &result, portMAX_DELAY);
+            os_signal_wait(&g_adc_done, portMAX_DELAY);
+            result = g_adc_result;
         }
-        xSemaphoreGive(g_adc_mutex);
+        os_lock_give(&g_adc_lock_stats, g_adc_mutex);
     }
     else
     {
+        os_signal_clear(&g_adc_done);
         adc0_start_conversion(channel_num);
-        while(! xQueueReceive(g_adc_result_queue, &result, 0))
+        while(! os_signal_wait(&g_adc_done, 0))
         {
             ;
         }
+        result = g_adc_result;
     }
 
     return result;
 }
+
+/// @returns the index of the frame of the ring buffer being written by the DMA
+static inline uint32_t adc0_burst_writing_frame(void)
+{
+    const uint32_t frame_bytes = sizeof(g_adc_burst_frames[0]);
+    const uint32_t dst = dma_get_channel(dma_ch_adc)->DMACCDestAddr;
+    return ((dst - (uint32_t) &g_adc_burst_frames[0][0]) / frame_bytes) % ADC0_BURST_FRAMES;
+}
+
+/**
+ * DMA interrupt of every half of the ring buffer while oversampling.  This accumulates every
+ * frame written since the last interrupt, so a late interrupt does not lose the frames unless
+ * the DMA has overwritten the whole ring buffer.
+ */
+static void adc0_ovs_dma_done(void *arg, bool error)
+{
+    const uint32_t done_bitmask = (1UL << 31);
+    const uint16_t decimation = (1 << (2 * g_adc_ovs_bits));
+    const uint32_t writing = adc0_burst_writing_frame();
+    BaseType_t switch_required = 0;
+    bool ready = false;
+    uint32_t ch = 0;
+
+    (void) arg;
+    if (error) {
+        return;
+    }
+
+    for ( ; g_adc_ovs_frame != writing; g_adc_ovs_frame = (g_adc_ovs_frame + 1) % ADC0_BURST_FRAMES)
+    {
+        for (ch = 0; ch < ADC0_MAX_CHANNELS; ch++)
+        {
+            const uint32_t r = g_adc_burst_frames[g_adc_ovs_frame][ch];
+            if (!(g_adc_burst_channels & (1 << ch)) || !(r & done_bitmask)) {
+                continue;
+            }
+
+            g_adc_ovs_acc[ch] += (r >> 4) & 0x0FFF;
+            if (++g_adc_ovs_count[ch] < decimation) {
+                continue;
+            }
+
+            /* Decimate with rounding, and then filter with the moving average of the results */
+            uint32_t result = g_adc_ovs_acc[ch];
+            if (g_adc_ovs_bits) {
+                result = (result + (1 << (g_adc_ovs_bits - 1))) >> g_adc_ovs_bits;
+            }
+            g_adc_ovs_acc[ch] = 0;
+            g_adc_ovs_count[ch] = 0;
+
+            if (g_adc_ovs_boxcar_len > 1) {
+                const uint32_t seq = g_adc_ovs_seq[ch];
+                const uint32_t slot = seq % g_adc_ovs_boxcar_len;
+                const uint32_t filled = (seq < g_adc_ovs_boxcar_len) ? (seq + 1) : g_adc_ovs_boxcar_len;
+
+                g_adc_ovs_boxcar_sum[ch] += result - g_adc_ovs_boxcar[ch][slot];
+                g_adc_ovs_boxcar[ch][slot] = result;
+                result = g_adc_ovs_boxcar_sum[ch] / filled;
+            }
+
+            g_adc_ovs_value[ch] = result;
+            g_adc_ovs_seq[ch]++;
+            ready = true;
+        }
+    }
+
+    if (ready && g_adc_ovs_ready_sem) {
+        xSemaphoreGiveFromISR(g_adc_ovs_ready_sem, &switch_required);
+        portEND_SWITCHING_ISR(switch_required);
+    }
+}
+
+/**
+ * Starts burst mode
+ * @param ovs    If true, the DMA interrupts every half of the ring buffer for adc0_ovs_dma_done()
+ * @param timed  If true, the timer starts each conversion of the one channel instead of burst mode
+ */
+static bool adc0_burst_setup(uint8_t channel_mask, uint32_t rate_hz, bool ovs, bool timed)
+{
+    const uint32_t clocks_per_conversion = 65;
+    const uint32_t max_adc_clock = (13 * 1000UL * 1000UL);
+    const uint32_t adc_clock = (sys_get_cpu_clock() / 8);
+    const uint32_t burst_bitmask = (1 << 16);
+    const uint32_t enable_adc_bitmask = (1 << 21);
+    LPC_GPDMACH_TypeDef *pCh = dma_get_channel(dma_ch_adc);
+    uint32_t num_channels = 0;
+    uint8_t last_channel = 0;
+    uint32_t i = 0;
+
+    for (i = 0; i < ADC0_MAX_CHANNELS; i++) {
+        if (channel_mask & (1 << i)) {
+            num_channels++;
+            last_channel = i;
+        }
+    }
+    if (0 == num_channels || 0 == rate_hz ||
+        taskSCHEDULER_RUNNING != xTaskGetSchedulerState()) {
+        return false;
+    }
+
+    os_lock_take(&g_adc_lock_stats, g_adc_mutex, portMAX_DELAY);
+    if (g_adc_burst_channels || !dma_channel_claim(dma_ch_adc)) {
+        os_lock_give(&g_adc_lock_stats, g_adc_mutex);
+        return false;
+    }
+
+    /* Each frame converts every selected channel, and the ADC clock is divided by
+     * CLKDIV + 1, which must not exceed the maximum ADC clock.  The timed mode runs the ADC
+     * at the maximum clock, so each conversion is done before the next match.
+     */
+    uint32_t div = timed ? 0 : adc_clock / (clocks_per_conversion * num_channels * rate_hz);
+    if (div * max_adc_clock < adc_clock) {
+        div = (adc_clock + max_adc_clock - 1) / max_adc_clock;
+    }
+    if (div < 1) {
+        div = 1;
+    }
+    else if (div > 256) {
+        div = 256;
+    }
+
+    /* The ADC interrupt is not used during burst mode.  The interrupt enable of the last
+     * channel of the round generates the DMA request, and ADGINTEN must be 0 in burst mode.
+     */
+    NVIC_DisableIRQ(ADC_IRQn);
+    g_adc_saved_adcr = LPC_ADC->ADCR;
+    LPC_ADC->ADCR = enable_adc_bitmask | ((div - 1) << 8);
+    LPC_ADC->ADINTEN = (1 << last_channel);
+
+    /**
+     * Each DMA request copies ADDR0 - ADDR7 as one burst into the next frame, and the last
+     * item points back to the first such that the DMA keeps overwriting the ring buffer.
+     * Reading ADDRx clears its DONE bit, so a frame only has DONE bits of new conversions.
+     */
+    dma_init();
+    for (i = 0; i < ADC0_BURST_FRAMES; i++) {
+        uint32_t ch = 0;
+        for (ch = 0; ch < ADC0_MAX_CHANNELS; ch++) {
+            g_adc_burst_frames[i][ch] = 0;
+        }
+        g_adc_burst_lli[i].src  = (uint32_t) &(LPC_ADC->ADDR0);
+        g_adc_burst_lli[i].dst  = (uint32_t) &g_adc_burst_frames[i][0];
+        g_adc_burst_lli[i].next = &g_adc_burst_lli[(i + 1) % ADC0_BURST_FRAMES];
+        g_adc_burst_lli[i].ctrl = ADC0_MAX_CHANNELS |
+                                  DMA_CTRL_SRC_BURST(dma_burst_8) | DMA_CTRL_DST_BURST(dma_burst_8) |
+                                  DMA_CTRL_SRC_WIDTH(dma_width_32bit) | DMA_CTRL_DST_WIDTH(dma_width_32bit) |
+                                  DMA_CTRL_SRC_INCR | DMA_CTRL_DST_INCR;
+        if (ovs && 0 == ((i + 1) % (ADC0_BURST_FRAMES / 2))) {
+            g_adc_burst_lli[i].ctrl |= DMA_CTRL_TC_INTR;
+        }
+    }
+
+    dma_clear_intr(dma_ch_adc);
+    g_adc_ovs_frame = 0;
+    dma_register_callback(dma_ch_adc, ovs ? adc0_ovs_dma_done : NULL, NULL);
+    pCh->DMACCSrcAddr  = g_adc_burst_lli[0].src;
+    pCh->DMACCDestAddr = g_adc_burst_lli[0].dst;
+    pCh->DMACCLLI      = (uint32_t) g_adc_burst_lli[0].next;
+    pCh->DMACCControl  = g_adc_burst_lli[0].ctrl;
+    pCh->DMACCConfig   = DMA_CFG_SRC_PERIPH(dma_req_adc) | DMA_CFG_P_TO_M | DMA_CFG_ENABLE |
+                         (ovs ? (DMA_CFG_TC_INTR | DMA_CFG_ERR_INTR) : 0);
+
+    // Select the channels last, and start the conversions
+    g_adc_burst_channels = channel_mask;
+    if (timed) {
+        LPC_ADC->ADCR |= channel_mask | ADC0_TIMED_START;
+        adc0_timed_timer_start(rate_hz);
+    }
+    else {
+        LPC_ADC->ADCR |= channel_mask | burst_bitmask;
+    }
+
+    // Mutex stays taken until adc0_burst_stop()
+    return true;
+}
+
+bool adc0_burst_start(uint8_t channel_mask, uint32_t rate_hz)
+{
+    return adc0_burst_setup(channel_mask, rate_hz, false, false);
+}
+
+bool adc0_timed_start(uint8_t channel_num, uint32_t rate_hz)
+{
+    /* Without burst mode, the ADC converts only one channel for each start */
+    if (channel_num >= ADC0_MAX_CHANNELS || rate_hz > ADC0_TIMED_MAX_RATE_HZ) {
+        return false;
+    }
+    return adc0_burst_setup((1 << channel_num), rate_hz, false, true);
+}
+
+bool adc0_burst_get_stats(uint8_t channel_num, uint32_t num_frames, adc0_stats_t *stats)
+{
+    const uint32_t done_bitmask = (1UL << 31);
+    uint32_t sum = 0;
+    uint32_t i = 0;
+
+    if (channel_num >= ADC0_MAX_CHANNELS || !stats) {
+        return false;
+    }
+    if (0 == num_frames || num_frames > ADC0_BURST_FRAMES) {
+        num_frames = ADC0_BURST_FRAMES;
+    }
+
+    stats->avg = 0;
+    stats->min = 0xFFFF;
+    stats->max = 0;
+    stats->count = 0;
+
+    /* The frame being written by the DMA is the oldest one, so walk back from the frame before it */
+    const uint32_t writing = adc0_burst_writing_frame();
+
+    for (i = 1; i <= num_frames; i++) {
+        const uint32_t idx = (writing + ADC0_BURST_FRAMES - i) % ADC0_BURST_FRAMES;
+        const uint32_t r = g_adc_burst_frames[idx][channel_num];
+
+        /* Entries without the DONE bit have not been written by the DMA yet */
+        if (r & done_bitmask) {
+            const uint16_t value = (r >> 4) & 0x0FFF;
+            sum += value;
+            stats->count++;
+            if (value < stats->min) {
+                stats->min = value;
+            }
+            if (value > stats->max) {
+                stats->max = value;
+            }
+        }
+    }
+
+    if (0 == stats->count) {
+        stats->min = 0;
+        return false;
+    }
+    stats->avg = sum / stats->count;
+    return true;
+}
+
+uint16_t adc0_burst_get_average(uint8_t channel_num)
+{
+    adc0_stats_t stats;
+    return adc0_burst_get_stats(channel_num, 0, &stats) ? stats.avg : 0;
+}
+
+void adc0_burst_stop(void)
+{
+    const uint32_t burst_bitmask = (1 << 16);
+    LPC_GPDMACH_TypeDef *pCh = dma_get_channel(dma_ch_adc);
+
+    if (!g_adc_burst_channels) {
+        return;
+    }
+
+    LPC_ADC->ADCR &= ~burst_bitmask;
+    if (g_adc_timed_rate_hz) {
+        adc0_timed_timer_stop();
+    }
+    pCh->DMACCConfig = 0;
+    dma_clear_intr(dma_ch_adc);
+    dma_channel_free(dma_ch_adc);
+    g_adc_ovs_ready_sem = 0;
+
+    /* Restore the single conversion mode of adc0_get_reading() */
+    LPC_ADC->ADCR = g_adc_saved_adcr;
+    LPC_ADC->ADINTEN = (1 << 8);
+    NVIC_ClearPendingIRQ(ADC_IRQn);
+    NVIC_EnableIRQ(ADC_IRQn);
+
+    g_adc_burst_channels = 0;
+    os_lock_give(&g_adc_lock_stats, g_adc_mutex);
+}
+
+bool adc0_oversample_start(uint8_t channel_mask, uint32_t rate_hz, uint8_t extra_bits,
+                           uint8_t boxcar_len, SemaphoreHandle_t ready_sem)
+{
+    uint32_t ch = 0, i = 0;
+
+    if (extra_bits > ADC0_OVS_MAX_BITS || boxcar_len > ADC0_OVS_MAX_BOXCAR) {
+        return false;
+    }
+
+    /* The DMA interrupt is not enabled yet, so the state can be reset without a critical section */
+    g_adc_ovs_bits = extra_bits;
+    g_adc_ovs_boxcar_len = boxcar_len;
+    g_adc_ovs_ready_sem = ready_sem;
+    for (ch = 0; ch < ADC0_MAX_CHANNELS; ch++) {
+        g_adc_ovs_acc[ch] = 0;
+        g_adc_ovs_count[ch] = 0;
+        g_adc_ovs_boxcar_sum[ch] = 0;
+        g_adc_ovs_value[ch] = 0;
+        g_adc_ovs_seq[ch] = 0;
+        for (i = 0; i < ADC0_OVS_MAX_BOXCAR; i++) {
+            g_adc_ovs_boxcar[ch][i] = 0;
+        }
+    }
+
+    if (!adc0_burst_setup(channel_mask, rate_hz, true, false)) {
+        g_adc_ovs_ready_sem = 0;
+        return false;
+    }
+    return true;
+}
+
+bool adc0_oversample_get(uint8_t channel_num, uint32_t *value, uint32_t *seq)
+{
+    uint32_t s = 0;
+
+    if (channel_num >= ADC0_MAX_CHANNELS || !value) {
+        return false;
+    }
+
+    /* Read again if the DMA interrupt wrote a new result in between */
+    do {
+        s = g_adc_ovs_seq[channel_num];
+        *value = g_adc_ovs_value[channel_num];
+    } while (s != g_adc_ovs_seq[channel_num]);
+
+    if (seq) {
+        *seq = s;
+    }
+    return (0 != s);
+}
+
+uint32_t adc0_get_oversampled(uint8_t channel_num, uint8_t extra_bits)
+{
+    const uint32_t samples = (1UL << (2 * extra_bits));
+    /* Every sample, and one more interrupt of half of the ring buffer */
+    const uint32_t timeout_ms = 10 + (samples + ADC0_BURST_FRAMES / 2) * 1000 / ADC0_OVS_RATE_HZ;
+    uint32_t value = 0;
+    uint32_t i = 0;
+
+    if (channel_num >= ADC0_MAX_CHANNELS || extra_bits > ADC0_OVS_MAX_BITS) {
+        return 0;
+    }
+
+    xSemaphoreTake(g_adc_ovs_sem, 0);
+    if (adc0_oversample_start((1 << channel_num), ADC0_OVS_RATE_HZ, extra_bits, 0, g_adc_ovs_sem))
+    {
+        const bool ready = xSemaphoreTake(g_adc_ovs_sem, OS_MS(timeout_ms)) &&
+                           adc0_oversample_get(channel_num, &value, NULL);
+        adc0_burst_stop();
+        if (ready) {
+            return value;
+        }
+    }
+
+    for (i = 0; i < samples; i++) {
+        value += adc0_get_reading(channel_num);
+    }
+    return extra_bits ? ((value + (1 << (extra_bits - 1))) >> extra_bits) : value;
+}
@@ -15,16 +15,18 @@
  *     You can reach the author of this software at :
  *          p r e e t . w i k i @ g m a i l . c o m
  */
+#include <stdlib.h>
 #include <string.h>
 
 #include "FreeRTOS.h"
 #include "queue.h"
+#include "semphr.h"
 #include "task.h"
 
 #include "can.h"
 #include "LPC17xx.h"
 #include "sys_config.h"
-#include "lpc_sys.h"    // sys_get_uptime_ms()
+#include "lpc_sys.h"    // sys_get_uptime_ms(), sys_get_uptime_us()
 
 
 
@@ -104,6 +106,7 @@ enum {
     can_mod_reset  = 0x01, ///< CAN MOD register value to reset the BUS
     can_mod_normal_tpm = (can_mod_normal | (1 << 3)), ///< CAN bus enabled with TPM mode bits set
     can_mod_selftest   = (1 << 2) | can_mod_normal,   ///< Used to enable global self-test
+    can_mod_selftest_tpm = (can_mod_selftest | (1 << 3)), ///< Self-test with TPM mode bits set
 };
 
 /// Mask of the PCONP register
@@ -112,22 +115,75 @@ enum {
     can2_pconp_mask = (1 << 14),    ///< CAN2 power on bitmask
 };
 
-/// Typedef of CAN queues and data
+/// Number of the transmit buffers of the CAN hardware
+#define CAN_HW_TX_BUFFERS       3
+
+/// Bit mask of the TX frame (TFI register) that holds the TX priority used by the TPM mode
+#define CAN_TX_PRIORITY_MASK    0xFF
+
+/// Entry of the TX priority queue
+typedef struct {
+    can_msg_t msg;                  ///< The message, with its TX priority in the lower 8 bits of the frame
+    uint16_t seq;                   ///< Sequence number to send the messages of the same priority in order
+    uint32_t queuedUs;              ///< The lower 32-bits of the uptime when CAN_tx() queued the message
+} can_tx_entry_t;
+
+/// The frame counter of an ID within the window of the statistics
+typedef struct {
+    uint32_t id;                    ///< The ID, with CAN_STATS_ID_29BIT set for a 29-bit ID
+    uint16_t frames;                ///< The frames of the window
+} can_id_counter_t;
+
+/**
+ * Typedef of CAN queues and data
+ *
+ * The received messages are stored in a lock-free single-producer single-consumer ring rather than a FreeRTOS
+ * queue because the CAN interrupt is the only writer, and the CAN_rx() is the only reader.  Only the ISR writes
+ * rxHead, and only CAN_rx() writes rxTail, and the ring holds one less message than its size to tell the
+ * difference between full and empty ring.  The rxSignal is only given when a message arrives in an empty ring.
+ * The interrupt drains all the messages of the HW before it returns, and time stamps each one of them.
+ *
+ * The messages to send are kept in a binary min-heap ordered by their TX priority, and then by the order in
+ * which they were queued.  The heap is modified within a critical section, or by the CAN interrupt, and the
+ * txSpace counting semaphore holds the number of free entries for the tasks that wait for space.
+ */
 typedef struct {
     LPC_CAN_TypeDef *pCanRegs;      ///< The pointer to the CAN registers
-    QueueHandle_t rxQ;              ///< TX queue
-    QueueHandle_t txQ;              ///< RX queue
+    can_rx_msg_t *rxRing;           ///< RX ring buffer
+    uint16_t rxRingSize;            ///< Number of messages of the RX ring buffer
+    volatile uint16_t rxHead;       ///< RX ring index written by the CAN interrupt
+    volatile uint16_t rxTail;       ///< RX ring index written by CAN_rx()
+    SemaphoreHandle_t rxSignal;     ///< Given by the CAN interrupt when a message is written to the empty RX ring
+    can_tx_entry_t *txHeap;         ///< TX priority queue
+    uint16_t txHeapSize;            ///< Number of messages of the TX priority queue
+    uint16_t txHeapCount;           ///< Number of messages in the TX priority queue
+    uint16_t txSeq;                 ///< Sequence number of the next queued message
+    SemaphoreHandle_t txSpace;      ///< Counts the free entries of the TX priority queue
+    uint8_t txHwPriority[CAN_HW_TX_BUFFERS]; ///< TX priority of the message last written to each HW buffer
     uint16_t droppedRxMsgs;         ///< Number of messages dropped if no space found during the CAN interrupt that queues the RX messages
-    uint16_t rxQWatermark;          ///< Watermark of the FreeRTOS Rx Queue
-    uint16_t txQWatermark;          ///< Watermark of the FreeRTOS Tx Queue
+    uint16_t rxQWatermark;          ///< Watermark of the Rx ring buffer
+    uint16_t txQWatermark;          ///< Watermark of the Tx priority queue
     uint16_t txMsgCount;            ///< Number of messages sent
     uint16_t rxMsgCount;            ///< Number of received messages
+    bool selfTest;                  ///< Each message sent is also received, @see CAN_set_self_test()
+
+    uint32_t txHwQueuedUs[CAN_HW_TX_BUFFERS];   ///< The queuedUs of the message of each HW buffer
+    can_msg_t txHwMsg[CAN_HW_TX_BUFFERS];       ///< The message of each HW buffer, for the statistics and the tap
+    uint64_t statsStartUs;          ///< The uptime when the window of the statistics started
+    uint32_t statsRxBits;           ///< The bits received in the window
+    uint32_t statsTxBits;           ///< The bits sent in the window
+    uint16_t statsRxFrames;         ///< The frames received in the window
+    uint16_t statsTxFrames;         ///< The frames sent in the window
+    uint8_t statsIdCount;           ///< The used entries of statsIds[]
+    can_id_counter_t statsIds[CAN_STATS_TRACKED_IDS];   ///< The frames of the IDs of the window
+    can_stats_t stats;              ///< @see CAN_get_stats()
+    can_tap_func_t tap;             ///< @see CAN_set_tap()
     can_void_func_t bus_error;      ///< When serious BUS error occurs
     can_void_func_t data_overrun;   ///< When we read the CAN buffer too late for incoming message
 } can_struct_t ;
 
 /// Structure of both CANs
-can_struct_t g_can_structs[can_max] = { {LPC_CAN1}, {LPC_CAN2}};
+can_struct_t g_can_structs[can_max] = { { .pCanRegs = LPC_CAN1 }, { .pCanRegs = LPC_CAN2 } };
 
 /**
  * This type of CAN interrupt should lead to "bus error", but note that intr_berr is not the right
@@ -138,70 +194,288 @@ static const can_intr_t g_can_bus_err_intr = intr_epi;
 
 
 /** @{ Private functions */
+/// Compiler memory barrier to publish the RX ring data before its index
+#define CAN_RING_BARRIER()      __asm volatile ("" ::: "memory")
+
+/// @returns the next index of the RX ring
+static inline uint16_t CAN_rx_ring_next(const can_struct_t *pStruct, uint16_t idx)
+{
+    return (++idx >= pStruct->rxRingSize) ? 0 : idx;
+}
+
+/// @returns the number of messages in the RX ring
+static inline uint16_t CAN_rx_ring_count(const can_struct_t *pStruct)
+{
+    const uint16_t head = pStruct->rxHead;
+    const uint16_t tail = pStruct->rxTail;
+    return (head >= tail) ? (head - tail) : (pStruct->rxRingSize - tail + head);
+}
+
+/**
+ * Pops up to max messages from the RX ring; this must only be called by the only consumer, which is CAN_rx()
+ * @returns the number of messages copied to pMsgs
+ */
+static uint16_t CAN_rx_ring_pop(can_struct_t *pStruct, can_rx_msg_t *pMsgs, uint16_t max)
+{
+    const uint16_t head = pStruct->rxHead;
+    uint16_t tail = pStruct->rxTail;
+    uint16_t count = 0;
+
+    while (count < max && tail != head) {
+        pMsgs[count++] = pStruct->rxRing[tail];
+        tail = CAN_rx_ring_next(pStruct, tail);
+    }
+
+    if (count > 0) {
+        CAN_RING_BARRIER();
+        pStruct->rxTail = tail;
+    }
+    return count;
+}
+
+/**
+ * Waits for the RX ring to have at least one message
+ * @returns true if the RX ring is not empty
+ */
+static bool CAN_rx_ring_wait(can_struct_t *pStruct, uint32_t timeout_ms)
+{
+    bool ok = false;
+
+    if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        const TickType_t timeout = OS_MS(timeout_ms);
+        const TickType_t start = xTaskGetTickCount();
+
+        /* The signal is only given when a message arrives in the empty ring, so always
+         * check the ring first, and only block for the remaining time when it is empty.
+         */
+        while (! (ok = (pStruct->rxTail != pStruct->rxHead))) {
+            const TickType_t elapsed = xTaskGetTickCount() - start;
+            if (elapsed >= timeout || !xSemaphoreTake(pStruct->rxSignal, timeout - elapsed)) {
+                ok = (pStruct->rxTail != pStruct->rxHead);
+                break;
+            }
+        }
+    }
+    else {
+        uint64_t msg_timeout = sys_get_uptime_ms() + timeout_ms;
+        while (! (ok = (pStruct->rxTail != pStruct->rxHead))) {
+            if (sys_get_uptime_ms() > msg_timeout) {
+                break;
+            }
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * @returns the worst case bits of the frame on the bus: the frame, the stuff bits of the frame up to the
+ *          CRC, and the interframe space.  A standard frame has 47 bits and an extended frame has 67 bits
+ *          besides the data, and up to one stuff bit may follow every 4 bits of the 34 or 54 bits and the data.
+ */
+static inline uint8_t CAN_frame_bits(const can_msg_t *pMsg)
+{
+    const uint32_t data_bits = pMsg->frame_fields.is_rtr ? 0 : 8 * (pMsg->frame_fields.data_len > 8 ? 8 : pMsg->frame_fields.data_len);
+    return pMsg->frame_fields.is_29bit ? (67 + data_bits + (54 + data_bits - 1) / 4) :
+                                         (47 + data_bits + (34 + data_bits - 1) / 4);
+}
+
+/// @returns the ID of the message for the statistics
+static inline uint32_t CAN_stats_id(const can_msg_t *pMsg)
+{
+    return pMsg->frame_fields.is_29bit ? (pMsg->msg_id | CAN_STATS_ID_29BIT) : pMsg->msg_id;
+}
+
+/// Counts a frame of the ID with the Space-Saving algorithm, @see CAN_get_stats()
+static void CAN_stats_count_id(can_struct_t *pStruct, uint32_t id)
+{
+    can_id_counter_t *pMin = NULL;
+    uint8_t i = 0;
+
+    for (i = 0; i < pStruct->statsIdCount; i++) {
+        can_id_counter_t *pCounter = &pStruct->statsIds[i];
+        if (id == pCounter->id) {
+            pCounter->frames++;
+            return;
+        }
+        if (!pMin || pCounter->frames < pMin->frames) {
+            pMin = pCounter;
+        }
+    }
+
+    if (pStruct->statsIdCount < CAN_STATS_TRACKED_IDS) {
+        pMin = &pStruct->statsIds[pStruct->statsIdCount++];
+        pMin->frames = 0;
+    }
+    pMin->id = id;
+    pMin->frames++;
+}
+
+/**
+ * Computes the statistics of the window if it is due, and starts the next window
+ * @warning This should be called by the CAN interrupt or from critical section
+ */
+static void CAN_stats_end_window(can_struct_t *pStruct, uint64_t now_us)
+{
+    can_stats_t *pStats = &pStruct->stats;
+    const uint64_t elapsed_us = now_us - pStruct->statsStartUs;
+    uint32_t taken = 0;
+    uint8_t i = 0;
+
+    if (0 == pStats->bitrate || elapsed_us < (CAN_STATS_WINDOW_MS * 1000)) {
+        return;
+    }
+
+    /* The worst case stuff bits can estimate more than the whole bus */
+    const uint64_t bits = (uint64_t) pStruct->statsRxBits + pStruct->statsTxBits;
+    const uint64_t load = (bits * 10000 * 1000000) / ((uint64_t) pStats->bitrate * elapsed_us);
+    pStats->load_x100 = (load > 10000) ? 10000 : load;
+    if (pStats->load_x100 > pStats->peak_load_x100) {
+        pStats->peak_load_x100 = pStats->load_x100;
+    }
+    pStats->rx_per_sec = ((uint64_t) pStruct->statsRxFrames * 1000000) / elapsed_us;
+    pStats->tx_per_sec = ((uint64_t) pStruct->statsTxFrames * 1000000) / elapsed_us;
+    pStats->window_end_ms = now_us / 1000;
+
+    /* Select the busiest IDs, busiest first */
+    for (i = 0; i < CAN_STATS_TOP_IDS; i++) {
+        int8_t best = -1;
+        for (uint8_t j = 0; j < pStruct->statsIdCount; j++) {
+            if (!(taken & (1 << j)) && (best < 0 || pStruct->statsIds[j].frames > pStruct->statsIds[best].frames)) {
+                best = j;
+            }
+        }
+
+        can_id_rate_t *pRate = &pStats->top_ids[i];
+        if (best >= 0) {
+            taken |= (1 << best);
+            pRate->msg_id = pStruct->statsIds[best].id;
+            pRate->frames = pStruct->statsIds[best].frames;
+            pRate->per_sec = ((uint64_t) pRate->frames * 1000000) / elapsed_us;
+        }
+        else {
+            memset(pRate, 0, sizeof(*pRate));
+        }
+    }
+
+    pStruct->statsStartUs = now_us;
+    pStruct->statsRxBits = 0;
+    pStruct->statsTxBits = 0;
+    pStruct->statsRxFrames = 0;
+    pStruct->statsTxFrames = 0;
+    pStruct->statsIdCount = 0;
+}
+
+/// @returns true if the TX entry a should be sent before b
+static inline bool CAN_tx_entry_before(const can_tx_entry_t *a, const can_tx_entry_t *b)
+{
+    const uint8_t pa = a->msg.frame & CAN_TX_PRIORITY_MASK;
+    const uint8_t pb = b->msg.frame & CAN_TX_PRIORITY_MASK;
+    return (pa != pb) ? (pa < pb) : ((int16_t) (a->seq - b->seq) < 0);
+}
+
+/// Adds a message to the TX priority queue, which must have space (called from critical section)
+static void CAN_tx_heap_push(can_struct_t *pStruct, const can_msg_t *pMsg, uint32_t queuedUs)
+{
+    can_tx_entry_t *heap = pStruct->txHeap;
+    uint16_t i = pStruct->txHeapCount++;
+    can_tx_entry_t entry;
+
+    entry.msg = *pMsg;
+    entry.seq = pStruct->txSeq++;
+    entry.queuedUs = queuedUs;
+
+    /* Move the parents down until the entry fits */
+    while (i > 0 && CAN_tx_entry_before(&entry, &heap[(i - 1) / 2])) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = entry;
+
+    if (pStruct->txHeapCount > pStruct->txQWatermark) {
+        pStruct->txQWatermark = pStruct->txHeapCount;
+    }
+}
+
+/// Removes the first message of the TX priority queue, which must not be empty (called from critical section)
+static void CAN_tx_heap_pop(can_struct_t *pStruct)
+{
+    can_tx_entry_t *heap = pStruct->txHeap;
+    const uint16_t count = --pStruct->txHeapCount;
+    const can_tx_entry_t *pLast = &heap[count];
+    uint16_t i = 0;
+    uint16_t child = 0;
+
+    /* Move the last entry from the top to where it fits */
+    while ((child = 2 * i + 1) < count) {
+        if ((child + 1) < count && CAN_tx_entry_before(&heap[child + 1], &heap[child])) {
+            child++;
+        }
+        if (!CAN_tx_entry_before(&heap[child], pLast)) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = *pLast;
+}
+
 /**
- * Sends a message using an available buffer.  Initially this chose one out of the three buffers but that's
- * a little tricky to use when messages are always queued since one of the 3 buffers can be starved and not
- * get sent.  So therefore some of that logic is #ifdef'd out to only use one HW buffer.
+ * Sends a message using an available HW buffer.  The CAN is used in the TPM mode, so when more than one
+ * buffer is waiting to be sent, the HW sends the one with the lowest TX priority in the lower 8 bits of
+ * the frame, and the HW chooses the buffer with the lowest number amongst the ones of equal priority.
+ * Therefore a message is only written to a buffer numbered higher than the buffers that still hold a
+ * message of the same priority so messages of the same priority are sent in order.
  *
  * @returns true if the message was written to the HW buffer to be sent, otherwise false if the HW buffer(s) are busy.
  *
- * Notes:
- *  - Using the TX message counter and the TPM bit, we can ensure that the HW chooses between the TX1/TX2/TX3
- *    in a round-robin fashion otherwise there is a possibility that if the CAN Tx queue is always full,
- *    a low message ID can be starved even if it was amongst the first ones written using this method call.
- *
  * @warning This should be called from critical section since this method is not thread-safe
  */
-static bool CAN_tx_now (can_struct_t *struct_ptr, can_msg_t *msg_ptr)
+static bool CAN_tx_now (can_struct_t *struct_ptr, const can_msg_t *msg_ptr, uint32_t queuedUs)
 {
     // 32-bit command of CMR register to start transmission of one of the buffers
-    enum {
-        go_cmd_invalid = 0,
-        go_cmd_tx1 = 0x21,
-        go_cmd_tx2 = 0x41,
-        go_cmd_tx3 = 0x81,
-    };
+    static const uint32_t go_cmds[CAN_HW_TX_BUFFERS] = { 0x21, 0x41, 0x81 };
+    static const uint32_t avail_masks[CAN_HW_TX_BUFFERS] = { tx1_avail, tx2_avail, tx3_avail };
 
     LPC_CAN_TypeDef *pCAN = struct_ptr->pCanRegs;
     const uint32_t can_sr_reg = pCAN->SR;
-    volatile can_msg_t *pHwMsgRegs = NULL;
-    uint32_t go_cmd = go_cmd_invalid;
-
-    if (can_sr_reg & tx1_avail){
-        pHwMsgRegs = (can_msg_t*)&(pCAN->TFI1);
-        go_cmd = go_cmd_tx1;
-    }
-#if 0
-    else if (can_sr_reg & tx2_avail){
-        pHwMsgRegs = (can_msg_t*)&(pCAN->TFI2);
-        go_cmd = go_cmd_tx2;
+    const uint8_t priority = msg_ptr->frame & CAN_TX_PRIORITY_MASK;
+    volatile can_msg_t *pHwMsgRegs = (can_msg_t*)&(pCAN->TFI1);
+    uint32_t go_cmd = 0;
+    uint8_t first = 0;
+    uint8_t i = 0;
+
+    /* Skip past the last busy buffer with a message of the same priority */
+    for (i = 0; i < CAN_HW_TX_BUFFERS; i++) {
+        if (!(can_sr_reg & avail_masks[i]) && priority == struct_ptr->txHwPriority[i]) {
+            first = i + 1;
+        }
     }
-    else if (can_sr_reg & tx3_avail){
-        pHwMsgRegs = (can_msg_t*)&(pCAN->TFI3);
-        go_cmd = go_cmd_tx3;
+    for (i = first; i < CAN_HW_TX_BUFFERS; i++) {
+        if (can_sr_reg & avail_masks[i]) {
+            break;
+        }
     }
-#endif
-    else {
+    if (i >= CAN_HW_TX_BUFFERS) {
         /* No buffer available, return failure */
         return false;
     }
 
-    /* Copy the CAN message to the HW CAN registers and write the 8 TPM bits.
-     * We set TPM bits each time by using the txMsgCount because otherwise if TX1, and TX2 are always
-     * being written with a lower message ID, then TX3 will starve and never be sent.
-     */
-#if 0
-    // Higher number will be sent later, but how do we handle the rollover from 255 to 0 because then the
-    // newly written 0 will be sent, and buffer that contains higher TPM can starve.
-    const uint8_t tpm = struct_ptr->txMsgCount;
-    msg_ptr->frame |= tpm;
-#endif
-    *pHwMsgRegs = *msg_ptr;
+    /* Copy the CAN message to the HW CAN registers (TFIx, TIDx, TDAx, TDBx are consecutive) */
+    pHwMsgRegs[i] = *msg_ptr;
+    struct_ptr->txHwPriority[i] = priority;
+    struct_ptr->txHwQueuedUs[i] = queuedUs;
+    struct_ptr->txHwMsg[i] = *msg_ptr;
     struct_ptr->txMsgCount++;
+    go_cmd = go_cmds[i];
 
     #if CAN_TESTING
     go_cmd &= (0xF0);
     go_cmd = (1 << 4); /* Self reception */
+    #else
+    if (struct_ptr->selfTest) {
+        go_cmd = (go_cmd & 0xE0) | (1 << 4); /* Self reception request of the selected buffer */
+    }
     #endif
 
     /* Send the message! */
@@ -209,38 +483,105 @@ static bool CAN_tx_now (can_struct_t *struct_ptr, can_msg_t *msg_ptr)
     return true;
 }
 
-static void CAN_handle_isr(const can_t can)
+/**
+ * Moves the queued messages to the available HW buffers, in the order of their priority.
+ * @returns the number of messages removed from the TX priority queue
+ * @warning This should be called from critical section since this method is not thread-safe
+ */
+static uint16_t CAN_tx_fill(can_struct_t *pStruct)
+{
+    uint16_t sent = 0;
+
+    while (pStruct->txHeapCount > 0 && CAN_tx_now(pStruct, &(pStruct->txHeap[0].msg), pStruct->txHeap[0].queuedUs)) {
+        CAN_tx_heap_pop(pStruct);
+        sent++;
+    }
+
+    return sent;
+}
+
+static RAMFUNC void CAN_handle_isr(const can_t can)
 {
     can_struct_t *pStruct = CAN_STRUCT_PTR(can);
     LPC_CAN_TypeDef *pCAN = pStruct->pCanRegs;
     const uint32_t rbs = (1 << 0);
     const uint32_t ibits = pCAN->ICR;
+    long higherPriorityTaskWoken = 0;
     UBaseType_t count;
-    can_msg_t msg;
+    const uint64_t now_us = sys_get_uptime_us();
 
-    /* Handle the received message */
+    /* Handle all of the received messages.  The HW has a double receive buffer, so after we release
+     * the receive buffer, the next message may already be available.
+     */
     if ((ibits & intr_rx) | (pCAN->GSR & rbs)) {
-        if( (count = uxQueueMessagesWaitingFromISR(pStruct->rxQ)) > pStruct->rxQWatermark) {
-            pStruct->rxQWatermark = count;
-        }
+        const bool was_empty = (pStruct->rxHead == pStruct->rxTail);
+        uint16_t head = pStruct->rxHead;
+
+        do {
+            const uint16_t next = CAN_rx_ring_next(pStruct, head);
+            const can_msg_t *pMsg = (const can_msg_t*) &(pCAN->RFS);
+
+            if (next != pStruct->rxTail) {
+                pStruct->rxRing[head].msg = *pMsg;
+                pStruct->rxRing[head].timestamp_us = now_us;
+                pMsg = &(pStruct->rxRing[head].msg);
+                head = next;
+                pStruct->rxMsgCount++;
+            }
+            else {
+                pStruct->droppedRxMsgs++;
+            }
 
-        can_msg_t *pHwMsgRegs = (can_msg_t*) &(pCAN->RFS);
-        if (xQueueSendFromISR(pStruct->rxQ, pHwMsgRegs, NULL)) {
-            pStruct->rxMsgCount++;
+            /* The frame of a dropped message was still on the bus, so it is read from the HW buffer */
+            pStruct->statsRxBits += CAN_frame_bits(pMsg);
+            CAN_stats_count_id(pStruct, CAN_stats_id(pMsg));
+            if (pStruct->tap) {
+                pStruct->tap(can, pMsg, now_us, false);
+            }
+            pStruct->statsRxFrames++;
+            pCAN->CMR = 0x04; // Release the receive buffer, no need to bitmask
+        } while (pCAN->GSR & rbs);
+
+        /* Publish all of the messages at once */
+        CAN_RING_BARRIER();
+        pStruct->rxHead = head;
+
+        /* Only wake up the reader if it may have found the ring empty */
+        if (was_empty && head != pStruct->rxTail) {
+            xSemaphoreGiveFromISR(pStruct->rxSignal, &higherPriorityTaskWoken);
         }
-        else {
-            pStruct->droppedRxMsgs++;
+
+        if( (count = CAN_rx_ring_count(pStruct)) > pStruct->rxQWatermark) {
+            pStruct->rxQWatermark = count;
         }
-        pCAN->CMR = 0x04; // Release the receive buffer, no need to bitmask
     }
 
-    /* A transmit finished, send any queued message(s) */
+    /* A transmit finished, send the queued message(s) with the highest priority */
     if (ibits & intr_all_tx) {
-        if( (count = uxQueueMessagesWaitingFromISR(pStruct->txQ)) > pStruct->txQWatermark) {
-            pStruct->txQWatermark = count;
+        static const uint32_t tx_intr[CAN_HW_TX_BUFFERS] = { intr_tx1, intr_tx2, intr_tx3 };
+        can_stats_t *pStats = &pStruct->stats;
+
+        for (uint8_t i = 0; i < CAN_HW_TX_BUFFERS; i++) {
+            if (ibits & tx_intr[i]) {
+                const uint32_t latency_us = (uint32_t) now_us - pStruct->txHwQueuedUs[i];
+                pStats->tx_latency_us = latency_us;
+                pStats->tx_latency_avg_us = (0 == pStats->tx_latency_avg_us) ? latency_us :
+                                            (pStats->tx_latency_avg_us - (pStats->tx_latency_avg_us / 16) + (latency_us / 16));
+                if (latency_us > pStats->tx_latency_max_us) {
+                    pStats->tx_latency_max_us = latency_us;
+                }
+                pStruct->statsTxBits += CAN_frame_bits(&(pStruct->txHwMsg[i]));
+                pStruct->statsTxFrames++;
+                CAN_stats_count_id(pStruct, CAN_stats_id(&(pStruct->txHwMsg[i])));
+                if (pStruct->tap) {
+                    pStruct->tap(can, &(pStruct->txHwMsg[i]), now_us, true);
+                }
+            }
         }
-        if (xQueueReceiveFromISR(pStruct->txQ, &msg, NULL)) {
-            CAN_tx_now(pStruct, &msg);
+
+        count = CAN_tx_fill(pStruct);
+        while (count--) {
+            xSemaphoreGiveFromISR(pStruct->txSpace, &higherPriorityTaskWoken);
         }
     }
 
@@ -253,6 +594,10 @@ static void CAN_handle_isr(const can_t can)
     if (ibits & intr_ovrn) {
         pStruct->data_overrun(ibits);
     }
+
+    CAN_stats_end_window(pStruct, now_us);
+
+    portEND_SWITCHING_ISR(higherPriorityTaskWoken);
 }
 /** @} */
 
@@ -309,12 +654,26 @@ bool CAN_init(can_t can, uint32_t baudrate_kbps, uint16_t rxq_size, uint16_t txq
         LPC_PINCON->PINSEL4 |=  (0x5 << 14);
     }
 
-    /* Create the queues with minimum size of 1 to avoid NULL pointer reference */
-    if (!pStruct->rxQ) {
-        pStruct->rxQ = xQueueCreate(rxq_size ? rxq_size : 1, sizeof(can_msg_t));
+    /* Create the queues with minimum size of 1 to avoid NULL pointer reference.
+     * The RX ring holds one less message than its size, so allocate one extra message.
+     */
+    if (!pStruct->rxRing) {
+        const uint16_t ring_size = (rxq_size ? rxq_size : 1) + 1;
+        if (NULL != (pStruct->rxRing = (can_rx_msg_t*) malloc(ring_size * sizeof(can_rx_msg_t)))) {
+            pStruct->rxRingSize = ring_size;
+        }
     }
-    if (!pStruct->txQ) {
-        pStruct->txQ = xQueueCreate(txq_size ? txq_size : 1, sizeof(can_msg_t));
+    if (!pStruct->rxSignal) {
+        pStruct->rxSignal = xSemaphoreCreateBinary();
+    }
+    if (!pStruct->txHeap) {
+        const uint16_t heap_size = txq_size ? txq_size : 1;
+        if (NULL != (pStruct->txHeap = (can_tx_entry_t*) malloc(heap_size * sizeof(can_tx_entry_t)))) {
+            pStruct->txHeapSize = heap_size;
+        }
+    }
+    if (!pStruct->txSpace && pStruct->txHeap) {
+        pStruct->txSpace = xSemaphoreCreateCounting(pStruct->txHeapSize, pStruct->txHeapSize);
     }
 
     /* The CAN dividers must all be the same for both CANs
@@ -381,10 +740,19 @@ bool CAN_init(can_t can, uint32_t baudrate_kbps, uint16_t rxq_size, uint16_t txq
 
         if (!failed) {
             pCAN->BTR  = (SAM << 23) | (TSEG2<<20) | (TSEG1<<16) | (SJW<<14) | BRP;
+
+            /* A bit is the sync quantum and the TSEG1 + 1 and TSEG2 + 1 quanta */
+            pStruct->stats.bitrate = sys_get_cpu_clock() / ((BRP + 1) * (TSEG1 + TSEG2 + 3));
+            pStruct->statsStartUs = sys_get_uptime_us();
             // CANx->BTR = 0x002B001D; // 48Mhz 100Khz
         }
     } while (0);
 
+    /* The interrupt cannot use the RX ring or the TX queue if we ran out of memory */
+    if (!pStruct->rxRing || !pStruct->rxSignal || !pStruct->txHeap || !pStruct->txSpace) {
+        failed = true;
+    }
+
     /* If everything okay so far, enable the CAN interrupts */
     if (!failed) {
         /* At minimum, we need Rx/Tx interrupts */
@@ -411,73 +779,88 @@ bool CAN_init(can_t can, uint32_t baudrate_kbps, uint16_t rxq_size, uint16_t txq
 
 
 bool CAN_tx (can_t can, can_msg_t *pCanMsg, uint32_t timeout_ms)
+{
+    return pCanMsg && CAN_tx_with_priority(can, pCanMsg, CAN_get_id_priority(pCanMsg), timeout_ms);
+}
+
+bool CAN_tx_with_priority(can_t can, can_msg_t *pCanMsg, uint8_t priority, uint32_t timeout_ms)
 {
     if (!CAN_VALID(can) || !pCanMsg || CAN_is_bus_off(can)) {
         return false;
     }
 
     bool ok = false;
+    uint16_t sent = 0;
     can_struct_t *pStruct = CAN_STRUCT_PTR(can);
-    LPC_CAN_TypeDef *CANx = pStruct->pCanRegs;
+    can_msg_t msg = *pCanMsg;
+    msg.frame = (msg.frame & ~CAN_TX_PRIORITY_MASK) | priority;
+    const uint32_t queuedUs = sys_get_uptime_us();
 
-    /* Try transmitting to one of the available buffers */
+    /* Try transmitting to one of the available buffers unless messages are already waiting */
     taskENTER_CRITICAL();
     do {
-        ok = CAN_tx_now(pStruct, pCanMsg);
+        ok = (0 == pStruct->txHeapCount) && CAN_tx_now(pStruct, &msg, queuedUs);
     } while(0);
     taskEXIT_CRITICAL();
 
-    /* If HW buffer not available, then just queue the message */
+    /* If HW buffer not available, then queue the message by its priority */
     if (!ok) {
-        if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
-            ok = xQueueSend(pStruct->txQ, pCanMsg, OS_MS(timeout_ms));
-        }
-        else {
-            ok = xQueueSend(pStruct->txQ, pCanMsg, 0);
-        }
+        const TickType_t timeout = (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) ? OS_MS(timeout_ms) : 0;
+        ok = xSemaphoreTake(pStruct->txSpace, timeout);
 
         /* There is possibility that before we queued the message, we got interrupted
-         * and all hw buffers were emptied meanwhile, and our queued message will now
+         * and the hw buffers were emptied meanwhile, and our queued message will now
          * sit in the queue forever until another Tx interrupt takes place.
-         * So we dequeue it here if all are empty and send it over.
+         * So we move the queued messages to any available buffers right away.
          */
-        taskENTER_CRITICAL();
-        do {
-            can_msg_t msg;
-            if (tx_all_avail == (CANx->SR & tx_all_avail) &&
-                xQueueReceive(pStruct->txQ, &msg, 0)
-            ) {
-                ok = CAN_tx_now(pStruct, &msg);
+        if (ok) {
+            taskENTER_CRITICAL();
+            do {
+                CAN_tx_heap_push(pStruct, &msg, queuedUs);
+                sent = CAN_tx_fill(pStruct);
+            } while(0);
+            taskEXIT_CRITICAL();
+
+            while (sent--) {
+                xSemaphoreGive(pStruct->txSpace);
             }
-        } while(0);
-        taskEXIT_CRITICAL();
+        }
     }
 
     return ok;
 }
 
+uint8_t CAN_get_id_priority(const can_msg_t *pCanMsg)
+{
+    /* Lower ID wins the bus arbitration, so use the most significant bits of the ID */
+    return (uint8_t) (pCanMsg->frame_fields.is_29bit ? (pCanMsg->msg_id >> 21) : (pCanMsg->msg_id >> 3));
+}
+
 bool CAN_rx (can_t can, can_msg_t *pCanMsg, uint32_t timeout_ms)
 {
     bool ok = false;
+    can_rx_msg_t rx;
 
-    if (CAN_VALID(can) && pCanMsg)
-    {
-        if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
-            ok = xQueueReceive(CAN_STRUCT_PTR(can)->rxQ, pCanMsg, OS_MS(timeout_ms));
-        }
-        else {
-            uint64_t msg_timeout = sys_get_uptime_ms() + timeout_ms;
-            while (! (ok = xQueueReceive(CAN_STRUCT_PTR(can)->rxQ, pCanMsg, 0))) {
-                if (sys_get_uptime_ms() > msg_timeout) {
-                    break;
-                }
-            }
+    if (CAN_VALID(can) && pCanMsg && CAN_rx_ring_wait(CAN_STRUCT_PTR(can), timeout_ms)) {
+        if ((ok = (1 == CAN_rx_ring_pop(CAN_STRUCT_PTR(can), &rx, 1)))) {
+            *pCanMsg = rx.msg;
         }
     }
 
     return ok;
 }
 
+uint16_t CAN_rx_batch(can_t can, can_rx_msg_t *pMsgs, uint16_t max, uint32_t timeout_ms)
+{
+    uint16_t count = 0;
+
+    if (CAN_VALID(can) && pMsgs && max > 0 && CAN_rx_ring_wait(CAN_STRUCT_PTR(can), timeout_ms)) {
+        count = CAN_rx_ring_pop(CAN_STRUCT_PTR(can), pMsgs, max);
+    }
+
+    return count;
+}
+
 bool CAN_is_bus_off(can_t can)
 {
     const uint32_t bus_off_mask = (1 << 7);
@@ -492,11 +875,19 @@ void CAN_reset_bus(can_t can)
         #if CAN_TESTING
             CAN_STRUCT_PTR(can)->pCanRegs->MOD = can_mod_selftest;
         #else
-            CAN_STRUCT_PTR(can)->pCanRegs->MOD = can_mod_normal_tpm;
+            CAN_STRUCT_PTR(can)->pCanRegs->MOD = CAN_STRUCT_PTR(can)->selfTest ? can_mod_selftest_tpm : can_mod_normal_tpm;
         #endif
     }
 }
 
+void CAN_set_self_test(can_t can, bool enable)
+{
+    if (CAN_VALID(can)) {
+        CAN_STRUCT_PTR(can)->selfTest = enable;
+        CAN_reset_bus(can);
+    }
+}
+
 uint16_t CAN_get_rx_watermark(can_t can)
 {
     return CAN_VALID(can) ? CAN_STRUCT_PTR(can)->rxQWatermark : 0;
@@ -522,6 +913,41 @@ uint16_t CAN_get_rx_dropped_count(can_t can)
     return CAN_VALID(can) ? CAN_STRUCT_PTR(can)->droppedRxMsgs : 0;
 }
 
+const can_stats_t* CAN_get_stats(can_t can)
+{
+    if (!CAN_VALID(can)) {
+        return NULL;
+    }
+
+    can_struct_t *pStruct = CAN_STRUCT_PTR(can);
+    if (pStruct->stats.bitrate > 0) {
+        taskENTER_CRITICAL();
+        CAN_stats_end_window(pStruct, sys_get_uptime_us());
+        taskEXIT_CRITICAL();
+    }
+    return &(pStruct->stats);
+}
+
+void CAN_reset_stats(can_t can)
+{
+    if (CAN_VALID(can)) {
+        can_stats_t *pStats = &(CAN_STRUCT_PTR(can)->stats);
+        taskENTER_CRITICAL();
+        pStats->peak_load_x100 = 0;
+        pStats->tx_latency_us = 0;
+        pStats->tx_latency_avg_us = 0;
+        pStats->tx_latency_max_us = 0;
+        taskEXIT_CRITICAL();
+    }
+}
+
+void CAN_set_tap(can_t can, can_tap_func_t tap)
+{
+    if (CAN_VALID(can)) {
+        CAN_STRUCT_PTR(can)->tap = tap;
+    }
+}
+
 void CAN_bypass_filter_accept_all_msgs(void)
 {
     LPC_CANAF->AFMR = afmr_bypass;
@@ -746,6 +1172,329 @@ bool CAN_setup_filter(const can_std_id_t *std_id_list,           uint16_t sid_cn
     return ok;
 }
 
+/** @{ Private types and functions of the filter set */
+#define CAN_FILTER_MAX_SPLIT_BITS   8       ///< A mask can have up to 8 "don't care" bits above its care bits
+#define CAN_FILTER_STD_ID_MASK      0x7FF
+#define CAN_FILTER_EXT_ID_MASK      0x1FFFFFFF
+
+/// Inclusive range of accepted IDs of one CAN controller
+typedef struct {
+    uint32_t low;       ///< Lowest ID
+    uint32_t high;      ///< Highest ID
+    uint8_t can_num;    ///< CAN controller number
+    uint8_t is_29bit;   ///< 1 if the range is for the extended IDs
+} can_filter_range_t;
+
+/// Number of entries of each section of the filter RAM
+typedef struct {
+    uint16_t sid;       ///< Standard IDs, including the disabled entry to make the count even
+    uint16_t sgp;       ///< Standard ID groups
+    uint16_t eid;       ///< Extended IDs
+    uint16_t egp;       ///< Extended ID groups
+} can_filter_counts_t;
+
+/// @returns the bytes of filter RAM used by the counts
+static inline uint32_t CAN_filter_count_bytes(const can_filter_counts_t *c)
+{
+    return (c->sid * sizeof(can_std_id_t))  + (c->sgp * sizeof(can_std_grp_id_t)) +
+           (c->eid * sizeof(can_ext_id_t))  + (c->egp * sizeof(can_ext_grp_id_t));
+}
+
+/// qsort() comparison of the ranges that sorts them in the order of the filter RAM
+static int CAN_filter_range_cmp(const void *p1, const void *p2)
+{
+    const can_filter_range_t *a = (const can_filter_range_t*) p1;
+    const can_filter_range_t *b = (const can_filter_range_t*) p2;
+
+    if (a->is_29bit != b->is_29bit) {
+        return (int) a->is_29bit - (int) b->is_29bit;
+    }
+    if (a->can_num != b->can_num) {
+        return (int) a->can_num - (int) b->can_num;
+    }
+    return (a->low < b->low) ? -1 : (a->low > b->low) ? 1 : 0;
+}
+
+/**
+ * Splits a filter into the ranges of IDs it accepts.  The "don't care" bits of the mask below its
+ * lowest care bit are a single range, and each combination of the other "don't care" bits is a range.
+ * @returns the number of ranges, which are written to pRanges if it is not NULL, or 0 if the filter is invalid
+ */
+static uint32_t CAN_filter_split(const can_filter_t *pFilter, can_filter_range_t *pRanges)
+{
+    const uint32_t id_mask = pFilter->is_29bit ? CAN_FILTER_EXT_ID_MASK : CAN_FILTER_STD_ID_MASK;
+    const uint32_t free_bits = ~pFilter->mask & id_mask;
+    const uint32_t low_bits = free_bits & ~(free_bits + 1);
+    const uint32_t split_bits = free_bits & ~low_bits;
+    const uint32_t split_count = __builtin_popcount(split_bits);
+    const uint32_t base = pFilter->id & ~free_bits;
+    uint32_t i = 0;
+
+    if (!CAN_VALID(pFilter->can) || (pFilter->id & ~id_mask) || split_count > CAN_FILTER_MAX_SPLIT_BITS) {
+        return 0;
+    }
+
+    for (i = 0; pRanges && i < (1U << split_count); i++) {
+        /* Distribute the bits of i to the split bits of the ID */
+        uint32_t bits = split_bits;
+        uint32_t id = base;
+        uint32_t b = 0;
+        for (b = 0; bits; b++) {
+            const uint32_t lsb = bits & -bits;
+            if (i & (1U << b)) {
+                id |= lsb;
+            }
+            bits &= ~lsb;
+        }
+
+        pRanges[i].low = id;
+        pRanges[i].high = id | low_bits;
+        pRanges[i].can_num = pFilter->can;
+        pRanges[i].is_29bit = pFilter->is_29bit ? 1 : 0;
+    }
+
+    return (1U << split_count);
+}
+
+/**
+ * Merges the overlapping and adjacent ranges, which must be sorted
+ * @returns the number of ranges left
+ */
+static uint32_t CAN_filter_merge(can_filter_range_t *pRanges, uint32_t count)
+{
+    uint32_t n = 0;
+    uint32_t i = 0;
+
+    for (i = 0; i < count; i++) {
+        can_filter_range_t *pLast = (n > 0) ? &pRanges[n - 1] : NULL;
+        if (pLast && pLast->is_29bit == pRanges[i].is_29bit && pLast->can_num == pRanges[i].can_num &&
+            pRanges[i].low <= pLast->high + 1)
+        {
+            if (pRanges[i].high > pLast->high) {
+                pLast->high = pRanges[i].high;
+            }
+        }
+        else {
+            pRanges[n++] = pRanges[i];
+        }
+    }
+
+    return n;
+}
+
+/**
+ * Counts the entries of each section of the filter RAM.  A range of a single ID uses an individual
+ * entry, and a larger range uses a group, which takes the same RAM as two individual entries.
+ */
+static void CAN_filter_count(const can_filter_range_t *pRanges, uint32_t count, can_filter_counts_t *pCounts)
+{
+    uint32_t i = 0;
+
+    memset(pCounts, 0, sizeof(*pCounts));
+    for (i = 0; i < count; i++) {
+        const bool single = (pRanges[i].low == pRanges[i].high);
+        if (pRanges[i].is_29bit) {
+            if (single) {
+                pCounts->eid++;
+            }
+            else {
+                pCounts->egp++;
+            }
+        }
+        else if (single) {
+            pCounts->sid++;
+        }
+        else {
+            pCounts->sgp++;
+        }
+    }
+
+    /* Standard IDs are stored two per word */
+    pCounts->sid += (pCounts->sid & 1);
+}
+
+/// @returns the raw standard ID entry of the filter RAM
+static inline uint32_t CAN_filter_sid_raw(uint8_t can_num, uint32_t id)
+{
+    return CAN_gen_sid((can_t) can_num, (uint16_t) id).raw;
+}
+
+/// @returns the raw extended ID entry of the filter RAM
+static inline uint32_t CAN_filter_eid_raw(uint8_t can_num, uint32_t id)
+{
+    return ((uint32_t) can_num << 29) | (id & CAN_FILTER_EXT_ID_MASK);
+}
+
+/**
+ * Writes the filter table to pTable in the order of the filter RAM sections.
+ * The standard IDs are big-endian within 32-bit words, see CAN_setup_filter()
+ */
+static void CAN_filter_write_table(const can_filter_range_t *pRanges, uint32_t count, uint32_t *pTable)
+{
+    uint32_t i = 0;
+    uint32_t sid_last = 0;
+    bool sid_half = false;
+
+    /* The ranges are sorted with standard IDs first, so each section is written in ascending order */
+    for (i = 0; i < count; i++) {
+        const can_filter_range_t *r = &pRanges[i];
+        if (!r->is_29bit && r->low == r->high) {
+            if (sid_half) {
+                *pTable++ = (sid_last << 16) | CAN_filter_sid_raw(r->can_num, r->low);
+            }
+            else {
+                sid_last = CAN_filter_sid_raw(r->can_num, r->low);
+            }
+            sid_half = !sid_half;
+        }
+    }
+    if (sid_half) {
+        /* Pair the last standard ID with a disabled entry, which has the highest ID */
+        *pTable++ = (sid_last << 16) | (CAN_gen_sid((can_t) (sid_last >> 13), 0xFFFF).raw & UINT16_MAX);
+    }
+
+    for (i = 0; i < count; i++) {
+        const can_filter_range_t *r = &pRanges[i];
+        if (!r->is_29bit && r->low != r->high) {
+            *pTable++ = (CAN_filter_sid_raw(r->can_num, r->low) << 16) | CAN_filter_sid_raw(r->can_num, r->high);
+        }
+    }
+    for (i = 0; i < count; i++) {
+        const can_filter_range_t *r = &pRanges[i];
+        if (r->is_29bit && r->low == r->high) {
+            *pTable++ = CAN_filter_eid_raw(r->can_num, r->low);
+        }
+    }
+    for (i = 0; i < count; i++) {
+        const can_filter_range_t *r = &pRanges[i];
+        if (r->is_29bit && r->low != r->high) {
+            *pTable++ = CAN_filter_eid_raw(r->can_num, r->low);
+            *pTable++ = CAN_filter_eid_raw(r->can_num, r->high);
+        }
+    }
+}
+
+/**
+ * Converts the filters to the sorted and merged ranges
+ * @param ppRanges  The allocated ranges, which must be freed by the caller
+ * @returns the number of ranges, or -1 upon invalid filters or out of memory
+ */
+static int32_t CAN_filter_get_ranges(const can_filter_t *pFilters, uint16_t count, can_filter_range_t **ppRanges)
+{
+    uint32_t total = 0;
+    uint32_t n = 0;
+    uint16_t i = 0;
+
+    *ppRanges = NULL;
+    for (i = 0; i < count; i++) {
+        if (0 == (n = CAN_filter_split(&pFilters[i], NULL))) {
+            return -1;
+        }
+        total += n;
+    }
+    if (0 == total) {
+        return 0;
+    }
+
+    if (NULL == (*ppRanges = (can_filter_range_t*) malloc(total * sizeof(can_filter_range_t)))) {
+        return -1;
+    }
+    for (i = 0, n = 0; i < count; i++) {
+        n += CAN_filter_split(&pFilters[i], *ppRanges + n);
+    }
+
+    qsort(*ppRanges, total, sizeof(can_filter_range_t), CAN_filter_range_cmp);
+    return (int32_t) CAN_filter_merge(*ppRanges, total);
+}
+/** @} */
+
+int32_t CAN_filter_set_get_ram_bytes(const can_filter_t *filters, uint16_t count)
+{
+    can_filter_range_t *pRanges = NULL;
+    can_filter_counts_t counts;
+    const int32_t n = CAN_filter_get_ranges(filters, count, &pRanges);
+
+    if (n < 0) {
+        return -1;
+    }
+
+    CAN_filter_count(pRanges, n, &counts);
+    free(pRanges);
+    return (int32_t) CAN_filter_count_bytes(&counts);
+}
+
+bool CAN_filter_set_apply(const can_filter_t *filters, uint16_t count)
+{
+    can_filter_range_t *pRanges = NULL;
+    uint32_t *pTable = NULL;
+    can_filter_counts_t counts;
+    uint32_t bytes = 0;
+    bool ok = false;
+    const int32_t n = CAN_filter_get_ranges(filters, count, &pRanges);
+
+    if (n < 0) {
+        return false;
+    }
+
+    /* Build the table in memory first, so the filter RAM is only off while the table is copied */
+    CAN_filter_count(pRanges, n, &counts);
+    bytes = CAN_filter_count_bytes(&counts);
+    if (0 == bytes || NULL != (pTable = (uint32_t*) malloc(bytes))) {
+        CAN_filter_write_table(pRanges, n, pTable);
+
+        taskENTER_CRITICAL();
+        do {
+            /* FullCAN entries at the start of the RAM, and their messages after the table remain in place */
+            const uint32_t start = LPC_CANAF->SFF_sa;
+            const uint32_t fullcan_bytes = sizeof(can_fullcan_msg_t) * CAN_fullcan_get_num_entries();
+
+            if ((start + bytes + fullcan_bytes) <= sizeof(LPC_CANAF_RAM->mask)) {
+                const uint32_t afmr = (0 == start) ? afmr_enabled : afmr_fullcan;
+                const uint32_t old_end = LPC_CANAF->ENDofTable / 4;
+                const uint32_t new_end = (start + bytes) / 4;
+                volatile uint32_t *ram = &(LPC_CANAF_RAM->mask[0]);
+                uint32_t i = 0;
+
+                LPC_CANAF->AFMR = afmr_disabled;
+
+                /* The FullCAN messages are stored after the end of the table, so move them first (by words
+                 * since the filter RAM is word accessed), and then overwrite the table
+                 */
+                if (new_end > old_end) {
+                    for (i = fullcan_bytes / 4; i > 0; i--) {
+                        ram[new_end + i - 1] = ram[old_end + i - 1];
+                    }
+                }
+                else {
+                    for (i = 0; i < fullcan_bytes / 4; i++) {
+                        ram[new_end + i] = ram[old_end + i];
+                    }
+                }
+                for (i = 0; i < bytes / 4; i++) {
+                    ram[start / 4 + i] = pTable[i];
+                }
+
+                LPC_CANAF->SFF_GRP_sa = start + counts.sid * sizeof(can_std_id_t);
+                LPC_CANAF->EFF_sa     = LPC_CANAF->SFF_GRP_sa + counts.sgp * sizeof(can_std_grp_id_t);
+                LPC_CANAF->EFF_GRP_sa = LPC_CANAF->EFF_sa + counts.eid * sizeof(can_ext_id_t);
+                LPC_CANAF->ENDofTable = LPC_CANAF->EFF_GRP_sa + counts.egp * sizeof(can_ext_grp_id_t);
+                LPC_CANAF->AFMR = afmr;
+                ok = true;
+            }
+        } while (0);
+        taskEXIT_CRITICAL();
+    }
+
+    free(pTable);
+    free(pRanges);
+    return ok;
+}
+
+uint16_t CAN_filter_get_ram_used(void)
+{
+    return LPC_CANAF->ENDofTable + (sizeof(can_fullcan_msg_t) * CAN_fullcan_get_num_entries());
+}
+
 #if CAN_TESTING
 #include <printf_lib.h>
 #define CAN_ASSERT(x)   if (!(x)) { u0_dbg_printf("Failed at %i, BUS: %s MOD: 0x%08x, GSR: 0x%08x\n"\
@@ -0,0 +1,448 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+#include <stddef.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "can_isotp.h"
+#include "lpc_sys.h"    // sys_get_uptime_ms()
+#include "utilities.h"  // delay_us()
+
+
+
+/// Protocol control information of the frames (upper 4 bits of the first byte)
+enum {
+    isotp_pci_single      = 0x0,
+    isotp_pci_first       = 0x1,
+    isotp_pci_consecutive = 0x2,
+    isotp_pci_flow        = 0x3,
+};
+
+/// Flow status of the flow control frames
+enum {
+    isotp_fs_cts      = 0x0,  ///< Continue to send
+    isotp_fs_wait     = 0x1,  ///< Wait for the next flow control
+    isotp_fs_overflow = 0x2,  ///< The message is too large for the receiver
+};
+
+/// States of the reception of a session
+enum {
+    isotp_rx_idle,
+    isotp_rx_receiving,
+    isotp_rx_done,
+};
+
+#define CAN_ISOTP_MAX_WAIT_FRAMES   10  ///< Flow control frames with the WAIT status we accept in a row
+#define CAN_ISOTP_SERVICE_MS        2   ///< How long the waiting functions receive the CAN messages at a time
+#define CAN_ISOTP_PADDING           0xCC
+
+static can_isotp_t *g_isotp_sessions = NULL;                ///< List of the sessions
+static SemaphoreHandle_t g_isotp_service_lock[can_max];     ///< Only one task can receive the CAN messages
+static can_isotp_rx_callback_t g_isotp_rx_callback = NULL;  ///< Callback of the other CAN messages
+
+
+
+/// Sends a frame of the session, padded to 8 bytes
+static bool CAN_isotp_send_frame(can_isotp_t *s, const uint8_t *data, uint8_t len, uint32_t timeout_ms)
+{
+    can_msg_t msg;
+
+    memset(&msg, 0, sizeof(msg));
+    memset(&msg.data.bytes[0], CAN_ISOTP_PADDING, sizeof(msg.data.bytes));
+    memcpy(&msg.data.bytes[0], data, len);
+    msg.msg_id = s->tx_id;
+    msg.frame_fields.is_29bit = s->is_29bit ? 1 : 0;
+    msg.frame_fields.data_len = 8;
+
+    return CAN_tx(s->can, &msg, timeout_ms);
+}
+
+/// Sends a flow control frame of the session
+static void CAN_isotp_send_fc(can_isotp_t *s, uint8_t flow_status)
+{
+    const uint8_t fc[3] = { (isotp_pci_flow << 4) | flow_status, s->block_size, s->st_min };
+    CAN_isotp_send_frame(s, fc, sizeof(fc), CAN_ISOTP_TIMEOUT_MS);
+}
+
+/// Starts to receive a message from its first frame
+static void CAN_isotp_start_rx(can_isotp_t *s, const uint8_t *ff)
+{
+    const uint16_t total = ((uint16_t) (ff[0] & 0x0F) << 8) | ff[1];
+
+    if (total > s->rx_size) {
+        s->rx_state = isotp_rx_idle;
+        CAN_isotp_send_fc(s, isotp_fs_overflow);
+    }
+    else {
+        memcpy(s->rx_buffer, &ff[2], 6);
+        s->rx_len = 6;
+        s->rx_expected = total;
+        s->rx_sn = 1;
+        s->rx_block_count = 0;
+        s->rx_last_ms = sys_get_uptime_ms();
+        s->rx_state = isotp_rx_receiving;
+        CAN_isotp_send_fc(s, isotp_fs_cts);
+    }
+}
+
+/// Handles a frame of the RX ID of the session
+static void CAN_isotp_handle_frame(can_isotp_t *s, const can_msg_t *msg)
+{
+    const uint8_t *d = &msg->data.bytes[0];
+    const uint8_t len = msg->frame_fields.data_len;
+    const uint8_t pci = d[0] >> 4;
+    bool pending = false;
+
+    if (len < 1) {
+        return;
+    }
+
+    switch (pci)
+    {
+        case isotp_pci_single:
+        {
+            const uint8_t n = d[0] & 0x0F;
+            if (0 == n || n > 7 || n > (len - 1) || n > s->rx_size || isotp_rx_done == s->rx_state) {
+                break;
+            }
+            memcpy(s->rx_buffer, &d[1], n);
+            s->rx_len = n;
+            s->rx_state = isotp_rx_done;
+            xSemaphoreGive(s->rx_event);
+            break;
+        }
+
+        case isotp_pci_first:
+            if (len < 8 || (((uint16_t) (d[0] & 0x0F) << 8) | d[1]) < 8) {
+                break;
+            }
+            /* Ask the sender to wait until the last message is read by CAN_isotp_recv() */
+            taskENTER_CRITICAL();
+            if ((pending = (isotp_rx_done == s->rx_state))) {
+                memcpy(s->rx_ff, d, sizeof(s->rx_ff));
+                s->rx_ff_pending = true;
+            }
+            taskEXIT_CRITICAL();
+
+            if (pending) {
+                CAN_isotp_send_fc(s, isotp_fs_wait);
+            }
+            else {
+                CAN_isotp_start_rx(s, d);
+            }
+            break;
+
+        case isotp_pci_consecutive:
+        {
+            uint16_t n = s->rx_expected - s->rx_len;
+            if (isotp_rx_receiving != s->rx_state) {
+                break;
+            }
+
+            /* Abort the message if a frame was lost */
+            if ((d[0] & 0x0F) != s->rx_sn) {
+                s->rx_state = isotp_rx_idle;
+                break;
+            }
+
+            n = (n > 7) ? 7 : n;
+            if (len < n + 1) {
+                s->rx_state = isotp_rx_idle;
+                break;
+            }
+            memcpy(&s->rx_buffer[s->rx_len], &d[1], n);
+            s->rx_len += n;
+            s->rx_sn = (s->rx_sn + 1) & 0x0F;
+            s->rx_last_ms = sys_get_uptime_ms();
+
+            if (s->rx_len >= s->rx_expected) {
+                s->rx_state = isotp_rx_done;
+                xSemaphoreGive(s->rx_event);
+            }
+            else if (0 != s->block_size && ++s->rx_block_count >= s->block_size) {
+                s->rx_block_count = 0;
+                CAN_isotp_send_fc(s, isotp_fs_cts);
+            }
+            break;
+        }
+
+        case isotp_pci_flow:
+            /* Keep the latest flow control until the sender reads it */
+            if (len >= 3) {
+                memcpy(s->tx_fc, d, sizeof(s->tx_fc));
+                xSemaphoreGive(s->tx_event);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/// Receives and dispatches the CAN messages; the caller must hold the service lock of the CAN
+static bool CAN_isotp_service_locked(can_t can, uint32_t timeout_ms)
+{
+    can_rx_msg_t msgs[8];
+    const uint16_t count = CAN_rx_batch(can, msgs, sizeof(msgs) / sizeof(msgs[0]), timeout_ms);
+    uint16_t i = 0;
+
+    for (i = 0; i < count; i++) {
+        if (!CAN_isotp_dispatch(can, &msgs[i].msg) && g_isotp_rx_callback) {
+            g_isotp_rx_callback(can, &msgs[i]);
+        }
+    }
+
+    return (count > 0);
+}
+
+/**
+ * Waits for the event of the session.  If no other task is receiving the CAN messages,
+ * then we receive and dispatch them while we wait.
+ */
+static bool CAN_isotp_wait(can_isotp_t *s, SemaphoreHandle_t event, uint32_t timeout_ms)
+{
+    const uint64_t end_ms = sys_get_uptime_ms() + timeout_ms;
+
+    do {
+        if (xSemaphoreTake(event, 0)) {
+            return true;
+        }
+        if (xSemaphoreTake(g_isotp_service_lock[s->can], 0)) {
+            CAN_isotp_service_locked(s->can, CAN_ISOTP_SERVICE_MS);
+            xSemaphoreGive(g_isotp_service_lock[s->can]);
+        }
+        else if (xSemaphoreTake(event, OS_MS(CAN_ISOTP_SERVICE_MS))) {
+            return true;
+        }
+    } while (sys_get_uptime_ms() < end_ms);
+
+    return xSemaphoreTake(event, 0);
+}
+
+/// Waits for the gap of STmin between the consecutive frames
+static void CAN_isotp_st_min_delay(uint8_t st_min)
+{
+    if (st_min >= 0xF1 && st_min <= 0xF9) {
+        delay_us((st_min - 0xF0) * 100);
+    }
+    else if (st_min > 0 && st_min <= 0x7F) {
+        /* Round up, because a delay of one tick may last less than a tick */
+        vTaskDelay(OS_MS(st_min) + 1);
+    }
+    else if (st_min > 0x7F) {
+        /* Reserved values shall be treated as the longest time */
+        vTaskDelay(OS_MS(0x7F) + 1);
+    }
+}
+
+
+
+bool CAN_isotp_init(can_isotp_t *session, can_t can, uint32_t tx_id, uint32_t rx_id, bool is_29bit,
+                    uint8_t *rx_buffer, uint16_t rx_size)
+{
+    if (!session || !rx_buffer || can >= can_max) {
+        return false;
+    }
+
+    memset(session, 0, sizeof(*session));
+    session->can = can;
+    session->tx_id = tx_id;
+    session->rx_id = rx_id;
+    session->is_29bit = is_29bit;
+    session->rx_buffer = rx_buffer;
+    session->rx_size = (rx_size > CAN_ISOTP_MAX_LEN) ? CAN_ISOTP_MAX_LEN : rx_size;
+    session->rx_state = isotp_rx_idle;
+    session->rx_event = xSemaphoreCreateBinary();
+    session->tx_event = xSemaphoreCreateBinary();
+
+    if (!g_isotp_service_lock[can]) {
+        g_isotp_service_lock[can] = xSemaphoreCreateMutex();
+    }
+    if (!session->rx_event || !session->tx_event || !g_isotp_service_lock[can]) {
+        return false;
+    }
+
+    taskENTER_CRITICAL();
+    {
+        session->next = g_isotp_sessions;
+        g_isotp_sessions = session;
+    }
+    taskEXIT_CRITICAL();
+
+    return true;
+}
+
+void CAN_isotp_set_flow_control(can_isotp_t *session, uint8_t block_size, uint8_t st_min)
+{
+    session->block_size = block_size;
+    session->st_min = st_min;
+}
+
+bool CAN_isotp_send(can_isotp_t *session, const void *data, uint16_t len, uint32_t timeout_ms)
+{
+    const uint8_t *p = (const uint8_t*) data;
+    uint8_t frame[8];
+    uint16_t sent = 0;
+    uint8_t sn = 1;
+
+    if (!session || !data || 0 == len || len > CAN_ISOTP_MAX_LEN) {
+        return false;
+    }
+
+    /* Single frame */
+    if (len <= 7) {
+        frame[0] = (isotp_pci_single << 4) | len;
+        memcpy(&frame[1], p, len);
+        return CAN_isotp_send_frame(session, frame, len + 1, timeout_ms);
+    }
+
+    /* First frame, and then the consecutive frames in the blocks allowed by the receiver */
+    xSemaphoreTake(session->tx_event, 0);
+    frame[0] = (isotp_pci_first << 4) | (len >> 8);
+    frame[1] = len & 0xFF;
+    memcpy(&frame[2], p, 6);
+    if (!CAN_isotp_send_frame(session, frame, 8, timeout_ms)) {
+        return false;
+    }
+    sent = 6;
+
+    while (sent < len) {
+        uint8_t waits = 0;
+        uint8_t block_size = 0;
+        uint8_t st_min = 0;
+        uint8_t count = 0;
+
+        /* Wait for the flow control, which may ask us to wait some more */
+        for (;;) {
+            if (!CAN_isotp_wait(session, session->tx_event, CAN_ISOTP_TIMEOUT_MS)) {
+                return false;
+            }
+
+            const uint8_t fs = session->tx_fc[0] & 0x0F;
+            if (isotp_fs_cts == fs) {
+                break;
+            }
+            if (isotp_fs_wait != fs || ++waits > CAN_ISOTP_MAX_WAIT_FRAMES) {
+                return false;
+            }
+        }
+        block_size = session->tx_fc[1];
+        st_min = session->tx_fc[2];
+
+        /* Send one block of frames */
+        while (sent < len && (0 == block_size || count < block_size)) {
+            const uint16_t n = ((len - sent) > 7) ? 7 : (len - sent);
+
+            if (count > 0) {
+                CAN_isotp_st_min_delay(st_min);
+            }
+            frame[0] = (isotp_pci_consecutive << 4) | sn;
+            memcpy(&frame[1], &p[sent], n);
+            sn = (sn + 1) & 0x0F;
+            count++;
+
+            if (!CAN_isotp_send_frame(session, frame, n + 1, timeout_ms)) {
+                return false;
+            }
+            sent += n;
+        }
+    }
+
+    return true;
+}
+
+uint16_t CAN_isotp_recv(can_isotp_t *session, void *data, uint16_t max, uint32_t timeout_ms)
+{
+    const uint64_t end_ms = sys_get_uptime_ms() + timeout_ms;
+    uint16_t len = 0;
+    bool pending = false;
+
+    if (!session || !data) {
+        return 0;
+    }
+
+    while (isotp_rx_done != session->rx_state) {
+        const uint64_t now_ms = sys_get_uptime_ms();
+        if (now_ms >= end_ms) {
+            return 0;
+        }
+
+        /* Drop the message if the sender stopped sending it */
+        if (isotp_rx_receiving == session->rx_state &&
+            ((uint32_t) now_ms - session->rx_last_ms) > CAN_ISOTP_TIMEOUT_MS) {
+            session->rx_state = isotp_rx_idle;
+        }
+
+        CAN_isotp_wait(session, session->rx_event, (end_ms - now_ms) > CAN_ISOTP_TIMEOUT_MS ?
+                                                    CAN_ISOTP_TIMEOUT_MS : (uint32_t) (end_ms - now_ms));
+    }
+
+    len = (session->rx_len > max) ? max : session->rx_len;
+    memcpy(data, session->rx_buffer, len);
+
+    /* Now that the message is read, accept the message that the sender is waiting to send */
+    taskENTER_CRITICAL();
+    {
+        session->rx_state = isotp_rx_idle;
+        pending = session->rx_ff_pending;
+        session->rx_ff_pending = false;
+    }
+    taskEXIT_CRITICAL();
+
+    if (pending) {
+        CAN_isotp_start_rx(session, session->rx_ff);
+    }
+
+    return len;
+}
+
+bool CAN_isotp_dispatch(can_t can, const can_msg_t *msg)
+{
+    can_isotp_t *s = NULL;
+
+    for (s = g_isotp_sessions; NULL != s; s = s->next) {
+        if (s->can == can && s->rx_id == msg->msg_id && s->is_29bit == !!msg->frame_fields.is_29bit) {
+            CAN_isotp_handle_frame(s, msg);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool CAN_isotp_service(can_t can, uint32_t timeout_ms)
+{
+    bool ok = false;
+
+    if (can < can_max && g_isotp_service_lock[can] &&
+        xSemaphoreTake(g_isotp_service_lock[can], OS_MS(timeout_ms)))
+    {
+        ok = CAN_isotp_service_locked(can, timeout_ms);
+        xSemaphoreGive(g_isotp_service_lock[can]);
+    }
+
+    return ok;
+}
+
+void CAN_isotp_set_rx_callback(can_isotp_rx_callback_t callback)
+{
+    g_isotp_rx_callback = callback;
+}
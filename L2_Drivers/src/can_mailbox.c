@@ -0,0 +1,181 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+#include <stddef.h>
+#include "can_mailbox.h"
+#include "LPC17xx.h"
+#include "lpc_sys.h"    // sys_get_uptime_ms()
+
+
+
+/// Semaphore bits of the FullCAN message (see the FullCAN chapter of the datasheet)
+enum {
+    fullcan_sem_read    = 0x0,  ///< Message was read by the software
+    fullcan_sem_writing = 0x1,  ///< Hardware is writing the message
+    fullcan_sem_new     = 0x3,  ///< Hardware wrote a new message
+};
+
+/// Number of times the snapshot is attempted while the hardware keeps writing the message
+#define CAN_MAILBOX_READ_TRIES  4
+
+/// @returns the key to sort the mailboxes in the order of the FullCAN entries
+static inline uint32_t CAN_mailbox_key(const can_mailbox_t *box)
+{
+    return ((uint32_t) box->can << 16) | box->id;
+}
+
+/// @returns the pointer to the FullCAN message, which is after the end of the filter table
+static inline volatile can_fullcan_msg_t* CAN_mailbox_get_msg(const can_mailbox_t *box)
+{
+    uint8_t *base = (uint8_t*) &(LPC_CANAF_RAM->mask[0]);
+    return ((volatile can_fullcan_msg_t*) (base + LPC_CANAF->ENDofTable)) + box->index;
+}
+
+
+
+bool CAN_mailbox_init(can_mailbox_t **boxes, uint16_t count)
+{
+    uint16_t index = CAN_fullcan_get_num_entries();
+    can_mailbox_t *pending = NULL;
+    uint32_t last_key = 0;
+    uint16_t n = 0;
+    uint16_t i = 0;
+    bool ok = true;
+
+    if (!boxes) {
+        return false;
+    }
+
+    /* Add the mailboxes in the ascending order of their keys, two entries at a time */
+    for (n = 0; ok && n < count; n++) {
+        can_mailbox_t *next = NULL;
+        for (i = 0; i < count; i++) {
+            const uint32_t key = CAN_mailbox_key(boxes[i]);
+            if ((0 == n || key > last_key) && (!next || key < CAN_mailbox_key(next))) {
+                next = boxes[i];
+            }
+        }
+
+        /* Duplicate keys or invalid mailboxes */
+        if (!next || next->id > 0x7FF) {
+            ok = false;
+            break;
+        }
+        last_key = CAN_mailbox_key(next);
+
+        next->index = index++;
+        next->rx_count = 0;
+        next->last_rx_ms = 0;
+        if (!pending) {
+            pending = next;
+        }
+        else {
+            ok = CAN_fullcan_add_entry(pending->can, CAN_gen_sid(pending->can, pending->id),
+                                       CAN_gen_sid(next->can, next->id));
+            pending = NULL;
+        }
+    }
+
+    /* Pair the last mailbox with a disabled entry */
+    if (ok && pending) {
+        ok = CAN_fullcan_add_entry(pending->can, CAN_gen_sid(pending->can, pending->id),
+                                   CAN_gen_sid(pending->can, 0xFFFF));
+    }
+
+    return ok;
+}
+
+bool CAN_mailbox_read(can_mailbox_t *box, can_data_t *data)
+{
+    volatile can_fullcan_msg_t *msg = NULL;
+    can_data_t copy;
+    uint8_t tries = 0;
+
+    if (!box) {
+        return false;
+    }
+
+    msg = CAN_mailbox_get_msg(box);
+    for (tries = 0; tries < CAN_MAILBOX_READ_TRIES; tries++) {
+        const uint32_t sem = msg->semphr;
+        if (fullcan_sem_writing == sem) {
+            continue;
+        }
+
+        /* Clear the semaphore bits, and if the hardware did not write them while
+         * we copied the data, then the data belongs to a single message.
+         */
+        msg->semphr = fullcan_sem_read;
+        copy.qword = msg->data.qword;
+        if (fullcan_sem_read != msg->semphr) {
+            continue;
+        }
+
+        if (fullcan_sem_new == sem) {
+            box->rx_count++;
+            box->last_rx_ms = (uint32_t) sys_get_uptime_ms();
+        }
+        if (data) {
+            *data = copy;
+        }
+        return (box->rx_count > 0);
+    }
+
+    return false;
+}
+
+uint32_t CAN_mailbox_get_age_ms(can_mailbox_t *box)
+{
+    if (!box || 0 == box->rx_count) {
+        return UINT32_MAX;
+    }
+    return (uint32_t) sys_get_uptime_ms() - box->last_rx_ms;
+}
+
+uint64_t CAN_signal_get_raw(const can_signal_t *signal, const can_data_t *data)
+{
+    const uint64_t mask = (signal->bit_len >= 64) ? UINT64_MAX : ((1ULL << signal->bit_len) - 1);
+    return (signal->start_bit >= 64) ? 0 : ((data->qword >> signal->start_bit) & mask);
+}
+
+int64_t CAN_signal_get_int(const can_signal_t *signal, const can_data_t *data)
+{
+    const uint64_t raw = CAN_signal_get_raw(signal, data);
+
+    /* Extend the sign bit of the signal */
+    if (signal->is_signed && signal->bit_len > 0 && signal->bit_len < 64 && (raw >> (signal->bit_len - 1)) & 1) {
+        return (int64_t) (raw | ~((1ULL << signal->bit_len) - 1));
+    }
+    return (int64_t) raw;
+}
+
+float CAN_signal_get_value(const can_signal_t *signal, const can_data_t *data)
+{
+    return ((float) CAN_signal_get_int(signal, data) * signal->scale) + signal->offset;
+}
+
+bool CAN_mailbox_get_signal(can_mailbox_t *box, const can_signal_t *signal, float *value)
+{
+    can_data_t data;
+
+    if (!signal || !value || !CAN_mailbox_read(box, &data)) {
+        return false;
+    }
+
+    *value = CAN_signal_get_value(signal, &data);
+    return true;
+}
@@ -1,146 +1,303 @@
-/*
- *     SocialLedge.com - Copyright (C) 2013
- *
- *     This file is part of free software framework for embedded processors.
- *     You can use it and/or distribute it as long as this copyright header
- *     remains unmodified.  The code is free for personal use and requires
- *     permission to use in a commercial product.
- *
- *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
- *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
- *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
- *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
- *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
- *
- *     You can reach the author of this software at :
- *          p r e e t . w i k i @ g m a i l . c o m
- */
-
-#include <stdlib.h>
-#include "eint.h"
-
-
-
-/// Linked list structure of EINTs (External interrupts)
-typedef struct eint3_entry {
-    uint32_t pin_mask;          ///< Port pin's concatenated pin-mask
-    void_func_t callback;       ///< Callback when interrupt occurs
-    struct eint3_entry* next;   ///< The pointer to the next entry
-} eint3_entry_t;
-
-/**
- * @{ Linked list of each ports' rising and falling edge interrupts
- */
-static eint3_entry_t *gp_port0_rising_list  = NULL;
-static eint3_entry_t *gp_port0_falling_list = NULL;
-static eint3_entry_t *gp_port2_rising_list  = NULL;
-static eint3_entry_t *gp_port2_falling_list = NULL;
-/** @} */
-
-
-
-/**
- * Goes through the linked list to find out which interrupt triggered, and makes the callback
- * @param [in] isr_bits_ptr   The pointer to the variable that contains interrupt status
- * @param [in] int_clr_ptr    The pointer to the register to clear the real interrupt
- * @param [in[ list_head_ptr  The linked list head pointer of the configured interrupts
- *
- * @note isr_bits_ptr are cleared if the callback was made.  If the bits are not cleared then
- *       the interrupt was set, and no callback was found.  This shouldn't happen though :)
- */
-static inline void handle_eint_list(uint32_t *isr_bits_ptr, volatile uint32_t *int_clr_ptr,
-                                    eint3_entry_t *list_head_ptr)
-{
-    eint3_entry_t *e = list_head_ptr;
-
-    /* Loop through our list to find which pin triggered this interrupt */
-    while (e && *isr_bits_ptr) {
-        /* If we find the pin, make the callback and clear the interrupt source*/
-        if (e->pin_mask & *isr_bits_ptr) {
-            (e->callback)();
-            *isr_bits_ptr &= ~(e->pin_mask);
-            *int_clr_ptr = e->pin_mask;
-        }
-        e = e->next;
-    };
-}
-
-/// Actual ISR Handler (mapped to startup file's interrupt vector function name)
-#ifdef __cplusplus
-extern "C" {
-#endif
-void EINT3_IRQHandler(void)
-{
-    /* Read all the ports' rising and falling isr status */
-    uint32_t p0_rising  = LPC_GPIOINT->IO0IntStatR;
-    uint32_t p0_falling = LPC_GPIOINT->IO0IntStatF;
-    uint32_t p2_rising  = LPC_GPIOINT->IO2IntStatR;
-    uint32_t p2_falling = LPC_GPIOINT->IO2IntStatF;
-
-    /* Go through each list to handle the ISR.
-     * This will clear the interrupt by writing either to IO0IntClr or IO2IntClr
-     */
-    handle_eint_list(&p0_rising,  &(LPC_GPIOINT->IO0IntClr), gp_port0_rising_list);
-    handle_eint_list(&p0_falling, &(LPC_GPIOINT->IO0IntClr), gp_port0_falling_list);
-    handle_eint_list(&p2_rising,  &(LPC_GPIOINT->IO2IntClr), gp_port2_rising_list);
-    handle_eint_list(&p2_falling, &(LPC_GPIOINT->IO2IntClr), gp_port2_falling_list);
-
-    /* In case interrupt handler not attached correctly, clear all interrupts here */
-    if (p0_rising || p0_falling) {
-        LPC_GPIOINT->IO0IntClr = 0xFFFFFFFF;
-    }
-    if (p2_rising || p2_falling) {
-        LPC_GPIOINT->IO2IntClr = 0xFFFFFFFF;
-    }
-}
-#ifdef __cplusplus
-}
-#endif
-
-
-
-/**
- * Enables a port pin interrupt by inserting entry to the linked list, and writing to the
- * enable register to enable the interrupt.
- *
- * @param [in] pin_number     0-31
- * @param [in] type           The type of the interrupt (rising or falling)
- * @param [in] func           The callback function.
- * @param [in] list_head_ptr  The pointer of the linked list to add the interrupt configuration to.
- * @param [in] int_en_reg_ptr The pointer of CPU register to enable the interrupt
- */
-static void eint3_enable(uint8_t pin_num, eint_intr_t type, void_func_t func,
-                         eint3_entry_t **list_head_ptr, volatile uint32_t *int_en_reg_ptr)
-{
-    const uint32_t pin_mask = (UINT32_C(1) << pin_num);
-    eint3_entry_t *e = NULL;
-
-    if (0 != pin_mask && NULL != func && NULL != (e = malloc(sizeof(*e))) )
-    {
-        /* Insert new entry at the head of the list */
-        e->callback = func;
-        e->pin_mask = pin_mask;
-        e->next = *list_head_ptr;
-        *list_head_ptr = e;
-
-        /* Enable the interrupt */
-        *int_en_reg_ptr |= e->pin_mask;
-
-        /* EINT3 shares pin interrupts with Port0 and Port2 */
-        NVIC_EnableIRQ(EINT3_IRQn);
-    }
-}
-
-void eint3_enable_port0(uint8_t pin_num, eint_intr_t type, void_func_t func)
-{
-    eint3_enable(pin_num, type, func,
-                 (eint_rising_edge == type) ? &gp_port0_rising_list : &gp_port0_falling_list,
-                 (eint_rising_edge == type) ? &(LPC_GPIOINT->IO0IntEnR) : &(LPC_GPIOINT->IO0IntEnF));
-}
-
-void eint3_enable_port2(uint8_t pin_num, eint_intr_t type, void_func_t func)
-{
-    eint3_enable(pin_num, type, func,
-                 (eint_rising_edge == type) ? &gp_port2_rising_list : &gp_port2_falling_list,
-                 (eint_rising_edge == type) ? &(LPC_GPIOINT->IO2IntEnR) : &(LPC_GPIOINT->IO2IntEnF));
-}
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <stdlib.h>
+#include "eint.h"
+#include "hw_timer.h"
+
+
+
+/// Number of ports with pin interrupts: port 0 and port 2
+#define EINT3_PORTS                 2
+
+/** @{ The registers of the pin interrupts of the port index (0 for port 0, 1 for port 2) */
+#define EINT3_EN_R(port)    (*((0 == (port)) ? &(LPC_GPIOINT->IO0IntEnR) : &(LPC_GPIOINT->IO2IntEnR)))
+#define EINT3_EN_F(port)    (*((0 == (port)) ? &(LPC_GPIOINT->IO0IntEnF) : &(LPC_GPIOINT->IO2IntEnF)))
+#define EINT3_CLR(port)     (*((0 == (port)) ? &(LPC_GPIOINT->IO0IntClr) : &(LPC_GPIOINT->IO2IntClr)))
+#define EINT3_PIN(port)     (((0 == (port)) ? LPC_GPIO0 : LPC_GPIO2)->FIOPIN)
+/** @} */
+
+/// @returns the highest pin of the bits, which must not be zero
+#define EINT3_HIGHEST_PIN(bits)     (31 - __builtin_clz(bits))
+
+/// The callbacks of each port, edge (eint_intr_t), and pin
+static void_func_t g_eint3_callbacks[EINT3_PORTS][2][32];
+
+/** @{ The debounced pins of each port */
+static uint32_t g_debounce_pins[EINT3_PORTS];           ///< The pins that are debounced
+static uint32_t g_debounce_busy[EINT3_PORTS];           ///< The pins waiting for the end of their debounce time
+static uint32_t g_debounce_level[EINT3_PORTS];          ///< The last stable level of the pins
+static uint32_t g_debounce_us[EINT3_PORTS][32];         ///< The debounce time of each pin
+static uint32_t g_debounce_end[EINT3_PORTS][32];        ///< The timer value at the end of the debounce time
+static hw_timer_t g_debounce_timer;                     ///< Expires at the first end of the debounce times
+static bool g_debounce_timer_init = false;              ///< Set once g_debounce_timer is initialized
+/** @} */
+
+/** @{ The debounce state is changed by the EINT3 and the timer service interrupts, which may preempt each other */
+static inline uint32_t eint3_lock(void)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+}
+static inline void eint3_unlock(const uint32_t primask)
+{
+    __set_PRIMASK(primask);
+}
+/** @} */
+
+
+
+/**
+ * Makes the callback of each pin of the bits
+ * @param [in] bits       The pins of the callbacks
+ * @param [in] callbacks  The callbacks of the pins of a port and an edge
+ */
+static inline void eint3_dispatch(uint32_t bits, void_func_t *callbacks)
+{
+    while (bits) {
+        const uint32_t pin = EINT3_HIGHEST_PIN(bits);
+        bits &= ~(UINT32_C(1) << pin);
+        if (callbacks[pin]) {
+            (callbacks[pin])();
+        }
+    }
+}
+
+/// Starts the debounce timer to the first end of the debounce times, or stops it
+static void eint3_debounce_schedule(const uint32_t now)
+{
+    int32_t next = INT32_MAX;
+    bool busy = false;
+
+    for (uint8_t port = 0; port < EINT3_PORTS; port++) {
+        uint32_t bits = g_debounce_busy[port];
+        while (bits) {
+            const uint32_t pin = EINT3_HIGHEST_PIN(bits);
+            const int32_t left = (int32_t) (g_debounce_end[port][pin] - now);
+            bits &= ~(UINT32_C(1) << pin);
+            next = (left < next) ? left : next;
+            busy = true;
+        }
+    }
+
+    if (busy) {
+        hw_timer_start(&g_debounce_timer, (next < 0) ? 0 : next, 0);
+    }
+    else {
+        hw_timer_stop(&g_debounce_timer);
+    }
+}
+
+/// Disables the interrupts of the pins until the end of their debounce time
+static void eint3_debounce_start(const uint8_t port, const uint32_t pins)
+{
+    const uint32_t primask = eint3_lock();
+    const uint32_t now = hw_timer_get_us();
+    uint32_t bits = pins;
+
+    EINT3_EN_R(port) &= ~pins;
+    EINT3_EN_F(port) &= ~pins;
+
+    while (bits) {
+        const uint32_t pin = EINT3_HIGHEST_PIN(bits);
+        bits &= ~(UINT32_C(1) << pin);
+        g_debounce_end[port][pin] = now + g_debounce_us[port][pin];
+    }
+
+    g_debounce_busy[port] |= pins;
+    eint3_debounce_schedule(now);
+    eint3_unlock(primask);
+}
+
+/**
+ * Ends the debounce time of the pins, and makes the callback of the pins that changed to the
+ * other level, which is the edge of the callback.
+ */
+static void eint3_debounce_end(const uint8_t port, const uint32_t pins)
+{
+    const uint32_t primask = eint3_lock();
+    const uint32_t level = EINT3_PIN(port) & pins;
+    const uint32_t changed = (level ^ g_debounce_level[port]) & pins;
+
+    g_debounce_busy[port] &= ~pins;
+    g_debounce_level[port] = (g_debounce_level[port] & ~pins) | level;
+
+    /* The debounced pins always interrupt on both edges to know the level */
+    EINT3_CLR(port) = pins;
+    EINT3_EN_R(port) |= pins;
+    EINT3_EN_F(port) |= pins;
+    eint3_unlock(primask);
+
+    eint3_dispatch(changed & level,  g_eint3_callbacks[port][eint_rising_edge]);
+    eint3_dispatch(changed & ~level, g_eint3_callbacks[port][eint_falling_edge]);
+
+    /* The pins that changed before their interrupts were enabled start over */
+    const uint32_t moved = (EINT3_PIN(port) & pins) ^ level;
+    if (moved) {
+        eint3_debounce_start(port, moved);
+    }
+}
+
+/**
+ * Makes the callbacks of the pending interrupts of a port, or starts the debounce time of the
+ * debounced pins.
+ * @param [in] port         The port index, 0 for port 0 and 1 for port 2
+ * @param [in] rising       The pending rising edge interrupts
+ * @param [in] falling      The pending falling edge interrupts
+ * @param [in] int_clr_ptr  The pointer to the register to clear the real interrupt
+ */
+static inline void eint3_handle_port(const uint8_t port, uint32_t rising, uint32_t falling,
+                                     volatile uint32_t *int_clr_ptr)
+{
+    const uint32_t debounced = (rising | falling) & g_debounce_pins[port];
+
+    /* Clear the interrupts first, so an edge during a callback interrupts again */
+    *int_clr_ptr = (rising | falling);
+
+    if (debounced) {
+        eint3_debounce_start(port, debounced);
+        rising  &= ~debounced;
+        falling &= ~debounced;
+    }
+
+    eint3_dispatch(rising,  g_eint3_callbacks[port][eint_rising_edge]);
+    eint3_dispatch(falling, g_eint3_callbacks[port][eint_falling_edge]);
+}
+
+/// Actual ISR Handler (mapped to startup file's interrupt vector function name)
+#ifdef __cplusplus
+extern "C" {
+#endif
+void EINT3_IRQHandler(void)
+{
+    /* Both ports are handled, each with one callback lookup for each pending pin */
+    if (LPC_GPIOINT->IntStatus & (1 << 0)) {
+        eint3_handle_port(0, LPC_GPIOINT->IO0IntStatR, LPC_GPIOINT->IO0IntStatF, &(LPC_GPIOINT->IO0IntClr));
+    }
+    if (LPC_GPIOINT->IntStatus & (1 << 2)) {
+        eint3_handle_port(1, LPC_GPIOINT->IO2IntStatR, LPC_GPIOINT->IO2IntStatF, &(LPC_GPIOINT->IO2IntClr));
+    }
+}
+#ifdef __cplusplus
+}
+#endif
+
+
+
+/// Callback of the debounce timer at the first end of the debounce times
+static void eint3_debounce_timer_callback(hw_timer_t *timer, void *arg)
+{
+    (void) timer;
+    (void) arg;
+
+    for (uint8_t port = 0; port < EINT3_PORTS; port++) {
+        const uint32_t now = hw_timer_get_us();
+        uint32_t bits = g_debounce_busy[port];
+        uint32_t done = 0;
+
+        while (bits) {
+            const uint32_t pin = EINT3_HIGHEST_PIN(bits);
+            bits &= ~(UINT32_C(1) << pin);
+            if ((int32_t) (g_debounce_end[port][pin] - now) <= 0) {
+                done |= (UINT32_C(1) << pin);
+            }
+        }
+        if (done) {
+            eint3_debounce_end(port, done);
+        }
+    }
+
+    const uint32_t primask = eint3_lock();
+    eint3_debounce_schedule(hw_timer_get_us());
+    eint3_unlock(primask);
+}
+
+/**
+ * Enables a port pin interrupt by setting its callback in the table, and writing to the
+ * enable register to enable the interrupt.
+ *
+ * @param [in] port         The port index, 0 for port 0 and 1 for port 2
+ * @param [in] pin_number   0-31
+ * @param [in] type         The type of the interrupt (rising or falling)
+ * @param [in] func         The callback function.
+ * @param [in] debounce_ms  The debounce time, or 0 if not debounced.
+ */
+static void eint3_enable(const uint8_t port, uint8_t pin_num, eint_intr_t type, void_func_t func,
+                         uint16_t debounce_ms)
+{
+    const uint32_t pin_mask = (UINT32_C(1) << pin_num);
+
+    if (pin_num >= 32 || NULL == func) {
+        return;
+    }
+    if (debounce_ms > 0 && !g_debounce_timer_init) {
+        hw_timer_init(&g_debounce_timer, eint3_debounce_timer_callback, NULL);
+        g_debounce_timer_init = true;
+    }
+
+    /* The interrupts use the table and the enable registers that we change here */
+    const uint32_t primask = eint3_lock();
+
+    g_eint3_callbacks[port][type][pin_num] = func;
+
+    if (debounce_ms > 0) {
+        g_debounce_us[port][pin_num] = (uint32_t) debounce_ms * 1000;
+        if (!(g_debounce_pins[port] & pin_mask)) {
+            g_debounce_pins[port] |= pin_mask;
+            g_debounce_level[port] = (g_debounce_level[port] & ~pin_mask) | (EINT3_PIN(port) & pin_mask);
+        }
+
+        /* Both edges are needed to know the level, unless it is waiting for its debounce time */
+        if (!(g_debounce_busy[port] & pin_mask)) {
+            EINT3_EN_R(port) |= pin_mask;
+            EINT3_EN_F(port) |= pin_mask;
+        }
+    }
+    else if (eint_rising_edge == type) {
+        EINT3_EN_R(port) |= pin_mask;
+    }
+    else {
+        EINT3_EN_F(port) |= pin_mask;
+    }
+
+    eint3_unlock(primask);
+
+    /* EINT3 shares pin interrupts with Port0 and Port2 */
+    NVIC_EnableIRQ(EINT3_IRQn);
+}
+
+void eint3_enable_port0(uint8_t pin_num, eint_intr_t type, void_func_t func)
+{
+    eint3_enable(0, pin_num, type, func, 0);
+}
+
+void eint3_enable_port2(uint8_t pin_num, eint_intr_t type, void_func_t func)
+{
+    eint3_enable(1, pin_num, type, func, 0);
+}
+
+void eint3_enable_port0_debounced(uint8_t pin_num, eint_intr_t type, void_func_t func, uint16_t debounce_ms)
+{
+    eint3_enable(0, pin_num, type, func, debounce_ms);
+}
+
+void eint3_enable_port2_debounced(uint8_t pin_num, eint_intr_t type, void_func_t func, uint16_t debounce_ms)
+{
+    eint3_enable(1, pin_num, type, func, debounce_ms);
+}
@@ -0,0 +1,218 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <stddef.h>
+#include "hw_timer.h"
+#include "lpc_timers.h"
+#include "lpc_isr.h"
+#include "lpc_sys.h"
+#include "sys_config.h"
+
+
+
+#if (SYS_CFG_HW_TIMER == SYS_CFG_SYS_TIMER) || (SYS_CFG_HW_TIMER == SYS_CFG_STEPPER_TIMER)
+#error "SYS_CFG_HW_TIMER cannot be the same timer as SYS_CFG_SYS_TIMER or SYS_CFG_STEPPER_TIMER"
+#endif
+
+/// Minimum time in microseconds to the next match to avoid missing the match
+#define HW_TIMER_MIN_MATCH_US       4
+
+/// MR0 interrupt bit of MCR and IR registers
+#define HW_TIMER_MR0_INTR           (1 << 0)
+
+static LPC_TIM_TypeDef *gp_timer = NULL;    ///< The timer of SYS_CFG_HW_TIMER
+static hw_timer_t *gp_head = NULL;          ///< The list of the active timers, sorted by the deadline
+
+
+
+/** @{ The list is also changed by the interrupt, and by the callers from any interrupt priority */
+static inline uint32_t hw_timer_lock(void)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+}
+static inline void hw_timer_unlock(const uint32_t primask)
+{
+    __set_PRIMASK(primask);
+}
+/** @} */
+
+/// @returns true if the deadline a is before the deadline b
+static inline bool hw_timer_before(const uint32_t a, const uint32_t b)
+{
+    return ((int32_t) (a - b) < 0);
+}
+
+/// Inserts the timer to the list after the timers with the same or earlier deadline
+static void hw_timer_insert(hw_timer_t *timer)
+{
+    hw_timer_t **pp = &gp_head;
+
+    while (NULL != *pp && !hw_timer_before(timer->deadline, (*pp)->deadline)) {
+        pp = &((*pp)->next);
+    }
+    timer->next = *pp;
+    *pp = timer;
+    timer->active = true;
+}
+
+/// Removes the timer from the list
+static void hw_timer_remove(hw_timer_t *timer)
+{
+    hw_timer_t **pp = &gp_head;
+
+    while (NULL != *pp && timer != *pp) {
+        pp = &((*pp)->next);
+    }
+    if (NULL != *pp) {
+        *pp = timer->next;
+    }
+    timer->next = NULL;
+    timer->active = false;
+}
+
+/// Sets the match register to the first deadline, or disables the match interrupt if no timer is active
+static void hw_timer_schedule(void)
+{
+    if (NULL == gp_head) {
+        gp_timer->MCR &= ~HW_TIMER_MR0_INTR;
+        return;
+    }
+
+    /* If the deadline is too close (or passed), the interrupt occurs right after it */
+    const uint32_t now = gp_timer->TC;
+    const uint32_t soonest = now + HW_TIMER_MIN_MATCH_US;
+    gp_timer->MR0 = hw_timer_before(gp_head->deadline, soonest) ? soonest : gp_head->deadline;
+    gp_timer->MCR |= HW_TIMER_MR0_INTR;
+}
+
+/**
+ * Actual ISR function (@see startup.cpp)
+ */
+#if (0 == SYS_CFG_HW_TIMER)
+void TIMER0_IRQHandler(void)
+#elif (1 == SYS_CFG_HW_TIMER)
+void TIMER1_IRQHandler(void)
+#elif (2 == SYS_CFG_HW_TIMER)
+void TIMER2_IRQHandler(void)
+#elif (3 == SYS_CFG_HW_TIMER)
+void TIMER3_IRQHandler(void)
+#else
+#error "SYS_CFG_HW_TIMER must be between 0-3 inclusively"
+void TIMERX_BAD_IRQHandler(void)
+#endif
+{
+    gp_timer->IR = HW_TIMER_MR0_INTR;
+
+    /* Run every timer that is due, including the ones that became due while the callbacks ran */
+    while (1)
+    {
+        const uint32_t primask = hw_timer_lock();
+        hw_timer_t *timer = gp_head;
+
+        if (NULL == timer || hw_timer_before(gp_timer->TC, timer->deadline)) {
+            hw_timer_schedule();
+            hw_timer_unlock(primask);
+            break;
+        }
+
+        gp_head = timer->next;
+        timer->next = NULL;
+        timer->active = false;
+        if (timer->period_us > 0) {
+            timer->deadline += timer->period_us;
+            hw_timer_insert(timer);
+        }
+        hw_timer_unlock(primask);
+
+        timer->callback(timer, timer->arg);
+    }
+}
+
+/// Keeps the timer at one microsecond when the CPU clock changes
+static void hw_timer_clock_changed(void *arg, unsigned int old_cpu_hz, unsigned int new_cpu_hz)
+{
+    (void) arg;
+    (void) old_cpu_hz;
+
+    gp_timer->PR = (new_cpu_hz / (1000 * 1000));
+    gp_timer->PC = 0;
+}
+
+void hw_timer_init(hw_timer_t *timer, hw_timer_callback_t callback, void *arg)
+{
+    const lpc_timer_t lpc_timer = (lpc_timer_t) SYS_CFG_HW_TIMER;
+
+    if (NULL == gp_timer) {
+        /* Free running timer with 1us resolution, and MR0 interrupt enabled only while a timer is active */
+        lpc_timer_enable(lpc_timer, 1);
+        gp_timer = lpc_timer_get_struct(lpc_timer);
+        gp_timer->MCR = 0;
+        gp_timer->IR = HW_TIMER_MR0_INTR;
+        sys_clock_add_listener(hw_timer_clock_changed, NULL);
+
+        NVIC_SetPriority(lpc_timer_get_irq_num(lpc_timer), IP_high);
+        NVIC_EnableIRQ(lpc_timer_get_irq_num(lpc_timer));
+    }
+
+    timer->next = NULL;
+    timer->deadline = 0;
+    timer->period_us = 0;
+    timer->callback = callback;
+    timer->arg = arg;
+    timer->active = false;
+}
+
+bool hw_timer_start(hw_timer_t *timer, uint32_t delay_us, uint32_t period_us)
+{
+    if (NULL == gp_timer || delay_us > HW_TIMER_MAX_US || period_us > HW_TIMER_MAX_US) {
+        return false;
+    }
+
+    const uint32_t primask = hw_timer_lock();
+    if (timer->active) {
+        hw_timer_remove(timer);
+    }
+    timer->deadline = gp_timer->TC + delay_us;
+    timer->period_us = period_us;
+    hw_timer_insert(timer);
+
+    /* Only a new first timer changes the match */
+    if (gp_head == timer) {
+        hw_timer_schedule();
+    }
+    hw_timer_unlock(primask);
+
+    return true;
+}
+
+void hw_timer_stop(hw_timer_t *timer)
+{
+    const uint32_t primask = hw_timer_lock();
+    if (timer->active) {
+        hw_timer_remove(timer);
+        hw_timer_schedule();
+    }
+    hw_timer_unlock(primask);
+}
+
+uint32_t hw_timer_get_us(void)
+{
+    return (NULL == gp_timer) ? 0 : gp_timer->TC;
+}
@@ -0,0 +1,288 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
+#include "lpc_dma.h"
+#include "lpc_sys.h"
+
+
+
+/** @{ Callback and its argument for each DMA channel */
+static dma_callback_t g_dma_callbacks[dma_ch_max] = { 0 };
+static void *g_dma_callback_args[dma_ch_max] = { 0 };
+/** @} */
+
+/// The bit of each channel that is claimed or allocated
+static uint8_t g_dma_used = 0;
+
+/**
+ * @{ The linked list items and the completion signal of each channel for dma_memcpy().
+ * The items are globals because GPDMA cannot access the task stacks (@see dma_is_accessible())
+ */
+static dma_lli_t g_dma_memcpy_lli[dma_ch_max][DMA_MEMCPY_MAX_LLI];
+static SemaphoreHandle_t g_dma_memcpy_done[dma_ch_max] = { 0 };
+static volatile bool g_dma_memcpy_error[dma_ch_max] = { 0 };
+/** @} */
+
+
+
+/** DMA Interrupt function (see startup.cpp) */
+void DMA_IRQHandler()
+{
+    const uint32_t tc_intr  = LPC_GPDMA->DMACIntTCStat;
+    const uint32_t err_intr = LPC_GPDMA->DMACIntErrStat;
+    uint32_t ch = 0;
+
+    LPC_GPDMA->DMACIntTCClear = tc_intr;
+    LPC_GPDMA->DMACIntErrClr  = err_intr;
+
+    for (ch = 0; ch < dma_ch_max; ch++)
+    {
+        const uint32_t mask = (1 << ch);
+        if ((tc_intr | err_intr) & mask)
+        {
+            if (g_dma_callbacks[ch]) {
+                g_dma_callbacks[ch](g_dma_callback_args[ch], !!(err_intr & mask));
+            }
+        }
+    }
+}
+
+void dma_init(void)
+{
+    const uint32_t dma_enable_bitmask = (1 << 0);
+
+    // Do not access the DMA registers before the DMA is powered up
+    if (!(LPC_SC->PCONP & (1 << pconp_gpdma)) || !(LPC_GPDMA->DMACConfig & dma_enable_bitmask))
+    {
+        // Power up and enable GPDMA
+        lpc_pconp(pconp_gpdma, true);
+        LPC_GPDMA->DMACConfig = dma_enable_bitmask;
+        while (!(LPC_GPDMA->DMACConfig & dma_enable_bitmask));
+    }
+}
+
+void dma_register_callback(const dma_ch_t ch, dma_callback_t cb, void *arg)
+{
+    if (ch >= dma_ch_max) {
+        return;
+    }
+
+    NVIC_DisableIRQ(DMA_IRQn);
+    g_dma_callbacks[ch] = cb;
+    g_dma_callback_args[ch] = arg;
+    NVIC_EnableIRQ(DMA_IRQn);
+}
+
+bool dma_channel_claim(const dma_ch_t ch)
+{
+    bool claimed = false;
+
+    if (ch < dma_ch_max) {
+        taskENTER_CRITICAL();
+        if (!(g_dma_used & (1 << ch))) {
+            g_dma_used |= (1 << ch);
+            claimed = true;
+        }
+        taskEXIT_CRITICAL();
+    }
+    return claimed;
+}
+
+dma_ch_t dma_channel_alloc(const dma_prio_t prio)
+{
+    dma_ch_t ch = dma_ch_max;
+    int i = 0;
+
+    taskENTER_CRITICAL();
+    for (i = 0; i < dma_ch_max; i++) {
+        const int n = (dma_prio_high == prio) ? i : (dma_ch_max - 1 - i);
+        if (!(g_dma_used & (1 << n))) {
+            g_dma_used |= (1 << n);
+            ch = (dma_ch_t) n;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return ch;
+}
+
+void dma_channel_free(const dma_ch_t ch)
+{
+    if (ch < dma_ch_max) {
+        dma_register_callback(ch, NULL, NULL);
+        taskENTER_CRITICAL();
+        g_dma_used &= ~(1 << ch);
+        taskEXIT_CRITICAL();
+    }
+}
+
+uint32_t dma_build_lli(dma_lli_t *pLli, uint32_t max_lli, uint32_t src, uint32_t dst,
+                       uint32_t num_units, uint32_t ctrl, uint32_t unit_size)
+{
+    uint32_t n = 0;
+
+    while (num_units > 0 && n < max_lli)
+    {
+        const uint32_t units = (num_units > DMA_CTRL_SIZE_MASK) ? DMA_CTRL_SIZE_MASK : num_units;
+        const uint32_t bytes = units * unit_size;
+
+        pLli[n].src  = src;
+        pLli[n].dst  = dst;
+        pLli[n].ctrl = units | ctrl;
+        pLli[n].next = NULL;
+        if (n > 0) {
+            pLli[n - 1].next = &pLli[n];
+        }
+
+        if (ctrl & DMA_CTRL_SRC_INCR) {
+            src += bytes;
+        }
+        if (ctrl & DMA_CTRL_DST_INCR) {
+            dst += bytes;
+        }
+        num_units -= units;
+        n++;
+    }
+
+    return n;
+}
+
+void dma_load_channel(const dma_ch_t ch, const dma_lli_t *pLli, uint32_t config)
+{
+    LPC_GPDMACH_TypeDef *pCh = dma_get_channel(ch);
+
+    pCh->DMACCSrcAddr  = pLli->src;
+    pCh->DMACCDestAddr = pLli->dst;
+    pCh->DMACCLLI      = (uint32_t) pLli->next;
+    pCh->DMACCControl  = pLli->ctrl;
+    pCh->DMACCConfig   = config;
+}
+
+bool dma_copy_start(const dma_ch_t ch, dma_lli_t *pLli, uint32_t max_lli,
+                    const dma_copy_t *pBlocks, uint32_t count, dma_callback_t cb, void *arg)
+{
+    uint32_t used = 0;
+    uint32_t i = 0;
+
+    if (ch >= dma_ch_max || dma_channel_busy(ch)) {
+        return false;
+    }
+
+    /* The items of each block are linked after the items of the previous block */
+    for (i = 0; i < count; i++) {
+        const uint32_t src = (uint32_t) pBlocks[i].src;
+        const uint32_t dst = (uint32_t) pBlocks[i].dst;
+        const bool words = (0 == ((src | dst | pBlocks[i].bytes) & 3));
+        const uint32_t width = words ? dma_width_32bit : dma_width_8bit;
+        const uint32_t unit_size = words ? 4 : 1;
+        const uint32_t ctrl = DMA_CTRL_SRC_BURST(dma_burst_4) | DMA_CTRL_DST_BURST(dma_burst_4) |
+                              DMA_CTRL_SRC_WIDTH(width) | DMA_CTRL_DST_WIDTH(width) |
+                              DMA_CTRL_SRC_INCR | DMA_CTRL_DST_INCR;
+        const uint32_t units = pBlocks[i].bytes / unit_size;
+
+        if (0 == units) {
+            continue;
+        }
+        if ((units + DMA_CTRL_SIZE_MASK - 1) / DMA_CTRL_SIZE_MASK > max_lli - used) {
+            return false;
+        }
+        const uint32_t n = dma_build_lli(&pLli[used], max_lli - used, src, dst, units, ctrl, unit_size);
+        if (used > 0) {
+            pLli[used - 1].next = &pLli[used];
+        }
+        used += n;
+    }
+    if (0 == used) {
+        return false;
+    }
+
+    /* Only the last item interrupts us */
+    pLli[used - 1].ctrl |= DMA_CTRL_TC_INTR;
+    dma_init();
+    dma_register_callback(ch, cb, arg);
+    dma_clear_intr(ch);
+    dma_load_channel(ch, pLli, DMA_CFG_M_TO_M | DMA_CFG_TC_INTR | DMA_CFG_ERR_INTR | DMA_CFG_ENABLE);
+
+    return true;
+}
+
+/// Callback of the channel of dma_memcpy(), the arg is the channel
+static void dma_memcpy_done(void *arg, bool error)
+{
+    const uint32_t ch = (uint32_t) arg;
+    long higherPriorityTaskWoken = 0;
+
+    g_dma_memcpy_error[ch] = error;
+    xSemaphoreGiveFromISR(g_dma_memcpy_done[ch], &higherPriorityTaskWoken);
+    portEND_SWITCHING_ISR(higherPriorityTaskWoken);
+}
+
+void dma_memcpy(void *dst, const void *src, uint32_t bytes)
+{
+    const uint32_t max_bytes = DMA_MEMCPY_MAX_LLI * DMA_CTRL_SIZE_MASK * 4;
+    const bool in_isr = !!(SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk);
+    dma_ch_t ch = dma_ch_max;
+
+    if (bytes < DMA_MEMCPY_MIN_BYTES || (((uint32_t) dst | (uint32_t) src | bytes) & 3) ||
+        !dma_is_accessible(dst) || !dma_is_accessible(src) ||
+        !dma_is_accessible((const char*) dst + bytes - 1) || !dma_is_accessible((const char*) src + bytes - 1) ||
+        in_isr || taskSCHEDULER_RUNNING != xTaskGetSchedulerState() ||
+        dma_ch_max == (ch = dma_channel_alloc(dma_prio_low)))
+    {
+        memcpy(dst, src, bytes);
+        return;
+    }
+
+    /* The channel is ours, so its signal is only created once by the first user of the channel */
+    if (NULL == g_dma_memcpy_done[ch]) {
+        g_dma_memcpy_done[ch] = xSemaphoreCreateBinary();
+    }
+
+    /* Each part is as large as the linked list items of the channel can copy */
+    while (bytes > 0) {
+        const uint32_t part = (bytes > max_bytes) ? max_bytes : bytes;
+        const dma_copy_t block = { dst, src, part };
+
+        if (NULL == g_dma_memcpy_done[ch] ||
+            !dma_copy_start(ch, &g_dma_memcpy_lli[ch][0], DMA_MEMCPY_MAX_LLI, &block, 1,
+                            dma_memcpy_done, (void*) (uint32_t) ch))
+        {
+            memcpy(dst, src, bytes);
+            break;
+        }
+        xSemaphoreTake(g_dma_memcpy_done[ch], portMAX_DELAY);
+
+        /* The bus error leaves the part incomplete, so the CPU copies it */
+        if (g_dma_memcpy_error[ch]) {
+            memcpy(dst, src, part);
+        }
+
+        dst = (char*) dst + part;
+        src = (const char*) src + part;
+        bytes -= part;
+    }
+
+    dma_channel_free(ch);
+}
@@ -1,93 +1,221 @@
-/*
- *     SocialLedge.com - Copyright (C) 2013
- *
- *     This file is part of free software framework for embedded processors.
- *     You can use it and/or distribute it as long as this copyright header
- *     remains unmodified.  The code is free for personal use and requires
- *     permission to use in a commercial product.
- *
- *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
- *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
- *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
- *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
- *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
- *
- *     You can reach the author of this software at :
- *          p r e e t . w i k i @ g m a i l . c o m
- */
-
-#include "lpc_pwm.hpp"
-#include "LPC17xx.h"
-#include "sys_config.h"
-
-
-
-/// Static variable of this class
-unsigned int PWM::msTcMax = 0;
-
-PWM::PWM(pwmType pwm, unsigned int frequencyHz) :
-    mPwm(pwm)
-{
-    /* Avoid divide by zero */
-    if (0 == frequencyHz) {
-        frequencyHz = 100;
-    }
-
-    if (0 == msTcMax) {
-        msTcMax = (sys_get_cpu_clock() / frequencyHz);
-
-        lpc_pconp(pconp_pwm1, true);
-        lpc_pclk(pclk_pwm1, clkdiv_1);
-
-        // Reset on PWMMR0: the PWMTC will be reset if PWMMR0 matches it.
-        LPC_PWM1->MCR |= (1 << 1);
-
-        // Suppose CPU = 48,000,000 (48Mhz)
-        // frequency desired = 50   (50Hz)
-        // PWM1MR0 will be ~ 960,000 to produce 50hz PWM
-        LPC_PWM1->MR0 = msTcMax;
-
-        LPC_PWM1->TCR = (1 << 0) | (1 << 3); // Enable PWM1
-        LPC_PWM1->CTCR &= ~(0xF << 0);
-    }
-
-    // Pinsel the PWM
-    LPC_PINCON->PINSEL4 &= ~(3 << (mPwm*2));
-    LPC_PINCON->PINSEL4 |=  (1 << (mPwm*2));
-
-    // Enable the PWM (bits 9-14)
-    LPC_PWM1->PCR |= (1 << (mPwm + 9));
-}
-
-PWM::~PWM()
-{
-    LPC_PWM1->PCR &= ~(1 << (mPwm + 9));
-    LPC_PINCON->PINSEL4 &= ~(3 << (mPwm*2));
-}
-
-bool PWM::set(float percent)
-{
-    if(percent > 100) {
-        return false;
-    }
-
-    // Get the value from the percent
-    // If percent = 50, mTcMax = 1000, then value will be 50*1000 / 100 = 500
-    const unsigned int valueNeeded = (percent * msTcMax) / 100;
-
-    switch(mPwm)
-    {
-        /* No tricks here, MR1-MR6 are not contiguous memory location */
-        case pwm1: LPC_PWM1->MR1 = valueNeeded;  break;
-        case pwm2: LPC_PWM1->MR2 = valueNeeded;  break;
-        case pwm3: LPC_PWM1->MR3 = valueNeeded;  break;
-        case pwm4: LPC_PWM1->MR4 = valueNeeded;  break;
-        case pwm5: LPC_PWM1->MR5 = valueNeeded;  break;
-        case pwm6: LPC_PWM1->MR6 = valueNeeded;  break;
-        default : return false;
-    }
-
-    // Enable the latch
-    LPC_PWM1->LER |= (1 << (mPwm+1));
-    return true;
-}
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include "lpc_pwm.hpp"
+#include "LPC17xx.h"
+#include "sys_config.h"
+
+
+
+/// Static variable of this class
+unsigned int PWM::msTcMax = 0;
+
+/** @{ The sequence of startSequence() */
+const PWM::pwmType *PWM::mspSeqChannels = 0;
+const uint32_t *PWM::mspSeqDuties = 0;
+uint32_t PWM::msSeqSteps = 0;
+volatile uint32_t PWM::msSeqStep = 0;
+uint8_t PWM::msSeqCount = 0;
+bool PWM::msSeqLoop = false;
+volatile bool PWM::msSeqRunning = false;
+/** @} */
+
+/// The MR0 interrupt at the start of each period
+#define PWM_MR0_INTR    (1 << 0)
+
+PWM::PWM(pwmType pwm, unsigned int frequencyHz) :
+    mPwm(pwm)
+{
+    /* Avoid divide by zero */
+    if (0 == frequencyHz) {
+        frequencyHz = 100;
+    }
+
+    if (0 == msTcMax) {
+        msTcMax = (sys_get_cpu_clock() / frequencyHz);
+
+        lpc_pconp(pconp_pwm1, true);
+        lpc_pclk(pclk_pwm1, clkdiv_1);
+
+        // Reset on PWMMR0: the PWMTC will be reset if PWMMR0 matches it.
+        LPC_PWM1->MCR |= (1 << 1);
+
+        // Suppose CPU = 48,000,000 (48Mhz)
+        // frequency desired = 50   (50Hz)
+        // PWM1MR0 will be ~ 960,000 to produce 50hz PWM
+        LPC_PWM1->MR0 = msTcMax;
+
+        LPC_PWM1->TCR = (1 << 0) | (1 << 3); // Enable PWM1
+        LPC_PWM1->CTCR &= ~(0xF << 0);
+    }
+
+    // Pinsel the PWM
+    LPC_PINCON->PINSEL4 &= ~(3 << (mPwm*2));
+    LPC_PINCON->PINSEL4 |=  (1 << (mPwm*2));
+
+    // Enable the PWM (bits 9-14)
+    LPC_PWM1->PCR |= (1 << (mPwm + 9));
+}
+
+PWM::~PWM()
+{
+    LPC_PWM1->PCR &= ~(1 << (mPwm + 9));
+    LPC_PINCON->PINSEL4 &= ~(3 << (mPwm*2));
+}
+
+volatile uint32_t* PWM::getMatchReg(pwmType pwm)
+{
+    switch(pwm)
+    {
+        /* No tricks here, MR1-MR6 are not contiguous memory location */
+        case pwm1: return &(LPC_PWM1->MR1);
+        case pwm2: return &(LPC_PWM1->MR2);
+        case pwm3: return &(LPC_PWM1->MR3);
+        case pwm4: return &(LPC_PWM1->MR4);
+        case pwm5: return &(LPC_PWM1->MR5);
+        case pwm6: return &(LPC_PWM1->MR6);
+        default : return 0;
+    }
+}
+
+void PWM::load(const pwmType *pChannels, const uint32_t *pDuty, uint8_t count)
+{
+    uint32_t latch = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        *getMatchReg(pChannels[i]) = dutyToTicks(pDuty[i]);
+        latch |= (1 << (pChannels[i] + 1));
+    }
+
+    // Enable the latch of all the channels at once
+    LPC_PWM1->LER = latch;
+}
+
+bool PWM::set(float percent)
+{
+    if(percent < 0 || percent > 100) {
+        return false;
+    }
+
+    // Get the 16-bit fraction from the percent
+    // If percent = 50, then duty will be 50 * 65536 / 100 = 32768
+    return setDuty((uint32_t) ((percent * PWM_DUTY_MAX) / 100));
+}
+
+bool PWM::setPercentX100(uint32_t percentX100)
+{
+    if (percentX100 > 100 * 100) {
+        return false;
+    }
+
+    // The largest product is 10000 * 65536, which fits in 32 bits
+    return setDuty((percentX100 * PWM_DUTY_MAX) / (100 * 100));
+}
+
+bool PWM::setDuty(uint32_t duty)
+{
+    return setGroup(&mPwm, &duty, 1);
+}
+
+bool PWM::setPulseUs(uint32_t us)
+{
+    // The PWM clock is the CPU clock, so there are (cpu / 1000000) ticks per microsecond
+    const uint64_t ticks = (uint64_t) us * (sys_get_cpu_clock() / (1000 * 1000));
+    if (0 == msTcMax || ticks > msTcMax) {
+        return false;
+    }
+
+    return setDuty((uint32_t) ((ticks << 16) / msTcMax));
+}
+
+bool PWM::setGroup(const pwmType *pChannels, const uint32_t *pDuty, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++) {
+        if (pDuty[i] > PWM_DUTY_MAX || 0 == getMatchReg(pChannels[i])) {
+            return false;
+        }
+    }
+
+    load(pChannels, pDuty, count);
+    return true;
+}
+
+bool PWM::startSequence(const pwmType *pChannels, uint8_t count,
+                        const uint32_t *pDuties, uint32_t steps, bool loop)
+{
+    if (msSeqRunning || 0 == msTcMax || 0 == count || 0 == steps) {
+        return false;
+    }
+    for (uint32_t i = 0; i < (uint32_t) count * steps; i++) {
+        if (pDuties[i] > PWM_DUTY_MAX || (i < count && 0 == getMatchReg(pChannels[i]))) {
+            return false;
+        }
+    }
+
+    mspSeqChannels = pChannels;
+    mspSeqDuties = pDuties;
+    msSeqSteps = steps;
+    msSeqCount = count;
+    msSeqLoop = loop;
+    msSeqStep = 0;
+    msSeqRunning = true;
+
+    /* The first row starts at the next period, and the MR0 interrupt loads each next row */
+    load(pChannels, pDuties, count);
+    msSeqStep = 1;
+    LPC_PWM1->IR = PWM_MR0_INTR;
+    LPC_PWM1->MCR |= (1 << 0);
+    NVIC_EnableIRQ(PWM1_IRQn);
+    return true;
+}
+
+void PWM::stopSequence(void)
+{
+    LPC_PWM1->MCR &= ~(1 << 0);
+    msSeqRunning = false;
+}
+
+bool PWM::isSequenceRunning(void)
+{
+    return msSeqRunning;
+}
+
+void PWM::sequenceIsr(void)
+{
+    LPC_PWM1->IR = PWM_MR0_INTR;
+
+    /* The row loaded from the last interrupt was latched at the start of this period */
+    if (msSeqStep >= msSeqSteps) {
+        if (!msSeqLoop) {
+            stopSequence();
+            return;
+        }
+        msSeqStep = 0;
+    }
+
+    load(mspSeqChannels, &mspSeqDuties[msSeqStep * msSeqCount], msSeqCount);
+    ++msSeqStep;
+}
+
+/**
+ * Actual ISR function (@see startup.cpp)
+ */
+extern "C" void PWM1_IRQHandler()
+{
+    PWM::sequenceIsr();
+}
@@ -1,103 +1,487 @@
-/*
- *     SocialLedge.com - Copyright (C) 2013
- *
- *     This file is part of free software framework for embedded processors.
- *     You can use it and/or distribute it as long as this copyright header
- *     remains unmodified.  The code is free for personal use and requires
- *     permission to use in a commercial product.
- *
- *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
- *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
- *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
- *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
- *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
- *
- *     You can reach the author of this software at :
- *          p r e e t . w i k i @ g m a i l . c o m
- */
-
-#include <string.h>
-
-#include "nrf_stream.hpp"
-#include "wireless.h"
-
-
-
-/// The default hops to use unless set by the user
-#define NRF_DEFAULT_HOPS        3
-
-
-
-NordicStream::NordicStream(void) : mDestAddr(0), mHops(NRF_DEFAULT_HOPS)
-{
-    memset(&mRxBuffer, 0, sizeof(mRxBuffer));
-    memset(&mTxBuffer, 0, sizeof(mTxBuffer));
-
-    /* We just rely on the mesh network algorithm to make sure that it delivers
-     * our packet, rather than handle the retry ourselves because if we retry
-     * ourselves, the other node may get duplicate packets whereas the mesh
-     * algorithm handles duplicates.  This seems to work fairly well in tests.
-     */
-    mesh_set_retry_count(MESH_RETRY_COUNT_MAX);
-}
-
-bool NordicStream::getChar(char* pInputChar, unsigned int timeout)
-{
-    bool dataAvailable = (mRxBuffer.dataPtr < mRxBuffer.pkt.info.data_len);
-
-    /* If no buffered data, then try to get new packet from nordic wireless */
-    if (!dataAvailable) {
-        if (wireless_get_rx_pkt(&(mRxBuffer.pkt), timeout)) {
-            mRxBuffer.dataPtr = 0;
-            dataAvailable = (mRxBuffer.dataPtr < mRxBuffer.pkt.info.data_len);
-        }
-    }
-
-    if (dataAvailable) {
-        *pInputChar = mRxBuffer.pkt.data[mRxBuffer.dataPtr++];
-    }
-
-    return dataAvailable;
-}
-
-bool NordicStream::putChar(char out, unsigned int timeout)
-{
-    bool ok = true;
-
-    /* Buffer the data */
-    mTxBuffer.pkt.data[mTxBuffer.dataPtr++] = out;
-
-    /* If buffer is full, flush the data */
-    if (mTxBuffer.dataPtr >= MESH_DATA_PAYLOAD_SIZE) {
-        ok = flush();
-    }
-
-    /* Always need to return true, otherwise CharDev class will halt printing further data */
-    ok = true;
-    return ok;
-}
-
-bool NordicStream::flush(void)
-{
-    bool ok = false;
-    mesh_packet_t ackPkt;
-
-    /* If destination address is not set, use the last source as destination */
-    const uint8_t dst = (0 == mDestAddr) ? mRxBuffer.pkt.nwk.src : mDestAddr;
-    const uint32_t ackTimeoutMs = mesh_get_max_timeout_before_packet_fails(dst);
-
-    void *data = &(mTxBuffer.pkt.data[0]);
-    uint8_t len = mTxBuffer.dataPtr;
-    mTxBuffer.dataPtr = 0;
-
-    /* Send the packet and wait for the ACK */
-    if ((ok = wireless_send(dst, mesh_pkt_ack, data, len, mHops)))
-    {
-        if ((ok = wireless_get_ack_pkt(&ackPkt, ackTimeoutMs)))
-        {
-            ok = mesh_is_ack_ok(&ackPkt, dst);
-        }
-    }
-
-    return ok;
-}
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "nrf_stream.hpp"
+#include "wireless.h"
+
+
+
+/// The default hops to use unless set by the user
+#define NRF_DEFAULT_HOPS        3
+
+
+
+NordicStream::NordicStream(void) : mDestAddr(0), mHops(NRF_DEFAULT_HOPS),
+        mWindow(1), mTxSeq(0), mRxSeq(0), mRxHeld(0), mFailed(0),
+        mTxLock(xSemaphoreCreateMutex()), mIdleTimer(NULL), mIdleTicks(0), mLastWriteTick(0),
+        mFlushOnNewline(false)
+{
+    memset(&mRxBuffer, 0, sizeof(mRxBuffer));
+    memset(&mTxBuffer, 0, sizeof(mTxBuffer));
+    memset(&mTxWindow[0], 0, sizeof(mTxWindow));
+    memset(&mRxWindow[0], 0, sizeof(mRxWindow));
+
+    /* We just rely on the mesh network algorithm to make sure that it delivers
+     * our packet, rather than handle the retry ourselves because if we retry
+     * ourselves, the other node may get duplicate packets whereas the mesh
+     * algorithm handles duplicates.  This seems to work fairly well in tests.
+     */
+    mesh_set_retry_count(MESH_RETRY_COUNT_MAX);
+}
+
+bool NordicStream::setWindow(uint8_t window)
+{
+    if (window < 1 || window > NRF_STREAM_WINDOW_MAX) {
+        return false;
+    }
+
+    xSemaphoreTake(mTxLock, portMAX_DELAY);
+    (void) sendBuffered(true);
+    mWindow = window;
+    mTxSeq = 0;
+    mRxSeq = 0;
+    mRxHeld = 0;
+    memset(&mTxWindow[0], 0, sizeof(mTxWindow));
+    mTxBuffer.dataPtr = getDataStart();
+    mRxBuffer.dataPtr = mRxBuffer.pkt.info.data_len;
+    xSemaphoreGive(mTxLock);
+    return true;
+}
+
+bool NordicStream::receive(unsigned int timeout)
+{
+    if (mWindow > 1) {
+        return receiveWindowed(timeout);
+    }
+
+    if (wireless_get_rx_pkt(&(mRxBuffer.pkt), timeout)) {
+        mRxBuffer.dataPtr = 0;
+        return true;
+    }
+    return false;
+}
+
+bool NordicStream::getChar(char* pInputChar, unsigned int timeout)
+{
+    bool dataAvailable = (mRxBuffer.dataPtr < mRxBuffer.pkt.info.data_len);
+
+    /* If no buffered data, then try to get new packet from nordic wireless */
+    if (!dataAvailable) {
+        if (receive(timeout)) {
+            dataAvailable = (mRxBuffer.dataPtr < mRxBuffer.pkt.info.data_len);
+        }
+    }
+
+    if (dataAvailable) {
+        *pInputChar = mRxBuffer.pkt.data[mRxBuffer.dataPtr++];
+    }
+
+    return dataAvailable;
+}
+
+bool NordicStream::putChar(char out, unsigned int timeout)
+{
+    return putBlock(&out, 1, timeout);
+}
+
+bool NordicStream::putBlock(const void* pData, size_t len, unsigned int timeout)
+{
+    const char *pChars = (const char*) pData;
+    const TickType_t startTick = xTaskGetTickCount();
+    bool ok = true;
+
+    if (!pData) {
+        return false;
+    }
+
+    xSemaphoreTake(mTxLock, portMAX_DELAY);
+
+    /* Copy as much data as we can fit in the packet, and send the packet when it is full */
+    while (len > 0)
+    {
+        /* In the windowed mode, a full payload stays buffered until there is room in the window */
+        if (mTxBuffer.dataPtr >= MESH_DATA_PAYLOAD_SIZE &&
+            !sendWindowed(getRemainingTimeout(startTick, timeout))) {
+            ok = false;
+            break;
+        }
+
+        size_t chunk = MESH_DATA_PAYLOAD_SIZE - mTxBuffer.dataPtr;
+        if (chunk > len) {
+            chunk = len;
+        }
+
+        /* Send the data up to the newline */
+        const char *pNewline = mFlushOnNewline ? (const char*) memchr(pChars, '\n', chunk) : NULL;
+        if (pNewline) {
+            chunk = (pNewline - pChars) + 1;
+        }
+
+        memcpy(&(mTxBuffer.pkt.data[mTxBuffer.dataPtr]), pChars, chunk);
+        mTxBuffer.dataPtr += chunk;
+        pChars += chunk;
+        len -= chunk;
+
+        if (mTxBuffer.dataPtr >= MESH_DATA_PAYLOAD_SIZE || pNewline) {
+            if (mWindow > 1) {
+                (void) sendWindowed(pNewline ? getRemainingTimeout(startTick, timeout) : 0);
+            }
+            else {
+                (void) sendBuffered(true);
+            }
+        }
+    }
+
+    /* The idle timer sends the rest of the data unless more data is written */
+    mLastWriteTick = xTaskGetTickCount();
+    if (mIdleTimer && mIdleTicks > 0 && !xTimerIsTimerActive(mIdleTimer) &&
+        (mTxBuffer.dataPtr > getDataStart() || mWindow > 1)) {
+        xTimerChangePeriod(mIdleTimer, mIdleTicks, 0);
+    }
+
+    xSemaphoreGive(mTxLock);
+
+    /* Unless the window is full, we need to return true, otherwise CharDev class will halt printing further data */
+    return ok;
+}
+
+bool NordicStream::getBlock(void* pData, size_t len, unsigned int timeout)
+{
+    char *pChars = (char*) pData;
+    const TickType_t startTick = xTaskGetTickCount();
+
+    if (!pData) {
+        return false;
+    }
+
+    while (len > 0)
+    {
+        /* If no buffered data, then try to get new packet from nordic wireless */
+        if (mRxBuffer.dataPtr >= mRxBuffer.pkt.info.data_len)
+        {
+            if (!receive(getRemainingTimeout(startTick, timeout))) {
+                return false;
+            }
+            continue;
+        }
+
+        /* Copy as much data as we can from the buffered packet */
+        size_t chunk = mRxBuffer.pkt.info.data_len - mRxBuffer.dataPtr;
+        if (chunk > len) {
+            chunk = len;
+        }
+
+        memcpy(pChars, &(mRxBuffer.pkt.data[mRxBuffer.dataPtr]), chunk);
+        mRxBuffer.dataPtr += chunk;
+        pChars += chunk;
+        len -= chunk;
+    }
+
+    return true;
+}
+
+bool NordicStream::flush(void)
+{
+    xSemaphoreTake(mTxLock, portMAX_DELAY);
+    const bool ok = sendBuffered(true);
+    xSemaphoreGive(mTxLock);
+
+    return ok;
+}
+
+bool NordicStream::setCoalescing(uint32_t idleMs, bool newline)
+{
+    xSemaphoreTake(mTxLock, portMAX_DELAY);
+
+    mFlushOnNewline = newline;
+    mIdleTicks = OS_MS(idleMs);
+    if (0 == idleMs) {
+        if (mIdleTimer) {
+            xTimerStop(mIdleTimer, 0);
+        }
+    }
+    else {
+        if (mIdleTicks < 1) {
+            mIdleTicks = 1;
+        }
+        if (!mIdleTimer) {
+            mIdleTimer = xTimerCreate("nrf_idle", mIdleTicks, pdFALSE, NULL, idleTimerCallback);
+        }
+    }
+
+    xSemaphoreGive(mTxLock);
+    return (0 == idleMs || NULL != mIdleTimer);
+}
+
+void NordicStream::idleTimerCallback(TimerHandle_t timer)
+{
+    NordicStream &n = NordicStream::getInstance();
+    TickType_t wait = n.mIdleTicks;
+
+    /* If a write holds the lock, it starts the timer again if needed */
+    if (!xSemaphoreTake(n.mTxLock, 0)) {
+        if (wait > 0) {
+            xTimerChangePeriod(timer, wait, 0);
+        }
+        return;
+    }
+
+    const TickType_t idle = xTaskGetTickCount() - n.mLastWriteTick;
+    if (0 == n.mIdleTicks) {
+        wait = 0;
+    }
+    else if (idle < n.mIdleTicks) {
+        wait = n.mIdleTicks - idle;
+    }
+    else {
+        /* This cannot block the timer task, so it does not wait for the ACKs */
+        (void) n.sendBuffered(false);
+
+        /* Handle the ACKs of the payloads in flight, and send them again if they time out */
+        bool inFlight = false;
+        if (n.mWindow > 1) {
+            while (n.waitForAck(0)) {
+                ;
+            }
+            for (uint8_t i = 0; i < n.mWindow; i++) {
+                inFlight = inFlight || n.mTxWindow[i].busy;
+            }
+        }
+
+        if (n.mTxBuffer.dataPtr <= n.getDataStart() && !inFlight) {
+            wait = 0;
+        }
+    }
+
+    xSemaphoreGive(n.mTxLock);
+
+    if (wait > 0) {
+        xTimerChangePeriod(timer, wait, 0);
+    }
+}
+
+bool NordicStream::sendBuffered(bool wait)
+{
+    bool ok = false;
+    mesh_packet_t pkt;
+
+    /* Send the partial payload, and wait until every payload in flight is ACKed or failed */
+    if (mWindow > 1) {
+        const uint32_t failed = mFailed;
+        if (mTxBuffer.dataPtr <= getDataStart()) {
+            ok = true;
+        }
+        else {
+            ok = sendWindowed(wait ? portMAX_DELAY : 0);
+        }
+
+        for (uint8_t i = 0; wait && i < mWindow; i++) {
+            while (mTxWindow[i].busy) {
+                (void) waitForAck(portMAX_DELAY);
+            }
+        }
+        return ok && (failed == mFailed);
+    }
+
+    if (0 == mTxBuffer.dataPtr) {
+        return true;
+    }
+
+    /* If destination address is not set, use the last source as destination */
+    const uint8_t dst = getDest();
+    const uint32_t ackTimeoutMs = mesh_get_max_timeout_before_packet_fails(dst);
+    const TickType_t startTick = xTaskGetTickCount();
+
+    const uint8_t len = mTxBuffer.dataPtr;
+    mTxBuffer.dataPtr = 0;
+
+    /* Send the packet and wait for the ACK */
+    if ((ok = wireless_form_pkt(&pkt, dst, mesh_pkt_ack, mHops, 1, &(mTxBuffer.pkt.data[0]), len) &&
+              wireless_send_formed_pkt(&pkt)) && wait)
+    {
+        /* The ACKs of the payloads sent without waiting may still be queued, so they are skipped */
+        mesh_packet_t ackPkt;
+        const uint8_t seq = pkt.info.pkt_seq_num;
+        ok = false;
+        while (!ok && wireless_get_ack_pkt(&ackPkt, getRemainingTimeout(startTick, OS_MS(ackTimeoutMs)))) {
+            ok = (seq == ackPkt.info.pkt_seq_num && mesh_is_ack_ok(&ackPkt, dst));
+        }
+    }
+
+    return ok;
+}
+
+bool NordicStream::sendSlot(nrfTxSlot_t *pSlot)
+{
+    /* A new mesh sequence number is used so the ACK of an earlier send is not mistaken for this one */
+    uint8_t data[MESH_DATA_PAYLOAD_SIZE];
+    const uint8_t dst = pSlot->pkt.nwk.dst;
+    memcpy(data, &(pSlot->pkt.data[0]), pSlot->len);
+
+    pSlot->sentTick = xTaskGetTickCount();
+    return (wireless_form_pkt(&(pSlot->pkt), dst, mesh_pkt_ack, mHops, 1, data, pSlot->len) &&
+            wireless_send_formed_pkt(&(pSlot->pkt)));
+}
+
+bool NordicStream::waitForAck(unsigned int timeout)
+{
+    bool freed = false;
+    mesh_packet_t ackPkt;
+    TickType_t wait = timeout;
+    const TickType_t now = xTaskGetTickCount();
+
+    /* Wait no longer than the first payload in flight that times out */
+    for (uint8_t i = 0; i < mWindow; i++) {
+        const nrfTxSlot_t *pSlot = &mTxWindow[i];
+        if (pSlot->busy) {
+            const TickType_t ackTicks = OS_MS(mesh_get_max_timeout_before_packet_fails(pSlot->pkt.nwk.dst));
+            const TickType_t elapsed = now - pSlot->sentTick;
+            const TickType_t left = (elapsed >= ackTicks) ? 0 : (ackTicks - elapsed);
+            if (left < wait) {
+                wait = left;
+            }
+        }
+    }
+
+    if (wireless_get_ack_pkt(&ackPkt, wait)) {
+        for (uint8_t i = 0; i < mWindow; i++) {
+            nrfTxSlot_t *pSlot = &mTxWindow[i];
+            if (pSlot->busy && ackPkt.info.pkt_seq_num == pSlot->pkt.info.pkt_seq_num &&
+                mesh_is_ack_ok(&ackPkt, pSlot->pkt.nwk.dst)) {
+                pSlot->busy = false;
+                freed = true;
+                break;
+            }
+        }
+    }
+
+    /* Send the payloads that timed out again, or give up on them */
+    for (uint8_t i = 0; i < mWindow; i++) {
+        nrfTxSlot_t *pSlot = &mTxWindow[i];
+        if (pSlot->busy) {
+            const TickType_t ackTicks = OS_MS(mesh_get_max_timeout_before_packet_fails(pSlot->pkt.nwk.dst));
+            if ((xTaskGetTickCount() - pSlot->sentTick) < ackTicks) {
+                continue;
+            }
+            if (pSlot->retries > 0) {
+                pSlot->retries--;
+                (void) sendSlot(pSlot);
+            }
+            else {
+                pSlot->busy = false;
+                freed = true;
+                ++mFailed;
+            }
+        }
+    }
+
+    return freed;
+}
+
+bool NordicStream::sendWindowed(unsigned int timeout)
+{
+    const TickType_t startTick = xTaskGetTickCount();
+    nrfTxSlot_t *pSlot = NULL;
+
+    if (mWindow <= 1) {
+        return false;
+    }
+
+    while (NULL == pSlot)
+    {
+        for (uint8_t i = 0; i < mWindow && NULL == pSlot; i++) {
+            if (!mTxWindow[i].busy) {
+                pSlot = &mTxWindow[i];
+            }
+        }
+
+        if (NULL == pSlot) {
+            const unsigned int remaining = getRemainingTimeout(startTick, timeout);
+            if (!waitForAck(remaining) && 0 == remaining) {
+                return false;
+            }
+        }
+    }
+
+    /* The first data byte is the stream sequence number */
+    mTxBuffer.pkt.data[0] = mTxSeq++;
+    memcpy(&(pSlot->pkt.data[0]), &(mTxBuffer.pkt.data[0]), mTxBuffer.dataPtr);
+    pSlot->pkt.nwk.dst = getDest();
+    pSlot->len = mTxBuffer.dataPtr;
+    pSlot->retries = NRF_STREAM_RETRIES;
+    pSlot->busy = true;
+    mTxBuffer.dataPtr = getDataStart();
+
+    /* If the send fails, the payload is sent again once its ACK times out */
+    (void) sendSlot(pSlot);
+    return true;
+}
+
+bool NordicStream::receiveWindowed(unsigned int timeout)
+{
+    const TickType_t startTick = xTaskGetTickCount();
+    mesh_packet_t pkt;
+
+    while (1)
+    {
+        /* Deliver the next payload if it was received early */
+        const uint8_t idx = mRxSeq % NRF_STREAM_WINDOW_MAX;
+        if ((mRxHeld & (1 << idx)) && mRxSeq == mRxWindow[idx].data[0]) {
+            mRxHeld &= ~(1 << idx);
+            mRxBuffer.pkt = mRxWindow[idx];
+            mRxBuffer.dataPtr = 1;
+            mRxSeq++;
+            return true;
+        }
+
+        if (!wireless_get_rx_pkt(&pkt, getRemainingTimeout(startTick, timeout))) {
+            return false;
+        }
+        if (pkt.info.data_len < 1) {
+            continue;
+        }
+
+        const uint8_t seq = pkt.data[0];
+        const uint8_t diff = seq - mRxSeq;
+
+        if (diff >= 128) {
+            /* A duplicate of a payload we already delivered, whose ACK was lost */
+            continue;
+        }
+        else if (diff > 0 && diff < NRF_STREAM_WINDOW_MAX) {
+            /* Hold the payload until the payloads before it arrive */
+            mRxWindow[seq % NRF_STREAM_WINDOW_MAX] = pkt;
+            mRxHeld |= (1 << (seq % NRF_STREAM_WINDOW_MAX));
+            continue;
+        }
+        else if (0 != diff) {
+            /* The sender started over, or we lost more than the window, so start from this payload */
+            mRxHeld = 0;
+        }
+
+        mRxBuffer.pkt = pkt;
+        mRxBuffer.dataPtr = 1;
+        mRxSeq = seq + 1;
+        return true;
+    }
+}
@@ -17,6 +17,7 @@
  */
 
 #include <stdio.h>
+#include <stdbool.h>
 #include <string.h>     // memcmp()
 #include <time.h>
 
@@ -26,6 +27,12 @@
 
 
 
+/** @{ The time cached by rtc_gettime_cached() */
+static rtc_t g_rtc_cache;
+static uint64_t g_rtc_cache_next_us = 0;    ///< The uptime at which the RTC is read again, 0 to read it next time
+/** @} */
+
+
 void rtc_init (void)
 {
     lpc_pconp(pconp_rtc, true);
@@ -68,6 +75,40 @@ rtc_t rtc_gettime (void)
     return t1;
 }
 
+rtc_t rtc_gettime_cached (uint64_t uptime_us)
+{
+    rtc_t time;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    time = g_rtc_cache;
+    const bool cached = (uptime_us < g_rtc_cache_next_us);
+    __set_PRIMASK(primask);
+
+    if (!cached)
+    {
+        /* The registers are read outside of the critical section */
+        const rtc_t now = rtc_gettime();
+
+        primask = __get_PRIMASK();
+        __disable_irq();
+        {
+            /* The RTC changed its second since the last read, so the next one is due about a second later */
+            if (0 != memcmp(&now, &g_rtc_cache, sizeof(now))) {
+                g_rtc_cache = now;
+                g_rtc_cache_next_us = uptime_us + (1000 * 1000) - RTC_CACHE_POLL_US;
+            }
+            else {
+                g_rtc_cache_next_us = uptime_us + RTC_CACHE_POLL_US;
+            }
+        }
+        __set_PRIMASK(primask);
+        time = now;
+    }
+
+    return time;
+}
+
 void rtc_settime (const rtc_t *rtc)
 {
     /* Disable the RTC first */
@@ -88,6 +129,9 @@ void rtc_settime (const rtc_t *rtc)
 
 	/* Restart RTC */
 	LPC_RTC->CCR = 1;
+
+	/* The cached time is read again */
+	g_rtc_cache_next_us = 0;
 }
 
 const char* rtc_get_date_time_str(void)
@@ -16,53 +16,159 @@
  *          p r e e t . w i k i @ g m a i l . c o m
  */
 
-#include "LPC17xx.h"
-
-
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
 
-#define SPI_DMA_TX_NUM      0    ///< DMA Channel number for SSP Tx
-#define SPI_DMA_RX_NUM      1    ///< DMA Channel number for SSP Rx
-#define SSP1_TX_CHAN        2UL  ///< DMA source for TX of SSP1
-#define SSP1_RX_CHAN        3UL  ///< DMA source for RX of SSP1
+#include "LPC17xx.h"
+#include "lpc_sys.h"
+#include "lpc_dma.h"
+#include "ssp0.h"
+#include "ssp1.h"
 
 
 
-#if !(SPI_DMA_TX_NUM>=0 && SPI_DMA_TX_NUM<=7)
-#error "SPI_DMA_TX_NUM must be between 0 and 7"
-#endif
-#if !(SPI_DMA_RX_NUM>=0 && SPI_DMA_RX_NUM<=7)
-#error "SPI_DMA_RX_NUM must be between 0 and 7"
-#endif
+#define SSP_DMA_TIMEOUT_MS  100  ///< Maximum time to wait for a DMA transfer to complete
+#define SSP1_DMA_MAX_LLI    8    ///< Maximum linked list items per SSP1 transfer (8 x 4095 frames)
+#define SSP0_DMA_MAX_LLI    1    ///< Maximum linked list items per SSP0 transfer (the radio payloads are small)
 
 
 enum {
     err_Dma = 0,
     err_Len = 1,
     err_busy = 2,
-    err_spiFifo = 3
+    err_spiFifo = 3,
+    err_timeout = 4,
 };
 
+/// The DMA channels and the state of the DMA transfers of an SSP port
+typedef struct {
+    LPC_SSP_TypeDef *pSSP;      ///< The SSP port
+    dma_ch_t tx_ch;             ///< The DMA channel of the Tx
+    dma_ch_t rx_ch;             ///< The DMA channel of the Rx
+    dma_req_t tx_req;           ///< The DMA request of the Tx
+    dma_req_t rx_req;           ///< The DMA request of the Rx
+    dma_lli_t *pRxLli;          ///< The linked list items of the Rx
+    dma_lli_t *pTxLli;          ///< The linked list items of the Tx
+    uint32_t max_lli;           ///< The number of linked list items of pRxLli and pTxLli
+    SemaphoreHandle_t done;     ///< Given by the DMA interrupt when the Rx channel completes the transfer
+} ssp_dma_port_t;
 
-void ssp1_dma_init()
+/**
+ * The dummy data sent out during a read operation, or received during a write operation.
+ * This is a global because GPDMA cannot access the task stacks allocated from the heap (@see loader.ld)
+ */
+static uint32_t g_ssp_dma_dummy = 0xffffffff;
+
+/// Linked list items used to transfer more than 4095 frames, these are globals for the same reason as above
+static dma_lli_t g_ssp1_rx_lli[SSP1_DMA_MAX_LLI];
+static dma_lli_t g_ssp1_tx_lli[SSP1_DMA_MAX_LLI];
+static dma_lli_t g_ssp0_rx_lli[SSP0_DMA_MAX_LLI];
+static dma_lli_t g_ssp0_tx_lli[SSP0_DMA_MAX_LLI];
+
+/// The SSP ports, each using its own DMA channels so their transfers do not collide
+static ssp_dma_port_t g_ssp_dma_ports[] = {
+    { LPC_SSP0, dma_ch_ssp0_tx, dma_ch_ssp0_rx, dma_req_ssp0_tx, dma_req_ssp0_rx,
+      g_ssp0_rx_lli, g_ssp0_tx_lli, SSP0_DMA_MAX_LLI, 0 },
+    { LPC_SSP1, dma_ch_ssp1_tx, dma_ch_ssp1_rx, dma_req_ssp1_tx, dma_req_ssp1_rx,
+      g_ssp1_rx_lli, g_ssp1_tx_lli, SSP1_DMA_MAX_LLI, 0 },
+};
+
+/// @returns the DMA port of the SSP, or NULL if the SSP is invalid
+static ssp_dma_port_t* ssp_dma_get_port(LPC_SSP_TypeDef *pSSP)
+{
+    uint32_t i = 0;
+    for (i = 0; i < sizeof(g_ssp_dma_ports) / sizeof(g_ssp_dma_ports[0]); i++) {
+        if (pSSP == g_ssp_dma_ports[i].pSSP) {
+            return &g_ssp_dma_ports[i];
+        }
+    }
+    return NULL;
+}
+
+/// Callback of the Rx DMA channel
+static void ssp_dma_rx_done(void *arg, bool error)
+{
+    ssp_dma_port_t *pPort = (ssp_dma_port_t*) arg;
+    long higherPriorityTaskWoken = 0;
+    xSemaphoreGiveFromISR(pPort->done, &higherPriorityTaskWoken);
+    portEND_SWITCHING_ISR(higherPriorityTaskWoken);
+    (void) error;
+}
+
+/// Keeps the SPI clock at or below its speed when sys_clock_set_cpu_scale() changes the CPU clock
+static void ssp_cpu_clock_changed(void *arg, unsigned int old_cpu_hz, unsigned int new_cpu_hz)
+{
+    LPC_SSP_TypeDef *pSSP = (LPC_SSP_TypeDef*) arg;
+    uint32_t divider = sys_clock_scale_divider(pSSP->CPSR, old_cpu_hz, new_cpu_hz);
+
+    // The SSP prescaler must be an even number between 2 and 254
+    divider = (divider + 1) & ~1;
+    if (divider < 2) {
+        divider = 2;
+    }
+    else if (divider > 254) {
+        divider = 254;
+    }
+    pSSP->CPSR = divider;
+}
+
+void ssp_dma_init(LPC_SSP_TypeDef *pSSP)
 {
+    ssp_dma_port_t *pPort = ssp_dma_get_port(pSSP);
+
     // Power up and enable GPDMA
-    lpc_pconp(pconp_gpdma, true);
-    LPC_GPDMA->DMACConfig = 1;
-    while (!(LPC_GPDMA->DMACConfig & 1));
+    dma_init();
+    sys_clock_add_listener(ssp_cpu_clock_changed, pSSP);
+
+    /* The channels stay claimed by the port, since its transfers can start at any time */
+    if (pPort && !pPort->done) {
+        dma_channel_claim(pPort->tx_ch);
+        dma_channel_claim(pPort->rx_ch);
+        pPort->done = xSemaphoreCreateBinary();
+        dma_register_callback(pPort->rx_ch, ssp_dma_rx_done, pPort);
+    }
 }
 
-unsigned ssp1_dma_transfer_block(unsigned char* pBuffer, uint32_t num_bytes, char is_write_op)
+void ssp1_dma_init()
+{
+    ssp_dma_init(LPC_SSP1);
+}
+
+void ssp0_dma_init()
+{
+    ssp_dma_init(LPC_SSP0);
+}
+
+unsigned ssp_dma_transfer(LPC_SSP_TypeDef *pSSP, unsigned char* pBuffer, uint32_t num_bytes, char is_write_op,
+                          const ssp_dma_profile_t *pProfile)
 {
     uint8_t errorMask = 0;
+    ssp_dma_port_t *pPort = ssp_dma_get_port(pSSP);
+
+    if (!pPort) {
+        return 1;
+    }
+
+    /* Sleep on the DMA interrupt only if a task is calling us, and not an ISR */
+    const bool in_isr = !!(SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk);
+    const bool use_intr = (pPort->done && !in_isr && taskSCHEDULER_RUNNING == xTaskGetSchedulerState());
+    LPC_GPDMACH_TypeDef *pDmaRxChannel = dma_get_channel(pPort->rx_ch);
+    LPC_GPDMACH_TypeDef *pDmaTxChannel = dma_get_channel(pPort->tx_ch);
 
-    uint32_t dummyBuffer = 0xffffffff;
-    LPC_GPDMACH_TypeDef *pDmaRxChannel = (LPC_GPDMACH_TypeDef *)
-                                          (LPC_GPDMACH0_BASE + SPI_DMA_RX_NUM*0x20);
-    LPC_GPDMACH_TypeDef *pDmaTxChannel = (LPC_GPDMACH_TypeDef *)
-                                          (LPC_GPDMACH0_BASE + SPI_DMA_TX_NUM*0x20);
+    if (!pProfile) {
+        pProfile = ssp_dma_get_profile(pBuffer, num_bytes);
+    }
 
-    // DMA is limited to 12-bit transfer size
-    if(num_bytes >= 0x1000) {
+    const bool is_16bit = (16 == pProfile->frame_bits);
+    const uint32_t unit_size = is_16bit ? 2 : 1;
+    const uint32_t num_units = num_bytes / unit_size;
+
+    /* 16-bit frames need even length and half-word aligned buffer, and the linked list
+     * is limited to max_lli items of the 12-bit DMA transfer size
+     */
+    if (0 == num_bytes || (num_bytes % unit_size) || ((uint32_t) pBuffer % unit_size) ||
+        num_units > (pPort->max_lli * DMA_CTRL_SIZE_MASK)) {
         errorMask |= err_Len;
         return 1;
     }
@@ -71,64 +177,26 @@ unsigned ssp1_dma_transfer_block(unsigned char* pBuffer, uint32_t num_bytes, cha
         errorMask |= err_busy;
         return 2;
     }
-    while( LPC_SSP1->SR & (1<<2)) {
+    while( pSSP->SR & (1<<2)) {
         errorMask |= err_spiFifo;
-        char dummy = LPC_SSP1->DR;
+        char dummy = pSSP->DR;
         (void)dummy;
     }
 
     /**
-     * TO DO : Optimize SSP1 DMA
-     *  - Try setting source and destination burst size to 4
-     *  - Try setting 16-bit SPI, and source and destination width to 1 WORD
-     *
-     * LPC_SSP1->CR0 : B3:B0. 0b0111 = 8-bit and 0b1111 = 16-bit
-     * LPC_SSP1->CR0 |=  (1<<3);  // 16-bit
-     * LPC_SSP1->CR0 &= ~(1<<3);  // 8-bit
-     *
-     * Bits of DMACCControl:
-     * Transfer size: B11:B0
-     * Source Burst Size: B14:B12   - 0:1, 1:4, 2:8, 3:16 bytes
-     * Dest.  Burst Size: B17:B15   - 0:1, 1:4, 2:8, 3:16 bytes
-     * Source Width: B20:B18        - 0:Byte, 1:Word, 2:DWORD
-     * Dest.  Width: B23:B21        - 0:Byte, 1:Word, 2:DWORD
-     * Source increment: B26
-     * Destination increment: B27
-     * Terminal count interrupt enable: B31
-     *
-     * Bits of DMACCConfig:
-     * Enable: B0
-     * Source Peripheral: B5:B1   (ignored if source is memory)
-     * Dest.  Peripheral: B10:B6  (ignored if dest. is memory)
-     * Transfer type: B13:B11 - See below
-     * Interrupt Error Mask: B14
-     * Terminal Count Interrupt : B15
+     * Bits of DMACCControl: @see lpc_dma.h
+     * The SSP requests a burst when its 8-frame FIFO is half full (Rx) or half empty (Tx),
+     * so a burst of 4 frames moves half of the FIFO per DMA request.  A larger burst would
+     * read past the Rx data or overflow the Tx FIFO, so it is limited to 4.  The remaining
+     * frames smaller than a burst are transferred by the single requests.
      *
-     * Bits for transfer type:
-     * 000 - Memory to Memory
-     * 001 - Memory to Peripheral
-     * 010 - Peripheral to Memory
-     * 011 - Source peripheral to destination peripheral
+     * The frame width of the SSP must match the DMA width on both sides:
+     * LPC_SSPn->CR0 : B3:B0. 0b0111 = 8-bit and 0b1111 = 16-bit
      */
-    #define SRC_INCR_BIT        (1 << 26)
-    #define DST_INCR_BIT        (1 << 27)
-    #define TCIE_BIT            (1 << 31)   // Terminal count interrupt
-    #define SRC_BURST_4_BYTES   (1 << 12)
-    #define DST_BURST_4_BYTES   (1 << 15)
-    #define SRC_WIDTH_2_BYTES   (1 << 18)
-    #define DST_WIDTH_2_BYTES   (1 << 21)
-
-    #define M_TO_P_BIT      (1 << 11)   // Memory to Peripheral
-    #define P_TO_M_BIT      (2 << 11)   // Peripheral to Memory
-    #define ER_INTR_BIT     (1 << 14)   // Error interrupt enable
-    #define TC_INTR_BIT     (1 << 15)   // Terminal count interrupt enable
-
-    /**
-     * Clear existing terminal count and error interrupts otherwise
-     * DMA will not start.
-     */
-    LPC_GPDMA->DMACIntTCClear = (1 << SPI_DMA_RX_NUM) | (1 << SPI_DMA_TX_NUM);
-    LPC_GPDMA->DMACIntErrClr  = (1 << SPI_DMA_RX_NUM) | (1 << SPI_DMA_TX_NUM);
+    const uint32_t burst = (pProfile->burst >= 4) ? dma_burst_4 : dma_burst_1;
+    const uint32_t width = is_16bit ? dma_width_16bit : dma_width_8bit;
+    const uint32_t ctrl = DMA_CTRL_SRC_BURST(burst) | DMA_CTRL_DST_BURST(burst) |
+                          DMA_CTRL_SRC_WIDTH(width) | DMA_CTRL_DST_WIDTH(width);
 
     /**
      * From SPI to buffer:
@@ -138,18 +206,13 @@ unsigned ssp1_dma_transfer_block(unsigned char* pBuffer, uint32_t num_bytes, cha
      * For read operation:
      *      - Read data into pBuffer
      *      - Increment destination
+     *
+     * Only the last item of the Rx interrupts us since the Rx finishes after the Tx
      */
-    pDmaRxChannel->DMACCSrcAddr  = (uint32_t)(&(LPC_SSP1->DR));
-    if(is_write_op) {
-        pDmaRxChannel->DMACCDestAddr = (uint32_t)(&dummyBuffer);
-        pDmaRxChannel->DMACCControl = num_bytes | TCIE_BIT;
-    }
-    else {
-        pDmaRxChannel->DMACCDestAddr = (uint32_t)pBuffer;
-        pDmaRxChannel->DMACCControl = num_bytes | DST_INCR_BIT | TCIE_BIT;
-    }
-    pDmaRxChannel->DMACCLLI = 0;
-    pDmaRxChannel->DMACCConfig = (SSP1_RX_CHAN << 1) | P_TO_M_BIT;
+    const uint32_t rx_lli_count = dma_build_lli(pPort->pRxLli, pPort->max_lli, (uint32_t) &(pSSP->DR),
+                                      is_write_op ? (uint32_t) &g_ssp_dma_dummy : (uint32_t) pBuffer,
+                                      num_units, ctrl | (is_write_op ? 0 : DMA_CTRL_DST_INCR), unit_size);
+    pPort->pRxLli[rx_lli_count - 1].ctrl |= DMA_CTRL_TC_INTR;
 
     /**
      * From buffer to SPI :
@@ -160,29 +223,95 @@ unsigned ssp1_dma_transfer_block(unsigned char* pBuffer, uint32_t num_bytes, cha
      *      - Source data is buffer with 0xFF
      *      - Don't increment source data
      */
-    if(is_write_op) {
-        pDmaTxChannel->DMACCSrcAddr = (uint32_t)(pBuffer);
-        pDmaTxChannel->DMACCControl = num_bytes | SRC_INCR_BIT;
+    dma_build_lli(pPort->pTxLli, pPort->max_lli,
+                  is_write_op ? (uint32_t) pBuffer : (uint32_t) &g_ssp_dma_dummy, (uint32_t) &(pSSP->DR),
+                  num_units, ctrl | (is_write_op ? DMA_CTRL_SRC_INCR : 0), unit_size);
+
+    /**
+     * Clear existing terminal count and error interrupts otherwise
+     * DMA will not start.
+     */
+    dma_clear_intr(pPort->rx_ch);
+    dma_clear_intr(pPort->tx_ch);
+
+    uint32_t rx_config = DMA_CFG_SRC_PERIPH(pPort->rx_req) | DMA_CFG_P_TO_M;
+    if (use_intr) {
+        rx_config |= (DMA_CFG_ERR_INTR | DMA_CFG_TC_INTR);
+        xSemaphoreTake(pPort->done, 0);
     }
-    else {
-        pDmaTxChannel->DMACCSrcAddr = (uint32_t)(&dummyBuffer);
-        pDmaTxChannel->DMACCControl = num_bytes;
+    dma_load_channel(pPort->rx_ch, &(pPort->pRxLli[0]), rx_config);
+    dma_load_channel(pPort->tx_ch, &(pPort->pTxLli[0]), DMA_CFG_DST_PERIPH(pPort->tx_req) | DMA_CFG_M_TO_P);
+
+    if (is_16bit) {
+        pSSP->CR0 |= (1 << 3);
     }
-    pDmaTxChannel->DMACCDestAddr = (uint32_t)(&(LPC_SSP1->DR));
-    pDmaTxChannel->DMACCLLI = 0;
-    pDmaTxChannel->DMACCConfig = (SSP1_TX_CHAN << 6) | M_TO_P_BIT;
 
     /**
      * Channel must be fully configured and then enabled separately.
      * Setting DMACR's Rx/Tx bits should trigger the DMA
      */
-    pDmaRxChannel->DMACCConfig |= 1;
-    pDmaTxChannel->DMACCConfig |= 1;
-    LPC_SSP1->DMACR |= 3; // RX: B0, TX: B1
+    pDmaRxChannel->DMACCConfig |= DMA_CFG_ENABLE;
+    pDmaTxChannel->DMACCConfig |= DMA_CFG_ENABLE;
+    pSSP->DMACR |= 3; // RX: B0, TX: B1
 
-    while( (pDmaRxChannel->DMACCControl & 0xfff) );
-    LPC_SSP1->DMACR &= ~3;
+    /* Block on the DMA interrupt while the OS is running to let other tasks use the CPU.
+     * The channel disables itself after the last linked list item, or upon an error.
+     */
+    if (use_intr) {
+        if (!xSemaphoreTake(pPort->done, OS_MS(SSP_DMA_TIMEOUT_MS))) {
+            errorMask |= err_timeout;
+        }
+    }
+    else {
+        while (dma_channel_busy(pPort->rx_ch));
+    }
+    pSSP->DMACR &= ~3;
+
+    if (is_16bit) {
+        pSSP->CR0 &= ~(1 << 3);
+    }
+
+    /* Upon an error or timeout, the channels may still be enabled.  DMA error also
+     * disables the channel, and leaves the transfer size or the linked list non-zero.
+     */
+    if ((errorMask & err_timeout) || (pDmaRxChannel->DMACCControl & DMA_CTRL_SIZE_MASK) || pDmaRxChannel->DMACCLLI) {
+        pDmaRxChannel->DMACCConfig &= ~DMA_CFG_ENABLE;
+        pDmaTxChannel->DMACCConfig &= ~DMA_CFG_ENABLE;
+        return 3;
+    }
 
     return 0;
 }
 
+const ssp_dma_profile_t* ssp_dma_get_profile(const unsigned char *pBuffer, uint32_t num_bytes)
+{
+    /* Burst of 4 is the fastest for a byte stream, and 16-bit frames are not used
+     * because they would swap the order of each pair of bytes (@see ssp_dma_profile_t)
+     */
+    static const ssp_dma_profile_t byte_burst4 = { 8, 4 };
+    static const ssp_dma_profile_t byte_single = { 8, 1 };
+
+    (void) pBuffer;
+    return (0 == (num_bytes % 4)) ? &byte_burst4 : &byte_single;
+}
+
+unsigned ssp1_dma_transfer(unsigned char* pBuffer, uint32_t num_bytes, char is_write_op,
+                           const ssp1_dma_profile_t *pProfile)
+{
+    return ssp_dma_transfer(LPC_SSP1, pBuffer, num_bytes, is_write_op, pProfile);
+}
+
+const ssp1_dma_profile_t* ssp1_dma_get_profile(const unsigned char *pBuffer, uint32_t num_bytes)
+{
+    return ssp_dma_get_profile(pBuffer, num_bytes);
+}
+
+unsigned ssp1_dma_transfer_block(unsigned char* pBuffer, uint32_t num_bytes, char is_write_op)
+{
+    return ssp_dma_transfer(LPC_SSP1, pBuffer, num_bytes, is_write_op, ssp_dma_get_profile(pBuffer, num_bytes));
+}
+
+unsigned ssp0_dma_transfer_block(unsigned char* pBuffer, uint32_t num_bytes, char is_write_op)
+{
+    return ssp_dma_transfer(LPC_SSP0, pBuffer, num_bytes, is_write_op, ssp_dma_get_profile(pBuffer, num_bytes));
+}
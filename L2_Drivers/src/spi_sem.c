@@ -15,29 +15,38 @@
  *     You can reach the author of this software at :
  *          p r e e t . w i k i @ g m a i l . c o m
  */
-#include "FreeRTOS.h"
-#include "task.h"
-#include "semphr.h"
+#include "spi_sem.h"
+#include "ssp_bus.h"
+#include "sys_config.h"     // SYS_CFG_SPI1_CLK_MHZ
 
 
 
-static SemaphoreHandle_t mSpi0Lock = 0;
+/// The SD card and the SPI flash, which are selected by their drivers (@see bio.h)
+static ssp_bus_dev_t g_spi1_storage = { ssp_bus_ssp1, SSP_BUS_NO_CS, 0, 0, SYS_CFG_SPI1_CLK_MHZ,
+                                        SSP_BUS_DEFAULT_PRIORITY, 0, 0 };
 
 
 
+/* The SSP1 lock of the bus manager, which hands the lock to the waiting devices of SSP1 by their priority */
 void spi1_lock(void)
 {
-    if(!mSpi0Lock) {
-        mSpi0Lock = xSemaphoreCreateMutex();
-    }
-    if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
-        xSemaphoreTake(mSpi0Lock, portMAX_DELAY);
+    /* The nested locks keep the clock, such as the slow clock during the init of the SD card */
+    if (ssp_bus_lock(ssp_bus_ssp1, SSP_BUS_DEFAULT_PRIORITY)) {
+        ssp_bus_setup(&g_spi1_storage);
     }
 }
 
 void spi1_unlock(void)
 {
-    if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
-        xSemaphoreGive(mSpi0Lock);
-    }
+    ssp_bus_unlock(ssp_bus_ssp1);
+}
+
+bool spi1_yield(uint32_t ms)
+{
+    return ssp_bus_yield(ssp_bus_ssp1, ms);
+}
+
+bool spi1_is_locked(void)
+{
+    return ssp_bus_is_locked(ssp_bus_ssp1);
 }
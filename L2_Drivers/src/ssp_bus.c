@@ -0,0 +1,334 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include "ssp_bus.h"
+#include "LPC17xx.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "os_signal.h"
+#include "os_lock_stats.h"
+#include "lpc_sys.h"        // sys_get_cpu_clock()
+#include "lpc_dma.h"        // dma_is_accessible()
+#include "base/ssp_prv.h"
+
+
+
+/// A task waiting for the lock of a bus, in the stack of the task
+typedef struct ssp_bus_waiter {
+    struct ssp_bus_waiter *pNext;   ///< The next waiter of the same or lower priority
+    os_signal_t granted;            ///< Given by ssp_bus_unlock() once the lock is handed to this task
+    uint8_t priority;
+} ssp_bus_waiter_t;
+
+/// The state of a bus
+typedef struct {
+    LPC_SSP_TypeDef *pSSP;
+    volatile TaskHandle_t holder;   ///< The task that has the bus locked
+    uint8_t depth;                  ///< The nested locks of the holder
+    uint8_t priority;               ///< The priority the holder locked the bus with
+    ssp_bus_waiter_t *pWaiters;     ///< The waiting tasks, highest priority first
+    ssp_bus_stats_t stats;
+    os_lock_stats_t lock_stats;     ///< The contention of the lock for the 'health' command
+} ssp_bus_state_t;
+
+static ssp_bus_state_t g_ssp_bus[ssp_bus_count] = {
+    { LPC_SSP0, NULL, 0, 0, NULL, { 0 }, OS_LOCK_STATS_INIT("ssp0") },
+    { LPC_SSP1, NULL, 0, 0, NULL, { 0 }, OS_LOCK_STATS_INIT("spi1") },
+};
+
+
+
+static inline LPC_GPIO_TypeDef* ssp_bus_get_gpio(const uint8_t port)
+{
+    return (LPC_GPIO_TypeDef*) (LPC_GPIO0_BASE + (port * (LPC_GPIO1_BASE - LPC_GPIO0_BASE)));
+}
+
+void ssp_bus_setup(ssp_bus_dev_t *pDev)
+{
+    LPC_SSP_TypeDef *pSSP = g_ssp_bus[pDev->bus].pSSP;
+    const uint32_t cpu_hz = sys_get_cpu_clock();
+
+    /* 8-bit SPI frames, with the CPOL at bit 6 and the CPHA at bit 7 */
+    const uint32_t cr0 = 7 | ((pDev->mode & 2) ? (1 << 6) : 0) | ((pDev->mode & 1) ? (1 << 7) : 0);
+
+    /* The prescaler is only calculated again after sys_clock_set_cpu_scale() */
+    if (cpu_hz != pDev->cpu_hz) {
+        const unsigned int divider = ssp_get_clock_divider(pDev->max_clock_mhz);
+        pDev->cpsr = (divider > 254) ? 254 : divider;
+        pDev->cpu_hz = cpu_hz;
+    }
+
+    /* The registers are compared since ssp1_set_max_clock() may change the clock behind our back */
+    if (pSSP->CPSR != pDev->cpsr || pSSP->CR0 != cr0) {
+        while (pSSP->SR & (1 << 4));    /* The frame format cannot change in the middle of a frame */
+        pSSP->CR0 = cr0;
+        pSSP->CPSR = pDev->cpsr;
+        ++g_ssp_bus[pDev->bus].stats.reconfigs;
+    }
+}
+
+/// Exchanges the bytes through the FIFO, which keeps up to 8 frames in flight
+static void ssp_bus_exchange(LPC_SSP_TypeDef *pSSP, const uint8_t *pTx, uint8_t *pRx, uint32_t len)
+{
+    const uint32_t fifo_size = 8;
+    const uint32_t rx_not_empty = (1 << 2);
+
+    while (len > 0) {
+        const uint32_t n = (len < fifo_size) ? len : fifo_size;
+        uint32_t i = 0;
+
+        for (i = 0; i < n; i++) {
+            pSSP->DR = pTx ? pTx[i] : 0xFF;
+        }
+        for (i = 0; i < n; i++) {
+            while (!(pSSP->SR & rx_not_empty));
+            const uint8_t b = pSSP->DR;
+            if (pRx) {
+                pRx[i] = b;
+            }
+        }
+
+        pTx = pTx ? (pTx + n) : NULL;
+        pRx = pRx ? (pRx + n) : NULL;
+        len -= n;
+    }
+}
+
+/// @returns false if the DMA transfer failed
+static bool ssp_bus_xfer(const ssp_bus_xfer_t *pXfer)
+{
+    LPC_SSP_TypeDef *pSSP = g_ssp_bus[pXfer->pDev->bus].pSSP;
+    const uint8_t *pTx = (const uint8_t*) pXfer->pTx;
+    uint8_t *pRx = (uint8_t*) pXfer->pRx;
+
+    /* The DMA only sends a buffer, or only receives to a buffer (@see ssp_dma_transfer()) */
+    if (pXfer->len >= SSP_BUS_DMA_MIN_BYTES) {
+        if (pTx && !pRx && dma_is_accessible(pTx)) {
+            return (0 == ssp_dma_transfer(pSSP, (unsigned char*) pTx, pXfer->len, 1, NULL));
+        }
+        if (!pTx && pRx && dma_is_accessible(pRx)) {
+            return (0 == ssp_dma_transfer(pSSP, pRx, pXfer->len, 0, NULL));
+        }
+    }
+
+    ssp_bus_exchange(pSSP, pTx, pRx, pXfer->len);
+    return true;
+}
+
+
+
+void ssp_bus_dev_init(ssp_bus_dev_t *pDev)
+{
+    pDev->cpu_hz = 0;
+
+    if (SSP_BUS_NO_CS != pDev->cs_port) {
+        LPC_GPIO_TypeDef *gpio = ssp_bus_get_gpio(pDev->cs_port);
+        gpio->FIOSET = (1 << pDev->cs_pin);
+        gpio->FIODIR |= (1 << pDev->cs_pin);
+    }
+}
+
+bool ssp_bus_lock(ssp_bus_t bus, uint8_t priority)
+{
+    ssp_bus_state_t *pBus = &g_ssp_bus[bus];
+    ssp_bus_waiter_t waiter;
+    ssp_bus_waiter_t **ppNext = &pBus->pWaiters;
+
+    if (taskSCHEDULER_RUNNING != xTaskGetSchedulerState()) {
+        return false;
+    }
+
+    const uint32_t start = os_lock_wait_start();
+    const TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    portENTER_CRITICAL();
+    {
+        if (self == pBus->holder) {
+            ++pBus->depth;
+            portEXIT_CRITICAL();
+            return false;
+        }
+
+        ++pBus->stats.locks;
+        if (NULL == pBus->holder) {
+            pBus->holder = self;
+            pBus->depth = 1;
+            pBus->priority = priority;
+            portEXIT_CRITICAL();
+            os_lock_acquired(&pBus->lock_stats, start, false);
+            return true;
+        }
+
+        /* Wait behind the tasks of the same or higher priority */
+        ++pBus->stats.contended;
+        os_signal_clear(&waiter.granted);
+        waiter.priority = priority;
+        while (NULL != *ppNext && (*ppNext)->priority >= priority) {
+            ppNext = &(*ppNext)->pNext;
+        }
+        waiter.pNext = *ppNext;
+        *ppNext = &waiter;
+    }
+    portEXIT_CRITICAL();
+
+    /* ssp_bus_unlock() makes us the holder before it gives the signal */
+    os_signal_wait(&waiter.granted, portMAX_DELAY);
+    os_lock_acquired(&pBus->lock_stats, start, true);
+    return true;
+}
+
+void ssp_bus_unlock(ssp_bus_t bus)
+{
+    ssp_bus_state_t *pBus = &g_ssp_bus[bus];
+    ssp_bus_waiter_t *pNext = NULL;
+
+    if (taskSCHEDULER_RUNNING != xTaskGetSchedulerState()) {
+        return;
+    }
+
+    portENTER_CRITICAL();
+    {
+        if (xTaskGetCurrentTaskHandle() != pBus->holder || --pBus->depth > 0) {
+            portEXIT_CRITICAL();
+            return;
+        }
+        os_lock_released(&pBus->lock_stats);
+
+        pNext = pBus->pWaiters;
+        if (NULL != pNext) {
+            pBus->pWaiters = pNext->pNext;
+            pBus->holder = pNext->granted.task;
+            pBus->depth = 1;
+            pBus->priority = pNext->priority;
+        }
+        else {
+            pBus->holder = NULL;
+        }
+    }
+    portEXIT_CRITICAL();
+
+    if (NULL != pNext) {
+        os_signal_give(&pNext->granted);
+    }
+}
+
+bool ssp_bus_yield(ssp_bus_t bus, uint32_t ms)
+{
+    ssp_bus_state_t *pBus = &g_ssp_bus[bus];
+    const TickType_t ticks = ms / portTICK_PERIOD_MS;
+
+    if (taskSCHEDULER_RUNNING != xTaskGetSchedulerState() ||
+        pBus->holder != xTaskGetCurrentTaskHandle()) {
+        return false;
+    }
+
+    /* The nested locks are kept across the yield */
+    const uint8_t depth = pBus->depth;
+    const uint8_t priority = pBus->priority;
+    pBus->depth = 1;
+    ssp_bus_unlock(bus);
+    vTaskDelay(ticks > 0 ? ticks : 1);
+    ssp_bus_lock(bus, priority);
+    pBus->depth = depth;
+    return true;
+}
+
+bool ssp_bus_is_locked(ssp_bus_t bus)
+{
+    return (NULL != g_ssp_bus[bus].holder);
+}
+
+void ssp_bus_acquire(ssp_bus_dev_t *pDev)
+{
+    ssp_bus_lock(pDev->bus, pDev->priority);
+    ssp_bus_setup(pDev);
+}
+
+void ssp_bus_release(ssp_bus_dev_t *pDev)
+{
+    ssp_bus_unlock(pDev->bus);
+}
+
+void ssp_bus_select(const ssp_bus_dev_t *pDev)
+{
+    if (SSP_BUS_NO_CS != pDev->cs_port) {
+        ssp_bus_get_gpio(pDev->cs_port)->FIOCLR = (1 << pDev->cs_pin);
+    }
+}
+
+void ssp_bus_deselect(const ssp_bus_dev_t *pDev)
+{
+    if (SSP_BUS_NO_CS != pDev->cs_port) {
+        ssp_bus_get_gpio(pDev->cs_port)->FIOSET = (1 << pDev->cs_pin);
+    }
+}
+
+bool ssp_bus_run(const ssp_bus_xfer_t *pXfers, uint32_t count)
+{
+    uint8_t priority = 0;
+    uint32_t i = 0;
+    bool success = true;
+
+    if (0 == count) {
+        return true;
+    }
+
+    const ssp_bus_t bus = pXfers[0].pDev->bus;
+    for (i = 0; i < count; i++) {
+        if (bus != pXfers[i].pDev->bus) {
+            return false;
+        }
+        if (pXfers[i].pDev->priority > priority) {
+            priority = pXfers[i].pDev->priority;
+        }
+    }
+
+    ssp_bus_lock(bus, priority);
+    for (i = 0; i < count; i++)
+    {
+        const ssp_bus_xfer_t *pXfer = &pXfers[i];
+        const bool selected = (i > 0 && pXfers[i - 1].pDev == pXfer->pDev &&
+                               (pXfers[i - 1].flags & SSP_BUS_XFER_CS_HOLD));
+
+        if (!selected) {
+            ssp_bus_setup(pXfer->pDev);
+            ssp_bus_select(pXfer->pDev);
+        }
+
+        success = ssp_bus_xfer(pXfer) && success;
+
+        /* The CS is not held into the transfer of another device, or past the last transfer */
+        if (!(pXfer->flags & SSP_BUS_XFER_CS_HOLD) || (i + 1) == count || pXfers[i + 1].pDev != pXfer->pDev) {
+            ssp_bus_deselect(pXfer->pDev);
+        }
+    }
+    g_ssp_bus[bus].stats.xfers += count;
+    ssp_bus_unlock(bus);
+
+    return success;
+}
+
+bool ssp_bus_transfer(ssp_bus_dev_t *pDev, const void *pTx, void *pRx, uint16_t len)
+{
+    const ssp_bus_xfer_t xfer = { pDev, pTx, pRx, len, 0 };
+    return ssp_bus_run(&xfer, 1);
+}
+
+ssp_bus_stats_t ssp_bus_get_stats(ssp_bus_t bus)
+{
+    return g_ssp_bus[bus].stats;
+}
@@ -0,0 +1,361 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <stddef.h>
+#include "stepper.h"
+#include "lpc_timers.h"
+#include "sys_config.h"
+#include "queue.h"
+#include "task.h"
+
+
+
+#if (SYS_CFG_STEPPER_TIMER == SYS_CFG_SYS_TIMER)
+#error "SYS_CFG_STEPPER_TIMER cannot be the same timer as SYS_CFG_SYS_TIMER"
+#endif
+
+/**
+ * The step period is stored as fixed point microseconds with this many fractional bits
+ * so that the small changes of the period during acceleration are not lost.
+ */
+#define STEPPER_PERIOD_FRAC_BITS    8
+
+/// Minimum time in microseconds to the next match to avoid missing the match
+#define STEPPER_MIN_MATCH_US        4
+
+/// Delay from the direction change to the first step pulse in microseconds
+#define STEPPER_DIR_SETUP_US        10
+
+/// MR0 interrupt bit of MCR and IR registers
+#define STEPPER_MR0_INTR            (1 << 0)
+
+/// A queued move
+typedef struct {
+    int32_t steps;              ///< The steps to move
+    SemaphoreHandle_t done_sem; ///< Semaphore to give when done
+} stepper_move_t;
+
+/// The state of the move being executed by the timer ISR
+typedef struct {
+    uint32_t remaining;         ///< Steps left in this move
+    uint32_t accel_steps;       ///< Number of acceleration steps taken (n of the speed profile)
+    uint32_t period;            ///< Current step period (fixed point microseconds)
+    int8_t dir;                 ///< +1 or -1
+    SemaphoreHandle_t done_sem; ///< Semaphore to give when done
+} stepper_state_t;
+
+static stepper_cfg_t g_cfg;                 ///< The configuration given to stepper_init()
+static LPC_TIM_TypeDef *gp_timer = NULL;    ///< The timer used to generate the step pulses
+static QueueHandle_t g_move_queue = NULL;   ///< The queue of moves
+static SemaphoreHandle_t g_wait_sem = NULL; ///< Semaphore used by stepper_move_wait()
+static volatile bool g_busy = false;        ///< true while the ISR is executing moves
+static bool g_step_high = false;            ///< State of the step pin (the pin may be open-drain, so it is not read back)
+static volatile int32_t g_position = 0;     ///< Net steps moved
+static stepper_state_t g_state;             ///< Current move
+
+/** @{ Speed profile used by the next move (fixed point microseconds) */
+static uint32_t g_first_period = 0;         ///< Period of the first step out of stand-still
+static uint32_t g_min_period = 0;           ///< Period at the maximum speed
+/** @} */
+
+
+
+/// @returns the integer square root of x
+static uint32_t stepper_isqrt(uint64_t x)
+{
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > x) {
+        bit >>= 2;
+    }
+    while (0 != bit) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t) root;
+}
+
+/// Sets the next match of the timer, "us" microseconds after the last match
+static inline void stepper_schedule(uint32_t us)
+{
+    uint32_t next = gp_timer->MR0 + us;
+
+    // If the ISR was delayed past the next step, step as soon as possible
+    if ((int32_t)(next - gp_timer->TC) < STEPPER_MIN_MATCH_US) {
+        next = gp_timer->TC + STEPPER_MIN_MATCH_US;
+    }
+    gp_timer->MR0 = next;
+}
+
+/**
+ * Begins the next move from the queue.
+ * @returns false if there is no move to begin
+ */
+static bool stepper_begin_next_move(BaseType_t *pWoken)
+{
+    stepper_move_t move;
+
+    while (xQueueReceiveFromISR(g_move_queue, &move, pWoken))
+    {
+        // A zero-step move is complete right away
+        if (0 == move.steps) {
+            if (move.done_sem) {
+                xSemaphoreGiveFromISR(move.done_sem, pWoken);
+            }
+            continue;
+        }
+
+        g_state.dir = (move.steps > 0) ? 1 : -1;
+        g_state.remaining = (move.steps > 0) ? move.steps : -move.steps;
+        g_state.accel_steps = 0;
+        g_state.period = g_first_period;
+        g_state.done_sem = move.done_sem;
+
+        if (g_state.dir > 0) {
+            g_cfg.gpio->FIOSET = g_cfg.dir_pin;
+        }
+        else {
+            g_cfg.gpio->FIOCLR = g_cfg.dir_pin;
+        }
+
+        // Give time for the direction pin to settle before the first step
+        gp_timer->MR0 = gp_timer->TC + STEPPER_DIR_SETUP_US;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * Updates the period of the next step using the trapezoidal speed profile.
+ * The step period of constant acceleration follows the recurrence of
+ * "Generate stepper-motor speed profiles in real time" (D. Austin, 2005):
+ *      Accelerating:  c(n) = c(n-1) - 2 * c(n-1) / (4n + 1)
+ *      Decelerating:  c(n-1) = c(n) + 2 * c(n) / (4n - 1)
+ * This avoids the square root or division by time in the ISR.
+ */
+static inline void stepper_update_period(void)
+{
+    stepper_state_t *s = &g_state;
+
+    if (s->remaining <= s->accel_steps) {
+        // Decelerate to stop at the end of the move
+        if (s->accel_steps > 0) {
+            s->period += (2 * s->period) / (4 * s->accel_steps - 1);
+            s->accel_steps--;
+        }
+    }
+    else if (s->period > g_min_period) {
+        s->accel_steps++;
+        s->period -= (2 * s->period) / (4 * s->accel_steps + 1);
+        if (s->period < g_min_period) {
+            s->period = g_min_period;
+        }
+    }
+}
+
+/**
+ * The timer ISR makes a step pulse in two halves of the step period: the rising edge
+ * is the step, and the falling edge completes the move when no steps are left.
+ */
+static void stepper_isr(void)
+{
+    BaseType_t woken = pdFALSE;
+    gp_timer->IR = STEPPER_MR0_INTR;
+
+    if (g_step_high)
+    {
+        g_cfg.gpio->FIOCLR = g_cfg.step_pin;
+        g_step_high = false;
+
+        if (0 == g_state.remaining) {
+            if (g_state.done_sem) {
+                xSemaphoreGiveFromISR(g_state.done_sem, &woken);
+            }
+            if (!stepper_begin_next_move(&woken)) {
+                gp_timer->MCR &= ~STEPPER_MR0_INTR;
+                g_busy = false;
+            }
+        }
+        else {
+            stepper_schedule(g_state.period >> (STEPPER_PERIOD_FRAC_BITS + 1));
+        }
+    }
+    else
+    {
+        g_cfg.gpio->FIOSET = g_cfg.step_pin;
+        g_step_high = true;
+        g_state.remaining--;
+        g_position += g_state.dir;
+        if (g_cfg.on_step) {
+            g_cfg.on_step(g_state.dir > 0);
+        }
+
+        const uint32_t half_period = g_state.period >> (STEPPER_PERIOD_FRAC_BITS + 1);
+        stepper_update_period();
+        stepper_schedule(half_period);
+    }
+
+    portYIELD_FROM_ISR(woken);
+}
+
+/// Starts executing the queued moves if the ISR is not already doing so
+static void stepper_kick(void)
+{
+    BaseType_t woken = pdFALSE;
+
+    taskENTER_CRITICAL();
+    if (!g_busy) {
+        if (stepper_begin_next_move(&woken)) {
+            g_busy = true;
+            gp_timer->IR = STEPPER_MR0_INTR;
+            gp_timer->MCR |= STEPPER_MR0_INTR;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if (woken) {
+        portYIELD();
+    }
+}
+
+/**
+ * Actual ISR function (@see startup.cpp)
+ */
+#if (0 == SYS_CFG_STEPPER_TIMER)
+void TIMER0_IRQHandler()
+#elif (1 == SYS_CFG_STEPPER_TIMER)
+void TIMER1_IRQHandler()
+#elif (2 == SYS_CFG_STEPPER_TIMER)
+void TIMER2_IRQHandler()
+#elif (3 == SYS_CFG_STEPPER_TIMER)
+void TIMER3_IRQHandler()
+#else
+#error "SYS_CFG_STEPPER_TIMER must be between 0-3 inclusively"
+void TIMERX_BAD_IRQHandler()
+#endif
+{
+    stepper_isr();
+}
+
+bool stepper_init(const stepper_cfg_t *cfg)
+{
+    const lpc_timer_t timer = (lpc_timer_t) SYS_CFG_STEPPER_TIMER;
+
+    if (NULL == cfg || NULL == cfg->gpio || 0 == cfg->max_sps || 0 == cfg->accel_sps2) {
+        return false;
+    }
+
+    g_cfg = *cfg;
+    if (NULL == g_move_queue) {
+        g_move_queue = xQueueCreate(STEPPER_MOVE_QUEUE_SIZE, sizeof(stepper_move_t));
+    }
+    if (NULL == g_wait_sem) {
+        g_wait_sem = xSemaphoreCreateBinary();
+    }
+    if (NULL == g_move_queue || NULL == g_wait_sem) {
+        return false;
+    }
+
+    stepper_set_speed(cfg->max_sps, cfg->accel_sps2);
+    g_cfg.gpio->FIOCLR = g_cfg.step_pin;
+
+    /* Free running timer with 1us resolution, and MR0 interrupt enabled only during moves */
+    lpc_timer_enable(timer, 1);
+    gp_timer = lpc_timer_get_struct(timer);
+    gp_timer->MCR = 0;
+    gp_timer->IR = STEPPER_MR0_INTR;
+    NVIC_EnableIRQ(lpc_timer_get_irq_num(timer));
+
+    return true;
+}
+
+void stepper_set_speed(uint32_t max_sps, uint32_t accel_sps2)
+{
+    if (0 == max_sps || 0 == accel_sps2) {
+        return;
+    }
+
+    /**
+     * First step at standstill: c0 = 0.676 * sqrt(2 / a) seconds.  The 0.676 factor
+     * corrects the error of the recurrence for the first step.
+     * In fixed point: c0 = 0.676 * sqrt(2) * 10^6 * 2^8 / sqrt(a) = 955008 * 2^16 / sqrt(a * 2^16)
+     */
+    const uint32_t first = (uint32_t) (((uint64_t) 955008 << 16) / stepper_isqrt((uint64_t) accel_sps2 << 16));
+    const uint32_t min = ((uint32_t) 1000000 << STEPPER_PERIOD_FRAC_BITS) / max_sps;
+
+    taskENTER_CRITICAL();
+    g_min_period = min;
+    g_first_period = (first > min) ? first : min;
+    taskEXIT_CRITICAL();
+}
+
+bool stepper_move(int32_t steps, SemaphoreHandle_t done_sem, TickType_t timeout)
+{
+    const stepper_move_t move = { steps, done_sem };
+
+    if (NULL == g_move_queue || !xQueueSend(g_move_queue, &move, timeout)) {
+        return false;
+    }
+
+    stepper_kick();
+    return true;
+}
+
+bool stepper_move_wait(int32_t steps, TickType_t timeout)
+{
+    // Discard a stale completion of a previous move that timed out
+    xSemaphoreTake(g_wait_sem, 0);
+
+    return stepper_move(steps, g_wait_sem, timeout) &&
+           xSemaphoreTake(g_wait_sem, timeout);
+}
+
+void stepper_stop(void)
+{
+    if (NULL == gp_timer) {
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    gp_timer->MCR &= ~STEPPER_MR0_INTR;
+    gp_timer->IR = STEPPER_MR0_INTR;
+    g_cfg.gpio->FIOCLR = g_cfg.step_pin;
+    g_step_high = false;
+    xQueueReset(g_move_queue);
+    g_state.remaining = 0;
+    g_busy = false;
+    taskEXIT_CRITICAL();
+}
+
+bool stepper_is_busy(void)
+{
+    return g_busy || (NULL != g_move_queue && uxQueueMessagesWaiting(g_move_queue) > 0);
+}
+
+int32_t stepper_get_position(void)
+{
+    return g_position;
+}
@@ -0,0 +1,91 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include "uart1.hpp"
+#include "LPC17xx.h"     // LPC_UART1_BASE
+#include "sys_config.h"  // sys_get_cpu_clock()
+
+
+
+/**
+ * IRQ Handler needs to be enclosed in extern "C" because this is C++ file, and
+ * we don't want C++ to "mangle" our function name.
+ * This ISR Function need needs to be named precisely to override "WEAK" ISR
+ * handler defined at startup.cpp
+ */
+extern "C"
+{
+    void UART1_IRQHandler()
+    {
+        Uart1::getInstance().handleInterrupt();
+    }
+}
+
+bool Uart1::init(unsigned int baudRate, int rxQSize, int txQSize, bool flowControl, uart1_pins_t pins)
+{
+    const uint8_t autoRts = (1 << 6);
+    const uint8_t autoCts = (1 << 7);
+
+    // Configure PINSEL for UART1 Tx/Rx and, if used, CTS and RTS
+    if (uart1_pins_p0 == pins) {
+        LPC_PINCON->PINSEL0 &= ~(3U << 30);
+        LPC_PINCON->PINSEL0 |=  (1U << 30);                 // TXD1 P0.15
+        LPC_PINCON->PINSEL1 &= ~(3 << 0);
+        LPC_PINCON->PINSEL1 |=  (1 << 0);                   // RXD1 P0.16
+        if (flowControl) {
+            LPC_PINCON->PINSEL1 &= ~((3 << 2) | (3 << 12));
+            LPC_PINCON->PINSEL1 |=  ((1 << 2) | (1 << 12)); // CTS1 P0.17, RTS1 P0.22
+        }
+    }
+    else {
+        LPC_PINCON->PINSEL4 &= ~(0xF << 0);
+        LPC_PINCON->PINSEL4 |=  (0xA << 0);                 // TXD1 P2.0, RXD1 P2.1
+        if (flowControl) {
+            LPC_PINCON->PINSEL4 &= ~((3 << 4) | (3 << 14));
+            LPC_PINCON->PINSEL4 |=  ((2 << 4) | (2 << 14)); // CTS1 P2.2, RTS1 P2.7
+        }
+    }
+
+    // Set UART1 Peripheral Clock divider to 1
+    lpc_pclk(pclk_uart1, clkdiv_1);
+    const unsigned int pclk = sys_get_cpu_clock();
+
+    const bool success = UartDev::init(pclk, baudRate, rxQSize, txQSize);
+    LPC_UART1_TypeDef *pUart1 = (LPC_UART1_TypeDef*) LPC_UART1_BASE;
+
+    if (success && flowControl) {
+        enableRxFlowControl();
+        pUart1->MCR = autoRts | autoCts;
+    }
+    else {
+        pUart1->MCR = 0;
+    }
+
+    return success;
+}
+
+bool Uart1::isClearToSend(void) const
+{
+    const uint8_t cts = (1 << 4);
+    return !!(((LPC_UART1_TypeDef*) LPC_UART1_BASE)->MSR & cts);
+}
+
+Uart1::Uart1() : UartDev((unsigned int*)LPC_UART1_BASE)
+{
+    // Nothing to do here other than handing off LPC_UART1_Base address to UART_Base
+}
@@ -0,0 +1,169 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief SSP bus manager: the devices of a shared SSP bus, with their own clock and SPI mode
+ * @ingroup Drivers
+ *
+ * Each device on an SSP bus (SSP0 or SSP1) is described by an ssp_bus_dev_t with its chip-select
+ * pin, its maximum clock, its SPI mode, and its priority.  The bus remembers the clock and the mode
+ * it is programmed with, so the prescaler and the frame format are only re-programmed when the
+ * next transfer is for a device with other settings, or after the CPU clock changed.
+ *
+ * The lock of a bus is handed over by the unlock to the waiting device with the highest priority
+ * (and the longest waiting among the same priority), instead of the task priority of a mutex.
+ * The same task may lock a bus again while it has it locked.  spi1_lock() is the lock of SSP1 with
+ * SSP_BUS_DEFAULT_PRIORITY, so the SD card and the SPI flash share it with the devices of SSP1, and
+ * it sets up SYS_CFG_SPI1_CLK_MHZ and the SPI mode 0 of the storage after another device used SSP1.
+ *
+ * A list of transfers, of the same or of different devices of a bus, is run with one lock:
+ * @code
+ *      static ssp_bus_dev_t adc = { ssp_bus_ssp0, 0, 6, 0, 2, SSP_BUS_DEFAULT_PRIORITY + 1 };
+ *      static ssp_bus_dev_t dac = { ssp_bus_ssp0, 0, 16, 1, 10, SSP_BUS_DEFAULT_PRIORITY };
+ *      ssp_bus_dev_init(&adc);
+ *      ssp_bus_dev_init(&dac);
+ *
+ *      uint8_t cmd[2] = { 0x06, 0x40 }, sample[2] = { 0 }, level[2] = { 0x30, 0x00 };
+ *      const ssp_bus_xfer_t xfers[] = {
+ *          { &adc, cmd, NULL, sizeof(cmd), SSP_BUS_XFER_CS_HOLD },    // CS stays low for the read
+ *          { &adc, NULL, sample, sizeof(sample), 0 },
+ *          { &dac, level, NULL, sizeof(level), 0 },
+ *      };
+ *      ssp_bus_run(xfers, sizeof(xfers) / sizeof(xfers[0]));
+ * @endcode
+ *
+ * 20261014: Initial
+ */
+#ifndef SSP_BUS_H__
+#define SSP_BUS_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+#define SSP_BUS_NO_CS               0xFF    ///< The cs_port of a device that is selected by its own driver
+#define SSP_BUS_DEFAULT_PRIORITY    4       ///< The priority of spi1_lock(); 0 is the lowest
+#define SSP_BUS_DMA_MIN_BYTES       32      ///< One way transfers of DMA memory of this many bytes use the DMA
+
+
+
+/// The SSP buses
+typedef enum {
+    ssp_bus_ssp0 = 0,
+    ssp_bus_ssp1,
+    ssp_bus_count
+} ssp_bus_t;
+
+/// The descriptor of a device on an SSP bus, set the public fields and call ssp_bus_dev_init()
+/// (a device of SSP_BUS_NO_CS does not need it, so it can be a static initializer)
+typedef struct {
+    ssp_bus_t bus;              ///< The bus of the device
+    uint8_t cs_port;            ///< The GPIO port of the chip-select pin (active low), or SSP_BUS_NO_CS
+    uint8_t cs_pin;             ///< The GPIO pin of the chip-select pin
+    uint8_t mode;               ///< The SPI mode 0-3: bit 1 is the clock polarity (CPOL), bit 0 the phase (CPHA)
+    uint8_t max_clock_mhz;      ///< The maximum clock of the device
+    uint8_t priority;           ///< The device of the highest priority waiting for the bus gets it first
+
+    /** @{ Private fields set by the transfers */
+    uint8_t cpsr;               ///< The prescaler of max_clock_mhz at the CPU clock of cpu_hz
+    uint32_t cpu_hz;            ///< The CPU clock that cpsr was calculated for, 0 if not yet
+    /** @} */
+} ssp_bus_dev_t;
+
+/// Flags of an ssp_bus_xfer_t
+enum {
+    SSP_BUS_XFER_CS_HOLD = (1 << 0),    ///< The CS stays low for the next transfer of the same device
+};
+
+/// A transfer of a list given to ssp_bus_run()
+typedef struct {
+    ssp_bus_dev_t *pDev;        ///< The device of the transfer
+    const void *pTx;            ///< The bytes to send, or NULL to send 0xFF
+    void *pRx;                  ///< The buffer of the received bytes (may be pTx), or NULL to discard them
+    uint16_t len;               ///< The bytes of the transfer
+    uint8_t flags;              ///< SSP_BUS_XFER_CS_HOLD
+} ssp_bus_xfer_t;
+
+/// The statistics of a bus
+typedef struct {
+    uint32_t locks;             ///< The locks that were not nested
+    uint32_t contended;         ///< The locks that had to wait for another task
+    uint32_t xfers;             ///< The transfers run by ssp_bus_run()
+    uint32_t reconfigs;         ///< The prescaler or the frame format was re-programmed
+} ssp_bus_stats_t;
+
+
+
+/**
+ * Initializes a device: sets its chip-select pin as an output that is high (not selected).
+ * @note The pins of the SSP itself are set up by ssp0_init() and ssp1_init().
+ */
+void ssp_bus_dev_init(ssp_bus_dev_t *pDev);
+
+/**
+ * @{ Lock of a bus
+ * Only one task uses a bus at a time.  These do nothing before the scheduler is running.
+ * @param priority  The lock is given to the waiting task of the highest priority first
+ * @returns true if the task got the lock, or false if the lock is nested (or the scheduler is not running)
+ */
+bool ssp_bus_lock(ssp_bus_t bus, uint8_t priority);
+void ssp_bus_unlock(ssp_bus_t bus);
+
+/// Same as spi1_yield() for any bus
+bool ssp_bus_yield(ssp_bus_t bus, uint32_t ms);
+
+/// @returns true if a task has locked the bus
+bool ssp_bus_is_locked(ssp_bus_t bus);
+/** @} */
+
+/**
+ * @{ Manual use of a device
+ * ssp_bus_acquire() locks the bus with the priority of the device, and sets up its clock and mode,
+ * then the driver selects the device and uses the ssp0.h or ssp1.h functions until ssp_bus_release().
+ */
+void ssp_bus_acquire(ssp_bus_dev_t *pDev);
+void ssp_bus_setup(ssp_bus_dev_t *pDev);            ///< Sets up the clock and the mode of the device if the bus has other settings
+void ssp_bus_release(ssp_bus_dev_t *pDev);
+void ssp_bus_select(const ssp_bus_dev_t *pDev);     ///< Drives the CS of the device low
+void ssp_bus_deselect(const ssp_bus_dev_t *pDev);   ///< Drives the CS of the device high
+/** @} */
+
+/**
+ * Runs a list of transfers with one lock of the bus, at the highest priority of its devices.
+ * Each transfer selects its device, unless the CS is held from the transfer before, and the clock
+ * and the mode are only set up when the device changes.
+ * @returns false if the devices are not of the same bus, or a DMA transfer failed
+ */
+bool ssp_bus_run(const ssp_bus_xfer_t *pXfers, uint32_t count);
+
+/// Runs one transfer of a device, @see ssp_bus_run()
+bool ssp_bus_transfer(ssp_bus_dev_t *pDev, const void *pTx, void *pRx, uint16_t len);
+
+/// @returns the statistics of a bus
+ssp_bus_stats_t ssp_bus_get_stats(ssp_bus_t bus);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* SSP_BUS_H__ */
@@ -0,0 +1,123 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @ingroup Drivers
+ *
+ * This API drives a stepper motor driver (step and direction pins) from the match
+ * interrupt of the timer selected by SYS_CFG_STEPPER_TIMER.  The step pulses follow
+ * a trapezoidal profile: the motor accelerates up to the maximum speed, cruises, and
+ * decelerates to stop at the end of the move.  The step timing does not depend on
+ * the OS tick or the task scheduling.
+ *
+ * Moves are queued and executed back to back, and each move can give a semaphore
+ * once it is complete.
+ *
+ * @code
+ *      stepper_cfg_t cfg = { LPC_GPIO2, (1 << 3), (1 << 1), 400, 800, NULL };
+ *      stepper_init(&cfg);
+ *
+ *      stepper_move(200, NULL, portMAX_DELAY);  // Queue one revolution of a 200 steps/rev motor
+ *      stepper_move_wait(-200, portMAX_DELAY);  // Queue the move back, and wait until it is done
+ * @endcode
+ *
+ * 20261014: Initial
+ */
+#ifndef STEPPER_H__
+#define STEPPER_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+#include "LPC17xx.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+
+
+/// The maximum number of moves that can be queued
+#define STEPPER_MOVE_QUEUE_SIZE     8
+
+/**
+ * Callback function called from the timer interrupt after each step
+ * @param forward  true if the step was in the positive direction
+ */
+typedef void (*stepper_step_callback_t)(bool forward);
+
+/// Configuration of the stepper engine
+typedef struct {
+    LPC_GPIO_TypeDef *gpio;     ///< The GPIO port of the step and direction pins
+    uint32_t step_pin;          ///< The bitmask of the step pin
+    uint32_t dir_pin;           ///< The bitmask of the direction pin, which is set for positive moves
+    uint32_t max_sps;           ///< Maximum speed in steps per second
+    uint32_t accel_sps2;        ///< Acceleration and deceleration in steps per second squared
+    stepper_step_callback_t on_step; ///< Optional callback after each step (called from the ISR)
+} stepper_cfg_t;
+
+
+
+/**
+ * Initializes the stepper engine and its timer.
+ * The step and direction pins should already be configured as GPIO outputs.
+ * @returns true if successful
+ */
+bool stepper_init(const stepper_cfg_t *cfg);
+
+/**
+ * Changes the speed profile of the moves that begin after this call.
+ * @param max_sps     Maximum speed in steps per second
+ * @param accel_sps2  Acceleration in steps per second squared
+ */
+void stepper_set_speed(uint32_t max_sps, uint32_t accel_sps2);
+
+/**
+ * Queues a move.
+ * @param steps     The number of steps to move, negative steps move in the opposite direction
+ * @param done_sem  Optional semaphore that is given once this move is complete
+ * @param timeout   The time to wait if the move queue is full
+ * @returns true if the move was queued
+ */
+bool stepper_move(int32_t steps, SemaphoreHandle_t done_sem, TickType_t timeout);
+
+/**
+ * Queues a move and waits until it is complete.
+ * @note Only one task should use this function at a time.
+ * @returns true if the move completed within the timeout
+ */
+bool stepper_move_wait(int32_t steps, TickType_t timeout);
+
+/**
+ * Stops the motor immediately, and discards the queued moves.
+ * @note The semaphores of the stopped and discarded moves are not given.
+ */
+void stepper_stop(void);
+
+/// @returns true if the motor is moving or moves are queued
+bool stepper_is_busy(void);
+
+/// @returns the net steps moved since stepper_init()
+int32_t stepper_get_position(void);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* STEPPER_H__ */
@@ -0,0 +1,80 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief UART1 Interrupt driven IO driver with the RTS/CTS hardware flow control
+ * @ingroup Drivers
+ *
+ * 20261014: Initial
+ */
+#ifndef UART1_HPP__
+#define UART1_HPP__
+
+#include "uart_dev.hpp"            // Base class
+#include "singleton_template.hpp"  // Singleton Template
+
+
+
+/// The pins of UART1
+typedef enum {
+    uart1_pins_p2 = 0,  ///< TXD1 P2.0, RXD1 P2.1, CTS1 P2.2, RTS1 P2.7 (shared with the PWM1.1 - 1.3 pins)
+    uart1_pins_p0 = 1,  ///< TXD1 P0.15, RXD1 P0.16, CTS1 P0.17, RTS1 P0.22 (shared with the SSP0 pins)
+} uart1_pins_t;
+
+/**
+ * UART1 Interrupt Driven Driver
+ * UART1 is the only UART with the modem control lines, so this enables the auto-RTS and
+ * auto-CTS of the hardware:
+ *  - The transmitter stops sending while the other side deasserts the CTS.
+ *  - The RTS is deasserted when the Rx FIFO reaches its trigger level (4 bytes).
+ *
+ * The interrupt stops reading the FIFO once the Rx buffer reaches its high watermark (see
+ * UartDev::enableRxFlowControl()), so the RTS stops the sender while the reader task is
+ * descheduled, and no bytes are lost at high baud rates.  The DMA mode is not supported.
+ *
+ * @code
+ *      Uart1 &u1 = Uart1::getInstance();
+ *      u1.init(921600, 256, 64);
+ *      u1.getBlock(buffer, sizeof(buffer));
+ * @endcode
+ * @ingroup Drivers
+ */
+class Uart1 : public UartDev, public SingletonTemplate<Uart1>
+{
+    public:
+        /**
+         * Initializes UART1 at the given @param baudRate
+         * @param rxQSize       The size of the receive queue  (optional, defaults to 128)
+         * @param txQSize       The size of the transmit queue (optional, defaults to 64)
+         * @param flowControl   If true, the RTS/CTS flow control is used
+         * @param pins          The pins of UART1
+         */
+        bool init(unsigned int baudRate, int rxQSize=128, int txQSize=64,
+                  bool flowControl=true, uart1_pins_t pins=uart1_pins_p2);
+
+        /// @returns true if the other side asserts our CTS, which means that we can send
+        bool isClearToSend(void) const;
+
+    private:
+        Uart1();  ///< Private constructor of this Singleton class
+        friend class SingletonTemplate<Uart1>;  ///< Friend class used for Singleton Template
+};
+
+
+#endif /* UART1_HPP__ */
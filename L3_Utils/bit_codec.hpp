@@ -0,0 +1,214 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief Bit packed message fields described by a compile-time layout.
+ *
+ * A layout lists the number of bits of each field of a record, and its size is known at
+ * compile time, so buffers can be sized from it.  Values that do not fit their field are
+ * rejected instead of being truncated, and reading past the data fails.
+ *
+ * @code
+ *      // Version 1 of a record: 12-bit ADC value and 8-bit position
+ *      typedef BitLayout<1, 12, 8> status_layout_t;
+ *
+ *      uint8_t buffer[status_layout_t::totalBytes * 2];
+ *      const uint32_t a[] = { 4095, 200 };
+ *      const uint32_t b[] = { 1234, 10 };
+ *      BitWriter w(buffer, sizeof(buffer));
+ *      status_layout_t::encode(w, a);
+ *      status_layout_t::encode(w, b);         // Records can be batched back to back
+ *
+ *      uint32_t values[status_layout_t::numFields];
+ *      BitReader r(buffer, w.getBytes());
+ *      while (status_layout_t::decode(r, values)) {
+ *          // Use values[0] and values[1]
+ *      }
+ * @endcode
+ *
+ * 20261014 : Initial
+ */
+#ifndef BIT_CODEC_HPP__
+#define BIT_CODEC_HPP__
+
+#include <stdint.h>
+#include <string.h>
+
+
+
+/// Writes bit fields to a buffer, with the first field at the LSB of the first byte
+class BitWriter
+{
+    public:
+        /// Constructor, which clears the buffer
+        BitWriter(void *buffer, uint32_t sizeBytes) :
+            mpBuffer((uint8_t*) buffer), mSizeBits(sizeBytes * 8), mPosBits(0), mOk(true)
+        {
+            memset(buffer, 0, sizeBytes);
+        }
+
+        /**
+         * Writes a field.
+         * @returns false if the value does not fit within the bits, or the buffer is full.
+         *          Once a field fails, the following fields also fail.
+         */
+        bool put(uint32_t value, uint8_t bits)
+        {
+            if (!mOk || 0 == bits || bits > 32 || (mPosBits + bits) > mSizeBits ||
+                (bits < 32 && (value >> bits))) {
+                mOk = false;
+                return false;
+            }
+
+            /* Write the bits of each byte at once */
+            while (bits > 0) {
+                const uint8_t shift = mPosBits & 7;
+                const uint8_t n = (bits < (8 - shift)) ? bits : (8 - shift);
+                mpBuffer[mPosBits >> 3] |= (uint8_t) ((value & ((1U << n) - 1)) << shift);
+                value >>= n;
+                bits -= n;
+                mPosBits += n;
+            }
+            return true;
+        }
+
+        /// @returns the number of bytes used by the fields written so far
+        inline uint32_t getBytes(void) const { return (mPosBits + 7) / 8; }
+
+        /// @returns false if any of the fields could not be written
+        inline bool ok(void) const { return mOk; }
+
+    private:
+        uint8_t *mpBuffer;
+        uint32_t mSizeBits;
+        uint32_t mPosBits;
+        bool mOk;
+};
+
+/// Reads the bit fields written by BitWriter
+class BitReader
+{
+    public:
+        BitReader(const void *data, uint32_t lenBytes) :
+            mpData((const uint8_t*) data), mSizeBits(lenBytes * 8), mPosBits(0)
+        {
+        }
+
+        /**
+         * Reads a field.
+         * @returns false if the data does not have the bits of the field.
+         */
+        bool get(uint32_t &value, uint8_t bits)
+        {
+            uint8_t done = 0;
+
+            if (0 == bits || bits > 32 || (mPosBits + bits) > mSizeBits) {
+                return false;
+            }
+
+            value = 0;
+            while (done < bits) {
+                const uint8_t shift = mPosBits & 7;
+                const uint8_t n = ((bits - done) < (8 - shift)) ? (bits - done) : (8 - shift);
+                const uint32_t b = (mpData[mPosBits >> 3] >> shift) & ((1U << n) - 1);
+                value |= b << done;
+                done += n;
+                mPosBits += n;
+            }
+            return true;
+        }
+
+        /// @returns the number of bits that can still be read
+        inline uint32_t getRemainingBits(void) const { return mSizeBits - mPosBits; }
+
+    private:
+        const uint8_t *mpData;
+        uint32_t mSizeBits;
+        uint32_t mPosBits;
+};
+
+/**
+ * Layout of a record with up to 8 fields of 1-32 bits each.
+ * @tparam V    The version of the layout, which should change when the fields change
+ * @tparam B0   The bits of the first field, and so on; unused fields are 0
+ */
+template <uint8_t V, uint8_t B0, uint8_t B1 = 0, uint8_t B2 = 0, uint8_t B3 = 0,
+          uint8_t B4 = 0, uint8_t B5 = 0, uint8_t B6 = 0, uint8_t B7 = 0>
+class BitLayout
+{
+    public:
+        enum {
+            version    = V,
+            numFields  = (B0 > 0) + (B1 > 0) + (B2 > 0) + (B3 > 0) + (B4 > 0) + (B5 > 0) + (B6 > 0) + (B7 > 0),
+            totalBits  = B0 + B1 + B2 + B3 + B4 + B5 + B6 + B7,
+            totalBytes = (totalBits + 7) / 8
+        };
+
+        /**
+         * Writes one record.
+         * @param values  numFields values, one for each field
+         * @returns false if a value does not fit its field, or the writer is full
+         */
+        static bool encode(BitWriter &w, const uint32_t *values)
+        {
+            const uint8_t *bits = getBits();
+            for (uint8_t i = 0; i < numFields; i++) {
+                if (!w.put(values[i], bits[i])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * Reads one record.
+         * @param values  Where numFields values are written
+         * @returns false if there is not a complete record left
+         */
+        static bool decode(BitReader &r, uint32_t *values)
+        {
+            const uint8_t *bits = getBits();
+            if (r.getRemainingBits() < (uint32_t) totalBits) {
+                return false;
+            }
+            for (uint8_t i = 0; i < numFields; i++) {
+                r.get(values[i], bits[i]);
+            }
+            return true;
+        }
+
+    private:
+        /* Compile-time checks of the layout: fields of 1-32 bits, used fields first */
+        typedef char fieldsTooLarge[(B0 <= 32 && B1 <= 32 && B2 <= 32 && B3 <= 32 &&
+                                     B4 <= 32 && B5 <= 32 && B6 <= 32 && B7 <= 32) ? 1 : -1];
+        typedef char fieldsNotPacked[(B0 > 0 && (B1 > 0 || !B2) && (B2 > 0 || !B3) && (B3 > 0 || !B4) &&
+                                      (B4 > 0 || !B5) && (B5 > 0 || !B6) && (B6 > 0 || !B7)) ? 1 : -1];
+
+        static const uint8_t* getBits(void)
+        {
+            static const uint8_t bits[] = { B0, B1, B2, B3, B4, B5, B6, B7 };
+            return bits;
+        }
+
+        BitLayout();
+};
+
+
+
+#endif /* BIT_CODEC_HPP__ */
@@ -0,0 +1,139 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+/**
+ * @file
+ * @brief Records time stamped binary records at high rates to the raw pages of the SPI flash
+ * @ingroup Utilities
+ *
+ * FatFs updates the FAT and the directory as a file grows, and writes it in sectors, which does
+ * not keep up with the sensor and motion traces of a few thousand records per second.  The black
+ * box instead writes whole pages to the raw region of the SPI flash (@see FLASH_RAW_SECTORS) as a
+ * circular log: once the region is full, the oldest page is overwritten.
+ *
+ * blackbox_record() copies a record to the page being filled in a RAM ring of BLACKBOX_RAM_PAGES,
+ * and can be called by the tasks and the interrupts.  The recorder task writes each full page
+ * with flash_raw_write_page(), which sends the next page while the last one is programmed, so
+ * the log is written at the program speed of the flash memory (about 25K per second).  The
+ * records that do not fit the ring while the flash is busy are counted as dropped.
+ * @code
+ *      blackbox_init(PRIORITY_HIGH);
+ *      blackbox_start();
+ *
+ *      void accel_isr(void)
+ *      {
+ *          const int16_t xyz[3] = { ... };
+ *          blackbox_record(BLACKBOX_ID_ACCEL, xyz, sizeof(xyz));
+ *      }
+ * @endcode
+ *
+ * Each page starts with a blackbox_page_t, followed by the records, and the rest is 0xFF:
+ * @code
+ *      <dt_us:4> <id:1> <len:1> <len bytes>
+ * @endcode
+ * The fields are little-endian, and dt_us is the time of the record after the start_us of its page.
+ * The 'blackbox export' command copies the pages, oldest first, to a file for offline decoding.
+ *
+ * 20261014: Initial
+ */
+#ifndef BLACKBOX_H__
+#define BLACKBOX_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+
+
+
+#define BLACKBOX_RAM_PAGES      4                   ///< The pages of the RAM ring, which covers the stalls of the flash memory
+#define BLACKBOX_MAX_PAGE_BYTES 512                 ///< The largest raw page of the flash memory, @see flash_raw_get_page_bytes()
+#define BLACKBOX_MAX_DATA       64                  ///< The max data bytes of a record
+#define BLACKBOX_FLUSH_MS       500                 ///< A page that is not full is written after this time
+#define BLACKBOX_STACK_SIZE     STACK_BYTES(1024)   ///< The stack of the recorder task
+#define BLACKBOX_PAGE_MAGIC     0x31584242          ///< "BBX1" in the magic of a page
+#define BLACKBOX_REC_HDR_BYTES  6                   ///< The bytes of the header of a record
+
+
+
+/// The header of each page of the log
+typedef struct {
+    uint32_t magic;         ///< BLACKBOX_PAGE_MAGIC
+    uint32_t seq;           ///< Increments with each page of the log, so the newest page is found after a boot
+    uint64_t start_us;      ///< The sys_get_uptime_us() that the dt_us of the records are relative to
+    uint16_t used;          ///< The bytes of the records after the header
+    uint16_t dropped;       ///< The records that did not fit the RAM ring before the records of this page
+    uint16_t session;       ///< Increments with each blackbox_start(), since start_us restarts with a boot
+    uint16_t crc;           ///< The crc16_update() of the header, with the crc as zero, and of the records
+} blackbox_page_t;
+
+/// The statistics of the recorder, @see blackbox_get_stats()
+typedef struct {
+    bool recording;         ///< True while recording
+    uint32_t records;       ///< The records of the current session
+    uint32_t dropped;       ///< The records that did not fit the RAM ring
+    uint32_t pages;         ///< The pages written by the current session
+    uint32_t log_pages;     ///< The pages of the log, up to flash_raw_get_page_count()
+    uint16_t session;       ///< The session of the recording
+    uint16_t max_write_ms;  ///< The longest time to write a page
+    uint8_t watermark;      ///< The most full pages in the RAM ring
+} blackbox_stats_t;
+
+
+
+/**
+ * Allocates the RAM ring, creates the recorder task, and finds the pages of the log
+ * @param priority  The priority of the recorder task, which should be higher than the tasks that
+ *                  use the SPI flash or the SD card, so it is not delayed by them
+ * @returns true if the recorder is ready, or was already initialized
+ */
+bool blackbox_init(UBaseType_t priority);
+
+/**
+ * Finds the newest page of the log, and starts recording after it in a new session
+ * @returns false if there is no raw region, such as if the flash was not formatted with it
+ */
+bool blackbox_start(void);
+
+/// Stops recording, and writes the page being filled
+void blackbox_stop(void);
+
+/**
+ * Records the data with the current time.  This can be called by the tasks and the interrupts.
+ * @returns false if not recording, or if the record did not fit the RAM ring
+ */
+bool blackbox_record(uint8_t id, const void *pData, uint8_t len);
+
+/// @returns the statistics of the recorder
+blackbox_stats_t blackbox_get_stats(void);
+
+/**
+ * Reads a page of the log
+ * @param n         The page of the log, from 0 for the oldest page to blackbox_get_stats().log_pages
+ * @param pPage     The memory of the page of flash_raw_get_page_bytes()
+ * @returns false if there is no such page, or if the page is not valid, such as if its crc does not match
+ */
+bool blackbox_read_page(uint32_t n, void *pPage);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* BLACKBOX_H__ */
@@ -0,0 +1,190 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+/**
+ * @file
+ * @brief Records the CAN traffic to a binary file, such as on the SD card, for offline analysis
+ * @ingroup Utilities
+ *
+ * The tap of each CAN (@see CAN_set_tap()) writes a time stamped record of each frame received
+ * and sent to a RAM ring, and the recorder task appends the ring to a stream file in batches of
+ * whole sectors (@see stream_file.h), so the file system is not updated for each frame.  Printing
+ * the frames from a task cannot keep up with a busy bus, but a record is only 16 bytes, and at
+ * 1Mbps a bus has at most about 9000 frames of 8 bytes per second, or 144K of records per
+ * second.  The ring of CAN_RECORDER_RING_FRAMES covers about 100ms of the stalls of the SD card
+ * at this rate; the frames that do not fit are counted, and a marker of them is recorded.
+ *
+ * The filters select the frames that are recorded, and the trigger (also a filter) can start
+ * the recording with the frames before it, such as to capture what led to an error frame:
+ * @code
+ *      CAN_init(can1, 500, 32, 8, NULL, NULL);
+ *      CAN_bypass_filter_accept_all_msgs();    // Record the whole bus, not only the accepted IDs
+ *      can_recorder_init(CAN_RECORDER_RING_FRAMES, PRIORITY_HIGH);
+ *
+ *      const can_rec_filter_t trigger = { 0x7DF, CAN_REC_KEY_ID_MASK };
+ *      can_recorder_arm("1:can.bin", &trigger, 100, 0);    // 100 frames before 0x7DF, and all after it
+ *      ...
+ *      can_recorder_stop();
+ * @endcode
+ *
+ * The file is a sequence of can_rec_t, which are all 16 bytes, little-endian.  Each record of a
+ * frame has the low 24 bits of its time, and the full time is in the markers: the file starts
+ * with a marker, and if two consecutive records would be CAN_REC_TIME_MASK or more apart, a
+ * marker is recorded between them.  So the time of each record is found from the marker before it,
+ * by adding the differences of the low 24 bits of the records in between.  The frames before a
+ * trigger may be far from the can_rec_start marker, so their time is found going back from the
+ * can_rec_trigger marker.
+ *
+ * @note The frames rejected by the acceptance filter and the FullCAN messages are not seen by the tap.
+ * @note The file is a stream file, so after a power loss, the size of the file should be rounded up
+ *       to whole records, since the zeros at the end of the last record are not part of the file.
+ *
+ * 20261014: Initial
+ */
+#ifndef CAN_RECORDER_H__
+#define CAN_RECORDER_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "ff.h"
+#include "can.h"
+
+
+
+#define CAN_RECORDER_RING_FRAMES    1024                ///< The default size of the RAM ring (16K)
+#define CAN_RECORDER_BATCH_FRAMES   128                 ///< The task is woken up when the ring has this many records (4 sectors)
+#define CAN_RECORDER_SYNC_MS        1000                ///< The partial batch is written and synced this often
+#define CAN_RECORDER_PREALLOC_BYTES (256 * 1024)        ///< The file grows by this much at once, @see stream_file_open()
+#define CAN_RECORDER_MAX_FILTERS    8                   ///< The max number of filters, @see can_recorder_set_filters()
+#define CAN_RECORDER_STACK_SIZE     STACK_BYTES(1536)   ///< The stack of the recorder task
+
+
+
+/** @{ The info of a record of a frame */
+#define CAN_REC_TIME_MASK       0x00FFFFFFU ///< The low 24 bits of the sys_get_uptime_us() of the frame
+#define CAN_REC_DLC_SHIFT       24          ///< The data length is in bits 24-27
+#define CAN_REC_INFO_CAN2       (1U << 28)  ///< The frame is of can2, otherwise of can1
+#define CAN_REC_INFO_TX         (1U << 29)  ///< The frame was sent by this node, otherwise received
+#define CAN_REC_INFO_RTR        (1U << 30)  ///< The frame is an RTR
+#define CAN_REC_INFO_29BIT      (1U << 31)  ///< The ID is 29 bits, otherwise 11 bits
+/** @} */
+
+/** @{ The msg_id of a marker record */
+#define CAN_REC_MARKER          (1U << 31)  ///< Set in the msg_id of a marker, which is not a frame
+#define CAN_REC_MARKER_TYPE(id)     ((can_rec_marker_t) ((id) & 0xFF))      ///< The can_rec_marker_t of a marker
+#define CAN_REC_MARKER_DROPPED(id)  (((id) >> 8) & 0xFFFF)                  ///< The count of a can_rec_dropped marker
+/** @} */
+
+/// The types of the markers, which have the full sys_get_uptime_us() in the data
+typedef enum {
+    can_rec_start   = 1,    ///< The start of a recording, which is the first record of the file
+    can_rec_time    = 2,    ///< The records before and after it are too far apart for the low 24 bits of the time
+    can_rec_trigger = 3,    ///< The next record is the frame that matched the trigger
+    can_rec_dropped = 4,    ///< The frames that did not fit the ring before the next record, @see CAN_REC_MARKER_DROPPED()
+} can_rec_marker_t;
+
+/// A record of the file and of the RAM ring
+typedef struct {
+    uint32_t info;          ///< The time of the record, and for a frame, the CAN_REC_INFO_* and the data length
+    uint32_t msg_id;        ///< The ID of the frame, or CAN_REC_MARKER and the can_rec_marker_t of a marker
+    can_data_t data;        ///< The data of the frame, or the full sys_get_uptime_us() of a marker
+} can_rec_t;
+
+/** @{ The bits of the key of a frame that is matched by a filter */
+#define CAN_REC_KEY_ID_MASK     0x1FFFFFFFU ///< The ID of the frame
+#define CAN_REC_KEY_TX          (1U << 29)  ///< The frame was sent
+#define CAN_REC_KEY_CAN2        (1U << 30)  ///< The frame is of can2
+#define CAN_REC_KEY_29BIT       (1U << 31)  ///< The ID is 29 bits
+/** @} */
+
+/// A filter matches a frame if the key of the frame masked by the mask is equal to the key masked by the mask
+typedef struct {
+    uint32_t key;           ///< The CAN_REC_KEY_* bits of the frames to match
+    uint32_t mask;          ///< The CAN_REC_KEY_* bits that are compared
+} can_rec_filter_t;
+
+/// The states of the recorder
+typedef enum {
+    can_rec_stopped,        ///< Not recording
+    can_rec_armed,          ///< Keeps the frames before the trigger, and waits for the trigger
+    can_rec_recording,      ///< Recording the frames to the file
+    can_rec_done,           ///< Recorded the frames after the trigger, and closed the file
+} can_rec_state_t;
+
+/// The statistics of the recorder, @see can_recorder_get_stats()
+typedef struct {
+    can_rec_state_t state;  ///< The state of the recorder
+    FRESULT error;          ///< The error of the file that stopped the last recording, or FR_OK
+    uint32_t frames;        ///< The frames written to the ring by the last recording
+    uint32_t dropped;       ///< The frames that did not fit the ring
+    uint32_t file_bytes;    ///< The bytes of the file of the last recording
+    uint16_t watermark;     ///< The most records in the ring
+    uint16_t max_write_ms;  ///< The longest time to write a batch to the file
+} can_rec_stats_t;
+
+
+
+/**
+ * Creates the ring and the recorder task, and sets the tap of both CANs.
+ * @param ring_frames  The records of the RAM ring, which is rounded up to whole sectors
+ * @param priority     The priority of the recorder task, which should be higher than the
+ *                     other tasks that write to the same disk, so it can keep up with the bus
+ * @returns true if the recorder is ready, or was already initialized
+ */
+bool can_recorder_init(uint16_t ring_frames, UBaseType_t priority);
+
+/**
+ * Sets the filters of the recorder, which apply to the trigger and to the recording.
+ * A frame is recorded if it matches any of the filters, or if count is zero.
+ * @returns false if there are more than CAN_RECORDER_MAX_FILTERS
+ */
+bool can_recorder_set_filters(const can_rec_filter_t *filters, uint8_t count);
+
+/**
+ * Creates the file, or overwrites it, and starts recording the frames that match the filters.
+ */
+FRESULT can_recorder_start(const char *filename);
+
+/**
+ * Creates the file, or overwrites it, and waits for a frame that matches the trigger.
+ * @param trigger       The trigger, and the frame also needs to match the filters
+ * @param pre_frames    The frames before the trigger that are recorded, up to the size of the ring
+ * @param post_frames   The frames recorded from the trigger on, including the frame of the trigger,
+ *                      or 0 to record until can_recorder_stop()
+ */
+FRESULT can_recorder_arm(const char *filename, const can_rec_filter_t *trigger,
+                         uint16_t pre_frames, uint32_t post_frames);
+
+/**
+ * Stops the recording, writes the rest of the ring to the file, and closes it.
+ * The frames before the trigger are discarded if the trigger did not occur.
+ */
+FRESULT can_recorder_stop(void);
+
+/// @returns the statistics of the recorder
+can_rec_stats_t can_recorder_get_stats(void);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* CAN_RECORDER_H__ */
@@ -0,0 +1,291 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+/**
+ * @file
+ * @brief Typed channels and buffer pools in static storage, shared at link time
+ * @ingroup Utilities
+ *
+ * A raw FreeRTOS queue is shared as a void pointer through scheduler_task::getSharedObject(),
+ * which is looked up by a string or an index at run-time and has no type checking, and its items
+ * are in the heap.  A Channel<T, N> instead has the storage of its N items in the object, so a
+ * global channel is in the .bss and its RAM is known at link time, and it is shared by its symbol
+ * using CHANNEL_DECLARE() and CHANNEL_DEFINE(), so the linker resolves it at no run-time cost.
+ * @code
+ *      // shared_handles.h
+ *      CHANNEL_DECLARE(sensor_channel, int, 4);
+ *
+ *      // producer.cpp
+ *      CHANNEL_DEFINE(sensor_channel, int, 4);
+ *      sensor_channel.send(AS.getX());
+ *
+ *      // consumer.cpp
+ *      int x = 0;
+ *      if (sensor_channel.receive(x, OS_MS(1000))) { ... }
+ * @endcode
+ *
+ * The slots of the items are used in place, and only the one byte index of a slot is passed
+ * through FreeRTOS queues, so an item is not copied into and out of a queue:
+ *  - send() and receive() copy the item once into and out of its slot, which is cheap for a small T.
+ *  - reserve() and commit() let the sender build the item in its slot, and acquire() and release()
+ *    let the receiver use the item in its slot, so a large T is never copied.
+ *
+ * A BufferPool<T, N> is the pool of slots of a Channel on its own.  A pipeline that passes a large
+ * buffer through several tasks allocates it from a pool, passes its pointer through a
+ * Channel<T*, M> from stage to stage, and the last stage frees it back to the pool.
+ *
+ * Each call has a FromISR() variant that never blocks.  The channels are created by
+ * channel_base::initAll() which is called by scheduler_start() before the init() of the tasks,
+ * or by their own init() if they are used earlier.
+ *
+ * 20261014 : Initial
+ */
+#ifndef CHANNEL_HPP_
+#define CHANNEL_HPP_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+
+
+
+/** @{ The channels are shared using their symbols instead of scheduler_task::getSharedObject() */
+#define CHANNEL_DECLARE(name, TYPE, N)      extern Channel<TYPE, N> name            ///< Declares a channel in a header
+#define CHANNEL_DEFINE(name, TYPE, N)       Channel<TYPE, N> name(#name)            ///< Defines the channel in one source file
+#define BUFFER_POOL_DECLARE(name, TYPE, N)  extern BufferPool<TYPE, N> name         ///< Declares a buffer pool in a header
+#define BUFFER_POOL_DEFINE(name, TYPE, N)   BufferPool<TYPE, N> name(#name)         ///< Defines the buffer pool in one source file
+/** @} */
+
+
+
+/**
+ * The base class of the channels and the buffer pools, which keeps the list of all of them such
+ * that they can be created before the tasks use them.
+ */
+class channel_base
+{
+    public:
+        /// Creates the FreeRTOS queues of every channel and pool, @returns false if any failed
+        static bool initAll(void);
+
+        /// Creates the FreeRTOS queues, and may be called again
+        virtual bool init(void) = 0;
+
+        const char* getName(void) const { return mpName; }     ///< @returns the name of the channel
+
+    protected:
+        /// The channels are usually globals, and their constructors run before the RTOS starts
+        channel_base(const char *pName);
+        virtual ~channel_base();
+
+    private:
+        static channel_base *mpList;    ///< The list of all channels and pools
+        channel_base *mpNext;           ///< The next channel of mpList
+        const char * const mpName;      ///< The name of the channel
+};
+
+/**
+ * A pool of N buffers of T in static storage.  A buffer is allocated by alloc() and it is owned by
+ * the caller until it is given back by free().
+ */
+template <typename T, uint32_t N>
+class BufferPool : public channel_base
+{
+    public:
+        BufferPool(const char *pName) : channel_base(pName), mFree(NULL) { }
+
+        bool init(void);
+
+        /// @returns a free buffer, or NULL if none became free within the timeout
+        T* alloc(TickType_t timeout = portMAX_DELAY)
+        {
+            uint8_t index = 0;
+            return (pdTRUE == xQueueReceive(mFree, &index, timeout)) ? &mBuffers[index] : NULL;
+        }
+
+        /// Gives the buffer back to the pool
+        void free(T *pBuffer)
+        {
+            const uint8_t index = indexOf(pBuffer);
+            xQueueSend(mFree, &index, 0);
+        }
+
+        /// @returns a free buffer, or NULL if none is free
+        T* allocFromISR(BaseType_t *pHigherPriorityTaskWoken)
+        {
+            uint8_t index = 0;
+            return (pdTRUE == xQueueReceiveFromISR(mFree, &index, pHigherPriorityTaskWoken)) ? &mBuffers[index] : NULL;
+        }
+
+        /// Gives the buffer back to the pool from an ISR
+        void freeFromISR(T *pBuffer, BaseType_t *pHigherPriorityTaskWoken)
+        {
+            const uint8_t index = indexOf(pBuffer);
+            xQueueSendFromISR(mFree, &index, pHigherPriorityTaskWoken);
+        }
+
+        /// @returns the number of free buffers
+        uint32_t getFreeCount(void) const { return uxQueueMessagesWaiting(mFree); }
+
+        /** @{ Used by the Channel that owns its pool */
+        T* getBuffer(uint8_t index)             { return &mBuffers[index]; }
+        uint8_t indexOf(const T *pBuffer) const { return (uint8_t) (pBuffer - &mBuffers[0]); }
+        /** @} */
+
+    private:
+        /// The indexes fit in one byte
+        typedef char size_check_t[(N > 0 && N <= 255) ? 1 : -1];
+
+        T mBuffers[N];          ///< The buffers
+        QueueHandle_t mFree;    ///< The indexes of the free buffers
+};
+
+/**
+ * A channel of up to N items of T, in the order they were sent.  It may have any number of
+ * senders and receivers, and a receiver gets each item once.
+ */
+template <typename T, uint32_t N>
+class Channel : public channel_base
+{
+    public:
+        Channel(const char *pName) : channel_base(pName), mPool(pName), mFilled(NULL) { }
+
+        bool init(void);
+
+        /** @{ Copies the item into and out of its slot */
+        bool send(const T& item, TickType_t timeout = portMAX_DELAY)
+        {
+            T *pSlot = reserve(timeout);
+            if (NULL != pSlot) {
+                *pSlot = item;
+                commit(pSlot);
+            }
+            return (NULL != pSlot);
+        }
+        bool receive(T& item, TickType_t timeout = portMAX_DELAY)
+        {
+            T *pSlot = acquire(timeout);
+            if (NULL != pSlot) {
+                item = *pSlot;
+                release(pSlot);
+            }
+            return (NULL != pSlot);
+        }
+        /** @} */
+
+        /**
+         * @{ Zero-copy: the sender builds the item in the slot given by reserve(), and sends it by
+         * commit().  The receiver uses the item in the slot given by acquire(), and then gives
+         * the slot back by release().
+         */
+        T* reserve(TickType_t timeout = portMAX_DELAY) { return mPool.alloc(timeout); }
+        void commit(T *pSlot)
+        {
+            const uint8_t index = mPool.indexOf(pSlot);
+            xQueueSend(mFilled, &index, 0);
+        }
+        T* acquire(TickType_t timeout = portMAX_DELAY)
+        {
+            uint8_t index = 0;
+            return (pdTRUE == xQueueReceive(mFilled, &index, timeout)) ? mPool.getBuffer(index) : NULL;
+        }
+        void release(T *pSlot) { mPool.free(pSlot); }
+        /** @} */
+
+        /** @{ The variants for an ISR, which do not block */
+        bool sendFromISR(const T& item, BaseType_t *pHigherPriorityTaskWoken)
+        {
+            T *pSlot = reserveFromISR(pHigherPriorityTaskWoken);
+            if (NULL != pSlot) {
+                *pSlot = item;
+                commitFromISR(pSlot, pHigherPriorityTaskWoken);
+            }
+            return (NULL != pSlot);
+        }
+        bool receiveFromISR(T& item, BaseType_t *pHigherPriorityTaskWoken)
+        {
+            T *pSlot = acquireFromISR(pHigherPriorityTaskWoken);
+            if (NULL != pSlot) {
+                item = *pSlot;
+                releaseFromISR(pSlot, pHigherPriorityTaskWoken);
+            }
+            return (NULL != pSlot);
+        }
+        T* reserveFromISR(BaseType_t *pHigherPriorityTaskWoken) { return mPool.allocFromISR(pHigherPriorityTaskWoken); }
+        void commitFromISR(T *pSlot, BaseType_t *pHigherPriorityTaskWoken)
+        {
+            const uint8_t index = mPool.indexOf(pSlot);
+            xQueueSendFromISR(mFilled, &index, pHigherPriorityTaskWoken);
+        }
+        T* acquireFromISR(BaseType_t *pHigherPriorityTaskWoken)
+        {
+            uint8_t index = 0;
+            return (pdTRUE == xQueueReceiveFromISR(mFilled, &index, pHigherPriorityTaskWoken)) ? mPool.getBuffer(index) : NULL;
+        }
+        void releaseFromISR(T *pSlot, BaseType_t *pHigherPriorityTaskWoken) { mPool.freeFromISR(pSlot, pHigherPriorityTaskWoken); }
+        /** @} */
+
+        /// @returns the number of items that are sent and not yet received
+        uint32_t getCount(void) const { return uxQueueMessagesWaiting(mFilled); }
+
+        /**
+         * @returns the queue of the indexes of the sent items, which may be added to a queue set such
+         * as scheduler_task::initQueueSet(); once it is selected, use acquire() or receive() with no timeout.
+         */
+        QueueHandle_t getQueue(void) const { return mFilled; }
+
+    private:
+        BufferPool<T, N> mPool;     ///< The slots of the items
+        QueueHandle_t mFilled;      ///< The indexes of the sent items in the order they were sent
+};
+
+
+
+template <typename T, uint32_t N>
+bool BufferPool<T, N>::init(void)
+{
+    if (NULL != mFree) {
+        return true;
+    }
+
+    QueueHandle_t queue = xQueueCreate(N, sizeof(uint8_t));
+    if (NULL == queue) {
+        return false;
+    }
+    for (uint32_t i = 0; i < N; i++) {
+        const uint8_t index = (uint8_t) i;
+        xQueueSend(queue, &index, 0);
+    }
+
+    mFree = queue;
+    return true;
+}
+
+template <typename T, uint32_t N>
+bool Channel<T, N>::init(void)
+{
+    if (NULL == mFilled) {
+        mFilled = xQueueCreate(N, sizeof(uint8_t));
+    }
+    return mPool.init() && (NULL != mFilled);
+}
+
+
+
+#endif /* CHANNEL_HPP_ */
@@ -0,0 +1,146 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief Multiplexes several char device channels over one link, such as one TCP connection
+ * @ingroup Utilities
+ *
+ * The data of each channel is sent over the link in frames, so several streams (such as a
+ * terminal session and HTTP requests) share one link at the same time:
+ * @code
+ *      0xC3 | channel | len | len bytes of data | sum
+ * @endcode
+ * The sum is the one's complement of the 8-bit sum of the channel, the len and the data, so the
+ * receiver can find the next frame if it starts in the middle of one.  The frames with a bad sum
+ * or an unknown channel are dropped.
+ *
+ * A task of the mux receives the frames of the link into the receive ring of each channel, and
+ * sends the data written to a channel once CHAR_MUX_FLUSH_MS passed, the frame is full, or the
+ * channel is flushed.  The data that does not fit the receive ring of its channel is dropped.
+ *
+ * @code
+ *      CharMux mux(Uart3::getInstance());
+ *      mux.start(PRIORITY_MEDIUM);
+ *      addCommandChannel(&mux.getChannel(0), false);
+ *      mux.getChannel(1).printf("Hello\n");
+ * @endcode
+ */
+#ifndef CHAR_MUX_HPP_
+#define CHAR_MUX_HPP_
+
+#include <stdint.h>
+#include "char_dev.hpp"
+#include "circular_buffer.hpp"
+
+
+
+#define CHAR_MUX_CHANNELS       2       ///< The number of channels of a mux
+#define CHAR_MUX_RX_BYTES       256     ///< The receive ring of each channel
+#define CHAR_MUX_FRAME_BYTES    64      ///< The max data bytes of a frame (less than 256)
+#define CHAR_MUX_FLUSH_MS       20      ///< The data written to a channel is sent after this time
+#define CHAR_MUX_STACK_SIZE     (512 / 4)   ///< Stack size of the mux task in 32-bit words
+#define CHAR_MUX_SYNC           0xC3    ///< The first byte of a frame
+
+
+
+/**
+ * The multiplexer of the channels over a link.
+ * @ingroup Utilities
+ */
+class CharMux
+{
+    public:
+        /// Constructor; the link is only used by the mux after start()
+        CharMux(CharDev& link);
+
+        /// Creates the task that receives the frames of the link and sends the data of the channels
+        bool start(uint8_t priority);
+
+        /// @returns the char device of the channel, which must be less than CHAR_MUX_CHANNELS
+        CharDev& getChannel(uint8_t channel) { return mChannels[channel]; }
+
+        /// @returns the number of received bytes that were dropped (bad frames, or full receive rings)
+        uint32_t getDroppedCount(void) const { return mDropped; }
+
+    private:
+        CharMux(const CharMux&);            ///< Disallow copy
+        CharMux& operator=(const CharMux&); ///< Disallow assignment
+
+        /// One channel of the mux
+        class Channel : public CharDev
+        {
+            public:
+                Channel();
+
+                /// Sets the mux and the number of this channel
+                void init(CharMux *pMux, uint8_t number) { mpMux = pMux; mNumber = number; }
+
+                /// Stores the data received from the link, and signals the reader
+                bool receive(const uint8_t *pData, uint8_t len);
+
+                /// Sends the data written to this channel
+                bool flush(void);
+
+                /** @{ Virtual function overrides for the base class to work */
+                bool getChar(char* pInputChar, unsigned int timeout=portMAX_DELAY);
+                bool putChar(char out, unsigned int timeout=portMAX_DELAY);
+                bool putBlock(const void* pData, size_t len, unsigned int timeout=portMAX_DELAY);
+                bool setRxEvent(SemaphoreHandle_t event) { mRxEvent = event; return true; }
+                /** @} */
+
+            private:
+                CharMux *mpMux;                     ///< The mux of this channel
+                uint8_t mNumber;                    ///< The number of this channel
+                SpscRingBuffer<char> mRx;           ///< The data received for this channel
+                SemaphoreHandle_t mRxSignal;        ///< Given when data is received
+                SemaphoreHandle_t mRxEvent;         ///< @see setRxEvent()
+                SemaphoreHandle_t mTxLock;          ///< Lock of mTx[]
+                uint8_t mTxLen;                     ///< The bytes in mTx[]
+                uint8_t mTx[CHAR_MUX_FRAME_BYTES];  ///< The data written but not yet sent
+        };
+
+        /// The state of the frame being received
+        typedef enum {
+            rx_sync,
+            rx_channel,
+            rx_len,
+            rx_data,
+            rx_sum,
+        } rxState_t;
+
+        static void task(void *p);              ///< The task of the mux
+        void receive(uint8_t byte);             ///< Receives a byte of a frame
+        bool sendFrame(uint8_t channel, const uint8_t *pData, uint8_t len);
+
+        CharDev& mLink;                         ///< The link of the frames
+        SemaphoreHandle_t mLinkLock;            ///< Lock of sending the frames to the link
+        Channel mChannels[CHAR_MUX_CHANNELS];   ///< The channels
+        uint32_t mDropped;                      ///< @see getDroppedCount()
+
+        rxState_t mRxState;                     ///< The state of the frame being received
+        uint8_t mRxChannel;                     ///< The channel of the frame being received
+        uint8_t mRxLen;                         ///< The data bytes of the frame being received
+        uint8_t mRxCount;                       ///< The data bytes received of the frame
+        uint8_t mRxSum;                         ///< The sum of the frame being received
+        uint8_t mRxData[CHAR_MUX_FRAME_BYTES];  ///< The data of the frame being received
+};
+
+
+
+#endif /* CHAR_MUX_HPP_ */
@@ -21,6 +21,8 @@
 * @brief Circular buffer
 * @ingroup Utilities
 *
+* Version: 20261014    Added Pow2RingBuffer
+* Version: 20141012    Added SpscRingBuffer
 * Version: 20140305    Initial
 */
 #ifndef CIRCULAR_BUFFER_HPP__
@@ -28,6 +30,7 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <iterator>
 
 
@@ -339,6 +342,348 @@ bool CircularBuffer<TYPE>::peek_front(TYPE* dataPtr)
 
 
 
+/**
+ * Compiler memory barrier used by SpscRingBuffer.  This is sufficient on a single core CPU
+ * such as the Cortex-M3 because the CPU itself does not reorder the memory accesses that
+ * an interrupt would observe; we only need to prevent the compiler from doing so.
+ */
+#define SPSC_RING_BARRIER()     __asm volatile ("" ::: "memory")
+
+/**
+ * Single-producer, single-consumer lock-free ring buffer
+ * @ingroup Utilities
+ *
+ * Unlike a FreeRTOS queue, this has no critical section, no task event list, and no
+ * memcpy through void pointers.  Only the producer writes the head index, and only the
+ * consumer writes the tail index, so one side can be an ISR, and the other side can be
+ * a task without disabling interrupts.
+ *
+ * There is no blocking built in.  The typical use is that the producer ISR gives a binary
+ * semaphore if the buffer was empty before it pushed the data, and the consumer task blocks
+ * on the semaphore only when the buffer is empty.
+ *
+ * @warning If there are multiple producers (or multiple consumers), the user must serialize
+ *          them, for example by using a critical section on the producer side.
+ *
+ * @code
+ *  SpscRingBuffer<char> rx(64);
+ *  // ISR:
+ *  const bool wasEmpty = rx.empty();
+ *  rx.push(c);
+ *  if (wasEmpty) xSemaphoreGiveFromISR(sig, &woken);
+ *  // Task:
+ *  while (!rx.pop(&c)) xSemaphoreTake(sig, portMAX_DELAY);
+ * @endcode
+ */
+template <typename TYPE>
+class SpscRingBuffer
+{
+public:
+    /// Constructor with the number of elements that can be stored
+    SpscRingBuffer(uint32_t capacity) : mSize(capacity + 1), mHead(0), mTail(0), mpArray(new TYPE[capacity + 1]) { }
+    ~SpscRingBuffer() { delete [] mpArray; }
+
+    /**
+     * @{ Producer API
+     * @returns true if the element was pushed, or the number of elements pushed for the bulk push.
+     */
+    bool push(const TYPE& data)
+    {
+        const uint32_t head = mHead;
+        const uint32_t next = nextIndex(head);
+
+        if (next == mTail) {
+            return false;
+        }
+
+        mpArray[head] = data;
+        SPSC_RING_BARRIER();
+        mHead = next;
+        return true;
+    }
+    uint32_t push(const TYPE* pData, uint32_t count)
+    {
+        uint32_t head = mHead;
+        const uint32_t tail = mTail;
+        uint32_t pushed = 0;
+
+        for (pushed = 0; pushed < count; pushed++) {
+            const uint32_t next = nextIndex(head);
+            if (next == tail) {
+                break;
+            }
+            mpArray[head] = pData[pushed];
+            head = next;
+        }
+
+        /* Publish all the elements at once */
+        SPSC_RING_BARRIER();
+        mHead = head;
+        return pushed;
+    }
+    /** @} */
+
+    /**
+     * @{ Consumer API
+     * @returns true if an element was popped, or the number of elements popped for the bulk pop.
+     */
+    bool pop(TYPE* pData)
+    {
+        const uint32_t tail = mTail;
+
+        if (tail == mHead) {
+            return false;
+        }
+
+        *pData = mpArray[tail];
+        SPSC_RING_BARRIER();
+        mTail = nextIndex(tail);
+        return true;
+    }
+    uint32_t pop(TYPE* pData, uint32_t count)
+    {
+        const uint32_t head = mHead;
+        uint32_t tail = mTail;
+        uint32_t popped = 0;
+
+        for (popped = 0; popped < count && tail != head; popped++) {
+            pData[popped] = mpArray[tail];
+            tail = nextIndex(tail);
+        }
+
+        SPSC_RING_BARRIER();
+        mTail = tail;
+        return popped;
+    }
+    bool peek(TYPE* pData) const
+    {
+        const uint32_t tail = mTail;
+        if (tail == mHead) {
+            return false;
+        }
+        *pData = mpArray[tail];
+        return true;
+    }
+    /// Discards all the elements; this should only be called by the consumer
+    void clear(void) { mTail = mHead; }
+    /** @} */
+
+    /// @returns the number of elements stored in the buffer
+    uint32_t size(void) const
+    {
+        const uint32_t head = mHead;
+        const uint32_t tail = mTail;
+        return (head >= tail) ? (head - tail) : (mSize - tail + head);
+    }
+
+    uint32_t capacity(void) const { return (mSize - 1);             } ///< @returns the capacity
+    bool empty(void) const        { return (mHead == mTail);          } ///< @returns true if empty
+    bool full(void) const         { return (nextIndex(mHead) == mTail); } ///< @returns true if full
+
+private:
+    SpscRingBuffer(const SpscRingBuffer&);            ///< Disallow copy constructor
+    SpscRingBuffer& operator=(const SpscRingBuffer&); ///< Disallow = operator
+
+    inline uint32_t nextIndex(uint32_t index) const { return (++index >= mSize) ? 0 : index; }
+
+    const uint32_t mSize;       ///< Size of the array which is one more than the capacity
+    volatile uint32_t mHead;    ///< Next write index, only written by the producer
+    volatile uint32_t mTail;    ///< Next read index, only written by the consumer
+    TYPE * const mpArray;       ///< The array of elements
+};
+
+
+
+/**
+ * Ring buffer with a power-of-two capacity that is given at compile time
+ * @ingroup Utilities
+ *
+ * The head and the tail are free running counters that are masked to index the array, so
+ * there is no modulo, no branch to wrap the index, and all CAPACITY elements can be used.
+ * Like SpscRingBuffer, only the producer writes the head and only the consumer writes the
+ * tail, so one side can be an ISR.
+ *
+ * Besides the single elements, the data is moved in blocks:
+ *  - push_bulk() and pop_bulk() memcpy up to two spans instead of one element at a time.
+ *  - contiguous_write_span() and contiguous_read_span() return the free or the used part of
+ *    the array up to its end, so the data can be written to or read from the buffer by the
+ *    DMA or by a function such as f_read() without a copy, and then commit_write() or
+ *    commit_read() publishes or frees the elements that were used.
+ *
+ * @warning The bulk functions use memcpy(), so TYPE must be a plain data type.
+ *
+ * @code
+ *  Pow2RingBuffer<char, 256> rx;
+ *  // Producer: DMA or read straight into the buffer
+ *  char *pSpan = NULL;
+ *  uint32_t n = rx.contiguous_write_span(&pSpan);
+ *  n = read_some(pSpan, n);
+ *  rx.commit_write(n);
+ *  // Consumer: use the data in place
+ *  const char *pData = NULL;
+ *  n = rx.contiguous_read_span(&pData);
+ *  write_some(pData, n);
+ *  rx.commit_read(n);
+ * @endcode
+ */
+template <typename TYPE, uint32_t CAPACITY>
+class Pow2RingBuffer
+{
+public:
+    Pow2RingBuffer() : mHead(0), mTail(0) { }
+
+    /**
+     * @{ Producer API
+     * @returns true if the element was pushed, or the number of elements pushed for the bulk push.
+     */
+    bool push_back(const TYPE& data)
+    {
+        const uint32_t head = mHead;
+        if ((head - mTail) >= CAPACITY) {
+            return false;
+        }
+
+        mArray[head & MASK] = data;
+        SPSC_RING_BARRIER();
+        mHead = head + 1;
+        return true;
+    }
+    uint32_t push_bulk(const TYPE* pData, uint32_t count)
+    {
+        const uint32_t head = mHead;
+        const uint32_t space = CAPACITY - (head - mTail);
+        if (count > space) {
+            count = space;
+        }
+
+        copySpans(&mArray[0], head & MASK, pData, count, true);
+        SPSC_RING_BARRIER();
+        mHead = head + count;
+        return count;
+    }
+
+    /// @returns the free elements up to the end of the array, and the pointer to the first one
+    uint32_t contiguous_write_span(TYPE** ppSpan)
+    {
+        const uint32_t head = mHead;
+        const uint32_t space = CAPACITY - (head - mTail);
+        const uint32_t toEnd = CAPACITY - (head & MASK);
+
+        *ppSpan = &mArray[head & MASK];
+        return (space < toEnd) ? space : toEnd;
+    }
+    /// Publishes the elements written to the span of contiguous_write_span()
+    void commit_write(uint32_t count)
+    {
+        SPSC_RING_BARRIER();
+        mHead = mHead + count;
+    }
+    /** @} */
+
+    /**
+     * @{ Consumer API
+     * @returns true if an element was popped, or the number of elements popped for the bulk pop.
+     */
+    bool pop_front(TYPE* pData)
+    {
+        const uint32_t tail = mTail;
+        if (tail == mHead) {
+            return false;
+        }
+
+        *pData = mArray[tail & MASK];
+        SPSC_RING_BARRIER();
+        mTail = tail + 1;
+        return true;
+    }
+    uint32_t pop_bulk(TYPE* pData, uint32_t count)
+    {
+        const uint32_t tail = mTail;
+        const uint32_t used = mHead - tail;
+        if (count > used) {
+            count = used;
+        }
+
+        copySpans(pData, tail & MASK, &mArray[0], count, false);
+        SPSC_RING_BARRIER();
+        mTail = tail + count;
+        return count;
+    }
+    bool peek_front(TYPE* pData) const
+    {
+        const uint32_t tail = mTail;
+        if (tail == mHead) {
+            return false;
+        }
+        *pData = mArray[tail & MASK];
+        return true;
+    }
+
+    /// @returns the used elements up to the end of the array, and the pointer to the oldest one
+    uint32_t contiguous_read_span(const TYPE** ppSpan) const
+    {
+        const uint32_t tail = mTail;
+        const uint32_t used = mHead - tail;
+        const uint32_t toEnd = CAPACITY - (tail & MASK);
+
+        *ppSpan = &mArray[tail & MASK];
+        return (used < toEnd) ? used : toEnd;
+    }
+    /// Frees the elements read from the span of contiguous_read_span()
+    void commit_read(uint32_t count)
+    {
+        SPSC_RING_BARRIER();
+        mTail = mTail + count;
+    }
+
+    /// Discards all the elements; this should only be called by the consumer
+    void clear(void) { mTail = mHead; }
+    /** @} */
+
+    /// Index operator, where index 0 is the oldest element
+    const TYPE& operator [] (uint32_t index) const { return mArray[(mTail + index) & MASK]; }
+
+    uint32_t size(void) const     { return (mHead - mTail);             } ///< @returns the number of elements
+    uint32_t capacity(void) const { return CAPACITY;                    } ///< @returns the capacity
+    bool empty(void) const        { return (mHead == mTail);            } ///< @returns true if empty
+    bool full(void) const         { return ((mHead - mTail) >= CAPACITY); } ///< @returns true if full
+
+private:
+    Pow2RingBuffer(const Pow2RingBuffer&);            ///< Disallow copy constructor
+    Pow2RingBuffer& operator=(const Pow2RingBuffer&); ///< Disallow = operator
+
+    static const uint32_t MASK = CAPACITY - 1;  ///< Mask of the array index
+
+    /// Fails to compile if the CAPACITY is not a power of two
+    typedef char capacity_is_pow2[(CAPACITY > 0 && 0 == (CAPACITY & MASK)) ? 1 : -1];
+
+    /**
+     * Copies count elements between pData and the array starting at the index, which wraps
+     * around to the start of the array at most once.
+     * @param toArray  If true, pData is copied to the array, otherwise the array is copied to pData
+     */
+    void copySpans(TYPE* pDst, uint32_t index, const TYPE* pSrc, uint32_t count, bool toArray)
+    {
+        const uint32_t toEnd = CAPACITY - index;
+        const uint32_t first = (count < toEnd) ? count : toEnd;
+
+        if (toArray) {
+            memcpy(&pDst[index], pSrc, first * sizeof(TYPE));
+            memcpy(&pDst[0], &pSrc[first], (count - first) * sizeof(TYPE));
+        }
+        else {
+            memcpy(pDst, &pSrc[index], first * sizeof(TYPE));
+            memcpy(&pDst[first], &pSrc[0], (count - first) * sizeof(TYPE));
+        }
+    }
+
+    volatile uint32_t mHead;    ///< Count of the elements written, only written by the producer
+    volatile uint32_t mTail;    ///< Count of the elements read, only written by the consumer
+    TYPE mArray[CAPACITY];      ///< The array of elements
+};
+
+
+
 #ifdef TESTING
 #include <assert.h>
 static inline void test_CircularBuffer(void)
@@ -478,6 +823,83 @@ static inline void test_CircularBuffer(void)
 
     puts("\nCircular Buffer Tests Successful!");
 }
+
+static inline void test_SpscRingBuffer(void)
+{
+    SpscRingBuffer <int> r(3);
+    int x = 0;
+    int data[4] = { 1, 2, 3, 4 };
+
+    assert(3 == r.capacity());
+    assert(r.empty());
+    assert(!r.pop(&x));
+
+    assert(r.push(1));
+    assert(r.push(2));
+    assert(r.push(3));
+    assert(!r.push(4));
+    assert(r.full());
+    assert(3 == r.size());
+
+    assert(r.peek(&x) && 1 == x);
+    assert(r.pop(&x) && 1 == x);
+    assert(r.push(4));  // Wraps around
+    assert(r.pop(&x) && 2 == x);
+    assert(r.pop(&x) && 3 == x);
+    assert(r.pop(&x) && 4 == x);
+    assert(r.empty());
+
+    // Bulk push and pop
+    assert(3 == r.push(data, 4));
+    assert(3 == r.size());
+    int out[4] = { 0 };
+    assert(2 == r.pop(out, 2));
+    assert(1 == out[0] && 2 == out[1]);
+    assert(2 == r.push(data, 2));
+    assert(3 == r.pop(out, 4));
+    assert(3 == out[0] && 1 == out[1] && 2 == out[2]);
+    assert(0 == r.size());
+
+    puts("\nSPSC Ring Buffer Tests Successful!");
+}
+
+static inline void test_Pow2RingBuffer(void)
+{
+    Pow2RingBuffer <char, 4> r;
+    char out[4] = { 0 };
+    const char *pRead = NULL;
+    char *pWrite = NULL;
+
+    assert(4 == r.capacity());
+    assert(r.empty());
+    assert(0 == r.contiguous_read_span(&pRead));
+
+    // Bulk push and pop that wrap around
+    assert(3 == r.push_bulk("abc", 3));
+    assert(2 == r.pop_bulk(out, 2));
+    assert('a' == out[0] && 'b' == out[1]);
+    assert(3 == r.push_bulk("defg", 4));
+    assert(r.full());
+    assert(!r.push_back('h'));
+    assert('c' == r[0] && 'f' == r[3]);
+    assert(4 == r.pop_bulk(out, 4));
+    assert(0 == memcmp(out, "cdef", 4));
+    assert(r.empty());
+
+    // The spans end at the end of the array
+    assert(2 == r.contiguous_write_span(&pWrite));
+    pWrite[0] = 'x'; pWrite[1] = 'y';
+    r.commit_write(2);
+    assert(2 == r.contiguous_write_span(&pWrite));
+    assert(2 == r.contiguous_read_span(&pRead));
+    assert('x' == pRead[0] && 'y' == pRead[1]);
+    r.commit_read(2);
+    assert(r.push_back('z'));
+    assert(r.peek_front(&out[0]) && 'z' == out[0]);
+    assert(1 == r.contiguous_read_span(&pRead) && 'z' == *pRead);
+
+    puts("\nPow2 Ring Buffer Tests Successful!");
+}
 #endif /* #ifdef TESTING */
 
 
@@ -0,0 +1,131 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief Splits the parameters of a command into tokens once, without copying them
+ * @ingroup Utilities
+ *
+ * A handler that looks for each option by str::containsIgnoreCase() and str::subString() scans the
+ * parameters again for each option, and copies the rest of the parameters to a new str each time.
+ * CmdArgs instead splits the parameters at the spaces once, into the views of up to CMD_ARGS_MAX
+ * tokens that point into the parameters; nothing is allocated or copied.  A token in double
+ * quotes may have spaces, and the quotes are not part of the token.
+ *
+ * An option is a token that starts with its name, and its value is the rest of the token, or the
+ * next token if the option is a token of its own: "-t1000" and "-t 1000" both give 1000 for "-t".
+ * The names are not case sensitive, and an option only matches one of the tokens of the flags.
+ * @code
+ *      CMD_HANDLER_FUNC(fooHandler)
+ *      {
+ *          CmdArgs args(cmdParams);
+ *          int timeout = 1000;
+ *          char text[16] = "A";
+ *
+ *          const bool master = args.hasFlag("--master");
+ *          args.getInt("-t", timeout);             // timeout is unchanged if there is no "-t"
+ *          args.getString("-c", text, sizeof(text));
+ *          ...
+ *      }
+ * @endcode
+ * @warning The views point into the parameters, so the str must not change while CmdArgs is used.
+ *
+ * 20261014 : Initial
+ */
+#ifndef CMD_ARGS_HPP_
+#define CMD_ARGS_HPP_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "str.hpp"
+
+
+
+#define CMD_ARGS_MAX    16      ///< The max number of tokens; the rest of the parameters is ignored
+
+
+
+/// A token of CmdArgs, which is not nul terminated
+typedef struct {
+    const char *p;      ///< The first character, or NULL if the token does not exist
+    uint16_t len;       ///< The number of characters
+} cmd_arg_view_t;
+
+/**
+ * The tokens of the parameters of a command
+ */
+class CmdArgs
+{
+    public:
+        CmdArgs(const str& params);         ///< Splits the parameters of the handler
+        CmdArgs(const char *pParams);       ///< Splits a nul terminated string
+
+        /// @returns the number of tokens
+        uint8_t count(void) const { return mCount; }
+
+        /// @returns the token at the index, or a view with NULL if the index does not exist
+        cmd_arg_view_t operator[](uint8_t index) const;
+
+        /// @returns true if the token at the index is the text (not case sensitive)
+        bool equals(uint8_t index, const char *pText) const;
+
+        /// @returns true if one of the tokens is the flag, such as "--master"
+        bool hasFlag(const char *pName) const;
+
+        /**
+         * @returns the value of an option, which is the rest of its token, or the next token
+         *          if the option is a token of its own, or a view with NULL if there is no option
+         */
+        cmd_arg_view_t getValue(const char *pName) const;
+
+        /**
+         * @{ Gets the value of an option, in decimal or in hex with 0x
+         * @returns false without changing the value if there is no option, or its value is not a number
+         */
+        bool getInt(const char *pName, int &value) const;
+        bool getUint(const char *pName, unsigned int &value) const;
+        /** @} */
+
+        /**
+         * Copies the value of an option, nul terminated and truncated to the size of the buffer
+         * @returns false without changing the buffer if there is no option
+         */
+        bool getString(const char *pName, char *pBuffer, size_t size) const;
+
+        /**
+         * @{ Converts a token to a number, same as getInt() and getUint()
+         * @returns false if the token is not a number
+         */
+        static bool toInt(const cmd_arg_view_t& arg, int &value);
+        static bool toUint(const cmd_arg_view_t& arg, unsigned int &value);
+        /** @} */
+
+    private:
+        void split(const char *pParams);    ///< Finds the tokens of the parameters
+
+        /// @returns the index of the token that starts with the option, or mCount if none
+        uint8_t find(const char *pName, uint16_t nameLen) const;
+
+        cmd_arg_view_t mArgs[CMD_ARGS_MAX]; ///< The tokens
+        uint8_t mCount;                     ///< The number of tokens
+};
+
+
+
+#endif /* CMD_ARGS_HPP_ */
@@ -0,0 +1,137 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief Binary command frames that run the handlers of a CommandProcessor
+ * @ingroup Utilities
+ *
+ * A host program can send binary frames on the same channel as the text commands.  A frame
+ * starts with a sync byte that is never typed at a terminal, and the fields are little-endian:
+ * @code
+ *      Request  : 0xA5 | seq | flags  | id (2) | len (2) | len bytes of parameters | crc (2)
+ *      Response : 0x5A | seq | status | id (2) | len (2) | len bytes of output     | crc (2)
+ * @endcode
+ *
+ * The id is the command ID of CommandProcessor::handleCommandId(), and id 0xFFFF responds with
+ * the names of the commands in the order of their IDs, each followed by a newline.  The request
+ * parameters are the text the command would get after its name, or an array of int32 values if
+ * the flags have cmd_frame_int_args, which are given to the handler as decimal text ("0 512").
+ * The crc is the CRC-16-CCITT (0x1021 polynomial, 0xFFFF initial value) of all the bytes after
+ * the sync byte up to the crc itself.
+ *
+ * The output of the handler is sent in responses of up to COMMAND_FRAME_RSP_BYTES, and all but
+ * the last response of a command have cmd_frame_more set in their status.  A handler that reads
+ * more data from its output device (such as the raw bytes of "file buffer") reads it from the
+ * channel right after the request frame, just like a text command does.
+ *
+ * The requests are handled in the order they arrive and every response echoes the seq of its
+ * request, so the host can send several requests without waiting for their responses, as long
+ * as they fit the receive buffer of the channel.
+ */
+#ifndef COMMAND_FRAME_HPP_
+#define COMMAND_FRAME_HPP_
+
+#include <stdint.h>
+#include "char_dev.hpp"
+#include "command_handler.hpp"
+
+
+
+#define COMMAND_FRAME_RSP_BYTES         128     ///< The maximum output bytes of one response frame
+#define COMMAND_FRAME_TIMEOUT_MS        100     ///< Timeout to receive each part of a request frame
+
+
+
+/// The sync bytes of the frames
+enum {
+    cmd_frame_req_sync = 0xA5,      ///< The first byte of a request
+    cmd_frame_rsp_sync = 0x5A,      ///< The first byte of a response
+    cmd_frame_list_id  = 0xFFFF,    ///< The command ID that lists the names of the commands
+};
+
+/// The flags of a request
+enum {
+    cmd_frame_int_args = (1 << 0),  ///< The parameters are an array of int32 values
+};
+
+/// The status of a response
+enum {
+    cmd_frame_ok       = 0,         ///< The handler returned true
+    cmd_frame_failed   = 1,         ///< The handler returned false
+    cmd_frame_unknown  = 2,         ///< There is no command with this ID
+    cmd_frame_bad_crc  = 3,         ///< The crc of the request did not match, so the command was not run
+    cmd_frame_too_long = 4,         ///< The parameters do not fit the parameter str, so the command was not run
+    cmd_frame_more     = 0x80,      ///< More responses of this request follow this one
+};
+
+/**
+ * Command frame handler
+ * @ingroup Utilities
+ *
+ * This is the output device given to the handlers of the framed commands; the output
+ * is sent in response frames and the input is read from the channel of the request.
+ *
+ * Example Usage:
+ * @code
+ *      CommandFrame frame(cmdProcessor);
+ *
+ *      if (!line.getLen() && CommandFrame::isRequestSync(c)) {
+ *          frame.handleFrame(uart0, params);
+ *      }
+ * @endcode
+ */
+class CommandFrame : public CharDev
+{
+    public:
+        /// Constructor; the frames run the handlers of the given command processor
+        CommandFrame(CommandProcessor& cmdProc);
+
+        /// @returns true if the char is the sync byte that starts a request frame
+        static inline bool isRequestSync(char c) { return (cmd_frame_req_sync == (uint8_t) c); }
+
+        /**
+         * Receives the rest of a request whose sync byte was received from io, runs the
+         * command and sends its responses to io.
+         * @param params  The str to store the command parameters; its capacity limits the parameters.
+         * @returns false if the request was not received within the timeout, so no response was sent.
+         */
+        bool handleFrame(CharDev& io, str& params);
+
+        /** @{ Virtual function overrides for the handlers to output to the response frames */
+        bool getChar(char* pInputChar, unsigned int timeout=portMAX_DELAY);
+        bool putChar(char out, unsigned int timeout=portMAX_DELAY);
+        bool putBlock(const void* pData, size_t len, unsigned int timeout=portMAX_DELAY);
+        bool getBlock(void* pData, size_t len, unsigned int timeout=portMAX_DELAY);
+        /** @} */
+
+    private:
+        /// Sends the buffered output in a response frame with the given status
+        void sendResponse(uint8_t status);
+
+        CommandProcessor& mCmdProc;             ///< The command processor of the handlers
+        CharDev *mpIo;                          ///< The channel of the request being handled
+        uint16_t mId;                           ///< The command ID of the request being handled
+        uint8_t mSeq;                           ///< The seq of the request being handled
+        uint16_t mRspLen;                       ///< The bytes of output buffered in mRsp[]
+        uint8_t mRsp[COMMAND_FRAME_RSP_BYTES];  ///< The output of the response frame
+};
+
+
+
+#endif /* COMMAND_FRAME_HPP_ */
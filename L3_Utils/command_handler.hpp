@@ -20,6 +20,7 @@
  * @brief Provides command handling mapping with a function pointer as handler
  * @ingroup Utilities
  *
+ * Version: 20261014    Added the command tables of CMD_DEFINE_HANDLER() in the flash
  * Version: 11102013    Removed 4th parameter (size) of command handler
  * Version: 05022013    Removed output string and replaced with output interface.
  * Version: 04192013    Removed restriction of command limit, just rely on source str as the command.
@@ -34,6 +35,7 @@
 #include "vector.hpp"
 #include "str.hpp"
 #include "char_dev.hpp"
+#include "profile.h"
 
 
 
@@ -64,6 +66,64 @@ typedef bool (*CmdHandlerFuncPtr)(str& cmdParams, CharDev& output, void* pDataPa
  */
 #define CMD_HANDLER_FUNC(name) bool name(str& cmdParams, CharDev& output, void* pDataParam)
 
+/// A command of CMD_DEFINE_HANDLER(), which is const data in the flash
+typedef struct
+{
+    const char* pTableName;   ///< The name of the table of the command
+    const char* pCommandStr;  ///< Pointer to the command text
+    const char* pCmdHelpText; ///< Pointer to the command's help
+    CmdHandlerFuncPtr pFunc;  ///< Pointer to the function pointer handler
+    void* pDataParam;         ///< Pointer to the data that should be passed as void pointer to pFunc
+#if (PROFILE_ENABLE)
+    profile_site_t** ppProfile; ///< The profile site of the command (in RAM), taken when it is first handled
+#endif
+} CmdTableEntryType;
+
+/**
+ * Defines a command of a command table at compile time, so the table needs no RAM
+ * and no sorting at startup; CommandProcessor::addTable() attaches the table.
+ * The linker script sorts the commands by the section ".cmd_table.<table>.<name>"
+ * between __cmd_table_start and __cmd_table_end, so a table is found and searched
+ * with a binary search.
+ *
+ * @param table  The name of the table, which is a C identifier such as terminal
+ * @param func   The handler, which must be declared before this (@see CMD_HANDLER_FUNC())
+ * @param name   The command, which is a string literal
+ * @param help   The help text of the command, which is a string literal
+ * @param param  The pDataParam of the handler, which is a constant such as (void*) 1
+ *
+ * @warning The command names of the tables must be lower-case, so the order of the
+ *          linker agrees with the search that ignores the case.
+ *
+ * @code
+ *      static CMD_HANDLER_FUNC(cmdHandler) { ... }
+ *      CMD_DEFINE_HANDLER(terminal, cmdHandler, "cmd", "My Cmd Help");
+ * @endcode
+ */
+#define CMD_DEFINE_HANDLER(table, func, name, help) \
+        CMD_DEFINE_HANDLER_PARAM(table, func, name, help, 0)
+
+/// Same as CMD_DEFINE_HANDLER() with the pDataParam of the handler
+#define CMD_DEFINE_HANDLER_PARAM(table, func, name, help, param) \
+        CMD_DEFINE_HANDLER_AT(table, func, name, help, param, __LINE__)
+
+/** @{ The expansion of CMD_DEFINE_HANDLER(), where the line makes the name of the entry unique in the file */
+#define CMD_DEFINE_HANDLER_AT(table, func, name, help, param, line) \
+        CMD_DEFINE_HANDLER_AT2(table, func, name, help, param, line)
+#define CMD_DEFINE_HANDLER_AT2(table, func, name, help, param, line) \
+        CMD_DEFINE_PROFILE_SITE(cmd_##table##_##line##_profile) \
+        static const CmdTableEntryType cmd_##table##_##line \
+        __attribute__((used, aligned(__alignof__(CmdTableEntryType)), section(".cmd_table." #table "." name))) = \
+        { #table, name, help, func, (void*) (param) CMD_PROFILE_SITE_INIT(cmd_##table##_##line##_profile) }
+#if (PROFILE_ENABLE)
+#define CMD_DEFINE_PROFILE_SITE(site)   static profile_site_t* site = 0;
+#define CMD_PROFILE_SITE_INIT(site)     , &site
+#else
+#define CMD_DEFINE_PROFILE_SITE(site)
+#define CMD_PROFILE_SITE_INIT(site)
+#endif
+/** @} */
+
 
 
 
@@ -75,6 +135,11 @@ typedef bool (*CmdHandlerFuncPtr)(str& cmdParams, CharDev& output, void* pDataPa
  * When user inputs a command, it will call the mapped handler.
  * Note that command input is capitalized to make this class case insensitive.
  *
+ * Each command is profiled as a site named by the command (@see profile.h) the first time it is handled.
+ *
+ * The commands of a table of CMD_DEFINE_HANDLER() are attached by addTable(), and come before the
+ * commands of addHandler().
+ *
  * One handler is already part of this class:
  *   - "help"   : Get list of supported commands
  *
@@ -91,6 +156,11 @@ typedef bool (*CmdHandlerFuncPtr)(str& cmdParams, CharDev& output, void* pDataPa
  *
  *      CommandProcessor cp;
  *      cp.addHandler(cmdHandler, "cmd", "My Cmd Help");
+ *
+ *      // Or at compile time, in any file:
+ *      CMD_DEFINE_HANDLER(mytable, cmdHandler, "cmd", "My Cmd Help");
+ *      CommandProcessor cp(0);
+ *      cp.addTable("mytable");
  * @endcode
  */
 class CommandProcessor
@@ -102,7 +172,8 @@ class CommandProcessor
          * @note addHandler() will grow the vector of command handlers if more commands are added later
          */
         CommandProcessor(int numCmds=8) :
-            mCmdHandlerVector(numCmds), mEnShortCmds(true)
+            mCmdHandlerVector(numCmds), mCmdSortedIndex(numCmds),
+            mpTable(0), mTableCount(0), mEnShortCmds(true)
         {
         }
 
@@ -115,10 +186,19 @@ class CommandProcessor
          * @warning pPersistentCmdStr and pPersistentCmdHelp must always exist in memory without going out of scope because
          *          these strings are not copied internally but their pointer is referenced during comparison
          * @note command is matched while ignoring case.
+         * @note The command must be a single word because the command's parameters begin after the first space.
          */
         void addHandler(CmdHandlerFuncPtr pFunc, const char* pPersistantCmdStr,
                         const char* pPersistentCmdHelpStr=0, void* pDataParam=0);
 
+        /**
+         * Attaches the commands of CMD_DEFINE_HANDLER() of a table
+         * @param pTableName  The name of the table, such as "terminal"
+         * @returns the number of commands of the table
+         * @note Only one table can be attached, and attaching another table replaces it.
+         */
+        unsigned int addTable(const char* pTableName);
+
         /**
          * @{ Command handling functions
          * Handles an incoming command and @returns null terminated string of the command output
@@ -129,10 +209,26 @@ class CommandProcessor
         bool handleCommand(str& cmd, CharDev& out);
         /** @} */
 
+        /**
+         * @{ Binary command dispatch used by the command frames (@see CommandFrame)
+         * The command ID is the position of the command in the table (in the order of the names), and
+         * then in the order it was added, starting at zero.
+         */
+        inline unsigned int getCommandCount(void) const { return mTableCount + mCmdHandlerVector.size(); }
+        const char* getCommandName(unsigned int id);
+
+        /**
+         * Calls the handler of the command ID with the given parameters
+         * @param handlerResult  Set to the value returned by the handler
+         * @returns false if there is no command with this ID
+         */
+        bool handleCommandId(unsigned int id, str& cmdParams, CharDev& out, bool& handlerResult);
+        /** @} */
+
         /**
          * Enables short-hand commands.  If a registered command is "information", and
          * a command comes in as "info", then it will be handled by "information" handler.
-         * First command that matches first two characters will take precedence.
+         * The first command (@see getCommandCount()) that begins with the input takes precedence.
          * @note This option is enabled by default.
          */
         inline void enableShortCmds(bool en) { mEnShortCmds = en;}
@@ -145,14 +241,37 @@ class CommandProcessor
             const char* pCmdHelpText; ///< Pointer to the command's help
             CmdHandlerFuncPtr pFunc;  ///< Pointer to the function pointer handler
             void* pDataParam;         ///< Pointer to the data that should be passed as void pointer to pFunc
+        #if (PROFILE_ENABLE)
+            profile_site_t* pProfile; ///< The profile site of the command, taken when it is first handled
+        #endif
         } CmdProcessorType;
 
-        VECTOR<CmdProcessorType> mCmdHandlerVector; ///< Vector of the command handlers
+        VECTOR<CmdProcessorType> mCmdHandlerVector; ///< Vector of the command handlers in the order they were added
+        VECTOR<unsigned short> mCmdSortedIndex;     ///< Indexes of mCmdHandlerVector sorted by command name (ignoring case)
+        const CmdTableEntryType* mpTable;           ///< The commands of addTable(), sorted by the linker
+        unsigned int mTableCount;                   ///< The number of commands at mpTable
         bool mEnShortCmds; ///< Enables partial matching of command names
 
         /// Handles a command stored at input and stores output in output object
         void handleCmd(str& input, CharDev& output);
 
+        /// @{ The name and the help of a command ID, which must be valid
+        const char* cmdName(unsigned int id);
+        const char* cmdHelp(unsigned int id);
+        /** @} */
+
+        /// Calls the handler of the command ID, which must be valid, and profiles it
+        bool callHandler(unsigned int id, str& cmdParams, CharDev& output);
+
+        /**
+         * Finds a command using binary search of mpTable, and then of mCmdSortedIndex
+         * @param pKey   The command name to find, which doesn't need to be null terminated
+         * @param keyLen The length of the command name at pKey
+         * @param prefix If true, the first command that begins with pKey is found
+         * @returns the command ID, or -1 if not found
+         */
+        int findCmd(const char* pKey, unsigned int keyLen, bool prefix);
+
         /// Gets a list of all registered commands which is used by the "HELP" command
         void getRegisteredCommandList(CharDev& output);
 
@@ -0,0 +1,222 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+/**
+ * @file
+ * @brief Stackless coroutines that share one FreeRTOS task
+ * @ingroup Utilities
+ *
+ * Each scheduler_task has its own stack, which is often most of the RAM of a small task that
+ * only blinks an LED or polls a sensor.  A coroutine is a cooperative task without a stack: its
+ * run() returns at every wait, and it continues after the wait the next time it is resumed.
+ * Many coroutines are hosted by one coroutine_task, so they share its stack and its priority.
+ * @code
+ *      class blinker : public coroutine
+ *      {
+ *          public:
+ *              blinker() : coroutine("blink") {}
+ *          protected:
+ *              void run(void)
+ *              {
+ *                  CO_BEGIN();
+ *                  while (1) {
+ *                      LE.toggle(1);
+ *                      CO_DELAY(500);
+ *                  }
+ *                  CO_END();
+ *              }
+ *      };
+ *
+ *      coroutine_task *pHost = new coroutine_task("co", 512*4, PRIORITY_LOW);
+ *      pHost->add(new blinker());
+ *      scheduler_add_task(pHost);
+ * @endcode
+ *
+ * The waits are macros that can only be used between CO_BEGIN() and CO_END() of run(), and not
+ * inside a switch statement of their own since they are cases of the CO_BEGIN() switch.
+ * The locals of run() do not survive a wait, so the state that is needed after a wait must be
+ * a member of the coroutine.  A coroutine should not call any blocking FreeRTOS API since it
+ * blocks every coroutine of its host; it should use the waits instead:
+ *  - CO_YIELD() lets the other coroutines run.
+ *  - CO_DELAY(ms) waits for the milliseconds.
+ *  - CO_AWAIT(cond) and CO_AWAIT_TIMEOUT(cond, ms) wait until the condition is true.
+ *  - CO_AWAIT_QUEUE() receives an item from a FreeRTOS queue.
+ *  - CO_AWAIT_SIGNAL() waits for a coroutine_signal given by a task, an ISR or an I/O completion.
+ *
+ * The host blocks until the next delay expires or a coroutine_signal is given, so the delays and
+ * the signals do not use any CPU while the coroutines wait.  A condition or a queue cannot wake
+ * up the host, so the host polls them every COROUTINE_POLL_MS while a coroutine waits on them.
+ *
+ * 20261014 : Initial
+ */
+#ifndef COROUTINE_HPP_
+#define COROUTINE_HPP_
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+
+#include "scheduler_task.hpp"
+
+
+
+/// The period at which the host checks the conditions and the queues of the waiting coroutines
+#define COROUTINE_POLL_MS       10
+
+
+
+/** @{ The waits of a coroutine, @see coroutine.hpp */
+#define CO_BEGIN()              switch (mCoLine) { case 0:                              ///< Starts the body of run()
+#define CO_END()                default: coFinish(); }                                  ///< Ends the body of run(), and the coroutine is done
+
+/// Yields to the other coroutines
+#define CO_YIELD()              do { mCoLine = __LINE__; coReady(); return; case __LINE__: ; } while (0)
+
+/// Waits for the milliseconds
+#define CO_DELAY(ms)            do { mCoLine = __LINE__; coDelay(ms); return; case __LINE__: ; } while (0)
+
+/// Waits until the condition is true, or the milliseconds expire, and then coTimedOut() tells which
+#define CO_AWAIT_TIMEOUT(cond, ms) \
+                                do { mCoLine = __LINE__; coDeadline(ms); case __LINE__: \
+                                     if ((mCoTimedOut = !(cond)) && !coExpired()) { coWait(); return; } } while (0)
+
+/// Waits until the condition is true; the condition is checked each time the coroutine is resumed
+#define CO_AWAIT(cond)          CO_AWAIT_TIMEOUT(cond, portMAX_DELAY)
+
+/// Waits and receives an item from the FreeRTOS queue
+#define CO_AWAIT_QUEUE(q, pItem)            CO_AWAIT(pdTRUE == xQueueReceive((q), (pItem), 0))
+
+/// Waits until the coroutine_signal is given
+#define CO_AWAIT_SIGNAL(sig)                CO_AWAIT((sig).take())
+
+/// Waits until the coroutine_signal is given, or the milliseconds expire
+#define CO_AWAIT_SIGNAL_TIMEOUT(sig, ms)    CO_AWAIT_TIMEOUT((sig).take(), (ms))
+/** @} */
+
+
+
+class coroutine_task;
+
+/**
+ * The base class of a coroutine; the derived class implements run() using CO_BEGIN() and CO_END()
+ */
+class coroutine
+{
+    public:
+        coroutine(const char *pName);
+        virtual ~coroutine() { }
+
+        const char* getName(void) const { return mpName; }              ///< @returns the name given to the constructor
+        bool isDone(void) const         { return co_done == mCoState; } ///< @returns true once run() reached CO_END()
+        uint32_t getResumeCount(void) const { return mResumes; }        ///< @returns the number of times run() was called
+
+        /// Starts the coroutine again from CO_BEGIN(), such as after it is done
+        void restart(void);
+
+    protected:
+        /// The body of the coroutine, which returns at each wait
+        virtual void run(void) = 0;
+
+        /// @returns true if the last CO_AWAIT_TIMEOUT() expired before its condition was true
+        bool coTimedOut(void) const { return mCoTimedOut; }
+
+        /** @{ Used by the CO_ macros */
+        void coReady(void);
+        void coDelay(uint32_t ms);
+        void coDeadline(uint32_t ms);
+        void coWait(void);
+        void coFinish(void);
+        bool coExpired(void) const;
+        /** @} */
+
+        uint16_t mCoLine;       ///< The line of the wait to continue from, or 0 to start from CO_BEGIN()
+        bool mCoTimedOut;       ///< @see coTimedOut()
+
+    private:
+        /// The states of a coroutine
+        typedef enum {
+            co_ready,           ///< Runs the next time the host runs
+            co_delayed,         ///< Runs when mWakeMs expires
+            co_waiting,         ///< Runs each time the host runs, until its condition is true
+            co_done,            ///< Reached CO_END()
+        } co_state_t;
+
+        const char * const mpName;  ///< The name of the coroutine
+        co_state_t mCoState;        ///< The state of the coroutine
+        bool mHasDeadline;          ///< True if the wait of a co_waiting coroutine expires at mWakeMs
+        uint32_t mWakeMs;           ///< The uptime in ms at which a delay or a deadline expires
+        uint32_t mResumes;          ///< @see getResumeCount()
+        coroutine *mpNext;          ///< The next coroutine of the host
+
+        friend class coroutine_task;
+};
+
+/**
+ * A signal that wakes up a coroutine waiting in CO_AWAIT_SIGNAL().  It may be given from any task,
+ * an ISR, or the completion callback of an I/O, and it counts the gives that were not taken yet.
+ * The host is woken up right away, instead of at the next COROUTINE_POLL_MS.
+ */
+class coroutine_signal
+{
+    public:
+        /// @param host  The host of the coroutines that wait on this signal
+        coroutine_signal(coroutine_task& host) : mrHost(host), mCount(0) { }
+
+        void give(void);                                    ///< Gives the signal from a task
+        void giveFromISR(BaseType_t *pHigherPriorityTaskWoken);    ///< Gives the signal from an ISR
+
+        /// Takes the signal if it was given; only used by the coroutines of the host
+        bool take(void);
+
+    private:
+        coroutine_task& mrHost;     ///< The host that is woken up by a give
+        volatile uint16_t mCount;   ///< The number of gives not taken yet
+};
+
+/**
+ * The FreeRTOS task that hosts the coroutines.  Its run() resumes each coroutine that is ready,
+ * and then blocks until the next coroutine is due.
+ */
+class coroutine_task : public scheduler_task
+{
+    public:
+        coroutine_task(const char *pName, uint32_t stackSize, uint8_t priority);
+
+        /**
+         * Adds a coroutine to the host.  The coroutines are added before scheduler_start(), or by
+         * the coroutines of the host since the list of the coroutines is not protected.
+         */
+        void add(coroutine *pCoroutine);
+
+        /// @returns the coroutine of the given index, or NULL if there are less coroutines
+        coroutine* getCoroutine(uint32_t index) const;
+
+        bool init(void);        ///< Creates the wake up semaphore
+        bool run(void *p);      ///< Resumes the coroutines that are due
+
+    private:
+        coroutine *mpList;          ///< The coroutines of the host
+        SemaphoreHandle_t mWake;    ///< Given to wake up the host before the next deadline
+
+        friend class coroutine_signal;
+};
+
+
+
+#endif /* COROUTINE_HPP_ */
@@ -0,0 +1,118 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+/**
+ * @file
+ * @brief Snapshot of the last crash, written to the reserved sectors of the SPI flash by the HardFault handler
+ * @ingroup Utilities
+ *
+ * The HardFault handler saves the registers stacked by the fault, the fault status registers,
+ * a window of the stack above the fault, the running task, and the newest records of the OS
+ * trace (@see os_trace.h) to a RAM snapshot that survives the reset.  If the SPI bus is not in
+ * the middle of a transfer, the snapshot is also programmed to the last FLASH_CRASH_SECTORS of
+ * the SPI flash, which are hidden from FatFs, so it is written in a few milliseconds without
+ * going through the file system, and it survives a power loss.  Otherwise the next boot writes
+ * the RAM snapshot to the flash once the flash is initialized (@see crash_snapshot_persist()).
+ *
+ * The 'health' command prints the snapshot of the last crash:
+ * @code
+ *      crash_snapshot_t snap;
+ *      if (crash_snapshot_get(&snap)) {
+ *          printf("PC: 0x%08X\n", (unsigned) snap.frame[crash_frame_pc]);
+ *      }
+ * @endcode
+ *
+ * 20261014: Initial
+ */
+#ifndef CRASH_SNAPSHOT_H__
+#define CRASH_SNAPSHOT_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "os_trace.h"
+
+
+
+#define CRASH_SNAPSHOT_MAGIC            0x48535243  ///< "CRSH" of a valid snapshot
+#define CRASH_SNAPSHOT_STACK_WORDS      48          ///< The words of the stack above the registers stacked by the fault
+#define CRASH_SNAPSHOT_TRACE_RECORDS    16          ///< The newest records of the OS trace
+#define CRASH_SNAPSHOT_TASK_NAME_LEN    8           ///< configMAX_TASK_NAME_LEN
+
+
+
+/// The indexes of the registers stacked by the fault, @see crash_snapshot_t::frame
+typedef enum {
+    crash_frame_r0 = 0,
+    crash_frame_r1,
+    crash_frame_r2,
+    crash_frame_r3,
+    crash_frame_r12,
+    crash_frame_lr,
+    crash_frame_pc,
+    crash_frame_psr,
+    crash_frame_words
+} crash_frame_reg_t;
+
+/// The snapshot of a crash, which fits one sector of the flash memory
+typedef struct {
+    uint32_t magic;             ///< CRASH_SNAPSHOT_MAGIC
+    uint16_t bytes;             ///< sizeof(crash_snapshot_t), so a snapshot of another layout is not used
+    uint16_t crc;               ///< crc16_update() of the snapshot after this field
+    uint32_t uptime_ms;         ///< The uptime of the fault
+    uint32_t frame[crash_frame_words];  ///< The registers stacked by the fault @see crash_frame_reg_t
+    uint32_t sp;                ///< The stack pointer of the code before the fault
+    uint32_t cfsr;              ///< Configurable fault status register (SCB->CFSR)
+    uint32_t hfsr;              ///< HardFault status register (SCB->HFSR)
+    uint32_t mmfar;             ///< MemManage fault address (SCB->MMFAR)
+    uint32_t bfar;              ///< BusFault address (SCB->BFAR)
+    char task[CRASH_SNAPSHOT_TASK_NAME_LEN];  ///< The running task, empty if the scheduler was not started
+    uint16_t stack_words;       ///< The words of stack[], which stop at the end of the RAM
+    uint16_t trace_records;     ///< The records of trace[]
+    uint32_t stack[CRASH_SNAPSHOT_STACK_WORDS];                     ///< The stack from sp
+    os_trace_record_t trace[CRASH_SNAPSHOT_TRACE_RECORDS];          ///< The newest trace records, oldest first
+} crash_snapshot_t;
+
+
+
+/**
+ * Saves the snapshot of the fault, and writes it to the flash memory if the SPI bus is free.
+ * @param pStackFrame  The registers stacked by the fault, given to isr_hard_fault_handler()
+ * @note This is only called by the HardFault handler.
+ */
+void crash_snapshot_save(const uint32_t *pStackFrame);
+
+/**
+ * Writes the snapshot of the last crash to the flash memory, if the HardFault handler could not.
+ * This is called at boot once the flash memory is mounted.
+ */
+void crash_snapshot_persist(void);
+
+/**
+ * Gets the snapshot of the last crash, from the RAM if there was no power loss since, or else from the flash.
+ * @returns false if there is no snapshot
+ */
+bool crash_snapshot_get(crash_snapshot_t *pSnapshot);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* CRASH_SNAPSHOT_H__ */
@@ -0,0 +1,82 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+/**
+ * @file
+ * @brief Table driven CRC-32 and CRC-16-CCITT
+ * @ingroup Utilities
+ *
+ * The CRC-32 is the one of zip and Ethernet (reflected 0x04C11DB7 polynomial), and it is used by
+ * the file transfers, the firmware update, the multicast and the disk telemetry.  It is computed
+ * four bytes at a time with four 256-entry tables (slice-by-4), which is about 4 times faster
+ * than the byte loop, and the 4K of tables are constant so they stay in the flash memory.
+ *
+ * The CRC-16-CCITT (0x1021 polynomial, MSB first) is the check of the small frames, such as
+ * the one of the command frame, and it is computed a byte at a time with a 256-entry table.
+ *
+ * Both are incremental: the data can be given in any number of parts of any size, so the CRC
+ * can be updated as each block is received, for example from the completion of each DMA
+ * transfer, without copying the data to one buffer first.
+ * @code
+ *      uint32_t crc = crc32_update(0, part1, len1);
+ *      crc = crc32_update(crc, part2, len2);
+ *
+ *      uint16_t crc16 = crc16_update(CRC16_INIT, part1, len1);
+ *      crc16 = crc16_update(crc16, part2, len2);
+ * @endcode
+ *
+ * 20261014: Moved crc32_update() here from utilities.h
+ */
+#ifndef CRC_H__
+#define CRC_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+
+
+
+#define CRC16_INIT      0xFFFF      ///< The initial value of the CRC-16-CCITT
+
+
+
+/**
+ * Updates the CRC-32 with the given data.
+ * Start with a crc of 0, and the result of the last update is the CRC-32 of all the data.
+ * The aligned words of the data are done four bytes at a time.
+ */
+uint32_t crc32_update(uint32_t crc, const void *data, uint32_t len);
+
+/**
+ * Updates the CRC-32 with the given words, which is the same as crc32_update() of their bytes.
+ * This is for the word aligned buffers filled by the DMA, such as each half of a ping-pong
+ * buffer, and it skips the byte loops that align the data.
+ */
+uint32_t crc32_update_words(uint32_t crc, const uint32_t *words, uint32_t count);
+
+/**
+ * Updates the CRC-16-CCITT with the given data.
+ * Start with a crc of CRC16_INIT, and the result of the last update is the CRC of all the data.
+ */
+uint16_t crc16_update(uint16_t crc, const void *data, uint32_t len);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* CRC_H__ */
@@ -0,0 +1,137 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+/**
+ * @file
+ * @brief Publish and subscribe of the latest samples of the topics
+ * @ingroup Utilities
+ *
+ * A sensor that is read by one task and used by several others either has each of them poll the
+ * sensor, or needs a queue for each consumer, and a consumer that falls behind fills up its queue
+ * and blocks the producer.  A topic instead keeps just the latest sample: a publisher writes it
+ * and sets the event bits of the subscribers, and each subscriber reads the latest sample in
+ * place whenever it gets to it.  A publisher never waits for a subscriber, and a slow subscriber
+ * only misses the samples that were replaced before it read them.
+ * @code
+ *      // sensors.h
+ *      EVENT_TOPIC_DECLARE(accel_topic);
+ *
+ *      // sensors.c
+ *      EVENT_TOPIC_DEFINE(accel_topic, accel_sample_t);
+ *      event_bus_publish(&accel_topic, &sample);
+ *
+ *      // A subscriber task, which may subscribe to many topics with the bits of one event group
+ *      EventGroupHandle_t events = xEventGroupCreate();
+ *      event_bus_subscribe(&accel_topic, events, 1 << 0);
+ *      while (1) {
+ *          if (event_bus_wait(events, 1 << 0, portMAX_DELAY)) {
+ *              accel_sample_t sample;
+ *              event_bus_read(&accel_topic, &sample);
+ *          }
+ *      }
+ * @endcode
+ *
+ * The sample is copied by the publisher while the interrupts are masked, so the samples should
+ * be small; a large sample can be published as a pointer to a buffer that is not modified while
+ * it is published.  The readers use a sequence count instead of a lock: event_bus_read() copies the
+ * sample again if a publish replaced it during the copy, and event_bus_read_begin() and
+ * event_bus_read_end() let a reader use the sample in place and tell if it was replaced meanwhile.
+ *
+ * 20261014: Initial
+ */
+#ifndef EVENT_BUS_H__
+#define EVENT_BUS_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "event_groups.h"
+
+
+
+#define EVENT_BUS_MAX_SUBS      4       ///< The max number of subscribers of a topic
+
+/// A subscriber of a topic, which is the bits set in its event group by each publish
+typedef struct {
+    EventGroupHandle_t group;
+    EventBits_t bits;
+} event_sub_t;
+
+/// A topic, which is defined by EVENT_TOPIC_DEFINE() and only accessed through the functions
+typedef struct {
+    const char *name;               ///< The name of the topic
+    void *sample;                   ///< The latest sample
+    uint16_t size;                  ///< The bytes of the sample
+    uint8_t num_subs;               ///< The number of subs[] used
+    volatile uint32_t seq;          ///< Incremented before and after each write of the sample, so it is odd during the write
+    event_sub_t subs[EVENT_BUS_MAX_SUBS];    ///< The subscribers
+} event_topic_t;
+
+/** @{ The topics are shared by their symbols, and the storage of a sample is static */
+#define EVENT_TOPIC_DECLARE(name)       extern event_topic_t name
+#define EVENT_TOPIC_DEFINE(name, TYPE)  static TYPE name##_sample; \
+                                        event_topic_t name = { #name, &name##_sample, sizeof(TYPE), 0, 0, { { 0, 0 } } }
+/** @} */
+
+/**
+ * Subscribes to the topic; each publish sets the bits of the event group
+ * @returns false if the topic already has EVENT_BUS_MAX_SUBS subscribers
+ */
+bool event_bus_subscribe(event_topic_t *topic, EventGroupHandle_t group, EventBits_t bits);
+
+/**
+ * Publishes the sample of topic->size bytes, and sets the bits of the subscribers.
+ * This never blocks, and it may be used by an ISR.
+ */
+void event_bus_publish(event_topic_t *topic, const void *sample);
+
+/// Waits for the bits of any of the subscribed topics, and @returns the bits that were set and cleared
+static inline EventBits_t event_bus_wait(EventGroupHandle_t group, EventBits_t bits, TickType_t timeout)
+{
+    return xEventGroupWaitBits(group, bits, pdTRUE, pdFALSE, timeout) & bits;
+}
+
+/**
+ * Copies the latest sample
+ * @returns the number of samples published so far, or 0 if there is no sample yet
+ */
+uint32_t event_bus_read(const event_topic_t *topic, void *sample);
+
+/**
+ * @{ Zero-copy read: event_bus_read_begin() @returns the latest sample in place, and the sequence
+ * count to give to event_bus_read_end(), which @returns false if a publish replaced the sample
+ * meanwhile, and then the sample that was used may be inconsistent and should be read again.
+ */
+const void* event_bus_read_begin(const event_topic_t *topic, uint32_t *seq);
+bool event_bus_read_end(const event_topic_t *topic, uint32_t seq);
+/** @} */
+
+/// @returns the number of samples published so far, which a polling reader may compare against its last read
+static inline uint32_t event_bus_get_count(const event_topic_t *topic)
+{
+    return topic->seq / 2;
+}
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* EVENT_BUS_H__ */
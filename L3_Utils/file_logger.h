@@ -21,6 +21,14 @@
  * @brief This is a logger that logs data to a file on the system such as an SD Card.
  * @ingroup Utilities
  *
+ * 20261014: Added the compression of the text log
+ * 20261014: Added the crash log of the text messages in the no-init RAM
+ * 20261014: Added the rotation of the text log
+ * 20261014: Added the sync policy and logger_emergency_flush()
+ * 20141030: Added compile-time and run-time minimum log level
+ * 20141028: Added rate limiting
+ * 20141024: Added binary logging
+ * 20141020: Log messages are printed directly to double buffered file buffers
  * 20140714: Fixed bugs and added more API
  * 20140529: Changed completely to C and FreeRTOS based logger
  * 20120923: modified flush() to use semaphores
@@ -32,37 +40,118 @@
 extern "C" {
 #endif
 #include <stdint.h>
+#include "sys_config.h"     // SYS_CFG_LOG_MIN_LEVEL
 
 
 
 /**
  * @{
- * The main parameters are the buffer size, and number of message buffers. The buffer size controls how
- * much data we can cache before we are forced to write it to the output file.
- *
- * The message buffers are the maximum number of LOGGING calls (macros) that can occur at once after which
- * the caller to LOG macro will be blocked.  Note that even a small number like 5 is good enough because
- * as soon as there is time for the logging task to run, it will transfer the LOGGED message into the
- * file buffer immediately.  So this number is kind of like a double buffer.  On the other hand, please
- * note that while the file is being written, the number of buffers need to be enough because the logger
- * task will be busy writing the buffer to the file.
- *
- * For example, if we anticipate logging every 10ms, and 1K of data takes 100ms to write, then we should
- * configure the number of logging buffers greater than 10 because while the logger task is busy writing
- * 1K of data for 100ms, we need to be able to write for 100ms, which will take at least 10 buffers.
+ * The main parameter is the buffer size which controls how much data we can cache before we are forced
+ * to write it to the output file.  There are two buffers of this size: the logging calls print their
+ * message directly into one buffer while the logger task writes the other buffer to the file.  So if
+ * we anticipate logging every 10ms, and 1K of data takes 100ms to write, then the buffer size should
+ * be large enough to hold more than 100ms worth of log messages otherwise the logging calls will block.
  *
  * The flush timeout is the timeout after which point we are forced to flush the data buffer to the file.
  * So in an event when no logging calls occur and there is data in the buffer, we will write it to the
  * file after this time.
  */
-#define FILE_LOGGER_BUFFER_SIZE      (1 * 1024)     ///< Recommend multiples of 512
-#define FILE_LOGGER_NUM_BUFFERS      10             ///< Number of buffers (need to have enough while file is being written)
+#define FILE_LOGGER_BUFFER_SIZE      (1 * 1024)     ///< Size of each of the two buffers, recommend multiples of 512
 #define FILE_LOGGER_LOG_MSG_MAX_LEN  150            ///< Max length of a log message
 #define FILE_LOGGER_FILENAME         "0:log.csv"    ///< Destination filename (0: for SPI flash, 1: for SD card)
 #define FILE_LOGGER_STACK_SIZE       (3 * 512 / 4)  ///< Stack size in 32-bit (1 = 4 bytes for 32-bit CPU)
 #define FILE_LOGGER_FLUSH_TIME_SEC   (1 * 60)       ///< Logs are flushed after this time
-#define FILE_LOGGER_BLOCK_TIME_MS    (10)           ///< If no buffer available within this time, block time counter will increment
+#define FILE_LOGGER_BLOCK_TIME_MS    (10)           ///< If no buffer space available within this time, block time counter will increment
 #define FILE_LOGGER_KEEP_FILE_OPEN   (0)            ///< If non-zero, the file will be kept open
+#define FILE_LOGGER_PREALLOC_BYTES   (16 * 1024)    ///< If non-zero, the files are kept open and grow by this much at once, @see stream_file.h
+/** @} */
+
+/**
+ * @{
+ * The sync policy of the buffers written to the file.  Each sync writes the partial sector at the end
+ * of the data, and the FAT and the directory entry unless the file is pre-allocated, so syncing after
+ * a few buffers rather than after each one cuts the writes several fold.  The written buffers are
+ * synced after FILE_LOGGER_SYNC_BUFFERS of them, or FILE_LOGGER_SYNC_TIME_SEC after the first one,
+ * and always upon the flush timeout, logger_send_flush_request() and logger_emergency_flush().
+ * A value of zero disables the buffer count or the time, so with both of them set to zero, only the
+ * error messages and the flushes are synced.
+ */
+#define FILE_LOGGER_SYNC_BUFFERS     (4)            ///< The written buffers are synced after this many (1 syncs each buffer)
+#define FILE_LOGGER_SYNC_TIME_SEC    (10)           ///< The written buffers are synced this long after the first one
+#define FILE_LOGGER_SYNC_ON_ERROR    (1)            ///< If non-zero, an error message is flushed and synced right away
+/** @} */
+
+/**
+ * @{
+ * Rotation of the text log over a ring of FILE_LOGGER_ROTATE_FILES pre-allocated files, instead of the
+ * single FILE_LOGGER_FILENAME that grows without a limit.  The files of the ring are named by printing
+ * their index with FILE_LOGGER_ROTATE_FILENAME, and are created by logger_init().  Once a file cannot
+ * fit another buffer within FILE_LOGGER_ROTATE_BYTES, it is closed and the logger continues with the
+ * next file.  The file after that one is the oldest, and it is emptied ahead of time, so the logs never
+ * take more than FILE_LOGGER_ROTATE_FILES * FILE_LOGGER_ROTATE_BYTES and no files are created or deleted.
+ * After a reboot, the logging continues with the file after the last full file.
+ *
+ * @note The rotation needs the FILE_LOGGER_PREALLOC_BYTES, and at least 3 files.
+ */
+#define FILE_LOGGER_ROTATE_FILES     (4)            ///< Number of files of the ring, 0 to log to FILE_LOGGER_FILENAME
+#define FILE_LOGGER_ROTATE_BYTES     (128 * 1024)   ///< Max size of each file of the ring
+#define FILE_LOGGER_ROTATE_FILENAME  "0:log%u.csv"  ///< The filenames of the ring, printed with the index of each file
+/** @} */
+
+/**
+ * @{
+ * The crash log is a ring in the .noinit RAM section (@see loader.ld), which is not initialized at startup
+ * and so survives the watchdog reset after a crash.  Each committed text message is also copied to the
+ * ring, and the ring keeps track of the messages that are synced to the file.  When the system boots
+ * after a crash or a watchdog reset, logger_init() writes the messages that were not synced to the file
+ * before the new messages, so the messages logged right before the crash are not lost although the
+ * file is written lazily.  The header of the ring has the integrity markers, so a ring that was not
+ * written by the logger, such as the random RAM contents after the power-on, is not written to the file.
+ *
+ * @note A few messages that were written to the file right before the crash may be written again.
+ */
+#define FILE_LOGGER_NOINIT_BYTES     (2 * 1024)     ///< Size of the crash log ring (power of two), 0 to disable it
+/** @} */
+
+/**
+ * @{
+ * Compression of the text log.  Each buffer is written to the file as an LZ frame (@see lz_frame.h)
+ * that is a fraction of the size of the text, which has the same filenames, function names and
+ * separators over and over.  The frames are decoded on the terminal by "cat <file> -lz".
+ * The encoder uses a 512 byte table and one frame buffer, which are shared by the writes of the text log.
+ */
+#define FILE_LOGGER_COMPRESS         (0)            ///< If non-zero, the text log is written as LZ frames
+/** @} */
+
+/**
+ * @{
+ * Rate limiting of the LOG_ERROR(), LOG_WARN(), LOG_INFO() and LOG_DEBUG() calls.
+ * Each severity and each call site (filename and line number) has a token bucket that refills at
+ * the given number of messages per second up to the burst size.  A rate of zero disables the limit.
+ * When the messages of a call site are suppressed, its next message that is logged is preceded by
+ * "N messages suppressed".  This prevents a fault storm from filling up the buffers.
+ */
+#define FILE_LOGGER_RATE_LIMIT       (1)            ///< If non-zero, the logging calls are rate limited
+#define FILE_LOGGER_RATE_DEBUG       (50)           ///< Debug messages per second, @see logger_set_rate_limit()
+#define FILE_LOGGER_RATE_INFO        (50)           ///< Info messages per second
+#define FILE_LOGGER_RATE_WARN        (20)           ///< Warning messages per second
+#define FILE_LOGGER_RATE_ERROR       (20)           ///< Error messages per second
+#define FILE_LOGGER_SEVERITY_BURST   (50)           ///< Burst size of each severity
+#define FILE_LOGGER_SITE_RATE        (5)            ///< Messages per second of each call site
+#define FILE_LOGGER_SITE_BURST       (10)           ///< Burst size of each call site
+#define FILE_LOGGER_RATE_SITES       (16)           ///< Number of call sites tracked at once
+#define FILE_LOGGER_DROP_WHEN_FULL   (1)            ///< If non-zero, a message is dropped (instead of blocking) if buffers are full
+/** @} */
+
+/**
+ * @{
+ * Binary log parameters, @see LOG_BIN_INFO()
+ * The binary log has its own double buffer, so messages are written to a separate file.
+ */
+#define FILE_LOGGER_BIN_ENABLE       (1)            ///< If non-zero, the binary log is enabled
+#define FILE_LOGGER_BIN_FILENAME     "0:log.bin"    ///< Destination filename of the binary log
+#define FILE_LOGGER_BIN_BUFFER_SIZE  (512)          ///< Size of each of the two binary log buffers
+#define FILE_LOGGER_BIN_MAX_ARGS     (4)            ///< Max number of 32-bit argument words (LOG_BIN_NARGS() counts up to 4)
 /** @} */
 
 
@@ -79,6 +168,23 @@ typedef enum {
     log_last, ///< Marks the last entry, do not use
 } logger_msg_t;
 
+/**
+ * Header of each binary log record which is followed by the argument words.
+ * The records are a multiple of 4 bytes, and written in the little-endian byte order.
+ */
+typedef struct {
+    uint16_t id;            ///< The message ID given to LOG_BIN_INFO() etc.
+    uint8_t  info;          ///< B7:B4 is the logger_msg_t severity, B3:B0 is the number of argument words
+    uint8_t  time_us_hi;    ///< B39:B32 of the sys_get_uptime_us()
+    uint32_t time_us_lo;    ///< B31:B0 of the sys_get_uptime_us()
+} logger_bin_header_t;
+
+/** @{ Pack and unpack logger_bin_header_t::info */
+#define LOGGER_BIN_INFO(type, nargs)    ((uint8_t) (((type) << 4) | ((nargs) & 0x0F)))
+#define LOGGER_BIN_INFO_TYPE(info)      ((logger_msg_t) ((info) >> 4))
+#define LOGGER_BIN_INFO_NARGS(info)     ((info) & 0x0F)
+/** @} */
+
 /**
  * Initializes the logger; this must be done before further logging calls are used.
  * @param [in] logger_priority The priority at which logger should buffer user data and then write to file.
@@ -95,6 +201,15 @@ void logger_init(uint8_t logger_priority);
  */
 void logger_set_printf(logger_msg_t type, bool enable);
 
+/**
+ * Sets the minimum severity that is logged at run-time.
+ * @param [in] type  The minimum severity, such as log_warn to ignore the debug and info messages
+ *
+ * @note This only applies above the SYS_CFG_LOG_MIN_LEVEL because the logging calls below
+ *       that level are not compiled in.
+ */
+void logger_set_min_level(logger_msg_t type);
+
 /**
  * @{ Macros to log a message using printf() style API
  * @note If FreeRTOS is not running, the message is immediately output to file.  If FreeRTOS is running,
@@ -104,13 +219,35 @@ void logger_set_printf(logger_msg_t type, bool enable);
  * @code
  *      LOG_INFO("Error %i encountered", error_number);
  * @endcode
+ *
+ * @note The macros below the SYS_CFG_LOG_MIN_LEVEL compile to nothing, so their arguments are not
+ *       evaluated, and their strings do not take any space.
  */
+#if (SYS_CFG_LOG_MIN_LEVEL <= 3)
 #define LOG_ERROR(msg, p...)  logger_log (log_error, __FILE__, __FUNCTION__, __LINE__, msg, ## p)
+#else
+#define LOG_ERROR(msg, p...)  LOG_NOTHING()
+#endif
+#if (SYS_CFG_LOG_MIN_LEVEL <= 2)
 #define LOG_WARN(msg, p...)   logger_log (log_warn,  __FILE__, __FUNCTION__, __LINE__, msg, ## p)
+#else
+#define LOG_WARN(msg, p...)   LOG_NOTHING()
+#endif
+#if (SYS_CFG_LOG_MIN_LEVEL <= 1)
 #define LOG_INFO(msg, p...)   logger_log (log_info,  __FILE__, __FUNCTION__, __LINE__, msg, ## p)
+#else
+#define LOG_INFO(msg, p...)   LOG_NOTHING()
+#endif
+#if (SYS_CFG_LOG_MIN_LEVEL <= 0)
 #define LOG_DEBUG(msg, p...)  logger_log (log_debug, __FILE__, __FUNCTION__, __LINE__, msg, ## p)
+#else
+#define LOG_DEBUG(msg, p...)  LOG_NOTHING()
+#endif
 /** @} */
 
+/// A logging call that is compiled out
+#define LOG_NOTHING()         do { } while (0)
+
 
 /**
  * This macro will log INFO message without filename, function name, and line number.
@@ -121,7 +258,51 @@ void logger_set_printf(logger_msg_t type, bool enable);
  *       the data will be written to buffer using the logger task and eventually flushed out to the file
  *       either after the timeout or when the buffer is full.
  */
+#if (SYS_CFG_LOG_MIN_LEVEL <= 1)
 #define LOG_SIMPLE_MSG(msg, p...)       logger_log (log_info, NULL, NULL, 0, msg, ## p)
+#else
+#define LOG_SIMPLE_MSG(msg, p...)       LOG_NOTHING()
+#endif
+
+/**
+ * @{ Macros to log a binary message to FILE_LOGGER_BIN_FILENAME
+ * The message is not formatted, and only its ID, the timestamp and the arguments are logged as
+ * 32-bit words, so this is much faster and uses a fraction of the space of the text logs. The
+ * message ID is a compile-time constant whose format string is used by the decoder to render the
+ * message, @see L5_Application/log_bin_msgs.h and the "log decode" terminal command.
+ *
+ * @note Up to FILE_LOGGER_BIN_MAX_ARGS integer arguments can be given.
+ *
+ * @code
+ *      LOG_BIN_INFO(logbin_motion_adc_sample, sample_number, adc, position);
+ * @endcode
+ */
+#if (FILE_LOGGER_BIN_ENABLE && SYS_CFG_LOG_MIN_LEVEL <= 3)
+#define LOG_BIN_ERROR(id, p...)  logger_log_bin (log_error, id, LOG_BIN_NARGS(p), ## p)
+#else
+#define LOG_BIN_ERROR(id, p...)  LOG_NOTHING()
+#endif
+#if (FILE_LOGGER_BIN_ENABLE && SYS_CFG_LOG_MIN_LEVEL <= 2)
+#define LOG_BIN_WARN(id, p...)   logger_log_bin (log_warn,  id, LOG_BIN_NARGS(p), ## p)
+#else
+#define LOG_BIN_WARN(id, p...)   LOG_NOTHING()
+#endif
+#if (FILE_LOGGER_BIN_ENABLE && SYS_CFG_LOG_MIN_LEVEL <= 1)
+#define LOG_BIN_INFO(id, p...)   logger_log_bin (log_info,  id, LOG_BIN_NARGS(p), ## p)
+#else
+#define LOG_BIN_INFO(id, p...)   LOG_NOTHING()
+#endif
+#if (FILE_LOGGER_BIN_ENABLE && SYS_CFG_LOG_MIN_LEVEL <= 0)
+#define LOG_BIN_DEBUG(id, p...)  logger_log_bin (log_debug, id, LOG_BIN_NARGS(p), ## p)
+#else
+#define LOG_BIN_DEBUG(id, p...)  LOG_NOTHING()
+#endif
+/** @} */
+
+/** @{ Counts the number of arguments (up to 4) given to the LOG_BIN macros */
+#define LOG_BIN_NARGS(p...)                         LOG_BIN_NARGS_N(_, ## p, 4, 3, 2, 1, 0)
+#define LOG_BIN_NARGS_N(_, a1, a2, a3, a4, n, ...)  n
+/** @} */
 
 /**
  * Logs a raw message without any header such as the timestamp.
@@ -153,30 +334,59 @@ void logger_set_printf(logger_msg_t type, bool enable);
 void logger_send_flush_request(void);
 
 /**
- * @returns the number of logged messages for the given severity.
+ * Writes the committed messages of the buffers to the files, and syncs them, without the logger
+ * task.  This is called by the fault handlers before the system is reset, so the scheduler is
+ * suspended, and nothing is written if the logger or the SPI bus were in use.
+ *
+ * @warning This does not return to the tasks, and is only meant to be called before a reset.
+ */
+void logger_emergency_flush(void);
+
+/**
+ * @returns the number of logging calls for the given severity, including the suppressed messages.
  * @param [in] severity  The severity for which to get the number of calls.
  */
 uint32_t logger_get_logged_call_count(logger_msg_t severity);
 
 /**
  * @returns the number of logging calls that ended up blocking or sleeping the task
- *          waiting for a logger buffer to be available.
+ *          waiting for the logger buffer space to be available.
  *
  * If the number is greater than zero, it indicates that you either need to slow
- * down logger calls, or increase the number of log buffers.
+ * down logger calls, or increase the FILE_LOGGER_BUFFER_SIZE.
  */
 uint16_t logger_get_blocked_call_count(void);
 
+/**
+ * @returns the number of messages of the given severity that were suppressed by the rate limits
+ * @param [in] severity  The severity for which to get the number of suppressed calls.
+ */
+uint32_t logger_get_suppressed_call_count(logger_msg_t severity);
+
+/**
+ * @returns the number of messages that were dropped because both buffers were full.
+ * @see FILE_LOGGER_DROP_WHEN_FULL
+ */
+uint16_t logger_get_dropped_call_count(void);
+
+/**
+ * Sets the rate limit of a severity, @see FILE_LOGGER_RATE_LIMIT
+ * @param [in] type     The severity
+ * @param [in] per_sec  The number of messages per second, or zero to disable the limit
+ * @param [in] burst    The number of messages that can be logged at once
+ */
+void logger_set_rate_limit(logger_msg_t type, uint16_t per_sec, uint16_t burst);
+
 /**
  * @returns the highest time that was spend writing the logger buffer to file.
- * This can be useful to assess how many FILE_LOGGER_NUM_BUFFERS we need because we only
- * need enough buffers available while the file buffer is being written.
+ * This can be useful to assess the FILE_LOGGER_BUFFER_SIZE we need because we only
+ * need enough buffer space available while the other buffer is being written.
  */
 uint16_t logger_get_highest_file_write_time_ms(void);
 
 /**
- * @returns the highest watermark of the number of buffers available to the logger
- * This can be useful to assess how many FILE_LOGGER_NUM_BUFFERS we need in the worst case.
+ * @returns the highest watermark of the number of messages waiting in the buffers to be written to file.
+ * This can be useful to assess the FILE_LOGGER_BUFFER_SIZE we need in the worst case.
  */
 uint16_t logger_get_num_buffers_watermark(void);
 
@@ -187,17 +397,23 @@ uint16_t logger_get_num_buffers_watermark(void);
 /* Do not use rest of the API after this line */
 
 /**
- * Logs a message.
+ * Logs a message, which is formatted by fmt_vsnprintf() of printf_lib.h
  * You should not use this directly, the macros pass the arguments to this function.
  */
 void logger_log(logger_msg_t type, const char * filename, const char * func_name, unsigned line_num,
-                const char * msg, ...);
+                const char * msg, ...) __attribute__((format(printf, 5, 6)));
 
 /**
  * @see LOG_RAW_MSG()
  * You should not use this directly, the macros pass the arguments to this function.
  */
-void logger_log_raw(const char * msg, ...);
+void logger_log_raw(const char * msg, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * @see LOG_BIN_INFO()
+ * You should not use this directly, the macros pass the arguments to this function.
+ */
+void logger_log_bin(logger_msg_t type, uint16_t id, uint8_t nargs, ...);
 
 
 
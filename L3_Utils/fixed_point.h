@@ -0,0 +1,110 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+/**
+ * @file
+ * @brief Fixed-point math for the Cortex-M3, which has no FPU
+ * @ingroup Utilities
+ *
+ * Each float or double operation on this CPU is a call to the soft-float library that takes
+ * tens to hundreds of cycles, while the same math on integers is a few instructions and the
+ * hardware divide.  The readings of the sensors are given in scaled integers, such as the
+ * hundredths of a degree, and these helpers scale, round, and print them:
+ * @code
+ *      const int32_t f_x100 = fixed_scale(c_x100, 9, 5) + 3200;       // Celsius to Farenheit
+ *      printf("%s%li.%02lu F\n", FIXED_X100_PRINT(f_x100));
+ * @endcode
+ *
+ * A Q16.16 number (q16_t) has 16 bits of fraction, for the math that needs more range than the
+ * scaled integers, such as a gain or a filter coefficient.  A float constant is converted by
+ * Q16_CONST() at compile time, so it does not pull in the soft-float library.
+ * @code
+ *      const q16_t gain = Q16_CONST(0.8);
+ *      int32_t filtered = q16_to_int(q16_mul(gain, q16_from_int(raw)));
+ * @endcode
+ *
+ * 20261014: Initial
+ */
+#ifndef FIXED_POINT_H__
+#define FIXED_POINT_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+
+
+
+/// A signed Q16.16 fixed-point number
+typedef int32_t q16_t;
+
+#define Q16_ONE             ((q16_t) 0x10000)   ///< 1.0 in Q16.16
+#define Q16_CONST(x)        ((q16_t) ((x) * 65536.0 + (((x) >= 0) ? 0.5 : -0.5)))   ///< Constant float to Q16.16 at compile time
+
+/// The sign, the integer part and the two decimals of a hundredths value for "%s%li.%02lu"
+#define FIXED_X100_PRINT(v) (((v) < 0) ? "-" : ""), (long) (((v) < 0) ? -(v) : (v)) / 100, (unsigned long) ((((v) < 0) ? -(v) : (v)) % 100)
+
+
+
+/**
+ * @returns value * num / den rounded to the nearest, with a 64-bit product so it does not overflow.
+ * The division uses the 32-bit hardware divide unless the product needs more than 31 bits.
+ */
+static inline int32_t fixed_scale(int32_t value, int32_t num, int32_t den)
+{
+    const int64_t product = (int64_t) value * num;
+    const uint64_t p = (product < 0) ? -(uint64_t) product : (uint64_t) product;
+    const uint32_t d = (den < 0) ? -(uint32_t) den : (uint32_t) den;
+    const uint64_t q = (p <= 0x7FFFFFFF) ? ((uint32_t) p + d / 2) / d : (p + d / 2) / d;
+    return (((product < 0) != (den < 0)) ? -(int32_t) q : (int32_t) q);
+}
+
+static inline q16_t q16_from_int(int32_t i)                 { return (q16_t) (i * Q16_ONE); }          ///< @returns the integer as Q16.16
+static inline q16_t q16_from_frac(int32_t num, int32_t den) { return fixed_scale(num, Q16_ONE, den); } ///< @returns num / den as Q16.16
+
+/// @returns the Q16.16 rounded to the nearest integer
+static inline int32_t q16_to_int(q16_t q)
+{
+    return (q >= 0) ? ((q + Q16_ONE / 2) >> 16) : -((-q + Q16_ONE / 2) >> 16);
+}
+
+/// @returns the Q16.16 in hundredths, rounded to the nearest
+static inline int32_t q16_to_x100(q16_t q)
+{
+    return fixed_scale(q, 100, Q16_ONE);
+}
+
+/// @returns a * b, rounded
+static inline q16_t q16_mul(q16_t a, q16_t b)
+{
+    return (q16_t) (((int64_t) a * b + Q16_ONE / 2) >> 16);
+}
+
+/// @returns a / b, or the largest value with the sign of a if b is zero
+static inline q16_t q16_div(q16_t a, q16_t b)
+{
+    if (0 == b) {
+        return (a < 0) ? (q16_t) 0x80000000 : (q16_t) 0x7FFFFFFF;
+    }
+    return (q16_t) (((int64_t) a << 16) / b);
+}
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* FIXED_POINT_H__ */
@@ -0,0 +1,113 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief LZ compression of the logs and the telemetry in small frames
+ * @ingroup Utilities
+ *
+ * The text logs and the ASCII telemetry repeat the same filenames, function names, separators
+ * and hex digits, so even a small window finds most of the matches.  Each frame compresses one
+ * buffer, such as a buffer of the logger, by itself: the matches only refer back within the frame,
+ * so the window is the buffer itself and the encoder only needs the 512 bytes of lz_work_t for
+ * its hash table.  The frames do not depend on each other, so a file that was cut by a crash,
+ * or whose oldest part was rotated away, is still decoded from any frame on.
+ *
+ * A frame is an 8 byte header and the data, and the fields are little-endian :
+ * @code
+ *      'L' 'Z' <raw_len:2> <data_len:2> <crc16:2> <data_len bytes>
+ * @endcode
+ * The data is the LZ4 block format of the raw bytes, or the raw bytes themselves if they do not
+ * compress (data_len == raw_len).  The crc16 is the crc16_update() of the raw bytes, so the
+ * decoder can tell the end of the frames from the zeros or the garbage after them.  The data
+ * ends with the last raw bytes which are not matched, so a frame of text does not end with a
+ * zero, which the stream file may trim after a crash (@see stream_file.h).
+ *
+ * @code
+ *      static lz_work_t work;
+ *      uint8_t frame[LZ_FRAME_MAX_BYTES(sizeof(text))];
+ *      const uint32_t frame_len = lz_frame_pack(text, sizeof(text), frame, &work);
+ *
+ *      char copy[sizeof(text)];
+ *      const int32_t len = lz_frame_unpack(frame, frame_len, copy, sizeof(copy));
+ * @endcode
+ *
+ * 20261014: Initial
+ */
+#ifndef LZ_FRAME_H__
+#define LZ_FRAME_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+#define LZ_FRAME_HEADER_SIZE    8       ///< The bytes of the header of a frame
+#define LZ_FRAME_MAX_RAW        0xFFFF  ///< The most raw bytes of a frame
+#define LZ_HASH_BITS            8       ///< The entries of the hash table of the encoder are 2^LZ_HASH_BITS
+
+/// The most bytes of the frame of the given number of raw bytes
+#define LZ_FRAME_MAX_BYTES(raw_len)     (LZ_FRAME_HEADER_SIZE + (raw_len))
+
+/// The working memory of the encoder, which may be shared by the encoders that do not run at the same time
+typedef struct {
+    uint16_t table[1 << LZ_HASH_BITS];  ///< The position + 1 of the last 4 bytes of each hash, or 0 if none
+} lz_work_t;
+
+/**
+ * Compresses the raw bytes to the LZ4 block format.
+ * @param dst_size  The size of dst, and the compression fails if the output does not fit
+ * @returns the bytes of the output, or 0 if it did not fit in dst_size
+ */
+uint32_t lz_compress(const void *src, uint32_t len, void *dst, uint32_t dst_size, lz_work_t *work);
+
+/**
+ * Decompresses the LZ4 block format.
+ * @returns the bytes of the output, or -1 if the data is corrupt or the output does not fit in dst_size
+ */
+int32_t lz_decompress(const void *src, uint32_t len, void *dst, uint32_t dst_size);
+
+/**
+ * Packs the raw bytes into a frame.
+ * @param len    The raw bytes, up to LZ_FRAME_MAX_RAW
+ * @param frame  The frame of LZ_FRAME_MAX_BYTES(len)
+ * @returns the bytes of the frame, or 0 if len is too large
+ */
+uint32_t lz_frame_pack(const void *src, uint32_t len, void *frame, lz_work_t *work);
+
+/**
+ * Gets the lengths of the frame of the header.
+ * @returns false if the header is not the header of a frame, such as at the end of the frames
+ */
+bool lz_frame_get_lengths(const void *header, uint16_t *raw_len, uint16_t *data_len);
+
+/**
+ * Unpacks the raw bytes of a frame.
+ * @param frame_len  The bytes of the frame, which may be more than the frame, such as a whole file
+ * @returns the raw bytes of the frame, or -1 if the frame is incomplete or corrupt, or if dst_size is too small
+ */
+int32_t lz_frame_unpack(const void *frame, uint32_t frame_len, void *dst, uint32_t dst_size);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* LZ_FRAME_H__ */
@@ -0,0 +1,134 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+/**
+ * @file
+ * @brief Arena and fixed size block allocators that do not use the malloc() lock
+ * @ingroup Utilities
+ *
+ * malloc() walks the heap with the lock of newlib/malloc_lock.c held, which is the time that
+ * every other allocation waits.  A hot path that allocates often can instead use memory of its
+ * own that is reserved once:
+ *
+ * A mem_arena_t hands out the memory of a buffer in order, and frees all of it at once by
+ * mem_arena_reset(), or everything allocated after a mem_arena_mark() by mem_arena_release().
+ * It has no lock, so an arena is owned by one task, such as the temporary memory of a command.
+ * @code
+ *      static uint8_t mem[512];
+ *      mem_arena_t arena;
+ *      mem_arena_init(&arena, mem, sizeof(mem));
+ *
+ *      char *pLine = (char*) mem_arena_alloc(&arena, 128);
+ *      mem_arena_reset(&arena);
+ * @endcode
+ *
+ * A mem_blocks_t is a pool of blocks of the same size, and a block is taken and given back in
+ * constant time.  The free list is changed with the interrupts masked for a few instructions,
+ * so the blocks can be shared by the tasks and the interrupts.
+ * @code
+ *      static uint8_t mem[MEM_BLOCKS_BYTES(sizeof(msg_t), 8)];
+ *      static mem_blocks_t msgs;
+ *      mem_blocks_init(&msgs, mem, sizeof(msg_t), 8);
+ *
+ *      msg_t *pMsg = (msg_t*) mem_blocks_alloc(&msgs);
+ *      mem_blocks_free(&msgs, pMsg);
+ * @endcode
+ *
+ * 20261014: Initial
+ */
+#ifndef MEM_ARENA_H__
+#define MEM_ARENA_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+#define MEM_ARENA_ALIGN     8   ///< The alignment of the memory of the arenas and of the blocks
+
+/// The bytes of the memory of a mem_blocks_t of the given number of blocks
+#define MEM_BLOCKS_BYTES(block_size, count) \
+    ((((block_size) + MEM_ARENA_ALIGN - 1) & ~(MEM_ARENA_ALIGN - 1)) * (count) + MEM_ARENA_ALIGN)
+
+/// An arena; the members are private to mem_arena.c
+typedef struct {
+    uint8_t *mem;           ///< The aligned memory of the arena
+    uint32_t size;          ///< The bytes of mem
+    uint32_t used;          ///< The bytes handed out
+    uint32_t peak;          ///< The most bytes ever handed out
+} mem_arena_t;
+
+/// A pool of blocks; the members are private to mem_arena.c
+typedef struct {
+    void *free_list;        ///< The free blocks, each of which stores the pointer to the next one
+    uint8_t *start;         ///< The first block
+    uint8_t *end;           ///< The end of the last block
+    uint16_t block_size;    ///< The aligned size of a block
+    uint16_t num_free;      ///< The blocks in free_list
+    uint16_t min_free;      ///< The fewest blocks ever in free_list
+} mem_blocks_t;
+
+
+
+/** @{ Arena */
+/// Initializes the arena over the memory, which is aligned to MEM_ARENA_ALIGN first
+void mem_arena_init(mem_arena_t *arena, void *mem, uint32_t size);
+
+/// @returns memory of the given bytes, aligned to MEM_ARENA_ALIGN, or NULL if the arena does not have enough
+void* mem_arena_alloc(mem_arena_t *arena, uint32_t bytes);
+
+/// @returns the position of the arena to give to mem_arena_release()
+static inline uint32_t mem_arena_mark(const mem_arena_t *arena) { return arena->used; }
+
+/// Frees the memory allocated since the mem_arena_mark() that returned the mark
+void mem_arena_release(mem_arena_t *arena, uint32_t mark);
+
+/// Frees all memory of the arena
+static inline void mem_arena_reset(mem_arena_t *arena) { arena->used = 0; }
+
+/// @returns the bytes that are not handed out, and the most bytes ever handed out through pPeak if not NULL
+uint32_t mem_arena_get_free(const mem_arena_t *arena, uint32_t *pPeak);
+/** @} */
+
+/** @{ Fixed size blocks */
+/**
+ * Initializes the pool of the given number of blocks
+ * @param mem   The memory of the blocks of at least MEM_BLOCKS_BYTES(block_size, count) bytes
+ */
+void mem_blocks_init(mem_blocks_t *blocks, void *mem, uint16_t block_size, uint16_t count);
+
+/// @returns a block, or NULL if all blocks are in use.  This can be used by an ISR.
+void* mem_blocks_alloc(mem_blocks_t *blocks);
+
+/// Gives back a block of mem_blocks_alloc().  This can be used by an ISR.
+void mem_blocks_free(mem_blocks_t *blocks, void *block);
+
+/// @returns true if the pointer is a block of the pool
+bool mem_blocks_owns(const mem_blocks_t *blocks, const void *ptr);
+
+/// @returns the free blocks, and the fewest free blocks ever through pMinFree if not NULL
+uint16_t mem_blocks_get_free(const mem_blocks_t *blocks, uint16_t *pMinFree);
+/** @} */
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* MEM_ARENA_H__ */
@@ -0,0 +1,129 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+/**
+ * @file
+ * @brief Lock-free buffer of variable length messages or of a byte stream
+ * @ingroup Utilities
+ *
+ * The items of a FreeRTOS queue have a fixed size, so a queue of packets reserves the largest
+ * packet for each item even if most of them are short, and a queue of bytes has the overhead of
+ * a queue call for each byte.  A message buffer stores the records one after the other in one
+ * ring of bytes, each with a two byte length header, so a record only uses its own length; or,
+ * in the stream mode, it stores the bytes with no headers at all.
+ *
+ * There is one writer and one reader, such as an ISR or a high priority task writing, and a
+ * task reading.  Only the writer modifies the head and only the reader modifies the tail, so
+ * neither side disables the interrupts or takes a lock.  If there are more writers (or more
+ * readers), they must be serialized by the caller.
+ * @code
+ *      static uint8_t rx_storage[256];
+ *      static msg_buffer_t rx;
+ *      msg_buffer_init(&rx, rx_storage, sizeof(rx_storage), msg_buffer_packets, true);
+ *
+ *      // Writer, which may be an ISR:
+ *      msg_buffer_write(&rx, pkt, pkt_len);
+ *
+ *      // Reader, which blocks up to one second for the next record:
+ *      uint8_t pkt[32];
+ *      const uint32_t len = msg_buffer_read(&rx, pkt, sizeof(pkt), 1000);
+ * @endcode
+ *
+ * 20261014: Initial
+ */
+#ifndef MSG_BUFFER_H__
+#define MSG_BUFFER_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+
+
+/// The modes of a message buffer
+typedef enum {
+    msg_buffer_packets,     ///< Each write is a record that is read as a whole
+    msg_buffer_stream,      ///< The bytes are read in any chunks, regardless of the writes
+} msg_buffer_mode_t;
+
+/// The bytes of the length header of a record of the msg_buffer_packets mode
+#define MSG_BUFFER_HDR_BYTES    2
+
+/// A message buffer, which is only accessed through the functions
+typedef struct {
+    uint8_t *buffer;            ///< The storage given to msg_buffer_init()
+    uint32_t mask;              ///< The size of the storage minus one
+    volatile uint32_t head;     ///< The free running count of the bytes written, only modified by the writer
+    volatile uint32_t tail;     ///< The free running count of the bytes read, only modified by the reader
+    msg_buffer_mode_t mode;     ///< @see msg_buffer_mode_t
+    SemaphoreHandle_t signal;   ///< Given by the writer for the blocking reads, or NULL
+    uint32_t dropped;           ///< The writes that did not fit, only modified by the writer
+} msg_buffer_t;
+
+/**
+ * Initializes the message buffer in the storage of the caller
+ * @param storage   The storage, which is usually a static array
+ * @param size      The bytes of the storage, which must be a power of two
+ * @param blocking  If true, msg_buffer_read() can wait for the writer using a binary semaphore
+ * @returns false if the size is not a power of two, or the semaphore could not be created
+ */
+bool msg_buffer_init(msg_buffer_t *mb, void *storage, uint32_t size, msg_buffer_mode_t mode, bool blocking);
+
+/**
+ * Writes a record, or the bytes of the stream.  It never blocks, so it may be used by an ISR.
+ * @returns the bytes written: a whole record or 0 if the record does not fit, and in the stream
+ *          mode as many bytes as fit.
+ */
+uint32_t msg_buffer_write(msg_buffer_t *mb, const void *data, uint32_t len);
+
+/**
+ * Reads the next record, or up to max bytes of the stream.
+ * If a record is longer than max, its first max bytes are read and the rest is discarded.
+ * @param timeout_ms  The time to wait while the buffer is empty, or portMAX_DELAY to wait forever;
+ *                    only a blocking message buffer waits, and only while FreeRTOS is running.
+ * @returns the bytes read, or 0 if the buffer was empty
+ */
+uint32_t msg_buffer_read(msg_buffer_t *mb, void *data, uint32_t max, uint32_t timeout_ms);
+
+/// @returns the length of the next record, or the bytes of the stream, that can be read now
+uint32_t msg_buffer_next_len(const msg_buffer_t *mb);
+
+/// @returns the number of bytes that can be written; a record also needs MSG_BUFFER_HDR_BYTES
+static inline uint32_t msg_buffer_get_free(const msg_buffer_t *mb)
+{
+    return (mb->mask + 1) - (mb->head - mb->tail);
+}
+
+/// @returns true if there is nothing to read
+static inline bool msg_buffer_is_empty(const msg_buffer_t *mb)
+{
+    return (mb->head == mb->tail);
+}
+
+/// Discards everything written so far; this is a read, so it is used by the reader
+void msg_buffer_flush(msg_buffer_t *mb);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* MSG_BUFFER_H__ */
@@ -25,6 +25,8 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
+#include <stdarg.h>
+#include <stddef.h>
 
 
 
@@ -36,6 +38,9 @@ extern "C" {
  *
  * @param [in] format   The printf format string
  * @param [in] ...      The printf arguments
+ *
+ * @warning This polls the UART with the interrupts disabled until the data is sent, so use printf()
+ *          for the routine output of the tasks, which is buffered (@see sys_set_out_policy()).
  */
 int u0_dbg_printf(const char *format, ...);
 
@@ -58,6 +63,42 @@ char* mprintf(const char *format, ...);
 
 
 
+/**
+ * @{ Small printf() formatter for the frequent output such as the logger and telemetry.
+ * This is several times faster than the newlib printf() and only uses about 100 bytes of stack,
+ * and the compiler checks the format string against the arguments.  The supported conversions are:
+ *  - %d %i %u %x %X %o %c %s %p %% with the h, hh, l, ll, z, j and t length modifiers
+ *  - %f with up to 9 digits of precision (6 by default), and %e %g are printed like %f
+ *    The values of 1e19 or more, which do not fit the 64-bit integer part, are printed as 1.234567e+19
+ *  - The flags '-', '0', '+', ' ', '#', and the width and precision, including '*'
+ *
+ * @code
+ *      char buffer[32];
+ *      fmt_snprintf(buffer, sizeof(buffer), "%u: %5.2f 0x%08X", count, (double) volts, flags);
+ * @endcode
+ */
+
+/**
+ * Function that is given the formatted output of fmt_vprint() in blocks of up to 32 chars
+ * @param arg   The argument given to fmt_vprint()
+ */
+typedef void (*fmt_write_func_t)(void *arg, const char *data, size_t len);
+
+/**
+ * Formats the output, and writes it to the given function
+ * @returns the number of chars that were written
+ */
+int fmt_vprint(fmt_write_func_t func, void *arg, const char *format, va_list args);
+
+/// Same as vsnprintf(), and its return value is the length of the entire formatted output
+int fmt_vsnprintf(char *buffer, size_t size, const char *format, va_list args);
+
+/// Same as snprintf(), and its return value is the length of the entire formatted output
+int fmt_snprintf(char *buffer, size_t size, const char *format, ...) __attribute__((format(printf, 3, 4)));
+/** @} */
+
+
+
 #ifdef __cplusplus
 }
 #endif
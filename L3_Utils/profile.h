@@ -0,0 +1,157 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+/**
+ * @file
+ * @brief Scoped profiling of code sites with a table of aggregated statistics
+ * @ingroup Utilities
+ *
+ * PRINT_EXECUTION_SPEED() and the stopwatches give one measurement at a time.  PROFILE_SCOPE()
+ * instead times every run of the code from the macro to the end of its scope by the CPU cycle
+ * counter, and adds it to the statistics of its site: the count, the total, min and max, and a
+ * histogram of log2 buckets of the cycles.  The sites are taken from a table of PROFILE_MAX_SITES
+ * the first time they run, and the 'profile' terminal command prints and resets the table.
+ * @code
+ *      void foo(void)
+ *      {
+ *          PROFILE_SCOPE("foo");
+ *          ...
+ *      }   // The time is recorded here, including by an early return
+ * @endcode
+ *
+ * The statistics are updated by the exclusive access instructions, without a lock or a critical
+ * section, so the sites can be used by the tasks of any priority and by the interrupts, and stay
+ * in the code permanently.  A scope costs about 50 CPU cycles.  The time of a scope includes the
+ * time of the tasks and the interrupts that preempted it.
+ *
+ * The profiling compiles to nothing when PROFILE_ENABLE is 0, which is the default of the host
+ * builds of the utilities.
+ */
+#ifndef PROFILE_H__
+#define PROFILE_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+
+
+
+#ifndef PROFILE_ENABLE
+#ifdef __arm__
+#define PROFILE_ENABLE          1   ///< Set to 0 to remove the profiling
+#else
+#define PROFILE_ENABLE          0   ///< The host builds do not have the cycle counter
+#endif
+#endif
+
+#define PROFILE_MAX_SITES       24  ///< The max number of sites in the table (88 bytes each)
+#define PROFILE_HIST_BUCKETS    16  ///< The buckets of the histogram; the last one counts the rest
+#define PROFILE_HIST_MIN_BITS   6   ///< Bucket N counts the runs of up to 2^(N + 6) cycles
+
+
+
+/// The statistics of a site
+typedef struct {
+    const char *name;           ///< The name of the site
+    uint32_t count;             ///< The number of runs
+    uint32_t total_lo;          ///< @{ The total cycles of the runs,
+    uint32_t total_hi;          ///<    as two words for the exclusive access instructions @}
+    uint32_t min_cycles;        ///< The shortest run
+    uint32_t max_cycles;        ///< The longest run
+    uint32_t hist[PROFILE_HIST_BUCKETS];   ///< The runs of each log2 bucket (@see PROFILE_HIST_MIN_BITS)
+} profile_site_t;
+
+/// The state of a profiled scope
+typedef struct {
+    profile_site_t *site;       ///< The site, or NULL if the table is full
+    uint32_t start;             ///< The CPU cycles at the start of the scope
+} profile_scope_t;
+
+#if (PROFILE_ENABLE)
+#include "lpc_sys.h"    // sys_get_cycles()
+
+/**
+ * Takes a site of the table
+ * @param name  The name of the site, which must be a persistent string
+ * @returns the site, or NULL if the table is full
+ */
+profile_site_t* profile_add_site(const char *name);
+
+/// Records the time since profile_begin() to the site of the scope
+void profile_end(profile_scope_t *scope);
+
+/**
+ * Starts the timing of a site; used by PROFILE_SCOPE(), or call profile_end() when done
+ * @param site  The site returned by profile_add_site()
+ */
+static inline profile_scope_t profile_begin(profile_site_t *site)
+{
+    profile_scope_t scope;
+    scope.site = site;
+    scope.start = sys_get_cycles();
+    return scope;
+}
+
+/// Takes the site of the macro the first time it runs, and starts its timing
+static inline profile_scope_t profile_begin_static(profile_site_t **site, const char *name)
+{
+    if (NULL == *site) {
+        *site = profile_add_site(name);
+    }
+    return profile_begin(*site);
+}
+
+/// @returns the number of sites in the table
+uint32_t profile_get_count(void);
+
+/**
+ * @returns the site of the table at the index, or NULL if the index is not used
+ * @note The name is NULL while the site is being taken by profile_add_site()
+ */
+const profile_site_t* profile_get_site(uint32_t index);
+
+/// @returns the total cycles of the site
+static inline uint64_t profile_get_total(const profile_site_t *site)
+{
+    return ((uint64_t) site->total_hi << 32) | site->total_lo;
+}
+
+/// Clears the statistics of every site; a run that ends during the reset may be partly counted
+void profile_reset(void);
+
+#define PROFILE_JOIN_(a, b)     a ## b
+#define PROFILE_JOIN(a, b)      PROFILE_JOIN_(a, b)
+
+/**
+ * Times the code from this macro to the end of its scope
+ * @param name  The name of the site, which must be a persistent string
+ */
+#define PROFILE_SCOPE(name)                                                                 \
+            static profile_site_t *PROFILE_JOIN(profile_site_, __LINE__) = NULL;            \
+            profile_scope_t PROFILE_JOIN(profile_scope_, __LINE__)                          \
+                __attribute__((cleanup(profile_end))) =                                     \
+                profile_begin_static(&PROFILE_JOIN(profile_site_, __LINE__), name)
+#else
+#define PROFILE_SCOPE(name)
+#endif
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* PROFILE_H__ */
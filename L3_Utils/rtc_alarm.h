@@ -1,99 +1,190 @@
-/*
- *     SocialLedge.com - Copyright (C) 2013
- *
- *     This file is part of free software framework for embedded processors.
- *     You can use it and/or distribute it as long as this copyright header
- *     remains unmodified.  The code is free for personal use and requires
- *     permission to use in a commercial product.
- *
- *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
- *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
- *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
- *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
- *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
- *
- *     You can reach the author of this software at :
- *          p r e e t . w i k i @ g m a i l . c o m
- */
-
-/**
- * @file
- * @brief This file provides API to enable real-time clock FreeRTOS signals or alarms
- * @ingroup Utilities
- */
-
-#ifndef RTC_SEM_HPP_
-#define RTC_SEM_HPP_
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-#include <stdint.h>
-
-#include "FreeRTOS.h"
-#include "semphr.h"
-
-
-
-/**
- * Frequency of a recurring alarm
- */
-typedef enum {
-    everySecond = 0,
-    everyMinute = 1,
-    everyHour   = 2,
-    everyDay    = 3,
-} alarm_freq_t;
-
-/**
- * rtc_alarm_create() returns the pointer to this structure.
- * This structure can be used to change the alarm time after
- * it has been created.
- */
-typedef struct {
-    uint8_t hour, min, sec;
-} alarm_time_t;
-
-
-
-/**
- * Enables a permanent recurring alarm every second, minute, or hour
- * @param pAlarm  The signal (semaphore) to give when the alarm triggers
- * @param freq    The frequency of the alarm  @see alarm_freq_t
- * @note This is different from rtc_alarm_create() because once you enable
- *       this recurring alarm, there is no way to disable it or change it later.
- */
-void rtc_alarm_create_recurring(alarm_freq_t freq, SemaphoreHandle_t *pAlarm);
-
-/**
- * Enables alarm at the given @param time
- * @post pAlarm semaphore will be given when RTC time matches the given time.
- * @return alarm_time_t that can be used to modify alarm time
- *
- * @code
- *      alarm_time_t my_time = { 12, 30, 0 }; // Alarm at 12:30 PM
- *      alarm_time_t *my_alarm_time = rtc_alarm_create(my_time, &my_sem);
- *
- *      // Check for alarm trigger :
- *      if (xSemaphoreTask(my_sem, portMAX_DELAY)) {
- *          // Do something
- *      }
- *
- *      // You can change the time any time :
- *      my_alarm_time->hour = 13
- * @endcode
- */
-alarm_time_t* rtc_alarm_create(alarm_time_t time, SemaphoreHandle_t *pAlarm);
-
-/**
- * Turns off an alarm that was created by rtc_alarm_create()
- * Nothing special here, the hour is set to 25, which will never occur.
- */
-static inline void rtc_alarm_off(alarm_time_t *p) { p->hour = 25; p->min = p->sec=0; }
-
-
-
-#ifdef __cplusplus
-}
-#endif
-#endif /* RTC_SEM_HPP_ */
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief This file provides API to enable real-time clock FreeRTOS signals or alarms
+ * @ingroup Utilities
+ *
+ * The rtc_job_* API is a calendar alarm scheduler for any number of jobs (up to RTC_JOB_MAX)
+ * that run once, every hour, every day, or on some days of the week.  The jobs are kept in a
+ * heap sorted by their next run time, and only the first one is programmed to the alarm
+ * registers of the RTC, so no task needs to stay awake and no interrupt occurs every second.
+ * Since the RTC keeps running in the Deep Sleep mode, its alarm interrupt can wake up the CPU
+ * from sys_clock_deep_sleep().
+ * @code
+ *      static rtc_job_t track_sun, rotate_log;
+ *      const alarm_time_t sunrise = { 6, 30, 0 };
+ *      const alarm_time_t every_hour = { 0, 0, 0 };   // At minute 0 of every hour
+ *
+ *      rtc_job_init(&track_sun, sunrise, alarm_daily, 0, track_sun_callback, NULL);
+ *      rtc_job_init(&rotate_log, every_hour, alarm_hourly, 0, rtc_job_give_semaphore, log_sem);
+ *      rtc_job_start(&track_sun);
+ *      rtc_job_start(&rotate_log);
+ * @endcode
+ */
+
+#ifndef RTC_SEM_HPP_
+#define RTC_SEM_HPP_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+
+
+/**
+ * Frequency of a recurring alarm
+ */
+typedef enum {
+    everySecond = 0,
+    everyMinute = 1,
+    everyHour   = 2,
+    everyDay    = 3,
+} alarm_freq_t;
+
+/**
+ * rtc_alarm_create() returns the pointer to this structure.
+ * This structure can be used to change the alarm time after
+ * it has been created.
+ */
+typedef struct {
+    uint8_t hour, min, sec;
+} alarm_time_t;
+
+/**
+ * The repetition of a calendar alarm job (@see rtc_job_init())
+ */
+typedef enum {
+    alarm_once   = 0,   ///< Runs once at the next occurrence of the time
+    alarm_hourly = 1,   ///< Runs every hour at the min and sec of the time
+    alarm_daily  = 2,   ///< Runs every day at the time
+    alarm_weekly = 3,   ///< Runs at the time on the days of the week of the dow_mask
+} alarm_repeat_t;
+
+/**
+ * Callback of a job, which is called from the RTC interrupt
+ * @param arg  The argument given to rtc_job_init()
+ * @returns true if a FreeRTOS "FromISR" function woke up a higher priority task
+ */
+typedef bool (*rtc_job_callback_t)(void *arg);
+
+/// The max number of jobs that are started at the same time
+#define RTC_JOB_MAX     16
+
+/// A calendar alarm job; the members are private to rtc_alarm.c
+typedef struct {
+    alarm_time_t time;              ///< The time of the day of the job
+    alarm_repeat_t repeat;          ///< The repetition of the job
+    uint8_t dow_mask;               ///< The days of the week of alarm_weekly (bit 0 is Sunday)
+    uint8_t heap_index;             ///< The index of the job in the heap, or RTC_JOB_MAX if not started
+    uint32_t next;                  ///< The next run time in seconds since 1970
+    rtc_job_callback_t callback;    ///< The callback of the job
+    void *arg;                      ///< The argument of the callback
+} rtc_job_t;
+
+
+
+/**
+ * Enables a permanent recurring alarm every second, minute, or hour
+ * @param pAlarm  The signal (semaphore) to give when the alarm triggers
+ * @param freq    The frequency of the alarm  @see alarm_freq_t
+ * @note This is different from rtc_alarm_create() because once you enable
+ *       this recurring alarm, there is no way to disable it or change it later.
+ */
+void rtc_alarm_create_recurring(alarm_freq_t freq, SemaphoreHandle_t *pAlarm);
+
+/**
+ * Enables alarm at the given @param time
+ * @post pAlarm semaphore will be given when RTC time matches the given time.
+ * @return alarm_time_t that can be used to modify alarm time
+ *
+ * @code
+ *      alarm_time_t my_time = { 12, 30, 0 }; // Alarm at 12:30 PM
+ *      alarm_time_t *my_alarm_time = rtc_alarm_create(my_time, &my_sem);
+ *
+ *      // Check for alarm trigger :
+ *      if (xSemaphoreTask(my_sem, portMAX_DELAY)) {
+ *          // Do something
+ *      }
+ *
+ *      // You can change the time any time :
+ *      my_alarm_time->hour = 13
+ * @endcode
+ */
+alarm_time_t* rtc_alarm_create(alarm_time_t time, SemaphoreHandle_t *pAlarm);
+
+/**
+ * Turns off an alarm that was created by rtc_alarm_create()
+ * Nothing special here, the hour is set to 25, which will never occur.
+ */
+static inline void rtc_alarm_off(alarm_time_t *p) { p->hour = 25; p->min = p->sec=0; }
+
+/**
+ * Initializes a job, which is not started
+ * @param job       The job
+ * @param time      The time of the day (only the min and sec are used by alarm_hourly)
+ * @param repeat    The repetition of the job
+ * @param dow_mask  The days of the week of alarm_weekly, such as (1 << dow_mon) | (1 << dow_fri)
+ * @param callback  The callback when the job runs
+ * @param arg       The argument of the callback
+ */
+void rtc_job_init(rtc_job_t *job, alarm_time_t time, alarm_repeat_t repeat, uint8_t dow_mask,
+                  rtc_job_callback_t callback, void *arg);
+
+/**
+ * Starts (or restarts) a job from the current RTC time.  This can also be used from the callback
+ * of a job to run it again, such as after changing its time.
+ * @returns false if the time is invalid, alarm_weekly has no days, or RTC_JOB_MAX jobs are started
+ */
+bool rtc_job_start(rtc_job_t *job);
+
+/// Stops a job; nothing is done if the job is not started
+void rtc_job_stop(rtc_job_t *job);
+
+/// @returns true if the job is started and will run again
+static inline bool rtc_job_is_started(const rtc_job_t *job) { return (job->heap_index < RTC_JOB_MAX); }
+
+/// @returns the next run time of a started job, in seconds since 1970
+static inline uint32_t rtc_job_get_next(const rtc_job_t *job) { return job->next; }
+
+/**
+ * Computes the next run time of every job from the current RTC time.
+ * Call this after rtc_settime(), otherwise the jobs keep their run times of the old time.
+ */
+void rtc_job_time_changed(void);
+
+/**
+ * A job callback that gives the semaphore given as the argument of the job
+ * @code
+ *      rtc_job_init(&job, time, alarm_daily, 0, rtc_job_give_semaphore, my_sem);
+ * @endcode
+ */
+bool rtc_job_give_semaphore(void *sem);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* RTC_SEM_HPP_ */
@@ -1,131 +1,299 @@
-/*
- *     SocialLedge.com - Copyright (C) 2013
- *
- *     This file is part of free software framework for embedded processors.
- *     You can use it and/or distribute it as long as this copyright header
- *     remains unmodified.  The code is free for personal use and requires
- *     permission to use in a commercial product.
- *
- *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
- *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
- *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
- *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
- *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
- *
- *     You can reach the author of this software at :
- *          p r e e t . w i k i @ g m a i l . c o m
- */
-
-#ifndef SAMPLER_HPP_
-#define SAMPLER_HPP_
-
-/**
- * Sampler class.
- * The purpose of this class is to store samples of a variable type
- * and be able to get the average, low, high from the samples.
- *
- * @code
- * Sampler<int> samples(2);
- * samples.storeSample(10);
- * samples.storeSample(20);
- * int avg = samples.getAverage(); // Should be 15
- * @endcode
- */
-template <typename TYPE>
-class Sampler
-{
-    public:
-        Sampler(int numSamples) : mSampleArraySize(numSamples), mSampleIndex(0), mAllSamplesReady(false)
-        {
-            mSamples = new TYPE[numSamples];
-            for(int i=0; i < numSamples; i++) {
-                mSamples[i] = 0;
-            }
-        }
-
-        ~Sampler()
-        {
-            delete [] mSamples;
-        }
-
-        void storeSample(const TYPE& sample)
-        {
-            mSamples[mSampleIndex] = sample;
-            if(++mSampleIndex >= mSampleArraySize) {
-                mSampleIndex = 0;
-                mAllSamplesReady = true;
-            }
-        }
-
-        TYPE getAverage(void) const
-        {
-            const int numSamples = mAllSamplesReady ? mSampleArraySize : mSampleIndex;
-            TYPE sum = 0;
-
-            for(int i=0; i < numSamples; i++) {
-                sum += mSamples[i];
-            }
-
-            return (sum / numSamples);
-        }
-
-        TYPE getLatest(void) const
-        {
-            int idx = (0 == mSampleIndex) ? (mSampleArraySize - 1) : (mSampleIndex - 1);
-            return mSamples[idx];
-        }
-
-        TYPE getHighest(void) const
-        {
-            const int numSamples = mAllSamplesReady ? mSampleArraySize : mSampleIndex;
-            TYPE highest = mSamples[0];
-
-            for(int i=0; i < numSamples; i++) {
-                if (highest < mSamples[i]) {
-                    highest = mSamples[i];
-                }
-            }
-
-            return highest;
-        }
-
-        TYPE getLowest(void) const
-        {
-            const int numSamples = mAllSamplesReady ? mSampleArraySize : mSampleIndex;
-            TYPE lowest = mSamples[0];
-
-            for(int i=0; i < numSamples; i++) {
-                if (lowest > mSamples[i]) {
-                    lowest = mSamples[i];
-                }
-            }
-
-            return lowest;
-        }
-
-        inline bool allSamplesReady(void)  const { return mAllSamplesReady; }
-        inline int getMaxSampleCount(void) const { return mSampleArraySize; }
-        inline int getSampleCount(void)    const { return mAllSamplesReady ? mSampleArraySize : mSampleIndex; }
-        inline TYPE getSampleNum(int idx)  const { return idx < mSampleArraySize ? mSamples[idx] : 0;         }
-
-        void clear(void)
-        {
-            mAllSamplesReady = false;
-            mSampleIndex = 0;
-        }
-
-    private:
-        /// Do not use this constructor
-        Sampler() :
-            mSampleArraySize(0), mSampleIndex(0),
-            mAllSamplesReady(false), mSamples(0)
-        {
-        }
-
-        const int mSampleArraySize; ///< Number of samples
-        int mSampleIndex;           ///< Index of next sample that will get stored to mSamples array
-        bool mAllSamplesReady;      ///< If the whole array is not filled, we can't compute the average
-        TYPE* mSamples;             ///< Array of samples
-};
-
-#endif /* SAMPLER_HPP_ */
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#ifndef SAMPLER_HPP_
+#define SAMPLER_HPP_
+
+#include <stdint.h>
+
+
+
+/**
+ * Sampler class.
+ * The purpose of this class is to store samples of a variable type
+ * and be able to get the average, low, high from the samples.
+ *
+ * The sum, the highest and the lowest sample are updated as the samples are stored,
+ * so the get methods do not scan the samples.  The highest and lowest samples are kept
+ * in a queue of candidates that is trimmed from the back, so storeSample() is O(1)
+ * on average.
+ *
+ * @code
+ * Sampler<int> samples(2);
+ * samples.storeSample(10);
+ * samples.storeSample(20);
+ * int avg = samples.getAverage(); // Should be 15
+ * @endcode
+ *
+ * @note For float TYPE, the running sum may collect rounding errors over a long time;
+ *       clear() resets it.
+ */
+template <typename TYPE>
+class Sampler
+{
+    public:
+        Sampler(int numSamples) : mSampleArraySize(numSamples), mSampleIndex(0), mAllSamplesReady(false),
+                                  mSum(0), mSeq(0)
+        {
+            mSamples = new TYPE[numSamples];
+            mHigh.mpSeq = new unsigned[numSamples];
+            mLow.mpSeq = new unsigned[numSamples];
+            for(int i=0; i < numSamples; i++) {
+                mSamples[i] = 0;
+            }
+            clear();
+        }
+
+        ~Sampler()
+        {
+            delete [] mSamples;
+            delete [] mHigh.mpSeq;
+            delete [] mLow.mpSeq;
+        }
+
+        void storeSample(const TYPE& sample)
+        {
+            const unsigned size = mSampleArraySize;
+
+            /* Candidates that leave the window must be removed before their slot is overwritten */
+            mHigh.expire(mSeq, size);
+            mLow.expire(mSeq, size);
+
+            if (mAllSamplesReady) {
+                mSum -= mSamples[mSampleIndex];
+            }
+            mSum += sample;
+            mSamples[mSampleIndex] = sample;
+
+            /* A new sample makes the older and smaller (or larger) candidates useless */
+            while (mHigh.mCount && !(sample < mSamples[mHigh.back(size) % size])) {
+                mHigh.mCount--;
+            }
+            while (mLow.mCount && !(mSamples[mLow.back(size) % size] < sample)) {
+                mLow.mCount--;
+            }
+            mHigh.push(mSeq, size);
+            mLow.push(mSeq, size);
+            ++mSeq;
+
+            if(++mSampleIndex >= mSampleArraySize) {
+                mSampleIndex = 0;
+                mAllSamplesReady = true;
+            }
+        }
+
+        TYPE getAverage(void) const
+        {
+            const int numSamples = getSampleCount();
+            return numSamples ? (mSum / numSamples) : 0;
+        }
+
+        TYPE getLatest(void) const
+        {
+            int idx = (0 == mSampleIndex) ? (mSampleArraySize - 1) : (mSampleIndex - 1);
+            return mSamples[idx];
+        }
+
+        TYPE getHighest(void) const
+        {
+            return mHigh.mCount ? mSamples[mHigh.front() % mSampleArraySize] : 0;
+        }
+
+        TYPE getLowest(void) const
+        {
+            return mLow.mCount ? mSamples[mLow.front() % mSampleArraySize] : 0;
+        }
+
+        inline TYPE getSum(void)           const { return mSum; }
+        inline bool allSamplesReady(void)  const { return mAllSamplesReady; }
+        inline int getMaxSampleCount(void) const { return mSampleArraySize; }
+        inline int getSampleCount(void)    const { return mAllSamplesReady ? mSampleArraySize : mSampleIndex; }
+        inline TYPE getSampleNum(int idx)  const { return idx < mSampleArraySize ? mSamples[idx] : 0;         }
+
+        void clear(void)
+        {
+            mAllSamplesReady = false;
+            mSampleIndex = 0;
+            mSum = 0;
+            mSeq = 0;
+            mHigh.mHead = mHigh.mCount = 0;
+            mLow.mHead = mLow.mCount = 0;
+        }
+
+    private:
+        /// Do not use this constructor
+        Sampler() :
+            mSampleArraySize(0), mSampleIndex(0),
+            mAllSamplesReady(false), mSamples(0), mSum(0), mSeq(0)
+        {
+        }
+
+        /**
+         * Queue of the sequence numbers of the candidates for the highest (or lowest) sample.
+         * The front is the oldest candidate, which is the answer.
+         */
+        typedef struct {
+            unsigned *mpSeq;    ///< Circular array of mSampleArraySize sequence numbers
+            unsigned mHead;     ///< Index of the front
+            unsigned mCount;    ///< Number of candidates
+
+            unsigned front(void) const               { return mpSeq[mHead]; }
+            unsigned back(unsigned size) const       { return mpSeq[(mHead + mCount - 1) % size]; }
+            void push(unsigned seq, unsigned size)   { mpSeq[(mHead + mCount++) % size] = seq; }
+            void expire(unsigned seq, unsigned size)
+            {
+                if (mCount && (seq - front()) >= size) {
+                    mHead = (mHead + 1) % size;
+                    mCount--;
+                }
+            }
+        } candidates_t;
+
+        const int mSampleArraySize; ///< Number of samples
+        int mSampleIndex;           ///< Index of next sample that will get stored to mSamples array
+        bool mAllSamplesReady;      ///< If the whole array is not filled, we can't compute the average
+        TYPE* mSamples;             ///< Array of samples
+        TYPE mSum;                  ///< Running sum of the samples
+        unsigned mSeq;              ///< Sequence number of the next sample
+        candidates_t mHigh;         ///< Candidates for getHighest()
+        candidates_t mLow;          ///< Candidates for getLowest()
+};
+
+
+/**
+ * Fixed-point first order IIR low-pass filter (exponential moving average).
+ * Each sample moves the output by 1/2^shift of the difference, so the filter
+ * only uses add, subtract and shift instructions.  The state keeps 8 fractional
+ * bits such that a slow filter does not get stuck short of the input.
+ *
+ * @code
+ * IirFilter light(3);      // Output moves 1/8th towards each sample
+ * light.filter(adc0_get_reading(2));
+ * int value = light.get();
+ * @endcode
+ *
+ * @note The input range is +/- 2^23
+ */
+class IirFilter
+{
+    public:
+        IirFilter(uint8_t shift) : mShift(shift), mState(0), mPrimed(false) {}
+
+        /// Filters a sample, and returns the new output
+        int32_t filter(int32_t sample)
+        {
+            const int32_t in = sample * (1 << mFracBits);
+            if (!mPrimed) {
+                /* The first sample sets the output to avoid the slow rise from zero */
+                mState = in;
+                mPrimed = true;
+            }
+            else {
+                mState += (in - mState) >> mShift;
+            }
+            return get();
+        }
+
+        /// @returns the rounded output of the filter
+        int32_t get(void) const { return (mState + (1 << (mFracBits - 1))) >> mFracBits; }
+
+        void reset(void) { mState = 0; mPrimed = false; }
+
+    private:
+        static const int32_t mFracBits = 8;
+        const uint8_t mShift;   ///< Filter strength
+        int32_t mState;         ///< Output with mFracBits fractional bits
+        bool mPrimed;           ///< True after the first sample
+};
+
+
+
+/**
+ * Moving median filter that rejects spikes of a sensor.
+ * The window is kept sorted by insertion such that each sample is O(n) with
+ * compare and move operations, which is cheap for small windows (3 to 15).
+ *
+ * @code
+ * MedianFilter<int> temperature(5);
+ * temperature.filter(10);
+ * temperature.filter(99);  // Spike
+ * int value = temperature.filter(11); // Should be 11
+ * @endcode
+ */
+template <typename TYPE>
+class MedianFilter
+{
+    public:
+        MedianFilter(int windowSize) : mWindowSize(windowSize), mIndex(0), mCount(0)
+        {
+            mWindow = new TYPE[windowSize];
+            mSorted = new TYPE[windowSize];
+        }
+
+        ~MedianFilter()
+        {
+            delete [] mWindow;
+            delete [] mSorted;
+        }
+
+        /// Filters a sample, and returns the median of the window
+        TYPE filter(const TYPE& sample)
+        {
+            int i = 0;
+
+            /* Remove the oldest sample from the sorted array once the window is full */
+            if (mCount == mWindowSize) {
+                const TYPE old = mWindow[mIndex];
+                for (i = 0; i < mCount - 1 && mSorted[i] != old; i++) {
+                    ;
+                }
+                for (; i < mCount - 1; i++) {
+                    mSorted[i] = mSorted[i + 1];
+                }
+                mCount--;
+            }
+
+            /* Insert the new sample in order */
+            for (i = mCount; i > 0 && sample < mSorted[i - 1]; i--) {
+                mSorted[i] = mSorted[i - 1];
+            }
+            mSorted[i] = sample;
+            mCount++;
+
+            mWindow[mIndex] = sample;
+            if (++mIndex >= mWindowSize) {
+                mIndex = 0;
+            }
+
+            return get();
+        }
+
+        /// @returns the median of the window
+        TYPE get(void) const { return mCount ? mSorted[mCount / 2] : 0; }
+
+        void clear(void) { mIndex = 0; mCount = 0; }
+
+    private:
+        const int mWindowSize;  ///< Number of samples of the window
+        int mIndex;             ///< Index of the next sample in mWindow
+        int mCount;             ///< Number of samples in the window
+        TYPE *mWindow;          ///< Samples in the order they were stored
+        TYPE *mSorted;          ///< Samples in ascending order
+};
+
+#endif /* SAMPLER_HPP_ */
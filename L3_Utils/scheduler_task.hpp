@@ -25,6 +25,10 @@
  * This file provides the structure to create and manage a FreeRTOS task.
  * @see scheduler_task for further documentation
  *
+ * 20261014     : Added deadline monitor of the periodic tasks (missed deadlines, max lateness, onDeadlineMiss())
+ * 20261014     : Added static stacks, and intrusive task list and shared object hash table without heap
+ * 20261014     : Added run loop profile (run() duration histogram, jitter, blocked time)
+ * 20261014     : Added event mode, where run() is called upon notify() instead of polling
  * 20140215     : Added add/get sharedHandles() by index (faster).
  *                Made some functions static with documentation on how to use them.
  * 20140211     : Fixed bug with statistical update (ticks to ms conversion)
@@ -40,13 +44,75 @@
 
 #include "FreeRTOS.h"
 #include "queue.h"
+#include "semphr.h"
 #include "task.h"
+#include "timers.h"
 
 
 
 /// Forward declaration of the scheduler task class
 class scheduler_task;
 
+/// Maximum number of objects shared by name using scheduler_task::addSharedObject() (must be a power of two)
+#define SCHEDULER_SHARED_NAME_SLOTS     16
+
+/// Number of buckets of the run() duration histogram: <10us, <100us, <1ms, <10ms, <100ms, and >= 100ms
+#define SCHEDULER_PROFILE_HIST_BUCKETS  6
+
+/// Default number of consecutive deadline misses that calls scheduler_task::onDeadlineMiss(), @see setDeadlineMissLimit()
+#define SCHEDULER_DEADLINE_MISS_LIMIT   3
+
+/**
+ * Profile of the run loop of a scheduler task measured using sys_get_uptime_us()
+ * @note The microsecond counters wrap-around after about 71 minutes; use resetProfile()
+ *       before measuring something specific.
+ */
+typedef struct {
+    uint32_t runLastUs;     ///< Duration of the last run()
+    uint32_t runMaxUs;      ///< Maximum duration of run()
+    uint32_t jitterMaxUs;   ///< Maximum deviation of the start of run() against setRunDuration()
+    uint32_t blockedUs;     ///< Total time spent blocked on the queue set or the event mode
+    uint32_t runHist[SCHEDULER_PROFILE_HIST_BUCKETS]; ///< Count of run() durations per decade
+
+    /** @{ Deadline monitor of the tasks using setRunDuration(), where the deadline of each run()
+     *     is the end of its period counted from the start of the first run()
+     */
+    uint32_t deadlineMisses;    ///< Number of run() that returned after their deadline
+    uint32_t latenessMaxUs;     ///< Maximum time by which a run() missed its deadline
+    uint32_t missStreak;        ///< Number of consecutive deadline misses up to the last run()
+    uint32_t missStreakMax;     ///< Maximum of missStreak
+    /** @} */
+} scheduler_profile_t;
+
+/** @{ CPU accounting of all the FreeRTOS tasks (@see scheduler_get_cpu()) */
+#define SCHEDULER_CPU_MAX_TASKS         16      ///< The max number of tasks accounted for
+#define SCHEDULER_CPU_SAMPLE_MS         1000    ///< The period of the samples of the run-time counters
+#define SCHEDULER_CPU_HISTORY           60      ///< The number of samples of the system CPU kept in the ring
+
+/// The averages of the CPU usage: the last sample, and the moving averages of about 10 and 60 seconds
+enum { scheduler_cpu_1s, scheduler_cpu_10s, scheduler_cpu_60s, scheduler_cpu_avgs };
+
+/// The CPU usage of a task
+typedef struct {
+    char name[configMAX_TASK_NAME_LEN]; ///< The task name
+    UBaseType_t number;                 ///< The TCB number of the task (TaskStatus_t::xTaskNumber), or 0 if unused
+    uint32_t lastRunTime;               ///< The run-time counter of the task at the last sample
+    uint32_t avgQ16[scheduler_cpu_avgs];///< The averages in hundredths of a percent, shifted by 16 bits
+    uint16_t cpu[scheduler_cpu_avgs];   ///< The averages in hundredths of a percent
+    scheduler_task *pTask;              ///< The scheduler task, or NULL if the task is not a scheduler task
+} scheduler_cpu_task_t;
+
+/// The CPU accounting of the system
+typedef struct {
+    scheduler_cpu_task_t tasks[SCHEDULER_CPU_MAX_TASKS];   ///< The tasks, in no particular order
+    uint16_t sysCpu[scheduler_cpu_avgs];        ///< The averages of the CPU used by all but the idle task
+    uint8_t history[SCHEDULER_CPU_HISTORY];     ///< The percent of the system CPU of each sample
+    uint8_t historyPos;                         ///< The position of the next sample in history[]
+    uint32_t samples;                           ///< The number of samples taken
+    uint32_t lastTotalRunTime;                  ///< The total run-time counter at the last sample
+} scheduler_cpu_t;
+/** @} */
+
 
 /**
  * Adds your task to the scheduler
@@ -69,6 +135,18 @@ void scheduler_add_task(scheduler_task *task);
  */
 void scheduler_start(bool dbg_print=false, bool register_internal_tlm=false);
 
+/**
+ * @returns the CPU accounting of all the FreeRTOS tasks, which is sampled every SCHEDULER_CPU_SAMPLE_MS
+ *          by a timer once scheduler_start() is called.
+ *
+ * Unlike 'info 200', the run-time counters are not reset, so the accounting continuously measures
+ * the production load.  Each sample is the difference of the run-time counters since the last
+ * sample, and the moving averages are exponentially weighted, like the load averages of Unix.
+ * If the counters are reset, such as by 'info 200', the sample is skipped.
+ * @note Only the first SCHEDULER_CPU_MAX_TASKS tasks are sampled, and none if there are more tasks.
+ */
+const scheduler_cpu_t& scheduler_get_cpu(void);
+
 
 /**
  * Scheduler task.
@@ -147,6 +225,13 @@ class scheduler_task
         static uint8_t getSysIdlePercent(void);  ///< Get total system IDLE percent
         /** @} */
 
+        /** @{ Run loop profile API */
+        inline const scheduler_profile_t& getProfile(void) const { return mProfile; }
+        /// @returns the moving average of the CPU usage in hundredths of a percent (@see scheduler_get_cpu())
+        inline uint16_t getCpuAverage(uint8_t avg) const { return (avg < scheduler_cpu_avgs) ? mCpu[avg] : 0; }
+        void resetProfile(void);
+        /** @} */
+
         /** @{
          * Suspend and resume functions.
          * Obviously you can suspend yourself but someone else will have to resume you ;)
@@ -155,13 +240,35 @@ class scheduler_task
         inline void resume (void) const { vTaskResume(mHandle);  }
         /** @} */
 
+        /**
+         * @{ Event notification API
+         * Sets the event bits and wakes up the task if it uses enableEventMode().
+         * The bits accumulate until the task's next run(), which gets them by getEventBits().
+         * @code
+         *      enum { evt_rx = (1 << 0), evt_tx = (1 << 1) };
+         *
+         *      // Any task :
+         *      scheduler_task::getTaskPtrByName("wireless")->notify(evt_tx);
+         *
+         *      // From an ISR :
+         *      BaseType_t woken = 0;
+         *      pTask->notifyFromISR(evt_rx, &woken);
+         *      portYIELD_FROM_ISR(woken);
+         * @endcode
+         * @note These do nothing if the task did not enable the event mode.
+         */
+        void notify(uint32_t bits);
+        void notifyFromISR(uint32_t bits, BaseType_t *pHigherPriorityTaskWoken);
+        /** @} */
+
         /**
          * @{
          * Add/Get a shared object pointer by name such that multiple classes of this type
          * can communicate between themselves.
          * @note It is recommended to use the later version of addSharedObject() and
-         *       getSharedObject() because it is faster.  Consider this version of
-         *       overloaded API deprecated -- :)
+         *       getSharedObject() because it doesn't need to hash the name.  At most
+         *       SCHEDULER_SHARED_NAME_SLOTS objects can be shared by name.
+         * @note A typed Channel shared by its symbol needs no lookup at all (@see channel.hpp)
          *
          * @code
          *     QueueHandle_t sensor_queue;
@@ -275,6 +382,22 @@ class scheduler_task
          */
         virtual bool run(void *param)=0;
 
+        /**
+         * Optional: Override this function to handle the deadline misses of the run() of a periodic task.
+         * It is called after the run() that makes the number of consecutive misses reach the limit
+         * set by setDeadlineMissLimit(), and the default logs a warning.
+         * @param consecutive  The number of consecutive deadline misses
+         * @param latenessUs   The time by which the last run() missed its deadline
+         * @note The misses are counted regardless, @see scheduler_profile_t::deadlineMisses
+         */
+        virtual void onDeadlineMiss(uint32_t consecutive, uint32_t latenessUs);
+
+        /**
+         * Sets the number of consecutive deadline misses that calls onDeadlineMiss()
+         * @param count  The number of misses, 0 to disable onDeadlineMiss()
+         */
+        inline void setDeadlineMissLimit(uint32_t count) { mDeadlineMissLimit = count; }
+
         /**
          * This can be used to set a desired time that the run() method will be called.
          * For example, if frequency is set to 1000, then the run() will be called
@@ -290,6 +413,35 @@ class scheduler_task
         /// @returns the run duration set by setRunDuration()
         inline uint32_t getRunDuration(void) const { return mTaskDelayMs; }
 
+        /**
+         * Enables the event mode in which run() is called only after notify() or
+         * notifyFromISR() is used, so the task doesn't need to wake up to poll for work.
+         * This should be called from your init() method.
+         * @param blockTime  The maximum ticks to wait for an event after which run()
+         *                   is called anyway with getEventBits() returning zero.
+         * @note setRunDuration() is not used in this mode, and the event mode takes
+         *       precedence over the queue set.
+         * @returns true if successful.
+         *
+         * @code
+         *      bool init(void)
+         *      {
+         *          return enableEventMode();
+         *      }
+         *      bool run(void *p)
+         *      {
+         *          if (getEventBits() & evt_rx) {
+         *              // Do something
+         *          }
+         *          return true;
+         *      }
+         * @endcode
+         */
+        bool enableEventMode(TickType_t blockTime=portMAX_DELAY);
+
+        /// @returns the event bits that were notified before the current run() was called
+        inline uint32_t getEventBits(void) const { return mEventBits; }
+
     #if (0 != configUSE_QUEUE_SETS)
         /**
          * Initialize the queue set to block on multiple queues and/or semaphores.
@@ -338,6 +490,14 @@ class scheduler_task
         /** @} */
     #endif
 
+        /**
+         * Uses the given memory as the task's stack instead of allocating it from the heap.
+         * The memory must be at least the stack size given to the constructor, and it must
+         * stay valid while the task exists.  @see scheduler_task_static
+         * @note This must be called before scheduler_start()
+         */
+        inline void setStackBuffer(StackType_t *pStack) { mpStackBuffer = pStack; }
+
         /**
          * Set the update rate in milliseconds that the free stack size is calculated at.
          * Default rate is 60 seconds; zero is to disable it.
@@ -352,7 +512,8 @@ class scheduler_task
     #if (0 != configUSE_QUEUE_SETS)
             mQueueSet(0), mQueueSetType(0), mQueueSetBlockTime(0),
     #endif
-            mHandle(0), mFreeStack(0), mRunCount(0), mTaskDelayMs(0), mStatUpdateRateMs(0),
+            mEventSem(0), mPendingEventBits(0), mEventBits(0), mEventBlockTime(0),
+            mProfile(), mDeadlineMissLimit(0), mCpu(), mpNextTask(0), mpStackBuffer(0), mHandle(0), mFreeStack(0), mRunCount(0), mTaskDelayMs(0), mStatUpdateRateMs(0),
             mName(0), mParam(0), mStackSize(0), mPriority(0) {}
 
     #if (0 != configUSE_QUEUE_SETS)
@@ -363,6 +524,19 @@ class scheduler_task
         /** @} */
     #endif
 
+        /** @{ Event mode members */
+        SemaphoreHandle_t mEventSem;            ///< Semaphore given by notify() to wake up this task
+        volatile uint32_t mPendingEventBits;    ///< Bits notified since the last run()
+        uint32_t mEventBits;                    ///< Bits notified before the current run()
+        TickType_t mEventBlockTime;             ///< Block time to wait for an event
+        /** @} */
+
+        scheduler_profile_t mProfile;   ///< Run loop profile
+        uint32_t mDeadlineMissLimit;    ///< Consecutive deadline misses that call onDeadlineMiss()
+        uint16_t mCpu[scheduler_cpu_avgs];  ///< The CPU averages, copied from scheduler_get_cpu() for the telemetry
+        scheduler_task *mpNextTask;     ///< Next task in the list of tasks added by scheduler_add_task()
+        StackType_t *mpStackBuffer;     ///< Statically allocated stack memory, or NULL to allocate it from the heap
+
         /** @{ Other member variables */
         TaskHandle_t mHandle;       ///< Task handle of this task
         uint32_t mFreeStack;        ///< Free stack of this task
@@ -381,9 +555,44 @@ class scheduler_task
         /** @{ Give access to our private members to these functions */
         friend bool scheduler_init_all(bool register_task_tlm);
         friend void scheduler_c_task_private(void *param);
+        friend void scheduler_add_task(scheduler_task *task);
+        friend void scheduler_cpu_sample(TimerHandle_t timer);
         /** @} */
 };
 
+/**
+ * Scheduler task with a stack allocated at compile time as part of this object
+ * instead of the FreeRTOS heap.  Declare the task as a global or static object
+ * to avoid heap allocation of the task and its stack.
+ * @param STACK_SIZE  The stack size in bytes
+ *
+ * @code
+ *      class my_task : public scheduler_task_static<2048>
+ *      {
+ *          public :
+ *          my_task() : scheduler_task_static<2048>("task name", 1) { }
+ *          bool run(void *param) { return true; }
+ *      };
+ *
+ *      static my_task task;
+ *      scheduler_add_task(&task);
+ * @endcode
+ * @note FreeRTOS still allocates the task control block (TCB) from the heap.
+ */
+template <uint32_t STACK_SIZE>
+class scheduler_task_static : public scheduler_task
+{
+    protected:
+        scheduler_task_static(const char *name, uint8_t priority, void *param=0) :
+            scheduler_task(name, STACK_SIZE, priority, param)
+        {
+            setStackBuffer(&mStack[0]);
+        }
+
+    private:
+        StackType_t mStack[STACK_BYTES(STACK_SIZE)]; ///< Stack memory of this task
+};
+
 
 
 #endif /* CPP_TASK_HPP_ */
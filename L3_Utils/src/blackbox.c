@@ -0,0 +1,374 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "blackbox.h"
+#include "crc.h"
+#include "task.h"
+#include "semphr.h"
+#include "LPC17xx.h"        // SCB->ICSR
+#include "lpc_sys.h"        // sys_get_uptime_us()
+#include "spi_sem.h"        // spi1_lock()
+#include "fat/disk/spi_flash.h"
+
+
+
+/// Compiler memory barrier to publish the records of a page before it is counted as full
+#define BLACKBOX_BARRIER()      __asm volatile ("" ::: "memory")
+
+/**
+ * The recorder.  The RAM ring has the page being filled at the head, and the full pages from
+ * the tail, which are written by the task.  The records are written to the head with the
+ * interrupts masked, and the head, the tail and the count are only changed with the
+ * interrupts masked, so the task writes the full pages while the records are added.
+ */
+typedef struct {
+    uint8_t *ring;                      ///< The RAM ring of BLACKBOX_RAM_PAGES pages
+    uint16_t page_bytes;                ///< The bytes of a page, @see flash_raw_get_page_bytes()
+    volatile uint8_t head;              ///< The page of the ring being filled
+    volatile uint8_t tail;              ///< The oldest full page of the ring
+    volatile uint8_t full;              ///< The full pages of the ring
+    volatile bool recording;            ///< True while blackbox_record() adds records
+    uint32_t pending_drops;             ///< The records dropped since the last page was started
+
+    uint32_t pages;                     ///< The raw pages of the flash memory
+    uint32_t next_page;                 ///< The raw page that the next page is written to
+    uint32_t seq;                       ///< The seq of the next page
+    uint16_t session;                   ///< The session of the recording
+
+    blackbox_stats_t stats;             ///< @see blackbox_get_stats()
+    SemaphoreHandle_t signal;           ///< Given when a page is full, to wake up the task
+} blackbox_t;
+
+static blackbox_t g_bb;
+
+
+
+/// @returns the page of the RAM ring
+static inline blackbox_page_t* blackbox_ring_page(uint8_t idx)
+{
+    return (blackbox_page_t*) (g_bb.ring + ((uint32_t) idx * g_bb.page_bytes));
+}
+
+/// Starts the page at the head of the ring
+static inline void blackbox_begin_page(void)
+{
+    blackbox_page_t *pPage = blackbox_ring_page(g_bb.head);
+    pPage->used = 0;
+    pPage->dropped = (g_bb.pending_drops > 0xFFFF) ? 0xFFFF : g_bb.pending_drops;
+    g_bb.pending_drops = 0;
+}
+
+/**
+ * Counts the page at the head as full, and starts the next page
+ * @returns false if the ring has no free page
+ * @pre The interrupts are masked
+ */
+static bool blackbox_seal(void)
+{
+    if (g_bb.full >= (BLACKBOX_RAM_PAGES - 1)) {
+        return false;
+    }
+
+    BLACKBOX_BARRIER();
+    ++g_bb.full;
+    g_bb.head = (g_bb.head + 1) % BLACKBOX_RAM_PAGES;
+    if (g_bb.full > g_bb.stats.watermark) {
+        g_bb.stats.watermark = g_bb.full;
+    }
+    blackbox_begin_page();
+    return true;
+}
+
+/// Counts the page at the head as full if it has records, so it is written without waiting for more records
+static void blackbox_seal_partial(void)
+{
+    taskENTER_CRITICAL();
+    if (blackbox_ring_page(g_bb.head)->used > 0) {
+        blackbox_seal();
+    }
+    taskEXIT_CRITICAL();
+}
+
+/// Writes the page at the tail of the ring to the flash memory
+static void blackbox_write_page(void)
+{
+    blackbox_page_t *pPage = blackbox_ring_page(g_bb.tail);
+    const uint32_t bytes = sizeof(*pPage) + pPage->used;
+
+    /* The rest of the page is left as if it was erased */
+    memset((uint8_t*) pPage + bytes, 0xFF, g_bb.page_bytes - bytes);
+    pPage->magic = BLACKBOX_PAGE_MAGIC;
+    pPage->seq = g_bb.seq++;
+    pPage->session = g_bb.session;
+    pPage->crc = 0;
+    pPage->crc = crc16_update(CRC16_INIT, pPage, bytes);
+
+    const uint32_t start_ms = sys_get_uptime_ms();
+    spi1_lock();
+    flash_raw_write_page(g_bb.next_page, pPage);
+    spi1_unlock();
+
+    const uint32_t write_ms = sys_get_uptime_ms() - start_ms;
+    if (write_ms > g_bb.stats.max_write_ms) {
+        g_bb.stats.max_write_ms = (write_ms > 0xFFFF) ? 0xFFFF : write_ms;
+    }
+
+    g_bb.next_page = (g_bb.next_page + 1) % g_bb.pages;
+    if (g_bb.stats.log_pages < g_bb.pages) {
+        ++g_bb.stats.log_pages;
+    }
+    ++g_bb.stats.pages;
+
+    /* The page was sent to the flash memory, so it can be filled again */
+    taskENTER_CRITICAL();
+    g_bb.tail = (g_bb.tail + 1) % BLACKBOX_RAM_PAGES;
+    --g_bb.full;
+    taskEXIT_CRITICAL();
+}
+
+static void blackbox_task(void *p)
+{
+    for (;;) {
+        /* No page was full for a while, so the page being filled is written as it is */
+        if (!xSemaphoreTake(g_bb.signal, OS_MS(BLACKBOX_FLUSH_MS))) {
+            blackbox_seal_partial();
+        }
+
+        while (g_bb.full > 0) {
+            blackbox_write_page();
+        }
+    }
+}
+
+/**
+ * Finds the newest page of the log, which has the highest seq, and the number of pages of the log
+ * @pre The SPI is locked
+ */
+static void blackbox_scan(void)
+{
+    blackbox_page_t hdr;
+    bool found = false;
+
+    g_bb.pages = flash_raw_get_page_count();
+    g_bb.next_page = 0;
+    g_bb.seq = 0;
+    g_bb.session = 0;
+    g_bb.stats.log_pages = 0;
+
+    for (uint32_t page = 0; page < g_bb.pages; page++) {
+        if (!flash_raw_read(page, 0, &hdr, sizeof(hdr)) || BLACKBOX_PAGE_MAGIC != hdr.magic) {
+            continue;
+        }
+
+        ++g_bb.stats.log_pages;
+        if (!found || hdr.seq >= g_bb.seq) {
+            found = true;
+            g_bb.seq = hdr.seq + 1;
+            g_bb.session = hdr.session;
+            g_bb.next_page = (page + 1) % g_bb.pages;
+        }
+    }
+}
+
+
+
+bool blackbox_init(UBaseType_t priority)
+{
+    if (NULL != g_bb.ring) {
+        return true;
+    }
+
+    if (NULL == g_bb.signal) {
+        g_bb.signal = xSemaphoreCreateBinary();
+    }
+    if (NULL == g_bb.signal) {
+        return false;
+    }
+
+    uint8_t *ring = (uint8_t*) malloc(BLACKBOX_RAM_PAGES * BLACKBOX_MAX_PAGE_BYTES);
+    if (NULL == ring) {
+        return false;
+    }
+
+#if BUILD_CFG_MPU
+    priority |= portPRIVILEGE_BIT;
+#endif
+
+    if (!xTaskCreate(blackbox_task, "blackbox", BLACKBOX_STACK_SIZE, NULL, priority, NULL)) {
+        free(ring);
+        return false;
+    }
+
+    g_bb.ring = ring;
+
+    /* The log of the last recording can be read before the next one is started */
+    spi1_lock();
+    blackbox_scan();
+    spi1_unlock();
+    return true;
+}
+
+bool blackbox_start(void)
+{
+    const uint32_t page_bytes = flash_raw_get_page_bytes();
+
+    if (NULL == g_bb.ring || page_bytes > BLACKBOX_MAX_PAGE_BYTES) {
+        return false;
+    }
+
+    /* The pages of the last recording are written first */
+    blackbox_stop();
+    while (g_bb.full > 0) {
+        vTaskDelay(1);
+    }
+
+    spi1_lock();
+    blackbox_scan();
+    spi1_unlock();
+
+    if (0 == g_bb.pages) {
+        return false;
+    }
+
+    g_bb.page_bytes = page_bytes;
+    g_bb.head = 0;
+    g_bb.tail = 0;
+    g_bb.pending_drops = 0;
+    ++g_bb.session;
+
+    const uint32_t log_pages = g_bb.stats.log_pages;
+    memset(&g_bb.stats, 0, sizeof(g_bb.stats));
+    g_bb.stats.log_pages = log_pages;
+    g_bb.stats.session = g_bb.session;
+    blackbox_begin_page();
+
+    /* blackbox_record() starts to use the ring */
+    BLACKBOX_BARRIER();
+    g_bb.recording = true;
+    g_bb.stats.recording = true;
+    return true;
+}
+
+void blackbox_stop(void)
+{
+    if (g_bb.recording) {
+        g_bb.recording = false;
+        g_bb.stats.recording = false;
+        blackbox_seal_partial();
+        xSemaphoreGive(g_bb.signal);
+    }
+}
+
+bool blackbox_record(uint8_t id, const void *pData, uint8_t len)
+{
+    const bool isr = (0 != (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk));
+    const uint32_t bytes = BLACKBOX_REC_HDR_BYTES + len;
+    bool recorded = false;
+    bool wake = false;
+
+    if (!g_bb.recording || len > BLACKBOX_MAX_DATA) {
+        return false;
+    }
+
+    const UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    const uint64_t now_us = sys_get_uptime_us();
+    blackbox_page_t *pPage = blackbox_ring_page(g_bb.head);
+
+    /* Start the next page if the record does not fit, or if its dt_us does not fit 32 bits */
+    if (pPage->used > 0 &&
+        (sizeof(*pPage) + pPage->used + bytes > g_bb.page_bytes || (now_us - pPage->start_us) > 0xFFFFFFFFU)) {
+        if ((wake = blackbox_seal())) {
+            pPage = blackbox_ring_page(g_bb.head);
+        }
+    }
+
+    if ((0 == pPage->used || sizeof(*pPage) + pPage->used + bytes <= g_bb.page_bytes)) {
+        uint8_t *pRec = (uint8_t*) pPage + sizeof(*pPage) + pPage->used;
+        const uint32_t dt_us = (0 == pPage->used) ? 0 : (uint32_t) (now_us - pPage->start_us);
+
+        if (0 == pPage->used) {
+            pPage->start_us = now_us;
+        }
+        memcpy(pRec, &dt_us, sizeof(dt_us));
+        pRec[4] = id;
+        pRec[5] = len;
+        memcpy(pRec + BLACKBOX_REC_HDR_BYTES, pData, len);
+        pPage->used += bytes;
+
+        ++g_bb.stats.records;
+        recorded = true;
+    }
+    else {
+        ++g_bb.pending_drops;
+        ++g_bb.stats.dropped;
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+
+    /* Wake up the task once for each full page */
+    if (wake && taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        if (isr) {
+            BaseType_t woken = pdFALSE;
+            xSemaphoreGiveFromISR(g_bb.signal, &woken);
+            portEND_SWITCHING_ISR(woken);
+        }
+        else {
+            xSemaphoreGive(g_bb.signal);
+        }
+    }
+    return recorded;
+}
+
+blackbox_stats_t blackbox_get_stats(void)
+{
+    blackbox_stats_t stats;
+    taskENTER_CRITICAL();
+    stats = g_bb.stats;
+    taskEXIT_CRITICAL();
+    return stats;
+}
+
+bool blackbox_read_page(uint32_t n, void *pPage)
+{
+    blackbox_page_t *pHdr = (blackbox_page_t*) pPage;
+    bool valid = false;
+
+    if (0 == g_bb.pages || n >= g_bb.stats.log_pages) {
+        return false;
+    }
+
+    /* The oldest page is the next one to be written once the log is full */
+    const uint32_t page = (g_bb.next_page + g_bb.pages - g_bb.stats.log_pages + n) % g_bb.pages;
+
+    spi1_lock();
+    valid = flash_raw_read(page, 0, pPage, flash_raw_get_page_bytes());
+    spi1_unlock();
+
+    if (valid && BLACKBOX_PAGE_MAGIC == pHdr->magic && sizeof(*pHdr) + pHdr->used <= flash_raw_get_page_bytes()) {
+        const uint16_t crc = pHdr->crc;
+        pHdr->crc = 0;
+        valid = (crc == crc16_update(CRC16_INIT, pPage, sizeof(*pHdr) + pHdr->used));
+        pHdr->crc = crc;
+    }
+    else {
+        valid = false;
+    }
+    return valid;
+}
@@ -1,422 +1,579 @@
-/*
- *     SocialLedge.com - Copyright (C) 2013
- *
- *     This file is part of free software framework for embedded processors.
- *     You can use it and/or distribute it as long as this copyright header
- *     remains unmodified.  The code is free for personal use and requires
- *     permission to use in a commercial product.
- *
- *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
- *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
- *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
- *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
- *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
- *
- *     You can reach the author of this software at :
- *          p r e e t . w i k i @ g m a i l . c o m
- */
-
-#include "c_list.h"
-#include <stdlib.h>
-#include <string.h>
-
-
-/**
- * Data for each linked list node
- */
-typedef struct c_data_node{
-    void *data_ptr;           /**< Pointer to the data */
-    struct c_data_node *next; /**< Pointer to the next data node */
-} c_data_node_type;
-
-/**
- * The linked list type with head and tail pointer
- */
-typedef struct {
-    struct c_data_node *head;
-    struct c_data_node *tail;
-
-    uint32_t node_count;
-}c_list_type;
-
-
-
-c_list_ptr c_list_create(void)
-{
-    c_list_type* new_list = (c_list_type*)malloc(sizeof(c_list_type));
-    if(NULL != new_list) {
-        memset(new_list, 0, sizeof(c_list_type));
-    }
-    return new_list;
-}
-
-bool c_list_delete(c_list_ptr p, c_list_callback_t delete_callback)
-{
-    c_list_type *list = p;
-    if(!list) {
-        return false;
-    }
-
-     c_data_node_type *iterator = list->head;
-     while(NULL != iterator) {
-         if(delete_callback) {
-             delete_callback(iterator->data_ptr, NULL, NULL, NULL);
-         }
-
-         c_data_node_type *temp = iterator;
-         iterator = iterator->next;
-         free(temp);
-     }
-
-     list->head = NULL;
-     list->tail = NULL;
-     list->node_count = 0;
-
-     free(list);
-
-     return true;
-}
-
-uint32_t c_list_node_count(const c_list_ptr p)
-{
-    const c_list_type *list = p;
-    return list ? list->node_count : 0;
-}
-
-bool c_list_insert_elm_end(c_list_ptr p, const void *elm_ptr)
-{
-    c_list_type *list = p;
-    if(!list) {
-        return false;
-    }
-
-    /* Allocate memory for the new node and copy the data */
-    c_data_node_type *new_node = malloc(sizeof(c_data_node_type));
-    if(NULL == new_node) {
-        return false;
-    }
-    new_node->next = NULL;
-    new_node->data_ptr = (void*)elm_ptr;
-
-    if(NULL == list->head) {
-        list->head = new_node;
-        list->tail = new_node;
-    }
-    else {
-        if (list->tail) {
-            (list->tail)->next = new_node;
-        }
-        list->tail = new_node;
-    }
-
-    ++(list->node_count);
-    return true;
-}
-
-bool c_list_insert_elm_beg(c_list_ptr p, const void *elm_ptr)
-{
-    c_list_type *list = p;
-    if(!list) {
-        return false;
-    }
-
-    /* Allocate memory for the new node and copy the data */
-    c_data_node_type *new_node = malloc(sizeof(c_data_node_type));
-    if(NULL == new_node) {
-        return false;
-    }
-    new_node->next = list->head;
-    new_node->data_ptr = (void*)elm_ptr;
-
-    /* Set the head (and tail if necessary) to this node */
-    list->head = new_node;
-    if(NULL == list->tail) {
-        list->tail = new_node;
-    }
-
-    ++(list->node_count);
-    return true;
-}
-
-void* c_list_get_elm_at(c_list_ptr p, uint32_t index, void **hint)
-{
-    c_list_type *list = p;
-    if(!list) {
-        return false;
-    }
-
-    c_data_node_type **hint_node = (c_data_node_type**)hint;
-    if (hint_node && 0 != index) {
-        c_data_node_type *node = *hint_node;
-        if (NULL != node) {
-            *hint_node = node->next;
-        }
-        return node ? node->data_ptr : NULL;
-    }
-    else {
-        c_data_node_type *iterator = list->head;
-        while (index != 0 && NULL != iterator)
-        {
-            iterator = iterator->next;
-            --index;
-        }
-
-        if (!iterator || 0 != index) {
-            return NULL;
-        }
-        else {
-            if (hint_node) {
-                *hint_node = iterator->next;
-            }
-            return iterator->data_ptr;
-        }
-    }
-}
-
-void* c_list_find_elm(c_list_ptr p, c_list_callback_t callback,
-                      void *arg1, void *arg2, void *arg3)
-{
-    c_list_type *list = p;
-    if(!list || !callback) {
-        return NULL;
-    }
-
-    c_data_node_type *iterator = list->head;
-    while(NULL != iterator) {
-        if(!callback(iterator->data_ptr, arg1, arg2, arg3)) {
-            return iterator->data_ptr;
-        }
-        iterator = iterator->next;
-    }
-
-    return NULL;
-}
-
-bool c_list_delete_elm(c_list_ptr p, const void *elm_ptr)
-{
-    c_list_type *list = p;
-    if(!list) {
-        return false;
-    }
-
-    c_data_node_type *iterator = list->head;
-    c_data_node_type *prev_node = NULL;
-
-    while(NULL != iterator) {
-        if(elm_ptr == iterator->data_ptr) {
-            if(list->head == iterator) {
-                list->head = iterator->next;
-            }
-            if(list->tail == iterator) {
-                list->tail = prev_node;
-            }
-
-            /* A->B->C ==> A->C */
-            if(prev_node) {
-                prev_node->next = iterator->next;
-            }
-
-            --(list->node_count);
-            free(iterator);
-            return true;
-        }
-
-        prev_node = iterator;
-        iterator = iterator->next;
-    }
-
-    return false;
-}
-
-bool c_list_for_each_elm(const c_list_ptr p, c_list_callback_t func,
-                           void *arg1, void *arg2, void *arg3)
-{
-    const c_list_type *list = p;
-
-    if(list && func) {
-        c_data_node_type *iterator = list->head;
-        while(NULL != iterator) {
-            if(!func(iterator->data_ptr, arg1, arg2, arg3)) {
-                return false;
-            }
-            iterator = iterator->next;
-        }
-    }
-
-    return true;
-}
-
-#if 0 /* Turn to 1 to enable test code */
-#include <assert.h>
-#include <stdio.h>
-
-static uint32_t del_callback_count = 0;
-bool del_callback(void *elm_ptr, void *arg1, void *arg2, void *arg3)
-{
-    del_callback_count++;
-    return true;
-}
-
-bool del_callback_free(void *elm_ptr, void *arg1, void *arg2, void *arg3)
-{
-    del_callback_count++;
-    free(elm_ptr);
-    return true;
-}
-
-bool test_list(void)
-{
-    int i = 0;
-
-    puts("Test: C-List");
-    c_list_type *p_list = c_list_create();
-    assert(p_list);
-    do {
-        assert(!p_list->head);
-        assert(!p_list->tail);
-    } while(0);
-
-    c_list_insert_elm_end(p_list, (void*)1);
-    do {
-        c_data_node_type *p_it = p_list->head;
-        assert(p_list->head == p_list->tail);
-        assert((void*)1 == p_it->data_ptr);
-        assert(!(p_it->next));
-    } while(0);
-
-    c_list_insert_elm_end(p_list, (void*) 2);
-    do {
-        c_data_node_type *p_it = p_list->head;
-        assert((void*)1 == p_it->data_ptr);
-        assert(p_it->next);
-        assert((void*)2 == p_it->next->data_ptr);
-        assert(!(p_it->next->next));
-    } while(0);
-
-    c_list_insert_elm_end(p_list, (void*) 3);
-    do {
-        c_data_node_type *p_it = p_list->head;
-        assert((void*)1 == p_it->data_ptr);
-        assert(p_it->next);
-        assert((void*)2 == p_it->next->data_ptr);
-        assert((p_it->next->next));
-        assert((void*)3 == p_it->next->next->data_ptr);
-        assert(!(p_it->next->next->next ));
-    } while(0);
-
-    assert(!c_list_delete_elm(p_list, (void*)4));
-    assert(c_list_delete_elm(p_list, (void*)1));
-    do {
-        c_data_node_type *p_it = p_list->head;
-        assert((void*)2 == p_it->data_ptr);
-        assert(p_it->next);
-        assert((void*)3 == p_it->next->data_ptr);
-        assert(!(p_it->next->next));
-    } while(0);
-
-    assert(c_list_delete_elm(p_list, (void*)2));
-    do {
-        c_data_node_type *p_it = p_list->head;
-        assert((void*)3 == p_it->data_ptr);
-        assert(!p_it->next);
-        assert(p_list->head == p_list->tail);
-    } while(0);
-
-    assert(c_list_delete_elm(p_list, (void*)3));
-    do {
-        assert(p_list->head == 0);
-        assert(p_list->tail == 0);
-    } while(0);
-
-    c_list_insert_elm_end(p_list, (void*) 1);
-    c_list_insert_elm_end(p_list, (void*) 2);
-    c_list_insert_elm_end(p_list, (void*) 3);
-    assert(c_list_delete_elm(p_list, (void*)2));
-    do {
-        c_data_node_type *p_it = p_list->head;
-        assert((void*)1 == p_it->data_ptr);
-        assert(p_it->next);
-        assert((void*)3 == p_it->next->data_ptr);
-        assert(!(p_it->next->next));
-    } while(0);
-
-    assert(c_list_delete_elm(p_list, (void*)1));
-    assert(c_list_delete_elm(p_list, (void*)3));
-    do {
-        assert(p_list->head == 0);
-        assert(p_list->tail == 0);
-    } while(0);
-
-    c_list_type *list2 = c_list_create();
-    assert(list2);
-    do {
-        assert(!list2->head);
-        assert(!list2->tail);
-    } while(0);
-
-    assert(c_list_insert_elm_beg(list2, (void*)2));
-    do {
-        c_data_node_type *p_it = list2->head;
-        assert(list2->head == list2->tail);
-        assert((void*)2 == p_it->data_ptr);
-        assert(!(p_it->next));
-    } while(0);
-
-    c_list_insert_elm_beg(list2, (void*) 1);
-    do {
-        c_data_node_type *p_it = list2->head;
-        assert((void*)1 == p_it->data_ptr);
-        assert(p_it->next);
-        assert((void*)2 == p_it->next->data_ptr);
-        assert(!(p_it->next->next));;
-        assert(list2->head != list2->tail);
-        assert(list2->tail == list2->head->next);
-    } while(0);
-
-    c_list_insert_elm_end(list2, (void*) 3);
-    do {
-        c_data_node_type *p_it = list2->head;
-        assert((void*)1 == p_it->data_ptr);
-        assert(p_it->next);
-        assert((void*)2 == p_it->next->data_ptr);
-        assert((p_it->next->next));
-        assert((void*)3 == p_it->next->next->data_ptr);
-        assert(!(p_it->next->next->next ));
-    } while(0);
-
-    assert((void*)1 == c_list_get_elm_at(list2, 0, NULL));
-    assert((void*)2 == c_list_get_elm_at(list2, 1, NULL));
-    assert((void*)3 == c_list_get_elm_at(list2, 2, NULL));
-    assert((void*)0 == c_list_get_elm_at(list2, 3, NULL));
-    assert((void*)0 == c_list_get_elm_at(list2, 4, NULL));
-
-    assert((void*)1 == c_list_get_elm_at(list2, 0, NULL));
-    assert((void*)2 == c_list_get_elm_at(list2, 1, NULL));
-    assert((void*)3 == c_list_get_elm_at(list2, 2, NULL));
-
-    void *hint = 0;
-    assert((void*)1 == c_list_get_elm_at(list2, 0, &hint));
-    assert((void*)2 == c_list_get_elm_at(list2, 1, &hint));
-    assert((void*)3 == c_list_get_elm_at(list2, 2, &hint));
-    assert((void*)0 == c_list_get_elm_at(list2, 3, &hint));
-    assert((void*)0 == c_list_get_elm_at(list2, 4, &hint));
-
-    assert((void*)1 == c_list_get_elm_at(list2, 0, &hint));
-    assert((void*)2 == c_list_get_elm_at(list2, 1, &hint));
-    assert((void*)3 == c_list_get_elm_at(list2, 2, &hint));
-
-    del_callback_count = 0;
-    c_list_delete(list2, del_callback);
-    assert(3 == del_callback_count);
-
-    list2 = c_list_create();
-    for (i=0; i<10; i++) {
-        c_list_insert_elm_beg(list2, malloc(1));
-    }
-    del_callback_count = 0;
-    c_list_delete(list2, del_callback_free);
-    assert(10 == del_callback_count);
-
-    return true;
-}
-#endif
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include "c_list.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Data for each linked list node
+ */
+typedef struct c_data_node{
+    void *data_ptr;           /**< Pointer to the data */
+    struct c_data_node *next; /**< Pointer to the next data node */
+} c_data_node_type;
+
+/**
+ * Chunk of nodes of a pooled list; the nodes follow this header
+ */
+typedef struct c_node_chunk {
+    struct c_node_chunk *next; /**< Pointer to the next chunk */
+} c_node_chunk_type;
+
+/**
+ * The linked list type with head and tail pointer
+ */
+typedef struct {
+    struct c_data_node *head;
+    struct c_data_node *tail;
+
+    uint32_t node_count;
+
+    struct c_data_node *free_nodes;  /**< Unused nodes of the pool */
+    struct c_node_chunk *chunks;     /**< Chunks allocated for the pool */
+    uint16_t chunk_nodes;            /**< Nodes per chunk, zero if not pooled */
+}c_list_type;
+
+
+
+/** Private function of this file */
+static c_data_node_type* c_list_alloc_node(c_list_type *list)
+{
+    c_data_node_type *node = NULL;
+    uint32_t i = 0;
+
+    if (0 == list->chunk_nodes) {
+        return malloc(sizeof(c_data_node_type));
+    }
+
+    /* Allocate another chunk and put its nodes to the free list */
+    if (NULL == list->free_nodes) {
+        c_node_chunk_type *chunk = malloc(sizeof(c_node_chunk_type) +
+                                          list->chunk_nodes * sizeof(c_data_node_type));
+        if (NULL == chunk) {
+            return NULL;
+        }
+        chunk->next = list->chunks;
+        list->chunks = chunk;
+
+        node = (c_data_node_type*) (chunk + 1);
+        for (i = 0; i < list->chunk_nodes; i++) {
+            node[i].next = list->free_nodes;
+            list->free_nodes = &node[i];
+        }
+    }
+
+    node = list->free_nodes;
+    list->free_nodes = node->next;
+    return node;
+}
+
+/** Private function of this file */
+static void c_list_free_node(c_list_type *list, c_data_node_type *node)
+{
+    if (0 == list->chunk_nodes) {
+        free(node);
+    }
+    else {
+        node->next = list->free_nodes;
+        list->free_nodes = node;
+    }
+}
+
+c_list_ptr c_list_create(void)
+{
+    return c_list_create_pooled(0);
+}
+
+c_list_ptr c_list_create_pooled(uint16_t chunk_nodes)
+{
+    c_list_type* new_list = (c_list_type*)malloc(sizeof(c_list_type));
+    if(NULL != new_list) {
+        memset(new_list, 0, sizeof(c_list_type));
+        new_list->chunk_nodes = chunk_nodes;
+    }
+    return new_list;
+}
+
+bool c_list_delete(c_list_ptr p, c_list_callback_t delete_callback)
+{
+    c_list_type *list = p;
+    if(!list) {
+        return false;
+    }
+
+     c_data_node_type *iterator = list->head;
+     while(NULL != iterator) {
+         if(delete_callback) {
+             delete_callback(iterator->data_ptr, NULL, NULL, NULL);
+         }
+
+         c_data_node_type *temp = iterator;
+         iterator = iterator->next;
+         c_list_free_node(list, temp);
+     }
+
+     /* Free the chunks of a pooled list, which also frees all of its nodes */
+     while (NULL != list->chunks) {
+         c_node_chunk_type *chunk = list->chunks;
+         list->chunks = chunk->next;
+         free(chunk);
+     }
+
+     list->head = NULL;
+     list->tail = NULL;
+     list->node_count = 0;
+
+     free(list);
+
+     return true;
+}
+
+uint32_t c_list_node_count(const c_list_ptr p)
+{
+    const c_list_type *list = p;
+    return list ? list->node_count : 0;
+}
+
+bool c_list_insert_elm_end(c_list_ptr p, const void *elm_ptr)
+{
+    c_list_type *list = p;
+    if(!list) {
+        return false;
+    }
+
+    /* Allocate memory for the new node and copy the data */
+    c_data_node_type *new_node = c_list_alloc_node(list);
+    if(NULL == new_node) {
+        return false;
+    }
+    new_node->next = NULL;
+    new_node->data_ptr = (void*)elm_ptr;
+
+    if(NULL == list->head) {
+        list->head = new_node;
+        list->tail = new_node;
+    }
+    else {
+        if (list->tail) {
+            (list->tail)->next = new_node;
+        }
+        list->tail = new_node;
+    }
+
+    ++(list->node_count);
+    return true;
+}
+
+bool c_list_insert_elm_beg(c_list_ptr p, const void *elm_ptr)
+{
+    c_list_type *list = p;
+    if(!list) {
+        return false;
+    }
+
+    /* Allocate memory for the new node and copy the data */
+    c_data_node_type *new_node = c_list_alloc_node(list);
+    if(NULL == new_node) {
+        return false;
+    }
+    new_node->next = list->head;
+    new_node->data_ptr = (void*)elm_ptr;
+
+    /* Set the head (and tail if necessary) to this node */
+    list->head = new_node;
+    if(NULL == list->tail) {
+        list->tail = new_node;
+    }
+
+    ++(list->node_count);
+    return true;
+}
+
+void* c_list_get_elm_at(c_list_ptr p, uint32_t index, void **hint)
+{
+    c_list_type *list = p;
+    if(!list) {
+        return false;
+    }
+
+    c_data_node_type **hint_node = (c_data_node_type**)hint;
+    if (hint_node && 0 != index) {
+        c_data_node_type *node = *hint_node;
+        if (NULL != node) {
+            *hint_node = node->next;
+        }
+        return node ? node->data_ptr : NULL;
+    }
+    else if (NULL != list->tail && index == list->node_count - 1) {
+        if (hint_node) {
+            *hint_node = NULL;
+        }
+        return list->tail->data_ptr;
+    }
+    else {
+        c_data_node_type *iterator = list->head;
+        while (index != 0 && NULL != iterator)
+        {
+            iterator = iterator->next;
+            --index;
+        }
+
+        if (!iterator || 0 != index) {
+            return NULL;
+        }
+        else {
+            if (hint_node) {
+                *hint_node = iterator->next;
+            }
+            return iterator->data_ptr;
+        }
+    }
+}
+
+void* c_list_find_elm(c_list_ptr p, c_list_callback_t callback,
+                      void *arg1, void *arg2, void *arg3)
+{
+    c_list_type *list = p;
+    if(!list || !callback) {
+        return NULL;
+    }
+
+    c_data_node_type *iterator = list->head;
+    while(NULL != iterator) {
+        if(!callback(iterator->data_ptr, arg1, arg2, arg3)) {
+            return iterator->data_ptr;
+        }
+        iterator = iterator->next;
+    }
+
+    return NULL;
+}
+
+bool c_list_delete_elm(c_list_ptr p, const void *elm_ptr)
+{
+    c_list_type *list = p;
+    if(!list) {
+        return false;
+    }
+
+    c_data_node_type *iterator = list->head;
+    c_data_node_type *prev_node = NULL;
+
+    while(NULL != iterator) {
+        if(elm_ptr == iterator->data_ptr) {
+            if(list->head == iterator) {
+                list->head = iterator->next;
+            }
+            if(list->tail == iterator) {
+                list->tail = prev_node;
+            }
+
+            /* A->B->C ==> A->C */
+            if(prev_node) {
+                prev_node->next = iterator->next;
+            }
+
+            --(list->node_count);
+            c_list_free_node(list, iterator);
+            return true;
+        }
+
+        prev_node = iterator;
+        iterator = iterator->next;
+    }
+
+    return false;
+}
+
+bool c_list_for_each_elm(const c_list_ptr p, c_list_callback_t func,
+                           void *arg1, void *arg2, void *arg3)
+{
+    const c_list_type *list = p;
+
+    if(list && func) {
+        c_data_node_type *iterator = list->head;
+        while(NULL != iterator) {
+            if(!func(iterator->data_ptr, arg1, arg2, arg3)) {
+                return false;
+            }
+            iterator = iterator->next;
+        }
+    }
+
+    return true;
+}
+
+void c_ilist_insert_beg(c_ilist *list, c_ilist_node *node)
+{
+    node->next = list->head;
+    list->head = node;
+    if (NULL == list->tail) {
+        list->tail = node;
+    }
+    ++(list->node_count);
+}
+
+void c_ilist_insert_end(c_ilist *list, c_ilist_node *node)
+{
+    node->next = NULL;
+    if (NULL == list->head) {
+        list->head = node;
+    }
+    else {
+        list->tail->next = node;
+    }
+    list->tail = node;
+    ++(list->node_count);
+}
+
+bool c_ilist_delete(c_ilist *list, c_ilist_node *node)
+{
+    c_ilist_node *iterator = list->head;
+    c_ilist_node *prev_node = NULL;
+
+    while (NULL != iterator) {
+        if (node == iterator) {
+            if (prev_node) {
+                prev_node->next = iterator->next;
+            }
+            else {
+                list->head = iterator->next;
+            }
+            if (list->tail == iterator) {
+                list->tail = prev_node;
+            }
+
+            iterator->next = NULL;
+            --(list->node_count);
+            return true;
+        }
+
+        prev_node = iterator;
+        iterator = iterator->next;
+    }
+
+    return false;
+}
+
+#if 0 /* Turn to 1 to enable test code */
+#include <assert.h>
+#include <stdio.h>
+
+static uint32_t del_callback_count = 0;
+bool del_callback(void *elm_ptr, void *arg1, void *arg2, void *arg3)
+{
+    del_callback_count++;
+    return true;
+}
+
+bool del_callback_free(void *elm_ptr, void *arg1, void *arg2, void *arg3)
+{
+    del_callback_count++;
+    free(elm_ptr);
+    return true;
+}
+
+bool test_list(void)
+{
+    int i = 0;
+
+    puts("Test: C-List");
+    c_list_type *p_list = c_list_create();
+    assert(p_list);
+    do {
+        assert(!p_list->head);
+        assert(!p_list->tail);
+    } while(0);
+
+    c_list_insert_elm_end(p_list, (void*)1);
+    do {
+        c_data_node_type *p_it = p_list->head;
+        assert(p_list->head == p_list->tail);
+        assert((void*)1 == p_it->data_ptr);
+        assert(!(p_it->next));
+    } while(0);
+
+    c_list_insert_elm_end(p_list, (void*) 2);
+    do {
+        c_data_node_type *p_it = p_list->head;
+        assert((void*)1 == p_it->data_ptr);
+        assert(p_it->next);
+        assert((void*)2 == p_it->next->data_ptr);
+        assert(!(p_it->next->next));
+    } while(0);
+
+    c_list_insert_elm_end(p_list, (void*) 3);
+    do {
+        c_data_node_type *p_it = p_list->head;
+        assert((void*)1 == p_it->data_ptr);
+        assert(p_it->next);
+        assert((void*)2 == p_it->next->data_ptr);
+        assert((p_it->next->next));
+        assert((void*)3 == p_it->next->next->data_ptr);
+        assert(!(p_it->next->next->next ));
+    } while(0);
+
+    assert(!c_list_delete_elm(p_list, (void*)4));
+    assert(c_list_delete_elm(p_list, (void*)1));
+    do {
+        c_data_node_type *p_it = p_list->head;
+        assert((void*)2 == p_it->data_ptr);
+        assert(p_it->next);
+        assert((void*)3 == p_it->next->data_ptr);
+        assert(!(p_it->next->next));
+    } while(0);
+
+    assert(c_list_delete_elm(p_list, (void*)2));
+    do {
+        c_data_node_type *p_it = p_list->head;
+        assert((void*)3 == p_it->data_ptr);
+        assert(!p_it->next);
+        assert(p_list->head == p_list->tail);
+    } while(0);
+
+    assert(c_list_delete_elm(p_list, (void*)3));
+    do {
+        assert(p_list->head == 0);
+        assert(p_list->tail == 0);
+    } while(0);
+
+    c_list_insert_elm_end(p_list, (void*) 1);
+    c_list_insert_elm_end(p_list, (void*) 2);
+    c_list_insert_elm_end(p_list, (void*) 3);
+    assert(c_list_delete_elm(p_list, (void*)2));
+    do {
+        c_data_node_type *p_it = p_list->head;
+        assert((void*)1 == p_it->data_ptr);
+        assert(p_it->next);
+        assert((void*)3 == p_it->next->data_ptr);
+        assert(!(p_it->next->next));
+    } while(0);
+
+    assert(c_list_delete_elm(p_list, (void*)1));
+    assert(c_list_delete_elm(p_list, (void*)3));
+    do {
+        assert(p_list->head == 0);
+        assert(p_list->tail == 0);
+    } while(0);
+
+    c_list_type *list2 = c_list_create();
+    assert(list2);
+    do {
+        assert(!list2->head);
+        assert(!list2->tail);
+    } while(0);
+
+    assert(c_list_insert_elm_beg(list2, (void*)2));
+    do {
+        c_data_node_type *p_it = list2->head;
+        assert(list2->head == list2->tail);
+        assert((void*)2 == p_it->data_ptr);
+        assert(!(p_it->next));
+    } while(0);
+
+    c_list_insert_elm_beg(list2, (void*) 1);
+    do {
+        c_data_node_type *p_it = list2->head;
+        assert((void*)1 == p_it->data_ptr);
+        assert(p_it->next);
+        assert((void*)2 == p_it->next->data_ptr);
+        assert(!(p_it->next->next));;
+        assert(list2->head != list2->tail);
+        assert(list2->tail == list2->head->next);
+    } while(0);
+
+    c_list_insert_elm_end(list2, (void*) 3);
+    do {
+        c_data_node_type *p_it = list2->head;
+        assert((void*)1 == p_it->data_ptr);
+        assert(p_it->next);
+        assert((void*)2 == p_it->next->data_ptr);
+        assert((p_it->next->next));
+        assert((void*)3 == p_it->next->next->data_ptr);
+        assert(!(p_it->next->next->next ));
+    } while(0);
+
+    assert((void*)1 == c_list_get_elm_at(list2, 0, NULL));
+    assert((void*)2 == c_list_get_elm_at(list2, 1, NULL));
+    assert((void*)3 == c_list_get_elm_at(list2, 2, NULL));
+    assert((void*)0 == c_list_get_elm_at(list2, 3, NULL));
+    assert((void*)0 == c_list_get_elm_at(list2, 4, NULL));
+
+    assert((void*)1 == c_list_get_elm_at(list2, 0, NULL));
+    assert((void*)2 == c_list_get_elm_at(list2, 1, NULL));
+    assert((void*)3 == c_list_get_elm_at(list2, 2, NULL));
+
+    void *hint = 0;
+    assert((void*)1 == c_list_get_elm_at(list2, 0, &hint));
+    assert((void*)2 == c_list_get_elm_at(list2, 1, &hint));
+    assert((void*)3 == c_list_get_elm_at(list2, 2, &hint));
+    assert((void*)0 == c_list_get_elm_at(list2, 3, &hint));
+    assert((void*)0 == c_list_get_elm_at(list2, 4, &hint));
+
+    assert((void*)1 == c_list_get_elm_at(list2, 0, &hint));
+    assert((void*)2 == c_list_get_elm_at(list2, 1, &hint));
+    assert((void*)3 == c_list_get_elm_at(list2, 2, &hint));
+
+    del_callback_count = 0;
+    c_list_delete(list2, del_callback);
+    assert(3 == del_callback_count);
+
+    list2 = c_list_create();
+    for (i=0; i<10; i++) {
+        c_list_insert_elm_beg(list2, malloc(1));
+    }
+    del_callback_count = 0;
+    c_list_delete(list2, del_callback_free);
+    assert(10 == del_callback_count);
+
+    puts("Test: Pooled C-List");
+    list2 = c_list_create_pooled(4);
+    for (i=1; i<=10; i++) {
+        assert(c_list_insert_elm_end(list2, (void*)i));
+    }
+    assert(10 == c_list_node_count(list2));
+    assert((void*)10 == c_list_get_elm_at(list2, 9, NULL));
+    assert(c_list_delete_elm(list2, (void*)10));
+    assert(c_list_delete_elm(list2, (void*)1));
+    assert((void*)9 == c_list_get_elm_at(list2, 7, NULL));
+    assert(c_list_insert_elm_beg(list2, (void*)1));
+    assert((void*)1 == c_list_get_elm_at(list2, 0, NULL));
+    del_callback_count = 0;
+    c_list_delete(list2, del_callback);
+    assert(9 == del_callback_count);
+
+    puts("Test: Intrusive C-List");
+    c_ilist ilist = C_ILIST_INIT;
+    c_ilist_node n1, n2, n3;
+    c_ilist_insert_end(&ilist, &n2);
+    c_ilist_insert_end(&ilist, &n3);
+    c_ilist_insert_beg(&ilist, &n1);
+    assert(3 == ilist.node_count);
+    assert(&n1 == ilist.head && &n2 == n1.next && &n3 == n2.next && &n3 == ilist.tail);
+    assert(c_ilist_delete(&ilist, &n3));
+    assert(&n2 == ilist.tail && !n2.next);
+    assert(!c_ilist_delete(&ilist, &n3));
+    assert(c_ilist_delete(&ilist, &n1));
+    assert(c_ilist_delete(&ilist, &n2));
+    assert(!ilist.head && !ilist.tail && 0 == ilist.node_count);
+
+    return true;
+}
+#endif
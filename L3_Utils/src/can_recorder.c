@@ -0,0 +1,460 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "can_recorder.h"
+#include "stream_file.h"
+#include "task.h"
+#include "semphr.h"
+#include "lpc_isr.h"    // RAMFUNC
+#include "lpc_sys.h"    // sys_get_uptime_ms(), sys_get_uptime_us()
+
+
+
+/// The records of a sector, which is the unit of the writes of the batches
+#define CAN_REC_PER_SECTOR      (_MAX_SS / sizeof(can_rec_t))
+
+/// The records of the ring that are not kept before the trigger, so the markers of the trigger always fit
+#define CAN_REC_ARM_SPARE       4
+
+/// Compiler memory barrier to publish the records of the ring before its index
+#define CAN_REC_BARRIER()       __asm volatile ("" ::: "memory")
+
+/**
+ * The recorder.  The ring is a single-producer single-consumer ring: the tap writes the head, and
+ * the task writes the tail, except while the recorder is armed, when the tap also moves the tail
+ * to discard the oldest frames before the trigger.  The tap only uses the ring while the state is
+ * armed or recording, so the ring is reset by the tasks while it is stopped.
+ */
+typedef struct {
+    can_rec_t *ring;                    ///< The RAM ring
+    uint16_t size;                      ///< The records of the ring
+    volatile uint16_t head;             ///< The index of the ring written by the tap
+    volatile uint16_t tail;             ///< The index of the ring written by the task, or by the tap while armed
+    volatile can_rec_state_t state;     ///< The state of the recorder
+
+    uint64_t last_us;                   ///< The time of the last record of the ring, or of the start
+    uint32_t pending_drops;             ///< The frames that were dropped since the last record
+    uint32_t post_left;                 ///< The frames left to record after the trigger, or 0 for all
+    uint32_t post_frames;               ///< @see can_recorder_arm()
+    uint16_t pre_frames;                ///< @see can_recorder_arm()
+    can_rec_filter_t trigger;           ///< @see can_recorder_arm()
+    can_rec_filter_t filters[CAN_RECORDER_MAX_FILTERS];    ///< @see can_recorder_set_filters()
+    uint8_t filter_count;               ///< The used entries of filters[]
+
+    can_rec_stats_t stats;              ///< @see can_recorder_get_stats()
+    uint32_t synced_ms;                 ///< The uptime of the last sync of the file
+    bool opened;                        ///< True if the file is open
+    stream_file_t file;                 ///< The file of the recording
+    SemaphoreHandle_t signal;           ///< Given by the tap to wake up the task
+    SemaphoreHandle_t lock;             ///< Protects the file, and the ring while it is written to the file
+} can_recorder_t;
+
+static can_recorder_t g_rec;
+
+
+
+/// @returns the number of records of the ring between the tail and the head
+static inline uint16_t can_recorder_count(uint16_t head, uint16_t tail)
+{
+    return (head >= tail) ? (head - tail) : (g_rec.size - tail + head);
+}
+
+/// @returns the index after the given index of the ring
+static inline uint16_t can_recorder_next(uint16_t idx, uint16_t n)
+{
+    idx += n;
+    return (idx >= g_rec.size) ? (idx - g_rec.size) : idx;
+}
+
+/// @returns true if the key of a frame matches the filter
+static inline bool can_recorder_match(const can_rec_filter_t *pFilter, uint32_t key)
+{
+    return (key & pFilter->mask) == (pFilter->key & pFilter->mask);
+}
+
+/// Writes a record to the ring, which should only be called by the tap; @returns false if the ring is full
+static inline bool can_recorder_put(uint32_t info, uint32_t msg_id, uint64_t data)
+{
+    const uint16_t head = g_rec.head;
+    const uint16_t next = can_recorder_next(head, 1);
+
+    if (next == g_rec.tail) {
+        return false;
+    }
+
+    can_rec_t *pRec = &g_rec.ring[head];
+    pRec->info = info;
+    pRec->msg_id = msg_id;
+    pRec->data.qword = data;
+
+    CAN_REC_BARRIER();
+    g_rec.head = next;
+    return true;
+}
+
+/// Fills a marker record, which has the full time in its data
+static inline void can_recorder_fill_marker(can_rec_t *pRec, can_rec_marker_t type, uint32_t arg, uint64_t timestamp_us)
+{
+    pRec->info = ((uint32_t) timestamp_us & CAN_REC_TIME_MASK) | (sizeof(pRec->data) << CAN_REC_DLC_SHIFT);
+    pRec->msg_id = CAN_REC_MARKER | (arg << 8) | type;
+    pRec->data.qword = timestamp_us;
+}
+
+/// Writes a marker to the ring; @returns false if the ring is full
+static inline bool can_recorder_put_marker(can_rec_marker_t type, uint32_t arg, uint64_t timestamp_us)
+{
+    can_rec_t marker;
+    can_recorder_fill_marker(&marker, type, arg, timestamp_us);
+    return can_recorder_put(marker.info, marker.msg_id, marker.data.qword);
+}
+
+/// The tap of both CANs, @see CAN_set_tap()
+static RAMFUNC void can_recorder_tap(can_t can, const can_msg_t *pMsg, uint64_t timestamp_us, bool tx)
+{
+    can_recorder_t *r = &g_rec;
+    const can_rec_state_t state = r->state;
+    bool marked = false;
+    uint8_t i = 0;
+
+    if (can_rec_armed != state && can_rec_recording != state) {
+        return;
+    }
+
+    const uint32_t key = (pMsg->msg_id & CAN_REC_KEY_ID_MASK) |
+                         (pMsg->frame_fields.is_29bit ? CAN_REC_KEY_29BIT : 0) |
+                         (can2 == can ? CAN_REC_KEY_CAN2 : 0) |
+                         (tx ? CAN_REC_KEY_TX : 0);
+
+    for (i = 0; i < r->filter_count && !can_recorder_match(&r->filters[i], key); i++) {
+        ;
+    }
+    if (r->filter_count > 0 && i >= r->filter_count) {
+        return;
+    }
+
+    if (can_rec_armed == state) {
+        /* Only keep the frames before the trigger, so the ring always has space while armed */
+        while (can_recorder_count(r->head, r->tail) >= r->pre_frames) {
+            if (r->head == r->tail) {
+                break;
+            }
+            r->tail = can_recorder_next(r->tail, 1);
+        }
+
+        if (can_recorder_match(&r->trigger, key)) {
+            marked = can_recorder_put_marker(can_rec_trigger, 0, timestamp_us);
+            r->post_left = r->post_frames;
+            r->state = can_rec_recording;
+        }
+    }
+    else if (r->pending_drops > 0) {
+        const uint32_t drops = (r->pending_drops > 0xFFFF) ? 0xFFFF : r->pending_drops;
+        if ((marked = can_recorder_put_marker(can_rec_dropped, drops, timestamp_us))) {
+            r->pending_drops -= drops;
+        }
+    }
+
+    /* The low bits of the time cannot tell how far this frame is from the last record */
+    if (!marked && (timestamp_us - r->last_us) > CAN_REC_TIME_MASK) {
+        can_recorder_put_marker(can_rec_time, 0, timestamp_us);
+    }
+
+    const uint32_t info = ((uint32_t) timestamp_us & CAN_REC_TIME_MASK) |
+                          (pMsg->frame_fields.data_len << CAN_REC_DLC_SHIFT) |
+                          (can2 == can ? CAN_REC_INFO_CAN2 : 0) |
+                          (tx ? CAN_REC_INFO_TX : 0) |
+                          (pMsg->frame_fields.is_rtr ? CAN_REC_INFO_RTR : 0) |
+                          (pMsg->frame_fields.is_29bit ? CAN_REC_INFO_29BIT : 0);
+
+    if (can_recorder_put(info, pMsg->msg_id, pMsg->data.qword)) {
+        const uint16_t count = can_recorder_count(r->head, r->tail);
+        r->last_us = timestamp_us;
+        r->stats.frames++;
+        if (count > r->stats.watermark) {
+            r->stats.watermark = count;
+        }
+
+        /* Wake up the task once for each batch, or when the frames after the trigger are recorded */
+        bool wake = (can_rec_recording == r->state && count == CAN_RECORDER_BATCH_FRAMES);
+        if (can_rec_recording == r->state && r->post_left > 0 && 0 == --r->post_left) {
+            r->state = can_rec_done;
+            wake = true;
+        }
+        if (wake) {
+            long higherPriorityTaskWoken = 0;
+            xSemaphoreGiveFromISR(r->signal, &higherPriorityTaskWoken);
+            portEND_SWITCHING_ISR(higherPriorityTaskWoken);
+        }
+    }
+    else {
+        r->pending_drops++;
+        r->stats.dropped++;
+    }
+}
+
+/**
+ * Writes the records of the ring to the file in whole sectors, or all of them and syncs the file.
+ * @pre The lock is taken, and the state is recording or done.
+ */
+static FRESULT can_recorder_write(bool sync)
+{
+    can_recorder_t *r = &g_rec;
+    FRESULT status = FR_OK;
+
+    for (;;) {
+        const uint16_t head = r->head;
+        const uint16_t tail = r->tail;
+        uint16_t n = (head >= tail) ? (head - tail) : (r->size - tail);
+
+        if (!sync) {
+            n -= (n % CAN_REC_PER_SECTOR);
+        }
+        if (0 == n) {
+            break;
+        }
+
+        const uint32_t start_ms = sys_get_uptime_ms();
+        if (FR_OK != (status = stream_file_append(&r->file, &r->ring[tail], n * sizeof(can_rec_t)))) {
+            break;
+        }
+
+        const uint32_t write_ms = sys_get_uptime_ms() - start_ms;
+        if (write_ms > r->stats.max_write_ms) {
+            r->stats.max_write_ms = (write_ms > 0xFFFF) ? 0xFFFF : write_ms;
+        }
+
+        /* The records are copied to the file before the tap can reuse them */
+        CAN_REC_BARRIER();
+        r->tail = can_recorder_next(tail, n);
+    }
+
+    if (FR_OK == status && sync) {
+        status = stream_file_sync(&r->file);
+        r->synced_ms = sys_get_uptime_ms();
+    }
+    r->stats.file_bytes = stream_file_size(&r->file);
+    return status;
+}
+
+/// Closes the file, which ends the recording; @pre The lock is taken
+static FRESULT can_recorder_close(void)
+{
+    can_recorder_t *r = &g_rec;
+    const can_rec_state_t state = r->state;
+    FRESULT status = FR_OK;
+
+    /* The tap does not use the ring once it is stopped */
+    r->state = can_rec_stopped;
+
+    if (r->opened) {
+        if (can_rec_recording == state || can_rec_done == state) {
+            status = can_recorder_write(true);
+        }
+        const FRESULT closed = stream_file_close(&r->file);
+        if (FR_OK == status) {
+            status = closed;
+        }
+        r->opened = false;
+    }
+    return status;
+}
+
+static void can_recorder_task(void *p)
+{
+    can_recorder_t *r = &g_rec;
+
+    for (;;) {
+        xSemaphoreTake(r->signal, OS_MS(CAN_RECORDER_SYNC_MS));
+        xSemaphoreTake(r->lock, portMAX_DELAY);
+
+        const can_rec_state_t state = r->state;
+        if (r->opened && (can_rec_recording == state || can_rec_done == state)) {
+            const bool sync = (sys_get_uptime_ms() - r->synced_ms >= CAN_RECORDER_SYNC_MS);
+            FRESULT status = FR_OK;
+
+            /* The frames after the trigger are recorded, so close the file, but stay done */
+            if (can_rec_done == state) {
+                status = can_recorder_close();
+                r->state = can_rec_done;
+            }
+            /* Such as if the disk is full or removed, which ends the recording */
+            else if (FR_OK != (status = can_recorder_write(sync))) {
+                can_recorder_close();
+            }
+            r->stats.error = status;
+        }
+
+        xSemaphoreGive(r->lock);
+    }
+}
+
+/// Opens the file, and starts the recording in the given state
+static FRESULT can_recorder_open(const char *filename, can_rec_state_t state)
+{
+    can_recorder_t *r = &g_rec;
+    FRESULT status = FR_NOT_READY;
+
+    if (NULL == r->ring) {
+        return FR_NOT_READY;
+    }
+
+    xSemaphoreTake(r->lock, portMAX_DELAY);
+    can_recorder_close();
+
+    if (FR_OK == (status = stream_file_open(&r->file, filename, CAN_RECORDER_PREALLOC_BYTES))) {
+        const uint64_t now_us = sys_get_uptime_us();
+        can_rec_t start;
+        can_recorder_fill_marker(&start, can_rec_start, 0, now_us);
+
+        if (FR_OK == (status = stream_file_truncate(&r->file)) &&
+            FR_OK == (status = stream_file_append(&r->file, &start, sizeof(start)))) {
+            r->head = 0;
+            r->tail = 0;
+            r->last_us = now_us;
+            r->pending_drops = 0;
+            memset(&r->stats, 0, sizeof(r->stats));
+            r->stats.file_bytes = stream_file_size(&r->file);
+            r->synced_ms = sys_get_uptime_ms();
+            r->opened = true;
+
+            /* The tap starts to use the ring */
+            CAN_REC_BARRIER();
+            r->state = state;
+        }
+        else {
+            stream_file_close(&r->file);
+        }
+    }
+
+    xSemaphoreGive(r->lock);
+    return status;
+}
+
+
+
+bool can_recorder_init(uint16_t ring_frames, UBaseType_t priority)
+{
+    can_recorder_t *r = &g_rec;
+    uint32_t size = ring_frames + CAN_REC_PER_SECTOR - 1;
+    can_rec_t *ring = NULL;
+
+    if (NULL != r->ring) {
+        return true;
+    }
+
+    /* The ring holds one less record than its size, so it needs at least two sectors */
+    size -= (size % CAN_REC_PER_SECTOR);
+    if (size < 2 * CAN_REC_PER_SECTOR) {
+        size = 2 * CAN_REC_PER_SECTOR;
+    }
+    if (size > 0xFFFF) {
+        return false;
+    }
+
+    if (NULL == r->signal) {
+        r->signal = xSemaphoreCreateBinary();
+    }
+    if (NULL == r->lock) {
+        r->lock = xSemaphoreCreateMutex();
+    }
+    if (NULL == r->signal || NULL == r->lock || NULL == (ring = (can_rec_t*) malloc(size * sizeof(can_rec_t)))) {
+        return false;
+    }
+
+#if BUILD_CFG_MPU
+    priority |= portPRIVILEGE_BIT;
+#endif
+
+    if (!xTaskCreate(can_recorder_task, "canrec", CAN_RECORDER_STACK_SIZE, NULL, priority, NULL)) {
+        free(ring);
+        return false;
+    }
+
+    r->size = size;
+    r->ring = ring;
+    CAN_set_tap(can1, can_recorder_tap);
+    CAN_set_tap(can2, can_recorder_tap);
+    return true;
+}
+
+bool can_recorder_set_filters(const can_rec_filter_t *filters, uint8_t count)
+{
+    if (count > CAN_RECORDER_MAX_FILTERS || (count > 0 && NULL == filters)) {
+        return false;
+    }
+
+    taskENTER_CRITICAL();
+    if (count > 0) {
+        memcpy(g_rec.filters, filters, count * sizeof(*filters));
+    }
+    g_rec.filter_count = count;
+    taskEXIT_CRITICAL();
+    return true;
+}
+
+FRESULT can_recorder_start(const char *filename)
+{
+    return can_recorder_open(filename, can_rec_recording);
+}
+
+FRESULT can_recorder_arm(const char *filename, const can_rec_filter_t *trigger,
+                         uint16_t pre_frames, uint32_t post_frames)
+{
+    can_recorder_t *r = &g_rec;
+
+    if (NULL == trigger || NULL == r->ring) {
+        return FR_INVALID_PARAMETER;
+    }
+
+    /* The recorder is stopped by can_recorder_open() before these are used by the tap */
+    xSemaphoreTake(r->lock, portMAX_DELAY);
+    can_recorder_close();
+    r->trigger = *trigger;
+    r->pre_frames = (pre_frames > r->size - CAN_REC_ARM_SPARE) ? (r->size - CAN_REC_ARM_SPARE) : pre_frames;
+    r->post_frames = post_frames;
+    xSemaphoreGive(r->lock);
+
+    return can_recorder_open(filename, can_rec_armed);
+}
+
+FRESULT can_recorder_stop(void)
+{
+    FRESULT status = FR_NOT_READY;
+
+    if (NULL != g_rec.ring) {
+        xSemaphoreTake(g_rec.lock, portMAX_DELAY);
+        status = can_recorder_close();
+        xSemaphoreGive(g_rec.lock);
+    }
+    return status;
+}
+
+can_rec_stats_t can_recorder_get_stats(void)
+{
+    can_rec_stats_t stats;
+
+    taskENTER_CRITICAL();
+    stats = g_rec.stats;
+    stats.state = g_rec.state;
+    taskEXIT_CRITICAL();
+
+    return stats;
+}
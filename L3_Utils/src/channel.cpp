@@ -0,0 +1,51 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include "channel.hpp"
+
+
+
+channel_base *channel_base::mpList = NULL;
+
+channel_base::channel_base(const char *pName) :
+    mpNext(mpList), mpName(pName)
+{
+    /* The constructors of the globals run one at a time before main() */
+    mpList = this;
+}
+
+channel_base::~channel_base()
+{
+    channel_base **ppChannel = &mpList;
+    while (NULL != *ppChannel && this != *ppChannel) {
+        ppChannel = &(*ppChannel)->mpNext;
+    }
+    if (NULL != *ppChannel) {
+        *ppChannel = mpNext;
+    }
+}
+
+bool channel_base::initAll(void)
+{
+    bool success = true;
+
+    for (channel_base *pChannel = mpList; NULL != pChannel; pChannel = pChannel->mpNext) {
+        success = pChannel->init() && success;
+    }
+    return success;
+}
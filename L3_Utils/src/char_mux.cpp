@@ -0,0 +1,212 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <string.h>
+#include "char_mux.hpp"
+#include "FreeRTOS.h"
+#include "task.h"
+
+
+
+CharMux::Channel::Channel() :
+        mpMux(NULL), mNumber(0), mRx(CHAR_MUX_RX_BYTES),
+        mRxSignal(xSemaphoreCreateBinary()), mRxEvent(NULL),
+        mTxLock(xSemaphoreCreateMutex()), mTxLen(0)
+{
+    /* Nothing to do */
+}
+
+bool CharMux::Channel::receive(const uint8_t *pData, uint8_t len)
+{
+    const bool wasEmpty = mRx.empty();
+    const bool stored = (len == mRx.push((const char*) pData, len));
+
+    if (wasEmpty) {
+        xSemaphoreGive(mRxSignal);
+        if (mRxEvent) {
+            xSemaphoreGive(mRxEvent);
+        }
+    }
+    return stored;
+}
+
+bool CharMux::Channel::getChar(char* pInputChar, unsigned int timeout)
+{
+    const TickType_t startTick = xTaskGetTickCount();
+
+    while (!mRx.pop(pInputChar)) {
+        const unsigned int remaining = getRemainingTimeout(startTick, timeout);
+        if (0 == remaining || !xSemaphoreTake(mRxSignal, remaining)) {
+            return mRx.pop(pInputChar);
+        }
+    }
+    return true;
+}
+
+bool CharMux::Channel::flush(void)
+{
+    bool success = true;
+
+    xSemaphoreTake(mTxLock, portMAX_DELAY);
+    if (mTxLen > 0) {
+        success = mpMux->sendFrame(mNumber, mTx, mTxLen);
+        mTxLen = 0;
+    }
+    xSemaphoreGive(mTxLock);
+
+    return success;
+}
+
+bool CharMux::Channel::putChar(char out, unsigned int timeout)
+{
+    return putBlock(&out, 1, timeout);
+}
+
+bool CharMux::Channel::putBlock(const void* pData, size_t len, unsigned int timeout)
+{
+    const uint8_t *pBytes = (const uint8_t*) pData;
+    bool success = true;
+
+    xSemaphoreTake(mTxLock, portMAX_DELAY);
+    while (len > 0)
+    {
+        size_t chunk = sizeof(mTx) - mTxLen;
+        if (chunk > len) {
+            chunk = len;
+        }
+        memcpy(&mTx[mTxLen], pBytes, chunk);
+        mTxLen += chunk;
+        pBytes += chunk;
+        len -= chunk;
+
+        if (mTxLen >= sizeof(mTx)) {
+            success = mpMux->sendFrame(mNumber, mTx, mTxLen) && success;
+            mTxLen = 0;
+        }
+    }
+    xSemaphoreGive(mTxLock);
+
+    return success;
+}
+
+
+
+CharMux::CharMux(CharDev& link) :
+        mLink(link), mLinkLock(xSemaphoreCreateMutex()), mDropped(0),
+        mRxState(rx_sync), mRxChannel(0), mRxLen(0), mRxCount(0), mRxSum(0)
+{
+    for (uint8_t i = 0; i < CHAR_MUX_CHANNELS; i++) {
+        mChannels[i].init(this, i);
+    }
+}
+
+bool CharMux::start(uint8_t priority)
+{
+    return (pdPASS == xTaskCreate(task, "mux", CHAR_MUX_STACK_SIZE, this, priority, NULL));
+}
+
+bool CharMux::sendFrame(uint8_t channel, const uint8_t *pData, uint8_t len)
+{
+    uint8_t frame[3 + CHAR_MUX_FRAME_BYTES + 1];
+    uint8_t sum = channel + len;
+
+    frame[0] = CHAR_MUX_SYNC;
+    frame[1] = channel;
+    frame[2] = len;
+    for (uint8_t i = 0; i < len; i++) {
+        frame[3 + i] = pData[i];
+        sum += pData[i];
+    }
+    frame[3 + len] = ~sum;
+
+    xSemaphoreTake(mLinkLock, portMAX_DELAY);
+    const bool success = mLink.putBlock(frame, 3 + len + 1);
+    xSemaphoreGive(mLinkLock);
+
+    return success;
+}
+
+void CharMux::receive(uint8_t byte)
+{
+    switch (mRxState)
+    {
+        case rx_sync:
+            mRxState = (CHAR_MUX_SYNC == byte) ? rx_channel : rx_sync;
+            if (rx_sync == mRxState) {
+                ++mDropped;
+            }
+            break;
+
+        case rx_channel:
+            mRxChannel = byte;
+            mRxSum = byte;
+            mRxState = rx_len;
+            break;
+
+        case rx_len:
+            mRxLen = byte;
+            mRxSum += byte;
+            mRxCount = 0;
+            mRxState = (0 == byte) ? rx_sum : (byte > CHAR_MUX_FRAME_BYTES) ? rx_sync : rx_data;
+            break;
+
+        case rx_data:
+            mRxData[mRxCount++] = byte;
+            mRxSum += byte;
+            if (mRxCount >= mRxLen) {
+                mRxState = rx_sum;
+            }
+            break;
+
+        case rx_sum:
+            if ((uint8_t) ~mRxSum != byte || mRxChannel >= CHAR_MUX_CHANNELS) {
+                mDropped += mRxLen;
+            }
+            else if (!mChannels[mRxChannel].receive(mRxData, mRxLen)) {
+                ++mDropped;
+            }
+            mRxState = rx_sync;
+            break;
+
+        default:
+            mRxState = rx_sync;
+            break;
+    }
+}
+
+void CharMux::task(void *p)
+{
+    CharMux *pMux = (CharMux*) p;
+    TickType_t lastFlush = xTaskGetTickCount();
+    char c = 0;
+
+    while (1)
+    {
+        /* Receive everything that is available, but flush the channels in between */
+        if (pMux->mLink.getChar(&c, OS_MS(CHAR_MUX_FLUSH_MS))) {
+            pMux->receive((uint8_t) c);
+        }
+
+        if ((xTaskGetTickCount() - lastFlush) >= OS_MS(CHAR_MUX_FLUSH_MS)) {
+            lastFlush = xTaskGetTickCount();
+            for (uint8_t i = 0; i < CHAR_MUX_CHANNELS; i++) {
+                pMux->mChannels[i].flush();
+            }
+        }
+    }
+}
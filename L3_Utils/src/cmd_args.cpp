@@ -0,0 +1,188 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <string.h>
+#include <ctype.h>
+
+#include "cmd_args.hpp"
+
+
+
+CmdArgs::CmdArgs(const str& params) :
+    mCount(0)
+{
+    split(params());
+}
+
+CmdArgs::CmdArgs(const char *pParams) :
+    mCount(0)
+{
+    split(pParams);
+}
+
+void CmdArgs::split(const char *pParams)
+{
+    const char *p = pParams;
+
+    while (NULL != p && mCount < CMD_ARGS_MAX)
+    {
+        while (' ' == *p || '\t' == *p) {
+            p++;
+        }
+        if ('\0' == *p) {
+            break;
+        }
+
+        /* A quoted token ends at the closing quote, or at the end of the parameters */
+        const char end = ('"' == *p) ? '"' : ' ';
+        if ('"' == end) {
+            p++;
+        }
+
+        const char *pStart = p;
+        while ('\0' != *p && end != *p && ('"' == end || '\t' != *p)) {
+            p++;
+        }
+
+        mArgs[mCount].p = pStart;
+        mArgs[mCount].len = (uint16_t) (p - pStart);
+        mCount++;
+
+        if ('"' == end && '"' == *p) {
+            p++;
+        }
+    }
+}
+
+cmd_arg_view_t CmdArgs::operator[](uint8_t index) const
+{
+    const cmd_arg_view_t none = { NULL, 0 };
+    return (index < mCount) ? mArgs[index] : none;
+}
+
+bool CmdArgs::equals(uint8_t index, const char *pText) const
+{
+    const size_t len = strlen(pText);
+    return (index < mCount && len == mArgs[index].len && 0 == strncasecmp(mArgs[index].p, pText, len));
+}
+
+bool CmdArgs::hasFlag(const char *pName) const
+{
+    for (uint8_t i = 0; i < mCount; i++) {
+        if (equals(i, pName)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint8_t CmdArgs::find(const char *pName, uint16_t nameLen) const
+{
+    uint8_t i = 0;
+    for (i = 0; i < mCount; i++) {
+        if (mArgs[i].len >= nameLen && 0 == strncasecmp(mArgs[i].p, pName, nameLen)) {
+            break;
+        }
+    }
+    return i;
+}
+
+cmd_arg_view_t CmdArgs::getValue(const char *pName) const
+{
+    const uint16_t nameLen = strlen(pName);
+    const uint8_t i = find(pName, nameLen);
+    cmd_arg_view_t value = { NULL, 0 };
+
+    if (i < mCount) {
+        if (mArgs[i].len > nameLen) {
+            value.p = mArgs[i].p + nameLen;
+            value.len = mArgs[i].len - nameLen;
+        }
+        else if (i + 1 < mCount) {
+            value = mArgs[i + 1];
+        }
+    }
+    return value;
+}
+
+bool CmdArgs::toUint(const cmd_arg_view_t& arg, unsigned int &value)
+{
+    const bool hex = (arg.len > 2 && '0' == arg.p[0] && ('x' == arg.p[1] || 'X' == arg.p[1]));
+    unsigned int v = 0;
+
+    if (NULL == arg.p || 0 == arg.len) {
+        return false;
+    }
+    for (uint16_t i = hex ? 2 : 0; i < arg.len; i++) {
+        const char c = arg.p[i];
+        if (hex && isxdigit((unsigned char) c)) {
+            v = (v << 4) | (isdigit((unsigned char) c) ? (c - '0') : (tolower((unsigned char) c) - 'a' + 10));
+        }
+        else if (!hex && isdigit((unsigned char) c)) {
+            v = (v * 10) + (c - '0');
+        }
+        else {
+            return false;
+        }
+    }
+
+    value = v;
+    return true;
+}
+
+bool CmdArgs::toInt(const cmd_arg_view_t& arg, int &value)
+{
+    const bool negative = (NULL != arg.p && arg.len > 1 && '-' == arg.p[0]);
+    cmd_arg_view_t digits = arg;
+    unsigned int v = 0;
+
+    if (negative) {
+        digits.p++;
+        digits.len--;
+    }
+    if (!toUint(digits, v)) {
+        return false;
+    }
+
+    value = negative ? -(int) v : (int) v;
+    return true;
+}
+
+bool CmdArgs::getInt(const char *pName, int &value) const
+{
+    return toInt(getValue(pName), value);
+}
+
+bool CmdArgs::getUint(const char *pName, unsigned int &value) const
+{
+    return toUint(getValue(pName), value);
+}
+
+bool CmdArgs::getString(const char *pName, char *pBuffer, size_t size) const
+{
+    const cmd_arg_view_t value = getValue(pName);
+
+    if (NULL == value.p || 0 == size) {
+        return false;
+    }
+
+    const size_t len = (value.len < size) ? value.len : (size - 1);
+    memcpy(pBuffer, value.p, len);
+    pBuffer[len] = '\0';
+    return true;
+}
@@ -0,0 +1,200 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <string.h>
+#include "command_frame.hpp"
+#include "crc.h"
+
+
+
+/// The bytes of the frame header after the sync byte: seq, flags or status, id, len
+#define FRAME_HDR_BYTES     6
+
+
+
+CommandFrame::CommandFrame(CommandProcessor& cmdProc) :
+        mCmdProc(cmdProc), mpIo(NULL), mId(0), mSeq(0), mRspLen(0)
+{
+    /* Nothing to do */
+}
+
+bool CommandFrame::handleFrame(CharDev& io, str& params)
+{
+    const unsigned int timeout = OS_MS(COMMAND_FRAME_TIMEOUT_MS);
+    uint8_t hdr[FRAME_HDR_BYTES];
+    uint8_t chunk[16];
+    uint8_t status = cmd_frame_ok;
+
+    if (!io.getBlock(hdr, sizeof(hdr), timeout)) {
+        return false;
+    }
+
+    const uint8_t flags = hdr[1];
+    uint16_t len = hdr[4] | (hdr[5] << 8);
+    uint16_t crc = crc16_update(CRC16_INIT, hdr, sizeof(hdr));
+
+    /* The int32 parameters are converted to text as they arrive, so the request needs no buffer */
+    if ((flags & cmd_frame_int_args) && (len % 4)) {
+        status = cmd_frame_too_long;
+    }
+
+    params.clear();
+    while (len > 0)
+    {
+        const uint16_t n = (len < sizeof(chunk)) ? len : sizeof(chunk);
+        if (!io.getBlock(chunk, n, timeout)) {
+            return false;
+        }
+        crc = crc16_update(crc, chunk, n);
+        len -= n;
+
+        if (cmd_frame_ok != status) {
+            continue;
+        }
+        if (flags & cmd_frame_int_args) {
+            /* Room for the separator, the sign and 10 digits of each value */
+            for (uint16_t i = 0; i + 3 < n && cmd_frame_ok == status; i += 4) {
+                const int32_t value = chunk[i] | (chunk[i+1] << 8) | (chunk[i+2] << 16) | ((uint32_t) chunk[i+3] << 24);
+                if (params.getLen() + 12 >= params.getCapacity()) {
+                    status = cmd_frame_too_long;
+                }
+                else {
+                    if (params.getLen() > 0) {
+                        params += ' ';
+                    }
+                    params.append((int) value);
+                }
+            }
+        }
+        else {
+            for (uint16_t i = 0; i < n && cmd_frame_ok == status; i++) {
+                if (params.getLen() + 1 >= params.getCapacity()) {
+                    status = cmd_frame_too_long;
+                }
+                else {
+                    params += (char) chunk[i];
+                }
+            }
+        }
+    }
+
+    if (!io.getBlock(chunk, 2, timeout)) {
+        return false;
+    }
+    if (crc != (chunk[0] | (chunk[1] << 8))) {
+        status = cmd_frame_bad_crc;
+    }
+
+    mpIo = &io;
+    mSeq = hdr[0];
+    mId = hdr[2] | (hdr[3] << 8);
+    mRspLen = 0;
+
+    if (cmd_frame_ok != status) {
+        /* Nothing to run */
+    }
+    else if (cmd_frame_list_id == mId) {
+        for (unsigned int id = 0; id < mCmdProc.getCommandCount(); id++) {
+            put(mCmdProc.getCommandName(id));
+            putChar('\n');
+        }
+    }
+    else {
+        bool handlerResult = false;
+        if (!mCmdProc.handleCommandId(mId, params, *this, handlerResult)) {
+            status = cmd_frame_unknown;
+        }
+        else if (!handlerResult) {
+            status = cmd_frame_failed;
+        }
+    }
+
+    sendResponse(status);
+    mpIo = NULL;
+    return true;
+}
+
+void CommandFrame::sendResponse(uint8_t status)
+{
+    uint8_t hdr[1 + FRAME_HDR_BYTES];
+    hdr[0] = cmd_frame_rsp_sync;
+    hdr[1] = mSeq;
+    hdr[2] = status;
+    hdr[3] = mId & 0xFF;
+    hdr[4] = mId >> 8;
+    hdr[5] = mRspLen & 0xFF;
+    hdr[6] = mRspLen >> 8;
+
+    const uint16_t crc = crc16_update(crc16_update(CRC16_INIT, &hdr[1], FRAME_HDR_BYTES), mRsp, mRspLen);
+    const uint8_t crcBytes[2] = { (uint8_t) (crc & 0xFF), (uint8_t) (crc >> 8) };
+
+    mpIo->putBlock(hdr, sizeof(hdr));
+    mpIo->putBlock(mRsp, mRspLen);
+    mpIo->putBlock(crcBytes, sizeof(crcBytes));
+    mRspLen = 0;
+}
+
+bool CommandFrame::putChar(char out, unsigned int timeout)
+{
+    if (!mpIo) {
+        return false;
+    }
+
+    mRsp[mRspLen++] = out;
+    if (mRspLen >= sizeof(mRsp)) {
+        sendResponse(cmd_frame_ok | cmd_frame_more);
+    }
+    return true;
+}
+
+bool CommandFrame::putBlock(const void* pData, size_t len, unsigned int timeout)
+{
+    const uint8_t *pBytes = (const uint8_t*) pData;
+
+    if (!mpIo || !pData) {
+        return false;
+    }
+
+    while (len > 0)
+    {
+        size_t chunk = sizeof(mRsp) - mRspLen;
+        if (chunk > len) {
+            chunk = len;
+        }
+
+        memcpy(&mRsp[mRspLen], pBytes, chunk);
+        mRspLen += chunk;
+        pBytes += chunk;
+        len -= chunk;
+
+        if (mRspLen >= sizeof(mRsp)) {
+            sendResponse(cmd_frame_ok | cmd_frame_more);
+        }
+    }
+    return true;
+}
+
+bool CommandFrame::getChar(char* pInputChar, unsigned int timeout)
+{
+    return mpIo ? mpIo->getChar(pInputChar, timeout) : false;
+}
+
+bool CommandFrame::getBlock(void* pData, size_t len, unsigned int timeout)
+{
+    return mpIo ? mpIo->getBlock(pData, len, timeout) : false;
+}
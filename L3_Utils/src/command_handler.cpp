@@ -17,7 +17,7 @@
  */
 
 #include <stdio.h>
-#include <string.h> // strlen()
+#include <string.h> // strlen() strncasecmp()
 #include "command_handler.hpp"
 
 
@@ -30,6 +30,54 @@ static const char* const SUPPORTED_COMMANDS_STR = "Supported Commands:";
 static const char* const COMMAND_FAILURE_HELP   = "Command failed!  Command's help is: ";
 static const char* const NO_HELP_STR_PTR        = "";
 
+/**
+ * The commands of CMD_DEFINE_HANDLER() of all the tables, sorted by the linker script.
+ * The symbols are weak, so a build without the section of loader.ld, such as the host
+ * benchmarks, links with both of them at zero, and each table is then empty.
+ */
+extern "C" const CmdTableEntryType __cmd_table_start[] __attribute__((weak));
+extern "C" const CmdTableEntryType __cmd_table_end[] __attribute__((weak));
+
+/**
+ * Compares a registered command name against the key while ignoring case.
+ * @returns negative if name sorts before the key, zero if they match, positive otherwise.
+ *          If prefix is true, any name that begins with the key is a match.
+ */
+static int compareCmdName(const char* pName, const char* pKey, unsigned int keyLen, bool prefix)
+{
+    const int c = strncasecmp(pName, pKey, keyLen);
+    if (0 != c || prefix) {
+        return c;
+    }
+    return ('\0' == pName[keyLen]) ? 0 : 1;
+}
+
+/**
+ * Finds the first command of the table that is not less than the name
+ * @param pTableName  The name of the table
+ * @param pName       The command name, or NULL to find the start of the table
+ */
+static const CmdTableEntryType* findTableEntry(const char* pTableName, const char* pName)
+{
+    const CmdTableEntryType* low = __cmd_table_start;
+    const CmdTableEntryType* high = __cmd_table_end;
+    while (low < high)
+    {
+        const CmdTableEntryType* mid = low + (high - low) / 2;
+        int c = strcmp(mid->pTableName, pTableName);
+        if (0 == c && pName) {
+            c = strcmp(mid->pCommandStr, pName);
+        }
+        if (c < 0) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
 
 void CommandProcessor::addHandler(CmdHandlerFuncPtr pFunc, const char* pPersistantCmdStr,
                                   const char* pPersistentCmdHelpStr,  void* pDataParam)
@@ -39,15 +87,90 @@ void CommandProcessor::addHandler(CmdHandlerFuncPtr pFunc, const char* pPersista
     handler.pCmdHelpText = pPersistentCmdHelpStr;
     handler.pFunc = pFunc;
     handler.pDataParam = pDataParam;
+#if (PROFILE_ENABLE)
+    handler.pProfile = 0;
+#endif
 
     if (0 == handler.pCmdHelpText) {
         handler.pCmdHelpText = NO_HELP_STR_PTR;
     }
     if (0 != handler.pCommandStr && 0 != handler.pFunc) {
+        const unsigned short idx = mCmdHandlerVector.size();
         mCmdHandlerVector += handler;
+
+        // Insert the index after all the commands whose name doesn't sort after this one
+        unsigned int pos = mCmdSortedIndex.size();
+        mCmdSortedIndex += idx;
+        while (pos > 0 &&
+               strcasecmp(mCmdHandlerVector[mCmdSortedIndex[pos-1]].pCommandStr, handler.pCommandStr) > 0)
+        {
+            mCmdSortedIndex[pos] = mCmdSortedIndex[pos-1];
+            pos--;
+        }
+        mCmdSortedIndex[pos] = idx;
     }
 }
 
+unsigned int CommandProcessor::addTable(const char* pTableName)
+{
+    /* The commands of the next table start after the name "\xff" of this table */
+    mpTable = findTableEntry(pTableName, 0);
+    const CmdTableEntryType* pEnd = findTableEntry(pTableName, "\xff");
+    mTableCount = (pEnd > mpTable && 0 == strcmp(mpTable->pTableName, pTableName)) ? (pEnd - mpTable) : 0;
+    return mTableCount;
+}
+
+int CommandProcessor::findCmd(const char* pKey, unsigned int keyLen, bool prefix)
+{
+    // The table is sorted, so the first command that is not less than the key is the one that takes precedence
+    unsigned int low = 0;
+    unsigned int high = mTableCount;
+    while (low < high)
+    {
+        const unsigned int mid = (low + high) / 2;
+        if (compareCmdName(mpTable[mid].pCommandStr, pKey, keyLen, prefix) < 0) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    if (low < mTableCount && 0 == compareCmdName(mpTable[low].pCommandStr, pKey, keyLen, prefix)) {
+        return low;
+    }
+
+    // Find the first sorted command that is not less than the key
+    low = 0;
+    high = mCmdSortedIndex.size();
+    while (low < high)
+    {
+        const unsigned int mid = (low + high) / 2;
+        if (compareCmdName(mCmdHandlerVector[mCmdSortedIndex[mid]].pCommandStr, pKey, keyLen, prefix) < 0) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+
+    // All the prefix matches are adjacent, and the one added first takes precedence
+    int found = -1;
+    for ( ; low < mCmdSortedIndex.size(); low++)
+    {
+        const int idx = mCmdSortedIndex[low];
+        if (0 != compareCmdName(mCmdHandlerVector[idx].pCommandStr, pKey, keyLen, prefix)) {
+            break;
+        }
+        if (found < 0 || idx < found) {
+            found = idx;
+        }
+        if (!prefix) {
+            break;
+        }
+    }
+    return (found < 0) ? found : (int) (mTableCount + found);
+}
+
 bool CommandProcessor::handleCommand(str& cmd, CharDev& output)
 {
     bool found = false;
@@ -63,55 +186,30 @@ bool CommandProcessor::handleCommand(str& cmd, CharDev& output)
     }
     else
     {
-        unsigned int i=0;
-        for(i=0; i < mCmdHandlerVector.size(); i++)
-        {
-            CmdProcessorType &cp = mCmdHandlerVector[i];
-
-            // If a command matches, return the response from the attached function pointer
-            if(cmd.beginsWithWholeWordIgnoreCase(cp.pCommandStr))
-            {
-                prepareCmdParam(cmd, cp.pCommandStr);
-                if (!cp.pFunc(cmd, output, cp.pDataParam)) {
-                    output.putline(COMMAND_FAILURE_HELP);
-                    output.putline(cp.pCmdHelpText);
-                }
-                found = true;
-                break;
-            }
-        }
+        // Command name is the first word of the input
+        const char* pCmdName = cmd();
+        const char* pSpace = strchr(pCmdName, ' ');
+        const unsigned int cmdLen = pSpace ? (pSpace - pCmdName) : strlen(pCmdName);
+
+        int idx = findCmd(pCmdName, cmdLen, false);
 
         /**
          * If command not matched, try to partially match a command.
-         * ie: If command is "magic", match "m" as command
+         * ie: If command is "thermostat", match "th" or "th on" as command
          */
-        if(!found)
+        if (idx < 0 && mEnShortCmds && cmdLen >= 2) {
+            idx = findCmd(pCmdName, cmdLen, true);
+        }
+
+        // If a command matches, return the response from the attached function pointer
+        if (idx >= 0)
         {
-            for(i=0; i < mCmdHandlerVector.size(); i++)
-            {
-                CmdProcessorType &cp = mCmdHandlerVector[i];
-                STR_ON_STACK(regCmd, 32);
-                regCmd = cp.pCommandStr;  /* Set to the command text */
-
-                /**
-                 * Check here if pCommandStr contains partial command :
-                 *      - regCmd may be "thermostat", when input is "th" or "th on"
-                 *      - So accept this command as shorthand command
-                 */
-                char shortCmd[8] = { 0 };
-                cmd.scanf("%7s ", shortCmd);
-                if(strlen(shortCmd) >= 2 && regCmd.beginsWithIgnoreCase(shortCmd))
-                {
-                    prepareCmdParam(cmd, cp.pCommandStr);
-                    if (!cp.pFunc(cmd, output, cp.pDataParam)) {
-                        output.putline(COMMAND_FAILURE_HELP);
-                        output.putline(cp.pCmdHelpText);
-                    }
-
-                    found = true;
-                    break;
-                }
+            prepareCmdParam(cmd, cmdName(idx));
+            if (!callHandler(idx, cmd, output)) {
+                output.putline(COMMAND_FAILURE_HELP);
+                output.putline(cmdHelp(idx));
             }
+            found = true;
         }
 
         if(!found)
@@ -122,17 +220,79 @@ bool CommandProcessor::handleCommand(str& cmd, CharDev& output)
     return found;
 }
 
+const char* CommandProcessor::getCommandName(unsigned int id)
+{
+    return (id < getCommandCount()) ? cmdName(id) : 0;
+}
+
+bool CommandProcessor::handleCommandId(unsigned int id, str& cmdParams, CharDev& output, bool& handlerResult)
+{
+    if (id >= getCommandCount()) {
+        return false;
+    }
+
+    handlerResult = callHandler(id, cmdParams, output);
+    return true;
+}
+
+const char* CommandProcessor::cmdName(unsigned int id)
+{
+    return (id < mTableCount) ? mpTable[id].pCommandStr : mCmdHandlerVector[id - mTableCount].pCommandStr;
+}
+
+const char* CommandProcessor::cmdHelp(unsigned int id)
+{
+    const char* pHelp = (id < mTableCount) ? mpTable[id].pCmdHelpText : mCmdHandlerVector[id - mTableCount].pCmdHelpText;
+    return (0 == pHelp) ? NO_HELP_STR_PTR : pHelp;
+}
+
+bool CommandProcessor::callHandler(unsigned int id, str& cmdParams, CharDev& output)
+{
+    CmdHandlerFuncPtr pFunc = 0;
+    void* pDataParam = 0;
+#if (PROFILE_ENABLE)
+    profile_site_t** ppProfile = 0;
+#endif
+
+    if (id < mTableCount) {
+        pFunc = mpTable[id].pFunc;
+        pDataParam = mpTable[id].pDataParam;
+#if (PROFILE_ENABLE)
+        ppProfile = mpTable[id].ppProfile;
+#endif
+    }
+    else {
+        CmdProcessorType &cp = mCmdHandlerVector[id - mTableCount];
+        pFunc = cp.pFunc;
+        pDataParam = cp.pDataParam;
+#if (PROFILE_ENABLE)
+        ppProfile = &cp.pProfile;
+#endif
+    }
+
+#if (PROFILE_ENABLE)
+    /* The site is taken when the command is first used, so the unused commands do not fill the table */
+    profile_scope_t scope = profile_begin_static(ppProfile, cmdName(id));
+    const bool result = pFunc(cmdParams, output, pDataParam);
+    profile_end(&scope);
+    return result;
+#else
+    return pFunc(cmdParams, output, pDataParam);
+#endif
+}
+
 void CommandProcessor::getRegisteredCommandList(CharDev& output)
 {
     char buffer[64];
     output.put(SUPPORTED_COMMANDS_STR);
     char *ptr = NULL;
 
-    for(unsigned int i=0; i<mCmdHandlerVector.size(); i++)
+    for(unsigned int i=0; i<getCommandCount(); i++)
     {
-        CmdProcessorType& c = mCmdHandlerVector[i];
-        if (strlen(c.pCmdHelpText) > 32) {
-            sprintf(buffer, "\n %10s : %.32s ...", c.pCommandStr, c.pCmdHelpText);
+        const char* pName = cmdName(i);
+        const char* pHelp = cmdHelp(i);
+        if (strlen(pHelp) > 32) {
+            sprintf(buffer, "\n %10s : %.32s ...", pName, pHelp);
 
             /* If a command's help has a newline, truncate it there .. */
             if ((ptr = strrchr(buffer, '\n')) > buffer) {
@@ -140,7 +300,7 @@ void CommandProcessor::getRegisteredCommandList(CharDev& output)
             }
             output.printf(buffer);
         } else {
-            output.printf("\n %10s : %s", c.pCommandStr, c.pCmdHelpText);
+            output.printf("\n %10s : %s", pName, pHelp);
         }
     }
 
@@ -153,18 +313,16 @@ void CommandProcessor::getHelpText(str& helpForCmd, CharDev& output)
     // where this parameter itself is a command name
     if(helpForCmd.getLen() > 0)
     {
-        for(unsigned int i=0; i < mCmdHandlerVector.size(); i++)
+        const int idx = findCmd(helpForCmd(), helpForCmd.getLen(), false);
+        if (idx >= 0)
         {
-            CmdProcessorType &cp = mCmdHandlerVector[i];
-            if(helpForCmd.compareToIgnoreCase(cp.pCommandStr))
-            {
-                const char* out = (0 == cp.pCmdHelpText || '\0' == cp.pCmdHelpText[0]) ?
-                                    NO_HELP_STR : cp.pCmdHelpText;
-                output.putline(out);
-                return;
-            }
+            const char* pHelp = cmdHelp(idx);
+            const char* out = ('\0' == pHelp[0]) ? NO_HELP_STR : pHelp;
+            output.putline(out);
+        }
+        else {
+            output.putline(CMD_INVALID_STR);
         }
-        output.putline(CMD_INVALID_STR);
     }
     else {
         getRegisteredCommandList(output);
@@ -0,0 +1,204 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include "coroutine.hpp"
+#include "lpc_sys.h"
+
+
+
+/// @returns the uptime in ms, which is compared using the difference so it may wrap-around
+static inline uint32_t coroutine_now_ms(void)
+{
+    return (uint32_t) sys_get_uptime_ms();
+}
+
+
+
+coroutine::coroutine(const char *pName) :
+    mCoLine(0), mCoTimedOut(false),
+    mpName(pName), mCoState(co_ready), mHasDeadline(false),
+    mWakeMs(0), mResumes(0), mpNext(NULL)
+{
+}
+
+void coroutine::restart(void)
+{
+    mCoLine = 0;
+    mCoTimedOut = false;
+    mHasDeadline = false;
+    mCoState = co_ready;
+}
+
+void coroutine::coReady(void)
+{
+    mCoState = co_ready;
+}
+
+void coroutine::coDelay(uint32_t ms)
+{
+    mWakeMs = coroutine_now_ms() + ms;
+    mCoState = co_delayed;
+}
+
+void coroutine::coDeadline(uint32_t ms)
+{
+    mHasDeadline = (portMAX_DELAY != ms);
+    mWakeMs = coroutine_now_ms() + ms;
+}
+
+void coroutine::coWait(void)
+{
+    mCoState = co_waiting;
+}
+
+void coroutine::coFinish(void)
+{
+    mCoState = co_done;
+}
+
+bool coroutine::coExpired(void) const
+{
+    return mHasDeadline && (int32_t) (coroutine_now_ms() - mWakeMs) >= 0;
+}
+
+
+
+void coroutine_signal::give(void)
+{
+    taskENTER_CRITICAL();
+    if (mCount < 0xFFFF) {
+        ++mCount;
+    }
+    taskEXIT_CRITICAL();
+
+    if (NULL != mrHost.mWake) {
+        xSemaphoreGive(mrHost.mWake);
+    }
+}
+
+void coroutine_signal::giveFromISR(BaseType_t *pHigherPriorityTaskWoken)
+{
+    const UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    if (mCount < 0xFFFF) {
+        ++mCount;
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+
+    if (NULL != mrHost.mWake) {
+        xSemaphoreGiveFromISR(mrHost.mWake, pHigherPriorityTaskWoken);
+    }
+}
+
+bool coroutine_signal::take(void)
+{
+    bool taken = false;
+
+    taskENTER_CRITICAL();
+    if (mCount > 0) {
+        --mCount;
+        taken = true;
+    }
+    taskEXIT_CRITICAL();
+
+    return taken;
+}
+
+
+
+coroutine_task::coroutine_task(const char *pName, uint32_t stackSize, uint8_t priority) :
+    scheduler_task(pName, stackSize, priority),
+    mpList(NULL), mWake(NULL)
+{
+}
+
+void coroutine_task::add(coroutine *pCoroutine)
+{
+    /* Append to keep the coroutines resumed in the order they were added */
+    coroutine **ppLast = &mpList;
+    while (NULL != *ppLast) {
+        ppLast = &(*ppLast)->mpNext;
+    }
+    pCoroutine->mpNext = NULL;
+    *ppLast = pCoroutine;
+}
+
+coroutine* coroutine_task::getCoroutine(uint32_t index) const
+{
+    coroutine *pCo = mpList;
+    while (NULL != pCo && index-- > 0) {
+        pCo = pCo->mpNext;
+    }
+    return pCo;
+}
+
+bool coroutine_task::init(void)
+{
+    return (NULL != (mWake = xSemaphoreCreateBinary()));
+}
+
+bool coroutine_task::run(void *p)
+{
+    uint32_t now = coroutine_now_ms();
+
+    for (coroutine *pCo = mpList; NULL != pCo; pCo = pCo->mpNext)
+    {
+        if (coroutine::co_done == pCo->mCoState ||
+            (coroutine::co_delayed == pCo->mCoState && (int32_t) (now - pCo->mWakeMs) < 0)) {
+            continue;
+        }
+        ++pCo->mResumes;
+        pCo->run();
+    }
+
+    /* Block until the nearest delay or deadline, or the next poll of the waiting coroutines */
+    uint32_t blockMs = portMAX_DELAY;
+    now = coroutine_now_ms();
+
+    for (coroutine *pCo = mpList; NULL != pCo && 0 != blockMs; pCo = pCo->mpNext)
+    {
+        uint32_t waitMs = portMAX_DELAY;
+        const int32_t leftMs = (int32_t) (pCo->mWakeMs - now);
+
+        switch (pCo->mCoState)
+        {
+            case coroutine::co_ready:
+                waitMs = 0;
+                break;
+            case coroutine::co_waiting:
+                waitMs = COROUTINE_POLL_MS;
+                if (pCo->mHasDeadline && leftMs < COROUTINE_POLL_MS) {
+                    waitMs = (leftMs > 0) ? leftMs : 0;
+                }
+                break;
+            case coroutine::co_delayed:
+                waitMs = (leftMs > 0) ? leftMs : 0;
+                break;
+            default:
+                break;
+        }
+
+        if (waitMs < blockMs) {
+            blockMs = waitMs;
+        }
+    }
+
+    if (0 != blockMs) {
+        xSemaphoreTake(mWake, (portMAX_DELAY == blockMs) ? portMAX_DELAY : OS_MS(blockMs));
+    }
+    return true;
+}
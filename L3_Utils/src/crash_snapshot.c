@@ -0,0 +1,151 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <string.h>
+
+#include "crash_snapshot.h"
+#include "crc.h"
+#include "LPC17xx.h"        // SCB
+#include "FreeRTOS.h"
+#include "task.h"           // pcTaskGetTaskName()
+#include "lpc_sys.h"        // sys_get_uptime_ms()
+#include "spi_sem.h"        // spi1_is_locked()
+#include "fat/disk/spi_flash.h"
+
+
+
+/// Marks the RAM snapshot that is not written to the flash memory yet
+#define CRASH_SNAPSHOT_PENDING      0x444E4550  // "PEND"
+
+/// Skips the magic, the size and the crc, for the crc of the rest of the snapshot
+#define CRASH_SNAPSHOT_CRC_OFFSET   (sizeof(uint32_t) + 2 * sizeof(uint16_t))
+
+/// The RAM snapshot, which is not cleared by the startup code, so the next boot finds it
+static struct {
+    crash_snapshot_t snap;
+    uint32_t pending;       ///< CRASH_SNAPSHOT_PENDING if the snapshot is not in the flash memory
+} g_crash __attribute__ ((section (".noinit")));
+
+
+
+static uint16_t crash_snapshot_crc(const crash_snapshot_t *pSnap)
+{
+    return crc16_update(0, ((const uint8_t*) pSnap) + CRASH_SNAPSHOT_CRC_OFFSET,
+                        sizeof(*pSnap) - CRASH_SNAPSHOT_CRC_OFFSET);
+}
+
+static bool crash_snapshot_valid(const crash_snapshot_t *pSnap)
+{
+    return (CRASH_SNAPSHOT_MAGIC == pSnap->magic && sizeof(*pSnap) == pSnap->bytes &&
+            crash_snapshot_crc(pSnap) == pSnap->crc);
+}
+
+/**
+ * @returns the words of the stack that can be read from the stack pointer, so the snapshot of
+ *          a stack overflow does not fault again by reading beyond the end of the RAM.
+ */
+static uint16_t crash_snapshot_stack_words(const uint32_t sp)
+{
+    static const uint32_t ram[][2] = {
+        { 0x10000000, 0x10008000 },     /* The 32K of the local SRAM */
+        { 0x2007C000, 0x20084000 },     /* The two 16K banks of the AHB SRAM */
+    };
+    uint32_t i = 0;
+
+    for (i = 0; i < sizeof(ram) / sizeof(ram[0]); i++) {
+        if (sp >= ram[i][0] && sp < ram[i][1] && 0 == (sp & 3)) {
+            const uint32_t words = (ram[i][1] - sp) / sizeof(uint32_t);
+            return (words < CRASH_SNAPSHOT_STACK_WORDS) ? words : CRASH_SNAPSHOT_STACK_WORDS;
+        }
+    }
+    return 0;
+}
+
+void crash_snapshot_save(const uint32_t *pStackFrame)
+{
+    crash_snapshot_t *pSnap = &g_crash.snap;
+    uint32_t i = 0;
+
+    memset(pSnap, 0, sizeof(*pSnap));
+    pSnap->magic = CRASH_SNAPSHOT_MAGIC;
+    pSnap->bytes = sizeof(*pSnap);
+    pSnap->uptime_ms = sys_get_uptime_ms();
+
+    for (i = 0; i < crash_frame_words; i++) {
+        pSnap->frame[i] = pStackFrame[i];
+    }
+    pSnap->sp = (uint32_t) (pStackFrame + crash_frame_words);
+    pSnap->cfsr = SCB->CFSR;
+    pSnap->hfsr = SCB->HFSR;
+    pSnap->mmfar = SCB->MMFAR;
+    pSnap->bfar = SCB->BFAR;
+
+    if (taskSCHEDULER_NOT_STARTED != xTaskGetSchedulerState()) {
+        strncpy(pSnap->task, pcTaskGetTaskName(NULL), sizeof(pSnap->task));
+    }
+
+    pSnap->stack_words = crash_snapshot_stack_words(pSnap->sp);
+    for (i = 0; i < pSnap->stack_words; i++) {
+        pSnap->stack[i] = ((const uint32_t*) pSnap->sp)[i];
+    }
+
+    #if (SYS_CFG_TRACE_RECORDS > 0)
+    /* The records that led to the fault are not overwritten by the handler */
+    os_trace_stop();
+    const uint32_t count = os_trace_get_count();
+    pSnap->trace_records = (count < CRASH_SNAPSHOT_TRACE_RECORDS) ? count : CRASH_SNAPSHOT_TRACE_RECORDS;
+    for (i = 0; i < pSnap->trace_records; i++) {
+        pSnap->trace[i] = *os_trace_get_record(count - pSnap->trace_records + i);
+    }
+    #endif
+
+    pSnap->crc = crash_snapshot_crc(pSnap);
+    g_crash.pending = CRASH_SNAPSHOT_PENDING;
+
+    /* A transfer of the SPI flash or the SD card that was interrupted cannot be resumed by us,
+     * so the snapshot is then written by crash_snapshot_persist() of the next boot.
+     */
+    if (!spi1_is_locked() && flash_crash_write(pSnap, sizeof(*pSnap))) {
+        g_crash.pending = 0;
+    }
+}
+
+void crash_snapshot_persist(void)
+{
+    if (CRASH_SNAPSHOT_PENDING == g_crash.pending && crash_snapshot_valid(&g_crash.snap)) {
+        spi1_lock();
+        if (flash_crash_write(&g_crash.snap, sizeof(g_crash.snap))) {
+            g_crash.pending = 0;
+        }
+        spi1_unlock();
+    }
+}
+
+bool crash_snapshot_get(crash_snapshot_t *pSnapshot)
+{
+    if (crash_snapshot_valid(&g_crash.snap)) {
+        *pSnapshot = g_crash.snap;
+        return true;
+    }
+
+    spi1_lock();
+    const bool read = flash_crash_read(pSnapshot, sizeof(*pSnapshot));
+    spi1_unlock();
+
+    return (read && crash_snapshot_valid(pSnapshot));
+}
@@ -0,0 +1,120 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <string.h>
+
+#include "event_bus.h"
+#include "task.h"
+#include "LPC17xx.h"    // SCB->ICSR
+
+
+
+/// Compiler memory barrier that orders the sample against its sequence count (@see SPSC_RING_BARRIER())
+#define EVENT_BUS_BARRIER()     __asm volatile ("" ::: "memory")
+
+
+
+bool event_bus_subscribe(event_topic_t *topic, EventGroupHandle_t group, EventBits_t bits)
+{
+    bool subscribed = false;
+
+    taskENTER_CRITICAL();
+    if (topic->num_subs < EVENT_BUS_MAX_SUBS) {
+        topic->subs[topic->num_subs].group = group;
+        topic->subs[topic->num_subs].bits = bits;
+        ++topic->num_subs;
+        subscribed = true;
+    }
+    taskEXIT_CRITICAL();
+
+    return subscribed;
+}
+
+void event_bus_publish(event_topic_t *topic, const void *sample)
+{
+    const bool isr = (0 != (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk));
+    const bool running = (taskSCHEDULER_RUNNING == xTaskGetSchedulerState());
+    UBaseType_t mask = 0;
+    BaseType_t woken = pdFALSE;
+    uint8_t i = 0;
+
+    /* Publishers are serialized, and the readers see the odd count of the write */
+    if (isr) {
+        mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    }
+    else {
+        taskENTER_CRITICAL();
+    }
+
+    ++topic->seq;
+    EVENT_BUS_BARRIER();
+    memcpy(topic->sample, sample, topic->size);
+    EVENT_BUS_BARRIER();
+    ++topic->seq;
+
+    if (isr) {
+        portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+    }
+    else {
+        taskEXIT_CRITICAL();
+    }
+
+    /* The bits of an ISR are set by the timer task (INCLUDE_xTimerPendFunctionCall) */
+    if (!running) {
+        return;
+    }
+    for (i = 0; i < topic->num_subs; i++) {
+        const event_sub_t *sub = &topic->subs[i];
+        if (isr) {
+            xEventGroupSetBitsFromISR(sub->group, sub->bits, &woken);
+        }
+        else {
+            xEventGroupSetBits(sub->group, sub->bits);
+        }
+    }
+    if (isr) {
+        portEND_SWITCHING_ISR(woken);
+    }
+}
+
+const void* event_bus_read_begin(const event_topic_t *topic, uint32_t *seq)
+{
+    /* The count is only odd while a publish writes with the interrupts masked, so this does not spin on one core */
+    while ((*seq = topic->seq) & 1) {
+        ;
+    }
+    EVENT_BUS_BARRIER();
+    return topic->sample;
+}
+
+bool event_bus_read_end(const event_topic_t *topic, uint32_t seq)
+{
+    EVENT_BUS_BARRIER();
+    return (seq == topic->seq);
+}
+
+uint32_t event_bus_read(const event_topic_t *topic, void *sample)
+{
+    uint32_t seq = 0;
+
+    do {
+        memcpy(sample, event_bus_read_begin(topic, &seq), topic->size);
+    } while (!event_bus_read_end(topic, seq));
+
+    return seq / 2;
+}
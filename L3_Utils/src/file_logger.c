@@ -24,27 +24,159 @@
 #include <stdbool.h>
 
 #include "FreeRTOS.h"
-#include "queue.h"
+#include "semphr.h"
 #include "task.h"
 
+#include "LPC17xx.h"    // __LDREXW() and __STREXW()
 #include "file_logger.h"
 #include "lpc_sys.h"
 #include "rtc.h"
 #include "ff.h"
+#include "stream_file.h"
+#include "lz_frame.h"
+#include "printf_lib.h" // fmt_snprintf()
+#include "profile.h"
+#include "spi_sem.h"    // spi1_is_locked()
 
 
 
-#if (FILE_LOGGER_KEEP_FILE_OPEN)
-static FIL *gp_file_ptr = NULL;                     ///< The pointer to the file object
+/**
+ * One of the two file buffers of a logger stream.
+ * Log calls reserve the maximum size of their message in the active buffer, print the message
+ * directly into the reserved space, and then commit the actual length.  If the reservation is
+ * still at the end of the buffer, the unused bytes are given back, otherwise (another task
+ * reserved space after us) the unused bytes are marked as a gap that is removed before the
+ * buffer is written to the file.
+ *
+ * Once a buffer cannot fit another message, it is sealed and the logger task writes it to the
+ * file after all of its reservations are committed while the other buffer takes new messages.
+ */
+typedef struct {
+    char *data;             ///< The buffer space of logger_stream_t::buffer_size bytes
+    uint16_t used;          ///< Bytes reserved or committed
+    uint16_t msgs;          ///< Number of messages in the buffer
+    uint8_t pending;        ///< Number of reservations that are not yet committed
+    uint8_t gaps;           ///< Number of committed messages that left a gap behind them
+    bool sealed;            ///< Buffer is full, or being flushed, and will be written to the file
+#if (FILE_LOGGER_NOINIT_BYTES)
+    uint32_t noinit_start;  ///< The crash log offset of the first committed message, @see logger_noinit_copy()
+#endif
+} logger_buffer_t;
+
+/**
+ * A logger stream is the double buffer of one output file.
+ * The text messages are logged to FILE_LOGGER_FILENAME, and the binary messages are
+ * logged to FILE_LOGGER_BIN_FILENAME
+ */
+typedef struct {
+    logger_buffer_t buffers[2];     ///< The double buffer space before it is written to file
+    uint16_t buffer_size;           ///< Size of each buffer
+    uint8_t active;                 ///< Index of buffers[] that takes new messages
+    uint8_t write;                  ///< Index of buffers[] to be written next by the logger task
+    const char *filename;           ///< The output filename
+    SemaphoreHandle_t space_signal; ///< Signals the log calls that a buffer has been written
+#if (FILE_LOGGER_PREALLOC_BYTES)
+    stream_file_t *stream_file;     ///< The pre-allocated file, or NULL if it could not be opened
+#endif
+    FIL *file_ptr;                  ///< The pointer to the file object, or NULL if stream_file is used
+#if (!FILE_LOGGER_KEEP_FILE_OPEN)
+    bool file_open;                 ///< The file is opened by the first write, and closed by the sync
+#endif
+    uint16_t unsynced;              ///< Number of buffers written since the file was synced
+    uint32_t sync_at_ms;            ///< The uptime by which the written buffers are synced
+#if (FILE_LOGGER_NOINIT_BYTES)
+    uint32_t noinit_written;        ///< The crash log offset up to which the messages are written to the file
+#endif
+} logger_stream_t;
+
+/// The text log is rotated over the ring of files, @see FILE_LOGGER_ROTATE_FILES
+#define FILE_LOGGER_ROTATE          (FILE_LOGGER_PREALLOC_BYTES && FILE_LOGGER_ROTATE_FILES)
+#if (FILE_LOGGER_ROTATE && FILE_LOGGER_ROTATE_FILES < 3)
+#error "FILE_LOGGER_ROTATE_FILES must be at least 3"
+#endif
+
+#if (FILE_LOGGER_NOINIT_BYTES)
+#if (FILE_LOGGER_NOINIT_BYTES & (FILE_LOGGER_NOINIT_BYTES - 1))
+#error "FILE_LOGGER_NOINIT_BYTES must be a power of two"
 #endif
+#define FILE_LOGGER_NOINIT_MAGIC    0x4C4F4752      ///< "LOGR" marks the crash log initialized by the logger
+
+/**
+ * The crash log ring in the no-init RAM, @see FILE_LOGGER_NOINIT_BYTES
+ * The offsets count the bytes copied to the ring since it was initialized (and wrap around at 32-bits),
+ * and the ring holds the last FILE_LOGGER_NOINIT_BYTES bytes before the head.
+ */
+typedef struct {
+    uint32_t magic;         ///< FILE_LOGGER_NOINIT_MAGIC once the ring is initialized
+    uint32_t head;          ///< The offset of the next message
+    uint32_t synced;        ///< The offset up to which the messages are synced to the file
+    uint32_t check;         ///< The complement of (head ^ synced), which is updated along with them
+    char data[FILE_LOGGER_NOINIT_BYTES];
+} logger_noinit_t;
+#endif
+
+/// Streams of g_streams[]
+typedef enum {
+    logger_stream_text,
+#if (FILE_LOGGER_BIN_ENABLE)
+    logger_stream_bin,
+#endif
+    logger_stream_count,
+} logger_stream_id_t;
+
+/**
+ * Token bucket used to rate limit the logging calls.
+ * Tokens are scaled by 1000 such that the bucket can be refilled every millisecond.
+ */
+typedef struct {
+    uint32_t tokens;        ///< Number of tokens x 1000
+    uint32_t last_ms;       ///< Uptime when the bucket was refilled last
+} logger_bucket_t;
+
+/// Call site of a logging call that is rate limited
+typedef struct {
+    const char *filename;   ///< The __FILE__ of the call site, NULL if the entry is not used
+    uint16_t line;          ///< The __LINE__ of the call site
+    uint16_t suppressed;    ///< Number of messages suppressed since the last message that was logged
+    logger_bucket_t bucket; ///< The bucket of this call site
+} logger_site_t;
 
 static uint16_t g_blocked_calls = 0;                ///< Number of logging calls that blocked
-static uint16_t g_buffer_watermark = 0;             ///< The watermark of the number of buffers consumed
+static uint16_t g_dropped_calls = 0;                ///< Number of logging calls dropped because buffers were full
+static uint16_t g_buffer_watermark = 0;             ///< The watermark of the number of messages waiting to be written
 static uint16_t g_highest_file_write_time = 0;      ///< Highest time spend while trying to write file buffer
-static char * gp_file_buffer = NULL;                ///< Pointer to local buffer space before it is written to file
-static QueueHandle_t g_write_buffer_queue = NULL;   ///< Log message pointers are written to this queue
-static QueueHandle_t g_empty_buffer_queue = NULL;   ///< Log message pointers are available from this queue
+static logger_stream_t g_streams[logger_stream_count];  ///< The logger streams
+static volatile bool g_flush_requested = false;     ///< Flush request to the logger task
+static volatile bool g_writing = false;             ///< The logger is writing a file
+static bool g_emergency = false;                    ///< Set by logger_emergency_flush(), which does not print errors
+
+#if (FILE_LOGGER_NOINIT_BYTES)
+static logger_noinit_t g_noinit __attribute__ ((section (".noinit")));  ///< The crash log, which survives the reset
+static uint32_t g_noinit_recovered = 0;             ///< Bytes of the crash log written to the file at startup
+#endif
+#if (FILE_LOGGER_COMPRESS)
+static uint8_t g_lz_frame[LZ_FRAME_MAX_BYTES(FILE_LOGGER_BUFFER_SIZE)];  ///< The frame of the text being written
+static lz_work_t g_lz_work;                         ///< The table of the encoder of the text log
+#endif
+#if (FILE_LOGGER_ROTATE)
+static uint8_t g_rotate_index = 0;                  ///< The index of the file of the ring being written
+static char g_rotate_filename[24];                  ///< The filename of the text log stream, @see logger_rotate_filename()
+#endif
+static char g_time_str[16];                         ///< The "m/d,hh:mm:ss," of the messages of the g_time_key second
+static uint8_t g_time_len = 0;                      ///< The length of g_time_str, or 0 if none
+static uint32_t g_time_key = 0;                     ///< The month, day and time of g_time_str, @see logger_print_time()
+static SemaphoreHandle_t g_write_signal = NULL;     ///< Signals the logger task that a buffer may be ready to write
 static uint32_t g_logger_calls[log_last] = { 0 };   ///< Number of logged messages of each severity
+static uint32_t g_logger_suppressed[log_last] = { 0 };  ///< Number of suppressed messages of each severity
+
+#if (FILE_LOGGER_RATE_LIMIT)
+static logger_bucket_t g_severity_buckets[log_last];    ///< Token bucket of each severity
+static uint16_t g_severity_rate[log_last] = { FILE_LOGGER_RATE_DEBUG, FILE_LOGGER_RATE_INFO,
+                                              FILE_LOGGER_RATE_WARN,  FILE_LOGGER_RATE_ERROR };
+static uint16_t g_severity_burst[log_last] = { FILE_LOGGER_SEVERITY_BURST, FILE_LOGGER_SEVERITY_BURST,
+                                               FILE_LOGGER_SEVERITY_BURST, FILE_LOGGER_SEVERITY_BURST };
+static logger_site_t g_sites[FILE_LOGGER_RATE_SITES];   ///< Call sites being rate limited
+#endif
 
 /**
  * Chooses severity levels that are printed on stdio and logged
@@ -52,46 +184,371 @@ static uint32_t g_logger_calls[log_last] = { 0 };   ///< Number of logged messag
  */
 static uint8_t g_logger_printf_mask = (1 << log_debug);
 
+/// Minimum severity that is logged, @see logger_set_min_level()
+static logger_msg_t g_logger_min_level = log_debug;
+
+/**
+ * Maximum chars of a message excluding the NULL terminator.  This leaves one byte for the newline, and
+ * makes sure that the gap left behind a message is at least two bytes (@see logger_commit())
+ */
+#define FILE_LOGGER_MSG_MAX_CHARS   (FILE_LOGGER_LOG_MSG_MAX_LEN - 3)
+
+
+/**
+ * @{ Increments a counter without a critical section using the exclusive access instructions
+ * so the logging calls from the tasks of any priority can update the counters.
+ */
+static inline void logger_atomic_inc(uint32_t *counter)
+{
+    uint32_t value;
+    do {
+        value = __LDREXW(counter) + 1;
+    } while (__STREXW(value, counter));
+}
+static inline void logger_atomic_inc16(uint16_t *counter)
+{
+    uint16_t value;
+    do {
+        value = __LDREXH(counter) + 1;
+    } while (__STREXH(value, counter));
+}
+/** @} */
+
+#if (FILE_LOGGER_RATE_LIMIT)
+/// Fills the bucket up to its burst size
+static inline void logger_bucket_fill(logger_bucket_t *b, const uint16_t burst, const uint32_t now_ms)
+{
+    b->tokens = (uint32_t) burst * 1000;
+    b->last_ms = now_ms;
+}
+
+/**
+ * Refills the bucket based on the elapsed time, and takes a token from it.
+ * @returns true if a token was available
+ */
+static bool logger_bucket_take(logger_bucket_t *b, const uint16_t rate, const uint16_t burst, const uint32_t now_ms)
+{
+    if (0 == rate) {
+        return true;
+    }
+
+    const uint32_t max_tokens = (uint32_t) burst * 1000;
+    uint32_t elapsed_ms = now_ms - b->last_ms;
+    b->last_ms = now_ms;
+
+    /* Prevent the overflow after a long time of not logging anything */
+    if (elapsed_ms > (max_tokens / rate)) {
+        elapsed_ms = (max_tokens / rate) + 1;
+    }
+    b->tokens += elapsed_ms * rate;
+    if (b->tokens > max_tokens) {
+        b->tokens = max_tokens;
+    }
+
+    if (b->tokens >= 1000) {
+        b->tokens -= 1000;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Checks the severity and the call site rate limits of a logging call.
+ * @param [out] suppressed  The number of messages of this call site suppressed before this one
+ * @returns true if the message should be logged
+ */
+static bool logger_rate_check(logger_msg_t type, const char *filename, unsigned line_num, uint16_t *suppressed)
+{
+    const uint32_t now_ms = sys_get_uptime_ms();
+    const uint32_t hash = ((uintptr_t) filename >> 2) ^ (line_num * 31);
+    logger_site_t *site = &g_sites[hash % FILE_LOGGER_RATE_SITES];
+    bool pass = false;
+
+    taskENTER_CRITICAL();
+    {
+        /* Another call site takes over the entry, which is fine since it is likely the one logging a lot */
+        if (site->filename != filename || site->line != line_num) {
+            site->filename = filename;
+            site->line = line_num;
+            site->suppressed = 0;
+            logger_bucket_fill(&site->bucket, FILE_LOGGER_SITE_BURST, now_ms);
+        }
+
+        pass = logger_bucket_take(&site->bucket, FILE_LOGGER_SITE_RATE, FILE_LOGGER_SITE_BURST, now_ms) &&
+               logger_bucket_take(&g_severity_buckets[type], g_severity_rate[type], g_severity_burst[type], now_ms);
+
+        if (pass) {
+            *suppressed = site->suppressed;
+            site->suppressed = 0;
+        }
+        else if (site->suppressed < UINT16_MAX) {
+            ++site->suppressed;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if (!pass) {
+        logger_atomic_inc(&g_logger_suppressed[type]);
+    }
+    return pass;
+}
+#endif
+
+#if (FILE_LOGGER_ROTATE)
+/// Prints the filename of the file of the ring to g_rotate_filename
+static const char * logger_rotate_filename(const uint8_t index)
+{
+    fmt_snprintf(g_rotate_filename, sizeof(g_rotate_filename), FILE_LOGGER_ROTATE_FILENAME, (unsigned) index);
+    return g_rotate_filename;
+}
+
+/// @returns true if the file of the ring with the given size cannot fit another buffer
+static inline bool logger_rotate_full(const logger_stream_t *stream, const uint32_t size)
+{
+    #if (FILE_LOGGER_COMPRESS)
+    return (size + LZ_FRAME_MAX_BYTES(stream->buffer_size) > FILE_LOGGER_ROTATE_BYTES);
+    #else
+    return (size + stream->buffer_size > FILE_LOGGER_ROTATE_BYTES);
+    #endif
+}
+
+/**
+ * Creates the files of the ring, and opens the file after the last full file, which is the file
+ * that was being written before the reboot because the file after the one being written is always empty.
+ */
+static FRESULT logger_rotate_open(logger_stream_t *stream)
+{
+    stream_file_t *sf = stream->stream_file;
+    bool full[FILE_LOGGER_ROTATE_FILES];
+    FRESULT err = FR_OK;
+    uint8_t i = 0;
+
+    /* Opening a file finds the size of its data, even if it was not closed before the reboot */
+    for (i = 0; i < FILE_LOGGER_ROTATE_FILES; i++) {
+        if (FR_OK != (err = stream_file_open(sf, logger_rotate_filename(i), FILE_LOGGER_PREALLOC_BYTES))) {
+            return err;
+        }
+        full[i] = logger_rotate_full(stream, stream_file_size(sf));
+        stream_file_close(sf);
+    }
+
+    g_rotate_index = 0;
+    for (i = 0; i < FILE_LOGGER_ROTATE_FILES; i++) {
+        if (full[i] && !full[(i + 1) % FILE_LOGGER_ROTATE_FILES]) {
+            g_rotate_index = (i + 1) % FILE_LOGGER_ROTATE_FILES;
+            break;
+        }
+    }
+
+    return stream_file_open(sf, logger_rotate_filename(g_rotate_index), FILE_LOGGER_PREALLOC_BYTES);
+}
+
+/**
+ * Closes the full file of the ring, empties the oldest file, and continues with the next file, which
+ * was emptied by the previous rotation.  A reboot at any point finds the file being written by
+ * logger_rotate_open() because the file after the last full file is never full.
+ */
+static FRESULT logger_rotate(logger_stream_t *stream)
+{
+    stream_file_t *sf = stream->stream_file;
+    const uint8_t next = (g_rotate_index + 1) % FILE_LOGGER_ROTATE_FILES;
+    const uint8_t oldest = (g_rotate_index + 2) % FILE_LOGGER_ROTATE_FILES;
+    FRESULT err = FR_OK;
+
+    stream_file_close(sf);
+    if (FR_OK == (err = stream_file_open(sf, logger_rotate_filename(oldest), FILE_LOGGER_PREALLOC_BYTES))) {
+        err = stream_file_truncate(sf);
+        stream_file_close(sf);
+    }
+
+    g_rotate_index = next;
+    const FRESULT open_err = stream_file_open(sf, logger_rotate_filename(next), FILE_LOGGER_PREALLOC_BYTES);
+    return (FR_OK == open_err) ? err : open_err;
+}
+#endif
+
+#if (FILE_LOGGER_NOINIT_BYTES)
+/// Sets the offsets of the crash log along with its check
+static inline void logger_noinit_set(const uint32_t head, const uint32_t synced)
+{
+    g_noinit.head = head;
+    g_noinit.synced = synced;
+    g_noinit.check = ~(head ^ synced);
+}
+
+/// @returns true if the crash log was written by the logger before the reset
+static inline bool logger_noinit_valid(void)
+{
+    return (FILE_LOGGER_NOINIT_MAGIC == g_noinit.magic) &&
+           (~(g_noinit.head ^ g_noinit.synced) == g_noinit.check) &&
+           ((int32_t) (g_noinit.head - g_noinit.synced) >= 0);
+}
+
+/**
+ * Copies a committed text message to the crash log.  This must be called within the critical section
+ * of logger_commit() before the message is counted as committed.
+ * @param [in] b    The buffer of the message
+ */
+static void logger_noinit_copy(logger_buffer_t *b, const char *msg, const uint32_t len)
+{
+    const uint32_t pos = g_noinit.head & (FILE_LOGGER_NOINIT_BYTES - 1);
+    const uint32_t first = (len < FILE_LOGGER_NOINIT_BYTES - pos) ? len : (FILE_LOGGER_NOINIT_BYTES - pos);
+
+    /* The first message committed to the buffer */
+    if (b->msgs == b->pending) {
+        b->noinit_start = g_noinit.head;
+    }
+
+    memcpy(&g_noinit.data[pos], msg, first);
+    memcpy(&g_noinit.data[0], msg + first, len - first);
+    logger_noinit_set(g_noinit.head + len, g_noinit.synced);
+}
+
 /**
- * Writes the buffer to the file.
+ * Finds the crash log offset up to which the messages are written to the file, which is the offset of the
+ * first committed message of a buffer that is not written yet.  Messages are committed in any order to the
+ * two buffers, so a few messages after this offset may have already been written.  This must be called
+ * within a critical section after a written buffer is emptied.
+ */
+static void logger_noinit_written(logger_stream_t *stream)
+{
+    uint32_t written = g_noinit.head;
+
+    if (&g_streams[logger_stream_text] != stream) {
+        return;
+    }
+    for (int n = 0; n < 2; n++) {
+        const logger_buffer_t *b = &stream->buffers[n];
+        if (b->msgs != b->pending && (int32_t) (b->noinit_start - written) < 0) {
+            written = b->noinit_start;
+        }
+    }
+    stream->noinit_written = written;
+}
+
+#endif
+
+/**
+ * Prints the time of the message header, of which the string is formatted once each second.
+ * @param [out] buffer  The buffer to print to, which fits FILE_LOGGER_MSG_MAX_CHARS
+ * @param [in]  time    The time of the message
+ * @returns the length of the time string
+ */
+static uint32_t logger_print_time(char *buffer, const rtc_t *time)
+{
+    const uint32_t key = (time->month << 22) | (time->day << 17) | (time->hour << 12) | (time->min << 6) | time->sec;
+    uint32_t len = 0;
+
+    taskENTER_CRITICAL();
+    if (key == g_time_key && g_time_len > 0) {
+        len = g_time_len;
+        memcpy(buffer, g_time_str, len);
+    }
+    taskEXIT_CRITICAL();
+
+    if (0 == len) {
+        len = fmt_snprintf(buffer, sizeof(g_time_str), "%d/%d,%02d:%02d:%02d,",
+                           (int) time->month, (int) time->day, (int) time->hour, (int) time->min, (int) time->sec);
+        if (len >= sizeof(g_time_str)) {
+            len = sizeof(g_time_str) - 1;
+        }
+
+        taskENTER_CRITICAL();
+        memcpy(g_time_str, buffer, len);
+        g_time_len = len;
+        g_time_key = key;
+        taskEXIT_CRITICAL();
+    }
+
+    return len;
+}
+
+/**
+ * Writes the buffer to the file, which is synced later by logger_sync_file().
+ * With FILE_LOGGER_COMPRESS, the text is written as the LZ frames of up to a buffer each.
+ * @param [in] stream   The logger stream of the file to write
  * @param [in] buffer   The data pointer to write from
  * @param [in] bytes_to_write  The number of bytes to write
  */
-static bool logger_write_to_file(const void * buffer, const uint32_t bytes_to_write)
+static bool logger_write_to_file(logger_stream_t *stream, const void * buffer, const uint32_t bytes_to_write)
 {
     bool success = false;
     FRESULT err = 0;
     UINT bytes_written = 0;
     const UINT bytes_to_write_uint = bytes_to_write;
     const uint32_t start_time = sys_get_uptime_ms();
-
-    #if (!FILE_LOGGER_KEEP_FILE_OPEN)
-    FIL fatfs_file = { 0 };
+    PROFILE_SCOPE("logger_write");
+
+    #if (FILE_LOGGER_COMPRESS)
+    if (&g_streams[logger_stream_text] == stream && g_lz_frame != buffer) {
+        const char *text = (const char*) buffer;
+        uint32_t done = 0;
+        while (done < bytes_to_write) {
+            const uint32_t len = (bytes_to_write - done < FILE_LOGGER_BUFFER_SIZE) ?
+                                 (bytes_to_write - done) : FILE_LOGGER_BUFFER_SIZE;
+            if (!logger_write_to_file(stream, g_lz_frame, lz_frame_pack(text + done, len, g_lz_frame, &g_lz_work))) {
+                return false;
+            }
+            done += len;
+        }
+        return true;
+    }
     #endif
 
+    g_writing = true;
     if (0 == bytes_to_write_uint) {
         success = true;
     }
+    /* The data is written to the pre-allocated clusters, so the FAT is only written when the file grows */
+    #if (FILE_LOGGER_PREALLOC_BYTES)
+    else if (NULL != stream->stream_file)
+    {
+        if (FR_OK == (err = stream_file_append(stream->stream_file, buffer, bytes_to_write))) {
+            bytes_written = bytes_to_write_uint;
+        }
+        #if (FILE_LOGGER_ROTATE)
+        /* The file is closed as soon as it is full, so it is synced and its data is final */
+        if (&g_streams[logger_stream_text] == stream &&
+            logger_rotate_full(stream, stream_file_size(stream->stream_file)) &&
+            FR_OK != (err = logger_rotate(stream)) && !g_emergency) {
+            printf("Error %u rotating logfile %s\n", (unsigned)err, stream->filename);
+        }
+        #endif
+    }
+    #endif
     /* File already open, so just write the data */
     #if (FILE_LOGGER_KEEP_FILE_OPEN)
-    else if (FR_OK == (err = f_write(gp_file_ptr, buffer, bytes_to_write_uint, &bytes_written)))
+    else if (FR_OK != (err = f_write(stream->file_ptr, buffer, bytes_to_write_uint, &bytes_written)) && !g_emergency)
     {
-        f_sync(gp_file_ptr);
+        printf("Failed file write: ");
     }
     #else
-    /* File not opened, open it, seek it, and then write it */
-    else if(FR_OK == (err = f_open(&fatfs_file, FILE_LOGGER_FILENAME, FA_OPEN_ALWAYS | FA_WRITE)))
+    /* File not opened since the last sync, open it, seek it, and then write it */
+    else if (!stream->file_open &&
+             FR_OK != (err = f_open(stream->file_ptr, stream->filename, FA_OPEN_ALWAYS | FA_WRITE)))
     {
-        if (FR_OK == (err = f_lseek(&fatfs_file, f_size(&fatfs_file))))
-        {
-            err = f_write(&fatfs_file, buffer, bytes_to_write_uint, &bytes_written);
+        if (!g_emergency) {
+            printf("Failed file write: ");
+        }
+    }
+    else
+    {
+        /* The file stays open until it is synced, so its FAT and directory entry are written once */
+        if (!stream->file_open) {
+            stream->file_open = true;
+            err = f_lseek(stream->file_ptr, f_size(stream->file_ptr));
+        }
+        if (FR_OK == err) {
+            err = f_write(stream->file_ptr, buffer, bytes_to_write_uint, &bytes_written);
         }
-        f_close(&fatfs_file);
     }
     #endif
-    else {
-        printf("Failed file write: ");
+
+    /* The sync is due by the time of the first buffer that is not synced */
+    if (bytes_written > 0 && 0 == stream->unsynced++) {
+        stream->sync_at_ms = sys_get_uptime_ms() + (1000 * FILE_LOGGER_SYNC_TIME_SEC);
     }
+    g_writing = false;
 
     /* Capture the time */
     const uint32_t diff_time = sys_get_uptime_ms() - start_time;
@@ -103,152 +560,367 @@ static bool logger_write_to_file(const void * buffer, const uint32_t bytes_to_wr
     success = (bytes_to_write_uint == bytes_written);
 
     /* We don't want to silently fail, so print a message in case an error occurs */
-    if (!success) {
+    if (!success && !g_emergency) {
         printf("Error %u writing logfile. %u/%u written. Fptr: %u\n",
-#if (FILE_LOGGER_KEEP_FILE_OPEN)
-                (unsigned)err, (unsigned)bytes_written, (unsigned)bytes_to_write, (unsigned) gp_file_ptr->fptr);
-#else
-                (unsigned)err, (unsigned)bytes_written, (unsigned)bytes_to_write, (unsigned) fatfs_file.fptr);
-#endif
+                (unsigned)err, (unsigned)bytes_written, (unsigned)bytes_to_write,
+                (unsigned) (stream->file_ptr ? stream->file_ptr->fptr : 0));
     }
 
     return success;
 }
 
 /**
- * @returns a logger buffer pointer
- * @param [in] os_running If FreeRTOS is running, this will grab from the queue while potentially blocking
- *             otherwise it will return a buffer pointer without blocking since buffer will always be
- *             available if OS is not running since no multi-threaded operation is going on.
+ * Syncs the buffers written to the file by logger_write_to_file()
+ * @param [in] stream   The logger stream of the file to sync
  */
-static char * logger_get_buffer_ptr(const bool os_running)
+static bool logger_sync_file(logger_stream_t *stream)
 {
-    char * buffer = NULL;
+    FRESULT err = FR_OK;
 
-    /* Get an available buffer to write the data to, and if OS is not running, we will always get a buffer */
-    if (!os_running) {
-        xQueueReceive(g_empty_buffer_queue, &buffer, 0);
+    if (0 == stream->unsynced) {
+        return true;
     }
-    else if (!xQueueReceive(g_empty_buffer_queue, &buffer, OS_MS(FILE_LOGGER_BLOCK_TIME_MS))) {
-        ++g_blocked_calls;
 
-        /* This time, just block forever until we get a buffer */
-        xQueueReceive(g_empty_buffer_queue, &buffer, portMAX_DELAY);
+    g_writing = true;
+    #if (FILE_LOGGER_PREALLOC_BYTES)
+    if (NULL != stream->stream_file) {
+        err = stream_file_sync(stream->stream_file);
+    }
+    else
+    #endif
+    #if (FILE_LOGGER_KEEP_FILE_OPEN)
+    {
+        err = f_sync(stream->file_ptr);
+    }
+    #else
+    if (stream->file_open) {
+        err = f_close(stream->file_ptr);
+        stream->file_open = false;
+    }
+    #endif
+    g_writing = false;
+
+    stream->unsynced = 0;
+    #if (FILE_LOGGER_NOINIT_BYTES)
+    /* The crash log no longer needs to recover the messages written before the sync */
+    if (FR_OK == err && &g_streams[logger_stream_text] == stream) {
+        taskENTER_CRITICAL();
+        logger_noinit_set(g_noinit.head, stream->noinit_written);
+        taskEXIT_CRITICAL();
     }
+    #endif
+    if (FR_OK != err && !g_emergency) {
+        printf("Error %u syncing logfile %s\n", (unsigned)err, stream->filename);
+    }
+    return (FR_OK == err);
+}
 
-    return buffer;
+/// @returns true if the written buffers of the stream should be synced by the FILE_LOGGER_SYNC_BUFFERS or the time
+static bool logger_sync_due(const logger_stream_t *stream, const uint32_t now_ms)
+{
+    return (stream->unsynced > 0) &&
+           ((FILE_LOGGER_SYNC_BUFFERS > 0 && stream->unsynced >= FILE_LOGGER_SYNC_BUFFERS) ||
+            (FILE_LOGGER_SYNC_TIME_SEC > 0 && (int32_t) (now_ms - stream->sync_at_ms) >= 0));
+}
+
+/// @returns true if the buffer is not sealed, and has not been written yet because it is empty
+static inline bool logger_buffer_free(const logger_buffer_t *b)
+{
+    return (!b->sealed && 0 == b->used);
 }
 
 /**
- * Writes the buffer pointer to either file buffer, or directly to file if OS is not running
- * @param [in] buffer The buffer pointer to write
- * @param [in] os_running If OS is running, it will just queue the pointer, and not write directly to the file.
+ * Seals the active buffer such that it will be written by the logger task, and activates the
+ * other buffer if it is free.  This must be called within a critical section.
  */
-static void logger_write_log_message(char * buffer, const bool os_running)
+static void logger_seal_active_buffer(logger_stream_t *stream)
 {
-    /* Send the buffer to the queue for the logger task to write */
-    if (os_running) {
-        xQueueSend(g_write_buffer_queue, &buffer, portMAX_DELAY);
-    }
-    /* No logging task to write the data, so we need to do it ourselves */
-    else {
-        size_t len = strlen(buffer);
-        buffer[len] = '\n';
-        buffer[++len] = '\0';
-        logger_write_to_file(buffer, len);
-
-        /* OS not running, so put the buffer back to the empty queue instead of write queue */
-        xQueueSend(g_empty_buffer_queue, &buffer, 0);
+    stream->buffers[stream->active].sealed = true;
+    if (logger_buffer_free(&stream->buffers[!stream->active])) {
+        stream->active = !stream->active;
     }
 }
 
 /**
- * This is the actual FreeRTOS logger task responsible for:
- *      - Retrieve a log message written to the write queue
- *      - Copy it to our local buffer
- *      - If local buffer is full, write it to the file
- *      - Put-back the log message buffer to available queue
+ * Reserves space in the active file buffer of a stream.
+ * @param [in] stream The logger stream
+ * @param [in] size   The maximum size of the message
+ * @param [in] os_running If FreeRTOS is running, this may block until the logger task writes a
+ *             buffer to the file.  If OS is not running, the buffer is always written right
+ *             after the log message so this will not block.
+ * @returns the pointer to the reserved space, which must be given to logger_commit(), or NULL
+ *          if the message was dropped because of FILE_LOGGER_DROP_WHEN_FULL
  */
-static void logger_task(void *p)
+static char * logger_reserve(logger_stream_t *stream, const uint16_t size, const bool os_running)
 {
-    /* Use "char * const" to disallow this pointer to be moved.
-     * We don't want to use "const char *" because we do want to be able to
-     * write to this pointer instead of using excessive casts later.
-     */
-    char * const start_ptr = gp_file_buffer;
-    char * const end_ptr = start_ptr + FILE_LOGGER_BUFFER_SIZE;
-
-    char * log_msg = NULL;
-    char * write_ptr = start_ptr;
-    size_t len = 0;
-    size_t buffer_overflow_cnt = 0;
+    char *slot = NULL;
+    bool sealed = false;
+    bool waited = false;
 
     while (1)
     {
-        /* Receive the log message we wish to write to our buffer.
-         * Timeout or NULL pointer received is the signal to flush the data.
-         */
-        log_msg = NULL;
-        if (!xQueueReceive(g_write_buffer_queue, &log_msg, OS_MS(1000 * FILE_LOGGER_FLUSH_TIME_SEC)) ||
-            NULL == log_msg)
+        taskENTER_CRITICAL();
         {
-            logger_write_to_file(start_ptr, (write_ptr - start_ptr));
-            write_ptr = start_ptr;
-            continue;
+            logger_buffer_t *b = &stream->buffers[stream->active];
+
+            if (b->sealed || b->used + size > stream->buffer_size) {
+                sealed = !b->sealed;
+                logger_seal_active_buffer(stream);
+                b = &stream->buffers[stream->active];
+            }
+
+            if (!b->sealed && b->used + size <= stream->buffer_size) {
+                slot = b->data + b->used;
+                b->used += size;
+                ++b->pending;
+                ++b->msgs;
+
+                const uint16_t msgs = (stream->buffers[0].msgs + stream->buffers[1].msgs);
+                if (msgs > g_buffer_watermark) {
+                    g_buffer_watermark = msgs;
+                }
+            }
         }
+        taskEXIT_CRITICAL();
 
-        /* Update the watermark of the number of messages we see in the queue and note that we
-         * add one to account for the message we just dequeued.
-         */
-        if ((len = (1 + uxQueueMessagesWaiting(g_write_buffer_queue)) ) > g_buffer_watermark) {
-            g_buffer_watermark = len;
+        /* We sealed a buffer; let the logger task know it may write it */
+        if (sealed && os_running) {
+            xSemaphoreGive(g_write_signal);
+            sealed = false;
         }
 
-        /* Get the length and append the newline character */
-        len = strlen(log_msg);
-        log_msg[len] = '\n';
-        log_msg[++len] = '\0';
+        if (slot || !os_running) {
+            break;
+        }
 
-        /* This is test code to immediately write data to the file.  It is highly in-efficient and is
-         * included here just for reference or test purposes.
-         */
-        #if 0
-        {
-            logger_write_to_file(log_msg, len);
-            xQueueSend(g_empty_buffer_queue, &log_msg, portMAX_DELAY);
-            continue;
+        /* Both buffers are waiting to be written to the file, drop the message instead of waiting */
+        #if (FILE_LOGGER_DROP_WHEN_FULL)
+        logger_atomic_inc16(&g_dropped_calls);
+        break;
+        #endif
+
+        /* Both buffers are waiting to be written to the file, wait for the logger task */
+        if (waited) {
+            xSemaphoreTake(stream->space_signal, portMAX_DELAY);
+        }
+        else if (!xSemaphoreTake(stream->space_signal, OS_MS(FILE_LOGGER_BLOCK_TIME_MS))) {
+            logger_atomic_inc16(&g_blocked_calls);
+
+            /* This time, just block forever until we get the space */
+            xSemaphoreTake(stream->space_signal, portMAX_DELAY);
+        }
+        waited = true;
+    }
+
+    /* Other callers may also be waiting for the space */
+    if (waited) {
+        xSemaphoreGive(stream->space_signal);
+    }
+
+    return slot;
+}
+
+/**
+ * Commits the reserved space of a log message.
+ * @param [in] stream The logger stream
+ * @param [in] slot   The pointer returned by logger_reserve()
+ * @param [in] size   The size given to logger_reserve()
+ * @param [in] len    The actual length of the message
+ * @param [in] os_running If OS is not running, the buffer is written to the file immediately
+ */
+static void logger_commit(logger_stream_t *stream, char * slot, const uint16_t size, const uint16_t len,
+                          const bool os_running)
+{
+    bool ready = false;
+    const uint32_t gap = size - len;
+    logger_buffer_t *b = (slot >= stream->buffers[0].data &&
+                          slot < stream->buffers[0].data + stream->buffer_size) ?
+                         &stream->buffers[0] : &stream->buffers[1];
+
+    taskENTER_CRITICAL();
+    {
+
+        /* Give back the unused space if no other reservation has been made after ours */
+        if (slot + size == b->data + b->used) {
+            b->used -= gap;
+        }
+        /* Mark the gap, which is at least two bytes due to FILE_LOGGER_MSG_MAX_CHARS */
+        else if (gap > 0) {
+            slot[len] = '\0';
+            slot[len + 1] = (char) gap;
+            ++b->gaps;
+        }
+
+        #if (FILE_LOGGER_NOINIT_BYTES)
+        if (&g_streams[logger_stream_text] == stream) {
+            logger_noinit_copy(b, slot, len);
         }
         #endif
 
-        /* If we will overflow our buffer we need to write the full buffer and do partial copy */
-        if (len + write_ptr >= end_ptr)
-        {
-            /* This could be zero when we write the last byte in the buffer */
-            buffer_overflow_cnt = (len + write_ptr - end_ptr);
+        --b->pending;
+        ready = (b->sealed && 0 == b->pending);
+    }
+    taskEXIT_CRITICAL();
 
-            /* Copy the partial message up until the end of the buffer */
-            memcpy(write_ptr, log_msg, (end_ptr - write_ptr));
+    if (os_running) {
+        if (ready) {
+            xSemaphoreGive(g_write_signal);
+        }
+    }
+    /* No logging task to write the data, so we need to do it ourselves */
+    else {
+        logger_write_to_file(stream, b->data, b->used);
+        b->used = 0;
+        b->msgs = 0;
+        #if (FILE_LOGGER_NOINIT_BYTES)
+        logger_noinit_written(stream);
+        #endif
+        logger_sync_file(stream);
+    }
+}
 
-            /* Write the entire buffer to the file */
-            logger_write_to_file(start_ptr, (end_ptr - start_ptr));
+/**
+ * Commits a text message reserved with FILE_LOGGER_LOG_MSG_MAX_LEN bytes.
+ * @param [in] slot  The reserved space containing a NULL terminated message
+ * @param [in] os_running @see logger_commit()
+ */
+static void logger_commit_text(char * slot, const bool os_running)
+{
+    /* Replace the NULL terminator by the newline */
+    uint32_t len = strlen(slot);
+    slot[len++] = '\n';
 
-            /* Optional: Zero out the buffer space */
-            // memset(start_ptr, '\0', buffer_size);
+    logger_commit(&g_streams[logger_stream_text], slot, FILE_LOGGER_LOG_MSG_MAX_LEN, len, os_running);
+}
 
-            /* Copy the left-over message to the start of "fresh" buffer space (after writing to the file) */
-            if (buffer_overflow_cnt > 0) {
-                memcpy(start_ptr, (log_msg + len - buffer_overflow_cnt), buffer_overflow_cnt);
-            }
-            write_ptr = start_ptr + buffer_overflow_cnt;
+/**
+ * Removes the gaps left by the messages that could not give back their unused space.
+ * Gap starts with a NULL char followed by the length of the gap.
+ * @returns the number of bytes of the buffer after removing the gaps
+ */
+static uint32_t logger_remove_gaps(char *data, const uint32_t used)
+{
+    const char *src = data;
+    const char *end = data + used;
+    char *dst = data;
+
+    while (src < end) {
+        if ('\0' == *src) {
+            src += (uint8_t) src[1];
         }
-        /* Buffer has enough space, write the entire message to the buffer */
         else {
-            memcpy(write_ptr, log_msg, len);
-            write_ptr += len;
+            *dst++ = *src++;
+        }
+    }
+
+    return (dst - data);
+}
+
+/**
+ * Writes the sealed buffers of a logger stream to the file once all of their messages are committed.
+ * @param [in] stream The logger stream
+ * @param [in] flush  If true, the active buffer is sealed to be written as well
+ */
+static void logger_write_stream(logger_stream_t *stream, const bool flush)
+{
+    if (flush) {
+        taskENTER_CRITICAL();
+        if (stream->buffers[stream->active].used > 0 && !stream->buffers[stream->active].sealed) {
+            logger_seal_active_buffer(stream);
+        }
+        taskEXIT_CRITICAL();
+    }
+
+    /* Buffers are sealed in the alternating order, so write them in the same order */
+    logger_buffer_t *b = &stream->buffers[stream->write];
+    while (b->sealed && 0 == b->pending)
+    {
+        uint32_t bytes = b->used;
+        if (b->gaps > 0) {
+            bytes = logger_remove_gaps(b->data, bytes);
+        }
+
+        /* This buffer cannot be changed by anyone else while it is sealed */
+        logger_write_to_file(stream, b->data, bytes);
+
+        taskENTER_CRITICAL();
+        {
+            b->used = 0;
+            b->msgs = 0;
+            b->gaps = 0;
+            b->sealed = false;
+
+            /* Both buffers were sealed, so the active one can be swapped now */
+            if (stream->buffers[stream->active].sealed) {
+                stream->active = stream->write;
+            }
+            #if (FILE_LOGGER_NOINIT_BYTES)
+            logger_noinit_written(stream);
+            #endif
+        }
+        taskEXIT_CRITICAL();
+
+        xSemaphoreGive(stream->space_signal);
+
+        stream->write = !stream->write;
+        b = &stream->buffers[stream->write];
+    }
+}
+
+/**
+ * @returns the time the logger task waits for the signal, which is the flush timeout unless
+ *          the written buffers of a stream are due to be synced before that
+ */
+static uint32_t logger_task_wait_ms(const uint32_t flush_ms)
+{
+    uint32_t wait_ms = flush_ms;
+
+#if (FILE_LOGGER_SYNC_TIME_SEC)
+    const uint32_t now_ms = sys_get_uptime_ms();
+    for (int i = 0; i < logger_stream_count; i++) {
+        if (g_streams[i].unsynced > 0) {
+            const int32_t due_ms = (int32_t) (g_streams[i].sync_at_ms - now_ms);
+            if (due_ms <= 0) {
+                wait_ms = 0;
+            }
+            else if ((uint32_t) due_ms < wait_ms) {
+                wait_ms = due_ms;
+            }
+        }
+    }
+#endif
+
+    return wait_ms;
+}
+
+/**
+ * This is the actual FreeRTOS logger task responsible for:
+ *      - Sealing the active buffers upon a flush request or the flush timeout
+ *      - Writing the sealed buffers to the file once all of their messages are committed
+ *      - Giving the written buffers back to the logging calls
+ *      - Syncing the written buffers according to the FILE_LOGGER_SYNC_BUFFERS and FILE_LOGGER_SYNC_TIME_SEC
+ */
+static void logger_task(void *p)
+{
+    const uint32_t flush_ms = 1000 * FILE_LOGGER_FLUSH_TIME_SEC;
+
+    while (1)
+    {
+        /* Timeout or the flush request is the signal to flush and sync the data, unless it was the sync time */
+        const uint32_t wait_ms = logger_task_wait_ms(flush_ms);
+        bool flush = !xSemaphoreTake(g_write_signal, OS_MS(wait_ms)) && (flush_ms == wait_ms);
+        if (g_flush_requested) {
+            g_flush_requested = false;
+            flush = true;
         }
 
-        /* Put the data pointer back to the available buffers */
-        xQueueSend(g_empty_buffer_queue, &log_msg, portMAX_DELAY);
+        const uint32_t now_ms = sys_get_uptime_ms();
+        for (int i = 0; i < logger_stream_count; i++) {
+            logger_write_stream(&g_streams[i], flush);
+            if (flush || logger_sync_due(&g_streams[i], now_ms)) {
+                logger_sync_file(&g_streams[i]);
+            }
+        }
     }
 }
 
@@ -257,9 +929,49 @@ static void logger_task(void *p)
  */
 static bool logger_initialized(void)
 {
-    return (NULL != gp_file_buffer);
+    return (NULL != g_streams[logger_stream_text].buffers[1].data);
 }
 
+#if (FILE_LOGGER_NOINIT_BYTES)
+/**
+ * Writes the messages of the crash log that were not synced to the file before the reset, and
+ * initializes the crash log.
+ */
+static void logger_noinit_recover(logger_stream_t *stream)
+{
+    const sys_boot_t boot = sys_get_boot_type();
+
+    if ((boot_watchdog_recover == boot || boot_watchdog == boot) && logger_noinit_valid())
+    {
+        uint32_t start = g_noinit.synced;
+        uint32_t bytes = g_noinit.head - g_noinit.synced;
+
+        /* The oldest messages were overwritten, so start after the first complete message */
+        if (bytes > FILE_LOGGER_NOINIT_BYTES) {
+            start = g_noinit.head - FILE_LOGGER_NOINIT_BYTES;
+            bytes = FILE_LOGGER_NOINIT_BYTES;
+            while (bytes > 0 && '\n' != g_noinit.data[start++ & (FILE_LOGGER_NOINIT_BYTES - 1)]) {
+                --bytes;
+            }
+            bytes -= (bytes > 0);
+        }
+
+        const uint32_t pos = start & (FILE_LOGGER_NOINIT_BYTES - 1);
+        const uint32_t first = (bytes < FILE_LOGGER_NOINIT_BYTES - pos) ? bytes : (FILE_LOGGER_NOINIT_BYTES - pos);
+        if (bytes > 0 &&
+            logger_write_to_file(stream, &g_noinit.data[pos], first) &&
+            logger_write_to_file(stream, &g_noinit.data[0], bytes - first) &&
+            logger_sync_file(stream)) {
+            g_noinit_recovered = bytes;
+        }
+    }
+
+    g_noinit.magic = FILE_LOGGER_NOINIT_MAGIC;
+    logger_noinit_set(0, 0);
+    stream->noinit_written = 0;
+}
+#endif
+
 /**
  * Allocates the memory used for the logger.
  * @param [in] logger_priority  The priority at which the logger task will run.
@@ -268,44 +980,92 @@ static bool logger_initialized(void)
 static bool logger_internal_init(UBaseType_t logger_priority)
 {
     uint32_t i = 0;
-    char * ptr = NULL;
+    uint32_t b = 0;
     const bool success = true;
 
-    /* Create the buffer space we write the logged messages to (before we flush it to the file) */
-    gp_file_buffer = (char*) malloc(FILE_LOGGER_BUFFER_SIZE);
-    if (NULL == gp_file_buffer) {
-        goto failure;
-    }
-
-    /* Create the queues that keep track of the written buffers, and available buffers */
-    g_write_buffer_queue = xQueueCreate(FILE_LOGGER_NUM_BUFFERS, sizeof(char*));
-    g_empty_buffer_queue = xQueueCreate(FILE_LOGGER_NUM_BUFFERS, sizeof(char*));
-    if (NULL == g_write_buffer_queue || NULL == g_empty_buffer_queue) {
-        goto failure;
-    }
+    g_streams[logger_stream_text].filename = FILE_LOGGER_FILENAME;
+    g_streams[logger_stream_text].buffer_size = FILE_LOGGER_BUFFER_SIZE;
+#if (FILE_LOGGER_BIN_ENABLE)
+    g_streams[logger_stream_bin].filename = FILE_LOGGER_BIN_FILENAME;
+    g_streams[logger_stream_bin].buffer_size = FILE_LOGGER_BIN_BUFFER_SIZE;
+#endif
 
-    /* Create the actual buffers for log messages */
-    for (i = 0; i < FILE_LOGGER_NUM_BUFFERS; i++)
+    /* Create the buffer space we write the logged messages to (before we flush it to the file) */
+    for (i = 0; i < logger_stream_count; i++)
     {
-        ptr = (char*) malloc(FILE_LOGGER_LOG_MSG_MAX_LEN);
+        logger_stream_t *stream = &g_streams[i];
+        for (b = 0; b < sizeof(stream->buffers) / sizeof(stream->buffers[0]); b++)
+        {
+            stream->buffers[b].data = (char*) malloc(stream->buffer_size);
+            if (NULL == stream->buffers[b].data) {
+                goto failure;
+            }
+        }
 
-        if (NULL == ptr) {
+        /* Create the signal to the logging calls waiting for the buffer space */
+        if (NULL == (stream->space_signal = xSemaphoreCreateBinary())) {
             goto failure;
         }
 
-        /* DO NOT USE xQueueSendFromISR().
-         * It causes weird file write errors and corrupts the entire file system
-         * when the logger task is running.
-         */
-        xQueueSend(g_empty_buffer_queue, &ptr, 0);
+#if (FILE_LOGGER_PREALLOC_BYTES)
+        stream->stream_file = malloc (sizeof(*stream->stream_file));
+#if (FILE_LOGGER_ROTATE)
+        if (logger_stream_text == i && NULL != stream->stream_file)
+        {
+            /* The text log is written to FILE_LOGGER_FILENAME if the files of the ring cannot be opened */
+            if (FR_OK == logger_rotate_open(stream)) {
+                stream->filename = g_rotate_filename;
+            }
+            else {
+                free(stream->stream_file);
+                stream->stream_file = NULL;
+            }
+        }
+        else
+#endif
+        if (NULL != stream->stream_file &&
+            FR_OK != stream_file_open(stream->stream_file, stream->filename, FILE_LOGGER_PREALLOC_BYTES))
+        {
+            /* The file is written without pre-allocation, such as if the volume is not formatted yet */
+            free(stream->stream_file);
+            stream->stream_file = NULL;
+        }
+#endif
+#if (FILE_LOGGER_KEEP_FILE_OPEN)
+        stream->file_ptr = malloc (sizeof(*stream->file_ptr));
+        if(NULL == stream->file_ptr ||
+           FR_OK != f_open(stream->file_ptr, stream->filename, FA_OPEN_ALWAYS | FA_WRITE) ||
+           FR_OK != f_lseek(stream->file_ptr, f_size(stream->file_ptr)))
+        {
+            goto failure;
+        }
+#else
+        /* The file object is only needed if the file is not pre-allocated */
+#if (FILE_LOGGER_PREALLOC_BYTES)
+        if (NULL == stream->stream_file)
+#endif
+        {
+            if (NULL == (stream->file_ptr = malloc (sizeof(*stream->file_ptr)))) {
+                goto failure;
+            }
+        }
+#endif
     }
 
-#if (FILE_LOGGER_KEEP_FILE_OPEN)
-    gp_file_ptr = malloc (sizeof(*gp_file_ptr));
-    if(FR_OK != f_open(gp_file_ptr, FILE_LOGGER_FILENAME, FA_OPEN_ALWAYS | FA_WRITE))
-    {
+#if (FILE_LOGGER_NOINIT_BYTES)
+    /* The crash log is written before any new message is logged */
+    logger_noinit_recover(&g_streams[logger_stream_text]);
+#endif
+
+    /* Create the signal to the logger task */
+    if (NULL == (g_write_signal = xSemaphoreCreateBinary())) {
         goto failure;
     }
+
+#if (FILE_LOGGER_RATE_LIMIT)
+    for (i = 0; i < log_last; i++) {
+        logger_bucket_fill(&g_severity_buckets[i], g_severity_burst[i], sys_get_uptime_ms());
+    }
 #endif
 
 #if BUILD_CFG_MPU
@@ -321,21 +1081,17 @@ static bool logger_internal_init(UBaseType_t logger_priority)
 
     /* failure case to delete allocated memory */
     failure:
-        if (gp_file_buffer) {
-            free(gp_file_buffer);
-            gp_file_buffer = NULL;
-        }
-
-        if (g_empty_buffer_queue) {
-            for (i = 0; i < FILE_LOGGER_NUM_BUFFERS; i++) {
-                if (xQueueReceive(g_empty_buffer_queue, &ptr, 0)) {
-                    free (ptr);
+        for (i = 0; i < logger_stream_count; i++) {
+            for (b = 0; b < sizeof(g_streams[i].buffers) / sizeof(g_streams[i].buffers[0]); b++) {
+                if (g_streams[i].buffers[b].data) {
+                    free(g_streams[i].buffers[b].data);
+                    g_streams[i].buffers[b].data = NULL;
                 }
             }
         }
 
-        /* Delete g_write_buffer_queue */
-        /* Delete g_empty_buffer_queue */
+        /* Delete g_write_signal */
+        /* Delete space_signal of the streams */
 
         return (!success);
 }
@@ -344,8 +1100,51 @@ void logger_send_flush_request(void)
 {
     if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState() && logger_initialized())
     {
-        char * null_ptr_to_flush = NULL;
-        xQueueSend(g_write_buffer_queue, &null_ptr_to_flush, portMAX_DELAY);
+        g_flush_requested = true;
+        xSemaphoreGive(g_write_signal);
+    }
+}
+
+void logger_emergency_flush(void)
+{
+    /* A fault while flushing does not flush again */
+    if (!logger_initialized() || g_emergency) {
+        return;
+    }
+    g_emergency = true;
+
+    /* No task runs from here on, and the drivers no longer take the locks of the file system and the SPI */
+    if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        vTaskSuspendAll();
+    }
+
+    /* A write or a transfer that was interrupted cannot be resumed by us */
+    if (g_writing || spi1_is_locked()) {
+        return;
+    }
+
+    for (int i = 0; i < logger_stream_count; i++)
+    {
+        logger_stream_t *stream = &g_streams[i];
+
+        /* Buffers are sealed in the alternating order, so the buffer to be written next is the oldest */
+        for (int n = 0; n < 2; n++)
+        {
+            logger_buffer_t *b = &stream->buffers[n ? !stream->write : stream->write];
+
+            /* The messages that are not committed yet may not be complete */
+            if (b->used > 0 && 0 == b->pending) {
+                const uint32_t bytes = (b->gaps > 0) ? logger_remove_gaps(b->data, b->used) : b->used;
+                logger_write_to_file(stream, b->data, bytes);
+                b->used = 0;
+                b->msgs = 0;
+                b->gaps = 0;
+            }
+        }
+        #if (FILE_LOGGER_NOINIT_BYTES)
+        logger_noinit_written(stream);
+        #endif
+        logger_sync_file(stream);
     }
 }
 
@@ -377,6 +1176,12 @@ void logger_init(uint8_t logger_priority)
         if (!logger_internal_init(logger_priority)) {
             printf("ERROR: logger initialization failure\n");
         }
+        #if (FILE_LOGGER_NOINIT_BYTES)
+        else if (g_noinit_recovered > 0) {
+            LOG_WARN("Recovered %u bytes of the log that were not synced before the reset",
+                     (unsigned) g_noinit_recovered);
+        }
+        #endif
     }
 }
 
@@ -391,18 +1196,47 @@ void logger_set_printf(logger_msg_t type, bool enable)
     }
 }
 
-void logger_log(logger_msg_t type, const char * filename, const char * func_name, unsigned line_num,
-                const char * msg, ...)
+uint32_t logger_get_suppressed_call_count(logger_msg_t severity)
 {
-    if (!logger_initialized()) {
-        return;
+    return (severity < log_last) ? g_logger_suppressed[severity] : 0;
+}
+
+uint16_t logger_get_dropped_call_count(void)
+{
+    return g_dropped_calls;
+}
+
+void logger_set_min_level(logger_msg_t type)
+{
+    g_logger_min_level = type;
+}
+
+void logger_set_rate_limit(logger_msg_t type, uint16_t per_sec, uint16_t burst)
+{
+#if (FILE_LOGGER_RATE_LIMIT)
+    if (type < log_last) {
+        taskENTER_CRITICAL();
+        g_severity_rate[type] = per_sec;
+        g_severity_burst[type] = burst;
+        logger_bucket_fill(&g_severity_buckets[type], burst, sys_get_uptime_ms());
+        taskEXIT_CRITICAL();
     }
+#endif
+}
 
+/**
+ * Logs a text message with the header containing the time, filename, function name etc.
+ * @see logger_log()
+ */
+static void logger_log_va(logger_msg_t type, const char * filename, const char * func_name, unsigned line_num,
+                          const char * msg, va_list args)
+{
     uint32_t len = 0;
     char * buffer = NULL;
     char * temp_ptr = NULL;
-    const rtc_t time = rtc_gettime();
-    const unsigned int uptime = sys_get_uptime_ms();
+    const uint64_t uptime_us = sys_get_uptime_us();
+    const rtc_t time = rtc_gettime_cached(uptime_us);
+    const unsigned int uptime = uptime_us / 1000;
     const bool os_running = (taskSCHEDULER_RUNNING == xTaskGetSchedulerState());
 
     /* This must match up with the logger_msg_t enumeration */
@@ -423,51 +1257,86 @@ void logger_log(logger_msg_t type, const char * filename, const char * func_name
         func_name = "";
     }
 
-    /* Get an available buffer */
-    buffer = logger_get_buffer_ptr(os_running);
+    /* Reserve the space in the file buffer to print the message to */
+    buffer = logger_reserve(&g_streams[logger_stream_text], FILE_LOGGER_LOG_MSG_MAX_LEN, os_running);
+    if (NULL == buffer) {
+        return;
+    }
 
     do {
-        int mon = time.month;
-        int day = time.day;
-        int hr = time.hour;
-        int min = time.min;
-        int sec = time.sec;
         unsigned int up = uptime;
         const char *log_type_str = type_str[type];
         const char *func_parens  = func_name[0] ? "()" : "";
 
         /* Write the header including time, filename, function name etc */
-        len = sprintf(buffer, "%d/%d,%02d:%02d:%02d,%u,%s,%s,%s%s,%u,",
-                      mon, day, hr, min, sec, up, log_type_str, filename, func_name, func_parens, line_num);
+        len = logger_print_time(buffer, &time);
+        len += fmt_snprintf(buffer + len, FILE_LOGGER_MSG_MAX_CHARS + 1 - len, "%u,%s,%s,%s%s,%u,",
+                            up, log_type_str, filename, func_name, func_parens, line_num);
+        if (len > FILE_LOGGER_MSG_MAX_CHARS) {
+            len = FILE_LOGGER_MSG_MAX_CHARS;
+        }
     } while (0);
 
-    /* Append actual user message, and leave one space for \n to be appended by the logger task.
-     * There is no efficient way to append \n here since we will have to use strlen(),
-     * but since the logger task will take strlen() anyway, it can append it there.
-     *
-     * Example: max length = 10, and say we printed 5 chars so far "hello"
-     *          we will sprintf "world" to "hello" where n = 10-5-1 = 4
-     *          So, this sprintf will append and make it: "hellowor\0" leaving space to add \n
+    /* Append actual user message, and leave space for the \n to be appended by logger_commit().
      *
      * Note: You cannot use returned value from vsnprintf() because snprintf() returns:
      *       "number of chars that would've been printed if n was sufficiently large"
      *
      * Note: "size" of snprintf() includes the NULL character
      */
-    do {
-        va_list args;
-        va_start(args, msg);
-        vsnprintf(buffer + len, FILE_LOGGER_LOG_MSG_MAX_LEN-len-1, msg, args);
-        va_end(args);
-    } while (0);
-
-    ++g_logger_calls[type];
-    logger_write_log_message(buffer, os_running);
+    fmt_vsnprintf(buffer + len, FILE_LOGGER_MSG_MAX_CHARS + 1 - len, msg, args);
 
-    /* Print the message out if the printf mask was set */
+    /* Print the message out if the printf mask was set (before the space is committed and recycled) */
     if (g_logger_printf_mask & (1 << type)) {
         puts(buffer);
     }
+
+    logger_commit_text(buffer, os_running);
+
+#if (FILE_LOGGER_SYNC_ON_ERROR)
+    if (log_error == type) {
+        logger_send_flush_request();
+    }
+#endif
+}
+
+#if (FILE_LOGGER_RATE_LIMIT)
+/// Logs the text message using logger_log_va()
+static void logger_log_fmt(logger_msg_t type, const char * filename, const char * func_name, unsigned line_num,
+                           const char * msg, ...)
+{
+    va_list args;
+    va_start(args, msg);
+    logger_log_va(type, filename, func_name, line_num, msg, args);
+    va_end(args);
+}
+#endif
+
+void logger_log(logger_msg_t type, const char * filename, const char * func_name, unsigned line_num,
+                const char * msg, ...)
+{
+    if (!logger_initialized() || type < g_logger_min_level) {
+        return;
+    }
+
+    /* All calls are counted, including the ones that are suppressed */
+    logger_atomic_inc(&g_logger_calls[type]);
+    PROFILE_SCOPE("logger_log");
+
+#if (FILE_LOGGER_RATE_LIMIT)
+    uint16_t suppressed = 0;
+    if (!logger_rate_check(type, filename, line_num, &suppressed)) {
+        return;
+    }
+    if (suppressed > 0) {
+        logger_log_fmt(type, filename, func_name, line_num, "%u messages suppressed", (unsigned) suppressed);
+    }
+#endif
+
+    va_list args;
+    va_start(args, msg);
+    logger_log_va(type, filename, func_name, line_num, msg, args);
+    va_end(args);
 }
 
 void logger_log_raw(const char * msg, ...)
@@ -477,15 +1346,67 @@ void logger_log_raw(const char * msg, ...)
     }
 
     const bool os_running = (taskSCHEDULER_RUNNING == xTaskGetSchedulerState());
-    char * buffer = logger_get_buffer_ptr(os_running);
+    char * buffer = logger_reserve(&g_streams[logger_stream_text], FILE_LOGGER_LOG_MSG_MAX_LEN, os_running);
+    if (NULL == buffer) {
+        return;
+    }
 
     /* Print the actual user message to the buffer */
     do {
         va_list args;
         va_start(args, msg);
-        vsnprintf(buffer, FILE_LOGGER_LOG_MSG_MAX_LEN-1, msg, args);
+        fmt_vsnprintf(buffer, FILE_LOGGER_MSG_MAX_CHARS + 1, msg, args);
+        va_end(args);
+    } while (0);
+
+    logger_commit_text(buffer, os_running);
+}
+
+#if (FILE_LOGGER_BIN_ENABLE)
+void logger_log_bin(logger_msg_t type, uint16_t id, uint8_t nargs, ...)
+{
+    if (!logger_initialized() || type < g_logger_min_level) {
+        return;
+    }
+
+    if (nargs > FILE_LOGGER_BIN_MAX_ARGS) {
+        nargs = FILE_LOGGER_BIN_MAX_ARGS;
+    }
+
+    const uint64_t uptime_us = sys_get_uptime_us();
+    const bool os_running = (taskSCHEDULER_RUNNING == xTaskGetSchedulerState());
+    const uint16_t size = sizeof(logger_bin_header_t) + (nargs * sizeof(uint32_t));
+
+    /* Buffers are word aligned, and so are the records since their size is a multiple of 4 */
+    logger_bin_header_t *header = (logger_bin_header_t*) logger_reserve(&g_streams[logger_stream_bin],
+                                                                          size, os_running);
+    logger_atomic_inc(&g_logger_calls[type]);
+    if (NULL == header) {
+        return;
+    }
+
+    uint32_t *words = (uint32_t*) (header + 1);
+
+    header->id = id;
+    header->info = LOGGER_BIN_INFO(type, nargs);
+    header->time_us_hi = (uint8_t) (uptime_us >> 32);
+    header->time_us_lo = (uint32_t) uptime_us;
+
+    do {
+        va_list args;
+        va_start(args, nargs);
+        for (uint8_t i = 0; i < nargs; i++) {
+            words[i] = va_arg(args, uint32_t);
+        }
         va_end(args);
     } while (0);
 
-    logger_write_log_message(buffer, os_running);
+    logger_commit(&g_streams[logger_stream_bin], (char*) header, size, size, os_running);
+
+#if (FILE_LOGGER_SYNC_ON_ERROR)
+    if (log_error == type) {
+        logger_send_flush_request();
+    }
+#endif
 }
+#endif
@@ -0,0 +1,283 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <string.h>
+
+#include "lz_frame.h"
+#include "crc.h"
+
+
+
+#define LZ_MIN_MATCH        4       ///< The shortest match of the LZ4 block format
+#define LZ_LAST_LITERALS    5       ///< The last bytes of a block are always literals
+#define LZ_MATCH_LIMIT      12      ///< The last match starts at least this many bytes before the end
+#define LZ_MAX_OFFSET       0xFFFF  ///< The farthest match
+
+
+
+/// @returns the 4 bytes at p, in any alignment
+static inline uint32_t lz_read32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/// @returns the hash of the 4 bytes for the table of lz_work_t
+static inline uint32_t lz_hash(const uint32_t v)
+{
+    return (v * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+/// Writes the bytes that extend a length of 15 or more of the token
+static uint8_t* lz_put_length(uint8_t *op, uint32_t len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = len;
+    return op;
+}
+
+/// @returns the worst case bytes of a sequence of the literals and the match
+static inline uint32_t lz_sequence_bytes(const uint32_t literals, const uint32_t match_len)
+{
+    return 1 + (literals / 255) + 1 + literals + 2 + (match_len / 255) + 1;
+}
+
+/// Writes a sequence of the literals and the match, or only the literals if match_len is 0
+static uint8_t* lz_put_sequence(uint8_t *op, const uint8_t *literals, const uint32_t literals_len,
+                                const uint32_t offset, const uint32_t match_len)
+{
+    uint8_t *token = op++;
+
+    *token = ((literals_len >= 15) ? 15 : literals_len) << 4;
+    if (literals_len >= 15) {
+        op = lz_put_length(op, literals_len - 15);
+    }
+    memcpy(op, literals, literals_len);
+    op += literals_len;
+
+    if (match_len > 0) {
+        const uint32_t ml = match_len - LZ_MIN_MATCH;
+        *op++ = offset & 0xFF;
+        *op++ = offset >> 8;
+        *token |= (ml >= 15) ? 15 : ml;
+        if (ml >= 15) {
+            op = lz_put_length(op, ml - 15);
+        }
+    }
+    return op;
+}
+
+uint32_t lz_compress(const void *src, uint32_t len, void *dst, uint32_t dst_size, lz_work_t *work)
+{
+    const uint8_t *base = (const uint8_t*) src;
+    const uint8_t *ip = base;
+    const uint8_t *anchor = base;
+    const uint8_t *end = base + len;
+    uint8_t *op = (uint8_t*) dst;
+    uint8_t *op_end = op + dst_size;
+
+    memset(work->table, 0, sizeof(work->table));
+
+    if (len > LZ_MATCH_LIMIT && len <= LZ_FRAME_MAX_RAW)
+    {
+        const uint8_t *match_start_limit = end - LZ_MATCH_LIMIT;
+        const uint8_t *match_end_limit = end - LZ_LAST_LITERALS;
+
+        while (ip < match_start_limit)
+        {
+            const uint32_t h = lz_hash(lz_read32(ip));
+            const uint16_t pos = work->table[h];
+            const uint8_t *ref = base + pos - 1;
+            work->table[h] = (ip - base) + 1;
+
+            if (0 == pos || (ip - ref) > LZ_MAX_OFFSET || lz_read32(ref) != lz_read32(ip)) {
+                ip++;
+                continue;
+            }
+
+            /* Extend the match forward, and back over the literals that also match */
+            uint32_t match_len = LZ_MIN_MATCH;
+            while (ip + match_len < match_end_limit && ip[match_len] == ref[match_len]) {
+                match_len++;
+            }
+            while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+                match_len++;
+            }
+
+            const uint32_t literals_len = ip - anchor;
+            if ((uint32_t) (op_end - op) < lz_sequence_bytes(literals_len, match_len)) {
+                return 0;
+            }
+            op = lz_put_sequence(op, anchor, literals_len, ip - ref, match_len);
+            ip += match_len;
+            anchor = ip;
+
+            /* The position within the match helps to find the next match */
+            if (ip < match_start_limit) {
+                work->table[lz_hash(lz_read32(ip - 2))] = (ip - 2 - base) + 1;
+            }
+        }
+    }
+
+    const uint32_t literals_len = end - anchor;
+    if ((uint32_t) (op_end - op) < lz_sequence_bytes(literals_len, 0)) {
+        return 0;
+    }
+    op = lz_put_sequence(op, anchor, literals_len, 0, 0);
+    return (op - (uint8_t*) dst);
+}
+
+/// Reads the bytes that extend a length of 15 of the token, @returns false if the input ends
+static bool lz_get_length(const uint8_t **ip, const uint8_t *end, uint32_t *len)
+{
+    uint8_t b = 255;
+    while (255 == b) {
+        if (*ip >= end) {
+            return false;
+        }
+        b = *(*ip)++;
+        *len += b;
+    }
+    return true;
+}
+
+int32_t lz_decompress(const void *src, uint32_t len, void *dst, uint32_t dst_size)
+{
+    const uint8_t *ip = (const uint8_t*) src;
+    const uint8_t *end = ip + len;
+    uint8_t *base = (uint8_t*) dst;
+    uint8_t *op = base;
+    uint8_t *op_end = base + dst_size;
+
+    while (ip < end)
+    {
+        const uint8_t token = *ip++;
+        uint32_t literals_len = token >> 4;
+        if (15 == literals_len && !lz_get_length(&ip, end, &literals_len)) {
+            return -1;
+        }
+        if (literals_len > (uint32_t) (end - ip) || literals_len > (uint32_t) (op_end - op)) {
+            return -1;
+        }
+        memcpy(op, ip, literals_len);
+        op += literals_len;
+        ip += literals_len;
+
+        /* The last sequence has only the literals */
+        if (ip >= end) {
+            break;
+        }
+
+        if (end - ip < 2) {
+            return -1;
+        }
+        const uint32_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        uint32_t match_len = token & 0x0F;
+        if (15 == match_len && !lz_get_length(&ip, end, &match_len)) {
+            return -1;
+        }
+        match_len += LZ_MIN_MATCH;
+        if (0 == offset || offset > (uint32_t) (op - base) || match_len > (uint32_t) (op_end - op)) {
+            return -1;
+        }
+
+        /* The match may overlap the bytes it writes, such as a run of one byte */
+        const uint8_t *ref = op - offset;
+        while (match_len--) {
+            *op++ = *ref++;
+        }
+    }
+
+    return (op - base);
+}
+
+uint32_t lz_frame_pack(const void *src, uint32_t len, void *frame, lz_work_t *work)
+{
+    uint8_t *hdr = (uint8_t*) frame;
+    uint8_t *data = hdr + LZ_FRAME_HEADER_SIZE;
+    uint32_t data_len = 0;
+
+    if (len > LZ_FRAME_MAX_RAW) {
+        return 0;
+    }
+
+    /* Store the raw bytes if they do not get smaller */
+    if (0 == (data_len = lz_compress(src, len, data, len - ((len > 0) ? 1 : 0), work))) {
+        data_len = len;
+        memcpy(data, src, len);
+    }
+
+    const uint16_t crc = crc16_update(CRC16_INIT, src, len);
+    hdr[0] = 'L';
+    hdr[1] = 'Z';
+    hdr[2] = len & 0xFF;
+    hdr[3] = len >> 8;
+    hdr[4] = data_len & 0xFF;
+    hdr[5] = data_len >> 8;
+    hdr[6] = crc & 0xFF;
+    hdr[7] = crc >> 8;
+
+    return (LZ_FRAME_HEADER_SIZE + data_len);
+}
+
+bool lz_frame_get_lengths(const void *header, uint16_t *raw_len, uint16_t *data_len)
+{
+    const uint8_t *hdr = (const uint8_t*) header;
+
+    if ('L' != hdr[0] || 'Z' != hdr[1]) {
+        return false;
+    }
+    *raw_len = hdr[2] | (hdr[3] << 8);
+    *data_len = hdr[4] | (hdr[5] << 8);
+
+    /* The data of a frame is never larger than its raw bytes */
+    return (*data_len <= *raw_len);
+}
+
+int32_t lz_frame_unpack(const void *frame, uint32_t frame_len, void *dst, uint32_t dst_size)
+{
+    const uint8_t *hdr = (const uint8_t*) frame;
+    const uint8_t *data = hdr + LZ_FRAME_HEADER_SIZE;
+    uint16_t raw_len = 0;
+    uint16_t data_len = 0;
+    int32_t len = -1;
+
+    if (frame_len < LZ_FRAME_HEADER_SIZE || !lz_frame_get_lengths(hdr, &raw_len, &data_len) ||
+        frame_len - LZ_FRAME_HEADER_SIZE < data_len || dst_size < raw_len) {
+        return -1;
+    }
+
+    if (data_len == raw_len) {
+        memcpy(dst, data, raw_len);
+        len = raw_len;
+    }
+    else {
+        len = lz_decompress(data, data_len, dst, raw_len);
+    }
+
+    const uint16_t crc = hdr[6] | (hdr[7] << 8);
+    if (len != raw_len || crc != crc16_update(CRC16_INIT, dst, raw_len)) {
+        return -1;
+    }
+    return len;
+}
@@ -0,0 +1,133 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <stddef.h>
+
+#include "mem_arena.h"
+#include "FreeRTOS.h"
+
+
+
+/// @returns the pointer rounded up to MEM_ARENA_ALIGN
+static inline uint8_t* mem_align(void *ptr)
+{
+    return (uint8_t*) (((uintptr_t) ptr + MEM_ARENA_ALIGN - 1) & ~(uintptr_t) (MEM_ARENA_ALIGN - 1));
+}
+
+void mem_arena_init(mem_arena_t *arena, void *mem, uint32_t size)
+{
+    uint8_t *aligned = mem_align(mem);
+    const uint32_t skip = aligned - (uint8_t*) mem;
+
+    arena->mem = aligned;
+    arena->size = (NULL != mem && size > skip) ? (size - skip) : 0;
+    arena->used = 0;
+    arena->peak = 0;
+}
+
+void* mem_arena_alloc(mem_arena_t *arena, uint32_t bytes)
+{
+    const uint32_t aligned = (bytes + MEM_ARENA_ALIGN - 1) & ~(MEM_ARENA_ALIGN - 1);
+    void *ptr = NULL;
+
+    if (aligned >= bytes && aligned <= arena->size - arena->used) {
+        ptr = arena->mem + arena->used;
+        arena->used += aligned;
+        if (arena->used > arena->peak) {
+            arena->peak = arena->used;
+        }
+    }
+    return ptr;
+}
+
+void mem_arena_release(mem_arena_t *arena, uint32_t mark)
+{
+    if (mark < arena->used) {
+        arena->used = mark;
+    }
+}
+
+uint32_t mem_arena_get_free(const mem_arena_t *arena, uint32_t *pPeak)
+{
+    if (NULL != pPeak) {
+        *pPeak = arena->peak;
+    }
+    return arena->size - arena->used;
+}
+
+void mem_blocks_init(mem_blocks_t *blocks, void *mem, uint16_t block_size, uint16_t count)
+{
+    /* A free block stores the pointer to the next free block */
+    if (block_size < sizeof(void*)) {
+        block_size = sizeof(void*);
+    }
+
+    blocks->block_size = (block_size + MEM_ARENA_ALIGN - 1) & ~(MEM_ARENA_ALIGN - 1);
+    blocks->start = mem_align(mem);
+    blocks->end = blocks->start + (uint32_t) blocks->block_size * count;
+    blocks->free_list = NULL;
+    blocks->num_free = count;
+    blocks->min_free = count;
+
+    /* Link the blocks from the last one so they are handed out in the order of the memory */
+    for (uint8_t *b = blocks->end; b > blocks->start; ) {
+        b -= blocks->block_size;
+        *(void**) b = blocks->free_list;
+        blocks->free_list = b;
+    }
+}
+
+void* mem_blocks_alloc(mem_blocks_t *blocks)
+{
+    const UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    void *block = blocks->free_list;
+    if (NULL != block) {
+        blocks->free_list = *(void**) block;
+        if (--blocks->num_free < blocks->min_free) {
+            blocks->min_free = blocks->num_free;
+        }
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+
+    return block;
+}
+
+void mem_blocks_free(mem_blocks_t *blocks, void *block)
+{
+    if (mem_blocks_owns(blocks, block)) {
+        const UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+        *(void**) block = blocks->free_list;
+        blocks->free_list = block;
+        ++blocks->num_free;
+        portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+    }
+}
+
+bool mem_blocks_owns(const mem_blocks_t *blocks, const void *ptr)
+{
+    const uint8_t *p = (const uint8_t*) ptr;
+    return (p >= blocks->start && p < blocks->end && 0 == (p - blocks->start) % blocks->block_size);
+}
+
+uint16_t mem_blocks_get_free(const mem_blocks_t *blocks, uint16_t *pMinFree)
+{
+    if (NULL != pMinFree) {
+        *pMinFree = blocks->min_free;
+    }
+    return blocks->num_free;
+}
@@ -0,0 +1,182 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <string.h>
+
+#include "msg_buffer.h"
+#include "task.h"
+#include "LPC17xx.h"    // SCB->ICSR
+
+
+
+/**
+ * Compiler memory barrier that orders the copy of the data against the update of the index.
+ * This is sufficient on a single core CPU such as the Cortex-M3 (@see SPSC_RING_BARRIER()).
+ */
+#define MSG_BUFFER_BARRIER()    __asm volatile ("" ::: "memory")
+
+
+
+/// Copies the bytes into the ring at the free running offset, which may wrap around the end
+static void msg_buffer_copy_in(msg_buffer_t *mb, uint32_t at, const void *data, uint32_t len)
+{
+    const uint32_t index = at & mb->mask;
+    const uint32_t first = (len < mb->mask + 1 - index) ? len : (mb->mask + 1 - index);
+
+    memcpy(&mb->buffer[index], data, first);
+    memcpy(&mb->buffer[0], (const uint8_t*) data + first, len - first);
+}
+
+/// Copies the bytes out of the ring at the free running offset, which may wrap around the end
+static void msg_buffer_copy_out(const msg_buffer_t *mb, uint32_t at, void *data, uint32_t len)
+{
+    const uint32_t index = at & mb->mask;
+    const uint32_t first = (len < mb->mask + 1 - index) ? len : (mb->mask + 1 - index);
+
+    memcpy(data, &mb->buffer[index], first);
+    memcpy((uint8_t*) data + first, &mb->buffer[0], len - first);
+}
+
+/// Wakes up the reader after a write
+static void msg_buffer_signal(msg_buffer_t *mb)
+{
+    if (NULL == mb->signal || taskSCHEDULER_RUNNING != xTaskGetSchedulerState()) {
+        return;
+    }
+
+    if (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) {
+        BaseType_t woken = pdFALSE;
+        xSemaphoreGiveFromISR(mb->signal, &woken);
+        portEND_SWITCHING_ISR(woken);
+    }
+    else {
+        xSemaphoreGive(mb->signal);
+    }
+}
+
+
+
+bool msg_buffer_init(msg_buffer_t *mb, void *storage, uint32_t size, msg_buffer_mode_t mode, bool blocking)
+{
+    if (NULL == storage || size < 2 || 0 != (size & (size - 1))) {
+        return false;
+    }
+
+    memset(mb, 0, sizeof(*mb));
+    mb->buffer = (uint8_t*) storage;
+    mb->mask = size - 1;
+    mb->mode = mode;
+
+    if (blocking && NULL == (mb->signal = xSemaphoreCreateBinary())) {
+        return false;
+    }
+    return true;
+}
+
+uint32_t msg_buffer_write(msg_buffer_t *mb, const void *data, uint32_t len)
+{
+    const uint32_t head = mb->head;
+    const uint32_t space = msg_buffer_get_free(mb);
+
+    if (0 == len) {
+        return 0;
+    }
+
+    if (msg_buffer_stream == mb->mode) {
+        if (len > space) {
+            len = space;
+            ++mb->dropped;
+        }
+        if (0 == len) {
+            return 0;
+        }
+        msg_buffer_copy_in(mb, head, data, len);
+    }
+    else {
+        if (len > 0xFFFF || MSG_BUFFER_HDR_BYTES + len > space) {
+            ++mb->dropped;
+            return 0;
+        }
+        const uint8_t hdr[MSG_BUFFER_HDR_BYTES] = { (uint8_t) (len & 0xFF), (uint8_t) (len >> 8) };
+        msg_buffer_copy_in(mb, head, hdr, sizeof(hdr));
+        msg_buffer_copy_in(mb, head + sizeof(hdr), data, len);
+    }
+
+    /* Publish the record once it is completely written */
+    MSG_BUFFER_BARRIER();
+    mb->head = head + len + ((msg_buffer_packets == mb->mode) ? MSG_BUFFER_HDR_BYTES : 0);
+
+    msg_buffer_signal(mb);
+    return len;
+}
+
+uint32_t msg_buffer_next_len(const msg_buffer_t *mb)
+{
+    const uint32_t used = mb->head - mb->tail;
+
+    if (msg_buffer_stream == mb->mode || 0 == used) {
+        return used;
+    }
+
+    uint8_t hdr[MSG_BUFFER_HDR_BYTES];
+    msg_buffer_copy_out(mb, mb->tail, hdr, sizeof(hdr));
+    return hdr[0] | (hdr[1] << 8);
+}
+
+uint32_t msg_buffer_read(msg_buffer_t *mb, void *data, uint32_t max, uint32_t timeout_ms)
+{
+    const TickType_t start = xTaskGetTickCount();
+    const TickType_t ticks = (portMAX_DELAY == timeout_ms) ? portMAX_DELAY : OS_MS(timeout_ms);
+
+    /* The signal may have been given by an earlier write, so check again after each wake up */
+    while (msg_buffer_is_empty(mb))
+    {
+        const TickType_t elapsed = xTaskGetTickCount() - start;
+
+        if (NULL == mb->signal || 0 == ticks || taskSCHEDULER_RUNNING != xTaskGetSchedulerState() ||
+            (portMAX_DELAY != ticks && elapsed >= ticks)) {
+            return 0;
+        }
+        xSemaphoreTake(mb->signal, (portMAX_DELAY == ticks) ? portMAX_DELAY : (ticks - elapsed));
+    }
+
+    const uint32_t tail = mb->tail;
+    uint32_t len = msg_buffer_next_len(mb);
+    uint32_t skip = 0;
+
+    if (msg_buffer_packets == mb->mode) {
+        skip = MSG_BUFFER_HDR_BYTES;
+    }
+
+    /* The rest of a record that is longer than max is discarded */
+    const uint32_t consumed = skip + len;
+    if (len > max) {
+        len = max;
+    }
+    msg_buffer_copy_out(mb, tail + skip, data, len);
+
+    /* The copy is done before the space is given back to the writer */
+    MSG_BUFFER_BARRIER();
+    mb->tail = tail + ((msg_buffer_stream == mb->mode) ? len : consumed);
+    return len;
+}
+
+void msg_buffer_flush(msg_buffer_t *mb)
+{
+    mb->tail = mb->head;
+}
@@ -17,6 +17,8 @@
  */
 
 #include <stdarg.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>       // malloc(), realloc()
 #include <string.h>       // strlen()
@@ -102,3 +104,406 @@ char* mprintf(const char *format, ...)
     va_end(args);
     return str_ptr;
 }
+
+
+
+/// The formatter output, which is written to a buffer, or collected in a chunk and given to a function
+typedef struct {
+    fmt_write_func_t func;  ///< The output function, or NULL to write to the buffer
+    void *arg;              ///< The argument of the output function
+    char *buffer;           ///< The buffer if there is no output function
+    size_t size;            ///< The size of the buffer
+    size_t len;             ///< The number of chars formatted so far
+    uint8_t count;          ///< The number of chars in the chunk
+    char chunk[32];         ///< The chars not yet given to the output function
+} fmt_out_t;
+
+/// The flags, width and precision of a conversion
+typedef struct {
+    bool left;              ///< '-' flag
+    bool zero;              ///< '0' flag
+    bool alt;               ///< '#' flag
+    char sign;              ///< '+' or ' ' flag, or zero
+    int width;              ///< The minimum width
+    int precision;          ///< The precision, or -1 if none was given
+} fmt_spec_t;
+
+static void fmt_putc(fmt_out_t *out, char c)
+{
+    if (out->func) {
+        out->chunk[out->count++] = c;
+        if (out->count >= sizeof(out->chunk)) {
+            out->func(out->arg, out->chunk, out->count);
+            out->count = 0;
+        }
+    }
+    else if (out->len + 1 < out->size) {
+        out->buffer[out->len] = c;
+    }
+    out->len++;
+}
+
+static void fmt_repeat(fmt_out_t *out, char c, int count)
+{
+    while (count-- > 0) {
+        fmt_putc(out, c);
+    }
+}
+
+/**
+ * Writes the digits with the sign or prefix, and pads them to the width of the conversion
+ * @param zeros  The number of zeros before the digits for the precision of an integer
+ */
+static void fmt_field(fmt_out_t *out, const fmt_spec_t *spec, const char *prefix,
+                      const char *digits, int num_digits, int zeros)
+{
+    const int prefix_len = (int) strlen(prefix);
+    int pad = spec->width - (prefix_len + zeros + num_digits);
+
+    if (spec->zero && !spec->left) {
+        zeros += (pad > 0) ? pad : 0;
+        pad = 0;
+    }
+    if (!spec->left) {
+        fmt_repeat(out, ' ', pad);
+    }
+    while (*prefix) {
+        fmt_putc(out, *prefix++);
+    }
+    fmt_repeat(out, '0', zeros);
+    while (num_digits-- > 0) {
+        fmt_putc(out, *digits++);
+    }
+    if (spec->left) {
+        fmt_repeat(out, ' ', pad);
+    }
+}
+
+/// Converts the value to digits at the end of the buffer, and @returns the pointer to the first digit
+static char* fmt_utoa(char *end, uint64_t value, unsigned base, bool upper)
+{
+    const char *hex = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+
+    /* The 32-bit division is a single instruction, but the 64-bit division is a library call */
+    while (value > UINT32_MAX) {
+        *--end = hex[value % base];
+        value /= base;
+    }
+    uint32_t value32 = (uint32_t) value;
+    do {
+        *--end = hex[value32 % base];
+        value32 /= base;
+    } while (value32);
+
+    return end;
+}
+
+static void fmt_integer(fmt_out_t *out, fmt_spec_t *spec, uint64_t value, bool negative,
+                        unsigned base, bool upper)
+{
+    char digits[24];
+    char prefix[4] = { 0 };
+    char *end = &digits[sizeof(digits)];
+    char *first = end;
+    int num_digits = 0;
+    int zeros = 0;
+    int p = 0;
+
+    /* Zero with a precision of zero has no digits */
+    if (0 != value || 0 != spec->precision) {
+        first = fmt_utoa(end, value, base, upper);
+    }
+    num_digits = (int) (end - first);
+
+    if (negative) {
+        prefix[p++] = '-';
+    }
+    else if (spec->sign) {
+        prefix[p++] = spec->sign;
+    }
+    if (spec->alt && 16 == base && 0 != value) {
+        prefix[p++] = '0';
+        prefix[p++] = upper ? 'X' : 'x';
+    }
+    else if (spec->alt && 8 == base && '0' != *first) {
+        zeros = 1;
+    }
+
+    /* The precision is the minimum number of digits, and the '0' flag is ignored with a precision */
+    if (spec->precision >= 0) {
+        spec->zero = false;
+        if (spec->precision - num_digits > zeros) {
+            zeros = spec->precision - num_digits;
+        }
+    }
+
+    fmt_field(out, spec, prefix, first, num_digits, zeros);
+}
+
+/// The floats from this value are printed in the exponent form, since their integer part is beyond 64-bit integers
+#define FMT_FLOAT_MAX_FIXED     1e19
+
+/// Prints the float as a fixed-point number, or in the exponent form if it is FMT_FLOAT_MAX_FIXED or more
+static void fmt_float(fmt_out_t *out, fmt_spec_t *spec, double value)
+{
+    static const uint32_t pow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000,
+                                      10000000, 100000000, 1000000000 };
+    char digits[40];
+    char prefix[2] = { 0 };
+    char *end = &digits[20];
+    char *first = end;
+    int precision = (spec->precision < 0) ? 6 : spec->precision;
+    int exponent = 0;
+    int i = 0;
+
+    if (precision > 9) {
+        precision = 9;
+    }
+    if (value < 0) {
+        prefix[0] = '-';
+        value = -value;
+    }
+    else if (spec->sign) {
+        prefix[0] = spec->sign;
+    }
+
+    if (__builtin_isnan(value) || __builtin_isinf(value)) {
+        spec->zero = false;
+        fmt_field(out, spec, prefix, __builtin_isnan(value) ? "nan" : "inf", 3, 0);
+        return;
+    }
+
+    /* The large values are scaled to a single integer digit, and the rounding may carry into a second one */
+    if (value >= FMT_FLOAT_MAX_FIXED) {
+        for (; value >= 1e10; exponent += 10) {
+            value /= 1e10;
+        }
+        for (; value >= 10.0; exponent++) {
+            value /= 10.0;
+        }
+        if (value + (0.5 / pow10[precision]) >= 10.0) {
+            value /= 10.0;
+            exponent++;
+        }
+    }
+
+    value += 0.5 / pow10[precision];
+    const uint64_t integer = (uint64_t) value;
+    uint32_t fraction = (uint32_t) ((value - (double) integer) * pow10[precision]);
+    if (fraction >= pow10[precision]) {
+        fraction = pow10[precision] - 1;
+    }
+
+    /* The integer digits end where the fraction digits start */
+    first = fmt_utoa(end, integer, 10, false);
+    if (precision > 0 || spec->alt) {
+        *end++ = '.';
+    }
+    for (i = precision - 1; i >= 0; i--) {
+        end[i] = '0' + (fraction % 10);
+        fraction /= 10;
+    }
+    end += precision;
+
+    if (exponent > 0) {
+        *end++ = 'e';
+        *end++ = '+';
+        if (exponent >= 100) {
+            *end++ = '0' + (exponent / 100);
+        }
+        *end++ = '0' + ((exponent / 10) % 10);
+        *end++ = '0' + (exponent % 10);
+    }
+
+    fmt_field(out, spec, prefix, first, (int) (end - first), 0);
+}
+
+static int fmt_format(fmt_out_t *out, const char *format, va_list args)
+{
+    while (*format)
+    {
+        fmt_spec_t spec = { false, false, false, 0, 0, -1 };
+        char length = 0;
+        bool is_long_long = false;
+
+        if ('%' != *format) {
+            fmt_putc(out, *format++);
+            continue;
+        }
+        const char *conversion_start = format++;
+
+        /* Flags */
+        for (;; format++) {
+            if      ('-' == *format) { spec.left = true;  }
+            else if ('0' == *format) { spec.zero = true;  }
+            else if ('#' == *format) { spec.alt  = true;  }
+            else if ('+' == *format) { spec.sign = '+';   }
+            else if (' ' == *format) { spec.sign = spec.sign ? spec.sign : ' '; }
+            else break;
+        }
+
+        /* Width and precision */
+        if ('*' == *format) {
+            spec.width = va_arg(args, int);
+            if (spec.width < 0) {
+                spec.left = true;
+                spec.width = -spec.width;
+            }
+            format++;
+        }
+        while (*format >= '0' && *format <= '9') {
+            spec.width = (spec.width * 10) + (*format++ - '0');
+        }
+        if ('.' == *format) {
+            format++;
+            spec.precision = 0;
+            if ('*' == *format) {
+                spec.precision = va_arg(args, int);
+                format++;
+            }
+            while (*format >= '0' && *format <= '9') {
+                spec.precision = (spec.precision * 10) + (*format++ - '0');
+            }
+        }
+
+        /* Length modifiers */
+        while ('h' == *format || 'l' == *format || 'z' == *format || 'j' == *format ||
+               't' == *format || 'L' == *format) {
+            is_long_long = is_long_long || ('j' == *format) || ('l' == *format && 'l' == length);
+            length = *format++;
+        }
+
+        const char conversion = *format++;
+        switch (conversion)
+        {
+            case 'd':
+            case 'i':
+            {
+                int64_t value = 0;
+                if      (is_long_long)   { value = va_arg(args, long long); }
+                else if ('l' == length)  { value = va_arg(args, long); }
+                else if ('z' == length)  { value = (int) va_arg(args, size_t); }
+                else if ('t' == length)  { value = va_arg(args, ptrdiff_t); }
+                else                     { value = va_arg(args, int); }
+                if ('h' == length)       { value = (short) value; }
+
+                const uint64_t magnitude = (value < 0) ? (0 - (uint64_t) value) : (uint64_t) value;
+                fmt_integer(out, &spec, magnitude, value < 0, 10, false);
+                break;
+            }
+
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+            {
+                uint64_t value = 0;
+                if      (is_long_long)   { value = va_arg(args, unsigned long long); }
+                else if ('l' == length)  { value = va_arg(args, unsigned long); }
+                else if ('z' == length)  { value = va_arg(args, size_t); }
+                else if ('t' == length)  { value = (unsigned) va_arg(args, ptrdiff_t); }
+                else                     { value = va_arg(args, unsigned int); }
+                if ('h' == length)       { value = (unsigned short) value; }
+
+                const unsigned base = ('u' == conversion) ? 10 : ('o' == conversion) ? 8 : 16;
+                fmt_integer(out, &spec, value, false, base, 'X' == conversion);
+                break;
+            }
+
+            case 'p':
+                spec.alt = true;
+                fmt_integer(out, &spec, (uintptr_t) va_arg(args, void*), false, 16, false);
+                break;
+
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+                fmt_float(out, &spec, va_arg(args, double));
+                break;
+
+            case 'c':
+            {
+                const char c = (char) va_arg(args, int);
+                spec.zero = false;
+                fmt_field(out, &spec, "", &c, 1, 0);
+                break;
+            }
+
+            case 's':
+            {
+                const char *str = va_arg(args, const char*);
+                int len = 0;
+                if (!str) {
+                    str = "(null)";
+                }
+                while (str[len] && (spec.precision < 0 || len < spec.precision)) {
+                    len++;
+                }
+                spec.zero = false;
+                fmt_field(out, &spec, "", str, len, 0);
+                break;
+            }
+
+            case '%':
+                fmt_putc(out, '%');
+                break;
+
+            default:
+                /* Unsupported conversion is printed as it is */
+                format = (conversion) ? format : (format - 1);
+                while (conversion_start < format) {
+                    fmt_putc(out, *conversion_start++);
+                }
+                break;
+        }
+    }
+
+    if (out->func && out->count > 0) {
+        out->func(out->arg, out->chunk, out->count);
+        out->count = 0;
+    }
+    if (!out->func && out->size > 0) {
+        out->buffer[(out->len < out->size) ? out->len : (out->size - 1)] = '\0';
+    }
+
+    return (int) out->len;
+}
+
+int fmt_vprint(fmt_write_func_t func, void *arg, const char *format, va_list args)
+{
+    fmt_out_t out;
+    out.func = func;
+    out.arg = arg;
+    out.buffer = NULL;
+    out.size = 0;
+    out.len = 0;
+    out.count = 0;
+
+    return func ? fmt_format(&out, format, args) : 0;
+}
+
+int fmt_vsnprintf(char *buffer, size_t size, const char *format, va_list args)
+{
+    fmt_out_t out;
+    out.func = NULL;
+    out.arg = NULL;
+    out.buffer = buffer;
+    out.size = buffer ? size : 0;
+    out.len = 0;
+    out.count = 0;
+
+    return fmt_format(&out, format, args);
+}
+
+int fmt_snprintf(char *buffer, size_t size, const char *format, ...)
+{
+    int len = 0;
+    va_list args;
+    va_start(args, format);
+    len = fmt_vsnprintf(buffer, size, format, args);
+    va_end(args);
+    return len;
+}
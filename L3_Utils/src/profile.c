@@ -0,0 +1,127 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <string.h>
+
+#include "profile.h"
+#include "LPC17xx.h"    // __LDREXW() and __STREXW()
+
+
+
+#if (PROFILE_ENABLE)
+/// The table of the sites, and the number of sites taken from it
+static profile_site_t g_profile_sites[PROFILE_MAX_SITES];
+static uint32_t g_profile_count = 0;
+
+
+
+/**
+ * @{ Updates a word without a critical section using the exclusive access instructions,
+ * so the sites can be used by the tasks of any priority and by the interrupts.
+ */
+static inline uint32_t profile_atomic_add(uint32_t *word, const uint32_t value)
+{
+    uint32_t sum;
+    do {
+        sum = __LDREXW(word) + value;
+    } while (__STREXW(sum, word));
+    return sum;
+}
+static inline void profile_atomic_min(uint32_t *word, const uint32_t value)
+{
+    do {
+        if (value >= __LDREXW(word)) {
+            __CLREX();
+            break;
+        }
+    } while (__STREXW(value, word));
+}
+static inline void profile_atomic_max(uint32_t *word, const uint32_t value)
+{
+    do {
+        if (value <= __LDREXW(word)) {
+            __CLREX();
+            break;
+        }
+    } while (__STREXW(value, word));
+}
+/** @} */
+
+profile_site_t* profile_add_site(const char *name)
+{
+    uint32_t index;
+    do {
+        index = __LDREXW(&g_profile_count);
+        if (index >= PROFILE_MAX_SITES) {
+            __CLREX();
+            return NULL;
+        }
+    } while (__STREXW(index + 1, &g_profile_count));
+
+    profile_site_t *site = &g_profile_sites[index];
+    site->name = name;
+    site->min_cycles = UINT32_MAX;
+    return site;
+}
+
+void profile_end(profile_scope_t *scope)
+{
+    const uint32_t cycles = sys_get_cycles() - scope->start;
+    profile_site_t *site = scope->site;
+    if (NULL == site) {
+        return;
+    }
+
+    /* The carry of the low word is added to the high word */
+    profile_atomic_add(&site->count, 1);
+    if (profile_atomic_add(&site->total_lo, cycles) < cycles) {
+        profile_atomic_add(&site->total_hi, 1);
+    }
+    profile_atomic_min(&site->min_cycles, cycles);
+    profile_atomic_max(&site->max_cycles, cycles);
+
+    /* The number of bits of (cycles - 1) is N for a run of more than 2^(N-1) and up to 2^N cycles */
+    const uint32_t bits = (cycles > 1) ? (32 - __builtin_clz(cycles - 1)) : 0;
+    uint32_t bucket = (bits > PROFILE_HIST_MIN_BITS) ? (bits - PROFILE_HIST_MIN_BITS) : 0;
+    if (bucket >= PROFILE_HIST_BUCKETS) {
+        bucket = PROFILE_HIST_BUCKETS - 1;
+    }
+    profile_atomic_add(&site->hist[bucket], 1);
+}
+
+uint32_t profile_get_count(void)
+{
+    return g_profile_count;
+}
+
+const profile_site_t* profile_get_site(uint32_t index)
+{
+    return (index < g_profile_count) ? &g_profile_sites[index] : NULL;
+}
+
+void profile_reset(void)
+{
+    for (uint32_t i = 0; i < g_profile_count; i++) {
+        profile_site_t *site = &g_profile_sites[i];
+        const char *name = site->name;
+        memset(site, 0, sizeof(*site));
+        site->name = name;
+        site->min_cycles = UINT32_MAX;
+    }
+}
+#endif /* PROFILE_ENABLE */
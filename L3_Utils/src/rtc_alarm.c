@@ -21,6 +21,7 @@
 #include "rtc_alarm.h"
 #include "rtc.h"
 #include "c_list.h"
+#include "mem_arena.h"
 #include "LPC17xx.h"
 
 
@@ -32,10 +33,31 @@
 typedef struct {
     SemaphoreHandle_t *pAlarm;  ///< Semaphore that is given when alarm is triggered
     alarm_time_t time;          ///< The time that triggers the alarm
+    c_ilist_node node;          ///< Node of g_list_timed_alarms
 } sem_alarm_t;
 
-static c_list_ptr g_list_timed_alarms = 0;        ///< Alarms for a specified time
-static c_list_ptr g_list_recur_alarms[4] = { 0 }; ///< Recurring alarms, such as "every second"
+static c_ilist g_list_timed_alarms = C_ILIST_INIT; ///< Alarms for a specified time
+static c_list_ptr g_list_recur_alarms[4] = { 0 };  ///< Recurring alarms, such as "every second"
+
+/// The timed alarms are allocated from a pool, and from the heap once the pool is used up
+#define RTC_ALARM_POOL_COUNT    8
+static uint8_t g_alarm_pool_mem[MEM_BLOCKS_BYTES(sizeof(sem_alarm_t), RTC_ALARM_POOL_COUNT)];
+static mem_blocks_t g_alarm_pool;
+static bool g_alarm_pool_ready = false;
+
+/** @{ RTC registers */
+#define RTC_ILR_COUNTER     (1 << 0)    ///< ILR bit of the increment (every second) interrupt
+#define RTC_ILR_ALARM       (1 << 1)    ///< ILR bit of the alarm interrupt
+#define RTC_AMR_DISABLED    (0xFF)      ///< AMR that masks all fields, which disables the alarm
+#define RTC_AMR_DATE_TIME   ((1 << 4) | (1 << 5))   ///< AMR that compares all fields except DOW and DOY
+/** @} */
+
+#define SECONDS_PER_DAY     (24 * 60 * 60)  ///< Seconds in a day
+#define DAYS_0000_TO_1970   719468          ///< Days from 0000-03-01 to 1970-01-01 (of the civil calendar)
+#define DOW_OF_1970         dow_thu         ///< Day of the week of 1970-01-01
+
+static rtc_job_t *g_job_heap[RTC_JOB_MAX];  ///< The started jobs, as a heap sorted by the next run time
+static uint8_t g_job_count = 0;             ///< The number of jobs in g_job_heap[]
 
 static void rtc_enable_intr(void)
 {
@@ -57,23 +79,222 @@ static bool for_each_recur_alarm_callback(void *item, void *arg1, void *arg2, vo
     return 1;
 }
 
-static bool for_each_alarm_callback(void *item, void *arg1, void *arg2, void *arg3)
+static void check_timed_alarm(const sem_alarm_t *a, const rtc_t *time, long *do_yield)
 {
-    const rtc_t time = rtc_gettime();
-    sem_alarm_t *a = (sem_alarm_t*)item;
-
-    if(a->time.hour == time.hour &&
-       a->time.min == time.min &&
-       a->time.sec == time.sec)
+    if(a->time.hour == time->hour &&
+       a->time.min == time->min &&
+       a->time.sec == time->sec)
     {
-        long *do_yield = arg1;
         long switch_required = 0;
         xSemaphoreGiveFromISR(*(a->pAlarm), &switch_required);
         if (switch_required) {
             *do_yield |= 1;
         }
     }
-    return 1;
+}
+
+
+
+
+/** @{ The heap of the jobs is used by the tasks and the RTC interrupt */
+static inline uint32_t rtc_job_lock(void)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+}
+static inline void rtc_job_unlock(const uint32_t primask)
+{
+    __set_PRIMASK(primask);
+}
+/** @} */
+
+/// @returns the days since 1970 of the date (the civil calendar algorithm with the year starting on March 1st)
+static uint32_t rtc_job_days_from_date(uint32_t year, const uint32_t month, const uint32_t day)
+{
+    year -= (month <= 2);
+    const uint32_t era = year / 400;
+    const uint32_t yoe = year - (era * 400);
+    const uint32_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const uint32_t doe = (yoe * 365) + (yoe / 4) - (yoe / 100) + doy;
+    return (era * 146097) + doe - DAYS_0000_TO_1970;
+}
+
+/// Converts the days since 1970 to the date; this is the reverse of rtc_job_days_from_date()
+static void rtc_job_date_from_days(uint32_t days, uint32_t *year, uint32_t *month, uint32_t *day)
+{
+    days += DAYS_0000_TO_1970;
+    const uint32_t era = days / 146097;
+    const uint32_t doe = days - (era * 146097);
+    const uint32_t yoe = (doe - (doe / 1460) + (doe / 36524) - (doe / 146096)) / 365;
+    const uint32_t doy = doe - ((yoe * 365) + (yoe / 4) - (yoe / 100));
+    const uint32_t mp = (5 * doy + 2) / 153;
+
+    *day = doy - (153 * mp + 2) / 5 + 1;
+    *month = (mp < 10) ? (mp + 3) : (mp - 9);
+    *year = (yoe + era * 400) + (*month <= 2);
+}
+
+/// @returns the RTC time in seconds since 1970
+static uint32_t rtc_job_get_seconds(const rtc_t *time)
+{
+    return (rtc_job_days_from_date(time->year, time->month, time->day) * SECONDS_PER_DAY) +
+           (time->hour * 3600) + (time->min * 60) + time->sec;
+}
+
+/// @returns the first run time of the job after the given time, or 0 if the job never runs
+static uint32_t rtc_job_get_next_run(const rtc_job_t *job, const uint32_t after)
+{
+    const uint32_t days = after / SECONDS_PER_DAY;
+    const uint32_t time_of_hour = (job->time.min * 60) + job->time.sec;
+    const uint32_t time_of_day = (job->time.hour * 3600) + time_of_hour;
+    uint32_t next = 0;
+    uint32_t i = 0;
+
+    switch (job->repeat)
+    {
+        case alarm_hourly:
+            next = after - (after % 3600) + time_of_hour;
+            return (next > after) ? next : (next + 3600);
+
+        case alarm_once:
+        case alarm_daily:
+            next = (days * SECONDS_PER_DAY) + time_of_day;
+            return (next > after) ? next : (next + SECONDS_PER_DAY);
+
+        case alarm_weekly:
+            for (i = 0; i <= 7; i++) {
+                next = ((days + i) * SECONDS_PER_DAY) + time_of_day;
+                if (next > after && (job->dow_mask & (1 << ((days + i + DOW_OF_1970) % 7)))) {
+                    return next;
+                }
+            }
+            return 0;
+
+        default:
+            return 0;
+    }
+}
+
+/** @{ Heap of the started jobs, with the earliest next run time at g_job_heap[0] */
+static void rtc_job_heap_set(const uint8_t index, rtc_job_t *job)
+{
+    g_job_heap[index] = job;
+    job->heap_index = index;
+}
+
+static void rtc_job_heap_up(uint8_t index)
+{
+    rtc_job_t *job = g_job_heap[index];
+    while (index > 0) {
+        const uint8_t parent = (index - 1) / 2;
+        if (g_job_heap[parent]->next <= job->next) {
+            break;
+        }
+        rtc_job_heap_set(index, g_job_heap[parent]);
+        index = parent;
+    }
+    rtc_job_heap_set(index, job);
+}
+
+static void rtc_job_heap_down(uint8_t index)
+{
+    rtc_job_t *job = g_job_heap[index];
+    while (1) {
+        uint8_t child = (2 * index) + 1;
+        if (child >= g_job_count) {
+            break;
+        }
+        if (child + 1 < g_job_count && g_job_heap[child + 1]->next < g_job_heap[child]->next) {
+            child++;
+        }
+        if (job->next <= g_job_heap[child]->next) {
+            break;
+        }
+        rtc_job_heap_set(index, g_job_heap[child]);
+        index = child;
+    }
+    rtc_job_heap_set(index, job);
+}
+
+static void rtc_job_heap_remove(rtc_job_t *job)
+{
+    const uint8_t index = job->heap_index;
+    rtc_job_t *last = g_job_heap[--g_job_count];
+
+    job->heap_index = RTC_JOB_MAX;
+    if (last != job) {
+        rtc_job_heap_set(index, last);
+        rtc_job_heap_up(index);
+        rtc_job_heap_down(last->heap_index);
+    }
+}
+
+static void rtc_job_heap_insert(rtc_job_t *job)
+{
+    rtc_job_heap_set(g_job_count++, job);
+    rtc_job_heap_up(job->heap_index);
+}
+/** @} */
+
+/**
+ * Programs the RTC alarm to the first job, or disables the alarm if there are no jobs.
+ * The alarm only matches the exact second, so if that second has already passed, the
+ * interrupt is set pending to run the job.
+ */
+static void rtc_job_set_alarm(void)
+{
+    uint32_t year = 0, month = 0, day = 0;
+
+    if (0 == g_job_count) {
+        LPC_RTC->AMR = RTC_AMR_DISABLED;
+        return;
+    }
+
+    const uint32_t next = g_job_heap[0]->next;
+    rtc_job_date_from_days(next / SECONDS_PER_DAY, &year, &month, &day);
+
+    LPC_RTC->AMR = RTC_AMR_DISABLED;
+    LPC_RTC->ALSEC  = next % 60;
+    LPC_RTC->ALMIN  = (next / 60) % 60;
+    LPC_RTC->ALHOUR = (next / 3600) % 24;
+    LPC_RTC->ALDOM  = day;
+    LPC_RTC->ALMON  = month;
+    LPC_RTC->ALYEAR = year;
+    LPC_RTC->AMR = RTC_AMR_DATE_TIME;
+
+    const rtc_t now = rtc_gettime();
+    if (rtc_job_get_seconds(&now) >= next) {
+        NVIC_SetPendingIRQ(RTC_IRQn);
+    }
+}
+
+/// Runs the jobs that are due at the given time, starts the repeating jobs again, and programs the alarm
+static void rtc_job_run_due(const rtc_t *time, long *do_yield)
+{
+    const uint32_t now = rtc_job_get_seconds(time);
+    uint32_t primask = rtc_job_lock();
+
+    while (g_job_count > 0 && g_job_heap[0]->next <= now)
+    {
+        rtc_job_t *job = g_job_heap[0];
+        rtc_job_heap_remove(job);
+
+        /* The next run is after this run, so a late run does not repeat the runs it missed */
+        if (alarm_once != job->repeat && 0 != (job->next = rtc_job_get_next_run(job, now))) {
+            rtc_job_heap_insert(job);
+        }
+
+        /* The callback can start or stop the jobs */
+        rtc_job_unlock(primask);
+        if (job->callback(job->arg)) {
+            *do_yield |= 1;
+        }
+        primask = rtc_job_lock();
+    }
+
+    rtc_job_set_alarm();
+    rtc_job_unlock(primask);
 }
 
 
@@ -84,7 +305,7 @@ void rtc_alarm_create_recurring(alarm_freq_t freq, SemaphoreHandle_t *pAlarm)
     if(pAlarm && freq >= everySecond && freq <= everyDay)
     {
         if (!g_list_recur_alarms[freq]) {
-            g_list_recur_alarms[freq] = c_list_create();
+            g_list_recur_alarms[freq] = c_list_create_pooled(4);
             rtc_enable_intr();
         }
         if (NULL != pAlarm) {
@@ -99,15 +320,15 @@ alarm_time_t* rtc_alarm_create(alarm_time_t time, SemaphoreHandle_t *pAlarm)
         return NULL;
     }
 
-    if (NULL == g_list_timed_alarms) {
-        g_list_timed_alarms = c_list_create();
-        rtc_enable_intr();
-    }
-    if (NULL == g_list_timed_alarms) {
-        return NULL;
+    if (!g_alarm_pool_ready) {
+        g_alarm_pool_ready = true;
+        mem_blocks_init(&g_alarm_pool, g_alarm_pool_mem, sizeof(sem_alarm_t), RTC_ALARM_POOL_COUNT);
     }
 
-    sem_alarm_t *pNewAlarm = (sem_alarm_t*) malloc(sizeof(sem_alarm_t));
+    sem_alarm_t *pNewAlarm = (sem_alarm_t*) mem_blocks_alloc(&g_alarm_pool);
+    if (NULL == pNewAlarm) {
+        pNewAlarm = (sem_alarm_t*) malloc(sizeof(sem_alarm_t));
+    }
     if (NULL == pNewAlarm) {
         return NULL;
     }
@@ -117,35 +338,118 @@ alarm_time_t* rtc_alarm_create(alarm_time_t time, SemaphoreHandle_t *pAlarm)
     pNewAlarm->time.sec  = time.sec;
     pNewAlarm->pAlarm = pAlarm;
 
-    if (!c_list_insert_elm_end(g_list_timed_alarms, pNewAlarm)) {
-        free(pNewAlarm);
-        return NULL;
-    }
+    /* The alarm is fully initialized before the RTC interrupt can see it in the list */
+    c_ilist_insert_end(&g_list_timed_alarms, &(pNewAlarm->node));
+    rtc_enable_intr();
 
     return &(pNewAlarm->time);
 }
 
+void rtc_job_init(rtc_job_t *job, alarm_time_t time, alarm_repeat_t repeat, uint8_t dow_mask,
+                  rtc_job_callback_t callback, void *arg)
+{
+    job->time = time;
+    job->repeat = repeat;
+    job->dow_mask = dow_mask;
+    job->heap_index = RTC_JOB_MAX;
+    job->next = 0;
+    job->callback = callback;
+    job->arg = arg;
+}
+
+bool rtc_job_start(rtc_job_t *job)
+{
+    const rtc_t time = rtc_gettime();
+    const uint32_t next = rtc_job_get_next_run(job, rtc_job_get_seconds(&time));
+    bool ok = false;
+
+    if (job->time.hour >= 24 || job->time.min >= 60 || job->time.sec >= 60 || 0 == next) {
+        return false;
+    }
+
+    const uint32_t primask = rtc_job_lock();
+    if (rtc_job_is_started(job)) {
+        rtc_job_heap_remove(job);
+    }
+    if (g_job_count < RTC_JOB_MAX) {
+        job->next = next;
+        rtc_job_heap_insert(job);
+        rtc_job_set_alarm();
+        ok = true;
+    }
+    rtc_job_unlock(primask);
+
+    NVIC_EnableIRQ(RTC_IRQn);
+    return ok;
+}
+
+void rtc_job_stop(rtc_job_t *job)
+{
+    const uint32_t primask = rtc_job_lock();
+    if (rtc_job_is_started(job)) {
+        rtc_job_heap_remove(job);
+        rtc_job_set_alarm();
+    }
+    rtc_job_unlock(primask);
+}
+
+void rtc_job_time_changed(void)
+{
+    const rtc_t time = rtc_gettime();
+    const uint32_t now = rtc_job_get_seconds(&time);
+    const uint32_t primask = rtc_job_lock();
+    uint8_t i = 0;
+
+    /* A heap of the new run times is built from the bottom up */
+    for (i = 0; i < g_job_count; i++) {
+        g_job_heap[i]->next = rtc_job_get_next_run(g_job_heap[i], now);
+    }
+    for (i = g_job_count / 2; i > 0; i--) {
+        rtc_job_heap_down(i - 1);
+    }
+    rtc_job_set_alarm();
+    rtc_job_unlock(primask);
+}
+
+bool rtc_job_give_semaphore(void *sem)
+{
+    long woken = 0;
+    xSemaphoreGiveFromISR((SemaphoreHandle_t) sem, &woken);
+    return (0 != woken);
+}
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 void RTC_IRQHandler(void)
 {
-    LPC_RTC->ILR |= (1 << 0); // Clear Increment Interrupt
+    /* Clear only the interrupts we handle (writing 1 clears), so an alarm is not lost */
+    const uint8_t flags = LPC_RTC->ILR & (RTC_ILR_COUNTER | RTC_ILR_ALARM);
+    LPC_RTC->ILR = flags;
     long do_yield = 0;
 
     const rtc_t time = rtc_gettime();
-    c_list_for_each_elm(g_list_recur_alarms[everySecond], for_each_recur_alarm_callback, &do_yield, NULL, NULL);
-    if(0 == time.sec) {
-        c_list_for_each_elm(g_list_recur_alarms[everyMinute], for_each_recur_alarm_callback, &do_yield, NULL, NULL);
-        if(0 == time.min) {
-            c_list_for_each_elm(g_list_recur_alarms[everyHour], for_each_recur_alarm_callback, &do_yield, NULL, NULL);
-            if(0 == time.hour) {
-                c_list_for_each_elm(g_list_recur_alarms[everyDay], for_each_recur_alarm_callback, &do_yield, NULL, NULL);
+
+    /* The jobs are also run if the interrupt was set pending by rtc_job_set_alarm() */
+    rtc_job_run_due(&time, &do_yield);
+
+    /* The alarms of rtc_alarm_create() and rtc_alarm_create_recurring() are checked every second */
+    if (flags & RTC_ILR_COUNTER) {
+        c_list_for_each_elm(g_list_recur_alarms[everySecond], for_each_recur_alarm_callback, &do_yield, NULL, NULL);
+        if(0 == time.sec) {
+            c_list_for_each_elm(g_list_recur_alarms[everyMinute], for_each_recur_alarm_callback, &do_yield, NULL, NULL);
+            if(0 == time.min) {
+                c_list_for_each_elm(g_list_recur_alarms[everyHour], for_each_recur_alarm_callback, &do_yield, NULL, NULL);
+                if(0 == time.hour) {
+                    c_list_for_each_elm(g_list_recur_alarms[everyDay], for_each_recur_alarm_callback, &do_yield, NULL, NULL);
+                }
             }
         }
-    }
 
-    c_list_for_each_elm(g_list_timed_alarms, for_each_alarm_callback, &do_yield, NULL, NULL);
+        for (const c_ilist_node *n = g_list_timed_alarms.head; NULL != n; n = n->next) {
+            check_timed_alarm(C_ILIST_ELM(n, sem_alarm_t, node), &time, &do_yield);
+        }
+    }
     portEND_SWITCHING_ISR(do_yield);
 }
 #ifdef __cplusplus
@@ -27,6 +27,9 @@
 #include "scheduler_task.hpp"
 #include "FreeRTOS.h"
 #include "semphr.h"
+#include "lpc_sys.h"    // sys_get_uptime_us()
+#include "channel.hpp"
+#include "file_logger.h"
 
 #include "c_tlm_comp.h"
 #include "c_tlm_var.h"
@@ -41,14 +44,8 @@ static SemaphoreHandle_t gRunTaskSemaphore = 0;  ///< Semaphore for a task to pr
 
 
 
-/// Linked list of the tasks
-typedef struct task_list {
-    scheduler_task *task;   ///< The pointer to the task
-    task_list *next;        ///< The next link
-} task_list_t;
-
-/// The instance of scheduler task list
-static task_list_t *gpTaskList = NULL;
+/// The instance of scheduler task list linked through scheduler_task::mpNextTask
+static scheduler_task *gpTaskList = NULL;
 
 
 
@@ -60,19 +57,50 @@ typedef struct {
 } ptr_enum_pair_t;
 
 /// Pair of a pointer and name used by getSharedObject() and addSharedObject()
-typedef struct ptr_name_pair {
+typedef struct {
     void *obj_ptr;              ///< The pointer
     const char *name;           ///< The name of the pointer
-    struct ptr_name_pair *next; ///< Pointer to the next linked list element
+    uint32_t hash;              ///< The hash of the name
 } ptr_name_pair_t;
 
 /// Instance of shared object by index
 static ptr_enum_pair_t gEnumObjects = { 0, 0 };
 
-/// Instance of shared objects by string name
-static ptr_name_pair_t *gpNamePairList = NULL;
+/**
+ * Hash table of shared objects by string name, which doesn't need any heap
+ * and finds an object in constant time.  This must be a power of two.
+ */
+static ptr_name_pair_t gNamePairTable[SCHEDULER_SHARED_NAME_SLOTS];
 /** @} */
 
+/// @returns FNV-1a hash of the name
+static uint32_t shared_name_hash(const char *name)
+{
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash ^= (uint8_t) *name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @returns the slot of the name in gNamePairTable using linear probing, which is
+ *          either the slot with this name or the first empty slot.  NULL is
+ *          returned if the name is not found and the table is full.
+ */
+static ptr_name_pair_t* shared_name_slot(const char *name, uint32_t hash)
+{
+    const uint32_t mask = SCHEDULER_SHARED_NAME_SLOTS - 1;
+    for (uint32_t i = 0; i < SCHEDULER_SHARED_NAME_SLOTS; i++) {
+        ptr_name_pair_t *e = &gNamePairTable[(hash + i) & mask];
+        if (NULL == e->name || (hash == e->hash && 0 == strcmp(e->name, name))) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
 
 
 /**
@@ -82,6 +110,13 @@ static ptr_name_pair_t *gpNamePairList = NULL;
  * WE PURPOSELY DO NOT USE printf() because it uses a lot of stack space.
  * puts() uses very little stack space.
  */
+/// The CPU accounting, sampled by gCpuTimer
+static scheduler_cpu_t gCpu;
+static TimerHandle_t gCpuTimer = 0;
+
+/// The weights of a new sample of the moving averages, shifted by 16 bits: 1 - e^(-1/N) of N samples
+static const uint32_t gCpuWeightQ16[scheduler_cpu_avgs] = { 65536, 6237, 1083 };
+
 static bool g_dbg_print = false;
 static void dbg_print(const char *one, const char *two=NULL)
 {
@@ -127,10 +162,10 @@ void scheduler_c_task_private(void *task_ptr)
         dbg_print(task.mName, " task calling taskEntry() for all tasks ... ");
         dbg_print("*  Each task will then enter the run() loop\n");
 
-        task_list_t *e = gpTaskList;
+        scheduler_task *e = gpTaskList;
         while (NULL != e) {
-            scheduler_task *t = e->task;
-            e = e->next;
+            scheduler_task *t = e;
+            e = e->mpNextTask;
             ++taskCount;
 
             if (!t->taskEntry()) {
@@ -156,15 +191,56 @@ void scheduler_c_task_private(void *task_ptr)
 
     TickType_t xLastWakeTime = xTaskGetTickCount();
     TickType_t xNextStatTime = xTaskGetTickCount();
+    uint32_t lastRunStartUs = 0;
+    uint32_t deadlineUs = 0;
+    bool deadlineSet = false;
 
     for (;;)
     {
+        const uint32_t blockStartUs = sys_get_uptime_us();
+
+        if (task.mEventSem) {
+            xSemaphoreTake(task.mEventSem, task.mEventBlockTime);
+
+            // Consume the pending bits atomically since ISRs may notify in between
+            taskENTER_CRITICAL();
+            task.mEventBits = task.mPendingEventBits;
+            task.mPendingEventBits = 0;
+            taskEXIT_CRITICAL();
+        }
         #if (0 != configUSE_QUEUE_SETS)
-        if (task.mQueueSet) {
+        else if (task.mQueueSet) {
             task.mQueueSetType = xQueueSelectFromSet(task.mQueueSet, task.mQueueSetBlockTime);
         }
         #endif
 
+        const uint32_t runStartUs = sys_get_uptime_us();
+        scheduler_profile_t &prof = task.mProfile;
+        if (task.mEventSem
+        #if (0 != configUSE_QUEUE_SETS)
+            || task.mQueueSet
+        #endif
+           ) {
+            prof.blockedUs += (runStartUs - blockStartUs);
+        }
+
+        // Jitter is the deviation of the run() start time against the requested period
+        if (task.mTaskDelayMs && !task.mEventSem && 0 != task.mRunCount) {
+            const int32_t jitterUs = (int32_t)(runStartUs - lastRunStartUs) - (int32_t)(task.mTaskDelayMs * 1000);
+            const uint32_t absJitterUs = (jitterUs < 0) ? -jitterUs : jitterUs;
+            if (absJitterUs > prof.jitterMaxUs) {
+                prof.jitterMaxUs = absJitterUs;
+            }
+        }
+        lastRunStartUs = runStartUs;
+
+        // The deadlines follow the wake up times of vTaskDelayUntil(), which does not slip after an overrun
+        const bool periodic = (task.mTaskDelayMs && !task.mEventSem);
+        if (periodic) {
+            deadlineUs = (deadlineSet ? deadlineUs : runStartUs) + (task.mTaskDelayMs * 1000);
+        }
+        deadlineSet = periodic;
+
         // Run the task code and suspend when an error occurs
         if (!task.run((void*)task.mParam)) {
             printline(task.mName, " --> FAILURE detected; suspending this task ...");
@@ -172,6 +248,37 @@ void scheduler_c_task_private(void *task_ptr)
         }
         ++(task.mRunCount);
 
+        // Update the run() duration statistics
+        prof.runLastUs = sys_get_uptime_us() - runStartUs;
+        if (prof.runLastUs > prof.runMaxUs) {
+            prof.runMaxUs = prof.runLastUs;
+        }
+        uint32_t bucket = 0;
+        for (uint32_t limit = 10; bucket < (SCHEDULER_PROFILE_HIST_BUCKETS - 1) && prof.runLastUs >= limit; limit *= 10) {
+            ++bucket;
+        }
+        ++(prof.runHist[bucket]);
+
+        // Check the deadline of a periodic run()
+        if (periodic) {
+            const int32_t latenessUs = (int32_t) (runStartUs + prof.runLastUs - deadlineUs);
+            if (latenessUs > 0) {
+                ++(prof.deadlineMisses);
+                if ((uint32_t) latenessUs > prof.latenessMaxUs) {
+                    prof.latenessMaxUs = latenessUs;
+                }
+                if (++(prof.missStreak) > prof.missStreakMax) {
+                    prof.missStreakMax = prof.missStreak;
+                }
+                if (prof.missStreak == task.mDeadlineMissLimit) {
+                    task.onDeadlineMiss(prof.missStreak, latenessUs);
+                }
+            }
+            else {
+                prof.missStreak = 0;
+            }
+        }
+
         // Update the task statistics once in a short while :
         if (0 != task.mStatUpdateRateMs && xTaskGetTickCount() > xNextStatTime) {
             xNextStatTime = xTaskGetTickCount() + (task.mStatUpdateRateMs / MS_PER_TICK());
@@ -180,13 +287,104 @@ void scheduler_c_task_private(void *task_ptr)
             task.mFreeStack *= sizeof(int);
         }
 
-        // Delay if set
-        if (task.mTaskDelayMs) {
+        // Delay if set (event mode blocks on the event semaphore instead)
+        if (task.mTaskDelayMs && !task.mEventSem) {
             vTaskDelayUntil( &xLastWakeTime, OS_MS(task.mTaskDelayMs));
         }
     }
 }
 
+/// Updates the moving averages with a sample in hundredths of a percent
+static void scheduler_cpu_average(uint32_t *avgQ16, uint16_t *avg, const uint32_t sample)
+{
+    for (uint32_t i = 0; i < scheduler_cpu_avgs; i++) {
+        const int64_t diff = ((int64_t) sample << 16) - avgQ16[i];
+        avgQ16[i] += (int32_t) ((diff * gCpuWeightQ16[i]) >> 16);
+        avg[i] = (avgQ16[i] + (1 << 15)) >> 16;
+    }
+}
+
+/**
+ * The timer callback that samples the run-time counters of all the tasks
+ * @note This runs in the timer task, and the tasks are sampled with the scheduler suspended
+ */
+void scheduler_cpu_sample(TimerHandle_t timer)
+{
+    (void) timer;
+    static TaskStatus_t status[SCHEDULER_CPU_MAX_TASKS];
+    uint32_t totalRunTime = 0;
+    const UBaseType_t count = uxTaskGetSystemState(&status[0], SCHEDULER_CPU_MAX_TASKS, &totalRunTime);
+
+    /* Skip the sample if the counters were reset since the last sample (the total time went backwards) */
+    const uint32_t elapsed = totalRunTime - gCpu.lastTotalRunTime;
+    const bool valid = (gCpu.samples > 0 && elapsed > 0 && elapsed <= 4 * SCHEDULER_CPU_SAMPLE_MS * 1000);
+    gCpu.lastTotalRunTime = totalRunTime;
+
+    bool seen[SCHEDULER_CPU_MAX_TASKS] = { false };
+    uint32_t idleCpu = 0;
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskStatus_t *s = &status[i];
+
+        /* Find the task, or take an unused entry for it */
+        scheduler_cpu_task_t *t = NULL;
+        scheduler_cpu_task_t *unused = NULL;
+        for (uint32_t j = 0; j < SCHEDULER_CPU_MAX_TASKS && NULL == t; j++) {
+            if (s->xTaskNumber == gCpu.tasks[j].number) {
+                t = &gCpu.tasks[j];
+                seen[j] = true;
+            }
+            else if (0 == gCpu.tasks[j].number && NULL == unused) {
+                unused = &gCpu.tasks[j];
+            }
+        }
+        if (NULL == t) {
+            if (NULL != unused) {
+                memset(unused, 0, sizeof(*unused));
+                strncpy(unused->name, s->pcTaskName, sizeof(unused->name) - 1);
+                unused->number = s->xTaskNumber;
+                unused->lastRunTime = s->ulRunTimeCounter;
+                unused->pTask = scheduler_task::getTaskPtrByName(s->pcTaskName);
+                seen[unused - &gCpu.tasks[0]] = true;
+            }
+            continue;
+        }
+
+        const uint32_t delta = s->ulRunTimeCounter - t->lastRunTime;
+        t->lastRunTime = s->ulRunTimeCounter;
+        if (valid) {
+            const uint32_t sample = (delta >= elapsed) ? 10000 : (uint32_t) (((uint64_t) delta * 10000) / elapsed);
+            scheduler_cpu_average(t->avgQ16, t->cpu, sample);
+            if (t->pTask) {
+                memcpy(t->pTask->mCpu, t->cpu, sizeof(t->cpu));
+            }
+            if (s->xHandle == xTaskGetIdleTaskHandle()) {
+                idleCpu = sample;
+            }
+        }
+    }
+
+    /* The tasks that were deleted free their entries */
+    for (uint32_t j = 0; j < SCHEDULER_CPU_MAX_TASKS && count > 0; j++) {
+        if (!seen[j]) {
+            gCpu.tasks[j].number = 0;
+        }
+    }
+
+    if (valid) {
+        static uint32_t sysAvgQ16[scheduler_cpu_avgs];
+        const uint32_t sysCpu = 10000 - idleCpu;
+        scheduler_cpu_average(sysAvgQ16, gCpu.sysCpu, sysCpu);
+        gCpu.history[gCpu.historyPos] = sysCpu / 100;
+        gCpu.historyPos = (gCpu.historyPos + 1) % SCHEDULER_CPU_HISTORY;
+    }
+    ++gCpu.samples;
+}
+
+const scheduler_cpu_t& scheduler_get_cpu(void)
+{
+    return gCpu;
+}
+
 bool scheduler_init_all(bool register_internal_tlm)
 {
     bool failure = false;
@@ -201,22 +399,25 @@ bool scheduler_init_all(bool register_internal_tlm)
 
     dbg_print("*  Creating tasks ...\n");
     do {
-        task_list_t *e = gpTaskList;
+        scheduler_task *e = gpTaskList;
         while (NULL != e) {
             ++taskCount;
-            scheduler_task *task = e->task;
-            e = e->next;
+            scheduler_task *task = e;
+            e = e->mpNextTask;
 
             UBaseType_t taskPriority = task->mPriority;
 #if BUILD_CFG_MPU
             taskPriority |= portPRIVILEGE_BIT;
 #endif
-            if (!xTaskCreate(scheduler_c_task_private,
-                             task->mName,                    /* Name  */
-                             STACK_BYTES(task->mStackSize),  /* Stack */
-                             task,                           /* Task param    */
-                             taskPriority,                   /* Task priority */
-                             &(task->mHandle)))              /* Task Handle   */
+            /* Stack is allocated from the heap unless the task provides a static stack */
+            if (!xTaskGenericCreate(scheduler_c_task_private,
+                                    task->mName,                    /* Name  */
+                                    STACK_BYTES(task->mStackSize),  /* Stack */
+                                    task,                           /* Task param    */
+                                    taskPriority,                   /* Task priority */
+                                    &(task->mHandle),               /* Task Handle   */
+                                    task->mpStackBuffer,            /* Stack memory  */
+                                    NULL))                          /* MPU regions   */
             {
                 printline(task->mName, "  --> FAILED xTaskCreate()");
                 failure = true;
@@ -230,14 +431,20 @@ bool scheduler_init_all(bool register_internal_tlm)
         failure = true;
     }
 
+    /* The channels are created before the tasks' init() that may use them */
+    if (!channel_base::initAll()) {
+        printline("ERROR: Creating the channels");
+        failure = true;
+    }
+
     /* Initialize all tasks */
     dbg_print("*  Initializing tasks ...\n");
     do {
-        task_list_t *e = gpTaskList;
+        scheduler_task *e = gpTaskList;
         while (NULL != e)
         {
-            scheduler_task *task = e->task;
-            e = e->next;
+            scheduler_task *task = e;
+            e = e->mpNextTask;
 
             if (!task->init()) {
                 printline(task->getTaskName(), "  --> FAILED init()");
@@ -250,11 +457,25 @@ bool scheduler_init_all(bool register_internal_tlm)
     #if SYS_CFG_ENABLE_TLM
     dbg_print("*  Registering tasks' telemetry ...\n");
     do {
-        task_list_t *e = gpTaskList;
+        /* The system CPU accounting; the tasks register their own CPU averages below */
+        if (register_internal_tlm) {
+            tlm_component *cpu = tlm_component_add("cpu");
+            if (!tlm_variable_register(cpu, "sys_cpu_x100", &(gCpu.sysCpu[0]),
+                 sizeof(gCpu.sysCpu[0]), scheduler_cpu_avgs, tlm_uint) ||
+                !tlm_variable_register(cpu, "history", &(gCpu.history[0]),
+                 sizeof(gCpu.history[0]), SCHEDULER_CPU_HISTORY, tlm_uint) ||
+                !tlm_variable_register(cpu, "history_pos", &(gCpu.historyPos),
+                 sizeof(gCpu.historyPos), 1, tlm_uint)) {
+                printline("cpu", "  --> FAILED telemetry registration");
+                failure = true;
+            }
+        }
+
+        scheduler_task *e = gpTaskList;
         while (NULL != e)
         {
-            scheduler_task *task = e->task;
-            e = e->next;
+            scheduler_task *task = e;
+            e = e->mpNextTask;
 
             if (!task->regTlm()) {
                 failure = true;
@@ -271,6 +492,29 @@ bool scheduler_init_all(bool register_internal_tlm)
                      sizeof(task->mRunCount), 1, tlm_uint)) {
                     failure = true;
                 }
+                if (!tlm_variable_register(comp, "cpu_x100", &(task->mCpu[0]),
+                     sizeof(task->mCpu[0]), scheduler_cpu_avgs, tlm_uint)) {
+                    failure = true;
+                }
+
+                /* Register the run loop profile */
+                scheduler_profile_t *prof = &(task->mProfile);
+                if (!tlm_variable_register(comp, "run_max_us", &(prof->runMaxUs),
+                     sizeof(prof->runMaxUs), 1, tlm_uint) ||
+                    !tlm_variable_register(comp, "jitter_max_us", &(prof->jitterMaxUs),
+                     sizeof(prof->jitterMaxUs), 1, tlm_uint) ||
+                    !tlm_variable_register(comp, "blocked_us", &(prof->blockedUs),
+                     sizeof(prof->blockedUs), 1, tlm_uint) ||
+                    !tlm_variable_register(comp, "run_hist", &(prof->runHist[0]),
+                     sizeof(prof->runHist[0]), SCHEDULER_PROFILE_HIST_BUCKETS, tlm_uint) ||
+                    !tlm_variable_register(comp, "deadline_misses", &(prof->deadlineMisses),
+                     sizeof(prof->deadlineMisses), 1, tlm_uint) ||
+                    !tlm_variable_register(comp, "lateness_max_us", &(prof->latenessMaxUs),
+                     sizeof(prof->latenessMaxUs), 1, tlm_uint) ||
+                    !tlm_variable_register(comp, "miss_streak_max", &(prof->missStreakMax),
+                     sizeof(prof->missStreakMax), 1, tlm_uint)) {
+                    failure = true;
+                }
             }
             if (failure) {
                 printline(task->mName, "  --> FAILED telemetry registration");
@@ -281,7 +525,10 @@ bool scheduler_init_all(bool register_internal_tlm)
         // Restore telemetry registered by "disk" component
         FILE *fd = fopen(SYS_CFG_DISK_TLM_NAME, "r");
         if (fd) {
-            tlm_stream_decode_file(fd);
+            // Disk telemetry is saved in binary, but older files may be in ASCII stream format
+            if (!tlm_stream_decode_binary_file(fd)) {
+                tlm_stream_decode_file(fd);
+            }
             fclose(fd);
         }
     } while (0);
@@ -295,10 +542,10 @@ bool scheduler_init_all(bool register_internal_tlm)
      */
     do {
         uint32_t highestStack = 0;
-        task_list_t *e = gpTaskList;
+        scheduler_task *e = gpTaskList;
         while (NULL != e) {
-            scheduler_task *task = e->task;
-            e = e->next;
+            scheduler_task *task = e;
+            e = e->mpNextTask;
 
             if (task->mStackSize > highestStack) {
                 highestStack = task->mStackSize;
@@ -315,12 +562,8 @@ void scheduler_add_task(scheduler_task* task)
     if (NULL != task)
     {
         /* Insert new task at the beginning */
-        task_list_t *newEntry = new task_list_t;
-        if (NULL != newEntry) {
-            newEntry->next = gpTaskList;
-            newEntry->task = task;
-            gpTaskList = newEntry;
-        }
+        task->mpNextTask = gpTaskList;
+        gpTaskList = task;
     }
 }
 
@@ -337,6 +580,12 @@ void scheduler_start(bool dp, bool register_internal_tlm)
          * task won't report incorrect CPU usage.
          */
         vTaskResetRunTimeStats();
+
+        /* Start the CPU accounting of the tasks */
+        gCpuTimer = xTimerCreate("cpu", OS_MS(SCHEDULER_CPU_SAMPLE_MS), pdTRUE, 0, scheduler_cpu_sample);
+        if (NULL == gCpuTimer || !xTimerStart(gCpuTimer, 0)) {
+            printline("ERROR: Failed to start the CPU accounting");
+        }
         vTaskStartScheduler();
 
         // vTaskStartScheduler() should not return
@@ -355,6 +604,15 @@ scheduler_task::scheduler_task(const char *name, uint32_t stack, uint8_t priorit
    mQueueSetType(0),
    mQueueSetBlockTime(1000),
 #endif
+   mEventSem(0),
+   mPendingEventBits(0),
+   mEventBits(0),
+   mEventBlockTime(portMAX_DELAY),
+   mProfile(),
+   mDeadlineMissLimit(SCHEDULER_DEADLINE_MISS_LIMIT),
+   mCpu(),
+   mpNextTask(0),
+   mpStackBuffer(0),
    mHandle(0),
    mFreeStack(0),
    mRunCount(0),
@@ -368,6 +626,46 @@ scheduler_task::scheduler_task(const char *name, uint32_t stack, uint8_t priorit
 
 }
 
+bool scheduler_task::enableEventMode(TickType_t blockTime)
+{
+    if (NULL == mEventSem) {
+        mEventSem = xSemaphoreCreateBinary();
+    }
+    mEventBlockTime = blockTime;
+    return (NULL != mEventSem);
+}
+
+void scheduler_task::notify(uint32_t bits)
+{
+    if (mEventSem) {
+        taskENTER_CRITICAL();
+        mPendingEventBits |= bits;
+        taskEXIT_CRITICAL();
+        xSemaphoreGive(mEventSem);
+    }
+}
+
+void scheduler_task::notifyFromISR(uint32_t bits, BaseType_t *pHigherPriorityTaskWoken)
+{
+    if (mEventSem) {
+        const UBaseType_t savedMask = portSET_INTERRUPT_MASK_FROM_ISR();
+        mPendingEventBits |= bits;
+        portCLEAR_INTERRUPT_MASK_FROM_ISR(savedMask);
+        xSemaphoreGiveFromISR(mEventSem, pHigherPriorityTaskWoken);
+    }
+}
+
+void scheduler_task::onDeadlineMiss(uint32_t consecutive, uint32_t latenessUs)
+{
+    LOG_WARN("Task %s missed %u deadlines of %u ms, the last one by %u us", mName,
+             (unsigned) consecutive, (unsigned) mTaskDelayMs, (unsigned) latenessUs);
+}
+
+void scheduler_task::resetProfile(void)
+{
+    memset(&mProfile, 0, sizeof(mProfile));
+}
+
 uint8_t scheduler_task::getTaskCpuPercent(void) const
 {
     return uxTaskGetCpuUsage(getTaskHandle());
@@ -409,10 +707,10 @@ void scheduler_task::initQueueSet(uint32_t queueSetSize, uint32_t count, ...)
  */
 scheduler_task* scheduler_task::getTaskPtrByName(const char *name)
 {
-    task_list_t *e = gpTaskList;
+    scheduler_task *e = gpTaskList;
     while (NULL != e) {
-        scheduler_task *task = e->task;
-        e = e->next;
+        scheduler_task *task = e;
+        e = e->mpNextTask;
 
         if (0 == strcmp(name, task->getTaskName())) {
             return task;
@@ -428,25 +726,16 @@ bool scheduler_task::addSharedObject(const char *name, void *obj_ptr)
     if (NULL != name && NULL != obj_ptr)
     {
         /* Disallow adding duplicate items by name */
-        ptr_name_pair_t *e = gpNamePairList;
-        while (NULL != e) {
-            if (0 == strcmp(e->name, name)) {
-                break;
-            }
-            e = e->next;
-        }
+        const uint32_t hash = shared_name_hash(name);
+        ptr_name_pair_t *e = shared_name_slot(name, hash);
 
-        /* e must be NULL if not a duplicate */
-        if (NULL == e) {
-            ptr_name_pair_t *newEntry = new ptr_name_pair_t;
-            if (NULL != newEntry) {
-                ok = true;
+        /* e must be an empty slot if not a duplicate */
+        if (NULL != e && NULL == e->name) {
+            ok = true;
 
-                newEntry->name    = name;
-                newEntry->obj_ptr = obj_ptr;
-                newEntry->next    = gpNamePairList;
-                gpNamePairList = newEntry;
-            }
+            e->name    = name;
+            e->obj_ptr = obj_ptr;
+            e->hash    = hash;
         }
     }
 
@@ -455,18 +744,8 @@ bool scheduler_task::addSharedObject(const char *name, void *obj_ptr)
 
 void* scheduler_task::getSharedObject(const char *name)
 {
-    void *ret = NULL;
-
-    ptr_name_pair_t *e = gpNamePairList;
-    while (NULL != e) {
-        if (0 == strcmp(e->name, name)) {
-            ret = e->obj_ptr;
-            break;
-        }
-        e = e->next;
-    }
-
-    return ret;
+    ptr_name_pair_t *e = shared_name_slot(name, shared_name_hash(name));
+    return (NULL != e) ? e->obj_ptr : NULL;
 }
 
 bool scheduler_task::addSharedObject(uint8_t index, void *obj)
@@ -0,0 +1,415 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <string.h>
+#include "stream_file.h"
+#include "fat/disk/diskio.h"
+
+
+
+/// The zeros that fill the clusters of a new run
+static const BYTE g_zeros[_MAX_SS] = { 0 };
+
+
+
+/**
+ * Maps the clusters of the file to write its sectors directly.
+ * If the file has too many fragments, the data is written through FatFs instead.
+ */
+static FRESULT stream_file_map(stream_file_t *sf)
+{
+    FRESULT status = FR_OK;
+
+    sf->direct = false;
+    if (sf->allocated > 0) {
+        sf->clmt[0] = sizeof(sf->clmt) / sizeof(sf->clmt[0]);
+
+        /* f_write() cannot extend a file with a fast seek table, so the table is only given for CREATE_LINKMAP */
+        sf->file.cltbl = sf->clmt;
+        status = f_lseek(&sf->file, CREATE_LINKMAP);
+        sf->file.cltbl = NULL;
+
+        sf->direct = (FR_OK == status);
+        if (FR_NOT_ENOUGH_CORE == status) {
+            status = FR_OK;
+        }
+    }
+    return status;
+}
+
+/// @returns the disk sector of the given sector of the file, which is mapped by stream_file_map()
+static DWORD stream_file_get_sector(const stream_file_t *sf, uint32_t file_sector)
+{
+    const FATFS *fs = sf->file.fs;
+    const DWORD *item = &sf->clmt[1];
+
+    for ( ; 0 != item[0]; item += 2) {
+        const uint32_t sectors = item[0] * fs->csize;
+        if (file_sector < sectors) {
+            return fs->database + (item[1] - 2) * fs->csize + file_sector;
+        }
+        file_sector -= sectors;
+    }
+
+    /* The file size is checked by the caller, so this is not reached */
+    return 0;
+}
+
+/**
+ * Finds the end of the data by skipping the zeros of the run at the end of the file,
+ * and reads the data of the last sector to sf->sector.
+ */
+static FRESULT stream_file_find_end(stream_file_t *sf)
+{
+    FRESULT status = FR_OK;
+    uint32_t end = sf->allocated;
+    UINT bytes = 0;
+
+    while (end > 0)
+    {
+        const uint32_t start = (end - 1) - ((end - 1) % _MAX_SS);
+        if (FR_OK != (status = f_lseek(&sf->file, start)) ||
+            FR_OK != (status = f_read(&sf->file, sf->sector, end - start, &bytes))) {
+            return status;
+        }
+
+        while (bytes > 0 && 0 == sf->sector[bytes - 1]) {
+            bytes--;
+        }
+        if (bytes > 0) {
+            end = start + bytes;
+            break;
+        }
+        end = start;
+    }
+
+    memset(&sf->sector[bytes], 0, sizeof(sf->sector) - bytes);
+    sf->size = end;
+    return status;
+}
+
+/// Reads the data of the last sector to sf->sector, which is re-written by stream_file_write()
+static FRESULT stream_file_read_tail(stream_file_t *sf)
+{
+    FRESULT status = FR_OK;
+    const uint32_t offset = sf->size % _MAX_SS;
+    UINT bytes = 0;
+
+    memset(sf->sector, 0, sizeof(sf->sector));
+    if (sf->direct && offset > 0) {
+        sf->file.dsect = 0;
+        if (FR_OK == (status = f_lseek(&sf->file, sf->size - offset)) &&
+            FR_OK == (status = f_read(&sf->file, sf->sector, offset, &bytes))) {
+            status = (bytes == offset) ? FR_OK : FR_INT_ERR;
+        }
+    }
+    return status;
+}
+
+/// @returns true if the disk reads the erased sectors as zeros, so the run can be erased instead of written
+static bool stream_file_erases_to_zero(const stream_file_t *sf)
+{
+    BYTE erased = 0xFF;
+    return (RES_OK == disk_ioctl(sf->file.fs->drv, CTRL_GET_ERASED_BYTE, &erased) && 0 == erased);
+}
+
+/// Erases the sectors of the file from the first up to the end sector, which are mapped by stream_file_map()
+static bool stream_file_erase(const stream_file_t *sf, uint32_t first, const uint32_t end)
+{
+    const FATFS *fs = sf->file.fs;
+    const DWORD *item = &sf->clmt[1];
+    uint32_t fragment = 0;
+
+    for ( ; 0 != item[0] && first < end; item += 2) {
+        const uint32_t fragment_end = fragment + item[0] * fs->csize;
+        if (first < fragment_end) {
+            const DWORD base = fs->database + (item[1] - 2) * fs->csize - fragment;
+            const uint32_t last = (end < fragment_end) ? end : fragment_end;
+            DWORD range[2] = { base + first, base + last - 1 };
+
+            if (RES_OK != disk_ioctl(fs->drv, CTRL_ERASE_SECTOR, range)) {
+                return false;
+            }
+            first = last;
+        }
+        fragment = fragment_end;
+    }
+    return (first >= end);
+}
+
+/// Writes the zeros from the end of the allocated part of the file up to the given end
+static FRESULT stream_file_zero_fill(stream_file_t *sf, const uint32_t end)
+{
+    FRESULT status = FR_OK;
+    UINT bytes = 0;
+
+    if (FR_OK == (status = f_lseek(&sf->file, sf->allocated)))
+    {
+        while (sf->allocated < end)
+        {
+            uint32_t chunk = _MAX_SS - (sf->allocated % _MAX_SS);
+            if (chunk > end - sf->allocated) {
+                chunk = end - sf->allocated;
+            }
+            status = f_write(&sf->file, g_zeros, chunk, &bytes);
+            sf->allocated += bytes;
+            if (FR_OK != status || bytes != chunk) {
+                status = (FR_OK == status) ? FR_DENIED : status;
+                break;
+            }
+        }
+    }
+    return status;
+}
+
+/**
+ * Grows the file by a run of zero filled clusters such that it has room for the given size.
+ * This is the only time the FAT and the directory entry are written while the file is open.
+ *
+ * If the disk reads the erased sectors as zeros, such as most SD cards, the clusters are
+ * allocated by seeking past the end of the file and the whole sectors of the run are erased,
+ * which is much faster than writing the zeros, and the card does not copy them at the next write.
+ */
+static FRESULT stream_file_grow(stream_file_t *sf, const uint32_t needed)
+{
+    FRESULT status = FR_OK;
+    const uint32_t cluster_bytes = sf->file.fs->csize * _MAX_SS;
+    const uint32_t end = ((needed + sf->prealloc_bytes + cluster_bytes - 1) / cluster_bytes) * cluster_bytes;
+
+    /* The sectors written by stream_file_write() did not go through the window of the file */
+    sf->file.dsect = 0;
+
+    if (stream_file_erases_to_zero(sf))
+    {
+        uint32_t first = ((sf->allocated + _MAX_SS - 1) / _MAX_SS) * _MAX_SS;
+        if (first > end) {
+            first = end;
+        }
+
+        /* The partial sector is written, and the clusters of the file are allocated up to the end */
+        if (FR_OK == (status = stream_file_zero_fill(sf, first)) &&
+            FR_OK == (status = f_lseek(&sf->file, end)) && end == f_tell(&sf->file) &&
+            FR_OK == (status = f_sync(&sf->file)) &&
+            FR_OK == (status = stream_file_map(sf)) &&
+            sf->direct && stream_file_erase(sf, first / _MAX_SS, end / _MAX_SS))
+        {
+            sf->allocated = end;
+            sf->file.dsect = 0;
+        }
+    }
+
+    /* Otherwise the zeros are written, which also re-writes the allocated sectors that were not erased */
+    if (FR_OK == status && sf->allocated < end) {
+        status = stream_file_zero_fill(sf, end);
+    }
+
+    if (FR_OK == status) {
+        status = f_sync(&sf->file);
+    }
+    if (FR_OK == status) {
+        status = stream_file_map(sf);
+    }
+    return (FR_OK == status) ? stream_file_read_tail(sf) : status;
+}
+
+/// Writes the data through FatFs, which is used if the file has too many fragments to be mapped
+static FRESULT stream_file_write_fatfs(stream_file_t *sf, const void *data, uint32_t len)
+{
+    FRESULT status = FR_OK;
+    UINT bytes = 0;
+
+    sf->file.dsect = 0;
+    if (FR_OK == (status = f_lseek(&sf->file, sf->size)) &&
+        FR_OK == (status = f_write(&sf->file, data, len, &bytes)))
+    {
+        status = (bytes == len) ? FR_OK : FR_DENIED;
+    }
+
+    sf->size += bytes;
+    if (sf->size > sf->allocated) {
+        sf->allocated = f_size(&sf->file);
+    }
+    return status;
+}
+
+FRESULT stream_file_open(stream_file_t *sf, const char *filename, uint32_t prealloc_bytes)
+{
+    FRESULT status = FR_OK;
+
+    memset(sf, 0, sizeof(*sf));
+    sf->prealloc_bytes = prealloc_bytes;
+
+    if (FR_OK != (status = f_open(&sf->file, filename, FA_OPEN_ALWAYS | FA_READ | FA_WRITE))) {
+        return status;
+    }
+
+    sf->allocated = f_size(&sf->file);
+    if (FR_OK == (status = stream_file_find_end(sf))) {
+        status = stream_file_map(sf);
+    }
+
+    if (FR_OK == status) {
+        sf->opened = true;
+    }
+    else {
+        f_close(&sf->file);
+    }
+    return status;
+}
+
+/// Writes the partial sector at the end of the data, which stream_file_append() keeps in sf->sector
+static FRESULT stream_file_write_tail(stream_file_t *sf)
+{
+    if (sf->tail_dirty) {
+        const DWORD sector = stream_file_get_sector(sf, sf->size / _MAX_SS);
+        if (RES_OK != disk_write(sf->file.fs->drv, sf->sector, sector, 1)) {
+            return FR_DISK_ERR;
+        }
+        sf->tail_dirty = false;
+    }
+    return FR_OK;
+}
+
+FRESULT stream_file_append(stream_file_t *sf, const void *data, uint32_t len)
+{
+    FRESULT status = FR_OK;
+    const BYTE *p = (const BYTE*) data;
+
+    if (!sf->opened) {
+        return FR_INVALID_OBJECT;
+    }
+
+    /* The growth may change the map of the sectors, and reads back the last sector */
+    if (sf->size + len > sf->allocated &&
+        (FR_OK != (status = stream_file_write_tail(sf)) || FR_OK != (status = stream_file_grow(sf, sf->size + len)))) {
+        return status;
+    }
+
+    sf->unsynced = true;
+    if (!sf->direct) {
+        return stream_file_write_fatfs(sf, data, len);
+    }
+
+    while (len > 0)
+    {
+        const uint32_t offset = sf->size % _MAX_SS;
+        const DWORD sector = stream_file_get_sector(sf, sf->size / _MAX_SS);
+        uint32_t chunk = _MAX_SS - offset;
+        const BYTE *src = sf->sector;
+
+        if (chunk > len) {
+            chunk = len;
+        }
+
+        /* A whole sector is written from the data, otherwise the data is copied to the last sector */
+        if (_MAX_SS == chunk) {
+            src = p;
+        }
+        else {
+            if (0 == offset) {
+                memset(sf->sector, 0, sizeof(sf->sector));
+            }
+            memcpy(&sf->sector[offset], p, chunk);
+        }
+
+        /* The last sector is written once it is full, or by stream_file_sync() */
+        sf->tail_dirty = (offset + chunk < _MAX_SS);
+        if (!sf->tail_dirty && RES_OK != disk_write(sf->file.fs->drv, src, sector, 1)) {
+            return FR_DISK_ERR;
+        }
+
+        sf->size += chunk;
+        p += chunk;
+        len -= chunk;
+    }
+
+    return status;
+}
+
+FRESULT stream_file_sync(stream_file_t *sf)
+{
+    FRESULT status = FR_OK;
+
+    if (!sf->opened) {
+        return FR_INVALID_OBJECT;
+    }
+    if (!sf->unsynced) {
+        return FR_OK;
+    }
+
+    if (!sf->direct) {
+        status = f_sync(&sf->file);
+    }
+    /* The disk may cache the sector writes, so the data is on the disk after the sync */
+    else if (FR_OK == (status = stream_file_write_tail(sf))) {
+        status = (RES_OK == disk_ioctl(sf->file.fs->drv, CTRL_SYNC, NULL)) ? FR_OK : FR_DISK_ERR;
+    }
+
+    if (FR_OK == status) {
+        sf->unsynced = false;
+    }
+    return status;
+}
+
+FRESULT stream_file_write(stream_file_t *sf, const void *data, uint32_t len)
+{
+    const FRESULT status = stream_file_append(sf, data, len);
+    return (FR_OK == status) ? stream_file_sync(sf) : status;
+}
+
+FRESULT stream_file_truncate(stream_file_t *sf)
+{
+    FRESULT status = FR_OK;
+
+    if (!sf->opened) {
+        return FR_INVALID_OBJECT;
+    }
+
+    sf->file.dsect = 0;
+    if (FR_OK == (status = f_lseek(&sf->file, 0)) &&
+        FR_OK == (status = f_truncate(&sf->file)) &&
+        FR_OK == (status = f_sync(&sf->file)))
+    {
+        sf->size = 0;
+        sf->allocated = 0;
+        sf->direct = false;
+        sf->tail_dirty = false;
+        sf->unsynced = false;
+        memset(sf->sector, 0, sizeof(sf->sector));
+    }
+    return status;
+}
+
+FRESULT stream_file_close(stream_file_t *sf)
+{
+    FRESULT status = FR_OK;
+
+    if (!sf->opened) {
+        return FR_INVALID_OBJECT;
+    }
+
+    sf->file.dsect = 0;
+    if (FR_OK == (status = stream_file_sync(sf)) &&
+        FR_OK == (status = f_lseek(&sf->file, sf->size))) {
+        status = f_truncate(&sf->file);
+    }
+
+    const FRESULT close_status = f_close(&sf->file);
+    sf->opened = false;
+    return (FR_OK == status) ? close_status : status;
+}
@@ -0,0 +1,140 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include "timer_wheel.h"
+
+
+
+/// The mask of the slot index of a tick
+#define TIMER_WHEEL_SLOT_MASK   (TIMER_WHEEL_SLOTS - 1)
+
+#if (0 != (TIMER_WHEEL_SLOTS & TIMER_WHEEL_SLOT_MASK))
+#error "TIMER_WHEEL_SLOTS must be a power of 2"
+#endif
+
+/// @returns the slot of the given time
+static inline uint32_t timer_wheel_get_slot(const uint32_t time)
+{
+    return (time >> TIMER_WHEEL_TICK_SHIFT) & TIMER_WHEEL_SLOT_MASK;
+}
+
+/// Adds the timer to the front of the list
+static inline void timer_wheel_link(timer_wheel_timer_t **head, timer_wheel_timer_t *timer)
+{
+    timer->next = *head;
+    if (timer->next) {
+        timer->next->pprev = &timer->next;
+    }
+    timer->pprev = head;
+    *head = timer;
+}
+
+/// Adds the timer to the slot of its deadline, or to the current slot if the deadline has passed
+static void timer_wheel_insert(timer_wheel_t *wheel, timer_wheel_timer_t *timer)
+{
+    const bool passed = ((int32_t) (timer->deadline - wheel->now) < 0);
+    timer_wheel_link(&wheel->slots[timer_wheel_get_slot(passed ? wheel->now : timer->deadline)], timer);
+}
+
+void timer_wheel_init(timer_wheel_t *wheel, uint32_t now)
+{
+    uint32_t i = 0;
+    for (i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        wheel->slots[i] = NULL;
+    }
+    wheel->now = now;
+}
+
+void timer_wheel_timer_init(timer_wheel_timer_t *timer, timer_wheel_callback_t callback, void *arg)
+{
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->deadline = 0;
+    timer->callback = callback;
+    timer->arg = arg;
+}
+
+bool timer_wheel_start(timer_wheel_t *wheel, timer_wheel_timer_t *timer, uint32_t now, uint32_t timeout)
+{
+    if (timeout > TIMER_WHEEL_MAX_TIMEOUT) {
+        return false;
+    }
+
+    timer_wheel_stop(timer);
+    timer->deadline = now + timeout;
+    timer_wheel_insert(wheel, timer);
+    return true;
+}
+
+void timer_wheel_stop(timer_wheel_timer_t *timer)
+{
+    if (timer->pprev) {
+        *(timer->pprev) = timer->next;
+        if (timer->next) {
+            timer->next->pprev = timer->pprev;
+        }
+        timer->next = NULL;
+        timer->pprev = NULL;
+    }
+}
+
+uint32_t timer_wheel_service(timer_wheel_t *wheel, uint32_t now)
+{
+    const uint32_t first_slot = timer_wheel_get_slot(wheel->now);
+    uint32_t ticks = (now >> TIMER_WHEEL_TICK_SHIFT) - (wheel->now >> TIMER_WHEEL_TICK_SHIFT);
+    uint32_t expired = 0;
+    uint32_t i = 0;
+
+    /* The rollover of the time is also a rollover of the ticks shifted out of it */
+    ticks &= (UINT32_MAX >> TIMER_WHEEL_TICK_SHIFT);
+
+    /* Each slot is visited at most once, even if the wheel was not serviced for more than a turn */
+    if (ticks >= TIMER_WHEEL_SLOTS) {
+        ticks = TIMER_WHEEL_SLOTS - 1;
+    }
+
+    for (i = 0; i <= ticks; i++)
+    {
+        timer_wheel_timer_t **head = &wheel->slots[(first_slot + i) & TIMER_WHEEL_SLOT_MASK];
+        timer_wheel_timer_t *pending = *head;
+        timer_wheel_timer_t *timer = NULL;
+
+        /* Detach the slot, so the timers started by the callbacks are not visited again by this loop */
+        *head = NULL;
+        if (pending) {
+            pending->pprev = &pending;
+        }
+
+        while (NULL != (timer = pending))
+        {
+            timer_wheel_stop(timer);
+
+            if ((int32_t) (timer->deadline - now) <= 0) {
+                ++expired;
+                timer->callback(timer, timer->arg);
+            }
+            else {
+                /* The deadline is one or more turns away, or later within the current tick */
+                timer_wheel_link(head, timer);
+            }
+        }
+    }
+
+    wheel->now = now;
+    return expired;
+}
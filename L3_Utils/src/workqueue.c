@@ -0,0 +1,236 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <stddef.h>
+
+#include "workqueue.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "LPC17xx.h"    // SCB->ICSR
+#include "lpc_sys.h"    // sys_get_uptime_ms()
+
+
+
+/**
+ * The message posted to a worker.  An item without a delayed item is run right away, otherwise
+ * the delayed item is scheduled with the function, or canceled if there is no function.
+ */
+typedef struct {
+    work_func_t func;
+    void *ctx;
+    work_delayed_t *work;
+    uint32_t due_ms;
+} work_msg_t;
+
+/// A worker task
+typedef struct {
+    QueueHandle_t queue;        ///< The messages posted to the worker
+    work_delayed_t *delayed;    ///< The delayed items, sorted by their due time
+    workqueue_stats_t stats;    ///< The statistics of the worker
+} worker_t;
+
+static worker_t g_workers[work_prio_count];
+
+/// The names and the priorities of the workers
+static const char * const g_worker_names[work_prio_count] = { "work_lo", "work_md", "work_hi" };
+static const UBaseType_t g_worker_priorities[work_prio_count] = { PRIORITY_LOW, PRIORITY_MEDIUM, PRIORITY_HIGH };
+static const uint16_t g_worker_stacks[work_prio_count] = { WORKQUEUE_LOW_STACK_SIZE, WORKQUEUE_STACK_SIZE, WORKQUEUE_STACK_SIZE };
+
+
+
+/// Removes the delayed item from the list of the worker, if it is in the list
+static void worker_remove(worker_t *w, work_delayed_t *work)
+{
+    for (work_delayed_t **pp = &w->delayed; NULL != *pp; pp = &(*pp)->next) {
+        if (work == *pp) {
+            *pp = work->next;
+            break;
+        }
+    }
+}
+
+/// Inserts the delayed item after the items that are due at the same time or earlier
+static void worker_insert(worker_t *w, work_delayed_t *work)
+{
+    work_delayed_t **pp = &w->delayed;
+    while (NULL != *pp && (int32_t) ((*pp)->due_ms - work->due_ms) <= 0) {
+        pp = &(*pp)->next;
+    }
+    work->next = *pp;
+    *pp = work;
+}
+
+/// Runs an item, and updates the statistics
+static void worker_run(worker_t *w, work_func_t func, void *ctx)
+{
+    const uint32_t start_us = sys_get_uptime_us();
+    func(ctx);
+    const uint32_t time_us = sys_get_uptime_us() - start_us;
+
+    ++w->stats.run;
+    if (time_us > w->stats.max_us) {
+        w->stats.max_us = time_us;
+    }
+}
+
+static void worker_task(void *p)
+{
+    worker_t *w = (worker_t*) p;
+    work_msg_t msg;
+
+    for (;;)
+    {
+        /* Block until the next delayed item is due */
+        TickType_t wait = portMAX_DELAY;
+        if (NULL != w->delayed) {
+            const int32_t ms = (int32_t) (w->delayed->due_ms - (uint32_t) sys_get_uptime_ms());
+            wait = (ms > 0) ? OS_MS(ms) + 1 : 0;
+        }
+
+        if (xQueueReceive(w->queue, &msg, wait)) {
+            if (NULL == msg.work) {
+                worker_run(w, msg.func, msg.ctx);
+            }
+            else {
+                worker_remove(w, msg.work);
+                if (NULL != msg.func) {
+                    msg.work->func = msg.func;
+                    msg.work->ctx = msg.ctx;
+                    msg.work->due_ms = msg.due_ms;
+                    worker_insert(w, msg.work);
+                }
+                else {
+                    msg.work->pending = false;
+                }
+            }
+        }
+
+        /* Run the delayed items that are due; an item may post itself again */
+        const uint32_t now_ms = sys_get_uptime_ms();
+        while (NULL != w->delayed && (int32_t) (now_ms - w->delayed->due_ms) >= 0) {
+            work_delayed_t *work = w->delayed;
+            w->delayed = work->next;
+            work->pending = false;
+            worker_run(w, work->func, work->ctx);
+        }
+    }
+}
+
+/// Sends the message to the worker from a task or an interrupt
+static bool worker_send(work_prio_t prio, const work_msg_t *msg)
+{
+    if (prio >= work_prio_count || NULL == g_workers[prio].queue) {
+        return false;
+    }
+
+    worker_t *w = &g_workers[prio];
+    bool sent = false;
+    if (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) {
+        BaseType_t woken = pdFALSE;
+        sent = xQueueSendFromISR(w->queue, msg, &woken);
+        portEND_SWITCHING_ISR(woken);
+    }
+    else {
+        sent = xQueueSend(w->queue, msg, 0);
+    }
+
+    if (!sent) {
+        ++w->stats.dropped;
+    }
+    return sent;
+}
+
+bool workqueue_start(work_prio_t prio)
+{
+    if (prio >= work_prio_count) {
+        return false;
+    }
+
+    /* The scheduler is suspended so two tasks do not start the same worker */
+    worker_t *w = &g_workers[prio];
+    bool success = true;
+    vTaskSuspendAll();
+    if (NULL == w->queue) {
+        /* The worker does not run before the scheduler is resumed, so its queue is set in time */
+        QueueHandle_t queue = xQueueCreate(WORKQUEUE_QUEUE_LENGTH, sizeof(work_msg_t));
+        if (NULL != queue &&
+            xTaskCreate(worker_task, g_worker_names[prio], g_worker_stacks[prio], w, g_worker_priorities[prio], NULL)) {
+            w->queue = queue;
+        }
+        else {
+            if (NULL != queue) {
+                vQueueDelete(queue);
+            }
+            success = false;
+        }
+    }
+    xTaskResumeAll();
+
+    return success;
+}
+
+bool workqueue_post(work_prio_t prio, work_func_t func, void *ctx)
+{
+    const work_msg_t msg = { func, ctx, NULL, 0 };
+    return (NULL != func) && worker_send(prio, &msg);
+}
+
+bool workqueue_post_from_isr(work_prio_t prio, work_func_t func, void *ctx, BaseType_t *woken)
+{
+    if (NULL == func || prio >= work_prio_count || NULL == g_workers[prio].queue) {
+        return false;
+    }
+
+    const work_msg_t msg = { func, ctx, NULL, 0 };
+    worker_t *w = &g_workers[prio];
+    if (!xQueueSendFromISR(w->queue, &msg, woken)) {
+        ++w->stats.dropped;
+        return false;
+    }
+    return true;
+}
+
+bool workqueue_post_delayed(work_prio_t prio, work_delayed_t *work, work_func_t func, void *ctx, uint32_t delay_ms)
+{
+    if (NULL == work || NULL == func) {
+        return false;
+    }
+
+    /* The item is pending as soon as it is posted, and stays as it was if it is not posted */
+    const work_msg_t msg = { func, ctx, work, (uint32_t) sys_get_uptime_ms() + delay_ms };
+    const bool pending = work->pending;
+    work->pending = true;
+    if (!worker_send(prio, &msg)) {
+        work->pending = pending;
+        return false;
+    }
+    return true;
+}
+
+bool workqueue_cancel(work_prio_t prio, work_delayed_t *work)
+{
+    const work_msg_t msg = { NULL, NULL, work, 0 };
+    return (NULL != work) && worker_send(prio, &msg);
+}
+
+workqueue_stats_t workqueue_get_stats(work_prio_t prio)
+{
+    const workqueue_stats_t none = { 0, 0, 0 };
+    return (prio < work_prio_count) ? g_workers[prio].stats : none;
+}
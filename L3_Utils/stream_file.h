@@ -0,0 +1,120 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief Append-only file that pre-allocates its clusters, such as for the logs
+ * @ingroup Utilities
+ *
+ * Appending to a file with FatFs allocates a new cluster every few writes, and f_sync() writes
+ * the FAT and the directory entry along with the data.  A stream file instead grows the file by
+ * a run of zero-filled clusters at once, so the FAT and the directory entry are only written when
+ * the file grows and when it is closed.  The appended data is written straight to the sectors of
+ * the run, and the partial sector at the end is re-written (padded with zeros) by each sync.
+ * If the disk reads the erased sectors as zeros, the run is erased rather than written with zeros.
+ *
+ * If the file is not closed, such as after a crash or a power loss, the zeros of the pre-allocated
+ * run are still part of the file, and stream_file_open() finds the end of the data by skipping the
+ * zeros at the end of the file.  So data that ends with zero bytes, such as binary records, may
+ * lose these trailing zero bytes after a crash.
+ *
+ * @code
+ *      stream_file_t log;
+ *      if (FR_OK == stream_file_open(&log, "0:log.csv", 16 * 1024)) {
+ *          stream_file_write(&log, "hello\n", 6);
+ *          stream_file_close(&log);   // Gives back the unused part of the run
+ *      }
+ * @endcode
+ *
+ * @warning Other readers of the file see the zeros of the run at the end of the file while it is open.
+ */
+#ifndef STREAM_FILE_H__
+#define STREAM_FILE_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+#include "ff.h"
+
+
+
+/// Number of fragments of the file that are mapped to write its sectors directly
+#define STREAM_FILE_MAX_FRAGMENTS   4
+
+
+
+/**
+ * A stream file; @see the file description
+ */
+typedef struct {
+    FIL file;                   ///< The file, kept open
+    uint32_t size;              ///< The size of the data of the file
+    uint32_t allocated;         ///< The size of the file, which includes the zeros of the run
+    uint32_t prealloc_bytes;    ///< The bytes by which the file grows at once
+    bool direct;                ///< True if the sectors of the file are mapped by clmt[]
+    bool opened;                ///< True if the file is open
+    bool tail_dirty;            ///< True if sector[] has data that is not written yet
+    bool unsynced;              ///< True if data was appended after the last stream_file_sync()
+    DWORD clmt[2 + 2 * STREAM_FILE_MAX_FRAGMENTS];  ///< The fast seek table of the file
+    BYTE sector[_MAX_SS];       ///< The last sector of the data
+} stream_file_t;
+
+/**
+ * Opens or creates a stream file, and finds the end of its data.
+ * @param prealloc_bytes  The bytes by which the file grows when the data reaches its end,
+ *                        which is rounded up to the clusters of the volume.
+ */
+FRESULT stream_file_open(stream_file_t *sf, const char *filename, uint32_t prealloc_bytes);
+
+/**
+ * Appends the data to the file.  The whole sectors are written, and the partial sector at the end
+ * of the data is kept until it is full or until stream_file_sync().
+ */
+FRESULT stream_file_append(stream_file_t *sf, const void *data, uint32_t len);
+
+/**
+ * Writes the partial sector at the end of the data, and syncs the disk, so the data given to
+ * stream_file_append() is on the disk when this returns.
+ */
+FRESULT stream_file_sync(stream_file_t *sf);
+
+/**
+ * Appends the data to the file, and syncs it.  The data is on the disk when this returns.
+ */
+FRESULT stream_file_write(stream_file_t *sf, const void *data, uint32_t len);
+
+/**
+ * Discards the data of the file and gives back its clusters, such as to reuse the file.
+ */
+FRESULT stream_file_truncate(stream_file_t *sf);
+
+/**
+ * Truncates the zeros of the run, and closes the file.
+ */
+FRESULT stream_file_close(stream_file_t *sf);
+
+/// @returns the size of the data of the file
+static inline uint32_t stream_file_size(const stream_file_t *sf) { return sf->size; }
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* STREAM_FILE_H__ */
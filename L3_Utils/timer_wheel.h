@@ -0,0 +1,140 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief Hashed timer wheel for a large number of polled timeouts
+ * @ingroup Utilities
+ *
+ * A SoftTimer is polled: each timer reads the clock and compares its target each time it is
+ * checked, so code with many timers does work for every timer on every pass.  The timer wheel
+ * instead hashes each timer to one of TIMER_WHEEL_SLOTS lists by its deadline, and the service
+ * function only walks the slots of the ticks that passed since its last call.  Starting and
+ * stopping a timer is O(1), and the service only touches the expired timers and the few timers
+ * that share their slots, no matter how many timers are running.
+ *
+ * The time is any 32-bit counter given by the caller (usually milliseconds), and the deadlines
+ * are compared across its rollover.  A timer further away than one turn of the wheel simply stays
+ * in its slot until its deadline comes around.  The expired timers are removed before their
+ * callback is called, so a callback can start its timer again.
+ *
+ * The wheel does not lock anything, so it should only be used by one task (or by a task that
+ * holds a lock of the data the timers belong to).
+ * @code
+ *      static timer_wheel_t wheel;
+ *      static timer_wheel_timer_t timeout;
+ *      static void timeout_callback(timer_wheel_timer_t *timer, void *arg) { ... }
+ *
+ *      timer_wheel_init(&wheel, sys_get_uptime_ms());
+ *      timer_wheel_timer_init(&timeout, timeout_callback, NULL);
+ *      timer_wheel_start(&wheel, &timeout, sys_get_uptime_ms(), 500);
+ *
+ *      // Periodically :
+ *      timer_wheel_service(&wheel, sys_get_uptime_ms());
+ * @endcode
+ *
+ * 20261014: Initial
+ */
+#ifndef TIMER_WHEEL_H__
+#define TIMER_WHEEL_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+
+
+#define TIMER_WHEEL_SLOTS       64      ///< The number of slots of a wheel; must be a power of 2
+#define TIMER_WHEEL_TICK_SHIFT  2       ///< Each slot is 2^TIMER_WHEEL_TICK_SHIFT units of time
+
+/// The max timeout, so the deadlines can be compared across the rollover of the time
+#define TIMER_WHEEL_MAX_TIMEOUT (UINT32_C(1) << 31)
+
+struct timer_wheel_timer;
+
+/**
+ * Callback function called by timer_wheel_service() when the timer expires
+ * @param timer  The timer that expired, which can be started again from the callback
+ * @param arg    The argument given to timer_wheel_timer_init()
+ */
+typedef void (*timer_wheel_callback_t)(struct timer_wheel_timer *timer, void *arg);
+
+/// A timer of the wheel; the members are private to timer_wheel.c
+typedef struct timer_wheel_timer {
+    struct timer_wheel_timer *next;     ///< The next timer of the slot
+    struct timer_wheel_timer **pprev;   ///< The pointer to this timer in the slot, or NULL if not started
+    uint32_t deadline;                  ///< The time this timer expires
+    timer_wheel_callback_t callback;    ///< The callback when this timer expires
+    void *arg;                          ///< The argument of the callback
+} timer_wheel_timer_t;
+
+/// The timer wheel; the members are private to timer_wheel.c
+typedef struct {
+    timer_wheel_timer_t *slots[TIMER_WHEEL_SLOTS];  ///< The timers hashed by their deadline
+    uint32_t now;                                   ///< The time of the last timer_wheel_service()
+} timer_wheel_t;
+
+
+
+/**
+ * Initializes an empty wheel
+ * @param wheel  The wheel
+ * @param now    The current time
+ */
+void timer_wheel_init(timer_wheel_t *wheel, uint32_t now);
+
+/**
+ * Initializes a timer, which is not started
+ * @param timer     The timer
+ * @param callback  The callback when the timer expires
+ * @param arg       The argument of the callback
+ */
+void timer_wheel_timer_init(timer_wheel_timer_t *timer, timer_wheel_callback_t callback, void *arg);
+
+/**
+ * Starts (or restarts) a timer
+ * @param wheel    The wheel
+ * @param timer    The timer initialized by timer_wheel_timer_init()
+ * @param now      The current time
+ * @param timeout  The time from now to the expiry; 0 expires at the next timer_wheel_service()
+ * @returns false if the timeout is larger than TIMER_WHEEL_MAX_TIMEOUT
+ */
+bool timer_wheel_start(timer_wheel_t *wheel, timer_wheel_timer_t *timer, uint32_t now, uint32_t timeout);
+
+/// Stops a timer; nothing is done if the timer is not started
+void timer_wheel_stop(timer_wheel_timer_t *timer);
+
+/// @returns true if the timer is started and has not expired
+static inline bool timer_wheel_is_active(const timer_wheel_timer_t *timer) { return (NULL != timer->pprev); }
+
+/**
+ * Calls the callback of each timer that expired since the last call
+ * @param wheel  The wheel
+ * @param now    The current time
+ * @returns the number of timers that expired
+ */
+uint32_t timer_wheel_service(timer_wheel_t *wheel, uint32_t now);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* TIMER_WHEEL_H__ */
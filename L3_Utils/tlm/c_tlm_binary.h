@@ -61,7 +61,8 @@ uint32_t tlm_binary_get_size_all(void);
 
 /**
  * @{
- * Copy the telemetry data to the provided memory pointer
+ * Copy the telemetry data to the provided memory pointer.  Each component is copied
+ * again if its update overlapped the copy @see tlm_begin_update()
  * @param comp_ptr   The component pointer
  * @param binary     The data pointer to which data will be copied
  * @returns The number of bytes copied into the data pointer.
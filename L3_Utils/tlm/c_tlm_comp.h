@@ -19,6 +19,9 @@
 #ifndef C_TLM_COMP_H__
 #define C_TLM_COMP_H__
 #include "c_list.h"
+#include "c_tlm_index.h"
+#include <stdint.h>
+#include <stdbool.h>
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -42,8 +45,29 @@ extern "C" {
  *      tlm_variable_register(comp, "a", &a, sizeof(a)));
  *      TLM_REG_VAR(comp, b); // Macro to register variable b
  * @endcode
+ *
+ * The telemetry is read straight from the registered variables while their tasks keep
+ * updating them, so an array or a group of variables may be streamed half updated.  The
+ * task that updates the variables of a component can optionally mark the update, and
+ * then the readers copy the variables again if the update overlapped the copy :
+ * @code
+ *      tlm_begin_update(comp);
+ *      memcpy(g_accel_xyz, xyz, sizeof(g_accel_xyz));
+ *      g_accel_samples++;
+ *      tlm_end_update(comp);
+ * @endcode
  */
 
+/**
+ * The readers copy the variables of a component again if an update of the component
+ * overlapped the copy, but at most this many times before the last copy is used.  A reader
+ * with a higher priority than the writer cannot let the writer finish its update, so the
+ * telemetry should be read by a lower priority task, such as the terminal or the disk task.
+ */
+#ifndef TLM_SEQ_MAX_RETRIES
+#define TLM_SEQ_MAX_RETRIES     8
+#endif
+
 /**
  * Structure of a telemetry component.
  * Each component has a name, and a list of variables
@@ -51,6 +75,10 @@ extern "C" {
 typedef struct {
     const char *name;    /** Name of the telemetry component */
     c_list_ptr var_list; /** List of the telemetry variables of this component */
+    tlm_index var_index; /** Index of the variables by name */
+    volatile uint32_t seq; /** Odd while the variables are being updated @see tlm_begin_update() */
+    uint16_t static_first; /** The first variable of this component in the table of TLM_DEFINE_VAR() */
+    uint16_t static_count; /** The number of variables of TLM_DEFINE_VAR() of this component */
 } tlm_component;
 
 /**
@@ -72,6 +100,13 @@ tlm_component* tlm_component_add(const char *name);
  */
 tlm_component* tlm_component_get_by_name(const char *name);
 
+/**
+ * Get an existing telemetry component by its index, which is the order it was added in,
+ * and the component index of the binary telemetry stream.
+ * @returns NULL pointer if there are not as many components
+ */
+tlm_component* tlm_component_get_by_index(uint32_t index);
+
 /**
  * Calls your callback function for each telemetry component added to the
  * telemetry components list by tlm_component_add().
@@ -80,6 +115,55 @@ tlm_component* tlm_component_get_by_name(const char *name);
  */
 void tlm_component_for_each(tlm_comp_callback callback, void *arg1, void *arg2);
 
+/**
+ * The processor has a single core, so the seq only needs to be ordered with the
+ * variables by the compiler.
+ */
+#define TLM_SEQ_BARRIER()   __asm__ __volatile__("" ::: "memory")
+
+/**
+ * Marks the start of an update of the variables of a component.  The updates of the
+ * same component must not overlap each other, so they should be made by one task or
+ * from one interrupt.  The components that are never marked are read as before.
+ */
+static inline void tlm_begin_update(tlm_component *comp_ptr)
+{
+    if (NULL != comp_ptr) {
+        comp_ptr->seq++;
+        TLM_SEQ_BARRIER();
+    }
+}
+
+/// Marks the end of the update started by tlm_begin_update()
+static inline void tlm_end_update(tlm_component *comp_ptr)
+{
+    if (NULL != comp_ptr) {
+        TLM_SEQ_BARRIER();
+        comp_ptr->seq++;
+    }
+}
+
+/**
+ * Starts reading the variables of a component.
+ * @returns The seq to give to tlm_read_retry() after the variables are copied
+ */
+static inline uint32_t tlm_read_begin(const tlm_component *comp_ptr)
+{
+    const uint32_t seq = comp_ptr->seq;
+    TLM_SEQ_BARRIER();
+    return seq;
+}
+
+/**
+ * @returns true if the variables copied since tlm_read_begin() may be half updated,
+ *          and should be copied again.
+ */
+static inline bool tlm_read_retry(const tlm_component *comp_ptr, uint32_t seq)
+{
+    TLM_SEQ_BARRIER();
+    return (0 != (seq & 1) || seq != comp_ptr->seq);
+}
+
 
 
 #ifdef __cplusplus
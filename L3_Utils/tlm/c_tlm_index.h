@@ -0,0 +1,75 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#ifndef C_TLM_INDEX_H__
+#define C_TLM_INDEX_H__
+#include <stdint.h>
+#include <stdbool.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/**
+ * @file
+ * Hash index of telemetry names.
+ *
+ * The components and the variables are still kept in their c_list to preserve the order
+ * of registration (the stream and binary format rely on it), but the lookup by name
+ * uses this index rather than a linear scan with strcmp().  The hash of the name is
+ * computed once when an element is inserted, and the table is a contiguous array
+ * using linear probing, so a lookup is typically one hash and one strcmp().
+ */
+
+/// A single entry of the index
+typedef struct {
+    uint32_t hash;      ///< Hash of the name, computed when inserted
+    const char *name;   ///< Persistent name pointer of the element
+    void *elm;          ///< The element, or NULL if this entry is unused
+} tlm_index_entry;
+
+/// The index; zero initialized index is a valid empty index
+typedef struct {
+    tlm_index_entry *entries;   ///< Table of capacity entries (power of 2)
+    uint32_t capacity;          ///< Number of entries in the table
+    uint32_t count;             ///< Number of used entries
+} tlm_index;
+
+/// @returns the hash of the name (FNV-1a)
+uint32_t tlm_index_hash(const char *name);
+
+/**
+ * Inserts an element to the index.  The table grows when it is 3/4th full.
+ * @param hash  The hash of the name from tlm_index_hash()
+ * @returns false if memory could not be allocated
+ */
+bool tlm_index_insert(tlm_index *index, uint32_t hash, const char *name, void *elm);
+
+/**
+ * @returns the element inserted by the given name, or NULL if not found
+ * @param hash  The hash of the name from tlm_index_hash()
+ */
+void* tlm_index_find(const tlm_index *index, uint32_t hash, const char *name);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* C_TLM_INDEX_H__ */
@@ -0,0 +1,98 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#ifndef C_TLM_SAMPLER_H__
+#define C_TLM_SAMPLER_H__
+#include <stdint.h>
+#include <stdbool.h>
+#include "c_tlm_stream.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/**
+ * @file
+ * Periodic telemetry sampler.
+ *
+ * Registered telemetry variables only point to the current value of the data.  The
+ * sampler takes snapshots of selected variables at their own rates from a FreeRTOS
+ * timer, and stores them into a fixed RAM ring.  When the ring is full, the oldest
+ * samples are overwritten, so the ring holds the most recent history of the variables.
+ * The history can then be dumped in bulk using the binary telemetry stream format,
+ * which is a lot cheaper than a task printing each sample.
+ *
+ * The dump consists of a tlm_bin_schema record of the "sampler" component, whose
+ * variables are the sampled channels named "<comp>.<var>", followed by one
+ * tlm_bin_samples record.  Both records use TLM_SAMPLER_COMP_IDX as component index.
+ * The payload of the samples record is a sequence of samples, oldest first :
+ *      <Channel index:1> <Uptime in ms:4> <Data bytes of the variable>
+ *
+ * @code
+ *      tlm_sampler_add("motion", "current_pos", 10);  // Sample every 10ms
+ *      tlm_sampler_add("motion", "adc", 100);         // Sample every 100ms
+ *      ...
+ *      tlm_sampler_stream(my_write_func, my_arg);     // Dump and clear the ring
+ * @endcode
+ *
+ * @note Samples are missed (and counted) while the ring is being dumped.
+ */
+
+#define TLM_SAMPLER_RING_BYTES  (4 * 1024)  ///< Size of the sample ring (less than 64K)
+#define TLM_SAMPLER_MAX_CHANS   8           ///< Maximum number of variables sampled
+#define TLM_SAMPLER_MAX_BYTES   16          ///< Max size of a single sampled variable
+#define TLM_SAMPLER_COMP_IDX    0xFF        ///< Component index of the sampler's records
+#define TLM_SAMPLER_HDR_BYTES   5           ///< Size of the channel and time of a sample
+
+/**
+ * Adds a registered telemetry variable to be sampled.  Adding a channel discards the
+ * samples in the ring because the size of the samples would no longer be known.
+ * @param comp_name  The name of the component
+ * @param var_name   The name of the variable registered under the component
+ * @param period_ms  The sampling period in milliseconds
+ * @returns false if the variable was not found, is too large, or no channel is left
+ */
+bool tlm_sampler_add(const char *comp_name, const char *var_name, uint16_t period_ms);
+
+/// Removes all the channels and stops sampling
+void tlm_sampler_clear(void);
+
+/**
+ * Streams the schema and the samples in the ring, and then empties the ring.
+ * @param stream  The callback function that will receive the binary data
+ * @param arg     This argument will be passed to the stream function as its argument
+ * @returns the number of samples streamed
+ */
+uint32_t tlm_sampler_stream(bin_stream_callback_type stream, void *arg);
+
+/**
+ * @{ Statistics of the sampler
+ * Overwritten count is the number of old samples lost because the ring was full.
+ * Missed count is the number of times sampling was skipped because the ring was busy.
+ */
+uint32_t tlm_sampler_get_overwritten_count(void);
+uint32_t tlm_sampler_get_missed_count(void);
+/** @} */
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* C_TLM_SAMPLER_H__ */
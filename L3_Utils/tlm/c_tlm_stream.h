@@ -114,6 +114,110 @@ bool tlm_stream_decode_file(FILE *file);
 
 
 
+/**
+ * @{
+ * Binary telemetry stream
+ *
+ * The ASCII stream above costs about 3 characters per data byte and a formatted print
+ * per byte.  The binary stream sends the raw bytes instead, and can send just the
+ * variables that have changed since the previous snapshot.  The stream is a sequence
+ * of records, each starting with a 4 byte header :
+ *      <Record type> <Component index> <Payload length LSB> <Payload length MSB>
+ *
+ * The component index is the position of the component in the order it is streamed.
+ * Payload of each record type :
+ *  - tlm_bin_schema : <Comp name>\0 <Var count:2> then for each variable :
+ *                     <Var name>\0 <Var size:2> <Array size:2> <Type:1>
+ *  - tlm_bin_data   : Data bytes of all variables, in the same order as the schema
+ *  - tlm_bin_delta  : Bitmap of changed variables (bit 0 of first byte is the first
+ *                     variable), followed by data bytes of only the changed variables
+ *  - tlm_bin_samples: Samples of the telemetry sampler, @see c_tlm_sampler.h
+ *  - tlm_bin_check  : <CRC32:4> of all the records after the previous check record, or after
+ *                     the start of the stream.  The component index is 0.
+ *  - tlm_bin_changes: Changed values pushed to a subscriber, @see c_tlm_subscribe.h
+ *
+ * All multi-byte fields are little-endian.  The schema is sent once along with the
+ * full data, and after that the deltas can be sent against the previous snapshot.
+ * A component whose data did not change is not sent at all in a delta stream.
+ * A file, such as the disk telemetry, ends each write with a check record, so the records of
+ * a write that did not complete are not decoded.
+ *
+ * @code
+ *      char *prev = (char*) malloc(tlm_binary_get_size_all());
+ *      tlm_stream_all_binary(my_write, my_arg, prev, false); // Schema + full data
+ *      tlm_stream_all_binary(my_write, my_arg, prev, true);  // Only what changed
+ * @endcode
+ */
+typedef enum {
+    tlm_bin_schema = 0xA1,
+    tlm_bin_data   = 0xA2,
+    tlm_bin_delta  = 0xA3,
+    tlm_bin_samples = 0xA4,
+    tlm_bin_check  = 0xA5,
+    tlm_bin_changes = 0xA6,
+} tlm_bin_record_type;
+
+#define TLM_BIN_HEADER_SIZE 4 ///< Size of the record header of the binary stream
+
+/**
+ * Typedef of the binary stream callback function
+ * @param data  The data to write
+ * @param len   The length of the data in bytes
+ * @param arg   The argument provided to the binary stream function
+ */
+typedef void (*bin_stream_callback_type)(const void *data, uint32_t len, void *arg);
+
+/**
+ * Streams the binary telemetry for one component.
+ * @param stream  The callback function that will receive the binary data
+ * @param arg     This argument will be passed to the stream function as its argument
+ * @param prev    The previous snapshot of tlm_binary_get_size_one() bytes, which is updated
+ *                with the streamed data.  This can be NULL if delta is not used.
+ * @param delta   If true, only variables that differ from prev are sent, otherwise the
+ *                schema and all the data is sent.
+ */
+void tlm_stream_one_binary(tlm_component *comp, bin_stream_callback_type stream, void *arg,
+                           char *prev, bool delta);
+
+/**
+ * Streams the binary telemetry for all components.
+ * @param prev  The previous snapshot of tlm_binary_get_size_all() bytes, or NULL
+ * @see tlm_stream_one_binary() for the rest of the parameters
+ */
+void tlm_stream_all_binary(bin_stream_callback_type stream, void *arg, char *prev, bool delta);
+
+/**
+ * Streams the header of a binary record.  This is used by other modules that output
+ * their own records, and the payload of len bytes must follow the header.
+ */
+void tlm_stream_binary_header(bin_stream_callback_type stream, void *arg,
+                              tlm_bin_record_type type, uint8_t comp_idx, uint16_t len);
+
+/**
+ * Streams the check record of the records streamed after the previous check record.
+ * @param crc  The crc32_update() of all the bytes of those records
+ */
+void tlm_stream_binary_check(bin_stream_callback_type stream, void *arg, uint32_t crc);
+
+/// Streams the schema, the data and the check of one component in binary format to a file pointer
+void tlm_stream_one_binary_file(tlm_component *comp_ptr, FILE *file);
+
+/**
+ * Decodes the binary telemetry stream from an opened file handle, and sets the values of
+ * the registered variables.  Variables not registered are skipped.
+ * If the schema of a component hashes the same as its registered variables, the data is
+ * copied to the variables in order, otherwise each variable is looked up by its name.
+ * If the stream has check records, only the records up to the last correct check record are
+ * decoded.  The older streams without the check records are decoded completely.
+ * @returns false if the file doesn't start with a binary schema record, or if the stream is
+ *          corrupt.  The file position is restored if no binary record was found, so the
+ *          same file can be given to tlm_stream_decode_file().
+ */
+bool tlm_stream_decode_binary_file(FILE *file);
+/** @} */
+
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,104 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#ifndef C_TLM_SUBSCRIBE_H__
+#define C_TLM_SUBSCRIBE_H__
+#include <stdint.h>
+#include <stdbool.h>
+#include "c_tlm_stream.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/**
+ * @file
+ * Push-on-change telemetry subscriptions.
+ *
+ * Instead of polling all of the telemetry, a subscriber registers the variables it is
+ * interested in, and only the values that changed are pushed to its stream function.
+ * A FreeRTOS timer checks the subscribed variables every TLM_SUB_CHECK_MS.  A variable is
+ * pushed when it differs from the value last pushed to the subscriber, or for a scalar
+ * number with a deadband, when it moved by more than the deadband.  A variable is not pushed
+ * more often than its minimum interval, and its latest value is pushed once the interval ends.
+ *
+ * If the component of a variable marks its updates (@see tlm_begin_update()), the variable
+ * is only copied and compared after its component was updated, so the idle variables cost
+ * nothing.  The variables of the other components are compared each time.
+ *
+ * The changes are pushed as one tlm_bin_changes record for each frame of up to the frame
+ * size of the subscriber.  The component index of the record is 0, and its payload is :
+ *      <Uptime in ms:4> { <Comp index:1> <Var index:1> <Len:1> <Data bytes of the variable> } ...
+ * The indexes are the same as the ones of the binary telemetry stream.
+ *
+ * @code
+ *      int sub = tlm_subscribe_open(my_write_func, my_arg, 64);
+ *      tlm_subscribe_add(sub, "motion", "current_pos", 0, 100);  // Any change, at most every 100ms
+ *      tlm_subscribe_add(sub, "motion", "last_adc", 5.0f, 0);    // Changes of more than 5
+ *      ...
+ *      tlm_subscribe_close(sub);
+ * @endcode
+ *
+ * @warning The stream function is called by the FreeRTOS timer task, so it must not block.
+ *          Each call is one complete record, so the stream function can drop the record as
+ *          a whole if it cannot send it right away.
+ */
+
+#define TLM_SUB_MAX_SUBSCRIBERS 2           ///< Maximum number of subscribers
+#define TLM_SUB_MAX_VARS        16          ///< Maximum number of variables of all subscribers
+#define TLM_SUB_MAX_BYTES       16          ///< Max size of a subscribed variable
+#define TLM_SUB_FRAME_BYTES     128         ///< Max size of a record of changes
+#define TLM_SUB_CHECK_MS        10          ///< The variables are checked this often
+#define TLM_SUB_HDR_BYTES       4           ///< Size of the uptime of a record of changes
+#define TLM_SUB_VAR_HDR_BYTES   3           ///< Size of the indexes and the length of a value
+
+/**
+ * Opens a subscriber.  If the stream function and its argument were already opened, the
+ * same subscriber is returned.
+ * @param stream       The callback function that will receive the records of changes
+ * @param arg          This argument will be passed to the stream function as its argument
+ * @param frame_bytes  The max size of a record, up to TLM_SUB_FRAME_BYTES
+ * @returns the subscriber, or -1 if no subscriber is left
+ */
+int tlm_subscribe_open(bin_stream_callback_type stream, void *arg, uint16_t frame_bytes);
+
+/**
+ * Subscribes to a registered telemetry variable.  Its current value is pushed first.
+ * @param sub              The subscriber of tlm_subscribe_open()
+ * @param comp_name        The name of the component
+ * @param var_name         The name of the variable registered under the component
+ * @param deadband         If non-zero, a scalar number is only pushed if it moved by more than this
+ * @param min_interval_ms  The variable is not pushed more often than this
+ * @returns false if the variable was not found, is too large, or no variable is left
+ */
+bool tlm_subscribe_add(int sub, const char *comp_name, const char *var_name,
+                       float deadband, uint16_t min_interval_ms);
+
+/// Removes the subscriber and its variables
+void tlm_subscribe_close(int sub);
+
+/// @returns the number of records of changes pushed to all of the subscribers
+uint32_t tlm_subscribe_get_pushed_count(void);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* C_TLM_SUBSCRIBE_H__ */
@@ -80,6 +80,15 @@ bool tlm_variable_register(tlm_component *comp_ptr,
                              const uint16_t arr_size,
                              tlm_type type);
 
+/**
+ * The variables up to this size are copied before they are streamed or printed, so they
+ * are not half updated if their component marks its updates @see tlm_begin_update()
+ * The larger variables are read in place.
+ */
+#ifndef TLM_SNAPSHOT_MAX_BYTES
+#define TLM_SNAPSHOT_MAX_BYTES  64
+#endif
+
 /**
  * Macro to register a variable.
  * If a variable is called "var", then this macro will yield :
@@ -94,6 +103,40 @@ bool tlm_variable_register(tlm_component *comp_ptr,
 #define TLM_REG_ARR(comp, var, type) \
     tlm_variable_register(comp, #var, &var[0], sizeof(var[0]), sizeof(var)/sizeof(var[0]), type)
 
+/**
+ * A variable defined at compile time by TLM_DEFINE_VAR() or TLM_DEFINE_ARR()
+ */
+typedef struct {
+    const char *comp_name; /**< Name of the component of the variable */
+    tlm_reg_var_type var;  /**< The registered variable */
+} tlm_static_var_type;
+
+/**
+ * @{ Defines a variable of a component at compile time, instead of tlm_variable_register() at
+ * run time.  The descriptor is const data in the flash, and the linker collects the descriptors
+ * of all the files sorted by "<comp>.<var>" (@see loader.ld), so the defined variables cost no
+ * heap, no list node and no index entry, and they exist before any code runs.  They are looked
+ * up by a binary search, and they come before the registered variables of their component.
+ *
+ * The comp and var are identifiers: comp is the name of the component, which still has to be
+ * added by tlm_component_add(), and var is a global or a static variable.
+ * @code
+ *      static uint16_t current_pos;
+ *      TLM_DEFINE_VAR(motion, current_pos, tlm_uint);
+ *      ...
+ *      tlm_component_add("motion");  // current_pos is the first variable of "motion"
+ * @endcode
+ */
+#define TLM_DEFINE_VAR(comp, var, type) \
+    TLM_DEFINE_STATIC(comp, var, &var, sizeof(var), 1, type)
+#define TLM_DEFINE_ARR(comp, var, type) \
+    TLM_DEFINE_STATIC(comp, var, &var[0], sizeof(var[0]), sizeof(var)/sizeof(var[0]), type)
+#define TLM_DEFINE_STATIC(comp, var, data_ptr, size, arr_size, type) \
+    static const tlm_static_var_type tlm_static_##comp##_##var \
+    __attribute__((used, aligned(__alignof__(tlm_static_var_type)), section(".tlm_vars." #comp "." #var))) = \
+    { #comp, { #var, data_ptr, size, arr_size, type } }
+/** @} */
+
 /**
  * Get the data pointer and the size of a previously registered variable.
  * The tlm_reg_var_type structure contains the pointer and the size.
@@ -112,6 +155,38 @@ const tlm_reg_var_type* tlm_variable_get_by_name(tlm_component *comp_ptr,
 const tlm_reg_var_type* tlm_variable_get_by_comp_and_name(const char *comp_name,
                                                           const char *name);
 
+/**
+ * Get a previously registered variable by its index within the component, which is
+ * the order it was registered in, and its order in the binary telemetry stream.
+ * The variables of TLM_DEFINE_VAR() come first, in the order of their names.
+ * @returns NULL if the component does not have as many variables
+ */
+const tlm_reg_var_type* tlm_variable_get_by_index(tlm_component *comp_ptr, uint32_t index);
+
+/// @returns the number of variables of the component, including the ones of TLM_DEFINE_VAR()
+uint32_t tlm_variable_count(const tlm_component *comp_ptr);
+
+/**
+ * Same as tlm_variable_get_by_index() except that the hint makes it quick to get each of
+ * the variables in order.
+ * @param hint  Set the pointer to NULL before getting the first variable
+ */
+const tlm_reg_var_type* tlm_variable_get_at(const tlm_component *comp_ptr, uint32_t index, void **hint);
+
+/**
+ * Finds the variables of TLM_DEFINE_VAR() of a component.  This is called by
+ * tlm_component_add(), and is not needed otherwise.
+ */
+void tlm_variable_attach_static(tlm_component *comp_ptr);
+
+/**
+ * Gets the indexes of a registered variable, which are the IDs of the variable in the
+ * binary telemetry stream; @see tlm_component_get_by_index() tlm_variable_get_by_index()
+ * @returns false if the variable was not found
+ */
+bool tlm_variable_get_indexes(const char *comp_name, const char *name,
+                              uint32_t *comp_index, uint32_t *var_index);
+
 /**
  * Sets a value to one of the telemetry variables.  This is sort of a back-door way to force
  * a value to the telemetry variable.
@@ -140,6 +215,18 @@ bool tlm_variable_get_value(const char *comp_name, const char *name, char *buffe
  */
 bool tlm_variable_print_value(const tlm_reg_var_type *reg_var, char *buffer, int len);
 
+/**
+ * Copies the data of a variable, and copies it again if an update of its component
+ * overlapped the copy @see tlm_read_retry()
+ * @param comp_ptr      The component of the variable
+ * @param reg_var       A registered variable of the component
+ * @param buffer        The buffer to copy the data to
+ * @param len           The length of the buffer
+ * @returns             false if the buffer is smaller than the variable
+ */
+bool tlm_variable_snapshot(const tlm_component *comp_ptr, const tlm_reg_var_type *reg_var,
+                           void *buffer, uint32_t len);
+
 
 
 #ifdef __cplusplus
@@ -27,26 +27,34 @@
  * @param arg_size  Must be a valid uint32_t pointer.  This pointer is updated with
  *                  the size of the telemetry in raw bytes
  * @param binary    If null, only the size of telemetry will be obtained.
- *                  If non-null, the telemetry will be saved into this data pointer.
+ *                  If non-null, the telemetry will be saved into this data pointer,
+ *                  and copied again if the component was updated during the copy.
  */
 static void get_tlm_one_comp(tlm_component *comp_ptr, void *arg_size, void *binary)
 {
     void *hint = 0;
-    tlm_reg_var_type *var = NULL;
+    const tlm_reg_var_type *var = NULL;
     uint32_t *size = arg_size;
     uint32_t i = 0, sizeOfVar = 0;
+    uint32_t start = 0, seq = 0, tries = 0;
 
     if (NULL != size && NULL != comp_ptr) {
-        for(i=0; i < c_list_node_count(comp_ptr->var_list); i++) {
-            var = c_list_get_elm_at(comp_ptr->var_list, i, &hint);
-            if (NULL != var) {
-                sizeOfVar = (var->elm_arr_size) * (var->elm_size_bytes);
-                if (binary) {
-                    memcpy(((char*)binary + (*size)), var->data_ptr, sizeOfVar);
+        start = *size;
+        do {
+            seq = tlm_read_begin(comp_ptr);
+            hint = 0;
+            *size = start;
+            for(i=0; i < tlm_variable_count(comp_ptr); i++) {
+                var = tlm_variable_get_at(comp_ptr, i, &hint);
+                if (NULL != var) {
+                    sizeOfVar = (var->elm_arr_size) * (var->elm_size_bytes);
+                    if (binary) {
+                        memcpy(((char*)binary + (*size)), var->data_ptr, sizeOfVar);
+                    }
+                    (*size) += sizeOfVar;
                 }
-                (*size) += sizeOfVar;
             }
-        }
+        } while (NULL != binary && tlm_read_retry(comp_ptr, seq) && ++tries < TLM_SEQ_MAX_RETRIES);
     }
 }
 
@@ -84,13 +92,13 @@ uint32_t tlm_binary_get_all(char *binary)
 static void cmp_tlm_one_comp(tlm_component *comp_ptr, void *binary, void *offset_arg)
 {
     void *hint = 0;
-    tlm_reg_var_type *var = NULL;
+    const tlm_reg_var_type *var = NULL;
     uint32_t size = 0, i = 0;
     uint32_t *offset = offset_arg;
 
     if (NULL != comp_ptr) {
-        for(i=0; i < c_list_node_count(comp_ptr->var_list); i++) {
-            var = c_list_get_elm_at(comp_ptr->var_list, i, &hint);
+        for(i=0; i < tlm_variable_count(comp_ptr); i++) {
+            var = tlm_variable_get_at(comp_ptr, i, &hint);
             if (NULL != var) {
                 size = (var->elm_arr_size) * (var->elm_size_bytes);
                 if (0 != memcmp(((char*)binary + (*offset)), var->data_ptr, size)) {
@@ -21,16 +21,17 @@
 #include <stdlib.h>
 #include <string.h>
 #include "c_tlm_comp.h"
+#include "c_tlm_var.h"
 
-/** Private member of this file */
-static c_list_ptr mp_tlm_component_list = NULL;
+/**
+ * Nodes of the component list and the variable lists are allocated in chunks of this
+ * many nodes rather than one malloc per registration.
+ */
+#define TLM_LIST_CHUNK_NODES    8
 
-static bool tlm_component_find_by_name(void *elm_ptr, void *arg1, void *arg2, void *arg3)
-{
-    tlm_component *comp = elm_ptr;
-    char *new_comp_name = arg1;
-    return (0 != strcmp(comp->name, new_comp_name));
-}
+/** Private members of this file */
+static c_list_ptr mp_tlm_component_list = NULL;
+static tlm_index m_tlm_component_index = { NULL, 0, 0 };
 
 static bool tlm_component_for_each_callback(void *elm_ptr, void *arg1, void *arg2, void *arg3)
 {
@@ -48,11 +49,12 @@ tlm_component* tlm_component_add(const char *name)
 
     /* Create component list if it doesn't exist */
     if(NULL == mp_tlm_component_list) {
-        mp_tlm_component_list = c_list_create();
+        mp_tlm_component_list = c_list_create_pooled(TLM_LIST_CHUNK_NODES);
     }
 
     /* Check if this component exists */
-    if (NULL != tlm_component_get_by_name(name)) {
+    const uint32_t hash = tlm_index_hash(name);
+    if (NULL != tlm_index_find(&m_tlm_component_index, hash, name)) {
         return NULL;
     }
 
@@ -65,18 +67,25 @@ tlm_component* tlm_component_add(const char *name)
 
     /* Create the component and the list of variables of this component*/
     new_comp->name = name;
-    new_comp->var_list = c_list_create();
+    tlm_variable_attach_static(new_comp);
+    new_comp->var_list = c_list_create_pooled(TLM_LIST_CHUNK_NODES);
     if(NULL == new_comp->var_list) {
         free(new_comp);
         return NULL;
     }
 
-    /* Finally, add this component to our list */
+    /* Finally, add this component to our list and the index */
     if(!c_list_insert_elm_end(mp_tlm_component_list, new_comp)) {
         free(new_comp->var_list);
         free(new_comp);
         return NULL;
     }
+    if(!tlm_index_insert(&m_tlm_component_index, hash, name, new_comp)) {
+        c_list_delete_elm(mp_tlm_component_list, new_comp);
+        free(new_comp->var_list);
+        free(new_comp);
+        return NULL;
+    }
 
     return new_comp;
 }
@@ -86,8 +95,19 @@ tlm_component* tlm_component_get_by_name(const char *name)
     tlm_component *comp = NULL;
 
     if (NULL != name) {
-        comp = c_list_find_elm(mp_tlm_component_list, tlm_component_find_by_name,
-                               (void*)name, NULL, NULL);
+        comp = tlm_index_find(&m_tlm_component_index, tlm_index_hash(name), name);
+    }
+
+    return comp;
+}
+
+tlm_component* tlm_component_get_by_index(uint32_t index)
+{
+    void *hint = 0;
+    tlm_component *comp = NULL;
+
+    if (NULL != mp_tlm_component_list && index < c_list_node_count(mp_tlm_component_list)) {
+        comp = c_list_get_elm_at(mp_tlm_component_list, index, &hint);
     }
 
     return comp;
@@ -0,0 +1,113 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "c_tlm_index.h"
+
+
+
+/// Initial number of entries of an index table
+#define TLM_INDEX_MIN_CAPACITY  8
+
+/**
+ * Puts the element at the first free entry starting from the hash position.
+ * The table must have at least one free entry.
+ */
+static void tlm_index_put(tlm_index_entry *entries, uint32_t capacity,
+                          uint32_t hash, const char *name, void *elm)
+{
+    const uint32_t mask = capacity - 1;
+    uint32_t i = hash & mask;
+
+    while (NULL != entries[i].elm) {
+        i = (i + 1) & mask;
+    }
+
+    entries[i].hash = hash;
+    entries[i].name = name;
+    entries[i].elm = elm;
+}
+
+static bool tlm_index_grow(tlm_index *index)
+{
+    const uint32_t capacity = (0 == index->capacity) ? TLM_INDEX_MIN_CAPACITY : (2 * index->capacity);
+    tlm_index_entry *entries = calloc(capacity, sizeof(*entries));
+    uint32_t i = 0;
+
+    if (NULL == entries) {
+        return false;
+    }
+
+    /* Hashes are already stored so re-hashing is just re-positioning the entries */
+    for (i = 0; i < index->capacity; i++) {
+        if (NULL != index->entries[i].elm) {
+            tlm_index_put(entries, capacity, index->entries[i].hash,
+                          index->entries[i].name, index->entries[i].elm);
+        }
+    }
+
+    free(index->entries);
+    index->entries = entries;
+    index->capacity = capacity;
+    return true;
+}
+
+uint32_t tlm_index_hash(const char *name)
+{
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash ^= (uint8_t) *name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+bool tlm_index_insert(tlm_index *index, uint32_t hash, const char *name, void *elm)
+{
+    if (NULL == index || NULL == name || NULL == elm) {
+        return false;
+    }
+
+    /* Keep the table at most 3/4th full to keep the probe sequences short */
+    if (4 * (index->count + 1) > 3 * index->capacity && !tlm_index_grow(index)) {
+        return false;
+    }
+
+    tlm_index_put(index->entries, index->capacity, hash, name, elm);
+    index->count++;
+    return true;
+}
+
+void* tlm_index_find(const tlm_index *index, uint32_t hash, const char *name)
+{
+    uint32_t mask = 0, i = 0;
+
+    if (NULL == index || NULL == name || 0 == index->capacity) {
+        return NULL;
+    }
+
+    mask = index->capacity - 1;
+    for (i = hash & mask; NULL != index->entries[i].elm; i = (i + 1) & mask) {
+        if (hash == index->entries[i].hash && 0 == strcmp(name, index->entries[i].name)) {
+            return index->entries[i].elm;
+        }
+    }
+
+    return NULL;
+}
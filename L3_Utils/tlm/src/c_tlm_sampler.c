@@ -0,0 +1,260 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "timers.h"
+
+#include "c_tlm_sampler.h"
+#include "c_tlm_var.h"
+#include "lpc_sys.h"
+
+
+
+/// A variable being sampled
+typedef struct {
+    const tlm_component *comp;      ///< The component of the variable
+    const tlm_reg_var_type *var;    ///< The registered variable
+    uint16_t size;                  ///< Bytes of one sample
+    uint16_t period_ms;             ///< Sampling period
+    uint32_t next_ms;               ///< Uptime of the next sample
+} tlm_sampler_chan_t;
+
+/** @{ Private members of this file */
+static tlm_sampler_chan_t g_chans[TLM_SAMPLER_MAX_CHANS];
+static uint8_t g_num_chans = 0;
+static uint16_t g_timer_period_ms = 0;
+
+static uint8_t g_ring[TLM_SAMPLER_RING_BYTES];
+static uint32_t g_ring_head = 0;    ///< Index where next sample will be written
+static uint32_t g_ring_tail = 0;    ///< Index of the oldest sample
+static uint32_t g_ring_used = 0;    ///< Bytes used in the ring
+static uint32_t g_ring_samples = 0; ///< Number of samples in the ring
+
+static uint32_t g_overwritten_count = 0;
+static uint32_t g_missed_count = 0;
+
+/// Protects the ring and the channels between the timer task and the other tasks
+static SemaphoreHandle_t g_lock = NULL;
+static TimerHandle_t g_timer = NULL;
+/** @} */
+
+
+
+static void tlm_sampler_ring_reset(void)
+{
+    g_ring_head = g_ring_tail = g_ring_used = g_ring_samples = 0;
+}
+
+static void tlm_sampler_ring_put(const void *data, uint32_t len)
+{
+    const uint8_t *p = (const uint8_t*) data;
+    while (len--) {
+        g_ring[g_ring_head] = *p++;
+        if (++g_ring_head >= sizeof(g_ring)) {
+            g_ring_head = 0;
+        }
+    }
+}
+
+/// Removes the oldest sample from the ring
+static void tlm_sampler_ring_drop(void)
+{
+    const uint32_t size = TLM_SAMPLER_HDR_BYTES + g_chans[g_ring[g_ring_tail]].size;
+
+    g_ring_tail = (g_ring_tail + size) % sizeof(g_ring);
+    g_ring_used -= size;
+    g_ring_samples--;
+    g_overwritten_count++;
+}
+
+static void tlm_sampler_take_sample(uint8_t chan_idx, uint32_t now_ms)
+{
+    const tlm_sampler_chan_t *chan = &g_chans[chan_idx];
+    const uint32_t size = TLM_SAMPLER_HDR_BYTES + chan->size;
+    const uint8_t hdr[TLM_SAMPLER_HDR_BYTES] = { chan_idx,
+                                                 (now_ms >>  0) & 0xFF, (now_ms >>  8) & 0xFF,
+                                                 (now_ms >> 16) & 0xFF, (now_ms >> 24) & 0xFF };
+
+    /* Overwrite the oldest samples to make room */
+    while (sizeof(g_ring) - g_ring_used < size) {
+        tlm_sampler_ring_drop();
+    }
+
+    tlm_sampler_ring_put(hdr, sizeof(hdr));
+    uint8_t data[TLM_SAMPLER_MAX_BYTES];
+    tlm_variable_snapshot(chan->comp, chan->var, data, sizeof(data));
+    tlm_sampler_ring_put(data, chan->size);
+    g_ring_used += size;
+    g_ring_samples++;
+}
+
+static void tlm_sampler_timer_callback(TimerHandle_t timer)
+{
+    const uint32_t now_ms = sys_get_uptime_ms();
+    uint8_t i = 0;
+
+    /* Never block the timer task, just count the missed sample instead */
+    if (!xSemaphoreTake(g_lock, 0)) {
+        ++g_missed_count;
+        return;
+    }
+
+    for (i = 0; i < g_num_chans; i++) {
+        tlm_sampler_chan_t *chan = &g_chans[i];
+        if ((int32_t)(now_ms - chan->next_ms) >= 0) {
+            tlm_sampler_take_sample(i, now_ms);
+
+            /* If we fell behind, do not try to catch up with a burst of samples */
+            chan->next_ms += chan->period_ms;
+            if ((int32_t)(now_ms - chan->next_ms) >= 0) {
+                chan->next_ms = now_ms + chan->period_ms;
+            }
+        }
+    }
+
+    xSemaphoreGive(g_lock);
+}
+
+bool tlm_sampler_add(const char *comp_name, const char *var_name, uint16_t period_ms)
+{
+    const tlm_reg_var_type *var = tlm_variable_get_by_comp_and_name(comp_name, var_name);
+    bool success = false;
+
+    if (NULL == var || 0 == period_ms ||
+        (var->elm_size_bytes * var->elm_arr_size) > TLM_SAMPLER_MAX_BYTES) {
+        return false;
+    }
+
+    if (NULL == g_lock && NULL == (g_lock = xSemaphoreCreateMutex())) {
+        return false;
+    }
+
+    xSemaphoreTake(g_lock, portMAX_DELAY);
+    if (g_num_chans < TLM_SAMPLER_MAX_CHANS)
+    {
+        tlm_sampler_chan_t *chan = &g_chans[g_num_chans++];
+        chan->comp = tlm_component_get_by_name(comp_name);
+        chan->var = var;
+        chan->size = var->elm_size_bytes * var->elm_arr_size;
+        chan->period_ms = period_ms;
+        chan->next_ms = sys_get_uptime_ms();
+
+        tlm_sampler_ring_reset();
+        success = true;
+    }
+    xSemaphoreGive(g_lock);
+
+    /* The timer runs at the fastest rate, and each channel is sampled when it is due */
+    if (success && (0 == g_timer_period_ms || period_ms < g_timer_period_ms)) {
+        const TickType_t ticks = (OS_MS(period_ms) > 0) ? OS_MS(period_ms) : 1;
+        g_timer_period_ms = period_ms;
+
+        if (NULL == g_timer) {
+            g_timer = xTimerCreate("tlm_sampler", ticks, pdTRUE, NULL, tlm_sampler_timer_callback);
+            success = (NULL != g_timer) && xTimerStart(g_timer, 0);
+        }
+        else {
+            /* This also starts the timer if it was stopped by tlm_sampler_clear() */
+            success = xTimerChangePeriod(g_timer, ticks, 0);
+        }
+    }
+
+    return success;
+}
+
+void tlm_sampler_clear(void)
+{
+    if (NULL != g_timer) {
+        xTimerStop(g_timer, 0);
+    }
+
+    if (NULL != g_lock) {
+        xSemaphoreTake(g_lock, portMAX_DELAY);
+        g_num_chans = 0;
+        g_timer_period_ms = 0;
+        tlm_sampler_ring_reset();
+        xSemaphoreGive(g_lock);
+    }
+}
+
+uint32_t tlm_sampler_stream(bin_stream_callback_type stream, void *arg)
+{
+    uint32_t len = strlen("sampler") + 1 + 2;
+    uint32_t count = 0;
+    uint8_t field[5];
+    uint8_t i = 0;
+
+    if (NULL == stream || NULL == g_lock) {
+        return 0;
+    }
+
+    xSemaphoreTake(g_lock, portMAX_DELAY);
+
+    /* Schema of the channels, using same format as tlm_bin_schema record */
+    for (i = 0; i < g_num_chans; i++) {
+        len += strlen(g_chans[i].comp->name) + 1 + strlen(g_chans[i].var->name) + 1 + sizeof(field);
+    }
+    tlm_stream_binary_header(stream, arg, tlm_bin_schema, TLM_SAMPLER_COMP_IDX, len);
+    stream("sampler", strlen("sampler") + 1, arg);
+    field[0] = g_num_chans;
+    field[1] = 0;
+    stream(field, 2, arg);
+
+    for (i = 0; i < g_num_chans; i++) {
+        const tlm_reg_var_type *var = g_chans[i].var;
+        field[0] = (var->elm_size_bytes & 0xFF);
+        field[1] = (var->elm_size_bytes >> 8) & 0xFF;
+        field[2] = (var->elm_arr_size & 0xFF);
+        field[3] = (var->elm_arr_size >> 8) & 0xFF;
+        field[4] = (uint8_t) var->elm_type;
+        stream(g_chans[i].comp->name, strlen(g_chans[i].comp->name), arg);
+        stream(".", 1, arg);
+        stream(var->name, strlen(var->name) + 1, arg);
+        stream(field, sizeof(field), arg);
+    }
+
+    /* The samples may wrap around the end of the ring */
+    tlm_stream_binary_header(stream, arg, tlm_bin_samples, TLM_SAMPLER_COMP_IDX, g_ring_used);
+    if (g_ring_used > 0) {
+        const uint32_t first = (g_ring_tail + g_ring_used <= sizeof(g_ring)) ?
+                               g_ring_used : (sizeof(g_ring) - g_ring_tail);
+        stream(&g_ring[g_ring_tail], first, arg);
+        if (first < g_ring_used) {
+            stream(&g_ring[0], g_ring_used - first, arg);
+        }
+    }
+
+    count = g_ring_samples;
+    tlm_sampler_ring_reset();
+    xSemaphoreGive(g_lock);
+
+    return count;
+}
+
+uint32_t tlm_sampler_get_overwritten_count(void)
+{
+    return g_overwritten_count;
+}
+
+uint32_t tlm_sampler_get_missed_count(void)
+{
+    return g_missed_count;
+}
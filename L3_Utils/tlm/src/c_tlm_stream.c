@@ -20,8 +20,10 @@
 
 #include "c_tlm_stream.h"
 #include "c_tlm_var.h"
+#include "c_tlm_binary.h"
+#include "crc.h"
 #include <string.h>     /* strlen() etc. */
-#include <stdlib.h>     /* atoi() */
+#include <stdlib.h>     /* atoi() malloc() */
 #include <ctype.h>      /* tolower() isdigit() etc. */
 #include <inttypes.h>
 
@@ -50,20 +52,23 @@ static void tlm_stream_file_ptr(const char *str, void *fptr)
 }
 
 /**
- * Callback function for each component's variables
+ * Streams one of the component's variables
  */
-static bool tlm_stream_for_each_component_var(void *elm_ptr, void *arg1, void *arg2, void *print_ascii)
+static void tlm_stream_component_var(const tlm_component *comp, const tlm_reg_var_type *reg_var,
+                                     stream_callback_type stream, void *stream_arg, void *print_ascii)
 {
     char buff[256];
-    tlm_reg_var_type *var = elm_ptr;
-    stream_callback_type stream = arg1;
-    void *stream_arg = arg2;
-    char *p = (char*)(var->data_ptr);
+    uint64_t data[TLM_SNAPSHOT_MAX_BYTES / sizeof(uint64_t)];
+    tlm_reg_var_type snap = *reg_var;
+    const tlm_reg_var_type *var = &snap;
+    const char *p = NULL;
     uint32_t i = 0;
 
-    if (NULL == stream || NULL == var) {
-        return false;
+    /* Stream a copy of the variable if it is small enough, so it is not half updated */
+    if (tlm_variable_snapshot(comp, reg_var, data, sizeof(data))) {
+        snap.data_ptr = data;
     }
+    p = (const char*)(var->data_ptr);
 
     stream((var->name), stream_arg);
     stream(":", stream_arg);
@@ -94,8 +99,6 @@ static bool tlm_stream_for_each_component_var(void *elm_ptr, void *arg1, void *a
     }
 
     stream("\n", stream_arg);
-
-    return true;
 }
 
 static bool tlm_stream_decode(FILE *file, tlm_component *p_comp)
@@ -180,7 +183,7 @@ void tlm_stream_one(tlm_component *comp, stream_callback_type stream, void *prin
 
     /* sca : stream callback argument */
     char buff[16] = { 0 };
-    sprintf(buff, "%u\n", (unsigned int)c_list_node_count((comp->var_list)));
+    sprintf(buff, "%u\n", (unsigned int)tlm_variable_count(comp));
 
     /* Send: "START:<name>:<#>\n" */
     stream("START:", sca);
@@ -188,14 +191,15 @@ void tlm_stream_one(tlm_component *comp, stream_callback_type stream, void *prin
     stream(":", sca);
     stream(buff, sca);
 
-    /* Now for each variable list of this component, make a call-back to our
-     * component for each function that will stream data of each variable
-     */
-    c_list_for_each_elm((comp->var_list), tlm_stream_for_each_component_var,
-                        stream,     /* arg1 */
-                        sca,        /* arg2 */
-                        print_ascii /* arg3 */
-                        );
+    /* Now stream the data of each variable of this component */
+    void *hint = 0;
+    const tlm_reg_var_type *var = NULL;
+    uint32_t i = 0;
+    for (i = 0; i < tlm_variable_count(comp); i++) {
+        if (NULL != (var = tlm_variable_get_at(comp, i, &hint))) {
+            tlm_stream_component_var(comp, var, stream, sca, print_ascii);
+        }
+    }
 
     /* Send: "END:<name>\n" */
     stream("END:", sca);
@@ -308,3 +312,476 @@ bool tlm_stream_decode_file(FILE *file)
     /* success only changed to true if we got atleast one "START" in the file */
     return success;
 }
+
+
+
+/* Binary stream functions */
+
+/// Arguments of tlm_stream_all_binary() passed to each component's callback
+typedef struct {
+    bin_stream_callback_type stream;
+    void *arg;
+    char *prev;         ///< Previous snapshot of all components (optional)
+    uint32_t offset;    ///< Offset of the current component in prev
+    uint8_t comp_idx;   ///< The index of the current component in the stream
+    bool delta;
+} tlm_bin_stream_args_t;
+
+/// Maximum number of variables per component that can be delta encoded (8 per byte)
+#define TLM_BIN_MAX_BITMAP_BYTES    32
+
+/// The file being written by tlm_bin_file_ptr()
+typedef struct {
+    FILE *file;
+    uint32_t crc;       ///< The CRC32 of the bytes written to the file
+} tlm_bin_file_t;
+
+static void tlm_bin_file_ptr(const void *data, uint32_t len, void *arg)
+{
+    tlm_bin_file_t *f = (tlm_bin_file_t*) arg;
+    fwrite(data, 1, len, f->file);
+    f->crc = crc32_update(f->crc, data, len);
+}
+
+static inline uint32_t tlm_bin_var_size(const tlm_reg_var_type *var)
+{
+    return (var->elm_size_bytes) * (var->elm_arr_size);
+}
+
+static void tlm_bin_stream_header(tlm_bin_stream_args_t *a, tlm_bin_record_type type, uint32_t len)
+{
+    tlm_stream_binary_header(a->stream, a->arg, type, a->comp_idx, len);
+}
+
+/// Streams the payload of the schema record of the component
+static void tlm_bin_stream_schema_fields(tlm_component *comp, bin_stream_callback_type stream, void *arg)
+{
+    void *hint = 0;
+    const tlm_reg_var_type *var = NULL;
+    const uint32_t count = tlm_variable_count(comp);
+    uint8_t field[5];
+    uint32_t i = 0;
+
+    stream(comp->name, strlen(comp->name) + 1, arg);
+    field[0] = (count & 0xFF);
+    field[1] = (count >> 8) & 0xFF;
+    stream(field, 2, arg);
+
+    for (i = 0; i < count; i++) {
+        if (NULL != (var = tlm_variable_get_at(comp, i, &hint))) {
+            field[0] = (var->elm_size_bytes & 0xFF);
+            field[1] = (var->elm_size_bytes >> 8) & 0xFF;
+            field[2] = (var->elm_arr_size & 0xFF);
+            field[3] = (var->elm_arr_size >> 8) & 0xFF;
+            field[4] = (uint8_t) var->elm_type;
+            stream(var->name, strlen(var->name) + 1, arg);
+            stream(field, sizeof(field), arg);
+        }
+    }
+}
+
+static void tlm_bin_stream_schema(tlm_component *comp, tlm_bin_stream_args_t *a)
+{
+    void *hint = 0;
+    const tlm_reg_var_type *var = NULL;
+    const uint32_t count = tlm_variable_count(comp);
+    uint32_t len = strlen(comp->name) + 1 + 2;
+    uint32_t i = 0;
+
+    for (i = 0; i < count; i++) {
+        if (NULL != (var = tlm_variable_get_at(comp, i, &hint))) {
+            len += strlen(var->name) + 1 + 5;
+        }
+    }
+
+    tlm_bin_stream_header(a, tlm_bin_schema, len);
+    tlm_bin_stream_schema_fields(comp, a->stream, a->arg);
+}
+
+static void tlm_bin_crc_ptr(const void *data, uint32_t len, void *arg)
+{
+    uint32_t *crc = (uint32_t*) arg;
+    *crc = crc32_update(*crc, data, len);
+}
+
+/**
+ * @returns The CRC32 of the schema record payload of the component, which is the hash of
+ *          the layout of its data records.
+ */
+static uint32_t tlm_bin_schema_crc(tlm_component *comp)
+{
+    uint32_t crc = 0;
+    tlm_bin_stream_schema_fields(comp, tlm_bin_crc_ptr, &crc);
+    return crc;
+}
+
+/**
+ * Streams the data of all the variables
+ * @param prev  If not NULL, the component is copied to this previous snapshot, and then the
+ *              copy is streamed, so the streamed data is not half updated
+ */
+static void tlm_bin_stream_data(tlm_component *comp, tlm_bin_stream_args_t *a, uint32_t size, char *prev)
+{
+    void *hint = 0;
+    const tlm_reg_var_type *var = NULL;
+    const uint32_t count = tlm_variable_count(comp);
+    uint32_t i = 0;
+    uint64_t data[TLM_SNAPSHOT_MAX_BYTES / sizeof(uint64_t)];
+
+    tlm_bin_stream_header(a, tlm_bin_data, size);
+    if (NULL != prev) {
+        tlm_binary_get_one(comp, prev);
+        a->stream(prev, size, a->arg);
+        return;
+    }
+
+    /* Without a snapshot, only each variable small enough to be copied is consistent */
+    for (i = 0; i < count; i++) {
+        if (NULL != (var = tlm_variable_get_at(comp, i, &hint))) {
+            if (tlm_variable_snapshot(comp, var, data, sizeof(data))) {
+                a->stream(data, tlm_bin_var_size(var), a->arg);
+            }
+            else {
+                a->stream(var->data_ptr, tlm_bin_var_size(var), a->arg);
+            }
+        }
+    }
+}
+
+/**
+ * Streams only the variables that differ from the previous snapshot
+ * @returns false if the component has too many variables to be delta encoded
+ */
+static bool tlm_bin_stream_delta(tlm_component *comp, tlm_bin_stream_args_t *a, char *prev)
+{
+    void *hint = 0;
+    const tlm_reg_var_type *var = NULL;
+    const uint32_t count = tlm_variable_count(comp);
+    const uint32_t bitmap_bytes = (count + 7) / 8;
+    uint8_t bitmap[TLM_BIN_MAX_BITMAP_BYTES] = { 0 };
+    uint32_t len = bitmap_bytes;
+    uint32_t offset = 0, size = 0, i = 0;
+
+    if (bitmap_bytes > sizeof(bitmap)) {
+        return false;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (NULL != (var = tlm_variable_get_at(comp, i, &hint))) {
+            size = tlm_bin_var_size(var);
+            if (0 != memcmp(prev + offset, var->data_ptr, size)) {
+                bitmap[i / 8] |= (1 << (i % 8));
+                len += size;
+            }
+            offset += size;
+        }
+    }
+
+    tlm_bin_stream_header(a, tlm_bin_delta, len);
+    a->stream(bitmap, bitmap_bytes, a->arg);
+
+    hint = 0;
+    offset = 0;
+    for (i = 0; i < count; i++) {
+        if (NULL != (var = tlm_variable_get_at(comp, i, &hint))) {
+            size = tlm_bin_var_size(var);
+            /* Copy the changed variable to the previous snapshot, and stream the copy */
+            if (bitmap[i / 8] & (1 << (i % 8))) {
+                tlm_variable_snapshot(comp, var, prev + offset, size);
+                a->stream(prev + offset, size, a->arg);
+            }
+            offset += size;
+        }
+    }
+
+    return true;
+}
+
+static void tlm_bin_stream_comp(tlm_component *comp, tlm_bin_stream_args_t *a)
+{
+    const uint32_t size = tlm_binary_get_size_one(comp);
+    char *prev = (NULL == a->prev) ? NULL : (a->prev + a->offset);
+
+    /* Record length is 16-bit, so we cannot stream a component this large */
+    if (size > 0xFFFF) {
+        return;
+    }
+
+    if (a->delta && NULL != prev) {
+        /* Nothing to send if nothing changed */
+        if (tlm_binary_compare_one(comp, prev) || tlm_bin_stream_delta(comp, a, prev)) {
+            return;
+        }
+    }
+
+    tlm_bin_stream_schema(comp, a);
+    tlm_bin_stream_data(comp, a, size, prev);
+}
+
+static void tlm_stream_all_binary_args(tlm_component *comp_ptr, void *arg1, void *arg2)
+{
+    tlm_bin_stream_args_t *a = (tlm_bin_stream_args_t*) arg1;
+
+    tlm_bin_stream_comp(comp_ptr, a);
+    a->offset += tlm_binary_get_size_one(comp_ptr);
+    a->comp_idx++;
+}
+
+void tlm_stream_binary_header(bin_stream_callback_type stream, void *arg,
+                              tlm_bin_record_type type, uint8_t comp_idx, uint16_t len)
+{
+    const uint8_t header[TLM_BIN_HEADER_SIZE] = { type, comp_idx, (len & 0xFF), (len >> 8) & 0xFF };
+    stream(header, sizeof(header), arg);
+}
+
+void tlm_stream_one_binary(tlm_component *comp, bin_stream_callback_type stream, void *arg,
+                           char *prev, bool delta)
+{
+    tlm_bin_stream_args_t a = { stream, arg, prev, 0, 0, delta };
+    if (NULL != comp && NULL != stream) {
+        tlm_bin_stream_comp(comp, &a);
+    }
+}
+
+void tlm_stream_all_binary(bin_stream_callback_type stream, void *arg, char *prev, bool delta)
+{
+    tlm_bin_stream_args_t a = { stream, arg, prev, 0, 0, delta };
+    if (NULL != stream) {
+        tlm_component_for_each((tlm_comp_callback)tlm_stream_all_binary_args, &a, NULL);
+    }
+}
+
+void tlm_stream_binary_check(bin_stream_callback_type stream, void *arg, uint32_t crc)
+{
+    const uint8_t check[4] = { (crc & 0xFF), (crc >> 8) & 0xFF, (crc >> 16) & 0xFF, (crc >> 24) & 0xFF };
+    tlm_stream_binary_header(stream, arg, tlm_bin_check, 0, sizeof(check));
+    stream(check, sizeof(check), arg);
+}
+
+void tlm_stream_one_binary_file(tlm_component *comp_ptr, FILE *file)
+{
+    tlm_bin_file_t f = { file, 0 };
+    if (file) {
+        tlm_stream_one_binary(comp_ptr, tlm_bin_file_ptr, &f, NULL, false);
+        tlm_stream_binary_check(tlm_bin_file_ptr, &f, f.crc);
+    }
+}
+
+/**
+ * The schema of the component being decoded by tlm_stream_decode_binary_file()
+ * If the schema hash is the same as the registered layout, the data records are copied
+ * to the variables in order without the vars and the sizes.
+ */
+typedef struct {
+    tlm_component *comp;            ///< The component if its layout is the same as the schema
+    const tlm_reg_var_type **vars;  ///< Registered variable of each stream variable, or NULL
+    uint32_t *sizes;                ///< Size of each stream variable
+    uint32_t count;                 ///< Number of variables in the stream
+    uint8_t comp_idx;               ///< Component index of the schema
+} tlm_bin_schema_t;
+
+static void tlm_bin_free_schema(tlm_bin_schema_t *s)
+{
+    free(s->vars);
+    free(s->sizes);
+    s->comp = NULL;
+    s->vars = NULL;
+    s->sizes = NULL;
+    s->count = 0;
+}
+
+static bool tlm_bin_decode_schema(tlm_bin_schema_t *s, uint8_t comp_idx, const char *p, uint32_t len)
+{
+    const char *end = p + len;
+    tlm_component *comp = NULL;
+    const tlm_reg_var_type *var = NULL;
+    uint32_t i = 0;
+
+    tlm_bin_free_schema(s);
+
+    /* Component name followed by 2 bytes of variable count */
+    const uint32_t name_len = strnlen(p, len) + 1;
+    if (name_len + 2 > len) {
+        return false;
+    }
+    comp = tlm_component_get_by_name(p);
+    s->count = (uint8_t)p[name_len] | ((uint8_t)p[name_len + 1] << 8);
+    s->comp_idx = comp_idx;
+
+    /* No need to look up each variable if the registered variables were saved */
+    if (NULL != comp && crc32_update(0, p, len) == tlm_bin_schema_crc(comp)) {
+        s->comp = comp;
+        return true;
+    }
+    p += name_len + 2;
+
+    s->vars = calloc(s->count, sizeof(*s->vars));
+    s->sizes = calloc(s->count, sizeof(*s->sizes));
+    if (s->count > 0 && (NULL == s->vars || NULL == s->sizes)) {
+        tlm_bin_free_schema(s);
+        return false;
+    }
+
+    for (i = 0; i < s->count; i++) {
+        const uint32_t var_len = strnlen(p, end - p) + 1;
+        if (p + var_len + 5 > end) {
+            tlm_bin_free_schema(s);
+            return false;
+        }
+
+        const uint8_t *f = (const uint8_t*) (p + var_len);
+        s->sizes[i] = (f[0] | (f[1] << 8)) * (f[2] | (f[3] << 8));
+
+        /* Only restore the variable if it is still registered with the same size */
+        var = (NULL == comp) ? NULL : tlm_variable_get_by_name(comp, p);
+        if (NULL != var && tlm_bin_var_size(var) == s->sizes[i]) {
+            s->vars[i] = var;
+        }
+        p += var_len + 5;
+    }
+
+    return true;
+}
+
+/**
+ * Decodes the data or the delta record
+ * @param bitmap  The bitmap of delta record, or NULL if all variables are present
+ */
+static bool tlm_bin_decode_data(tlm_bin_schema_t *s, const uint8_t *bitmap, const char *p, uint32_t len)
+{
+    const char *end = p + len;
+    void *hint = 0;
+    const tlm_reg_var_type *var = NULL;
+    uint32_t i = 0, size = 0;
+
+    for (i = 0; i < s->count; i++) {
+        if (NULL != s->comp) {
+            var = tlm_variable_get_at(s->comp, i, &hint);
+            size = tlm_bin_var_size(var);
+        }
+        else {
+            var = s->vars[i];
+            size = s->sizes[i];
+        }
+
+        if (NULL != bitmap && !(bitmap[i / 8] & (1 << (i % 8)))) {
+            continue;
+        }
+        if (p + size > end) {
+            return false;
+        }
+        if (NULL != var) {
+            memcpy((char*)(var->data_ptr), p, size);
+        }
+        p += size;
+    }
+
+    return true;
+}
+
+/**
+ * Checks the records of the file against its check records.
+ * @returns The file offset after the last correct check record, or -1 if the file has no check
+ *          records.  The file position is restored to start.
+ */
+static long tlm_bin_checked_end(FILE *file, long start)
+{
+    uint8_t header[TLM_BIN_HEADER_SIZE];
+    uint8_t chunk[64];
+    uint32_t crc = 0;
+    long end = -1;
+    bool have_check = false;
+    bool ok = true;
+
+    while (ok && sizeof(header) == fread(header, 1, sizeof(header), file)) {
+        uint32_t len = header[2] | (header[3] << 8);
+
+        if (tlm_bin_check == header[0]) {
+            have_check = true;
+            ok = (sizeof(uint32_t) == len && len == fread(chunk, 1, len, file) &&
+                  crc == (chunk[0] | (chunk[1] << 8) | (chunk[2] << 16) | ((uint32_t) chunk[3] << 24)));
+            if (ok) {
+                end = ftell(file);
+                crc = 0;
+            }
+            continue;
+        }
+
+        crc = crc32_update(crc, header, sizeof(header));
+        while (ok && len > 0) {
+            const uint32_t n = (len < sizeof(chunk)) ? len : sizeof(chunk);
+            ok = (n == fread(chunk, 1, n, file));
+            crc = crc32_update(crc, chunk, n);
+            len -= n;
+        }
+    }
+
+    fseek(file, start, SEEK_SET);
+    return (have_check && end < 0) ? start : end;
+}
+
+bool tlm_stream_decode_binary_file(FILE *file)
+{
+    tlm_bin_schema_t schema = { NULL, NULL, NULL, 0, 0 };
+    bool have_schema = false;
+    bool success = true;
+    uint8_t header[TLM_BIN_HEADER_SIZE];
+    char *payload = NULL;
+    const long start = ftell(file);
+
+    /* Check the first record to make sure this is a binary stream */
+    if (sizeof(header) != fread(header, 1, sizeof(header), file) || tlm_bin_schema != header[0]) {
+        fseek(file, start, SEEK_SET);
+        return false;
+    }
+
+    /* Nothing is decoded if even the first write is not complete */
+    fseek(file, start, SEEK_SET);
+    const long end = tlm_bin_checked_end(file, start);
+    if (end == start) {
+        return false;
+    }
+    fseek(file, start + sizeof(header), SEEK_SET);
+
+    do {
+        const uint32_t len = header[2] | (header[3] << 8);
+        const uint32_t bitmap_bytes = (schema.count + 7) / 8;
+
+        if (NULL == (payload = malloc(len + 1)) || len != fread(payload, 1, len, file)) {
+            success = false;
+            break;
+        }
+
+        switch (header[0]) {
+            case tlm_bin_schema:
+                have_schema = success = tlm_bin_decode_schema(&schema, header[1], payload, len);
+                break;
+
+            /* Skip the data of the components we don't have the schema for */
+            case tlm_bin_data:
+                if (have_schema && schema.comp_idx == header[1]) {
+                    success = tlm_bin_decode_data(&schema, NULL, payload, len);
+                }
+                break;
+
+            case tlm_bin_delta:
+                if (have_schema && schema.comp_idx == header[1]) {
+                    success = (len >= bitmap_bytes) &&
+                              tlm_bin_decode_data(&schema, (uint8_t*)payload,
+                                                  payload + bitmap_bytes, len - bitmap_bytes);
+                }
+                break;
+
+            default:
+                break;
+        }
+
+        free(payload);
+        payload = NULL;
+    } while (success && (end < 0 || ftell(file) < end) &&
+             sizeof(header) == fread(header, 1, sizeof(header), file));
+
+    free(payload);
+    tlm_bin_free_schema(&schema);
+    return success;
+}
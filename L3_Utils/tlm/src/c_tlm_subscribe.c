@@ -0,0 +1,351 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "timers.h"
+
+#include "c_tlm_subscribe.h"
+#include "c_tlm_var.h"
+#include "lpc_sys.h"
+
+
+
+/// A subscriber of the changes
+typedef struct {
+    bin_stream_callback_type stream;    ///< The stream function, or NULL if the subscriber is free
+    void *arg;                          ///< The argument of the stream function
+    uint16_t frame_bytes;               ///< Max size of a record of changes
+} tlm_subscriber_t;
+
+/// A variable subscribed by a subscriber
+typedef struct {
+    const tlm_component *comp;          ///< The component of the variable
+    const tlm_reg_var_type *var;        ///< The registered variable, or NULL if the entry is free
+    float deadband;                     ///< Scalar numbers are pushed if they moved by more than this
+    uint16_t min_interval_ms;           ///< Min time between the pushes of the variable
+    uint8_t sub;                        ///< The subscriber of the variable
+    uint8_t comp_idx;                   ///< Component index of the binary telemetry stream
+    uint8_t var_idx;                    ///< Variable index of the binary telemetry stream
+    uint8_t size;                       ///< Bytes of the value
+    bool pushed;                        ///< Set once the first value was pushed
+    uint32_t seq;                       ///< The seq of the component when the variable was compared
+    uint32_t pushed_ms;                 ///< Uptime of the last push of the variable
+    uint8_t value[TLM_SUB_MAX_BYTES];   ///< The value last pushed to the subscriber
+} tlm_sub_var_t;
+
+/** @{ Private members of this file */
+static tlm_subscriber_t g_subs[TLM_SUB_MAX_SUBSCRIBERS];
+static tlm_sub_var_t g_vars[TLM_SUB_MAX_VARS];
+static uint8_t g_frame[TLM_SUB_FRAME_BYTES];
+static uint32_t g_pushed_count = 0;
+
+/// Protects the subscribers and the variables between the timer task and the other tasks
+static SemaphoreHandle_t g_lock = NULL;
+static TimerHandle_t g_timer = NULL;
+/** @} */
+
+
+
+/**
+ * Gets the value of a scalar number to compare it to the deadband.
+ * @returns false if the variable is not a scalar number
+ */
+static bool tlm_sub_get_number(const tlm_reg_var_type *var, const void *data, float *num)
+{
+    const uint32_t size = var->elm_size_bytes;
+    int32_t i = 0;
+    uint32_t u = 0;
+    float f = 0;
+    double d = 0;
+
+    if (1 != var->elm_arr_size) {
+        return false;
+    }
+
+    /* The data is copied since it may not be aligned */
+    if (tlm_int == var->elm_type || tlm_uint == var->elm_type) {
+        if (1 == size) {
+            u = *(const uint8_t*) data;
+            i = (int8_t) u;
+        }
+        else if (2 == size) {
+            uint16_t u16 = 0;
+            memcpy(&u16, data, sizeof(u16));
+            u = u16;
+            i = (int16_t) u16;
+        }
+        else if (4 == size) {
+            memcpy(&u, data, sizeof(u));
+            i = (int32_t) u;
+        }
+        else {
+            return false;
+        }
+        *num = (tlm_int == var->elm_type) ? (float) i : (float) u;
+    }
+    else if (tlm_float == var->elm_type && sizeof(f) == size) {
+        memcpy(&f, data, sizeof(f));
+        *num = f;
+    }
+    else if (tlm_double == var->elm_type && sizeof(d) == size) {
+        memcpy(&d, data, sizeof(d));
+        *num = (float) d;
+    }
+    else {
+        return false;
+    }
+
+    return true;
+}
+
+/// @returns true if the data should be pushed against the value last pushed
+static bool tlm_sub_changed(const tlm_sub_var_t *v, const void *data)
+{
+    float now = 0;
+    float last = 0;
+
+    if (v->deadband > 0 &&
+        tlm_sub_get_number(v->var, data, &now) && tlm_sub_get_number(v->var, v->value, &last)) {
+        return ((now > last) ? (now - last) : (last - now)) > v->deadband;
+    }
+
+    return (0 != memcmp(data, v->value, v->size));
+}
+
+/// Pushes the record of len bytes in g_frame[] to the subscriber
+static void tlm_sub_flush(const tlm_subscriber_t *sub, uint32_t len, uint32_t now_ms)
+{
+    const uint16_t payload = len - TLM_BIN_HEADER_SIZE;
+
+    g_frame[0] = tlm_bin_changes;
+    g_frame[1] = 0;
+    g_frame[2] = (payload >> 0) & 0xFF;
+    g_frame[3] = (payload >> 8) & 0xFF;
+    g_frame[4] = (now_ms >>  0) & 0xFF;
+    g_frame[5] = (now_ms >>  8) & 0xFF;
+    g_frame[6] = (now_ms >> 16) & 0xFF;
+    g_frame[7] = (now_ms >> 24) & 0xFF;
+
+    sub->stream(g_frame, len, sub->arg);
+    ++g_pushed_count;
+}
+
+static void tlm_sub_push_changes(uint8_t sub_idx, uint32_t now_ms)
+{
+    const tlm_subscriber_t *sub = &g_subs[sub_idx];
+    uint8_t data[TLM_SUB_MAX_BYTES];
+    uint32_t len = 0;
+    uint8_t i = 0;
+
+    for (i = 0; i < TLM_SUB_MAX_VARS; i++)
+    {
+        tlm_sub_var_t *v = &g_vars[i];
+        if (NULL == v->var || sub_idx != v->sub) {
+            continue;
+        }
+
+        /* A change while the interval is not over is pushed once it is over */
+        if (v->pushed && (now_ms - v->pushed_ms) < v->min_interval_ms) {
+            continue;
+        }
+
+        /* The variable cannot have changed if its component marks the updates, and was not updated */
+        const uint32_t seq = v->comp->seq;
+        if (v->pushed && 0 != seq && seq == v->seq) {
+            continue;
+        }
+
+        tlm_variable_snapshot(v->comp, v->var, data, sizeof(data));
+        v->seq = seq;
+        if (v->pushed && !tlm_sub_changed(v, data)) {
+            continue;
+        }
+
+        if (len + TLM_SUB_VAR_HDR_BYTES + v->size > sub->frame_bytes) {
+            tlm_sub_flush(sub, len, now_ms);
+            len = 0;
+        }
+        if (0 == len) {
+            len = TLM_BIN_HEADER_SIZE + TLM_SUB_HDR_BYTES;
+        }
+
+        g_frame[len++] = v->comp_idx;
+        g_frame[len++] = v->var_idx;
+        g_frame[len++] = v->size;
+        memcpy(&g_frame[len], data, v->size);
+        len += v->size;
+
+        memcpy(v->value, data, v->size);
+        v->pushed = true;
+        v->pushed_ms = now_ms;
+    }
+
+    if (len > 0) {
+        tlm_sub_flush(sub, len, now_ms);
+    }
+}
+
+static void tlm_sub_timer_callback(TimerHandle_t timer)
+{
+    const uint32_t now_ms = sys_get_uptime_ms();
+    uint8_t i = 0;
+
+    /* Never block the timer task, the changes are pushed the next time instead */
+    if (!xSemaphoreTake(g_lock, 0)) {
+        return;
+    }
+
+    for (i = 0; i < TLM_SUB_MAX_SUBSCRIBERS; i++) {
+        if (NULL != g_subs[i].stream) {
+            tlm_sub_push_changes(i, now_ms);
+        }
+    }
+
+    xSemaphoreGive(g_lock);
+}
+
+int tlm_subscribe_open(bin_stream_callback_type stream, void *arg, uint16_t frame_bytes)
+{
+    int sub = -1;
+    int i = 0;
+
+    if (NULL == stream) {
+        return -1;
+    }
+    if (NULL == g_lock && NULL == (g_lock = xSemaphoreCreateMutex())) {
+        return -1;
+    }
+
+    xSemaphoreTake(g_lock, portMAX_DELAY);
+    for (i = 0; i < TLM_SUB_MAX_SUBSCRIBERS; i++) {
+        if (stream == g_subs[i].stream && arg == g_subs[i].arg) {
+            sub = i;
+            break;
+        }
+        if (sub < 0 && NULL == g_subs[i].stream) {
+            sub = i;
+        }
+    }
+
+    if (sub >= 0) {
+        g_subs[sub].stream = stream;
+        g_subs[sub].arg = arg;
+        g_subs[sub].frame_bytes = (frame_bytes < TLM_SUB_FRAME_BYTES) ? frame_bytes : TLM_SUB_FRAME_BYTES;
+    }
+    xSemaphoreGive(g_lock);
+
+    return sub;
+}
+
+bool tlm_subscribe_add(int sub, const char *comp_name, const char *var_name,
+                       float deadband, uint16_t min_interval_ms)
+{
+    const tlm_reg_var_type *var = tlm_variable_get_by_comp_and_name(comp_name, var_name);
+    uint32_t comp_idx = 0;
+    uint32_t var_idx = 0;
+    tlm_sub_var_t *v = NULL;
+    uint8_t i = 0;
+
+    if (sub < 0 || sub >= TLM_SUB_MAX_SUBSCRIBERS || NULL == g_lock || NULL == var ||
+        !tlm_variable_get_indexes(comp_name, var_name, &comp_idx, &var_idx) ||
+        comp_idx > 0xFF || var_idx > 0xFF) {
+        return false;
+    }
+
+    const uint32_t size = var->elm_size_bytes * var->elm_arr_size;
+    if (size > TLM_SUB_MAX_BYTES) {
+        return false;
+    }
+
+    xSemaphoreTake(g_lock, portMAX_DELAY);
+
+    /* The value has to fit a record of the subscriber */
+    if (NULL == g_subs[sub].stream ||
+        TLM_BIN_HEADER_SIZE + TLM_SUB_HDR_BYTES + TLM_SUB_VAR_HDR_BYTES + size > g_subs[sub].frame_bytes) {
+        xSemaphoreGive(g_lock);
+        return false;
+    }
+
+    /* Subscribing to the same variable again changes its deadband and interval */
+    for (i = 0; i < TLM_SUB_MAX_VARS; i++) {
+        if (var == g_vars[i].var && sub == g_vars[i].sub) {
+            v = &g_vars[i];
+            break;
+        }
+        if (NULL == v && NULL == g_vars[i].var) {
+            v = &g_vars[i];
+        }
+    }
+
+    if (NULL != v) {
+        v->comp = tlm_component_get_by_name(comp_name);
+        v->var = var;
+        v->deadband = deadband;
+        v->min_interval_ms = min_interval_ms;
+        v->sub = sub;
+        v->comp_idx = comp_idx;
+        v->var_idx = var_idx;
+        v->size = size;
+        v->pushed = false;
+    }
+    xSemaphoreGive(g_lock);
+
+    if (NULL == v) {
+        return false;
+    }
+
+    /* This also starts the timer if it was stopped by tlm_subscribe_close() */
+    if (NULL == g_timer) {
+        const TickType_t ticks = (OS_MS(TLM_SUB_CHECK_MS) > 0) ? OS_MS(TLM_SUB_CHECK_MS) : 1;
+        g_timer = xTimerCreate("tlm_sub", ticks, pdTRUE, NULL, tlm_sub_timer_callback);
+    }
+    return (NULL != g_timer) && xTimerStart(g_timer, 0);
+}
+
+void tlm_subscribe_close(int sub)
+{
+    bool any_vars = false;
+    uint8_t i = 0;
+
+    if (sub < 0 || sub >= TLM_SUB_MAX_SUBSCRIBERS || NULL == g_lock) {
+        return;
+    }
+
+    xSemaphoreTake(g_lock, portMAX_DELAY);
+    for (i = 0; i < TLM_SUB_MAX_VARS; i++) {
+        if (sub == g_vars[i].sub) {
+            g_vars[i].var = NULL;
+        }
+        any_vars |= (NULL != g_vars[i].var);
+    }
+    g_subs[sub].stream = NULL;
+    g_subs[sub].arg = NULL;
+    xSemaphoreGive(g_lock);
+
+    if (!any_vars && NULL != g_timer) {
+        xTimerStop(g_timer, 0);
+    }
+}
+
+uint32_t tlm_subscribe_get_pushed_count(void)
+{
+    return g_pushed_count;
+}
@@ -24,30 +24,98 @@
 #include <inttypes.h>
 
 #include "c_tlm_var.h"
+#include "printf_lib.h"  /* fmt_snprintf() */
 
 
+/**
+ * Variables are allocated in blocks rather than one at a time because they are never
+ * unregistered.  This saves the malloc overhead per variable, and keeps the variables
+ * of a component mostly contiguous in memory.
+ */
+#define TLM_VAR_ALLOC_BLOCK     16
+
+/** Private members of this file */
+static tlm_reg_var_type *mp_var_block = NULL;
+static uint32_t m_var_block_free = 0;
+
+/**
+ * The variables of TLM_DEFINE_VAR() sorted by "<comp>.<var>" by the linker @see loader.ld
+ * The symbols are weak, so a build without the section of loader.ld, such as the host
+ * benchmarks, links with both of them at zero, and has no static variables.
+ */
+extern const tlm_static_var_type __tlm_vars_start[] __attribute__((weak));
+extern const tlm_static_var_type __tlm_vars_end[] __attribute__((weak));
+
+/**
+ * Private function of this file
+ * Compares "<comp>.<var>" of a static variable to "<comp_name>." in the order of strcmp(), which
+ * is the order that the linker sorted the section names by.
+ */
+static int tlm_variable_static_cmp(const tlm_static_var_type *s, const char *comp_name)
+{
+    const char *a = s->comp_name;
+    const char *b = comp_name;
+
+    while ('\0' != *a && *a == *b) {
+        ++a;
+        ++b;
+    }
+
+    /* The same component, so "<comp>.<var>" comes after "<comp>." */
+    if ('\0' == *a && '\0' == *b) {
+        return 1;
+    }
+
+    /* The end of either component name is followed by a '.' */
+    return (int) (uint8_t) ('\0' == *a ? '.' : *a) - (int) (uint8_t) ('\0' == *b ? '.' : *b);
+}
+
 /** Private function of this file */
-static bool tlm_variable_check_dup(void *elm_ptr, void *arg1,
-                                     void *arg2, void *arg3)
+static const tlm_reg_var_type* tlm_variable_find_static(const tlm_component *comp_ptr, const char *name)
 {
-    tlm_reg_var_type *reg_var = elm_ptr;
-    tlm_reg_var_type *new_var = arg1;
+    const tlm_static_var_type *vars = &__tlm_vars_start[comp_ptr->static_first];
+    uint32_t lo = 0;
+    uint32_t hi = comp_ptr->static_count;
+
+    /* The variables of a component are sorted by their names */
+    while (lo < hi) {
+        const uint32_t mid = (lo + hi) / 2;
+        const int cmp = strcmp(vars[mid].var.name, name);
+        if (0 == cmp) {
+            return &vars[mid].var;
+        }
+        else if (cmp < 0) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return NULL;
+}
 
-    return (reg_var->data_ptr != new_var->data_ptr &&
-            0 != strcmp(reg_var->name, new_var->name)
-            );
+/** Private function of this file */
+static tlm_reg_var_type* tlm_variable_alloc(void)
+{
+    if (0 == m_var_block_free) {
+        if (NULL == (mp_var_block = malloc(TLM_VAR_ALLOC_BLOCK * sizeof(tlm_reg_var_type)))) {
+            return NULL;
+        }
+        m_var_block_free = TLM_VAR_ALLOC_BLOCK;
+    }
+
+    --m_var_block_free;
+    return mp_var_block++;
 }
 
 /** Private function of this file */
-static bool tlm_component_find_callback(void *elm_ptr, void *arg1, void *arg2, void *arg3)
+static bool tlm_variable_check_dup_ptr(void *elm_ptr, void *arg1,
+                                       void *arg2, void *arg3)
 {
     tlm_reg_var_type *reg_var = elm_ptr;
-    const char *name = arg1;
+    tlm_reg_var_type *new_var = arg1;
 
-    /* If we locate the name, make copy of the pointer, and return false
-     * to stop iterating further through the list
-     */
-    return (0 != strcmp(name, reg_var->name));
+    return (reg_var->data_ptr != new_var->data_ptr);
 }
 
 
@@ -63,28 +131,37 @@ bool tlm_variable_register(tlm_component *comp_ptr,
         return false;
     }
 
-    tlm_reg_var_type *new_var = malloc(sizeof(tlm_reg_var_type));
-    if(NULL == new_var) {
-        return false;
-    }
-
     /* If not an array, a single var still has size of 1 array element
      * This is make it easier to calculate bytes of the variable
      */
-    new_var->name = name;
-    new_var->data_ptr = data_ptr;
-    new_var->elm_size_bytes = data_size;
-    new_var->elm_arr_size = 0 == arr_size ? 1 : arr_size;
-    new_var->elm_type = type;
-
-    if (!c_list_for_each_elm(comp_ptr->var_list, tlm_variable_check_dup,
-                             (void*)new_var, NULL, NULL)) {
-        free(new_var);
+    tlm_reg_var_type var;
+    var.name = name;
+    var.data_ptr = data_ptr;
+    var.elm_size_bytes = data_size;
+    var.elm_arr_size = 0 == arr_size ? 1 : arr_size;
+    var.elm_type = type;
+
+    /* Check for duplicate name using the index, and duplicate memory pointer */
+    const uint32_t hash = tlm_index_hash(name);
+    if (NULL != tlm_index_find(&(comp_ptr->var_index), hash, name) ||
+        NULL != tlm_variable_find_static(comp_ptr, name) ||
+        !c_list_for_each_elm(comp_ptr->var_list, tlm_variable_check_dup_ptr,
+                             (void*)&var, NULL, NULL)) {
         return false;
     }
 
+    /* Add the new variable to the list, and to the index for lookups by name */
+    tlm_reg_var_type *new_var = tlm_variable_alloc();
+    if(NULL == new_var) {
+        return false;
+    }
+    *new_var = var;
+
     if (!c_list_insert_elm_end(comp_ptr->var_list, new_var)) {
-        free(new_var);
+        return false;
+    }
+    if (!tlm_index_insert(&(comp_ptr->var_index), hash, name, new_var)) {
+        c_list_delete_elm(comp_ptr->var_list, new_var);
         return false;
     }
 
@@ -93,27 +170,98 @@ bool tlm_variable_register(tlm_component *comp_ptr,
 
 const tlm_reg_var_type* tlm_variable_get_by_name(tlm_component *comp_ptr, const char *name)
 {
-    tlm_reg_var_type *reg_var = NULL;
+    const tlm_reg_var_type *reg_var = NULL;
     if (NULL != comp_ptr && NULL != name && '\0' != *name) {
-        reg_var = c_list_find_elm(comp_ptr->var_list, tlm_component_find_callback,
-                                  (void*)name, NULL, NULL);
+        reg_var = tlm_index_find(&(comp_ptr->var_index), tlm_index_hash(name), name);
+        if (NULL == reg_var) {
+            reg_var = tlm_variable_find_static(comp_ptr, name);
+        }
     }
     return reg_var;
 }
 
 const tlm_reg_var_type* tlm_variable_get_by_comp_and_name(const char *comp_name, const char *name)
 {
-    tlm_reg_var_type *reg_var = NULL;
-    tlm_component *comp_ptr = tlm_component_get_by_name(comp_name);
+    return tlm_variable_get_by_name(tlm_component_get_by_name(comp_name), name);
+}
 
-    if (NULL != comp_ptr && NULL != name && '\0' != *name) {
-        reg_var = c_list_find_elm(comp_ptr->var_list, tlm_component_find_callback,
-                                  (void*)name, NULL, NULL);
-    }
+const tlm_reg_var_type* tlm_variable_get_by_index(tlm_component *comp_ptr, uint32_t index)
+{
+    void *hint = 0;
+    return tlm_variable_get_at(comp_ptr, index, &hint);
+}
+
+uint32_t tlm_variable_count(const tlm_component *comp_ptr)
+{
+    return (NULL == comp_ptr) ? 0 : (comp_ptr->static_count + c_list_node_count(comp_ptr->var_list));
+}
 
+const tlm_reg_var_type* tlm_variable_get_at(const tlm_component *comp_ptr, uint32_t index, void **hint)
+{
+    const tlm_reg_var_type *reg_var = NULL;
+
+    if (NULL == comp_ptr) {
+        /* Nothing to get */
+    }
+    else if (index < comp_ptr->static_count) {
+        reg_var = &__tlm_vars_start[comp_ptr->static_first + index].var;
+    }
+    else if ((index -= comp_ptr->static_count) < c_list_node_count(comp_ptr->var_list)) {
+        reg_var = c_list_get_elm_at(comp_ptr->var_list, index, hint);
+    }
     return reg_var;
 }
 
+void tlm_variable_attach_static(tlm_component *comp_ptr)
+{
+    const uint32_t total = __tlm_vars_end - __tlm_vars_start;
+    uint32_t lo = 0;
+    uint32_t hi = total;
+
+    /* Find the first variable of the component, and then count its variables */
+    while (lo < hi) {
+        const uint32_t mid = (lo + hi) / 2;
+        if (tlm_variable_static_cmp(&__tlm_vars_start[mid], comp_ptr->name) < 0) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    comp_ptr->static_first = lo;
+    while (lo < total && 0 == strcmp(__tlm_vars_start[lo].comp_name, comp_ptr->name)) {
+        ++lo;
+    }
+    comp_ptr->static_count = lo - comp_ptr->static_first;
+}
+
+bool tlm_variable_get_indexes(const char *comp_name, const char *name,
+                              uint32_t *comp_index, uint32_t *var_index)
+{
+    const tlm_component *comp = tlm_component_get_by_name(comp_name);
+    const tlm_reg_var_type *reg_var = tlm_variable_get_by_name((tlm_component*) comp, name);
+    const tlm_reg_var_type *v = NULL;
+    tlm_component *c = NULL;
+    uint32_t i = 0;
+
+    if (NULL == reg_var) {
+        return false;
+    }
+
+    for (i = 0; NULL != (c = tlm_component_get_by_index(i)) && comp != c; i++) {
+        ;
+    }
+    *comp_index = i;
+
+    for (i = 0; NULL != (v = tlm_variable_get_by_index(c, i)) && reg_var != v; i++) {
+        ;
+    }
+    *var_index = i;
+
+    return (NULL != v);
+}
+
 bool tlm_variable_set_value(const char *comp_name, const char *name, const char *value)
 {
     const tlm_reg_var_type *reg_var = tlm_variable_get_by_comp_and_name(comp_name, name);
@@ -217,16 +365,41 @@ bool tlm_variable_set_value(const char *comp_name, const char *name, const char
 
 bool tlm_variable_get_value(const char *comp_name, const char *name, char *buffer, int len)
 {
-    const tlm_reg_var_type *reg_var = tlm_variable_get_by_comp_and_name(comp_name, name);
+    tlm_component *comp_ptr = tlm_component_get_by_name(comp_name);
+    const tlm_reg_var_type *reg_var = tlm_variable_get_by_name(comp_ptr, name);
     bool success = false;
 
     if (NULL != reg_var) {
-        success = tlm_variable_print_value(reg_var, buffer, len);
+        /* Print a copy of the variable if it is small enough, aligned for the doubles */
+        uint64_t data[TLM_SNAPSHOT_MAX_BYTES / sizeof(uint64_t)];
+        tlm_reg_var_type snap = *reg_var;
+        if (tlm_variable_snapshot(comp_ptr, reg_var, data, sizeof(data))) {
+            snap.data_ptr = data;
+        }
+        success = tlm_variable_print_value(&snap, buffer, len);
     }
 
     return success;
 }
 
+bool tlm_variable_snapshot(const tlm_component *comp_ptr, const tlm_reg_var_type *reg_var,
+                           void *buffer, uint32_t len)
+{
+    const uint32_t size = reg_var->elm_size_bytes * reg_var->elm_arr_size;
+    uint32_t seq = 0, tries = 0;
+
+    if (size > len) {
+        return false;
+    }
+
+    do {
+        seq = tlm_read_begin(comp_ptr);
+        memcpy(buffer, reg_var->data_ptr, size);
+    } while (tlm_read_retry(comp_ptr, seq) && ++tries < TLM_SEQ_MAX_RETRIES);
+
+    return true;
+}
+
 bool tlm_variable_print_value(const tlm_reg_var_type *reg_var, char *buffer, int len)
 {
     uint16_t i = 0;
@@ -235,7 +408,7 @@ bool tlm_variable_print_value(const tlm_reg_var_type *reg_var, char *buffer, int
         for ( i=1; i < reg_var->elm_arr_size; i++) {                \
             ++var;                                                  \
             size_t curr_len = strlen(buffer);                       \
-            snprintf(buffer+curr_len, len-curr_len, format, *data); \
+            fmt_snprintf(buffer+curr_len, len-curr_len, format, *data); \
         } do{ } while(0)
 
     bool success = false;
@@ -245,22 +418,22 @@ bool tlm_variable_print_value(const tlm_reg_var_type *reg_var, char *buffer, int
             success = true;
             if (1 == reg_var->elm_size_bytes) {
                 int8_t *data = (int8_t*)(reg_var->data_ptr);
-                snprintf(buffer, len, "int8:%i", *data);
+                fmt_snprintf(buffer, len, "int8:%i", *data);
                 tlm_variable_print_array(",%i", data, buffer);
             }
             else if (2 == reg_var->elm_size_bytes) {
                 int16_t *data = (int16_t*)(reg_var->data_ptr);
-                snprintf(buffer, len, "int16:%i", *data);
+                fmt_snprintf(buffer, len, "int16:%i", *data);
                 tlm_variable_print_array(",%i", data, buffer);
             }
             else if (4 == reg_var->elm_size_bytes) {
                 int32_t *data = (int32_t*)(reg_var->data_ptr);
-                snprintf(buffer, len, "int32:%" PRIi32, *data);
+                fmt_snprintf(buffer, len, "int32:%" PRIi32, *data);
                 tlm_variable_print_array(",%"PRIi32, data, buffer);
             }
             else if (8 == reg_var->elm_size_bytes) {
                 int64_t *data = (int64_t*)(reg_var->data_ptr);
-                snprintf(buffer, len, "int64:%"PRIi64, *data);
+                fmt_snprintf(buffer, len, "int64:%"PRIi64, *data);
                 tlm_variable_print_array(",%"PRIi64, data, buffer);
             }
             else {
@@ -274,22 +447,22 @@ bool tlm_variable_print_value(const tlm_reg_var_type *reg_var, char *buffer, int
             success = true;
             if (1 == reg_var->elm_size_bytes) {
                 uint8_t *data = (uint8_t*)(reg_var->data_ptr);
-                snprintf(buffer, len, "uint8:%u", *data);
+                fmt_snprintf(buffer, len, "uint8:%u", *data);
                 tlm_variable_print_array(",%u", data, buffer);
             }
             else if (2 == reg_var->elm_size_bytes) {
                 uint16_t *data = (uint16_t*)(reg_var->data_ptr);
-                snprintf(buffer, len, "uint16:%u", *data);
+                fmt_snprintf(buffer, len, "uint16:%u", *data);
                 tlm_variable_print_array(",%u", data, buffer);
             }
             else if (4 == reg_var->elm_size_bytes) {
                 uint32_t *data = (uint32_t*)(reg_var->data_ptr);
-                snprintf(buffer, len, "uint32:%"PRIu32, *data);
+                fmt_snprintf(buffer, len, "uint32:%"PRIu32, *data);
                 tlm_variable_print_array(",%"PRIu32, data, buffer);
             }
             else if (8 == reg_var->elm_size_bytes) {
                 uint64_t *data = (uint64_t*)(reg_var->data_ptr);
-                snprintf(buffer, len, "uint64:%"PRIu64, *data);
+                fmt_snprintf(buffer, len, "uint64:%"PRIu64, *data);
                 tlm_variable_print_array(",%"PRIu64, data, buffer);
             }
             else {
@@ -301,7 +474,7 @@ bool tlm_variable_print_value(const tlm_reg_var_type *reg_var, char *buffer, int
         case tlm_char:
         {
             char *data = (char*) (reg_var->data_ptr);
-            snprintf(buffer, len, "char:%c", *data);
+            fmt_snprintf(buffer, len, "char:%c", *data);
             tlm_variable_print_array(",%c", data, buffer);
             success = true;
             break;
@@ -310,7 +483,7 @@ bool tlm_variable_print_value(const tlm_reg_var_type *reg_var, char *buffer, int
         case tlm_binary:
         {
             char *data = (char*) (reg_var->data_ptr);
-            snprintf(buffer, len, "binary:%c", *data);
+            fmt_snprintf(buffer, len, "binary:%c", *data);
             tlm_variable_print_array("%c", data, buffer);
             success = true;
             break;
@@ -318,7 +491,7 @@ bool tlm_variable_print_value(const tlm_reg_var_type *reg_var, char *buffer, int
 
         case tlm_string:
         {
-            snprintf(buffer, len, "string:%s", (char*)(reg_var->data_ptr));
+            fmt_snprintf(buffer, len, "string:%s", (char*)(reg_var->data_ptr));
             success = true;
             break;
         }
@@ -326,11 +499,11 @@ bool tlm_variable_print_value(const tlm_reg_var_type *reg_var, char *buffer, int
         case tlm_bit_or_bool:
         {
             char *data = (char*) (reg_var->data_ptr);
-            snprintf(buffer, len, "bool:%s", *data ? "true" : "false");
+            fmt_snprintf(buffer, len, "bool:%s", *data ? "true" : "false");
             for (i=1; i < reg_var->elm_arr_size; i++) {
                 ++data;
                 size_t curr_len = strlen(buffer);
-                snprintf(buffer+curr_len, len-curr_len, ",%s", *data ? "true" : "false");
+                fmt_snprintf(buffer+curr_len, len-curr_len, ",%s", *data ? "true" : "false");
             }
             success = true;
             break;
@@ -339,7 +512,7 @@ bool tlm_variable_print_value(const tlm_reg_var_type *reg_var, char *buffer, int
         case tlm_float:
         {
             float *data = (float*) (reg_var->data_ptr);
-            snprintf(buffer, len, "float:%f", *data);
+            fmt_snprintf(buffer, len, "float:%f", *data);
             tlm_variable_print_array(",%f", data, buffer);
             success = true;
             break;
@@ -348,7 +521,7 @@ bool tlm_variable_print_value(const tlm_reg_var_type *reg_var, char *buffer, int
         case tlm_double:
         {
             double *data = (double*) (reg_var->data_ptr);
-            snprintf(buffer, len, "double:%f", *data);
+            fmt_snprintf(buffer, len, "double:%f", *data);
             tlm_variable_print_array(",%f", data, buffer);
             success = true;
             break;
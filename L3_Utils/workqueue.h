@@ -0,0 +1,147 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+/**
+ * @file
+ * @brief Shared worker tasks that run deferred work items
+ * @ingroup Utilities
+ *
+ * A feature that only waits for an event and then does a little work does not need its own
+ * task and stack.  The workqueue has one worker task for each of the work priorities, and the
+ * code posts a work item (a function and its context) to a worker from a task or an interrupt.
+ * A worker is created by the first workqueue_start() of its priority.
+ * The worker runs its items one at a time, in the order they were posted, and each item runs to
+ * completion, so an item should not block for long since it delays the items behind it.
+ * @code
+ *      static void print_press(void *ctx) { printf("Button %u pressed\n", (unsigned) ctx); }
+ *
+ *      void button_isr(void)
+ *      {
+ *          BaseType_t woken = pdFALSE;
+ *          workqueue_post_from_isr(work_prio_low, print_press, (void*) 1, &woken);
+ *          portEND_SWITCHING_ISR(woken);
+ *      }
+ * @endcode
+ *
+ * Delayed work uses a work_delayed_t that is owned by the caller, and it runs once after the
+ * delay.  Posting it again before it runs moves it to the new time, so a timeout can be pushed
+ * back by posting it again, and workqueue_cancel() removes it:
+ * @code
+ *      static work_delayed_t idle_work;
+ *      workqueue_post_delayed(work_prio_low, &idle_work, go_idle, NULL, 5000);
+ * @endcode
+ *
+ * 20261014: Initial
+ */
+#ifndef WORKQUEUE_H__
+#define WORKQUEUE_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+
+
+
+#define WORKQUEUE_STACK_SIZE    STACK_BYTES(2048)   ///< The stack of the medium and the high worker
+#define WORKQUEUE_LOW_STACK_SIZE STACK_BYTES(4096)  ///< The stack of the low worker, which also runs the background terminal commands
+#define WORKQUEUE_QUEUE_LENGTH  16                  ///< The items that can be pending at each worker
+
+/// The function of a work item
+typedef void (*work_func_t)(void *ctx);
+
+/// The workers, which run at PRIORITY_LOW, PRIORITY_MEDIUM and PRIORITY_HIGH
+typedef enum {
+    work_prio_low,
+    work_prio_medium,
+    work_prio_high,
+    work_prio_count
+} work_prio_t;
+
+/// A delayed work item; the members are private to workqueue.c, and only changed by the worker once posted
+typedef struct work_delayed {
+    struct work_delayed *next;  ///< The next delayed item of the worker, sorted by the due time
+    uint32_t due_ms;            ///< The uptime when the item runs
+    work_func_t func;           ///< The function of the item
+    void *ctx;                  ///< The context of the item
+    volatile bool pending;      ///< Set when the item is posted, and cleared when it runs or is canceled
+} work_delayed_t;
+
+/// The statistics of a worker
+typedef struct {
+    uint32_t run;               ///< The items that were run
+    uint32_t dropped;           ///< The items that were not posted since the queue was full
+    uint32_t max_us;            ///< The longest time of an item
+} workqueue_stats_t;
+
+
+
+/**
+ * Creates the worker task of the priority if it is not created yet, so only the workers that are
+ * used take memory.  The code that posts to a worker starts it during its initialization, before
+ * the interrupts that post to it are enabled.  The items can be posted before the scheduler starts.
+ * @returns false if the worker could not be created
+ */
+bool workqueue_start(work_prio_t prio);
+
+/**
+ * Posts a work item to the worker
+ * @param prio  The worker
+ * @param func  The function to call
+ * @param ctx   The parameter of the function
+ * @returns false if the queue of the worker is full, or if the worker is not started
+ */
+bool workqueue_post(work_prio_t prio, work_func_t func, void *ctx);
+
+/**
+ * Posts a work item from an interrupt
+ * @param woken  Set to pdTRUE if the worker has a higher priority than the interrupted task
+ * @see workqueue_post()
+ */
+bool workqueue_post_from_isr(work_prio_t prio, work_func_t func, void *ctx, BaseType_t *woken);
+
+/**
+ * Posts, or moves, a delayed work item; this can be called from an interrupt
+ * @param prio      The worker, which must be the same each time the item is posted
+ * @param work      The delayed item, which must stay in memory while it is pending
+ * @param func      The function to call
+ * @param ctx       The parameter of the function
+ * @param delay_ms  The delay from now
+ * @returns false if the queue of the worker is full
+ */
+bool workqueue_post_delayed(work_prio_t prio, work_delayed_t *work, work_func_t func, void *ctx, uint32_t delay_ms);
+
+/**
+ * Cancels a delayed work item that has not run yet; this can be called from an interrupt
+ * @note The item may still run if it is due before the worker processes the cancel
+ */
+bool workqueue_cancel(work_prio_t prio, work_delayed_t *work);
+
+/// @returns true if the delayed item is scheduled and has not run yet
+static inline bool workqueue_is_pending(const work_delayed_t *work) { return work->pending; }
+
+/// @returns the statistics of the worker
+workqueue_stats_t workqueue_get_stats(work_prio_t prio);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* WORKQUEUE_H__ */
@@ -1,65 +1,98 @@
-/*
- *     SocialLedge.com - Copyright (C) 2013
- *
- *     This file is part of free software framework for embedded processors.
- *     You can use it and/or distribute it as long as this copyright header
- *     remains unmodified.  The code is free for personal use and requires
- *     permission to use in a commercial product.
- *
- *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
- *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
- *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
- *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
- *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
- *
- *     You can reach the author of this software at :
- *          p r e e t . w i k i @ g m a i l . c o m
- */
-
-/**
- * @file
- * @ingroup BoardIO
- */
- 
-#ifndef IR_SENSOR_HPP_
-#define IR_SENSOR_HPP_
-#include <stdint.h>
-
-
-
-/**
- * IR Sensor class used to get signals from the on-board IR Sensor
- * This sensor can decode a remote's IR signals, such as a TV remote control.
- *
- * To make sure no decoded signals are over-written, or you do not get a decoded signal that is very
- * obsolete, the user should periodically check isIRCodeReceived() every 50ms, and buffer signals externally.
- *
- * If a signal is decoded, getLastIRCode() will provide it, and clear out the buffer to receive future signal.
- * If getLastIRCode() is not called regularly, it is possible that this may return an older signal, even if
- * it was many hours ago.
- *
- * @ingroup BoardIO
- */
-class IR_Sensor : public SingletonTemplate<IR_Sensor>
-{
-    public:
-        bool init(); ///< Initializes this device, @returns true if successful
-
-        /// @returns true if an IR signal was decoded and is available to read
-        bool isIRCodeReceived();
-
-        /// @returns The last IR signal that was decoded or 0 if nothing was decoded
-        uint32_t getLastIRCode();
-
-        /** @{ Don't use these functions */
-        void storeIrCode(uint32_t);
-        void decodeIrCode(void);
-        /** @} */
-
-    private:
-        /// Private constructor of this Singleton class
-        IR_Sensor() {}
-        friend class SingletonTemplate<IR_Sensor>;  ///< Friend class used for Singleton Template
-};
-
-#endif /* IR_SENSOR_HPP_ */
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @ingroup BoardIO
+ */
+ 
+#ifndef IR_SENSOR_HPP_
+#define IR_SENSOR_HPP_
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "queue.h"
+
+
+
+#define IR_SENSOR_QUEUE_SIZE        8       ///< Number of decoded IR codes that can be queued
+#define IR_SENSOR_TOLERANCE_PCT     30      ///< Percentage that a mark or space may differ from its protocol timing
+#define IR_SENSOR_REPEAT_MS         150     ///< A frame within this time of the last frame of a held button is its repeat
+
+/// The protocol of a decoded IR code
+typedef enum {
+    ir_protocol_nec = 0,    ///< NEC: 32-bit frames with a repeat frame while the button is held
+    ir_protocol_rc5 = 1,    ///< Philips RC5: 14-bit Manchester frames with a toggle bit
+} ir_protocol_t;
+
+/// An IR code decoded by the IR_Sensor
+typedef struct {
+    uint32_t code;      ///< NEC: the 32-bit frame, RC5: the address (bits 12:8) and the 7-bit command
+    uint8_t protocol;   ///< @see ir_protocol_t
+    uint8_t repeat;     ///< 0 for a button press, then counts up (to 255) while the button is held
+} ir_code_t;
+
+/**
+ * IR Sensor class used to get signals from the on-board IR Sensor
+ * This sensor can decode a remote's IR signals, such as a TV remote control.
+ *
+ * Timer 1 captures the time of each edge of CAP1.0 in hardware, so the timing does not depend
+ * on the interrupt latency.  The capture interrupt runs the state machines of the NEC and
+ * RC5 protocols, and each decoded frame is sent to a queue, so a task can wait for the codes
+ * with getIrCode() instead of polling.  A held button produces the same code with an
+ * incrementing repeat count: the NEC repeat frames and the RC5 frames with the same toggle bit.
+ *
+ * isIRCodeReceived() and getLastIRCode() only return the button presses, not the repeats.
+ *
+ * @ingroup BoardIO
+ */
+class IR_Sensor : public SingletonTemplate<IR_Sensor>
+{
+    public:
+        bool init(); ///< Initializes this device, @returns true if successful
+
+        /**
+         * Gets the next decoded IR code
+         * @param code     The decoded code
+         * @param timeout  The ticks to wait for a code
+         * @returns true if a code was decoded
+         */
+        bool getIrCode(ir_code_t &code, TickType_t timeout);
+
+        /// @returns true if an IR signal was decoded and is available to read
+        bool isIRCodeReceived();
+
+        /// @returns The next button press that was decoded or 0 if nothing was decoded
+        uint32_t getLastIRCode();
+
+        /// @returns the number of decoded codes lost because the queue was full
+        uint32_t getDropCount() const { return mDrops; }
+
+        /** @{ Don't use these functions */
+        void captureIsr(uint32_t time_us);  ///< Called by the timer ISR with the captured time of an edge
+        /** @} */
+
+    private:
+        /// Private constructor of this Singleton class
+        IR_Sensor() : mQueue(NULL), mDrops(0) {}
+        friend class SingletonTemplate<IR_Sensor>;  ///< Friend class used for Singleton Template
+
+        QueueHandle_t mQueue;   ///< Queue of the decoded ir_code_t
+        uint32_t mDrops;        ///< @see getDropCount()
+};
+
+#endif /* IR_SENSOR_HPP_ */
@@ -1,83 +1,172 @@
-/*
- *     SocialLedge.com - Copyright (C) 2013
- *
- *     This file is part of free software framework for embedded processors.
- *     You can use it and/or distribute it as long as this copyright header
- *     remains unmodified.  The code is free for personal use and requires
- *     permission to use in a commercial product.
- *
- *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
- *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
- *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
- *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
- *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
- *
- *     You can reach the author of this software at :
- *          p r e e t . w i k i @ g m a i l . c o m
- */
-
-/**
- * @file
- * @ingroup BoardIO
- */
- 
-#ifndef ACCELERATION_SENSOR_HPP_
-#define ACCELERATION_SENSOR_HPP_
-#include <stdint.h>
-#include "i2c2_device.hpp"  // I2C Device Base Class
-
-
-
-/**
- * Acceleration Sensor class used to get acceleration data reading from the on-board sensor.
- * Acceleration data reading can provide absolute tilt of the board (if under no movement),
- * and it can also provide the movement activity of the board.
- *
- * @ingroup BoardIO
- */
-class Acceleration_Sensor : private i2c2_device, public SingletonTemplate<Acceleration_Sensor>
-{
-    public:
-        bool init();   ///< Initializes the sensor
-
-        int16_t getX();  ///< @returns X-Axis value
-        int16_t getY();  ///< @returns Y-Axis value
-        int16_t getZ();  ///< @returns Z-Axis value
-
-    private:
-        /// Private constructor of this Singleton class
-        Acceleration_Sensor() : i2c2_device(I2CAddr_AccelerationSensor)
-        {
-        }
-        friend class SingletonTemplate<Acceleration_Sensor>;  ///< Friend class used for Singleton Template
-
-
-
-        /// Expected value of Sensor's "WHO AM I" register
-        static const unsigned char mWhoAmIExpectedValue = 0x2A;
-        typedef enum {
-            status=0,
-            X_MSB=1, X_LSB=2,
-            Y_MSB=3, Y_LSB=4,
-            Z_MSB=5, Z_LSB=6,
-
-            SysMod=0xb, IntSource=0xc,WhoAmI=0xd,
-            XYZDataCfg=0xe,HPFilterCutoff=0xf,
-
-            PL_Status=0x10, PL_Cfg=0x11,    PL_Count=0x12,  PL_BF_ZComp=0x13, PL_THS_Reg=0x14,
-            FF_MT_Cfg=0x15, FF_MT_Src=0x16, FF_MT_THS=0x17, FF_MT_Count=0x18,
-
-            Transient_Cfg=0x1d, Transient_Src=0x1e, Transient_THS=0x1f, Transient_Count=0x20,
-            Pulse_Cfg=0x21, Pulse_Src=0x22, Pulse_THSX=0x23, Pulse_THSY=0x24, Pulse_THSZ=0x25,
-            Pulse_TMLT=0x26, Pulse_LTCY=0x27, Pulse_Wind=0x28,
-
-            ASLP_Count=0x29,
-            Ctrl_Reg1=0x2A, Ctrl_Reg2=0x2B, Ctrl_Reg3=0x2C, Ctrl_Reg4=0x2D, Ctrl_Reg5=0x2E,
-            OffsetX=0x2F, OffsetY=0x30, OffsetZ=0x31
-
-        } __attribute__ ((packed)) RegisterMap;
-
-};
-
-
-#endif /* ACCELERATION_SENSOR_HPP_ */
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @ingroup BoardIO
+ */
+ 
+#ifndef ACCELERATION_SENSOR_HPP_
+#define ACCELERATION_SENSOR_HPP_
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "i2c2_device.hpp"  // I2C Device Base Class
+#include "event_bus.h"
+
+
+
+/// The counts of the axes per g, which is the 12-bit sample at the +/- 2g range
+#define ACCEL_COUNTS_PER_G      1024
+
+/// @returns the axis value in milli-g, using integer math
+static inline int16_t accel_counts_to_mg(int16_t counts) { return (int16_t) ((counts * 1000) / ACCEL_COUNTS_PER_G); }
+
+/// A sample of all the axes of the acceleration sensor
+typedef struct {
+    int16_t x;              ///< X-Axis value
+    int16_t y;              ///< Y-Axis value
+    int16_t z;              ///< Z-Axis value
+    uint64_t timestamp_us;  ///< Uptime when the sample was ready
+} accel_sample_t;
+
+/// The orientation detected by the portrait/landscape engine of the sensor
+typedef enum {
+    accel_portrait_up = 0,
+    accel_portrait_down = 1,
+    accel_landscape_right = 2,
+    accel_landscape_left = 3,
+} accel_orient_t;
+
+/// An orientation change detected by the sensor
+typedef struct {
+    uint8_t orientation;    ///< The accel_orient_t
+    bool back;              ///< True if the board is facing down (negative Z-Axis)
+    uint64_t timestamp_us;  ///< Uptime of the interrupt of the change
+} accel_orient_event_t;
+
+/// The orientation changes published after Acceleration_Sensor::startOrientation()
+EVENT_TOPIC_DECLARE(accel_orient_topic);
+
+/**
+ * Acceleration Sensor class used to get acceleration data reading from the on-board sensor.
+ * Acceleration data reading can provide absolute tilt of the board (if under no movement),
+ * and it can also provide the movement activity of the board.
+ *
+ * @ingroup BoardIO
+ */
+class Acceleration_Sensor : private i2c2_device, public SingletonTemplate<Acceleration_Sensor>
+{
+    public:
+        bool init();   ///< Initializes the sensor
+
+        int16_t getX();  ///< @returns X-Axis value
+        int16_t getY();  ///< @returns Y-Axis value
+        int16_t getZ();  ///< @returns Z-Axis value
+
+        /**
+         * Reads all the axes in one I2C burst, which is faster than getX(), getY(), and getZ()
+         * @returns true if the sample was read
+         */
+        bool getXYZ(accel_sample_t &sample);
+
+        /**
+         * Starts streaming the samples to the queue at 100Hz.  The data-ready interrupt (INT1)
+         * of the sensor submits an asynchronous I2C read, and the I2C interrupt sends the
+         * time stamped sample to the queue, so no task is involved until the queue has data.
+         *
+         * @param port2Pin  The pin of port 2 connected to the INT1 pin of the sensor
+         * @param queue     The queue of accel_sample_t
+         * @returns false if it was already started
+         */
+        bool startStreaming(uint8_t port2Pin, QueueHandle_t queue);
+
+        /// @returns the number of streaming samples lost because the I2C or the queue was busy
+        uint32_t getStreamDrops() const { return mStreamDrops; }
+
+        /**
+         * Starts the portrait/landscape engine of the sensor, which interrupts (INT2) only when
+         * the orientation changes, so the axes do not need to be polled.  The interrupt posts
+         * a work item to the work_prio_low worker, which reads the new orientation and publishes
+         * it to accel_orient_topic.  This can be used together with startStreaming().
+         *
+         * @param port2Pin  The pin of port 2 connected to the INT2 pin of the sensor
+         * @returns false if it was already started
+         */
+        bool startOrientation(uint8_t port2Pin);
+
+    private:
+        /// Private constructor of this Singleton class
+        Acceleration_Sensor() : i2c2_device(I2CAddr_AccelerationSensor, 400),
+            mStreamQueue(NULL), mStreamTimestamp(0), mStreamDrops(0),
+            mIntEnable(0), mIntRoute(0), mOrientStarted(false), mOrientPending(false), mOrientTimestamp(0)
+        {
+        }
+        friend class SingletonTemplate<Acceleration_Sensor>;  ///< Friend class used for Singleton Template
+
+        /// Converts the XYZ registers (MSB first, 12-bit left justified) to the sample
+        static void decodeXYZ(const uint8_t *pData, accel_sample_t &sample);
+
+        static void dataReadyIsr(void);            ///< Data-ready interrupt of the sensor
+        static void sampleReadIsr(I2C_Job_t *pJob); ///< Completion of the I2C read of the sample
+        static void orientIsr(void);                ///< Orientation interrupt of the sensor
+        static void orientWork(void *ctx);          ///< Reads and publishes the orientation
+
+        QueueHandle_t mStreamQueue;         ///< Queue of the streaming samples
+        uint8_t mStreamData[6];             ///< The XYZ registers read by the streaming job
+        I2C_Trx_t mStreamTrx;               ///< The I2C transaction of the streaming job
+        I2C_Job_t mStreamJob;               ///< The I2C job that reads a streaming sample
+        uint64_t mStreamTimestamp;          ///< Uptime of the last data-ready interrupt
+        uint32_t mStreamDrops;              ///< Streaming samples lost
+
+        uint8_t mIntEnable;                 ///< The interrupts enabled in Ctrl_Reg4
+        uint8_t mIntRoute;                  ///< The interrupts routed to INT1 by Ctrl_Reg5
+        bool mOrientStarted;                ///< Set by startOrientation()
+        volatile bool mOrientPending;       ///< Set while orientWork() is posted
+        uint64_t mOrientTimestamp;          ///< Uptime of the last orientation interrupt
+
+
+
+        /// Expected value of Sensor's "WHO AM I" register
+        static const unsigned char mWhoAmIExpectedValue = 0x2A;
+        typedef enum {
+            status=0,
+            X_MSB=1, X_LSB=2,
+            Y_MSB=3, Y_LSB=4,
+            Z_MSB=5, Z_LSB=6,
+
+            SysMod=0xb, IntSource=0xc,WhoAmI=0xd,
+            XYZDataCfg=0xe,HPFilterCutoff=0xf,
+
+            PL_Status=0x10, PL_Cfg=0x11,    PL_Count=0x12,  PL_BF_ZComp=0x13, PL_THS_Reg=0x14,
+            FF_MT_Cfg=0x15, FF_MT_Src=0x16, FF_MT_THS=0x17, FF_MT_Count=0x18,
+
+            Transient_Cfg=0x1d, Transient_Src=0x1e, Transient_THS=0x1f, Transient_Count=0x20,
+            Pulse_Cfg=0x21, Pulse_Src=0x22, Pulse_THSX=0x23, Pulse_THSY=0x24, Pulse_THSZ=0x25,
+            Pulse_TMLT=0x26, Pulse_LTCY=0x27, Pulse_Wind=0x28,
+
+            ASLP_Count=0x29,
+            Ctrl_Reg1=0x2A, Ctrl_Reg2=0x2B, Ctrl_Reg3=0x2C, Ctrl_Reg4=0x2D, Ctrl_Reg5=0x2E,
+            OffsetX=0x2F, OffsetY=0x30, OffsetZ=0x31
+
+        } __attribute__ ((packed)) RegisterMap;
+
+};
+
+
+#endif /* ACCELERATION_SENSOR_HPP_ */
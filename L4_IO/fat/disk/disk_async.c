@@ -0,0 +1,374 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+#include "task.h"
+
+#include "disk_async.h"
+#include "diskio.h"
+#include "lpc_dma.h"        // dma_memcpy()
+
+
+
+#define DISK_ASYNC_SECTOR_SIZE      512
+#define DISK_ASYNC_MAX_DRIVES       2
+#define DISK_ASYNC_MAX_SECTORS      255     ///< disk_read() and disk_write() use BYTE count
+
+
+
+static TaskHandle_t g_disk_task = NULL;     ///< The disk I/O task
+static QueueHandle_t g_req_queue = NULL;    ///< Queue of pending disk_async_req_t pointers
+static QueueHandle_t g_waiter_pool = NULL;  ///< Pool of semaphores used by disk_async_rw()
+
+/// The next sector of a sequential read of each drive
+static DWORD g_seq_next_sector[DISK_ASYNC_MAX_DRIVES] = { 0 };
+
+/// The drives that may have background work since their last write (@see disk_idle())
+static bool g_idle_pending[DISK_ASYNC_MAX_DRIVES] = { false };
+
+#if (DISK_ASYNC_READ_AHEAD_SECTORS > 0)
+/**
+ * The read-ahead buffer.  This is a global because GPDMA cannot access the heap memory
+ * (@see loader.ld), and only the disk I/O task accesses it, so there is no lock.
+ */
+static BYTE g_ra_buff[DISK_ASYNC_READ_AHEAD_SECTORS * DISK_ASYNC_SECTOR_SIZE] __attribute__((aligned(4)));
+static struct {
+    bool valid;         ///< true if g_ra_buff contains the data of the sectors below
+    bool pending;       ///< true if the read-ahead should be performed when the task is idle
+    BYTE drv;           ///< The drive of the read-ahead data
+    DWORD sector;       ///< The first sector of the read-ahead data
+    uint32_t changes;   ///< g_ra_changes[] of the drive before the read-ahead data was read
+} g_ra = { false, false, 0, 0, 0 };
+
+/**
+ * The count of the changes of each drive that are not served by the disk I/O task, such as the
+ * erase of CTRL_ERASE_SECTOR by the other tasks (@see disk_async_invalidate()).  These are counted
+ * instead of clearing g_ra.valid, so a read-ahead that races with an erase is never used.
+ */
+static volatile uint32_t g_ra_changes[DISK_ASYNC_MAX_DRIVES] = { 0 };
+#endif
+
+
+
+/// @returns true if the two sector ranges overlap
+static inline bool disk_async_ranges_overlap(const disk_async_req_t *a, const disk_async_req_t *b)
+{
+    return (a->drv == b->drv) && (a->sector < b->sector + b->count) && (b->sector < a->sector + a->count);
+}
+
+/**
+ * Sorts the requests by drive, and by sector using insertion sort.  A request is not moved
+ * ahead of an overlapping request if one of them is a write, so the order of the data is kept.
+ */
+static void disk_async_sort(disk_async_req_t **pReqs, uint32_t count)
+{
+    uint32_t i = 0, j = 0;
+
+    for (i = 1; i < count; i++)
+    {
+        disk_async_req_t *pReq = pReqs[i];
+
+        for (j = i; j > 0; j--)
+        {
+            disk_async_req_t *pPrev = pReqs[j - 1];
+            const bool in_order = (pPrev->drv < pReq->drv) ||
+                                  (pPrev->drv == pReq->drv && pPrev->sector <= pReq->sector);
+            const bool conflict = (pPrev->write || pReq->write) && disk_async_ranges_overlap(pPrev, pReq);
+
+            if (in_order || conflict) {
+                break;
+            }
+            pReqs[j] = pPrev;
+        }
+        pReqs[j] = pReq;
+    }
+}
+
+/**
+ * @returns true if pNext can be served by the same transfer as the requests before it.
+ * The buffers must be contiguous because the drivers transfer into a single buffer.
+ */
+static inline bool disk_async_can_merge(const disk_async_req_t *pLast, const disk_async_req_t *pNext,
+                                        uint32_t merged_count)
+{
+    return (pLast->drv == pNext->drv && pLast->write == pNext->write) &&
+           (pLast->sector + pLast->count == pNext->sector) &&
+           (pLast->buff + (pLast->count * DISK_ASYNC_SECTOR_SIZE) == pNext->buff) &&
+           (merged_count + pNext->count <= DISK_ASYNC_MAX_SECTORS);
+}
+
+static void disk_async_complete(disk_async_req_t *pReq, DRESULT result)
+{
+    pReq->result = result;
+
+    if (pReq->callback) {
+        pReq->callback(pReq);
+    }
+    if (pReq->done) {
+        xSemaphoreGive(pReq->done);
+    }
+}
+
+#if (DISK_ASYNC_READ_AHEAD_SECTORS > 0)
+/// @returns true if g_ra_buff has the data of the read-ahead sectors, and the drive has not changed since
+static inline bool disk_async_ra_valid(void)
+{
+    return g_ra.valid && g_ra.changes == g_ra_changes[g_ra.drv];
+}
+
+/// Copies the data from the read-ahead buffer if the whole request is in the buffer
+static bool disk_async_ra_hit(const disk_async_req_t *pReq)
+{
+    if (!disk_async_ra_valid() || g_ra.drv != pReq->drv || pReq->sector < g_ra.sector ||
+        pReq->sector + pReq->count > g_ra.sector + DISK_ASYNC_READ_AHEAD_SECTORS) {
+        return false;
+    }
+
+    /* The sectors are copied by the DMA while the other tasks run */
+    dma_memcpy(pReq->buff, &g_ra_buff[(pReq->sector - g_ra.sector) * DISK_ASYNC_SECTOR_SIZE],
+               pReq->count * DISK_ASYNC_SECTOR_SIZE);
+    return true;
+}
+
+/// Schedules the read-ahead after a sequential read unless the next sectors are already buffered
+static void disk_async_ra_schedule(BYTE drv, DWORD next_sector)
+{
+    const bool buffered = disk_async_ra_valid() && g_ra.drv == drv &&
+                          next_sector >= g_ra.sector &&
+                          next_sector < g_ra.sector + DISK_ASYNC_READ_AHEAD_SECTORS;
+    if (!buffered) {
+        /* The buffer has the sectors of the old window until the read-ahead of the new one */
+        g_ra.valid = false;
+        g_ra.pending = true;
+        g_ra.drv = drv;
+        g_ra.sector = next_sector;
+    }
+}
+
+static void disk_async_ra_perform(void)
+{
+    g_ra.pending = false;
+    g_ra.changes = g_ra_changes[g_ra.drv];
+    g_ra.valid = (RES_OK == disk_rw_now(g_ra.drv, false, g_ra_buff, g_ra.sector, DISK_ASYNC_READ_AHEAD_SECTORS));
+}
+#endif
+
+/// Performs a read or write of the requests from pReqs[0] to pReqs[count - 1] that are merged together
+static void disk_async_serve(disk_async_req_t **pReqs, uint32_t count, uint32_t sectors)
+{
+    disk_async_req_t *pFirst = pReqs[0];
+    const DWORD next = pFirst->sector + sectors;
+    DRESULT result = RES_OK;
+    uint32_t i = 0;
+
+#if (DISK_ASYNC_READ_AHEAD_SECTORS > 0)
+    if (pFirst->write) {
+        /* Read-ahead data is stale if we write to any of its sectors */
+        if (g_ra.valid && g_ra.drv == pFirst->drv &&
+            pFirst->sector < g_ra.sector + DISK_ASYNC_READ_AHEAD_SECTORS && g_ra.sector < next) {
+            g_ra.valid = false;
+        }
+    }
+    else if (1 == count && disk_async_ra_hit(pFirst)) {
+        sectors = 0;
+    }
+#endif
+
+    if (sectors > 0) {
+        result = disk_rw_now(pFirst->drv, pFirst->write, pFirst->buff, pFirst->sector, sectors);
+    }
+    if (pFirst->write && pFirst->drv < DISK_ASYNC_MAX_DRIVES) {
+        g_idle_pending[pFirst->drv] = true;
+    }
+
+    /* Sequential reads of a drive trigger the read-ahead of the next sectors */
+    if (!pFirst->write && pFirst->drv < DISK_ASYNC_MAX_DRIVES) {
+#if (DISK_ASYNC_READ_AHEAD_SECTORS > 0)
+        if (RES_OK == result && g_seq_next_sector[pFirst->drv] == pFirst->sector) {
+            disk_async_ra_schedule(pFirst->drv, next);
+        }
+#endif
+        g_seq_next_sector[pFirst->drv] = next;
+    }
+
+    for (i = 0; i < count; i++) {
+        disk_async_complete(pReqs[i], result);
+    }
+}
+
+/// @returns true if any drive has background work for disk_async_idle()
+static bool disk_async_idle_pending(void)
+{
+    for (uint32_t drv = 0; drv < DISK_ASYNC_MAX_DRIVES; drv++) {
+        if (g_idle_pending[drv]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Performs one step of the background work of each drive, such as the erase of the free flash pages
+static void disk_async_idle(void)
+{
+    for (uint32_t drv = 0; drv < DISK_ASYNC_MAX_DRIVES; drv++) {
+        if (g_idle_pending[drv]) {
+            g_idle_pending[drv] = disk_idle(drv);
+        }
+    }
+}
+
+static void disk_async_task(void *p)
+{
+    disk_async_req_t *reqs[DISK_ASYNC_QUEUE_SIZE];
+    uint32_t count = 0;
+    uint32_t i = 0, j = 0;
+    (void) p;
+
+    while (1)
+    {
+        /* Block for the next request unless we have read-ahead work to do while idle.  The background
+         * work waits for the device, so it is polled without keeping the requests waiting.
+         */
+        TickType_t wait = disk_async_idle_pending() ? OS_MS(DISK_ASYNC_IDLE_POLL_MS) : portMAX_DELAY;
+#if (DISK_ASYNC_READ_AHEAD_SECTORS > 0)
+        if (g_ra.pending) {
+            wait = 0;
+        }
+#endif
+        if (!xQueueReceive(g_req_queue, &reqs[0], wait)) {
+#if (DISK_ASYNC_READ_AHEAD_SECTORS > 0)
+            if (g_ra.pending) {
+                disk_async_ra_perform();
+                continue;
+            }
+#endif
+            disk_async_idle();
+            continue;
+        }
+
+        /* Collect all the pending requests to schedule them together */
+        for (count = 1; count < DISK_ASYNC_QUEUE_SIZE && xQueueReceive(g_req_queue, &reqs[count], 0); count++) {
+            ;
+        }
+        disk_async_sort(reqs, count);
+
+        /* Serve the requests, merging the adjacent ones into single transfer */
+        for (i = 0; i < count; i = j)
+        {
+            uint32_t sectors = reqs[i]->count;
+            for (j = i + 1; j < count && disk_async_can_merge(reqs[j - 1], reqs[j], sectors); j++) {
+                sectors += reqs[j]->count;
+            }
+            disk_async_serve(&reqs[i], j - i, sectors);
+        }
+    }
+}
+
+
+
+bool disk_async_init(UBaseType_t priority)
+{
+    uint32_t i = 0;
+
+    if (g_disk_task) {
+        return true;
+    }
+
+    g_req_queue = xQueueCreate(DISK_ASYNC_QUEUE_SIZE, sizeof(disk_async_req_t*));
+    g_waiter_pool = xQueueCreate(DISK_ASYNC_MAX_WAITERS, sizeof(SemaphoreHandle_t));
+    if (!g_req_queue || !g_waiter_pool) {
+        return false;
+    }
+
+    for (i = 0; i < DISK_ASYNC_MAX_WAITERS; i++) {
+        SemaphoreHandle_t s = xSemaphoreCreateBinary();
+        if (!s) {
+            return false;
+        }
+        xQueueSend(g_waiter_pool, &s, 0);
+    }
+
+#if BUILD_CFG_MPU
+    priority |= portPRIVILEGE_BIT;
+#endif
+
+    return xTaskCreate(disk_async_task, "diskio", DISK_ASYNC_STACK_SIZE / sizeof(StackType_t),
+                       NULL, priority, &g_disk_task);
+}
+
+bool disk_async_is_running(void)
+{
+    /* The disk I/O task itself must not use the queue, since nobody would serve it */
+    return (NULL != g_disk_task) &&
+           (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) &&
+           (g_disk_task != xTaskGetCurrentTaskHandle());
+}
+
+void disk_async_invalidate(BYTE drv)
+{
+#if (DISK_ASYNC_READ_AHEAD_SECTORS > 0)
+    if (drv < DISK_ASYNC_MAX_DRIVES) {
+        g_ra_changes[drv]++;
+    }
+#else
+    (void) drv;
+#endif
+}
+
+bool disk_async_submit(disk_async_req_t *pReq, TickType_t timeout)
+{
+    if (!pReq || !pReq->buff || 0 == pReq->count || !disk_async_is_running()) {
+        return false;
+    }
+
+    pReq->result = RES_NOTRDY;
+    return xQueueSend(g_req_queue, &pReq, timeout);
+}
+
+DRESULT disk_async_rw(BYTE drv, bool write, BYTE *buff, DWORD sector, BYTE count)
+{
+    disk_async_req_t req;
+    SemaphoreHandle_t done = NULL;
+
+    if (!xQueueReceive(g_waiter_pool, &done, portMAX_DELAY)) {
+        return RES_ERROR;
+    }
+
+    req.drv = drv;
+    req.count = count;
+    req.write = write;
+    req.buff = buff;
+    req.sector = sector;
+    req.callback = NULL;
+    req.arg = NULL;
+    req.done = done;
+
+    if (disk_async_submit(&req, portMAX_DELAY)) {
+        xSemaphoreTake(done, portMAX_DELAY);
+    }
+    else {
+        req.result = RES_ERROR;
+    }
+
+    xQueueSend(g_waiter_pool, &done, 0);
+    return req.result;
+}
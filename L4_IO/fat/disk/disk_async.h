@@ -0,0 +1,121 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief Asynchronous disk I/O request queue served by a single disk I/O task
+ * @ingroup Board IO
+ *
+ * Instead of each task holding the SPI lock for its entire disk transfer, the disk requests
+ * are queued to the disk I/O task that owns the SPI bus.  The task collects the pending
+ * requests, sorts them by drive and sector, merges the adjacent requests into a single
+ * multi-sector transfer, and reads ahead the next sectors of a sequential read when it
+ * has nothing else to do.  After the writes, the background work of the drives, such as the
+ * erase of the free flash pages, is performed while idle (@see disk_idle()).
+ *
+ * Once disk_async_init() is called, disk_read() and disk_write() use this layer
+ * automatically, so the FatFs users do not need to change.
+ *
+ * 20261014 : Added the background work of the drives while idle
+ * 20141014 : Initial
+ */
+#ifndef DISK_ASYNC_H__
+#define DISK_ASYNC_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "diskioStructs.h"
+
+
+
+/** @{ Disk I/O task configuration */
+#define DISK_ASYNC_QUEUE_SIZE           8     ///< Number of requests that can be pending
+#define DISK_ASYNC_MAX_WAITERS          4     ///< Number of tasks that can wait on disk_async_rw() at once
+#define DISK_ASYNC_READ_AHEAD_SECTORS   4     ///< Sectors read ahead during sequential reads (0 to disable)
+#define DISK_ASYNC_STACK_SIZE           (512 * 4)   ///< Stack size of the disk I/O task in bytes
+#define DISK_ASYNC_IDLE_POLL_MS         4     ///< Polling period of the background work of disk_idle()
+/** @} */
+
+struct disk_async_req;
+
+/// Callback of a request, this is called by the disk I/O task after the request completes
+typedef void (*disk_async_cb_t)(struct disk_async_req *pReq);
+
+/**
+ * A disk request.  The memory of the request and its buffer must remain valid until it completes.
+ * Either the callback, or the semaphore (or both) can be used to find out when it completes.
+ */
+typedef struct disk_async_req {
+    BYTE drv;                   ///< The drive number (@see DriveNumberType)
+    BYTE count;                 ///< Number of sectors
+    bool write;                 ///< true for a write request, false for a read request
+    BYTE *buff;                 ///< The data buffer
+    DWORD sector;               ///< The starting sector
+
+    disk_async_cb_t callback;   ///< Optional callback
+    void *arg;                  ///< Optional argument for the callback
+    SemaphoreHandle_t done;     ///< Optional binary semaphore given upon the completion
+
+    volatile DRESULT result;    ///< The result of the request, set before the completion is signaled
+} disk_async_req_t;
+
+
+
+/**
+ * Creates the disk I/O task.  After this, disk_read() and disk_write() are served by this task
+ * once the FreeRTOS scheduler starts.
+ * @param priority  The priority of the disk I/O task
+ * @returns true if successful
+ */
+bool disk_async_init(UBaseType_t priority);
+
+/// @returns true if the disk I/O task is running and the caller can use disk_async_submit()
+bool disk_async_is_running(void);
+
+/**
+ * Drops the read-ahead data of a drive after its sectors are changed without the disk I/O task,
+ * which disk_ioctl() does after CTRL_ERASE_SECTOR.  This can be called by any task.
+ * @param drv  The drive number (@see DriveNumberType)
+ */
+void disk_async_invalidate(BYTE drv);
+
+/**
+ * Queues a disk request to the disk I/O task.
+ * @param timeout  The OS ticks to wait if the request queue is full
+ * @returns true if the request was queued
+ */
+bool disk_async_submit(disk_async_req_t *pReq, TickType_t timeout);
+
+/**
+ * Submits the request and waits for it to complete.  This is what disk_read()
+ * and disk_write() use if the disk I/O task is running.
+ * @returns the result of the disk request
+ */
+DRESULT disk_async_rw(BYTE drv, bool write, BYTE *buff, DWORD sector, BYTE count);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* DISK_ASYNC_H__ */
@@ -3,23 +3,76 @@
 #include "sd.h"
 #include "c_tlm_var.h"
 #include "spi_sem.h"
+#include "disk_async.h"
+#include "ssp1.h"
+#include "sys_config.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "profile.h"
 
 
 
+/**
+ * The drivers give the SPI to other tasks while their device is busy (@see spi1_yield()), so
+ * each drive has its own lock that is held for the whole operation to protect the driver data.
+ * The locks are created by disk_lock_init() before the scheduler starts.
+ */
+static SemaphoreHandle_t g_drive_lock[2] = { 0 };
+
+bool disk_lock_init(void)
+{
+    for (unsigned int i = 0; i < sizeof(g_drive_lock) / sizeof(g_drive_lock[0]); i++) {
+        if (!g_drive_lock[i] && !(g_drive_lock[i] = xSemaphoreCreateMutex())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Locks the drive and the SPI
+ * @returns true if the lock of the drive was taken, which is given back by disk_unlock().
+ *          It is not taken before the scheduler starts, so the scheduler can start in between.
+ */
+static bool disk_lock(BYTE drv)
+{
+    bool locked = false;
+    if (drv < sizeof(g_drive_lock) / sizeof(g_drive_lock[0]) && g_drive_lock[drv] &&
+        taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        locked = xSemaphoreTake(g_drive_lock[drv], portMAX_DELAY);
+    }
+    spi1_lock();
+    return locked;
+}
+
+static void disk_unlock(BYTE drv, bool locked)
+{
+    spi1_unlock();
+    if (locked) {
+        xSemaphoreGive(g_drive_lock[drv]);
+    }
+}
+
 DSTATUS disk_initialize(BYTE drv)
 {
     DSTATUS status = RES_PARERR;
 
-    spi1_lock();
+    const bool locked = disk_lock(drv);
     {
         switch(drv)
         {
             case driveNumFlashMem: status = flash_initialize();    break;
-            case driveNumSdCard:   status = sd_initialize();       break;
+            case driveNumSdCard:
+                status = sd_initialize();
+
+                /* SD card initialization modifies the SPI speed, so reset desired speed for the flash memory too */
+                ssp1_set_max_clock(SYS_CFG_SPI1_CLK_MHZ);
+                break;
             default: status = RES_PARERR;    break;
         }
     }
-    spi1_unlock();
+    disk_unlock(drv, locked);
 
     return status;
 }
@@ -42,59 +95,72 @@ DSTATUS disk_status(BYTE drv)
     return status;
 }
 
-DRESULT disk_read (BYTE drv, BYTE *buff, DWORD sector, BYTE count)
+DRESULT disk_rw_now(BYTE drv, bool write, BYTE *buff, DWORD sector, BYTE count)
 {
     DSTATUS status = RES_PARERR;
 
-    spi1_lock();
+    const bool locked = disk_lock(drv);
     {
         switch(drv)
         {
             case driveNumFlashMem:
-                status = flash_read_sectors(buff, sector, count);
+                status = write ? flash_write_sectors(buff, sector, count) :
+                                 flash_read_sectors(buff, sector, count);
                 break;
             case driveNumSdCard:
-                status = sd_read(buff, sector, count);
+                status = write ? sd_write(buff, sector, count) :
+                                 sd_read(buff, sector, count);
                 break;
             default:
                 status = RES_PARERR;
                 break;
         }
     }
-    spi1_unlock();
+    disk_unlock(drv, locked);
 
     return status;
 }
 
-DRESULT disk_write(BYTE drv, const BYTE *buff, DWORD sector, BYTE count)
+bool disk_idle(BYTE drv)
 {
-    DSTATUS status = RES_PARERR;
+    bool more = false;
 
-    spi1_lock();
+    const bool locked = disk_lock(drv);
     {
         switch(drv)
         {
-            case driveNumFlashMem:
-                status = flash_write_sectors((unsigned char*)buff, sector, count);
-                break;
-            case driveNumSdCard:
-                status = sd_write(buff, sector, count);
-                break;
-            default:
-                status = RES_PARERR;
-                break;
+            case driveNumFlashMem: more = flash_erase_idle();  break;
+            default:            more = false; break;
         }
     }
-    spi1_unlock();
+    disk_unlock(drv, locked);
 
-    return status;
+    return more;
+}
+
+DRESULT disk_read (BYTE drv, BYTE *buff, DWORD sector, BYTE count)
+{
+    PROFILE_SCOPE("disk_read");
+    if (disk_async_is_running()) {
+        return disk_async_rw(drv, false, buff, sector, count);
+    }
+    return disk_rw_now(drv, false, buff, sector, count);
+}
+
+DRESULT disk_write(BYTE drv, const BYTE *buff, DWORD sector, BYTE count)
+{
+    PROFILE_SCOPE("disk_write");
+    if (disk_async_is_running()) {
+        return disk_async_rw(drv, true, (BYTE*) buff, sector, count);
+    }
+    return disk_rw_now(drv, true, (BYTE*) buff, sector, count);
 }
 
 DRESULT disk_ioctl(BYTE drv, BYTE ctrl,void *buff)
 {
     DSTATUS status = RES_PARERR;
 
-    spi1_lock();
+    const bool locked = disk_lock(drv);
     {
         switch(drv)
         {
@@ -103,7 +169,12 @@ DRESULT disk_ioctl(BYTE drv, BYTE ctrl,void *buff)
             default:            status = RES_PARERR; break;
         }
     }
-    spi1_unlock();
+    disk_unlock(drv, locked);
+
+    /* The erase is not served by the disk I/O task, so its read-ahead data may have the old sectors */
+    if (CTRL_ERASE_SECTOR == ctrl) {
+        disk_async_invalidate(drv);
+    }
 
     return status;
 }
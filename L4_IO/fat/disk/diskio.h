@@ -5,6 +5,7 @@ extern "C" {
 #endif
 
 
+#include <stdbool.h>
 #include "disk_defines.h"
 #include "diskioStructs.h"  // DSTATUS
 
@@ -14,6 +15,12 @@ typedef enum {
     driveNumSdCard = 1
 } DriveNumberType;
 
+/**
+ * Creates the locks of the drives, which must be done before the scheduler starts
+ * @returns false if a lock could not be created
+ */
+bool disk_lock_init(void);
+
 /**
  * Initializes the disk given by @param drv
  */
@@ -44,6 +51,21 @@ DRESULT disk_read (BYTE drv, BYTE *buff, DWORD sector, BYTE count);
  */
 DRESULT disk_write(BYTE drv, const BYTE *buff, DWORD sector, BYTE count);
 
+/**
+ * Performs the disk read or write immediately while holding the SPI lock.
+ * disk_read() and disk_write() use this directly until the disk I/O task is started,
+ * after which the disk I/O task uses this to serve the requests (@see disk_async.h)
+ */
+DRESULT disk_rw_now(BYTE drv, bool write, BYTE *buff, DWORD sector, BYTE count);
+
+/**
+ * Performs one step of the background work of the drive while holding the SPI lock, such as
+ * the background erase of the flash memory (@see flash_erase_idle()).  The disk I/O task
+ * calls this while it has no requests.
+ * @returns true if the drive has more background work, and this should be called again later
+ */
+bool disk_idle(BYTE drv);
+
 /**
  * Gets control data of the disk
  * @param drv   The drive number to get data from
@@ -6,6 +6,8 @@
 #include "disk_defines.h"
 #include "bio.h"            // flash cs and ds
 #include "fat/ff.h"         // FR_OK and FR_DISK_ERR
+#include "spi_sem.h"        // spi1_yield()
+#include "lpc_sys.h"        // sys_get_uptime_ms()
 
 
 
@@ -62,6 +64,18 @@ static inline void flash_spi_multi_io(void *p, int len) {   ssp1_exchange_data(p
  */
 #define FLASH_PAGENUM_BIT_OFFSET   9
 
+/**
+ * @{ The busy flash is polled for FLASH_BUSY_SPIN_MS, and after that the SPI is given to other tasks
+ * between the polls, doubling the delay up to FLASH_BUSY_MAX_DELAY_MS.  A page program takes a few
+ * milliseconds, and a page erase and program up to 35ms.
+ */
+#define FLASH_BUSY_SPIN_MS          1
+#define FLASH_BUSY_MAX_DELAY_MS     4
+/** @} */
+
+/// Pages written by flash_write_run() between the reads of their write counters
+#define FLASH_WRITE_BURST_PAGES     8
+
 /// Function pointer of I/O operation
 typedef void (*flash_io_func_t) (uint8_t *data, const uint32_t addr, const uint32_t size);
 
@@ -85,6 +99,24 @@ typedef enum {
     opcode_buffer1_to_mem_no_builtin_erase = 0x88,
     /** @} */
 
+    /**
+     * @{ Multi-page writes alternate the two buffers: one buffer is filled while the page
+     * of the other buffer is being programmed (@see flash_write_run())
+     */
+    opcode_write_buffer2     = 0x87,
+    opcode_buffer1_to_mem    = 0x83,
+    opcode_buffer2_to_mem    = 0x86,
+    opcode_buffer2_to_mem_no_builtin_erase = 0x89,
+    /** @} */
+
+    /**
+     * @{ A background erase is suspended to read the other pages, and then resumed
+     * (@see flash_erase_idle())
+     */
+    opcode_suspend           = 0xB0,
+    opcode_resume            = 0xD0,
+    /** @} */
+
     opcode_read_security_reg  = 0x77,
     opcode_write_security_reg = 0x9B,
 } flash_opcode_t;
@@ -113,8 +145,51 @@ typedef enum {
 static flash_cap_t g_flash_capacity = flash_cap_invalid;
 static uint16_t g_flash_pagesize    = 0;
 static uint32_t g_sector_count = 0;
+static bool g_reserved_ok = false;  ///< The crash and the raw sectors are not used by the file system
+static bool g_raw_buffer2 = false;  ///< The buffer of the flash memory of the next raw page
+static bool g_raw_programming = false; ///< A raw page may be programming, and nothing else used the flash since
 /// @}
 
+#if (FLASH_CACHE_SECTORS > 0)
+/**
+ * Requests larger than this many sectors bypass the cache for the sectors that are not cached,
+ * otherwise a large file read or write would evict the FAT and directory sectors.
+ */
+#define FLASH_CACHE_BYPASS_COUNT    (FLASH_CACHE_SECTORS / 2)
+
+/// Cache entry of one sector
+typedef struct {
+    int32_t sector;     ///< The cached sector number, or -1 if this entry is unused
+    uint32_t last_use;  ///< Value of g_cache_use_counter when this entry was last used
+    bool dirty;         ///< true if the data has not been written to the flash yet
+} flash_cache_entry_t;
+
+/// @{ Sector cache data; the data is a global because GPDMA cannot access the heap (@see loader.ld)
+static flash_cache_entry_t g_cache[FLASH_CACHE_SECTORS];
+static uint8_t g_cache_data[FLASH_CACHE_SECTORS][FLASH_SECTOR_SIZE];
+static uint32_t g_cache_use_counter = 0;
+/// @}
+#endif
+
+#if (FLASH_ERASE_POOL > 0)
+/**
+ * @{ Background erase (@see flash_erase_idle()).  A sector of g_erase_free is free but not erased yet.
+ * A sector of g_erase_pool is erased, and its write counter is kept until the sector is written
+ * because the erase also erases the spare bytes.
+ */
+static uint8_t g_erase_free[FLASH_ERASE_MAX_SECTORS / 8];
+static uint32_t g_erase_free_count = 0;
+static struct {
+    uint16_t sector;
+    uint32_t write_count;
+} g_erase_pool[FLASH_ERASE_POOL];
+static uint8_t g_erase_pool_count = 0;
+static uint32_t g_erase_cursor = 0;         ///< The sector after the last written sector
+static bool g_erase_busy = false;           ///< A background erase was started, and may still be in progress
+static bool g_erase_suspended = false;      ///< The background erase is suspended by flash_read_sectors()
+/** @} */
+#endif
+
 
 
 /** @{ Private Functions used at this file */
@@ -136,6 +211,23 @@ static inline uint32_t flash_get_metadata_addr_from_pageaddr(const uint32_t addr
     return (addr | byte_offset);
 }
 
+/// @returns the data bytes of a page, without the spare bytes of 264 and 528 byte pages
+static inline uint32_t flash_get_page_data_bytes(void)
+{
+    return (g_flash_pagesize & ~0x0000001F);
+}
+
+/// @returns the address of a page, as used by flash_perform_page_io_of_fatfs_sector()
+static inline uint32_t flash_get_page_addr(const uint32_t page)
+{
+    switch (g_flash_pagesize) {
+        /* 528 byte page requires 10 address bits, and 264 byte page requires 9 address bits */
+        case FLASH_PAGESIZE_528 : return (page << (FLASH_PAGENUM_BIT_OFFSET + 1));
+        case FLASH_PAGESIZE_264 : return (page << FLASH_PAGENUM_BIT_OFFSET);
+        default                 : return (page * g_flash_pagesize);
+    }
+}
+
 static inline void flash_send_op_addr(const flash_opcode_t opcode, const uint32_t addr)
 {
     uint8_t data[] = { (uint8_t)opcode, (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)(addr >> 0)};
@@ -145,19 +237,60 @@ static inline void flash_send_op_addr(const flash_opcode_t opcode, const uint32_
 static uint8_t flash_wait_for_ready()
 {
     const uint8_t busybit = (1 << 7); ///< "1" means device is ready
+    const uint64_t spin_until = sys_get_uptime_ms() + FLASH_BUSY_SPIN_MS;
+    uint32_t delay_ms = 1;
+    bool spin = false;
     uint8_t status = 0;
 
-    CHIP_SELECT_OP()
+    for (;;)
     {
-        flash_spi_io(opcode_status_reg);
-        do {
-            status = flash_spi_io(0xFF);
-        } while (! (status & busybit));
+        CHIP_SELECT_OP()
+        {
+            flash_spi_io(opcode_status_reg);
+            do {
+                status = flash_spi_io(0xFF);
+            } while (! (status & busybit) && (spin || sys_get_uptime_ms() < spin_until));
+        }
+
+        if (status & busybit) {
+            break;
+        }
+
+        /* The flash keeps programming while it is not selected; keep spinning if we cannot yield */
+        spin = !spi1_yield(delay_ms);
+        if (delay_ms < FLASH_BUSY_MAX_DELAY_MS) {
+            delay_ms *= 2;
+        }
     }
 
+#if (FLASH_ERASE_POOL > 0)
+    /* The background erase is done, unless it is only suspended */
+    if (!g_erase_suspended) {
+        g_erase_busy = false;
+    }
+#endif
+
+    /* Neither buffer is being programmed, @see flash_raw_write_page() */
+    g_raw_programming = false;
     return status;
 }
 
+#if (FLASH_ERASE_POOL > 0)
+/// @returns true if the flash is ready, without waiting for it
+static bool flash_is_ready(void)
+{
+    const uint8_t busybit = (1 << 7); ///< "1" means device is ready
+    uint8_t status = 0;
+
+    CHIP_SELECT_OP()
+    {
+        flash_spi_io(opcode_status_reg);
+        status = flash_spi_io(0xFF);
+    }
+    return !!(status & busybit);
+}
+#endif
+
 static void flash_write_page(uint8_t *data, const uint32_t addr, const uint32_t size)
 {
     uint32_t writeCounter = 0xFFFFFFFF;
@@ -236,6 +369,713 @@ static void flash_perform_page_io_of_fatfs_sector(flash_io_func_t func, uint8_t*
         func((pData + halfsector), addr, halfsector);
     }
 }
+
+#if (FLASH_FTL_ENABLE)
+/**
+ * @{ Flash translation layer (FTL)
+ *
+ * Each FatFs sector (logical sector) is written to a different flash page (physical sector) each time,
+ * so the FAT and frequently written sectors do not wear out the same page.  The 16 spare bytes of a 528
+ * byte page store the write counter (same as flash_write_page()), the logical sector, and a sequence
+ * number, so the mapping is rebuilt by flash_ftl_mount() by scanning the spare bytes of all the pages.
+ * If a logical sector is found in multiple pages (power loss before the old page is reused), the page
+ * with the higher sequence number is the valid one, and the other pages are garbage to be reused.
+ *
+ * Free pages are selected in a round-robin fashion skipping the pages that are worn out more than
+ * FLASH_FTL_WEAR_DELTA writes above the average.  A few free pages are erased after each write so the
+ * next writes can program them without the built-in erase cycle, which is faster.
+ */
+#define FLASH_FTL_UNMAPPED          0xFFFF
+#define FLASH_FTL_CHECK(l, s)       (~((l) ^ (s)))
+
+/// Spare bytes at the end of a 528 byte page
+typedef struct {
+    uint32_t write_count;   ///< Write counter, same as the metadata of flash_write_page()
+    uint32_t logical;       ///< The logical sector stored in this page
+    uint32_t seq;           ///< Sequence number of the write; higher is newer
+    uint32_t check;         ///< FLASH_FTL_CHECK() to tell apart the pages not written by the FTL
+} flash_ftl_spare_t;
+
+static bool g_ftl_enabled = false;                          ///< Only enabled for 528 byte pages
+static uint16_t g_ftl_map[FLASH_FTL_MAX_SECTORS];           ///< Logical to physical sector map
+static uint8_t g_ftl_used[FLASH_FTL_MAX_SECTORS / 8];       ///< Bitmap of physical sectors with valid data
+static uint32_t g_ftl_phys_count = 0;                       ///< Number of physical sectors
+static uint32_t g_ftl_logical_count = 0;                    ///< Number of logical sectors
+static uint32_t g_ftl_seq = 0;                              ///< The next sequence number
+static uint32_t g_ftl_cursor = 0;                           ///< The next physical sector for the allocator
+static uint32_t g_ftl_avg_write_count = 0;                  ///< Average write count found during the mount
+
+/// Pre-erased pages, and their write counts because the erase also erases the spare bytes
+static struct {
+    uint16_t page;
+    uint32_t write_count;
+} g_ftl_erased[FLASH_FTL_ERASED_POOL];
+static uint8_t g_ftl_erased_count = 0;
+
+static inline uint32_t flash_ftl_page_addr(const uint32_t page)
+{
+    /* 528 byte page requires 10 address bits, then 12 page number bits, and 2 dummy bits */
+    return (page << (FLASH_PAGENUM_BIT_OFFSET + 1));
+}
+
+static inline bool flash_ftl_is_used(const uint32_t page)
+{
+    return !!(g_ftl_used[page / 8] & (1 << (page % 8)));
+}
+
+static inline void flash_ftl_set_used(const uint32_t page, const bool used)
+{
+    if (used) {
+        g_ftl_used[page / 8] |= (1 << (page % 8));
+    }
+    else {
+        g_ftl_used[page / 8] &= ~(1 << (page % 8));
+    }
+}
+
+static bool flash_ftl_is_erased(const uint32_t page)
+{
+    for (uint8_t i = 0; i < g_ftl_erased_count; i++) {
+        if (page == g_ftl_erased[i].page) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void flash_ftl_read_spare(const uint32_t page, flash_ftl_spare_t *pSpare)
+{
+    memset(pSpare, 0xFF, sizeof(*pSpare));
+    CHIP_SELECT_OP()
+    {
+        flash_send_op_addr(opcode_read_cont_lowfreq, flash_ftl_page_addr(page) | FLASH_SECTOR_SIZE);
+        flash_spi_multi_io(pSpare, sizeof(*pSpare));
+    }
+}
+
+static inline bool flash_ftl_spare_valid(const flash_ftl_spare_t *pSpare)
+{
+    return (pSpare->logical < g_ftl_logical_count) && (FLASH_FTL_CHECK(pSpare->logical, pSpare->seq) == pSpare->check);
+}
+
+static inline uint32_t flash_ftl_write_count(const flash_ftl_spare_t *pSpare)
+{
+    return (UINT32_MAX == pSpare->write_count) ? 0 : pSpare->write_count;
+}
+
+/// Clears the map; all the physical sectors become free
+static void flash_ftl_reset(void)
+{
+    memset(g_ftl_map, 0xFF, sizeof(g_ftl_map));
+    memset(g_ftl_used, 0, sizeof(g_ftl_used));
+    g_ftl_erased_count = 0;
+    g_ftl_cursor = 0;
+}
+
+/// Rebuilds the map from the spare bytes of all the pages
+static void flash_ftl_mount(void)
+{
+    flash_ftl_spare_t spare, other;
+    uint64_t total_writes = 0;
+
+    g_ftl_enabled = false;
+    g_ftl_phys_count = (flash_get_mem_size_bytes() / FLASH_SECTOR_SIZE) - FLASH_CRASH_SECTORS - FLASH_RAW_SECTORS;
+    if (FLASH_PAGESIZE_528 != g_flash_pagesize || g_ftl_phys_count > FLASH_FTL_MAX_SECTORS) {
+        return;
+    }
+
+    g_ftl_logical_count = g_ftl_phys_count - FLASH_FTL_RESERVED_SECTORS;
+    g_ftl_seq = 0;
+    flash_ftl_reset();
+
+    for (uint32_t page = 0; page < g_ftl_phys_count; page++)
+    {
+        flash_ftl_read_spare(page, &spare);
+        total_writes += flash_ftl_write_count(&spare);
+
+        if (!flash_ftl_spare_valid(&spare)) {
+            continue;
+        }
+        if (spare.seq >= g_ftl_seq) {
+            g_ftl_seq = spare.seq + 1;
+        }
+
+        /* Keep the newer copy if the logical sector is found twice */
+        const uint16_t existing = g_ftl_map[spare.logical];
+        if (FLASH_FTL_UNMAPPED != existing) {
+            flash_ftl_read_spare(existing, &other);
+            if (other.seq > spare.seq) {
+                continue;
+            }
+            flash_ftl_set_used(existing, false);
+        }
+
+        g_ftl_map[spare.logical] = page;
+        flash_ftl_set_used(page, true);
+    }
+
+    g_ftl_avg_write_count = total_writes / g_ftl_phys_count;
+    g_ftl_enabled = true;
+}
+
+/**
+ * Finds a free physical sector starting at the cursor
+ * @param skip_worn  If true, the pages worn out above the average are skipped
+ * @param pSpare     The spare bytes of the selected page
+ * @returns the physical sector or FLASH_FTL_UNMAPPED if none found
+ */
+static uint16_t flash_ftl_find_free(const bool skip_worn, flash_ftl_spare_t *pSpare)
+{
+    for (uint32_t tries = 0; tries < g_ftl_phys_count; tries++)
+    {
+        const uint32_t page = g_ftl_cursor;
+        g_ftl_cursor = (g_ftl_cursor + 1) % g_ftl_phys_count;
+
+        if (flash_ftl_is_used(page) || flash_ftl_is_erased(page)) {
+            continue;
+        }
+
+        flash_ftl_read_spare(page, pSpare);
+        if (skip_worn && flash_ftl_write_count(pSpare) > (g_ftl_avg_write_count + FLASH_FTL_WEAR_DELTA)) {
+            continue;
+        }
+        return page;
+    }
+    return FLASH_FTL_UNMAPPED;
+}
+
+/// Erases a free page to be used by a later write, the erase continues in the background
+static void flash_ftl_pre_erase(void)
+{
+    flash_ftl_spare_t spare;
+
+    if (g_ftl_erased_count >= FLASH_FTL_ERASED_POOL) {
+        return;
+    }
+
+    const uint16_t page = flash_ftl_find_free(true, &spare);
+    if (FLASH_FTL_UNMAPPED != page)
+    {
+        g_ftl_erased[g_ftl_erased_count].page = page;
+        g_ftl_erased[g_ftl_erased_count].write_count = flash_ftl_write_count(&spare);
+        g_ftl_erased_count++;
+
+        flash_wait_for_ready();
+        CHIP_SELECT_OP()
+        {
+            flash_send_op_addr(opcode_page_erase, flash_ftl_page_addr(page));
+        }
+#if (FLASH_ERASE_POOL > 0)
+        g_erase_busy = true;
+#endif
+    }
+}
+
+static void flash_ftl_read(uint8_t *pData, const uint32_t logical)
+{
+    const uint16_t page = g_ftl_map[logical];
+
+    /* Sector that was never written reads like erased flash */
+    if (FLASH_FTL_UNMAPPED == page) {
+        memset(pData, 0xFF, FLASH_SECTOR_SIZE);
+    }
+    else {
+        flash_read_page(pData, flash_ftl_page_addr(page), FLASH_SECTOR_SIZE);
+    }
+}
+
+static DRESULT flash_ftl_write(uint8_t *pData, const uint32_t logical)
+{
+    flash_ftl_spare_t spare;
+    uint16_t page = FLASH_FTL_UNMAPPED;
+    uint32_t write_count = 0;
+    bool pre_erased = false;
+
+    if (g_ftl_erased_count > 0) {
+        --g_ftl_erased_count;
+        page = g_ftl_erased[g_ftl_erased_count].page;
+        write_count = g_ftl_erased[g_ftl_erased_count].write_count;
+        pre_erased = true;
+    }
+    else {
+        /* If all free pages are worn out, use any free page */
+        page = flash_ftl_find_free(true, &spare);
+        if (FLASH_FTL_UNMAPPED == page) {
+            page = flash_ftl_find_free(false, &spare);
+        }
+        if (FLASH_FTL_UNMAPPED == page) {
+            return RES_ERROR;
+        }
+        write_count = flash_ftl_write_count(&spare);
+    }
+
+    spare.write_count = write_count + 1;
+    spare.logical = logical;
+    spare.seq = g_ftl_seq++;
+    spare.check = FLASH_FTL_CHECK(spare.logical, spare.seq);
+
+    flash_wait_for_ready();
+    if (pre_erased)
+    {
+        /* Fill the buffer, and program the erased page without the built-in erase cycle */
+        CHIP_SELECT_OP()
+        {
+            flash_send_op_addr(opcode_write_buffer1, 0);
+            ssp1_dma_transfer_block(pData, FLASH_SECTOR_SIZE, 1);
+            flash_spi_multi_io(&spare, sizeof(spare));
+        }
+        CHIP_SELECT_OP()
+        {
+            flash_send_op_addr(opcode_buffer1_to_mem_no_builtin_erase, flash_ftl_page_addr(page));
+        }
+    }
+    else
+    {
+        CHIP_SELECT_OP()
+        {
+            flash_send_op_addr(opcode_prog_thru_buffer1, flash_ftl_page_addr(page));
+            ssp1_dma_transfer_block(pData, FLASH_SECTOR_SIZE, 1);
+            flash_spi_multi_io(&spare, sizeof(spare));
+        }
+    }
+
+    /* The previous page of this logical sector is now free */
+    const uint16_t old_page = g_ftl_map[logical];
+    if (FLASH_FTL_UNMAPPED != old_page) {
+        flash_ftl_set_used(old_page, false);
+    }
+    g_ftl_map[logical] = page;
+    flash_ftl_set_used(page, true);
+
+#if (FLASH_ERASE_POOL > 0)
+    /* flash_erase_idle() refills the pool while the disk is idle, so a read does not wait for the erase */
+    if (0 == g_ftl_erased_count)
+#endif
+    flash_ftl_pre_erase();
+    return RES_OK;
+}
+/** @} */
+#endif /* FLASH_FTL_ENABLE */
+
+/// @returns true if the sectors are written to the pages chosen by the FTL
+static inline bool flash_ftl_is_enabled(void)
+{
+#if (FLASH_FTL_ENABLE)
+    return g_ftl_enabled;
+#else
+    return false;
+#endif
+}
+
+/** @{ Background erase of the free sectors (@see flash_erase_idle()) */
+#if (FLASH_ERASE_POOL > 0)
+/// @returns true if the free sectors are tracked, which requires one page per sector and no FTL
+static inline bool flash_erase_is_tracked(void)
+{
+    return (FLASH_SECTOR_SIZE == flash_get_page_data_bytes()) && (g_sector_count <= FLASH_ERASE_MAX_SECTORS) &&
+           !flash_ftl_is_enabled();
+}
+
+static inline bool flash_erase_is_free(const uint32_t sector)
+{
+    return !!(g_erase_free[sector / 8] & (1 << (sector % 8)));
+}
+
+/// @returns the index of the sector in g_erase_pool, or -1 if the sector is not erased
+static int flash_erase_find(const uint32_t sector)
+{
+    for (int i = 0; i < g_erase_pool_count; i++) {
+        if (sector == g_erase_pool[i].sector) {
+            return i;
+        }
+    }
+    return -1;
+}
+#endif
+
+static void flash_erase_reset(void)
+{
+#if (FLASH_ERASE_POOL > 0)
+    memset(g_erase_free, 0, sizeof(g_erase_free));
+    g_erase_free_count = 0;
+    g_erase_pool_count = 0;
+    g_erase_cursor = 0;
+    g_erase_busy = false;
+    g_erase_suspended = false;
+#endif
+}
+
+/// Marks the sectors removed by FatFs as free, so flash_erase_idle() can erase them
+static void flash_erase_trim(uint32_t first, const uint32_t last)
+{
+#if (FLASH_FTL_ENABLE)
+    /* The pages of the removed sectors become free pages of the FTL */
+    if (g_ftl_enabled) {
+        for ( ; first <= last && first < g_ftl_logical_count; first++) {
+            const uint16_t page = g_ftl_map[first];
+            if (FLASH_FTL_UNMAPPED != page) {
+                flash_ftl_set_used(page, false);
+                g_ftl_map[first] = FLASH_FTL_UNMAPPED;
+            }
+        }
+        return;
+    }
+#endif
+#if (FLASH_ERASE_POOL > 0)
+    if (flash_erase_is_tracked()) {
+        for ( ; first <= last && first < g_sector_count; first++) {
+            if (!flash_erase_is_free(first) && flash_erase_find(first) < 0) {
+                g_erase_free[first / 8] |= (1 << (first % 8));
+                g_erase_free_count++;
+            }
+        }
+    }
+#else
+    (void) first;
+    (void) last;
+#endif
+}
+
+/**
+ * Updates the background erase state of a sector that is about to be written
+ * @param pWriteCount  The write counter of the erased sector is written here
+ * @returns true if the sector is erased, and can be programmed without the built-in erase cycle
+ */
+static bool flash_erase_written(const uint32_t sector, uint32_t *pWriteCount)
+{
+#if (FLASH_ERASE_POOL > 0)
+    const int i = flash_erase_find(sector);
+
+    g_erase_cursor = sector + 1;
+    if (i >= 0) {
+        *pWriteCount = g_erase_pool[i].write_count;
+        g_erase_pool[i] = g_erase_pool[--g_erase_pool_count];
+        return true;
+    }
+    if (flash_erase_is_tracked() && flash_erase_is_free(sector)) {
+        g_erase_free[sector / 8] &= ~(1 << (sector % 8));
+        g_erase_free_count--;
+    }
+#else
+    (void) sector;
+    (void) pWriteCount;
+#endif
+    return false;
+}
+
+/// Suspends the background erase (if it is still in progress) to read the other pages
+static void flash_erase_suspend(void)
+{
+#if (FLASH_ERASE_POOL > 0)
+    if (g_erase_busy && !g_erase_suspended && !flash_is_ready()) {
+        CHIP_SELECT_OP()
+        {
+            flash_spi_io(opcode_suspend);
+        }
+        g_erase_suspended = true;
+    }
+#endif
+}
+
+/// Resumes the background erase suspended by flash_erase_suspend()
+static void flash_erase_resume(void)
+{
+#if (FLASH_ERASE_POOL > 0)
+    if (g_erase_suspended) {
+        g_erase_suspended = false;
+        CHIP_SELECT_OP()
+        {
+            flash_spi_io(opcode_resume);
+        }
+    }
+#endif
+}
+/** @} */
+
+/// Programs a sector to its erased page without the built-in erase cycle
+static void flash_write_erased_page(uint8_t *pData, const uint32_t sector, uint32_t writeCounter)
+{
+    /* The buffer may still be in use by the previous write */
+    flash_wait_for_ready();
+    CHIP_SELECT_OP()
+    {
+        flash_send_op_addr(opcode_write_buffer1, 0);
+        ssp1_dma_transfer_block(pData, FLASH_SECTOR_SIZE, 1);
+
+        if (flash_supports_metadata()) {
+            ++writeCounter;
+            flash_spi_multi_io(&writeCounter, sizeof(writeCounter));
+        }
+    }
+    CHIP_SELECT_OP()
+    {
+        flash_send_op_addr(opcode_buffer1_to_mem_no_builtin_erase, flash_get_page_addr(sector));
+    }
+}
+
+/// Reads a FatFs sector through the FTL if it is enabled
+static void flash_read_sector(uint8_t *pData, const uint32_t sector)
+{
+#if (FLASH_FTL_ENABLE)
+    if (g_ftl_enabled) {
+        flash_ftl_read(pData, sector);
+        return;
+    }
+#endif
+    flash_perform_page_io_of_fatfs_sector(flash_read_page, pData, (sector * FLASH_SECTOR_SIZE));
+}
+
+/// Writes a FatFs sector through the FTL if it is enabled
+static DRESULT flash_write_sector(uint8_t *pData, const uint32_t sector)
+{
+    uint32_t writeCounter = 0;
+
+    /* The flash cannot program while the erase is suspended */
+    flash_erase_resume();
+
+#if (FLASH_FTL_ENABLE)
+    if (g_ftl_enabled) {
+        return flash_ftl_write(pData, sector);
+    }
+#endif
+    if (flash_erase_written(sector, &writeCounter)) {
+        flash_write_erased_page(pData, sector, writeCounter);
+    }
+    else {
+        flash_perform_page_io_of_fatfs_sector(flash_write_page, pData, (sector * FLASH_SECTOR_SIZE));
+    }
+    return RES_OK;
+}
+
+/**
+ * Reads consecutive FatFs sectors with a single continuous read; the flash memory moves on to
+ * the next page by itself, so only the spare bytes between the pages need to be skipped.
+ */
+static void flash_read_run(uint8_t *pData, const uint32_t sector, const uint32_t count)
+{
+    /* The FTL pages of consecutive sectors are not consecutive */
+    if (1 == count || flash_ftl_is_enabled()) {
+        for (uint32_t i = 0; i < count; i++) {
+            flash_read_sector(pData + (i * FLASH_SECTOR_SIZE), sector + i);
+        }
+        return;
+    }
+
+    const uint32_t data_bytes = flash_get_page_data_bytes();
+    const uint32_t spare_bytes = g_flash_pagesize - data_bytes;
+    const uint32_t pages = count * (FLASH_SECTOR_SIZE / data_bytes);
+    uint8_t spare[FLASH_PAGESIZE_528 - FLASH_PAGESIZE_512];
+
+    CHIP_SELECT_OP()
+    {
+        flash_send_op_addr(opcode_read_cont_lowfreq, flash_get_page_addr(sector * (FLASH_SECTOR_SIZE / data_bytes)));
+        for (uint32_t i = 0; i < pages; i++) {
+            ssp1_dma_transfer_block(pData, data_bytes, 0);
+            pData += data_bytes;
+
+            if (spare_bytes > 0 && (i + 1) < pages) {
+                flash_spi_multi_io(&spare[0], spare_bytes);
+            }
+        }
+    }
+}
+
+/**
+ * Writes consecutive FatFs sectors.  The pages are programmed from the two buffers of the flash
+ * memory in turns, so the data of the next page is sent while the previous page is programmed.
+ */
+static DRESULT flash_write_run(uint8_t *pData, const uint32_t sector, const uint32_t count)
+{
+    if (1 == count || flash_ftl_is_enabled()) {
+        for (uint32_t i = 0; i < count; i++) {
+            if (RES_OK != flash_write_sector(pData + (i * FLASH_SECTOR_SIZE), sector + i)) {
+                return RES_ERROR;
+            }
+        }
+        return RES_OK;
+    }
+
+    const uint32_t data_bytes = flash_get_page_data_bytes();
+    const bool meta_data_exists = flash_supports_metadata();
+    uint32_t page = sector * (FLASH_SECTOR_SIZE / data_bytes);
+    uint32_t pages = count * (FLASH_SECTOR_SIZE / data_bytes);
+    uint32_t writeCounter[FLASH_WRITE_BURST_PAGES];
+    bool erased[FLASH_WRITE_BURST_PAGES];
+    bool buffer2 = false;
+
+    flash_erase_resume();
+    while (pages > 0)
+    {
+        const uint32_t burst = (pages < FLASH_WRITE_BURST_PAGES) ? pages : FLASH_WRITE_BURST_PAGES;
+
+        /* A previous write may still be programming from either buffer.  The write counters of
+         * the pages (@see flash_write_page()) can only be read while the flash is not programming,
+         * so they are read ahead for a burst of pages.
+         */
+        flash_wait_for_ready();
+        if (meta_data_exists) {
+            for (uint32_t i = 0; i < burst; i++) {
+                CHIP_SELECT_OP()
+                {
+                    flash_send_op_addr(opcode_read_cont_lowfreq,
+                                       flash_get_metadata_addr_from_pageaddr(flash_get_page_addr(page + i)));
+                    flash_spi_multi_io(&writeCounter[i], sizeof(writeCounter[i]));
+                }
+            }
+        }
+
+        /* The pages erased in the background use their saved write counters, and skip the built-in erase */
+        for (uint32_t i = 0; i < burst; i++) {
+            erased[i] = (FLASH_SECTOR_SIZE == data_bytes) && flash_erase_written(page + i, &writeCounter[i]);
+        }
+
+        for (uint32_t i = 0; i < burst; i++)
+        {
+            /* This buffer is not the one being programmed, so it can be filled while the flash is busy */
+            CHIP_SELECT_OP()
+            {
+                flash_send_op_addr(buffer2 ? opcode_write_buffer2 : opcode_write_buffer1, 0);
+                ssp1_dma_transfer_block(pData, data_bytes, 1);
+
+                if (meta_data_exists) {
+                    ++writeCounter[i];
+                    flash_spi_multi_io(&writeCounter[i], sizeof(writeCounter[i]));
+                }
+            }
+
+            const flash_opcode_t program = buffer2 ?
+                    (erased[i] ? opcode_buffer2_to_mem_no_builtin_erase : opcode_buffer2_to_mem) :
+                    (erased[i] ? opcode_buffer1_to_mem_no_builtin_erase : opcode_buffer1_to_mem);
+            flash_wait_for_ready();
+            CHIP_SELECT_OP()
+            {
+                flash_send_op_addr(program, flash_get_page_addr(page + i));
+            }
+
+            buffer2 = !buffer2;
+            pData += data_bytes;
+        }
+
+        page += burst;
+        pages -= burst;
+    }
+
+    return RES_OK;
+}
+
+#if (FLASH_CACHE_SECTORS > 0)
+static void flash_cache_invalidate(void)
+{
+    for (int i = 0; i < FLASH_CACHE_SECTORS; i++) {
+        g_cache[i].sector = -1;
+        g_cache[i].dirty = false;
+        g_cache[i].last_use = 0;
+    }
+}
+
+/// @returns the cache entry index of the sector, or -1 if the sector is not cached
+static int flash_cache_find(const int sector)
+{
+    for (int i = 0; i < FLASH_CACHE_SECTORS; i++) {
+        if (sector == g_cache[i].sector) {
+            g_cache[i].last_use = ++g_cache_use_counter;
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void flash_cache_write_back(const int i)
+{
+    if (g_cache[i].dirty) {
+        flash_write_sector(&g_cache_data[i][0], g_cache[i].sector);
+        g_cache[i].dirty = false;
+
+        /* The callers may read the flash next, which requires the flash to be ready */
+        flash_wait_for_ready();
+    }
+}
+
+/// Evicts the least recently used entry (writing it back if needed) and assigns it to the sector
+static int flash_cache_alloc(const int sector)
+{
+    int lru = 0;
+    for (int i = 0; i < FLASH_CACHE_SECTORS; i++) {
+        if (g_cache[i].sector < 0) {
+            lru = i;
+            break;
+        }
+        if (g_cache[i].last_use < g_cache[lru].last_use) {
+            lru = i;
+        }
+    }
+
+    flash_cache_write_back(lru);
+    g_cache[lru].sector = sector;
+    g_cache[lru].last_use = ++g_cache_use_counter;
+    return lru;
+}
+#endif
+/** @} */
+
+/** @{ Crash sectors, see FLASH_CRASH_SECTORS */
+/// @returns the first page of the crash sectors, which are after the sectors of FatFs and the FTL
+static inline uint32_t flash_crash_first_page(void)
+{
+    const uint32_t first_sector = (flash_get_mem_size_bytes() / FLASH_SECTOR_SIZE) - FLASH_CRASH_SECTORS;
+    return (first_sector * FLASH_SECTOR_SIZE) / flash_get_page_data_bytes();
+}
+
+/// Reads the bytes of sector 0 that do not cross a page of 256 bytes
+static void flash_crash_read_sector0(uint8_t *pData, const uint32_t offset, const uint32_t size)
+{
+#if (FLASH_FTL_ENABLE)
+    if (g_ftl_enabled) {
+        if (FLASH_FTL_UNMAPPED == g_ftl_map[0]) {
+            memset(pData, 0xFF, size);
+        }
+        else {
+            flash_read_page(pData, flash_ftl_page_addr(g_ftl_map[0]) + offset, size);
+        }
+        return;
+    }
+#endif
+    const uint32_t page_bytes = flash_get_page_data_bytes();
+    flash_read_page(pData, flash_get_page_addr(offset / page_bytes) + (offset % page_bytes), size);
+}
+
+/**
+ * @returns true if the volume of sector 0 (the boot sector, or the first partition of the MBR) ends
+ *          before the raw and the crash sectors, or if the flash memory is not formatted.  A file system
+ *          of an older format may end at a later sector, so the reserved sectors are not written.
+ */
+static bool flash_crash_check_volume(void)
+{
+    uint8_t boot[36] = { 0 };
+    uint8_t part[66] = { 0 };   /* The partition table and the signature at offset 446 */
+    uint32_t end = 0;
+
+    flash_crash_read_sector0(boot, 0, sizeof(boot));
+    flash_crash_read_sector0(part, 446, sizeof(part));
+
+    if (0x55 != part[64] || 0xAA != part[65]) {
+        return true;
+    }
+
+    /* The jump instruction of a boot sector, otherwise an MBR with the start and size of the partition */
+    if (0xEB == boot[0] || 0xE9 == boot[0]) {
+        end = boot[19] | (boot[20] << 8);
+        if (0 == end) {
+            end = boot[32] | (boot[33] << 8) | (boot[34] << 16) | ((uint32_t) boot[35] << 24);
+        }
+    }
+    else {
+        end = (part[8]  | (part[9]  << 8) | (part[10] << 16) | ((uint32_t) part[11] << 24)) +
+              (part[12] | (part[13] << 8) | (part[14] << 16) | ((uint32_t) part[15] << 24));
+    }
+
+    return (end <= g_sector_count);
+}
 /** @} */
 
 
@@ -270,50 +1110,108 @@ DSTATUS flash_initialize()
             g_flash_pagesize = (status & std_page_size_bit) ? FLASH_PAGESIZE_512 : FLASH_PAGESIZE_528;
         }
 
-        g_sector_count = flash_get_mem_size_bytes() / FLASH_SECTOR_SIZE;
+        g_sector_count = (flash_get_mem_size_bytes() / FLASH_SECTOR_SIZE) - FLASH_CRASH_SECTORS - FLASH_RAW_SECTORS;
+
+#if (FLASH_FTL_ENABLE)
+        /* FatFs only sees the logical sectors, the reserved sectors are spare pages of the FTL */
+        flash_ftl_mount();
+        if (g_ftl_enabled) {
+            g_sector_count = g_ftl_logical_count;
+        }
+#endif
+        g_reserved_ok = flash_crash_check_volume();
     }
 
+#if (FLASH_CACHE_SECTORS > 0)
+    flash_cache_invalidate();
+#endif
+    flash_erase_reset();
+
     return (0 == g_flash_pagesize) ? FR_DISK_ERR : FR_OK;
 }
 
 DRESULT flash_read_sectors(unsigned char *pData, int sectorNum, int sectorCount)
 {
-    uint32_t addr = (sectorNum * FLASH_SECTOR_SIZE);
-
-    if ((uint32_t) (sectorNum + sectorCount - 1) > g_sector_count)
+    if (sectorNum < 0 || (uint32_t) (sectorNum + sectorCount - 1) >= g_sector_count)
     {
         return RES_ERROR;
     }
 
-    /* Wait for any pending write operation to finish.  Once flash is ready, then
-     * we no longer need to perform this operation to read more sectors
+    /* Wait for any pending write operation to finish, but suspend a background erase instead of
+     * waiting for it.  Once flash is ready, then we no longer need to perform this operation to read
+     * more sectors
      */
+    flash_erase_suspend();
     flash_wait_for_ready();
 
-    for(int i = 0; i < sectorCount; i++)
+    for(int i = 0; i < sectorCount; )
     {
-        flash_perform_page_io_of_fatfs_sector(flash_read_page, pData, addr);
-        addr  += FLASH_SECTOR_SIZE;
-        pData += FLASH_SECTOR_SIZE;
+        int run = sectorCount - i;
+
+#if (FLASH_CACHE_SECTORS > 0)
+        int c = flash_cache_find(sectorNum + i);
+        if (c < 0 && sectorCount <= FLASH_CACHE_BYPASS_COUNT) {
+            c = flash_cache_alloc(sectorNum + i);
+            flash_read_sector(&g_cache_data[c][0], sectorNum + i);
+        }
+
+        if (c >= 0) {
+            memcpy(pData, &g_cache_data[c][0], FLASH_SECTOR_SIZE);
+            pData += FLASH_SECTOR_SIZE;
+            i++;
+            continue;
+        }
+
+        /* A cached sector may be newer than the flash, so the run stops at the next cached sector */
+        for (run = 1; (i + run) < sectorCount && flash_cache_find(sectorNum + i + run) < 0; run++) {
+        }
+#endif
+
+        flash_read_run(pData, sectorNum + i, run);
+        pData += (run * FLASH_SECTOR_SIZE);
+        i += run;
     }
 
+    flash_erase_resume();
     return RES_OK;
 }
 
 DRESULT flash_write_sectors(unsigned char *pData, int sectorNum, int sectorCount)
 {
-    uint32_t addr = (sectorNum * FLASH_SECTOR_SIZE);
-
-    if ((uint32_t) (sectorNum + sectorCount - 1) > g_sector_count)
+    if (sectorNum < 0 || (uint32_t) (sectorNum + sectorCount - 1) >= g_sector_count)
     {
         return RES_ERROR;
     }
 
-    for(int i = 0; i < sectorCount; i++)
+    for(int i = 0; i < sectorCount; )
     {
-        flash_perform_page_io_of_fatfs_sector(flash_write_page, pData, addr);
-        addr  += FLASH_SECTOR_SIZE;
-        pData += FLASH_SECTOR_SIZE;
+        int run = sectorCount - i;
+
+#if (FLASH_CACHE_SECTORS > 0)
+        /* Write-back: the page is only programmed upon eviction or flash_cache_flush() */
+        int c = flash_cache_find(sectorNum + i);
+        if (c < 0 && sectorCount <= FLASH_CACHE_BYPASS_COUNT) {
+            c = flash_cache_alloc(sectorNum + i);
+        }
+
+        if (c >= 0) {
+            memcpy(&g_cache_data[c][0], pData, FLASH_SECTOR_SIZE);
+            g_cache[c].dirty = true;
+            pData += FLASH_SECTOR_SIZE;
+            i++;
+            continue;
+        }
+
+        /* The cached sectors are updated in the cache, so the run stops at the next cached sector */
+        for (run = 1; (i + run) < sectorCount && flash_cache_find(sectorNum + i + run) < 0; run++) {
+        }
+#endif
+
+        if (RES_OK != flash_write_run(pData, sectorNum + i, run)) {
+            return RES_ERROR;
+        }
+        pData += (run * FLASH_SECTOR_SIZE);
+        i += run;
     }
 
     return RES_OK;
@@ -333,13 +1231,14 @@ DRESULT flash_ioctl(BYTE ctrl,void *buff)
 
         // Flush any pending write operation
         case CTRL_SYNC:
+            flash_cache_flush();
             flash_wait_for_ready();
             status = RES_OK;
             break;
 
         // Used by mkfs() while formatting the memory
         case GET_SECTOR_COUNT:
-            *(DWORD*) buff = (DWORD) ((flash_get_mem_size_bytes() / FLASH_SECTOR_SIZE));
+            *(DWORD*) buff = (DWORD) g_sector_count;
             status = RES_OK;
             break;
 
@@ -354,7 +1253,9 @@ DRESULT flash_ioctl(BYTE ctrl,void *buff)
             status = RES_OK;
             break;
 
+        // FatFs removed the clusters of these sectors, so they can be erased in the background
         case CTRL_ERASE_SECTOR:
+            flash_erase_trim(((DWORD*) buff)[0], ((DWORD*) buff)[1]);
             status = RES_OK;
             break;
 
@@ -408,13 +1309,17 @@ bool flash_supports_metadata(void)
 
 uint32_t flash_get_page_write_count(uint32_t page_number)
 {
-    /* Metadata is at the end of the page */
-    const uint32_t page_addr = (page_number << FLASH_PAGENUM_BIT_OFFSET);
+    /* Metadata is at the end of the page, and 528 byte page requires 10 address bits for the byte offset */
+    const uint32_t page_addr = (FLASH_PAGESIZE_528 == g_flash_pagesize) ?
+                               (page_number << (FLASH_PAGENUM_BIT_OFFSET + 1)) :
+                               (page_number << FLASH_PAGENUM_BIT_OFFSET);
     const uint32_t meta_data_addr = flash_get_metadata_addr_from_pageaddr(page_addr);
     uint32_t write_counter = UINT32_MAX;
 
     if (flash_supports_metadata())
     {
+        /* The memory cannot be read while a write of the disk task is being programmed */
+        flash_wait_for_ready();
         CHIP_SELECT_OP()
         {
             flash_send_op_addr(opcode_read_cont_lowfreq, meta_data_addr);
@@ -425,12 +1330,229 @@ uint32_t flash_get_page_write_count(uint32_t page_number)
     return (UINT32_MAX == write_counter) ? 0 : write_counter;
 }
 
+void flash_cache_flush(void)
+{
+#if (FLASH_CACHE_SECTORS > 0)
+    /* Write back in the order of the sectors */
+    for (int n = 0; n < FLASH_CACHE_SECTORS; n++) {
+        int next = -1;
+        for (int i = 0; i < FLASH_CACHE_SECTORS; i++) {
+            if (g_cache[i].dirty && (next < 0 || g_cache[i].sector < g_cache[next].sector)) {
+                next = i;
+            }
+        }
+        if (next < 0) {
+            break;
+        }
+        flash_cache_write_back(next);
+    }
+#endif
+}
+
+bool flash_erase_idle(void)
+{
+#if (FLASH_ERASE_POOL > 0)
+    /* The previous erase or write continues in the background, so we are called again later */
+    if (!flash_is_ready()) {
+        return true;
+    }
+    g_erase_busy = false;
+
+#if (FLASH_FTL_ENABLE)
+    if (g_ftl_enabled) {
+        const uint8_t count = g_ftl_erased_count;
+        flash_ftl_pre_erase();
+        return (g_ftl_erased_count > count && g_ftl_erased_count < FLASH_FTL_ERASED_POOL);
+    }
+#endif
+
+    if (!flash_erase_is_tracked() || 0 == g_erase_free_count || g_erase_pool_count >= FLASH_ERASE_POOL) {
+        return false;
+    }
+
+    /* The next free sector after the last written sector, which FatFs will likely write next */
+    uint32_t sector = g_erase_cursor % g_sector_count;
+    while (!flash_erase_is_free(sector)) {
+        sector = (sector + 1) % g_sector_count;
+    }
+
+    uint32_t writeCounter = UINT32_MAX;
+    const uint32_t addr = flash_get_page_addr(sector);
+    if (flash_supports_metadata()) {
+        CHIP_SELECT_OP()
+        {
+            flash_send_op_addr(opcode_read_cont_lowfreq, flash_get_metadata_addr_from_pageaddr(addr));
+            flash_spi_multi_io(&writeCounter, sizeof(writeCounter));
+        }
+    }
+
+    g_erase_free[sector / 8] &= ~(1 << (sector % 8));
+    g_erase_free_count--;
+    g_erase_pool[g_erase_pool_count].sector = sector;
+    g_erase_pool[g_erase_pool_count].write_count = writeCounter;
+    g_erase_pool_count++;
+
+    CHIP_SELECT_OP()
+    {
+        flash_send_op_addr(opcode_page_erase, addr);
+    }
+    g_erase_busy = true;
+
+    return (g_erase_free_count > 0 && g_erase_pool_count < FLASH_ERASE_POOL);
+#else
+    return false;
+#endif
+}
+
 void flash_chip_erase(void)
 {
     unsigned char chip_erase[] = { 0xC7, 0x94, 0x80, 0x9A };
 
+#if (FLASH_CACHE_SECTORS > 0)
+    /* The cached data no longer matches the erased flash */
+    flash_cache_invalidate();
+#endif
+#if (FLASH_FTL_ENABLE)
+    if (g_ftl_enabled) {
+        flash_ftl_reset();
+    }
+#endif
+    flash_erase_reset();
+
+    /* The file system formatted after the erase does not use the crash and the raw sectors */
+    g_reserved_ok = true;
+
     CHIP_SELECT_OP()
     {
         flash_spi_multi_io(&chip_erase, sizeof(chip_erase));
     }
 }
+
+bool flash_crash_write(const void *pData, uint32_t bytes)
+{
+    const uint8_t *pBytes = (const uint8_t*) pData;
+    const uint32_t page_bytes = flash_get_page_data_bytes();
+
+    if (!g_reserved_ok || 0 == page_bytes || bytes > (FLASH_CRASH_SECTORS * FLASH_SECTOR_SIZE)) {
+        return false;
+    }
+
+    /* The flash cannot program while the erase is suspended */
+    flash_erase_resume();
+
+    for (uint32_t page = flash_crash_first_page(); bytes > 0; page++)
+    {
+        const uint32_t size = (bytes < page_bytes) ? bytes : page_bytes;
+
+        /* The whole page is sent, so the spare bytes are not left over from the last write of the buffer */
+        flash_wait_for_ready();
+        CHIP_SELECT_OP()
+        {
+            flash_send_op_addr(opcode_prog_thru_buffer1, flash_get_page_addr(page));
+            for (uint32_t i = 0; i < g_flash_pagesize; i++) {
+                flash_spi_io((i < size) ? pBytes[i] : 0xFF);
+            }
+        }
+        pBytes += size;
+        bytes -= size;
+    }
+
+    flash_wait_for_ready();
+    return true;
+}
+
+bool flash_crash_read(void *pData, uint32_t bytes)
+{
+    uint8_t *pBytes = (uint8_t*) pData;
+    const uint32_t page_bytes = flash_get_page_data_bytes();
+
+    if (!g_reserved_ok || 0 == page_bytes || bytes > (FLASH_CRASH_SECTORS * FLASH_SECTOR_SIZE)) {
+        return false;
+    }
+
+    flash_erase_suspend();
+    flash_wait_for_ready();
+
+    for (uint32_t page = flash_crash_first_page(); bytes > 0; page++)
+    {
+        const uint32_t size = (bytes < page_bytes) ? bytes : page_bytes;
+        flash_read_page(pBytes, flash_get_page_addr(page), size);
+        pBytes += size;
+        bytes -= size;
+    }
+
+    flash_erase_resume();
+    return true;
+}
+
+uint32_t flash_raw_get_page_count(void)
+{
+    const uint32_t page_bytes = flash_get_page_data_bytes();
+    return (g_reserved_ok && page_bytes > 0) ? ((FLASH_RAW_SECTORS * FLASH_SECTOR_SIZE) / page_bytes) : 0;
+}
+
+uint32_t flash_raw_get_page_bytes(void)
+{
+    return flash_get_page_data_bytes();
+}
+
+/// @returns the page of the flash memory of a raw page, which are before the crash sectors
+static inline uint32_t flash_raw_page(const uint32_t page)
+{
+    return flash_crash_first_page() - flash_raw_get_page_count() + page;
+}
+
+bool flash_raw_write_page(uint32_t page, const void *pData)
+{
+    const uint32_t data_bytes = flash_get_page_data_bytes();
+    const uint32_t spare_bytes = g_flash_pagesize - data_bytes;
+
+    if (page >= flash_raw_get_page_count()) {
+        return false;
+    }
+
+    /* The flash cannot program while the erase is suspended */
+    flash_erase_resume();
+
+    /* Only the buffer of the previous raw page may still be programming, otherwise the other
+     * writes may have left either buffer programming.
+     */
+    if (!g_raw_programming) {
+        flash_wait_for_ready();
+    }
+
+    CHIP_SELECT_OP()
+    {
+        flash_send_op_addr(g_raw_buffer2 ? opcode_write_buffer2 : opcode_write_buffer1, 0);
+        ssp1_dma_transfer_block((uint8_t*) pData, data_bytes, 1);
+
+        /* The spare bytes are not left over from the last write of the buffer */
+        for (uint32_t i = 0; i < spare_bytes; i++) {
+            flash_spi_io(0xFF);
+        }
+    }
+
+    flash_wait_for_ready();
+    CHIP_SELECT_OP()
+    {
+        flash_send_op_addr(g_raw_buffer2 ? opcode_buffer2_to_mem : opcode_buffer1_to_mem,
+                           flash_get_page_addr(flash_raw_page(page)));
+    }
+
+    g_raw_buffer2 = !g_raw_buffer2;
+    g_raw_programming = true;
+    return true;
+}
+
+bool flash_raw_read(uint32_t page, uint32_t offset, void *pData, uint32_t bytes)
+{
+    if (page >= flash_raw_get_page_count() || offset + bytes > flash_get_page_data_bytes()) {
+        return false;
+    }
+
+    flash_erase_suspend();
+    flash_wait_for_ready();
+    flash_read_page((uint8_t*) pData, flash_get_page_addr(flash_raw_page(page)) + offset, bytes);
+    flash_erase_resume();
+    return true;
+}
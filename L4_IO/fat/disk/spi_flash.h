@@ -15,6 +15,64 @@
 
 
 
+/**
+ * Number of 512-byte sectors of the write-back LRU cache in front of the flash memory, or 0 to disable.
+ * The FAT and directory sectors are written many times while a file is written, so they are only
+ * programmed to the flash when they are evicted, or when flash_cache_flush() is called by CTRL_SYNC
+ * (f_sync() and f_close()).
+ */
+#define FLASH_CACHE_SECTORS     4
+
+/**
+ * @{ Wear-leveling flash translation layer (FTL)
+ * If enabled, each sector write goes to a different flash page based on the page write counters,
+ * and the mapping is kept in the spare bytes of the pages.  This is only supported with 528 byte pages
+ * because the mapping requires 12 spare bytes next to the write counter.
+ *
+ * @warning The FTL costs 2 bytes of RAM per sector (8K for 16mbit flash), and the flash memory must be
+ *          re-formatted after enabling or disabling the FTL since the sectors are no longer at the same pages.
+ */
+#define FLASH_FTL_ENABLE            0       ///< Set to non-zero to enable the FTL
+#define FLASH_FTL_MAX_SECTORS       4096    ///< The FTL is disabled if the flash has more sectors than this
+#define FLASH_FTL_RESERVED_SECTORS  64      ///< Sectors hidden from FatFs so the FTL always has free pages
+#define FLASH_FTL_ERASED_POOL       4       ///< Free pages erased ahead of time for faster writes
+#define FLASH_FTL_WEAR_DELTA        1000    ///< Free pages written this many times above the average are avoided
+/** @} */
+
+/**
+ * @{ Background erase of the free pages
+ * FatFs reports the sectors of the removed clusters with CTRL_ERASE_SECTOR, and flash_erase_idle()
+ * erases up to FLASH_ERASE_POOL of them, starting after the last written sector because FatFs
+ * allocates the clusters forward.  A write of an erased page is programmed without the built-in
+ * erase cycle, and a read while a background erase is in progress suspends the erase (AT45DB-E)
+ * instead of waiting for it.  With the FTL, flash_erase_idle() erases the free pages of the FTL
+ * instead, and CTRL_ERASE_SECTOR frees the pages of the removed sectors.
+ *
+ * The erased pages lose their write counters, so the counters are kept in RAM until the page is
+ * written; a power loss before that restarts their count.  The free sectors are only known since
+ * the boot, and only with the 512 and 528 byte pages where each sector is a page.
+ */
+#define FLASH_ERASE_POOL            8       ///< Pages erased ahead of the writes, 0 to disable
+#define FLASH_ERASE_MAX_SECTORS     4096    ///< The free sectors are not tracked if the flash has more sectors than this
+/** @} */
+
+/**
+ * The last sectors of the flash memory are hidden from FatFs (and the FTL) and are written by
+ * flash_crash_write() when the system crashes, such as by the crash_snapshot.h of the HardFault.
+ * @warning The flash memory must be re-formatted after changing this; the crash sectors are not
+ *          written while the file system of an older format still uses them.
+ */
+#define FLASH_CRASH_SECTORS         1
+
+/**
+ * The sectors before the crash sectors are also hidden from FatFs (and the FTL), and are the raw
+ * pages of the black box recorder (@see blackbox.h), which are written by flash_raw_write_page()
+ * without the FAT and directory updates.  Set to 0 to give these sectors to the file system.
+ * @warning The flash memory must be re-formatted after changing this, like FLASH_CRASH_SECTORS.
+ */
+#define FLASH_RAW_SECTORS           1024
+
+
 /**
  * Initializes the Flash Memory
  */
@@ -70,12 +128,68 @@ bool flash_supports_metadata(void);
 uint32_t flash_get_page_write_count(uint32_t page_number);
 /** @} */
 
+/**
+ * Writes all the modified sectors of the cache to the flash memory.
+ * This is called by flash_ioctl(CTRL_SYNC), so FatFs f_sync() and f_close() flush the cache.
+ * @warning DO NOT USE THIS FUNCTION WITHOUT THE SPI SEMAPHORE!!!
+ */
+void flash_cache_flush(void);
+
+/**
+ * Performs one step of the background erase, such as erasing the next free page.
+ * The erase continues in the background, so this returns right away if the flash is busy.
+ * The disk I/O task calls this through disk_idle() while it has no requests.
+ * @returns true if there is more to erase, and this should be called again in a few milliseconds
+ * @warning DO NOT USE THIS FUNCTION WITHOUT THE SPI SEMAPHORE!!!
+ */
+bool flash_erase_idle(void);
+
 /**
  * This will ERASE the entire chip, including the meta-data!!
  * This can take several seconds to perform the chip erase...
  */
 void flash_chip_erase(void);
 
+/**
+ * Writes the data to the crash sectors of FLASH_CRASH_SECTORS.  This only uses the polled SPI
+ * without the DMA, the interrupts, the cache, or the RTOS, so it can be called by a fault handler.
+ * A background erase is resumed first, and the pages are programmed with their built-in erase.
+ * @returns false if the data does not fit, or the flash memory was not formatted with the crash sectors.
+ * @warning The SPI must not be in the middle of a transfer, see spi1_is_locked()
+ */
+bool flash_crash_write(const void *pData, uint32_t bytes);
+
+/**
+ * Reads the data written by flash_crash_write()
+ * @warning DO NOT USE THIS FUNCTION WITHOUT THE SPI SEMAPHORE!!!
+ */
+bool flash_crash_read(void *pData, uint32_t bytes);
+
+/**
+ * @{ Raw pages of FLASH_RAW_SECTORS
+ * The raw pages are numbered from 0, and each page has flash_get_page_size() bytes without the
+ * spare bytes of the 264 and 528 byte pages.  There are no raw pages if the flash memory was not
+ * formatted with the raw sectors.
+ */
+uint32_t flash_raw_get_page_count(void);
+uint32_t flash_raw_get_page_bytes(void);
+
+/**
+ * Writes a whole raw page with the built-in erase.  The page is sent to one of the two buffers of the
+ * flash memory while the page of the previous call is still being programmed from the other buffer,
+ * and this returns once the page is being programmed, so consecutive pages are written at the
+ * program time of the flash memory.
+ * @warning DO NOT USE THIS FUNCTION WITHOUT THE SPI SEMAPHORE!!!
+ */
+bool flash_raw_write_page(uint32_t page, const void *pData);
+
+/**
+ * Reads the bytes of a raw page from the given offset
+ * @warning DO NOT USE THIS FUNCTION WITHOUT THE SPI SEMAPHORE!!!
+ */
+bool flash_raw_read(uint32_t page, uint32_t offset, void *pData, uint32_t bytes);
+/** @} */
+
 
 
 #ifdef __cplusplus
@@ -1,5 +1,6 @@
 #include "integer.h"    // DWORD
 #include "rtc.h"        // RTC functions
+#include "lpc_sys.h"    // sys_get_uptime_us()
 
 /**
  * This function is called by FAT FS System to get system time
@@ -7,7 +8,8 @@
  */
 DWORD get_fattime()
 {
-    rtc_t sysTime = rtc_gettime();
+    /* FatFs gets the time for each sync, and its timestamps only have a 2 second resolution */
+    rtc_t sysTime = rtc_gettime_cached(sys_get_uptime_us());
 
     return ((DWORD) (sysTime.year - 1980) << 25)
             | ((DWORD) sysTime.month << 21)
@@ -115,6 +115,7 @@
 /                   Fixed LFN entry is not deleted on delete/rename an object with lossy converted SFN.
 /---------------------------------------------------------------------------*/
 
+#include <string.h>		/* memcpy(), memset() and memcmp() of newlib_string.c */
 #include "ff.h"			/* Declarations of FatFs API */
 #include "disk/diskio.h"		/* Declarations of disk I/O functions */
 
@@ -557,40 +558,24 @@ const BYTE ExCvt[] = _EXCVT;	/* Upper conversion table for extended characters *
 /* String functions                                                      */
 /*-----------------------------------------------------------------------*/
 
+/* The string functions of the C library move the aligned words (see newlib_string.c) */
+
 /* Copy memory to memory */
 static
 void mem_cpy (void* dst, const void* src, UINT cnt) {
-	BYTE *d = (BYTE*)dst;
-	const BYTE *s = (const BYTE*)src;
-
-#if _WORD_ACCESS == 1
-	while (cnt >= sizeof (int)) {
-		*(int*)d = *(int*)s;
-		d += sizeof (int); s += sizeof (int);
-		cnt -= sizeof (int);
-	}
-#endif
-	while (cnt--)
-		*d++ = *s++;
+	memcpy(dst, src, cnt);
 }
 
 /* Fill memory */
 static
 void mem_set (void* dst, int val, UINT cnt) {
-	BYTE *d = (BYTE*)dst;
-
-	while (cnt--)
-		*d++ = (BYTE)val;
+	memset(dst, val, cnt);
 }
 
 /* Compare memory to memory */
 static
 int mem_cmp (const void* dst, const void* src, UINT cnt) {
-	const BYTE *d = (const BYTE *)dst, *s = (const BYTE *)src;
-	int r = 0;
-
-	while (cnt-- && (r = *d++ - *s++) == 0) ;
-	return r;
+	return memcmp(dst, src, cnt);
 }
 
 /* Check if chr is contained in the string */
@@ -1482,13 +1467,142 @@ BYTE sum_sfn (
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Directory handling - Directory entry cache                            */
+/*-----------------------------------------------------------------------*/
+#if _FS_DIRCACHE
+
+static
+DWORD dcache_hash_chr (	/* Returns the hash updated by a character of the name */
+	DWORD hash,
+	WCHAR chr
+)
+{
+#if _USE_LFN
+	chr = ff_wtoupper(chr);		/* The names are case insensitive */
+#endif
+	return (hash ^ chr) * 16777619;	/* FNV-1a */
+}
+
+
+static
+DWORD dcache_hash_name (	/* Returns the hash of the name of the directory object */
+	const DIR* dp
+)
+{
+	DWORD hash = 2166136261;
+	UINT i;
+
+#if _USE_LFN
+	if (dp->lfn) {
+		for (i = 0; dp->lfn[i]; i++) hash = dcache_hash_chr(hash, dp->lfn[i]);
+		return hash;
+	}
+#endif
+	for (i = 0; i < 11; i++) hash = dcache_hash_chr(hash, dp->fn[i]);
+	return hash;
+}
+
+
+#if _USE_LFN
+static
+DWORD dcache_hash_sfn (	/* Returns the hash of the SFN entry in the form of a name given by the path */
+	const BYTE* dir
+)
+{
+	DWORD hash = 2166136261;
+	UINT i;
+	WCHAR c;
+
+	for (i = 0; i < 11; i++) {
+		c = dir[i];
+		if (c == ' ') continue;
+		if (i == 0 && c == NDDE) c = DDE;	/* Restore the replaced DDE character */
+		if (i == 8) hash = dcache_hash_chr(hash, '.');
+		if (c >= 0x80) c = ff_convert(c, 1);
+		hash = dcache_hash_chr(hash, c);
+	}
+	return hash;
+}
+#endif
+
+
+static
+DCACHE* dcache_slot (	/* Returns the cache item of the name in the directory */
+	FATFS* fs,
+	DWORD sclust,
+	DWORD hash
+)
+{
+	return &fs->dcache[(hash ^ sclust) % _FS_DIRCACHE];
+}
+
+
+static
+void dcache_put (
+	FATFS* fs,
+	DWORD sclust,
+	DWORD hash,
+	WORD start,		/* Index of the first entry of the object */
+	WORD index		/* Index of the SFN entry */
+)
+{
+	DCACHE* ent = dcache_slot(fs, sclust, hash);
+
+	ent->sclust = sclust; ent->hash = hash;
+	ent->start = start; ent->index = index;
+}
+
+
+static
+void dcache_put_read (	/* Caches the entry read by dir_read() */
+	DIR* dp
+)
+{
+#if _USE_LFN
+	WORD start = (dp->lfn_idx == 0xFFFF) ? dp->index : dp->lfn_idx;
+
+	if (dp->lfn && dp->lfn_idx != 0xFFFF)	/* The object can be found by its LFN or SFN */
+		dcache_put(dp->fs, dp->sclust, dcache_hash_name(dp), start, dp->index);
+	dcache_put(dp->fs, dp->sclust, dcache_hash_sfn(dp->dir), start, dp->index);
+#else
+	DWORD hash = 2166136261;
+	UINT i;
+
+	for (i = 0; i < 11; i++) hash = dcache_hash_chr(hash, dp->dir[i]);
+	dcache_put(dp->fs, dp->sclust, hash, dp->index, dp->index);
+#endif
+}
+
+
+static
+void dcache_clear (	/* Removes the cached entries of a directory, or of every directory */
+	FATFS* fs,
+	DWORD sclust,
+	int all
+)
+{
+	UINT i;
+
+	for (i = 0; i < _FS_DIRCACHE; i++) {
+		if (all || fs->dcache[i].sclust == sclust) fs->dcache[i].index = 0xFFFF;
+	}
+}
+
+#endif /* _FS_DIRCACHE */
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Directory handling - Find an object in the directory                  */
 /*-----------------------------------------------------------------------*/
 
 static
-FRESULT dir_find (
-	DIR* dp			/* Pointer to the directory object linked to the file name */
+FRESULT dir_scan (
+	DIR* dp,		/* Pointer to the directory object linked to the file name */
+	WORD start,		/* Index of the first entry to check */
+	WORD stop		/* Index of the last entry to check */
 )
 {
 	FRESULT res;
@@ -1497,7 +1611,7 @@ FRESULT dir_find (
 	BYTE a, ord, sum;
 #endif
 
-	res = dir_sdi(dp, 0);			/* Rewind directory object */
+	res = dir_sdi(dp, start);		/* Rewind directory object */
 	if (res != FR_OK) return res;
 
 #if _USE_LFN
@@ -1535,12 +1649,44 @@ FRESULT dir_find (
 			break;
 #endif
 		res = dir_next(dp, 0);		/* Next entry */
+		if (res == FR_OK && dp->index > stop) res = FR_NO_FILE;
 	} while (res == FR_OK);
 
 	return res;
 }
 
 
+static
+FRESULT dir_find (
+	DIR* dp			/* Pointer to the directory object linked to the file name */
+)
+{
+#if _FS_DIRCACHE
+	FRESULT res;
+	DWORD hash = dcache_hash_name(dp);
+	DCACHE* ent = dcache_slot(dp->fs, dp->sclust, hash);
+
+	/* Check only the entries of the cached object, and scan the directory if they do not match */
+	if (ent->index != 0xFFFF && ent->sclust == dp->sclust && ent->hash == hash) {
+		if (dir_scan(dp, ent->start, ent->index) == FR_OK) return FR_OK;
+		ent->index = 0xFFFF;
+	}
+
+	res = dir_scan(dp, 0, 0xFFFF);
+	if (res == FR_OK) {
+#if _USE_LFN
+		dcache_put(dp->fs, dp->sclust, hash, (dp->lfn_idx == 0xFFFF) ? dp->index : dp->lfn_idx, dp->index);
+#else
+		dcache_put(dp->fs, dp->sclust, hash, dp->index, dp->index);
+#endif
+	}
+	return res;
+#else
+	return dir_scan(dp, 0, 0xFFFF);
+#endif
+}
+
+
 
 
 /*-----------------------------------------------------------------------*/
@@ -1618,6 +1764,9 @@ FRESULT dir_register (	/* FR_OK:Successful, FR_DENIED:No free entry or too many
 	WCHAR *lfn;
 
 
+#if _FS_DIRCACHE
+	dcache_clear(dp->fs, dp->sclust, 0);
+#endif
 	fn = dp->fn; lfn = dp->lfn;
 	mem_cpy(sn, fn, 12);
 
@@ -1658,6 +1807,9 @@ FRESULT dir_register (	/* FR_OK:Successful, FR_DENIED:No free entry or too many
 		}
 	}
 #else	/* Non LFN configuration */
+#if _FS_DIRCACHE
+	dcache_clear(dp->fs, dp->sclust, 0);
+#endif
 	res = dir_alloc(dp, 1);		/* Allocate an entry for SFN */
 #endif
 
@@ -1693,6 +1845,9 @@ FRESULT dir_remove (	/* FR_OK: Successful, FR_DISK_ERR: A disk error */
 #if _USE_LFN	/* LFN configuration */
 	UINT i;
 
+#if _FS_DIRCACHE
+	dcache_clear(dp->fs, dp->sclust, 0);
+#endif
 	i = dp->index;	/* SFN index */
 	res = dir_sdi(dp, (dp->lfn_idx == 0xFFFF) ? i : dp->lfn_idx);	/* Goto the SFN or top of the LFN entries */
 	if (res == FR_OK) {
@@ -1709,6 +1864,9 @@ FRESULT dir_remove (	/* FR_OK: Successful, FR_DISK_ERR: A disk error */
 	}
 
 #else			/* Non LFN configuration */
+#if _FS_DIRCACHE
+	dcache_clear(dp->fs, dp->sclust, 0);
+#endif
 	res = dir_sdi(dp, dp->index);
 	if (res == FR_OK) {
 		res = move_window(dp->fs, dp->sect);
@@ -2314,6 +2472,9 @@ FRESULT find_volume (	/* FR_OK(0): successful, !=0: any error occurred */
 #endif
 	fs->fs_type = fmt;	/* FAT sub-type */
 	fs->id = ++Fsid;	/* File system mount ID */
+#if _FS_DIRCACHE
+	dcache_clear(fs, 0, 1);
+#endif
 #if _FS_RPATH
 	fs->cdir = 0;		/* Set current directory to root */
 #endif
@@ -3258,6 +3419,9 @@ FRESULT f_readdir (
 				res = FR_OK;
 			}
 			if (res == FR_OK) {				/* A valid entry is found */
+#if _FS_DIRCACHE
+				dcache_put_read(dp);		/* The object may be opened next, such as by a copy */
+#endif
 				get_fileinfo(dp, fno);		/* Get the object information */
 				res = dir_next(dp, 0);		/* Increment index for next */
 				if (res == FR_NO_FILE) {
@@ -3369,6 +3533,12 @@ FRESULT f_getfree (
 			fs->free_clust = n;
 			fs->fsi_flag |= 1;
 			*nclst = n;
+#if !_FS_READONLY
+			/* Save the count to the FSINFO right away, so the next mount of a FAT32
+			   volume need not scan the FAT if no file is written before a reset */
+			if (res == FR_OK && fat == FS_FAT32)
+				res = sync_fs(fs);
+#endif
 		}
 	}
 	LEAVE_FF(fs, res);
@@ -72,6 +72,19 @@ typedef char TCHAR;
 
 
 
+/* Directory entry cache item (DCACHE) */
+
+#if _FS_DIRCACHE
+typedef struct {
+	DWORD	sclust;			/* Start cluster of the directory */
+	DWORD	hash;			/* Hash of the name */
+	WORD	start;			/* Index of the first entry of the object (the LFN or the SFN) */
+	WORD	index;			/* Index of the SFN entry (0xFFFF:Not used) */
+} DCACHE;
+#endif
+
+
+
 /* File system object structure (FATFS) */
 
 typedef struct {
@@ -103,6 +116,9 @@ typedef struct {
 	DWORD	dirbase;		/* Root directory start sector (FAT32:Cluster#) */
 	DWORD	database;		/* Data start sector */
 	DWORD	winsect;		/* Current sector appearing in the win[] */
+#if _FS_DIRCACHE
+	DCACHE	dcache[_FS_DIRCACHE];	/* Directory entry cache */
+#endif
 	BYTE	win[_MAX_SS];	/* Disk access window for Directory, FAT (and file data at tiny cfg) */
 } FATFS;
 
@@ -41,7 +41,7 @@
 /* To enable f_mkfs() function, set _USE_MKFS to 1 and set _FS_READONLY to 0 */
 
 
-#define	_USE_FASTSEEK	0	/* 0:Disable or 1:Enable */
+#define	_USE_FASTSEEK	1	/* 0:Disable or 1:Enable */
 /* To enable fast seek feature, set _USE_FASTSEEK to 1. */
 
 
@@ -161,11 +161,18 @@
 /  GET_SECTOR_SIZE command must be implemented to the disk_ioctl() function. */
 
 
-#define	_USE_ERASE	0	/* 0:Disable or 1:Enable */
+#define	_USE_ERASE	1	/* 0:Disable or 1:Enable */
 /* To enable sector erase feature, set _USE_ERASE to 1. Also CTRL_ERASE_SECTOR command
 /  should be added to the disk_ioctl() function. */
 
 
+#define _FS_DIRCACHE	16	/* 0:Disable or number of cached directory entries */
+/* To speed up the path name lookups, set _FS_DIRCACHE to the number of directory entries
+/  cached by each volume.  The location of an entry found by its name, or read by f_readdir(),
+/  is cached and verified on the next lookup of the name, so the directory is not scanned
+/  from its start.  The cache uses _FS_DIRCACHE * 12 bytes of each file system object. */
+
+
 #define _FS_NOFSINFO	0	/* 0 to 3 */
 /* If you need to know correct free space on the FAT32 volume, set bit 0 of this option
 /  and f_getfree() function at first time after volume mount will force a full FAT scan.
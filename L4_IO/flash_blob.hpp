@@ -0,0 +1,186 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief Read-only access to a file of the flash memory without copying it to the RAM
+ * @ingroup BoardIO
+ *
+ * Large tables (such as IR codes, calibration curves or help text) can be stored as files
+ * and used in place rather than loaded to the RAM by Storage::read().  When the blob is opened,
+ * the sectors of the file are located once, and after that the data is read one sector at a time
+ * into a window of _MAX_SS bytes, directly from the disk without going through FatFs.
+ * The clusters of a file start at the sector (and page) boundaries of the flash memory, so
+ * each window is read with a single sector read.
+ *
+ * @code
+ *      FlashBlob blob;
+ *      if (FR_OK == blob.open("0:ir_codes.bin")) {
+ *          FlashBlobPtr<uint32_t> codes = blob.begin<uint32_t>();
+ *          for (uint32_t i = 0; i < blob.size() / sizeof(uint32_t); i++) {
+ *              if (code == codes[i]) { ... }
+ *          }
+ *      }
+ * @endcode
+ *
+ * @warning The blob is for files that do not change; the data is read from the sectors that were
+ *          found by open(), so open() the blob again if the file is re-written.  A blob object
+ *          should only be used by one task at a time, since its window is not protected.
+ */
+#ifndef FLASH_BLOB_HPP__
+#define FLASH_BLOB_HPP__
+
+#include <stdint.h>
+#include <string.h>
+#include "src/FileSystemObject.hpp"
+
+
+
+/// Number of fragments of a file that can be opened as a blob; a file that was written at once is usually one fragment
+#define FLASH_BLOB_MAX_FRAGMENTS    4
+
+
+template <typename T> class FlashBlobPtr;
+
+/**
+ * A read-only file of a FatFs volume accessed through a cached sector window.
+ * @ingroup BoardIO
+ */
+class FlashBlob
+{
+    public:
+        FlashBlob();
+
+        /**
+         * Locates the sectors of the file.  The file is not kept open.
+         * @returns FR_NOT_ENOUGH_CORE if the file has more than FLASH_BLOB_MAX_FRAGMENTS fragments
+         */
+        FRESULT open(const char *pFilename);
+
+        /// Forgets the file; the blob can be opened again
+        void close(void) { mOpened = false; mSize = 0; mFragments = 0; mWindowSector = 0; }
+
+        /// @returns the size of the file, or 0 if not open
+        uint32_t size(void) const { return mSize; }
+        bool isOpen(void) const { return mOpened; }
+
+        /**
+         * Reads bytes of the file; the parts that are in the window are not read again.
+         * @returns false if the range is beyond the file, or the disk failed
+         */
+        bool read(void *pData, uint32_t offset, uint32_t len);
+
+        /**
+         * Pages in the sector of the offset and returns a pointer to the data within the window,
+         * so the data can be used without copying it.
+         * @param pLen  Set to the bytes available at the pointer (up to the end of the window or the file)
+         * @returns NULL if the offset is beyond the file or the disk failed
+         * @note The pointer is only valid until the next access of this blob
+         */
+        const uint8_t* map(uint32_t offset, uint32_t *pLen);
+
+        /// @returns the byte at the offset, or 0 if it cannot be read
+        uint8_t at(uint32_t offset)
+        {
+            uint32_t len = 0;
+            const uint8_t *p = map(offset, &len);
+            return p ? *p : 0;
+        }
+
+        /// @returns the pointer-like iterator to the values of type T at the start of the file
+        template <typename T>
+        inline FlashBlobPtr<T> begin(void);
+
+        /// @returns the iterator past the last whole value of type T of the file
+        template <typename T>
+        inline FlashBlobPtr<T> end(void);
+
+    private:
+        FlashBlob(const FlashBlob&);            ///< Disallow copy
+        FlashBlob& operator=(const FlashBlob&); ///< Disallow assignment
+
+        /// @returns the disk sector of the given sector of the file
+        uint32_t getSector(uint32_t fileSector) const;
+
+        /// The sectors of each fragment of the file
+        typedef struct {
+            uint32_t firstSector;   ///< The disk sector of the fragment
+            uint32_t sectors;       ///< The number of sectors of the fragment
+        } fragment_t;
+
+        bool mOpened;                               ///< True if open() succeeded
+        uint32_t mSize;                             ///< The size of the file
+        uint8_t mDrive;                             ///< The physical drive of the file
+        uint8_t mFragments;                         ///< The used items of mFragment[]
+        fragment_t mFragment[FLASH_BLOB_MAX_FRAGMENTS];
+        uint32_t mWindowSector;                     ///< The sector of the file in mWindow[] plus 1, or 0 if none
+        uint8_t mWindow[_MAX_SS];                   ///< The cached sector
+};
+
+/**
+ * A pointer-like iterator to the values of type T of a FlashBlob.  The values are
+ * returned by value, and read from the blob on demand.
+ */
+template <typename T>
+class FlashBlobPtr
+{
+    public:
+        FlashBlobPtr(FlashBlob& blob, uint32_t offset) : mpBlob(&blob), mOffset(offset) {}
+
+        /// @returns the value, which is zero if it cannot be read
+        T operator*() const
+        {
+            T value;
+            if (!mpBlob->read(&value, mOffset, sizeof(value))) {
+                memset(&value, 0, sizeof(value));
+            }
+            return value;
+        }
+        T operator[](uint32_t index) const { return *(*this + index); }
+
+        FlashBlobPtr& operator++()                  { mOffset += sizeof(T); return *this; }
+        FlashBlobPtr& operator--()                  { mOffset -= sizeof(T); return *this; }
+        FlashBlobPtr& operator+=(int32_t n)         { mOffset += n * sizeof(T); return *this; }
+        FlashBlobPtr operator+(int32_t n) const     { return FlashBlobPtr(*mpBlob, mOffset + n * sizeof(T)); }
+        int32_t operator-(const FlashBlobPtr& rhs) const { return ((int32_t) mOffset - (int32_t) rhs.mOffset) / (int32_t) sizeof(T); }
+        bool operator==(const FlashBlobPtr& rhs) const { return (mpBlob == rhs.mpBlob && mOffset == rhs.mOffset); }
+        bool operator!=(const FlashBlobPtr& rhs) const { return !(*this == rhs); }
+
+        /// @returns the file offset of the value this points to
+        uint32_t getOffset(void) const { return mOffset; }
+
+    private:
+        FlashBlob *mpBlob;
+        uint32_t mOffset;
+};
+
+template <typename T>
+inline FlashBlobPtr<T> FlashBlob::begin(void)
+{
+    return FlashBlobPtr<T>(*this, 0);
+}
+
+template <typename T>
+inline FlashBlobPtr<T> FlashBlob::end(void)
+{
+    return FlashBlobPtr<T>(*this, mSize - (mSize % sizeof(T)));
+}
+
+
+
+#endif /* FLASH_BLOB_HPP__ */
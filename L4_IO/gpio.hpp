@@ -123,5 +123,67 @@ class GPIO
 
 
 
+/**
+ * Compile-time descriptor of a group of pins of one port.  The port and the pins are template
+ * arguments, so there is no object, and each function compiles to a single store to the FIOSET,
+ * FIOCLR or FIODIR register instead of a read-modify-write of FIOPIN.  Setting or clearing
+ * several pins is also one store, so the pins change at the same clock edge.
+ *
+ * @code
+ *      typedef GpioPins<2, (1 << 0) | (1 << 1)> StepDir;   // P2.0 and P2.1
+ *      StepDir::setAsOutput();
+ *      StepDir::write((1 << 1));    // P2.1 = 1 and P2.0 = 0 at once
+ *      StepDir::setHigh();          // Both pins are set
+ * @endcode
+ */
+template <uint8_t port, uint32_t pins>
+struct GpioPins
+{
+    /// @returns the GPIO registers of the port
+    static inline LPC_GPIO_TypeDef* gpio(void) { return LPC_GPIO(port); }
+
+    static inline void setAsInput(void)  { gpio()->FIODIR &= ~pins; } ///< Sets the pins as input pins
+    static inline void setAsOutput(void) { gpio()->FIODIR |= pins;   } ///< Sets the pins as output pins
+
+    static inline uint32_t read(void)    { return (gpio()->FIOPIN & pins); }   ///< @returns the pins that are high
+    static inline void setHigh(void)     { gpio()->FIOSET = pins;  } ///< Sets all the pins high
+    static inline void setLow(void)      { gpio()->FIOCLR = pins;  } ///< Sets all the pins low
+
+    /**
+     * Sets the pins to the value (the other bits of value are ignored) with one write of FIOPIN.
+     * FIOMASK limits the write to the pins, and the interrupts are disabled meanwhile because
+     * FIOMASK also applies to the other writes to the port.
+     */
+    static inline void write(uint32_t value)
+    {
+        const uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        gpio()->FIOMASK = ~pins;
+        gpio()->FIOPIN = value;
+        gpio()->FIOMASK = 0;
+        __set_PRIMASK(primask);
+    }
+};
+
+/**
+ * Compile-time descriptor of one pin, @see GpioPins
+ * @code
+ *      typedef GpioPin<1, 0> Led0;  // P1.0
+ *      Led0::setAsOutput();
+ *      Led0::set(true);
+ * @endcode
+ */
+template <uint8_t port, uint8_t pin>
+struct GpioPin : public GpioPins<port, (UINT32_C(1) << pin)>
+{
+    typedef GpioPins<port, (UINT32_C(1) << pin)> Pins;   ///< The group of this one pin
+
+    static inline bool read(void)        { return (0 != Pins::read()); }  ///< @returns true if the pin is high
+    static inline void set(bool on)      { on ? Pins::setHigh() : Pins::setLow(); } ///< Sets the pin high or low
+    static inline void toggle(void)      { read() ? Pins::setLow() : Pins::setHigh(); } ///< Toggles the pin
+};
+
+
+
 #endif /* GPIO_H__ */
 
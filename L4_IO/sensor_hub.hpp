@@ -0,0 +1,98 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief The sensor hub task that samples the on-board sensors, and caches their readings
+ *
+ * Reading TS, LS or AS directly costs an I2C transfer or an ADC conversion for each call, and
+ * the tasks that use the sensors contend for the I2C bus.  The sensor hub task instead samples
+ * each sensor at its own rate, and publishes the fixed-point readings with their timestamps to
+ * the topics of the event bus.  Any task reads the latest reading with a lock-free copy, or
+ * subscribes to the topic to be woken up by each new reading.
+ * @code
+ *      sensor_temp_t temp;
+ *      if (sensor_hub_get_temp(temp)) {
+ *          printf("%i.%02i C\n", temp.celsius_x100 / 100, temp.celsius_x100 % 100);
+ *      }
+ * @endcode
+ *
+ * 20261014 : Initial
+ */
+#ifndef SENSOR_HUB_HPP_
+#define SENSOR_HUB_HPP_
+
+#include <stdint.h>
+
+#include "scheduler_task.hpp"
+#include "acceleration_sensor.hpp"
+#include "event_bus.h"
+
+
+
+/** @{ The sampling periods of the sensors, which are multiples of SENSOR_HUB_TICK_MS, or 0 to not sample one */
+#define SENSOR_HUB_TICK_MS          10      ///< The period of the task
+#define SENSOR_HUB_ACCEL_MS         20      ///< The acceleration sensor
+#define SENSOR_HUB_LIGHT_MS         100     ///< The light sensor
+#define SENSOR_HUB_TEMP_MS          1000    ///< The temperature sensor, which converts once per read
+/** @} */
+
+
+
+/// A reading of the temperature sensor
+typedef struct {
+    int16_t celsius_x100;   ///< Hundredths of Celsius, including the offset of the sensor
+    uint64_t timestamp_us;  ///< Uptime when the reading was taken
+} sensor_temp_t;
+
+/// A reading of the light sensor
+typedef struct {
+    uint16_t raw;           ///< The 12-bit ADC value
+    uint8_t percent;        ///< The raw value as a percentage
+    uint64_t timestamp_us;  ///< Uptime when the reading was taken
+} sensor_light_t;
+
+/** @{ The topics of the readings, which are published by the sensorHubTask */
+EVENT_TOPIC_DECLARE(sensor_accel_topic);    ///< accel_sample_t
+EVENT_TOPIC_DECLARE(sensor_light_topic);    ///< sensor_light_t
+EVENT_TOPIC_DECLARE(sensor_temp_topic);     ///< sensor_temp_t
+/** @} */
+
+/** @{ Copies the latest reading, @returns false if there is none yet */
+static inline bool sensor_hub_get_accel(accel_sample_t &s) { return event_bus_read(&sensor_accel_topic, &s) > 0; }
+static inline bool sensor_hub_get_light(sensor_light_t &s) { return event_bus_read(&sensor_light_topic, &s) > 0; }
+static inline bool sensor_hub_get_temp(sensor_temp_t &s)   { return event_bus_read(&sensor_temp_topic, &s) > 0; }
+/** @} */
+
+/**
+ * The task that samples the sensors.  All the sensors due at a tick are read back to back, so
+ * the bus is used in one burst.  A sensor that fails to read keeps its last reading.
+ */
+class sensorHubTask : public scheduler_task
+{
+    public:
+        sensorHubTask(uint8_t priority);
+        bool run(void *p);      ///< Samples the sensors that are due
+
+    private:
+        uint32_t mTicks;        ///< The number of run()s so far
+};
+
+
+
+#endif /* SENSOR_HUB_HPP_ */
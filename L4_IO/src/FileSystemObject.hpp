@@ -48,12 +48,13 @@ class FileSystemObject
 
         /**
          * Initializes the disk and mounts the storage
+         * @param delayed  If true, the disk is initialized and mounted by the first access of a file
          * @returns TRUE if the disk is ready to be used.
          * @note If disk is not formatted correctly, FILE IO may fail
          */
-        char mount() const
+        char mount(bool delayed=false) const
         {
-            return f_mount((FATFS*)&mFileSystem, getDrivePath(), 1);
+            return f_mount((FATFS*)&mFileSystem, getDrivePath(), delayed ? 0 : 1);
         }
 
         /**
@@ -61,6 +62,9 @@ class FileSystemObject
          * @param pTotalDriveSpaceKB    Pointer where total drive space in kilobytes will be written
          * @param pAvailableSpaceKB     Pointer where drive's available space in kilobytes will be written
          * @note The parameters will be written to zero if an error occurs during this operation.
+         * @note FatFs counts the free clusters when the clusters are allocated and freed, so only the
+         *       first call after the drive is mounted scans the FAT (a FAT32 volume reads the count
+         *       from its FSINFO sector instead).  The calls after that do not access the drive.
          */
         FRESULT getDriveInfo(unsigned int* pTotalDriveSpaceKB, unsigned int* pAvailableSpaceKB) const
         {
@@ -0,0 +1,131 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <string.h>
+#include "flash_blob.hpp"
+
+
+
+FlashBlob::FlashBlob() :
+        mOpened(false), mSize(0), mDrive(0), mFragments(0), mWindowSector(0)
+{
+    /* Nothing to do */
+}
+
+FRESULT FlashBlob::open(const char *pFilename)
+{
+    /* The fast seek table has the table size, a pair of items for each fragment, and a terminator */
+    DWORD table[2 + 2 * FLASH_BLOB_MAX_FRAGMENTS];
+    FRESULT status;
+    FIL file;
+
+    close();
+    if (FR_OK != (status = f_open(&file, pFilename, FA_OPEN_EXISTING | FA_READ))) {
+        return status;
+    }
+
+    if (f_size(&file) > 0) {
+        table[0] = sizeof(table) / sizeof(table[0]);
+        file.cltbl = table;
+        status = f_lseek(&file, CREATE_LINKMAP);
+    }
+
+    if (FR_OK == status) {
+        const FATFS *fs = file.fs;
+        for (DWORD *pItem = &table[1]; f_size(&file) > 0 && 0 != pItem[0]; pItem += 2) {
+            mFragment[mFragments].firstSector = fs->database + (pItem[1] - 2) * fs->csize;
+            mFragment[mFragments].sectors = pItem[0] * fs->csize;
+            mFragments++;
+        }
+
+        mDrive = fs->drv;
+        mSize = f_size(&file);
+        mOpened = true;
+    }
+    else {
+        mFragments = 0;
+    }
+
+    f_close(&file);
+    return status;
+}
+
+uint32_t FlashBlob::getSector(uint32_t fileSector) const
+{
+    for (uint8_t i = 0; i < mFragments; i++) {
+        if (fileSector < mFragment[i].sectors) {
+            return mFragment[i].firstSector + fileSector;
+        }
+        fileSector -= mFragment[i].sectors;
+    }
+
+    /* The file size is checked by the caller, so this is not reached */
+    return 0;
+}
+
+const uint8_t* FlashBlob::map(uint32_t offset, uint32_t *pLen)
+{
+    const uint32_t fileSector = offset / _MAX_SS;
+    const uint32_t windowOffset = offset % _MAX_SS;
+
+    *pLen = 0;
+    if (!mOpened || offset >= mSize) {
+        return NULL;
+    }
+
+    if (mWindowSector != fileSector + 1) {
+        mWindowSector = 0;
+        if (RES_OK != disk_read(mDrive, mWindow, getSector(fileSector), 1)) {
+            return NULL;
+        }
+        mWindowSector = fileSector + 1;
+    }
+
+    *pLen = _MAX_SS - windowOffset;
+    if (*pLen > mSize - offset) {
+        *pLen = mSize - offset;
+    }
+    return &mWindow[windowOffset];
+}
+
+bool FlashBlob::read(void *pData, uint32_t offset, uint32_t len)
+{
+    uint8_t *pBytes = (uint8_t*) pData;
+
+    if (offset > mSize || len > mSize - offset) {
+        return false;
+    }
+
+    while (len > 0)
+    {
+        uint32_t chunk = 0;
+        const uint8_t *pWindow = map(offset, &chunk);
+        if (!pWindow) {
+            return false;
+        }
+        if (chunk > len) {
+            chunk = len;
+        }
+
+        memcpy(pBytes, pWindow, chunk);
+        pBytes += chunk;
+        offset += chunk;
+        len -= chunk;
+    }
+    return true;
+}
@@ -1,400 +1,921 @@
-/*
- *     SocialLedge.com - Copyright (C) 2013
- *
- *     This file is part of free software framework for embedded processors.
- *     You can use it and/or distribute it as long as this copyright header
- *     remains unmodified.  The code is free for personal use and requires
- *     permission to use in a commercial product.
- *
- *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
- *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
- *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
- *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
- *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
- *
- *     You can reach the author of this software at :
- *          p r e e t . w i k i @ g m a i l . c o m
- */
-
-#include <stdint.h>
-
-#include "io.hpp" // All IO Class definitions
-#include "bio.h"
-#include "adc0.h"
-
-
-
-/**
- * The following diagram shows bit number corresponding to the LED
- *
- *      0
- *     ---
- *  5 | 6 | 1
- *     ---
- *  4 |   | 2
- *     ---
- *      3   *7
- */
-static const unsigned char LED_DISPLAY_CHARMAP[128] =
-{
-        0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0,
-        0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0,
-        0,    // 32 : Space
-        0x86, // 33 : !
-        0,0,0,0, 0,0,0,0, 0,0,0, // 34-44
-        0x40, // 45 : -
-        0x80, // 46 : .
-        0x00, // 47 : /
-        0x3F, // 48 : 0
-        0x30, // 49 : 1
-        0x5B, // 50 : 2
-        0x4F, // 51 : 3
-        0x66, // 52 : 4
-        0x6D, // 53 : 5
-        0x7C, // 54 : 6
-        0x07, // 55 : 7
-        0x7F, // 56 : 8
-        0x67, // 57 : 9
-        0,0,0,0,0,0,0, // 58-64
-        0x77, // 65 : A
-        0x7F, // 66 : B
-        0x39, // 67 : C
-        0x3F, // 68 : D
-        0x79, // 69 : E
-        0x71, // 70 : F
-        0x3D, // 71 : G
-        0x76, // 72 : H
-        0x30, // 73 : I
-        0x1F, // 74 : J
-        0x00, // 75 : K
-        0x38, // 76 : L
-        0x00, // 77 : M
-        0x00, // 78 : N
-        0x3F, // 79 : O
-        0x73, // 80 : P
-        0x00, // 81 : Q
-        0x00, // 82 : R
-        0x6D, // 83 : S
-        0x00, // 84 : T
-        0x3F, // 85 : U
-        0x00, // 86 : V
-        0x00, // 87 : W
-        0x00, // 88 : X
-        0x00, // 89 : Y
-        0x00, // 90 : Z
-
-        0, 0, 0, 0, 0, 0,
-
-        0x77, // 97 : a
-        0x7F, // 98 : b
-        0x39, // 99 : c
-        0x3F, // 100 : d
-        0x79, // 101 : e
-        0x71, // 102 : f
-        0x3D, // 103 : g
-        0x76, // 104 : h
-        0x30, // 105 : i
-        0x1F, // 106 : j
-        0x00, // 107 : k
-        0x38, // 108 : l
-        0x00, // 109 : m
-        0x00, // 110 : n
-        0x3F, // 111 : o
-        0x73, // 112 : p
-        0x00, // 113 : q
-        0x00, // 114 : r
-        0x6D, // 115 : s
-        0x00, // 116 : t
-        0x3F, // 117 : u
-        0x00, // 118 : v
-        0x00, // 119 : w
-        0x00, // 120 : x
-        0x00, // 121 : y
-        0x00, // 122 : z
-};
-
-
-
-bool Acceleration_Sensor::init()
-{
-    const unsigned char activeModeWith100Hz = (1 << 0) | (3 << 3); // Active Mode @ 100Hz
-
-    writeReg(Ctrl_Reg1, activeModeWith100Hz);
-    const char whoAmIReg = readReg(WhoAmI);
-
-    return (mWhoAmIExpectedValue == whoAmIReg);
-}
-int16_t Acceleration_Sensor::getX()
-{
-    return (int16_t)get16BitRegister(X_MSB) / 16;
-}
-int16_t Acceleration_Sensor::getY()
-{
-    return (int16_t)get16BitRegister(Y_MSB) / 16;
-}
-int16_t Acceleration_Sensor::getZ()
-{
-    return (int16_t)get16BitRegister(Z_MSB) / 16;
-}
-
-
-
-/**
- * The design of the IR Sensor is as follows:
- *  Timer1 captures falling edges of CAP1.0 and timestamps are saved when this happens.
- *  Every time capture happens, a 20ms match interrupt is setup/reset.  When no more
- *  signals arrive, the 20ms match interrupt will decode the timestamps and convert
- *  timestamps into binary signal.
- *
- *  Note that this doesn't decode into real data sent through the IR, but nevertheless,
- *  the decoded signal will be unique per button pressed on an IR remote.
- */
-
-
-#define MAX_FALLING_EDGES_PER_IR_FRAME      32
-static uint32_t g_ir_timings[MAX_FALLING_EDGES_PER_IR_FRAME] = { 0 };   ///< IR signal falling edges
-static uint16_t g_signal_count = 0;         ///< The number of falling edges
-static uint32_t g_last_decoded_signal = 0;  ///< Value of the last decoded signals
-
-void IR_Sensor::storeIrCode(uint32_t value)
-{
-    // Just store the timestamp of this signal
-    if(g_signal_count < MAX_FALLING_EDGES_PER_IR_FRAME) {
-        g_ir_timings[g_signal_count++] = value;
-    }
-}
-
-void IR_Sensor::decodeIrCode(void)
-{
-    if(g_signal_count > 1)
-    {
-        /* Calculate differences of falling edges */
-        for(int i = 0; i < g_signal_count-1; i++) {
-            g_ir_timings[i] = g_ir_timings[i+1] - g_ir_timings[i];
-        }
-
-        /**
-         * First falling edge value should indicate binary 0.
-         * So anything higher than 50% of this value is considered binary 1.
-         */
-        const uint32_t binary1Threshold = g_ir_timings[1] + (g_ir_timings[1]/2);
-        uint32_t decodedSignal = 0;
-        for(uint16_t i=0; i < g_signal_count-1; i++) {
-            if(g_ir_timings[i] > binary1Threshold) {
-                decodedSignal |= (1 << i);
-            }
-        }
-        g_last_decoded_signal = decodedSignal;
-    }
-
-    g_signal_count = 0;
-}
-
-/**
- * IR Sensor is attached to P1.18 - CAP1.0, so it needs TIMER1 to capture the times on P1.18
- */
-bool IR_Sensor::init()
-{
-    /* Power up the timer 1 in case it is off */
-    lpc_pconp(pconp_timer1, true);
-
-    /* Timer 1 should be initialized by high_level_init.cpp using lpc_sys.c API
-     * We will just add on the capture functionality here.
-     */
-    LPC_TIM1->CCR &= ~(7 << 0);            // Clear Bits 2:1:0
-    LPC_TIM1->CCR |=  (1 << 2) | (1 << 1); // Enable Falling Edge capture0 with interrupt
-
-    // Select P1.18 as CAP1.0 by setting bits 5:4 to 0b11
-    LPC_PINCON->PINSEL3 |= (3 << 4);
-
-    return true;
-}
-
-bool IR_Sensor::isIRCodeReceived()
-{
-    return (0 != g_last_decoded_signal);
-}
-uint32_t IR_Sensor::getLastIRCode()
-{
-    const uint32_t signal = g_last_decoded_signal;
-    g_last_decoded_signal = 0;
-    return signal;
-}
-
-
-
-bool LED_Display::init()
-{
-    bool devicePresent = checkDeviceResponse();
-    if(devicePresent)
-    {
-        const unsigned char cfgAsOutput = 0x00;
-        writeReg(cfgPort0, cfgAsOutput);
-        writeReg(cfgPort1, cfgAsOutput);
-
-        setLeftDigit('.');
-        setRightDigit('.');
-    }
-
-    return devicePresent;
-}
-void LED_Display::clear()
-{
-    setLeftDigit(' ');
-    setRightDigit(' ');
-}
-void LED_Display::setNumber(char num)
-{
-    num %= 100;
-    setRightDigit(num%10 + '0');
-
-    if(num < 10)
-        setLeftDigit(' ');
-    else
-        setLeftDigit (num/10 + '0');
-}
-void LED_Display::setLeftDigit(char alpha)
-{
-    mNumAtDisplay[0] = alpha;
-    writeReg(outputPort1, LED_DISPLAY_CHARMAP[(unsigned) (alpha & 0x7F) ]);
-}
-void LED_Display::setRightDigit(char alpha)
-{
-    mNumAtDisplay[1] = alpha;
-    writeReg(outputPort0, LED_DISPLAY_CHARMAP[(unsigned) (alpha & 0x7F) ]);
-}
-
-
-
-
-bool LED::init()
-{
-    /* Pins initialized by bio.h */
-    return true;
-}
-void LED::on(uint8_t ledNum)
-{
-    portENTER_CRITICAL();
-    mLedValue or_eq (1 << (ledNum-1));
-    setAll(mLedValue);
-    portEXIT_CRITICAL();
-}
-void LED::off(uint8_t ledNum)
-{
-    portENTER_CRITICAL();
-    mLedValue and_eq ~(1 << (ledNum-1));
-    setAll(mLedValue);
-    portEXIT_CRITICAL();
-}
-void LED::toggle(uint8_t ledNum)
-{
-    portENTER_CRITICAL();
-    mLedValue xor_eq (1 << (ledNum-1));
-    setAll(mLedValue);
-    portEXIT_CRITICAL();
-}
-void LED::set(uint8_t ledNum, bool ON)
-{
-    ON ? on(ledNum) : off(ledNum);
-}
-void LED::setAll(uint8_t value)
-{
-    portENTER_CRITICAL();
-    {
-        /* LEDs are active low */
-        #define led_set(num, realbit)               \
-            if (mLedValue & (1 << num))             \
-                LPC_GPIO1->FIOCLR = (1 << realbit); \
-            else                                    \
-                LPC_GPIO1->FIOSET = (1 << realbit)
-
-        mLedValue = value & 0x0F;
-        led_set(0, 0);
-        led_set(1, 1);
-        led_set(2, 4);
-        led_set(3, 8);
-    }
-    portEXIT_CRITICAL();
-}
-uint8_t LED::getValues(void) const
-{
-    return mLedValue;
-}
-
-
-bool Light_Sensor::init()
-{
-    return true;
-}
-uint16_t Light_Sensor::getRawValue()
-{
-    return adc0_get_reading(BIO_LIGHT_ADC_CH_NUM);
-}
-uint8_t Light_Sensor::getPercentValue()
-{
-    const unsigned int maxAdcValue = 4096;
-    return (getRawValue() * 100) / maxAdcValue;
-}
-
-
-
-bool Switches::init()
-{
-    /* Pins initialized by bio.h */
-    return true;
-}
-uint8_t Switches::getSwitchValues()
-{
-    /* Return contiguous bits 0-3 from scattered switch pins */
-    const int swValues = LPC_GPIO1->FIOPIN;
-    const int p9_p10  = (swValues >> 9)  & 0x3;
-    const int p14_p15 = (swValues >> 14) & 0x3;
-    return (p9_p10 | (p14_p15 << 2));
-}
-bool Switches::getSwitch(int num)
-{
-    if (num >= 1 && num <= 4) {
-        return getSwitchValues() & (1 << (num-1));
-    }
-    else {
-        return false;
-    }
-}
-
-
-
-bool I2C_Temp::init()
-{
-    const unsigned char temperatureCfgRegPtr = 0x01;
-    const unsigned char oneShotShutdownMode = 0x81;
-    const unsigned char expectedBitsThatAreNotZero = 0x60; // R1:R0 bits are 1s at startup
-
-    // Enter one-shot shutdown mode.
-    writeReg(temperatureCfgRegPtr, oneShotShutdownMode);
-
-    const unsigned char cfgRegByte0 = readReg(temperatureCfgRegPtr);
-    return (0 != (cfgRegByte0 & expectedBitsThatAreNotZero));
-}
-float I2C_Temp::getCelsius()
-{
-    // Get signed 16-bit data of temperature register pointer
-    const unsigned char temperatureRegsiterPtr = 0x00;
-    signed short temperature = get16BitRegister(temperatureRegsiterPtr);
-
-    // Trigger next conversion:
-    const unsigned char temperatureCfgRegPtr = 0x01;
-    const unsigned char oneShotShutdownMode = 0x81;
-    writeReg(temperatureCfgRegPtr, oneShotShutdownMode);
-
-    // Temperature data is in bits 15:3 which contains signed 16-bit data
-    temperature /= 16;
-
-    // Each bit is of 0.0625 degree per bit resolution
-    return (0.0625F * temperature) + mOffsetCelcius;
-}
-
-float I2C_Temp::getFarenheit()
-{
-    return (getCelsius() * 9.0F / 5) + 32;
-}
-
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "io.hpp" // All IO Class definitions
+#include "lpc_sys.h"
+#include "lpc_timers.h"
+#include "bio.h"
+#include "adc0.h"
+#include "eint.h"
+#include "fixed_point.h"
+#include "workqueue.h"
+
+
+
+/**
+ * The following diagram shows bit number corresponding to the LED
+ *
+ *      0
+ *     ---
+ *  5 | 6 | 1
+ *     ---
+ *  4 |   | 2
+ *     ---
+ *      3   *7
+ */
+static const unsigned char LED_DISPLAY_CHARMAP[128] =
+{
+        0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0,
+        0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0,
+        0,    // 32 : Space
+        0x86, // 33 : !
+        0,0,0,0, 0,0,0,0, 0,0,0, // 34-44
+        0x40, // 45 : -
+        0x80, // 46 : .
+        0x00, // 47 : /
+        0x3F, // 48 : 0
+        0x30, // 49 : 1
+        0x5B, // 50 : 2
+        0x4F, // 51 : 3
+        0x66, // 52 : 4
+        0x6D, // 53 : 5
+        0x7C, // 54 : 6
+        0x07, // 55 : 7
+        0x7F, // 56 : 8
+        0x67, // 57 : 9
+        0,0,0,0,0,0,0, // 58-64
+        0x77, // 65 : A
+        0x7F, // 66 : B
+        0x39, // 67 : C
+        0x3F, // 68 : D
+        0x79, // 69 : E
+        0x71, // 70 : F
+        0x3D, // 71 : G
+        0x76, // 72 : H
+        0x30, // 73 : I
+        0x1F, // 74 : J
+        0x00, // 75 : K
+        0x38, // 76 : L
+        0x00, // 77 : M
+        0x00, // 78 : N
+        0x3F, // 79 : O
+        0x73, // 80 : P
+        0x00, // 81 : Q
+        0x00, // 82 : R
+        0x6D, // 83 : S
+        0x00, // 84 : T
+        0x3F, // 85 : U
+        0x00, // 86 : V
+        0x00, // 87 : W
+        0x00, // 88 : X
+        0x00, // 89 : Y
+        0x00, // 90 : Z
+
+        0, 0, 0, 0, 0, 0,
+
+        0x77, // 97 : a
+        0x7F, // 98 : b
+        0x39, // 99 : c
+        0x3F, // 100 : d
+        0x79, // 101 : e
+        0x71, // 102 : f
+        0x3D, // 103 : g
+        0x76, // 104 : h
+        0x30, // 105 : i
+        0x1F, // 106 : j
+        0x00, // 107 : k
+        0x38, // 108 : l
+        0x00, // 109 : m
+        0x00, // 110 : n
+        0x3F, // 111 : o
+        0x73, // 112 : p
+        0x00, // 113 : q
+        0x00, // 114 : r
+        0x6D, // 115 : s
+        0x00, // 116 : t
+        0x3F, // 117 : u
+        0x00, // 118 : v
+        0x00, // 119 : w
+        0x00, // 120 : x
+        0x00, // 121 : y
+        0x00, // 122 : z
+};
+
+
+
+/// The orientation changes of Acceleration_Sensor::startOrientation()
+EVENT_TOPIC_DEFINE(accel_orient_topic, accel_orient_event_t);
+
+bool Acceleration_Sensor::init()
+{
+    const unsigned char activeModeWith100Hz = (1 << 0) | (3 << 3); // Active Mode @ 100Hz
+
+    writeReg(Ctrl_Reg1, activeModeWith100Hz);
+    const char whoAmIReg = readReg(WhoAmI);
+
+    return (mWhoAmIExpectedValue == whoAmIReg);
+}
+int16_t Acceleration_Sensor::getX()
+{
+    return (int16_t)get16BitRegister(X_MSB) / 16;
+}
+int16_t Acceleration_Sensor::getY()
+{
+    return (int16_t)get16BitRegister(Y_MSB) / 16;
+}
+int16_t Acceleration_Sensor::getZ()
+{
+    return (int16_t)get16BitRegister(Z_MSB) / 16;
+}
+bool Acceleration_Sensor::getXYZ(accel_sample_t &sample)
+{
+    uint8_t data[6] = { 0 };
+    const bool ok = readRegisters(X_MSB, &data[0], sizeof(data));
+
+    decodeXYZ(&data[0], sample);
+    sample.timestamp_us = sys_get_uptime_us();
+    return ok;
+}
+bool Acceleration_Sensor::startStreaming(uint8_t port2Pin, QueueHandle_t queue)
+{
+    const unsigned char activeModeWith100Hz = (1 << 0) | (3 << 3);
+    const unsigned char dataReadyInterrupt = (1 << 0); // INT_EN_DRDY, and INT_CFG_DRDY to route it to INT1
+
+    if (!queue || mStreamQueue) {
+        return false;
+    }
+
+    memset(&mStreamJob, 0, sizeof(mStreamJob));
+    mStreamTrx.deviceAddress = getAddress();
+    mStreamTrx.firstReg = X_MSB;
+    mStreamTrx.read = true;
+    mStreamTrx.pData = &mStreamData[0];
+    mStreamTrx.size = sizeof(mStreamData);
+    mStreamJob.pTrx = &mStreamTrx;
+    mStreamJob.numTrx = 1;
+    mStreamJob.callback = sampleReadIsr;
+    mStreamQueue = queue;
+
+    // The control registers can only be changed in the standby mode
+    writeReg(Ctrl_Reg1, 0);
+    mIntEnable |= dataReadyInterrupt;
+    mIntRoute |= dataReadyInterrupt;
+    writeReg(Ctrl_Reg4, mIntEnable);
+    writeReg(Ctrl_Reg5, mIntRoute);
+
+    // INT1 is active low, and is de-asserted once the XYZ registers are read
+    eint3_enable_port2(port2Pin, eint_falling_edge, dataReadyIsr);
+    writeReg(Ctrl_Reg1, activeModeWith100Hz);
+
+    // Read any sample that was ready before the interrupt was enabled
+    accel_sample_t sample;
+    return getXYZ(sample);
+}
+bool Acceleration_Sensor::startOrientation(uint8_t port2Pin)
+{
+    const unsigned char activeModeWith100Hz = (1 << 0) | (3 << 3);
+    const unsigned char orientEnable = (1 << 7) | (1 << 6);    // PL_CFG: DBCNTM to clear the debounce count, and PL_EN
+    const unsigned char orientDebounce = 5;                     // Samples of the new orientation, 50ms @ 100Hz
+    const unsigned char orientInterrupt = (1 << 4);             // INT_EN_LNDPRT, and INT_CFG_LNDPRT cleared to route it to INT2
+
+    if (mOrientStarted || !workqueue_start(work_prio_low)) {
+        return false;
+    }
+    mOrientStarted = true;
+
+    // The control registers can only be changed in the standby mode
+    writeReg(Ctrl_Reg1, 0);
+    writeReg(PL_Cfg, orientEnable);
+    writeReg(PL_Count, orientDebounce);
+    mIntEnable |= orientInterrupt;
+    mIntRoute &= ~orientInterrupt;
+    writeReg(Ctrl_Reg4, mIntEnable);
+    writeReg(Ctrl_Reg5, mIntRoute);
+
+    // INT2 is active low, and is de-asserted once PL_Status is read, so clear an old change first
+    readReg(PL_Status);
+    eint3_enable_port2(port2Pin, eint_falling_edge, orientIsr);
+    writeReg(Ctrl_Reg1, activeModeWith100Hz);
+
+    return true;
+}
+void Acceleration_Sensor::decodeXYZ(const uint8_t *pData, accel_sample_t &sample)
+{
+    sample.x = (int16_t)((pData[0] << 8) | pData[1]) / 16;
+    sample.y = (int16_t)((pData[2] << 8) | pData[3]) / 16;
+    sample.z = (int16_t)((pData[4] << 8) | pData[5]) / 16;
+}
+void Acceleration_Sensor::dataReadyIsr(void)
+{
+    Acceleration_Sensor &as = getInstance();
+
+    if (as.mStreamJob.busy) {
+        ++as.mStreamDrops;
+    }
+    else {
+        as.mStreamTimestamp = sys_get_uptime_us();
+        as.getI2C().submit(&as.mStreamJob);
+    }
+}
+void Acceleration_Sensor::sampleReadIsr(I2C_Job_t *pJob)
+{
+    Acceleration_Sensor &as = getInstance();
+    long higherPriorityTaskWaiting = 0;
+    accel_sample_t sample;
+
+    if (0 != pJob->error) {
+        ++as.mStreamDrops;
+        return;
+    }
+
+    decodeXYZ(&as.mStreamData[0], sample);
+    sample.timestamp_us = as.mStreamTimestamp;
+    if (!xQueueSendFromISR(as.mStreamQueue, &sample, &higherPriorityTaskWaiting)) {
+        ++as.mStreamDrops;
+    }
+    portEND_SWITCHING_ISR(higherPriorityTaskWaiting);
+}
+void Acceleration_Sensor::orientIsr(void)
+{
+    Acceleration_Sensor &as = getInstance();
+    BaseType_t woken = pdFALSE;
+
+    // The I2C read blocks, so it is done by the worker, and only one read is posted at a time
+    as.mOrientTimestamp = sys_get_uptime_us();
+    if (!as.mOrientPending) {
+        as.mOrientPending = true;
+        if (!workqueue_post_from_isr(work_prio_low, orientWork, NULL, &woken)) {
+            as.mOrientPending = false;
+        }
+    }
+    portEND_SWITCHING_ISR(woken);
+}
+void Acceleration_Sensor::orientWork(void *ctx)
+{
+    Acceleration_Sensor &as = getInstance();
+    const unsigned char newOrientation = (1 << 7);  // PL_STATUS: NEWLP
+
+    // Cleared before the read de-asserts INT2, so the interrupt of the next change posts it again
+    as.mOrientPending = false;
+    const unsigned char status = as.readReg(PL_Status);
+
+    if (status & newOrientation) {
+        accel_orient_event_t event;
+        event.orientation = (status >> 1) & 0x03;   // LAPO
+        event.back = (status & (1 << 0));           // BAFRO
+        event.timestamp_us = as.mOrientTimestamp;
+        event_bus_publish(&accel_orient_topic, &event);
+    }
+}
+
+
+
+/**
+ * The design of the IR Sensor is as follows:
+ *  Timer1 captures both edges of CAP1.0, so the timestamps are taken by the hardware, and the
+ *  capture interrupt gives the duration of the mark (IR burst) or space that just ended to the
+ *  state machines of the NEC and the RC5 protocols.  The output of the IR receiver is low
+ *  during a mark.  A frame is decoded at its last edge, so no timeout is needed, and the
+ *  decoded codes are sent to the queue.
+ */
+
+#define IR_SENSOR_PIN               (1 << 18)   ///< P1.18 is the CAP1.0 pin of the IR receiver
+
+/** @{ NEC timing in microseconds */
+#define IR_NEC_LEADER_MARK_US       9000
+#define IR_NEC_LEADER_SPACE_US      4500
+#define IR_NEC_REPEAT_SPACE_US      2250
+#define IR_NEC_BIT_MARK_US          560
+#define IR_NEC_ZERO_SPACE_US        560
+#define IR_NEC_ONE_SPACE_US         1690
+/** @} */
+
+#define IR_RC5_HALF_BIT_US          889         ///< The RC5 bits are two halves of this time
+#define IR_RC5_HALF_BITS            28          ///< The half bits of the 14-bit RC5 frame
+
+/// The state of the NEC decoder
+typedef enum {
+    ir_nec_idle,        ///< Waiting for the leader mark
+    ir_nec_leader,      ///< Got the leader mark, the space tells the frame from the repeat frame
+    ir_nec_data,        ///< Receiving the 32 bits
+    ir_nec_repeat,      ///< Waiting for the mark that ends the repeat frame
+} ir_nec_state_t;
+
+static uint8_t g_ir_nec_state = ir_nec_idle;    ///< @see ir_nec_state_t
+static uint8_t g_ir_nec_bits = 0;               ///< The NEC bits received
+static uint32_t g_ir_nec_data = 0;              ///< The NEC frame being received (LSB first)
+
+static uint8_t g_ir_rc5_halves = 0;             ///< The RC5 half bits received, or 0 if idle
+static uint32_t g_ir_rc5_data = 0;              ///< The RC5 half bits, 1 for a mark
+
+static uint32_t g_ir_last_edge_us = 0;          ///< The captured time of the last edge
+static uint32_t g_ir_last_frame_us = 0;         ///< The time of the last decoded frame
+static ir_code_t g_ir_last_code = { 0, 0, 0 };  ///< The last decoded code, for the repeats
+static uint8_t g_ir_rc5_toggle = 0xFF;          ///< The toggle bit of the last RC5 frame
+
+/// @returns true if the time is within IR_SENSOR_TOLERANCE_PCT of the nominal time
+static inline bool ir_match(uint32_t us, uint32_t nominal_us)
+{
+    const uint32_t tolerance = (nominal_us * IR_SENSOR_TOLERANCE_PCT) / 100;
+    return (us >= nominal_us - tolerance && us <= nominal_us + tolerance);
+}
+
+/**
+ * NEC decoder, given the duration of each mark or space
+ * @returns 1 for a frame in *pData, 2 for a repeat frame, and 0 otherwise
+ */
+static uint8_t ir_nec_edge(bool mark, uint32_t us, uint32_t *pData)
+{
+    uint8_t decoded = 0;
+    bool valid = true;
+
+    switch (g_ir_nec_state)
+    {
+        case ir_nec_leader:
+            if (!mark && ir_match(us, IR_NEC_LEADER_SPACE_US)) {
+                g_ir_nec_state = ir_nec_data;
+                g_ir_nec_bits = 0;
+                g_ir_nec_data = 0;
+            }
+            else if (!mark && ir_match(us, IR_NEC_REPEAT_SPACE_US)) {
+                g_ir_nec_state = ir_nec_repeat;
+            }
+            else {
+                valid = false;
+            }
+            break;
+
+        case ir_nec_data:
+            if (mark) {
+                valid = ir_match(us, IR_NEC_BIT_MARK_US);
+            }
+            else if (ir_match(us, IR_NEC_ZERO_SPACE_US) || ir_match(us, IR_NEC_ONE_SPACE_US)) {
+                if (ir_match(us, IR_NEC_ONE_SPACE_US)) {
+                    g_ir_nec_data |= (UINT32_C(1) << g_ir_nec_bits);
+                }
+                if (++g_ir_nec_bits >= 32) {
+                    g_ir_nec_state = ir_nec_idle;
+                    *pData = g_ir_nec_data;
+                    decoded = 1;
+                }
+            }
+            else {
+                valid = false;
+            }
+            break;
+
+        case ir_nec_repeat:
+            g_ir_nec_state = ir_nec_idle;
+            if (mark && ir_match(us, IR_NEC_BIT_MARK_US)) {
+                decoded = 2;
+            }
+            break;
+
+        case ir_nec_idle:
+        default:
+            valid = false;
+            break;
+    }
+
+    /* Any unexpected time starts over, and the mark may be the leader of the next frame */
+    if (!valid) {
+        g_ir_nec_state = (mark && ir_match(us, IR_NEC_LEADER_MARK_US)) ? ir_nec_leader : ir_nec_idle;
+    }
+    return decoded;
+}
+
+/**
+ * RC5 decoder, given the duration of each mark or space.  Each bit is a space and a mark for 1,
+ * or a mark and a space for 0, so the marks and spaces are one or two half bits.
+ * @returns true for a frame in *pData, which has the 14 bits of the frame
+ */
+static bool ir_rc5_edge(bool mark, uint32_t us, uint32_t *pData)
+{
+    const uint8_t halves = ir_match(us, IR_RC5_HALF_BIT_US) ? 1 : ir_match(us, 2 * IR_RC5_HALF_BIT_US) ? 2 : 0;
+
+    /* The first bit is a 1, and its space is not seen since the line was idle */
+    if (0 == g_ir_rc5_halves) {
+        if (!mark || 0 == halves) {
+            return false;
+        }
+        g_ir_rc5_halves = 1;
+        g_ir_rc5_data = 0;
+    }
+    else if (0 == halves) {
+        g_ir_rc5_halves = 0;
+        return false;
+    }
+
+    for (uint8_t i = 0; i < halves; i++) {
+        g_ir_rc5_data = (g_ir_rc5_data << 1) | (mark ? 1 : 0);
+        g_ir_rc5_halves++;
+    }
+
+    /* The space of the last bit is not seen either if it is a 0 */
+    if (IR_RC5_HALF_BITS - 1 == g_ir_rc5_halves && mark) {
+        g_ir_rc5_data <<= 1;
+        g_ir_rc5_halves++;
+    }
+    if (g_ir_rc5_halves < IR_RC5_HALF_BITS) {
+        return false;
+    }
+
+    bool valid = (IR_RC5_HALF_BITS == g_ir_rc5_halves);
+    uint32_t data = 0;
+    for (int8_t bit = IR_RC5_HALF_BITS - 2; valid && bit >= 0; bit -= 2) {
+        const uint8_t pair = (g_ir_rc5_data >> bit) & 3;
+        valid = (1 == pair || 2 == pair);
+        data = (data << 1) | (1 == pair ? 1 : 0);
+    }
+
+    g_ir_rc5_halves = 0;
+    *pData = data;
+    return valid;
+}
+
+void IR_Sensor::captureIsr(uint32_t time_us)
+{
+    /* The pin is read after the edge, so the mark or space that ended is the opposite level */
+    const bool mark = (0 != (LPC_GPIO1->FIOPIN & IR_SENSOR_PIN));
+    const uint32_t us = time_us - g_ir_last_edge_us;
+    g_ir_last_edge_us = time_us;
+
+    uint32_t necData = 0, rc5Data = 0;
+    const uint8_t nec = ir_nec_edge(mark, us, &necData);
+    const bool rc5 = ir_rc5_edge(mark, us, &rc5Data);
+
+    const bool recent = (time_us - g_ir_last_frame_us) < (IR_SENSOR_REPEAT_MS * 1000);
+    ir_code_t code = { 0, 0, 0 };
+
+    if (1 == nec) {
+        /* The second and the fourth bytes are the inverse of the address and the command, but
+         * the extended NEC uses a 16-bit address, so only the command is checked.
+         */
+        if (0xFF != (((necData >> 16) ^ (necData >> 24)) & 0xFF)) {
+            return;
+        }
+        code.code = necData;
+        code.protocol = ir_protocol_nec;
+    }
+    else if (2 == nec) {
+        /* The repeat frames are only sent after a frame */
+        if (!recent || ir_protocol_nec != g_ir_last_code.protocol || 0 == g_ir_last_code.code) {
+            return;
+        }
+        code = g_ir_last_code;
+        code.repeat = (code.repeat < 0xFF) ? (code.repeat + 1) : code.repeat;
+    }
+    else if (rc5) {
+        /* The inverted field bit is the 7th bit of the command of the extended RC5 */
+        const uint8_t toggle = (rc5Data >> 11) & 1;
+        const uint32_t command = (rc5Data & 0x3F) | ((~rc5Data >> 6) & 0x40);
+        code.code = (((rc5Data >> 6) & 0x1F) << 8) | command;
+        code.protocol = ir_protocol_rc5;
+
+        /* The toggle bit changes with each button press, so the same toggle is the held button */
+        if (recent && toggle == g_ir_rc5_toggle && ir_protocol_rc5 == g_ir_last_code.protocol &&
+            code.code == g_ir_last_code.code) {
+            code.repeat = (g_ir_last_code.repeat < 0xFF) ? (g_ir_last_code.repeat + 1) : g_ir_last_code.repeat;
+        }
+        g_ir_rc5_toggle = toggle;
+    }
+    else {
+        return;
+    }
+
+    g_ir_last_code = code;
+    g_ir_last_frame_us = time_us;
+
+    long higherPriorityTaskWaiting = 0;
+    if (NULL == mQueue || !xQueueSendFromISR(mQueue, &code, &higherPriorityTaskWaiting)) {
+        ++mDrops;
+    }
+    portEND_SWITCHING_ISR(higherPriorityTaskWaiting);
+}
+
+#if (1 != SYS_CFG_SYS_TIMER)
+/// The system timer is not TIMER1, so TIMER1 runs at 1us for the captures as the system timer would
+static void ir_sensor_clock_changed(void *arg, unsigned int old_cpu_hz, unsigned int new_cpu_hz)
+{
+    (void) arg;
+    (void) old_cpu_hz;
+
+    LPC_TIM1->PR = (new_cpu_hz / (1000 * 1000));
+    LPC_TIM1->PC = 0;
+}
+
+#if (1 == SYS_CFG_STEPPER_TIMER)
+#warning "IR receiver will not work since TIMER1 is used by the stepper (SYS_CFG_STEPPER_TIMER)"
+#else
+/**
+ * Actual ISR function (@see startup.cpp)
+ */
+extern "C" void TIMER1_IRQHandler()
+{
+    const uint32_t timer_capt0_intr = (1 << 4);
+
+    LPC_TIM1->IR = timer_capt0_intr;
+    IS.captureIsr(LPC_TIM1->CR0);
+}
+#endif
+#endif
+
+/**
+ * IR Sensor is attached to P1.18 - CAP1.0, so it needs TIMER1 to capture the times on P1.18
+ */
+bool IR_Sensor::init()
+{
+    if (NULL == mQueue) {
+        mQueue = xQueueCreate(IR_SENSOR_QUEUE_SIZE, sizeof(ir_code_t));
+    }
+
+#if (1 == SYS_CFG_SYS_TIMER)
+    /* Power up the timer 1 in case it is off */
+    lpc_pconp(pconp_timer1, true);
+
+    /* Timer 1 should be initialized by high_level_init.cpp using lpc_sys.c API
+     * We will just add on the capture functionality here.
+     */
+#elif (1 != SYS_CFG_STEPPER_TIMER)
+    /* Timer 1 only captures the edges, so it runs without any match interrupt */
+    lpc_timer_enable(lpc_timer1, 1);
+    LPC_TIM1->MCR = 0;
+    LPC_TIM1->IR = 0x3F;
+    sys_clock_add_listener(ir_sensor_clock_changed, NULL);
+    NVIC_EnableIRQ(TIMER1_IRQn);
+#else
+    return false;
+#endif
+
+    LPC_TIM1->CCR &= ~(7 << 0);                       // Clear Bits 2:1:0
+    LPC_TIM1->CCR |=  (1 << 2) | (1 << 1) | (1 << 0); // Enable Rising and Falling Edge capture0 with interrupt
+
+    // Select P1.18 as CAP1.0 by setting bits 5:4 to 0b11
+    LPC_PINCON->PINSEL3 |= (3 << 4);
+
+    return (NULL != mQueue);
+}
+
+bool IR_Sensor::getIrCode(ir_code_t &code, TickType_t timeout)
+{
+    return (NULL != mQueue && xQueueReceive(mQueue, &code, timeout));
+}
+
+bool IR_Sensor::isIRCodeReceived()
+{
+    ir_code_t code;
+
+    /* The repeats of a held button are not reported here */
+    while (NULL != mQueue && xQueuePeek(mQueue, &code, 0)) {
+        if (0 == code.repeat) {
+            return true;
+        }
+        (void) xQueueReceive(mQueue, &code, 0);
+    }
+    return false;
+}
+
+uint32_t IR_Sensor::getLastIRCode()
+{
+    ir_code_t code;
+    return (isIRCodeReceived() && getIrCode(code, 0)) ? code.code : 0;
+}
+
+
+
+bool LED_Display::init()
+{
+    bool devicePresent = checkDeviceResponse();
+    if(devicePresent)
+    {
+        const unsigned char cfgAsOutput = 0x00;
+        writeReg(cfgPort0, cfgAsOutput);
+        writeReg(cfgPort1, cfgAsOutput);
+
+        /* The digits are written immediately if there is no worker */
+        workqueue_start(work_prio_low);
+        setLeftDigit('.');
+        setRightDigit('.');
+    }
+
+    return devicePresent;
+}
+void LED_Display::clear()
+{
+    setLeftDigit(' ');
+    setRightDigit(' ');
+}
+void LED_Display::setNumber(char num)
+{
+    num %= 100;
+    setRightDigit(num%10 + '0');
+
+    if(num < 10)
+        setLeftDigit(' ');
+    else
+        setLeftDigit (num/10 + '0');
+}
+void LED_Display::setLeftDigit(char alpha)
+{
+    setDigit(0, alpha);
+}
+void LED_Display::setRightDigit(char alpha)
+{
+    setDigit(1, alpha);
+}
+void LED_Display::setDigit(uint8_t index, char alpha)
+{
+    /* The left digit is outputPort1 */
+    mNumAtDisplay[index] = alpha;
+    mFrame[1 - index] = LED_DISPLAY_CHARMAP[(unsigned) (alpha & 0x7F) ];
+
+    /* A pending refresh is not moved, so a high rate of updates cannot postpone it */
+    if (taskSCHEDULER_RUNNING != xTaskGetSchedulerState()) {
+        refresh();
+    }
+    else if (!workqueue_is_pending(&mRefreshWork) &&
+             !workqueue_post_delayed(work_prio_low, &mRefreshWork, refreshWork, this, LED_DISPLAY_REFRESH_MS)) {
+        refresh();
+    }
+}
+void LED_Display::refresh()
+{
+    uint8_t frame[2];
+
+    portENTER_CRITICAL();
+    frame[0] = mFrame[0];
+    frame[1] = mFrame[1];
+    portEXIT_CRITICAL();
+
+    /* Both output registers are written in one burst */
+    if (frame[0] != mWritten[0] || frame[1] != mWritten[1]) {
+        if (writeRegisters(outputPort0, &frame[0], sizeof(frame))) {
+            mWritten[0] = frame[0];
+            mWritten[1] = frame[1];
+        }
+    }
+}
+void LED_Display::refreshWork(void *pThis)
+{
+    ((LED_Display*) pThis)->refresh();
+}
+
+
+
+
+bool LED::init()
+{
+    /* Pins initialized by bio.h, and the changes are written immediately if there is no worker */
+    workqueue_start(work_prio_low);
+    return true;
+}
+void LED::on(uint8_t ledNum)
+{
+    portENTER_CRITICAL();
+    mLedValue or_eq (1 << (ledNum-1));
+    portEXIT_CRITICAL();
+    changed();
+}
+void LED::off(uint8_t ledNum)
+{
+    portENTER_CRITICAL();
+    mLedValue and_eq ~(1 << (ledNum-1));
+    portEXIT_CRITICAL();
+    changed();
+}
+void LED::toggle(uint8_t ledNum)
+{
+    portENTER_CRITICAL();
+    mLedValue xor_eq (1 << (ledNum-1));
+    portEXIT_CRITICAL();
+    changed();
+}
+void LED::set(uint8_t ledNum, bool ON)
+{
+    ON ? on(ledNum) : off(ledNum);
+}
+void LED::setAll(uint8_t value)
+{
+    mLedValue = value & 0x0F;
+    changed();
+}
+void LED::changed(void)
+{
+    /* A pending refresh is not moved, so a high rate of updates cannot postpone it */
+    if (taskSCHEDULER_RUNNING != xTaskGetSchedulerState()) {
+        refresh();
+    }
+    else if (!workqueue_is_pending(&mRefreshWork) &&
+             !workqueue_post_delayed(work_prio_low, &mRefreshWork, refreshWork, this, LED_REFRESH_MS)) {
+        refresh();
+    }
+}
+void LED::refresh(void)
+{
+    /* LEDs are active low, and are P1.0, P1.1, P1.4, and P1.8 */
+    const uint32_t ledPins = (1 << 0) | (1 << 1) | (1 << 4) | (1 << 8);
+
+    portENTER_CRITICAL();
+    const uint8_t value = mLedValue;
+    if (value != mWritten) {
+        const uint32_t onPins = ((value & (1 << 0)) ? (1 << 0) : 0) |
+                                ((value & (1 << 1)) ? (1 << 1) : 0) |
+                                ((value & (1 << 2)) ? (1 << 4) : 0) |
+                                ((value & (1 << 3)) ? (1 << 8) : 0);
+        LPC_GPIO1->FIOCLR = onPins;
+        LPC_GPIO1->FIOSET = ledPins & ~onPins;
+        mWritten = value;
+    }
+    portEXIT_CRITICAL();
+}
+void LED::refreshWork(void *pThis)
+{
+    ((LED*) pThis)->refresh();
+}
+uint8_t LED::getValues(void) const
+{
+    return mLedValue;
+}
+
+
+bool Light_Sensor::init()
+{
+    return true;
+}
+uint16_t Light_Sensor::getRawValue()
+{
+    return adc0_get_reading(BIO_LIGHT_ADC_CH_NUM);
+}
+uint8_t Light_Sensor::getPercentValue()
+{
+    const unsigned int maxAdcValue = 4096;
+    return (getRawValue() * 100) / maxAdcValue;
+}
+uint32_t Light_Sensor::getOversampledValue(uint8_t extraBits)
+{
+    return adc0_get_oversampled(BIO_LIGHT_ADC_CH_NUM, extraBits);
+}
+
+
+
+bool Switches::init()
+{
+    /* Pins initialized by bio.h */
+    return true;
+}
+uint8_t Switches::getSwitchValues()
+{
+    /* Return contiguous bits 0-3 from scattered switch pins */
+    const int swValues = LPC_GPIO1->FIOPIN;
+    const int p9_p10  = (swValues >> 9)  & 0x3;
+    const int p14_p15 = (swValues >> 14) & 0x3;
+    return (p9_p10 | (p14_p15 << 2));
+}
+bool Switches::getSwitch(int num)
+{
+    if (num >= 1 && num <= 4) {
+        return getSwitchValues() & (1 << (num-1));
+    }
+    else {
+        return false;
+    }
+}
+bool Switches::subscribe(QueueHandle_t queue)
+{
+    bool added = false;
+
+    if (NULL == queue) {
+        return false;
+    }
+
+    portENTER_CRITICAL();
+    if (mNumSubs < SWITCH_MAX_SUBSCRIBERS) {
+        mSubs[mNumSubs++] = queue;
+        added = true;
+    }
+    portEXIT_CRITICAL();
+
+    /* The switches that are already pressed are not reported as a press */
+    if (added && !mScanning) {
+        mScanning = true;
+        mStable = getSwitchValues();
+        memset(mChangeScans, 0, sizeof(mChangeScans));
+        memset(mHeldScans, 0, sizeof(mHeldScans));
+        hw_timer_init(&mScanTimer, scanIsr, this);
+        hw_timer_start(&mScanTimer, SWITCH_SCAN_MS * 1000, SWITCH_SCAN_MS * 1000);
+    }
+    return added;
+}
+void Switches::sendFromIsr(uint8_t num, switch_event_type_t type, long *pWoken)
+{
+    switch_event_t event;
+    event.num = num;
+    event.type = type;
+    event.timestamp_us = sys_get_uptime_us();
+
+    for (uint8_t i = 0; i < mNumSubs; i++) {
+        if (!xQueueSendFromISR(mSubs[i], &event, pWoken)) {
+            ++mEventDrops;
+        }
+    }
+}
+void Switches::scanIsr(hw_timer_t *timer, void *arg)
+{
+    Switches &sw = *(Switches*) arg;
+    const uint16_t longPressScans = SWITCH_LONG_PRESS_MS / SWITCH_SCAN_MS;
+    const uint8_t values = sw.getSwitchValues();
+    long woken = 0;
+
+    for (uint8_t i = 0; i < sizeof(sw.mChangeScans); i++)
+    {
+        const uint8_t bit = (1 << i);
+
+        /* A bounce before the switch is stable starts the debounce again */
+        if ((values ^ sw.mStable) & bit) {
+            if (++sw.mChangeScans[i] >= SWITCH_DEBOUNCE_SCANS) {
+                sw.mChangeScans[i] = 0;
+                sw.mHeldScans[i] = 0;
+                sw.mStable ^= bit;
+                sw.sendFromIsr(i + 1, (values & bit) ? switch_pressed : switch_released, &woken);
+            }
+        }
+        else {
+            sw.mChangeScans[i] = 0;
+            if ((sw.mStable & bit) && sw.mHeldScans[i] < longPressScans &&
+                ++sw.mHeldScans[i] == longPressScans) {
+                sw.sendFromIsr(i + 1, switch_long_press, &woken);
+            }
+        }
+    }
+    portEND_SWITCHING_ISR(woken);
+}
+
+
+
+bool I2C_Temp::init()
+{
+    const unsigned char temperatureCfgRegPtr = 0x01;
+    const unsigned char oneShotShutdownMode = 0x81;
+    const unsigned char expectedBitsThatAreNotZero = 0x60; // R1:R0 bits are 1s at startup
+
+    // Enter one-shot shutdown mode.
+    writeReg(temperatureCfgRegPtr, oneShotShutdownMode);
+
+    const unsigned char cfgRegByte0 = readReg(temperatureCfgRegPtr);
+    return (0 != (cfgRegByte0 & expectedBitsThatAreNotZero));
+}
+int16_t I2C_Temp::readSixteenths()
+{
+    // Get signed 16-bit data of temperature register pointer
+    const unsigned char temperatureRegsiterPtr = 0x00;
+    signed short temperature = get16BitRegister(temperatureRegsiterPtr);
+
+    // Trigger next conversion:
+    const unsigned char temperatureCfgRegPtr = 0x01;
+    const unsigned char oneShotShutdownMode = 0x81;
+    writeReg(temperatureCfgRegPtr, oneShotShutdownMode);
+
+    // Temperature data is in bits 15:3 which contains signed 16-bit data
+    return temperature / 16;
+}
+
+float I2C_Temp::getCelsius()
+{
+    // Each bit is of 0.0625 degree per bit resolution
+    return (0.0625F * readSixteenths()) + (mOffsetCelciusX100 / 100.0F);
+}
+
+int16_t I2C_Temp::getCelsiusX100()
+{
+    // Each bit is 100/16 hundredths of a degree
+    return (int16_t) (fixed_scale(readSixteenths(), 100, 16) + mOffsetCelciusX100);
+}
+
+int16_t I2C_Temp::getFarenheitX100()
+{
+    return (int16_t) (fixed_scale(getCelsiusX100(), 9, 5) + 3200);
+}
+
+float I2C_Temp::getFarenheit()
+{
+    return (getCelsius() * 9.0F / 5) + 32;
+}
+
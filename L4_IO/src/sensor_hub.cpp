@@ -0,0 +1,75 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include "sensor_hub.hpp"
+#include "io.hpp"
+#include "lpc_sys.h"
+
+
+
+#if (0 != SENSOR_HUB_ACCEL_MS % SENSOR_HUB_TICK_MS || 0 != SENSOR_HUB_LIGHT_MS % SENSOR_HUB_TICK_MS || \
+     0 != SENSOR_HUB_TEMP_MS % SENSOR_HUB_TICK_MS)
+#error "The sampling periods of the sensor hub should be multiples of SENSOR_HUB_TICK_MS"
+#endif
+
+EVENT_TOPIC_DEFINE(sensor_accel_topic, accel_sample_t);
+EVENT_TOPIC_DEFINE(sensor_light_topic, sensor_light_t);
+EVENT_TOPIC_DEFINE(sensor_temp_topic, sensor_temp_t);
+
+/// @returns true if the sensor of the period is due at the tick
+static inline bool sensor_hub_due(uint32_t ticks, uint32_t periodMs)
+{
+    return (0 != periodMs) && (0 == ticks % (periodMs / SENSOR_HUB_TICK_MS));
+}
+
+
+
+sensorHubTask::sensorHubTask(uint8_t priority) :
+    scheduler_task("sensors", 512 * 3, priority),
+    mTicks(0)
+{
+    setRunDuration(SENSOR_HUB_TICK_MS);
+}
+
+bool sensorHubTask::run(void *p)
+{
+    if (sensor_hub_due(mTicks, SENSOR_HUB_ACCEL_MS)) {
+        accel_sample_t accel;
+        if (AS.getXYZ(accel)) {
+            event_bus_publish(&sensor_accel_topic, &accel);
+        }
+    }
+
+    if (sensor_hub_due(mTicks, SENSOR_HUB_LIGHT_MS)) {
+        sensor_light_t light;
+        light.raw = LS.getRawValue();
+        light.percent = (light.raw * 100) / 4096;
+        light.timestamp_us = sys_get_uptime_us();
+        event_bus_publish(&sensor_light_topic, &light);
+    }
+
+    if (sensor_hub_due(mTicks, SENSOR_HUB_TEMP_MS)) {
+        sensor_temp_t temp;
+        temp.celsius_x100 = TS.getCelsiusX100();
+        temp.timestamp_us = sys_get_uptime_us();
+        event_bus_publish(&sensor_temp_topic, &temp);
+    }
+
+    ++mTicks;
+    return true;
+}
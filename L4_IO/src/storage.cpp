@@ -16,22 +16,518 @@
  *          p r e e t . w i k i @ g m a i l . c o m
  */
 
+#include <string.h>
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
 #include "lpc_sys.h"
 #include "storage.hpp"
 #include "ff.h"
+#include "workqueue.h"
+
+
+
+/**
+ * If a seek is beyond the clusters covered by a map, the map is re-built if more than
+ * this many clusters need to be followed on the FAT, otherwise the new clusters are
+ * followed from the end of the map.  This bounds the cost of appending to a growing file.
+ */
+#define STORAGE_CLMT_MAX_TAIL   8
+
+#if (STORAGE_CACHED_FILES >= SYS_CFG_MAX_FILES_OPENED)
+#error "STORAGE_CACHED_FILES should be less than SYS_CFG_MAX_FILES_OPENED, so other files can be opened"
+#endif
+
+/**
+ * @{ Buffers of the pipelined Storage::copy().  The buffers are a multiple of the sector size,
+ * so FatFs reads and writes them with multi-sector disk_read() and disk_write() of the user
+ * buffer, rather than one sector at a time through the window of the file system.
+ */
+#define STORAGE_COPY_BUFFERS        2
+#define STORAGE_COPY_BUFFER_BYTES   (8 * _MAX_SS)
+/** @} */
+
+/// A buffer of the pipelined copy
+typedef struct {
+    UINT len;                                   ///< The bytes of data[], 0 tells the writer task to exit
+    char data[STORAGE_COPY_BUFFER_BYTES];
+} storage_copy_buffer_t;
+
+/// The state of the pipelined copy shared by the reader (the caller) and the writer task
+typedef struct {
+    FIL *pDst;                  ///< The file being written
+    QueueHandle_t filled;       ///< Buffers read by the reader, to be written
+    QueueHandle_t empty;        ///< Buffers written by the writer, to be read into
+    unsigned int writeTimeMs;   ///< Time spent within f_write()
+    volatile FRESULT status;    ///< The first error of the writer
+} storage_copy_pipe_t;
+
+/// A file cached open by Storage::read(), write() and append(), and the cluster map of the file
+typedef struct {
+    char name[32];              ///< Filename of the entry, empty if the entry is free
+    bool inUse;                 ///< Entry is being used by a task
+    bool opened;                ///< The file is open
+    unsigned int lastUsed;      ///< Least recently used counter
+    unsigned int releasedMs;    ///< The uptime when the entry was last released, for the idle close
+    FIL file;
+    ClusterMap map;
+} storage_file_entry_t;
+
+static storage_file_entry_t g_file_cache[STORAGE_CACHED_FILES];
+static unsigned int g_file_use_counter = 0;
+
+/// The work item that closes the idle files, and if it is posted
+static work_delayed_t g_idle_work;
+static volatile bool g_idle_posted = false;
+
+/// @returns the bytes per cluster of the file's volume
+static inline DWORD storage_cluster_bytes(const FIL *pFile)
+{
+#if _MAX_SS != _MIN_SS
+    return (DWORD) pFile->fs->csize * pFile->fs->ssize;
+#else
+    return (DWORD) pFile->fs->csize * _MAX_SS;
+#endif
+}
+
+/// @returns false if the volume of the open file was mounted again or formatted since it was opened
+static inline bool storage_file_valid(const FIL *pFile)
+{
+    return (pFile->fs && pFile->fs->fs_type && pFile->id == pFile->fs->id);
+}
+
+/**
+ * Claims the cached entry of the given file, or the least recently used entry,
+ * and closes the file of the entry if it belonged to another file.
+ * @returns NULL if no entry is available, in which case the file should be opened by the caller.
+ */
+static storage_file_entry_t* storage_claim(const char *pFilename)
+{
+    storage_file_entry_t *pEntry = 0;
+    bool reused = false;
+
+    if (strlen(pFilename) >= sizeof(g_file_cache[0].name)) {
+        return 0;
+    }
+
+    taskENTER_CRITICAL();
+    {
+        for (int i = 0; i < STORAGE_CACHED_FILES; i++) {
+            if (0 == strcmp(g_file_cache[i].name, pFilename)) {
+                pEntry = g_file_cache[i].inUse ? 0 : &g_file_cache[i];
+                break;
+            }
+            if (!g_file_cache[i].inUse && (!pEntry || g_file_cache[i].lastUsed < pEntry->lastUsed)) {
+                pEntry = &g_file_cache[i];
+            }
+        }
+
+        if (pEntry) {
+            if (0 != strcmp(pEntry->name, pFilename)) {
+                strcpy(pEntry->name, pFilename);
+                pEntry->map.invalidate();
+                reused = true;
+            }
+            pEntry->inUse = true;
+            pEntry->lastUsed = ++g_file_use_counter;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    /* The entry is ours now, so the file of the previous name can be closed outside of the critical section */
+    if (reused && pEntry->opened) {
+        pEntry->opened = false;
+        f_close(&pEntry->file);
+    }
+
+    return pEntry;
+}
+
+/**
+ * Claims the cached entry of the file, and opens the file if it is not open yet.  The file is
+ * opened for reading and writing, so the same handle is used by read(), write() and append().
+ * @param mode     The FatFs mode to open the file with, without FA_READ and FA_WRITE
+ * @param pStatus  Set to the status of f_open() if the file could not be opened
+ * @returns NULL if the file is not cached, in which case *pStatus tells if the caller should open it
+ */
+static storage_file_entry_t* storage_open(const char *pFilename, BYTE mode, FRESULT *pStatus)
+{
+    storage_file_entry_t *pEntry = storage_claim(pFilename);
+
+    if (pEntry)
+    {
+        /* A remount of the volume invalidates the handle, but the file was synced after each write */
+        if (pEntry->opened && !storage_file_valid(&pEntry->file)) {
+            pEntry->opened = false;
+        }
+
+        if (!pEntry->opened) {
+            *pStatus = f_open(&pEntry->file, pFilename, mode | FA_READ | FA_WRITE);
+            pEntry->opened = (FR_OK == *pStatus);
+        }
+
+        if (!pEntry->opened) {
+            pEntry->name[0] = '\0';
+            pEntry->inUse = false;
+            pEntry = 0;
+        }
+    }
+
+    return pEntry;
+}
+
+/// @returns true if the file should be opened without the cache after storage_open() returned NULL
+static inline bool storage_open_uncached(FRESULT status)
+{
+    /* The cached handle is writable, so a read-only file or disk uses a read-only handle */
+    return (FR_OK == status || FR_DENIED == status || FR_WRITE_PROTECTED == status);
+}
+
+/// Closes the files that were not used for STORAGE_IDLE_CLOSE_MS; this runs on the workqueue
+static void storage_close_idle(void *ctx)
+{
+    const unsigned int nowMs = sys_get_uptime_ms();
+    bool opened = false;
+    (void) ctx;
+
+    for (int i = 0; i < STORAGE_CACHED_FILES; i++)
+    {
+        storage_file_entry_t *pEntry = &g_file_cache[i];
+        bool claimed = false;
+
+        taskENTER_CRITICAL();
+        if (!pEntry->inUse && pEntry->opened) {
+            if (nowMs - pEntry->releasedMs >= STORAGE_IDLE_CLOSE_MS) {
+                pEntry->inUse = claimed = true;
+            }
+            else {
+                opened = true;
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        if (claimed) {
+            pEntry->opened = false;
+            f_close(&pEntry->file);
+            pEntry->inUse = false;
+        }
+    }
+
+    /* Check again for the files that are still open */
+    g_idle_posted = opened && workqueue_post_delayed(work_prio_low, &g_idle_work, storage_close_idle,
+                                                     NULL, STORAGE_IDLE_CLOSE_MS);
+}
+
+/**
+ * Releases the entry claimed by storage_open().  The file is closed if the access failed,
+ * otherwise it stays open until it is idle for STORAGE_IDLE_CLOSE_MS.
+ */
+static void storage_release(storage_file_entry_t *pEntry, FRESULT status)
+{
+    pEntry->file.cltbl = 0;
+    pEntry->releasedMs = sys_get_uptime_ms();
+
+    if (FR_OK != status) {
+        pEntry->opened = false;
+        f_close(&pEntry->file);
+    }
+    else if (!g_idle_posted) {
+        /* If the idle close cannot be posted, the file is not kept open */
+        g_idle_posted = workqueue_start(work_prio_low) &&
+                        workqueue_post_delayed(work_prio_low, &g_idle_work, storage_close_idle,
+                                               NULL, STORAGE_IDLE_CLOSE_MS);
+        if (!g_idle_posted) {
+            pEntry->opened = false;
+            f_close(&pEntry->file);
+        }
+    }
+
+    pEntry->inUse = false;
+}
+
+
+
+bool ClusterMap::covers(const FIL *pFile, DWORD offset) const
+{
+    return (mClusters > 0 && mStartCluster == pFile->sclust &&
+            (offset - 1) / storage_cluster_bytes(pFile) < mClusters);
+}
+
+FRESULT ClusterMap::build(FIL *pFile)
+{
+    FRESULT status;
+
+    mStartCluster = 0;
+    mClusters = 0;
+
+    mTable[0] = STORAGE_CLMT_ITEMS;
+    pFile->cltbl = mTable;
+    status = f_lseek(pFile, CREATE_LINKMAP);
+    pFile->cltbl = 0;
+
+    /* Table is pairs of fragment length and start cluster terminated by zero length */
+    if (FR_OK == status) {
+        for (DWORD *pItem = &mTable[1]; *pItem; pItem += 2) {
+            mClusters += *pItem;
+        }
+        mStartCluster = pFile->sclust;
+    }
+    else {
+        /* The file has too many fragments for the table, so it isn't walked again at each seek */
+        mFailedCluster = pFile->sclust;
+    }
+
+    return status;
+}
+
+FRESULT ClusterMap::seek(FIL *pFile, DWORD offset)
+{
+    pFile->cltbl = 0;
+
+    /* Fast seek cannot expand the file, the top of the file doesn't need the map, and
+     * the map of a file with too many fragments could not be built
+     */
+    if (0 == offset || offset > f_size(pFile) || mFailedCluster == pFile->sclust) {
+        return f_lseek(pFile, offset);
+    }
+
+    if (!covers(pFile, offset)) {
+        const DWORD cluster = (offset - 1) / storage_cluster_bytes(pFile);
+        if (0 == mClusters || mStartCluster != pFile->sclust ||
+            cluster - mClusters >= STORAGE_CLMT_MAX_TAIL) {
+            build(pFile);
+        }
+    }
+
+    if (0 == mClusters || mStartCluster != pFile->sclust) {
+        return f_lseek(pFile, offset);
+    }
+
+    pFile->cltbl = mTable;
+    if (covers(pFile, offset)) {
+        return f_lseek(pFile, offset);
+    }
+
+    /* Fast seek to the end of the map, and follow the remaining clusters on the FAT */
+    FRESULT status = f_lseek(pFile, mClusters * storage_cluster_bytes(pFile));
+    pFile->cltbl = 0;
+    if (FR_OK == status) {
+        status = f_lseek(pFile, offset);
+    }
+    return status;
+}
+
+void ClusterMap::select(FIL *pFile, DWORD bytes)
+{
+    const bool inMap = (bytes > 0 && covers(pFile, f_tell(pFile) + bytes));
+    pFile->cltbl = inMap ? mTable : 0;
+}
+
+
+
+FRESULT IndexedFile::open(const char *pFilename, BYTE mode)
+{
+    close();
+    mMap.invalidate();
+
+    FRESULT status = f_open(&mFile, pFilename, mode);
+    mOpened = (FR_OK == status);
+    return status;
+}
+
+FRESULT IndexedFile::close(void)
+{
+    FRESULT status = FR_OK;
+    if (mOpened) {
+        mOpened = false;
+        status = f_close(&mFile);
+    }
+    return status;
+}
+
+FRESULT IndexedFile::seek(DWORD offset)
+{
+    return mMap.seek(&mFile, offset);
+}
+
+FRESULT IndexedFile::read(void *pData, UINT bytesToRead, UINT *pBytesRead)
+{
+    mMap.select(&mFile, bytesToRead);
+    return f_read(&mFile, pData, bytesToRead, pBytesRead);
+}
+
+FRESULT IndexedFile::write(const void *pData, UINT bytesToWrite, UINT *pBytesWritten)
+{
+    mMap.select(&mFile, bytesToWrite);
+    return f_write(&mFile, pData, bytesToWrite, pBytesWritten);
+}
+
+
+
+FRESULT Storage::close(const char* pFilename)
+{
+    FRESULT status = FR_OK;
+
+    for (int i = 0; i < STORAGE_CACHED_FILES; i++)
+    {
+        storage_file_entry_t *pEntry = &g_file_cache[i];
+        bool claimed = false;
+
+        /* Wait for the task that is using the file */
+        do {
+            bool matched = false;
+            taskENTER_CRITICAL();
+            if ('\0' != pEntry->name[0] && (!pFilename || 0 == strcmp(pEntry->name, pFilename))) {
+                matched = true;
+                if (!pEntry->inUse) {
+                    pEntry->inUse = claimed = true;
+                }
+            }
+            taskEXIT_CRITICAL();
+
+            if (!matched) {
+                break;
+            }
+            if (!claimed) {
+                vTaskDelay(1);
+            }
+        } while (!claimed);
+
+        if (claimed) {
+            if (pEntry->opened) {
+                pEntry->opened = false;
+                const FRESULT closeStatus = f_close(&pEntry->file);
+                if (FR_OK != closeStatus) {
+                    status = closeStatus;
+                }
+            }
+            pEntry->name[0] = '\0';
+            pEntry->map.invalidate();
+            pEntry->inUse = false;
+        }
+    }
+
+    return status;
+}
+
+
+
+/// Writes the buffers of the pipelined copy, and gives back the buffer of length 0 when it exits
+static void storage_copy_writer(void *p)
+{
+    storage_copy_pipe_t *pipe = (storage_copy_pipe_t*) p;
+    storage_copy_buffer_t *buffer = NULL;
+
+    while (xQueueReceive(pipe->filled, &buffer, portMAX_DELAY) && buffer->len > 0)
+    {
+        /* After an error, the buffers are still given back, so the reader does not get stuck */
+        if (FR_OK == pipe->status) {
+            const unsigned int startTime = sys_get_uptime_ms();
+            UINT bytesWritten = 0;
+            pipe->status = f_write(pipe->pDst, buffer->data, buffer->len, &bytesWritten);
+            if (FR_OK == pipe->status && bytesWritten != buffer->len) {
+                pipe->status = FR_DENIED;
+            }
+            pipe->writeTimeMs += sys_get_uptime_ms() - startTime;
+        }
+        xQueueSend(pipe->empty, &buffer, portMAX_DELAY);
+    }
+
+    xQueueSend(pipe->empty, &buffer, portMAX_DELAY);
+    vTaskDelete(NULL);
+}
+
+/**
+ * Copies the file by reading into one buffer while the writer task writes another one,
+ * so the time of the copy is closer to the larger of the read and write times than their sum.
+ * @returns FR_NOT_ENOUGH_CORE if the buffers or the writer task could not be created,
+ *          in which case nothing was copied
+ */
+static FRESULT storage_pipelined_copy(FIL *pSrc, FIL *pDst, unsigned int *pReadTimeMs,
+                                      unsigned int *pWriteTimeMs, unsigned int *pBytes)
+{
+    FRESULT status = FR_OK;
+    storage_copy_pipe_t pipe;
+    storage_copy_buffer_t *buffer = NULL;
+
+    storage_copy_buffer_t *buffers = (storage_copy_buffer_t*) malloc(STORAGE_COPY_BUFFERS * sizeof(*buffers));
+    pipe.pDst = pDst;
+    pipe.filled = xQueueCreate(STORAGE_COPY_BUFFERS, sizeof(buffer));
+    pipe.empty = xQueueCreate(STORAGE_COPY_BUFFERS, sizeof(buffer));
+    pipe.writeTimeMs = 0;
+    pipe.status = FR_OK;
+
+    if (!buffers || !pipe.filled || !pipe.empty ||
+        !xTaskCreate(storage_copy_writer, "copy", STACK_BYTES(1024), &pipe, PRIORITY_MEDIUM, NULL))
+    {
+        status = FR_NOT_ENOUGH_CORE;
+    }
+    else
+    {
+        for (unsigned int i = 0; i < STORAGE_COPY_BUFFERS; i++) {
+            buffer = &buffers[i];
+            xQueueSend(pipe.empty, &buffer, 0);
+        }
+
+        /* Read into each buffer that comes back, until the end of the file or an error */
+        for (;;)
+        {
+            xQueueReceive(pipe.empty, &buffer, portMAX_DELAY);
+            if (FR_OK != pipe.status) {
+                break;
+            }
+
+            const unsigned int startTime = sys_get_uptime_ms();
+            status = f_read(pSrc, buffer->data, sizeof(buffer->data), &buffer->len);
+            *pReadTimeMs += sys_get_uptime_ms() - startTime;
 
+            if (FR_OK != status || 0 == buffer->len) {
+                break;
+            }
+            *pBytes += buffer->len;
+            xQueueSend(pipe.filled, &buffer, portMAX_DELAY);
+        }
+
+        /* The buffer of length 0 ends the writer, and it comes back after all the other ones */
+        buffer->len = 0;
+        xQueueSend(pipe.filled, &buffer, portMAX_DELAY);
+        for (unsigned int i = 0; i < STORAGE_COPY_BUFFERS; i++) {
+            xQueueReceive(pipe.empty, &buffer, portMAX_DELAY);
+        }
+
+        *pWriteTimeMs = pipe.writeTimeMs;
+        if (FR_OK == status) {
+            status = pipe.status;
+        }
+    }
 
+    if (pipe.filled) {
+        vQueueDelete(pipe.filled);
+    }
+    if (pipe.empty) {
+        vQueueDelete(pipe.empty);
+    }
+    free(buffers);
+    return status;
+}
 
 FRESULT Storage::copy(const char* pExistingFile, const char* pNewFile,
                         unsigned int* pReadTime,
                         unsigned int* pWriteTime,
-                        unsigned int* pBytesTransferred)
+                        unsigned int* pBytesTransferred,
+                        unsigned int* pTotalTime)
 {
     FRESULT status;
     FIL srcFile;
     FIL dstFile;
     unsigned int readTimeMs = 0;
     unsigned int writeTimeMs = 0;
+    const unsigned int copyStartTime = sys_get_uptime_ms();
+
+    // The new file is truncated below, so its cached handle would no longer be valid
+    close(pNewFile);
 
     // Open Existing file
     if (FR_OK != (status = f_open(&srcFile, pExistingFile, FA_OPEN_EXISTING | FA_READ))) {
@@ -50,7 +546,14 @@ FRESULT Storage::copy(const char* pExistingFile, const char* pNewFile,
     unsigned int bytesWritten = 0;
     unsigned int totalBytesTransferred = 0;
 
-    for (;;)
+    /* Without the memory for the pipelined copy, copy until the end of the file using our stack buffer */
+    bool copied = false;
+    if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        status = storage_pipelined_copy(&srcFile, &dstFile, &readTimeMs, &writeTimeMs, &totalBytesTransferred);
+        copied = (FR_NOT_ENOUGH_CORE != status);
+    }
+
+    while (!copied)
     {
         unsigned int startTime = sys_get_uptime_ms();
         if(FR_OK != (status = f_read(&srcFile, buffer, sizeof(buffer), &bytesRead)) ||
@@ -82,23 +585,35 @@ FRESULT Storage::copy(const char* pExistingFile, const char* pNewFile,
     f_close(&srcFile);
     f_close(&dstFile);
 
+    if(0 != pTotalTime) {
+        *pTotalTime = sys_get_uptime_ms() - copyStartTime;
+    }
+
     return status;
 }
 
 FRESULT Storage::read(const char* pFilename,  void* pData, unsigned int bytesToRead, unsigned int offset)
 {
-    FRESULT status = FR_INT_ERR;
-    FIL file;
+    FRESULT status = FR_OK;
     unsigned int bytesRead = 0;
+    storage_file_entry_t *pEntry = storage_open(pFilename, FA_OPEN_EXISTING, &status);
 
-    // Open Existing file
-    if (FR_OK == (status = f_open(&file, pFilename, FA_OPEN_EXISTING | FA_READ)))
-    {
-        if(offset) {
-            f_lseek(&file, offset);
+    if (pEntry) {
+        if (FR_OK == (status = pEntry->map.seek(&pEntry->file, offset))) {
+            pEntry->map.select(&pEntry->file, bytesToRead);
+            status = f_read(&pEntry->file, pData, bytesToRead, &bytesRead);
+        }
+        storage_release(pEntry, status);
+    }
+    else if (storage_open_uncached(status)) {
+        FIL file;
+        if (FR_OK == (status = f_open(&file, pFilename, FA_OPEN_EXISTING | FA_READ))) {
+            if(offset) {
+                f_lseek(&file, offset);
+            }
+            status = f_read(&file, pData, bytesToRead, &bytesRead);
+            f_close(&file);
         }
-        status = f_read(&file, pData, bytesToRead, &bytesRead);
-        f_close(&file);
     }
 
     return status;
@@ -106,18 +621,30 @@ FRESULT Storage::read(const char* pFilename,  void* pData, unsigned int bytesToR
 
 FRESULT Storage::write(const char* pFilename, void* pData, unsigned int bytesToWrite, unsigned int offset)
 {
-    FRESULT status = FR_INT_ERR;
-    FIL file;
+    FRESULT status = FR_OK;
     unsigned int bytesWritten = 0;
+    storage_file_entry_t *pEntry = storage_open(pFilename, FA_OPEN_ALWAYS, &status);
 
-    status = f_open(&file, pFilename, FA_CREATE_ALWAYS | FA_WRITE);
-    if(FR_OK == status)
-    {
-        if(offset) {
-            f_lseek(&file, offset);
+    if (pEntry) {
+        // The file is truncated, so its previous cluster map is no longer valid
+        pEntry->map.invalidate();
+        if (FR_OK == (status = f_lseek(&pEntry->file, 0)) &&
+            FR_OK == (status = f_truncate(&pEntry->file)) &&
+            FR_OK == (status = f_lseek(&pEntry->file, offset)) &&
+            FR_OK == (status = f_write(&pEntry->file, pData, bytesToWrite, &bytesWritten))) {
+            status = f_sync(&pEntry->file);
+        }
+        storage_release(pEntry, status);
+    }
+    else if (storage_open_uncached(status)) {
+        FIL file;
+        if (FR_OK == (status = f_open(&file, pFilename, FA_CREATE_ALWAYS | FA_WRITE))) {
+            if(offset) {
+                f_lseek(&file, offset);
+            }
+            status = f_write(&file, pData, bytesToWrite, &bytesWritten);
+            f_close(&file);
         }
-        status = f_write(&file, pData, bytesToWrite, &bytesWritten);
-        f_close(&file);
     }
 
     return status;
@@ -125,23 +652,29 @@ FRESULT Storage::write(const char* pFilename, void* pData, unsigned int bytesToW
 
 FRESULT Storage::append(const char* pFilename,void* pData, unsigned int bytesToAppend, unsigned int offset)
 {
-    FRESULT status = FR_INT_ERR;
-    FIL file;
+    FRESULT status = FR_OK;
     unsigned int bytesWritten = 0;
+    storage_file_entry_t *pEntry = storage_open(pFilename, FA_OPEN_ALWAYS, &status);
 
-    // Open Existing file
-    if (FR_OK == (status = f_open(&file, pFilename, FA_OPEN_ALWAYS | FA_WRITE)))
-    {
-        if(offset > 0) {
-            f_lseek(&file, offset);
+    if (pEntry) {
+        /* The file stays open, so the chunks appended one after the other do not need to seek */
+        const DWORD seekTo = (offset > 0) ? offset : f_size(&pEntry->file);
+        if (f_tell(&pEntry->file) == seekTo || FR_OK == (status = pEntry->map.seek(&pEntry->file, seekTo))) {
+            pEntry->map.select(&pEntry->file, bytesToAppend);
+            if (FR_OK == (status = f_write(&pEntry->file, pData, bytesToAppend, &bytesWritten))) {
+                /* The file on the disk is complete after each call, as if it was closed */
+                status = f_sync(&pEntry->file);
+            }
         }
-        else {
-            f_lseek(&file, f_size(&file));
+        storage_release(pEntry, status);
+    }
+    else if (storage_open_uncached(status)) {
+        FIL file;
+        if (FR_OK == (status = f_open(&file, pFilename, FA_OPEN_ALWAYS | FA_WRITE))) {
+            f_lseek(&file, (offset > 0) ? offset : f_size(&file));
+            status = f_write(&file, pData, bytesToAppend, &bytesWritten);
+            f_close(&file);
         }
-
-        status = f_write(&file, pData, bytesToAppend, &bytesWritten);
-
-        f_close(&file);
     }
 
     return status;
@@ -28,6 +28,101 @@
 
 
 
+/// Number of DWORDs of a cluster link map table; each fragment of a file uses two items
+#define STORAGE_CLMT_ITEMS          32
+
+/// Number of files that are kept open by Storage::read(), write() and append(), with their cluster link map table
+#define STORAGE_CACHED_FILES        2
+
+/// The files kept open by Storage are closed once they were not used for this time
+#define STORAGE_IDLE_CLOSE_MS       2000
+
+
+
+/**
+ * Cluster link map table (CLMT) used by the FatFs fast seek feature.
+ * The table maps the cluster chain of a file such that a seek doesn't need to
+ * follow the FAT from the start of the file.  The map stays valid when the file
+ * grows, it only covers the clusters that existed when it was built.
+ *
+ * @warning The map becomes invalid if the file is truncated, removed, or re-written
+ *          without using Storage or IndexedFile.  Call invalidate() in that case.
+ */
+class ClusterMap
+{
+    public:
+        ClusterMap() : mStartCluster(0), mClusters(0), mFailedCluster(0) { mTable[0] = 0; }
+
+        /// Invalidates the map; next seek will build it again
+        void invalidate(void) { mStartCluster = 0; mClusters = 0; mFailedCluster = 0; }
+
+        /**
+         * Seeks the file to the given offset, building the map if needed.
+         * An offset beyond the file size uses the normal FatFs seek which expands the file.
+         */
+        FRESULT seek(FIL *pFile, DWORD offset);
+
+        /**
+         * Selects fast or normal mode before reading or writing bytes at the current
+         * file pointer.  If the access reaches clusters that are not covered by the
+         * map, the normal mode is used which also allows FatFs to stretch the file.
+         */
+        void select(FIL *pFile, DWORD bytes);
+
+    private:
+        bool covers(const FIL *pFile, DWORD offset) const;
+        FRESULT build(FIL *pFile);
+
+        DWORD mStartCluster;                ///< Start cluster of the file that this map belongs to
+        DWORD mClusters;                    ///< Number of clusters covered by the map
+        DWORD mFailedCluster;               ///< Start cluster of the file whose map did not fit, which uses the normal seek
+        DWORD mTable[STORAGE_CLMT_ITEMS];   ///< The CLMT given to FatFs
+};
+
+/**
+ * A file handle that uses FatFs fast seek.
+ * The cluster link map is built on the first seek, and cached for the life of the
+ * object, so seeking within a multi-megabyte file doesn't walk the cluster chain.
+ *
+ * @code
+ *      IndexedFile file;
+ *      if (FR_OK == Storage::openIndexed(file, "1:log.csv", FA_OPEN_EXISTING | FA_READ)) {
+ *          file.seek(offset);
+ *          file.read(buffer, sizeof(buffer), &bytesRead);
+ *          file.close();
+ *      }
+ * @endcode
+ */
+class IndexedFile
+{
+    public:
+        IndexedFile() : mOpened(false) {}
+        ~IndexedFile() { close(); }
+
+        /// Opens the file, @see f_open() for the mode
+        FRESULT open(const char *pFilename, BYTE mode);
+        FRESULT close(void);
+
+        FRESULT seek(DWORD offset);
+        FRESULT read(void *pData, UINT bytesToRead, UINT *pBytesRead);
+        FRESULT write(const void *pData, UINT bytesToWrite, UINT *pBytesWritten);
+        FRESULT sync(void) { return f_sync(&mFile); }
+
+        DWORD size(void) const { return f_size(&mFile); }
+        DWORD tell(void) const { return f_tell(&mFile); }
+        bool isOpen(void) const { return mOpened; }
+
+    private:
+        IndexedFile(const IndexedFile&);            ///< Disallow copy
+        IndexedFile& operator=(const IndexedFile&); ///< Disallow assignment
+
+        FIL mFile;
+        ClusterMap mMap;
+        bool mOpened;
+};
+
+
+
 /**
  * Storage class contains the File System Objects
  *
@@ -65,10 +160,26 @@ class Storage
          * @param pReadTime         Optional: Provide pointer to get the time taken to read the file
          * @param pWriteTime        Optional: Provide pointer to get the time taken to write the file
          * @param pBytesTransferred Optional: Provide pointer to get number of bytes transferred
+         * @param pTotalTime        Optional: Provide pointer to get the time taken by the copy
+         *
+         * @note The file is read while the previous part of it is written by another task, so
+         *       the read and write times overlap and the total time can be less than their sum.
          */
         static FRESULT copy(const char* pExistingFile, const char* pNewFile,
                             unsigned int* pReadTime=0, unsigned int* pWriteTime=0,
-                            unsigned int* pBytesTransferred=0);
+                            unsigned int* pBytesTransferred=0, unsigned int* pTotalTime=0);
+
+        /**
+         * @{ File IO
+         * The files are kept open between the calls, so the chunks of a file that are read or
+         * written one after the other do not open the file and seek it each time.  The least
+         * recently used file is closed once STORAGE_CACHED_FILES files are open, and a file is
+         * closed when it is not used for STORAGE_IDLE_CLOSE_MS.  The file is synced after each
+         * write, so the file on the disk is complete as if it was closed.
+         *
+         * @warning A file that is removed, renamed, or re-written by other means than Storage
+         *          must be closed with close() first.
+         */
 
         /**
          * Reads an existing file
@@ -98,6 +209,32 @@ class Storage
          */
         static FRESULT append(const char* pFilename,void* pData, unsigned int bytesToAppend, unsigned int offset=0);
 
+        /**
+         * Closes the file kept open by read(), write() and append(), and forgets its cluster map
+         * @param pFilename  The filename, or NULL to close all of the files
+         */
+        static FRESULT close(const char* pFilename=0);
+        /** @} */
+
+        /**
+         * Opens a file that uses FatFs fast seek
+         * @param file       The file handle to open
+         * @param pFilename  The filename to open
+         * @param mode       The FatFs open mode, such as FA_OPEN_EXISTING | FA_READ
+         */
+        static FRESULT openIndexed(IndexedFile& file, const char* pFilename, BYTE mode)
+        {
+            return file.open(pFilename, mode);
+        }
+
+        /**
+         * Forgets the cluster map cached by read() and append(), which also closes the file.
+         * This must be called if a file is truncated, removed or re-written by
+         * other means than Storage or IndexedFile.
+         * @param pFilename  The filename, or NULL to forget all the cached maps
+         */
+        static void invalidateIndex(const char* pFilename=0) { close(pFilename); }
+
     private:
         /// Private constructor to restrict object creation
         Storage() {}
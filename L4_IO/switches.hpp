@@ -1,54 +1,118 @@
-/*
- *     SocialLedge.com - Copyright (C) 2013
- *
- *     This file is part of free software framework for embedded processors.
- *     You can use it and/or distribute it as long as this copyright header
- *     remains unmodified.  The code is free for personal use and requires
- *     permission to use in a commercial product.
- *
- *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
- *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
- *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
- *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
- *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
- *
- *     You can reach the author of this software at :
- *          p r e e t . w i k i @ g m a i l . c o m
- */
-
-/**
- * @file
- * @ingroup BoardIO
- */
-#ifndef SWITCHES_HPP__
-#define SWITCHES_HPP__
-#include <stdint.h>
-#include "singleton_template.hpp"
-
-
-
-/**
- * Switches class used to get switch values from on-board switches
- *
- * @ingroup BoardIO
- */
-class Switches : public SingletonTemplate<Switches>
-{
-    public:
-        bool init(); ///< Initializes this device, @returns true if successful
-
-        /// @returns The 8-bit char containing bit values of the 4 switches, 1 bit per switch
-        uint8_t getSwitchValues();
-
-        /**
-         * @param num   The switch number to test from 1-4
-         * @returns true if the switch is active, or false otherwise
-         */
-        bool getSwitch(int num);
-
-    private:
-        Switches() {}   ///< Private constructor of this Singleton class
-        friend class SingletonTemplate<Switches>;  ///< Friend class used for Singleton Template
-};
-
-#endif /* SWITCHES_HPP__ */
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @ingroup BoardIO
+ */
+#ifndef SWITCHES_HPP__
+#define SWITCHES_HPP__
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "singleton_template.hpp"
+#include "hw_timer.h"
+
+
+
+#define SWITCH_SCAN_MS              10      ///< The switches are sampled this often after the first subscribe()
+#define SWITCH_DEBOUNCE_SCANS       3       ///< The scans a switch must be stable to change its state
+#define SWITCH_LONG_PRESS_MS        1000    ///< The time a switch is held for the switch_long_press event
+#define SWITCH_MAX_SUBSCRIBERS      4       ///< The max number of queues given to subscribe()
+
+/// The type of a switch_event_t
+typedef enum {
+    switch_pressed,     ///< The switch was pressed
+    switch_released,    ///< The switch was released
+    switch_long_press,  ///< The switch is still pressed after SWITCH_LONG_PRESS_MS
+} switch_event_type_t;
+
+/// An event of a switch, sent to the queues of Switches::subscribe()
+typedef struct {
+    uint8_t num;            ///< The switch number from 1-4
+    uint8_t type;           ///< The switch_event_type_t
+    uint64_t timestamp_us;  ///< Uptime of the event
+} switch_event_t;
+
+/**
+ * Switches class used to get switch values from on-board switches
+ *
+ * The switches can be also delivered as debounced events, so the tasks do not poll them:
+ * @code
+ *      QueueHandle_t switchQueue = xQueueCreate(4, sizeof(switch_event_t));
+ *      SW.subscribe(switchQueue);
+ *
+ *      switch_event_t event;
+ *      if (xQueueReceive(switchQueue, &event, portMAX_DELAY) && switch_pressed == event.type) {
+ *          printf("Switch %u pressed\n", event.num);
+ *      }
+ * @endcode
+ *
+ * The switches are on port 1, which does not have the GPIO interrupts, so one timer of the
+ * timer service (@see hw_timer.h) reads all of them once every SWITCH_SCAN_MS, and a switch
+ * changes state after it is stable for SWITCH_DEBOUNCE_SCANS.  Nothing is sent to the queues
+ * unless a switch changes, and the event is sent from the timer interrupt, so the latency is
+ * at most the debounce time plus one scan.
+ *
+ * @ingroup BoardIO
+ */
+class Switches : public SingletonTemplate<Switches>
+{
+    public:
+        bool init(); ///< Initializes this device, @returns true if successful
+
+        /// @returns The 8-bit char containing bit values of the 4 switches, 1 bit per switch
+        uint8_t getSwitchValues();
+
+        /**
+         * @param num   The switch number to test from 1-4
+         * @returns true if the switch is active, or false otherwise
+         */
+        bool getSwitch(int num);
+
+        /**
+         * Sends the events of the switches to the queue of switch_event_t, and starts scanning
+         * the switches the first time.  This must be called from a task (or before the scheduler starts).
+         * @returns false if there are already SWITCH_MAX_SUBSCRIBERS queues
+         */
+        bool subscribe(QueueHandle_t queue);
+
+        /// @returns the events that were lost because a queue was full
+        uint32_t getEventDrops() const { return mEventDrops; }
+
+    private:
+        /// Private constructor of this Singleton class
+        Switches() : mNumSubs(0), mStable(0), mEventDrops(0), mScanning(false) {}
+
+        /// Callback of mScanTimer that debounces the switches, and sends their events
+        static void scanIsr(hw_timer_t *timer, void *arg);
+        /// Sends the event to every queue from the interrupt
+        void sendFromIsr(uint8_t num, switch_event_type_t type, long *pWoken);
+
+        QueueHandle_t mSubs[SWITCH_MAX_SUBSCRIBERS];    ///< The queues of subscribe()
+        uint8_t mNumSubs;                               ///< The number of mSubs[] used
+        uint8_t mStable;                                ///< The debounced switch values
+        uint8_t mChangeScans[4];                        ///< The scans that each switch differs from mStable
+        uint16_t mHeldScans[4];                         ///< The scans that each switch has been pressed
+        uint32_t mEventDrops;                           ///< The events lost because a queue was full
+        bool mScanning;                                 ///< Set once mScanTimer is started
+        hw_timer_t mScanTimer;                          ///< Scans the switches
+        friend class SingletonTemplate<Switches>;  ///< Friend class used for Singleton Template
+};
+
+#endif /* SWITCHES_HPP__ */
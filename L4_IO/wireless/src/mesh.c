@@ -16,6 +16,7 @@
  *          p r e e t . w i k i @ g m a i l . c o m
  */
 #include "mesh.h"
+#include "timer_wheel.h"
 #include <string.h>   // memcpy(), memset(), strncpy()
 #include <stdarg.h>
 #include <stdlib.h>
@@ -35,6 +36,15 @@
 #if (MESH_MAX_PEND_PKTS < 2)
 #error "Max pending packets should be 2 or more"
 #endif
+#if (MESH_TX_QUEUE_SIZE > 255)
+#error "MESH_TX_QUEUE_SIZE cannot be greater than 255"
+#endif
+#if (MESH_ACK_TIMEOUT_MAX_MS > 32767 || MESH_ACK_TIMEOUT_MIN_MS < 1)
+#error "MESH_ACK_TIMEOUT_MAX_MS must fit the 15-bit timeout of the pending packets, and minimum must not be zero"
+#endif
+#if (MESH_PKT_HISTORY_SIZE < 2 || MESH_PKT_HISTORY_SIZE > 128 || (MESH_PKT_HISTORY_SIZE & (MESH_PKT_HISTORY_SIZE - 1)))
+#error "MESH_PKT_HISTORY_SIZE must be a power of 2 between 2 and 128"
+#endif
 /** @} */
 
 /** If debug not defined, define it to empty to be able to compile */
@@ -52,26 +62,58 @@
  * avoid duplicate packet handling.
  */
 typedef struct {
-    uint8_t src;     ///< Sender address
-    uint8_t pkt_id;  ///< Sender's packet id (sequence)
-    uint8_t retries; ///< Packet retry count
+    uint8_t src;      ///< Sender address, zero if the entry is free
+    uint8_t pkt_id;   ///< Sender's packet id (sequence)
+    uint8_t retries;  ///< Packet retry count
+    uint32_t time_ms; ///< The time this packet was first received
 } __attribute__((packed)) mesh_pkt_history_t ;
 
 /**
  * Mesh Pending packet type
- * Only 16-bit timer is needed which can supply up to 65,535ms
- * value, which is far above a useful mesh packet retry value
+ * The retry timeout of each pending packet is a timer of g_pnd_wheel, which is the timer
+ * of the same index in g_mesh_pnd_timers[] or g_our_pnd_timers[].
  */
 typedef struct {
     mesh_packet_t pkt;        ///< The packet itself
-    uint16_t timer_ms;        ///< Running time.  MUST BE UINT16 due to hard-coded usage of UINT16_MAX.
-    uint16_t timeout_ms : 15; ///< Target time when timer expires.  We don't need a lot of bits for this.
-    uint16_t disc_pkt : 1;    ///< Flag if this is a route discovery packet.
+    uint32_t sent_ms;         ///< The time the packet was last sent, which gives its round trip time
+    uint16_t timeout_ms : 15; ///< Time after sent_ms when timer expires.  We don't need a lot of bits for this.
+    uint16_t disc_pkt : 1;    ///< Flag if this is a route discovery or a broadcast packet we repeat.
+    uint8_t copies;           ///< Copies of the discovery or broadcast packet we heard so far
 } __attribute__((packed)) mesh_pnd_pkt_t;
 
+/**
+ * Our packet waiting for a free slot of g_our_pnd_pkts[]
+ * @see MESH_TX_QUEUE_SIZE
+ */
+typedef struct {
+    mesh_packet_t pkt;        ///< The formed packet, nwk.dst is zero if the entry is free
+    uint8_t prio;             ///< The priority of the packet @see mesh_prio_t
+    uint16_t order;           ///< The order the packet was queued, which keeps a destination's packets in order
+} __attribute__((packed)) mesh_queued_pkt_t;
+
+/**
+ * Neighbor type, which measures the delivery ratio of the link from the beacons
+ * @see MESH_BEACON_INTERVAL_MS
+ */
+typedef struct {
+    uint8_t node;        ///< Neighbor address, zero if the entry is free
+    uint8_t last_seq;    ///< Sequence number of the last beacon counted from the neighbor
+    uint8_t fwd_ratio;   ///< Ratio (x/255) of our beacons the neighbor received, zero if not reported
+    uint8_t heard  : 1;  ///< Flag if a beacon of the neighbor was received since our last beacon
+    uint8_t missed : 7;  ///< Number of our beacons sent since the neighbor was last heard
+    uint16_t rx_mask;    ///< Beacons received from the neighbor, bit 0 being the one of last_seq
+    uint8_t span;        ///< Number of beacons of rx_mask that count (up to MESH_BEACON_WINDOW)
+} __attribute__((packed)) mesh_nbr_t;
+
+/// ETX in 1/16 units of a perfect link, such that a route's cost is 16 per hop
+#define MESH_ETX_ONE  16
+
 /// Macro to get size of array
 #define MESH_ARRAY_SIZEOF(x)  (sizeof(x) / sizeof(x[0]))
 
+/// Number of consecutive history slots searched from the hashed slot of a packet
+#define MESH_PKT_HISTORY_PROBES  4
+
 
 
 /*************************************************************************/
@@ -84,22 +126,49 @@ static uint8_t g_our_node_id = 1;        ///< Our Node ID
 static uint8_t g_retry_count = 2;        ///< Number of retries for ACK packet
 static mesh_driver_t g_driver = { 0 };   ///< Radio send/recv functions
 static mesh_error_mask_t g_error_mask = mesh_err_none;
+static uint32_t g_prev_time_ms = 0;      ///< The time of the last call to mesh_update_time()
+static uint32_t g_flood_rand = 1;        ///< Random state of the hold-off of the flood repeats and beacons
+static uint8_t g_pkt_seq_num = 0;        ///< Sequence number of our last packet
 
 static char g_our_name[MESH_DATA_PAYLOAD_SIZE] = { 0 };        ///< Name of our name used for PING response
 static mesh_rte_table_t g_rte_table[MESH_MAX_NODES];           ///< Our routing table entries
-static mesh_pkt_history_t g_pkt_hist[MESH_MAX_NODES];          ///< Our packet history
-static mesh_pkt_history_t *g_pkt_hist_wptr = &(g_pkt_hist[0]); ///< Packet history write pointer (circular write)
+static uint8_t g_rte_index[256];                               ///< Routing table index of each node address
+static mesh_pkt_history_t g_pkt_hist[MESH_PKT_HISTORY_SIZE];   ///< Our packet history (hash table)
 static mesh_pnd_pkt_t g_mesh_pnd_pkts[MESH_MAX_NODES];         ///< Pending packets of other mesh nodes
 static mesh_pnd_pkt_t g_our_pnd_pkts[MESH_MAX_PEND_PKTS];      ///< Pending packets sent by us
+#if (MESH_TX_QUEUE_SIZE > 0)
+static mesh_queued_pkt_t g_tx_queue[MESH_TX_QUEUE_SIZE];       ///< Our packets waiting for g_our_pnd_pkts[]
+static uint16_t g_tx_queue_order = 0;                          ///< The order of the last packet queued
+#endif
+
+static timer_wheel_t g_pnd_wheel;                                   ///< The retry timeouts of the pending packets
+static timer_wheel_timer_t g_mesh_pnd_timers[MESH_MAX_NODES];      ///< Timer of each of g_mesh_pnd_pkts[]
+static timer_wheel_timer_t g_our_pnd_timers[MESH_MAX_PEND_PKTS];   ///< Timer of each of g_our_pnd_pkts[]
+static mesh_pnd_pkt_t *g_expired_pnd_pkts[MESH_MAX_NODES + MESH_MAX_PEND_PKTS]; ///< Expired during mesh_service()
+static uint16_t g_expired_pnd_pkts_count = 0;                       ///< Entries of g_expired_pnd_pkts[]
+
+#if (MESH_BEACON_INTERVAL_MS > 0)
+static mesh_nbr_t g_nbrs[MESH_MAX_NEIGHBORS];  ///< Our neighbors heard through their beacons
+static uint32_t g_beacon_due_ms = 0;           ///< The time we send our next beacon
+static uint8_t g_beacon_seq = 0;               ///< Sequence number of our last beacon
+static const uint8_t g_nbrs_size = MESH_ARRAY_SIZEOF(g_nbrs);
+#endif
 
 static const uint8_t g_rte_tbl_size       = MESH_ARRAY_SIZEOF(g_rte_table);
 static const uint8_t g_pkt_history_size   = MESH_ARRAY_SIZEOF(g_pkt_hist);
 static const uint8_t g_mesh_pnd_pkts_size = MESH_ARRAY_SIZEOF(g_mesh_pnd_pkts);
 static const uint8_t g_our_pnd_pkts_size  = MESH_ARRAY_SIZEOF(g_our_pnd_pkts);
+#if (MESH_TX_QUEUE_SIZE > 0)
+static const uint8_t g_tx_queue_size      = MESH_ARRAY_SIZEOF(g_tx_queue);
+#endif
 
 #if MESH_USE_STATISTICS
 static mesh_stats_t g_mesh_stats = { 0 };
 #endif
+#if MESH_USE_LINK_STATISTICS
+static mesh_link_stats_t g_link_stats[MESH_LINK_STATS_SIZE];   ///< Statistics of each node
+static const uint8_t g_link_stats_size = MESH_ARRAY_SIZEOF(g_link_stats);
+#endif
 
 
 
@@ -117,44 +186,210 @@ static inline bool mesh_is_same_packet(const mesh_packet_t *p1, const mesh_packe
 static uint8_t mesh_get_next_seq_num(void)
 {
     /* Generate unique packet sequence number */
-    static uint8_t s_next_packet_id = 0;
-    return ++s_next_packet_id;
+    return ++g_pkt_seq_num;
+}
+
+/// @returns the timer of the pending packet
+static timer_wheel_timer_t* mesh_get_pnd_timer(const mesh_pnd_pkt_t *pnd)
+{
+    if (pnd >= &g_our_pnd_pkts[0] && pnd < &g_our_pnd_pkts[g_our_pnd_pkts_size]) {
+        return &g_our_pnd_timers[pnd - &g_our_pnd_pkts[0]];
+    }
+    return &g_mesh_pnd_timers[pnd - &g_mesh_pnd_pkts[0]];
 }
 
-static void mesh_incr_soft_timers_for_arr(mesh_pnd_pkt_t *arr, const uint8_t arr_size, const uint32_t delta_time)
+/// Callback of the timer of a pending packet, which is handled after the timers are serviced
+static void mesh_pnd_timer_expired(timer_wheel_timer_t *timer, void *arg)
+{
+    (void) timer;
+    if (g_expired_pnd_pkts_count < MESH_ARRAY_SIZEOF(g_expired_pnd_pkts)) {
+        g_expired_pnd_pkts[g_expired_pnd_pkts_count++] = (mesh_pnd_pkt_t*) arg;
+    }
+}
+
+/// Initializes the timers of the pending packets, none of which are started
+static void mesh_init_pnd_timers(void)
 {
-    uint32_t timer = 0;
     uint8_t i = 0;
 
-    for (i = 0; i < arr_size; i++) {
-        if (MESH_ZERO_ADDR != arr[i].pkt.nwk.dst) {
-            /* Check if adding delta will overflow uint16, if so, set it to max value */
-            timer = arr[i].timer_ms;
-            timer += delta_time;
-            arr[i].timer_ms = (timer <= UINT16_MAX) ? timer : UINT16_MAX;
-        }
+    timer_wheel_init(&g_pnd_wheel, g_prev_time_ms);
+    for (i = 0; i < g_mesh_pnd_pkts_size; i++) {
+        timer_wheel_timer_init(&g_mesh_pnd_timers[i], mesh_pnd_timer_expired, &g_mesh_pnd_pkts[i]);
     }
+    for (i = 0; i < g_our_pnd_pkts_size; i++) {
+        timer_wheel_timer_init(&g_our_pnd_timers[i], mesh_pnd_timer_expired, &g_our_pnd_pkts[i]);
+    }
+    g_expired_pnd_pkts_count = 0;
+}
+
+/// Starts the retry timeout of the pending packet from now
+static void mesh_start_pnd_timer(mesh_pnd_pkt_t *pnd)
+{
+    pnd->sent_ms = g_prev_time_ms;
+    timer_wheel_start(&g_pnd_wheel, mesh_get_pnd_timer(pnd), g_prev_time_ms, pnd->timeout_ms);
+}
+
+/// @returns true if the retry timeout of the pending packet has expired
+static inline bool mesh_is_pnd_pkt_timed_out(const mesh_pnd_pkt_t *pnd)
+{
+    return !timer_wheel_is_active(mesh_get_pnd_timer(pnd));
+}
+
+/// @returns the time since the pending packet was last sent
+static inline uint32_t mesh_get_pnd_pkt_elapsed_ms(const mesh_pnd_pkt_t *pnd)
+{
+    return (g_prev_time_ms - pnd->sent_ms);
+}
+
+/// Frees the pending packet entry, and stops its timer
+static void mesh_clear_pnd_pkt(mesh_pnd_pkt_t *pnd)
+{
+    timer_wheel_stop(mesh_get_pnd_timer(pnd));
+    memset(pnd, 0, sizeof(*pnd));
+}
+
+/// @returns a pseudo random number (0-32767) that differs for each node address
+static inline uint16_t mesh_get_random(void)
+{
+    g_flood_rand = (g_flood_rand * 1103515245) + 12345;
+    return (g_flood_rand >> 16) & 0x7FFF;
 }
 
 /**
- * Handles the software timers used for packet retry timeout.
- * If a packet is pending, its timer is incremented by the delta computed
- * from the last time this function is called.
+ * @returns the random hold-off of repeating a route discovery or a broadcast packet, so the
+ * nodes that heard the same packet do not repeat it at the same time.
  */
-static bool mesh_update_soft_timers(void)
+static uint16_t mesh_get_flood_timeout(void)
+{
+    return MESH_PKT_DISC_TIMEOUT_MS + (mesh_get_random() % (MESH_FLOOD_JITTER_MS + 1));
+}
+
+/**
+ * Counts a copy of a flood packet that another node repeated, and cancels our pending
+ * repeat of the packet once we heard MESH_FLOOD_COPIES_MAX copies of it.
+ */
+static void mesh_flood_copy_heard(const mesh_packet_t *pRxPkt)
+{
+    #if (MESH_FLOOD_COPIES_MAX > 0)
+    uint8_t i = 0;
+    for (i = 0; i < g_mesh_pnd_pkts_size; i++) {
+        mesh_pnd_pkt_t *pnd = &g_mesh_pnd_pkts[i];
+        if (pnd->disc_pkt && MESH_ZERO_ADDR != pnd->pkt.nwk.dst &&
+            mesh_is_same_packet(pRxPkt, &(pnd->pkt)) &&
+            ++(pnd->copies) >= MESH_FLOOD_COPIES_MAX)
+        {
+            MESH_DEBUG_PRINTF("SUPPRESS FLOOD PKT NWK %i/%i: HEARD %i COPIES",
+                              pnd->pkt.nwk.src, pnd->pkt.nwk.dst, pnd->copies);
+            mesh_clear_pnd_pkt(pnd);
+        }
+    }
+    #else
+    (void) pRxPkt;
+    #endif
+}
+
+/// Updates g_prev_time_ms from the timer of the driver
+static bool mesh_update_time(void)
 {
-    static uint32_t s_prev_time_ms = 0;
     uint32_t time_now_ms = 0;
     const bool ok = g_driver.get_timer(&time_now_ms, sizeof(time_now_ms));
-    const uint32_t delta = (time_now_ms - s_prev_time_ms);
 
-    s_prev_time_ms = time_now_ms;
-    mesh_incr_soft_timers_for_arr(&g_mesh_pnd_pkts[0], g_mesh_pnd_pkts_size, delta);
-    mesh_incr_soft_timers_for_arr(&g_our_pnd_pkts[0],  g_our_pnd_pkts_size,  delta);
+    g_prev_time_ms = time_now_ms;
     return ok;
 }
 
-static inline bool mesh_send_packet(mesh_packet_t *pkt)
+/**
+ * Handles the software timers used for packet retry timeout.
+ * Only the timers that expired since the last call are touched, and their pending
+ * packets are added to g_expired_pnd_pkts[].
+ */
+static bool mesh_update_soft_timers(void)
+{
+    const bool ok = mesh_update_time();
+    timer_wheel_service(&g_pnd_wheel, g_prev_time_ms);
+    return ok;
+}
+
+#if MESH_USE_LINK_STATISTICS
+/// Events counted by mesh_link_stats_count()
+typedef enum {
+    mesh_link_failed,
+    mesh_link_duplicate,
+    mesh_link_queue_drop,
+    mesh_link_route_change,
+} mesh_link_event_t;
+
+/**
+ * @returns the statistics entry of the node, or NULL for the zero and broadcast address.
+ * If the node has no entry, the free entry or the entry with the fewest packets is reused.
+ */
+static mesh_link_stats_t* mesh_get_link_stats_entry(const uint8_t node)
+{
+    mesh_link_stats_t *entry = NULL;
+    uint8_t i = 0;
+
+    if (MESH_ZERO_ADDR == node || MESH_BROADCAST_ADDR == node) {
+        return NULL;
+    }
+
+    for (i = 0; i < g_link_stats_size; i++) {
+        if (node == g_link_stats[i].node) {
+            return &g_link_stats[i];
+        }
+        if (NULL == entry || MESH_ZERO_ADDR == g_link_stats[i].node ||
+            (MESH_ZERO_ADDR != entry->node &&
+             (g_link_stats[i].pkts_acked + g_link_stats[i].pkts_failed) < (entry->pkts_acked + entry->pkts_failed)))
+        {
+            entry = &g_link_stats[i];
+        }
+    }
+
+    memset(entry, 0, sizeof(*entry));
+    entry->node = node;
+    return entry;
+}
+
+static void mesh_link_stats_count(const uint8_t node, const mesh_link_event_t event)
+{
+    mesh_link_stats_t *entry = mesh_get_link_stats_entry(node);
+
+    if (NULL != entry) {
+        switch (event) {
+            case mesh_link_failed:       entry->pkts_failed++;   break;
+            case mesh_link_duplicate:    entry->duplicates++;    break;
+            case mesh_link_queue_drop:   entry->queue_drops++;   break;
+            case mesh_link_route_change: entry->route_changes++; break;
+        }
+    }
+}
+
+/**
+ * Counts our acknowledged packet to the node.
+ * @param retries_rem  The retries that were remaining
+ * @param rtt_ms       The round trip time, or UINT32_MAX if unknown or the packet was retried
+ */
+static void mesh_link_stats_acked(const uint8_t node, const uint8_t retries_rem, const uint32_t rtt_ms)
+{
+    mesh_link_stats_t *entry = mesh_get_link_stats_entry(node);
+    const uint8_t retries = (g_retry_count > retries_rem) ? (g_retry_count - retries_rem) : 0;
+    uint8_t bin = 0;
+
+    if (NULL != entry) {
+        entry->pkts_acked++;
+        entry->retry_hist[(retries < MESH_LINK_RETRY_BINS) ? retries : (MESH_LINK_RETRY_BINS - 1)]++;
+
+        if (UINT32_MAX != rtt_ms) {
+            while ((bin + 1) < MESH_LINK_RTT_BINS && (rtt_ms >> (bin + 1))) {
+                bin++;
+            }
+            entry->rtt_hist[bin]++;
+        }
+    }
+}
+#endif
+
+/// @returns the return value of the radio_send() of the driver
+static inline int mesh_send_packet(mesh_packet_t *pkt)
 {
     #if MESH_USE_STATISTICS
     /* If we are not the source, then we must be repeating the packet */
@@ -168,10 +403,19 @@ static inline bool mesh_send_packet(mesh_packet_t *pkt)
 
     MESH_DEBUG_PRINTF("SEND TO %i THRU %i MAX HOPS %i", pkt->nwk.dst, pkt->mac.dst, pkt->info.hop_count_max);
     pkt->mac.src = g_our_node_id;
-    return (g_driver.radio_send((void*)pkt, sizeof(*pkt)));
+
+    /* Only the header and the data is sent, so the radio can send a shorter packet.
+     * The data beyond MESH_DATA_PAYLOAD_SIZE only fits the compact header of a direct packet,
+     * so such a packet cannot be sent once its route goes through a repeater.
+     */
+    const uint8_t data_len = (pkt->info.data_len <= sizeof(pkt->data)) ? pkt->info.data_len : sizeof(pkt->data);
+    if (data_len > MESH_DATA_PAYLOAD_SIZE && !mesh_pkt_is_compact(pkt)) {
+        return 0;
+    }
+    return (g_driver.radio_send((void*)pkt, MESH_PAYLOAD_HEADER_SIZE + data_len));
 }
 
-static void mesh_send_retry_packet(mesh_packet_t *pkt)
+static int mesh_send_retry_packet(mesh_packet_t *pkt)
 {
     #if MESH_USE_STATISTICS
     if (pkt->nwk.src == g_our_node_id) {
@@ -183,22 +427,33 @@ static void mesh_send_retry_packet(mesh_packet_t *pkt)
     #endif
 
     pkt->info.retries_rem--;
-    mesh_send_packet(pkt);
+    return mesh_send_packet(pkt);
 }
 
 /**
  * Gets the routing table entry based on destination ID.
  * If destination ID is not found in the table, NULL entry is returned
+ *
+ * g_rte_index[] remembers where each address was last found, so a known route
+ * is found without searching the table.  The index is only a hint that is checked
+ * against the table, so the table can still be written without updating the index.
  */
 static mesh_rte_table_t* mesh_find_rte_tbl_entry(const uint8_t dst_id)
 {
-    uint8_t i = 0;
+    uint8_t i = g_rte_index[dst_id];
     mesh_rte_table_t *entry = NULL;
 
-    for (i = 0; i < g_rte_tbl_size; i++) {
-        if (dst_id == g_rte_table[i].dst) {
-            entry = &g_rte_table[i];
-            break;
+    /* Free entries (MESH_ZERO_ADDR) are always searched to get the first free entry */
+    if (MESH_ZERO_ADDR != dst_id && i < g_rte_tbl_size && dst_id == g_rte_table[i].dst) {
+        entry = &g_rte_table[i];
+    }
+    else {
+        for (i = 0; i < g_rte_tbl_size; i++) {
+            if (dst_id == g_rte_table[i].dst) {
+                entry = &g_rte_table[i];
+                g_rte_index[dst_id] = i;
+                break;
+            }
         }
     }
 
@@ -221,6 +476,8 @@ static mesh_rte_table_t* mesh_get_rte_to_modify(const uint8_t dst_id)
     /* No entry found with dst_id, so find empty entry */
     if (NULL == entry) {
         entry = mesh_find_rte_tbl_entry(MESH_ZERO_ADDR);
+        /* The caller takes this entry for dst_id, so index it for the next lookup */
+        g_rte_index[dst_id] = (uint8_t) (entry ? (entry - &g_rte_table[0]) : 0);
 
         /* No free routing entries, over-write least used entry */
         if (NULL == entry) {
@@ -233,6 +490,7 @@ static mesh_rte_table_t* mesh_get_rte_to_modify(const uint8_t dst_id)
                 }
             }
             memset(entry, 0, sizeof(*entry));
+            g_rte_index[dst_id] = (uint8_t) (entry - &g_rte_table[0]);
 
             #if MESH_USE_STATISTICS
             g_mesh_stats.rte_overwritten++;
@@ -277,6 +535,327 @@ static void mesh_update_rte_scores(mesh_rte_table_t *entry)
     }
 }
 
+/**
+ * Removes the routes whose next hop is the given node, so these routes are discovered again.
+ */
+static void mesh_remove_rtes_through(const uint8_t next_hop)
+{
+    uint8_t i = 0;
+    for (i = 0; i < g_rte_tbl_size; i++) {
+        if (MESH_ZERO_ADDR != g_rte_table[i].dst && next_hop == g_rte_table[i].next_hop) {
+            memset(&g_rte_table[i], 0, sizeof(g_rte_table[i]));
+        }
+    }
+}
+
+#if (MESH_BEACON_INTERVAL_MS > 0)
+/// @returns the neighbor entry of the node, or NULL if it is not our neighbor
+static mesh_nbr_t* mesh_find_nbr(const uint8_t node)
+{
+    uint8_t i = 0;
+    for (i = 0; i < g_nbrs_size; i++) {
+        if (node == g_nbrs[i].node) {
+            return &g_nbrs[i];
+        }
+    }
+    return NULL;
+}
+
+/// @returns the ratio (x/255) of the beacons we received from the neighbor
+static uint8_t mesh_get_nbr_rx_ratio(const mesh_nbr_t *nbr)
+{
+    const uint16_t window = (uint16_t) ((1UL << MESH_BEACON_WINDOW) - 1);
+    uint16_t mask = nbr->rx_mask & window;
+    uint8_t count = 0;
+
+    for ( ; 0 != mask; mask >>= 1) {
+        count += (mask & 1);
+    }
+    return (nbr->span > 0) ? (uint8_t) ((count * 255U) / nbr->span) : 0;
+}
+
+/**
+ * Shifts the given number of beacons into the receive mask of the neighbor.
+ * @param received  If true, the last of these beacons was received, otherwise all are lost.
+ */
+static void mesh_shift_nbr_beacons(mesh_nbr_t *nbr, const uint8_t count, const bool received)
+{
+    nbr->rx_mask = (count < 16) ? (nbr->rx_mask << count) : 0;
+    nbr->rx_mask |= received ? 1 : 0;
+    nbr->span = (nbr->span + count < MESH_BEACON_WINDOW) ? (nbr->span + count) : MESH_BEACON_WINDOW;
+    nbr->last_seq += count;
+}
+
+/**
+ * Handles the beacon of a neighbor.  The beacon's data is the list of the neighbors that
+ * sender hears, and the ratio of their beacons it received, which includes the ratio of ours.
+ */
+static void mesh_handle_beacon(const mesh_packet_t *pPkt)
+{
+    const uint8_t node = pPkt->mac.src;
+    mesh_nbr_t *nbr = mesh_find_nbr(node);
+    uint8_t i = 0;
+
+    /* A new neighbor takes a free entry, or the entry with the lowest delivery ratio */
+    if (NULL == nbr) {
+        nbr = mesh_find_nbr(MESH_ZERO_ADDR);
+        if (NULL == nbr) {
+            nbr = &g_nbrs[0];
+            for (i = 1; i < g_nbrs_size; i++) {
+                if (mesh_get_nbr_rx_ratio(&g_nbrs[i]) < mesh_get_nbr_rx_ratio(nbr)) {
+                    nbr = &g_nbrs[i];
+                }
+            }
+            mesh_remove_rtes_through(nbr->node);
+        }
+        memset(nbr, 0, sizeof(*nbr));
+        nbr->node = node;
+        nbr->last_seq = pPkt->info.pkt_seq_num - 1;
+    }
+
+    /* A beacon counted as lost by mesh_age_nbrs() may still arrive, since the intervals
+     * of two nodes are not the same, so such a beacon is counted as received instead.
+     */
+    const uint8_t gap = pPkt->info.pkt_seq_num - nbr->last_seq;
+    if (gap > 0 && gap < 128) {
+        mesh_shift_nbr_beacons(nbr, gap, true);
+    }
+    else {
+        nbr->rx_mask |= 1;
+        nbr->last_seq = pPkt->info.pkt_seq_num;
+    }
+    nbr->heard = 1;
+    nbr->missed = 0;
+
+    /* Find how much of our beacons this neighbor received */
+    nbr->fwd_ratio = 0;
+    for (i = 0; i + 1 < pPkt->info.data_len && i + 1 < sizeof(pPkt->data); i += 2) {
+        if (g_our_node_id == pPkt->data[i]) {
+            nbr->fwd_ratio = pPkt->data[i + 1];
+            break;
+        }
+    }
+}
+
+/**
+ * Counts a lost beacon of each neighbor not heard since our last beacon, and drops the
+ * neighbors that missed MESH_BEACON_LOSS_MAX beacons along with their routes.
+ */
+static void mesh_age_nbrs(void)
+{
+    uint8_t i = 0;
+    for (i = 0; i < g_nbrs_size; i++) {
+        mesh_nbr_t *nbr = &g_nbrs[i];
+        if (MESH_ZERO_ADDR == nbr->node) {
+            continue;
+        }
+
+        if (nbr->heard) {
+            nbr->heard = 0;
+        }
+        else if (++(nbr->missed) >= MESH_BEACON_LOSS_MAX) {
+            MESH_DEBUG_PRINTF("NEIGHBOR %i LOST", nbr->node);
+            mesh_remove_rtes_through(nbr->node);
+            memset(nbr, 0, sizeof(*nbr));
+        }
+        else {
+            mesh_shift_nbr_beacons(nbr, 1, false);
+        }
+    }
+}
+
+/// Sends our beacon if it is due, see MESH_BEACON_INTERVAL_MS
+static void mesh_beacon_service(void)
+{
+    mesh_packet_t pkt;
+    uint8_t i = 0;
+
+    if ((int32_t) (g_prev_time_ms - g_beacon_due_ms) < 0) {
+        return;
+    }
+    g_beacon_due_ms = g_prev_time_ms + (MESH_BEACON_INTERVAL_MS * 3 / 4) +
+                      (mesh_get_random() % (MESH_BEACON_INTERVAL_MS / 2 + 1));
+    mesh_age_nbrs();
+
+    /* The beacon is addressed to nobody, such that it is not routed or repeated */
+    memset(&pkt, 0, sizeof(pkt));
+    pkt.info.version = MESH_VERSION;
+    pkt.info.pkt_type = mesh_pkt_nack;
+    pkt.info.retries_rem = g_retry_count;
+    pkt.info.pkt_seq_num = ++g_beacon_seq;
+    pkt.nwk.src = pkt.mac.src = g_our_node_id;
+    pkt.nwk.dst = MESH_ZERO_ADDR;
+    pkt.mac.dst = MESH_BROADCAST_ADDR;
+
+    for (i = 0; i < g_nbrs_size && pkt.info.data_len + 2 <= MESH_DATA_PAYLOAD_SIZE; i++) {
+        if (MESH_ZERO_ADDR != g_nbrs[i].node) {
+            pkt.data[pkt.info.data_len++] = g_nbrs[i].node;
+            pkt.data[pkt.info.data_len++] = mesh_get_nbr_rx_ratio(&g_nbrs[i]);
+        }
+    }
+
+    g_driver.radio_send(&pkt, MESH_PAYLOAD_HEADER_SIZE + pkt.info.data_len);
+}
+#endif
+
+/**
+ * @returns the ETX of the link to the neighbor in 1/16 units (MESH_ETX_ONE is a perfect link).
+ * A node whose beacons were not heard counts as a perfect link, which makes the routes of
+ * the nodes without beacons compare by their number of hops.
+ */
+static uint16_t mesh_get_link_etx_x16(const uint8_t node)
+{
+    #if (MESH_BEACON_INTERVAL_MS > 0)
+    const mesh_nbr_t *nbr = mesh_find_nbr(node);
+    if (NULL != nbr) {
+        const uint32_t rev = mesh_get_nbr_rx_ratio(nbr);
+        /* The neighbor did not report our beacons yet, so the link is assumed symmetric */
+        const uint32_t fwd = (0 != nbr->fwd_ratio) ? nbr->fwd_ratio : rev;
+        const uint32_t etx = (0 == rev) ? UINT16_MAX : ((MESH_ETX_ONE * 255UL * 255UL) / (fwd * rev));
+        return (etx < UINT16_MAX) ? (uint16_t) etx : UINT16_MAX;
+    }
+    #else
+    (void) node;
+    #endif
+    return MESH_ETX_ONE;
+}
+
+/**
+ * @returns the expected transmissions (1/16 units) of a route, which is the ETX of its next
+ * hop, and one transmission for each of the hops after it.
+ */
+static inline uint32_t mesh_get_rte_cost(const uint8_t next_hop, const uint8_t num_hops)
+{
+    return (uint32_t) mesh_get_link_etx_x16(next_hop) + ((uint32_t) num_hops * MESH_ETX_ONE);
+}
+
+/**
+ * @returns true if the radio hardware of the destination acknowledged our ACK packet.
+ * This only applies to our packet sent directly to its destination (without repeater).
+ */
+static inline bool mesh_is_radio_acked(const mesh_packet_t *pkt, const int radio_status)
+{
+    return (MESH_RADIO_SEND_ACKED == radio_status &&
+            mesh_pkt_ack == pkt->info.pkt_type &&
+            g_our_node_id == pkt->nwk.src &&
+            pkt->nwk.dst == pkt->mac.dst);
+}
+
+/**
+ * Our ACK packet was acknowledged by the radio hardware of its destination, so the
+ * destination does not send the ACK_RSP packet.  We give the application the ACK_RSP
+ * packet (without data) that it would have received, and nothing is left pending.
+ */
+static void mesh_handle_radio_ack(const mesh_packet_t *pkt)
+{
+    mesh_packet_t rsp;
+    memset(&rsp, 0, sizeof(rsp));
+
+    rsp.info.version = MESH_VERSION;
+    rsp.info.pkt_type = mesh_pkt_ack_rsp;
+    rsp.info.pkt_seq_num = pkt->info.pkt_seq_num;
+    rsp.nwk.src = rsp.mac.src = pkt->nwk.dst;
+    rsp.nwk.dst = rsp.mac.dst = g_our_node_id;
+
+    MESH_DEBUG_PRINTF("RADIO ACK FROM %i", pkt->nwk.dst);
+    mesh_update_rte_scores(mesh_find_rte_tbl_entry(pkt->nwk.dst));
+    #if MESH_USE_LINK_STATISTICS
+    mesh_link_stats_acked(pkt->nwk.dst, pkt->info.retries_rem, UINT32_MAX);
+    #endif
+    if (!g_driver.app_recv(&rsp, sizeof(rsp))) {
+        g_error_mask |= mesh_err_app_recv;
+    }
+}
+
+/**
+ * Sets the route of a routing table entry.
+ * The measured round trip time no longer applies if the route has changed.
+ */
+static void mesh_set_route(mesh_rte_table_t *entry, const uint8_t dst, const uint8_t next_hop, const uint8_t num_hops)
+{
+    if (entry->next_hop != next_hop || entry->num_hops != num_hops) {
+        entry->srtt_x8 = 0;
+        entry->rttvar_x4 = 0;
+
+        /* A new routing entry (without a next hop) is not a change of the route */
+        #if MESH_USE_LINK_STATISTICS
+        if (dst == entry->dst && MESH_ZERO_ADDR != entry->next_hop) {
+            mesh_link_stats_count(dst, mesh_link_route_change);
+        }
+        #endif
+    }
+    entry->dst = dst;
+    entry->next_hop = next_hop;
+    entry->num_hops = num_hops;
+}
+
+/**
+ * Updates the smoothed round trip time and its variation of a route (RFC 6298).
+ * Both are kept as scaled integers such that the gains of 1/8 and 1/4 are just shifts.
+ * @param entry   The routing entry, NULL means a NOP
+ * @param rtt_ms  The round trip time of a packet that was not retried
+ */
+static void mesh_update_rte_rtt(mesh_rte_table_t *entry, uint32_t rtt_ms)
+{
+    int32_t delta = 0;
+
+    if (NULL == entry) {
+        return;
+    }
+
+    /* Zero is reserved to mark an unmeasured route */
+    if (0 == rtt_ms) {
+        rtt_ms = 1;
+    }
+    else if (rtt_ms > MESH_ACK_TIMEOUT_MAX_MS) {
+        rtt_ms = MESH_ACK_TIMEOUT_MAX_MS;
+    }
+
+    if (0 == entry->srtt_x8) {
+        entry->srtt_x8 = (uint16_t) (rtt_ms << 3);
+        entry->rttvar_x4 = (uint16_t) (rtt_ms << 1);
+    }
+    else {
+        delta = (int32_t) rtt_ms - (entry->srtt_x8 >> 3);
+        entry->srtt_x8 = (uint16_t) (entry->srtt_x8 + delta);
+        if (delta < 0) {
+            delta = -delta;
+        }
+        entry->rttvar_x4 = (uint16_t) (entry->rttvar_x4 + delta - (entry->rttvar_x4 >> 2));
+    }
+}
+
+/**
+ * @returns The time to wait for the ACK of a packet sent through the given route.
+ * Once the round trip time of the route is measured, the timeout is the smoothed round
+ * trip time plus four times its variation, otherwise it is based on the number of hops.
+ *
+ * @param entry     The routing entry, which can be NULL if the route is not known
+ * @param num_hops  The number of hops to use if the round trip time is not known
+ */
+static uint32_t mesh_get_ack_timeout(const mesh_rte_table_t *entry, const uint8_t num_hops)
+{
+    uint32_t timeout = (1 + num_hops) * MESH_ACK_TIMEOUT_MS;
+
+    if (NULL != entry && 0 != entry->srtt_x8) {
+        timeout = (entry->srtt_x8 >> 3) + entry->rttvar_x4;
+        if (timeout < MESH_ACK_TIMEOUT_MIN_MS) {
+            timeout = MESH_ACK_TIMEOUT_MIN_MS;
+        }
+        else if (timeout > MESH_ACK_TIMEOUT_MAX_MS) {
+            timeout = MESH_ACK_TIMEOUT_MAX_MS;
+        }
+    }
+
+    return timeout;
+}
+
+/// @returns The doubled timeout for the next retry of a packet (exponential backoff)
+static inline uint32_t mesh_get_backoff_timeout(const uint32_t timeout)
+{
+    return (2 * timeout <= MESH_ACK_TIMEOUT_MAX_MS) ? (2 * timeout) : timeout;
+}
+
 /**
  * Finds a possible free slot from the pending packet array.
  * If a slot is not found, then the slot with least amount of retries+timeout is returned
@@ -305,15 +884,20 @@ static mesh_pnd_pkt_t* mesh_get_pnd_pkt_slot(mesh_pnd_pkt_t *arr, const uint8_t
         entry = &arr[0];
 
         for (i = 0; i < size_of_array; i++) {
+            const uint32_t elapsed_ms = mesh_get_pnd_pkt_elapsed_ms(&arr[i]);
             pkt_timeout = (arr[i].pkt.info.retries_rem);
-            pkt_timeout <<= sizeof(arr[i].timer_ms) * 8;
-            pkt_timeout |= arr[i].timer_ms;
+            pkt_timeout <<= 16;
+            pkt_timeout |= (elapsed_ms <= UINT16_MAX) ? elapsed_ms : UINT16_MAX;
 
             if (highest_timeout < pkt_timeout) {
                 highest_timeout = pkt_timeout;
                 entry = &arr[i];
             }
         }
+
+        #if MESH_USE_LINK_STATISTICS
+        mesh_link_stats_count(entry->pkt.nwk.dst, mesh_link_queue_drop);
+        #endif
     }
 
     return entry;
@@ -334,12 +918,17 @@ static void mesh_pending_packets_add(const mesh_packet_t *pPkt, const uint8_t nu
     mesh_pnd_pkt_t *entry = NULL;
     uint16_t timeout_ms = (1 + num_hops) * MESH_ACK_TIMEOUT_MS;
 
+    /* Use the measured round trip time of the route the packet is sent through */
+    if (MESH_ZERO_ADDR != pPkt->mac.dst) {
+        timeout_ms = mesh_get_ack_timeout(mesh_find_rte_tbl_entry(pPkt->nwk.dst), num_hops);
+    }
+
     /*
-     * We have to update soft timers before we add a pending packet because if mesh_service()
-     * is not called periodically, then the delta will be large, and the packet will be sent
+     * We have to update the time before we add a pending packet because if mesh_service()
+     * is not called periodically, then the time will be old, and the packet will be sent
      * again too soon.
      */
-    mesh_update_soft_timers();
+    mesh_update_time();
 
     /* We don't want mesh packets to take precedence over our own pending packets, so
      * we use different pending packets arrays for our own pending packets.
@@ -349,10 +938,11 @@ static void mesh_pending_packets_add(const mesh_packet_t *pPkt, const uint8_t nu
     }
     else {
         entry = mesh_get_pnd_pkt_slot(&g_mesh_pnd_pkts[0], g_mesh_pnd_pkts_size);
-        /* Route discovery packet needs to use special timeout */
-        if (MESH_ZERO_ADDR == pPkt->mac.dst) {
+        /* Route discovery and broadcast packets are repeated after a random hold-off */
+        if (MESH_ZERO_ADDR == pPkt->mac.dst || MESH_BROADCAST_ADDR == pPkt->nwk.dst) {
             entry->disc_pkt = true;
-            timeout_ms = MESH_PKT_DISC_TIMEOUT_MS;
+            entry->copies = 1;
+            timeout_ms = mesh_get_flood_timeout();
         }
     }
 
@@ -362,156 +952,298 @@ static void mesh_pending_packets_add(const mesh_packet_t *pPkt, const uint8_t nu
      * If we don't then we let the source dictate the retries throughout the mesh nodes.
      * If we do, then we increase the chances of getting the packet through.
      */
-    entry->timer_ms    = 0;
     entry->timeout_ms  = timeout_ms;
     entry->pkt         = *pPkt;
     entry->pkt.info.retries_rem = g_retry_count; /* DO THIS AFTER COPYING THE PACKET!!! */
+    mesh_start_pnd_timer(entry);
 
     MESH_DEBUG_PRINTF("ADD PND PKT NWK %i/%i NEXT %i TIMEOUT %ims",
                       pPkt->nwk.src, pPkt->nwk.dst, pPkt->mac.dst, entry->timeout_ms);
 }
 
 /**
- * Handles the timeout and retry logic for the pending packets array.
+ * Sends the packet we formed, and adds it to the pending packets if its delivery
+ * needs to be ensured.
+ * @returns true if the packet was sent
+ */
+static bool mesh_send_our_pkt(mesh_packet_t *pkt)
+{
+    const int radio_status = mesh_send_packet(pkt);
+    if (!radio_status) {
+        return false;
+    }
+
+    /* Ensure delivery of ACK or APP_ACK packet */
+    const bool ack_pkt = (mesh_pkt_ack == pkt->info.pkt_type || mesh_pkt_ack_app == pkt->info.pkt_type);
+
+    /* Ensure delivery of ACK's response to the next node */
+    const bool rsp_pkt = (mesh_pkt_ack_rsp == pkt->info.pkt_type &&
+                          pkt->mac.dst != MESH_ZERO_ADDR &&
+                          pkt->nwk.dst != pkt->mac.dst);
+
+    /* Nothing is pending if the radio of our neighbor already acknowledged our packet */
+    if (mesh_is_radio_acked(pkt, radio_status)) {
+        mesh_handle_radio_ack(pkt);
+    }
+    else if (ack_pkt || rsp_pkt) {
+        mesh_pending_packets_add(pkt, pkt->info.hop_count_max);
+    }
+
+    return true;
+}
+
+#if (MESH_TX_QUEUE_SIZE > 0)
+/// @returns true if one of our pending packets is free
+static bool mesh_is_our_pnd_pkt_free(void)
+{
+    uint8_t i = 0;
+
+    for (i = 0; i < g_our_pnd_pkts_size; i++) {
+        if (MESH_ZERO_ADDR == g_our_pnd_pkts[i].pkt.nwk.dst) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @returns true if our ACK packet should wait in the queue; either all of our pending
+ *          packets are in use, or other packets are queued before it.
+ */
+static bool mesh_must_queue_pkt(const mesh_packet_t *pkt)
+{
+    return (g_our_node_id == pkt->nwk.src &&
+            (mesh_pkt_ack == pkt->info.pkt_type || mesh_pkt_ack_app == pkt->info.pkt_type) &&
+            (!mesh_is_our_pnd_pkt_free() || mesh_get_queued_pkt_count(MESH_ZERO_ADDR) > 0));
+}
+
+/**
+ * Adds our packet to the queue.
+ * @returns false if the queue is full
+ */
+static bool mesh_tx_queue_add(const mesh_packet_t *pkt, const mesh_prio_t prio)
+{
+    uint8_t i = 0;
+
+    for (i = 0; i < g_tx_queue_size; i++) {
+        if (MESH_ZERO_ADDR == g_tx_queue[i].pkt.nwk.dst) {
+            g_tx_queue[i].pkt = *pkt;
+            g_tx_queue[i].prio = prio;
+            g_tx_queue[i].order = ++g_tx_queue_order;
+            MESH_DEBUG_PRINTF("QUEUE PKT TO %i PRIO %i", pkt->nwk.dst, prio);
+            return true;
+        }
+    }
+
+    #if MESH_USE_LINK_STATISTICS
+    mesh_link_stats_count(pkt->nwk.dst, mesh_link_queue_drop);
+    #endif
+    return false;
+}
+
+/**
+ * If one of our pending packets is free, this sends the queued packet of the highest
+ * priority, which is the oldest one of that priority.  Only one packet is sent for each
+ * call, so the queued packets are paced by the ACKs of our pending packets.
  */
-static void mesh_handle_pnd_pkts_for_arr(const mesh_packet_t *pRxPkt, mesh_pnd_pkt_t *arr, const uint8_t size_of_array)
+static void mesh_tx_queue_service(void)
 {
+    mesh_queued_pkt_t *next = NULL;
     uint8_t i = 0;
+
+    if (!mesh_is_our_pnd_pkt_free()) {
+        return;
+    }
+
+    for (i = 0; i < g_tx_queue_size; i++) {
+        mesh_queued_pkt_t *q = &g_tx_queue[i];
+        if (MESH_ZERO_ADDR != q->pkt.nwk.dst &&
+            (NULL == next || q->prio > next->prio ||
+             (q->prio == next->prio && (int16_t) (q->order - next->order) < 0))) {
+            next = q;
+        }
+    }
+    if (NULL == next) {
+        return;
+    }
+
+    mesh_packet_t pkt = next->pkt;
+    next->pkt.nwk.dst = MESH_ZERO_ADDR;
+
+    /* The route may have changed while the packet was queued */
+    mesh_rte_table_t *entry = mesh_find_rte_tbl_entry(pkt.nwk.dst);
+    if (NULL != entry) {
+        pkt.info.hop_count_max = entry->num_hops;
+        pkt.mac.dst = entry->next_hop;
+    }
+    else if (MESH_ZERO_ADDR != pkt.mac.dst) {
+        pkt.info.hop_count_max = MESH_RTE_DISCOVERY_HOPS;
+        pkt.mac.dst = MESH_ZERO_ADDR;
+    }
+
+    if (!mesh_send_our_pkt(&pkt)) {
+        MESH_DEBUG_PRINTF("DROP QUEUED PKT TO %i", pkt.nwk.dst);
+    }
+}
+#endif
+
+/**
+ * Handles the timeout and retry logic for a pending packet.
+ */
+static void mesh_handle_pnd_pkt(const mesh_packet_t *pRxPkt, mesh_pnd_pkt_t *pnd)
+{
     bool clear = false;
-    mesh_pnd_pkt_t *pnd = NULL;
 
-    for (i = 0; i < size_of_array; i++) {
-        pnd = &arr[i];
-
-        /* Was this pending packet a route discovery packet? */
-        if (pnd->disc_pkt) {
-            /* If destined node responded, so no need to repeat this packet. */
-            if (NULL != pRxPkt &&
-                pRxPkt->nwk.src == pnd->pkt.nwk.dst && /* Destined node responded */
-                pRxPkt->nwk.dst == pnd->pkt.nwk.src)
-            {
-                MESH_DEBUG_PRINTF("REMOVE RTE DISC PKT: DST %i RESPONDED TO %i",
-                                  pnd->pkt.nwk.src, pnd->pkt.nwk.dst);
-                memset(pnd, 0, sizeof(*pnd));
-            }
-            /*
-             * Another case is when another node repeats the packet who knows the route, so
-             * we don't need to repeat the discovery packet.
-             */
-            else if (NULL != pRxPkt &&
-                MESH_ZERO_ADDR != pRxPkt->mac.dst &&
-                mesh_is_same_packet(pRxPkt, &(pnd->pkt)))
-            {
-                MESH_DEBUG_PRINTF("REMOVE RTE DISC PKT: RTE %i RPT FOR NWK %i/%i",
-                                  pnd->pkt.mac.src, pnd->pkt.nwk.src, pnd->pkt.nwk.dst);
-                memset(pnd, 0, sizeof(*pnd));
-            }
-            /* Packet timeout occurred, and destined node did not respond
-             * so it is time to repeat the packet.
-             */
-            else if (pnd->timer_ms >= pnd->timeout_ms) {
-                MESH_DEBUG_PRINTF("TIMEOUT: SEND DISC PKT FOR NWK %i/%i",
-                                  pnd->pkt.nwk.src, pnd->pkt.nwk.dst);
-                mesh_send_packet(&(pnd->pkt));
-                memset(pnd, 0, sizeof(*pnd));
-            }
+    /* Was this pending packet a route discovery packet? */
+    if (pnd->disc_pkt) {
+        /* If destined node responded, so no need to repeat this packet. */
+        if (NULL != pRxPkt &&
+            pRxPkt->nwk.src == pnd->pkt.nwk.dst && /* Destined node responded */
+            pRxPkt->nwk.dst == pnd->pkt.nwk.src)
+        {
+            MESH_DEBUG_PRINTF("REMOVE RTE DISC PKT: DST %i RESPONDED TO %i",
+                              pnd->pkt.nwk.src, pnd->pkt.nwk.dst);
+            mesh_clear_pnd_pkt(pnd);
         }
-        /* Is this a pending packet with a destination ? */
-        else if (MESH_ZERO_ADDR != pnd->pkt.nwk.dst) {
-            clear = false;
-
-            /* If the response is received, clear the pending packet :
-             * For packet N1 --> N2 --> N3, nwk.src = 1, and nwk.dst = 3
-             * For resp : N3 --> N3 --> N1,  rx.src = 3, and  rx.dst = 1
-             * The response should be a ACK_RSP packet to accommodate for the fact
-             * that N1 and N3 may be sending ACK packets to each other.
-             */
-            if (NULL != pRxPkt &&
-                    mesh_pkt_ack_rsp == pRxPkt->info.pkt_type &&
-                    pnd->pkt.nwk.src == pRxPkt->nwk.dst &&
-                    pnd->pkt.nwk.dst == pRxPkt->nwk.src)
-            {
-                MESH_DEBUG_PRINTF("CLR PND PKT: ACK_RSP OK WITH NWK %i/%i", pRxPkt->nwk.src, pRxPkt->nwk.dst);
-                clear = true;
+        /*
+         * Another case is when another node repeats the packet who knows the route, so
+         * we don't need to repeat the discovery packet.
+         */
+        else if (NULL != pRxPkt &&
+            MESH_ZERO_ADDR != pRxPkt->mac.dst &&
+            mesh_is_same_packet(pRxPkt, &(pnd->pkt)))
+        {
+            MESH_DEBUG_PRINTF("REMOVE RTE DISC PKT: RTE %i RPT FOR NWK %i/%i",
+                              pnd->pkt.mac.src, pnd->pkt.nwk.src, pnd->pkt.nwk.dst);
+            mesh_clear_pnd_pkt(pnd);
+        }
+        /* Packet timeout occurred, and destined node did not respond
+         * so it is time to repeat the packet.
+         */
+        else if (mesh_is_pnd_pkt_timed_out(pnd)) {
+            MESH_DEBUG_PRINTF("TIMEOUT: SEND DISC PKT FOR NWK %i/%i",
+                              pnd->pkt.nwk.src, pnd->pkt.nwk.dst);
+            mesh_send_packet(&(pnd->pkt));
+            mesh_clear_pnd_pkt(pnd);
+        }
+    }
+    /* Is this a pending packet with a destination ? */
+    else if (MESH_ZERO_ADDR != pnd->pkt.nwk.dst) {
+        clear = false;
+
+        /* If the response is received, clear the pending packet :
+         * For packet N1 --> N2 --> N3, nwk.src = 1, and nwk.dst = 3
+         * For resp : N3 --> N3 --> N1,  rx.src = 3, and  rx.dst = 1
+         * The response should be a ACK_RSP packet to accommodate for the fact
+         * that N1 and N3 may be sending ACK packets to each other.
+         */
+        if (NULL != pRxPkt &&
+                mesh_pkt_ack_rsp == pRxPkt->info.pkt_type &&
+                pnd->pkt.nwk.src == pRxPkt->nwk.dst &&
+                pnd->pkt.nwk.dst == pRxPkt->nwk.src)
+        {
+            MESH_DEBUG_PRINTF("CLR PND PKT: ACK_RSP OK WITH NWK %i/%i", pRxPkt->nwk.src, pRxPkt->nwk.dst);
+            clear = true;
+
+            /* Only a packet that was not retried tells the round trip time (Karn's algorithm) */
+            const bool not_retried = (g_retry_count == pnd->pkt.info.retries_rem);
+            if (not_retried) {
+                mesh_update_rte_rtt(mesh_find_rte_tbl_entry(pnd->pkt.nwk.dst), mesh_get_pnd_pkt_elapsed_ms(pnd));
             }
-            /* An intermediate node repeated ACK_RSP packet, meaning it got the packet */
-            else if (NULL != pRxPkt &&
-                    mesh_pkt_ack_rsp == pRxPkt->info.pkt_type &&
-                    pnd->pkt.mac.dst == pRxPkt->mac.src &&         /* Next node sent this packet out */
-                    mesh_is_same_packet(&(pnd->pkt), pRxPkt)       /* Network src/dst/id matches */
-            ){
-                MESH_DEBUG_PRINTF("CLR PND PKT: %i RPT ACK_RSP PKT FOR NWK %i/%i",
-                                  pRxPkt->mac.src, pRxPkt->nwk.src, pRxPkt->nwk.dst);
-                clear = true;
+            #if MESH_USE_LINK_STATISTICS
+            if (g_our_node_id == pnd->pkt.nwk.src) {
+                mesh_link_stats_acked(pnd->pkt.nwk.dst, pnd->pkt.info.retries_rem,
+                                      not_retried ? mesh_get_pnd_pkt_elapsed_ms(pnd) : UINT32_MAX);
             }
-            /* If packet goes from N1 --> N2 --> N3 with ACK, and we hear back
-             * from N2 sending packet out, we do not need to re-send it to N2.
-             */
-            else if (NULL != pRxPkt &&
-                    pRxPkt->info.pkt_type &&
-                    pRxPkt->mac.src == pnd->pkt.mac.dst &&   /* Destined node repeated packet */
-                    mesh_is_same_packet(&(pnd->pkt), pRxPkt) /* Network src/dst/id matches */
-            ){
-                pnd->timer_ms = 0;
-                pnd->pkt.info.retries_rem = 0;
-                MESH_DEBUG_PRINTF("%i RPT PKT, NO RPT WITH NWK %i/%i TO MAC %i",
-                                  pRxPkt->mac.src, pRxPkt->nwk.src, pRxPkt->nwk.dst, pRxPkt->mac.dst);
-                // We do not clear the packet here, since we want to clear the routing entry
-                // and retry the packet to find a new route.
+            #endif
+        }
+        /* An intermediate node repeated ACK_RSP packet, meaning it got the packet */
+        else if (NULL != pRxPkt &&
+                mesh_pkt_ack_rsp == pRxPkt->info.pkt_type &&
+                pnd->pkt.mac.dst == pRxPkt->mac.src &&         /* Next node sent this packet out */
+                mesh_is_same_packet(&(pnd->pkt), pRxPkt)       /* Network src/dst/id matches */
+        ){
+            MESH_DEBUG_PRINTF("CLR PND PKT: %i RPT ACK_RSP PKT FOR NWK %i/%i",
+                              pRxPkt->mac.src, pRxPkt->nwk.src, pRxPkt->nwk.dst);
+            clear = true;
+        }
+        /* If packet goes from N1 --> N2 --> N3 with ACK, and we hear back
+         * from N2 sending packet out, we do not need to re-send it to N2.
+         */
+        else if (NULL != pRxPkt &&
+                pRxPkt->info.pkt_type &&
+                pRxPkt->mac.src == pnd->pkt.mac.dst &&   /* Destined node repeated packet */
+                mesh_is_same_packet(&(pnd->pkt), pRxPkt) /* Network src/dst/id matches */
+        ){
+            mesh_start_pnd_timer(pnd);
+            pnd->pkt.info.retries_rem = 0;
+            MESH_DEBUG_PRINTF("%i RPT PKT, NO RPT WITH NWK %i/%i TO MAC %i",
+                              pRxPkt->mac.src, pRxPkt->nwk.src, pRxPkt->nwk.dst, pRxPkt->mac.dst);
+            // We do not clear the packet here, since we want to clear the routing entry
+            // and retry the packet to find a new route.
+        }
+        /* Is it time to retransmit? */
+        else if(mesh_is_pnd_pkt_timed_out(pnd))
+        {
+            if (pnd->pkt.info.retries_rem > 0) {
+                MESH_DEBUG_PRINTF("RETRY PKT WITH NWK %i/%i", pnd->pkt.nwk.src, pnd->pkt.nwk.dst);
+                if (mesh_is_radio_acked(&(pnd->pkt), mesh_send_retry_packet(&(pnd->pkt)))) {
+                    mesh_handle_radio_ack(&(pnd->pkt));
+                    clear = true;
+                }
+                pnd->timeout_ms = mesh_get_backoff_timeout(pnd->timeout_ms);
             }
-            /* Is it time to retransmit? */
-            else if(pnd->timer_ms >= pnd->timeout_ms)
-            {
-                pnd->timer_ms = 0;
-
-                if (pnd->pkt.info.retries_rem > 0) {
-                    MESH_DEBUG_PRINTF("RETRY PKT WITH NWK %i/%i", pnd->pkt.nwk.src, pnd->pkt.nwk.dst);
+            else {
+                /* Were we the source and was it through an intermediate node?
+                 * If so, then remove the routing node, and retry packet delivery
+                 * with unknown node.
+                 * We only want to do this if we are the source node because we
+                 * don't want the intermediate node to repeat 2x the retry count.
+                 */
+                if (mesh_pkt_ack_rsp != pnd->pkt.info.pkt_type &&
+                        pnd->pkt.nwk.src == g_our_node_id &&    /* Source was us */
+                        pnd->pkt.mac.dst != pnd->pkt.nwk.dst && /* Through intermediate node */
+                        pnd->pkt.mac.dst != MESH_ZERO_ADDR
+                ) {
+                    pnd->pkt.mac.dst = MESH_ZERO_ADDR;         /* Route is now unknown  */
+                    pnd->pkt.info.hop_count_max = MESH_RTE_DISCOVERY_HOPS;
+                    MESH_DEBUG_PRINTF("RETRY PKT AND DISC NEW RTE WITH NWK %i/%i",
+                                      pnd->pkt.nwk.src, pnd->pkt.nwk.dst);
                     mesh_send_retry_packet(&(pnd->pkt));
+                    pnd->pkt.info.retries_rem = g_retry_count; /* Reset retry count */
                 }
                 else {
-                    /* Were we the source and was it through an intermediate node?
-                     * If so, then remove the routing node, and retry packet delivery
-                     * with unknown node.
-                     * We only want to do this if we are the source node because we
-                     * don't want the intermediate node to repeat 2x the retry count.
-                     */
-                    if (mesh_pkt_ack_rsp != pnd->pkt.info.pkt_type &&
-                            pnd->pkt.nwk.src == g_our_node_id &&    /* Source was us */
-                            pnd->pkt.mac.dst != pnd->pkt.nwk.dst && /* Through intermediate node */
-                            pnd->pkt.mac.dst != MESH_ZERO_ADDR
-                    ) {
-                        pnd->pkt.mac.dst = MESH_ZERO_ADDR;         /* Route is now unknown  */
-                        pnd->pkt.info.hop_count_max = MESH_RTE_DISCOVERY_HOPS;
-                        MESH_DEBUG_PRINTF("RETRY PKT AND DISC NEW RTE WITH NWK %i/%i",
-                                          pnd->pkt.nwk.src, pnd->pkt.nwk.dst);
-                        mesh_send_retry_packet(&(pnd->pkt));
-                        pnd->pkt.info.retries_rem = g_retry_count; /* Reset retry count */
+                    /* Retries have reached zero */
+                    MESH_DEBUG_PRINTF("CLR PND PKT: FAILED WITH NWK %i/%i", pnd->pkt.nwk.src, pnd->pkt.nwk.dst);
+                    clear = true;
+                    #if MESH_USE_LINK_STATISTICS
+                    if (g_our_node_id == pnd->pkt.nwk.src) {
+                        mesh_link_stats_count(pnd->pkt.nwk.dst, mesh_link_failed);
                     }
-                    else {
-                        /* Retries have reached zero */
-                        MESH_DEBUG_PRINTF("CLR PND PKT: FAILED WITH NWK %i/%i", pnd->pkt.nwk.src, pnd->pkt.nwk.dst);
-                        clear = true;
-                    }
-
-                    /* We no longer hear from nwk.dst, so remove the route */
-                    MESH_DEBUG_PRINTF("RTE %i REMOVED", pnd->pkt.nwk.dst);
-                    mesh_remove_rte_entry(pnd->pkt.nwk.dst);
-
-                    /**
-                     * TO DO : FUTURE FEATURE :
-                     * We could also send a special packet back to origin node to remove its
-                     * route of pkt.nwk.dst through us, since we no longer hear from that node.
-                     * Currently, origin node will timeout, and remove the route by itself at
-                     * the expense of time, and retries, however, it is less code this way.
-                     */
+                    #endif
                 }
-            }
 
-            if (clear) {
-                memset(pnd, 0, sizeof(*pnd));
+                /* We no longer hear from nwk.dst, so remove the route */
+                MESH_DEBUG_PRINTF("RTE %i REMOVED", pnd->pkt.nwk.dst);
+                mesh_remove_rte_entry(pnd->pkt.nwk.dst);
+
+                /**
+                 * TO DO : FUTURE FEATURE :
+                 * We could also send a special packet back to origin node to remove its
+                 * route of pkt.nwk.dst through us, since we no longer hear from that node.
+                 * Currently, origin node will timeout, and remove the route by itself at
+                 * the expense of time, and retries, however, it is less code this way.
+                 */
             }
-        } // end if
-    } // end loop
+
+            /* The timeout starts again from this retry, with the backoff of the timeout */
+            mesh_start_pnd_timer(pnd);
+        }
+
+        if (clear) {
+            mesh_clear_pnd_pkt(pnd);
+        }
+    }
 }
 
 /**
@@ -520,10 +1252,66 @@ static void mesh_handle_pnd_pkts_for_arr(const mesh_packet_t *pRxPkt, mesh_pnd_p
  *                NULL indicating that there is no incoming packet and the
  *                call to this function is just to retransmit pending packets.
  */
-static inline void mesh_handle_pending_packets(const mesh_packet_t *pRxPkt)
+static void mesh_handle_pending_packets(const mesh_packet_t *pRxPkt)
+{
+    uint16_t i = 0;
+
+    /* Every pending packet is checked against the incoming packet, otherwise
+     * only the pending packets whose timer expired have something to do.
+     */
+    if (NULL != pRxPkt) {
+        for (i = 0; i < g_mesh_pnd_pkts_size; i++) {
+            mesh_handle_pnd_pkt(pRxPkt, &g_mesh_pnd_pkts[i]);
+        }
+        for (i = 0; i < g_our_pnd_pkts_size; i++) {
+            mesh_handle_pnd_pkt(pRxPkt, &g_our_pnd_pkts[i]);
+        }
+    }
+    else {
+        for (i = 0; i < g_expired_pnd_pkts_count; i++) {
+            mesh_handle_pnd_pkt(NULL, g_expired_pnd_pkts[i]);
+        }
+    }
+    g_expired_pnd_pkts_count = 0;
+}
+
+/**
+ * Searches the packet history for the source and the packet id of the given packet.
+ * The packet hashes to a slot of the history, and only a few slots from there are
+ * searched, so the cost does not grow with the number of mesh nodes.
+ *
+ * @param pkt    The packet fields to search, and the time of its arrival.
+ * @param found  returned value is true if the packet was found within MESH_PKT_HISTORY_TIMEOUT_MS
+ * @returns The matching entry, or else the free or the oldest entry to write the packet to.
+ */
+static mesh_pkt_history_t* mesh_find_pkt_history(const mesh_pkt_history_t *pkt, bool *found)
 {
-    mesh_handle_pnd_pkts_for_arr(pRxPkt, &g_mesh_pnd_pkts[0], g_mesh_pnd_pkts_size);
-    mesh_handle_pnd_pkts_for_arr(pRxPkt, &g_our_pnd_pkts[0],  g_our_pnd_pkts_size);
+    const uint8_t mask = g_pkt_history_size - 1;
+    const uint8_t hash = (uint8_t) ((pkt->src * 31) + pkt->pkt_id);
+    mesh_pkt_history_t *oldest = &g_pkt_hist[hash & mask];
+    mesh_pkt_history_t *e = NULL;
+    uint8_t i = 0;
+
+    *found = false;
+    for (i = 0; i < MESH_PKT_HISTORY_PROBES && i < g_pkt_history_size; i++) {
+        e = &g_pkt_hist[(hash + i) & mask];
+
+        /* Free entries, and entries older than the timeout no longer mark a duplicate */
+        if (MESH_ZERO_ADDR == e->src || (pkt->time_ms - e->time_ms) >= MESH_PKT_HISTORY_TIMEOUT_MS) {
+            e->src = MESH_ZERO_ADDR;
+        }
+        else if (e->src == pkt->src && e->pkt_id == pkt->pkt_id) {
+            *found = true;
+            return e;
+        }
+
+        if (MESH_ZERO_ADDR != oldest->src &&
+            (MESH_ZERO_ADDR == e->src || (pkt->time_ms - e->time_ms) > (pkt->time_ms - oldest->time_ms))) {
+            oldest = e;
+        }
+    }
+
+    return oldest;
 }
 
 /**
@@ -535,24 +1323,21 @@ static inline void mesh_handle_pending_packets(const mesh_packet_t *pRxPkt)
 static void mesh_update_history_and_routing(const mesh_packet_t *pPkt, bool *duplicate, bool *is_retry_packet)
 {
     bool duplicate_packet = false;
-    uint8_t i = 0;
     mesh_pkt_history_t new_pkt;
+    mesh_pkt_history_t *existing = NULL;
     mesh_rte_table_t *entry = NULL;
 
     new_pkt.src = pPkt->nwk.src;
     new_pkt.pkt_id = pPkt->info.pkt_seq_num;
     new_pkt.retries = pPkt->info.retries_rem;
+    new_pkt.time_ms = g_prev_time_ms; /* Updated by mesh_service() which is called frequently */
 
     /* Check if we have the unique id in our history */
-    for(i = 0; i < g_pkt_history_size; i++) {
-        mesh_pkt_history_t *existing = &g_pkt_hist[i];
-        if(existing->src == new_pkt.src && existing->pkt_id == new_pkt.pkt_id) {
-            duplicate_packet = true;
-            /* Packet is a duplicate, but does it differ only by retry count? */
-            *is_retry_packet = (existing->retries != new_pkt.retries);
-            existing->retries = new_pkt.retries;
-            break;
-        }
+    existing = mesh_find_pkt_history(&new_pkt, &duplicate_packet);
+    if (duplicate_packet) {
+        /* Packet is a duplicate, but does it differ only by retry count? */
+        *is_retry_packet = (existing->retries != new_pkt.retries);
+        existing->retries = new_pkt.retries;
     }
 
     /* If not duplicate packet, add to our history of duplicate packets.
@@ -561,14 +1346,7 @@ static void mesh_update_history_and_routing(const mesh_packet_t *pPkt, bool *dup
      */
     if (!duplicate_packet)
     {
-        *g_pkt_hist_wptr = new_pkt;
-        /* if the pointer was at the last element, reset back to zero */
-        if (g_pkt_hist_wptr == &(g_pkt_hist[g_pkt_history_size-1])) {
-            g_pkt_hist_wptr = &(g_pkt_hist[0]);
-        }
-        else {
-            g_pkt_hist_wptr++;
-        }
+        *existing = new_pkt;
 
         /* Update the routing table when a packet arrives to us through an
          * intermediate node, but we don't want to add our own route if our
@@ -578,15 +1356,16 @@ static void mesh_update_history_and_routing(const mesh_packet_t *pPkt, bool *dup
             entry = mesh_get_rte_to_modify(pPkt->nwk.src);
             mesh_update_rte_scores(entry);
 
-            /* We only want to add or modify this route if hops are less to nwk.src through this mac.src
-             * If we get entry->dst being zero, that means, we got an entry that needs to be over-written.
-             * If new hop count is less than or equal to, we need to update the route even if it is equal
-             * such that we can keep a copy of the latest route.
+            /* We only want to add or modify this route if it costs less transmissions to nwk.src through
+             * this mac.src.  If we get entry->dst being zero, that means, we got an entry that needs to be
+             * over-written.  If the new cost is less than or equal to, we need to update the route even if
+             * it is equal such that we can keep a copy of the latest route.
              */
-            if (MESH_ZERO_ADDR == entry->dst || pPkt->info.hop_count <= entry->num_hops) {
-                entry->dst = pPkt->nwk.src;
-                entry->next_hop = pPkt->mac.src;
-                entry->num_hops = pPkt->info.hop_count;
+            if (MESH_ZERO_ADDR == entry->dst ||
+                mesh_get_rte_cost(pPkt->mac.src, pPkt->info.hop_count) <=
+                mesh_get_rte_cost(entry->next_hop, entry->num_hops))
+            {
+                mesh_set_route(entry, pPkt->nwk.src, pPkt->mac.src, pPkt->info.hop_count);
             }
         }
     }
@@ -598,19 +1377,61 @@ static void mesh_update_history_and_routing(const mesh_packet_t *pPkt, bool *dup
      * duplicate packet from the source node.
      */
     entry = mesh_get_rte_to_modify(pPkt->mac.src);
-    entry->dst = pPkt->mac.src;
-    entry->next_hop = pPkt->mac.src;
-    entry->num_hops = 0;
+    mesh_set_route(entry, pPkt->mac.src, pPkt->mac.src, 0);
     mesh_update_rte_scores(entry);
 
     *duplicate = duplicate_packet;
 }
 
+#if MESH_CUT_THROUGH
+/**
+ * Repeats a routed packet through us right away if we know the next hop of its destination.
+ * This is checked before the history and the routing are updated, and a copy of the packet is
+ * sent, so the bookkeeping is then done as usual while our repeat is already on the air.
+ * @returns true if the packet was repeated, and mesh_handle_mesh_packet() should not send it again.
+ */
+static bool mesh_cut_through(const mesh_packet_t *pPkt)
+{
+    mesh_pkt_history_t pkt;
+    mesh_pkt_history_t *existing = NULL;
+    mesh_rte_table_t *entry = NULL;
+    mesh_packet_t fwd;
+    bool duplicate = false;
+
+    /* Only a unicast through us that mesh_handle_mesh_packet() would repeat to a known next hop */
+    if (!g_rpt_node || g_our_node_id != pPkt->mac.dst ||
+        pPkt->info.hop_count >= pPkt->info.hop_count_max ||
+        g_our_node_id == pPkt->nwk.src || g_our_node_id == pPkt->nwk.dst ||
+        MESH_BROADCAST_ADDR == pPkt->nwk.dst || pPkt->mac.src == pPkt->nwk.dst ||
+        NULL == (entry = mesh_find_rte_tbl_entry(pPkt->nwk.dst))) {
+        return false;
+    }
+
+    /* The duplicates that mesh_service() discards are not repeated */
+    pkt.src = pPkt->nwk.src;
+    pkt.pkt_id = pPkt->info.pkt_seq_num;
+    pkt.time_ms = g_prev_time_ms;
+    existing = mesh_find_pkt_history(&pkt, &duplicate);
+    if (duplicate && existing->retries == pPkt->info.retries_rem) {
+        return false;
+    }
+
+    fwd = *pPkt;
+    fwd.info.hop_count++;
+    fwd.mac.dst = entry->next_hop;
+    MESH_DEBUG_PRINTF("CUT THROUGH PKT WITH NWK %i/%i TO %i", fwd.nwk.src, fwd.nwk.dst, fwd.mac.dst);
+    mesh_send_packet(&fwd);
+    return true;
+}
+#endif
+
 /**
  * Handles the packet such that we can participate in the mesh network
  * and route it appropriately.
+ * @param forwarded  If true, the packet was already repeated by mesh_cut_through(), so only
+ *                   the pending packet to ensure its delivery is added.
  */
-static void mesh_handle_mesh_packet(mesh_packet_t *pPkt)
+static void mesh_handle_mesh_packet(mesh_packet_t *pPkt, const bool forwarded)
 {
     bool ensure_delivery = false;
     uint8_t num_hops = 0;
@@ -656,7 +1477,12 @@ static void mesh_handle_mesh_packet(mesh_packet_t *pPkt)
         pPkt->mac.dst = MESH_ZERO_ADDR;
     }
 
-    mesh_send_packet(pPkt);
+    if (forwarded) {
+        pPkt->mac.src = g_our_node_id;
+    }
+    else {
+        mesh_send_packet(pPkt);
+    }
 
     /* If packet type requires ACK, and we are the next node responsible to
      * deliver the packet, then we add this packet to our list of packets
@@ -765,17 +1591,35 @@ bool mesh_init(const uint8_t id,
 
     memset(&g_our_pnd_pkts[0], 0, sizeof(g_our_pnd_pkts));
     memset(&g_mesh_pnd_pkts[0], 0, sizeof(g_mesh_pnd_pkts));
+    #if (MESH_TX_QUEUE_SIZE > 0)
+    memset(&g_tx_queue[0], 0, sizeof(g_tx_queue));
+    #endif
     memset(&g_rte_table[0], 0, sizeof(g_rte_table));
+    memset(&g_rte_index[0], 0, sizeof(g_rte_index));
     memset(&g_pkt_hist[0], 0, sizeof(g_pkt_hist));
     #if MESH_USE_STATISTICS
     memset(&g_mesh_stats, 0, sizeof(g_mesh_stats));
     #endif
+    #if MESH_USE_LINK_STATISTICS
+    memset(&g_link_stats[0], 0, sizeof(g_link_stats));
+    #endif
+    #if (MESH_BEACON_INTERVAL_MS > 0)
+    memset(&g_nbrs[0], 0, sizeof(g_nbrs));
+    #endif
 
     g_our_node_id = id;
+    g_flood_rand = id;
     g_rpt_node = is_rpt_node;
     g_driver = d;
     memset(g_our_name, 0, sizeof(g_our_name));
+
+    /* The timers of the pending packets start from the time of the new driver */
+    mesh_update_time();
+    mesh_init_pnd_timers();
     strncpy(g_our_name, node_name, sizeof(g_our_name)-1);
+    #if (MESH_BEACON_INTERVAL_MS > 0)
+    g_beacon_due_ms = g_prev_time_ms + MESH_BEACON_INTERVAL_MS;
+    #endif
 
     /* If init works, then send discovery packet if asked */
     status = g_driver.radio_init(NULL, 0);
@@ -786,7 +1630,7 @@ bool mesh_init(const uint8_t id,
 
     /* Test to make sure our software timer callback returns good value */
     if (status) {
-        status = mesh_update_soft_timers();
+        status = mesh_update_time();
     }
 
     return status;
@@ -845,11 +1689,29 @@ void mesh_service(void)
             MESH_DEBUG_PRINTF("ERROR: DUPLICATE NODE WITH OUR ADDRESS");
             g_error_mask |= mesh_err_dup_node;
         }
+        /* The beacon of a neighbor is only used to measure the link, see mesh_beacon_service() */
+        else if (MESH_ZERO_ADDR == packet.nwk.dst && MESH_BROADCAST_ADDR == packet.mac.dst) {
+            #if (MESH_BEACON_INTERVAL_MS > 0)
+            mesh_handle_beacon(&packet);
+            #endif
+        }
         else {
+            /* A packet through us to a known next hop is repeated before the bookkeeping below */
+            #if MESH_CUT_THROUGH
+            const bool forwarded = mesh_cut_through(&packet);
+            #else
+            const bool forwarded = false;
+            #endif
+
             /* Update history and routing and get status if packet is a duplicate or retry packet */
             bool duplicate = false;
             bool is_retry_packet = false;
             mesh_update_history_and_routing(&packet, &duplicate, &is_retry_packet);
+            #if MESH_USE_LINK_STATISTICS
+            if (duplicate) {
+                mesh_link_stats_count(packet.nwk.src, mesh_link_duplicate);
+            }
+            #endif
 
             /* If packet is complete duplicate, then we do not consider it unique */
             const bool unique_packet = !duplicate || is_retry_packet;
@@ -870,6 +1732,7 @@ void mesh_service(void)
             {
                 MESH_DEBUG_PRINTF("DISCARD DUP PKT FROM %i NWK %i/%i",
                                   packet.mac.src, packet.nwk.src, packet.nwk.dst);
+                mesh_flood_copy_heard(&packet);
             }
             /* Can't do something with our own packet which we may receive when someone
              * repeats our own packet back to us, but we do need to update our routing
@@ -887,10 +1750,10 @@ void mesh_service(void)
                     g_error_mask |= mesh_err_app_recv;
                 }
 
-                /* Repeat broadcast packet blindly without any routing mess */
+                /* Repeat broadcast packet without any routing mess, unless other nodes repeat it first */
                 if (packet.info.hop_count++ < packet.info.hop_count_max) {
-                    MESH_DEBUG_PRINTF("TX BROADCAST PKT FROM %i THRU %i", packet.nwk.src, packet.mac.src);
-                    mesh_send_packet(&packet);
+                    MESH_DEBUG_PRINTF("ADD BROADCAST PKT FROM %i THRU %i", packet.nwk.src, packet.mac.src);
+                    mesh_pending_packets_add(&packet, packet.info.hop_count_max);
                 }
             }
             else if (g_our_node_id == packet.nwk.dst)
@@ -903,7 +1766,7 @@ void mesh_service(void)
             }
             else if (g_rpt_node && packet.info.hop_count < packet.info.hop_count_max) {
                 pMeshPacket = &packet;
-                mesh_handle_mesh_packet(pMeshPacket);
+                mesh_handle_mesh_packet(pMeshPacket, forwarded);
             }
             else {
                 MESH_DEBUG_PRINTF("DISCARD PKT NWK %i/%i MAC %i/%i HOPS %i/%i SEQ:%i RT:%i",
@@ -923,11 +1786,27 @@ void mesh_service(void)
      * then we will send out the packet again.
      */
     mesh_handle_pending_packets(pMeshPacket);
+
+    /* Our queued packet is sent once one of our pending packets is free */
+    #if (MESH_TX_QUEUE_SIZE > 0)
+    mesh_tx_queue_service();
+    #endif
+
+    #if (MESH_BEACON_INTERVAL_MS > 0)
+    mesh_beacon_service();
+    #endif
 }
 
 bool mesh_send(const uint8_t dst, const mesh_protocol_t type,
                const void* pData, const uint8_t len,
                const uint8_t hop_count_max)
+{
+    return mesh_send_prio(dst, type, pData, len, hop_count_max, mesh_prio_normal);
+}
+
+bool mesh_send_prio(const uint8_t dst, const mesh_protocol_t type,
+                    const void* pData, const uint8_t len,
+                    const uint8_t hop_count_max, const mesh_prio_t prio)
 {
     bool status = false;
     mesh_packet_t packet;
@@ -942,7 +1821,7 @@ bool mesh_send(const uint8_t dst, const mesh_protocol_t type,
     if(len <= sizeof(packet.data) && !(!!pData ^ !!len)) {
         const uint8_t pair_cnt = 0 == len ? 0 : 1;
         if (mesh_form_pkt(&packet, dst, type, hop_count_max, pair_cnt, pData, len)) {
-            status = mesh_send_formed_pkt(&packet);
+            status = mesh_send_formed_pkt_prio(&packet, prio);
         }
     }
 
@@ -1021,6 +1900,11 @@ bool mesh_form_pkt(mesh_packet_t *pkt, const uint8_t dst,
         pkt->mac.dst = entry->next_hop;
     }
 
+    /* Only a packet to a direct neighbor has the compact header, and the larger data */
+    if (pkt->info.data_len > MESH_DATA_PAYLOAD_SIZE && !mesh_pkt_is_compact(pkt)) {
+        ok = false;
+    }
+
     return ok;
 }
 
@@ -1050,7 +1934,59 @@ bool mesh_deform_pkt(mesh_packet_t *pkt, uint8_t num_ptrs, ...)
     return (ok);
 }
 
+uint8_t mesh_pkt_compact(const mesh_packet_t *pkt, void *frame)
+{
+    const uint8_t data_len = (pkt->info.data_len <= sizeof(pkt->data)) ? pkt->info.data_len : sizeof(pkt->data);
+
+    if (!mesh_pkt_is_compact(pkt)) {
+        memcpy(frame, pkt, MESH_PAYLOAD_HEADER_SIZE + data_len);
+        return (MESH_PAYLOAD_HEADER_SIZE + data_len);
+    }
+
+    /* The hop counts are zero, and the network addresses are the same as the MAC addresses */
+    mesh_pkt_compact_hdr_t hdr;
+    hdr.addr = pkt->mac;
+    hdr.pkt_seq_num = pkt->info.pkt_seq_num;
+    hdr.data_len = data_len;
+    hdr.version = MESH_VERSION_COMPACT;
+    hdr.retries_rem = pkt->info.retries_rem;
+    hdr.pkt_type = pkt->info.pkt_type;
+
+    /* The data is moved after the header, in case the frame is the packet itself */
+    uint8_t *bytes = (uint8_t*) frame;
+    memmove(bytes + MESH_COMPACT_HEADER_SIZE, pkt->data, data_len);
+    memcpy(bytes, &hdr, MESH_COMPACT_HEADER_SIZE);
+    return (MESH_COMPACT_HEADER_SIZE + data_len);
+}
+
+bool mesh_pkt_expand(mesh_packet_t *pkt)
+{
+    if (MESH_VERSION_COMPACT != pkt->info.version) {
+        return false;
+    }
+
+    mesh_pkt_compact_hdr_t hdr;
+    memcpy(&hdr, pkt, MESH_COMPACT_HEADER_SIZE);
+    const uint8_t data_len = (hdr.data_len <= sizeof(pkt->data)) ? hdr.data_len : sizeof(pkt->data);
+    memmove(pkt->data, ((uint8_t*) pkt) + MESH_COMPACT_HEADER_SIZE, data_len);
+
+    pkt->nwk = pkt->mac = hdr.addr;
+    pkt->info.version = MESH_VERSION;
+    pkt->info.retries_rem = hdr.retries_rem;
+    pkt->info.pkt_type = hdr.pkt_type;
+    pkt->info.hop_count = 0;
+    pkt->info.hop_count_max = 0;
+    pkt->info.pkt_seq_num = hdr.pkt_seq_num;
+    pkt->info.data_len = data_len;
+    return true;
+}
+
 bool mesh_send_formed_pkt(mesh_packet_t *pkt)
+{
+    return mesh_send_formed_pkt_prio(pkt, mesh_prio_normal);
+}
+
+bool mesh_send_formed_pkt_prio(mesh_packet_t *pkt, const mesh_prio_t prio)
 {
     bool ok = false;
 
@@ -1059,17 +1995,17 @@ bool mesh_send_formed_pkt(mesh_packet_t *pkt)
      * out mesh_send() from accessing the structures.
      */
     g_locked = true;
-    if (NULL != pkt && (ok = mesh_send_packet(pkt))) {
-        /* Ensure delivery of ACK or APP_ACK packet */
-        const bool ack_pkt = (mesh_pkt_ack == pkt->info.pkt_type || mesh_pkt_ack_app == pkt->info.pkt_type);
-
-        /* Ensure delivery of ACK's response to the next node */
-        const bool rsp_pkt = (mesh_pkt_ack_rsp == pkt->info.pkt_type &&
-                              pkt->mac.dst != MESH_ZERO_ADDR &&
-                              pkt->nwk.dst != pkt->mac.dst);
-
-        if (ack_pkt || rsp_pkt) {
-            mesh_pending_packets_add(pkt, pkt->info.hop_count_max);
+    if (NULL != pkt) {
+        #if (MESH_TX_QUEUE_SIZE > 0)
+        if (mesh_must_queue_pkt(pkt)) {
+            ok = mesh_tx_queue_add(pkt, prio);
+        }
+        else
+        #else
+        (void) prio;
+        #endif
+        {
+            ok = mesh_send_our_pkt(pkt);
         }
     }
     g_locked = false;
@@ -1111,15 +2047,7 @@ uint8_t mesh_get_num_routing_entries(void)
 
 bool mesh_is_route_known(const uint8_t addr)
 {
-    uint8_t idx = 0;
-
-    for (idx = 0; idx < g_rte_tbl_size; idx++) {
-        if (addr == g_rte_table[idx].dst) {
-            return true;
-        }
-    }
-
-    return false;
+    return (MESH_ZERO_ADDR != addr && NULL != mesh_find_rte_tbl_entry(addr));
 }
 
 uint8_t mesh_get_pnd_pkt_count(void)
@@ -1138,23 +2066,48 @@ uint8_t mesh_get_pnd_pkt_count(void)
         }
     }
 
+    return count + mesh_get_queued_pkt_count(MESH_ZERO_ADDR);
+}
+
+uint8_t mesh_get_queued_pkt_count(const uint8_t dst)
+{
+    uint8_t count = 0;
+
+    #if (MESH_TX_QUEUE_SIZE > 0)
+    uint8_t i = 0;
+    for (i = 0; i < g_tx_queue_size; i++) {
+        if (MESH_ZERO_ADDR != g_tx_queue[i].pkt.nwk.dst &&
+            (MESH_ZERO_ADDR == dst || dst == g_tx_queue[i].pkt.nwk.dst)) {
+            ++count;
+        }
+    }
+    #else
+    (void) dst;
+    #endif
+
     return count;
 }
 
 uint32_t mesh_get_expected_ack_time(uint8_t node_addr)
 {
     mesh_rte_table_t *e =  mesh_find_rte_tbl_entry(node_addr);
-    uint32_t timeout = e ? (1 + e->num_hops) * MESH_ACK_TIMEOUT_MS :
+    uint32_t timeout = e ? mesh_get_ack_timeout(e, e->num_hops) :
                            (MESH_ACK_TIMEOUT_MS * MESH_RTE_DISCOVERY_HOPS);
     return timeout;
 }
 
 uint32_t mesh_get_max_timeout_before_packet_fails(uint8_t node_addr)
 {
-    mesh_rte_table_t *e =  mesh_find_rte_tbl_entry(node_addr);
-    uint32_t timeout = e ? (1 + e->num_hops) * g_retry_count * MESH_ACK_TIMEOUT_MS :
-                           (g_retry_count * MESH_ACK_TIMEOUT_MS * MESH_RTE_DISCOVERY_HOPS);
-    return timeout;
+    uint32_t timeout = mesh_get_expected_ack_time(node_addr);
+    uint32_t total = timeout;
+    uint8_t i = 0;
+
+    /* Each retry waits twice as long as the previous one */
+    for (i = 0; i < g_retry_count; i++) {
+        timeout = mesh_get_backoff_timeout(timeout);
+        total += timeout;
+    }
+    return total;
 }
 
 #if MESH_USE_STATISTICS
@@ -1164,6 +2117,34 @@ mesh_stats_t mesh_get_stats(void)
 }
 #endif
 
+#if MESH_USE_LINK_STATISTICS
+const mesh_link_stats_t* mesh_get_link_stats(const uint8_t index)
+{
+    return (index < g_link_stats_size && MESH_ZERO_ADDR != g_link_stats[index].node) ?
+           &g_link_stats[index] : NULL;
+}
+
+const mesh_link_stats_t* mesh_get_link_stats_table(void)
+{
+    return &g_link_stats[0];
+}
+#endif
+
+uint16_t mesh_get_link_etx(const uint8_t node)
+{
+    return mesh_get_link_etx_x16(node);
+}
+
+uint32_t mesh_get_next_beacon_ms(void)
+{
+    #if (MESH_BEACON_INTERVAL_MS > 0)
+    const int32_t remaining = (int32_t) (g_beacon_due_ms - g_prev_time_ms);
+    return (remaining > 0) ? (uint32_t) remaining : 0;
+    #else
+    return UINT32_MAX;
+    #endif
+}
+
 mesh_error_mask_t mesh_get_error_mask(void)
 {
     return g_error_mask;
@@ -1178,3 +2159,7 @@ void mesh_reset_error_mask(void)
 #if (MESH_INCLUDE_TESTS)
 #include "mesh_test.c.inc"
 #endif
+
+#if (MESH_INCLUDE_SIM)
+#include "mesh_sim.c.inc"
+#endif
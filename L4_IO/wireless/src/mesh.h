@@ -180,6 +180,19 @@ bool mesh_send(const uint8_t dst, const mesh_protocol_t type,
                const void* pData, const uint8_t len,
                const uint8_t hop_count_max);
 
+/**
+ * Same as mesh_send() with the priority of the packet in the queue of MESH_TX_QUEUE_SIZE.
+ * If all of our pending packets are waiting for their ACK, our ACK packet is queued and
+ * sent later by mesh_service(), rather than overwriting one of our pending packets.
+ *
+ * @returns true if the packet was sent or queued, false if the queue is full.
+ * @note Queued packets are sent in order of their priority, so a control packet can be
+ *       sent before the bulk data that was queued before it.
+ */
+bool mesh_send_prio(const uint8_t dst, const mesh_protocol_t type,
+                    const void* pData, const uint8_t len,
+                    const uint8_t hop_count_max, const mesh_prio_t prio);
+
 /**
  * Form a packet by copying the data from the given pointers as variable arguments.
  * @see parameters of mesh_send()
@@ -221,6 +234,9 @@ bool mesh_form_pkt(mesh_packet_t *pkt, const uint8_t dst,
  */
 bool mesh_send_formed_pkt(mesh_packet_t *pkt);
 
+/// Same as mesh_send_formed_pkt() with the priority of the packet @see mesh_send_prio()
+bool mesh_send_formed_pkt_prio(mesh_packet_t *pkt, const mesh_prio_t prio);
+
 /**
  * This does the opposite of mesh_form_pkt().  Instead of copying data from the
  * pointers and storing to the packet data, this will copy the data from the packet
@@ -240,6 +256,23 @@ bool mesh_send_formed_pkt(mesh_packet_t *pkt);
  */
 bool mesh_deform_pkt(mesh_packet_t *pkt, uint8_t num_ptrs, ...);
 
+/**
+ * Converts a packet to the frame that the radio driver sends.  If the packet is between
+ * direct neighbors (see mesh_pkt_is_compact()), the frame has the compact header, and its
+ * version is MESH_VERSION_COMPACT, otherwise the frame is the header and the data of the packet.
+ * @param pkt    The packet given to radio_send() of the driver.
+ * @param frame  The frame of at least MESH_PAYLOAD bytes; this may not be the same as pkt.
+ * @returns The bytes of the frame.
+ */
+uint8_t mesh_pkt_compact(const mesh_packet_t *pkt, void *frame);
+
+/**
+ * Converts the frame the radio driver received, in place, to the packet given to mesh_service().
+ * @param pkt  The received frame, of MESH_PAYLOAD bytes.
+ * @returns true if the frame had the compact header and was expanded.
+ */
+bool mesh_pkt_expand(mesh_packet_t *pkt);
+
 
 /**
  * After a packet is obtained, this method should be called to check if ACK is required.
@@ -298,10 +331,17 @@ bool mesh_is_route_known(const uint8_t addr);
  * packets, then mesh_service() doesn't have to be called periodically.
  *
  * @returns The number of packets that are in the pending state, means they are waiting
- *          to be acknowledged, or repeated after a timeout.
+ *          to be acknowledged, or repeated after a timeout, or are queued to be sent.
  */
 uint8_t mesh_get_pnd_pkt_count(void);
 
+/**
+ * @param dst  The destination, or MESH_ZERO_ADDR to count the packets to every destination.
+ * @returns The number of our packets waiting in the queue of MESH_TX_QUEUE_SIZE.  A sender
+ *          can use this to hold off its next packets, rather than having mesh_send() fail.
+ */
+uint8_t mesh_get_queued_pkt_count(const uint8_t dst);
+
 /**
  * @returns the expected number of milliseconds it should take for the destination node
  *          to send us an ACK packet.  This is the most ideal time assuming no packet
@@ -317,6 +357,21 @@ uint32_t mesh_get_expected_ack_time(uint8_t node_addr);
  */
 uint32_t mesh_get_max_timeout_before_packet_fails(uint8_t node_addr);
 
+/**
+ * @returns the expected transmission count (ETX) of the link to a neighbor in 1/16 units,
+ *          so 16 is a perfect link.  A node whose beacons were not heard also returns 16,
+ *          and a neighbor whose beacons are all lost returns UINT16_MAX.
+ * @see MESH_BEACON_INTERVAL_MS
+ */
+uint16_t mesh_get_link_etx(const uint8_t node);
+
+/**
+ * @returns the milliseconds until mesh_service() sends our next beacon, or UINT32_MAX if
+ *          the beacons are disabled.  mesh_service() should be called by then even if
+ *          there are no packets to receive or send.
+ */
+uint32_t mesh_get_next_beacon_ms(void);
+
 /**
  * @{ Mesh API to get error types and reset errors
  * Mesh layer keeps error bit fields during its operation.  The error mask can be obtained
@@ -339,6 +394,18 @@ void mesh_reset_error_mask(void);            ///< Resets the error mask to zero.
 mesh_stats_t mesh_get_stats(void);
 #endif
 
+#if MESH_USE_LINK_STATISTICS
+/**
+ * Allows user to query the statistics of each node we exchanged packets with.
+ * @param index  The entry to query : 0 - (MESH_LINK_STATS_SIZE-1)
+ * @returns NULL if the entry is not used
+ */
+const mesh_link_stats_t* mesh_get_link_stats(const uint8_t index);
+
+/// @returns the array of MESH_LINK_STATS_SIZE entries (including unused entries), for telemetry
+const mesh_link_stats_t* mesh_get_link_stats_table(void);
+#endif
+
 
 
 #ifdef __cplusplus
@@ -33,6 +33,11 @@ extern "C" {
  * Each payload header contains mesh version to detect version mismatch.
  *
  * Version info :
+ *   4b  - No change to the protocol.  Our ACK packets wait in the queue of MESH_TX_QUEUE_SIZE
+ *          when our pending packets are full, see mesh_send_prio().
+ *   4   - The packets between direct neighbors are sent with the compact header, which has
+ *          MESH_VERSION_COMPACT, and their data can be up to MESH_DIRECT_PAYLOAD_SIZE bytes.
+ *          The radio driver uses mesh_pkt_compact() and mesh_pkt_expand() on the frames.
  *   3c  - No change.  Changed all "m_" to "g_" (coding standard)
  *   3b  - No change to algorithm; added more methods:
  *          - mesh_is_ack_ok()
@@ -58,7 +63,10 @@ extern "C" {
  *  1a- Minor update to add mesh_error_mask_t
  *  1 - Initial version
  */
-#define MESH_VERSION                3
+#define MESH_VERSION                4
+
+/// The version of the compact header, which is only understood by the nodes of MESH_VERSION
+#define MESH_VERSION_COMPACT        (MESH_VERSION + 1)
 
 /**
  * The payload that your radio driver can carry.  Part of the payload
@@ -68,14 +76,16 @@ extern "C" {
 
 /**
  * Defines the number of buffers we use for various purposes :
- *  - Routing table consisting of destination, and source address (4 bytes each)
- *  - Previous packets to avoid duplicate transmission (3 bytes each)
+ *  - Routing table consisting of destination, source address, and round trip time (8 bytes each)
+ *  - Previous packets to avoid duplicate transmission (7 bytes each)
  *  - Mesh packets used to retransmit a lost packet (payload + 4 bytes each)
  *
  *  The formula for the RAM requirement is :
- *  (4 * N) + (3 * N) + N*(PL + 4) + M*(PL + 4)
+ *  256 + (8 * N) + (7 * H) + N*(PL + 4) + M*(PL + 4)
  *  where N = MESH_MAX_NODES
  *    and M = MESH_MAX_PEND_PKTS
+ *    and H = MESH_PKT_HISTORY_SIZE
+ *  The 256 bytes index the routing table by the node address.
  *
  *  This should be ideally the max nodes this node can communicate with.  If there
  *  are too many neighboring nodes, such as 20, a lower number like 10 can be used,
@@ -83,7 +93,9 @@ extern "C" {
  *  to be rediscovered as they may be over-written.  Furthermore, the node may drop
  *  packets that it may be responsible to repeat.
  */
+#ifndef MESH_MAX_NODES
 #define MESH_MAX_NODES              4
+#endif
 
 /**
  * This defines dedicated buffer size of OUR packets sent to others by mesh_send().
@@ -94,7 +106,40 @@ extern "C" {
  *
  * Minimum should be 2, one for outgoing packet, and one for an ACK packet.
  */
+#ifndef MESH_MAX_PEND_PKTS
 #define MESH_MAX_PEND_PKTS          2
+#endif
+
+/**
+ * The queue of our ACK packets that wait for a free slot of our pending packets.  Instead of
+ * overwriting one of our pending packets, mesh_send() queues the packet, and mesh_service()
+ * sends one queued packet at a time as the slots are freed; the higher priority first, and
+ * the older first within the same priority (see mesh_prio_t).  When the queue is full,
+ * mesh_send() returns false, and mesh_get_queued_pkt_count() tells how many are waiting.
+ *
+ * Each entry uses PL + 6 bytes.  Set this to 0 to overwrite our pending packets like before.
+ */
+#ifndef MESH_TX_QUEUE_SIZE
+#define MESH_TX_QUEUE_SIZE          4
+#endif
+
+/**
+ * @{ Packet history used to discard duplicate packets.
+ *
+ * MESH_PKT_HISTORY_SIZE :
+ * The history is a hash table indexed by the source address and the packet id, so
+ * the lookup of each received packet does not depend on the size of the history.
+ * This must be a power of 2, and should be a few times more than MESH_MAX_NODES.
+ *
+ * MESH_PKT_HISTORY_TIMEOUT_MS :
+ * A history entry older than this time no longer marks a packet as a duplicate.
+ * This should be more than the time it takes for all the retries of a packet to
+ * travel through the mesh network, but less than the time a node takes to wrap
+ * around its 8-bit packet id.
+ */
+#define MESH_PKT_HISTORY_SIZE       16
+#define MESH_PKT_HISTORY_TIMEOUT_MS 1000
+/** @} */
 
 /**
  * @{ Mesh packet timeout and route configuration.
@@ -114,17 +159,40 @@ extern "C" {
  * time for intermediate node(s) to wait for destination to respond before
  * they repeat the packet hoping it will go to its final destination.
  *
+ * MESH_ACK_TIMEOUT_MIN_MS and MESH_ACK_TIMEOUT_MAX_MS
+ * The round trip time of each route is measured from the ACKs of our packets, and once
+ * measured, it replaces the hop based MESH_ACK_TIMEOUT_MS of the route.  Each retry then
+ * doubles the timeout of the packet.  These limit the measured and the doubled timeouts.
+ *
  * MESH_RTE_DISCOVERY_HOPS
  * When a route is discovered, it is saved for future use.  When a packet to
  * this known route fails, the packet needs to discover a new route, and we
  * use this many hops to find its new route.  If route still fails, then the
  * user should manually send a new packet with higher max-hop-count
+ *
+ * MESH_FLOOD_JITTER_MS and MESH_FLOOD_COPIES_MAX
+ * The repeat of a route discovery or a broadcast packet is held off by a random time of
+ * up to MESH_FLOOD_JITTER_MS after MESH_PKT_DISC_TIMEOUT_MS.  If we hear the packet
+ * MESH_FLOOD_COPIES_MAX times (including the copy we received) before then, the repeat
+ * is cancelled, so in a dense network only the first few nodes to time out repeat a flood.
+ * Set MESH_FLOOD_COPIES_MAX to zero to always repeat the flood packets.
  */
 #define MESH_ACK_TIMEOUT_MS          8  ///< Packet is retried if an ACK is not received within this time.
 #define MESH_PKT_DISC_TIMEOUT_MS     4  ///< Destined node is given this time before we send repeat the packet.
+#define MESH_ACK_TIMEOUT_MIN_MS      2  ///< Minimum timeout of a route with measured round trip time.
+#define MESH_ACK_TIMEOUT_MAX_MS    500  ///< Maximum timeout, including the exponential backoff of retries.
 #define MESH_RTE_DISCOVERY_HOPS      3  ///< Number of hops to use when a routed packet fails.
+#define MESH_FLOOD_JITTER_MS         4  ///< Max random hold-off added to the repeat of a flood packet.
+#define MESH_FLOOD_COPIES_MAX        3  ///< Repeat of a flood packet is cancelled after hearing this many copies.
 /** @} */
 
+/**
+ * A routed packet through us whose next hop is already known is repeated as soon as it is
+ * received, and the history, routing and pending packets are updated after it is sent.
+ * Set to zero to repeat it after the bookkeeping instead.
+ */
+#define MESH_CUT_THROUGH            1
+
 /**
  * @{ Special mesh addresses - Do not change these.
  */
@@ -141,6 +209,41 @@ extern "C" {
  */
 #define MESH_USE_STATISTICS         1
 
+/**
+ * @{ Statistics of each node we exchange packets with, see mesh_get_link_stats().
+ * MESH_LINK_STATS_SIZE entries are kept, and the entry with the fewest packets is
+ * reused for a new node.  Each entry uses 2 + 2 * (5 + R + T) bytes
+ * where R = MESH_LINK_RETRY_BINS and T = MESH_LINK_RTT_BINS.
+ *
+ * Bin N of the RTT histogram counts the round trip times of 2^N to 2^(N+1)-1 ms, except
+ * that the first bin includes 0ms and the last bin includes the longer times.
+ */
+#define MESH_USE_LINK_STATISTICS    1
+#define MESH_LINK_STATS_SIZE        MESH_MAX_NODES
+#define MESH_LINK_RETRY_BINS        4   ///< The last bin counts this many retries minus 1, or more
+#define MESH_LINK_RTT_BINS          8
+/** @} */
+
+/**
+ * @{ Neighbor beacons and the expected transmission count (ETX) of each link.
+ *
+ * Every MESH_BEACON_INTERVAL_MS (with some jitter), each node sends a beacon to its neighbors
+ * that is not repeated, and lists how much of the beacons of each neighbor it received.
+ * The delivery ratio of a link is measured over the last MESH_BEACON_WINDOW beacons in each
+ * direction, and its ETX is 1 / (forward ratio * reverse ratio).  A route is then chosen by the
+ * ETX of its next hop plus one transmission for each of the remaining hops, so a longer route
+ * over good links wins over a route through a lossy link that eats the retries.
+ *
+ * A neighbor whose last MESH_BEACON_LOSS_MAX beacons were missed is dropped along with the
+ * routes through it, so its routes are discovered again before our packets fail over them.
+ * Each neighbor uses 6 bytes; set MESH_BEACON_INTERVAL_MS to zero to disable the beacons.
+ */
+#define MESH_BEACON_INTERVAL_MS     1000
+#define MESH_BEACON_WINDOW          16  ///< Beacons the delivery ratio is measured over (16 max)
+#define MESH_BEACON_LOSS_MAX        4   ///< A neighbor is dropped after missing this many beacons
+#define MESH_MAX_NEIGHBORS          MESH_MAX_NODES
+/** @} */
+
 /**
  * Optionally, define the debug print method.
  */
@@ -160,6 +263,15 @@ extern "C" {
  */
 #define MESH_INCLUDE_TESTS          0
 
+/**
+ * If this is set to non-zero, then the mesh.c will include the host simulator of many
+ * nodes with its main() function; @see mesh_sim.c.inc for how to build it.
+ * This is set from the command line of the host build with -DMESH_INCLUDE_SIM=1
+ */
+#ifndef MESH_INCLUDE_SIM
+#define MESH_INCLUDE_SIM            0
+#endif
+
 
 
 #ifdef __cplusplus
@@ -42,6 +42,13 @@ extern "C" {
 /** Typedef of Function Pointer */
 typedef int(*mesh_fptr_t)(void* pData, int data_len);
 
+/**
+ * The driver's radio_send() can return this value when the radio hardware of mac.dst
+ * acknowledged our packet.  For our mesh_pkt_ack packet to a direct neighbor, this
+ * means the neighbor will not send an ACK_RSP packet, so the mesh produces one for us.
+ */
+#define MESH_RADIO_SEND_ACKED  2
+
 /**
  * Structure of the mesh driver used to send/receive data.
  * Examples of these functions are given at mesh.h
@@ -52,16 +59,18 @@ typedef struct
     mesh_fptr_t app_recv;   ///< Application call-back. Return true upon success.
     mesh_fptr_t get_timer;  ///< Get timer value in ms. Return true upon success.
     mesh_fptr_t radio_init; ///< Initialize the RADIO.  Return true upon success.
-    mesh_fptr_t radio_send; ///< Send a packet.         Return value not checked.
+    mesh_fptr_t radio_send; ///< Send a packet (header and data_len bytes).  Return MESH_RADIO_SEND_ACKED if hardware ACK was received.
     mesh_fptr_t radio_recv; ///< Receive a packet.      Return true if valid packet returned.
 } mesh_driver_t;
 
 /// Routing table type
 typedef struct {
-    uint8_t dst;      ///< Destination ID
-    uint8_t next_hop; ///< Next destination to get to dst
-    uint8_t num_hops; ///< Number of hops to dst
-    uint8_t score;    ///< The score of this route (higher if used more often)
+    uint8_t dst;        ///< Destination ID
+    uint8_t next_hop;   ///< Next destination to get to dst
+    uint8_t num_hops;   ///< Number of hops to dst
+    uint8_t score;      ///< The score of this route (higher if used more often)
+    uint16_t srtt_x8;   ///< Smoothed round trip time to dst in 1/8 ms, zero if not measured yet
+    uint16_t rttvar_x4; ///< Variation of the round trip time in 1/4 ms
 } mesh_rte_table_t;
 
 #if MESH_USE_STATISTICS
@@ -82,6 +91,21 @@ typedef struct {
 } __attribute__((packed)) mesh_stats_t;
 #endif
 
+#if MESH_USE_LINK_STATISTICS
+/// Statistics of the packets exchanged with one node
+typedef struct {
+    uint8_t node;                               ///< Node address, MESH_ZERO_ADDR if unused
+    uint8_t reserved;
+    uint16_t pkts_acked;                        ///< Our packets to node that were acknowledged
+    uint16_t pkts_failed;                       ///< Our packets to node that ran out of retries
+    uint16_t duplicates;                        ///< Duplicate packets received from node
+    uint16_t queue_drops;                       ///< Pending packets to node that were overwritten, or did not fit the queue
+    uint16_t route_changes;                     ///< Times the route to node has changed
+    uint16_t retry_hist[MESH_LINK_RETRY_BINS];  ///< Acknowledged packets by the number of retries
+    uint16_t rtt_hist[MESH_LINK_RTT_BINS];      ///< Round trip times of the packets that were not retried
+} mesh_link_stats_t;
+#endif
+
 /// Mesh packet type
 typedef enum {
     mesh_pkt_nack=0,    ///< No ACK - Must be value of 0
@@ -90,6 +114,13 @@ typedef enum {
     mesh_pkt_ack_rsp,   ///< Response packet of an ACK
 } mesh_protocol_t;
 
+/// Priority of our packet in the queue of MESH_TX_QUEUE_SIZE @see mesh_send_prio()
+typedef enum {
+    mesh_prio_bulk = 0,     ///< Bulk data, sent after the other packets
+    mesh_prio_normal,       ///< Priority of mesh_send()
+    mesh_prio_control,      ///< Control packets, sent before the other packets
+} mesh_prio_t;
+
 /// Mesh error types
 typedef enum {
     mesh_err_none = 0,
@@ -134,6 +165,32 @@ typedef struct {
 /// Size of the data payload (Do not modify)
 #define MESH_DATA_PAYLOAD_SIZE      (MESH_PAYLOAD - MESH_PAYLOAD_HEADER_SIZE)
 
+/**
+ * The compact header of a packet between direct neighbors.  The nwk addresses are the same as
+ * the mac addresses, and both hop counts are zero, so they are not sent.  The version is at the
+ * same offset as the version of the full header, so the receiver can tell the two apart.
+ * @see mesh_pkt_compact() and mesh_pkt_expand()
+ */
+typedef struct {
+    mesh_pkt_addr_t addr;       ///< Both the nwk and the mac address
+
+    uint8_t pkt_seq_num;        ///< Sequence number of the packet.
+    uint8_t data_len;           ///< Length of the packet data
+
+    uint8_t version     : 3;    ///< MESH_VERSION_COMPACT
+    uint8_t retries_rem : 3;    ///< Packet retries remaining
+    uint8_t pkt_type    : 2;    ///< The type of mesh packet @see mesh_protocol_t
+} __attribute__((packed)) mesh_pkt_compact_hdr_t;
+
+/// Size of the compact header
+#define MESH_COMPACT_HEADER_SIZE    (sizeof(mesh_pkt_compact_hdr_t))
+
+/**
+ * Size of the data payload of a packet to a direct neighbor, which is sent with the compact header.
+ * A packet with more than MESH_DATA_PAYLOAD_SIZE bytes cannot be routed through other nodes.
+ */
+#define MESH_DIRECT_PAYLOAD_SIZE    (MESH_PAYLOAD - MESH_COMPACT_HEADER_SIZE)
+
 #if (MESH_PAYLOAD <= 8) /* M_TODO : How do I calculate a compile time sizeof() instead of using hard-coded value? */
 #error "Mesh payload size is too small; it should be bigger than MESH_PAYLOAD_HEADER_SIZE"
 #endif
@@ -146,9 +203,20 @@ typedef struct
     mesh_pkt_addr_t nwk;                    ///< Packet network address
     mesh_pkt_addr_t mac;                    ///< Packet physical address
     mesh_pkt_info_t info;                   ///< Packet header
-	uint8_t data[MESH_DATA_PAYLOAD_SIZE];   ///< Actual data within the payload
+	uint8_t data[MESH_DIRECT_PAYLOAD_SIZE]; ///< Actual data within the payload
 } __attribute__((packed)) mesh_packet_t;
 
+/**
+ * @returns true if the packet is sent with the compact header, which is the packet (or the
+ *          ACK response) to a direct neighbor that is not repeated by any other node.
+ */
+static inline bool mesh_pkt_is_compact(const mesh_packet_t *pkt)
+{
+    return (pkt->nwk.src == pkt->mac.src && pkt->nwk.dst == pkt->mac.dst &&
+            0 == pkt->info.hop_count && 0 == pkt->info.hop_count_max &&
+            MESH_ZERO_ADDR != pkt->mac.dst);
+}
+
 
 
 #ifdef __cplusplus
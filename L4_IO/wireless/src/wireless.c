@@ -17,47 +17,259 @@
  */
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "wireless.h"
 #include "FreeRTOS.h"
 #include "queue.h"
 #include "task.h"
 #include "semphr.h"
+#include "os_signal.h"
 
 #include "mesh.h"
 #include "nrf24L01Plus.h"
+#include "wireless_bulk_prv.h"
 #include "sys_config.h"   /* WIRELESS_CHANNEL_NUM */
 #include "lpc_sys.h"
 #include "eint.h"
+#include "profile.h"
+#include "msg_buffer.h"
 
 
 
-static QueueHandle_t g_rx_queue = NULL;     ///< Queue handle for RX queue
+static QueueHandle_t g_rx_queue = NULL;     ///< Queue of the pointers of the RX packets of g_pkt_pool[]
 static QueueHandle_t g_ack_queue = NULL;    ///< Queue handle for RX Ack packet
-static SemaphoreHandle_t g_nrf_activity_sem = NULL; ///< If FreeRTOS is running, we will not poll for nordic activity
+static os_signal_t g_nrf_activity = OS_SIGNAL_INIT; ///< If FreeRTOS is running, we will not poll for nordic activity
+static SemaphoreHandle_t g_rx_event = NULL;         ///< Given when a packet is queued to g_rx_queue
+static volatile uint64_t g_rx_irq_time_us = 0;     ///< Uptime of the last RX interrupt, used by the time beacons
+static uint64_t g_rx_pkt_time_us = 0;               ///< Uptime of the RX interrupt of the packet given to the mesh
+
+/**
+ * @{ The frames are moved from the radio FIFO by wireless_radio_service() of the critical
+ * priority task, and the mesh logic of wireless_service() runs at a lower priority.  If the
+ * radio task is not running, wireless_service() reads the radio itself.  The radio mutex
+ * serializes the SPI access of both tasks and the application tasks that send packets.
+ */
+typedef struct {
+    uint64_t rx_time_us;        ///< Uptime of the RX interrupt of the frame
+    mesh_packet_t pkt;
+} wireless_radio_frame_t;
+
+/// The bytes of a frame of g_radio_rx: the time, the header and the data_len bytes of the data
+#define WIRELESS_RADIO_FRAME_LEN(p)     (offsetof(wireless_radio_frame_t, pkt) + MESH_PAYLOAD_HEADER_SIZE + \
+                                         (((p)->info.data_len < MESH_DIRECT_PAYLOAD_SIZE) ? (p)->info.data_len : MESH_DIRECT_PAYLOAD_SIZE))
+
+static uint8_t g_radio_rx_storage[WIRELESS_RADIO_RX_BYTES];   ///< The storage of g_radio_rx
+static msg_buffer_t g_radio_rx;                     ///< Frames read by wireless_radio_service(), only as long as their data
+static os_signal_t g_radio_signal = OS_SIGNAL_INIT; ///< Given by the radio IRQ to wake up wireless_radio_service()
+static SemaphoreHandle_t g_radio_mutex = NULL;      ///< Held during the SPI access of the radio
+static volatile bool g_radio_task = false;          ///< Set once wireless_radio_service() is running
+/** @} */
+
+/// Messages of wireless_send_batched() waiting to be sent to one destination
+typedef struct {
+    uint8_t dst;                ///< Destination address
+    uint8_t protocol;           ///< @see mesh_protocol_t
+    uint8_t max_hops;           ///< Maximum hops of the packet
+    uint8_t len;                ///< Bytes used in data[], 0 if this slot is free
+    TickType_t deadline;        ///< Tick when this batch is sent
+    uint8_t data[MESH_DATA_PAYLOAD_SIZE];
+} wireless_batch_t;
+
+static wireless_batch_t g_tx_batches[WIRELESS_BATCH_SLOTS]; ///< Open batches of wireless_send_batched()
+static mesh_packet_t *g_rx_batch_ref = NULL; ///< Received batch packet being unpacked by wireless_get_rx_pkt_ref()
+static uint8_t g_rx_batch_offset = 0;       ///< Offset of the next message of g_rx_batch_ref
+
+/**
+ * @{ Reference counted buffers of the received packets.
+ * The mesh callback copies a packet once into a free buffer, and then only the pointer
+ * travels through the RX queue to the application.  A buffer is free if its count is 0.
+ */
+#if (WIRELESS_PKT_POOL_SIZE < WIRELESS_RX_QUEUE_SIZE + 2)
+#error "WIRELESS_PKT_POOL_SIZE should hold the RX queue, one batch packet and one application packet"
+#endif
+static mesh_packet_t g_pkt_pool[WIRELESS_PKT_POOL_SIZE];
+static uint8_t g_pkt_refs[WIRELESS_PKT_POOL_SIZE];
+/** @} */
+
+/**
+ * @{ Hardware ACK (Enhanced Shockburst) of the packets to a direct neighbor
+ * Every node listens to the shared mesh address on Pipe0 without auto-ack, and to its own
+ * address on Pipe1 with auto-ack.  The LSB of a node's own address is its node address.
+ * With WIRELESS_DYN_PAYLOAD, Pipe0 also needs the auto-ack, but the mesh packets have the
+ * NO_ACK flag so nobody acknowledges them.
+ */
+#define WIRELESS_HW_ACK_PIPE    1
+#define WIRELESS_HW_ACK_ADDR    { 0x00, 0xC3, 0x5A, 0xE7, 0xE7 }
+static uint8_t g_hw_ack_our_addr = 0;       ///< The node address our Pipe1 listens to
+/** @} */
+
+/**
+ * @{ Per-link air data rate of WIRELESS_LINK_RATE
+ * Every node listens at WIRELESS_AIR_DATARATE_KBPS, which is the rate of the broadcasts and the
+ * slowest rate of every link.  Our packets with hardware ACK to a direct neighbor step up to the
+ * next rate after WIRELESS_RATE_UP_PKTS of them were ACKed on the first try, and step back down
+ * once one is retried or lost.  Before we send at a faster rate, a wake-up frame at the common
+ * rate to the neighbor's Pipe1 moves the neighbor to that rate, and it stays there until it
+ * receives nothing on Pipe1 for WIRELESS_RATE_WINDOW_MS.  Meanwhile it misses the traffic at
+ * the common rate, which the mesh retries cover.
+ */
+#if (WIRELESS_LINK_RATE && !WIRELESS_HW_ACK)
+#error "WIRELESS_LINK_RATE needs WIRELESS_HW_ACK"
+#endif
+#define WIRELESS_RATE_MARKER        0xA5    ///< nwk.dst of the wake-up frame, whose nwk.src is MESH_ZERO_ADDR
+#define WIRELESS_RATE_WINDOW_MS     20      ///< The neighbor returns to the common rate after this idle time
+#define WIRELESS_RATE_SWITCH_US     500     ///< Time for the neighbor to switch after it ACKed the wake-up frame
+#define WIRELESS_RATE_UP_PKTS       16      ///< Packets ACKed on the first try before we try the next rate
+#define WIRELESS_RATE_LINKS         8       ///< Number of neighbors whose rate we remember
+static const uint16_t g_rates_kbps[] = { 250, 1000, 2000 };
+#define WIRELESS_NUM_RATES          (sizeof(g_rates_kbps) / sizeof(g_rates_kbps[0]))
+
+typedef struct {
+    uint8_t addr;               ///< The neighbor, or MESH_ZERO_ADDR if this entry is free
+    uint8_t rate_idx;           ///< The rate of g_rates_kbps[] we send at
+    uint8_t ok_run;             ///< Packets ACKed on the first try at rate_idx
+    uint32_t awake_ms;          ///< The neighbor listens at rate_idx until this time
+} wireless_link_rate_t;
+
+static wireless_link_rate_t g_link_rates[WIRELESS_RATE_LINKS];
+static uint8_t g_link_rate_next = 0;        ///< The entry of g_link_rates[] replaced next
+static uint8_t g_common_rate_idx = 0;       ///< The index of WIRELESS_AIR_DATARATE_KBPS
+static uint8_t g_radio_rate_idx = 0;        ///< The rate the radio is set to
+static uint8_t g_rx_rate_idx = 0;           ///< The rate we listen at
+static uint32_t g_rx_rate_until_ms = 0;     ///< We listen at the faster rate until this time
+/** @} */
+
+/**
+ * @{ Low-power listening (radio duty cycling) of WIRELESS_LPL
+ * A node whose class has an interval powers down its radio, and every interval it powers it up
+ * to listen for WIRELESS_LPL_LISTEN_US.  If it hears a frame or a carrier, it stays awake until
+ * it is idle for WIRELESS_LPL_AWAKE_MS, and it is also awake for that long after it sends.
+ * Before a packet to a sleeping neighbor, the sender repeats a short wake-up frame (strobe) that
+ * names the destination and the time left until the packet, such that the other neighbors go
+ * back to sleep right away.
+ *
+ * Once both nodes are synced, the neighbor wakes up at the multiples of its interval of the
+ * network time, so the sender waits for the wake-up and only strobes around it for the error
+ * of the time.  Otherwise the sender strobes for the whole interval.  The class and the sync of
+ * a neighbor are learned from its strobes, and a sleeping node announces them with a strobe to
+ * nobody before it sends, every WIRELESS_LPL_ANNOUNCE_MS.
+ */
+#define WIRELESS_LPL_MARKER         0xA6    ///< nwk.dst of the strobe, whose nwk.src is MESH_ZERO_ADDR
+#define WIRELESS_LPL_POWER_UP_US    1500    ///< Time for the radio to reach Standby-1 after it is powered up
+#define WIRELESS_LPL_LISTEN_US      1500    ///< Time we listen at each wake-up, which is longer than two strobes
+#define WIRELESS_LPL_AWAKE_MS       50      ///< We stay awake after the last packet we sent or received
+#define WIRELESS_LPL_GUARD_US       2000    ///< The error of the network time we allow for the wake-up of a neighbor
+#define WIRELESS_LPL_ANNOUNCE_MS    10000   ///< Period of the announce strobe of a sleeping node
+#define WIRELESS_LPL_NODES          8       ///< Number of neighbors whose class we remember
+static const uint16_t g_lpl_intervals_ms[] = WIRELESS_LPL_INTERVALS_MS;
+#define WIRELESS_LPL_NUM_CLASSES    (sizeof(g_lpl_intervals_ms) / sizeof(g_lpl_intervals_ms[0]))
+
+/// The data of the strobe
+typedef struct {
+    uint8_t src;                ///< The sender
+    uint8_t cls;                ///< The class of the sender
+    uint8_t synced;             ///< 1 if the sender wakes up at the multiples of its interval of the network time
+    uint8_t dst;                ///< The neighbor to wake up, MESH_BROADCAST_ADDR for all, or MESH_ZERO_ADDR for nobody
+    uint8_t remaining_ms[2];    ///< Little-endian time until the packet is sent
+} wireless_lpl_strobe_t;
+
+typedef struct {
+    uint8_t addr;               ///< The neighbor, or MESH_ZERO_ADDR if this entry is free
+    uint8_t cls;                ///< The class of the neighbor
+    bool synced;                ///< The neighbor wakes up at the multiples of its interval of the network time
+    uint32_t awake_ms;          ///< The neighbor is awake until this time
+} wireless_lpl_node_t;
+
+#if WIRELESS_LPL
+static wireless_lpl_node_t g_lpl_nodes[WIRELESS_LPL_NODES];
+static uint8_t g_lpl_node_next = 0;         ///< The entry of g_lpl_nodes[] replaced next
+static uint8_t g_lpl_class = WIRELESS_LPL_CLASS; ///< Our class
+static bool g_lpl_asleep = false;           ///< Our radio is powered down
+static uint32_t g_lpl_awake_ms = 0;         ///< We stay awake until this time
+static uint64_t g_lpl_wake_us = 0;          ///< The uptime of our next wake-up
+static uint32_t g_lpl_announce_ms = 0;      ///< The time of our next announce strobe
+static void wireless_lpl_service(void);     ///< Called by wireless_service() to power down and wake up the radio
+static uint32_t nrf_lpl_get_due_ms(void);   ///< @returns the time until wireless_lpl_service() has something to do
+#endif
+/** @} */
+
+/**
+ * Air time is 1 byte preamble, 5 byte address, 2 byte CRC and 9 bits at the end.
+ * We add 25 just to make sure we satisfy air time requirement.
+ */
+#define WIRELESS_AIR_TIME_US(len)   (25 + (((8 * ((len) + 1 + 5 + 3)) * 1000) / WIRELESS_AIR_DATARATE_KBPS))
+static const uint32_t g_pkt_air_time_us = WIRELESS_AIR_TIME_US(MESH_PAYLOAD); ///< Air time of the largest packet
+
+/** @{ Burst transmit of wireless_tx_burst_begin() */
+#define WIRELESS_TX_MODE_MAX_US 4000                ///< The radio shouldn't stay in Tx mode longer than this
+static TaskHandle_t g_burst_owner = NULL;           ///< The task whose packets are queued
+static uint8_t g_burst_count = 0;                   ///< Packets in g_burst_pkts[]
+static mesh_packet_t g_burst_pkts[WIRELESS_TX_BURST_SIZE];
+static uint8_t g_burst_lens[WIRELESS_TX_BURST_SIZE];  ///< The bytes sent of each of g_burst_pkts[]
+/** @} */
+
+/**
+ * @{ Clear channel assessment and channel hopping
+ * The quality of the current channel is the filtered percentage of the transmissions
+ * that found the channel busy, or that were not acknowledged by the radio's hardware ACK.
+ * With WIRELESS_CHANNEL_HOPPING, a node that finds its channel bad broadcasts a switch to
+ * the best channel of WIRELESS_HOP_CHANNELS, and all nodes switch after the broadcast
+ * had the time to flood the mesh.
+ */
+#define WIRELESS_HOP_SWITCH_DELAY_MS    100     ///< Time for the channel switch broadcast to reach every node
+#define WIRELESS_HOP_EVAL_MS            1000    ///< Period of the channel quality evaluation
+#define WIRELESS_HOP_MIN_PKTS           8       ///< Transmissions needed during a period to evaluate the channel
+#define WIRELESS_HOP_LOST_PERIODS       5       ///< Periods of sending without receiving anything before we search the next channel
+static const uint16_t g_hop_channels[] = WIRELESS_HOP_CHANNELS;
+#define WIRELESS_HOP_NUM_CHANNELS       (sizeof(g_hop_channels) / sizeof(g_hop_channels[0]))
+
+typedef struct {
+    uint8_t chan_idx;           ///< Index of the current channel of g_hop_channels[]
+    uint8_t next_idx;           ///< Index of the channel we switch to at switch_ms
+    uint8_t seq;                ///< Sequence number of the last channel switch
+    bool switch_pending;        ///< true if we will switch the channel at switch_ms
+    uint8_t lost_periods;       ///< Consecutive periods we didn't receive anything
+    uint32_t switch_ms;         ///< Time to switch to next_idx
+    uint32_t eval_ms;           ///< Time of the next channel quality evaluation
+    uint16_t tx_cnt;            ///< Transmissions during this period
+    uint16_t busy_cnt;          ///< Clear channel assessments that found the channel busy during this period
+    uint16_t rx_cnt;            ///< Packets received during this period
+    uint8_t bad_pct[WIRELESS_HOP_NUM_CHANNELS]; ///< Filtered percentage of bad transmissions of each channel
+} wireless_channel_t;
+
+static wireless_channel_t g_chan;
+static void wireless_channel_service(void); ///< Called by wireless_service() to evaluate and switch the channel
+#if WIRELESS_LINK_RATE
+static void wireless_link_rate_service(void); ///< Called by wireless_service() to return to the common rate
+#endif
+/** @} */
 
 /** @{ Functions used for nordic wireless mesh network
  * These are call-back functions for mesh_service() so you shouldn't use these directly.
  */
 static int nrf_driver_init(void* p, int len);     ///< Initializes nordic wireless chip
 static int nrf_driver_send(void* p, int len);     ///< Sends the data over nordic
+static void nrf_send_burst(void);                 ///< Sends the packets queued by nrf_driver_send() during a burst
 static int nrf_driver_receive(void* p, int len);  ///< Gets the data from nordic, returns true if packet was fetched
+static int nrf_read_frame(void* p, int len);      ///< Reads a frame from the nordic FIFO for nrf_driver_receive()
 static int nrf_driver_app_recv(void *p, int len); ///< Application callback function when mesh_service() gets data for us
 static int nrf_driver_get_timer(void *p, int len);///< Get system timer value.
 /** @} */
 
-/// Retrieves a packet from the queue handle with the given timeout.
-static char wireless_get_queued_pkt(QueueHandle_t qhandle, mesh_packet_t *pkt, const uint32_t timeout_ms)
+/// Retrieves an item (packet or packet pointer) from the queue handle with the given timeout.
+static char wireless_get_queued_pkt(QueueHandle_t qhandle, void *item, const uint32_t timeout_ms)
 {
     char ok = 0;
 
     if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
-        ok = xQueueReceive(qhandle, pkt, OS_MS(timeout_ms));
+        ok = xQueueReceive(qhandle, item, OS_MS(timeout_ms));
     }
     else {
         uint64_t timeout_of_char = sys_get_uptime_ms() + timeout_ms;
-        while (! (ok = xQueueReceive(qhandle, pkt, 0))) {
+        while (! (ok = xQueueReceive(qhandle, item, 0))) {
             if (sys_get_uptime_ms() > timeout_of_char) {
                 break;
             }
@@ -67,12 +279,79 @@ static char wireless_get_queued_pkt(QueueHandle_t qhandle, mesh_packet_t *pkt, c
     return ok;
 }
 
+/**
+ * @{ The packet pool is shared by the wireless task and the application tasks.
+ * Before FreeRTOS is running, everything runs from one context so no lock is needed.
+ */
+static void wireless_pool_lock(void)
+{
+    if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        taskENTER_CRITICAL();
+    }
+}
+static void wireless_pool_unlock(void)
+{
+    if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        taskEXIT_CRITICAL();
+    }
+}
+/** @} */
+
+/**
+ * @{ Lock of the radio, which is not needed before FreeRTOS is running.
+ * Non-recursive, so only the outer functions that access the radio take it.
+ */
+static void nrf_radio_lock(void)
+{
+    if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        xSemaphoreTake(g_radio_mutex, portMAX_DELAY);
+    }
+}
+static void nrf_radio_unlock(void)
+{
+    if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        xSemaphoreGive(g_radio_mutex);
+    }
+}
+/** @} */
+
+/// @returns true if there are frames the mesh logic of wireless_service() should handle
+static bool wireless_radio_pending(void)
+{
+    return g_radio_task ? !msg_buffer_is_empty(&g_radio_rx) : nordic_intr_signal();
+}
+
+/// @returns a free buffer of the pool with a reference count of 1, or NULL if none are free
+static mesh_packet_t* wireless_pkt_alloc(void)
+{
+    mesh_packet_t *pkt = NULL;
+    uint32_t i = 0;
+
+    wireless_pool_lock();
+    for (i = 0; i < WIRELESS_PKT_POOL_SIZE; i++) {
+        if (0 == g_pkt_refs[i]) {
+            g_pkt_refs[i] = 1;
+            pkt = &g_pkt_pool[i];
+            break;
+        }
+    }
+    wireless_pool_unlock();
+
+    return pkt;
+}
+
+/// @returns the index of the pool buffer, or WIRELESS_PKT_POOL_SIZE if pkt is not from the pool
+static uint32_t wireless_pkt_index(const mesh_packet_t *pkt)
+{
+    const uint32_t i = pkt - &g_pkt_pool[0];
+    return (pkt >= &g_pkt_pool[0] && i < WIRELESS_PKT_POOL_SIZE) ? i : WIRELESS_PKT_POOL_SIZE;
+}
+
 /// ISR callback function upon NRF IRQ rising edge interrupt
-static void nrf_irq_callback(void)
+static RAMFUNC void nrf_irq_callback(void)
 {
-    long yieldRequired = 0;
-    xSemaphoreGiveFromISR(g_nrf_activity_sem, &yieldRequired);
-    portEND_SWITCHING_ISR(yieldRequired);
+    g_rx_irq_time_us = sys_get_uptime_us();
+    portEND_SWITCHING_ISR(os_signal_give_from_isr(g_radio_task ? &g_radio_signal : &g_nrf_activity));
 }
 
 
@@ -90,9 +369,251 @@ bool wireless_init(void)
     return mesh_init(WIRELESS_NODE_ADDR, true, WIRELESS_NODE_NAME, driver, false);
 }
 
+void wireless_pkt_retain(mesh_packet_t *pkt)
+{
+    const uint32_t i = wireless_pkt_index(pkt);
+
+    if (i < WIRELESS_PKT_POOL_SIZE) {
+        wireless_pool_lock();
+        if (g_pkt_refs[i] && g_pkt_refs[i] < UINT8_MAX) {
+            g_pkt_refs[i]++;
+        }
+        wireless_pool_unlock();
+    }
+}
+
+void wireless_pkt_release(mesh_packet_t *pkt)
+{
+    const uint32_t i = wireless_pkt_index(pkt);
+
+    if (i < WIRELESS_PKT_POOL_SIZE) {
+        wireless_pool_lock();
+        if (g_pkt_refs[i]) {
+            g_pkt_refs[i]--;
+        }
+        wireless_pool_unlock();
+    }
+}
+
+bool wireless_pkt_forward(mesh_packet_t *pkt, uint8_t dst_addr, mesh_protocol_t protocol, uint8_t max_hops)
+{
+    const bool ok = mesh_send(dst_addr, protocol, pkt->data, pkt->info.data_len, max_hops);
+    wireless_pkt_release(pkt);
+    return ok;
+}
+
+uint32_t wireless_pkt_get_free_count(void)
+{
+    uint32_t count = 0;
+    uint32_t i = 0;
+
+    for (i = 0; i < WIRELESS_PKT_POOL_SIZE; i++) {
+        if (0 == g_pkt_refs[i]) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Copies the next message of g_rx_batch_ref to a buffer of the pool.
+ * The batch packet is released after its last message, or if it is malformed.
+ * @returns NULL if there is no batch or no more messages, or if the pool is empty.
+ */
+static mesh_packet_t* wireless_unpack_next_ref(void)
+{
+    mesh_packet_t *pkt = NULL;
+    mesh_packet_t *done = NULL;
+
+    /* The unpacking state is shared, so protect it in case multiple tasks receive packets */
+    wireless_pool_lock();
+    mesh_packet_t *batch = g_rx_batch_ref;
+    if (NULL != batch) {
+        const uint8_t end = batch->info.data_len;
+        const uint8_t off = g_rx_batch_offset;
+        const uint8_t len = (off && off < end) ? batch->data[off] : 0;
+
+        if (0 == len || (off + 1 + len) > end) {
+            done = batch;
+            g_rx_batch_ref = NULL;
+            g_rx_batch_offset = 0;
+        }
+        else if (NULL != (pkt = wireless_pkt_alloc())) {
+            pkt->nwk  = batch->nwk;
+            pkt->mac  = batch->mac;
+            pkt->info = batch->info;
+            pkt->info.data_len = len;
+            memcpy(pkt->data, &batch->data[off + 1], len);
+            g_rx_batch_offset = off + 1 + len;
+        }
+    }
+    wireless_pool_unlock();
+
+    if (NULL != done) {
+        wireless_pkt_release(done);
+    }
+
+    return pkt;
+}
+
+mesh_packet_t* wireless_get_rx_pkt_ref(const uint32_t timeout_ms)
+{
+    mesh_packet_t *pkt = wireless_unpack_next_ref();
+
+    /* Messages of a pending batch are returned before the next packet of the queue */
+    if (NULL == pkt && NULL == g_rx_batch_ref &&
+        wireless_get_queued_pkt(g_rx_queue, &pkt, timeout_ms) &&
+        pkt->info.data_len > 0 && WIRELESS_BATCH_MARKER == pkt->data[0])
+    {
+        mesh_packet_t *discarded = pkt;
+
+        wireless_pool_lock();
+        if (NULL == g_rx_batch_ref) {
+            g_rx_batch_ref = pkt;
+            g_rx_batch_offset = 1;
+            discarded = NULL;
+        }
+        wireless_pool_unlock();
+
+        /* Another task started unpacking a batch while we were waiting */
+        if (NULL != discarded) {
+            wireless_pkt_release(discarded);
+        }
+        pkt = wireless_unpack_next_ref();
+    }
+
+    return pkt;
+}
+
 char wireless_get_rx_pkt(mesh_packet_t *pkt, const uint32_t timeout_ms)
 {
-    return wireless_get_queued_pkt(g_rx_queue, pkt, timeout_ms);
+    mesh_packet_t *ref = wireless_get_rx_pkt_ref(timeout_ms);
+
+    if (NULL != ref) {
+        *pkt = *ref;
+        wireless_pkt_release(ref);
+    }
+
+    return (NULL != ref);
+}
+
+/**
+ * Removes the batches that should be sent and sends them.
+ * @param all  If true all batches are sent, otherwise only the expired batches
+ */
+static void wireless_send_batches(const bool all)
+{
+    wireless_batch_t batch;
+    uint32_t i = 0;
+
+    wireless_tx_burst_begin();
+    for (i = 0; i < WIRELESS_BATCH_SLOTS; i++) {
+        /* Copy the batch out of the slot, and send it outside of the critical section */
+        batch.len = 0;
+        taskENTER_CRITICAL();
+        if (g_tx_batches[i].len &&
+            (all || (int32_t)(xTaskGetTickCount() - g_tx_batches[i].deadline) >= 0)) {
+            batch = g_tx_batches[i];
+            g_tx_batches[i].len = 0;
+        }
+        taskEXIT_CRITICAL();
+
+        if (batch.len) {
+            mesh_send(batch.dst, (mesh_protocol_t) batch.protocol, batch.data, batch.len, batch.max_hops);
+        }
+    }
+    wireless_tx_burst_end();
+}
+
+/// @returns the ticks to wait until the next batch should be sent
+static TickType_t wireless_batch_block_time(void)
+{
+    TickType_t block_time = portMAX_DELAY;
+    const TickType_t now = xTaskGetTickCount();
+    uint32_t i = 0;
+
+    for (i = 0; i < WIRELESS_BATCH_SLOTS; i++) {
+        if (g_tx_batches[i].len) {
+            const int32_t remaining = (int32_t)(g_tx_batches[i].deadline - now);
+            const TickType_t ticks = (remaining > 0) ? remaining : 0;
+            if (ticks < block_time) {
+                block_time = ticks;
+            }
+        }
+    }
+
+    return block_time;
+}
+
+bool wireless_send_batched(uint8_t dst_addr, mesh_protocol_t protocol, const void *data, uint8_t len, uint8_t max_hops)
+{
+    wireless_batch_t full;
+    wireless_batch_t *batch = NULL;
+    bool opened = false;
+    uint32_t i = 0;
+
+    if (taskSCHEDULER_RUNNING != xTaskGetSchedulerState() || 0 == len || len > WIRELESS_BATCH_MAX_MSG_LEN) {
+        return wireless_send(dst_addr, protocol, data, len, max_hops);
+    }
+
+    full.len = 0;
+    taskENTER_CRITICAL();
+    {
+        for (i = 0; i < WIRELESS_BATCH_SLOTS; i++) {
+            wireless_batch_t *b = &g_tx_batches[i];
+            if (b->len && b->dst == dst_addr && b->protocol == protocol && b->max_hops == max_hops) {
+                batch = b;
+                break;
+            }
+            if (0 == b->len && !batch) {
+                batch = b;
+            }
+        }
+        if (i < WIRELESS_BATCH_SLOTS && (batch->len + 1 + len) > MESH_DATA_PAYLOAD_SIZE) {
+            /* The message does not fit, so send this batch and start over */
+            full = *batch;
+            batch->len = 0;
+        }
+
+        if (batch) {
+            if (0 == batch->len) {
+                batch->dst = dst_addr;
+                batch->protocol = protocol;
+                batch->max_hops = max_hops;
+                batch->deadline = xTaskGetTickCount() + OS_MS(WIRELESS_BATCH_WINDOW_MS);
+                batch->data[batch->len++] = WIRELESS_BATCH_MARKER;
+                opened = true;
+            }
+            batch->data[batch->len++] = len;
+            memcpy(&batch->data[batch->len], data, len);
+            batch->len += len;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if (full.len) {
+        mesh_send(full.dst, (mesh_protocol_t) full.protocol, full.data, full.len, full.max_hops);
+    }
+
+    /* All slots are used by other destinations */
+    if (!batch) {
+        return wireless_send(dst_addr, protocol, data, len, max_hops);
+    }
+
+    /* Wake up the wireless task such that it waits for the new deadline */
+    if (opened) {
+        os_signal_give(&g_nrf_activity);
+    }
+
+    return true;
+}
+
+void wireless_flush_batched(void)
+{
+    if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        wireless_send_batches(true);
+    }
 }
 
 char wireless_get_ack_pkt(mesh_packet_t *pkt, const uint32_t timeout_ms)
@@ -104,32 +625,111 @@ int wireless_flush_rx(void)
 {
     int cnt = 0;
     mesh_packet_t pkt;
-    while(wireless_get_rx_pkt(&pkt, 0) || wireless_get_ack_pkt(&pkt, 0)) {
+    mesh_packet_t *ref = NULL;
+
+    while (NULL != (ref = wireless_get_rx_pkt_ref(0))) {
+        wireless_pkt_release(ref);
+        cnt++;
+    }
+    while (wireless_get_ack_pkt(&pkt, 0)) {
         cnt++;
     }
     return cnt;
 }
 
+void wireless_set_rx_event(SemaphoreHandle_t event)
+{
+    g_rx_event = event;
+}
+
+void wireless_tx_burst_begin(void)
+{
+    if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        g_burst_count = 0;
+        g_burst_owner = xTaskGetCurrentTaskHandle();
+    }
+}
+
+void wireless_tx_burst_end(void)
+{
+    if (NULL != g_burst_owner && xTaskGetCurrentTaskHandle() == g_burst_owner) {
+        nrf_radio_lock();
+        nrf_send_burst();
+        nrf_radio_unlock();
+        g_burst_owner = NULL;
+    }
+}
+
+void wireless_wakeup_service(void)
+{
+    os_signal_give(&g_nrf_activity);
+}
+
 void wireless_service(void)
 {
     /*
      * If FreeRTOS is running, then a task should be calling us, so we can block on
-     * the nordic activity semaphore.
+     * the nordic activity signal.
      *
      * There are three cases of block time :
-     *  1 - If nordic interrupt signal is still pending, then we haven't read
-     *      all Nordic FIFO, so we don't block on semaphore at all.
+     *  1 - If frames of the radio are still pending, then we haven't handled
+     *      all of them, so we don't block on semaphore at all.
      *  2 - There are pending packets that need either ACK or retry, so we
-     *      block just for one tick to carry out mesh logic.
+     *      block just for one tick to carry out mesh logic.  Batches of
+     *      wireless_send_batched() wake us up when their window expires.
      *  3 - No RX and no TX, so block until either a packet is sent, or until
-     *      we receive a packet; both cases will give the semaphore.
+     *      we receive a packet; both cases will give the signal.
      */
     if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
-        if (!nordic_intr_signal()) {
-            const TickType_t blockTime = mesh_get_pnd_pkt_count() ? 1 : portMAX_DELAY;
-            xSemaphoreTake(g_nrf_activity_sem, blockTime);
+        if (!wireless_radio_pending()) {
+            const TickType_t batchTime = wireless_batch_block_time();
+            TickType_t blockTime = mesh_get_pnd_pkt_count() ? 1 : batchTime;
+            if (blockTime > OS_MS(wireless_mcast_get_due_ms())) {
+                blockTime = OS_MS(wireless_mcast_get_due_ms());
+            }
+            #if (MESH_BEACON_INTERVAL_MS > 0)
+            if (blockTime > OS_MS(mesh_get_next_beacon_ms())) {
+                blockTime = OS_MS(mesh_get_next_beacon_ms());
+            }
+            #endif
+            #if WIRELESS_LINK_RATE
+            if (g_rx_rate_idx != g_common_rate_idx && blockTime > OS_MS(WIRELESS_RATE_WINDOW_MS)) {
+                blockTime = OS_MS(WIRELESS_RATE_WINDOW_MS);
+            }
+            #endif
+            #if WIRELESS_LPL
+            if (g_lpl_intervals_ms[g_lpl_class] > 0 && blockTime > OS_MS(nrf_lpl_get_due_ms())) {
+                blockTime = OS_MS(nrf_lpl_get_due_ms());
+            }
+            #endif
+            if (blockTime) {
+                os_signal_wait(&g_nrf_activity, blockTime);
+            }
+        }
+        wireless_send_batches(false);
+
+        /* Handle the frames within our time budget, and then let the other tasks run */
+        const TickType_t start = xTaskGetTickCount();
+        do {
+            PROFILE_SCOPE("mesh_service");
+            mesh_service();
+        } while (wireless_radio_pending() && (xTaskGetTickCount() - start) < OS_MS(WIRELESS_SERVICE_BUDGET_MS));
+
+        wireless_bulk_service();
+        wireless_mcast_service();
+        wireless_tlm_service();
+        wireless_time_service();
+        wireless_channel_service();
+        #if WIRELESS_LINK_RATE
+        wireless_link_rate_service();
+        #endif
+        #if WIRELESS_LPL
+        wireless_lpl_service();
+        #endif
+
+        if (wireless_radio_pending()) {
+            vTaskDelay(1);
         }
-        mesh_service();
     }
     /* A timer ISR is calling us, so we can't use FreeRTOS API, hence we poll */
     else {
@@ -141,109 +741,1078 @@ void wireless_service(void)
 
 
 
-static int nrf_driver_init(void* p, int len)
+void wireless_radio_service(void)
 {
-    if (NULL == g_rx_queue) {
-        g_rx_queue = xQueueCreate(WIRELESS_RX_QUEUE_SIZE, MESH_PAYLOAD);
-    }
-    if (NULL == g_ack_queue) {
-        g_ack_queue = xQueueCreate(1, MESH_PAYLOAD);
-    }
-    if (NULL == g_nrf_activity_sem) {
-        g_nrf_activity_sem = xSemaphoreCreateBinary();
-    }
-
-    nordic_init(MESH_PAYLOAD, WIRELESS_CHANNEL_NUM, WIRELESS_AIR_DATARATE_KBPS);
-    nordic_standby1_to_rx();
+    wireless_radio_frame_t frame;
+    bool queued = false;
 
-    /* Hook up the interrupt callback for nordic pin */
-    eint3_enable_port0(BIO_NORDIC_IRQ_P0PIN, eint_falling_edge, nrf_irq_callback);
+    g_radio_task = true;
 
-    return (NULL != g_rx_queue && NULL != g_ack_queue && NULL != g_nrf_activity_sem);
-}
+    /* The IRQ may have given the activity signal before we were running, so we poll once */
+    os_signal_wait(&g_radio_signal, nordic_intr_signal() ? 0 : portMAX_DELAY);
 
-static int nrf_driver_send(void* p, int len)
-{
-    /**
-     * Air time is 1 byte preamble, 5 byte address, 2 byte CRC and 9 bits at the end.
-     * We add 25 just to make sure we satisfy air time requirement.
-     * The slots is the number of slots we allocate for someone to send their data,
-     * and we pick one of them to avoid data collision when nodes repeat a packet.
-     */
-	static const uint32_t s_pkt_air_time_us =
-	        25 + (((8 * (MESH_PAYLOAD + 1 + 5 + 3)) * 1000) / WIRELESS_AIR_DATARATE_KBPS);
-	const uint32_t slots = MESH_MAX_NODES;
-    int packetWasSent = 1;
+    nrf_radio_lock();
+    while (nordic_intr_signal() || nordic_is_packet_available())
+    {
+        memset(&frame, 0, sizeof(frame));
+        frame.rx_time_us = g_rx_irq_time_us;
+        if (!nrf_read_frame(&frame.pkt, sizeof(frame.pkt))) {
+            /* No frame, or the interrupt of a sent packet which the sender already cleared */
+            if (!nordic_is_packet_available()) {
+                break;
+            }
+            continue;
+        }
 
-    /**
-     * If we are not the source of this packet, that means we are repeating the packet.
-     * If we are repeating the packet to discover the route (mac.dst == MESH_ZERO_ADDR)
-     * then we need to randomly pick one air-time slot otherwise if all nodes send at
-     * the same time, then their data will collide and packet won't go through.
-     */
-    const mesh_packet_t *pkt = (mesh_packet_t*)p;
-    if (mesh_get_node_address() != pkt->nwk.src) {
-        if (MESH_ZERO_ADDR == pkt->mac.dst) {
-            const uint32_t timeSlotDelayUs = ((rand() % slots) + 1) * s_pkt_air_time_us;
-            delay_us(timeSlotDelayUs); /**< Maximize mesh nodes to repeat the packet and not collide */
+        /* If the mesh logic is behind, this frame is dropped since only the reader frees the space */
+        if (msg_buffer_write(&g_radio_rx, &frame, WIRELESS_RADIO_FRAME_LEN(&frame.pkt))) {
+            queued = true;
         }
     }
+    nrf_radio_unlock();
 
-	// Bring from RX mode to TX mode
-	nordic_rx_to_Stanby1();
-	nordic_standby1_to_tx_mode1();
+    if (queued) {
+        os_signal_give(&g_nrf_activity);
+    }
+}
 
-	// Send the packet :
-	nordic_mode1_send_single_packet(p, len);
-	nordic_clear_packet_sent_flag();
 
-	// Switch back to receive mode
-	nordic_standby1_to_rx();
 
-	/* If FreeRTOS is running, we are probably blocked indefinitely on the activity semaphore.
-	 * So we will give the semaphore here, to give the mesh network task to unblock and
-	 * carry out retry logic.  We use FromISR() API such that mesh_send() will not be
-	 * restricted to be called from a FreeRTOS task alone.
-	 */
-	if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
-	    xSemaphoreGiveFromISR(g_nrf_activity_sem, NULL);
-	}
+#if WIRELESS_HW_ACK
+/// Sets the address of our Pipe1 if our node address has changed.
+static void nrf_hw_ack_set_our_addr(void)
+{
+    char addr[] = WIRELESS_HW_ACK_ADDR;
+    const uint8_t our_addr = mesh_get_node_address();
 
-	return packetWasSent;
+    if (our_addr != g_hw_ack_our_addr) {
+        addr[0] = g_hw_ack_our_addr = our_addr;
+        nordic_set_rx_pipe1_addr(addr, sizeof(addr));
+    }
 }
 
-static int nrf_driver_receive(void* p, int len)
+/**
+ * Sends the packet to the address of the neighbor's Pipe1, and waits for its hardware ACK.
+ * Pipe0 temporarily uses the neighbor's address with auto-ack to receive the ACK.
+ * @returns true if the neighbor acknowledged the packet.
+ */
+static bool nrf_hw_ack_send(const uint8_t neighbor, void *p, int len)
 {
-	int packetWasReceived = 0;
+    char addr[] = WIRELESS_HW_ACK_ADDR;
+    char mesh_addr[] = NORDIC_INIT_ADDR;
+    bool acked = false;
 
-	if(nordic_is_packet_available())
-	{
-		nordic_read_rx_fifo(p, len);
+    addr[0] = neighbor;
+    nordic_set_tx_address(addr, sizeof(addr));
+    nordic_set_rx_pipe0_addr(addr, sizeof(addr));
+    nordic_set_auto_ack_for_pipes(1, 1, 0, 0, 0, 0);
 
-		// Only clear the interrupt if no more packet available
-		// because nordic has 3 level Rx FIFO.
-		if (!nordic_is_packet_available()) {
-		    nordic_clear_packet_available_flag();
-		}
-		packetWasReceived = 1;
-	}
+    acked = nordic_mode1_send_single_packet_with_ack(p, len);
 
-	return packetWasReceived;
+    nordic_set_auto_ack_for_pipes(WIRELESS_DYN_PAYLOAD, 1, 0, 0, 0, 0);
+    nordic_set_tx_address(mesh_addr, sizeof(mesh_addr));
+    nordic_set_rx_pipe0_addr(mesh_addr, sizeof(mesh_addr));
+
+    return acked;
 }
+#endif
 
-static int nrf_driver_app_recv(void *p, int len)
+#if WIRELESS_LINK_RATE
+/// Sets the air data rate of the radio, which must be in Standby-1 or Tx mode
+static void nrf_set_rate_idx(const uint8_t idx)
 {
-    /* Only mesh_pkt_ack_rsp is an ACK packet, others are to REQUEST for ack or nack */
-    const mesh_packet_t *pkt = (mesh_packet_t*) p;
-    const QueueHandle_t qhandle = (mesh_pkt_ack_rsp == pkt->info.pkt_type) ? g_ack_queue : g_rx_queue;
+    if (idx != g_radio_rate_idx) {
+        g_radio_rate_idx = idx;
+        nordic_set_air_data_rate(g_rates_kbps[idx]);
+    }
+}
+
+/// @returns the rate entry of the neighbor, which replaces the oldest entry if the neighbor has none
+static wireless_link_rate_t* nrf_link_rate_get(const uint8_t neighbor)
+{
+    wireless_link_rate_t *link = NULL;
+    uint32_t i = 0;
+
+    for (i = 0; i < WIRELESS_RATE_LINKS; i++) {
+        if (neighbor == g_link_rates[i].addr) {
+            return &g_link_rates[i];
+        }
+    }
+
+    link = &g_link_rates[g_link_rate_next];
+    g_link_rate_next = (g_link_rate_next + 1) % WIRELESS_RATE_LINKS;
+    memset(link, 0, sizeof(*link));
+    link->addr = neighbor;
+    link->rate_idx = g_common_rate_idx;
+    return link;
+}
+
+/**
+ * Sends the packet with hardware ACK at the rate of the link to the neighbor, or at the common
+ * rate if the faster rate fails, and steps the rate of the link.
+ * @returns true if the neighbor acknowledged the packet.
+ */
+static bool nrf_link_rate_send(const uint8_t neighbor, void *p, int len)
+{
+    wireless_link_rate_t *link = nrf_link_rate_get(neighbor);
+    const uint32_t now = sys_get_uptime_ms();
+    bool acked = false;
+    bool fast_failed = false;
+    uint8_t retries = 0;
+
+    if (link->rate_idx != g_common_rate_idx)
+    {
+        bool awake = ((int32_t) (now - link->awake_ms) < 0);
+
+        /* Wake up the neighbor at the common rate, and give it the time to switch */
+        if (!awake) {
+            mesh_packet_t wake;
+            memset(&wake, 0, sizeof(wake));
+            wake.nwk.src = MESH_ZERO_ADDR;
+            wake.nwk.dst = WIRELESS_RATE_MARKER;
+            wake.info.data_len = 1;
+            wake.data[0] = link->rate_idx;
+
+            nrf_set_rate_idx(g_common_rate_idx);
+            if ((awake = nrf_hw_ack_send(neighbor, &wake, WIRELESS_DYN_PAYLOAD ? (MESH_PAYLOAD_HEADER_SIZE + 1) : MESH_PAYLOAD))) {
+                delay_us(WIRELESS_RATE_SWITCH_US);
+            }
+        }
+
+        if (awake) {
+            nrf_set_rate_idx(link->rate_idx);
+            acked = nrf_hw_ack_send(neighbor, p, len);
+            retries = nordic_get_retransmit_count();
+        }
+        fast_failed = !acked;
+        link->awake_ms = acked ? (now + (WIRELESS_RATE_WINDOW_MS / 2)) : now;
+    }
+
+    if (!acked) {
+        nrf_set_rate_idx(g_common_rate_idx);
+        acked = nrf_hw_ack_send(neighbor, p, len);
+        retries = nordic_get_retransmit_count();
+    }
+    nrf_set_rate_idx(g_rx_rate_idx);
+
+    /* Step up after a run of packets that were not retried, and step down after a retry */
+    if (acked && 0 == retries && !fast_failed) {
+        if (++link->ok_run >= WIRELESS_RATE_UP_PKTS && (link->rate_idx + 1) < WIRELESS_NUM_RATES) {
+            link->rate_idx++;
+            link->ok_run = 0;
+            link->awake_ms = now;
+        }
+    }
+    else {
+        link->ok_run = 0;
+        if (link->rate_idx > g_common_rate_idx) {
+            link->rate_idx--;
+            link->awake_ms = now;
+        }
+    }
+
+    return acked;
+}
+
+/**
+ * Handles the wake-up frame of a neighbor received on Pipe1, and keeps us at the faster rate
+ * while the neighbor sends to us.
+ * @returns true if the packet is a wake-up frame, which is not given to the mesh.
+ */
+static bool nrf_link_rate_handle_rx(const mesh_packet_t *pkt)
+{
+    const bool wake = (MESH_ZERO_ADDR == pkt->nwk.src && WIRELESS_RATE_MARKER == pkt->nwk.dst &&
+                       pkt->data[0] < WIRELESS_NUM_RATES);
+
+    if (wake && pkt->data[0] != g_rx_rate_idx) {
+        g_rx_rate_idx = pkt->data[0];
+        nordic_rx_to_Stanby1();
+        nrf_set_rate_idx(g_rx_rate_idx);
+        nordic_standby1_to_rx();
+    }
+    if (wake || g_rx_rate_idx != g_common_rate_idx) {
+        g_rx_rate_until_ms = sys_get_uptime_ms() + WIRELESS_RATE_WINDOW_MS;
+    }
+
+    return wake;
+}
+
+static void wireless_link_rate_service(void)
+{
+    if (g_rx_rate_idx != g_common_rate_idx && (int32_t) (sys_get_uptime_ms() - g_rx_rate_until_ms) >= 0) {
+        g_rx_rate_idx = g_common_rate_idx;
+        nrf_radio_lock();
+        nordic_rx_to_Stanby1();
+        nrf_set_rate_idx(g_rx_rate_idx);
+        nordic_standby1_to_rx();
+        nrf_radio_unlock();
+    }
+}
+#endif
+
+uint16_t wireless_get_link_rate_kbps(uint8_t neighbor)
+{
+    #if WIRELESS_LINK_RATE
+    uint32_t i = 0;
+    for (i = 0; i < WIRELESS_RATE_LINKS; i++) {
+        if (neighbor == g_link_rates[i].addr) {
+            return g_rates_kbps[g_link_rates[i].rate_idx];
+        }
+    }
+    #else
+    (void) neighbor;
+    #endif
+
+    return WIRELESS_AIR_DATARATE_KBPS;
+}
+
+static int nrf_driver_init(void* p, int len)
+{
+    if (NULL == g_rx_queue) {
+        g_rx_queue = xQueueCreate(WIRELESS_RX_QUEUE_SIZE, sizeof(mesh_packet_t*));
+    }
+    if (NULL == g_ack_queue) {
+        g_ack_queue = xQueueCreate(1, MESH_PAYLOAD);
+    }
+    if (NULL == g_radio_rx.buffer) {
+        msg_buffer_init(&g_radio_rx, g_radio_rx_storage, sizeof(g_radio_rx_storage), msg_buffer_packets, false);
+    }
+    if (NULL == g_radio_mutex) {
+        g_radio_mutex = xSemaphoreCreateMutex();
+    }
+    const bool bulk_ok = wireless_bulk_init() && wireless_mcast_init() && wireless_tlm_init();
+
+    nordic_init(MESH_PAYLOAD, WIRELESS_CHANNEL_NUM, WIRELESS_AIR_DATARATE_KBPS);
+    nordic_set_dynamic_payload(WIRELESS_DYN_PAYLOAD);
+    #if WIRELESS_HW_ACK
+    nordic_set_payload_for_pipe(WIRELESS_HW_ACK_PIPE, MESH_PAYLOAD);
+    g_hw_ack_our_addr = MESH_ZERO_ADDR;
+    nrf_hw_ack_set_our_addr();
+    #endif
+    nordic_set_auto_ack_for_pipes(WIRELESS_DYN_PAYLOAD, WIRELESS_HW_ACK, 0, 0, 0, 0);
+    nordic_standby1_to_rx();
+
+    memset(&g_chan, 0, sizeof(g_chan));
+    g_chan.eval_ms = sys_get_uptime_ms() + WIRELESS_HOP_EVAL_MS;
+
+    #if WIRELESS_LINK_RATE
+    memset(&g_link_rates[0], 0, sizeof(g_link_rates));
+    for (g_common_rate_idx = 0; g_common_rate_idx < WIRELESS_NUM_RATES - 1; g_common_rate_idx++) {
+        if (WIRELESS_AIR_DATARATE_KBPS == g_rates_kbps[g_common_rate_idx]) {
+            break;
+        }
+    }
+    g_radio_rate_idx = g_rx_rate_idx = g_common_rate_idx;
+    #endif
+
+    #if WIRELESS_LPL
+    memset(&g_lpl_nodes[0], 0, sizeof(g_lpl_nodes));
+    g_lpl_asleep = false;
+    g_lpl_awake_ms = sys_get_uptime_ms() + WIRELESS_LPL_AWAKE_MS;
+    g_lpl_announce_ms = sys_get_uptime_ms();
+    #endif
+
+    /* Hook up the interrupt callback for nordic pin */
+    eint3_enable_port0(BIO_NORDIC_IRQ_P0PIN, eint_falling_edge, nrf_irq_callback);
+
+    return (NULL != g_rx_queue && NULL != g_ack_queue &&
+            NULL != g_radio_rx.buffer && NULL != g_radio_mutex && bulk_ok);
+}
+
+/**
+ * Waits while the receiver detects a carrier on our channel, with a random backoff of
+ * air-time slots that doubles each time the channel is still busy.  We send anyway
+ * after WIRELESS_CCA_TRIES, since most of the interference is too short to be detected.
+ */
+static void nrf_wait_for_clear_channel(void)
+{
+    uint32_t i = 0;
+
+    for (i = 0; i < WIRELESS_CCA_TRIES && !nordic_is_air_free(); i++) {
+        g_chan.busy_cnt++;
+        delay_us(((rand() % (2U << i)) + 1) * g_pkt_air_time_us);
+    }
+}
+
+/// Tunes the radio to the channel of g_hop_channels[] (the radio should be in RX mode)
+static void nrf_set_channel_idx(const uint8_t idx)
+{
+    if (idx < WIRELESS_HOP_NUM_CHANNELS && idx != g_chan.chan_idx) {
+        g_chan.chan_idx = idx;
+        nrf_radio_lock();
+        nordic_rx_to_Stanby1();
+        nordic_set_channel(g_hop_channels[idx]);
+        nordic_standby1_to_rx();
+        nrf_radio_unlock();
+    }
+}
+
+#if WIRELESS_CHANNEL_HOPPING
+/**
+ * Handles the channel switch broadcast of another node.  The switch with the newer
+ * sequence number wins, and if two nodes announce at the same time, the lower channel wins.
+ * @returns true if this was a channel switch packet.
+ */
+static bool wireless_hop_handle_pkt(const mesh_packet_t *pkt)
+{
+    if (3 != pkt->info.data_len || WIRELESS_HOP_MARKER != pkt->data[0]) {
+        return false;
+    }
+
+    const uint8_t seq = pkt->data[1];
+    const uint8_t idx = pkt->data[2];
+    const int8_t newer = (int8_t) (seq - g_chan.seq);
+    const uint8_t target = g_chan.switch_pending ? g_chan.next_idx : g_chan.chan_idx;
+
+    if (idx < WIRELESS_HOP_NUM_CHANNELS && (newer > 0 || (0 == newer && idx < target))) {
+        g_chan.seq = seq;
+        g_chan.next_idx = idx;
+        g_chan.switch_ms = sys_get_uptime_ms() + WIRELESS_HOP_SWITCH_DELAY_MS;
+        g_chan.switch_pending = true;
+    }
+
+    return true;
+}
+
+/// Broadcasts the switch to the channel, and switches ourselves after WIRELESS_HOP_SWITCH_DELAY_MS
+static void wireless_hop_announce(const uint8_t idx)
+{
+    uint8_t data[] = { WIRELESS_HOP_MARKER, (uint8_t) (g_chan.seq + 1), idx };
+    uint32_t i = 0;
+
+    g_chan.seq = data[1];
+    g_chan.next_idx = idx;
+    g_chan.switch_ms = sys_get_uptime_ms() + WIRELESS_HOP_SWITCH_DELAY_MS;
+    g_chan.switch_pending = true;
+
+    /* Broadcast packets are not acknowledged, so send it twice */
+    for (i = 0; i < 2; i++) {
+        mesh_send(MESH_BROADCAST_ADDR, mesh_pkt_nack, data, sizeof(data), MESH_RTE_DISCOVERY_HOPS);
+    }
+}
+#endif
+
+/// Updates the channel quality every WIRELESS_HOP_EVAL_MS, and switches the channel if needed
+static void wireless_channel_service(void)
+{
+    const uint32_t now = sys_get_uptime_ms();
+    uint32_t i = 0;
+
+    if (g_chan.switch_pending && (int32_t) (now - g_chan.switch_ms) >= 0) {
+        g_chan.switch_pending = false;
+        nrf_set_channel_idx(g_chan.next_idx);
+    }
+    if ((int32_t) (now - g_chan.eval_ms) < 0) {
+        return;
+    }
+    g_chan.eval_ms = now + WIRELESS_HOP_EVAL_MS;
+
+    /* The lost packet count of the radio is the number of hardware ACK failures */
+    const uint32_t tx = g_chan.tx_cnt;
+    nrf_radio_lock();
+    const uint32_t bad = g_chan.busy_cnt + nordic_get_lost_packet_cnt(true);
+    nrf_radio_unlock();
+    const uint32_t rx = g_chan.rx_cnt;
+    g_chan.tx_cnt = g_chan.busy_cnt = g_chan.rx_cnt = 0;
+
+    /* The other channels slowly recover such that they will be tried again */
+    for (i = 0; i < WIRELESS_HOP_NUM_CHANNELS; i++) {
+        if (i == g_chan.chan_idx) {
+            if (tx >= WIRELESS_HOP_MIN_PKTS) {
+                const uint32_t pct = (bad >= tx) ? 100 : (bad * 100) / tx;
+                g_chan.bad_pct[i] = (3 * g_chan.bad_pct[i] + pct) / 4;
+            }
+        }
+        else {
+            g_chan.bad_pct[i] -= g_chan.bad_pct[i] / 8;
+        }
+    }
+
+    #if WIRELESS_CHANNEL_HOPPING
+    if (g_chan.switch_pending) {
+        return;
+    }
+
+    /* If we are sending but nobody answers, the network may have switched without us */
+    g_chan.lost_periods = (tx >= WIRELESS_HOP_MIN_PKTS && 0 == rx) ? (g_chan.lost_periods + 1) : 0;
+    if (g_chan.lost_periods >= WIRELESS_HOP_LOST_PERIODS) {
+        g_chan.lost_periods = 0;
+        nrf_set_channel_idx((g_chan.chan_idx + 1) % WIRELESS_HOP_NUM_CHANNELS);
+        return;
+    }
+
+    if (g_chan.bad_pct[g_chan.chan_idx] > WIRELESS_HOP_BAD_PERCENT) {
+        uint8_t best = g_chan.chan_idx;
+        for (i = 0; i < WIRELESS_HOP_NUM_CHANNELS; i++) {
+            if (g_chan.bad_pct[i] < g_chan.bad_pct[best]) {
+                best = i;
+            }
+        }
+        if (best != g_chan.chan_idx) {
+            wireless_hop_announce(best);
+        }
+    }
+    #else
+    (void) rx;
+    #endif
+}
+
+uint16_t wireless_get_channel_mhz(void)
+{
+    return g_hop_channels[g_chan.chan_idx];
+}
+
+uint8_t wireless_get_channel_bad_percent(void)
+{
+    return g_chan.bad_pct[g_chan.chan_idx];
+}
+
+#if WIRELESS_LPL
+/// @returns the wake-up interval of the class, or 0 if its nodes are always on
+static uint32_t nrf_lpl_interval_ms(const uint8_t cls)
+{
+    return (cls < WIRELESS_LPL_NUM_CLASSES) ? g_lpl_intervals_ms[cls] : 0;
+}
 
-    int ok = xQueueSend(qhandle, p, 0);
+/// @returns the entry of the neighbor, or NULL if it has none and add is false (the oldest entry is replaced)
+static wireless_lpl_node_t* nrf_lpl_get_node(const uint8_t neighbor, const bool add)
+{
+    wireless_lpl_node_t *node = NULL;
+    uint32_t i = 0;
+
+    for (i = 0; i < WIRELESS_LPL_NODES; i++) {
+        if (neighbor == g_lpl_nodes[i].addr) {
+            return &g_lpl_nodes[i];
+        }
+    }
+    if (!add || MESH_ZERO_ADDR == neighbor || MESH_BROADCAST_ADDR == neighbor) {
+        return NULL;
+    }
+
+    node = &g_lpl_nodes[g_lpl_node_next];
+    g_lpl_node_next = (g_lpl_node_next + 1) % WIRELESS_LPL_NODES;
+    memset(node, 0, sizeof(*node));
+    node->addr = neighbor;
+    node->awake_ms = sys_get_uptime_ms();
+    return node;
+}
+
+/// Keeps us awake for at least this long
+static void nrf_lpl_stay_awake(const uint32_t ms)
+{
+    const uint32_t until = sys_get_uptime_ms() + ms;
+    if ((int32_t) (until - g_lpl_awake_ms) > 0) {
+        g_lpl_awake_ms = until;
+    }
+}
+
+/// Powers up our radio to RX mode if it is powered down, the radio should be locked
+static void nrf_lpl_power_up(void)
+{
+    if (g_lpl_asleep) {
+        g_lpl_asleep = false;
+        nordic_power_up();
+        delay_us(WIRELESS_LPL_POWER_UP_US);
+        nordic_standby1_to_rx();
+    }
+}
+
+/// Powers down our radio until our next wake-up, which is at the multiple of our interval of the network time once we are synced
+static void nrf_lpl_power_down(void)
+{
+    const uint32_t interval_us = 1000 * nrf_lpl_interval_ms(g_lpl_class);
+
+    nordic_rx_to_Stanby1();
+    nordic_power_down();
+    g_lpl_asleep = true;
+
+    g_lpl_wake_us = sys_get_uptime_us();
+    if (wireless_time_is_synced()) {
+        g_lpl_wake_us += wireless_time_get_slot_start_us(interval_us, 0, 0) - wireless_time_get_us();
+    }
+    else {
+        g_lpl_wake_us += interval_us;
+    }
+}
+
+/// Waits until the uptime, and lets the other tasks run if the wait is long
+static void nrf_lpl_wait_until(const uint64_t uptime_us)
+{
+    int64_t remaining_us = 0;
+
+    while ((remaining_us = (int64_t) (uptime_us - sys_get_uptime_us())) > 2000 &&
+           taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        vTaskDelay(OS_MS((uint32_t) (remaining_us / 1000) - 1) + 1);
+    }
+    if (remaining_us > 0) {
+        delay_us(remaining_us);
+    }
+}
+
+/// Sends the strobes to the neighbor for the duration, the radio should be in Tx mode at the common rate
+static void nrf_lpl_send_strobes(const uint8_t dst, const uint32_t duration_us)
+{
+    mesh_packet_t strobe;
+    wireless_lpl_strobe_t *data = (wireless_lpl_strobe_t*) &strobe.data[0];
+    const int len = WIRELESS_DYN_PAYLOAD ? (MESH_PAYLOAD_HEADER_SIZE + sizeof(*data)) : MESH_PAYLOAD;
+    const uint64_t start_us = sys_get_uptime_us();
+    uint32_t elapsed_us = 0;
+
+    memset(&strobe, 0, sizeof(strobe));
+    strobe.nwk.src = MESH_ZERO_ADDR;
+    strobe.nwk.dst = WIRELESS_LPL_MARKER;
+    strobe.info.data_len = sizeof(*data);
+    data->src = mesh_get_node_address();
+    data->cls = g_lpl_class;
+    data->synced = wireless_time_is_synced();
+    data->dst = dst;
+
+    /* At least one strobe is sent, such as the announce strobe */
+    do {
+        const uint32_t remaining_ms = (duration_us - elapsed_us) / 1000;
+        data->remaining_ms[0] = remaining_ms & 0xFF;
+        data->remaining_ms[1] = (remaining_ms > 0xFFFF) ? 0xFF : (remaining_ms >> 8);
+        nordic_mode1_send_single_packet((char*) &strobe, len);
+        elapsed_us = sys_get_uptime_us() - start_us;
+    } while (elapsed_us < duration_us);
+}
+
+/**
+ * Wakes up the sleeping neighbors of the packet before we send it, and announces our class
+ * if we are sleeping too.  Our radio is powered up, and stays awake for the replies.
+ * The radio should be locked and in RX mode.
+ */
+static void nrf_lpl_wake_up(const uint8_t mac_dst)
+{
+    const bool bcast = (MESH_ZERO_ADDR == mac_dst || MESH_BROADCAST_ADDR == mac_dst);
+    const uint32_t now = sys_get_uptime_ms();
+    uint32_t interval_ms = 0;
+    uint32_t strobe_us = 0;
+    bool synced = wireless_time_is_synced();
+    uint32_t i = 0;
+
+    nrf_lpl_power_up();
+    nrf_lpl_stay_awake(WIRELESS_LPL_AWAKE_MS);
+
+    /* The longest interval of the sleeping neighbors we send to, whose wake-ups line up at that interval */
+    for (i = 0; i < WIRELESS_LPL_NODES; i++) {
+        const wireless_lpl_node_t *node = &g_lpl_nodes[i];
+        if (MESH_ZERO_ADDR != node->addr && (bcast || mac_dst == node->addr) &&
+            nrf_lpl_interval_ms(node->cls) > 0 && (int32_t) (now - node->awake_ms) >= 0) {
+            if (interval_ms < nrf_lpl_interval_ms(node->cls)) {
+                interval_ms = nrf_lpl_interval_ms(node->cls);
+            }
+            synced = synced && node->synced;
+        }
+    }
+
+    const bool announce = (nrf_lpl_interval_ms(g_lpl_class) > 0 && (int32_t) (now - g_lpl_announce_ms) >= 0);
+    if (0 == interval_ms && !announce) {
+        return;
+    }
+
+    /* Strobe from the guard time before the next wake-up until the end of its listen time, or right away
+     * if the last wake-up is still within that time.  Without the sync, strobe for the whole interval.
+     */
+    if (interval_ms > 0 && synced) {
+        const uint32_t interval_us = 1000 * interval_ms;
+        const uint32_t window_us = (2 * WIRELESS_LPL_GUARD_US) + WIRELESS_LPL_LISTEN_US;
+        const uint32_t next_us = wireless_time_get_slot_start_us(interval_us, 0, 0) - wireless_time_get_us();
+        const uint32_t since_us = interval_us - next_us;
+
+        if (since_us + WIRELESS_LPL_GUARD_US < window_us) {
+            strobe_us = window_us - WIRELESS_LPL_GUARD_US - since_us;
+        }
+        else {
+            if (next_us > WIRELESS_LPL_GUARD_US) {
+                nrf_lpl_wait_until(sys_get_uptime_us() + next_us - WIRELESS_LPL_GUARD_US);
+            }
+            strobe_us = window_us;
+        }
+    }
+    else if (interval_ms > 0) {
+        strobe_us = (1000 * interval_ms) + WIRELESS_LPL_LISTEN_US;
+    }
+
+    nrf_wait_for_clear_channel();
+    nordic_rx_to_Stanby1();
+    nordic_standby1_to_tx_mode1();
+    #if WIRELESS_LINK_RATE
+    nrf_set_rate_idx(g_common_rate_idx);
+    #endif
+    nrf_lpl_send_strobes((0 == interval_ms) ? MESH_ZERO_ADDR : (bcast ? MESH_BROADCAST_ADDR : mac_dst), strobe_us);
+    #if WIRELESS_LINK_RATE
+    nrf_set_rate_idx(g_rx_rate_idx);
+    #endif
+    nordic_clear_packet_sent_flag();
+    nordic_standby1_to_rx();
+
+    g_lpl_announce_ms = sys_get_uptime_ms() + WIRELESS_LPL_ANNOUNCE_MS;
+    for (i = 0; interval_ms > 0 && i < WIRELESS_LPL_NODES; i++) {
+        wireless_lpl_node_t *node = &g_lpl_nodes[i];
+        if (MESH_ZERO_ADDR != node->addr && (bcast || mac_dst == node->addr)) {
+            node->awake_ms = sys_get_uptime_ms() + WIRELESS_LPL_AWAKE_MS;
+        }
+    }
+}
+
+/**
+ * Learns the class of the neighbor from its strobe, and stays awake if the strobe is for us.
+ * Any other packet keeps us and its sender awake.  The radio should be locked.
+ * @returns true if the packet is a strobe, which is not given to the mesh.
+ */
+static bool nrf_lpl_handle_rx(const mesh_packet_t *pkt)
+{
+    const wireless_lpl_strobe_t *data = (const wireless_lpl_strobe_t*) &pkt->data[0];
+    const bool strobe = (MESH_ZERO_ADDR == pkt->nwk.src && WIRELESS_LPL_MARKER == pkt->nwk.dst &&
+                         pkt->info.data_len >= sizeof(*data));
+    wireless_lpl_node_t *node = NULL;
+
+    if (!strobe) {
+        if (NULL != (node = nrf_lpl_get_node(pkt->mac.src, false))) {
+            node->awake_ms = sys_get_uptime_ms() + WIRELESS_LPL_AWAKE_MS;
+        }
+        nrf_lpl_stay_awake(WIRELESS_LPL_AWAKE_MS);
+        return false;
+    }
+
+    /* A neighbor that is always on is only remembered if we already had an entry for it */
+    if (NULL != (node = nrf_lpl_get_node(data->src, nrf_lpl_interval_ms(data->cls) > 0))) {
+        node->cls = data->cls;
+        node->synced = !!data->synced;
+    }
+    if (MESH_BROADCAST_ADDR == data->dst || mesh_get_node_address() == data->dst) {
+        nrf_lpl_stay_awake((data->remaining_ms[0] | (data->remaining_ms[1] << 8)) + WIRELESS_LPL_AWAKE_MS);
+    }
+    return true;
+}
+
+static uint32_t nrf_lpl_get_due_ms(void)
+{
+    const uint64_t now_us = sys_get_uptime_us();
+
+    if (!g_lpl_asleep) {
+        const int32_t ms = (int32_t) (g_lpl_awake_ms - (uint32_t) (now_us / 1000));
+        return (ms > 0) ? ms : 0;
+    }
+    if (now_us + WIRELESS_LPL_POWER_UP_US >= g_lpl_wake_us) {
+        return 0;
+    }
+    return (g_lpl_wake_us - now_us - WIRELESS_LPL_POWER_UP_US) / 1000;
+}
+
+static void wireless_lpl_service(void)
+{
+    /* Our class may have changed to always on */
+    if (0 == nrf_lpl_interval_ms(g_lpl_class)) {
+        if (g_lpl_asleep) {
+            nrf_radio_lock();
+            nrf_lpl_power_up();
+            nrf_radio_unlock();
+        }
+        return;
+    }
+    if (0 != nrf_lpl_get_due_ms()) {
+        return;
+    }
+
+    nrf_radio_lock();
+    /* Power down once we are idle, but not while the radio has frames or packets are queued for a burst */
+    if (!g_lpl_asleep) {
+        if (0 == nrf_lpl_get_due_ms() && !wireless_radio_pending() && 0 == g_burst_count) {
+            nrf_lpl_power_down();
+        }
+    }
+    /* Listen at our wake-up.  A frame or a carrier keeps us awake until the radio task reads
+     * the frame, which keeps us awake for longer unless it is a strobe for another node.
+     */
+    else {
+        nrf_lpl_power_up();
+        delay_us(WIRELESS_LPL_LISTEN_US);
+        if (nordic_intr_signal() || nordic_is_packet_available() || !nordic_is_air_free()) {
+            nrf_lpl_stay_awake(1 + (WIRELESS_LPL_LISTEN_US / 1000));
+        }
+        else {
+            nrf_lpl_power_down();
+        }
+    }
+    nrf_radio_unlock();
+}
+#endif
+
+void wireless_lpl_set_class(uint8_t cls)
+{
+    #if WIRELESS_LPL
+    if (cls < WIRELESS_LPL_NUM_CLASSES) {
+        g_lpl_class = cls;
+        g_lpl_announce_ms = sys_get_uptime_ms();
+        wireless_wakeup_service();
+    }
+    #else
+    (void) cls;
+    #endif
+}
+
+uint8_t wireless_lpl_get_class(void)
+{
+    #if WIRELESS_LPL
+    return g_lpl_class;
+    #else
+    return 0;
+    #endif
+}
+
+void wireless_lpl_set_node_class(uint8_t neighbor, uint8_t cls)
+{
+    #if WIRELESS_LPL
+    wireless_lpl_node_t *node = NULL;
+    if (cls < WIRELESS_LPL_NUM_CLASSES) {
+        nrf_radio_lock();
+        if (NULL != (node = nrf_lpl_get_node(neighbor, true))) {
+            node->cls = cls;
+            node->synced = false;
+        }
+        nrf_radio_unlock();
+    }
+    #else
+    (void) neighbor;
+    (void) cls;
+    #endif
+}
+
+uint8_t wireless_lpl_get_node_class(uint8_t neighbor)
+{
+    #if WIRELESS_LPL
+    uint32_t i = 0;
+    for (i = 0; i < WIRELESS_LPL_NODES; i++) {
+        if (neighbor == g_lpl_nodes[i].addr) {
+            return g_lpl_nodes[i].cls;
+        }
+    }
+    #else
+    (void) neighbor;
+    #endif
+
+    return 0;
+}
+
+/// Switches the radio back to RX mode after sending, and wakes up the mesh task
+static void nrf_send_done(void)
+{
+	nordic_clear_packet_sent_flag();
+
+	// Switch back to receive mode
+	nordic_standby1_to_rx();
+
+	/* If FreeRTOS is running, we are probably blocked indefinitely on the activity signal.
+	 * So we will give the signal here, to give the mesh network task to unblock and
+	 * carry out retry logic.  We use FromISR() API such that mesh_send() will not be
+	 * restricted to be called from a FreeRTOS task alone.
+	 */
+	if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+	    os_signal_give_from_isr(&g_nrf_activity);
+	}
+}
+
+static void nrf_send_burst(void)
+{
+    /* Split the burst such that the radio doesn't stay in Tx mode for too long */
+    const uint32_t max_per_tx = (WIRELESS_TX_MODE_MAX_US / g_pkt_air_time_us) ?
+                                (WIRELESS_TX_MODE_MAX_US / g_pkt_air_time_us) : 1;
+    uint32_t sent = 0;
+
+    if (0 == g_burst_count) {
+        return;
+    }
+
+    g_chan.tx_cnt += g_burst_count;
+    nrf_wait_for_clear_channel();
+    nordic_rx_to_Stanby1();
+    nordic_standby1_to_tx_mode1();
+    #if WIRELESS_LINK_RATE
+    nrf_set_rate_idx(g_common_rate_idx);
+    #endif
+    while (sent < g_burst_count) {
+        const uint32_t remaining = g_burst_count - sent;
+        const uint32_t n = (remaining < max_per_tx) ? remaining : max_per_tx;
+        nordic_send_burst((char*) &g_burst_pkts[sent], sizeof(g_burst_pkts[0]), &g_burst_lens[sent], n);
+        sent += n;
+    }
+    g_burst_count = 0;
+
+    #if WIRELESS_LINK_RATE
+    nrf_set_rate_idx(g_rx_rate_idx);
+    #endif
+    nrf_send_done();
+}
+
+/// Sends the packet, the radio should be locked
+static int nrf_send_pkt(void* p, int len)
+{
+    /**
+     * The slots is the number of slots we allocate for someone to send their data,
+     * and we pick one of them to avoid data collision when nodes repeat a packet.
+     */
+	const uint32_t slots = MESH_MAX_NODES;
+    int packetWasSent = 1;
+
+    /**
+     * If we are not the source of this packet, that means we are repeating the packet.
+     * If we are repeating the packet to discover the route (mac.dst == MESH_ZERO_ADDR)
+     * then we need to randomly pick one air-time slot otherwise if all nodes send at
+     * the same time, then their data will collide and packet won't go through.
+     */
+    const mesh_packet_t *pkt = (mesh_packet_t*)p;
+
+    /* Our time beacon is stamped right before it is sent, but not the neighbor beacon of the mesh */
+    const bool time_beacon = (WIRELESS_TIME_MARKER == pkt->data[0] && mesh_get_node_address() == pkt->nwk.src &&
+                              MESH_ZERO_ADDR != pkt->nwk.dst);
+
+    /* The packet to a direct neighbor is sent with the compact header, except the time beacon
+     * which is stamped at the offset of its data in the packet.  We still inspect the packet.
+     */
+    mesh_packet_t frame;
+    if (!time_beacon) {
+        len = mesh_pkt_compact(pkt, &frame);
+        p = &frame;
+    }
+
+    /* The mesh gives us the header and the data, and without the dynamic payload every packet has the fixed payload */
+    if (!WIRELESS_DYN_PAYLOAD || len > MESH_PAYLOAD) {
+        len = MESH_PAYLOAD;
+    }
+
+    if (mesh_get_node_address() != pkt->nwk.src) {
+        if (MESH_ZERO_ADDR == pkt->mac.dst) {
+            const uint32_t timeSlotDelayUs = ((rand() % slots) + 1) * g_pkt_air_time_us;
+            delay_us(timeSlotDelayUs); /**< Maximize mesh nodes to repeat the packet and not collide */
+        }
+    }
+
+    /* Our ACK packet directly to its destination uses the hardware ACK, and the
+     * destination does not send an ACK_RSP packet.  The ping packet (no data) still
+     * needs the ACK_RSP packet because it contains the name of the destination.
+     * If the hardware ACK fails, we send the packet normally to use the mesh retries.
+     */
+    const bool hw_ack = WIRELESS_HW_ACK &&
+                        mesh_pkt_ack == pkt->info.pkt_type &&
+                        mesh_get_node_address() == pkt->nwk.src &&
+                        pkt->nwk.dst == pkt->mac.dst &&
+                        MESH_ZERO_ADDR != pkt->mac.dst &&
+                        MESH_BROADCAST_ADDR != pkt->mac.dst &&
+                        pkt->info.data_len > 0;
+
+    #if WIRELESS_LPL
+    nrf_lpl_wake_up(pkt->mac.dst);
+    #endif
+
+    /* Queue the packet if its task started a burst, but the packet with hardware ACK
+     * (or the time beacon) is sent by itself after the queued packets to keep their order.
+     */
+    if (NULL != g_burst_owner && xTaskGetCurrentTaskHandle() == g_burst_owner) {
+        if (!hw_ack && !time_beacon) {
+            g_burst_lens[g_burst_count] = len;
+            memcpy(&g_burst_pkts[g_burst_count++], p, len);
+            if (g_burst_count >= WIRELESS_TX_BURST_SIZE) {
+                nrf_send_burst();
+            }
+            return packetWasSent;
+        }
+        nrf_send_burst();
+    }
+
+    g_chan.tx_cnt++;
+    nrf_wait_for_clear_channel();
+
+	// Bring from RX mode to TX mode
+	nordic_rx_to_Stanby1();
+	nordic_standby1_to_tx_mode1();
+
+    #if WIRELESS_LINK_RATE
+    nrf_hw_ack_set_our_addr();
+    if (hw_ack && nrf_link_rate_send(pkt->mac.dst, p, len))
+    {
+        packetWasSent = MESH_RADIO_SEND_ACKED;
+    }
+    else
+    #elif WIRELESS_HW_ACK
+    nrf_hw_ack_set_our_addr();
+    if (hw_ack && nrf_hw_ack_send(pkt->mac.dst, p, len))
+    {
+        packetWasSent = MESH_RADIO_SEND_ACKED;
+    }
+    else
+    #endif
+    {
+        /* The beacon time is for the end of the packet, after the 130uS PLL settling */
+        if (time_beacon) {
+            wireless_time_stamp_pkt(p, 130 + WIRELESS_AIR_TIME_US(len));
+        }
+
+        // Send the packet :
+        #if WIRELESS_LINK_RATE
+        nrf_set_rate_idx(g_common_rate_idx);
+        nordic_mode1_send_single_packet(p, len);
+        nrf_set_rate_idx(g_rx_rate_idx);
+        #else
+        nordic_mode1_send_single_packet(p, len);
+        #endif
+    }
+    nrf_send_done();
+
+	return packetWasSent;
+}
+
+static int nrf_driver_send(void* p, int len)
+{
+    nrf_radio_lock();
+    const int packetWasSent = nrf_send_pkt(p, len);
+    nrf_radio_unlock();
+
+    return packetWasSent;
+}
+
+/// Reads the next frame of the radio FIFO, the radio should be locked
+static int nrf_read_frame(void* p, int len)
+{
+	int packetWasReceived = 0;
+
+	if(nordic_is_packet_available())
+	{
+		/* With the dynamic payload, the rest of the packet after its data is zero */
+		#if WIRELESS_DYN_PAYLOAD
+		const int width = nordic_get_rx_payload_width();
+		if (width > MESH_PAYLOAD || width > len || width < (int) MESH_COMPACT_HEADER_SIZE) {
+		    nordic_flush_rx_fifo();
+		    nordic_clear_packet_available_flag();
+		    return packetWasReceived;
+		}
+		memset(p, 0, len);
+		len = width;
+		#endif
+
+		const char pipe = nordic_read_rx_fifo(p, len);
+		mesh_pkt_expand((mesh_packet_t*) p);
+
+		/* Our radio already acknowledged an ACK packet of Pipe1, so the mesh
+		 * should not send an ACK_RSP packet back (see nrf_driver_send())
+		 */
+		#if WIRELESS_HW_ACK
+		mesh_packet_t *pkt = (mesh_packet_t*) p;
+		if (WIRELESS_HW_ACK_PIPE == pipe && mesh_pkt_ack == pkt->info.pkt_type) {
+		    pkt->info.pkt_type = mesh_pkt_nack;
+		}
+		#else
+		(void) pipe;
+		#endif
+
+		/* The wake-up frame of WIRELESS_LINK_RATE and the strobe of WIRELESS_LPL are not mesh packets */
+		#if WIRELESS_LINK_RATE
+		bool wake = (WIRELESS_HW_ACK_PIPE == pipe && nrf_link_rate_handle_rx(pkt));
+		#else
+		bool wake = false;
+		#endif
+		#if WIRELESS_LPL
+		wake = nrf_lpl_handle_rx((mesh_packet_t*) p) || wake;
+		#endif
+
+		// Only clear the interrupt if no more packet available
+		// because nordic has 3 level Rx FIFO.
+		if (!nordic_is_packet_available()) {
+		    nordic_clear_packet_available_flag();
+		}
+		packetWasReceived = !wake;
+		g_chan.rx_cnt++;
+	}
+
+	return packetWasReceived;
+}
+
+static int nrf_driver_receive(void* p, int len)
+{
+    wireless_radio_frame_t frame;
+    int packetWasReceived = 0;
+
+    if (g_radio_task && taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        /* The rest of the packet after its data is zero, as read from the radio */
+        memset(&frame, 0, sizeof(frame));
+        if ((packetWasReceived = (msg_buffer_read(&g_radio_rx, &frame, sizeof(frame), 0) > 0))) {
+            memcpy(p, &frame.pkt, (len < (int) sizeof(frame.pkt)) ? len : sizeof(frame.pkt));
+            g_rx_pkt_time_us = frame.rx_time_us;
+        }
+    }
+    else {
+        nrf_radio_lock();
+        packetWasReceived = nrf_read_frame(p, len);
+        nrf_radio_unlock();
+        g_rx_pkt_time_us = g_rx_irq_time_us;
+    }
+
+    return packetWasReceived;
+}
+
+static int nrf_driver_app_recv(void *p, int len)
+{
+    /* Only mesh_pkt_ack_rsp is an ACK packet, others are to REQUEST for ack or nack */
+    const mesh_packet_t *pkt = (mesh_packet_t*) p;
+    mesh_packet_t *ref = NULL;
+    mesh_packet_t *discarded = NULL;
+    int ok = 0;
+
+    /* The single ACK packet is still copied into its queue */
+    if (mesh_pkt_ack_rsp == pkt->info.pkt_type) {
+        mesh_packet_t discarded_pkt;
+        if (!(ok = xQueueSend(g_ack_queue, p, 0))) {
+            xQueueReceive(g_ack_queue, &discarded_pkt, 0);
+            ok = xQueueSend(g_ack_queue, p, 0);
+        }
+        return ok;
+    }
+
+    /* Bulk transfer packets are handled right here to avoid overflowing the small RX queue */
+    if (wireless_bulk_handle_pkt(pkt)) {
+        return 1;
+    }
+    if (wireless_mcast_handle_pkt(pkt)) {
+        return 1;
+    }
+    if (wireless_tlm_handle_pkt(pkt)) {
+        return 1;
+    }
+    if (wireless_can_handle_pkt(pkt)) {
+        return 1;
+    }
+    if (wireless_time_handle_pkt(pkt, g_rx_pkt_time_us)) {
+        return 1;
+    }
+    #if WIRELESS_CHANNEL_HOPPING
+    if (wireless_hop_handle_pkt(pkt)) {
+        return 1;
+    }
+    #endif
+
+    /* If the pool is empty, discard the oldest packet of the queue to reuse its buffer */
+    if (NULL == (ref = wireless_pkt_alloc()) && xQueueReceive(g_rx_queue, &discarded, 0)) {
+        wireless_pkt_release(discarded);
+        ref = wireless_pkt_alloc();
+    }
+    if (NULL == ref) {
+        return 0;
+    }
+    memcpy(ref, p, (len < (int) sizeof(*ref)) ? len : sizeof(*ref));
 
     /* If queue was full, discard oldest data, and push again */
+    if (!(ok = xQueueSend(g_rx_queue, &ref, 0))) {
+        if (xQueueReceive(g_rx_queue, &discarded, 0)) {
+            wireless_pkt_release(discarded);
+        }
+        ok = xQueueSend(g_rx_queue, &ref, 0);
+    }
     if (!ok) {
-        mesh_packet_t discarded_pkt;
-        xQueueReceive(qhandle, &discarded_pkt, 0);
-        ok = xQueueSend(qhandle, p, 0);
+        wireless_pkt_release(ref);
+    }
+    else if (NULL != g_rx_event) {
+        xSemaphoreGive(g_rx_event);
     }
 
     return ok;
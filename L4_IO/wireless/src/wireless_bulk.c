@@ -0,0 +1,428 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief Reliable bulk transfer over the mesh network using a sliding window.
+ *
+ * The data packets are sent as mesh_pkt_nack, so mesh.c does not wait for an ACK of
+ * each packet.  The receiver reports the next sequence number it expects, a bitmap of
+ * the packets it has buffered after that, and its free window.  The sender keeps up to
+ * WIRELESS_BULK_WINDOW packets in flight, and retransmits only the missing packets.
+ *
+ * Packet format (data payload of the mesh packet) :
+ *      Open and data : | MARKER | type + flags | seq LSB | seq MSB | data ... |
+ *      Selective ACK : | MARKER | type         | seq LSB | seq MSB | bitmap (4 bytes) | window |
+ */
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
+#include "wireless.h"
+#include "wireless_bulk_prv.h"
+#include "sys_config.h"
+
+
+
+#if (WIRELESS_BULK_WINDOW < 1 || WIRELESS_BULK_WINDOW > 32)
+#error "WIRELESS_BULK_WINDOW should be between 1 and 32 to fit the selective ACK bitmap"
+#endif
+#if (WIRELESS_BULK_RX_BUFFER & (WIRELESS_BULK_RX_BUFFER - 1))
+#error "WIRELESS_BULK_RX_BUFFER should be a power of 2 because its indexes are free running"
+#endif
+
+#define BULK_HDR_SIZE       4                                       ///< Bytes of the header of the data packets
+#define BULK_DATA_SIZE      (MESH_DATA_PAYLOAD_SIZE - BULK_HDR_SIZE)///< Data bytes of each packet
+#define BULK_SACK_SIZE      (BULK_HDR_SIZE + 4 + 1)                 ///< Bytes of the selective ACK packet
+#define BULK_RETRIES_MAX    10                                      ///< Consecutive timeouts before we give up
+#define BULK_FLAG_ACK_REQ   0x80                                    ///< Receiver should ACK right away
+#define BULK_TYPE_MASK      0x7F
+
+/// Types of the bulk transfer packets
+typedef enum {
+    bulk_open = 1,      ///< Starts a new transfer from the sender, and resets the receiver
+    bulk_data = 2,      ///< Data packet
+    bulk_sack = 3,      ///< Selective ACK from the receiver
+} bulk_type_t;
+
+/// Receiver state, modified only by the wireless task (except the ring buffer read index)
+static struct {
+    uint8_t src;                ///< Source of the current transfer, MESH_ZERO_ADDR if none
+    uint8_t hops;               ///< Max hops of the sender's packets, used for the selective ACK
+    uint16_t next_seq;          ///< Sequence number of the next in-order packet
+    uint32_t ooo_mask;          ///< Bit N means that (next_seq + N) is buffered out of order
+    uint8_t pkts_since_sack;    ///< Packets received since the last selective ACK
+    volatile bool sack_pending; ///< A selective ACK should be sent
+    uint8_t ooo_len[WIRELESS_BULK_WINDOW];
+    uint8_t ooo_data[WIRELESS_BULK_WINDOW][BULK_DATA_SIZE];
+} g_rx;
+
+static uint8_t g_rx_ring[WIRELESS_BULK_RX_BUFFER];  ///< In-order data for wireless_bulk_recv()
+static volatile uint32_t g_rx_wr = 0;               ///< Free running write index of g_rx_ring
+static volatile uint32_t g_rx_rd = 0;               ///< Free running read index of g_rx_ring
+static SemaphoreHandle_t g_rx_sem = NULL;           ///< Given when data is added to g_rx_ring
+
+/// Sender state that is used by the task calling wireless_bulk_send()
+static struct {
+    uint8_t dst;                ///< Destination of the transfer
+    uint8_t hops;               ///< Max hops of the packets
+    uint16_t next_seq;          ///< Sequence number of the next new packet
+    bool open;                  ///< True after wireless_bulk_open() succeeds
+} g_tx;
+
+/// Latest selective ACK received by the wireless task for the sender
+static struct {
+    uint8_t src;
+    uint16_t base;
+    uint32_t mask;
+    uint8_t window;
+} g_tx_sack;
+static SemaphoreHandle_t g_tx_sack_sem = NULL;      ///< Given when a selective ACK is received
+
+
+
+/// @returns the number of packets that are guaranteed to fit into the ring buffer
+static uint8_t bulk_rx_window(void)
+{
+    const uint32_t free_bytes = sizeof(g_rx_ring) - (g_rx_wr - g_rx_rd);
+    const uint32_t pkts = free_bytes / BULK_DATA_SIZE;
+    return (pkts < WIRELESS_BULK_WINDOW) ? pkts : WIRELESS_BULK_WINDOW;
+}
+
+/// Appends in-order data to the ring buffer
+static void bulk_rx_append(const uint8_t *data, uint8_t len)
+{
+    uint8_t i = 0;
+    for (i = 0; i < len; i++) {
+        g_rx_ring[(g_rx_wr + i) % sizeof(g_rx_ring)] = data[i];
+    }
+    g_rx_wr += len;
+}
+
+static void bulk_rx_handle_data(const mesh_packet_t *pkt, const uint16_t seq, const uint8_t flags)
+{
+    const uint8_t len = pkt->info.data_len - BULK_HDR_SIZE;
+    const uint16_t d = (uint16_t)(seq - g_rx.next_seq);
+    const uint8_t slot = seq % WIRELESS_BULK_WINDOW;
+
+    if (pkt->nwk.src != g_rx.src || 0 == len || len > BULK_DATA_SIZE) {
+        return;
+    }
+
+    /* Duplicate of a packet we already have, or beyond our window; the sender should learn
+     * our state because it probably missed our selective ACK.
+     */
+    if (d >= bulk_rx_window()) {
+        g_rx.sack_pending = true;
+        return;
+    }
+
+    if (0 == d) {
+        bulk_rx_append(&pkt->data[BULK_HDR_SIZE], len);
+        g_rx.next_seq++;
+        g_rx.ooo_mask >>= 1;
+
+        /* Deliver the packets that were waiting for this one */
+        while (g_rx.ooo_mask & 1) {
+            const uint8_t s = g_rx.next_seq % WIRELESS_BULK_WINDOW;
+            bulk_rx_append(&g_rx.ooo_data[s][0], g_rx.ooo_len[s]);
+            g_rx.next_seq++;
+            g_rx.ooo_mask >>= 1;
+        }
+        xSemaphoreGive(g_rx_sem);
+    }
+    else {
+        memcpy(&g_rx.ooo_data[slot][0], &pkt->data[BULK_HDR_SIZE], len);
+        g_rx.ooo_len[slot] = len;
+        g_rx.ooo_mask |= (1UL << d);
+
+        /* Report the hole right away such that the sender can retransmit it */
+        g_rx.sack_pending = true;
+    }
+
+    if ((flags & BULK_FLAG_ACK_REQ) || ++g_rx.pkts_since_sack >= (WIRELESS_BULK_WINDOW + 1) / 2) {
+        g_rx.sack_pending = true;
+    }
+}
+
+static bool bulk_send_pkt(uint8_t dst, uint8_t hops, uint8_t type, uint16_t seq, const void *data, uint8_t len)
+{
+    uint8_t buffer[MESH_DATA_PAYLOAD_SIZE];
+
+    buffer[0] = WIRELESS_BULK_MARKER;
+    buffer[1] = type;
+    buffer[2] = (seq >> 0) & 0xFF;
+    buffer[3] = (seq >> 8) & 0xFF;
+    if (len > 0) {
+        memcpy(&buffer[BULK_HDR_SIZE], data, len);
+    }
+
+    return mesh_send(dst, mesh_pkt_nack, buffer, BULK_HDR_SIZE + len, hops);
+}
+
+/// Sends a data packet of the sender's sequence number seq
+static void bulk_send_seq(const uint8_t *data, uint32_t len, uint16_t first, uint16_t seq, bool ack_req)
+{
+    const uint32_t offset = (uint16_t)(seq - first) * BULK_DATA_SIZE;
+    const uint32_t remaining = len - offset;
+    const uint8_t pkt_len = (remaining < BULK_DATA_SIZE) ? remaining : BULK_DATA_SIZE;
+    const uint8_t type = bulk_data | (ack_req ? BULK_FLAG_ACK_REQ : 0);
+
+    bulk_send_pkt(g_tx.dst, g_tx.hops, type, seq, &data[offset], pkt_len);
+}
+
+/// @returns the time to wait for a selective ACK
+static TickType_t bulk_rto(void)
+{
+    const TickType_t ticks = OS_MS(2 * mesh_get_expected_ack_time(g_tx.dst));
+    return ticks ? ticks : 1;
+}
+
+
+
+bool wireless_bulk_init(void)
+{
+    if (NULL == g_rx_sem) {
+        g_rx_sem = xSemaphoreCreateBinary();
+    }
+    if (NULL == g_tx_sack_sem) {
+        g_tx_sack_sem = xSemaphoreCreateBinary();
+    }
+    return (NULL != g_rx_sem && NULL != g_tx_sack_sem);
+}
+
+bool wireless_bulk_handle_pkt(const mesh_packet_t *pkt)
+{
+    if (pkt->info.data_len < BULK_HDR_SIZE || WIRELESS_BULK_MARKER != pkt->data[0]) {
+        return false;
+    }
+    /* Bulk transfer needs the wireless task, so drop the packets until FreeRTOS is running */
+    if (taskSCHEDULER_RUNNING != xTaskGetSchedulerState()) {
+        return true;
+    }
+
+    const uint8_t type  = pkt->data[1] & BULK_TYPE_MASK;
+    const uint8_t flags = pkt->data[1] & ~BULK_TYPE_MASK;
+    const uint16_t seq  = pkt->data[2] | (pkt->data[3] << 8);
+
+    switch (type)
+    {
+        case bulk_open:
+            /* Discard any previous transfer, and start over from sequence number 0 */
+            taskENTER_CRITICAL();
+            g_rx.src = pkt->nwk.src;
+            g_rx.hops = pkt->info.hop_count_max;
+            g_rx.next_seq = 0;
+            g_rx.ooo_mask = 0;
+            g_rx.pkts_since_sack = 0;
+            g_rx_rd = g_rx_wr;
+            taskEXIT_CRITICAL();
+            g_rx.sack_pending = true;
+            break;
+
+        case bulk_data:
+            bulk_rx_handle_data(pkt, seq, flags);
+            break;
+
+        case bulk_sack:
+            if (BULK_SACK_SIZE == pkt->info.data_len) {
+                taskENTER_CRITICAL();
+                g_tx_sack.src = pkt->nwk.src;
+                g_tx_sack.base = seq;
+                g_tx_sack.mask = pkt->data[4] | (pkt->data[5] << 8) | (pkt->data[6] << 16) | ((uint32_t)pkt->data[7] << 24);
+                g_tx_sack.window = pkt->data[8];
+                taskEXIT_CRITICAL();
+                xSemaphoreGive(g_tx_sack_sem);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return true;
+}
+
+void wireless_bulk_service(void)
+{
+    uint8_t sack[BULK_SACK_SIZE - BULK_HDR_SIZE];
+
+    if (!g_rx.sack_pending || MESH_ZERO_ADDR == g_rx.src) {
+        return;
+    }
+
+    g_rx.sack_pending = false;
+    g_rx.pkts_since_sack = 0;
+
+    sack[0] = (g_rx.ooo_mask >> 0)  & 0xFF;
+    sack[1] = (g_rx.ooo_mask >> 8)  & 0xFF;
+    sack[2] = (g_rx.ooo_mask >> 16) & 0xFF;
+    sack[3] = (g_rx.ooo_mask >> 24) & 0xFF;
+    sack[4] = bulk_rx_window();
+    bulk_send_pkt(g_rx.src, g_rx.hops, bulk_sack, g_rx.next_seq, sack, sizeof(sack));
+}
+
+bool wireless_bulk_open(uint8_t dst_addr, uint8_t max_hops)
+{
+    uint32_t tries = 0;
+
+    g_tx.dst = dst_addr;
+    g_tx.hops = max_hops;
+    g_tx.next_seq = 0;
+    g_tx.open = false;
+
+    for (tries = 0; tries < BULK_RETRIES_MAX && !g_tx.open; tries++) {
+        xSemaphoreTake(g_tx_sack_sem, 0);
+        bulk_send_pkt(dst_addr, max_hops, bulk_open | BULK_FLAG_ACK_REQ, 0, NULL, 0);
+
+        if (xSemaphoreTake(g_tx_sack_sem, bulk_rto())) {
+            taskENTER_CRITICAL();
+            g_tx.open = (dst_addr == g_tx_sack.src && 0 == g_tx_sack.base);
+            taskEXIT_CRITICAL();
+        }
+    }
+
+    return g_tx.open;
+}
+
+bool wireless_bulk_send(const void *data, uint32_t len)
+{
+    const uint8_t *bytes = (const uint8_t*) data;
+    const uint32_t num_pkts = (len + BULK_DATA_SIZE - 1) / BULK_DATA_SIZE;
+    const uint16_t first = g_tx.next_seq;
+    const uint16_t end = first + num_pkts;
+
+    uint16_t base = first;          ///< Oldest packet not received in order
+    uint16_t next = first;          ///< Next new packet to send
+    uint32_t retx_mask = 0;         ///< Bit N means that (base + N) was retransmitted since the last timeout
+    uint8_t peer_window = WIRELESS_BULK_WINDOW;
+    uint32_t timeouts = 0;
+
+    if (!g_tx.open || num_pkts > 0x7FFF) {
+        return false;
+    }
+
+    while (base != end)
+    {
+        /* Fill the window with new packets, and ask for an ACK with the last one */
+        const uint16_t in_flight = next - base;
+        uint16_t new_pkts = (peer_window > in_flight) ? (peer_window - in_flight) : 0;
+        if (new_pkts > (uint16_t)(end - next)) {
+            new_pkts = end - next;
+        }
+        wireless_tx_burst_begin();
+        while (new_pkts--) {
+            bulk_send_seq(bytes, len, first, next, (0 == new_pkts));
+            next++;
+        }
+        wireless_tx_burst_end();
+
+        if (!xSemaphoreTake(g_tx_sack_sem, bulk_rto())) {
+            /* Probe with the oldest packet, which also learns about the reopened window */
+            if (++timeouts > BULK_RETRIES_MAX) {
+                g_tx.open = false;
+                return false;
+            }
+            retx_mask = 0;
+            bulk_send_seq(bytes, len, first, base, true);
+
+            /* If the receiver's window was closed, the probe was a new packet */
+            if (next == base) {
+                next++;
+            }
+            continue;
+        }
+
+        taskENTER_CRITICAL();
+        const uint8_t sack_src = g_tx_sack.src;
+        const uint16_t sack_base = g_tx_sack.base;
+        const uint32_t sack_mask = g_tx_sack.mask;
+        const uint8_t sack_window = g_tx_sack.window;
+        taskEXIT_CRITICAL();
+
+        /* Ignore the selective ACKs of other nodes, or with old data */
+        const uint16_t acked = sack_base - base;
+        if (sack_src != g_tx.dst || acked > (uint16_t)(next - base)) {
+            continue;
+        }
+
+        timeouts = 0;
+        base = sack_base;
+        retx_mask = (acked < 32) ? (retx_mask >> acked) : 0;
+        peer_window = (sack_window < WIRELESS_BULK_WINDOW) ? sack_window : WIRELESS_BULK_WINDOW;
+
+        /* Retransmit the holes below the latest packet that the receiver has */
+        if (sack_mask) {
+            uint32_t i = 0;
+            uint32_t last = 31;
+            while (!(sack_mask & (1UL << last))) {
+                last--;
+            }
+            wireless_tx_burst_begin();
+            for (i = 0; i < last; i++) {
+                const uint32_t bit = (1UL << i);
+                if (!(sack_mask & bit) && !(retx_mask & bit)) {
+                    bulk_send_seq(bytes, len, first, base + i, false);
+                    retx_mask |= bit;
+                }
+            }
+            wireless_tx_burst_end();
+        }
+    }
+
+    g_tx.next_seq = end;
+    return true;
+}
+
+uint32_t wireless_bulk_recv(void *data, uint32_t max_len, uint32_t timeout_ms)
+{
+    uint8_t *bytes = (uint8_t*) data;
+    uint32_t count = 0;
+
+    const TickType_t start = xTaskGetTickCount();
+    const TickType_t timeout = OS_MS(timeout_ms);
+
+    /* The semaphore may be left over from data that was already read, so check the ring again */
+    while (g_rx_wr == g_rx_rd) {
+        const TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout || !xSemaphoreTake(g_rx_sem, timeout - elapsed)) {
+            return 0;
+        }
+    }
+
+    const uint8_t window_before = bulk_rx_window();
+    while (count < max_len && g_rx_rd != g_rx_wr) {
+        bytes[count++] = g_rx_ring[g_rx_rd % sizeof(g_rx_ring)];
+        g_rx_rd++;
+    }
+
+    /* If the sender could be stalled by our small window, tell it that the window is open again */
+    if (count && window_before < (WIRELESS_BULK_WINDOW + 1) / 2 && bulk_rx_window() > window_before) {
+        g_rx.sack_pending = true;
+        wireless_wakeup_service();
+    }
+
+    return count;
+}
+
+uint8_t wireless_bulk_get_rx_src(void)
+{
+    return g_rx.src;
+}
@@ -0,0 +1,105 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief Private functions between wireless.c, wireless_bulk.c, wireless_mcast.c, wireless_tlm.c, wireless_time.c
+ *        and wireless_can.c
+ * @ingroup  WIRELESS
+ */
+#ifndef WIRELESS_BULK_PRV_H__
+#define WIRELESS_BULK_PRV_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdbool.h>
+#include "mesh_typedefs.h"
+
+
+
+/// Creates the semaphores of the bulk transfer
+bool wireless_bulk_init(void);
+
+/**
+ * Called by the application receive callback of the mesh network.
+ * @returns true if the packet belonged to the bulk transfer, and should not be queued.
+ */
+bool wireless_bulk_handle_pkt(const mesh_packet_t *pkt);
+
+/// Called by wireless_service() after mesh_service() to send the pending selective ACK
+void wireless_bulk_service(void);
+
+/// Creates the queue of the blocks of the multicast transfer
+bool wireless_mcast_init(void);
+
+/**
+ * Called by the application receive callback of the mesh network.
+ * @returns true if the packet belonged to the multicast transfer, and should not be queued.
+ */
+bool wireless_mcast_handle_pkt(const mesh_packet_t *pkt);
+
+/// Called by wireless_service() to send our NACKs once their random delay is over
+void wireless_mcast_service(void);
+
+/// @returns the milliseconds until wireless_mcast_service() sends our NACKs, or UINT32_MAX if none
+uint32_t wireless_mcast_get_due_ms(void);
+
+/// Creates the semaphore of the telemetry query
+bool wireless_tlm_init(void);
+
+/**
+ * Called by the application receive callback of the mesh network.
+ * @returns true if the packet was a telemetry query or reply, and should not be queued.
+ */
+bool wireless_tlm_handle_pkt(const mesh_packet_t *pkt);
+
+/// Called by wireless_service() to reply the telemetry query of another node
+void wireless_tlm_service(void);
+
+/**
+ * Called by the application receive callback of the mesh network.
+ * @returns true if the packet was of the CAN gateway, and should not be queued.
+ */
+bool wireless_can_handle_pkt(const mesh_packet_t *pkt);
+
+/**
+ * Called by the application receive callback of the mesh network.
+ * @param rx_time_us  Our uptime of the RX interrupt of the packet
+ * @returns true if the packet was a time beacon, and should not be queued.
+ */
+bool wireless_time_handle_pkt(const mesh_packet_t *pkt, const uint64_t rx_time_us);
+
+/**
+ * Called by the radio driver right before the packet is sent, and writes the time
+ * into our time beacon.  Other packets are not modified.
+ * @param latency_us  Time from now until the end of the packet is received
+ */
+void wireless_time_stamp_pkt(void *pkt, const uint32_t latency_us);
+
+/// Called by wireless_service() to send our time beacon
+void wireless_time_service(void);
+
+/// Wakes up the task blocked in wireless_service() (implemented by wireless.c)
+void wireless_wakeup_service(void);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* WIRELESS_BULK_PRV_H__ */
@@ -0,0 +1,483 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "wireless.h"
+#include "wireless_can.h"
+#include "wireless_bulk_prv.h"
+#include "sys_config.h"
+#include "lpc_sys.h"    // sys_get_uptime_ms()
+
+
+
+#define CAN_GW_HDR_SIZE     2       ///< Bytes of the header of each packet: the marker and the sequence number
+#define CAN_GW_FLAG_29BIT   0x80    ///< Set in the first byte of a frame with a 29-bit ID
+#define CAN_GW_DLC_SHIFT    3       ///< The data length is in bits 6-3 of the first byte of a frame
+#define CAN_GW_STD_HDR      2       ///< Bytes of the header of a frame with an 11-bit ID
+#define CAN_GW_EXT_HDR      5       ///< Bytes of the header of a frame with a 29-bit ID
+#define CAN_GW_RX_BATCH     8       ///< Frames read from the CAN at once
+#define CAN_GW_IDLE_MS      100     ///< The gateway task waits up to this long for the frames
+
+/// The routes have to fit the sizes of the packets and of the counters
+typedef char can_gw_sizes_check[(CAN_GW_HDR_SIZE + CAN_GW_EXT_HDR + 8 <= MESH_DATA_PAYLOAD_SIZE &&
+                                 WIRELESS_CAN_MAX_ROUTES <= 255) ? 1 : -1];
+
+/// The rate limit of a route in thousandths of a frame, @see logger_bucket_take()
+typedef struct {
+    uint32_t tokens;            ///< Thousandths of the frames that can be sent
+    uint32_t last_ms;           ///< The uptime of the last refill
+} can_gw_bucket_t;
+
+/**
+ * The packet being coalesced for a node, which is only used by the gateway task.  The slot keeps
+ * its node once the packet is sent, so the sequence numbers to the node stay consecutive.
+ * The sequence number 0 starts a new sequence, which is not counted as lost packets.
+ */
+typedef struct {
+    uint8_t node;               ///< The destination of the packet
+    uint8_t hops;               ///< The max hops of the packet, which is the highest of its routes
+    uint8_t len;                ///< Bytes of data[], or 0 if the slot has no frames
+    uint8_t seq;                ///< The sequence number of the next packet to the node
+    uint8_t frames;             ///< The frames in data[]
+    bool used;                  ///< True once the slot has a node
+    uint32_t first_ms;          ///< The uptime of the first frame of the packet
+    uint8_t data[MESH_DATA_PAYLOAD_SIZE];   ///< The packet
+} can_gw_batch_t;
+
+/// The last sequence number received from a node, which is only used by the wireless task
+typedef struct {
+    uint8_t node;               ///< The sender, or MESH_ZERO_ADDR if the entry is unused
+    uint8_t seq;                ///< Its last sequence number
+} can_gw_source_t;
+
+/// The routes are used by the gateway and the wireless task, and only changed within a critical section
+static struct {
+    wireless_can_route_t routes[WIRELESS_CAN_MAX_ROUTES];
+    can_gw_bucket_t buckets[WIRELESS_CAN_MAX_ROUTES];
+    uint8_t count;
+    can_gw_batch_t batches[WIRELESS_CAN_DESTS];
+    can_gw_source_t sources[WIRELESS_CAN_SOURCES];
+    uint8_t next_source;        ///< The entry of sources[] replaced by the next new sender
+    wireless_can_stats_t stats;
+    TaskHandle_t task;
+} g_gw;
+
+
+
+/// Adds to a counter that is updated by both tasks
+static inline void can_gw_count(uint32_t *counter, uint32_t n)
+{
+    taskENTER_CRITICAL();
+    *counter += n;
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * Refills the bucket of a route based on the elapsed time, up to a second of frames, and takes a frame from it.
+ * @returns true if the frame can be sent
+ */
+static bool can_gw_bucket_take(can_gw_bucket_t *b, const uint16_t rate, const uint32_t now_ms)
+{
+    if (0 == rate) {
+        return true;
+    }
+
+    const uint32_t max_tokens = (uint32_t) rate * 1000;
+    uint32_t elapsed_ms = now_ms - b->last_ms;
+    b->last_ms = now_ms;
+
+    if (elapsed_ms > 1000) {
+        elapsed_ms = 1000;
+    }
+    b->tokens += elapsed_ms * rate;
+    if (b->tokens > max_tokens) {
+        b->tokens = max_tokens;
+    }
+
+    if (b->tokens >= 1000) {
+        b->tokens -= 1000;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Finds the first route of a frame, and takes the frame from its rate limit.
+ * @param can   The CAN of a wireless_can_to_mesh frame
+ * @param src   The sender of a wireless_can_to_can frame
+ * @param key   The ID of the frame, with WIRELESS_CAN_ID_29BIT for a 29-bit ID
+ * @returns true if the frame should be bridged by the route
+ */
+static bool can_gw_route_take(wireless_can_dir_t dir, can_t can, uint8_t src, uint32_t key, wireless_can_route_t *route)
+{
+    const uint32_t now_ms = sys_get_uptime_ms();
+    bool found = false, allowed = false;
+    uint8_t i = 0;
+
+    taskENTER_CRITICAL();
+    for (i = 0; i < g_gw.count && !found; i++) {
+        const wireless_can_route_t *r = &g_gw.routes[i];
+        found = (dir == r->dir && (key & r->mask) == (r->id & r->mask) &&
+                 ((wireless_can_to_mesh == dir) ? (can == r->can) : (MESH_BROADCAST_ADDR == r->node || src == r->node)));
+        if (found) {
+            *route = *r;
+            if (!(allowed = can_gw_bucket_take(&g_gw.buckets[i], r->max_per_sec, now_ms))) {
+                g_gw.stats.limited++;
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return allowed;
+}
+
+/// @returns the ID of the frame given by the map_id of its route, which keeps the format of the ID
+static uint32_t can_gw_map_id(const wireless_can_route_t *route, uint32_t id, bool is_29bit)
+{
+    const uint32_t mask = route->mask & (is_29bit ? 0x1FFFFFFF : 0x7FF);
+    return (0 == route->map_id) ? id : ((id & ~mask) | (route->map_id & mask));
+}
+
+/// @returns the bytes of the frame in a packet
+static inline uint8_t can_gw_frame_size(bool is_29bit, uint8_t dlc)
+{
+    return (is_29bit ? CAN_GW_EXT_HDR : CAN_GW_STD_HDR) + dlc;
+}
+
+/**
+ * Reads a frame of a packet.
+ * @returns the bytes of the frame, or 0 if it does not fit the rest of the packet
+ */
+static uint8_t can_gw_decode(const uint8_t *data, uint8_t len, can_msg_t *msg)
+{
+    const bool is_29bit = (data[0] & CAN_GW_FLAG_29BIT);
+    const uint8_t dlc = (data[0] >> CAN_GW_DLC_SHIFT) & 0x0F;
+    const uint8_t size = can_gw_frame_size(is_29bit, dlc);
+
+    if (dlc > 8 || size > len) {
+        return 0;
+    }
+
+    memset(msg, 0, sizeof(*msg));
+    msg->frame_fields.is_29bit = is_29bit;
+    msg->frame_fields.data_len = dlc;
+    if (is_29bit) {
+        msg->msg_id = data[1] | (data[2] << 8) | (data[3] << 16) | ((uint32_t) data[4] << 24);
+    }
+    else {
+        msg->msg_id = ((data[0] & 0x07) << 8) | data[1];
+    }
+    memcpy(&msg->data.bytes[0], &data[size - dlc], dlc);
+    return size;
+}
+
+/// Writes a frame to a packet; @returns the bytes of the frame
+static uint8_t can_gw_encode(uint8_t *data, const can_msg_t *msg, uint32_t id, uint8_t dlc)
+{
+    const bool is_29bit = msg->frame_fields.is_29bit;
+    const uint8_t size = can_gw_frame_size(is_29bit, dlc);
+
+    if (is_29bit) {
+        data[0] = CAN_GW_FLAG_29BIT | (dlc << CAN_GW_DLC_SHIFT);
+        data[1] = (id >> 0) & 0xFF;
+        data[2] = (id >> 8) & 0xFF;
+        data[3] = (id >> 16) & 0xFF;
+        data[4] = (id >> 24) & 0x1F;
+    }
+    else {
+        data[0] = (dlc << CAN_GW_DLC_SHIFT) | ((id >> 8) & 0x07);
+        data[1] = id & 0xFF;
+    }
+    memcpy(&data[size - dlc], &msg->data.bytes[0], dlc);
+    return size;
+}
+
+/// Sends the packet of the slot
+static void can_gw_send(can_gw_batch_t *b)
+{
+    if (wireless_send(b->node, mesh_pkt_nack, b->data, b->len, b->hops)) {
+        g_gw.stats.to_mesh_pkts++;
+        g_gw.stats.to_mesh_frames += b->frames;
+    }
+    else {
+        can_gw_count(&g_gw.stats.failed, b->frames);
+    }
+
+    b->seq = (255 == b->seq) ? 1 : (b->seq + 1);
+    b->len = 0;
+    b->frames = 0;
+}
+
+/// @returns the slot of the packet to the node, or a new one, which may send the oldest packet
+static can_gw_batch_t* can_gw_get_batch(uint8_t node)
+{
+    can_gw_batch_t *pFree = NULL, *pOldest = NULL;
+    uint8_t i = 0;
+
+    for (i = 0; i < WIRELESS_CAN_DESTS; i++) {
+        can_gw_batch_t *b = &g_gw.batches[i];
+        if (b->used && node == b->node) {
+            return b;
+        }
+        if (!pFree && (!b->used || 0 == b->len)) {
+            pFree = b;
+        }
+        if (b->len > 0 && (!pOldest || (int32_t) (b->first_ms - pOldest->first_ms) < 0)) {
+            pOldest = b;
+        }
+    }
+
+    if (!pFree) {
+        can_gw_send(pOldest);
+        pFree = pOldest;
+    }
+    pFree->used = true;
+    pFree->node = node;
+    pFree->seq = 0;
+    return pFree;
+}
+
+/// Adds a frame of the CAN to the packet of the node of its route
+static void can_gw_to_mesh(can_t can, const can_msg_t *msg, uint32_t now_ms)
+{
+    const bool is_29bit = msg->frame_fields.is_29bit;
+    const uint32_t key = msg->msg_id | (is_29bit ? WIRELESS_CAN_ID_29BIT : 0);
+    const uint8_t dlc = (msg->frame_fields.data_len > 8) ? 8 : msg->frame_fields.data_len;
+    const uint8_t size = can_gw_frame_size(is_29bit, dlc);
+    wireless_can_route_t route;
+    can_msg_t pending;
+    uint8_t offset = CAN_GW_HDR_SIZE, n = 0;
+
+    if (msg->frame_fields.is_rtr || !can_gw_route_take(wireless_can_to_mesh, can, MESH_ZERO_ADDR, key, &route)) {
+        return;
+    }
+
+    const uint32_t id = can_gw_map_id(&route, msg->msg_id, is_29bit);
+    can_gw_batch_t *b = can_gw_get_batch(route.node);
+
+    /* A newer frame of the same ID and size replaces the one in the packet */
+    while (offset < b->len && 0 != (n = can_gw_decode(&b->data[offset], b->len - offset, &pending))) {
+        if (id == pending.msg_id && is_29bit == pending.frame_fields.is_29bit && dlc == pending.frame_fields.data_len) {
+            can_gw_encode(&b->data[offset], msg, id, dlc);
+            g_gw.stats.coalesced++;
+            return;
+        }
+        offset += n;
+    }
+
+    if (b->len + size > sizeof(b->data)) {
+        can_gw_send(b);
+    }
+    if (0 == b->len) {
+        b->data[0] = WIRELESS_CAN_MARKER;
+        b->data[1] = b->seq;
+        b->len = CAN_GW_HDR_SIZE;
+        b->hops = 0;
+        b->first_ms = now_ms;
+    }
+    if (route.max_hops > b->hops) {
+        b->hops = route.max_hops;
+    }
+
+    b->len += can_gw_encode(&b->data[b->len], msg, id, dlc);
+    b->frames++;
+
+    /* Send it now if not even a frame without data fits */
+    if (b->len + CAN_GW_STD_HDR > sizeof(b->data)) {
+        can_gw_send(b);
+    }
+}
+
+/**
+ * Sends the packets whose first frame is WIRELESS_CAN_BATCH_MS old.
+ * @returns the milliseconds until the next packet is due, or CAN_GW_IDLE_MS if none
+ */
+static uint32_t can_gw_send_due(uint32_t now_ms)
+{
+    uint32_t wait_ms = CAN_GW_IDLE_MS;
+    uint8_t i = 0;
+
+    wireless_tx_burst_begin();
+    for (i = 0; i < WIRELESS_CAN_DESTS; i++) {
+        can_gw_batch_t *b = &g_gw.batches[i];
+        if (b->len > 0) {
+            const uint32_t age_ms = now_ms - b->first_ms;
+            if (age_ms >= WIRELESS_CAN_BATCH_MS) {
+                can_gw_send(b);
+            }
+            else if (WIRELESS_CAN_BATCH_MS - age_ms < wait_ms) {
+                wait_ms = WIRELESS_CAN_BATCH_MS - age_ms;
+            }
+        }
+    }
+    wireless_tx_burst_end();
+
+    return wait_ms;
+}
+
+/// @returns true if a wireless_can_to_mesh route reads the CAN
+static bool can_gw_reads(can_t can)
+{
+    uint8_t i = 0;
+    for (i = 0; i < g_gw.count; i++) {
+        if (wireless_can_to_mesh == g_gw.routes[i].dir && can == g_gw.routes[i].can) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void can_gw_task(void *p)
+{
+    can_rx_msg_t msgs[CAN_GW_RX_BATCH];
+
+    for (;;) {
+        const bool both = can_gw_reads(can1) && can_gw_reads(can2);
+        uint32_t wait_ms = can_gw_send_due(sys_get_uptime_ms());
+        bool read = false;
+        int c = 0;
+
+        /* The first CAN blocks, so the other one is polled at least every batch window */
+        if (both && wait_ms > WIRELESS_CAN_BATCH_MS) {
+            wait_ms = WIRELESS_CAN_BATCH_MS;
+        }
+
+        for (c = can1; c < can_max; c++) {
+            if (can_gw_reads((can_t) c)) {
+                const uint16_t count = CAN_rx_batch((can_t) c, msgs, CAN_GW_RX_BATCH, read ? 0 : wait_ms);
+                const uint32_t now_ms = sys_get_uptime_ms();
+                uint16_t i = 0;
+
+                for (i = 0; i < count; i++) {
+                    can_gw_to_mesh((can_t) c, &msgs[i].msg, now_ms);
+                }
+                read = true;
+            }
+        }
+
+        if (!read) {
+            vTaskDelay(OS_MS(CAN_GW_IDLE_MS));
+        }
+    }
+}
+
+/// Counts the packets from the node that were lost before this one
+static void can_gw_count_lost(uint8_t node, uint8_t seq)
+{
+    can_gw_source_t *pSource = NULL;
+    uint8_t i = 0;
+
+    for (i = 0; i < WIRELESS_CAN_SOURCES && !pSource; i++) {
+        if (node == g_gw.sources[i].node) {
+            pSource = &g_gw.sources[i];
+        }
+    }
+
+    if (!pSource) {
+        pSource = &g_gw.sources[g_gw.next_source];
+        g_gw.next_source = (g_gw.next_source + 1) % WIRELESS_CAN_SOURCES;
+        pSource->node = node;
+    }
+    /* The sequence numbers are 1-255 after the 0 of a new sequence */
+    else if (0 != seq && 0 != pSource->seq) {
+        const uint8_t expected = (255 == pSource->seq) ? 1 : (pSource->seq + 1);
+        can_gw_count(&g_gw.stats.lost_pkts, (seq + 255 - expected) % 255);
+    }
+    pSource->seq = seq;
+}
+
+
+
+bool wireless_can_handle_pkt(const mesh_packet_t *pkt)
+{
+    const uint8_t len = pkt->info.data_len;
+    uint8_t offset = CAN_GW_HDR_SIZE, n = 0;
+    can_msg_t msg;
+
+    if (len < CAN_GW_HDR_SIZE || WIRELESS_CAN_MARKER != pkt->data[0]) {
+        return false;
+    }
+
+    g_gw.stats.to_can_pkts++;
+    can_gw_count_lost(pkt->nwk.src, pkt->data[1]);
+
+    while (offset < len && 0 != (n = can_gw_decode(&pkt->data[offset], len - offset, &msg))) {
+        const bool is_29bit = msg.frame_fields.is_29bit;
+        const uint32_t key = msg.msg_id | (is_29bit ? WIRELESS_CAN_ID_29BIT : 0);
+        wireless_can_route_t route;
+
+        if (can_gw_route_take(wireless_can_to_can, can_max, pkt->nwk.src, key, &route)) {
+            msg.msg_id = can_gw_map_id(&route, msg.msg_id, is_29bit);
+            if (CAN_tx(route.can, &msg, 0)) {
+                g_gw.stats.to_can_frames++;
+            }
+            else {
+                can_gw_count(&g_gw.stats.failed, 1);
+            }
+        }
+        offset += n;
+    }
+
+    return true;
+}
+
+bool wireless_can_start(const wireless_can_route_t *routes, uint8_t count, UBaseType_t priority)
+{
+    const uint32_t now_ms = sys_get_uptime_ms();
+    uint8_t i = 0;
+
+    if (count > WIRELESS_CAN_MAX_ROUTES || (count > 0 && NULL == routes)) {
+        return false;
+    }
+
+    /* Each route starts with a second of frames */
+    taskENTER_CRITICAL();
+    for (i = 0; i < count; i++) {
+        g_gw.routes[i] = routes[i];
+        g_gw.buckets[i].tokens = (uint32_t) routes[i].max_per_sec * 1000;
+        g_gw.buckets[i].last_ms = now_ms;
+    }
+    g_gw.count = count;
+    taskEXIT_CRITICAL();
+
+#if BUILD_CFG_MPU
+    priority |= portPRIVILEGE_BIT;
+#endif
+
+    if (NULL == g_gw.task && count > 0 &&
+        !xTaskCreate(can_gw_task, "cangw", WIRELESS_CAN_STACK_SIZE, NULL, priority, &g_gw.task)) {
+        g_gw.task = NULL;
+        return false;
+    }
+    return true;
+}
+
+wireless_can_stats_t wireless_can_get_stats(void)
+{
+    wireless_can_stats_t stats;
+
+    taskENTER_CRITICAL();
+    stats = g_gw.stats;
+    taskEXIT_CRITICAL();
+
+    return stats;
+}
@@ -0,0 +1,450 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief Multicast distribution of a file to all the nodes, with the repairs based on NACKs.
+ *
+ * The sender broadcasts the numbered blocks of the file, and then a poll.  Each receiver
+ * keeps a bitmap of the blocks it has, and answers the poll after a random delay with the
+ * bitmaps of the first ranges of the blocks it misses.  The sender merges the missing blocks
+ * of all the receivers into its own bitmap, and broadcasts each of them once in the next
+ * round.  The sender is done once MCAST_QUIET_POLLS polls in a row are not answered.
+ *
+ * The poll also announces the file, so a node that starts listening in the middle of the
+ * transfer gets the blocks it missed through the repairs.
+ *
+ * Packet format (data payload of the mesh packet) :
+ *      Data : | MARKER | type | session | block LSB | block MSB | data ... |
+ *      Poll : | MARKER | type | session | blocks LSB | blocks MSB | size (4) | crc32 (4) | round |
+ *      NACK : | MARKER | type | session | first LSB | first MSB | bitmap of the missing blocks (16) |
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "task.h"
+
+#include "wireless.h"
+#include "wireless_bulk_prv.h"
+#include "sys_config.h"
+#include "lpc_sys.h"
+
+
+
+#define MCAST_HDR_SIZE      5                                       ///< Bytes of the header of each packet
+#define MCAST_DATA_SIZE     (MESH_DATA_PAYLOAD_SIZE - MCAST_HDR_SIZE)///< Data bytes of each block
+#define MCAST_POLL_SIZE     (MCAST_HDR_SIZE + 4 + 4 + 1)            ///< Bytes of the poll packet
+#define MCAST_NACK_BLOCKS   128                                     ///< Blocks of the bitmap of a NACK
+#define MCAST_NACK_SIZE     (MCAST_HDR_SIZE + MCAST_NACK_BLOCKS / 8)///< Bytes of the NACK packet
+#define MCAST_NACKS_PER_POLL 4                                      ///< NACKs a receiver sends for each poll
+#define MCAST_MAX_BLOCKS    ((WIRELESS_MCAST_MAX_BYTES + MCAST_DATA_SIZE - 1) / MCAST_DATA_SIZE)
+#define MCAST_ANNOUNCES     3                                       ///< Polls that announce the file before its data
+#define MCAST_QUIET_POLLS   3                                       ///< Unanswered polls in a row that end the transfer
+#define MCAST_ROUNDS_MAX    200                                     ///< The sender gives up after this many rounds
+#define MCAST_BURST_PKTS    MESH_MAX_NODES                          ///< Blocks sent back to back, which the repeaters can hold
+#define MCAST_RX_QUEUE_SIZE 8                                       ///< Received blocks for wireless_mcast_recv()
+
+/// WIRELESS_MCAST_MAX_BYTES is too large, or the mesh payload is too small for the NACK
+typedef char mcast_sizes_check[(MCAST_NACK_SIZE <= MESH_DATA_PAYLOAD_SIZE && MCAST_MAX_BLOCKS <= 0xFFFF) ? 1 : -1];
+
+/// Types of the multicast packets
+typedef enum {
+    mcast_data = 1,     ///< Block of the file
+    mcast_poll = 2,     ///< Announces the file, and asks for the missing blocks (except round 0)
+    mcast_nack = 3,     ///< Bitmap of the missing blocks from a receiver
+} mcast_type_t;
+
+/// Modes of this node
+typedef enum {
+    mcast_idle,
+    mcast_sending,
+    mcast_listening,
+} mcast_mode_t;
+
+/// A received block for wireless_mcast_recv()
+typedef struct {
+    uint32_t offset;
+    uint8_t len;
+    uint8_t data[MCAST_DATA_SIZE];
+} mcast_block_t;
+
+/**
+ * State of the sender or the receiver, since a node is only one of them at a time.
+ * The receiver is modified only by the wireless task.
+ */
+static struct {
+    volatile uint8_t mode;      ///< @see mcast_mode_t
+    uint8_t session;            ///< Session of the transfer, which changes with each wireless_mcast_send()
+    uint8_t src;                ///< Sender of the session we receive
+    uint8_t hops;               ///< Max hops of the packets
+    bool known;                 ///< Receiver got the poll of the session
+    uint16_t num_blocks;        ///< Blocks of the file
+    uint16_t have;              ///< Blocks the receiver has
+    uint32_t size;              ///< Bytes of the file
+    uint32_t crc;               ///< CRC32 of the file
+    volatile bool nacked;       ///< Sender got a NACK since its last poll
+    bool nack_pending;          ///< Receiver should answer the poll at nack_due_ms
+    uint32_t nack_due_ms;       ///< Our uptime to send the NACKs
+    uint8_t blocks[(MCAST_MAX_BLOCKS + 7) / 8]; ///< Receiver: the blocks we have, sender: the blocks to send again
+} g_mc;
+
+static QueueHandle_t g_mc_rx_queue = NULL;      ///< Received blocks for wireless_mcast_recv()
+
+
+
+static inline bool mcast_get_bit(const uint16_t block)
+{
+    return !!(g_mc.blocks[block / 8] & (1 << (block % 8)));
+}
+static inline void mcast_set_bit(const uint16_t block)
+{
+    g_mc.blocks[block / 8] |= (1 << (block % 8));
+}
+static inline void mcast_clear_bit(const uint16_t block)
+{
+    g_mc.blocks[block / 8] &= ~(1 << (block % 8));
+}
+
+static bool mcast_send_pkt(uint8_t dst, uint8_t type, uint16_t block, const void *data, uint8_t len)
+{
+    uint8_t buffer[MESH_DATA_PAYLOAD_SIZE];
+
+    buffer[0] = WIRELESS_MCAST_MARKER;
+    buffer[1] = type;
+    buffer[2] = g_mc.session;
+    buffer[3] = (block >> 0) & 0xFF;
+    buffer[4] = (block >> 8) & 0xFF;
+    if (len > 0) {
+        memcpy(&buffer[MCAST_HDR_SIZE], data, len);
+    }
+
+    return mesh_send(dst, mesh_pkt_nack, buffer, MCAST_HDR_SIZE + len, g_mc.hops);
+}
+
+/// Broadcasts the poll of the given round, the round 0 only announces the file
+static void mcast_send_poll(uint8_t round)
+{
+    uint8_t poll[MCAST_POLL_SIZE - MCAST_HDR_SIZE];
+
+    memcpy(&poll[0], &g_mc.size, sizeof(g_mc.size));
+    memcpy(&poll[4], &g_mc.crc, sizeof(g_mc.crc));
+    poll[8] = round;
+    mcast_send_pkt(MESH_BROADCAST_ADDR, mcast_poll, g_mc.num_blocks, poll, sizeof(poll));
+}
+
+/**
+ * Broadcasts the blocks marked in the bitmap, and clears their bits.  A NACK can mark a block
+ * again while we send, which is then sent in the next round.
+ * @returns false if the data could not be read
+ */
+static bool mcast_send_marked(wireless_mcast_read_t read, void *arg)
+{
+    uint8_t data[MCAST_DATA_SIZE];
+    uint16_t sent = 0;
+    uint16_t block = 0;
+    bool ok = true;
+
+    wireless_tx_burst_begin();
+    for (block = 0; ok && block < g_mc.num_blocks; block++)
+    {
+        taskENTER_CRITICAL();
+        const bool marked = mcast_get_bit(block);
+        mcast_clear_bit(block);
+        taskEXIT_CRITICAL();
+        if (!marked) {
+            continue;
+        }
+
+        const uint32_t offset = (uint32_t) block * MCAST_DATA_SIZE;
+        const uint8_t len = (g_mc.size - offset < MCAST_DATA_SIZE) ? (g_mc.size - offset) : MCAST_DATA_SIZE;
+        if (!(ok = read(data, offset, len, arg))) {
+            break;
+        }
+        mcast_send_pkt(MESH_BROADCAST_ADDR, mcast_data, block, data, len);
+
+        /* The repeaters hold off their repeats (see MESH_FLOOD_JITTER_MS), so they should
+         * be done with a burst before we send the next one.
+         */
+        if (0 == (++sent % MCAST_BURST_PKTS)) {
+            wireless_tx_burst_end();
+            vTaskDelay(g_mc.hops ? OS_MS(MESH_PKT_DISC_TIMEOUT_MS + MESH_FLOOD_JITTER_MS + 1) : 1);
+            wireless_tx_burst_begin();
+        }
+    }
+    wireless_tx_burst_end();
+
+    return ok;
+}
+
+/// Starts receiving the session of the poll, which discards any previous session
+static void mcast_rx_start_session(const mesh_packet_t *pkt, const uint16_t num_blocks)
+{
+    uint32_t size = 0;
+    memcpy(&size, &pkt->data[MCAST_HDR_SIZE], sizeof(size));
+
+    xQueueReset(g_mc_rx_queue);
+    memset(g_mc.blocks, 0, sizeof(g_mc.blocks));
+    g_mc.session = pkt->data[2];
+    g_mc.src = pkt->nwk.src;
+    g_mc.hops = pkt->info.hop_count_max;
+    g_mc.num_blocks = num_blocks;
+    g_mc.have = 0;
+    g_mc.size = size;
+    memcpy(&g_mc.crc, &pkt->data[MCAST_HDR_SIZE + 4], sizeof(g_mc.crc));
+    g_mc.nack_pending = false;
+
+    /* The number of the blocks should match the size */
+    g_mc.known = (num_blocks <= MCAST_MAX_BLOCKS && size > 0 &&
+                  num_blocks == (size + MCAST_DATA_SIZE - 1) / MCAST_DATA_SIZE);
+}
+
+static void mcast_rx_handle_data(const mesh_packet_t *pkt, const uint16_t block)
+{
+    mcast_block_t item;
+
+    if (!g_mc.known || block >= g_mc.num_blocks || mcast_get_bit(block)) {
+        return;
+    }
+
+    item.offset = (uint32_t) block * MCAST_DATA_SIZE;
+    item.len = (g_mc.size - item.offset < MCAST_DATA_SIZE) ? (g_mc.size - item.offset) : MCAST_DATA_SIZE;
+    if (pkt->info.data_len < MCAST_HDR_SIZE + item.len) {
+        return;
+    }
+    memcpy(item.data, &pkt->data[MCAST_HDR_SIZE], item.len);
+
+    /* If the reader is behind, the block is not marked, so it is sent again after a NACK */
+    if (xQueueSend(g_mc_rx_queue, &item, 0)) {
+        mcast_set_bit(block);
+        g_mc.have++;
+    }
+}
+
+/// Merges the missing blocks of a receiver into the blocks we send again
+static void mcast_tx_handle_nack(const mesh_packet_t *pkt, const uint16_t first)
+{
+    uint16_t i = 0;
+
+    if (MCAST_NACK_SIZE != pkt->info.data_len) {
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    for (i = 0; i < MCAST_NACK_BLOCKS && (uint32_t) first + i < g_mc.num_blocks; i++) {
+        if (pkt->data[MCAST_HDR_SIZE + i / 8] & (1 << (i % 8))) {
+            mcast_set_bit(first + i);
+        }
+    }
+    taskEXIT_CRITICAL();
+    g_mc.nacked = true;
+}
+
+
+
+bool wireless_mcast_init(void)
+{
+    if (NULL == g_mc_rx_queue) {
+        g_mc_rx_queue = xQueueCreate(MCAST_RX_QUEUE_SIZE, sizeof(mcast_block_t));
+    }
+    return (NULL != g_mc_rx_queue);
+}
+
+bool wireless_mcast_handle_pkt(const mesh_packet_t *pkt)
+{
+    if (pkt->info.data_len < MCAST_HDR_SIZE || WIRELESS_MCAST_MARKER != pkt->data[0]) {
+        return false;
+    }
+    /* Multicast needs the wireless task, so drop the packets until FreeRTOS is running */
+    if (taskSCHEDULER_RUNNING != xTaskGetSchedulerState()) {
+        return true;
+    }
+
+    const uint8_t type = pkt->data[1];
+    const uint8_t session = pkt->data[2];
+    const uint16_t block = pkt->data[3] | (pkt->data[4] << 8);
+    const bool same_session = (g_mc.known && session == g_mc.session && pkt->nwk.src == g_mc.src);
+
+    switch (type)
+    {
+        case mcast_poll:
+            if (mcast_listening != g_mc.mode || MCAST_POLL_SIZE != pkt->info.data_len) {
+                break;
+            }
+            if (!same_session) {
+                mcast_rx_start_session(pkt, block);
+            }
+            /* Answer after a random delay, so the receivers do not answer at the same time */
+            if (g_mc.known && 0 != pkt->data[MCAST_POLL_SIZE - 1] && g_mc.have < g_mc.num_blocks) {
+                g_mc.nack_pending = true;
+                g_mc.nack_due_ms = sys_get_uptime_ms() + (rand() % (WIRELESS_MCAST_POLL_MS / 2));
+            }
+            break;
+
+        case mcast_data:
+            if (mcast_listening == g_mc.mode && same_session) {
+                mcast_rx_handle_data(pkt, block);
+            }
+            break;
+
+        case mcast_nack:
+            if (mcast_sending == g_mc.mode && session == g_mc.session) {
+                mcast_tx_handle_nack(pkt, block);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return true;
+}
+
+void wireless_mcast_service(void)
+{
+    uint8_t bitmap[MCAST_NACK_BLOCKS / 8];
+    uint32_t first = 0;
+    uint8_t nacks = 0;
+
+    if (!g_mc.nack_pending || mcast_listening != g_mc.mode ||
+        (int32_t) (sys_get_uptime_ms() - g_mc.nack_due_ms) < 0) {
+        return;
+    }
+    g_mc.nack_pending = false;
+
+    /* Each NACK starts at a missing block, and covers the next MCAST_NACK_BLOCKS blocks */
+    for (nacks = 0; nacks < MCAST_NACKS_PER_POLL; nacks++)
+    {
+        uint16_t i = 0;
+        while (first < g_mc.num_blocks && mcast_get_bit(first)) {
+            first++;
+        }
+        if (first >= g_mc.num_blocks) {
+            break;
+        }
+
+        memset(bitmap, 0, sizeof(bitmap));
+        for (i = 0; i < MCAST_NACK_BLOCKS && first + i < g_mc.num_blocks; i++) {
+            if (!mcast_get_bit(first + i)) {
+                bitmap[i / 8] |= (1 << (i % 8));
+            }
+        }
+        mcast_send_pkt(g_mc.src, mcast_nack, first, bitmap, sizeof(bitmap));
+        first += MCAST_NACK_BLOCKS;
+    }
+}
+
+uint32_t wireless_mcast_get_due_ms(void)
+{
+    if (!g_mc.nack_pending) {
+        return UINT32_MAX;
+    }
+    const int32_t remaining = (int32_t) (g_mc.nack_due_ms - sys_get_uptime_ms());
+    return (remaining > 0) ? (uint32_t) remaining : 0;
+}
+
+bool wireless_mcast_send(uint32_t size, uint32_t crc32, uint8_t max_hops, wireless_mcast_read_t read, void *arg)
+{
+    uint8_t round = 0;
+    uint8_t quiet = 0;
+    bool ok = false;
+
+    if (0 == size || size > WIRELESS_MCAST_MAX_BYTES || NULL == read || mcast_idle != g_mc.mode) {
+        return false;
+    }
+
+    /* A new session makes the receivers discard the blocks of any previous transfer */
+    g_mc.session = (g_mc.session + 1 + (rand() % 0x7F)) & 0xFF;
+    g_mc.src = mesh_get_node_address();
+    g_mc.hops = max_hops;
+    g_mc.size = size;
+    g_mc.crc = crc32;
+    g_mc.num_blocks = (size + MCAST_DATA_SIZE - 1) / MCAST_DATA_SIZE;
+    g_mc.known = true;
+    g_mc.nacked = false;
+    g_mc.mode = mcast_sending;
+
+    for (round = 0; round < MCAST_ANNOUNCES; round++) {
+        mcast_send_poll(0);
+        vTaskDelay(OS_MS(10));
+    }
+
+    /* The first round sends all of the blocks, and the next rounds send the missing ones */
+    memset(g_mc.blocks, 0xFF, sizeof(g_mc.blocks));
+    for (round = 1; round < MCAST_ROUNDS_MAX; round++)
+    {
+        if (!mcast_send_marked(read, arg)) {
+            break;
+        }
+
+        g_mc.nacked = false;
+        mcast_send_poll(round);
+        vTaskDelay(OS_MS(WIRELESS_MCAST_POLL_MS));
+
+        quiet = g_mc.nacked ? 0 : (quiet + 1);
+        if (quiet >= MCAST_QUIET_POLLS) {
+            ok = true;
+            break;
+        }
+    }
+
+    g_mc.mode = mcast_idle;
+    return ok;
+}
+
+void wireless_mcast_listen(bool listen)
+{
+    taskENTER_CRITICAL();
+    if (mcast_sending != g_mc.mode) {
+        g_mc.known = false;
+        g_mc.nack_pending = false;
+        g_mc.mode = listen ? mcast_listening : mcast_idle;
+    }
+    taskEXIT_CRITICAL();
+}
+
+bool wireless_mcast_get_file(uint32_t *size, uint32_t *crc32)
+{
+    taskENTER_CRITICAL();
+    const bool known = g_mc.known && mcast_listening == g_mc.mode;
+    if (known) {
+        *size = g_mc.size;
+        *crc32 = g_mc.crc;
+    }
+    taskEXIT_CRITICAL();
+    return known;
+}
+
+uint32_t wireless_mcast_recv(void *data, uint32_t *offset, uint32_t timeout_ms)
+{
+    mcast_block_t item;
+
+    if (NULL == g_mc_rx_queue || !xQueueReceive(g_mc_rx_queue, &item, OS_MS(timeout_ms))) {
+        return 0;
+    }
+    memcpy(data, item.data, item.len);
+    *offset = item.offset;
+    return item.len;
+}
+
+bool wireless_mcast_is_complete(void)
+{
+    return (g_mc.known && mcast_listening == g_mc.mode && g_mc.have == g_mc.num_blocks &&
+            0 == uxQueueMessagesWaiting(g_mc_rx_queue));
+}
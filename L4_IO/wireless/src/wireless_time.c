@@ -0,0 +1,237 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief Network time of the mesh network from the beacons of the time master.
+ *
+ * The master broadcasts a beacon every WIRELESS_TIME_BEACON_MS that is not repeated by
+ * the mesh.  The radio driver writes the time into the beacon right before it is sent,
+ * so the time is that of the end of the packet when the neighbors get their RX interrupt.
+ * A node estimates its offset and the skew of its clock from the beacons of its parent,
+ * and sends its own beacons with a stratum one more than its parent, up to
+ * WIRELESS_TIME_MAX_STRATUM, such that nodes out of the master's range are synced too.
+ *
+ * Packet format (data payload of the mesh packet) :
+ *      | MARKER | stratum | time in us (8 bytes, LSB first) |
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "wireless.h"
+#include "wireless_bulk_prv.h"
+#include "sys_config.h"
+#include "lpc_sys.h"
+
+
+
+#define TIME_BEACON_SIZE    10                  ///< Bytes of the beacon
+#define TIME_UNSYNCED       0xFF                ///< Stratum of a node without time
+#define TIME_LOST_BEACONS   3                   ///< Beacons of the parent we can miss before we lose the time
+#define TIME_MIN_SKEW_US    (100 * 1000)        ///< Minimum time between two beacons to measure the skew
+#define TIME_MAX_SKEW_PPB   (500 * 1000)        ///< Larger skew than 500ppm is a bad measurement
+#define TIME_SPIN_US        2000                ///< wireless_time_wait_until() spins this close to the time
+
+/// Time state, modified only by the wireless task
+static struct {
+    uint8_t stratum;            ///< 0 for the master, TIME_UNSYNCED if we don't have the time
+    uint8_t parent;             ///< Node address whose beacons we use
+    bool skew_valid;            ///< true once the skew is measured from the beacons of the parent
+    int32_t skew_ppb;           ///< Our clock is slow by this many parts per billion
+    int32_t error_us;           ///< Difference of our estimate with the last beacon
+    uint64_t local_ref;         ///< Our uptime at the last beacon
+    uint64_t global_ref;        ///< Network time at the last beacon
+    uint64_t last_beacon_ms;    ///< Our uptime when we got or sent the last beacon
+    uint64_t next_tx_ms;        ///< Our uptime to send our next beacon
+} g_time = { TIME_UNSYNCED };
+
+
+
+/// @returns the network time of our uptime (should be called in a critical section)
+static uint64_t time_local_to_global(const uint64_t local_us)
+{
+    const int64_t dl = (int64_t) (local_us - g_time.local_ref);
+    return g_time.global_ref + dl + (dl * g_time.skew_ppb) / 1000000000LL;
+}
+
+void wireless_time_start_master(void)
+{
+    taskENTER_CRITICAL();
+    g_time.stratum = 0;
+    g_time.parent = mesh_get_node_address();
+    g_time.skew_ppb = 0;
+    g_time.error_us = 0;
+    g_time.local_ref = g_time.global_ref = 0;
+    g_time.next_tx_ms = 0;
+    taskEXIT_CRITICAL();
+}
+
+bool wireless_time_is_synced(void)
+{
+    return TIME_UNSYNCED != g_time.stratum;
+}
+
+uint64_t wireless_time_get_us(void)
+{
+    uint64_t now = 0;
+
+    taskENTER_CRITICAL();
+    now = time_local_to_global(sys_get_uptime_us());
+    taskEXIT_CRITICAL();
+
+    return now;
+}
+
+int32_t wireless_time_get_error_us(void)
+{
+    return g_time.error_us;
+}
+
+uint8_t wireless_time_get_stratum(void)
+{
+    return g_time.stratum;
+}
+
+uint64_t wireless_time_get_slot_start_us(const uint32_t frame_us, const uint32_t slot_us, const uint32_t slot)
+{
+    const uint64_t now = wireless_time_get_us();
+    uint64_t start = now - (now % frame_us) + ((uint64_t) slot * slot_us);
+
+    if (start <= now) {
+        start += frame_us;
+    }
+
+    return start;
+}
+
+bool wireless_time_wait_until(const uint64_t global_us)
+{
+    uint64_t now = 0;
+
+    if (!wireless_time_is_synced() || (now = wireless_time_get_us()) >= global_us) {
+        return false;
+    }
+
+    /* Sleep until we are close to the time, then spin for the precise time */
+    while ((global_us - now) > TIME_SPIN_US && taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        vTaskDelay(OS_MS((global_us - now - TIME_SPIN_US / 2) / 1000));
+        now = wireless_time_get_us();
+    }
+    while (wireless_time_get_us() < global_us) {
+        ;
+    }
+
+    return true;
+}
+
+
+
+bool wireless_time_handle_pkt(const mesh_packet_t *pkt, const uint64_t rx_time_us)
+{
+    if (TIME_BEACON_SIZE != pkt->info.data_len || WIRELESS_TIME_MARKER != pkt->data[0]) {
+        return false;
+    }
+
+    const uint8_t stratum = pkt->data[1];
+    const uint8_t src = pkt->nwk.src;
+    uint64_t global_us = 0;
+    int i = 0;
+
+    /* Use only the direct beacons of our parent, or of a better parent */
+    if (0 == g_time.stratum || 0 != pkt->info.hop_count ||
+        (src != g_time.parent && stratum + 1 >= g_time.stratum))
+    {
+        return true;
+    }
+
+    for (i = 7; i >= 0; i--) {
+        global_us = (global_us << 8) | pkt->data[2 + i];
+    }
+
+    taskENTER_CRITICAL();
+    if (src != g_time.parent || TIME_UNSYNCED == g_time.stratum) {
+        g_time.parent = src;
+        g_time.skew_valid = false;
+        g_time.skew_ppb = 0;
+    }
+    else {
+        /* Measure the skew between this and the last beacon, and filter it */
+        const int64_t dl = (int64_t) (rx_time_us - g_time.local_ref);
+        const int64_t dg = (int64_t) (global_us - g_time.global_ref);
+        g_time.error_us = (int32_t) (int64_t) (time_local_to_global(rx_time_us) - global_us);
+
+        if (dl > TIME_MIN_SKEW_US) {
+            const int64_t ppb = ((dg - dl) * 1000000000LL) / dl;
+            if (ppb > -TIME_MAX_SKEW_PPB && ppb < TIME_MAX_SKEW_PPB) {
+                g_time.skew_ppb = !g_time.skew_valid ? (int32_t) ppb :
+                                  (int32_t) (g_time.skew_ppb + (ppb - g_time.skew_ppb) / 4);
+                g_time.skew_valid = true;
+            }
+        }
+    }
+    g_time.stratum = stratum + 1;
+    g_time.local_ref = rx_time_us;
+    g_time.global_ref = global_us;
+    g_time.last_beacon_ms = sys_get_uptime_ms();
+    taskEXIT_CRITICAL();
+
+    return true;
+}
+
+void wireless_time_stamp_pkt(void *p, const uint32_t latency_us)
+{
+    mesh_packet_t *pkt = (mesh_packet_t*) p;
+    int i = 0;
+
+    if (TIME_BEACON_SIZE == pkt->info.data_len && WIRELESS_TIME_MARKER == pkt->data[0] &&
+        mesh_get_node_address() == pkt->nwk.src)
+    {
+        uint64_t global_us = wireless_time_get_us() + latency_us;
+        for (i = 0; i < 8; i++) {
+            pkt->data[2 + i] = (uint8_t) global_us;
+            global_us >>= 8;
+        }
+    }
+}
+
+void wireless_time_service(void)
+{
+    const uint64_t now_ms = sys_get_uptime_ms();
+
+    /* Lose the time if our parent is gone */
+    if (0 != g_time.stratum && TIME_UNSYNCED != g_time.stratum &&
+        (now_ms - g_time.last_beacon_ms) > (TIME_LOST_BEACONS * WIRELESS_TIME_BEACON_MS))
+    {
+        g_time.stratum = TIME_UNSYNCED;
+    }
+
+    if (g_time.stratum < WIRELESS_TIME_MAX_STRATUM && now_ms >= g_time.next_tx_ms) {
+        /* The time is written by the radio driver, see wireless_time_stamp_pkt() */
+        uint8_t beacon[TIME_BEACON_SIZE] = { WIRELESS_TIME_MARKER, g_time.stratum };
+        mesh_send(MESH_BROADCAST_ADDR, mesh_pkt_nack, beacon, sizeof(beacon), 0);
+
+        /* Others send after the master with some jitter to avoid colliding with each other */
+        g_time.next_tx_ms = now_ms + WIRELESS_TIME_BEACON_MS;
+        if (0 != g_time.stratum) {
+            g_time.next_tx_ms += rand() % (WIRELESS_TIME_BEACON_MS / 4);
+        }
+    }
+}
@@ -0,0 +1,278 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief Queries of the telemetry variables of another node over the mesh network.
+ *
+ * The request has the IDs of up to WIRELESS_TLM_MAX_VARS variables, and the reply packs
+ * their raw bytes back to back, like the data record of the binary telemetry stream, in as
+ * few frames as they fit in.  The ID of a variable is its component index and its variable
+ * index, which are the indexes of the schema records of the binary telemetry stream.
+ *
+ * The reply is a bitmap of the variables that were not found (or did not fit), followed by
+ * the data of the other variables, which is split into frames of TLM_FRAME_DATA bytes.
+ * The frames are not acknowledged; the requester asks again if any frame is missing.
+ *
+ * Packet format (data payload of the mesh packet) :
+ *      Request : | MARKER | type | seq | count | comp idx | var idx | ... |
+ *      Reply   : | MARKER | type | seq | frame + last flag | data ... |
+ */
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
+#include "wireless.h"
+#include "wireless_bulk_prv.h"
+#include "sys_config.h"
+#include "tlm/c_tlm_comp.h"
+#include "tlm/c_tlm_var.h"
+
+
+
+#define TLM_HDR_SIZE        4                                       ///< Bytes of the header of each packet
+#define TLM_FRAME_DATA      (MESH_DATA_PAYLOAD_SIZE - TLM_HDR_SIZE) ///< Reply bytes of each frame
+#define TLM_MISSING_SIZE    2                                       ///< Bytes of the bitmap of the variables not found
+#define TLM_MAX_FRAMES      ((TLM_MISSING_SIZE + WIRELESS_TLM_MAX_BYTES + TLM_FRAME_DATA - 1) / TLM_FRAME_DATA)
+#define TLM_FLAG_LAST       0x80                                    ///< Set on the last frame of the reply
+#define TLM_TRIES_MAX       4                                       ///< Requests sent by wireless_tlm_query()
+
+/// The request has to fit one packet, and the frames have to fit the bitmap of the requester
+typedef char tlm_sizes_check[(TLM_HDR_SIZE + 2 * WIRELESS_TLM_MAX_VARS <= MESH_DATA_PAYLOAD_SIZE &&
+                              WIRELESS_TLM_MAX_VARS <= 8 * TLM_MISSING_SIZE && TLM_MAX_FRAMES <= 8) ? 1 : -1];
+
+/// Types of the telemetry packets
+typedef enum {
+    tlm_request = 1,    ///< IDs of the variables to read
+    tlm_reply = 2,      ///< Frame of the values of the variables
+} tlm_pkt_type_t;
+
+/// Request to reply by wireless_tlm_service(), modified only by the wireless task
+static struct {
+    volatile bool pending;      ///< A reply should be sent
+    uint8_t src;                ///< The node that asked
+    uint8_t hops;               ///< Max hops of its request
+    uint8_t seq;                ///< Sequence number of its request
+    uint8_t count;              ///< Number of variables
+    wireless_tlm_id_t ids[WIRELESS_TLM_MAX_VARS];
+} g_srv;
+
+/// Reply of the query of wireless_tlm_query()
+static struct {
+    uint8_t dst;                ///< The node we asked
+    uint8_t seq;                ///< Sequence number of our request
+    uint8_t frames;             ///< Bit N is set when frame N is received
+    uint8_t last;               ///< The last frame, or TLM_MAX_FRAMES until it is received
+    uint8_t len;                ///< Bytes of the reply, which is known with the last frame
+    uint8_t data[TLM_MAX_FRAMES * TLM_FRAME_DATA];
+} g_query;
+static SemaphoreHandle_t g_query_sem = NULL;    ///< Given when the whole reply is received
+
+
+
+static bool tlm_send_pkt(uint8_t dst, uint8_t hops, uint8_t type, uint8_t seq, uint8_t arg,
+                         const void *data, uint8_t len)
+{
+    uint8_t buffer[MESH_DATA_PAYLOAD_SIZE];
+
+    buffer[0] = WIRELESS_TLM_MARKER;
+    buffer[1] = type;
+    buffer[2] = seq;
+    buffer[3] = arg;
+    if (len > 0) {
+        memcpy(&buffer[TLM_HDR_SIZE], data, len);
+    }
+
+    return mesh_send(dst, mesh_pkt_nack, buffer, TLM_HDR_SIZE + len, hops);
+}
+
+/**
+ * Packs the missing bitmap and the values of the requested variables
+ * @returns the bytes of the reply
+ */
+static uint32_t tlm_pack_reply(uint8_t *reply)
+{
+    uint16_t missing = 0;
+    uint32_t len = TLM_MISSING_SIZE;
+    uint8_t i = 0;
+
+    for (i = 0; i < g_srv.count; i++)
+    {
+        const tlm_reg_var_type *var = NULL;
+        uint32_t size = 0;
+
+#if SYS_CFG_ENABLE_TLM
+        var = tlm_variable_get_by_index(tlm_component_get_by_index(g_srv.ids[i].comp), g_srv.ids[i].var);
+#endif
+        if (NULL != var) {
+            size = var->elm_size_bytes * var->elm_arr_size;
+        }
+
+        if (NULL == var || len + size > TLM_MISSING_SIZE + WIRELESS_TLM_MAX_BYTES) {
+            missing |= (1 << i);
+        }
+        else {
+            memcpy(&reply[len], var->data_ptr, size);
+            len += size;
+        }
+    }
+
+    reply[0] = (missing >> 0) & 0xFF;
+    reply[1] = (missing >> 8) & 0xFF;
+    return len;
+}
+
+static void tlm_handle_reply(const mesh_packet_t *pkt)
+{
+    const uint8_t frame = pkt->data[3] & ~TLM_FLAG_LAST;
+    const uint8_t len = pkt->info.data_len - TLM_HDR_SIZE;
+
+    /* Ignore the late replies of our previous requests */
+    if (pkt->nwk.src != g_query.dst || pkt->data[2] != g_query.seq ||
+        frame >= TLM_MAX_FRAMES || len > TLM_FRAME_DATA || (g_query.frames & (1 << frame))) {
+        return;
+    }
+
+    /* Every frame but the last one is full */
+    if (pkt->data[3] & TLM_FLAG_LAST) {
+        g_query.last = frame;
+        g_query.len = frame * TLM_FRAME_DATA + len;
+    }
+    else if (TLM_FRAME_DATA != len) {
+        return;
+    }
+
+    memcpy(&g_query.data[frame * TLM_FRAME_DATA], &pkt->data[TLM_HDR_SIZE], len);
+    g_query.frames |= (1 << frame);
+
+    if (g_query.last < TLM_MAX_FRAMES && (uint8_t) ((2 << g_query.last) - 1) == g_query.frames) {
+        xSemaphoreGive(g_query_sem);
+    }
+}
+
+
+
+bool wireless_tlm_init(void)
+{
+    if (NULL == g_query_sem) {
+        g_query_sem = xSemaphoreCreateBinary();
+    }
+    return (NULL != g_query_sem);
+}
+
+bool wireless_tlm_handle_pkt(const mesh_packet_t *pkt)
+{
+    if (pkt->info.data_len < TLM_HDR_SIZE || WIRELESS_TLM_MARKER != pkt->data[0]) {
+        return false;
+    }
+    /* The replies are sent by the wireless task, so drop the packets until FreeRTOS is running */
+    if (taskSCHEDULER_RUNNING != xTaskGetSchedulerState()) {
+        return true;
+    }
+
+    const uint8_t count = pkt->data[3];
+
+    switch (pkt->data[1])
+    {
+        case tlm_request:
+            /* A new request replaces the one we did not reply yet */
+            if (count > 0 && count <= WIRELESS_TLM_MAX_VARS && TLM_HDR_SIZE + 2 * count == pkt->info.data_len) {
+                g_srv.src = pkt->nwk.src;
+                g_srv.hops = pkt->info.hop_count_max;
+                g_srv.seq = pkt->data[2];
+                g_srv.count = count;
+                memcpy(&g_srv.ids[0], &pkt->data[TLM_HDR_SIZE], 2 * count);
+                g_srv.pending = true;
+            }
+            break;
+
+        case tlm_reply:
+            tlm_handle_reply(pkt);
+            break;
+
+        default:
+            break;
+    }
+
+    return true;
+}
+
+void wireless_tlm_service(void)
+{
+    uint8_t reply[TLM_MAX_FRAMES * TLM_FRAME_DATA];
+    uint32_t len = 0, offset = 0;
+    uint8_t frame = 0;
+
+    if (!g_srv.pending) {
+        return;
+    }
+    g_srv.pending = false;
+
+    /* Pack the reply at once, so all the values are from the same time */
+    len = tlm_pack_reply(reply);
+
+    wireless_tx_burst_begin();
+    for (frame = 0; offset < len; frame++) {
+        const uint8_t chunk = (len - offset < TLM_FRAME_DATA) ? (len - offset) : TLM_FRAME_DATA;
+        const uint8_t last = (offset + chunk >= len) ? TLM_FLAG_LAST : 0;
+
+        tlm_send_pkt(g_srv.src, g_srv.hops, tlm_reply, g_srv.seq, frame | last, &reply[offset], chunk);
+        offset += chunk;
+    }
+    wireless_tx_burst_end();
+}
+
+bool wireless_tlm_query(uint8_t dst_addr, uint8_t max_hops, const wireless_tlm_id_t *ids, uint8_t count,
+                        void *values, uint32_t *len, uint16_t *missing, uint32_t timeout_ms)
+{
+    static uint8_t seq = 0;
+    const TickType_t timeout = OS_MS(timeout_ms / TLM_TRIES_MAX) ? OS_MS(timeout_ms / TLM_TRIES_MAX) : 1;
+    bool received = false;
+    uint32_t tries = 0;
+
+    if (0 == count || count > WIRELESS_TLM_MAX_VARS) {
+        return false;
+    }
+
+    for (tries = 0; tries < TLM_TRIES_MAX && !received; tries++)
+    {
+        /* Each request has a new sequence number, so the frames of a reply are read at the same time */
+        taskENTER_CRITICAL();
+        g_query.dst = dst_addr;
+        g_query.seq = ++seq;
+        g_query.frames = 0;
+        g_query.last = TLM_MAX_FRAMES;
+        taskEXIT_CRITICAL();
+
+        xSemaphoreTake(g_query_sem, 0);
+        tlm_send_pkt(dst_addr, max_hops, tlm_request, g_query.seq, count, ids, 2 * count);
+        received = xSemaphoreTake(g_query_sem, timeout);
+    }
+
+    if (received) {
+        *missing = g_query.data[0] | (g_query.data[1] << 8);
+        *len = g_query.len - TLM_MISSING_SIZE;
+        memcpy(values, &g_query.data[TLM_MISSING_SIZE], *len);
+    }
+
+    /* Stop accepting the frames into g_query */
+    g_query.dst = MESH_ZERO_ADDR;
+    return received;
+}
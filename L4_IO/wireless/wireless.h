@@ -28,6 +28,8 @@
 extern "C" {
 #endif
 #include <stdbool.h>
+#include "FreeRTOS.h"
+#include "semphr.h"
 #include "src/mesh.h"
 #include "src/mesh_typedefs.h"
 
@@ -49,6 +51,15 @@ bool wireless_init(void);
  */
 void wireless_service(void);
 
+/**
+ * Moves the frames received by the radio into the queue of wireless_service().
+ * This should be called by a task of higher priority than the one calling wireless_service(),
+ * such that the radio FIFO is read right away while the mesh logic of wireless_service()
+ * runs at a lower priority within its WIRELESS_SERVICE_BUDGET_MS.  If no task calls this,
+ * wireless_service() reads the radio itself.
+ */
+void wireless_radio_service(void);
+
 /// Just a wrapper around mesh_is_ack_required() to put all wireless related API at this file.
 static inline bool wireless_is_ack_required(mesh_packet_t *pkt) {
     return mesh_is_ack_required(pkt);
@@ -59,6 +70,319 @@ static inline bool wireless_send(uint8_t dst_addr, mesh_protocol_t protocol, con
     return mesh_send(dst_addr, protocol, data, len, max_hops);
 }
 
+/// Just a wrapper around mesh_send_prio() to put all wireless related API at this file.
+static inline bool wireless_send_prio(uint8_t dst_addr, mesh_protocol_t protocol, const void *data, uint8_t len, uint8_t max_hops, mesh_prio_t prio) {
+    return mesh_send_prio(dst_addr, protocol, data, len, max_hops, prio);
+}
+
+/**
+ * The first data byte of a packet that holds several messages of wireless_send_batched().
+ * Packets sent by wireless_send() should not begin with this byte.
+ */
+#define WIRELESS_BATCH_MARKER       0xFE
+
+/// Maximum length of each message of wireless_send_batched() (marker and length byte are the overhead)
+#define WIRELESS_BATCH_MAX_MSG_LEN  (MESH_DATA_PAYLOAD_SIZE - 2)
+
+/**
+ * Same as wireless_send(), except that small messages to the same destination are packed
+ * into one mesh packet, so they take one air-time slot and one ACK.  The packet is sent
+ * once the next message does not fit, or WIRELESS_BATCH_WINDOW_MS after its first message.
+ *
+ * The receiver's wireless_get_rx_pkt() unpacks the messages, and returns each of them
+ * as a separate packet with the header of the mesh packet that carried them.
+ *
+ * @returns true if the message was queued (or sent)
+ * @note Before FreeRTOS is running, this is the same as wireless_send()
+ */
+bool wireless_send_batched(uint8_t dst_addr, mesh_protocol_t protocol, const void *data, uint8_t len, uint8_t max_hops);
+
+/// Sends the queued messages of wireless_send_batched() now instead of waiting for the window to expire
+void wireless_flush_batched(void);
+
+/**
+ * @{ Burst transmit
+ * Between these calls, the packets that this task sends without hardware ACK are queued,
+ * and then sent back to back through the 3-level TX FIFO of the radio, which avoids the
+ * gap of switching the radio and the SPI transfer between each packet.  The packets are
+ * also sent when WIRELESS_TX_BURST_SIZE packets are queued.
+ *
+ * @code
+ *      wireless_tx_burst_begin();
+ *      for (i = 0; i < 4; i++) {
+ *          wireless_send(MESH_BROADCAST_ADDR, mesh_pkt_nack, &data[i], 1, 1);
+ *      }
+ *      wireless_tx_burst_end();
+ * @endcode
+ *
+ * @note Only one task can have a burst at a time, and these are a NOP before FreeRTOS runs.
+ */
+void wireless_tx_burst_begin(void);
+void wireless_tx_burst_end(void);
+/** @} */
+
+/**
+ * The first data byte of the packets of the bulk transfer (wireless_bulk_send()).
+ * These packets are handled by the wireless task, and are not returned by wireless_get_rx_pkt().
+ */
+#define WIRELESS_BULK_MARKER        0xFD
+
+/**
+ * The first data byte of the channel switch broadcast of WIRELESS_CHANNEL_HOPPING.
+ * These packets are handled by the wireless task, and are not returned by wireless_get_rx_pkt().
+ */
+#define WIRELESS_HOP_MARKER         0xFC
+
+/**
+ * The first data byte of the time beacons of wireless_time_start_master().
+ * These packets are handled by the wireless task, and are not returned by wireless_get_rx_pkt().
+ */
+#define WIRELESS_TIME_MARKER        0xFB
+
+/**
+ * The first data byte of the packets of the multicast transfer (wireless_mcast_send()).
+ * These packets are handled by the wireless task, and are not returned by wireless_get_rx_pkt().
+ */
+#define WIRELESS_MCAST_MARKER       0xFA
+
+/**
+ * The first byte of the data of the packets of the telemetry query, which are handled
+ * by the wireless task; @see wireless_tlm_query()
+ */
+#define WIRELESS_TLM_MARKER         0xF9
+
+/**
+ * The first byte of the data of the packets of the CAN gateway, which are handled
+ * by the wireless task; @see wireless_can.h
+ */
+#define WIRELESS_CAN_MARKER         0xF8
+
+/**
+ * @{ Network time
+ * One node calls wireless_time_start_master(), and sends a time beacon every
+ * WIRELESS_TIME_BEACON_MS.  The other nodes estimate the offset and the skew of their
+ * clock from the beacons, and relay the time to the nodes out of the master's range.
+ * A command for all nodes can then be broadcast once with the time it should be run :
+ *
+ * @code
+ *      // Master: all nodes should scan 50ms from now
+ *      uint64_t t = wireless_time_get_us() + 50 * 1000;
+ *      wireless_send(MESH_BROADCAST_ADDR, mesh_pkt_nack, &t, sizeof(t), 3);
+ *
+ *      // Others: upon receiving the packet
+ *      uint64_t t;
+ *      memcpy(&t, pkt.data, sizeof(t));
+ *      if (wireless_time_wait_until(t)) {
+ *          scan();
+ *      }
+ * @endcode
+ */
+/// Makes this node the time master whose uptime is the network time
+void wireless_time_start_master(void);
+
+/// @returns true if wireless_time_get_us() is the network time
+bool wireless_time_is_synced(void);
+
+/// @returns the network time in microseconds (our uptime before we are first synced)
+uint64_t wireless_time_get_us(void);
+
+/**
+ * Gets the start of the next TDMA slot.  The frames of all nodes start at the multiples
+ * of frame_us of the network time, and slot N starts at N * slot_us of the frame.
+ * @returns the network time of the next start of the slot, which is in the future
+ */
+uint64_t wireless_time_get_slot_start_us(const uint32_t frame_us, const uint32_t slot_us, const uint32_t slot);
+
+/**
+ * Waits until the network time.  The task sleeps, and then spins for the last few
+ * milliseconds for precise timing.
+ * @returns false if we are not synced, or if the time has already passed.
+ */
+bool wireless_time_wait_until(const uint64_t global_us);
+
+/// @returns the error of our estimated time when we received the last beacon
+int32_t wireless_time_get_error_us(void);
+
+/// @returns 0 for the master, 1 for its neighbors, etc, or 0xFF if we are not synced
+uint8_t wireless_time_get_stratum(void);
+/** @} */
+
+/// @returns the current channel in MHz, which changes with WIRELESS_CHANNEL_HOPPING
+uint16_t wireless_get_channel_mhz(void);
+
+/// @returns the filtered percentage of the transmissions of the current channel that found it busy or were lost
+uint8_t wireless_get_channel_bad_percent(void);
+
+/// @returns the air data rate of our packets to the neighbor, which changes with WIRELESS_LINK_RATE
+uint16_t wireless_get_link_rate_kbps(uint8_t neighbor);
+
+/**
+ * @{ Low-power listening of WIRELESS_LPL
+ * A node of a class with an interval of WIRELESS_LPL_INTERVALS_MS powers down its radio, and
+ * wakes it up every interval to listen for a moment.  A packet to the node waits for its next
+ * wake-up, so the interval of each class is the latency budget of each hop to its nodes, and
+ * the routers should be class 0 (always on).  Once the nodes have the network time, the
+ * wake-ups are at the multiples of the interval of the network time, and the sender only
+ * wakes up the node around that time instead of for a whole interval.
+ *
+ * The nodes learn the class of a sleeping neighbor from its wake-up frames, which it also sends
+ * before its own packets once in a while.  The class of a neighbor can also be set beforehand.
+ */
+/// Sets our class of WIRELESS_LPL_INTERVALS_MS
+void wireless_lpl_set_class(uint8_t cls);
+
+/// @returns our class of WIRELESS_LPL_INTERVALS_MS
+uint8_t wireless_lpl_get_class(void);
+
+/// Sets the class of the neighbor, until it tells us its class
+void wireless_lpl_set_node_class(uint8_t neighbor, uint8_t cls);
+
+/// @returns the class of the neighbor, or 0 if it is always on or unknown
+uint8_t wireless_lpl_get_node_class(uint8_t neighbor);
+/** @} */
+
+/**
+ * @{ Reliable bulk transfer
+ * The sender keeps up to WIRELESS_BULK_WINDOW packets in flight without waiting for
+ * the ACK of each packet.  The receiver acknowledges with a bitmap of the packets it
+ * has, such that only the lost packets are sent again.  The receiver is always ready,
+ * and buffers up to WIRELESS_BULK_RX_BUFFER bytes for wireless_bulk_recv().
+ *
+ * @code
+ *      // Sender
+ *      if (wireless_bulk_open(dst, 2)) {
+ *          wireless_bulk_send(buffer, sizeof(buffer));
+ *      }
+ *
+ *      // Receiver
+ *      uint32_t bytes = wireless_bulk_recv(buffer, sizeof(buffer), 1000);
+ * @endcode
+ *
+ * @note There is one transfer at a time, and only one task should send or receive.
+ */
+
+/**
+ * Starts a new transfer to the destination, which discards the receiver's previous transfer.
+ * @returns true if the destination responded
+ */
+bool wireless_bulk_open(uint8_t dst_addr, uint8_t max_hops);
+
+/**
+ * Sends the data of the transfer started by wireless_bulk_open().
+ * The data of multiple calls is received as one stream.  Each call returns after all of
+ * its data is acknowledged, so use blocks of a few hundred bytes or more.
+ * @returns true if the receiver acknowledged all of the data
+ */
+bool wireless_bulk_send(const void *data, uint32_t len);
+
+/**
+ * Gets the in-order data of the bulk transfer.
+ * @returns the number of bytes copied to data, which is 0 if there is no data within the timeout
+ */
+uint32_t wireless_bulk_recv(void *data, uint32_t max_len, uint32_t timeout_ms);
+
+/// @returns the source address of the current received bulk transfer
+uint8_t wireless_bulk_get_rx_src(void);
+/** @} */
+
+/**
+ * @{ Multicast transfer of a file (such as a firmware image) to all the nodes at once
+ * The sender broadcasts the blocks of the file, and then polls the receivers, which answer
+ * with the bitmaps of the blocks they miss.  The missing blocks of all the receivers are
+ * merged, and each is broadcast once in the next round, so the transfer takes about the
+ * same time for any number of nodes.  The receivers can get the blocks in any order.
+ *
+ * @code
+ *      // Sender
+ *      wireless_mcast_send(size, crc32, 2, read_from_file, &file);
+ *
+ *      // Receivers
+ *      wireless_mcast_listen(true);
+ *      while (!wireless_mcast_is_complete()) {
+ *          uint32_t offset = 0;
+ *          uint32_t bytes = wireless_mcast_recv(buffer, &offset, 1000);
+ *          // write bytes of buffer at the offset of the file
+ *      }
+ *      wireless_mcast_listen(false);
+ * @endcode
+ *
+ * @note A node is a sender or a receiver of one transfer at a time.
+ */
+
+/**
+ * Callback of wireless_mcast_send() to read the data of the file.
+ * @returns false if the data could not be read, which stops the transfer
+ */
+typedef bool (*wireless_mcast_read_t)(void *data, uint32_t offset, uint32_t len, void *arg);
+
+/**
+ * Sends the file to all the listening nodes within max_hops.
+ * @param size   The size of the file, up to WIRELESS_MCAST_MAX_BYTES
+ * @param crc32  The CRC32 of the file, which the receivers get with wireless_mcast_get_file()
+ * @returns true once no receiver reports a missing block, or false if we gave up
+ */
+bool wireless_mcast_send(uint32_t size, uint32_t crc32, uint8_t max_hops, wireless_mcast_read_t read, void *arg);
+
+/// Starts (or stops) receiving the next multicast transfer, which discards the previous transfer
+void wireless_mcast_listen(bool listen);
+
+/**
+ * Gets the file of the transfer being received.
+ * @returns false if the sender has not announced the file yet
+ */
+bool wireless_mcast_get_file(uint32_t *size, uint32_t *crc32);
+
+/**
+ * Gets the next block of the file, which is up to MESH_DATA_PAYLOAD_SIZE bytes.
+ * @param offset  The offset of the block in the file
+ * @returns the number of bytes copied to data, which is 0 if there is no block within the timeout
+ */
+uint32_t wireless_mcast_recv(void *data, uint32_t *offset, uint32_t timeout_ms);
+
+/// @returns true once every block of the file was returned by wireless_mcast_recv()
+bool wireless_mcast_is_complete(void);
+/** @} */
+
+/**
+ * @{ Query of the telemetry variables of another node
+ * A master reading the status of many nodes would otherwise need the ASCII telemetry of
+ * each node over a NordicStream terminal.  This asks for up to WIRELESS_TLM_MAX_VARS
+ * variables by their IDs, and gets their binary values in a couple of packets.
+ *
+ * @code
+ *      wireless_tlm_id_t ids[2] = { { 0, 1 }, { 2, 0 } };
+ *      uint8_t values[WIRELESS_TLM_MAX_BYTES];
+ *      uint32_t len = 0;
+ *      uint16_t missing = 0;
+ *      if (wireless_tlm_query(addr, 2, ids, 2, values, &len, &missing, 500)) {
+ *          // values has the bytes of the variables which are not set in the missing bitmap
+ *      }
+ * @endcode
+ */
+#define WIRELESS_TLM_MAX_VARS       10      ///< Variables of each query
+#define WIRELESS_TLM_MAX_BYTES      158     ///< Bytes of the values of each query
+
+/**
+ * The ID of a telemetry variable, which is the same on the nodes running the same firmware.
+ * @see tlm_variable_get_indexes()
+ */
+typedef struct {
+    uint8_t comp;   ///< The component index, which is also its index in the binary telemetry stream
+    uint8_t var;    ///< The variable index within the component
+} wireless_tlm_id_t;
+
+/**
+ * Reads the telemetry variables of another node.
+ * @param values   The buffer of WIRELESS_TLM_MAX_BYTES for the values, which are packed
+ *                 in the order of the ids without the variables set in the missing bitmap.
+ * @param len      The bytes copied to values
+ * @param missing  Bit N is set if the Nth variable was not found, or if it did not fit
+ * @returns true if the reply was received within the timeout
+ */
+bool wireless_tlm_query(uint8_t dst_addr, uint8_t max_hops, const wireless_tlm_id_t *ids, uint8_t count,
+                        void *values, uint32_t *len, uint16_t *missing, uint32_t timeout_ms);
+/** @} */
+
 /// Just a wrapper around mesh_send_formed_pkt() to put all wireless related API at this file.
 static inline bool wireless_send_formed_pkt(mesh_packet_t *pkt) {
     return mesh_send_formed_pkt(pkt);
@@ -91,6 +415,45 @@ static inline bool wireless_send_formed_pkt(mesh_packet_t *pkt) {
  */
 char wireless_get_rx_pkt (mesh_packet_t *pkt, const uint32_t timeout_ms);
 
+/**
+ * @{ Received packets without copies
+ * The received packets are kept in a pool of WIRELESS_PKT_POOL_SIZE reference counted
+ * buffers, and wireless_get_rx_pkt() copies the packet out of its buffer.  The functions
+ * below hand out the buffer itself, which must be released once it is no longer used.
+ * Another task can be given the packet by sending the pointer through a queue.
+ *
+ * @code
+ *      mesh_packet_t *pkt = wireless_get_rx_pkt_ref(100);
+ *      if (NULL != pkt) {
+ *          // Use pkt->data, then release it, or forward it to another node :
+ *          //     wireless_pkt_forward(pkt, 200, mesh_pkt_nack, 2);
+ *          wireless_pkt_release(pkt);
+ *      }
+ * @endcode
+ */
+/**
+ * Same as wireless_get_rx_pkt(), except the packet is not copied.
+ * @returns the packet which should be released by wireless_pkt_release(), or NULL if there
+ *          is no packet within the timeout.
+ */
+mesh_packet_t* wireless_get_rx_pkt_ref(const uint32_t timeout_ms);
+
+/// Adds a reference to the packet, such that it needs one more wireless_pkt_release()
+void wireless_pkt_retain(mesh_packet_t *pkt);
+
+/// Releases the reference of the packet (pointers that are not from the pool are ignored)
+void wireless_pkt_release(mesh_packet_t *pkt);
+
+/**
+ * Sends the data of the received packet to another node, and then releases the packet.
+ * @returns the value of wireless_send()
+ */
+bool wireless_pkt_forward(mesh_packet_t *pkt, uint8_t dst_addr, mesh_protocol_t protocol, uint8_t max_hops);
+
+/// @returns the number of free buffers of the packet pool
+uint32_t wireless_pkt_get_free_count(void);
+/** @} */
+
 /// Same as wireless_get_rx_pkt(), except this will retrieve an ACK response
 char wireless_get_ack_pkt(mesh_packet_t *pkt, const uint32_t timeout_ms);
 
@@ -98,6 +461,13 @@ char wireless_get_ack_pkt(mesh_packet_t *pkt, const uint32_t timeout_ms);
 /// @returns the discarded packet count
 int wireless_flush_rx(void);
 
+/**
+ * Sets the semaphore that is given when a packet is queued for wireless_get_rx_pkt(), so the
+ * task can wait for the wireless along with other inputs (@see CharDev::setRxEvent()).
+ * @param event  The binary semaphore, or NULL to stop giving it
+ */
+void wireless_set_rx_event(SemaphoreHandle_t event);
+
 
 
 #ifdef __cplusplus
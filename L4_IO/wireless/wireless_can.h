@@ -0,0 +1,117 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+/**
+ * @file
+ * @brief Gateway between the CAN buses and the mesh network
+ * @ingroup  WIRELESS
+ *
+ * A node on a CAN bus and on the mesh can bridge the frames of some IDs to other nodes, and
+ * send the frames of the other nodes on its CAN, so a remote CAN segment can be monitored or
+ * controlled.  The routes select the frames of each direction, and the first route that matches
+ * a frame is used.  The frames to a node are coalesced into one packet, which is sent once the
+ * next frame does not fit, or WIRELESS_CAN_BATCH_MS after its first frame.  A newer frame of an
+ * ID that is already in the packet replaces it, so a fast periodic ID only sends its latest data.
+ *
+ * Each frame of a packet has a compact header: a byte with the 29-bit flag (bit 7), and the data
+ * length (bits 6-3), and either the bits 10-8 of an 11-bit ID (bits 2-0) and a byte of the other
+ * bits, or 4 bytes of a 29-bit ID (little-endian).  A packet has up to two 8-byte frames with
+ * 11-bit IDs, or up to five 2-byte frames, after the marker and the sequence number.
+ *
+ * @code
+ *      // Node 1: send the 0x100-0x10F frames of can1 to node 2, at most 50 per second
+ *      // Node 2: send the frames from node 1 on its can1 as 0x200-0x20F
+ *      const wireless_can_route_t node1[] = { { wireless_can_to_mesh, can1, 2, 2, 0x100, 0x7F0, 0, 50 } };
+ *      const wireless_can_route_t node2[] = { { wireless_can_to_can, can1, 1, 0, 0x100, 0x7F0, 0x200, 0 } };
+ *      wireless_can_start(node1, 1, PRIORITY_MEDIUM);     // And wireless_can_start(node2, ...) on node 2
+ * @endcode
+ *
+ * @note The gateway task is the reader of CAN_rx() of the CANs of the wireless_can_to_mesh routes,
+ *       and the frames that do not match a route are discarded.  The RTR frames are not bridged.
+ * @note The packets are sent without the mesh ACK, so the lost packets are only counted.
+ */
+#ifndef WIRELESS_CAN_H__
+#define WIRELESS_CAN_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "can.h"
+
+
+
+#define WIRELESS_CAN_DESTS          4                   ///< Nodes that can have a pending packet at a time
+#define WIRELESS_CAN_SOURCES        4                   ///< Nodes whose sequence numbers are tracked to count the lost packets
+#define WIRELESS_CAN_STACK_SIZE     STACK_BYTES(1024)   ///< The stack of the gateway task
+#define WIRELESS_CAN_ID_29BIT       (1U << 31)          ///< Set in the id and the mask of a route for the 29-bit IDs
+
+
+
+/// The direction of the frames of a route
+typedef enum {
+    wireless_can_to_mesh,   ///< The frames of the CAN are sent to the node
+    wireless_can_to_can,    ///< The frames received from the node are sent on the CAN
+} wireless_can_dir_t;
+
+/**
+ * A route of the gateway.  A frame matches the route if its ID (with WIRELESS_CAN_ID_29BIT for a
+ * 29-bit ID) masked by the mask equals the id masked by the mask.
+ */
+typedef struct {
+    wireless_can_dir_t dir;     ///< The direction of the frames
+    can_t can;                  ///< The CAN the frames are read from, or sent on
+    uint8_t node;               ///< The node the frames are sent to (or MESH_BROADCAST_ADDR), or received
+                                ///< from (MESH_BROADCAST_ADDR for any node)
+    uint8_t max_hops;           ///< The max hops of the packets to the node
+    uint32_t id;                ///< The ID of the frames of the route
+    uint32_t mask;              ///< The bits of the ID that are compared
+    uint32_t map_id;            ///< If not 0, the frames get the ID (ID & ~mask) | (map_id & mask)
+    uint16_t max_per_sec;       ///< The frames per second of the route, 0 for no limit
+} wireless_can_route_t;
+
+/// The counters of the gateway
+typedef struct {
+    uint32_t to_mesh_frames;    ///< The frames that were sent to the nodes
+    uint32_t to_mesh_pkts;      ///< The packets that were sent
+    uint32_t coalesced;         ///< The frames that replaced an older frame of their ID in a packet
+    uint32_t to_can_frames;     ///< The frames of the nodes that were sent on the CAN
+    uint32_t to_can_pkts;       ///< The packets that were received
+    uint32_t lost_pkts;         ///< The packets that were not received, by their sequence numbers
+    uint32_t limited;           ///< The frames dropped by the max_per_sec of their route
+    uint32_t failed;            ///< The frames that could not be sent, on the mesh or on the CAN
+} wireless_can_stats_t;
+
+/**
+ * Sets the routes of the gateway, and creates the gateway task the first time.
+ * @param count     Up to WIRELESS_CAN_MAX_ROUTES, or 0 to stop bridging
+ * @param priority  The priority of the gateway task
+ * @pre CAN_init() of the CANs of the routes, and the CAN filter that accepts their frames
+ */
+bool wireless_can_start(const wireless_can_route_t *routes, uint8_t count, UBaseType_t priority);
+
+/// @returns the counters of the gateway
+wireless_can_stats_t wireless_can_get_stats(void);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* WIRELESS_CAN_H__ */
@@ -1,378 +1,689 @@
-#include <stdlib.h>
-#include <stdio.h>
-#include <time.h>
-#include <string.h>
-
-#include "rn_xv_task.hpp"
-#include "file_logger.h"
-#include "tlm/c_tlm_comp.h"
-#include "tlm/c_tlm_var.h"
-#include "utilities.h"
-#include "str.hpp"
-
-
-
-void wifiTask::wifiFlush(void)
-{
-    char c = 0;
-    while(mWifi.getChar(&c, OS_MS(500))) {
-        if(mWifiEcho) {
-            putchar(c);
-        }
-    }
-}
-
-void wifiTask::wifiSendCmd(const char* pCmd, const char* pParam)
-{
-    mWifi.put(pCmd);
-    if(0 != pParam) {
-        mWifi.put(pParam);
-    }
-    mWifi.put("\r\n");
-
-    wifiFlush();
-}
-
-void wifiTask::wifiEnterCmdMode(void)
-{
-    /* Exit out of command mode just in case */
-    mWifi.putline("exit");
-
-    vTaskDelayMs(260);
-    mWifi.put("$$$");
-    vTaskDelayMs(260);
-
-    wifiFlush();
-}
-
-bool wifiTask::wifiHandleHttpReq(web_req_type* request)
-{
-    bool success = false;
-
-    if(NULL == request->http_ip_host ||
-       NULL == request->http_get_request ||
-       NULL == request->http_response ||
-       '\0' == request->http_get_request[0] ||
-       '\0' == request->http_ip_host[0] ||
-       request->http_response_size <= 0)
-    {
-        success = false;
-        return success;
-    }
-
-    wifiEnterCmdMode();
-    wifiSendCmd("set comm open @");
-
-    /* ********************************************************
-     * Open connection
-     * RN-XV will exit command mode after connection is open,
-     * so 'save' and 'exit' commands are not required
-     */
-    mWifi.put("open ");
-    mWifi.put(request->http_ip_host);
-    mWifi.putline(" 80");
-
-    /* Need to wait for connection */
-    // puts("Wait for connection char ...");
-    char c = 0;
-    while (c != '@' && mWifi.getChar(&c, OS_MS(30 * 1000))) {
-        // putchar(c);
-    }
-    wifiFlush();
-
-    success = ('@' == c);
-    if (!success) {
-        LOG_WARN("No connection char while servicing HTTP request");
-    }
-
-    /* Send our get request */
-    mWifi.put("GET ");
-    mWifi.put(request->http_get_request);
-    mWifi.putline("\n\n\r\n");
-
-    /* Wait higher timeout to get first server response */
-    success = mWifi.getChar(&c, OS_MS(10 * 1000));
-    if (!success) {
-        LOG_WARN("No response data from HTTP server for 10 seconds");
-    }
-
-    if (success && request->http_discard_until) {
-        /* Discard input until we see the discard_until char */
-        while(request->http_discard_until != c) {
-            if(!mWifi.getChar(&c, OS_MS(500))) {
-                break;
-            }
-        }
-    }
-
-    /* Get the rest of the data with lower timeout and not that we
-     * already received 1 byte above
-     */
-    request->http_response[0] = c;
-    int len = request->http_response_size - 1;
-    char *store = request->http_response + 1;
-    while(len--) {
-        if (! mWifi.getChar(&c, OS_MS(500))) {
-            break;
-        }
-        *store++ = c;
-    }
-    *store = '\0';
-    request->http_response_size = (store - request->http_response);
-
-    wifiFlush();
-    wifiEnterCmdMode();
-    wifiSendCmd("close");
-    wifiSendCmd("set comm open 0");
-    wifiSendCmd("exit");
-
-    return success;
-}
-
-bool wifiTask::wifiConnect(void)
-{
-    char *wifi_ssid = mWifiSsid;
-    char *wifi_key  = mWifiKey;
-
-    if(wifi_ssid && wifi_key && *wifi_ssid && *wifi_key)
-    {
-        puts("Using SSID/KEY from disk: ");
-        puts(wifi_ssid);
-        puts(wifi_key);
-        puts("");
-    }
-    else
-    {
-        puts("Please configure wifi settings.");
-        return false;
-    }
-    wifiEnterCmdMode();
-
-    // Disable extra printing
-    puts("Disable extra printing");
-    wifiSendCmd("set sys printlvl 0");
-    wifiSendCmd("set uart mode 0");
-
-    // Set connection parameters
-    puts("Set connection parameters");
-    wifiSendCmd("set ip dhcp 1");
-    wifiSendCmd("set wlan ssid ", wifi_ssid);
-    wifiSendCmd("set wlan auth 4");
-    wifiSendCmd("set wlan phrase ", wifi_key);
-    wifiSendCmd("set wlan channel 0");
-    wifiSendCmd("set wlan mask 0x1FFF");
-
-    // Set greeting parameters
-    puts("Set greeting parameters");
-    wifiSendCmd("set comm close 0");
-    wifiSendCmd("set comm open 0");
-    wifiSendCmd("set comm remote 0");
-
-    // Set flush parameters
-    puts("Set buffer parameters");
-    wifiSendCmd("set comm match 0");
-    wifiSendCmd("set comm timeout 10");
-    wifiSendCmd("set comm size 1024");
-    //wifi_SendCommand(w, "set comm idle 0");
-    wifiSendCmd("set comm idle 10");
-
-    // Set our TCP/IP server parameters
-    puts("Setup TCP/IP");
-    wifiSendCmd("set ip protocol 2"); /* TCP Server and Client */
-    wifiSendCmd("set ip localport " WIFI_PORT);
-
-    puts("Reboot");
-    wifiSendCmd("save");
-    wifiSendCmd("reboot");
-    wifiFlush();
-    return true;
-}
-
-bool wifiTask::wifiIsConnected(void)
-{
-    wifiEnterCmdMode();
-    mWifi.putline("show connection");
-
-    /**
-     * Get response, which could either be : "show connection\n####" (uart echo)
-     * or the response could be just "####" (status)
-     */
-    STR_ON_STACK(rsp, 128);
-    mWifi.gets((char*)rsp(), rsp.getCapacity(), 1000);
-    if(rsp.beginsWithIgnoreCase("show")) {
-        mWifi.gets((char*)rsp(), rsp.getCapacity(), 1000);
-    }
-
-    mWifi.putline("exit");
-    wifiFlush();
-
-    // Response is in hex: 8ABC
-    // Bits 4 and 5 indicate if connection is established
-    char lsbHex = rsp[2];
-    if(lsbHex >= '0' && lsbHex <= '9') {
-        lsbHex -= '0';
-    }
-    else if(lsbHex >= 'A' && lsbHex <= 'F') {
-        lsbHex -= 'A' + 10;
-    }
-
-    bool connected = (lsbHex & 0x3);
-    return connected;
-}
-
-void wifiTask::wifiSendTestCmd(void)
-{
-    wifiFlush();
-    wifiEnterCmdMode();
-    wifiFlush();
-    mWifi.putline("ver");
-}
-
-bool wifiTask::wifiInitBaudRate(void)
-{
-    STR_ON_STACK(s, 128);
-
-    /* If we can communicate right now, we've got baud rate match so return out of here */
-    printf("    Wifi attempt communication @ %i bps\n", (int)mWifiBaudRate);
-    mWifi.setBaudRate(mWifiBaudRate);
-    wifiSendTestCmd();
-
-    /* Wifi should either echo back "ver" or send response with "wifly" in it */
-    s.clear();
-    mWifi.gets((char*)s(), s.getCapacity(), 1000);
-    if (s.containsIgnoreCase("wifly") || s.containsIgnoreCase("ver")) {
-        printf("    Wifi Baud Rate confirmed @ %i\n", (int)mWifiBaudRate);
-        wifiSendCmd("exit");
-        return true;
-    }
-
-    /* We cannot communicate, so try different baud rates */
-    int baudRatesToTry[] = {9600, 38400, 115200, 230400, 460800};
-    const int num_baud_rates = sizeof(baudRatesToTry) / sizeof(baudRatesToTry[0]);
-    for (int i = 0; i < num_baud_rates; i++) {
-        const int baudRateToTry = baudRatesToTry[i];
-
-        printf("    Wifi attempt communication @ %i bps\n", baudRateToTry);
-        wifiFlush();
-        mWifi.setBaudRate(baudRateToTry);
-        wifiSendTestCmd();
-
-        /* If we can enter command mode now, then we've found the baud rate!
-         * So set/change the desired baud rate on the wifi module
-         */
-        s.clear();
-        if (mWifi.gets((char*)s(), s.getCapacity(), 1000)) {
-            if(s.containsIgnoreCase("wifly") || s.containsIgnoreCase("ver")) {
-                printf("    Wifi Baud Rate is: %i bps\n", baudRateToTry);
-
-                printf("    Changing Wifi to %i bps\n", (int)mWifiBaudRate);
-                s.printf("set uart baudrate %i", mWifiBaudRate);
-                wifiSendCmd(s());
-                wifiSendCmd("save");
-                wifiSendCmd("reboot");
-                delay_ms(2000);
-                wifiFlush();
-                return true;
-            }
-            else {
-                printf("    Wifi bad response: %s\n", s());
-            }
-        }
-    }
-
-    mWifi.setBaudRate(mWifiBaudRate);
-    printf("    Wifi Baud Rate is UNKNOWN.  Set baud rate back to %i\n", (int) mWifiBaudRate);
-    return false;
-}
-
-wifiTask::wifiTask(UartDev& uartForWifi, uint8_t priority) :
-        scheduler_task("rnxv", 512*8, priority),
-        mWifi(uartForWifi),
-        mWifiBaudRate(WIFI_BAUD_RATE),
-        mWifiEcho(true)
-{
-    mHttpReqQueue = xQueueCreate(1, sizeof(web_req_type*));
-    memset(mWifiSsid, 0, sizeof(mWifiSsid));
-    memset(mWifiKey, 0, sizeof(mWifiKey));
-
-    /* Default values, can be changed/saved during runtime */
-    strncpy(mWifiSsid, WIFI_SSID, sizeof(mWifiSsid) - 1);
-    strncpy(mWifiKey,  WIFI_KEY , sizeof(mWifiKey) - 1);
-}
-
-bool wifiTask::init()
-{
-    return addSharedObject(WIFI_SHR_OBJ, mHttpReqQueue);
-}
-
-bool wifiTask::regTlm()
-{
-#if SYS_CFG_ENABLE_TLM
-    /* User can change this during run-time by setting telemetry variable */
-    tlm_component *disk = tlm_component_get_by_name(SYS_CFG_DISK_TLM_NAME);
-    TLM_REG_VAR(disk, mWifiSsid, tlm_string);
-    TLM_REG_VAR(disk, mWifiKey,  tlm_string);
-    TLM_REG_VAR(disk, mWifiEcho, tlm_bit_or_bool);
-    TLM_REG_VAR(disk, mWifiBaudRate, tlm_uint);
-#endif
-
-    return true;
-}
-
-bool wifiTask::taskEntry()
-{
-    // Not ready until changed otherwise
-    mWifi.setReady(false);
-
-    /* If we cannot detect baud rate, error out from here, but return true
-     * so that this task doesn't halt the whole system due to this error.
-     */
-    if(!wifiInitBaudRate()) {
-        return true;
-    }
-
-    if(!wifiIsConnected()) {
-        puts("    Wifi not connected");
-        if(wifiConnect()) {
-            puts("    Wifi is now connected!");
-        }
-        else {
-            puts("    Wifi ERROR connecting");
-        }
-    }
-
-    /* Display the IP address */
-    do {
-        wifiEnterCmdMode();
-        mWifi.putline("get ip");
-        char buffer[128] = { 0 };
-        mWifi.gets(buffer, sizeof(buffer), 1000); /* echo */
-        mWifi.gets(buffer, sizeof(buffer), 1000); /* IF=UP */
-        mWifi.gets(buffer, sizeof(buffer), 1000); /* DHCP=ON */
-        mWifi.gets(buffer, sizeof(buffer), 1000); /* IP : Port */
-        mWifi.putline("exit");
-        printf("    Wifi %s\n", buffer);
-    } while (0) ;
-
-    wifiFlush();
-    mWifi.setReady(true);
-
-    return true;
-}
-
-bool wifiTask::run(void* p)
-{
-    web_req_type *request = 0;
-    if (xQueueReceive(mHttpReqQueue, &(request), portMAX_DELAY)) {
-        mWifi.setReady(false);
-        {
-            request->success = wifiHandleHttpReq(request);
-            if(request->req_done_signal) {
-                xSemaphoreGive( (request->req_done_signal));
-            }
-        }
-        mWifi.setReady(true);
-    }
-
-    return true;
-}
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <string.h>
+
+#include "rn_xv_task.hpp"
+#include "file_logger.h"
+#include "tlm/c_tlm_comp.h"
+#include "tlm/c_tlm_var.h"
+#include "utilities.h"
+#include "str.hpp"
+
+
+
+/// @returns true if the last chars of the RN-XV output end a command response, such as the "<4.00> " prompt
+static bool wifi_is_rsp_end(const char *pTail)
+{
+    static const char * const ends[] = { "> ", "CMD\r\n", "EXIT\r\n" };
+    const size_t tailLen = strlen(pTail);
+
+    for (size_t i = 0; i < sizeof(ends) / sizeof(ends[0]); i++) {
+        const size_t endLen = strlen(ends[i]);
+        if (tailLen >= endLen && 0 == strcmp(pTail + tailLen - endLen, ends[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void wifiTask::wifiFlush(void)
+{
+    char c = 0;
+
+    /* The response ends once the line goes idle after the response end and nothing else is buffered,
+     * otherwise wait until the RN-XV stops sending for 500ms.
+     */
+    if (mWifi.isFramingEnabled()) {
+        char frame[32];
+        char tail[8] = { 0 };
+        size_t len = 0;
+
+        while (0 != (len = mWifi.getFrame(frame, sizeof(frame), NULL, OS_MS(500)))) {
+            for (size_t i = 0; i < len; i++) {
+                if(mWifiEcho) {
+                    putchar(frame[i]);
+                }
+                memmove(tail, tail + 1, sizeof(tail) - 2);
+                tail[sizeof(tail) - 2] = frame[i];
+            }
+            if (mWifi.isFrameEnd() && 0 == mWifi.getRxQueueSize() && wifi_is_rsp_end(tail)) {
+                break;
+            }
+        }
+        return;
+    }
+
+    while(mWifi.getChar(&c, OS_MS(500))) {
+        if(mWifiEcho) {
+            putchar(c);
+        }
+    }
+}
+
+void wifiTask::wifiSendCmd(const char* pCmd, const char* pParam)
+{
+    mWifi.put(pCmd);
+    if(0 != pParam) {
+        mWifi.put(pParam);
+    }
+    mWifi.put("\r\n");
+
+    wifiFlush();
+}
+
+void wifiTask::wifiEnterCmdMode(void)
+{
+    /* Exit out of command mode just in case */
+    mWifi.putline("exit");
+
+    vTaskDelayMs(260);
+    mWifi.put("$$$");
+    vTaskDelayMs(260);
+
+    wifiFlush();
+}
+
+/// The storage of a response, which skips the data until web_req_type::http_discard_until
+typedef struct {
+    char *store;        ///< Next byte of web_req_type::http_response
+    int room;           ///< The room left at store, excluding the NULL terminator
+    bool storing;       ///< True once the http_discard_until char has been found
+    char discardUntil;  ///< The web_req_type::http_discard_until
+} http_rsp_t;
+
+static void http_rsp_put(http_rsp_t *pRsp, char c)
+{
+    if (!pRsp->storing && c == pRsp->discardUntil) {
+        pRsp->storing = true;
+    }
+    if (pRsp->storing && pRsp->room > 0) {
+        *(pRsp->store)++ = c;
+        pRsp->room--;
+    }
+}
+
+bool wifiTask::wifiIsOpen(const char* pHost)
+{
+    const char *pClose = WIFI_HTTP_CLOSE_STR;
+    const char *pMatch = pClose;
+    char c = 0;
+
+    if ('\0' == mOpenHost[0]) {
+        return false;
+    }
+
+    /* The data received between the requests is discarded, but tells us if the host closed the connection */
+    while (mWifi.getChar(&c, 0)) {
+        pMatch = (c == *pMatch) ? (pMatch + 1) : ((c == pClose[0]) ? (pClose + 1) : pClose);
+        if ('\0' == *pMatch) {
+            mOpenHost[0] = '\0';
+            return false;
+        }
+    }
+
+    if (0 != strcmp(mOpenHost, pHost)) {
+        wifiCloseConnection();
+        return false;
+    }
+    return true;
+}
+
+bool wifiTask::wifiOpenConnection(const char* pHost)
+{
+    wifiEnterCmdMode();
+    wifiSendCmd("set comm open @");
+    wifiSendCmd("set comm close " WIFI_HTTP_CLOSE_STR);
+
+    /* ********************************************************
+     * Open connection
+     * RN-XV will exit command mode after connection is open,
+     * so 'save' and 'exit' commands are not required
+     */
+    mWifi.put("open ");
+    mWifi.put(pHost);
+    mWifi.putline(" 80");
+
+    /* Need to wait for connection */
+    char c = 0;
+    while (c != '@' && mWifi.getChar(&c, OS_MS(30 * 1000))) {
+        ;
+    }
+
+    if ('@' != c) {
+        LOG_WARN("No connection char while servicing HTTP request");
+        mWifi.putline("exit");
+        wifiFlush();
+        return false;
+    }
+
+    strncpy(mOpenHost, pHost, sizeof(mOpenHost) - 1);
+    mOpenHost[sizeof(mOpenHost) - 1] = '\0';
+    return true;
+}
+
+void wifiTask::wifiCloseConnection(void)
+{
+    if ('\0' == mOpenHost[0]) {
+        return;
+    }
+
+    wifiEnterCmdMode();
+    wifiSendCmd("close");
+    wifiSendCmd("set comm open 0");
+    wifiSendCmd("set comm close 0");
+    wifiSendCmd("exit");
+    mOpenHost[0] = '\0';
+}
+
+void wifiTask::wifiSendHttpReq(web_req_type* request)
+{
+    CharDev& io = *mpHttpIo;
+
+    io.put(request->http_post_data ? "POST " : "GET ");
+    if ('/' != request->http_get_request[0]) {
+        io.put("/");
+    }
+    io.put(request->http_get_request);
+    io.put(" HTTP/1.1\r\nHost: ");
+    io.put(request->http_ip_host);
+
+    if (request->http_post_data) {
+        char length[16] = { 0 };
+        sprintf(length, "%i", request->http_post_size);
+        io.put("\r\nContent-Type: ");
+        io.put(request->http_content_type ? request->http_content_type : "application/octet-stream");
+        io.put("\r\nContent-Length: ");
+        io.put(length);
+    }
+
+    io.put((WIFI_HTTP_KEEP_ALIVE_MS > 0) ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n");
+    if (request->http_post_data) {
+        io.putBlock(request->http_post_data, request->http_post_size);
+    }
+}
+
+bool wifiTask::wifiReadHttpRsp(web_req_type* request, bool& keepAlive)
+{
+    CharDev& io = *mpHttpIo;
+    http_rsp_t rsp = { request->http_response, request->http_response_size - 1,
+                       (0 == request->http_discard_until), request->http_discard_until };
+    STR_ON_STACK(line, 64);
+    int contentLength = -1;
+    bool firstLine = true;
+    char c = 0;
+
+    keepAlive = false;
+
+    /* Wait higher timeout to get first server response */
+    if (!io.getChar(&c, OS_MS(10 * 1000))) {
+        LOG_WARN("No response data from HTTP server for 10 seconds");
+        *rsp.store = '\0';
+        request->http_response_size = 0;
+        return false;
+    }
+
+    /* The header lines are stored like the rest of the response, and parsed until the empty line */
+    bool success = true;
+    do {
+        http_rsp_put(&rsp, c);
+        if ('\r' == c) {
+            continue;
+        }
+        if ('\n' != c) {
+            if (line.getLen() + 1 < line.getCapacity()) {
+                line += c;
+            }
+            continue;
+        }
+
+        if (0 == line.getLen()) {
+            break;
+        }
+        if (firstLine) {
+            keepAlive = !line.beginsWithIgnoreCase("HTTP/1.0");
+            firstLine = false;
+        }
+        else if (line.beginsWithIgnoreCase("content-length:")) {
+            contentLength = atoi(line() + 15);
+        }
+        else if (line.beginsWithIgnoreCase("connection:")) {
+            keepAlive = !line.containsIgnoreCase("close");
+        }
+        else if (line.beginsWithIgnoreCase("transfer-encoding:")) {
+            /* The end of the chunked body is not parsed, so the connection is not used again */
+            contentLength = -1;
+        }
+        line.clear();
+    } while ((success = io.getChar(&c, OS_MS(500))));
+
+    if (!success) {
+        keepAlive = false;
+    }
+    /* Without the Content-Length, the response ends when the data stops, or in the framing mode
+     * of the UART, once the line goes idle after the close string
+     */
+    else if (contentLength < 0) {
+        const char *pClose = WIFI_HTTP_CLOSE_STR;
+        const char *pMatch = pClose;
+        const bool framed = (&io == &mWifi && mWifi.isFramingEnabled());
+
+        keepAlive = false;
+        while (io.getChar(&c, OS_MS(500))) {
+            http_rsp_put(&rsp, c);
+            pMatch = (c == *pMatch) ? (pMatch + 1) : ((c == pClose[0]) ? (pClose + 1) : pClose);
+            if (framed && '\0' == *pMatch && mWifi.isFrameEnd()) {
+                break;
+            }
+        }
+    }
+    else {
+        for (int i = 0; i < contentLength; i++) {
+            if (!io.getChar(&c, OS_MS(500))) {
+                keepAlive = success = false;
+                break;
+            }
+            http_rsp_put(&rsp, c);
+        }
+    }
+
+    *rsp.store = '\0';
+    request->http_response_size = (rsp.store - request->http_response);
+
+    /* The close string is not part of the response */
+    const int closeLen = sizeof(WIFI_HTTP_CLOSE_STR) - 1;
+    if (request->http_response_size >= closeLen &&
+        0 == strcmp(rsp.store - closeLen, WIFI_HTTP_CLOSE_STR)) {
+        request->http_response_size -= closeLen;
+        request->http_response[request->http_response_size] = '\0';
+        keepAlive = false;
+    }
+
+    return success;
+}
+
+void wifiTask::wifiHandleHttpReqs(web_req_type** pRequests, uint8_t count)
+{
+#if WIFI_MUX_ENABLE
+    /* The gateway keeps the connections to the hosts, so the requests are only sent and read */
+    bool keepAlive = false;
+    for (uint8_t i = 0; i < count; i++) {
+        wifiSendHttpReq(pRequests[i]);
+    }
+    mpHttpIo->flush();
+    for (uint8_t i = 0; i < count; i++) {
+        pRequests[i]->success = wifiReadHttpRsp(pRequests[i], keepAlive);
+    }
+    return;
+#endif
+
+    /* The requests are to the same host, and if the host closes the connection after a response,
+     * the requests after it are sent again on a new connection.
+     */
+    uint8_t next = 0;
+    while (next < count)
+    {
+        const bool reused = wifiIsOpen(pRequests[next]->http_ip_host);
+        if (!reused && !wifiOpenConnection(pRequests[next]->http_ip_host)) {
+            for ( ; next < count; next++) {
+                pRequests[next]->success = false;
+            }
+            break;
+        }
+
+        for (uint8_t i = next; i < count; i++) {
+            wifiSendHttpReq(pRequests[i]);
+        }
+
+        bool keepAlive = false;
+        for ( ; next < count; next++) {
+            pRequests[next]->success = wifiReadHttpRsp(pRequests[next], keepAlive);
+            if (!pRequests[next]->success || !keepAlive) {
+                break;
+            }
+        }
+
+        if (next < count) {
+            wifiCloseConnection();
+
+            /* A request that failed on a connection that was open before may have found it closed by the host */
+            if (pRequests[next]->success || !reused) {
+                next++;
+            }
+        }
+    }
+
+    if (0 == WIFI_HTTP_KEEP_ALIVE_MS) {
+        wifiCloseConnection();
+    }
+}
+
+void wifiTask::wifiConnectGateway(void)
+{
+    wifiEnterCmdMode();
+
+    /* The RN-XV connects to the gateway by itself, also when the connection is lost */
+    wifiSendCmd("set comm open 0");
+    wifiSendCmd("set comm close 0");
+    wifiSendCmd("set comm remote 0");
+    wifiSendCmd("set ip host 0");
+    wifiSendCmd("set dns name " WIFI_MUX_GATEWAY);
+    wifiSendCmd("set ip remote " WIFI_MUX_PORT);
+    wifiSendCmd("set sys autoconn 1");
+    wifiSendCmd("save");
+
+    /* The RN-XV exits the command mode after the connection is open */
+    mWifi.putline("open");
+}
+
+bool wifiTask::wifiConnect(void)
+{
+    char *wifi_ssid = mWifiSsid;
+    char *wifi_key  = mWifiKey;
+
+    if(wifi_ssid && wifi_key && *wifi_ssid && *wifi_key)
+    {
+        puts("Using SSID/KEY from disk: ");
+        puts(wifi_ssid);
+        puts(wifi_key);
+        puts("");
+    }
+    else
+    {
+        puts("Please configure wifi settings.");
+        return false;
+    }
+    wifiEnterCmdMode();
+
+    // Disable extra printing
+    puts("Disable extra printing");
+    wifiSendCmd("set sys printlvl 0");
+    wifiSendCmd("set uart mode 0");
+
+    // Set connection parameters
+    puts("Set connection parameters");
+    wifiSendCmd("set ip dhcp 1");
+    wifiSendCmd("set wlan ssid ", wifi_ssid);
+    wifiSendCmd("set wlan auth 4");
+    wifiSendCmd("set wlan phrase ", wifi_key);
+    wifiSendCmd("set wlan channel 0");
+    wifiSendCmd("set wlan mask 0x1FFF");
+
+    // Set greeting parameters
+    puts("Set greeting parameters");
+    wifiSendCmd("set comm close 0");
+    wifiSendCmd("set comm open 0");
+    wifiSendCmd("set comm remote 0");
+
+    // Set flush parameters
+    puts("Set buffer parameters");
+    wifiSendCmd("set comm match 0");
+    wifiSendCmd("set comm timeout 10");
+    wifiSendCmd("set comm size 1024");
+    //wifi_SendCommand(w, "set comm idle 0");
+    wifiSendCmd("set comm idle 10");
+
+    // Set our TCP/IP server parameters
+    puts("Setup TCP/IP");
+    wifiSendCmd("set ip protocol 2"); /* TCP Server and Client */
+    wifiSendCmd("set ip localport " WIFI_PORT);
+
+    puts("Reboot");
+    wifiSendCmd("save");
+    wifiSendCmd("reboot");
+    wifiFlush();
+    return true;
+}
+
+bool wifiTask::wifiIsConnected(void)
+{
+    wifiEnterCmdMode();
+    mWifi.putline("show connection");
+
+    /**
+     * Get response, which could either be : "show connection\n####" (uart echo)
+     * or the response could be just "####" (status)
+     */
+    STR_ON_STACK(rsp, 128);
+    mWifi.gets((char*)rsp(), rsp.getCapacity(), 1000);
+    if(rsp.beginsWithIgnoreCase("show")) {
+        mWifi.gets((char*)rsp(), rsp.getCapacity(), 1000);
+    }
+
+    mWifi.putline("exit");
+    wifiFlush();
+
+    // Response is in hex: 8ABC
+    // Bits 4 and 5 indicate if connection is established
+    char lsbHex = rsp[2];
+    if(lsbHex >= '0' && lsbHex <= '9') {
+        lsbHex -= '0';
+    }
+    else if(lsbHex >= 'A' && lsbHex <= 'F') {
+        lsbHex -= 'A' + 10;
+    }
+
+    bool connected = (lsbHex & 0x3);
+    return connected;
+}
+
+void wifiTask::wifiSendTestCmd(void)
+{
+    wifiFlush();
+    wifiEnterCmdMode();
+    wifiFlush();
+    mWifi.putline("ver");
+}
+
+bool wifiTask::wifiInitBaudRate(void)
+{
+    STR_ON_STACK(s, 128);
+
+    /* If we can communicate right now, we've got baud rate match so return out of here */
+    printf("    Wifi attempt communication @ %i bps\n", (int)mWifiBaudRate);
+    mWifi.setBaudRate(mWifiBaudRate);
+    wifiSendTestCmd();
+
+    /* Wifi should either echo back "ver" or send response with "wifly" in it */
+    s.clear();
+    mWifi.gets((char*)s(), s.getCapacity(), 1000);
+    if (s.containsIgnoreCase("wifly") || s.containsIgnoreCase("ver")) {
+        printf("    Wifi Baud Rate confirmed @ %i\n", (int)mWifiBaudRate);
+        wifiSendCmd("exit");
+        return true;
+    }
+
+    /* We cannot communicate, so try different baud rates */
+    int baudRatesToTry[] = {9600, 38400, 115200, 230400, 460800};
+    const int num_baud_rates = sizeof(baudRatesToTry) / sizeof(baudRatesToTry[0]);
+    for (int i = 0; i < num_baud_rates; i++) {
+        const int baudRateToTry = baudRatesToTry[i];
+
+        printf("    Wifi attempt communication @ %i bps\n", baudRateToTry);
+        wifiFlush();
+        mWifi.setBaudRate(baudRateToTry);
+        wifiSendTestCmd();
+
+        /* If we can enter command mode now, then we've found the baud rate!
+         * So set/change the desired baud rate on the wifi module
+         */
+        s.clear();
+        if (mWifi.gets((char*)s(), s.getCapacity(), 1000)) {
+            if(s.containsIgnoreCase("wifly") || s.containsIgnoreCase("ver")) {
+                printf("    Wifi Baud Rate is: %i bps\n", baudRateToTry);
+
+                printf("    Changing Wifi to %i bps\n", (int)mWifiBaudRate);
+                s.printf("set uart baudrate %i", mWifiBaudRate);
+                wifiSendCmd(s());
+                wifiSendCmd("save");
+                wifiSendCmd("reboot");
+                delay_ms(2000);
+                wifiFlush();
+                return true;
+            }
+            else {
+                printf("    Wifi bad response: %s\n", s());
+            }
+        }
+    }
+
+    mWifi.setBaudRate(mWifiBaudRate);
+    printf("    Wifi Baud Rate is UNKNOWN.  Set baud rate back to %i\n", (int) mWifiBaudRate);
+    return false;
+}
+
+wifiTask::wifiTask(UartDev& uartForWifi, uint8_t priority) :
+        scheduler_task("rnxv", 512*8, priority),
+        mWifi(uartForWifi),
+        mWifiBaudRate(WIFI_BAUD_RATE),
+        mpNextReq(NULL),
+#if WIFI_MUX_ENABLE
+        mMux(uartForWifi),
+        mpHttpIo(&mMux.getChannel(WIFI_MUX_HTTP)),
+#else
+        mpHttpIo(&uartForWifi),
+#endif
+        mWifiEcho(true)
+{
+    mHttpReqQueue = xQueueCreate(WIFI_HTTP_PIPELINE, sizeof(web_req_type*));
+    memset(mOpenHost, 0, sizeof(mOpenHost));
+    memset(mWifiSsid, 0, sizeof(mWifiSsid));
+    memset(mWifiKey, 0, sizeof(mWifiKey));
+
+    /* Default values, can be changed/saved during runtime */
+    strncpy(mWifiSsid, WIFI_SSID, sizeof(mWifiSsid) - 1);
+    strncpy(mWifiKey,  WIFI_KEY , sizeof(mWifiKey) - 1);
+}
+
+bool wifiTask::init()
+{
+#if WIFI_MUX_ENABLE
+    if (!addSharedObject(WIFI_MUX_SHR_OBJ, &mMux.getChannel(WIFI_MUX_TERMINAL))) {
+        return false;
+    }
+#endif
+
+    return addSharedObject(WIFI_SHR_OBJ, mHttpReqQueue);
+}
+
+bool wifiTask::regTlm()
+{
+#if SYS_CFG_ENABLE_TLM
+    /* User can change this during run-time by setting telemetry variable */
+    tlm_component *disk = tlm_component_get_by_name(SYS_CFG_DISK_TLM_NAME);
+    TLM_REG_VAR(disk, mWifiSsid, tlm_string);
+    TLM_REG_VAR(disk, mWifiKey,  tlm_string);
+    TLM_REG_VAR(disk, mWifiEcho, tlm_bit_or_bool);
+    TLM_REG_VAR(disk, mWifiBaudRate, tlm_uint);
+#endif
+
+    return true;
+}
+
+bool wifiTask::taskEntry()
+{
+    // Not ready until changed otherwise
+    mWifi.setReady(false);
+
+    // The idle line ends the responses of the RN-XV, @see wifiFlush()
+    mWifi.enableFraming();
+
+    /* If we cannot detect baud rate, error out from here, but return true
+     * so that this task doesn't halt the whole system due to this error.
+     */
+    if(!wifiInitBaudRate()) {
+        return true;
+    }
+
+    if(!wifiIsConnected()) {
+        puts("    Wifi not connected");
+        if(wifiConnect()) {
+            puts("    Wifi is now connected!");
+        }
+        else {
+            puts("    Wifi ERROR connecting");
+        }
+    }
+
+    /* Display the IP address */
+    do {
+        wifiEnterCmdMode();
+        mWifi.putline("get ip");
+        char buffer[128] = { 0 };
+        mWifi.gets(buffer, sizeof(buffer), 1000); /* echo */
+        mWifi.gets(buffer, sizeof(buffer), 1000); /* IF=UP */
+        mWifi.gets(buffer, sizeof(buffer), 1000); /* DHCP=ON */
+        mWifi.gets(buffer, sizeof(buffer), 1000); /* IP : Port */
+        mWifi.putline("exit");
+        printf("    Wifi %s\n", buffer);
+    } while (0) ;
+
+    wifiFlush();
+
+#if WIFI_MUX_ENABLE
+    /* The UART belongs to the mux from now on */
+    wifiConnectGateway();
+    wifiFlush();
+    return mMux.start(getTaskPriority());
+#else
+    mWifi.setReady(true);
+    return true;
+#endif
+}
+
+bool wifiTask::run(void* p)
+{
+    web_req_type *requests[WIFI_HTTP_PIPELINE];
+    uint8_t count = 0;
+
+    /* Close the connection if no request arrives within the keep-alive time */
+    const TickType_t timeout = ('\0' != mOpenHost[0]) ? OS_MS(WIFI_HTTP_KEEP_ALIVE_MS) : portMAX_DELAY;
+    if (NULL == mpNextReq && !xQueueReceive(mHttpReqQueue, &mpNextReq, timeout)) {
+        wifiCloseConnection();
+        mWifi.setReady(!WIFI_MUX_ENABLE);
+        return true;
+    }
+
+    /* The requests waiting in the queue for the same host are pipelined */
+    do {
+        web_req_type *request = mpNextReq;
+        if (count > 0 && 0 != strcmp(requests[0]->http_ip_host, request->http_ip_host)) {
+            break;
+        }
+        mpNextReq = NULL;
+
+        if(NULL == request->http_ip_host ||
+           NULL == request->http_get_request ||
+           NULL == request->http_response ||
+           '\0' == request->http_get_request[0] ||
+           '\0' == request->http_ip_host[0] ||
+           request->http_response_size <= 0 ||
+           (request->http_post_data && request->http_post_size < 0))
+        {
+            request->success = false;
+            if(request->req_done_signal) {
+                xSemaphoreGive(request->req_done_signal);
+            }
+        }
+        else {
+            requests[count++] = request;
+        }
+    } while (count < WIFI_HTTP_PIPELINE && xQueueReceive(mHttpReqQueue, &mpNextReq, 0));
+
+    if (count > 0) {
+        mWifi.setReady(false);
+        wifiHandleHttpReqs(requests, count);
+        for (uint8_t i = 0; i < count; i++) {
+            if(requests[i]->req_done_signal) {
+                xSemaphoreGive(requests[i]->req_done_signal);
+            }
+        }
+    }
+
+    /* The UART can be used by others when the connection is not kept open */
+    if ('\0' == mOpenHost[0]) {
+        mWifi.setReady(!WIFI_MUX_ENABLE);
+    }
+
+    return true;
+}
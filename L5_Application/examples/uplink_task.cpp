@@ -0,0 +1,297 @@
+#include <string.h>
+
+#include "uplink_task.hpp"
+#include "file_logger.h"
+#include "lpc_sys.h"
+#include "ff.h"
+#include "tlm/c_tlm_comp.h"
+#include "tlm/c_tlm_var.h"
+#include "tlm/c_tlm_sampler.h"
+
+
+
+/// The bytes of the batch header: 'U' 'B' and the seq
+#define UPLINK_BATCH_HDR_BYTES  4
+
+/// The bytes of the chunk header: the tag and the length
+#define UPLINK_CHUNK_HDR_BYTES  3
+
+
+
+uplinkTask::uplinkTask(uint8_t priority) :
+        scheduler_task("uplink", 512*4, priority),
+        mBatchLen(0), mChunk(0), mSeq(0), mSealed(false),
+        mReqDone(NULL),
+        mRetryMs(0), mRetryAtMs(0),
+        mLogOffset(0), mSpoolOffset(0), mDroppedBatches(0)
+{
+    memset(&mReq, 0, sizeof(mReq));
+    startBatch();
+    setRunDuration(UPLINK_PERIOD_MS);
+}
+
+bool uplinkTask::init(void)
+{
+    return (NULL != (mReqDone = xSemaphoreCreateBinary()));
+}
+
+bool uplinkTask::regTlm(void)
+{
+#if SYS_CFG_ENABLE_TLM
+    tlm_component *disk = tlm_component_get_by_name(SYS_CFG_DISK_TLM_NAME);
+    TLM_REG_VAR(disk, mLogOffset, tlm_uint);
+    TLM_REG_VAR(disk, mSpoolOffset, tlm_uint);
+    TLM_REG_VAR(disk, mDroppedBatches, tlm_uint);
+#endif
+
+    return true;
+}
+
+void uplinkTask::startBatch(void)
+{
+    mSeq++;
+    mBatch[0] = 'U';
+    mBatch[1] = 'B';
+    mBatch[2] = mSeq & 0xFF;
+    mBatch[3] = mSeq >> 8;
+    mBatchLen = UPLINK_BATCH_HDR_BYTES;
+    mChunk = 0;
+}
+
+void uplinkTask::append(uint8_t tag, const void *pData, uint32_t len)
+{
+    const uint8_t *pBytes = (const uint8_t*) pData;
+
+    while (len > 0)
+    {
+        /* Continue the last chunk if it has the same tag, otherwise start a new chunk */
+        if (0 == mChunk || tag != mBatch[mChunk]) {
+            if ((uint32_t) mBatchLen + UPLINK_CHUNK_HDR_BYTES >= sizeof(mBatch)) {
+                spool(mBatch, mBatchLen);
+                startBatch();
+                mSealed = true;
+            }
+            mChunk = mBatchLen;
+            mBatch[mChunk] = tag;
+            mBatch[mChunk + 1] = 0;
+            mBatch[mChunk + 2] = 0;
+            mBatchLen += UPLINK_CHUNK_HDR_BYTES;
+        }
+
+        uint32_t chunk = sizeof(mBatch) - mBatchLen;
+        if (chunk > len) {
+            chunk = len;
+        }
+        memcpy(&mBatch[mBatchLen], pBytes, chunk);
+        mBatchLen += chunk;
+        pBytes += chunk;
+        len -= chunk;
+
+        const uint16_t chunkLen = mBatchLen - mChunk - UPLINK_CHUNK_HDR_BYTES;
+        mBatch[mChunk + 1] = chunkLen & 0xFF;
+        mBatch[mChunk + 2] = chunkLen >> 8;
+
+        /* The batch is full, so the next chunk starts the next batch */
+        if (len > 0) {
+            mChunk = 0;
+        }
+    }
+}
+
+void uplinkTask::appendSamples(const void *pData, uint32_t len, void *pThis)
+{
+    ((uplinkTask*) pThis)->append(uplink_tag_tlm_sampler, pData, len);
+}
+
+void uplinkTask::collectLog(void)
+{
+#if (FILE_LOGGER_BIN_ENABLE)
+    FIL file;
+    if (FR_OK != f_open(&file, FILE_LOGGER_BIN_FILENAME, FA_OPEN_EXISTING | FA_READ)) {
+        return;
+    }
+
+    /* The log was deleted, or is a new file */
+    if (mLogOffset > f_size(&file)) {
+        mLogOffset = 0;
+    }
+
+    uint8_t record[sizeof(logger_bin_header_t) + FILE_LOGGER_BIN_MAX_ARGS * sizeof(uint32_t)];
+    logger_bin_header_t *pHeader = (logger_bin_header_t*) record;
+    UINT bytesRead = 0;
+
+    f_lseek(&file, mLogOffset);
+    while (FR_OK == f_read(&file, pHeader, sizeof(*pHeader), &bytesRead) && sizeof(*pHeader) == bytesRead)
+    {
+        /* The zeros after the records are the unwritten part of the pre-allocated file */
+        const uint8_t nargs = LOGGER_BIN_INFO_NARGS(pHeader->info);
+        if ((0 == pHeader->id && 0 == pHeader->info && 0 == pHeader->time_us_hi && 0 == pHeader->time_us_lo) ||
+            nargs > FILE_LOGGER_BIN_MAX_ARGS) {
+            break;
+        }
+
+        const UINT argBytes = nargs * sizeof(uint32_t);
+        if (FR_OK != f_read(&file, &record[sizeof(*pHeader)], argBytes, &bytesRead) || argBytes != bytesRead) {
+            break;
+        }
+
+        /* A record is not split across the batches */
+        const uint32_t recordBytes = sizeof(*pHeader) + argBytes;
+        if (mBatchLen + UPLINK_CHUNK_HDR_BYTES + recordBytes > sizeof(mBatch)) {
+            spool(mBatch, mBatchLen);
+            startBatch();
+            mSealed = true;
+        }
+        append(uplink_tag_log_bin, record, recordBytes);
+        mLogOffset += recordBytes;
+    }
+    f_close(&file);
+#endif
+}
+
+bool uplinkTask::spool(const uint8_t *pData, uint16_t len)
+{
+    FIL file;
+    UINT bytesWritten = 0;
+    bool success = false;
+    const uint8_t frameLen[2] = { (uint8_t) (len & 0xFF), (uint8_t) (len >> 8) };
+
+    if (FR_OK == f_open(&file, UPLINK_SPOOL_FILENAME, FA_OPEN_ALWAYS | FA_WRITE))
+    {
+        if (f_size(&file) + sizeof(frameLen) + len <= UPLINK_SPOOL_MAX_BYTES &&
+            FR_OK == f_lseek(&file, f_size(&file)) &&
+            FR_OK == f_write(&file, frameLen, sizeof(frameLen), &bytesWritten) && sizeof(frameLen) == bytesWritten &&
+            FR_OK == f_write(&file, pData, len, &bytesWritten) && len == bytesWritten)
+        {
+            success = true;
+        }
+        f_close(&file);
+    }
+
+    if (!success) {
+        ++mDroppedBatches;
+        LOG_WARN("Dropped uplink batch of %u bytes", (unsigned) len);
+    }
+    return success;
+}
+
+bool uplinkTask::post(const uint8_t *pData, uint16_t len)
+{
+    QueueHandle_t webReqQueue = getSharedObject(WIFI_SHR_OBJ);
+    web_req_type *pReq = &mReq;
+
+    if (NULL == webReqQueue) {
+        return false;
+    }
+
+    #if UPLINK_COMPRESS
+    len = lz_frame_pack(pData, len, mPacked, &mLzWork);
+    pData = mPacked;
+    #endif
+
+    memset(&mReq, 0, sizeof(mReq));
+    memset(mRsp, 0, sizeof(mRsp));
+    mReq.http_ip_host = (char*) UPLINK_HOST;
+    mReq.http_get_request = (char*) UPLINK_PATH;
+    mReq.http_response = mRsp;
+    mReq.http_response_size = sizeof(mRsp);
+    mReq.http_post_data = pData;
+    mReq.http_post_size = len;
+    mReq.req_done_signal = mReqDone;
+
+    /* The wifiTask always gives the signal, and mReq is in use until then */
+    xSemaphoreTake(mReqDone, 0);
+    if (!xQueueSend(webReqQueue, &pReq, portMAX_DELAY) || !xSemaphoreTake(mReqDone, portMAX_DELAY)) {
+        return false;
+    }
+
+    /* The response starts with the status line, such as "HTTP/1.1 200 OK" */
+    return (mReq.success && 0 == strncmp(mRsp, "HTTP/", 5) && '2' == mRsp[9]);
+}
+
+bool uplinkTask::sendSpool(bool& empty)
+{
+    FIL file;
+    UINT bytesRead = 0;
+    bool success = true;
+
+    empty = true;
+    if (FR_OK != f_open(&file, UPLINK_SPOOL_FILENAME, FA_OPEN_EXISTING | FA_READ)) {
+        mSpoolOffset = 0;
+        return true;
+    }
+
+    for (uint8_t i = 0; success && i < UPLINK_SPOOL_PER_RUN && mSpoolOffset < f_size(&file); i++)
+    {
+        uint8_t frameLen[2] = { 0 };
+        uint16_t len = 0;
+
+        /* A batch that was not completely written is skipped */
+        if (FR_OK != f_lseek(&file, mSpoolOffset) ||
+            FR_OK != f_read(&file, frameLen, sizeof(frameLen), &bytesRead) || sizeof(frameLen) != bytesRead ||
+            (len = frameLen[0] | (frameLen[1] << 8)) > sizeof(mSend) ||
+            FR_OK != f_read(&file, mSend, len, &bytesRead) || len != bytesRead) {
+            mSpoolOffset = f_size(&file);
+            break;
+        }
+
+        if ((success = post(mSend, len))) {
+            mSpoolOffset += sizeof(frameLen) + len;
+        }
+    }
+
+    empty = (mSpoolOffset >= f_size(&file));
+    f_close(&file);
+
+    /* Every spooled batch is sent, so start a new file */
+    if (empty) {
+        f_unlink(UPLINK_SPOOL_FILENAME);
+        mSpoolOffset = 0;
+    }
+    return success;
+}
+
+bool uplinkTask::run(void *p)
+{
+    /* Collect the records; the samples are not added to the batch if there are none */
+    const uint16_t batchLen = mBatchLen, chunk = mChunk;
+    mSealed = false;
+    if (0 == tlm_sampler_stream(appendSamples, this) && !mSealed) {
+        mBatchLen = batchLen;
+        mChunk = chunk;
+    }
+    collectLog();
+
+    /* Keep collecting until the retry is due */
+    if (sys_get_uptime_ms() < mRetryAtMs) {
+        return true;
+    }
+
+    /* The spooled batches are older, so they are sent first */
+    bool spoolEmpty = true;
+    bool failed = !sendSpool(spoolEmpty);
+
+    if (mBatchLen > UPLINK_BATCH_HDR_BYTES) {
+        if (!failed && spoolEmpty) {
+            failed = !post(mBatch, mBatchLen);
+        }
+        if (failed || !spoolEmpty) {
+            spool(mBatch, mBatchLen);
+        }
+        startBatch();
+    }
+
+    if (!failed) {
+        mRetryMs = 0;
+        mRetryAtMs = 0;
+    }
+    else {
+        mRetryMs = (0 == mRetryMs) ? UPLINK_RETRY_MIN_MS : (2 * mRetryMs);
+        if (mRetryMs > UPLINK_RETRY_MAX_MS) {
+            mRetryMs = UPLINK_RETRY_MAX_MS;
+        }
+        mRetryAtMs = sys_get_uptime_ms() + mRetryMs;
+    }
+
+    return true;
+}
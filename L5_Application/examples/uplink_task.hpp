@@ -0,0 +1,128 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief Contains the uplink task that POSTs batches of telemetry and log records through the wifiTask
+ */
+#ifndef UPLINK_TASK_HPP_
+#define UPLINK_TASK_HPP_
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+#include "scheduler_task.hpp"
+#include "rn_xv_task.hpp"
+#include "lz_frame.h"
+
+
+
+#define UPLINK_HOST             "example.com"       ///< The host to POST the batches to
+#define UPLINK_PATH             "/uplink"           ///< The path on the host to POST the batches to
+#define UPLINK_PERIOD_MS        (10 * 1000)         ///< The records are collected and sent this often
+#define UPLINK_BATCH_BYTES      1024                ///< The max size of a batch, which is one POST
+#define UPLINK_RETRY_MIN_MS     (5 * 1000)          ///< The first retry delay after a failed POST
+#define UPLINK_RETRY_MAX_MS     (5 * 60 * 1000)     ///< The retry delay doubles up to this
+#define UPLINK_SPOOL_FILENAME   "1:uplink.bin"      ///< The batches that are not sent yet are spooled to this file
+#define UPLINK_SPOOL_MAX_BYTES  (1024 * 1024)       ///< The batches are dropped if the spool file would be larger
+#define UPLINK_SPOOL_PER_RUN    8                   ///< Max number of spooled batches sent each time
+#define UPLINK_COMPRESS         0                   ///< If non-zero, the body of each POST is the LZ frame of the batch
+
+
+
+/// The tags of the chunks of a batch
+enum {
+    uplink_tag_tlm_sampler = 1,     ///< The data of tlm_sampler_stream()
+    uplink_tag_log_bin     = 2,     ///< The records of the binary log, FILE_LOGGER_BIN_FILENAME
+};
+
+/**
+ * This task collects the samples of the telemetry sampler and the new records of the binary
+ * log, and POSTs them in batches of up to UPLINK_BATCH_BYTES through the web request queue of
+ * the wifiTask, instead of one request for each value.  The body of each POST is a batch:
+ * @code
+ *      'U' 'B' <seq:2> { <tag:1> <len:2> <len bytes> } ...
+ * @endcode
+ * The fields are little-endian and the seq increments with each batch.  The chunks of each tag,
+ * joined in the order of the batches, are the original stream: the tlm_sampler_stream() records
+ * or the logger_bin_header_t records (which are not split across the chunks).
+ * With UPLINK_COMPRESS, the body is instead the LZ frame of the batch (@see lz_frame.h), which
+ * starts with 'L' 'Z' and is decoded by any LZ4 block decoder.
+ *
+ * If a POST fails, such as while the board is offline, the batch is appended to the spool file
+ * on the SD card, and the POST is retried with an exponential backoff from UPLINK_RETRY_MIN_MS up to
+ * UPLINK_RETRY_MAX_MS.  The spooled batches are sent first once the host is reachable, so the
+ * batches arrive in order.  The file offsets of the log and of the spool are disk telemetry
+ * variables, so the records are sent at least once across a power cycle.
+ *
+ * @code
+ *      scheduler_add_task(new wifiTask(Uart3::getInstance(), PRIORITY_LOW));
+ *      scheduler_add_task(new uplinkTask(PRIORITY_LOW));
+ * @endcode
+ */
+class uplinkTask : public scheduler_task
+{
+    public:
+        uplinkTask(uint8_t priority);
+
+        bool init(void);        ///< Creates the signal of the web request
+        bool regTlm(void);      ///< Registers the file offsets as "disk" variables
+        bool run(void *p);      ///< Collects the records and sends the batches
+
+    private:
+        /// Appends the data to the batch, and spools the batch if it is full
+        void append(uint8_t tag, const void *pData, uint32_t len);
+        /// Callback of tlm_sampler_stream()
+        static void appendSamples(const void *pData, uint32_t len, void *pThis);
+
+        void collectLog(void);          ///< Appends the new records of the binary log
+        void startBatch(void);          ///< Empties the batch, and starts the next seq
+        bool spool(const uint8_t *pData, uint16_t len);      ///< Appends a batch to the spool file
+        bool post(const uint8_t *pData, uint16_t len);       ///< POSTs a batch, and returns true if the host accepted it
+        bool sendSpool(bool& empty);    ///< Sends the spooled batches
+
+        uint8_t mBatch[UPLINK_BATCH_BYTES];     ///< The batch being collected
+        uint16_t mBatchLen;                     ///< The bytes used in mBatch[]
+        uint16_t mChunk;                        ///< The offset of the last chunk in mBatch[], or 0 if none
+        uint16_t mSeq;                          ///< The seq of the batch being collected
+        bool mSealed;                           ///< Set when a full batch was spooled by append()
+
+        uint8_t mSend[UPLINK_BATCH_BYTES];      ///< The spooled batch being sent
+        web_req_type mReq;                      ///< The web request given to the wifiTask
+        char mRsp[16];                          ///< The start of the response to the POST
+#if UPLINK_COMPRESS
+        uint8_t mPacked[LZ_FRAME_MAX_BYTES(UPLINK_BATCH_BYTES)];  ///< The LZ frame of the batch being POSTed
+        lz_work_t mLzWork;                      ///< The table of the encoder
+#endif
+        SemaphoreHandle_t mReqDone;             ///< Given by the wifiTask when mReq is done
+
+        uint32_t mRetryMs;                      ///< The current retry delay, or 0 if the last POST succeeded
+        uint64_t mRetryAtMs;                    ///< The uptime of the next POST attempt
+
+        /** @{ Disk telemetry variables */
+        uint32_t mLogOffset;                    ///< The offset of the records of the binary log not yet collected
+        uint32_t mSpoolOffset;                  ///< The offset of the first spooled batch not yet sent
+        uint32_t mDroppedBatches;               ///< The batches that did not fit the spool file
+        /** @} */
+};
+
+
+
+#endif /* UPLINK_TASK_HPP_ */
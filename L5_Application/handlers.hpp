@@ -30,6 +30,9 @@
 /// Handler for task list & CPU Information
 CMD_HANDLER_FUNC(taskListHandler);
 
+/// Continuous CPU usage of the tasks
+CMD_HANDLER_FUNC(topHandler);
+
 /// Handler to list memory information
 CMD_HANDLER_FUNC(memInfoHandler);
 
@@ -105,4 +108,16 @@ CMD_HANDLER_FUNC(orientationCmd);
 /// Semaphore test command
 CMD_HANDLER_FUNC(semaphoreCmd);
 
+/// OS trace recorder command
+CMD_HANDLER_FUNC(traceHandler);
+
+/// Benchmarks of the I/O paths and the OS
+CMD_HANDLER_FUNC(benchHandler);
+
+/// Statistics of the PROFILE_SCOPE() sites and of the commands
+CMD_HANDLER_FUNC(profileHandler);
+
+/// The black box recorder of the raw pages of the SPI flash
+CMD_HANDLER_FUNC(blackboxHandler);
+
 #endif /* HANDLERS_HPP_ */
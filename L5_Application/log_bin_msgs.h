@@ -0,0 +1,53 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ *
+ * @file
+ * @brief Contains the messages of the binary log used in the project.
+ * @see   LOG_BIN_INFO() in file_logger.h
+ */
+#ifndef LOG_BIN_MSGS_H__
+#define LOG_BIN_MSGS_H__
+
+
+
+/**
+ * List of the binary log messages with their format string.
+ * You can add additional messages here, and use their ID with LOG_BIN_INFO() etc.
+ * The format string is only used by the "log decode" command, and each argument is
+ * a 32-bit word so only use the integer conversions such as %i, %u and %x.
+ *
+ * @warning Only add new messages at the end, otherwise existing log files cannot be decoded.
+ */
+#define LOG_BIN_MESSAGES(MSG)                                                       \
+    MSG(logbin_motion_adc_sample,   "ADC sample %i: %u, position=%u")               \
+    MSG(logbin_motion_scan_end,     "Scan ended at position: %u")                   \
+    MSG(logbin_motion_mppt_rescan,  "MPPT energy %u below %u, scanning again")      \
+
+/// Enumeration of the binary log message IDs
+enum {
+#define LOG_BIN_MSG_ID(id, fmt) id,
+    LOG_BIN_MESSAGES(LOG_BIN_MSG_ID)
+#undef LOG_BIN_MSG_ID
+    logbin_last,    ///< Marks the last entry, do not use
+};
+
+
+
+#endif /* LOG_BIN_MSGS_H__ */
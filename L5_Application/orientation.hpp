@@ -1,9 +1,6 @@
 #include "io.hpp"
-#include "queue.h"
-
-typedef enum {
-   shared_SensorQueueId,
-} sharedHandleId_t;
+#include "gpio.hpp"
+#include "event_bus.h"
 
 /// Orientation type enumeration
 typedef enum {
@@ -18,70 +15,61 @@ static char orientation_c[5][8] = {
         "invalid", "up", "down", "left", "right",
 };
 
-class orient_compute : public scheduler_task
-{
-    public:
-        orient_compute(uint8_t priority) : scheduler_task("compute", 2048, priority)
-        {
-            /* We save the queue handle by using addSharedObject() */
-            qid = xQueueCreate(1, sizeof(orientation_t));
-            addSharedObject(shared_SensorQueueId, qid);
-        }
-
-        bool run(void *p)
-        {
-            /* Compute orientation here, and send it to the queue once a second */
-            orientation_t orientation = invalid;
-            if (AS.getZ() > 1000)
-                orientation = up;
-            else if (AS.getZ() < -1000)
-                orientation = down;
-            else if (AS.getY() + AS.getY() < -1000)
-                orientation = left;
-            else if (AS.getY() + AS.getY() > 1000)
-                orientation = right;
-            if (orientation) {
-                printf("----------------------------------------\n");
-                printf("Task compute: Before sending orientation\n");
-                xQueueSend(qid, &orientation, portMAX_DELAY);
-                printf("Task compute: After sending orientation\n");
-            }
-            vTaskDelay(1000);
-            return true;
-        }
-    private:
-        QueueHandle_t qid;
-};
-
+/**
+ * The accelerometer interrupts only when the orientation changes (@see Acceleration_Sensor::startOrientation()),
+ * so this task sleeps until then, instead of a task that polls the axes and publishes the orientation.
+ * @code
+ *      scheduler_add_task(new orient_process(PRIORITY_LOW, 6));    // P2.6 is connected to INT2 of the sensor
+ * @endcode
+ */
 class orient_process : public scheduler_task
 {
     public:
-        orient_process (uint8_t priority) : scheduler_task("process", 2048, priority)
+        orient_process (uint8_t priority, uint8_t port2Pin) : scheduler_task("process", 2048, priority),
+            mPort2Pin(port2Pin)
         {
-            qid = getSharedObject(shared_SensorQueueId);
+            /* Each orientation change sets our event bit */
+            events = xEventGroupCreate();
+            event_bus_subscribe(&accel_orient_topic, events, orientation_bit);
             /* Initialize GPIO1[0] to control LED9 */
-            LPC_GPIO1->FIODIR |= BITS(0);
+            Led9::setAsOutput();
             /* Turn off LED initially */
-            LPC_GPIO1->FIOPIN |= BITS(0);
+            Led9::setHigh();
+        }
+
+        bool init(void)
+        {
+            return AS.startOrientation(mPort2Pin);
         }
 
         bool run(void *p)
         {
-            /* We first get the queue handle the other task added using addSharedObject() */
             orientation_t orientation = invalid;
+            accel_orient_event_t event;
 
-            /* Sleep the task forever until an item is available in the queue */
-            if (xQueueReceive(qid, &orientation, portMAX_DELAY))
+            /* Sleep the task forever until the orientation changes, and read the latest one */
+            if (event_bus_wait(events, orientation_bit, portMAX_DELAY))
             {
-                printf("Task process: received %s\n", orientation_c[orientation]);
-                if (orientation == left || orientation == right)
-                    LPC_GPIO1->FIOPIN &= MASK(0);
+                event_bus_read(&accel_orient_topic, &event);
+                if (event.back)
+                    orientation = down;
+                else if (accel_landscape_left == event.orientation)
+                    orientation = left;
+                else if (accel_landscape_right == event.orientation)
+                    orientation = right;
                 else
-                    LPC_GPIO1->FIOPIN |= BITS(0);
+                    orientation = up;
+
+                printf("Task process: received %s\n", orientation_c[orientation]);
+                /* The LED is on when the pin is low */
+                Led9::set(!(orientation == left || orientation == right));
             }
 
             return true;
         }
     private:
-        QueueHandle_t qid;
+        typedef GpioPin<1, 0> Led9; ///< P1.0 controls LED9
+        static const EventBits_t orientation_bit = (1 << 0);
+        EventGroupHandle_t events;
+        const uint8_t mPort2Pin;    ///< The pin of port 2 connected to INT2 of the accelerometer
 };
@@ -25,6 +25,8 @@
 #ifndef SHARED_HANDLES_H__
 #define SHARED_HANDLES_H__
 
+#include "channel.hpp"
+
 
 
 /**
@@ -32,10 +34,41 @@
  * You can add additional IDs here to use addSharedHandle() and getSharedHandle() API
  */
 enum {
-    shared_SensorQueue,    ///< Shared handle used by examples (producer and consumer tasks)
     shared_learnSemaphore, ///< Terminal command gives this semaphore to remoteTask (IR sensor task)
 };
 
+/**
+ * The channels shared by the tasks, which are resolved at link time (@see channel.hpp)
+ */
+CHANNEL_DECLARE(sensor_channel, int, 1);    ///< The acceleration of the examples (producer and consumer tasks)
+
+/// The requests of the 'learn' command to the remoteTask, other than learning the digits
+typedef enum {
+    remote_learn_bind,          ///< Binds the next button to the action
+    remote_learn_forget,        ///< Forgets the buttons of the action
+    remote_learn_forget_all,    ///< Forgets all the buttons
+    remote_learn_list,          ///< Prints the learned buttons
+} remote_learn_op_t;
+
+#define REMOTE_ACTION_MAX   0x0FFF  ///< The max action of remote_learn_bind
+
+/// A request of the 'learn' command to the remoteTask
+typedef struct {
+    uint8_t op;         ///< @see remote_learn_op_t
+    uint8_t repeat;     ///< Non-zero if the action of remote_learn_bind repeats while the button is held
+    uint16_t action;    ///< The action of remote_learn_bind and remote_learn_forget
+} remote_learn_t;
+
+CHANNEL_DECLARE(remote_learn_channel, remote_learn_t, 2);  ///< The 'learn' command to the remoteTask
+
+/// A button of an action other than the digits, sent by the remoteTask
+typedef struct {
+    uint16_t action;    ///< The action of the button, REMOTE_ACTION_DIGITS or more
+    uint8_t repeat;     ///< 0 for the press, then the repeat count while a button of a repeating action is held
+} remote_action_t;
+
+CHANNEL_DECLARE(remote_action_channel, remote_action_t, 4); ///< The remote buttons to the task of your project
+
 void power_wifi_init();
 
 #endif /* SHARED_HANDLES_H__ */
@@ -0,0 +1,822 @@
+#include <stdint.h>
+#include <stdio.h>              // snprintf()
+#include <stdlib.h>             // rand(), qsort()
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"               // uxTaskGetSystemState()
+#include "queue.h"
+#include "semphr.h"
+
+#include "command_handler.hpp"
+#include "lpc_sys.h"            // sys_get_cycles(), sys_cycles_to_ns()
+#include "sys_config.h"
+#include "uart1.hpp"
+#include "uart2.hpp"
+#include "uart3.hpp"
+#include "ssp1.h"
+#include "spi_sem.h"
+#include "i2c2.hpp"
+#include "can.h"
+#include "ff.h"
+#include "fat/disk/diskio.h"
+#include "wireless.h"
+#include "newlib_string.h"      // mem_copy()
+#include "crc.h"
+#include "lpc_dma.h"            // dma_memcpy()
+
+
+
+/**
+ * The latencies kept by each benchmark for the percentiles, the tasks looked at for the CPU usage,
+ * the size of the data buffer, and the bytes of each block of the sequential disk I/O.
+ */
+enum { benchMaxSamples = 256, benchMaxTasks = 16, benchBufferBytes = 4096, benchSeqBytes = 4096 };
+
+/// The measurements of one benchmark, which is reported as one line by benchEnd()
+typedef struct {
+    const char *name;           ///< The name of the benchmark, such as "sd.read.seq"
+    uint32_t ops;               ///< The operations done
+    uint32_t errors;            ///< The operations that failed
+    uint64_t bytes;             ///< The bytes moved by the successful operations
+    uint64_t startUs;           ///< The uptime at benchBegin()
+    uint32_t idleStart;         ///< The run time of the idle task at benchBegin()
+    uint32_t totalStart;        ///< The total run time at benchBegin()
+    uint32_t sampleCount;       ///< The latencies in samples[]
+    uint32_t samples[benchMaxSamples];  ///< The latencies in CPU cycles, a random subset if there are more ops
+} bench_t;
+
+/// The benchmark being measured, which is too large for the stack of the terminal
+static bench_t g_bench;
+
+/// The data moved by the benchmarks.  It is global since the GPDMA cannot access the stack memory.
+static uint8_t g_bench_buffer[benchBufferBytes] __attribute__((aligned(4)));
+
+/// The helper task of the context switch benchmark
+typedef struct {
+    SemaphoreHandle_t ping;     ///< Given by the benchmark, taken by the helper task
+    SemaphoreHandle_t pong;     ///< Given by the helper task, taken by the benchmark
+    volatile bool stop;         ///< The helper task exits at the next ping
+} benchPong_t;
+
+
+
+/// Gets the run time of the idle task and the total run time, and @returns the priority of the calling task
+static UBaseType_t benchGetRunTime(uint32_t &idle, uint32_t &total)
+{
+    TaskStatus_t status[benchMaxTasks];
+    const TaskHandle_t idleTask = xTaskGetIdleTaskHandle();
+    const UBaseType_t n = uxTaskGetSystemState(&status[0], benchMaxTasks, &total);
+    UBaseType_t priority = tskIDLE_PRIORITY;
+
+    idle = 0;
+    for (UBaseType_t i = 0; i < n; i++) {
+        if (idleTask == status[i].xHandle) {
+            idle = status[i].ulRunTimeCounter;
+        }
+        if (eRunning == status[i].eCurrentState) {
+            priority = status[i].uxCurrentPriority;
+        }
+    }
+    return priority;
+}
+
+static int benchCompare(const void *a, const void *b)
+{
+    const uint32_t x = *(const uint32_t*) a;
+    const uint32_t y = *(const uint32_t*) b;
+    return (x < y) ? -1 : (x > y) ? 1 : 0;
+}
+
+/// Prints the cycles as microseconds with a fraction, such as "   12.3"
+static void benchPrintUs(CharDev& output, uint32_t cycles)
+{
+    const uint32_t ns = (uint32_t) sys_cycles_to_ns(cycles);
+    output.printf(" %7u.%u", (unsigned) (ns / 1000), (unsigned) ((ns % 1000) / 100));
+}
+
+static void benchPrintHeader(CharDev& output)
+{
+    output.printf("Firmware built %s %s, CPU at %u MHz\n", __DATE__, __TIME__,
+                  (unsigned) (sys_get_cpu_clock() / (1000 * 1000)));
+    output.printf("%-16s %7s %6s %9s %9s %9s %9s %9s %4s\n",
+                  "Benchmark", "Ops", "Errors", "KB/s", "Ops/s", "p50 us", "p99 us", "Max us", "CPU%");
+}
+
+static void benchBegin(const char *name)
+{
+    bench_t *b = &g_bench;
+    memset(b, 0, sizeof(*b));
+    b->name = name;
+    benchGetRunTime(b->idleStart, b->totalStart);
+    b->startUs = sys_get_uptime_us();
+}
+
+/**
+ * Counts one operation of the benchmark
+ * @param start  The sys_get_cycles() at the start of the operation
+ * @param bytes  The bytes moved by the operation
+ * @param ok     False if the operation failed, which is counted as an error
+ */
+static void benchOp(uint32_t start, uint32_t bytes, bool ok)
+{
+    bench_t *b = &g_bench;
+    const uint32_t cycles = sys_get_cycles() - start;
+
+    b->ops++;
+    if (ok) {
+        b->bytes += bytes;
+    }
+    else {
+        b->errors++;
+    }
+
+    /* Keep a uniform random subset of the latencies if there are more ops than samples */
+    if (b->sampleCount < benchMaxSamples) {
+        b->samples[b->sampleCount++] = cycles;
+    }
+    else {
+        const uint32_t i = (uint32_t) rand() % b->ops;
+        if (i < benchMaxSamples) {
+            b->samples[i] = cycles;
+        }
+    }
+}
+
+/// Prints the line of the benchmark: the throughput, the latency percentiles, and the CPU usage
+static void benchEnd(CharDev& output)
+{
+    bench_t *b = &g_bench;
+    const uint64_t elapsedUs = sys_get_uptime_us() - b->startUs;
+    uint32_t idle = 0, total = 0;
+    benchGetRunTime(idle, total);
+
+    /* The CPU usage is the time not spent by the idle task */
+    const uint32_t totalUs = total - b->totalStart;
+    const uint32_t idleUs = idle - b->idleStart;
+    const uint32_t cpuPercent = (0 == totalUs || idleUs > totalUs) ? 0 : 100 - (uint32_t) ((100ULL * idleUs) / totalUs);
+
+    const uint32_t kbps = (0 == elapsedUs) ? 0 : (uint32_t) ((b->bytes * 1000000) / 1024 / elapsedUs);
+    const uint32_t opsps = (0 == elapsedUs) ? 0 : (uint32_t) ((b->ops * 1000000ULL) / elapsedUs);
+
+    qsort(b->samples, b->sampleCount, sizeof(b->samples[0]), benchCompare);
+    const uint32_t last = (b->sampleCount > 0) ? (b->sampleCount - 1) : 0;
+
+    output.printf("%-16s %7u %6u %9u %9u", b->name, (unsigned) b->ops, (unsigned) b->errors,
+                  (unsigned) kbps, (unsigned) opsps);
+    benchPrintUs(output, b->samples[(last * 50) / 100]);
+    benchPrintUs(output, b->samples[(last * 99) / 100]);
+    benchPrintUs(output, b->samples[last]);
+    output.printf(" %4u\n", (unsigned) cpuPercent);
+}
+
+/// @returns the FatFs drive of "flash" or "sd", or -1 if the name is neither
+static int benchGetDrive(const char *name)
+{
+    if (NULL == name || 0 == strcmp(name, "flash")) {
+        return 0;
+    }
+    return (0 == strcmp(name, "sd")) ? 1 : -1;
+}
+
+/// @returns the integer of the string, or the default value if there is no string
+static int benchGetInt(const char *s, int defaultValue)
+{
+    return (NULL == s) ? defaultValue : str::toInt(s);
+}
+
+
+
+/**
+ * Sends the data in blocks of 16 bytes, and receives them back through a wire from TX to RX.
+ * UART1 also needs a wire from RTS to CTS for its flow control.
+ */
+static void benchUart(CharDev& output, int port, uint32_t bytes, uint32_t baud)
+{
+    const uint32_t blockBytes = 16;
+    const unsigned int timeoutMs = 100;
+    UartDev &uart = (3 == port) ? (UartDev&) Uart3::getInstance() :
+                    (1 == port) ? (UartDev&) Uart1::getInstance() : (UartDev&) Uart2::getInstance();
+    char c = 0;
+
+    if (3 == port) {
+        Uart3::getInstance().init(baud, 64, 64);
+    }
+    else if (1 == port) {
+        Uart1::getInstance().init(baud, 64, 64);
+    }
+    else {
+        Uart2::getInstance().init(baud, 64, 64);
+    }
+    output.printf("Baud rate %u: actual %u, error %d ppm\n", (unsigned) baud,
+                  (unsigned) uart.getActualBaudRate(), (int) uart.getBaudErrorPpm());
+    while (uart.getChar(&c, 0)) {
+        ;
+    }
+
+    benchBegin((3 == port) ? "uart3.loopback" : "uart2.loopback");
+    for (uint32_t sent = 0; sent < bytes; sent += blockBytes)
+    {
+        const uint32_t start = sys_get_cycles();
+        bool ok = true;
+
+        for (uint32_t i = 0; ok && i < blockBytes; i++) {
+            ok = uart.putChar((char) (sent + i), OS_MS(timeoutMs));
+        }
+        for (uint32_t i = 0; ok && i < blockBytes; i++) {
+            ok = uart.getChar(&c, OS_MS(timeoutMs)) && (char) (sent + i) == c;
+        }
+        benchOp(start, blockBytes, ok);
+    }
+    benchEnd(output);
+}
+
+/**
+ * Sends the blocks over the SSP1 using the DMA and then by polling the FIFO.  The chip selects
+ * are not asserted, so the SD card and the flash ignore the data.
+ */
+static void benchSsp(CharDev& output, uint32_t blockBytes, uint32_t count)
+{
+    if (blockBytes > sizeof(g_bench_buffer)) {
+        blockBytes = sizeof(g_bench_buffer);
+    }
+    memset(g_bench_buffer, 0xFF, blockBytes);
+
+    spi1_lock();
+    {
+        benchBegin("ssp1.dma");
+        for (uint32_t i = 0; i < count; i++) {
+            const uint32_t start = sys_get_cycles();
+            benchOp(start, blockBytes, 0 == ssp1_dma_transfer_block(g_bench_buffer, blockBytes, 1));
+        }
+        benchEnd(output);
+
+        benchBegin("ssp1.pio");
+        for (uint32_t i = 0; i < count; i++) {
+            const uint32_t start = sys_get_cycles();
+            for (uint32_t j = 0; j < blockBytes; j++) {
+                ssp1_exchange_byte(g_bench_buffer[j]);
+            }
+            benchOp(start, blockBytes, true);
+        }
+        benchEnd(output);
+    }
+    spi1_unlock();
+}
+
+/**
+ * Reads the sectors of the disk in order and at random.  The writes are made to the sectors of
+ * a temporary file so the file system is not corrupted.
+ */
+static void benchDisk(CharDev& output, int drive, uint32_t sectors)
+{
+    const uint32_t seqSectors = benchSeqBytes / _MAX_SS;
+    const bool sd = (1 == drive);
+    char filename[] = "0:bench.bin";
+    DWORD diskSectors = 0;
+    FIL file;
+    UINT bytes = 0;
+
+    sectors = ((sectors + seqSectors - 1) / seqSectors) * seqSectors;
+    filename[0] = '0' + drive;
+    if (RES_OK != disk_ioctl(drive, GET_SECTOR_COUNT, &diskSectors) || 0 == diskSectors) {
+        output.printf("Cannot get the sector count of the %s\n", sd ? "SD card" : "flash");
+        return;
+    }
+
+    benchBegin(sd ? "sd.read.seq" : "flash.read.seq");
+    for (uint32_t s = 0; s < sectors; s += seqSectors) {
+        const uint32_t start = sys_get_cycles();
+        benchOp(start, benchSeqBytes, RES_OK == disk_read(drive, g_bench_buffer, s % diskSectors, seqSectors));
+    }
+    benchEnd(output);
+
+    benchBegin(sd ? "sd.read.rand" : "flash.read.rand");
+    for (uint32_t s = 0; s < sectors; s++) {
+        const uint32_t start = sys_get_cycles();
+        benchOp(start, _MAX_SS, RES_OK == disk_read(drive, g_bench_buffer, (uint32_t) rand() % diskSectors, 1));
+    }
+    benchEnd(output);
+
+    /* FatFs writes the whole sectors directly to the disk */
+    if (FR_OK != f_open(&file, filename, FA_CREATE_ALWAYS | FA_WRITE)) {
+        output.printf("Cannot create %s\n", filename);
+        return;
+    }
+    for (uint32_t i = 0; i < sizeof(g_bench_buffer); i++) {
+        g_bench_buffer[i] = (uint8_t) i;
+    }
+
+    benchBegin(sd ? "sd.write.seq" : "flash.write.seq");
+    for (uint32_t s = 0; s < sectors; s += seqSectors) {
+        const uint32_t start = sys_get_cycles();
+        benchOp(start, benchSeqBytes,
+                FR_OK == f_write(&file, g_bench_buffer, benchSeqBytes, &bytes) && benchSeqBytes == bytes);
+    }
+    const uint32_t syncStart = sys_get_cycles();
+    benchOp(syncStart, 0, FR_OK == f_sync(&file));
+    benchEnd(output);
+
+    benchBegin(sd ? "sd.write.rand" : "flash.write.rand");
+    for (uint32_t s = 0; s < sectors; s++) {
+        const uint32_t start = sys_get_cycles();
+        benchOp(start, _MAX_SS, FR_OK == f_lseek(&file, ((uint32_t) rand() % sectors) * _MAX_SS) &&
+                                FR_OK == f_write(&file, g_bench_buffer, _MAX_SS, &bytes) && _MAX_SS == bytes);
+    }
+    benchEnd(output);
+
+    f_close(&file);
+    f_unlink(filename);
+}
+
+/**
+ * Creates the small files, and appends the records to a file the way the loggers do, which
+ * opens, appends and closes the file for each record.
+ */
+static void benchFatFs(CharDev& output, int drive, uint32_t files)
+{
+    const UINT recordBytes = 64;
+    const bool sd = (1 == drive);
+    char dir[] = "0:bench";
+    char filename[24];
+    FIL file;
+    UINT bytes = 0;
+
+    dir[0] = '0' + drive;
+    memset(g_bench_buffer, 'x', recordBytes);
+    const FRESULT status = f_mkdir(dir);
+    if (FR_OK != status && FR_EXIST != status) {
+        output.printf("Cannot create %s\n", dir);
+        return;
+    }
+
+    benchBegin(sd ? "sd.fat.create" : "flash.fat.create");
+    for (uint32_t i = 0; i < files; i++) {
+        const uint32_t start = sys_get_cycles();
+        snprintf(filename, sizeof(filename), "%s/%u.txt", dir, (unsigned) i);
+        bool ok = (FR_OK == f_open(&file, filename, FA_CREATE_ALWAYS | FA_WRITE));
+        if (ok) {
+            ok = (FR_OK == f_write(&file, g_bench_buffer, recordBytes, &bytes) && recordBytes == bytes);
+            ok = (FR_OK == f_close(&file)) && ok;
+        }
+        benchOp(start, recordBytes, ok);
+    }
+    benchEnd(output);
+
+    snprintf(filename, sizeof(filename), "%s/log.txt", dir);
+    benchBegin(sd ? "sd.fat.append" : "flash.fat.append");
+    for (uint32_t i = 0; i < files; i++) {
+        const uint32_t start = sys_get_cycles();
+        bool ok = (FR_OK == f_open(&file, filename, FA_OPEN_ALWAYS | FA_WRITE));
+        if (ok) {
+            ok = (FR_OK == f_lseek(&file, f_size(&file)) &&
+                  FR_OK == f_write(&file, g_bench_buffer, recordBytes, &bytes) && recordBytes == bytes);
+            ok = (FR_OK == f_close(&file)) && ok;
+        }
+        benchOp(start, recordBytes, ok);
+    }
+    benchEnd(output);
+
+    f_unlink(filename);
+    for (uint32_t i = 0; i < files; i++) {
+        snprintf(filename, sizeof(filename), "%s/%u.txt", dir, (unsigned) i);
+        f_unlink(filename);
+    }
+    f_unlink(dir);
+}
+
+static void benchI2c(CharDev& output, uint8_t addr, uint8_t reg, uint32_t count)
+{
+    I2C2 &i2c = I2C2::getInstance();
+    uint8_t value = 0;
+
+    benchBegin("i2c2.read.reg");
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t start = sys_get_cycles();
+        benchOp(start, sizeof(value), i2c.readRegisters(addr, reg, &value, sizeof(value)));
+    }
+    benchEnd(output);
+}
+
+/**
+ * Sends the messages on CAN1 in the self-test mode, and receives each of them back.
+ * @note The RD/TD wires need a CAN transceiver, or a 1K resistor between them (@see CAN_set_self_test())
+ */
+static void benchCan(CharDev& output, uint32_t count)
+{
+    can_msg_t tx, rx;
+    memset(&tx, 0, sizeof(tx));
+    tx.frame_fields.data_len = 8;
+
+    if (!CAN_init(can1, 100, 4, 4, NULL, NULL)) {
+        output.putline("CAN init failed");
+        return;
+    }
+    CAN_bypass_filter_accept_all_msgs();
+    CAN_set_self_test(can1, true);
+
+    benchBegin("can1.selftest");
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t start = sys_get_cycles();
+        tx.msg_id = 0x100 + (i & 0xFF);
+        tx.data.qword = i;
+        benchOp(start, tx.frame_fields.data_len,
+                CAN_tx(can1, &tx, 10) && CAN_rx(can1, &rx, 10) && rx.msg_id == tx.msg_id && rx.data.qword == i);
+    }
+    benchEnd(output);
+
+    CAN_set_self_test(can1, false);
+}
+
+/**
+ * Pings the node, and then sends the data using the bulk transfer.  The other node should
+ * run 'bench mesh rx' to receive the bulk transfer.
+ */
+static void benchMesh(CharDev& output, uint8_t addr, uint32_t count)
+{
+    const uint8_t maxHops = 2;
+    const uint32_t blockBytes = 512;
+    mesh_packet_t pkt;
+
+    while (wireless_get_ack_pkt(&pkt, 0)) {
+        ;
+    }
+
+    benchBegin("mesh.ping");
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t start = sys_get_cycles();
+        benchOp(start, 0, wireless_send(addr, mesh_pkt_ack, NULL, 0, maxHops) &&
+                          wireless_get_ack_pkt(&pkt, 1000) && addr == pkt.nwk.src);
+    }
+    benchEnd(output);
+
+    if (!wireless_bulk_open(addr, maxHops)) {
+        output.printf("Node %u did not respond to the bulk transfer\n", addr);
+        return;
+    }
+    memset(g_bench_buffer, 0xA5, blockBytes);
+
+    benchBegin("mesh.bulk.tx");
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t start = sys_get_cycles();
+        benchOp(start, blockBytes, wireless_bulk_send(g_bench_buffer, blockBytes));
+    }
+    benchEnd(output);
+}
+
+/// Receives the bulk transfer of 'bench mesh <addr>' until there is no data for the timeout
+static void benchMeshRx(CharDev& output, uint32_t timeoutMs)
+{
+    bool started = false;
+
+    output.printf("Waiting %u ms for the bulk transfer\n", (unsigned) timeoutMs);
+    benchBegin("mesh.bulk.rx");
+    for (;;) {
+        const uint32_t start = sys_get_cycles();
+        const uint32_t bytes = wireless_bulk_recv(g_bench_buffer, sizeof(g_bench_buffer), timeoutMs);
+        if (0 == bytes) {
+            break;
+        }
+        /* The throughput starts with the first data */
+        if (!started) {
+            benchBegin("mesh.bulk.rx");
+            started = true;
+        }
+        benchOp(start, bytes, true);
+    }
+    benchEnd(output);
+}
+
+/**
+ * Measures the inline copies of mem_copy(), memcpy(), memset() and memcmp() of newlib_string.c,
+ * the dma_memcpy() of lpc_dma.h, and the CRCs of crc.h.
+ * Each op of the small copies is benchMemCopies copies to the different offsets of the buffer.
+ */
+static void benchMem(CharDev& output, uint32_t count)
+{
+    enum { benchMemCopies = 16, benchMemHalf = benchBufferBytes / 2 };
+    uint8_t *dst = &g_bench_buffer[0];
+    const uint8_t *src = &g_bench_buffer[benchMemHalf];
+
+    benchBegin("mem.inline 8");
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t start = sys_get_cycles();
+        for (uint32_t j = 0; j < benchMemCopies; j++) {
+            mem_copy(&dst[j * 32], &src[j * 32], 8);
+        }
+        benchOp(start, benchMemCopies * 8, true);
+    }
+    benchEnd(output);
+
+    benchBegin("mem.inline 16");
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t start = sys_get_cycles();
+        for (uint32_t j = 0; j < benchMemCopies; j++) {
+            mem_copy(&dst[j * 32], &src[j * 32], 16);
+        }
+        benchOp(start, benchMemCopies * 16, true);
+    }
+    benchEnd(output);
+
+    benchBegin("mem.inline 32");
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t start = sys_get_cycles();
+        for (uint32_t j = 0; j < benchMemCopies; j++) {
+            mem_copy(&dst[j * 32], &src[j * 32], 32);
+        }
+        benchOp(start, benchMemCopies * 32, true);
+    }
+    benchEnd(output);
+
+    /* The sizes are volatile so the calls are not inlined by the compiler */
+    static const char * const names[] = { "mem.copy 8", "mem.copy 16", "mem.copy 32", "mem.copy 512", "mem.copy 2k" };
+    static volatile uint32_t sizes[] = { 8, 16, 32, 512, benchMemHalf };
+    for (uint32_t s = 0; s < sizeof(names) / sizeof(names[0]); s++) {
+        const uint32_t bytes = sizes[s];
+        benchBegin(names[s]);
+        for (uint32_t i = 0; i < count; i++) {
+            const uint32_t start = sys_get_cycles();
+            memcpy(dst, src, bytes);
+            benchOp(start, bytes, true);
+        }
+        benchEnd(output);
+    }
+
+    const volatile uint32_t bytes = benchMemHalf - 1;
+    benchBegin("mem.copy 2k unal");
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t start = sys_get_cycles();
+        memcpy(dst, src + 1, bytes);
+        benchOp(start, bytes, true);
+    }
+    benchEnd(output);
+
+    /* The buffer is a global, so the DMA can access it */
+    benchBegin("mem.dma 2k");
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t start = sys_get_cycles();
+        dma_memcpy(dst, src, benchMemHalf);
+        benchOp(start, benchMemHalf, true);
+    }
+    benchEnd(output);
+
+    benchBegin("mem.set 2k");
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t start = sys_get_cycles();
+        memset(dst, (int) i, benchMemHalf);
+        benchOp(start, benchMemHalf, true);
+    }
+    benchEnd(output);
+
+    /* The halves are equal, so the whole 2k is compared */
+    memcpy(dst, src, benchMemHalf);
+    benchBegin("mem.cmp 2k");
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t start = sys_get_cycles();
+        benchOp(start, benchMemHalf, 0 == memcmp(dst, src, benchMemHalf));
+    }
+    benchEnd(output);
+
+    /* The result is volatile so the CRC is not optimized away */
+    volatile uint32_t crc = 0;
+    benchBegin("mem.crc32 2k");
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t start = sys_get_cycles();
+        crc = crc32_update(0, src, benchMemHalf);
+        benchOp(start, benchMemHalf, true);
+    }
+    benchEnd(output);
+
+    benchBegin("mem.crc16 2k");
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t start = sys_get_cycles();
+        crc = crc16_update(CRC16_INIT, src, benchMemHalf);
+        benchOp(start, benchMemHalf, true);
+    }
+    benchEnd(output);
+    (void) crc;
+}
+
+/// The other task of the context switch benchmark, which answers each ping with a pong
+static void benchPongTask(void *p)
+{
+    benchPong_t *pong = (benchPong_t*) p;
+
+    while (xSemaphoreTake(pong->ping, portMAX_DELAY) && !pong->stop) {
+        xSemaphoreGive(pong->pong);
+    }
+    xSemaphoreGive(pong->pong);
+    vTaskDelete(NULL);
+}
+
+/**
+ * Measures the queue send and receive, semaphore give and take, mutex take and give without
+ * blocking, and the round trip to a higher priority task which is two context switches.
+ */
+static void benchOs(CharDev& output, uint32_t count)
+{
+    uint32_t idle = 0, total = 0;
+    const UBaseType_t priority = benchGetRunTime(idle, total);
+    QueueHandle_t queue = xQueueCreate(1, sizeof(uint32_t));
+    SemaphoreHandle_t sem = xSemaphoreCreateBinary();
+    SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+    benchPong_t pong = { xSemaphoreCreateBinary(), xSemaphoreCreateBinary(), false };
+    uint32_t value = 0;
+
+    if (NULL == queue || NULL == sem || NULL == mutex || NULL == pong.ping || NULL == pong.pong) {
+        output.putline("Out of memory");
+    }
+    else {
+        benchBegin("os.queue");
+        for (uint32_t i = 0; i < count; i++) {
+            const uint32_t start = sys_get_cycles();
+            benchOp(start, sizeof(value), xQueueSend(queue, &i, 0) && xQueueReceive(queue, &value, 0) && i == value);
+        }
+        benchEnd(output);
+
+        benchBegin("os.semaphore");
+        for (uint32_t i = 0; i < count; i++) {
+            const uint32_t start = sys_get_cycles();
+            benchOp(start, 0, xSemaphoreGive(sem) && xSemaphoreTake(sem, 0));
+        }
+        benchEnd(output);
+
+        benchBegin("os.mutex");
+        for (uint32_t i = 0; i < count; i++) {
+            const uint32_t start = sys_get_cycles();
+            benchOp(start, 0, xSemaphoreTake(mutex, 0) && xSemaphoreGive(mutex));
+        }
+        benchEnd(output);
+
+        const UBaseType_t pongPriority = (priority + 1 < configMAX_PRIORITIES) ? (priority + 1) : priority;
+        if (!xTaskCreate(benchPongTask, "pong", 256, &pong, pongPriority, NULL)) {
+            output.putline("Cannot create the pong task");
+        }
+        else {
+            benchBegin("os.switch");
+            for (uint32_t i = 0; i < count; i++) {
+                const uint32_t start = sys_get_cycles();
+                benchOp(start, 0, xSemaphoreGive(pong.ping) && xSemaphoreTake(pong.pong, 100));
+            }
+            benchEnd(output);
+
+            /* Wait for the pong task to exit before its semaphores are deleted */
+            pong.stop = true;
+            xSemaphoreGive(pong.ping);
+            xSemaphoreTake(pong.pong, portMAX_DELAY);
+            vTaskDelay(1);
+        }
+    }
+
+    if (queue)     vQueueDelete(queue);
+    if (sem)       vSemaphoreDelete(sem);
+    if (mutex)     vSemaphoreDelete(mutex);
+    if (pong.ping) vSemaphoreDelete(pong.ping);
+    if (pong.pong) vSemaphoreDelete(pong.pong);
+}
+
+
+
+static CMD_HANDLER_FUNC(benchUartHandler)
+{
+    char *port = NULL, *bytes = NULL, *baud = NULL;
+    cmdParams.tokenize(" ", 3, &port, &bytes, &baud);
+
+    const int portNum = benchGetInt(port, 2);
+    if (1 != portNum && 2 != portNum && 3 != portNum) {
+        return false;
+    }
+    benchPrintHeader(output);
+    benchUart(output, portNum, benchGetInt(bytes, 4096), benchGetInt(baud, 115200));
+    return true;
+}
+
+static CMD_HANDLER_FUNC(benchSspHandler)
+{
+    char *bytes = NULL, *count = NULL;
+    cmdParams.tokenize(" ", 2, &bytes, &count);
+
+    benchPrintHeader(output);
+    benchSsp(output, benchGetInt(bytes, 512), benchGetInt(count, 200));
+    return true;
+}
+
+static CMD_HANDLER_FUNC(benchDiskHandler)
+{
+    char *disk = NULL, *sectors = NULL;
+    cmdParams.tokenize(" ", 2, &disk, &sectors);
+
+    const int drive = benchGetDrive(disk);
+    if (drive < 0) {
+        return false;
+    }
+    benchPrintHeader(output);
+    benchDisk(output, drive, benchGetInt(sectors, 256));
+    return true;
+}
+
+static CMD_HANDLER_FUNC(benchFatFsHandler)
+{
+    char *disk = NULL, *files = NULL;
+    cmdParams.tokenize(" ", 2, &disk, &files);
+
+    const int drive = benchGetDrive(disk);
+    if (drive < 0) {
+        return false;
+    }
+    benchPrintHeader(output);
+    benchFatFs(output, drive, benchGetInt(files, 20));
+    return true;
+}
+
+static CMD_HANDLER_FUNC(benchI2cHandler)
+{
+    char *addr = NULL, *reg = NULL, *count = NULL;
+    cmdParams.tokenize(" ", 3, &addr, &reg, &count);
+
+    benchPrintHeader(output);
+    benchI2c(output, benchGetInt(addr, I2CAddr_AccelerationSensor), benchGetInt(reg, 0x0D), benchGetInt(count, 1000));
+    return true;
+}
+
+static CMD_HANDLER_FUNC(benchCanHandler)
+{
+    benchPrintHeader(output);
+    benchCan(output, benchGetInt(cmdParams.getLen() ? cmdParams() : NULL, 500));
+    return true;
+}
+
+static CMD_HANDLER_FUNC(benchMeshHandler)
+{
+    char *addr = NULL, *count = NULL;
+    cmdParams.tokenize(" ", 2, &addr, &count);
+
+    if (NULL == addr) {
+        return false;
+    }
+    benchPrintHeader(output);
+    if (0 == strcmp(addr, "rx")) {
+        benchMeshRx(output, benchGetInt(count, 10) * 1000);
+    }
+    else {
+        benchMesh(output, benchGetInt(addr, 0), benchGetInt(count, 32));
+    }
+    return true;
+}
+
+static CMD_HANDLER_FUNC(benchMemHandler)
+{
+    benchPrintHeader(output);
+    benchMem(output, benchGetInt(cmdParams.getLen() ? cmdParams() : NULL, 1000));
+    return true;
+}
+
+static CMD_HANDLER_FUNC(benchOsHandler)
+{
+    benchPrintHeader(output);
+    benchOs(output, benchGetInt(cmdParams.getLen() ? cmdParams() : NULL, 1000));
+    return true;
+}
+
+/// Runs the benchmarks that do not need any wiring or another board
+static CMD_HANDLER_FUNC(benchAllHandler)
+{
+    benchPrintHeader(output);
+    benchOs(output, 1000);
+    benchMem(output, 1000);
+    benchSsp(output, 512, 200);
+    for (int drive = 0; drive <= 1; drive++) {
+        benchDisk(output, drive, 256);
+        benchFatFs(output, drive, 20);
+    }
+    benchI2c(output, I2CAddr_AccelerationSensor, 0x0D, 1000);
+    return true;
+}
+
+CMD_DEFINE_HANDLER(bench, benchAllHandler,   "all",   "'all' : Run os, mem, ssp, disk, fatfs and i2c with the default parameters");
+CMD_DEFINE_HANDLER(bench, benchUartHandler,  "uart",  "'uart <1|2|3> [bytes] [baud]' : Loopback with the TX wired to the RX (and RTS to CTS on UART1)");
+CMD_DEFINE_HANDLER(bench, benchSspHandler,   "ssp",   "'ssp [bytes] [count]' : SSP1 transfers using the DMA and polling");
+CMD_DEFINE_HANDLER(bench, benchDiskHandler,  "disk",  "'disk <flash|sd> [sectors]' : Sequential and random sector reads and writes");
+CMD_DEFINE_HANDLER(bench, benchFatFsHandler, "fatfs", "'fatfs <flash|sd> [files]' : File create, and open-append-close");
+CMD_DEFINE_HANDLER(bench, benchI2cHandler,   "i2c",   "'i2c [addr] [reg] [count]' : Register reads, the accelerometer by default");
+CMD_DEFINE_HANDLER(bench, benchCanHandler,   "can",   "'can [count]' : CAN1 messages in the self-test mode");
+CMD_DEFINE_HANDLER(bench, benchMeshHandler,  "mesh",  "'mesh <addr> [count]' : Ping and bulk transfer, 'mesh rx [seconds]' on the other node");
+CMD_DEFINE_HANDLER(bench, benchOsHandler,    "os",    "'os [count]' : Queue, semaphore, mutex and context switch");
+CMD_DEFINE_HANDLER(bench, benchMemHandler,   "mem",   "'mem [count]' : Inline copies, memcpy(), memset(), memcmp() and the CRCs");
+
+CMD_HANDLER_FUNC(benchHandler)
+{
+    static CommandProcessor *pCmdProcessor = NULL;
+    if (NULL == pCmdProcessor)
+    {
+        pCmdProcessor = new CommandProcessor(0);
+        pCmdProcessor->addTable("bench");
+    }
+
+    /* Display help for empty command */
+    if (cmdParams == "") {
+        cmdParams = "help";
+    }
+
+    return pCmdProcessor->handleCommand(cmdParams, output);
+}
@@ -19,6 +19,7 @@
 #include <stdio.h>              // printf()
 #include <string.h>
 #include <time.h>
+#include <unistd.h>             // STDOUT_FILENO
 
 #include "FreeRTOS.h"
 #include "task.h"               // uxTaskGetSystemState()
@@ -29,32 +30,95 @@
 #include "rtc.h"                // Set and Get System Time
 #include "sys_config.h"         // TERMINAL_END_CHARS
 #include "lpc_sys.h"
+#include "os_latency.h"         // Interrupt latency statistics
+#include "os_lock_stats.h"      // Lock contention statistics
+#include "profile.h"
+#include "workqueue.h"
+#include "cmd_args.hpp"         // Parameters of the commands without allocations
 
 #include "utilities.h"          // printMemoryInfo()
 #include "storage.hpp"          // Get Storage Device instances
 #include "fat/disk/spi_flash.h"
 #include "spi_sem.h"
 #include "file_logger.h"
+#include "log_bin_msgs.h"
+#include "crash_snapshot.h"
+#include "blackbox.h"
+#include "lz_frame.h"
 
 #include "uart0.hpp"
 #include "wireless.h"
 #include "nrf_stream.hpp"
 
 #include "io.hpp"
+#include "gpio.hpp"
+#include "sensor_hub.hpp"
+#include "fixed_point.h"
 #include "shared_handles.h"
 #include "scheduler_task.hpp"
 
 #include "c_tlm_stream.h"
 #include "c_tlm_var.h"
+#include "c_tlm_binary.h"
+#include "c_tlm_sampler.h"
+#include "c_tlm_subscribe.h"
 
 
 
+#if (1 == configUSE_TRACE_FACILITY && 1 == configRECORD_STACK_HIGH_ADDRESS)
+/// Prints the stack size and the most stack each task has used, so the stack sizes can be tuned
+static void printStackInfo(CharDev &output, const TaskStatus_t *status, unsigned count)
+{
+    uint32_t totalSize = 0;
+    uint32_t totalFree = 0;
+
+    output.printf("%10s  Size  Used  Free Used%%\n", "Name");
+    for (unsigned i = 0; i < count; i++) {
+        const uint32_t size = 4 * uxTaskGetStackSize(status[i].xHandle);
+        const uint32_t free = 4 * status[i].usStackHighWaterMark;
+        const uint32_t used = (size > free) ? (size - free) : 0;
+        totalSize += size;
+        totalFree += free;
+        output.printf("%10s %5u %5u %5u %4u%%\n", status[i].pcTaskName,
+                      (unsigned) size, (unsigned) used, (unsigned) free, (unsigned) (size ? (used * 100) / size : 0));
+    }
+    output.printf("%10s %5u %5u %5u\n", "(total)", (unsigned) totalSize, (unsigned) (totalSize - totalFree),
+                  (unsigned) totalFree);
+#if (1 == configUSE_STACK_GUARD)
+    output.printf("The free stack includes up to %u bytes of the overflow guard, which cannot be used\n",
+                  (unsigned) (2 * portSTACK_GUARD_BYTES));
+#endif
+}
+#endif
+
 CMD_HANDLER_FUNC(taskListHandler)
 {
 #if (1 == configUSE_TRACE_FACILITY)
     const int delayInMs = (int)cmdParams;  // cast parameter str to integer
 
+    // Limit the tasks to avoid heap allocation.
+    const unsigned portBASE_TYPE maxTasks = 16;
+    TaskStatus_t status[maxTasks];
+    uint32_t totalRunTime = 0;
+    uint32_t tasksRunTime = 0;
+
+#if (1 == configRECORD_STACK_HIGH_ADDRESS)
+    if (cmdParams == "stacks") {
+        printStackInfo(output, status, uxTaskGetSystemState(&status[0], maxTasks, NULL));
+        return true;
+    }
+#endif
+
     if(delayInMs > 0) {
+        /* Reset the run loop profile of the scheduler tasks too */
+        const unsigned portBASE_TYPE n = uxTaskGetSystemState(&status[0], maxTasks, &totalRunTime);
+        for (unsigned i = 0; i < n; i++) {
+            scheduler_task *task = scheduler_task::getTaskPtrByName(status[i].pcTaskName);
+            if (task) {
+                task->resetProfile();
+            }
+        }
+
         vTaskResetRunTimeStats();
         vTaskDelayMs(delayInMs);
     }
@@ -62,11 +126,6 @@ CMD_HANDLER_FUNC(taskListHandler)
     // Enum to char : eRunning, eReady, eBlocked, eSuspended, eDeleted
     const char * const taskStatusTbl[] = { "RUN", "RDY", "BLK", "SUS", "DEL" };
 
-    // Limit the tasks to avoid heap allocation.
-    const unsigned portBASE_TYPE maxTasks = 16;
-    TaskStatus_t status[maxTasks];
-    uint32_t totalRunTime = 0;
-    uint32_t tasksRunTime = 0;
     const unsigned portBASE_TYPE uxArraySize =
             uxTaskGetSystemState(&status[0], maxTasks, &totalRunTime);
 
@@ -98,6 +157,22 @@ CMD_HANDLER_FUNC(taskListHandler)
     output.printf("%10s --- -- ----- %4u %10u uS\n",
                   "(overhead)", overheadPercent, overheadUs);
 
+    /* Print the run loop profile of the scheduler tasks */
+    output.printf("\n%10s  Run max(us) Jitter(us) Blocked(ms)  Misses Late(us) Streak   <10us  <100us    <1ms   <10ms  <100ms   more\n", "Name");
+    for (unsigned i = 0; i < uxArraySize; i++) {
+        const scheduler_task *task = scheduler_task::getTaskPtrByName(status[i].pcTaskName);
+        if (task) {
+            const scheduler_profile_t &p = task->getProfile();
+            output.printf("%10s %12u %10u %11u %7u %8u %6u", task->getTaskName(),
+                          (unsigned) p.runMaxUs, (unsigned) p.jitterMaxUs, (unsigned) (p.blockedUs / 1000),
+                          (unsigned) p.deadlineMisses, (unsigned) p.latenessMaxUs, (unsigned) p.missStreakMax);
+            for (unsigned b = 0; b < SCHEDULER_PROFILE_HIST_BUCKETS; b++) {
+                output.printf(" %7u", (unsigned) p.runHist[b]);
+            }
+            output.putline("");
+        }
+    }
+
     if (uxTaskGetNumberOfTasks() > maxTasks) {
         output.printf("** WARNING: Only reported first %u tasks\n", maxTasks);
     }
@@ -108,6 +183,64 @@ CMD_HANDLER_FUNC(taskListHandler)
     return true;
 }
 
+/// Prints the CPU accounting of the tasks, sorted by the 10 second average
+static void printCpuAccounting(CharDev& output)
+{
+    /* The tasks are copied so they do not change while being printed */
+    const scheduler_cpu_t &cpu = scheduler_get_cpu();
+    scheduler_cpu_task_t tasks[SCHEDULER_CPU_MAX_TASKS];
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < SCHEDULER_CPU_MAX_TASKS; i++) {
+        if (0 != cpu.tasks[i].number) {
+            uint32_t j = count++;
+            for (; j > 0 && tasks[j - 1].cpu[scheduler_cpu_10s] < cpu.tasks[i].cpu[scheduler_cpu_10s]; j--) {
+                tasks[j] = tasks[j - 1];
+            }
+            tasks[j] = cpu.tasks[i];
+        }
+    }
+
+    /* The history is printed as a bar of the deciles, oldest first */
+    const char bar[] = " .:-=+*#%@@";
+    char history[SCHEDULER_CPU_HISTORY + 1];
+    for (uint32_t i = 0; i < SCHEDULER_CPU_HISTORY; i++) {
+        history[i] = bar[cpu.history[(cpu.historyPos + i) % SCHEDULER_CPU_HISTORY] / 10];
+    }
+    history[SCHEDULER_CPU_HISTORY] = '\0';
+
+    const uint16_t *sys = cpu.sysCpu;
+    output.printf("CPU %3u.%02u%% %3u.%02u%% %3u.%02u%% (1s 10s 60s)\033[K\n"
+                  "   [%s]\033[K\n\033[K\n",
+                  sys[0] / 100, sys[0] % 100, sys[1] / 100, sys[1] % 100, sys[2] / 100, sys[2] % 100, history);
+    output.printf("%10s     1s%%    10s%%    60s%%\033[K\n", "Name");
+    for (uint32_t i = 0; i < count; i++) {
+        const uint16_t *c = tasks[i].cpu;
+        output.printf("%10s %3u.%02u %3u.%02u %3u.%02u\033[K\n", tasks[i].name,
+                      c[0] / 100, c[0] % 100, c[1] / 100, c[1] % 100, c[2] / 100, c[2] % 100);
+    }
+}
+
+CMD_HANDLER_FUNC(topHandler)
+{
+    if (cmdParams == "once") {
+        printCpuAccounting(output);
+        return true;
+    }
+
+    /* Refresh in place each sample until a key is pressed */
+    char c = 0;
+    output.put("\033[2J");
+    do {
+        output.put("\033[H");
+        printCpuAccounting(output);
+        output.put("\033[J(press a key to stop)");
+        output.flush();
+    } while (!output.getChar(&c, OS_MS(SCHEDULER_CPU_SAMPLE_MS)));
+
+    output.putline("");
+    return true;
+}
+
 CMD_HANDLER_FUNC(memInfoHandler)
 {
 #if 0 /* This was for memory test */
@@ -121,9 +254,54 @@ CMD_HANDLER_FUNC(memInfoHandler)
     char buffer[512];
     sys_get_mem_info_str(buffer);
     output.putline(buffer);
+
+    if (cmdParams == "detail") {
+#if (6 == configMEM_MANG_TYPE)
+        size_t bins[portHEAP_FREE_BLOCK_BINS];
+        const size_t largest = xPortGetFreeBlockHistogram(bins);
+        const size_t avail = xPortGetFreeHeapSize();
+
+        output.printf("Heap: %u total, %u free, %u min free, largest free block %u (%u%% fragmented)\n",
+                      xPortGetTotalHeapSize(), avail, xPortGetMinimumEverFreeHeapSize(),
+                      largest, avail ? (100 - (100 * largest / avail)) : 0);
+        output.printf("Free blocks:");
+        for (size_t i = 0; i < portHEAP_FREE_BLOCK_BINS - 1; i++) {
+            output.printf(" <%u:%u", portHEAP_FREE_BLOCK_BIN_MIN << i, bins[i]);
+        }
+        output.printf(" more:%u\n", bins[portHEAP_FREE_BLOCK_BINS - 1]);
+
+        size_t size = 0, n_free = 0, min_free = 0;
+        for (UBaseType_t pool = 0; 0 != (size = xPortGetPoolInfo(pool, &n_free, &min_free)); pool++) {
+            output.printf("Pool %3u bytes: %3u free, %3u min free\n", size, n_free, min_free);
+        }
+
+    #if (1 == configMEM_PROFILE)
+        HeapSiteStats_t sites[configMEM_PROFILE_SITES];
+        size_t live = 0, peak = 0;
+        const UBaseType_t n = uxPortGetHeapProfile(sites, configMEM_PROFILE_SITES, &live, &peak);
+
+        output.printf("Allocated: %u bytes, peak %u bytes\n", live, peak);
+        output.printf("%10s %8s %8s %8s %8s\n", "Caller", "Allocs", "Frees", "Live", "Peak");
+        for (UBaseType_t i = 0; i < n; i++) {
+            output.printf("%10p %8u %8u %8u %8u\n", sites[i].pvSite, (unsigned) sites[i].ulAllocs,
+                          (unsigned) sites[i].ulFrees, sites[i].xLiveBytes, sites[i].xPeakBytes);
+        }
+    #else
+        output.putline("Set configMEM_PROFILE to 1 to count the memory of each caller");
+    #endif
+#else
+        output.putline("The detail needs the memory scheme 6 (configMEM_MANG_TYPE)");
+#endif
+    }
     return true;
 }
 
+/// @returns the CPU cycles in tenths of microseconds
+static unsigned cyclesToUsX10(uint32_t cycles)
+{
+    return (unsigned) (sys_cycles_to_ns(cycles) / 100);
+}
+
 CMD_HANDLER_FUNC(healthHandler)
 {
     Uart0 &u0 = Uart0::getInstance();
@@ -132,9 +310,11 @@ CMD_HANDLER_FUNC(healthHandler)
     unsigned int available = 0;
     Storage::getFlashDrive().getDriveInfo(&total, &available);
 
-    float floatTemp = TS.getFarenheit();
-    int floatSig1 = (int) floatTemp;
-    int floatDec1 = ((floatTemp - floatSig1) * 10);
+    /* The cached readings of the sensor hub are used if it is running */
+    sensor_temp_t temp;
+    sensor_light_t light;
+    const int32_t tempFx100 = sensor_hub_get_temp(temp) ? (fixed_scale(temp.celsius_x100, 9, 5) + 3200) : TS.getFarenheitX100();
+    const uint16_t lightRaw = sensor_hub_get_light(light) ? light.raw : LS.getRawValue();
     rtc_t bt = sys_get_boot_time();
 
     unsigned int highestWrCnt = 0;
@@ -163,23 +343,150 @@ CMD_HANDLER_FUNC(healthHandler)
         output.printf("Flash: %u/%u\n", available, total);
     }
 
-    output.printf( "Temp : %u.%u\n"
+    output.printf( "Temp : %s%li.%02lu\n"
                    "Light: %u\n"
                    "Time : %s"
                    "Boot Time: %02u/%02u/%4u,%02u:%02u:%02u\n"
                    "Uart0 Watermarks: %u/%u (rx/tx)\n",
-                    floatSig1, floatDec1,
-                    LS.getRawValue(),
+                    FIXED_X100_PRINT(tempFx100),
+                    lightRaw,
                     rtc_get_date_time_str(),
                     bt.month, bt.day, bt.year, bt.hour, bt.min, bt.sec,
                     u0.getRxQueueWatermark(), u0.getTxQueueWatermark()
     );
 
+    const sys_out_stats_t out = sys_get_out_stats(STDOUT_FILENO);
+    const sys_out_stats_t err = sys_get_out_stats(STDERR_FILENO);
+    output.printf("stdout: %u bytes, %u dropped, %u unbuffered\n"
+                  "stderr: %u bytes, %u dropped, %u unbuffered\n",
+                  (unsigned) out.bytes_written, (unsigned) out.bytes_dropped, (unsigned) out.unbuffered,
+                  (unsigned) err.bytes_written, (unsigned) err.bytes_dropped, (unsigned) err.unbuffered);
+
+    /* The snapshot is too large for the stack of the terminal task */
+    static crash_snapshot_t crash;
+    if (crash_snapshot_get(&crash)) {
+        output.printf("Last crash: '%.*s' at %u ms, PC: 0x%08X LR: 0x%08X PSR: 0x%08X SP: 0x%08X\n"
+                      "            CFSR: 0x%08X HFSR: 0x%08X MMFAR: 0x%08X BFAR: 0x%08X\n"
+                      "            %u stack words, %u trace records\n",
+                      (int) sizeof(crash.task), crash.task, (unsigned) crash.uptime_ms,
+                      (unsigned) crash.frame[crash_frame_pc], (unsigned) crash.frame[crash_frame_lr],
+                      (unsigned) crash.frame[crash_frame_psr], (unsigned) crash.sp,
+                      (unsigned) crash.cfsr, (unsigned) crash.hfsr, (unsigned) crash.mmfar, (unsigned) crash.bfar,
+                      (unsigned) crash.stack_words, (unsigned) crash.trace_records);
+    }
+
     // TODO: Print U2/U3 and CAN statistics if it is initialized
 
+    /* The interrupt latency is printed in microseconds, with one decimal */
+    const os_latency_probe_t probe = os_latency_get_probe();
+    if (probe.count > 0) {
+        const unsigned minUs = cyclesToUsX10(probe.min_cycles);
+        const unsigned avgUs = cyclesToUsX10(probe.sum_cycles / probe.count);
+        const unsigned maxUs = cyclesToUsX10(probe.max_cycles);
+        output.printf("IRQ entry latency: %u.%u/%u.%u/%u.%u us (min/avg/max), jitter %u.%u us, %u samples\n",
+                      minUs / 10, minUs % 10, avgUs / 10, avgUs % 10, maxUs / 10, maxUs % 10,
+                      (maxUs - minUs) / 10, (maxUs - minUs) % 10, (unsigned) probe.count);
+    }
+
+    os_latency_site_t sites[5];
+    const uint32_t count = os_latency_get_sites(sites, sizeof(sites) / sizeof(sites[0]));
+    for (uint32_t i = 0; i < count; i++) {
+        const unsigned maxUs = cyclesToUsX10(sites[i].max_cycles);
+        output.printf("%s0x%08X: %u.%u us max, %u times\n", (0 == i) ? "IRQs masked by " : "                ",
+                      (unsigned) sites[i].site, maxUs / 10, maxUs % 10, (unsigned) sites[i].count);
+    }
+
+    /* The locks that waited the longest are the first to redesign */
+    os_lock_stats_t locks[6];
+    const uint32_t numLocks = os_lock_get_stats(locks, sizeof(locks) / sizeof(locks[0]));
+    if (numLocks > 0) {
+        output.printf("%-6s %8s %8s %9s %10s %10s %-8s %s\n",
+                      "Lock", "Count", "Waited", "Wait ms", "Max wait", "Max hold", "By", "Owner");
+    }
+    for (uint32_t i = 0; i < numLocks; i++) {
+        const os_lock_stats_t *l = &locks[i];
+        const unsigned maxWaitUs = cyclesToUsX10(l->max_wait_cycles);
+        const unsigned maxHoldUs = cyclesToUsX10(l->max_hold_cycles);
+        output.printf("%-6.6s %8u %8u %9u %6u.%uus %6u.%uus %-8.*s %s\n", l->name,
+                      (unsigned) l->count, (unsigned) l->contended,
+                      (unsigned) (l->wait_cycles / (sys_get_cpu_clock() / 1000)),
+                      maxWaitUs / 10, maxWaitUs % 10, maxHoldUs / 10, maxHoldUs % 10,
+                      (int) sizeof(l->max_hold_task), l->max_hold_task,
+                      (NULL != l->owner) ? pcTaskGetTaskName(l->owner) : "");
+    }
+
+    /* The workers that were started by workqueue_start() */
+    const char * const workerNames[work_prio_count] = { "low", "medium", "high" };
+    for (uint32_t i = 0; i < work_prio_count; i++) {
+        const workqueue_stats_t w = workqueue_get_stats((work_prio_t) i);
+        if (w.run > 0 || w.dropped > 0) {
+            output.printf("Worker %s: %u run, %u dropped, %u us max\n", workerNames[i],
+                          (unsigned) w.run, (unsigned) w.dropped, (unsigned) w.max_us);
+        }
+    }
+
+    if (cmdParams == "reset") {
+        os_latency_reset();
+        os_lock_reset();
+    }
+
     return true;
 }
 
+CMD_HANDLER_FUNC(profileHandler)
+{
+#if (PROFILE_ENABLE)
+    if (cmdParams == "reset") {
+        profile_reset();
+        return true;
+    }
+
+    /* The histogram of one site, or the table of all the sites */
+    const uint32_t cyclesPerMs = sys_get_cpu_clock() / 1000;
+    bool found = cmdParams.getLen() == 0;
+    if (found) {
+        output.printf("%-16s %8s %9s %9s %9s %9s\n", "Site", "Count", "Avg us", "Min us", "Max us", "Total ms");
+    }
+
+    for (uint32_t i = 0; i < profile_get_count(); i++) {
+        const profile_site_t *site = profile_get_site(i);
+        if (NULL == site->name || 0 == site->count) {
+            continue;
+        }
+
+        if (cmdParams.getLen() == 0) {
+            const unsigned avgUs = cyclesToUsX10(profile_get_total(site) / site->count);
+            const unsigned minUs = cyclesToUsX10(site->min_cycles);
+            const unsigned maxUs = cyclesToUsX10(site->max_cycles);
+            output.printf("%-16.16s %8u %7u.%u %7u.%u %7u.%u %9u\n", site->name, (unsigned) site->count,
+                          avgUs / 10, avgUs % 10, minUs / 10, minUs % 10, maxUs / 10, maxUs % 10,
+                          (unsigned) (profile_get_total(site) / cyclesPerMs));
+        }
+        else if (cmdParams.compareToIgnoreCase(site->name)) {
+            found = true;
+            output.printf("%s: %u runs\n", site->name, (unsigned) site->count);
+            for (uint32_t b = 0; b < PROFILE_HIST_BUCKETS; b++) {
+                if (0 == site->hist[b]) {
+                    continue;
+                }
+                /* The last bucket counts all the longer runs */
+                const unsigned upToNs = (unsigned) sys_cycles_to_ns(1UL << (b + PROFILE_HIST_MIN_BITS));
+                output.printf("  %s %8u ns : %u\n", (b < PROFILE_HIST_BUCKETS - 1) ? "<=" : "> ",
+                              (b < PROFILE_HIST_BUCKETS - 1) ? upToNs : upToNs / 2, (unsigned) site->hist[b]);
+            }
+        }
+    }
+
+    if (!found) {
+        output.printf("Site '%s' not found\n", cmdParams());
+    }
+    return true;
+#else
+    output.putline("Profiling is disabled (PROFILE_ENABLE)");
+    return true;
+#endif
+}
+
 CMD_HANDLER_FUNC(timeHandler)
 {
     rtc_t time;
@@ -206,6 +513,69 @@ CMD_HANDLER_FUNC(timeHandler)
     return true;
 }
 
+/**
+ * Renders the binary log file written by the LOG_BIN macros
+ * @param output     The output to print the messages to
+ * @param pFilename  The binary log filename
+ */
+static bool logDecodeBinary(CharDev& output, const char *pFilename)
+{
+    /* The format strings of the binary log messages */
+    const char * const formats[] = {
+        #define LOG_BIN_MSG_FMT(id, fmt) fmt,
+        LOG_BIN_MESSAGES(LOG_BIN_MSG_FMT)
+        #undef LOG_BIN_MSG_FMT
+    };
+    const char * const type_str[] = { "debug", "info", "warn", "error" };
+
+    FIL file;
+    if (FR_OK != f_open(&file, pFilename, FA_OPEN_EXISTING | FA_READ)) {
+        output.printf("Failed to open: %s\n", pFilename);
+        return true;
+    }
+
+    logger_bin_header_t header;
+    uint32_t args[FILE_LOGGER_BIN_MAX_ARGS];
+    UINT bytesRead = 0;
+    unsigned int count = 0;
+
+    while (FR_OK == f_read(&file, &header, sizeof(header), &bytesRead) && sizeof(header) == bytesRead)
+    {
+        const uint8_t nargs = LOGGER_BIN_INFO_NARGS(header.info);
+        const logger_msg_t type = LOGGER_BIN_INFO_TYPE(header.info);
+
+        /* The zeros after the records are the unwritten part of the pre-allocated file */
+        if (0 == header.id && 0 == header.info && 0 == header.time_us_hi && 0 == header.time_us_lo) {
+            break;
+        }
+        if (nargs > FILE_LOGGER_BIN_MAX_ARGS || type >= log_last) {
+            output.printf("Invalid record at offset %u\n", (unsigned) (f_tell(&file) - sizeof(header)));
+            break;
+        }
+
+        memset(args, 0, sizeof(args));
+        if (FR_OK != f_read(&file, args, nargs * sizeof(args[0]), &bytesRead) ||
+            bytesRead != nargs * sizeof(args[0])) {
+            break;
+        }
+
+        const uint64_t us = ((uint64_t) header.time_us_hi << 32) | header.time_us_lo;
+        output.printf("%u.%06u,%s,", (unsigned) (us / 1000000), (unsigned) (us % 1000000), type_str[type]);
+        if (header.id < logbin_last) {
+            output.printf(formats[header.id], args[0], args[1], args[2], args[3]);
+        }
+        else {
+            output.printf("Unknown message %u", header.id);
+        }
+        output.putline("");
+        ++count;
+    }
+    f_close(&file);
+
+    output.printf("Decoded %u messages\n", count);
+    return true;
+}
+
 CMD_HANDLER_FUNC(logHandler)
 {
     bool enablePrintf = false;
@@ -216,18 +586,41 @@ CMD_HANDLER_FUNC(logHandler)
     }
     else if (cmdParams == "status") {
         output.printf("Blocked calls  : %u\n", logger_get_blocked_call_count());
-        output.printf("Queue watermark: %u\n", logger_get_num_buffers_watermark());
+        output.printf("Dropped calls  : %u\n", logger_get_dropped_call_count());
+        output.printf("Msgs watermark : %u\n", logger_get_num_buffers_watermark());
         output.printf("Highest file write time: %ums\n", logger_get_highest_file_write_time_ms());
         output.printf("Call counts    : %u dgb %u info %u warn %u err\n",
                       logger_get_logged_call_count(log_debug),
                       logger_get_logged_call_count(log_info),
                       logger_get_logged_call_count(log_warn),
                       logger_get_logged_call_count(log_error));
+        output.printf("Suppressed     : %u dgb %u info %u warn %u err\n",
+                      logger_get_suppressed_call_count(log_debug),
+                      logger_get_suppressed_call_count(log_info),
+                      logger_get_suppressed_call_count(log_warn),
+                      logger_get_suppressed_call_count(log_error));
     }
     else if (cmdParams.beginsWith("raw")) {
         cmdParams.eraseFirstWords(1);
         logger_log_raw(cmdParams());
     }
+    else if (cmdParams.beginsWith("decode")) {
+        cmdParams.eraseFirstWords(1);
+        cmdParams.trimStart(" ");
+        cmdParams.trimEnd(" ");
+        return logDecodeBinary(output, (cmdParams.getLen() > 0) ? cmdParams() : FILE_LOGGER_BIN_FILENAME);
+    }
+    else if (cmdParams.beginsWith("level ")) {
+        cmdParams.eraseFirstWords(1);
+        logger_msg_t type = cmdParams.beginsWithIgnoreCase("warn")  ? log_warn  :
+                            cmdParams.beginsWithIgnoreCase("error") ? log_error :
+                            cmdParams.beginsWithIgnoreCase("info")  ? log_info  : log_debug;
+
+        logger_set_min_level(type);
+        output.printf("Minimum log level: %s (compiled in: %u)\n",
+                      type == log_debug ? "debug" : type == log_info ? "info" : type == log_warn ? "warn" : "error",
+                      (unsigned) SYS_CFG_LOG_MIN_LEVEL);
+    }
     else if ( (enablePrintf = cmdParams.beginsWith("enable ")) || cmdParams.beginsWith("disable ")) {
         // command is: 'enableprint info/warning/error'
 
@@ -264,24 +657,77 @@ CMD_HANDLER_FUNC(cpHandler)
     unsigned int readTimeMs = 0;
     unsigned int writeTimeMs = 0;
     unsigned int bytesTransferred = 0;
+    unsigned int totalTimeMs = 0;
     FRESULT copyStatus = Storage::copy(srcFile, dstFile,
-                                       &readTimeMs, &writeTimeMs, &bytesTransferred);
+                                       &readTimeMs, &writeTimeMs, &bytesTransferred, &totalTimeMs);
 
     if(FR_OK != copyStatus) {
         output.printf("Error %u copying |%s| -> |%s|\n", copyStatus, srcFile, dstFile);
     }
     else {
-        output.printf("Finished!  Read: %u Kb/sec, Write: %u Kb/sec\n",
+        output.printf("Finished!  Read: %u Kb/sec, Write: %u Kb/sec, Copy: %u Kb/sec\n",
                       bytesTransferred/(0 == readTimeMs  ? 1 : readTimeMs),
-                      bytesTransferred/(0 == writeTimeMs ? 1 : writeTimeMs));
+                      bytesTransferred/(0 == writeTimeMs ? 1 : writeTimeMs),
+                      bytesTransferred/(0 == totalTimeMs ? 1 : totalTimeMs));
     }
     return true;
 }
 
+/**
+ * Prints the text of the LZ frames of the file one frame at a time, such as the text log of
+ * FILE_LOGGER_COMPRESS, @see lz_frame.h
+ * @returns the bytes of the text
+ */
+static UINT catLzFrames(FIL &file, CharDev& output, const bool printToScreen)
+{
+    uint8_t header[LZ_FRAME_HEADER_SIZE];
+    uint16_t rawLen = 0, dataLen = 0;
+    UINT bytesRead = 0, totalBytes = 0;
+    char c = 0;
+
+    /* The frames end with the zeros of a pre-allocated file, or at the end of the file */
+    DWORD offset = f_tell(&file);
+    while (FR_OK == f_read(&file, header, sizeof(header), &bytesRead) && sizeof(header) == bytesRead &&
+           lz_frame_get_lengths(header, &rawLen, &dataLen))
+    {
+        uint8_t *pFrame = (uint8_t*) malloc(LZ_FRAME_HEADER_SIZE + dataLen);
+        char *pText = (char*) malloc(rawLen + 1);
+        int32_t len = -1;
+
+        if (NULL != pFrame && NULL != pText) {
+            memcpy(pFrame, header, sizeof(header));
+            if (FR_OK == f_read(&file, pFrame + sizeof(header), dataLen, &bytesRead) && dataLen == bytesRead) {
+                len = lz_frame_unpack(pFrame, LZ_FRAME_HEADER_SIZE + dataLen, pText, rawLen);
+            }
+        }
+        for (int32_t i = 0; printToScreen && i < len; i++) {
+            output.putChar(pText[i]);
+        }
+        free(pFrame);
+        free(pText);
+
+        if (len < 0) {
+            output.printf("\nCorrupt frame at offset %u\n", (unsigned) offset);
+            break;
+        }
+        totalBytes += len;
+        offset = f_tell(&file);
+
+        if (printToScreen) {
+            output.getChar(&c, portMAX_DELAY);
+            if ('x' == c) {
+                break;
+            }
+        }
+    }
+    return totalBytes;
+}
+
 CMD_HANDLER_FUNC(catHandler)
 {
     // If -print was present, we will print to console
     const bool printToScreen = !cmdParams.erase("-noprint");
+    const bool unpack = cmdParams.erase("-lz");
     cmdParams.trimStart(" ");
     cmdParams.trimEnd(" ");
 
@@ -305,7 +751,10 @@ CMD_HANDLER_FUNC(catHandler)
         UINT totalBytesRead = 0;
 
         const unsigned int startTime = sys_get_uptime_ms();
-        while(FR_OK == f_read(&file, buffer, sizeof(buffer), &bytesRead) && bytesRead > 0)
+        if (unpack) {
+            totalBytesRead = catLzFrames(file, output, printToScreen);
+        }
+        while(!unpack && FR_OK == f_read(&file, buffer, sizeof(buffer), &bytesRead) && bytesRead > 0)
         {
             totalBytesRead += bytesRead;
 
@@ -418,6 +867,7 @@ CMD_HANDLER_FUNC(mkdirHandler)
 
 CMD_HANDLER_FUNC(rmHandler)
 {
+    Storage::close(cmdParams());
     output.printf("Delete '%s' : %s\n",
                   cmdParams(), (FR_OK == f_unlink(cmdParams())) ? "OK" : "ERROR");
     return true;
@@ -486,6 +936,8 @@ CMD_HANDLER_FUNC(mvHandler)
         return false;
     }
     else {
+        Storage::close(srcFile);
+        Storage::close(dstFile);
         output.printf("Move '%s' -> '%s' : %s\n",
                       srcFile, dstFile,
                       (FR_OK == f_rename(srcFile, dstFile))  ? "OK" : "ERROR");
@@ -499,6 +951,7 @@ CMD_HANDLER_FUNC(newFileHandler)
     int timeout_ms = OS_MS(10 * 1000);
 
     FIL file;
+    Storage::close(cmdParams());
     if (FR_OK != f_open(&file, cmdParams(), FA_WRITE | FA_CREATE_ALWAYS)) {
         output.printf("Unable to open '%s' to write the file\n", cmdParams());
         return true;
@@ -579,6 +1032,9 @@ CMD_HANDLER_FUNC(dcpHandler)
 
 CMD_HANDLER_FUNC(storageHandler)
 {
+    /* The files kept open by Storage would not be valid after a format or a mount */
+    Storage::close();
+
     if(cmdParams == "format sd") {
         output.putline((FR_OK == Storage::getSDDrive().format()) ? "Format OK" : "Format ERROR");
     }
@@ -620,8 +1076,44 @@ static void stream_tlm(const char *s, void *arg)
     }
 }
 
+static void stream_tlm_binary(const void *data, uint32_t len, void *arg)
+{
+    CharDev *out = (CharDev*) arg;
+    out->putBlock(data, len);
+}
+
+/* The records of the subscriptions are pushed by the timer task, so these do not block */
+static void stream_tlm_push(const void *data, uint32_t len, void *arg)
+{
+    CharDev *out = (CharDev*) arg;
+    out->putBlock(data, len, 0);
+}
+static void stream_tlm_push_mesh(const void *data, uint32_t len, void *arg)
+{
+    const uint8_t addr = (uint8_t) (uintptr_t) arg;
+    wireless_send(addr, mesh_pkt_nack, data, len, 2);
+}
+
+/// Subscribes the variable of the params "<comp name> <var name> [deadband] [min ms]"
+static bool subscribeTlm(CharDev& output, int sub, char *compName, char *varName, char *deadband, char *minMs)
+{
+    if (sub < 0 || NULL == varName) {
+        output.putline("Required parameters: '<comp name> <var name> [deadband] [min ms]'");
+        return false;
+    }
+    if (!tlm_subscribe_add(sub, compName, varName, deadband ? atof(deadband) : 0, minMs ? atoi(minMs) : 0)) {
+        output.printf("Failed to subscribe %s:%s\n", compName, varName);
+        return false;
+    }
+    return true;
+}
+
 CMD_HANDLER_FUNC(telemetryHandler)
 {
+    /* Snapshot of the last binary telemetry, used for the delta stream */
+    static char *binarySnapshot = NULL;
+    static uint32_t binarySnapshotSize = 0;
+
     if(cmdParams.getLen() == 0)
     {
         tlm_stream_all(stream_tlm, &output, false);
@@ -630,11 +1122,94 @@ CMD_HANDLER_FUNC(telemetryHandler)
     {
         tlm_stream_all(stream_tlm, &output, true);
     }
+    else if (cmdParams == "binary" || cmdParams == "delta")
+    {
+        /* If more telemetry was registered, the snapshot is no longer valid */
+        bool delta = (cmdParams == "delta");
+        const uint32_t size = tlm_binary_get_size_all();
+        if (size != binarySnapshotSize) {
+            delete [] binarySnapshot;
+            binarySnapshot = new char[size];
+            binarySnapshotSize = size;
+            delta = false;
+        }
+        tlm_stream_all_binary(stream_tlm_binary, &output, binarySnapshot, delta);
+    }
+    else if (cmdParams == "samples")
+    {
+        tlm_sampler_stream(stream_tlm_binary, &output);
+    }
+    else if (cmdParams == "sample clear")
+    {
+        output.printf("Sampler stopped, %u samples were overwritten, %u were missed\n",
+                      (unsigned) tlm_sampler_get_overwritten_count(),
+                      (unsigned) tlm_sampler_get_missed_count());
+        tlm_sampler_clear();
+    }
+    else if (cmdParams.beginsWithIgnoreCase("sample "))
+    {
+        char *compName = NULL;
+        char *varName = NULL;
+        char *periodMs = NULL;
+        if (4 != cmdParams.tokenize(" ", 4, NULL, &compName, &varName, &periodMs)) {
+            output.putline("Required parameters: 'sample <comp name> <var name> <period ms>'");
+        }
+        else if (tlm_sampler_add(compName, varName, atoi(periodMs))) {
+            output.printf("Sampling %s:%s every %sms\n", compName, varName, periodMs);
+        }
+        else {
+            output.printf("Failed to sample %s:%s\n", compName, varName);
+        }
+    }
+    else if (cmdParams.beginsWithIgnoreCase("sub "))
+    {
+        char *compName = NULL;
+        char *varName = NULL;
+        char *deadband = NULL;
+        char *minMs = NULL;
+        cmdParams.tokenize(" ", 5, NULL, &compName, &varName, &deadband, &minMs);
+        subscribeTlm(output, tlm_subscribe_open(stream_tlm_push, &output, TLM_SUB_FRAME_BYTES),
+                     compName, varName, deadband, minMs);
+    }
+    else if (cmdParams.beginsWithIgnoreCase("msub "))
+    {
+        char *addr = NULL;
+        char *compName = NULL;
+        char *varName = NULL;
+        char *deadband = NULL;
+        char *minMs = NULL;
+        cmdParams.tokenize(" ", 6, NULL, &addr, &compName, &varName, &deadband, &minMs);
+        if (NULL != addr) {
+            void *dst = (void*) (uintptr_t) atoi(addr);
+            subscribeTlm(output, tlm_subscribe_open(stream_tlm_push_mesh, dst, MESH_DATA_PAYLOAD_SIZE),
+                         compName, varName, deadband, minMs);
+        }
+    }
+    else if (cmdParams.beginsWithIgnoreCase("unsub"))
+    {
+        /* Opening the same stream again returns its subscriber */
+        char *addr = NULL;
+        cmdParams.tokenize(" ", 2, NULL, &addr);
+        if (NULL == addr) {
+            tlm_subscribe_close(tlm_subscribe_open(stream_tlm_push, &output, TLM_SUB_FRAME_BYTES));
+        }
+        else {
+            tlm_subscribe_close(tlm_subscribe_open(stream_tlm_push_mesh, (void*) (uintptr_t) atoi(addr),
+                                                   MESH_DATA_PAYLOAD_SIZE));
+        }
+        output.printf("Unsubscribed, %u records of changes were pushed\n",
+                      (unsigned) tlm_subscribe_get_pushed_count());
+    }
     else if(cmdParams == "save") {
         FILE *fd = fopen(SYS_CFG_DISK_TLM_NAME, "w");
-        tlm_stream_one_file(tlm_component_get_by_name(SYS_CFG_DISK_TLM_NAME), fd);
-        fclose(fd);
-        output.putline("Telemetry was saved to disk");
+        if (fd) {
+            tlm_stream_one_binary_file(tlm_component_get_by_name(SYS_CFG_DISK_TLM_NAME), fd);
+            fclose(fd);
+            output.putline("Telemetry was saved to disk");
+        }
+        else {
+            output.putline("Failed to open the disk telemetry file");
+        }
     }
     else if(cmdParams.beginsWithIgnoreCase("get")) {
         char *compName = NULL;
@@ -674,17 +1249,50 @@ CMD_HANDLER_FUNC(telemetryHandler)
 CMD_HANDLER_FUNC(learnIrHandler)
 {
     SemaphoreHandle_t learn_sem = scheduler_task::getSharedObject(shared_learnSemaphore);
+    remote_learn_t req = { remote_learn_list, 0, 0 };
+    unsigned int action = 0;
 
-    if (learn_sem)
+    if (!learn_sem)
+    {
+        output.putline("ERROR: Semaphore was NULL, is the 'remote' task running?");
+        return true;
+    }
+
+    if (cmdParams == "")
     {
         xSemaphoreGive(learn_sem);
         output.putline("Learning mode enabled");
+        return true;
     }
-    else
-    {
-        output.putline("ERROR: Semaphore was NULL, is the 'remote' task running?");
+
+    /* The other requests are done by the remote task, which prints their output */
+    if (cmdParams.beginsWithIgnoreCase("list")) {
+        req.op = remote_learn_list;
+    }
+    else if (cmdParams.beginsWithIgnoreCase("forget")) {
+        if (cmdParams.containsIgnoreCase("all")) {
+            req.op = remote_learn_forget_all;
+        }
+        else if (1 == cmdParams.scanf("%*s %u", &action) && action <= REMOTE_ACTION_MAX) {
+            req.op = remote_learn_forget;
+            req.action = action;
+        }
+        else {
+            return false;
+        }
+    }
+    else if (1 == cmdParams.scanf("%u", &action) && action <= REMOTE_ACTION_MAX) {
+        req.op = remote_learn_bind;
+        req.action = action;
+        req.repeat = cmdParams.containsIgnoreCase("repeat");
+    }
+    else {
+        return false;
     }
 
+    if (!remote_learn_channel.send(req, 0)) {
+        output.putline("ERROR: The remote task is busy");
+    }
     return true;
 }
 
@@ -700,31 +1308,20 @@ CMD_HANDLER_FUNC(ledHandler)
     int total = 4000, period = 200, times, tmp;
     int switch_major = 0, switch_minor = 30;
     int led_major = 2, led_minor = 7;
-    str tmpStr;
+    char pin[8];
+    CmdArgs args(cmdParams);
 
-    if(cmdParams.containsIgnoreCase("-t")) {
-        tmpStr = str(cmdParams.subString("-t"));
-        tmpStr.scanf("-t%d", &tmp);
-        if (tmp > 0)
-            total = tmp;
-    }
+    if (args.getInt("-t", tmp) && tmp > 0)
+        total = tmp;
 
-    if(cmdParams.containsIgnoreCase("-p")) {
-        tmpStr = str(cmdParams.subString("-p"));
-        tmpStr.scanf("-p%d", &tmp);
-        if (tmp > 0)
-            period = tmp;
-    }
+    if (args.getInt("-p", tmp) && tmp > 0)
+        period = tmp;
 
-    if(cmdParams.containsIgnoreCase("-i")) {
-        tmpStr = str(cmdParams.subString("-i"));
-        tmpStr.scanf("-iP%u.%u", &switch_major, &switch_minor);
-    }
+    if (args.getString("-i", pin, sizeof(pin)))
+        sscanf(pin, "P%u.%u", &switch_major, &switch_minor);
 
-    if(cmdParams.containsIgnoreCase("-o")) {
-        tmpStr = str(cmdParams.subString("-o"));
-        tmpStr.scanf("-oP%u.%u", &led_major, &led_minor);
-    }
+    if (args.getString("-o", pin, sizeof(pin)))
+        sscanf(pin, "P%u.%u", &led_major, &led_minor);
 
     times = total / period;
     printf("total time = %dms, period = %dms,\n", total, period);
@@ -758,6 +1355,9 @@ CMD_HANDLER_FUNC(ledHandler)
     return true;
 }
 
+/// P0.6 is the chip select of the flash
+typedef GpioPin<0, 6> spi1_flash_cs;
+
 static void spi_flash_init()
 {
     /* Select GPIO0.6, MISO, MOSI, and SCK pin-select functionality */
@@ -765,8 +1365,8 @@ static void spi_flash_init()
     LPC_PINCON->PINSEL0 |= ((2 << 14) | (2 << 16) | (2 << 18));
 
     /* Initialize GPIO0.6 as an output pin with default HIGH */
-    LPC_GPIO0->FIODIR |= BITS(6);
-    LPC_GPIO0->FIOPIN |= BITS(6);
+    spi1_flash_cs::setAsOutput();
+    spi1_flash_cs::setHigh();
 
     /* Power up SPI1 and set its clock */
     lpc_pconp(pconp_ssp1, true);
@@ -790,10 +1390,10 @@ static unsigned char spi1_exchange_byte(char input)
 }
 
 #define spi1_flash_chip_select() \
-    do {LPC_GPIO0->FIOPIN &= MASK(6);} while (0)
+    do {spi1_flash_cs::setLow();} while (0)
 
 #define spi1_flash_chip_deselect() \
-    do {LPC_GPIO0->FIOPIN |= BITS(6);} while (0)
+    do {spi1_flash_cs::setHigh();} while (0)
 
 #define xmit_spi(dat)           spi1_exchange_byte(dat)
 #define rcvr_spi()              spi1_exchange_byte(0xff)
@@ -964,40 +1564,6 @@ fail:
     return true;
 }
 
-/**
- * UART Command dividers
- *
- * Formula:
- * Baudrate = Peripheral Clock / (16 * dl * (1 + divadd / mul))
- *
- * @rate: Baud rate
- * @dl: 16-bit dividers ((DLM << 8) | DLM)
- * @divadd: Numerator for the fraction
- * @mul: Denominator for the fraction
- */
-static struct uart_divider {
-        unsigned int rate;
-        unsigned short dl;
-        unsigned char divadd;
-        unsigned char mul;
-} divisor_list[] = {
-#ifdef PARAM_HAROLDO
-        /* Required 9600Hz, Acutal 9616Hz, err = 1.6% */
-        {9600, 312, 0, 1},
-#else
-        /* Required 9600Hz, Acutal 9600Hz, err = 0 */
-        {9600, 250, 1, 4},
-#endif
-        /* Required 19200Hz, Acutal 19200Hz, err = 0 */
-        {19200, 125, 1, 4},
-        /* Required 38400Hz, Acutal 38372Hz, err = 0.7% */
-        {38400, 43, 9, 11},
-        /* Required 57600Hz, Acutal 57544Hz, err = 0.9% */
-        {57600, 46, 2, 15},
-        /* Required 115200Hz, Acutal 115089Hz, err = 0.9% */
-        {115200, 23, 2, 15},
-};
-
 #define BUF_MAX             256
 #define FIFO_DEPTH          8
 #define MIN_SLEEP_PERIOD    10
@@ -1054,10 +1620,8 @@ static void UART3_IRQHandler()
 #define UART_IRQ_ENABLE(port) \
     do {NVIC_EnableIRQ(port == 2 ? UART2_IRQn : UART3_IRQn);} while (0)
 
-static bool uart_init(int port, unsigned int rate, unsigned int index)
+static bool uart_init(int port, const uart_baud_t& baud)
 {
-    struct uart_divider div;
-
     switch (port) {
         case 2:
             /* Select TXD2 and RXD2 pin-select functionality */
@@ -1085,9 +1649,9 @@ static bool uart_init(int port, unsigned int rate, unsigned int index)
     LPC_UART23(port)->LCR = BITS(7);
 
     /* Set divisors to get the required baud rate */
-    LPC_UART23(port)->DLM = divisor_list[index].dl >> 8;
-    LPC_UART23(port)->DLL = divisor_list[index].dl & 0xff;
-    LPC_UART23(port)->FDR = divisor_list[index].mul << 4 | div.divadd;
+    LPC_UART23(port)->DLM = baud.dl >> 8;
+    LPC_UART23(port)->DLL = baud.dl & 0xff;
+    LPC_UART23(port)->FDR = baud.mulVal << 4 | baud.divAddVal;
 
     /* Disable DLAB; Set 8-bit character length, 1 stop bit, no parity */
     LPC_UART23(port)->LCR = 3;
@@ -1105,34 +1669,25 @@ static bool uart_init(int port, unsigned int rate, unsigned int index)
 
 CMD_HANDLER_FUNC(uartHandler)
 {
-    unsigned int rate_list[] = {9600, 19200, 38400, 57600, 115200};
-    unsigned int timeout = 1000, rate = 9600, i;
+    unsigned int timeout = 1000, rate = 9600;
+    uart_baud_t baud;
     char tx_buf[BUF_MAX] = "A";
     unsigned int index = 0;
     bool master = false;
     bool ret = true;
     int port = 2;
-    str tmpStr;
+    CmdArgs args(cmdParams);
 
     tx_index = 0;
     rx_index = 0;
 
-    if(cmdParams.containsIgnoreCase("--master"))
+    if (args.hasFlag("--master"))
         master = true;
 
-    if(cmdParams.containsIgnoreCase("-c")) {
-        tmpStr = str(cmdParams.subString("-c"));
-        tmpStr.scanf("-c%s", tx_buf);
-    }
-
-    if(cmdParams.containsIgnoreCase("-t")) {
-        tmpStr = str(cmdParams.subString("-t"));
-        tmpStr.scanf("-t%d", &timeout);
-    }
+    args.getString("-c", tx_buf, sizeof(tx_buf));
+    args.getUint("-t", timeout);
 
-    if(cmdParams.containsIgnoreCase("-p")) {
-        tmpStr = str(cmdParams.subString("-p"));
-        tmpStr.scanf("-p%d", &port);
+    if (args.getInt("-p", port)) {
         switch (port) {
         case 2:
         case 3:
@@ -1144,28 +1699,23 @@ CMD_HANDLER_FUNC(uartHandler)
         }
     }
 
-    if(cmdParams.containsIgnoreCase("-b")) {
-        tmpStr = str(cmdParams.subString("-b"));
-        tmpStr.scanf("-b%d", &rate);
-    }
-
-    /* Error out unsupported baud rate */
-    for (i = 0; i < ARRAY_SIZE(divisor_list); i++)
-        if (divisor_list[i].rate == rate)
-            break;
+    args.getUint("-b", rate);
 
-    if (i == ARRAY_SIZE(rate_list)) {
+    /* Error out unsupported baud rate; the UART clock is the CPU clock */
+    if (!UartDev::solveBaudRate(sys_get_cpu_clock(), rate, baud) ||
+        baud.errorPpm > UART_BAUD_MAX_ERROR_PPM || baud.errorPpm < -UART_BAUD_MAX_ERROR_PPM) {
         printf("Unsupported baud rate for UART%d: %d\n", port, rate);
         ret = false;
         goto fail;
     }
 
-    ret = uart_init(port, rate, i);
+    ret = uart_init(port, baud);
     if (!ret)
         goto fail;
 
-    printf("Running UART port %d as %s (%s first) at baud rate %dHz\n", port,
-           master ? "master" : "slave", master ? "TX" : "RX", rate);
+    printf("Running UART port %d as %s (%s first) at baud rate %dHz (actual %uHz, error %d ppm)\n", port,
+           master ? "master" : "slave", master ? "TX" : "RX", rate,
+           (unsigned int) baud.actualBaud, (int) baud.errorPpm);
 
     /* Master Mode: send characters from command line */
     while (master && tx_buf[tx_index] != '\0') {
@@ -1201,29 +1751,10 @@ fail:
     return ret;
 }
 
-/*
- * I2C Slave Buffer Structure
- *
- * Description : Status   Count   Data    ... ...    Max
- *       Index :   0        1      2             I2C_BUF_MAX
- *
- * Status : CLEAR or END (Rx finished) or RESTART (Going to Tx)
- * Count  : The length/count of valid data in the Slave Buffer
- * Data   : Valid data, must start from index 2
- */
-#define I2C_BUF_MAX         16
-#define I2C_MEM_MAX         2
-#define I2C_DATA_IDX        2
-#define I2C_COUNT_IDX       1
-#define I2C_STATUS_IDX      0
-#define I2C_STATUS_CLEAR    0x0
-#define I2C_STATUS_END      0x1
-#define I2C_STATUS_RESTART  0xff
-
 /*
  * I2C Slave Register Map
  *
- * Address      Value       Description
+ * Register     Value       Description
  *   0x0        Write 0     Turn off LED9
  *   0x0        Write 1     Turn on LED9
  *   0x0        Read        Read the value of this register
@@ -1238,18 +1769,19 @@ CMD_HANDLER_FUNC(i2cSlaveHandler)
     I2C2& i2c = I2C2::getInstance();
     const uint8_t slaveAddr = 0x88;
     unsigned int timeout = 30000;
-    uint8_t buffer[I2C_BUF_MAX];
-    uint8_t memory[I2C_MEM_MAX];
+    static uint8_t ledReg = 0;
+    static uint8_t flashIdReg[SPI_FLASH_ID_LEN] = { 0 };
+    static I2C_SlaveReg_t regs[] = {
+        { &ledReg,        sizeof(ledReg),     true,  NULL, NULL },  // I2C_CMD_LED
+        { &flashIdReg[0], sizeof(flashIdReg), false, NULL, NULL },  // I2C_CMD_SPI_FLASH
+    };
     bool infinity;
-    uint8_t addr;
+    uint8_t reg;
+    uint8_t value;
     uint64_t time;
-    str tmpStr;
     int i;
 
-    if(cmdParams.containsIgnoreCase("-t")) {
-        tmpStr = str(cmdParams.subString("-t"));
-        tmpStr.scanf("-t%d", &timeout);
-    }
+    CmdArgs(cmdParams).getUint("-t", timeout);
 
     if (!timeout) {
         infinity = true;
@@ -1264,64 +1796,29 @@ CMD_HANDLER_FUNC(i2cSlaveHandler)
     /* Turn off LED initially */
     LPC_GPIO1->FIOPIN |= BITS(0);
 
-    /* Initialize SPI Flash */
+    /* Initialize SPI Flash, and read its signature to the read-only register */
     spi_flash_init();
+    spi1_flash_chip_select();
+    xmit_spi(SPI_FLASH_ID_OPCODE);
+    for (i = 0; i < SPI_FLASH_ID_LEN; i++)
+        flashIdReg[i] = rcvr_spi();
+    spi1_flash_chip_deselect();
 
-    memset(buffer, 0, sizeof(buffer));
-    memset(memory, 0, sizeof(memory));
-
-    i2c.initSlave(slaveAddr, buffer, ARRAY_SIZE(buffer));
+    ledReg = 0;
+    i2c.initSlaveRegisters(slaveAddr, &regs[0], ARRAY_SIZE(regs));
 
     time = xTaskGetMsCount();
 
-    while (infinity || timeout) {
-        switch (buffer[I2C_STATUS_IDX]) {
-        case I2C_STATUS_RESTART:
-            /* Going to read */
-            NVIC_DisableIRQ(I2C2_IRQn);
-            buffer[I2C_STATUS_IDX] = I2C_STATUS_CLEAR;
-            /* Save the register address */
-            addr = buffer[I2C_DATA_IDX];
-            switch (addr) {
-            case I2C_CMD_LED:
-                buffer[I2C_COUNT_IDX] = 1;
-                buffer[I2C_DATA_IDX] = memory[addr];
-                printf("Loading data %x from register %x\n",
-                       memory[addr], addr);
-                break;
-            case I2C_CMD_SPI_FLASH:
-                buffer[I2C_COUNT_IDX] = 5;
-                /* Read the signature of the SPI Flash */
-                spi1_flash_chip_select();
-                xmit_spi(SPI_FLASH_ID_OPCODE);
-                for (i = 0; i < SPI_FLASH_ID_LEN; i++)
-                    buffer[i + I2C_DATA_IDX] = rcvr_spi();
-                spi1_flash_chip_deselect();
-                printf("Loading SPI Flash ID via register 1\n");
-                break;
-            default:
-                break;
-            }
-            NVIC_EnableIRQ(I2C2_IRQn);
-            break;
-        case I2C_STATUS_END:
-            /* Write completed */
-            buffer[I2C_STATUS_IDX] = I2C_STATUS_CLEAR;
-            addr = buffer[I2C_DATA_IDX];
-            if (addr >= I2C_MEM_MAX)
-                continue;
-            memory[addr] = buffer[I2C_DATA_IDX + 1];
-            printf("Saving data %x to register %x\n",
-                   buffer[I2C_DATA_IDX + 1], addr);
-            break;
-        default:
-            if (xTaskGetMsCount() == time + timeout)
-                timeout = 0;
-            if (memory[I2C_CMD_LED])
-                LPC_GPIO1->FIOPIN &= MASK(0);
-            else
-                LPC_GPIO1->FIOPIN |= BITS(0);
-            break;
+    /* The I2C interrupt answers the reads, so we only sleep until the master writes a register */
+    while (infinity || (xTaskGetMsCount() - time) < timeout) {
+        if (!i2c.slaveWaitForWrite(reg, 100)) {
+            continue;
+        }
+
+        if (I2C_CMD_LED == reg && i2c.slaveReadRegister(reg, &value, sizeof(value))) {
+            printf("Saving data %x to register %x\n", value, reg);
+            /* The LED is on when P1.0 is low */
+            GpioPin<1, 0>::set(!value);
         }
     }
 
@@ -1353,60 +1850,45 @@ CMD_HANDLER_FUNC(orientationCmd)
     return true;
 }
 
-static SemaphoreHandle_t gButtonPressSemaphore;
-static TimerHandle_t semaphoreTimer;
-
-void gpio_isr()
+/// The bottom half of gpio_isr(), run by the low priority worker
+static void button_press_work(void *p)
 {
-    if (!xTimerIsTimerActive(semaphoreTimer))
-        xTimerStart(semaphoreTimer, 0);
+    printf("ISR: Got a button press event\n");
 }
 
-void semaphore_timer_callback(TimerHandle_t pxTimer)
-{
-    xSemaphoreGive(gButtonPressSemaphore);
-}
-
-void semaphore_task(void *p)
+void gpio_isr()
 {
-    while (1) {
-        if (!xSemaphoreTake(gButtonPressSemaphore, portMAX_DELAY))
-            continue;
-        printf("ISR: Got a button press event\n");
-    }
+    BaseType_t higherPriorityTaskWaiting = pdFALSE;
+    workqueue_post_from_isr(work_prio_low, button_press_work, NULL, &higherPriorityTaskWaiting);
+    portEND_SWITCHING_ISR(higherPriorityTaskWaiting);
 }
 
 CMD_HANDLER_FUNC(semaphoreCmd)
 {
     int port = 26, tmp;
-    str tmpStr;
 
-    if(cmdParams.containsIgnoreCase("-p")) {
-        tmpStr = str(cmdParams.subString("-p"));
-        tmpStr.scanf("-p%d", &tmp);
-        if (tmp >= 0 && tmp < 32)
-            port = tmp;
-    }
+    if (CmdArgs(cmdParams).getInt("-p", tmp) && tmp >= 0 && tmp < 32)
+        port = tmp;
 
     /* Select GPIO0.x pin-select functionality */
     LPC_PINCON->PINSEL0 &= ~(0x3 << port);
     /* Initialize GPIO0.0 as an input pin */
     LPC_GPIO0->FIODIR &= MASK(port);
 
-    /* Create a semaphore */
-    gButtonPressSemaphore = xSemaphoreCreateBinary();
-    /* Create a timer to delay the semaphore from ISR by 300ms for switch debounce */
-    semaphoreTimer = xTimerCreate("semaphore_timer", 300, pdFALSE, 0, semaphore_timer_callback);
-    /* Create a task to receive the semaphore */
-    xTaskCreate(semaphore_task, "semaphore_test", STACK_BYTES(1024), 0, PRIORITY_LOW, NULL);
-    /* Register an ISR for GPIO interrupt */
-    eint3_enable_port0(port, eint_falling_edge, gpio_isr);
+    /* The button presses are printed by the low priority worker instead of a task of their own */
+    if (!workqueue_start(work_prio_low)) {
+        return false;
+    }
+    /* Register an ISR for GPIO interrupt, which is called once the switch is stable for 50ms */
+    eint3_enable_port0_debounced(port, eint_falling_edge, gpio_isr, 50);
 
     return true;
 }
 
 #if TERMINAL_USE_CAN_BUS_HANDLER
 #include "can.h"
+#include "can_isotp.h"
+#include "can_recorder.h"
 #include "printf_lib.h"
 void can_BusOffCallback(uint32_t ibits)
 {
@@ -1433,31 +1915,66 @@ CMD_HANDLER_FUNC(canBusHandler)
 #endif
     if (cmdParams == "init")
     {
-        bool ok = CAN_init(can, baudrate, 3, 3, can_BusOffCallback, NULL);
+        /* The RX queue holds one ISO-TP block of the file transfers */
+        bool ok = CAN_init(can, baudrate, 32, 8, can_BusOffCallback, NULL);
         output.printf("CAN init: %s\n", ok ? "OK" : "ERROR");
 
         CAN_reset_bus(can);
-        CAN_bypass_filter_ack_all_msgs();
+        CAN_bypass_filter_accept_all_msgs();
     }
     else if (cmdParams.beginsWithIgnoreCase("filter"))
     {
         uint32_t id = 0;
-        if (cmdParams.scanf("%*s %x", &id))
+        uint32_t mask = CAN_FILTER_EXACT;
+        if (cmdParams.scanf("%*s %x %x", &id, &mask))
         {
-            can_std_id_t *nosid = NULL;
-            can_std_grp_id_t *nosgp = NULL;
-            can_ext_grp_id_t *noeid = NULL;
-            can_ext_id_t eid = CAN_gen_eid(can, id);
-
-            CAN_setup_filter(nosid, 0,
-                             nosgp, 0,
-                             &eid, 1,
-                             noeid, 0);
+            const can_filter_t filter = { id, mask, can, true };
+            const bool ok = CAN_filter_set_apply(&filter, 1);
+            output.printf("CAN filter: %s, %u bytes of filter RAM used\n", ok ? "OK" : "ERROR",
+                          CAN_filter_get_ram_used());
         }
         else {
-            output.printf("Please specify the ID to filter: 'filter 0x100'\n");
+            output.printf("Please specify the ID and optional mask to filter: 'filter 0x100 [0x1FFFFFF0]'\n");
         }
     }
+    else if (cmdParams.beginsWithIgnoreCase("sendfile"))
+    {
+        /* Send the file data in ISO-TP messages to another board running 'file can <filename> <size>' */
+        static uint8_t sRxBuffer[8];
+        static can_isotp_t sSession;
+        static bool sInit = false;
+        char srcFile[128] = { 0 };
+        char buffer[1024];
+        unsigned int bytesRead = 0;
+        unsigned int fileOffset = 0;
+        FIL file;
+
+        if (1 != cmdParams.scanf("%*s %128s", &srcFile[0])) {
+            output.printf("Please specify the file to send: 'sendfile 0:file.bin'\n");
+            return true;
+        }
+        if (FR_OK != f_open(&file, srcFile, FA_OPEN_EXISTING | FA_READ)) {
+            output.printf("Unable to open '%s'\n", srcFile);
+            return true;
+        }
+        if (!sInit) {
+            sInit = CAN_isotp_init(&sSession, can, TERMINAL_CAN_ISOTP_DATA_ID, TERMINAL_CAN_ISOTP_FC_ID, false,
+                                   sRxBuffer, sizeof(sRxBuffer));
+        }
+
+        const unsigned int startMs = sys_get_uptime_ms();
+        while (sInit && FR_OK == f_read(&file, buffer, sizeof(buffer), &bytesRead) && bytesRead > 0) {
+            if (!CAN_isotp_send(&sSession, buffer, bytesRead, 100)) {
+                output.printf("ERROR: Receiver stopped responding at %u\n", fileOffset);
+                break;
+            }
+            fileOffset += bytesRead;
+        }
+        if (fileOffset == file.fsize) {
+            output.printf("Sent %u bytes in %u ms\n", fileOffset, (unsigned int) sys_get_uptime_ms() - startMs);
+        }
+        f_close(&file);
+    }
     else if (cmdParams.beginsWithIgnoreCase("tx"))
     {
         int length = 0;
@@ -1514,6 +2031,83 @@ CMD_HANDLER_FUNC(canBusHandler)
             output.printf("Failed to receive data with %i timeout\n", timeout);
         }
     }
+    else if (cmdParams.beginsWithIgnoreCase("stats"))
+    {
+        if (cmdParams == "stats reset") {
+            CAN_reset_stats(can);
+        }
+
+        const can_stats_t *pStats = CAN_get_stats(can);
+        output.printf("Bus load : %u.%02u %% (peak %u.%02u %%) at %u bps\n",
+                      pStats->load_x100 / 100, pStats->load_x100 % 100,
+                      pStats->peak_load_x100 / 100, pStats->peak_load_x100 % 100, (unsigned) pStats->bitrate);
+        output.printf("Frames/s : %u RX, %u TX (%u dropped, RX/TX queue watermarks %u/%u)\n",
+                      pStats->rx_per_sec, pStats->tx_per_sec, CAN_get_rx_dropped_count(can),
+                      CAN_get_rx_watermark(can), CAN_get_tx_watermark(can));
+        output.printf("TX latency: %u us last, %u us avg, %u us max\n",
+                      (unsigned) pStats->tx_latency_us, (unsigned) pStats->tx_latency_avg_us,
+                      (unsigned) pStats->tx_latency_max_us);
+
+        output.printf("Busiest IDs of the %u ms window ending at %u ms:\n",
+                      CAN_STATS_WINDOW_MS, (unsigned) pStats->window_end_ms);
+        for (int i = 0; i < CAN_STATS_TOP_IDS && pStats->top_ids[i].frames > 0; i++) {
+            const can_id_rate_t *pRate = &pStats->top_ids[i];
+            output.printf("  %8X%s : %5u frames/s\n", (unsigned) (pRate->msg_id & ~CAN_STATS_ID_29BIT),
+                          (pRate->msg_id & CAN_STATS_ID_29BIT) ? "x" : " ", pRate->per_sec);
+        }
+    }
+    else if (cmdParams.beginsWithIgnoreCase("rec"))
+    {
+        static can_rec_filter_t sFilters[CAN_RECORDER_MAX_FILTERS];
+        static uint8_t sFilterCount = 0;
+        static const char * const sStates[] = { "stopped", "armed", "recording", "done" };
+        char filename[64] = "1:can.bin";
+        can_rec_filter_t filter = { 0, CAN_REC_KEY_ID_MASK };
+        unsigned int preFrames = 0, postFrames = 0;
+        FRESULT status = FR_OK;
+
+        if (!can_recorder_init(CAN_RECORDER_RING_FRAMES, PRIORITY_HIGH)) {
+            output.printf("ERROR: Failed to initialize the CAN recorder\n");
+            return true;
+        }
+
+        cmdParams.eraseFirstWords(1);
+        if (cmdParams.beginsWithIgnoreCase("start")) {
+            cmdParams.scanf("%*s %63s", &filename[0]);
+            status = can_recorder_start(filename);
+        }
+        else if (cmdParams.beginsWithIgnoreCase("arm")) {
+            if (cmdParams.scanf("%*s %x %x %u %u %63s", &filter.key, &filter.mask, &preFrames, &postFrames, &filename[0]) < 1) {
+                output.printf("Need <key> [mask] [frames before] [frames from the trigger on] [file]\n");
+                return true;
+            }
+            status = can_recorder_arm(filename, &filter, preFrames, postFrames);
+        }
+        else if (cmdParams.beginsWithIgnoreCase("filter")) {
+            if (cmdParams == "filter clear") {
+                sFilterCount = 0;
+            }
+            else if (cmdParams.scanf("%*s %x %x", &filter.key, &filter.mask) >= 1 && sFilterCount < CAN_RECORDER_MAX_FILTERS) {
+                sFilters[sFilterCount++] = filter;
+            }
+            else {
+                output.printf("Need <key> [mask] of up to %u filters, or 'clear'\n", CAN_RECORDER_MAX_FILTERS);
+            }
+            can_recorder_set_filters(sFilters, sFilterCount);
+            output.printf("%u filters\n", sFilterCount);
+        }
+        else if (cmdParams == "stop") {
+            status = can_recorder_stop();
+        }
+
+        const can_rec_stats_t stats = can_recorder_get_stats();
+        if (FR_OK != status || FR_OK != stats.error) {
+            output.printf("ERROR: File error %u\n", (unsigned) (FR_OK != status ? status : stats.error));
+        }
+        output.printf("CAN recorder is %s: %u frames, %u dropped, %u bytes\n", sStates[stats.state],
+                      (unsigned) stats.frames, (unsigned) stats.dropped, (unsigned) stats.file_bytes);
+        output.printf("Ring watermark %u frames, longest write %u ms\n", stats.watermark, stats.max_write_ms);
+    }
     else if (cmdParams == "registers")
     {
         /* Read CAN registers for debugging */
@@ -1542,3 +2136,93 @@ CMD_HANDLER_FUNC(canBusHandler)
 }
 
 #endif
+
+CMD_HANDLER_FUNC(blackboxHandler)
+{
+    static uint8_t sPage[BLACKBOX_MAX_PAGE_BYTES];
+    const blackbox_page_t *pHdr = (const blackbox_page_t*) &sPage[0];
+    char filename[64] = "1:blackbox.bin";
+    unsigned int pages = 1;
+
+    if (!blackbox_init(PRIORITY_HIGH)) {
+        output.printf("ERROR: Failed to initialize the black box\n");
+        return true;
+    }
+
+    if (cmdParams == "start") {
+        if (!blackbox_start()) {
+            output.printf("ERROR: No raw pages; format the flash with FLASH_RAW_SECTORS\n");
+        }
+    }
+    else if (cmdParams == "stop") {
+        blackbox_stop();
+    }
+    else if (cmdParams.beginsWithIgnoreCase("export")) {
+        FIL file;
+        UINT bytesWritten = 0;
+        uint32_t exported = 0;
+        const uint32_t pageBytes = flash_raw_get_page_bytes();
+        const uint32_t logPages = blackbox_get_stats().log_pages;
+
+        cmdParams.scanf("%*s %63s", &filename[0]);
+        if (FR_OK != f_open(&file, filename, FA_WRITE | FA_CREATE_ALWAYS)) {
+            output.printf("ERROR: Failed to create %s\n", filename);
+            return true;
+        }
+
+        /* The pages that are not valid are skipped, such as one being overwritten while recording */
+        for (uint32_t n = 0; n < logPages; n++) {
+            if (!blackbox_read_page(n, sPage)) {
+                continue;
+            }
+            if (FR_OK != f_write(&file, sPage, pageBytes, &bytesWritten) || pageBytes != bytesWritten) {
+                output.printf("ERROR: Failed to write %s\n", filename);
+                break;
+            }
+            ++exported;
+        }
+        f_close(&file);
+        output.printf("Exported %u pages of %u bytes to %s\n", (unsigned) exported, (unsigned) pageBytes, filename);
+    }
+    else if (cmdParams.beginsWithIgnoreCase("print")) {
+        const uint32_t logPages = blackbox_get_stats().log_pages;
+
+        cmdParams.scanf("%*s %u", &pages);
+        for (uint32_t n = (pages < logPages) ? (logPages - pages) : 0; n < logPages; n++) {
+            if (!blackbox_read_page(n, sPage)) {
+                output.printf("Page %u is not valid\n", (unsigned) n);
+                continue;
+            }
+            if (pHdr->dropped > 0) {
+                output.printf("(%u records dropped)\n", pHdr->dropped);
+            }
+
+            for (uint32_t i = sizeof(*pHdr); i + BLACKBOX_REC_HDR_BYTES <= sizeof(*pHdr) + pHdr->used; ) {
+                uint32_t dt_us = 0;
+                memcpy(&dt_us, &sPage[i], sizeof(dt_us));
+                const uint8_t id = sPage[i + 4];
+                const uint8_t len = sPage[i + 5];
+                const uint64_t time_us = pHdr->start_us + dt_us;
+
+                output.printf("%u: %u.%06u s, id %3u:", pHdr->session, (unsigned) (time_us / 1000000),
+                              (unsigned) (time_us % 1000000), id);
+                for (uint8_t b = 0; b < len; b++) {
+                    output.printf(" %02X", sPage[i + BLACKBOX_REC_HDR_BYTES + b]);
+                }
+                output.putline("");
+                i += BLACKBOX_REC_HDR_BYTES + len;
+            }
+        }
+    }
+    else if (cmdParams.getLen() > 0 && cmdParams != "status") {
+        return false;
+    }
+
+    const blackbox_stats_t stats = blackbox_get_stats();
+    output.printf("Black box is %s: session %u, %u records, %u dropped, %u pages written\n",
+                  stats.recording ? "recording" : "stopped", stats.session, (unsigned) stats.records,
+                  (unsigned) stats.dropped, (unsigned) stats.pages);
+    output.printf("Log has %u of %u pages, RAM ring watermark %u pages, longest write %u ms\n",
+                  (unsigned) stats.log_pages, (unsigned) flash_raw_get_page_count(), stats.watermark, stats.max_write_ms);
+    return true;
+}
@@ -1,8 +1,10 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "FreeRTOS.h"
 #include "task.h"
+#include "queue.h"
 
 #include "ff.h"
 #include "storage.hpp"
@@ -10,14 +12,444 @@
 #include "command_handler.hpp"
 #include "lpc_sys.h"
 #include "chip_info.h"
+#include "fw_update.h"
+#include "wireless.h"
+#include "sys_config.h"
+#include "crc.h"
+#if TERMINAL_USE_CAN_BUS_HANDLER
+#include "can_isotp.h"
+#endif
 
 
 
+#if TERMINAL_USE_CAN_BUS_HANDLER
+/// The ISO-TP messages of 'canbus sendfile' are up to this size
+#define CAN_FILE_MSG_BYTES  1024
+
+/// @returns the ISO-TP session that receives the messages of 'canbus sendfile', or NULL on error
+static can_isotp_t* getCanFileSession(CharDev &output)
+{
+    static uint8_t sRxBuffer[CAN_FILE_MSG_BYTES];
+    static can_isotp_t sSession;
+    static bool sInit = false;
+    const uint8_t blockSize = 16;
+
+    if (!sInit) {
+        sInit = CAN_isotp_init(&sSession, can1, TERMINAL_CAN_ISOTP_FC_ID, TERMINAL_CAN_ISOTP_DATA_ID, false,
+                               sRxBuffer, sizeof(sRxBuffer));
+        CAN_isotp_set_flow_control(&sSession, blockSize, 0);
+    }
+    if (!sInit) {
+        output.printf("ERROR: CAN ISO-TP session could not be created\n");
+        return NULL;
+    }
+    return &sSession;
+}
+
+/**
+ * Receives a file sent by 'canbus sendfile' over ISO-TP messages of up to 1024 bytes.
+ * The sender is paced by our flow control while we write each message to the file.
+ * @returns true if the file was received
+ */
+static bool receiveFileOverCan(CharDev &output, const char *filename, int size)
+{
+    static uint8_t sFileBuffer[CAN_FILE_MSG_BYTES];
+    can_isotp_t *pSession = getCanFileSession(output);
+    int offset = 0;
+    FRESULT writeStatus = FR_OK;
+
+    if (!pSession) {
+        return false;
+    }
+
+    while (offset < size && FR_OK == writeStatus) {
+        const uint16_t bytes = CAN_isotp_recv(pSession, sFileBuffer, sizeof(sFileBuffer), 2000);
+        if (0 == bytes) {
+            break;
+        }
+
+        writeStatus = (0 == offset) ? Storage::write(filename, sFileBuffer, bytes) :
+                                      Storage::append(filename, sFileBuffer, bytes, offset);
+        offset += bytes;
+    }
+
+    if (offset != size) {
+        output.printf(FR_OK == writeStatus ? "ERROR: TIMEOUT\n" : "File write error\n");
+        return false;
+    }
+    return true;
+}
+#endif
+
+/// The state of 'file stream' shared with its writer task
+typedef struct {
+    FIL file;               ///< The file being written
+    QueueHandle_t writes;   ///< The lengths of the chunks to write, from buffers[] in turn (0 ends the task)
+    QueueHandle_t results;  ///< The FRESULT of each write, and one more when the task ends
+    char *buffers[2];       ///< One chunk is received while the other is written
+} fileStream_t;
+
+/// Writes the chunks of 'file stream' to the file, so the next chunk is received in the meantime
+static void fileStreamWriter(void *p)
+{
+    fileStream_t *s = (fileStream_t*) p;
+    unsigned int idx = 0;
+    UINT len = 0;
+
+    while (xQueueReceive(s->writes, &len, portMAX_DELAY) && len > 0) {
+        UINT written = 0;
+        FRESULT status = f_write(&s->file, s->buffers[idx], len, &written);
+        if (FR_OK == status && written != len) {
+            status = FR_DENIED; // The disk is full
+        }
+        xQueueSend(s->results, &status, portMAX_DELAY);
+        idx ^= 1;
+    }
+
+    const FRESULT status = FR_OK;
+    xQueueSend(s->results, &status, portMAX_DELAY);
+    vTaskDelete(NULL);
+}
+
+/**
+ * Receives a file in chunks that are each followed by their little-endian CRC32.  Each chunk is
+ * acknowledged by "OK <received bytes>" as soon as its CRC is good, and then it is written by the
+ * writer task while the next chunk is received, so the upload can run at the speed of the UART.
+ * The chunks are a multiple of the sector size, so FatFs writes them straight to the disk.
+ * @returns true if the file was received
+ */
+static bool receiveFileStream(CharDev &output, const char *filename, int size, int chunkSize)
+{
+    const unsigned int timeout = OS_MS(2000);
+    unsigned int idx = 0;
+    unsigned int pending = 0;
+    uint32_t fileCrc = 0;
+    int offset = 0;
+    FRESULT status = FR_OK;
+    bool ok = false;
+
+    if (size < 0 || chunkSize <= 0 || 0 != (chunkSize % 512)) {
+        output.printf("ERROR: Chunk size must be a multiple of 512 bytes\n");
+        return false;
+    }
+
+    fileStream_t *s = (fileStream_t*) malloc(sizeof(fileStream_t) + 2 * chunkSize);
+    if (!s) {
+        output.printf("ERROR: Not enough memory for %i byte chunks\n", chunkSize);
+        return false;
+    }
+    s->buffers[0] = (char*) (s + 1);
+    s->buffers[1] = s->buffers[0] + chunkSize;
+    s->writes = xQueueCreate(1, sizeof(UINT));
+    s->results = xQueueCreate(2, sizeof(FRESULT));
+
+    if (FR_OK != (status = f_open(&s->file, filename, FA_CREATE_ALWAYS | FA_WRITE))) {
+        output.printf("Unable to open '%s'\n", filename);
+    }
+    else if (!s->writes || !s->results ||
+             !xTaskCreate(fileStreamWriter, "fstream", STACK_BYTES(2048), s, PRIORITY_HIGH, NULL)) {
+        output.printf("ERROR: Unable to create the writer task\n");
+        f_close(&s->file);
+    }
+    else {
+        output.printf("READY %i\n", chunkSize);
+
+        while (offset < size)
+        {
+            const int len = (size - offset < chunkSize) ? (size - offset) : chunkSize;
+            uint8_t crc[4] = { 0 };
+            if (!output.getBlock(s->buffers[idx], len, timeout) || !output.getBlock(crc, sizeof(crc), timeout)) {
+                output.printf("ERROR: TIMEOUT\n");
+                break;
+            }
+
+            const uint32_t expected = crc[0] | (crc[1] << 8) | (crc[2] << 16) | ((uint32_t) crc[3] << 24);
+            if (crc32_update(0, s->buffers[idx], len) != expected) {
+                output.printf("ERROR: CRC %i\n", offset);
+                break;
+            }
+
+            /* The previous chunk must be written before the host sends the next one into its buffer */
+            if (pending > 0) {
+                xQueueReceive(s->results, &status, portMAX_DELAY);
+                --pending;
+                if (FR_OK != status) {
+                    output.printf("File write error\n");
+                    break;
+                }
+            }
+
+            const UINT writeLen = len;
+            xQueueSend(s->writes, &writeLen, portMAX_DELAY);
+            ++pending;
+
+            fileCrc = crc32_update(fileCrc, s->buffers[idx], len);
+            offset += len;
+            idx ^= 1;
+            output.printf("OK %i\n", offset);
+        }
+
+        /* Wait for the last write, and then stop the writer task */
+        while (pending > 0) {
+            FRESULT result = FR_OK;
+            xQueueReceive(s->results, &result, portMAX_DELAY);
+            status = (FR_OK == status) ? result : status;
+            --pending;
+        }
+        const UINT stop = 0;
+        FRESULT result = FR_OK;
+        xQueueSend(s->writes, &stop, portMAX_DELAY);
+        xQueueReceive(s->results, &result, portMAX_DELAY);
+
+        result = f_close(&s->file);
+        status = (FR_OK == status) ? result : status;
+        if (offset == size) {
+            if (FR_OK == status) {
+                output.printf("OK %i bytes, CRC32 %08X\n", offset, (unsigned int) fileCrc);
+                ok = true;
+            }
+            else {
+                output.printf("File write error\n");
+            }
+        }
+    }
+
+    if (s->writes) {
+        vQueueDelete(s->writes);
+    }
+    if (s->results) {
+        vQueueDelete(s->results);
+    }
+    free(s);
+    return ok;
+}
+
+/**
+ * Receives the file of the next wireless multicast transfer ('wireless mcast' of the sender).
+ * The blocks arrive in any order, so each one is written at its offset of the file.
+ * @param waitSec  Max seconds without any block before we give up
+ * @returns true if the whole file was received and its CRC32 is good
+ */
+static bool receiveFileMcast(CharDev &output, const char *filename, int waitSec, uint32_t *pSize, uint32_t *pCrc)
+{
+    uint8_t block[MESH_DATA_PAYLOAD_SIZE];
+    uint32_t lastRxMs = sys_get_uptime_ms();
+    uint32_t size = 0, crc = 0, fileCrc = 0;
+    FRESULT status = FR_OK;
+    FIL file;
+    bool ok = false;
+
+    if (FR_OK != f_open(&file, filename, FA_CREATE_ALWAYS | FA_WRITE | FA_READ)) {
+        output.printf("Unable to open '%s'\n", filename);
+        return false;
+    }
+
+    output.printf("Waiting for the multicast transfer\n");
+    wireless_mcast_listen(true);
+    while (FR_OK == status && !wireless_mcast_is_complete())
+    {
+        uint32_t offset = 0;
+        UINT written = 0;
+        const uint32_t bytes = wireless_mcast_recv(block, &offset, 1000);
+
+        if (bytes > 0) {
+            lastRxMs = sys_get_uptime_ms();
+            if (FR_OK == (status = f_lseek(&file, offset)) &&
+                FR_OK == (status = f_write(&file, block, bytes, &written)) && written != bytes) {
+                status = FR_DENIED; // The disk is full
+            }
+        }
+        else if (sys_get_uptime_ms() - lastRxMs > (uint32_t) waitSec * 1000) {
+            break;
+        }
+    }
+
+    if (!wireless_mcast_is_complete() || !wireless_mcast_get_file(&size, &crc)) {
+        output.printf(FR_OK == status ? "ERROR: TIMEOUT\n" : "File write error\n");
+    }
+    else if (FR_OK == (status = f_lseek(&file, 0))) {
+        /* Read back the file to check what was written */
+        UINT bytesRead = 0;
+        while (FR_OK == (status = f_read(&file, block, sizeof(block), &bytesRead)) && bytesRead > 0) {
+            fileCrc = crc32_update(fileCrc, block, bytesRead);
+        }
+        if (FR_OK == status && fileCrc == crc) {
+            output.printf("OK %u bytes, CRC32 %08X\n", (unsigned int) size, (unsigned int) crc);
+            *pSize = size;
+            *pCrc = crc;
+            ok = true;
+        }
+        else {
+            output.printf("ERROR: The CRC32 of the file is %08X instead of %08X\n",
+                          (unsigned int) fileCrc, (unsigned int) crc);
+        }
+    }
+    wireless_mcast_listen(false);
+
+    status = f_close(&file);
+    return ok && FR_OK == status;
+}
+
+/// The sources of the image of 'flash <source> <size> <crc32>'
+typedef enum {
+    fwSrcUart,      ///< Chunks with their CRC32 from the terminal, like 'file stream'
+    fwSrcBulk,      ///< Wireless bulk transfer
+    fwSrcCan,       ///< ISO-TP messages of 'canbus sendfile'
+    fwSrcFile,      ///< A file that was received before, such as by 'flash mcast'
+} fwSource_t;
+
+/**
+ * Receives a new firmware image straight into the staging region of the flash memory.
+ * Once its CRC32 is checked, the image is committed and the board reboots to apply it.
+ * @returns false if the image was not received or is not good, in which case the board does not reboot
+ */
+static bool receiveFirmware(CharDev &output, fwSource_t source, int size, uint32_t crc, FIL *pFile = NULL)
+{
+    const int chunkSize = 4096;
+    const unsigned int timeout = OS_MS(2000);
+    bool ok = true;
+
+    if (size <= 0 || size > FW_UPDATE_MAX_IMAGE_BYTES) {
+        output.printf("ERROR: The image must be 1-%u bytes\n", FW_UPDATE_MAX_IMAGE_BYTES);
+        return false;
+    }
+
+    char *pBuffer = (char*) malloc(chunkSize);
+    if (!pBuffer) {
+        output.printf("ERROR: Not enough memory\n");
+        return false;
+    }
+
+    if (!fw_update_begin(size)) {
+        output.printf("ERROR: The staging flash memory could not be erased\n");
+        ok = false;
+    }
+    else if (fwSrcUart == source) {
+        output.printf("READY %i\n", chunkSize);
+    }
+
+    #if TERMINAL_USE_CAN_BUS_HANDLER
+    can_isotp_t *pSession = (fwSrcCan == source) ? getCanFileSession(output) : NULL;
+    ok = ok && (fwSrcCan != source || NULL != pSession);
+    #endif
+
+    while (ok && (int) fw_update_get_written() < size)
+    {
+        const int remaining = size - fw_update_get_written();
+        const int wanted = (remaining < chunkSize) ? remaining : chunkSize;
+        int bytes = 0;
+
+        if (fwSrcUart == source) {
+            /* Each chunk is acknowledged after it is programmed, so the UART never overflows */
+            uint8_t chunkCrc[4] = { 0 };
+            if (!output.getBlock(pBuffer, wanted, timeout) || !output.getBlock(chunkCrc, sizeof(chunkCrc), timeout)) {
+                break;
+            }
+            const uint32_t expected = chunkCrc[0] | (chunkCrc[1] << 8) | (chunkCrc[2] << 16) | ((uint32_t) chunkCrc[3] << 24);
+            if (crc32_update(0, pBuffer, wanted) != expected) {
+                output.printf("ERROR: CRC %u\n", (unsigned int) fw_update_get_written());
+                ok = false;
+                break;
+            }
+            bytes = wanted;
+        }
+        else if (fwSrcBulk == source) {
+            bytes = wireless_bulk_recv(pBuffer, wanted, 2000);
+        }
+        else if (fwSrcFile == source) {
+            UINT bytesRead = 0;
+            if (FR_OK == f_read(pFile, pBuffer, wanted, &bytesRead)) {
+                bytes = bytesRead;
+            }
+        }
+        #if TERMINAL_USE_CAN_BUS_HANDLER
+        else if (fwSrcCan == source) {
+            bytes = CAN_isotp_recv(pSession, (uint8_t*) pBuffer, chunkSize, 2000);
+        }
+        #endif
+
+        if (bytes <= 0) {
+            break;
+        }
+        if (!fw_update_write(pBuffer, bytes)) {
+            output.printf("ERROR: Flash programming failed\n");
+            ok = false;
+        }
+        else if (fwSrcUart == source) {
+            output.printf("OK %u\n", (unsigned int) fw_update_get_written());
+        }
+    }
+    free(pBuffer);
+
+    if (!ok) {
+        return false;
+    }
+    if (!fw_update_finish()) {
+        output.printf("ERROR: TIMEOUT after %u of %i bytes\n", (unsigned int) fw_update_get_written(), size);
+        return false;
+    }
+
+    const uint32_t actualCrc = crc32_update(0, fw_update_get_image(), size);
+    if (actualCrc != crc) {
+        output.printf("ERROR: The CRC32 of the image is %08X\n", (unsigned int) actualCrc);
+        return false;
+    }
+    if (!fw_update_commit()) {
+        output.printf("ERROR: The image is not a program built for 0x%X\n", FW_UPDATE_ACTIVE_ADDR);
+        return false;
+    }
+
+    output.printf("%i bytes will be applied.\n"
+                  "Rebooting now to upgrade firmware!\n\n", size);
+    output.flush();
+    vTaskDelay(10);
+    sys_reboot();
+    return true;
+}
+
 CMD_HANDLER_FUNC(flashProgHandler)
 {
     FIL file;
     const int maxChars = 12;
 
+    /* flash <stream|bulk|can> <size> <crc32> : Program the image received while we run */
+    const bool uart = cmdParams.beginsWithIgnoreCase("stream ");
+    const bool bulk = cmdParams.beginsWithIgnoreCase("bulk ");
+    const bool can  = cmdParams.beginsWithIgnoreCase("can ");
+    if (uart || bulk || can)
+    {
+        int size = 0;
+        unsigned int crc = 0;
+        if (2 != cmdParams.scanf("%*s %i %x", &size, &crc)) {
+            return false;
+        }
+    #if !TERMINAL_USE_CAN_BUS_HANDLER
+        if (can) {
+            output.printf("CAN bus handler is not enabled at sys_config.h\n");
+            return true;
+        }
+    #endif
+        receiveFirmware(output, uart ? fwSrcUart : bulk ? fwSrcBulk : fwSrcCan, size, crc);
+        return true;
+    }
+
+    /* flash mcast <filename> [wait seconds] : Receive a multicast file, and then program it */
+    if (cmdParams.beginsWithIgnoreCase("mcast "))
+    {
+        char filename[128] = { 0 };
+        int waitSec = 60;
+        uint32_t size = 0, crc = 0;
+        if (cmdParams.scanf("%*s %127s %i", &filename[0], &waitSec) < 1) {
+            return false;
+        }
+        if (receiveFileMcast(output, filename, waitSec, &size, &crc) &&
+            FR_OK == f_open(&file, filename, FA_OPEN_EXISTING | FA_READ)) {
+            receiveFirmware(output, fwSrcFile, size, crc, &file);
+            f_close(&file);
+        }
+        return true;
+    }
+
     if (cmdParams.getLen() >= maxChars) {
         output.printf("Filename should be less than %i chars\n", maxChars);
     }
@@ -54,10 +486,85 @@ CMD_HANDLER_FUNC(getFileHandler)
 
     /**
      * Packet format:
-     * buffer <offset> <num bytes> ...
+     * buffer <offset> <num bytes> [crc] ... : Replies with the byte sum, or the CRC32 with 'crc'
      * commit <filename> <file offset> <num bytes from buffer>
+     * bulk <filename> <file size> [crc32] : Receive the file through wireless bulk transfer
+     * can <filename> <file size>   : Receive the file through CAN ISO-TP messages
+     * stream <filename> <file size> [chunk size] : Receive the file in chunks followed by their CRC32
+     * mcast <filename> [wait seconds] : Receive the file of the next wireless multicast transfer
      */
-    if (cmdParams.beginsWithIgnoreCase("commit"))
+    if (cmdParams.beginsWithIgnoreCase("bulk"))
+    {
+        char filename[128] = { 0 };
+        int size = 0;
+        int offset = 0;
+        int buffered = 0;
+        unsigned int expectedCrc = 0;
+        uint32_t crc = 0;
+        FRESULT writeStatus = FR_OK;
+        const bool checkCrc = (3 == cmdParams.scanf("%*s %128s %i %x", &filename[0], &size, &expectedCrc));
+
+        /* Write to the file once the buffer is full, or at the end of the file */
+        while (offset + buffered < size && FR_OK == writeStatus) {
+            const int wanted = (size - offset < maxBufferSize) ? (size - offset) : maxBufferSize;
+            const uint32_t bytes = wireless_bulk_recv(&spBuffer[buffered], wanted - buffered, 2000);
+            if (0 == bytes) {
+                break;
+            }
+
+            crc = crc32_update(crc, &spBuffer[buffered], bytes);
+            buffered += bytes;
+            if (buffered == wanted) {
+                writeStatus = (0 == offset) ? Storage::write(filename, spBuffer, buffered) :
+                                              Storage::append(filename, spBuffer, buffered, offset);
+                offset += buffered;
+                buffered = 0;
+            }
+        }
+
+        if (offset != size) {
+            output.printf(FR_OK == writeStatus ? "ERROR: TIMEOUT\n" : "File write error\n");
+        }
+        else if (checkCrc && crc != expectedCrc) {
+            output.printf("ERROR: CRC32 %08X\n", (unsigned int) crc);
+        }
+        else {
+            output.printf("OK\n");
+        }
+    }
+#if TERMINAL_USE_CAN_BUS_HANDLER
+    else if (cmdParams.beginsWithIgnoreCase("can "))
+    {
+        char filename[128] = { 0 };
+        int size = 0;
+        cmdParams.scanf("%*s %128s %i", &filename[0], &size);
+
+        if (receiveFileOverCan(output, filename, size)) {
+            output.printf("OK\n");
+        }
+    }
+#endif
+    else if (cmdParams.beginsWithIgnoreCase("mcast "))
+    {
+        char filename[128] = { 0 };
+        int waitSec = 60;
+        uint32_t size = 0, crc = 0;
+        if (cmdParams.scanf("%*s %127s %i", &filename[0], &waitSec) < 1) {
+            return false;
+        }
+        receiveFileMcast(output, filename, waitSec, &size, &crc);
+    }
+    else if (cmdParams.beginsWithIgnoreCase("stream "))
+    {
+        char filename[128] = { 0 };
+        int size = 0;
+        int chunkSize = 4096;
+        if (cmdParams.scanf("%*s %127s %i %i", &filename[0], &size, &chunkSize) < 2) {
+            return false;
+        }
+        receiveFileStream(output, filename, size, chunkSize);
+    }
+    else if (cmdParams.beginsWithIgnoreCase("commit"))
     {
         char filename[128] = { 0 };
         int offset = 0;
@@ -79,25 +586,32 @@ CMD_HANDLER_FUNC(getFileHandler)
         int numBytes = 0;
         int checksum = 0;
         char c = 0;
+        char check[4] = { 0 };
 
-        cmdParams.scanf("%*s %i %i", &offset, &numBytes);
+        cmdParams.scanf("%*s %i %i %3s", &offset, &numBytes, &check[0]);
 
-        if (offset + numBytes > maxBufferSize) {
+        if (offset < 0 || numBytes < 0 || offset + numBytes > maxBufferSize) {
             output.printf("ERROR: Max buffer size is %i bytes\n", maxBufferSize);
             return true;
         }
 
-        for(int i=offset; i - offset < numBytes && i < maxBufferSize; i++) {
-            if(! output.getChar(&c, OS_MS(2000))) {
-                output.printf("ERROR: TIMEOUT\n");
-                return true;
-            }
-
-            spBuffer[i] = c;
-            checksum += c;
+        /* Get the entire block at once, and then compute the checksum */
+        if (numBytes > 0 && ! output.getBlock(&spBuffer[offset], numBytes, OS_MS(2000))) {
+            output.printf("ERROR: TIMEOUT\n");
+            return true;
         }
 
-        output.printf("Checksum %i\n", checksum);
+        /* The byte sum is the reply that netload.exe expects, and the CRC32 is the better check */
+        if (0 == strcmp(check, "crc")) {
+            output.printf("CRC32 %08X\n", (unsigned int) crc32_update(0, &spBuffer[offset], numBytes));
+        }
+        else {
+            for(int i=offset; i - offset < numBytes; i++) {
+                c = spBuffer[i];
+                checksum += c;
+            }
+            output.printf("Checksum %i\n", checksum);
+        }
     }
     else {
         return false;
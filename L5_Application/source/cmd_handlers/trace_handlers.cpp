@@ -0,0 +1,297 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"               // uxTaskGetSystemState()
+
+#include "command_handler.hpp"
+#include "lpc_sys.h"            // sys_cycles_to_ns()
+#include "sys_config.h"
+#include "os_trace.h"
+
+
+
+#if (SYS_CFG_TRACE_RECORDS > 0)
+/// Header of the binary dump, followed by the task names, and the records from the oldest to the newest
+typedef struct {
+    uint32_t magic;             ///< "OSTR"
+    uint8_t version;            ///< Version of this format
+    uint8_t record_size;        ///< sizeof(os_trace_record_t)
+    uint8_t task_count;         ///< The task names that follow the header
+    uint8_t task_name_len;      ///< Bytes of each task name, after the task number byte
+    uint32_t cpu_hz;            ///< CPU clock, to convert the cycles to time
+    uint32_t record_count;      ///< The records that follow the task names
+    uint32_t overwritten;       ///< The records that were lost since the ring was full
+} trace_dump_header_t;
+
+/// The maximum tasks, interrupts and queues of the summary; the rest are not summarised
+enum { traceMaxTasks = 16, traceMaxIsrs = 16, traceMaxQueues = 24 };
+
+typedef struct {
+    uint8_t num;                ///< Task number
+    uint32_t switches;          ///< Times the task was switched in
+    uint64_t runCycles;         ///< Cycles between the switch in and out (including the interrupts)
+    uint32_t maxRunCycles;      ///< The longest time the task ran at once
+    uint32_t readyAt;           ///< When the task was made ready, if readyPending
+    bool readyPending;          ///< The task was made ready, but not yet switched in
+    bool running;               ///< The task was switched in at inAt
+    uint32_t inAt;              ///< When the task was switched in
+    uint32_t wakeups;           ///< Times the task was switched in after it was made ready
+    uint64_t latencyCycles;     ///< Total time from ready to running
+    uint32_t maxLatencyCycles;  ///< The longest time from ready to running
+} traceTaskSummary_t;
+
+typedef struct {
+    uint8_t num;                ///< Exception number
+    uint32_t count;             ///< Times the interrupt was entered
+    uint64_t cycles;            ///< Total time in the interrupt
+    uint32_t maxCycles;         ///< The longest interrupt
+    uint32_t enterAt;           ///< When the interrupt was entered, if active
+    bool active;                ///< The interrupt was entered at enterAt
+} traceIsrSummary_t;
+
+typedef struct {
+    uint16_t num;               ///< Queue number
+    uint32_t sends, recvs;      ///< Successful sends and receives, including the interrupts
+    uint32_t sendBlocks, recvBlocks;    ///< Times a task blocked since the queue was full or empty
+    uint32_t sendFails, recvFails;      ///< Timeouts and failures
+} traceQueueSummary_t;
+
+/// Returns the task, ISR or queue entry of the table with the number, or adds it
+template <typename T>
+static T* traceFind(T *table, uint32_t &count, uint32_t max, uint16_t num)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        if (table[i].num == num) {
+            return &table[i];
+        }
+    }
+    if (count >= max) {
+        return NULL;
+    }
+    memset(&table[count], 0, sizeof(T));
+    table[count].num = num;
+    return &table[count++];
+}
+
+static uint32_t traceUs(uint64_t cycles)
+{
+    return (uint32_t) (sys_cycles_to_ns(cycles > UINT32_MAX ? UINT32_MAX : (uint32_t) cycles) / 1000);
+}
+
+/// @returns the name of the task number, or "?" if the task no longer exists
+static const char* traceTaskName(const TaskStatus_t *status, uint32_t count, uint8_t num)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        if ((uint8_t) status[i].xTaskNumber == num) {
+            return status[i].pcTaskName;
+        }
+    }
+    return "?";
+}
+
+static void traceDump(CharDev &output, const TaskStatus_t *status, uint32_t taskCount)
+{
+    trace_dump_header_t header;
+    header.magic = 0x5254534F;  // "OSTR" in little-endian
+    header.version = 1;
+    header.record_size = sizeof(os_trace_record_t);
+    header.task_count = taskCount;
+    header.task_name_len = configMAX_TASK_NAME_LEN;
+    header.cpu_hz = sys_get_cpu_clock();
+    header.record_count = os_trace_get_count();
+    header.overwritten = os_trace_get_overwritten();
+    output.putBlock(&header, sizeof(header));
+
+    for (uint32_t i = 0; i < taskCount; i++) {
+        char name[1 + configMAX_TASK_NAME_LEN] = { 0 };
+        name[0] = (char) status[i].xTaskNumber;
+        strncpy(&name[1], status[i].pcTaskName, configMAX_TASK_NAME_LEN);
+        output.putBlock(name, sizeof(name));
+    }
+
+    /* The ring wraps around, so output the records in up to two blocks */
+    uint32_t i = 0;
+    while (i < header.record_count) {
+        const os_trace_record_t *first = os_trace_get_record(i);
+        uint32_t n = 1;
+        while (i + n < header.record_count && os_trace_get_record(i + n) == first + n) {
+            ++n;
+        }
+        output.putBlock(first, n * sizeof(*first));
+        i += n;
+    }
+}
+
+static void traceSummary(CharDev &output, const TaskStatus_t *status, uint32_t taskCount)
+{
+    static traceTaskSummary_t tasks[traceMaxTasks];
+    static traceIsrSummary_t isrs[traceMaxIsrs];
+    static traceQueueSummary_t queues[traceMaxQueues];
+    uint32_t nTasks = 0, nIsrs = 0, nQueues = 0;
+
+    const uint32_t count = os_trace_get_count();
+    if (0 == count) {
+        output.putline("No trace records, use 'trace start' first");
+        return;
+    }
+    const uint32_t start = os_trace_get_record(0)->cycles;
+    const uint32_t span = os_trace_get_record(count - 1)->cycles - start;
+
+    for (uint32_t i = 0; i < count; i++) {
+        const os_trace_record_t *r = os_trace_get_record(i);
+        traceTaskSummary_t *t = NULL;
+        traceIsrSummary_t *isr = NULL;
+        traceQueueSummary_t *q = NULL;
+
+        switch (r->event) {
+            case os_trace_task_ready:
+                if (NULL != (t = traceFind(tasks, nTasks, traceMaxTasks, r->id)) && !t->readyPending) {
+                    t->readyPending = true;
+                    t->readyAt = r->cycles;
+                }
+                break;
+
+            case os_trace_task_in:
+                if (NULL != (t = traceFind(tasks, nTasks, traceMaxTasks, r->id))) {
+                    t->switches++;
+                    t->running = true;
+                    t->inAt = r->cycles;
+                    if (t->readyPending) {
+                        const uint32_t latency = r->cycles - t->readyAt;
+                        t->readyPending = false;
+                        t->wakeups++;
+                        t->latencyCycles += latency;
+                        t->maxLatencyCycles = (latency > t->maxLatencyCycles) ? latency : t->maxLatencyCycles;
+                    }
+                }
+                break;
+
+            case os_trace_task_out:
+                if (NULL != (t = traceFind(tasks, nTasks, traceMaxTasks, r->id)) && t->running) {
+                    const uint32_t run = r->cycles - t->inAt;
+                    t->running = false;
+                    t->runCycles += run;
+                    t->maxRunCycles = (run > t->maxRunCycles) ? run : t->maxRunCycles;
+                }
+                break;
+
+            case os_trace_isr_enter:
+                if (NULL != (isr = traceFind(isrs, nIsrs, traceMaxIsrs, r->id))) {
+                    isr->count++;
+                    isr->active = true;
+                    isr->enterAt = r->cycles;
+                }
+                break;
+
+            case os_trace_isr_exit:
+                if (NULL != (isr = traceFind(isrs, nIsrs, traceMaxIsrs, r->id)) && isr->active) {
+                    const uint32_t cycles = r->cycles - isr->enterAt;
+                    isr->active = false;
+                    isr->cycles += cycles;
+                    isr->maxCycles = (cycles > isr->maxCycles) ? cycles : isr->maxCycles;
+                }
+                break;
+
+            case os_trace_user_mark:
+                output.fprint("Mark %u by task %s at %u us\n", r->arg, traceTaskName(status, taskCount, r->id),
+                              (unsigned) traceUs(r->cycles - start));
+                break;
+
+            case os_trace_user_mark_isr:
+                output.fprint("Mark %u by IRQ %d at %u us\n", r->arg, (int) r->id - 16,
+                              (unsigned) traceUs(r->cycles - start));
+                break;
+
+            default:
+                if (r->event >= os_trace_queue_send && r->event <= os_trace_queue_recv_isr_failed &&
+                    NULL != (q = traceFind(queues, nQueues, traceMaxQueues, r->arg)))
+                {
+                    switch (r->event) {
+                        case os_trace_queue_send:
+                        case os_trace_queue_send_isr:           q->sends++;      break;
+                        case os_trace_queue_send_block:         q->sendBlocks++; break;
+                        case os_trace_queue_send_failed:
+                        case os_trace_queue_send_isr_failed:    q->sendFails++;  break;
+                        case os_trace_queue_recv:
+                        case os_trace_queue_recv_isr:           q->recvs++;      break;
+                        case os_trace_queue_recv_block:         q->recvBlocks++; break;
+                        default:                                q->recvFails++;  break;
+                    }
+                }
+                break;
+        }
+    }
+
+    output.fprint("%u records over %u us, %u overwritten\n",
+                  (unsigned) count, (unsigned) traceUs(span), (unsigned) os_trace_get_overwritten());
+
+    output.fprint("\n%3s %8s %8s %10s %8s %8s %8s\n", "#", "Task", "Switches", "Run us", "Max us",
+                  "Wake avg", "Wake max");
+    for (uint32_t i = 0; i < nTasks; i++) {
+        const traceTaskSummary_t *t = &tasks[i];
+        output.fprint("%3u %8s %8u %10u %8u %8u %8u\n", t->num, traceTaskName(status, taskCount, t->num),
+                      (unsigned) t->switches, (unsigned) traceUs(t->runCycles), (unsigned) traceUs(t->maxRunCycles),
+                      (unsigned) (t->wakeups ? traceUs(t->latencyCycles / t->wakeups) : 0),
+                      (unsigned) traceUs(t->maxLatencyCycles));
+    }
+
+    if (nIsrs > 0) {
+        output.fprint("\n%3s %8s %10s %8s %8s\n", "IRQ", "Count", "Total us", "Avg us", "Max us");
+    }
+    for (uint32_t i = 0; i < nIsrs; i++) {
+        const traceIsrSummary_t *isr = &isrs[i];
+        output.fprint("%3d %8u %10u %8u %8u\n", (int) isr->num - 16, (unsigned) isr->count,
+                      (unsigned) traceUs(isr->cycles),
+                      (unsigned) (isr->count ? traceUs(isr->cycles / isr->count) : 0),
+                      (unsigned) traceUs(isr->maxCycles));
+    }
+
+    if (nQueues > 0) {
+        output.fprint("\n%5s %8s %8s %8s %8s %8s %8s\n", "Queue", "Sends", "Full", "Failed",
+                      "Receives", "Empty", "Failed");
+    }
+    for (uint32_t i = 0; i < nQueues; i++) {
+        const traceQueueSummary_t *q = &queues[i];
+        output.fprint("%5u %8u %8u %8u %8u %8u %8u\n", q->num,
+                      (unsigned) q->sends, (unsigned) q->sendBlocks, (unsigned) q->sendFails,
+                      (unsigned) q->recvs, (unsigned) q->recvBlocks, (unsigned) q->recvFails);
+    }
+}
+
+CMD_HANDLER_FUNC(traceHandler)
+{
+    if (cmdParams == "start" || cmdParams == "start all") {
+        os_trace_start(cmdParams == "start all" ? os_trace_all : os_trace_default);
+        output.putline("Trace started");
+        return true;
+    }
+    else if (cmdParams == "stop") {
+        os_trace_stop();
+    }
+    else if (cmdParams != "dump" && cmdParams != "summary" && cmdParams.getLen() > 0) {
+        return false;
+    }
+
+    /* Do not let the records change while we read them */
+    if (os_trace_is_running() && cmdParams.getLen() > 0) {
+        os_trace_stop();
+        output.putline("Trace stopped");
+    }
+
+    TaskStatus_t status[traceMaxTasks];
+    const uint32_t taskCount = uxTaskGetSystemState(&status[0], traceMaxTasks, NULL);
+
+    if (cmdParams == "dump") {
+        traceDump(output, status, taskCount);
+    }
+    else if (cmdParams == "summary") {
+        traceSummary(output, status, taskCount);
+    }
+    else {
+        output.fprint("Trace is %s with %u records, %u overwritten\n", os_trace_is_running() ? "running" : "stopped",
+                      (unsigned) os_trace_get_count(), (unsigned) os_trace_get_overwritten());
+    }
+    return true;
+}
+#endif /* SYS_CFG_TRACE_RECORDS */
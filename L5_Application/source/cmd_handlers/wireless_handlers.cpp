@@ -1,11 +1,16 @@
 #include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
 
 #include "command_handler.hpp"
 #include "wireless.h"
+#include "wireless_can.h"
 #include "nrf_stream.hpp"
+#include "lpc_sys.h"
 #include "ff.h"
+#include "crc.h"
+#include "tlm/c_tlm_var.h"
 
 
 
@@ -105,12 +110,14 @@ static CMD_HANDLER_FUNC(wsFileTxHandler)
 {
     /**
      * If other node is running same software, we will just use its "file" handler:
-     * buffer <offset> <num bytes> ...
-     * commit <filename> <file offset> <num bytes from buffer>
+     * bulk <filename> <file size> <crc32>
+     * The file data is then sent using the sliding window of wireless_bulk_send(), and the
+     * other node checks the CRC32 of all of the data before it replies "OK".
      */
     char srcFile[128] = { 0 };
     char dstFile[128] = { 0 };
-    int timeout = 1000;
+    const int timeout = 3000;
+    const int max_hops_to_use = 2;
     int addr = 0;
     FIL file;
 
@@ -126,65 +133,173 @@ static CMD_HANDLER_FUNC(wsFileTxHandler)
 
     char c = 0;
     char buffer[512];
-    int expectedChecksum = 0;
     unsigned int bytesRead = 0;
     unsigned int fileOffset = 0;
-    unsigned int retries = 0;
-    unsigned int retriesMax = 3;
     STR_ON_STACK(response, 128);
 
-    // Sorry for the dirty hack #define
-    #define doRetry() ++retries; n.printf("\n"); n.flush(); while (n.getChar(&c, timeout)); goto retry
+    // Flush any stale data:
+    while (n.getChar(&c, 5)) {
+        ;
+    }
+
+    uint32_t crc = 0;
+    while (FR_OK == f_read(&file, buffer, sizeof(buffer), &bytesRead) && bytesRead > 0) {
+        crc = crc32_update(crc, buffer, bytesRead);
+    }
+    f_lseek(&file, 0);
 
     output.printf("Transfer %s --> %i:%s\n", srcFile, addr, dstFile);
+    n.printf("file bulk %s %u %08X\n", dstFile, (unsigned int) file.fsize, (unsigned int) crc);
+    n.flush();
+
+    if (!wireless_bulk_open(addr, max_hops_to_use)) {
+        output.printf("ERROR: Remote node did not respond\n");
+        f_close(&file);
+        return true;
+    }
+
+    const unsigned int startMs = sys_get_uptime_ms();
     while(FR_OK == f_read(&file, buffer, sizeof(buffer), &bytesRead) && bytesRead > 0)
     {
-        retry:
-        if (retries >= retriesMax) {
+        if (!wireless_bulk_send(buffer, bytesRead)) {
+            output.printf("ERROR: Remote node stopped acknowledging at %u\n", fileOffset);
             break;
         }
+        fileOffset += bytesRead;
+        output.printf("Sent %i/%i\n", fileOffset, file.fsize);
+    }
+    const unsigned int elapsedMs = sys_get_uptime_ms() - startMs;
 
-        n.printf("file buffer 0 %i\n", bytesRead);
-        n.flush();
-
-        expectedChecksum = 0;
-        for (unsigned int i=0; i < bytesRead; i++) {
-            n.putChar(buffer[i]);
-            expectedChecksum += buffer[i];
-        }
-        n.flush();
-
-        // Confirm the checksum: response should be something like "Checksum: 123"
-        n.gets((char*) response(), response.getCapacity(), timeout);
-        response.eraseFirstWords(1);
-        if ( (int)response != expectedChecksum) {
-            output.printf("ERROR: Checksum Expected %i Actual %i\n", expectedChecksum, (int) response);
-            doRetry();
-        }
-
-        // Make sure the file was written correctly, response should be "OK"
-        n.printf("file commit %s %i %i\n", dstFile, fileOffset, bytesRead);
-        n.flush();
+    // Make sure the file was written correctly, response should be "OK"
+    if (fileOffset == file.fsize) {
         n.gets((char*) response(), response.getCapacity(), timeout);
         if (!response.containsIgnoreCase("ok")) {
             output.printf("ERROR: Remote node did not acknowledge file write (%s)\n", response());
-            doRetry();
         }
+        else {
+            output.printf("Transferred %u bytes in %u ms\n", fileOffset, elapsedMs);
+        }
+    }
 
-        response = "";
-        fileOffset += bytesRead;
-        output.printf("Sent %i/%i\n", fileOffset, file.fsize);
+    f_close(&file);
+    return true;
+}
 
-        // Reset the retries such that only if we fail continuously we will give up
-        if (retries > 0) {
-            --retries;
-        }
+/// Reads the data of 'wireless mcast' from the file
+static bool wsMcastRead(void *data, uint32_t offset, uint32_t len, void *arg)
+{
+    FIL *pFile = (FIL*) arg;
+    unsigned int bytesRead = 0;
+    return (FR_OK == f_lseek(pFile, offset) && FR_OK == f_read(pFile, data, len, &bytesRead) && len == bytesRead);
+}
+
+static CMD_HANDLER_FUNC(wsMcastHandler)
+{
+    /**
+     * The other nodes receive the file by 'file mcast <filename>' or 'flash mcast <filename>'
+     * which should be started before this.
+     */
+    char srcFile[128] = { 0 };
+    int max_hops_to_use = 2;
+    FIL file;
+
+    if (cmdParams.scanf("%128s %i", &srcFile[0], &max_hops_to_use) < 1) {
+        return false;
+    }
+    if (FR_OK != f_open(&file, srcFile, FA_OPEN_EXISTING | FA_READ)) {
+        return false;
+    }
+
+    /* The receivers check the whole file against its CRC32 */
+    char buffer[512];
+    unsigned int bytesRead = 0;
+    uint32_t crc = 0;
+    while (FR_OK == f_read(&file, buffer, sizeof(buffer), &bytesRead) && bytesRead > 0) {
+        crc = crc32_update(crc, buffer, bytesRead);
+    }
+
+    output.printf("Multicast %s (%u bytes, CRC32 %08X)\n", srcFile, (unsigned int) file.fsize, (unsigned int) crc);
+    const unsigned int startMs = sys_get_uptime_ms();
+    if (wireless_mcast_send(file.fsize, crc, max_hops_to_use, wsMcastRead, &file)) {
+        output.printf("Transferred %u bytes in %u ms\n", (unsigned int) file.fsize, sys_get_uptime_ms() - startMs);
+    }
+    else {
+        output.printf("ERROR: Receivers are still missing blocks, or the file could not be read\n");
     }
 
     f_close(&file);
     return true;
 }
 
+static CMD_HANDLER_FUNC(wsTlmHandler)
+{
+    /**
+     * Each variable is given by its "comp:var" name, which is looked up in our own telemetry,
+     * or by its "<comp idx>.<var idx>" ID of the binary telemetry stream of the other node.
+     */
+    wireless_tlm_id_t ids[WIRELESS_TLM_MAX_VARS];
+    uint32_t sizes[WIRELESS_TLM_MAX_VARS] = { 0 };  ///< Sizes of the variables we know
+    uint8_t values[WIRELESS_TLM_MAX_BYTES];
+    uint32_t len = 0;
+    uint16_t missing = 0;
+    uint8_t count = 0;
+
+    const str *pToken = cmdParams.getToken(" ", true);
+    const int addr = pToken ? atoi(pToken->c_str()) : 0;
+    if (0 == addr) {
+        return false;
+    }
+
+    while (count < WIRELESS_TLM_MAX_VARS && NULL != (pToken = cmdParams.getToken(" ")))
+    {
+        char compName[48] = { 0 };
+        char varName[48] = { 0 };
+        unsigned int comp = 0, var = 0;
+
+        if (2 == sscanf(pToken->c_str(), "%47[^:]:%47s", compName, varName)) {
+            const tlm_reg_var_type *pVar = tlm_variable_get_by_comp_and_name(compName, varName);
+            uint32_t compIdx = 0, varIdx = 0;
+            if (NULL == pVar || !tlm_variable_get_indexes(compName, varName, &compIdx, &varIdx)) {
+                output.printf("%s is not one of our telemetry variables\n", pToken->c_str());
+                return true;
+            }
+            comp = compIdx;
+            var = varIdx;
+            sizes[count] = pVar->elm_size_bytes * pVar->elm_arr_size;
+        }
+        else if (2 != sscanf(pToken->c_str(), "%u.%u", &comp, &var)) {
+            return false;
+        }
+        ids[count].comp = comp;
+        ids[count].var = var;
+        count++;
+    }
+    if (0 == count) {
+        return false;
+    }
+
+    if (!wireless_tlm_query(addr, 2, ids, count, values, &len, &missing, 1000)) {
+        output.printf("No reply from %i\n", addr);
+        return true;
+    }
+
+    /* Print the bytes of each variable we know the size of, and the rest at once */
+    uint32_t offset = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        output.printf("%u.%u: ", ids[i].comp, ids[i].var);
+        if (missing & (1 << i)) {
+            output.printf("not found\n");
+            continue;
+        }
+        const uint32_t end = (sizes[i] > 0 && offset + sizes[i] <= len) ? (offset + sizes[i]) : len;
+        while (offset < end) {
+            output.printf("%02X", values[offset++]);
+        }
+        output.printf("\n");
+    }
+    return true;
+}
+
 static CMD_HANDLER_FUNC(wsRxHandler)
 {
     bool rx = false;
@@ -246,10 +361,67 @@ static CMD_HANDLER_FUNC(wsStatsHandler)
 {
     mesh_stats_t stats = mesh_get_stats();
     wirelessHandlerPrintStats(output, &stats, mesh_get_node_address());
+    output.printf("Free RX packet buffers: %u/%u\n",
+                  (unsigned int) wireless_pkt_get_free_count(), (unsigned int) WIRELESS_PKT_POOL_SIZE);
+    output.printf("Channel: %u MHz, %u%% busy or lost\n",
+                  (unsigned int) wireless_get_channel_mhz(), (unsigned int) wireless_get_channel_bad_percent());
+    if (wireless_time_is_synced()) {
+        output.printf("Network time: stratum %u, error %i us\n",
+                      (unsigned int) wireless_time_get_stratum(), (int) wireless_time_get_error_us());
+    }
+
+    // Print the measured round trip time of each route, and the ACK timeout based on it
+    const mesh_rte_table_t *e = NULL;
+    uint8_t i = 0;
+    if (mesh_get_num_routing_entries() > 0) {
+        output.printf("DST: RTT +/- VAR, ACK timeout (ms)\n");
+    }
+    while ((e = mesh_get_routing_entry(i++))) {
+        if (e->srtt_x8) {
+            output.printf("%3i: %u +/- %u, %u\n", e->dst, e->srtt_x8 / 8, e->rttvar_x4 / 4,
+                          (unsigned int) mesh_get_expected_ack_time(e->dst));
+        }
+        else {
+            output.printf("%3i: not measured, %u\n", e->dst, (unsigned int) mesh_get_expected_ack_time(e->dst));
+        }
+    }
+
+    #if MESH_USE_LINK_STATISTICS
+    // Print the statistics of each node, and the retry and RTT histograms
+    const mesh_link_stats_t *l = NULL;
+    for (i = 0; i < MESH_LINK_STATS_SIZE; i++) {
+        if (NULL == (l = mesh_get_link_stats(i))) {
+            continue;
+        }
+        output.printf("%3i: ACKed %u, failed %u, dup %u, drops %u, route changes %u\n",
+                      l->node, l->pkts_acked, l->pkts_failed, l->duplicates, l->queue_drops, l->route_changes);
+        output.printf("     retries:");
+        for (uint8_t b = 0; b < MESH_LINK_RETRY_BINS; b++) {
+            output.printf(" %u", l->retry_hist[b]);
+        }
+        output.printf("\n     RTT (ms) :");
+        for (uint8_t b = 0; b < MESH_LINK_RTT_BINS - 1; b++) {
+            output.printf(" <%u:%u", (2U << b), l->rtt_hist[b]);
+        }
+        output.printf(" more:%u", l->rtt_hist[MESH_LINK_RTT_BINS - 1]);
+        output.printf("\n");
+    }
+    #endif
     return true;
 }
 #endif
 
+static CMD_HANDLER_FUNC(wsCanHandler)
+{
+    const wireless_can_stats_t stats = wireless_can_get_stats();
+    output.printf("CAN to mesh: %u frames in %u packets, %u replaced by a newer frame\n",
+                  (unsigned) stats.to_mesh_frames, (unsigned) stats.to_mesh_pkts, (unsigned) stats.coalesced);
+    output.printf("Mesh to CAN: %u frames of %u packets, %u packets lost\n",
+                  (unsigned) stats.to_can_frames, (unsigned) stats.to_can_pkts, (unsigned) stats.lost_pkts);
+    output.printf("Rate limited: %u, failed: %u\n", (unsigned) stats.limited, (unsigned) stats.failed);
+    return true;
+}
+
 static CMD_HANDLER_FUNC(wsTxHandler)
 {
     char *addr_str = NULL;
@@ -345,27 +517,32 @@ static CMD_HANDLER_FUNC(sendTxHandler)
     return true;
 }
 
+CMD_DEFINE_HANDLER(wireless, wsStreamHandler,  "stream",   "'stream <addr> <msg>' : Stream a command to another board");
+CMD_DEFINE_HANDLER(wireless, wsFileTxHandler,  "transfer", "'transfer <src filename> <dst filename> <naddr>' : Transfer a file to another board");
+CMD_DEFINE_HANDLER(wireless, wsMcastHandler,   "mcast",    "'mcast <filename> [hops]' : Send a file to all the boards running 'file mcast' or 'flash mcast'");
+CMD_DEFINE_HANDLER(wireless, wsTlmHandler,     "tlm",      "'tlm <addr> <comp:var | comp idx.var idx> ...' : Read the telemetry of another board");
+CMD_DEFINE_HANDLER(wireless, wsRxHandler,      "rx",       "'rx <time_ms>' : Poll for a packet");
+CMD_DEFINE_HANDLER(wireless, wsAddrHandler,    "addr",     "'addr <addr>   : Set the wireless address");
+CMD_DEFINE_HANDLER(wireless, wsRteHandler,     "routes",   "'routes' : See the wireless routes");
+CMD_DEFINE_HANDLER(wireless, wsCanHandler,     "cangw",    "'cangw' : See the counters of the CAN gateway (wireless_can.h)");
+
+/* The data parameter of wsTxHandler() is non-zero to wait for the acknowledgment */
+CMD_DEFINE_HANDLER_PARAM(wireless, wsTxHandler,   "ack",  "'ack <addr> <data>'  : Send a packet and wait for acknowledgment", 1);
+CMD_DEFINE_HANDLER_PARAM(wireless, wsTxHandler,   "nack", "'nack <addr> <data>' : Send a packet", 0);
+CMD_DEFINE_HANDLER_PARAM(wireless, sendTxHandler, "send", "'send <addr> <cmd> <parameter>' : Send a packet", 0);
+
+#if MESH_USE_STATISTICS
+CMD_DEFINE_HANDLER(wireless, wsStatsHandler,   "stats", "'stats' : See the wireless stats");
+#endif
+
 CMD_HANDLER_FUNC(wirelessHandler)
 {
+    /* The commands are the table of CMD_DEFINE_HANDLER(), so nothing is allocated */
     static CommandProcessor *pCmdProcessor = NULL;
     if (NULL == pCmdProcessor)
     {
-        pCmdProcessor = new CommandProcessor(8);
-        pCmdProcessor->addHandler(wsStreamHandler,  "stream",   "'stream <addr> <msg>' : Stream a command to another board");
-        pCmdProcessor->addHandler(wsFileTxHandler,  "transfer", "'transfer <src filename> <dst filename> <naddr>' : Transfer a file to another board");
-        pCmdProcessor->addHandler(wsRxHandler,      "rx",       "'rx <time_ms>' : Poll for a packet");
-        pCmdProcessor->addHandler(wsAddrHandler,    "addr",     "'addr <addr>   : Set the wireless address");
-        pCmdProcessor->addHandler(wsRteHandler,     "routes",   "'routes' : See the wireless routes");
-
-        void *ack = (void*) 1;
-        void *nack = 0;
-        pCmdProcessor->addHandler(wsTxHandler,      "ack",  "'ack <addr> <data>'  : Send a packet and wait for acknowledgment", ack);
-        pCmdProcessor->addHandler(wsTxHandler,      "nack", "'nack <addr> <data>' : Send a packet", nack);
-        pCmdProcessor->addHandler(sendTxHandler,      "send", "'send <addr> <cmd> <parameter>' : Send a packet", nack);
-
-        #if MESH_USE_STATISTICS
-        pCmdProcessor->addHandler(wsStatsHandler,   "stats", "'stats' : See the wireless stats");
-        #endif
+        pCmdProcessor = new CommandProcessor(0);
+        pCmdProcessor->addTable("wireless");
     }
 
     /* Display help for empty command */
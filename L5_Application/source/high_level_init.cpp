@@ -28,6 +28,8 @@
 
 #include "fat/disk/sd.h"        // Initialize SD Card Pins for CS, WP, and CD
 #include "fat/disk/spi_flash.h" // Initialize Flash CS pin
+#include "fat/disk/disk_async.h" // Start the disk I/O task
+#include "fat/disk/diskio.h"     // Create the locks of the drives
 
 #include "rtc.h"             // RTC init
 #include "i2c2.hpp"          // I2C2 init
@@ -36,13 +38,20 @@
 #include "ssp1.h"            // SPI-1 init
 
 #include "file_logger.h"
+#include "crash_snapshot.h"  // Persist the crash snapshot
 #include "storage.hpp"       // Mount Flash & SD Storage
 #include "bio.h"             // Init io signals
 #include "io.hpp"            // Board IO peripherals
 
 #include "wireless.h"
+#include "can.h"             // CAN traffic statistics telemetry
 #include "fault_registers.h"
+#include "os_latency.h"     // Start the interrupt latency probe
+#include "FreeRTOS.h"
+#include "task.h"
+#include "event_groups.h"
 #include "c_tlm_comp.h"
+#include "c_tlm_var.h"
 
 
 
@@ -75,6 +84,69 @@ static void hl_handle_board_id(void);
 /// Prints out the board programming info (how many times the board was programmed etc.)
 static void hl_show_prog_info(void);
 
+/**
+ * @{ Boot stages
+ * The boot after the wireless init is a graph of stages, where a stage runs after the stages
+ * it depends on.  The stages run in the order of the table, or if SYS_CFG_BOOT_TASKS is non-zero,
+ * the stages that are not needed before the OS starts run in that many tasks once the scheduler
+ * runs, so the stages that are independent of each other run at the same time, and the SD card
+ * is mounted by its first file access.
+ */
+static void hl_stage_console(void);    ///< Startup delay and boot info
+static void hl_stage_flash(void);      ///< Mounts the flash memory, and formats it if needed
+static void hl_stage_sd_card(void);    ///< Mounts the SD card
+static void hl_stage_board_io(void);   ///< Initializes the board sensors and the LED display
+static void hl_stage_board_id(void);   ///< Board ID and programming info
+static void hl_stage_boot_log(void);   ///< Logs the boot message (SYS_CFG_LOG_BOOT_INFO_FILENAME)
+static void hl_stage_disk_io(void);    ///< Starts the disk I/O task
+static void hl_stage_logger(void);     ///< Starts the logger
+
+typedef enum {
+    hl_console, hl_flash, hl_sd_card, hl_board_io, hl_node_addr,
+    hl_board_id, hl_boot_log, hl_disk_io, hl_logger, hl_num_stages
+} hl_stage_t;
+
+#define HL_DEP(stage)   (1 << (stage))  ///< The bit of a stage in the dependencies of another stage
+
+typedef struct {
+    const char *name;       ///< Name printed with the boot time of the stage
+    void (*init)(void);     ///< The function of the stage
+    uint32_t depends;       ///< Bits (HL_DEP()) of the stages this stage depends on
+    bool before_os;         ///< The stage is needed by scheduler_start(), such as the disk telemetry file
+    uint32_t start_us;      ///< Uptime when the stage started
+    uint32_t end_us;        ///< Uptime when the stage finished
+} hl_boot_stage_t;
+
+/// The boot stages; a stage can only depend on the stages before it
+static hl_boot_stage_t g_stages[hl_num_stages] = {
+    { "console",   hl_stage_console,               0,                                         false, 0, 0 },
+    { "flash",     hl_stage_flash,                 0,                                         true,  0, 0 },
+    { "sd_card",   hl_stage_sd_card,               0,                                         false, 0, 0 },
+    { "board_io",  hl_stage_board_io,              0,                                         false, 0, 0 },
+    { "node_addr", hl_wireless_set_addr_from_file, HL_DEP(hl_flash),                          true,  0, 0 },
+    { "board_id",  hl_stage_board_id,              HL_DEP(hl_console) | HL_DEP(hl_board_io),  false, 0, 0 },
+    { "boot_log",  hl_stage_boot_log,              HL_DEP(hl_flash),                          false, 0, 0 },
+    { "disk_io",   hl_stage_disk_io,               HL_DEP(hl_flash),                          true,  0, 0 },
+    { "logger",    hl_stage_logger,                HL_DEP(hl_flash) | HL_DEP(hl_disk_io),     false, 0, 0 },
+};
+
+static uint32_t g_wireless_ready_us = 0;    ///< Uptime when the wireless (mesh) was initialized
+
+/// Runs a stage, and records its boot time
+static void hl_run_stage(hl_boot_stage_t *stage);
+
+/// Prints the boot time of each stage
+static void hl_print_boot_times(void);
+
+#if SYS_CFG_BOOT_TASKS
+/// The tasks that run the boot stages once the scheduler starts
+static void hl_boot_task(void *p);
+static EventGroupHandle_t g_boot_done = NULL;   ///< Bits of the stages done
+static uint32_t g_boot_claimed = 0;             ///< Bits of the stages taken by the boot tasks
+static uint8_t g_boot_tasks = 0;                ///< Number of the boot tasks that are running
+#endif
+/** @} */
+
 
 
 /**
@@ -95,6 +167,9 @@ void high_level_init(void)
     adc0_init();
     ssp1_init();
     ssp0_init(SYS_CFG_SPI0_CLK_MHZ);
+    if (!disk_lock_init()) {
+        puts("ERROR: Failed to create the locks of the drives");
+    }
     if (!I2C2::getInstance().init(SYS_CFG_I2C2_CLK_KHZ)) {
         puts("ERROR: Possible short on SDA or SCL wire (I2C2)!");
     }
@@ -111,6 +186,11 @@ void high_level_init(void)
      */
     lpc_sys_setup_system_timer();
 
+    /* Measure the interrupt entry latency reported by the 'health' command */
+    #if SYS_CFG_LATENCY_PROBE
+        os_latency_probe_start();
+    #endif
+
     /* After the Nordic SPI is initialized, initialize the wireless system asap otherwise
      * the background task may access NULL pointers of the mesh networking task.
      *
@@ -120,13 +200,142 @@ void high_level_init(void)
     if (!wireless_init()) {
         puts("ERROR: Failed to initialize wireless");
     }
+    g_wireless_ready_us = (uint32_t) sys_get_uptime_us();
 
     /* Add default telemetry components if telemetry is enabled */
     #if SYS_CFG_ENABLE_TLM
         tlm_component_add(SYS_CFG_DISK_TLM_NAME);
         tlm_component_add(SYS_CFG_DEBUG_DLM_NAME);
+
+        /* The statistics of each node of the mesh network (array of mesh_link_stats_t) */
+        #if MESH_USE_LINK_STATISTICS
+        tlm_variable_register(tlm_component_add("wireless"), "link_stats", mesh_get_link_stats_table(),
+                              sizeof(mesh_link_stats_t), MESH_LINK_STATS_SIZE, tlm_binary);
+        #endif
+
+        /* The traffic statistics of the CAN buses (can_stats_t), which are zero until CAN_init() */
+        {
+            tlm_component *pCanTlm = tlm_component_add("can");
+            tlm_variable_register(pCanTlm, "can1_stats", CAN_get_stats(can1), sizeof(can_stats_t), 1, tlm_binary);
+            tlm_variable_register(pCanTlm, "can2_stats", CAN_get_stats(can2), sizeof(can_stats_t), 1, tlm_binary);
+        }
     #endif
 
+#if SYS_CFG_BOOT_TASKS
+    /* Run the stages needed before the OS, and leave the rest to the boot tasks */
+    uint32_t done = 0;
+    for (int i = 0; i < hl_num_stages; i++) {
+        if (g_stages[i].before_os) {
+            hl_run_stage(&g_stages[i]);
+            done |= HL_DEP(i);
+        }
+    }
+
+    g_boot_claimed = done;
+    g_boot_done = xEventGroupCreate();
+    if (NULL != g_boot_done) {
+        xEventGroupSetBits(g_boot_done, done);
+        for (int i = 0; i < SYS_CFG_BOOT_TASKS; i++) {
+            if (pdPASS == xTaskCreate(hl_boot_task, "boot", STACK_BYTES(2048), NULL, PRIORITY_MEDIUM, NULL)) {
+                ++g_boot_tasks;
+            }
+        }
+    }
+
+    /* Without any boot task, run the rest here */
+    if (0 == g_boot_tasks) {
+        puts("ERROR: Failed to create the boot tasks");
+        for (int i = 0; i < hl_num_stages; i++) {
+            if (!(done & HL_DEP(i))) {
+                hl_run_stage(&g_stages[i]);
+            }
+        }
+        hl_print_boot_times();
+    }
+#else
+    for (int i = 0; i < hl_num_stages; i++) {
+        hl_run_stage(&g_stages[i]);
+    }
+    hl_print_boot_times();
+#endif
+
+    /* and finally ... call the user's main() method */
+    puts("Calling your main()");
+    hl_print_line();
+}
+
+static void hl_run_stage(hl_boot_stage_t *stage)
+{
+    stage->start_us = (uint32_t) sys_get_uptime_us();
+    stage->init();
+    stage->end_us = (uint32_t) sys_get_uptime_us();
+}
+
+static void hl_print_boot_times(void)
+{
+    printf("Boot times (ms): wireless ready at %u\n", (unsigned) (g_wireless_ready_us / 1000));
+    for (int i = 0; i < hl_num_stages; i++) {
+        const hl_boot_stage_t *stage = &g_stages[i];
+        printf("  %-10s start %5u, took %5u\n", stage->name,
+               (unsigned) (stage->start_us / 1000), (unsigned) ((stage->end_us - stage->start_us) / 1000));
+    }
+
+    /* Print memory information after the boot */
+    char buff[512] = { 0 };
+    sys_get_mem_info_str(buff);
+    printf("%s", buff);
+    hl_print_line();
+}
+
+#if SYS_CFG_BOOT_TASKS
+static void hl_boot_task(void *p)
+{
+    const EventBits_t all = HL_DEP(hl_num_stages) - 1;
+    bool last = false;
+
+    for (;;) {
+        const EventBits_t done = xEventGroupGetBits(g_boot_done);
+        hl_boot_stage_t *stage = NULL;
+        int i = 0;
+
+        /* Take the first stage whose dependencies are done */
+        taskENTER_CRITICAL();
+        for (i = 0; i < hl_num_stages; i++) {
+            if (!(g_boot_claimed & HL_DEP(i)) && (g_stages[i].depends & done) == g_stages[i].depends) {
+                g_boot_claimed |= HL_DEP(i);
+                stage = &g_stages[i];
+                break;
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        if (stage) {
+            hl_run_stage(stage);
+            xEventGroupSetBits(g_boot_done, HL_DEP(i));
+        }
+        else if (all == g_boot_claimed) {
+            break;
+        }
+        else {
+            /* Wait for another task to finish a stage that the remaining stages may depend on */
+            xEventGroupWaitBits(g_boot_done, all & ~done, pdFALSE, pdFALSE, portMAX_DELAY);
+        }
+    }
+
+    /* The last task to exit has all the stages done */
+    taskENTER_CRITICAL();
+    last = (0 == --g_boot_tasks);
+    taskEXIT_CRITICAL();
+
+    if (last) {
+        hl_print_boot_times();
+    }
+    vTaskDelete(NULL);
+}
+#endif
+
+static void hl_stage_console(void)
+{
     /**
      * User configured startup delay to close Hyperload COM port and re-open it at Hercules serial window.
      * Since the timer is setup that is now resetting the watchdog, we can delay without a problem.
@@ -136,7 +345,10 @@ void high_level_init(void)
 
     /* Print out CPU speed and what caused the system boot */
     hl_print_boot_info();
+}
 
+static void hl_stage_flash(void)
+{
     /**
      * If Flash is not mounted, it is probably a new board and the flash is not
      * formatted so format it, so alert the user, and try to re-mount it.
@@ -156,12 +368,24 @@ void high_level_init(void)
         }
     }
 
-    hl_mount_storage(Storage::getSDDrive(), "SD Card");
+    /* The snapshot of the crash is written now if the SPI was busy during the HardFault */
+    crash_snapshot_persist();
+}
 
-	/* SD card initialization modifies the SPI speed, so after it has been initialized, reset desired speed for spi1 */
-    ssp1_set_max_clock(SYS_CFG_SPI1_CLK_MHZ);
+static void hl_stage_sd_card(void)
+{
+    /* The boot tasks do not wait for the SD card, it is initialized by its first access */
+    #if SYS_CFG_BOOT_TASKS
+        Storage::getSDDrive().mount(true);
+        puts("SD Card: Mounted on first access");
+    #else
+        hl_mount_storage(Storage::getSDDrive(), "SD Card");
+    #endif
     hl_print_line();
+}
 
+static void hl_stage_board_io(void)
+{
     /* Initialize all sensors of this board and display "--" on the LED display if an error has occurred. */
     if(!hl_init_board_io()) {
         hl_print_line();
@@ -170,41 +394,45 @@ void high_level_init(void)
         LE.setAll(0xFF);
     }
     else {
-        LD.setNumber(TS.getFarenheit());
+        LD.setNumber(TS.getFarenheitX100() / 100);
     }
 
-    /* After Flash memory is mounted, try to set node address from a file */
-    hl_wireless_set_addr_from_file();
-
     /* Feed the random seed to get random numbers from the rand() function */
     srand(LS.getRawValue() + time(NULL));
+}
 
-    /* Print memory information before we call main() */
-    do {
-        char buff[512] = { 0 };
-        sys_get_mem_info_str(buff);
-        printf("%s", buff);
-        hl_print_line();
-    } while(0);
-
+static void hl_stage_board_id(void)
+{
     /* Print miscellaneous info */
     hl_handle_board_id();
     hl_show_prog_info();
     hl_print_line();
+}
 
+static void hl_stage_boot_log(void)
+{
     /* File I/O is up, so log the boot message if chosen by the user */
     #ifdef SYS_CFG_LOG_BOOT_INFO_FILENAME
     log_boot_info(__DATE__);
     #endif
+}
+
+static void hl_stage_disk_io(void)
+{
+    /* Disk requests are served by the disk I/O task once the scheduler starts */
+    #if SYS_CFG_DISK_IO_TASK_PRIORITY
+    if (!disk_async_init(SYS_CFG_DISK_IO_TASK_PRIORITY)) {
+        puts("ERROR: Failed to create the disk I/O task");
+    }
+    #endif
+}
 
+static void hl_stage_logger(void)
+{
     /* File I/O is up, so initialize the logger if user chose the option */
     #if SYS_CFG_INITIALIZE_LOGGER
     logger_init(SYS_CFG_LOGGER_TASK_PRIORITY);
     #endif
-
-    /* and finally ... call the user's main() method */
-    puts("Calling your main()");
-    hl_print_line();
 }
 
 static bool hl_mount_storage(FileSystemObject& drive, const char* pDescStr)
@@ -250,11 +478,11 @@ static void hl_print_boot_info(void)
         hl_print_line();
         printf("System rebooted after crash.  Relevant info:\n"
                "PC: 0x%08X.  LR: 0x%08X.  PSR: 0x%08X\n"
-               "Possible last running OS Task: '%s'\n",
+               "Possible last running OS Task: '%s'\n"
+               "Use 'health' command for the crash snapshot\n",
                 (unsigned int)FAULT_PC, (unsigned int)FAULT_LR, (unsigned int)FAULT_PSR,
                 taskName);
         hl_print_line();
-        delay_ms(SYS_CFG_CRASH_STARTUP_DELAY_MS);
     }
 }
 
@@ -1,8 +1,22 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "io.hpp"
 #include "wireless.h"
+#include "lpc_sys.h"
 #include "adc0.h"
+#include "stepper.h"
+#include "bit_codec.hpp"
+#include "file_logger.h"
+#include "log_bin_msgs.h"
+#include "sys_config.h"
+#include "queue.h"
+#include "semphr.h"
+#if SYS_CFG_ENABLE_TLM
+#include "c_tlm_comp.h"
+#include "c_tlm_var.h"
+#include "c_tlm_sampler.h"
+#endif
 
 #define DEBUG 1
 
@@ -41,22 +55,72 @@
 #define WIFI_IS_MASTER()         (mesh_get_node_address() == WIFI_MASTER_ADDR)
 
 /**
- * Status Package Structure
+ * TDMA mode using the network time of the master
+ *
+ * Each frame is divided in slots, and the master assigns a slot to each slave in its
+ * GET_STATUS reply.  The slaves send their status only in their own slot, and the master
+ * replies within the slot.  Slot 0 is shared by the slaves without a slot to send REQPWR
+ * at a random time.  Without network time, the slaves use the polled protocol.
+ *
+ * GET_STATUS in TDMA mode :
+ * || 1 byte  |  1 byte  ||
+ * || Command |   Slot   ||
+ */
+#define WIFI_USE_TDMA            1
+#define WIFI_TDMA_FRAME_MS       1000
+#define WIFI_TDMA_SLOT_MS        25     // Status, its ACK, and the master's reply
+#define WIFI_TDMA_SLOTS          (WIFI_TDMA_FRAME_MS / WIFI_TDMA_SLOT_MS)
+#define WIFI_TDMA_GUARD_MS       2      // Margin for the time error at the start and the end of a slot
+#define WIFI_TDMA_LEASE_FRAMES   5      // Master frees the slot of a slave not heard for this many frames
+#define WIFI_TDMA_NO_SLOT        0
+
+/**
+ * Master: the session of each slave
+ *
+ * The master keeps a session for each slave that it hears from, and each packet of a slave only
+ * advances the state of that slave's session, so the exchanges with many slaves are in progress
+ * at the same time.  The replies are queued by wireless_send_batched() without waiting for the
+ * ACK, and the session tick resends the request of a session that is not answered in time, so a
+ * slow or lost slave only delays its own session.  The sessions are only used by wifi_task(),
+ * so they do not need a lock.
+ *
+ *      free --REQPWR--> status --GIVE_STATUS--> scan --GIVE_STATUS, scan done--> ready
+ *                         ^                                                        |
+ *                         +------------------ WIFI_SESSION_RESCAN_MS -------------+
+ *
+ * A session is freed if the status is not received after WIFI_SESSION_RETRIES requests, or if
+ * the slave is not heard from for WIFI_SESSION_LEASE_MS.
+ */
+#define WIFI_MAX_SESSIONS        32
+#define WIFI_SESSION_TICK_MS     250
+#define WIFI_SESSION_RETRY_MS    1000               // The status is requested again after this
+#define WIFI_SESSION_RETRIES     3
+#define WIFI_SESSION_POLL_MS     5000               // The status of a ready slave not heard from is requested
+#define WIFI_SESSION_SCAN_MS     (60 * 1000)        // The max time of the scan of a slave
+#define WIFI_SESSION_RESCAN_MS   (10 * 60 * 1000)   // A ready slave is asked to scan again this often
+#define WIFI_SESSION_LEASE_MS    (30 * 1000)
+
+/**
+ * Status Package Structure (bit packed, see bit_codec.hpp)
  *
- * ||   1 byte   |      1 byte      |      1 byte      |     x byte     ||
- * || Error byte | ADC upper 4 bits | ADC lower 8 bits | Motor position ||
+ * Header, followed by one record for each sensor :
+ * || 8 bits  |    4 bits    |  4 bits ||
+ * || Command | Record count | Version ||
  *
- * Error byte Structure
+ * Record (version 1) :
+ * || 3 bits |  1 bit   | 12 bits |    8 bits      ||
+ * || Sensor | Busy bit |   ADC   | Motor position ||
  *
- * || 8th bit  | 7th bit  | 6th bit  | 5th bit  | 4th bit  | 3rd bit  | 2nd bit  | 1st bit  ||
- * || reserved | reserved | reserved | reserved | reserved | reserved | reserved | Busy bit ||
+ * Version 0 is the status of the older slaves, whose second byte is the error byte
+ * with the busy bit, followed by the ADC upper 4 bits, ADC lower 8 bits and the position.
  */
-#define WIFI_STATUS_IDX_ERR     1
-#define WIFI_STATUS_IDX_ADCU    2
-#define WIFI_STATUS_IDX_ADCL    3
-#define WIFI_STATUS_IDX_MPOS    4
+typedef BitLayout<1, 8, 4, 4> wifi_header_layout_t;
+typedef BitLayout<1, 3, 1, 12, 8> wifi_status_layout_t;
+#define WIFI_STATUS_MAX_RECORDS ((MESH_DATA_PAYLOAD_SIZE - wifi_header_layout_t::totalBytes) / wifi_status_layout_t::totalBytes)
+#define WIFI_STATUS_ADC_PORTS   { ADC_PORT }    // ADC channel of each sensor of the status
 #define ADC_PORT                3
 #define ADC_AVERAGE_DEPTH       2000
+#define ADC_BURST_RATE_HZ       8000
 
 /**
  * Motion Control Package Structure
@@ -64,63 +128,411 @@
  * || 1 byte  |   1 byte    |   1 byte    |   1 byte    ||
  * || Command | Parameter 1 | Parameter 2 | Parameter 3 ||
  */
-#define WIFI_MOVE_IDX_CMD       0
-#define WIFI_MOVE_IDX_PARAM1    1
-#define WIFI_MOVE_IDX_PARAM2    2
-#define WIFI_MOVE_IDX_PARAM3    3
+typedef struct {
+    uint8_t cmd;
+    int8_t param1;      // Step pin toggles of WIFI_CMD_MOVE
+    uint8_t param2;
+    uint8_t param3;
+} motion_cmd_t;
 
-#define CMD_UNPACK(p)           (((p) >> 24) & 0xff)
-#define PARAM1_UNPACK(p)        (((p) >> 16) & 0xff)
-#define PARAM2_UNPACK(p)        (((p) >> 8) & 0xff)
-#define PARAM3_UNPACK(p)        (((p) >> 0) & 0xff)
+static void motion_command(const motion_cmd_t *cmd);
 
 static char position = 0;
-static unsigned char busy = 0;
+static volatile unsigned char busy = 0;   // Slave: set while the motion task moves the motor
 static unsigned char error = 0;
-static QueueHandle_t comm_queue;
-static QueueHandle_t motion_queue;
-static SemaphoreHandle_t signalSlaveHeartbeat;
 static bool slave_boot_up = false;
 
-static void wifi_slave_request(void *p)
+/**
+ * The app is one task, wifi_task(), that waits for its events and runs the protocol and the
+ * motion as state machines, so a received packet reaches the motion without a queue hop, and
+ * no task waits on its own.  The events are the received packets (the rx event of the wireless),
+ * the completion of the stepper moves, and the timers below, whose first deadline is the timeout
+ * of the wait.  The handlers do not block, except for the ADC status measurement and for the
+ * short precise wait of a TDMA slot, which the timer of the slot expires just before.
+ */
+typedef enum {
+    wifi_timer_request,     // Slave: REQPWR until the master answers
+    wifi_timer_heartbeat,   // Slave: our status in our TDMA slot
+    wifi_timer_session,     // Master: the session tick
+    wifi_timer_motion,      // Slave: the delays and ADC windows of the motion
+    wifi_timer_count
+} wifi_timer_t;
+
+static uint64_t wifi_timers_ms[wifi_timer_count];   // The uptime when each timer expires, or 0 if stopped
+static SemaphoreHandle_t wifi_rx_event;             // Given by the wireless when a packet is received
+static SemaphoreHandle_t motion_move_done;          // Given by the stepper engine when a move is complete
+static QueueSetHandle_t wifi_events;                // The set of wifi_rx_event and motion_move_done
+
+static void wifi_timer_start(wifi_timer_t timer, uint32_t delay_ms)
 {
-    char cmd = WIFI_CMD_REQPWR;
-    while (1) {
-        if (!slave_boot_up && mesh_get_node_address() != WIFI_MASTER_ADDR &&
-            !wireless_send(WIFI_MASTER_ADDR, mesh_pkt_ack, &cmd, sizeof(cmd), 0))
-            pr_err("failed to send REQPWR\n");
-        vTaskDelay(1000);
+    wifi_timers_ms[timer] = sys_get_uptime_ms() + delay_ms;
+}
+
+typedef enum {
+    wifi_session_free,
+    wifi_session_status,    // GET_STATUS is sent, and its status is not received yet
+    wifi_session_scan,      // SCAN is sent, and the slave has not finished the scan
+    wifi_session_ready,     // The slave is at its peak
+} wifi_session_state_t;
+
+typedef struct {
+    uint8_t addr;           // The address of the slave
+    uint8_t state;          // The wifi_session_state_t
+    uint8_t retries;        // The requests sent in this state
+    bool scan_started;      // Set once the slave reports busy in the scan state
+    uint8_t busy;           // The last status of the slave
+    uint8_t position;
+    uint16_t adc;
+    uint32_t heard_ms;      // When we last heard from the slave
+    uint32_t state_ms;      // When the session entered its state
+    uint32_t sent_ms;       // When the last request was sent
+} wifi_session_t;
+
+static wifi_session_t wifi_sessions[WIFI_MAX_SESSIONS];    // Master: the session of each slave
+#if WIFI_USE_TDMA
+static volatile uint8_t tdma_my_slot = WIFI_TDMA_NO_SLOT;  // Slave: the slot given by the master
+static uint8_t tdma_slot_owner[WIFI_TDMA_SLOTS];            // Master: the slave of each slot
+static uint32_t tdma_slot_heard_ms[WIFI_TDMA_SLOTS];        // Master: when we last heard from the slave
+static bool tdma_request_armed = false;                     // Slave: our REQPWR is scheduled at tdma_request_us
+static uint64_t tdma_request_us = 0;
+static bool tdma_heartbeat_armed = false;                   // Slave: our status is scheduled at tdma_heartbeat_us
+static uint64_t tdma_heartbeat_us = 0;
+
+/// Master: @returns the slot of the slave, assigning a free slot if it has none, or WIFI_TDMA_NO_SLOT
+static uint8_t tdma_get_slot(uint8_t slave, bool assign)
+{
+    const uint32_t now = sys_get_uptime_ms();
+    uint8_t free_slot = WIFI_TDMA_NO_SLOT;
+
+    for (uint8_t i = 1; i < WIFI_TDMA_SLOTS; i++) {
+        if (tdma_slot_owner[i] == slave) {
+            tdma_slot_heard_ms[i] = now;
+            return i;
+        }
+        if (WIFI_TDMA_NO_SLOT == free_slot && (0 == tdma_slot_owner[i] ||
+            (now - tdma_slot_heard_ms[i]) > (WIFI_TDMA_LEASE_FRAMES * WIFI_TDMA_FRAME_MS)))
+            free_slot = i;
     }
+
+    if (assign && WIFI_TDMA_NO_SLOT != free_slot) {
+        tdma_slot_owner[free_slot] = slave;
+        tdma_slot_heard_ms[free_slot] = now;
+    }
+    return assign ? free_slot : WIFI_TDMA_NO_SLOT;
 }
 
-static void wifi_slave_heartbeat(void *p)
+/**
+ * Slave: starts the timer early_ms before a random time of the shared slot 0 (or the start of our slot)
+ * @returns the network time of the send, for wireless_time_wait_until()
+ */
+static uint64_t tdma_schedule_slot(wifi_timer_t timer, uint8_t slot, bool random_offset, uint32_t early_ms)
 {
-    char pkg[WIFI_DATA_MAX];
-    unsigned short adc = 0;
+    uint32_t offset_ms = WIFI_TDMA_GUARD_MS;
+    if (random_offset)
+        offset_ms += rand() % (WIFI_TDMA_SLOT_MS - 2 * WIFI_TDMA_GUARD_MS);
+
+    const uint64_t t = wireless_time_get_slot_start_us(WIFI_TDMA_FRAME_MS * 1000, WIFI_TDMA_SLOT_MS * 1000, slot) +
+                       offset_ms * 1000;
+    const uint64_t now = wireless_time_get_us();
+    const uint32_t delay_ms = (t > now) ? (uint32_t) ((t - now) / 1000) : 0;
+    wifi_timer_start(timer, (delay_ms > early_ms) ? (delay_ms - early_ms) : 0);
+    return t;
+}
+
+/// Master: replies GET_STATUS with the slot of the slave
+static void tdma_send_slot(uint8_t slave, uint8_t slot)
+{
+    char pkg[] = { WIFI_CMD_GET_STATUS, (char) slot };
+    if (!wireless_send_batched(slave, mesh_pkt_ack, pkg, sizeof(pkg), 0))
+        pr_err("failed to send the slot to %d\n", slave);
+}
+#endif
+
+/// Master: @returns the session of the slave, starting a new one if it has none and create is set
+static wifi_session_t* wifi_session_get(uint8_t slave, bool create)
+{
+    wifi_session_t *free_session = NULL;
+
+    for (uint8_t i = 0; i < WIFI_MAX_SESSIONS; i++) {
+        wifi_session_t *s = &wifi_sessions[i];
+        if (wifi_session_free != s->state && s->addr == slave)
+            return s;
+        if (NULL == free_session && wifi_session_free == s->state)
+            free_session = s;
+    }
+
+    if (!create || NULL == free_session)
+        return NULL;
+    memset(free_session, 0, sizeof(*free_session));
+    free_session->addr = slave;
+    free_session->heard_ms = sys_get_uptime_ms();
+    return free_session;
+}
+
+/// Master: moves the session to the state, and sends the request of the state
+static void wifi_session_enter(wifi_session_t *s, wifi_session_state_t state)
+{
+    const uint32_t now = sys_get_uptime_ms();
+
+    if (s->state != state) {
+        s->retries = 0;
+        s->scan_started = false;
+        s->state_ms = now;
+    }
+    s->state = state;
+    s->sent_ms = now;
+
+    if (wifi_session_scan == state) {
+        const char pkg[] = { WIFI_CMD_SCAN };
+        if (!wireless_send_batched(s->addr, mesh_pkt_ack, pkg, sizeof(pkg), 0))
+            pr_err("failed to send SCAN to %d\n", s->addr);
+    }
+    else if (wifi_session_status == state) {
+#if WIFI_USE_TDMA
+        /* The slave sends its status in its slot once it has one */
+        if (wireless_time_is_synced()) {
+            const uint8_t slot = tdma_get_slot(s->addr, true);
+            if (WIFI_TDMA_NO_SLOT == slot)
+                pr_err("no free slot for %d\n", s->addr);
+            else
+                tdma_send_slot(s->addr, slot);
+            return;
+        }
+#endif
+        const char pkg[] = { WIFI_CMD_GET_STATUS };
+        if (!wireless_send_batched(s->addr, mesh_pkt_ack, pkg, sizeof(pkg), 0))
+            pr_err("failed to send GET_STATUS to %d\n", s->addr);
+    }
+}
+
+/// Master: advances the session with the status of its slave
+static void wifi_session_on_status(wifi_session_t *s)
+{
+    const uint32_t now = sys_get_uptime_ms();
+    s->heard_ms = now;
+
+    switch (s->state) {
+        case wifi_session_status:
+            wifi_session_enter(s, wifi_session_scan);
+            break;
+        case wifi_session_scan:
+            /* The scan is done once the slave was busy and is not anymore */
+            if (s->busy)
+                s->scan_started = true;
+            else if (s->scan_started)
+                wifi_session_enter(s, wifi_session_ready);
+            break;
+        case wifi_session_ready:
+            if ((now - s->state_ms) >= WIFI_SESSION_RESCAN_MS)
+                wifi_session_enter(s, wifi_session_scan);
+            break;
+        default:
+            break;
+    }
+}
+
+/// Master: resends the requests that are not answered, and frees the sessions of the lost slaves
+static void wifi_session_tick(void)
+{
+    const uint32_t now = sys_get_uptime_ms();
+
+    for (uint8_t i = 0; i < WIFI_MAX_SESSIONS; i++) {
+        wifi_session_t *s = &wifi_sessions[i];
+        const uint32_t state_ms = now - s->state_ms;
+        const uint32_t sent_ms = now - s->sent_ms;
+
+        if (wifi_session_free == s->state)
+            continue;
+        if ((now - s->heard_ms) >= WIFI_SESSION_LEASE_MS) {
+            pr_debug("session of %d expired\n", s->addr);
+            s->state = wifi_session_free;
+            continue;
+        }
+
+        switch (s->state) {
+            case wifi_session_status:
+                if (sent_ms < WIFI_SESSION_RETRY_MS)
+                    break;
+                if (++s->retries > WIFI_SESSION_RETRIES) {
+                    pr_debug("no status from %d\n", s->addr);
+                    s->state = wifi_session_free;
+                }
+                else
+                    wifi_session_enter(s, wifi_session_status);
+                break;
+            case wifi_session_scan:
+                /* A slave that tracks its peak ignores the SCAN, and is never busy */
+                if (state_ms >= WIFI_SESSION_SCAN_MS)
+                    wifi_session_enter(s, wifi_session_ready);
+                break;
+            case wifi_session_ready:
+                /* The polled slaves only send their status when asked */
+                if ((now - s->heard_ms) >= WIFI_SESSION_POLL_MS && sent_ms >= WIFI_SESSION_POLL_MS) {
+                    s->sent_ms = now;
+                    const char pkg[] = { WIFI_CMD_GET_STATUS };
+                    wireless_send_batched(s->addr, mesh_pkt_ack, pkg, sizeof(pkg), 0);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    wifi_timer_start(wifi_timer_session, WIFI_SESSION_TICK_MS);
+}
+
+/// Slave: sends REQPWR until the master answers, in the shared slot 0 in TDMA mode
+static void wifi_on_request_timer(void)
+{
+    const char cmd = WIFI_CMD_REQPWR;
+
+#if WIFI_USE_TDMA
+    /* Ask for a slot in the shared slot of each frame until the master gives us one */
+    if (wireless_time_is_synced() && !WIFI_IS_MASTER()) {
+        if (tdma_request_armed && WIFI_TDMA_NO_SLOT == tdma_my_slot && wireless_time_wait_until(tdma_request_us))
+            wireless_send(WIFI_MASTER_ADDR, mesh_pkt_nack, &cmd, sizeof(cmd), 0);
+
+        tdma_request_armed = (WIFI_TDMA_NO_SLOT == tdma_my_slot);
+        if (tdma_request_armed)
+            tdma_request_us = tdma_schedule_slot(wifi_timer_request, 0, true, WIFI_TDMA_GUARD_MS);
+        else
+            wifi_timer_start(wifi_timer_request, WIFI_TDMA_FRAME_MS);
+        return;
+    }
+    tdma_request_armed = false;
+#endif
+    if (!slave_boot_up && !WIFI_IS_MASTER() &&
+        !wireless_send_batched(WIFI_MASTER_ADDR, mesh_pkt_ack, &cmd, sizeof(cmd), 0))
+        pr_err("failed to send REQPWR\n");
+    wifi_timer_start(wifi_timer_request, 1000);
+}
+
+/// Slave: measures our status, and @returns the length of the status package
+static int wifi_slave_status(char *pkg)
+{
+    static const uint8_t ports[] = WIFI_STATUS_ADC_PORTS;
+    const uint32_t num_sensors = sizeof(ports) / sizeof(ports[0]);
+    typedef char too_many_sensors[(sizeof(ports) <= WIFI_STATUS_MAX_RECORDS) ? 1 : -1];
+    unsigned int adc[sizeof(ports)];
+    uint8_t mask = 0;
+    uint32_t s = 0;
     int i = 0;
+    adc0_stats_t stats;
 
     error = busy;
 
-    for (i = 0; i < ADC_AVERAGE_DEPTH; i++)
-        adc += adc0_get_reading(ADC_PORT);
-    adc /= ADC_AVERAGE_DEPTH;
-    pr_debug("before sending adc = %d\n", adc);
-    i = 0;
-    pkg[i++] = WIFI_CMD_GIVE_STATUS;
-    pkg[i++] = error;
-    pkg[i++] = (adc >> 8) & 0xf;
-    pkg[i++] = adc & 0xff;
-    pkg[i++] = position;
-    wireless_send(WIFI_MASTER_ADDR, mesh_pkt_ack, pkg, i, 0);
+    /* Average a block of burst conversions, or fall back to single conversions */
+    for (s = 0; s < num_sensors; s++)
+        mask |= (1 << ports[s]);
+    if (adc0_burst_start(mask, ADC_BURST_RATE_HZ)) {
+        vTaskDelay(ADC0_BURST_FRAMES * 1000 / ADC_BURST_RATE_HZ + 1);
+        for (s = 0; s < num_sensors; s++) {
+            adc0_burst_get_stats(ports[s], 0, &stats);
+            adc[s] = stats.avg;
+        }
+        adc0_burst_stop();
+    }
+    else {
+        for (s = 0; s < num_sensors; s++) {
+            adc[s] = 0;
+            for (i = 0; i < ADC_AVERAGE_DEPTH; i++)
+                adc[s] += adc0_get_reading(ports[s]);
+            adc[s] /= ADC_AVERAGE_DEPTH;
+        }
+    }
+
+    BitWriter w(pkg, MESH_DATA_PAYLOAD_SIZE);
+    const uint32_t hdr[] = { WIFI_CMD_GIVE_STATUS, num_sensors, wifi_status_layout_t::version };
+    wifi_header_layout_t::encode(w, hdr);
+    for (s = 0; s < num_sensors; s++) {
+        pr_debug("before sending adc%u = %u\n", (unsigned int) s, adc[s]);
+        const uint32_t rec[] = { s, error & 1U, (adc[s] > 0xFFF) ? 0xFFF : adc[s], (uint8_t) position };
+        wifi_status_layout_t::encode(w, rec);
+    }
+    if (!w.ok())
+        pr_err("failed to encode the status\n");
+
+    (void) sizeof(too_many_sensors);
+    return w.getBytes();
+}
+
+/// Master: decodes and prints the status of a slave, and saves the status of its first sensor to the session
+/// @returns false if the status is malformed or of an unknown version
+static bool wifi_decode_status(const mesh_packet_t *pkt, wifi_session_t *s)
+{
+    uint32_t hdr[wifi_header_layout_t::numFields];
+    uint32_t rec[wifi_status_layout_t::numFields];
+    uint32_t n = 0;
+    BitReader r(pkt->data, pkt->info.data_len);
+
+    if (!wifi_header_layout_t::decode(r, hdr))
+        return false;
+
+    if (0 == hdr[2]) {
+        if (pkt->info.data_len < 5)
+            return false;
+        const unsigned int adc = (pkt->data[2] << 8) | pkt->data[3];
+        pr_debug("got ADC val: %u (%u mv)\n", adc, adc * 3300 / 4096);
+        s->busy = pkt->data[1] & 1;
+        s->adc = adc;
+        s->position = pkt->data[4];
+        return true;
+    }
+    if (wifi_status_layout_t::version != hdr[2]) {
+        pr_err("unknown status version %u\n", (unsigned int) hdr[2]);
+        return false;
+    }
+
+    for (n = 0; n < hdr[1] && wifi_status_layout_t::decode(r, rec); n++) {
+        pr_debug("sensor %u: busy %u, ADC val: %u (%u mv), position %u\n",
+                 (unsigned int) rec[0], (unsigned int) rec[1], (unsigned int) rec[2],
+                 (unsigned int) rec[2] * 3300 / 4096, (unsigned int) rec[3]);
+        if (0 == n) {
+            s->busy = rec[1];
+            s->adc = rec[2];
+            s->position = rec[3];
+        }
+    }
+    return n == hdr[1];
+}
+
+static void wifi_slave_heartbeat(void)
+{
+    char pkg[WIFI_DATA_MAX];
+    const int len = wifi_slave_status(pkg);
+    wireless_send_batched(WIFI_MASTER_ADDR, mesh_pkt_ack, pkg, len, 0);
 }
 
+#if WIFI_USE_TDMA
+/// Slave: sends our status in our slot of every frame
+static void wifi_on_heartbeat_timer(void)
+{
+    /* The status is measured right before our slot, which takes one ADC burst window */
+    const uint32_t measure_ms = ADC0_BURST_FRAMES * 1000 / ADC_BURST_RATE_HZ + 1 + WIFI_TDMA_GUARD_MS;
+
+    if (WIFI_IS_MASTER() || WIFI_TDMA_NO_SLOT == tdma_my_slot || !wireless_time_is_synced()) {
+        tdma_heartbeat_armed = false;
+        wifi_timer_start(wifi_timer_heartbeat, WIFI_TDMA_FRAME_MS);
+        return;
+    }
+
+    if (tdma_heartbeat_armed) {
+        char pkg[WIFI_DATA_MAX];
+        const int len = wifi_slave_status(pkg);
+        if (wireless_time_wait_until(tdma_heartbeat_us))
+            wireless_send(WIFI_MASTER_ADDR, mesh_pkt_ack, pkg, len, 0);
+    }
+    tdma_heartbeat_armed = true;
+    tdma_heartbeat_us = tdma_schedule_slot(wifi_timer_heartbeat, tdma_my_slot, false, measure_ms);
+}
+#endif
+
 static int wifi_pkt_decoding(mesh_packet_t *pkt)
 {
     char len = pkt->info.data_len;
     char cmd = pkt->data[0];
-    char pkg[WIFI_DATA_MAX];
-    uint32_t motion;
-    int i = 0;
+    motion_cmd_t motion = { (uint8_t) cmd, 0, 0, 0 };
+    wifi_session_t *session = NULL;
 
     pr_debug("got cmd %x\n", cmd);
 
@@ -129,34 +541,56 @@ static int wifi_pkt_decoding(mesh_packet_t *pkt)
             /* Master: Slave is requesting power */
             if (mesh_get_node_address() != WIFI_MASTER_ADDR)
                 break;
-            pkg[i++] = WIFI_CMD_GET_STATUS;
-            if (!wireless_send(pkt->nwk.src, mesh_pkt_ack, pkg, i, 0))
-                pr_err("failed to reply REQPWR\n");;
+            /* A slave that asks again has restarted, so its session starts over */
+            if (NULL == (session = wifi_session_get(pkt->nwk.src, true))) {
+                pr_err("no free session for %d\n", pkt->nwk.src);
+                break;
+            }
+            session->heard_ms = sys_get_uptime_ms();
+            wifi_session_enter(session, wifi_session_status);
             break;
         case WIFI_CMD_GET_STATUS:
             slave_boot_up = true;
             /* Slave: Master is asking my status */
             if (mesh_get_node_address() == WIFI_MASTER_ADDR)
                 break;
-            wifi_slave_heartbeat(NULL);
-            //xSemaphoreGive(signalSlaveHeartbeat);
+#if WIFI_USE_TDMA
+            /* Our heartbeat timer sends the status in our slot, and is scheduled again for a new slot */
+            if (len >= 2) {
+                if (tdma_my_slot != pkt->data[1]) {
+                    tdma_my_slot = pkt->data[1];
+                    tdma_heartbeat_armed = false;
+                    wifi_timer_start(wifi_timer_heartbeat, 0);
+                }
+                break;
+            }
+#endif
+            wifi_slave_heartbeat();
             break;
         case WIFI_CMD_GIVE_STATUS:
             /* Master: Slave is giving its status */
             if (mesh_get_node_address() != WIFI_MASTER_ADDR)
                 break;
-            if (!len) {
-                pr_err("no status received!\n");
+            /* A slave without a session, for example after we restarted, is given one */
+            if (NULL == (session = wifi_session_get(pkt->nwk.src, true))) {
+                pr_err("no free session for %d\n", pkt->nwk.src);
+                break;
+            }
+            if (!wifi_decode_status(pkt, session)) {
+                pr_err("bad status received!\n");
                 return cmd;
             }
-            pr_debug("got ADC val: %d\n",
-                     pkt->data[WIFI_STATUS_IDX_ADCU] << 8 |
-                     pkt->data[WIFI_STATUS_IDX_ADCL]);
-            pr_debug("%d mv", (pkt->data[WIFI_STATUS_IDX_ADCU] << 8 |
-                     pkt->data[WIFI_STATUS_IDX_ADCL]) * 3300 / 4096);
-            pkg[i++] = WIFI_CMD_SCAN;
-            if (!wireless_send(pkt->nwk.src, mesh_pkt_ack, pkg, i, 0))
-                pr_err("failed to reply REQPWR\n");;
+#if WIFI_USE_TDMA
+            /* A slave without a slot, for example after we restarted, is given one */
+            if (wireless_time_is_synced() && WIFI_TDMA_NO_SLOT == tdma_get_slot(pkt->nwk.src, false)) {
+                const uint8_t slot = tdma_get_slot(pkt->nwk.src, true);
+                if (WIFI_TDMA_NO_SLOT != slot)
+                    tdma_send_slot(pkt->nwk.src, slot);
+            }
+#endif
+            if (wifi_session_free == session->state)
+                session->state = wifi_session_status;
+            wifi_session_on_status(session);
             break;
         case WIFI_CMD_CTL_DIR:
             /* Slave: Master is controlling my direction */
@@ -170,16 +604,17 @@ static int wifi_pkt_decoding(mesh_packet_t *pkt)
             break;
         case WIFI_CMD_MOVE:
             /* Slave: Master is moving the slave */
-            motion = cmd << 24 | pkt->data[WIFI_MOVE_IDX_PARAM1] << 16 |
-                    pkt->data[WIFI_MOVE_IDX_PARAM2] << 8;
-            if (!xQueueSend(motion_queue, &motion, 1000))
-                pr_err("failed to pass MOVE cmd to next layer\n");
+            if (len < 3) {
+                pr_err("MOVE cmd is too short\n");
+                return cmd;
+            }
+            motion.param1 = (int8_t) pkt->data[1];
+            motion.param2 = pkt->data[2];
+            motion_command(&motion);
             break;
         case WIFI_CMD_SCAN:
             /* Slave: Master is scanning the slave */
-            motion = cmd << 24;
-            if (!xQueueSend(motion_queue, &motion, 1000))
-                pr_err("failed to pass MOVE cmd to next layer\n");
+            motion_command(&motion);
             break;
         default:
             pr_err("undefined wireless commands: 0x%x\n", cmd);
@@ -189,51 +624,15 @@ static int wifi_pkt_decoding(mesh_packet_t *pkt)
     return 0;
 }
 
-static void wifi_receive_task(void *p)
+/// Decodes the received packets
+static void wifi_on_rx_event(void)
 {
-    mesh_packet_t pkt;
+    mesh_packet_t *pkt;
 
-    while (1) {
-        if (!wireless_get_rx_pkt(&pkt, 1000))//portMAX_DELAY))
-            continue;
-        if (!xQueueSend(comm_queue, &pkt, 1000))
-            pr_err("failed to send packet to comm queue\n");
-    }
-}
-
-static void wifi_slave_heartbeat_task(void *p)
-{
-#if 0
-    unsigned int adc, i;
-    while (1) {
-        adc = 0;
-        for (i = 0; i < ADC_AVERAGE_DEPTH; i++) {
-            adc += adc0_get_reading(3);
-        }
-        adc /= ADC_AVERAGE_DEPTH;
-        pr_debug("Adc = %d (%dmv)\n", adc, adc * 3300 / 4096);
-        vTaskDelay(900);
-    }
-#endif
-    while (mesh_get_node_address() != WIFI_MASTER_ADDR) {
-        if (!xSemaphoreTake(signalSlaveHeartbeat, portMAX_DELAY))
-            continue;;
-        wifi_slave_heartbeat(NULL);
-        vTaskDelay(2000);
-    }
-
-    while(1);
-}
-
-static void mid_comm_task(void *p)
-{
-    mesh_packet_t pkt;
-
-    while (1) {
-        if (!xQueueReceive(comm_queue, &pkt, 1000))
-            continue;
-        if (wifi_pkt_decoding(&pkt))
+    while (NULL != (pkt = wireless_get_rx_pkt_ref(0))) {
+        if (wifi_pkt_decoding(pkt))
             pr_err("failed to decode wireless packet.\n");
+        wireless_pkt_release(pkt);
     }
 }
 
@@ -241,38 +640,108 @@ static void mid_comm_task(void *p)
 #define ENABLE_PIN    (1 << 0)
 #define STEP_PIN      (1 << 3)
 
-#define SPEED_MS  10  // 5ms per toggle, 2 toggles per step, 200 steps/rev,  100 steps/s, 0.5 rev/s, 180 deg/s
+#define SPEED_MS  (1000 / MOTOR_MAX_SPS)  // Period of a step at the maximum speed, used to sample the position
 #define STEPS_FULL_REV 400
 #define ENERGY_SAMPLES 10 // each 2 STEPS_FULL_REV = 1 step
 #define ADC_SAMPLE_PERIOD (STEPS_FULL_REV / ENERGY_SAMPLES)
 
 #define STEPS_PER_REV 200
+#define MOTOR_MAX_SPS       200 // Maximum speed in steps per second (1 rev/s)
+#define MOTOR_ACCEL_SPS2    400 // Acceleration in steps per second squared
+/**
+ * The pipelined scan keeps the motor moving for one revolution while the ADC converts
+ * continuously (burst mode and DMA), and records the energy at every step position.
+ * Otherwise, the motor stops at each of the ENERGY_SAMPLES positions to sample the ADC.
+ */
+#define MOTION_PIPELINED_SCAN   1
+#define SCAN_MAX_SPS            50   // Scan speed, where one step is one ADC burst window
+#define SCAN_ADC_RATE_HZ        1600 // ADC0_BURST_FRAMES / SCAN_ADC_RATE_HZ = 20ms window
+#define SCAN_SMOOTH_STEPS       2    // Steps on each side that are averaged to find the peak
+
+/**
+ * Maximum power point tracking (perturb and observe)
+ *
+ * After a scan, the slave keeps the panel at the peak by itself: every MPPT_PERIOD_MS it makes
+ * MPPT_STEP_STEPS in its direction and measures the energy with one ADC burst window, and it
+ * reverses the direction if the energy dropped, so the panel stays within a few steps of the
+ * peak as the peak moves.  The SCAN commands of the master are ignored while tracking, and a
+ * full scan is only done again if the energy drops below MPPT_RESCAN_PERCENT of the best
+ * energy since the last scan (a peak too far away to be followed), at most every MPPT_RESCAN_MIN_MS.
+ * A MOVE command of the master stops the tracking until the next scan.
+ *
+ * The motion is a state machine of wifi_task(), whose states end with a move of the stepper
+ * engine (motion_move_done) or with the motion timer (a delay or an ADC burst window).  The
+ * commands received while the motor moves are run once it is at rest.
+ */
+#define MOTION_MPPT             1
+#define MPPT_PERIOD_MS          2000
+#define MPPT_STEP_STEPS         2
+#define MPPT_RESCAN_PERCENT     70
+#define MPPT_RESCAN_MIN_MS      (60 * 1000)
+
+/**
+ * The position of the motor at rest is a "disk" telemetry variable, so after a reboot the slave
+ * resumes at its last position, and keeps tracking the peak if it was tracking it, instead of
+ * scanning again.  The position is unknown during a scan or a MOVE, and is not saved until the
+ * motor is at rest.  The disk telemetry is saved at most every SYS_CFG_DISK_TLM_MIN_SAVE_MS,
+ * so the tracking steps after the last save are not saved, but they are found again by the
+ * tracking since they are only a few steps.  If the position is unknown, the motor is homed
+ * with the home switch if MOTION_HOME_SWITCH is set, and otherwise the master's scan finds the peak.
+ */
+#define MOTION_POS_UNKNOWN      0xFFFF
+#define MOTION_HOME_SWITCH      0               // Set if a switch (active low) closes at position 0
+#define MOTION_HOME_GPIO        LPC_GPIO2
+#define MOTION_HOME_PIN         (1 << 4)
+#define MOTION_HOME_CHUNK       4               // The steps of each homing move, after which the switch is checked
+
 #define DRIVE_ON false
 #define DRIVE_OFF true
 
-#define CW true
-#define CCW false
-
-enum commandType
-{
-    scan,
-    set_speed,
-    move,
-    test_rotate_pos,
-    test_rotate_neg,
-    none
-};
+typedef enum {
+    motion_idle,
+    motion_scan_settle,     // The ADC burst fills its first window before the revolution
+    motion_scan_rev,        // The revolution of the pipelined scan
+    motion_sample_wait,     // The delay before sampling a position, or before the move to the peak
+    motion_sample_measure,  // The ADC measurement of a position
+    motion_sample_move,     // The move to the next sample position
+    motion_scan_peak,       // The move to the peak
+    motion_mppt_measure,    // Tracking: the ADC measurement after the scan or a step
+    motion_mppt_wait,       // Tracking: the delay before the next step
+    motion_mppt_move,       // Tracking: a step
+    motion_move,            // A MOVE command
+    motion_home,            // A move towards the home switch
+} motion_state_t;
 
 static uint16_t current_pos = 0;
+static uint16_t motion_saved_pos = MOTION_POS_UNKNOWN;  // Disk: the position at rest, or MOTION_POS_UNKNOWN
+static uint8_t motion_saved_tracking = 0;               // Disk: set if the slave was tracking the peak at motion_saved_pos
+#if MOTION_HOME_SWITCH
+static uint8_t motion_home_moves = 0;                   // The homing moves so far
+#endif
+static uint16_t last_adc = 0;
+#if SYS_CFG_ENABLE_TLM
+TLM_DEFINE_VAR(motion, current_pos, tlm_uint);
+TLM_DEFINE_VAR(motion, last_adc, tlm_uint);
+#endif
 static int16_t steps_todo = 0;
-static int8_t steps_todo2 = 0;
-static uint16_t current_speed = SPEED_MS;
-static double energyArray[ENERGY_SAMPLES*2];
-static commandType commandSequence[10];
+static uint16_t energyArray[ENERGY_SAMPLES*2];
 static uint8_t energyArray_idx = 0;
-static uint8_t busy_bit = 0;
-static commandType command = none;
-static uint8_t command_idx = 0;
+static int adc_sampe_ctr = 0;
+static motion_state_t motion_state = motion_idle;
+static bool motion_measure_burst = false;   // The measurement uses the ADC burst mode
+static bool motion_pending_scan = false;    // A SCAN received while the motor moves
+static int16_t motion_pending_steps = 0;    // The steps of the MOVEs received while the motor moves
+#if MOTION_PIPELINED_SCAN
+static uint16_t scan_energy[STEPS_PER_REV];
+static volatile bool scan_capture = false;
+#endif
+#if MOTION_MPPT
+static bool mppt_first = false;         // The measurement after the scan starts the tracking
+static int8_t mppt_dir = 1;             // The direction of the next step
+static uint16_t mppt_last = 0;          // The energy after the last step
+static uint16_t mppt_best = 0;          // The best energy since the last scan
+static uint32_t mppt_scan_ms = 0;       // The uptime of the last scan
+#endif
 
 static void enableDrive(bool state)
 {
@@ -283,22 +752,46 @@ static void enableDrive(bool state)
         LPC_GPIO2->FIOCLR = ENABLE_PIN;
 }
 
-static void toggleStep(void)
+/// Called by the stepper engine (from its ISR) after each step to track the motor position
+static void motion_on_step(bool forward)
 {
-    if ((bool) (LPC_GPIO2->FIOPIN & STEP_PIN)) {
-        LPC_GPIO2->FIOCLR = STEP_PIN;
+    if (forward) {
+        current_pos = (current_pos + 1) % STEPS_PER_REV;
     } else {
-        LPC_GPIO2->FIOSET = STEP_PIN;
-        if ( LPC_GPIO2->FIOSET & DIRECTION_PIN) {
-            current_pos = (current_pos + 1) % STEPS_PER_REV;
-        } else {
-            if (current_pos > 0)
-                current_pos--;
-            else
-                current_pos = STEPS_PER_REV - 1;
+        if (current_pos > 0)
+            current_pos--;
+        else
+            current_pos = STEPS_PER_REV - 1;
+    }
+
+#if MOTION_PIPELINED_SCAN
+    if (scan_capture)
+        scan_energy[current_pos] = adc0_burst_get_average(ADC_PORT);
+#endif
+}
+
+#if MOTION_PIPELINED_SCAN
+/// @returns the position of the maximum energy of the scan curve averaged over neighboring steps
+static uint16_t get_max_energy_pos_curve(void)
+{
+    uint32_t max_energy = 0;
+    uint16_t max_pos = 0;
+
+    for (int pos = 0; pos < STEPS_PER_REV; pos++) {
+        uint32_t energy = 0;
+        for (int j = -SCAN_SMOOTH_STEPS; j <= SCAN_SMOOTH_STEPS; j++)
+            energy += scan_energy[(pos + j + STEPS_PER_REV) % STEPS_PER_REV];
+
+        if (energy > max_energy) {
+            max_energy = energy;
+            max_pos = pos;
         }
     }
+    last_adc = max_energy / (2 * SCAN_SMOOTH_STEPS + 1);
+    pr_debug("max energy pos = %d (adc = %d)\n", max_pos, last_adc);
+    return max_pos;
 }
+#endif
 
 static uint8_t get_max_energy_pos(void)
 {
@@ -314,100 +807,372 @@ static uint8_t get_max_energy_pos(void)
     return max_sample_idx * (ADC_SAMPLE_PERIOD / 2);
 }
 
-static void setDirection(bool direction)
+/// Queues a move, whose completion is the motion_move_done event of the state
+static void motion_start_move(motion_state_t state, int32_t steps)
 {
-    if (direction)
-        LPC_GPIO2->FIOSET = DIRECTION_PIN;
-    else
-        LPC_GPIO2->FIOCLR = DIRECTION_PIN;
+    motion_state = state;
+    busy = 1;
+    if (!stepper_move(steps, motion_move_done, 0)) {
+        pr_err("failed to queue the move\n");
+        xSemaphoreGive(motion_move_done);
+    }
 }
 
-#if 0
-static void setStep(bool state)
+/// Starts measuring the panel, using one ADC burst window if burst mode is available
+static void motion_start_measure(motion_state_t state)
 {
-    if (state)
-        LPC_GPIO2->FIOSET = STEP_PIN;
-    else
-        LPC_GPIO2->FIOCLR = STEP_PIN;
+    motion_state = state;
+    motion_measure_burst = adc0_burst_start(1 << ADC_PORT, SCAN_ADC_RATE_HZ);
+    wifi_timer_start(wifi_timer_motion, motion_measure_burst ? (ADC0_BURST_FRAMES * 1000 / SCAN_ADC_RATE_HZ + 1) : 0);
+}
+
+/// @returns the average ADC reading of the measurement, once the motion timer expired
+static uint16_t motion_finish_measure(void)
+{
+    unsigned int adc = 0, i;
+
+    if (motion_measure_burst) {
+        adc = adc0_burst_get_average(ADC_PORT);
+        adc0_burst_stop();
+        return adc;
+    }
+
+    for (i = 0; i < ADC_AVERAGE_DEPTH; i++)
+        adc += adc0_get_reading(ADC_PORT);
+    return adc / ADC_AVERAGE_DEPTH;
 }
+
+/// @returns true while the slave tracks the peak
+static bool motion_is_tracking(void)
+{
+    return (motion_mppt_measure == motion_state || motion_mppt_wait == motion_state ||
+            motion_mppt_move == motion_state);
+}
+
+/// Starts the scan of a full revolution, which ends at the position of the maximum energy
+static void motion_start_scan(void)
+{
+    /* set busy bit */
+    busy = 1;
+    motion_saved_pos = MOTION_POS_UNKNOWN;
+    adc_sampe_ctr = 0;
+    pr_debug("SCANNING \n");
+    energyArray_idx = 0;
+    enableDrive(DRIVE_ON);
+
+#if MOTION_PIPELINED_SCAN
+    /* Rotate one revolution while the step ISR records the ADC average at each position */
+    if (adc0_burst_start(1 << ADC_PORT, SCAN_ADC_RATE_HZ)) {
+        for (int pos = 0; pos < STEPS_PER_REV; pos++)
+            scan_energy[pos] = 0;
+
+        stepper_set_speed(SCAN_MAX_SPS, MOTOR_ACCEL_SPS2);
+        motion_state = motion_scan_settle;
+        wifi_timer_start(wifi_timer_motion, ADC0_BURST_FRAMES * 1000 / SCAN_ADC_RATE_HZ);
+        return;
+    }
+    pr_err("ADC burst mode is unavailable, scanning one position at a time\n");
 #endif
 
-static void motion_task(void *p)
+    /* Sample the ADC and then step to the next sample position for one full revolution */
+    motion_state = motion_sample_wait;
+    wifi_timer_start(wifi_timer_motion, 1000);
+}
+
+/// Runs the commands received while the motor moved, or rests in the state (motion_idle or motion_mppt_wait)
+static void motion_rest(motion_state_t rest)
 {
-    int adc_sample_flag;
-    uint32_t rx;
-    int adc_sampe_ctr = 0;
+    busy = 0;
+    motion_state = rest;
+    motion_saved_pos = current_pos;
+    motion_saved_tracking = (motion_mppt_wait == rest);
 
-    while (1) {
-        if (!xQueueReceive(motion_queue, &rx, 1000))
-            continue;
-        pr_debug("recevied %lx\n", rx);
-
-        switch (CMD_UNPACK(rx)) {
-            case WIFI_CMD_SCAN:
-                /* set busy bit */
-                busy_bit = 1;
-                adc_sample_flag = 0;
-                adc_sampe_ctr = 0;
-                pr_debug("SCANNING \n");
-                steps_todo = STEPS_FULL_REV;
-                energyArray_idx = 0;
-                enableDrive(DRIVE_ON);
-                setDirection(CW);
-                while (steps_todo > 0) {
-                    if (adc_sample_flag % ADC_SAMPLE_PERIOD == 0) {
-                        vTaskDelay(1000);
-                        unsigned int adc = 0, i;
-                        for (i = 0; i < ADC_AVERAGE_DEPTH; i++)
-                            adc += adc0_get_reading(ADC_PORT);
-                        energyArray[energyArray_idx++] = adc / ADC_AVERAGE_DEPTH;
-                        pr_debug("ADC sample %d: %d, position=%u\n",
-                                  adc_sampe_ctr, adc / ADC_AVERAGE_DEPTH, current_pos);
-                        adc_sampe_ctr++;
-                    }
-                    adc_sample_flag++;
-
-                    toggleStep();
-                    steps_todo--;
-                    vTaskDelay(current_speed);
-                }
+    if (0 != motion_pending_steps) {
+        const int16_t steps = motion_pending_steps;
+        motion_pending_steps = 0;
+        motion_saved_pos = MOTION_POS_UNKNOWN;
+        motion_start_move(motion_move, steps);
+    }
+    else if (motion_pending_scan && motion_idle == rest) {
+        motion_pending_scan = false;
+        motion_start_scan();
+    }
+    else if (motion_mppt_wait == rest) {
+        motion_pending_scan = false;
+        wifi_timer_start(wifi_timer_motion, MPPT_PERIOD_MS);
+    }
+}
+
+/// The scan is at the peak, so track it, or wait for the next command
+static void motion_end_scan(void)
+{
+    pr_debug("Scan ended at position: %d \n", current_pos);
+    LOG_BIN_INFO(logbin_motion_scan_end, current_pos);
+#if MOTION_MPPT
+    mppt_first = true;
+    mppt_scan_ms = sys_get_uptime_ms();
+    motion_start_measure(motion_mppt_measure);
+#else
+    motion_rest(motion_idle);
+#endif
+}
+
+#if MOTION_MPPT
+/// Perturb and observe: reverses the direction if the step lowered the energy, and scans again if the peak was lost
+static void mppt_on_measure(uint16_t adc)
+{
+    last_adc = adc;
+    if (mppt_first) {
+        mppt_first = false;
+        mppt_last = mppt_best = adc;
+        motion_rest(motion_mppt_wait);
+        return;
+    }
 
+    /* Moving away from the peak, so the next step goes the other way */
+    if (adc < mppt_last)
+        mppt_dir = -mppt_dir;
+    mppt_last = adc;
+    if (adc > mppt_best)
+        mppt_best = adc;
+
+    const uint32_t threshold = (uint32_t) mppt_best * MPPT_RESCAN_PERCENT / 100;
+    if (adc < threshold && (sys_get_uptime_ms() - mppt_scan_ms) >= MPPT_RESCAN_MIN_MS) {
+        pr_debug("energy %u below %u, scanning again\n", adc, (unsigned int) threshold);
+        LOG_BIN_INFO(logbin_motion_mppt_rescan, adc, threshold);
+        motion_start_scan();
+        return;
+    }
+    motion_rest(motion_mppt_wait);
+}
+#endif
+
+/// Runs a command of the master, or keeps it until the motor is at rest
+static void motion_command(const motion_cmd_t *cmd)
+{
+    const bool resting = (motion_idle == motion_state || motion_mppt_wait == motion_state);
+
+    pr_debug("recevied %x %d\n", cmd->cmd, cmd->param1);
+    switch (cmd->cmd) {
+        case WIFI_CMD_SCAN:
+            /* The peak is tracked, so the panel is not moved away from it by a scan */
+            if (motion_is_tracking())
+                break;
+            if (resting)
+                motion_start_scan();
+            else
+                motion_pending_scan = true;
+            break;
+        case WIFI_CMD_MOVE:
+            pr_debug("MOVING %d STEPS \n", cmd->param1);
+            // The parameter is the number of step pin toggles, and each step is two toggles
+            if (resting) {
+                motion_saved_pos = MOTION_POS_UNKNOWN;
+                motion_start_move(motion_move, cmd->param1 / 2);
+            }
+            else
+                motion_pending_steps += cmd->param1 / 2;
+            break;
+        default:
+            break;
+    }
+}
+
+/// The motion timer expired: a delay or an ADC burst window is over
+static void motion_on_timer(void)
+{
+    switch (motion_state) {
+#if MOTION_PIPELINED_SCAN
+        case motion_scan_settle:
+            scan_capture = true;
+            motion_start_move(motion_scan_rev, STEPS_PER_REV);
+            break;
+#endif
+        case motion_sample_wait:
+            if (energyArray_idx < ENERGY_SAMPLES)
+                motion_start_measure(motion_sample_measure);
+            else
+                motion_start_move(motion_scan_peak, steps_todo);
+            break;
+        case motion_sample_measure:
+            last_adc = motion_finish_measure();
+            energyArray[energyArray_idx++] = last_adc;
+            pr_debug("ADC sample %d: %d, position=%u\n",
+                      adc_sampe_ctr, last_adc, current_pos);
+            LOG_BIN_INFO(logbin_motion_adc_sample,
+                         adc_sampe_ctr, last_adc, current_pos);
+            adc_sampe_ctr++;
+            motion_start_move(motion_sample_move, ADC_SAMPLE_PERIOD / 2);
+            break;
+#if MOTION_MPPT
+        case motion_mppt_measure:
+            mppt_on_measure(motion_finish_measure());
+            break;
+        case motion_mppt_wait:
+            motion_start_move(motion_mppt_move, mppt_dir * MPPT_STEP_STEPS);
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+/// The move of the state is complete
+static void motion_on_move_done(void)
+{
+    switch (motion_state) {
+#if MOTION_PIPELINED_SCAN
+        case motion_scan_rev:
+            scan_capture = false;
+            adc0_burst_stop();
+            stepper_set_speed(MOTOR_MAX_SPS, MOTOR_ACCEL_SPS2);
+
+            for (int pos = 0; pos < STEPS_PER_REV; pos += ADC_SAMPLE_PERIOD / 2) {
+                LOG_BIN_INFO(logbin_motion_adc_sample, adc_sampe_ctr++, scan_energy[pos], pos);
+            }
+
+            /* Take the shorter way to the peak */
+            steps_todo = get_max_energy_pos_curve() - current_pos;
+            if (steps_todo > STEPS_PER_REV / 2)
+                steps_todo -= STEPS_PER_REV;
+            else if (steps_todo < -STEPS_PER_REV / 2)
+                steps_todo += STEPS_PER_REV;
+            pr_debug("currentPos = %d, steps_todo = %d\n", current_pos, steps_todo);
+            motion_start_move(motion_scan_peak, steps_todo);
+            break;
+#endif
+        case motion_sample_move:
+            if (energyArray_idx >= ENERGY_SAMPLES) {
                 steps_todo = get_max_energy_pos() - current_pos;
                 pr_debug("currentPos = %d, steps_todo = %d\n", current_pos, steps_todo);
+            }
+            motion_state = motion_sample_wait;
+            wifi_timer_start(wifi_timer_motion, 1000);
+            break;
+        case motion_scan_peak:
+            motion_end_scan();
+            break;
+#if MOTION_MPPT
+        case motion_mppt_move:
+            motion_start_measure(motion_mppt_measure);
+            break;
+#endif
+        case motion_move:
+            motion_rest(motion_idle);
+            break;
+#if MOTION_HOME_SWITCH
+        case motion_home:
+            /* The switch is checked after each chunk, up to a bit more than one revolution */
+            if (0 == (MOTION_HOME_GPIO->FIOPIN & MOTION_HOME_PIN)) {
+                current_pos = 0;
+                pr_debug("homed\n");
+                motion_rest(motion_idle);
+            }
+            else if (++motion_home_moves > (STEPS_PER_REV / MOTION_HOME_CHUNK) + 1) {
+                pr_err("home switch not found\n");
+                motion_rest(motion_idle);
+            }
+            else
+                motion_start_move(motion_home, -MOTION_HOME_CHUNK);
+            break;
+#endif
+        default:
+            break;
+    }
+}
 
-                vTaskDelay(1000);
-                setDirection(steps_todo > 0 ? CW : CCW);
-                while (steps_todo > 0) {
-                    toggleStep();
-                    steps_todo--;
-                    vTaskDelay(current_speed);
-                }
-                pr_debug("Scan ended at position: %d \n", current_pos);
-                busy_bit = 0;
-                break;
-            case WIFI_CMD_MOVE:
-                // set busy bit
-                busy_bit = 1;
-                steps_todo2 = PARAM1_UNPACK(rx);
-                pr_debug("MOVING %d STEPS \n", steps_todo2);
-                if (steps_todo2 > 0)
-                    setDirection(CW);
-                else
-                    setDirection(CCW);
-                steps_todo2 = abs(steps_todo2);
-                while (steps_todo2 > 0) {
-                    toggleStep();
-                    steps_todo2--;
-                    vTaskDelay(current_speed);
-                }
-                busy_bit = 0;
-                break;
-            default:
-                break;
+/// Resumes the position saved before the reboot, or homes the motor if the position is unknown
+static void motion_resume(void)
+{
+    if (WIFI_IS_MASTER())
+        return;
+
+    if (MOTION_POS_UNKNOWN != motion_saved_pos && motion_saved_pos < STEPS_PER_REV) {
+        current_pos = motion_saved_pos;
+        pr_info("resuming at position %u\n", current_pos);
+        enableDrive(DRIVE_ON);
+#if MOTION_MPPT
+        /* The master's scan is ignored while the peak is tracked */
+        if (motion_saved_tracking) {
+            busy = 1;
+            mppt_first = true;
+            mppt_scan_ms = sys_get_uptime_ms();
+            motion_start_measure(motion_mppt_measure);
         }
+#endif
+        return;
+    }
+
+#if MOTION_HOME_SWITCH
+    pr_info("homing\n");
+    enableDrive(DRIVE_ON);
+    motion_home_moves = 0;
+    motion_start_move(motion_home, -MOTION_HOME_CHUNK);
+#endif
+}
 
-        if (busy_bit == 0)
-            command = commandSequence[command_idx++];
+static void wifi_on_timer(wifi_timer_t timer)
+{
+    switch (timer) {
+        case wifi_timer_request:
+            wifi_on_request_timer();
+            break;
+#if WIFI_USE_TDMA
+        case wifi_timer_heartbeat:
+            wifi_on_heartbeat_timer();
+            break;
+#endif
+        case wifi_timer_session:
+            wifi_session_tick();
+            break;
+        case wifi_timer_motion:
+            motion_on_timer();
+            break;
+        default:
+            break;
+    }
+}
+
+static void wifi_task(void *p)
+{
+    /* The disk telemetry is restored before the scheduler starts */
+    motion_resume();
+
+    /* The timers restart themselves */
+    wifi_timer_start(wifi_timer_request, 0);
+#if WIFI_USE_TDMA
+    wifi_timer_start(wifi_timer_heartbeat, 0);
+#endif
+    if (WIFI_IS_MASTER())
+        wifi_timer_start(wifi_timer_session, WIFI_SESSION_TICK_MS);
+
+    while (1) {
+        /* Run the expired timers, and then wait for an event until the first deadline */
+        uint64_t next_ms = 0;
+        for (int t = 0; t < wifi_timer_count; t++) {
+            if (0 != wifi_timers_ms[t] && wifi_timers_ms[t] <= sys_get_uptime_ms()) {
+                wifi_timers_ms[t] = 0;
+                wifi_on_timer((wifi_timer_t) t);
+            }
+        }
+        for (int t = 0; t < wifi_timer_count; t++) {
+            if (0 != wifi_timers_ms[t] && (0 == next_ms || wifi_timers_ms[t] < next_ms))
+                next_ms = wifi_timers_ms[t];
+        }
+
+        const uint64_t now_ms = sys_get_uptime_ms();
+        const TickType_t timeout = (0 == next_ms) ? portMAX_DELAY :
+                                   (next_ms > now_ms) ? OS_MS((uint32_t) (next_ms - now_ms)) : 0;
+        const QueueSetMemberHandle_t event = xQueueSelectFromSet(wifi_events, timeout);
+
+        if (event == wifi_rx_event) {
+            xSemaphoreTake(wifi_rx_event, 0);
+            wifi_on_rx_event();
+        }
+        else if (event == motion_move_done) {
+            xSemaphoreTake(motion_move_done, 0);
+            motion_on_move_done();
+        }
     }
 }
 
@@ -424,21 +1189,47 @@ void power_wifi_init()
     /* set up pull down for all */
     LPC_PINCON->PINMODE4 |= 3 + (3 << 2) + (3 << 4);
     LPC_PINCON->PINMODE_OD2 = DIRECTION_PIN + ENABLE_PIN + STEP_PIN;
+#if MOTION_HOME_SWITCH
+    MOTION_HOME_GPIO->FIODIR &= ~MOTION_HOME_PIN;
+#endif
 
-    /* test scan */
-    commandSequence[0] = scan;
-    commandSequence[1] = scan;
+    /* Step pulses are generated by the timer ISR of the stepper engine */
+    const stepper_cfg_t motor = { LPC_GPIO2, STEP_PIN, DIRECTION_PIN,
+                                  MOTOR_MAX_SPS, MOTOR_ACCEL_SPS2, motion_on_step };
+    if (!stepper_init(&motor))
+        pr_err("failed to initialize the stepper engine\n");
 
-    signalSlaveHeartbeat = xSemaphoreCreateBinary();
+    #if SYS_CFG_ENABLE_TLM
+    /* Trace the motor position at the step rate, and the ADC at a lower rate.  The variables of
+     * the component are defined by TLM_DEFINE_VAR() above.
+     */
+    if (tlm_component_add("motion")) {
+        tlm_sampler_add("motion", "current_pos", SPEED_MS);
+        tlm_sampler_add("motion", "last_adc", 100);
+    }
+
+    tlm_component *disk = tlm_component_get_by_name(SYS_CFG_DISK_TLM_NAME);
+    if (!TLM_REG_VAR(disk, motion_saved_pos, tlm_uint) ||
+        !TLM_REG_VAR(disk, motion_saved_tracking, tlm_uint))
+        pr_err("failed to register the saved position\n");
+    #endif
 
-    comm_queue = xQueueCreate(10, sizeof(mesh_packet_t));
-    motion_queue = xQueueCreate(10, sizeof(int32_t));
+    /* The master's uptime is the network time, such that slaves can run commands at the same time */
+    if (mesh_get_node_address() == WIFI_MASTER_ADDR)
+        wireless_time_start_master();
+
+    /* The semaphores are empty when they are added to the set */
+    wifi_rx_event = xSemaphoreCreateBinary();
+    motion_move_done = xSemaphoreCreateBinary();
+    wifi_events = xQueueCreateSet(2);
+    if (NULL == wifi_rx_event || NULL == motion_move_done || NULL == wifi_events ||
+        !xQueueAddToSet(wifi_rx_event, wifi_events) || !xQueueAddToSet(motion_move_done, wifi_events)) {
+        pr_err("failed to create the events\n");
+        return;
+    }
+    wireless_set_rx_event(wifi_rx_event);
 
-    xTaskCreate(wifi_receive_task, "wifi_receive", STACK_BYTES(2048), 0, PRIORITY_MEDIUM, NULL);
-    xTaskCreate(wifi_slave_heartbeat_task, "wifi_slave_heartbeat", STACK_BYTES(2048), 0, PRIORITY_MEDIUM, NULL);
-    xTaskCreate(wifi_slave_request, "wifi_slave_request", STACK_BYTES(2048), 0, PRIORITY_MEDIUM, NULL);
-    xTaskCreate(mid_comm_task, "mid_comm_task", STACK_BYTES(2048), 0, PRIORITY_MEDIUM, NULL);
-    xTaskCreate(motion_task, "motion_task", STACK_BYTES(2048), 0, PRIORITY_MEDIUM, NULL);
+    xTaskCreate(wifi_task, "power_wifi", STACK_BYTES(2048), 0, PRIORITY_MEDIUM, NULL);
 
     pr_info("initialized\n");
 }
@@ -28,17 +28,36 @@
 
 
 
+CHANNEL_DEFINE(remote_learn_channel, remote_learn_t, 2);
+CHANNEL_DEFINE(remote_action_channel, remote_action_t, 4);
+
+/// @returns the slot of an IR code in the hash table, where the probing for the code starts
+static inline unsigned int remote_hash(uint32_t code)
+{
+    /* Fibonacci hashing: the upper bits of the product depend on all the bits of the code */
+    return ((code * 2654435761u) >> 16) & (REMOTE_CODE_SLOTS - 1);
+}
+
+/// @returns the protocol bit of the binding of an IR code
+static inline uint16_t remote_protocol_bit(uint8_t protocol)
+{
+    return (ir_protocol_rc5 == protocol) ? REMOTE_BINDING_RC5 : 0;
+}
+
+
+
 remoteTask::remoteTask(uint8_t priority) :
         scheduler_task("remote", 512*3, priority),
+        mCodeCount(0),
         mIrNumber(0),
         mLearnSem(NULL)
 {
-    memset(mNumCodes, 0, sizeof(mNumCodes));
+    memset(mIrCodes, 0, sizeof(mIrCodes));
+    memset(mIrBindings, 0, sizeof(mIrBindings));
 }
 
 bool remoteTask::init(void)
 {
-    setRunDuration(100);
     mLearnSem = xSemaphoreCreateBinary();
 
     /**
@@ -54,7 +73,10 @@ bool remoteTask::regTlm(void)
     #if SYS_CFG_ENABLE_TLM
         tlm_component *disk = tlm_component_get_by_name(SYS_CFG_DISK_TLM_NAME);
         if(success) {
-            success = TLM_REG_ARR(disk, mNumCodes, tlm_uint);
+            success = TLM_REG_ARR(disk, mIrCodes, tlm_uint);
+        }
+        if(success) {
+            success = TLM_REG_ARR(disk, mIrBindings, tlm_uint);
         }
     #endif
     return success;
@@ -62,43 +84,55 @@ bool remoteTask::regTlm(void)
 bool remoteTask::taskEntry(void)
 {
     // LD.clear();
+
+    /* The disk telemetry is restored before the scheduler starts, so count the learned codes now */
+    mCodeCount = 0;
+    for (unsigned int i = 0; i < REMOTE_CODE_SLOTS; i++) {
+        if (mIrBindings[i] & REMOTE_BINDING_USED) {
+            ++mCodeCount;
+        }
+    }
     return true;
 }
 bool remoteTask::run(void *p)
 {
-    uint32_t number = 0;
-    STR_ON_STACK(temp, 64);
+    uint16_t binding = 0;
+    ir_code_t ir = { 0, 0, 0 };
+    remote_learn_t req;
 
-    if(xSemaphoreTake(mLearnSem, 0))
-    {
-        puts("IR Codes will be learned.  Press buttons 0-9 on the remote");
-        LD.setLeftDigit('-');
-        LD.setRightDigit('-');
-
-        for(int i=0; i < 10; i++)
-        {
-            while(!IS.isIRCodeReceived()) {
-                vTaskDelayMs(100);
-            }
+    if(xSemaphoreTake(mLearnSem, 0)) {
+        learn(NULL);
+    }
+    else if (remote_learn_channel.receive(req, 0)) {
+        learn(&req);
+    }
 
-            unsigned int code = IS.getLastIRCode();
-            temp.printf("Learned: #%i = %x", i, code);
-            puts(temp());
+    /**
+     * Wait for the next IR code, which also sets the rate of checking the learn requests
+     * and the timer below.
+     */
+    const bool received = IS.getIrCode(ir, OS_MS(100)) && getBindingFromCode(ir, binding);
+    const uint16_t action = binding & REMOTE_BINDING_ACTION;
 
-            mNumCodes[i] = code;
-            LD.setNumber(i);
+    /* The other actions, and their repeats while the button is held if the action repeats */
+    if (received && action >= REMOTE_ACTION_DIGITS) {
+        if (0 == ir.repeat || (binding & REMOTE_BINDING_REPEAT)) {
+            /* Dropped if the channel is full, so the remote is not held up by a slow receiver */
+            const remote_action_t button = { action, ir.repeat };
+            remote_action_channel.send(button, 0);
         }
-
-        puts("Learned all numbers!");
-        vTaskDelayMs(2000);
     }
 
+    /* The repeats of a held digit are ignored */
+    const bool pressed = received && action < REMOTE_ACTION_DIGITS && (0 == ir.repeat);
+    const uint32_t number = action;
+
     /**
      * If the timer is running, we are expecting 2nd digit to be entered through IR code.
      * If the timeout occurs, we clear the LED display and throw away the IR numbers.
      */
     if (mIrNumTimer.isRunning()) {
-        if(IS.isIRCodeReceived() && getNumberFromCode(IS.getLastIRCode(), number))
+        if(pressed)
         {
             mIrNumber += number;
             LD.setRightDigit(number + '0');
@@ -107,7 +141,9 @@ bool remoteTask::run(void *p)
             vTaskDelayMs(2000);
 
             // Discard if any code came in within the delay above
-            (void) IS.getLastIRCode();
+            while (IS.getIrCode(ir, 0)) {
+                ;
+            }
             mIrNumTimer.stop();
         }
         else if (mIrNumTimer.expired()) {
@@ -120,7 +156,7 @@ bool remoteTask::run(void *p)
          * If we got an IR code, we store the left digit, and start the timer to expect
          * the 2nd IR code to be entered.
          */
-        if(IS.isIRCodeReceived() && getNumberFromCode(IS.getLastIRCode(), number)) {
+        if(pressed) {
             LD.setLeftDigit(number + '0');
             LD.setRightDigit('-');
 
@@ -142,16 +178,193 @@ void remoteTask::handleUserEntry(int num)
     /* TODO Handle the IR number here for your project */
 }
 
-bool remoteTask::getNumberFromCode(uint32_t code, uint32_t& num)
+void remoteTask::learn(const remote_learn_t *pReq)
 {
-    for(int i = 0; i < 10; i++)
+    ir_code_t ir = { 0, 0, 0 };
+    bool pressed = false;
+
+    if (NULL == pReq)
     {
-        if(mNumCodes[i] == code)
+        puts("IR Codes will be learned.  Press buttons 0-9 on the remote");
+        LD.setLeftDigit('-');
+        LD.setRightDigit('-');
+
+        for(int i=0; i < REMOTE_ACTION_DIGITS; i++)
         {
-            num = i;
-            return true;
+            // The repeats of a held button are not a new number
+            do {
+                (void) IS.getIrCode(ir, portMAX_DELAY);
+            } while (0 != ir.repeat);
+
+            // A number is only one button, so the button learned before is forgotten
+            forgetAction(i);
+            if (bindCode(ir, i, false)) {
+                printf("Learned: #%i = %x\n", i, (unsigned int) ir.code);
+            }
+            else {
+                printf("ERROR: %u codes are learned already, #%i is not learned\n", mCodeCount, i);
+            }
+            LD.setNumber(i);
+        }
+
+        puts("Learned all numbers!");
+        vTaskDelayMs(2000);
+        return;
+    }
+
+    switch (pReq->op)
+    {
+        case remote_learn_bind:
+            printf("Press the button of action %u\n", pReq->action);
+
+            // The repeats of the button held down before the press are not the press
+            while ((pressed = IS.getIrCode(ir, OS_MS(REMOTE_BIND_TIMEOUT_MS))) && 0 != ir.repeat) {
+                ;
+            }
+
+            if (!pressed) {
+                puts("No button was pressed");
+            }
+            else if (bindCode(ir, pReq->action, 0 != pReq->repeat)) {
+                printf("Learned: %x = action %u%s\n", (unsigned int) ir.code, pReq->action,
+                       pReq->repeat ? " (repeats)" : "");
+            }
+            else {
+                printf("ERROR: %u codes are learned already\n", mCodeCount);
+            }
+            break;
+
+        case remote_learn_forget:
+            printf("Forgot %u codes of action %u\n", forgetAction(pReq->action), pReq->action);
+            break;
+
+        case remote_learn_forget_all:
+            memset(mIrCodes, 0, sizeof(mIrCodes));
+            memset(mIrBindings, 0, sizeof(mIrBindings));
+            mCodeCount = 0;
+            puts("Forgot all the codes");
+            break;
+
+        case remote_learn_list:
+            listCodes();
+            break;
+
+        default:
+            break;
+    }
+}
+
+bool remoteTask::getBindingFromCode(const ir_code_t& ir, uint16_t& binding)
+{
+    const int slot = findSlot(ir.code, ir.protocol);
+    if (slot < 0) {
+        return false;
+    }
+
+    binding = mIrBindings[slot];
+    return true;
+}
+
+int remoteTask::findSlot(uint32_t code, uint8_t protocol)
+{
+    const uint16_t protocolBit = remote_protocol_bit(protocol);
+    unsigned int slot = remote_hash(code);
+
+    /* The table is never full, so an unused slot is reached soon after the code's hash slot */
+    for (unsigned int i = 0; i < REMOTE_CODE_SLOTS && (mIrBindings[slot] & REMOTE_BINDING_USED); i++)
+    {
+        if (code == mIrCodes[slot] && protocolBit == (mIrBindings[slot] & REMOTE_BINDING_RC5)) {
+            return slot;
+        }
+        slot = (slot + 1) & (REMOTE_CODE_SLOTS - 1);
+    }
+
+    return -1;
+}
+
+bool remoteTask::bindCode(const ir_code_t& ir, uint16_t action, bool repeat)
+{
+    const uint16_t binding = REMOTE_BINDING_USED | remote_protocol_bit(ir.protocol) |
+                             (repeat ? REMOTE_BINDING_REPEAT : 0) | (action & REMOTE_BINDING_ACTION);
+
+    /* A learned code is bound to the new action */
+    int slot = findSlot(ir.code, ir.protocol);
+    if (slot < 0)
+    {
+        if (mCodeCount >= REMOTE_MAX_CODES) {
+            return false;
+        }
+
+        slot = remote_hash(ir.code);
+        while (mIrBindings[slot] & REMOTE_BINDING_USED) {
+            slot = (slot + 1) & (REMOTE_CODE_SLOTS - 1);
+        }
+        ++mCodeCount;
+    }
+
+    mIrCodes[slot] = ir.code;
+    mIrBindings[slot] = binding;
+    return true;
+}
+
+void remoteTask::forgetSlot(unsigned int slot)
+{
+    /**
+     * The codes after the slot move back to it if it is between their hash slot and their slot,
+     * so there is no unused slot in the probing of any code, and no tombstones are needed.
+     */
+    unsigned int next = slot;
+    for (unsigned int i = 1; i < REMOTE_CODE_SLOTS; i++)
+    {
+        next = (next + 1) & (REMOTE_CODE_SLOTS - 1);
+        if (!(mIrBindings[next] & REMOTE_BINDING_USED)) {
+            break;
+        }
+
+        const unsigned int home = remote_hash(mIrCodes[next]);
+        if (((next - home) & (REMOTE_CODE_SLOTS - 1)) >= ((next - slot) & (REMOTE_CODE_SLOTS - 1))) {
+            mIrCodes[slot] = mIrCodes[next];
+            mIrBindings[slot] = mIrBindings[next];
+            slot = next;
         }
     }
 
-    return false;
+    mIrCodes[slot] = 0;
+    mIrBindings[slot] = 0;
+    --mCodeCount;
+}
+
+unsigned int remoteTask::forgetAction(uint16_t action)
+{
+    unsigned int count = 0;
+
+    for (unsigned int i = 0; i < REMOTE_CODE_SLOTS; )
+    {
+        if ((mIrBindings[i] & REMOTE_BINDING_USED) && action == (mIrBindings[i] & REMOTE_BINDING_ACTION)) {
+            // Another code may have moved to this slot, so it is checked again
+            forgetSlot(i);
+            ++count;
+        }
+        else {
+            ++i;
+        }
+    }
+
+    return count;
+}
+
+void remoteTask::listCodes(void)
+{
+    printf("%u of %u codes are learned\n", mCodeCount, REMOTE_MAX_CODES);
+
+    for (unsigned int i = 0; i < REMOTE_CODE_SLOTS; i++)
+    {
+        const uint16_t binding = mIrBindings[i];
+        if (binding & REMOTE_BINDING_USED) {
+            printf("  %08X %s : action %4u%s\n", (unsigned int) mIrCodes[i],
+                   (binding & REMOTE_BINDING_RC5) ? "RC5" : "NEC",
+                   binding & REMOTE_BINDING_ACTION,
+                   (binding & REMOTE_BINDING_REPEAT) ? " (repeats)" : "");
+        }
+    }
 }
@@ -24,9 +24,14 @@
 
 #include "uart0.hpp"        // Interrupt driven UART0 driver
 #include "nrf_stream.hpp"
+#if TERMINAL_USE_WIFI_MUX
+#include "examples/rn_xv_task.hpp"
+#endif
 
 #include "lpc_sys.h"        // Set input/output char functions
 #include "utilities.h"      // PRINT_EXECUTION_SPEED()
+#include "crc.h"            // crc32_update()
+#include "workqueue.h"      // Background commands
 #include "handlers.hpp"     // Command-line handlers
 
 #include "file_logger.h"
@@ -45,12 +50,118 @@
 
 
 
+#if SYS_CFG_ENABLE_TLM
+/// The disk telemetry file being written by disk_tlm_write()
+typedef struct {
+    FILE *file;         ///< The opened disk telemetry file
+    uint32_t bytes;     ///< The bytes written to the file
+    uint32_t crc;       ///< The CRC32 of the bytes written, for the check record
+    bool ok;            ///< False if any write failed
+} diskTlmJournal_t;
+
+/// The binary telemetry stream callback that writes to the disk telemetry file
+static void disk_tlm_write(const void *data, uint32_t len, void *arg)
+{
+    diskTlmJournal_t *j = (diskTlmJournal_t*) arg;
+    if (len != fwrite(data, 1, len, j->file)) {
+        j->ok = false;
+    }
+    j->bytes += len;
+    j->crc = crc32_update(j->crc, data, len);
+}
+#endif
+
+#if (TERMINAL_MAX_JOBS > 0)
+terminalTask::Job::Job() :
+        mState(job_free), mKilled(false), mId(0), mpOrigin(NULL), mEvent(NULL), mpProc(NULL),
+        mStartMs(0), mCmd(MAX_COMMANDLINE_INPUT), mOut(TERMINAL_JOB_OUT_BYTES)
+{
+    setReady(true);
+}
+
+void terminalTask::Job::drain(void)
+{
+    /* Only the output that is buffered now is written, so a command that keeps writing does
+     * not keep the terminal here
+     */
+    uint32_t remaining = mOut.size();
+    bool wrote = false;
+    char buff[32];
+
+    while (remaining > 0)
+    {
+        const uint32_t count = mOut.pop(buff, (remaining < sizeof(buff)) ? remaining : sizeof(buff));
+        if (0 == count) {
+            break;
+        }
+        remaining -= count;
+
+        /* The output of a killed command is dropped */
+        if (!mKilled) {
+            mpOrigin->putBlock(buff, count);
+            wrote = true;
+        }
+    }
+
+    if (wrote) {
+        mpOrigin->flush();
+    }
+}
+
+bool terminalTask::Job::getChar(char* pInputChar, unsigned int timeout)
+{
+    /* A background command has no input */
+    (void) pInputChar;
+    (void) timeout;
+    return false;
+}
+
+bool terminalTask::Job::putChar(char out, unsigned int timeout)
+{
+    return putBlock(&out, 1, timeout);
+}
+
+bool terminalTask::Job::putBlock(const void* pData, size_t len, unsigned int timeout)
+{
+    const char *pChars = (const char*) pData;
+    const TickType_t startTick = xTaskGetTickCount();
+
+    while (!mKilled)
+    {
+        const uint32_t pushed = mOut.push(pChars, len);
+        pChars += pushed;
+        len -= pushed;
+
+        if (pushed > 0 && mEvent) {
+            xSemaphoreGive(mEvent);
+        }
+        if (0 == len) {
+            return true;
+        }
+
+        /* The buffer is full, so wait for the terminal to write it */
+        if (0 == getRemainingTimeout(startTick, timeout)) {
+            break;
+        }
+        vTaskDelay(1);
+    }
+
+    return false;
+}
+#endif
+
 terminalTask::terminalTask(uint8_t priority) :
         scheduler_task("terminal", 1024*4, priority),
         mCmdIface(2), /* 2 interfaces can be added without memory reallocation */
-        mCmdProc(24), /* 24 commands can be added without memory reallocation */
-        mCommandCount(0), mDiskTlmSize(0), mpBinaryDiskTlm(NULL),
-        mCmdTimer(CMD_TIMEOUT_DISK_VARS)
+        mCmdProc(2), /* The commands of this task are added to the table of CMD_DEFINE_HANDLER() */
+        mCommandCount(0), mDiskTlmSize(0), mpBinaryDiskTlm(NULL), mDiskTlmJournalBytes(0),
+        mDiskTlmSaveTimer(),
+        mCmdTimer(CMD_TIMEOUT_DISK_VARS),
+        mRxEvent(0), mAllChannelsSignal(true),
+        mCmdFrame(mCmdProc), mShowPrompt(true)
+#if (TERMINAL_MAX_JOBS > 0)
+        , mLastJobId(0)
+#endif
 {
     /* Nothing to do */
 }
@@ -65,98 +176,154 @@ bool terminalTask::regTlm(void)
     #endif
 }
 
+/* The commands of the terminal, which are sorted by the linker (@see CMD_DEFINE_HANDLER()) */
+// System information handlers
+CMD_DEFINE_HANDLER(terminal, taskListHandler, "info",    "Task/CPU Info.  Use 'info 200' to get CPU during 200ms\n"
+                                                         "'info stacks' : Stack size and the most stack used by each task");
+CMD_DEFINE_HANDLER(terminal, topHandler,      "top",     "CPU of each task, averaged without resetting the counters.  'top once' : Print it once");
+CMD_DEFINE_HANDLER(terminal, memInfoHandler,  "meminfo", "See memory info\n"
+                                                         "'meminfo detail' : Heap fragmentation, pools and callers");
+CMD_DEFINE_HANDLER(terminal, healthHandler,   "health",  "Output system health\n"
+                                                         "'health reset' : Clears the interrupt latency and the lock statistics");
+CMD_DEFINE_HANDLER(terminal, timeHandler,     "time",    "'time' to view time.  'time set MM DD YYYY HH MM SS Wday' to set time");
+CMD_DEFINE_HANDLER(terminal, benchHandler,    "bench",   "Use 'bench' to see the benchmarks.  'bench all' : Run the ones that need no wiring");
+CMD_DEFINE_HANDLER(terminal, profileHandler,  "profile", "'profile' : The time of each PROFILE_SCOPE() site and command\n"
+                                                         "'profile <site>' : The histogram of a site\n"
+                                                         "'profile reset' : Clear the statistics");
+#if (SYS_CFG_TRACE_RECORDS > 0)
+CMD_DEFINE_HANDLER(terminal, traceHandler,    "trace",   "'trace start' : Record task switches, interrupts and queue operations\n"
+                                                         "'trace start all' : Also record the OS tick interrupt\n"
+                                                         "'trace stop' : Stop recording\n"
+                                                         "'trace summary' : Summarise the task, interrupt and queue timing\n"
+                                                         "'trace dump' : Output the records in binary (see trace_handlers.cpp)");
+#endif
+
+// File I/O handlers:
+CMD_DEFINE_HANDLER(terminal, catHandler,    "cat",   "Read a file.  Ex: 'cat 0:file.txt' or "
+                                                     "'cat 0:file.txt -noprint' to test if file can be read.  "
+                                                     "'cat 0:log0.csv -lz' prints the text of the LZ frames");
+CMD_DEFINE_HANDLER(terminal, cpHandler,     "cp",    "Copy files from/to Flash/SD Card.  Ex: 'cp 0:file.txt 1:file.txt'");
+CMD_DEFINE_HANDLER(terminal, dcpHandler,    "dcp",   "Copy all files of a directory to another directory.  Ex: 'dcp 0:src 1:dst'");
+CMD_DEFINE_HANDLER(terminal, lsHandler,     "ls",    "Use 'ls 0:' for Flash, or 'ls 1:' for SD Card");
+CMD_DEFINE_HANDLER(terminal, mkdirHandler,  "mkdir", "Create a directory. Ex: 'mkdir test'");
+CMD_DEFINE_HANDLER(terminal, mvHandler,     "mv",    "Rename a file. Ex: 'rm 0:file.txt 0:new.txt'");
+CMD_DEFINE_HANDLER(terminal, newFileHandler,"nf",    "Write a new file. Ex: 'nf <file.txt>");
+CMD_DEFINE_HANDLER(terminal, rmHandler,     "rm",    "Remove a file. Ex: 'rm 0:file.txt'");
+
+// Misc. handlers
+CMD_DEFINE_HANDLER(terminal, i2cIoHandler,   "i2c",   "'i2c read 0x01 0x02 <count>' : Reads  device 0x01, and register 0x02\n"
+                                                      "'i2c write 0x01 0x02 0x03'   : Writes device 0x01, reg 0x02, data 0x03\n"
+                                                      "'i2c discover' : Discover I2C devices");
+#if TERMINAL_USE_CAN_BUS_HANDLER
+CMD_HANDLER_FUNC(canBusHandler);
+CMD_DEFINE_HANDLER(terminal, canBusHandler,  "canbus", "'canbus init' : initialize CAN-1\n"
+                                                       "'canbus filter <id>' : Add 29-bit ID fitler\n"
+                                                       "'canbus tx <msg id> <len> <byte0> <byte1> ...' : Send CAN Message\n"
+                                                       "'canbus rx <timeout in ms>' : Receive a CAN message\n"
+                                                       "'canbus sendfile <file>' : Send a file to 'file can <file> <size>' over ISO-TP\n"
+                                                       "'canbus stats [reset]' : Bus load, frame rates, TX latency and the busiest IDs\n"
+                                                       "'canbus rec [start [file]|stop]' : Record the frames of both CANs to a file (default 1:can.bin)\n"
+                                                       "'canbus rec arm <key> [mask] [before] [after] [file]' : Record the frames around a trigger\n"
+                                                       "'canbus rec filter <key> [mask]|clear' : Only record the matching frames (see can_recorder.h)\n"
+                                                       "'canbus registers' : See some of CAN BUS registers");
+#endif
+
+CMD_DEFINE_HANDLER(terminal, storageHandler,  "storage",  "Parameters: 'format sd', 'format flash', 'mount sd', 'mount flash'");
+CMD_DEFINE_HANDLER(terminal, blackboxHandler, "blackbox", "'blackbox [status]' : The state of the recorder of the raw flash pages (see blackbox.h)\n"
+                                                          "'blackbox start|stop' : Start a new session of the log, or stop recording\n"
+                                                          "'blackbox export [file]' : Copy the pages, oldest first, to a file (default 1:blackbox.bin)\n"
+                                                          "'blackbox print [pages]' : Print the records of the newest pages");
+CMD_DEFINE_HANDLER(terminal, rebootHandler,   "reboot",   "Reboots the system");
+CMD_DEFINE_HANDLER(terminal, logHandler,      "log",      "'log <hello>': log an info message\n"
+                                                          "'log flush'  : flush the logs\n"
+                                                          "' log status': get status of the logger\n"
+                                                          "'log decode <0:log.bin>': decode the binary log\n"
+                                                          "'log level debug/info/warn/error': Sets the minimum level that is logged\n"
+                                                          "'log enableprint debug/info/warn/error' : Enables logger calls to printf\n"
+                                                          "'log disableprint debug/info/warn/error': Disables logger calls to printf\n"
+                                                          );
+CMD_DEFINE_HANDLER(terminal, learnIrHandler,  "learn",    "Begin to learn IR codes for numbers 0-9\n"
+                                                          "'learn <action> [repeat]' : Bind the next button to an action, which may repeat while held\n"
+                                                          "'learn list' : List the learned buttons\n"
+                                                          "'learn forget <action>|all' : Forget the buttons of an action, or all of them");
+CMD_DEFINE_HANDLER(terminal, wirelessHandler, "wireless", "Use 'wireless' to see the nested commands");
+CMD_DEFINE_HANDLER(terminal, helloHandler, "hello", "Use 'hello' to print hello world");
+CMD_DEFINE_HANDLER(terminal, ledHandler, "led", "Use 'led' to light an external LED via GPIO:\n"
+                                                "\t'-t' : Set total time for LED control (Default: 4000ms)\n"
+                                                "\t'-p' : Set blinking period (Default: 200ms)\n"
+                                                "\t'-i' : Set GPIO input port (Default: P0.30)\n"
+                                                "\t'-o' : Set GPIO output port (Default: P2.7)\n"
+                                                "example : led -t8000 -t100");
+CMD_DEFINE_HANDLER(terminal, spiHandler, "spi", "Use 'spi' to read out the information of the SPI flash attached to SSP1.\n");
+CMD_DEFINE_HANDLER(terminal, uartHandler, "uart", "Use 'uart' to test UART2 or UART3 function with other boards.\n"
+                                          "'--master' : Master mode (TX first); Default: slave (RX first)\n"
+                                          "'-p' : Set UART port 2 (default) or 3\n"
+                                          "'-b' : Set baud rate (Default: 9600; up to 1500000 within 1.5% error)\n"
+                                          "'-c' : Characters for Master mode to send (Default: 'A'; Max length: 255)\n"
+                                          "'-t' : Timeout threshold in ms (Default: 1000ms)\n"
+                                          "example1 : uart --master -cCheeseBurger -p3 -b115200\n"
+                                          "example2 : uart --slave -p3 -b9600");
+CMD_DEFINE_HANDLER(terminal, i2cSlaveHandler, "i2c-slave", "Use 'i2c-slave' to test I2C2 function as a Slave.\n"
+                                          "'-t' : Timeout threshold in ms (Default: 30000ms; Infinity if -t0)\n"
+                                          "example1 : i2c-slave -t0\n");
+CMD_DEFINE_HANDLER(terminal, orientationCmd, "orientation", "Two options: 'orientation on' or 'orientation off'");
+CMD_DEFINE_HANDLER(terminal, semaphoreCmd, "semaphore", "A test program running with semaphore and interrupt functions\n"
+                                           "'-p' : Set GPIO0 port number for interrupt detection (default: P0.30)\n");
+
+/* Firmware upgrade handlers
+ * Please read "netload_readme.txt" at ref_and_datasheets directory.
+ */
+CMD_HANDLER_FUNC(getFileHandler);
+CMD_HANDLER_FUNC(flashProgHandler);
+CMD_DEFINE_HANDLER(terminal, getFileHandler,   "file",  "Get a file using netload.exe or by using the following protocol:\n"
+                                                        "Write buffer: buffer <offset> <num bytes> [crc] ...\n"
+                                                        "Write buffer to file: commit <filename> <file offset> <num bytes from buffer>\n"
+                                                        "Receive over CAN ISO-TP: can <filename> <file size>\n"
+                                                        "Stream with CRC32 per chunk: stream <filename> <file size> [chunk size]\n"
+                                                        "Receive the next wireless multicast: mcast <filename> [wait seconds]");
+CMD_DEFINE_HANDLER(terminal, flashProgHandler, "flash", "'flash <filename>' Will flash CPU with this new binary file\n"
+                                                        "'flash stream <size> <crc32>' Receives the binary like 'file stream', and applies it\n"
+                                                        "'flash bulk <size> <crc32>' Receives the binary over wireless bulk transfer, and applies it\n"
+                                                        "'flash can <size> <crc32>' Receives the binary over CAN ISO-TP, and applies it\n"
+                                                        "'flash mcast <filename> [wait seconds]' Receives the binary of 'wireless mcast' to the file, and applies it");
+
+#if (SYS_CFG_ENABLE_TLM)
+CMD_DEFINE_HANDLER(terminal, telemetryHandler, "telemetry", "Outputs registered telemetry: "
+                                                            "'telemetry save' : Saves disk tel\n"
+                                                            "'telemetry ascii' : Prints all telemetry in human readable format\n"
+                                                            "'telemetry binary' : Outputs binary schema and data of all telemetry\n"
+                                                            "'telemetry delta' : Outputs binary telemetry changed since last binary/delta\n"
+                                                            "'telemetry sample <comp. name> <name> <ms>' : Samples a variable into history ring\n"
+                                                            "'telemetry samples' : Outputs and clears sampled history in binary format\n"
+                                                            "'telemetry sample clear' : Stops all sampling\n"
+                                                            "'telemetry sub <comp. name> <name> [deadband] [min ms]' : Pushes the changes of a variable in binary format\n"
+                                                            "'telemetry msub <addr> <comp. name> <name> [deadband] [min ms]' : Pushes the changes to a mesh node\n"
+                                                            "'telemetry unsub [addr]' : Stops pushing the changes to this terminal or the mesh node\n"
+                                                            "'telemetry <comp. name> <name> <value>' to set a telemetry variable\n"
+                                                            "'telemetry get <comp. name> <name>' to get variable value\n");
+#endif
+
+
 bool terminalTask::taskEntry()
 {
     /* remoteTask() creates shared object in its init(), so we can get it now */
     CommandProcessor &cp = mCmdProc;
 
-    // System information handlers
-    cp.addHandler(taskListHandler, "info",    "Task/CPU Info.  Use 'info 200' to get CPU during 200ms");
-    cp.addHandler(memInfoHandler,  "meminfo", "See memory info");
-    cp.addHandler(healthHandler,   "health",  "Output system health");
-    cp.addHandler(timeHandler,     "time",    "'time' to view time.  'time set MM DD YYYY HH MM SS Wday' to set time");
-
-    // File I/O handlers:
-    cp.addHandler(catHandler,    "cat",   "Read a file.  Ex: 'cat 0:file.txt' or "
-                                          "'cat 0:file.txt -noprint' to test if file can be read");
-    cp.addHandler(cpHandler,     "cp",    "Copy files from/to Flash/SD Card.  Ex: 'cp 0:file.txt 1:file.txt'");
-    cp.addHandler(dcpHandler,    "dcp",   "Copy all files of a directory to another directory.  Ex: 'dcp 0:src 1:dst'");
-    cp.addHandler(lsHandler,     "ls",    "Use 'ls 0:' for Flash, or 'ls 1:' for SD Card");
-    cp.addHandler(mkdirHandler,  "mkdir", "Create a directory. Ex: 'mkdir test'");
-    cp.addHandler(mvHandler,     "mv",    "Rename a file. Ex: 'rm 0:file.txt 0:new.txt'");
-    cp.addHandler(newFileHandler,"nf",    "Write a new file. Ex: 'nf <file.txt>");
-    cp.addHandler(rmHandler,     "rm",    "Remove a file. Ex: 'rm 0:file.txt'");
-
-    // Misc. handlers
-    cp.addHandler(i2cIoHandler,   "i2c",   "'i2c read 0x01 0x02 <count>' : Reads  device 0x01, and register 0x02\n"
-                                           "'i2c write 0x01 0x02 0x03'   : Writes device 0x01, reg 0x02, data 0x03\n"
-                                           "'i2c discover' : Discover I2C devices");
-#if TERMINAL_USE_CAN_BUS_HANDLER
-    CMD_HANDLER_FUNC(canBusHandler);
-    cp.addHandler(canBusHandler,  "canbus", "'canbus init' : initialize CAN-1\n"
-                                            "'canbus filter <id>' : Add 29-bit ID fitler\n"
-                                            "'canbus tx <msg id> <len> <byte0> <byte1> ...' : Send CAN Message\n"
-                                            "'canbus rx <timeout in ms>' : Receive a CAN message\n"
-                                            "'canbus registers' : See some of CAN BUS registers");
+    /* The commands of CMD_DEFINE_HANDLER() are in the flash, and only the ones that need this task are added */
+    cp.addTable("terminal");
+#if (TERMINAL_MAX_JOBS > 0)
+    cp.addHandler(jobsCmd,         "jobs",    "The commands running in the background.  A command with a trailing '&' runs\n"
+                                              "in the background, such as 'dcp 0:src 1:dst &', and its output is shown when the terminal is idle", this);
+    cp.addHandler(killCmd,         "kill",    "'kill <job>' : Drops the output of a background command, and fails its writes", this);
 #endif
 
-    cp.addHandler(storageHandler,  "storage",  "Parameters: 'format sd', 'format flash', 'mount sd', 'mount flash'");
-    cp.addHandler(rebootHandler,   "reboot",   "Reboots the system");
-    cp.addHandler(logHandler,      "log",      "'log <hello>': log an info message\n"
-                                               "'log flush'  : flush the logs\n"
-                                               "' log status': get status of the logger\n"
-                                               "'log enableprint debug/info/warn/error' : Enables logger calls to printf\n"
-                                               "'log disableprint debug/info/warn/error': Disables logger calls to printf\n"
-                                               );
-    cp.addHandler(learnIrHandler,  "learn",    "Begin to learn IR codes for numbers 0-9");
-    cp.addHandler(wirelessHandler, "wireless", "Use 'wireless' to see the nested commands");
-    cp.addHandler(helloHandler, "hello", "Use 'hello' to print hello world");
-    cp.addHandler(ledHandler, "led", "Use 'led' to light an external LED via GPIO:\n"
-                                     "\t'-t' : Set total time for LED control (Default: 4000ms)\n"
-                                     "\t'-p' : Set blinking period (Default: 200ms)\n"
-                                     "\t'-i' : Set GPIO input port (Default: P0.30)\n"
-                                     "\t'-o' : Set GPIO output port (Default: P2.7)\n"
-                                     "example : led -t8000 -t100");
-    cp.addHandler(spiHandler, "spi", "Use 'spi' to read out the information of the SPI flash attached to SSP1.\n");
-    cp.addHandler(uartHandler, "uart", "Use 'uart' to test UART2 or UART3 function with other boards.\n"
-                               "'--master' : Master mode (TX first); Default: slave (RX first)\n"
-                               "'-p' : Set UART port 2 (default) or 3\n"
-                               "'-b' : Set baud rate (9600[*], 19200, 38400, 57600 or 115200)\n"
-                               "'-c' : Characters for Master mode to send (Default: 'A'; Max length: 255)\n"
-                               "'-t' : Timeout threshold in ms (Default: 1000ms)\n"
-                               "example1 : uart --master -cCheeseBurger -p3 -b115200\n"
-                               "example2 : uart --slave -p3 -b9600");
-    cp.addHandler(i2cSlaveHandler, "i2c-slave", "Use 'i2c-slave' to test I2C2 function as a Slave.\n"
-                               "'-t' : Timeout threshold in ms (Default: 30000ms; Infinity if -t0)\n"
-                               "example1 : i2c-slave -t0\n");
-    cp.addHandler(orientationCmd, "orientation", "Two options: 'orientation on' or 'orientation off'");
-    cp.addHandler(semaphoreCmd, "semaphore", "A test program running with semaphore and interrupt functions\n"
-                                "'-p' : Set GPIO0 port number for interrupt detection (default: P0.30)\n");
-
-    /* Firmware upgrade handlers
-     * Please read "netload_readme.txt" at ref_and_datasheets directory.
-     */
-    CMD_HANDLER_FUNC(getFileHandler);
-    CMD_HANDLER_FUNC(flashProgHandler);
-    cp.addHandler(getFileHandler,   "file",  "Get a file using netload.exe or by using the following protocol:\n"
-                                             "Write buffer: buffer <offset> <num bytes> ...\n"
-                                             "Write buffer to file: commit <filename> <file offset> <num bytes from buffer>");
-    cp.addHandler(flashProgHandler, "flash", "'flash <filename>' Will flash CPU with this new binary file");
-
-    #if (SYS_CFG_ENABLE_TLM)
-    cp.addHandler(telemetryHandler, "telemetry", "Outputs registered telemetry: "
-                                                 "'telemetry save' : Saves disk tel\n"
-                                                 "'telemetry ascii' : Prints all telemetry in human readable format\n"
-                                                 "'telemetry <comp. name> <name> <value>' to set a telemetry variable\n"
-                                                 "'telemetry get <comp. name> <name>' to get variable value\n");
-    #endif
-
     // Initialize Interrupt driven version of getchar & putchar
     Uart0& uart0 = Uart0::getInstance();
-    bool success = uart0.init(SYS_CFG_UART0_BPS, 32, SYS_CFG_UART0_TXQ_SIZE);
+    bool success = uart0.init(SYS_CFG_UART0_BPS, SYS_CFG_UART0_RXQ_SIZE, SYS_CFG_UART0_TXQ_SIZE);
     uart0.setReady(true);
     sys_set_inchar_func(uart0.getcharIntrDriven);
     sys_set_outchar_func(uart0.putcharIntrDriven);
+    sys_set_outblock_func(uart0.putblockIntrDriven);
 
     /* Add UART0 to command input/output */
     addCommandChannel(&uart0, true);
@@ -165,10 +332,23 @@ bool terminalTask::taskEntry()
     do {
         NordicStream& nrf = NordicStream::getInstance();
         nrf.setReady(true);
+        nrf.setWindow(TERMINAL_NRF_STREAM_WINDOW);
+        nrf.setCoalescing(TERMINAL_NRF_STREAM_IDLE_MS, TERMINAL_NRF_STREAM_NEWLINE);
         addCommandChannel(&nrf, false);
     } while(0);
     #endif
 
+    #if TERMINAL_USE_WIFI_MUX
+    do {
+        /* The terminal channel of the wifiTask is shared during init() */
+        CharDev *pWifi = (CharDev*) getSharedObject(WIFI_MUX_SHR_OBJ);
+        if (NULL != pWifi) {
+            pWifi->setReady(true);
+            addCommandChannel(pWifi, false);
+        }
+    } while(0);
+    #endif
+
     #if SYS_CFG_ENABLE_TLM
     /* Telemetry should be registered at this point, so initialize the binary
      * telemetry space that we periodically check to save data to disk
@@ -194,7 +374,9 @@ bool terminalTask::taskEntry()
 
 bool terminalTask::run(void* p)
 {
-    printf("LPC: ");
+    if (mShowPrompt) {
+        printf("LPC: ");
+    }
     cmdChan_t cmdChannel = getCommand();
 
     // If no command, try to save disk data (persistent variables)
@@ -206,17 +388,60 @@ bool terminalTask::run(void* p)
             puts("");
         }
     }
+    else if (cmdChannel.frame) {
+        ++mCommandCount;
+        mShowPrompt = false;
+
+        #if (TERMINAL_STR_ARENA_BYTES > 0)
+        str::arenaBegin(mStrArena, sizeof(mStrArena));
+        mCmdFrame.handleFrame(*(cmdChannel.iodev), *(cmdChannel.cmdstr));
+        str::arenaEnd();
+        #else
+        mCmdFrame.handleFrame(*(cmdChannel.iodev), *(cmdChannel.cmdstr));
+        #endif
+
+        cmdChannel.cmdstr->clear();
+        cmdChannel.iodev->flush();
+    }
     else {
         // Set our references to the IO channel and the command str (just for covenience sake)
         CharDev& io = *(cmdChannel.iodev);
         str& cmd = *(cmdChannel.cmdstr);
 
+        #if (TERMINAL_MAX_JOBS > 0)
+        /* A trailing '&' runs the command on the workqueue, so this and the other channels can
+         * run commands while it runs
+         */
+        if (cmd.endsWith("&"))
+        {
+            ++mCommandCount;
+            cmd.eraseLast(1);
+            cmd.trimEnd(" ");
+            if (!startJob(cmdChannel)) {
+                io.putline("Could not start the background command, see 'jobs'");
+            }
+
+            cmd.clear();
+            io.flush();
+        }
+        else
+        #endif
         if (cmd.getLen() > 0)
         {
             PRINT_EXECUTION_SPEED()
             {
                 ++mCommandCount;
+
+                /* Temporary str objects of the command handler use the arena rather
+                 * than the heap, and all of it is given back after the command.
+                 */
+                #if (TERMINAL_STR_ARENA_BYTES > 0)
+                str::arenaBegin(mStrArena, sizeof(mStrArena));
                 mCmdProc.handleCommand(cmd, io);
+                str::arenaEnd();
+                #else
+                mCmdProc.handleCommand(cmd, io);
+                #endif
 
                 /* Send special chars to indicate end of command output
                  * Usually, serial terminals will ignore these chars
@@ -230,6 +455,7 @@ bool terminalTask::run(void* p)
             cmd.clear();
             io.flush();
         }
+        mShowPrompt = true;
     }
 
     return true;
@@ -247,20 +473,35 @@ bool terminalTask::saveDiskTlm(void)
         return changed;
     }
 
+    /* A variable that keeps changing would otherwise be written every time the terminal is idle */
+    if (mDiskTlmSaveTimer.isRunning() && !mDiskTlmSaveTimer.expired()) {
+        return changed;
+    }
+
     if (!tlm_binary_compare_one(disk, mpBinaryDiskTlm))
     {
         changed = true;
         puts("Disk variables changed...");
 
-        FILE *file = fopen(SYS_CFG_DISK_TLM_NAME, "w");
-        if (file) {
+        /* Append only the changed variables, but write the schema and all of the data the first
+         * time after boot (the registered variables may differ from the file), or if the file is
+         * full or a previous save failed.
+         */
+        const bool compact = (0 == mDiskTlmJournalBytes || mDiskTlmJournalBytes >= SYS_CFG_DISK_TLM_JOURNAL_BYTES);
+        diskTlmJournal_t journal = { fopen(SYS_CFG_DISK_TLM_NAME, compact ? "w" : "a"), 0, 0, true };
+
+        if (journal.file) {
             // Only update variables if we could open the file
-            tlm_binary_get_one(disk, mpBinaryDiskTlm);
+            tlm_stream_one_binary(disk, disk_tlm_write, &journal, mpBinaryDiskTlm, !compact);
 
-            tlm_stream_one_file(disk, file);
-            fclose(file);
+            /* The records of this save are only restored if the check after them was written */
+            tlm_stream_binary_check(disk_tlm_write, &journal, journal.crc);
+            fclose(journal.file);
 
-            puts("Changes saved to disk...");
+            mDiskTlmJournalBytes = !journal.ok ? 0 : (compact ? 0 : mDiskTlmJournalBytes) + journal.bytes;
+            mDiskTlmSaveTimer.reset(SYS_CFG_DISK_TLM_MIN_SAVE_MS);
+
+            printf("%u bytes of changes saved to disk...\n", (unsigned) journal.bytes);
             LOG_SIMPLE_MSG("Disk variables saved to disk");
         }
     }
@@ -269,6 +510,128 @@ bool terminalTask::saveDiskTlm(void)
     return changed;
 }
 
+#if (TERMINAL_MAX_JOBS > 0)
+bool terminalTask::startJob(cmdChan_t& chan)
+{
+    Job *pJob = NULL;
+    for (unsigned i = 0; i < TERMINAL_MAX_JOBS && !pJob; i++) {
+        if (Job::job_free == mJobs[i].mState) {
+            pJob = &mJobs[i];
+        }
+    }
+
+    /* The low worker has the stack for the commands */
+    if (NULL == pJob || 0 == chan.cmdstr->getLen() || !workqueue_start(work_prio_low)) {
+        return false;
+    }
+
+    if (0 == ++mLastJobId) {
+        ++mLastJobId;
+    }
+    pJob->mId = mLastJobId;
+    pJob->mKilled = false;
+    pJob->mpOrigin = chan.iodev;
+    pJob->mEvent = mRxEvent;
+    pJob->mpProc = &mCmdProc;
+    pJob->mStartMs = sys_get_uptime_ms();
+    pJob->mCmd = *(chan.cmdstr);
+    pJob->mState = Job::job_pending;
+
+    if (!workqueue_post(work_prio_low, runJob, pJob)) {
+        pJob->mState = Job::job_free;
+        return false;
+    }
+
+    chan.iodev->printf("[%u] %s\n", pJob->mId, pJob->mCmd());
+    return true;
+}
+
+void terminalTask::serviceJobs(void)
+{
+    for (unsigned i = 0; i < TERMINAL_MAX_JOBS; i++)
+    {
+        Job& job = mJobs[i];
+        if (Job::job_free == job.mState) {
+            continue;
+        }
+
+        /* The state is read before the output, so all of the output of a finished job is written */
+        const bool done = (Job::job_done == job.mState);
+        job.drain();
+
+        if (done) {
+            job.mpOrigin->printf("[%u] %s  %s\n", job.mId, job.mKilled ? "Killed" : "Done", job.mCmd());
+            job.mpOrigin->flush();
+            job.mState = Job::job_free;
+        }
+    }
+}
+
+void terminalTask::runJob(void *pJob)
+{
+    Job *pThis = (Job*) pJob;
+
+    /* The command processor changes the command, so mCmd is kept for 'jobs' */
+    if (!pThis->mKilled) {
+        pThis->mState = Job::job_running;
+        str cmd(pThis->mCmd);
+        pThis->mpProc->handleCommand(cmd, *pThis);
+    }
+
+    pThis->mState = Job::job_done;
+    if (pThis->mEvent) {
+        xSemaphoreGive(pThis->mEvent);
+    }
+}
+
+bool terminalTask::jobsCmd(str& cmdParams, CharDev& output, void* pDataParam)
+{
+    static const char * const states[] = { "free", "pending", "running", "done" };
+    terminalTask *pThis = (terminalTask*) pDataParam;
+    const uint32_t nowMs = sys_get_uptime_ms();
+    unsigned count = 0;
+
+    for (unsigned i = 0; i < TERMINAL_MAX_JOBS; i++)
+    {
+        const Job& job = pThis->mJobs[i];
+        const Job::state_t state = job.mState;
+        if (Job::job_free != state) {
+            output.printf("[%u] %-8s %6us  %s\n", job.mId, job.mKilled ? "killed" : states[state],
+                          (unsigned) ((nowMs - job.mStartMs) / 1000), job.mCmd());
+            ++count;
+        }
+    }
+
+    if (0 == count) {
+        output.putline("No background commands");
+    }
+    return true;
+}
+
+bool terminalTask::killCmd(str& cmdParams, CharDev& output, void* pDataParam)
+{
+    terminalTask *pThis = (terminalTask*) pDataParam;
+    unsigned id = 0;
+
+    if (1 != cmdParams.scanf("%u", &id)) {
+        return false;
+    }
+
+    for (unsigned i = 0; i < TERMINAL_MAX_JOBS; i++)
+    {
+        Job& job = pThis->mJobs[i];
+        if (Job::job_free != job.mState && id == job.mId) {
+            /* A command that runs cannot be stopped, but its writes fail from now on */
+            job.mKilled = true;
+            output.printf("[%u] Killed  %s\n", job.mId, job.mCmd());
+            return true;
+        }
+    }
+
+    output.printf("No background command %u\n", id);
+    return true;
+}
+#endif
 
 void terminalTask::handleEchoAndBackspace(cmdChan_t *io, char newChar)
 {
@@ -303,15 +666,24 @@ void terminalTask::addCommandChannel(CharDev *channel, bool echo)
     cmdChan_t input;
     input.iodev = channel;
     input.echo = echo;
+    input.frame = false;
     input.cmdstr = new str(MAX_COMMANDLINE_INPUT);
     mCmdIface += input;
+
+    /* All channels share one event, so we can wait for the input of all of them at once */
+    if (NULL == mRxEvent) {
+        mRxEvent = xSemaphoreCreateBinary();
+    }
+    if (!mRxEvent || !channel->setRxEvent(mRxEvent)) {
+        mAllChannelsSignal = false;
+    }
 }
 
 terminalTask::cmdChan_t terminalTask::getCommand(void)
 {
     if (0 == mCmdIface.size()) {
         vTaskDelayMs(1000);
-        cmdChan_t noIface = { NULL, NULL };
+        cmdChan_t noIface = { NULL, NULL, false, false };
         return noIface;
     }
 
@@ -321,6 +693,10 @@ terminalTask::cmdChan_t terminalTask::getCommand(void)
 
     do
     {
+        #if (TERMINAL_MAX_JOBS > 0)
+        serviceJobs();
+        #endif
+
         /* Get a single char from one of the input sources */
         const TickType_t ticksBefore = xTaskGetTickCount();
         bool gotChar = false;
@@ -330,19 +706,32 @@ terminalTask::cmdChan_t terminalTask::getCommand(void)
             if (mCmdIface[idx].iodev->isReady() && mCmdIface[idx].iodev->getChar(&c, 0))
             {
                 ret = mCmdIface[idx];
-                handleEchoAndBackspace(&ret, c);
-
                 mCmdTimer.reset();
+
+                /* The sync byte at the start of a line begins a binary command frame */
+                if (0 == ret.cmdstr->getLen() && CommandFrame::isRequestSync(c)) {
+                    ret.frame = true;
+                    return ret;
+                }
+                handleEchoAndBackspace(&ret, c);
                 gotChar = true;
                 break;
             }
         }
 
-        /* If no interfaces are ready, we will not sleep in the previous loop,
-         * so we don't want to hog the CPU, so just delay here by one tick
+        /* If no channel had any input, sleep until one of them receives a char, or until the
+         * command timer expires.  If a channel cannot signal us, then we have to poll it, so
+         * just wait for two ticks in that case to avoid hogging the CPU.
          */
         if (!gotChar && xTaskGetTickCount() == ticksBefore) {
-            vTaskDelay(2);
+            const uint32_t timerMs = mCmdTimer.getTimeToExpirationMs() + 1;
+            const TickType_t waitTicks = mAllChannelsSignal ? OS_MS(timerMs) : 2;
+            if (mRxEvent) {
+                xSemaphoreTake(mRxEvent, waitTicks);
+            }
+            else {
+                vTaskDelay(waitTicks);
+            }
         }
 
         /* Guard against command length too large */
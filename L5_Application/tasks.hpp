@@ -26,8 +26,13 @@
 #include "scheduler_task.hpp"
 #include "soft_timer.hpp"
 #include "command_handler.hpp"
+#include "command_frame.hpp"
 #include "wireless.h"
 #include "char_dev.hpp"
+#include "circular_buffer.hpp"
+#include "sensor_hub.hpp"
+#include "IR_sensor.hpp"
+#include "shared_handles.h"
 
 #include "FreeRTOS.h"
 #include "semphr.h"
@@ -39,6 +44,11 @@
  * This also saves and restores the "disk" telemetry.  Disk telemetry variables
  * are automatically saved and restored across power-cycles to help us preserve
  * any non-volatile information.
+ *
+ * The disk telemetry file is a journal of binary telemetry records: the first save after
+ * boot writes the schema and all of the data, and the later saves only append the variables
+ * that changed, so they are replayed in order at the next boot.  The file is rewritten as one
+ * snapshot once the appended changes grow past SYS_CFG_DISK_TLM_JOURNAL_BYTES.
  */
 class terminalTask : public scheduler_task
 {
@@ -54,26 +64,106 @@ class terminalTask : public scheduler_task
             CharDev *iodev; ///< The IO channel
             str *cmdstr;    ///< The command string
             bool echo;      ///< If input should be echo'd back
+            bool frame;     ///< If a binary command frame was started rather than a text command
         } cmdChan_t;
 
+#if (TERMINAL_MAX_JOBS > 0)
+        /**
+         * A command that was started with a trailing '&', and runs on the low workqueue worker.
+         * Its output is buffered, and written to the channel that started it by the terminal.
+         * Only the terminal frees a job, after all of its output was written.
+         */
+        class Job : public CharDev
+        {
+            public:
+                /// The state of a job
+                typedef enum {
+                    job_free,       ///< The job is not used
+                    job_pending,    ///< Posted to the workqueue, but not started yet
+                    job_running,    ///< The command is running
+                    job_done,       ///< The command returned, but its output may not be written yet
+                } state_t;
+
+                Job();
+
+                /// Writes the buffered output to the channel that started the command
+                void drain(void);
+
+                /** @{ Virtual function overrides for the base class to work */
+                bool getChar(char* pInputChar, unsigned int timeout=portMAX_DELAY);
+                bool putChar(char out, unsigned int timeout=portMAX_DELAY);
+                bool putBlock(const void* pData, size_t len, unsigned int timeout=portMAX_DELAY);
+                /** @} */
+
+                volatile state_t mState;        ///< @see state_t
+                volatile bool mKilled;          ///< Set by 'kill', so the output is dropped and the writes fail
+                uint8_t mId;                    ///< The number of the job shown by 'jobs'
+                CharDev *mpOrigin;              ///< The channel that started the command
+                SemaphoreHandle_t mEvent;       ///< Given when there is output, which is the mRxEvent of the terminal
+                CommandProcessor *mpProc;       ///< The command processor that runs the command
+                uint32_t mStartMs;              ///< The uptime when the command was started
+                str mCmd;                       ///< The command
+                SpscRingBuffer<char> mOut;      ///< The output not yet written to mpOrigin
+        };
+#endif
+
         VECTOR<cmdChan_t> mCmdIface;   ///< Command interfaces
         CommandProcessor mCmdProc;     ///< Command processor
         uint16_t mCommandCount;        ///< terminal command count
         uint16_t mDiskTlmSize;         ///< Size of disk variables in bytes
         char *mpBinaryDiskTlm;         ///< Binary disk telemetry
+        uint32_t mDiskTlmJournalBytes; ///< Bytes written to the disk telemetry file since it was compacted
+        SoftTimer mDiskTlmSaveTimer;   ///< Throttles the saves of the disk telemetry
         SoftTimer mCmdTimer;           ///< Command timer
+        SemaphoreHandle_t mRxEvent;    ///< Given by the command channels when they receive input
+        bool mAllChannelsSignal;       ///< True if all channels give mRxEvent, so they need not be polled
+        CommandFrame mCmdFrame;        ///< Runs the binary command frames
+        bool mShowPrompt;              ///< The prompt is not shown after a command frame to keep the frames apart
+#if (TERMINAL_MAX_JOBS > 0)
+        Job mJobs[TERMINAL_MAX_JOBS];  ///< The background commands
+        uint8_t mLastJobId;            ///< The number of the last background command
+#endif
+#if (TERMINAL_STR_ARENA_BYTES > 0)
+        char mStrArena[TERMINAL_STR_ARENA_BYTES]; ///< str arena for each command
+#endif
 
         cmdChan_t getCommand(void);
         void addCommandChannel(CharDev *channel, bool echo);
         void handleEchoAndBackspace(cmdChan_t *io, char c);
         bool saveDiskTlm(void);
+
+#if (TERMINAL_MAX_JOBS > 0)
+        bool startJob(cmdChan_t& chan);     ///< Posts the command of the channel to the workqueue
+        void serviceJobs(void);             ///< Writes the output of the jobs, and frees the finished jobs
+        static void runJob(void *pJob);     ///< The work item of a job
+        static bool jobsCmd(str& cmdParams, CharDev& output, void* pDataParam);  ///< 'jobs' command
+        static bool killCmd(str& cmdParams, CharDev& output, void* pDataParam);  ///< 'kill' command
+#endif
 };
 
+#define REMOTE_CODE_SLOTS       256     ///< The slots of the hash table of the learned IR codes, which is a power of two
+#define REMOTE_MAX_CODES        (REMOTE_CODE_SLOTS * 3 / 4)  ///< The table is at most 3/4 full, so a lookup only probes a few slots
+#define REMOTE_ACTION_DIGITS    10      ///< The actions 0-9 are the digits of the 2-digit number
+#define REMOTE_BIND_TIMEOUT_MS  (10 * 1000) ///< The time to press the button of 'learn <action>'
+
+/** @{ The bits of a binding of a learned IR code */
+#define REMOTE_BINDING_USED     (1 << 15)   ///< The slot is used
+#define REMOTE_BINDING_REPEAT   (1 << 14)   ///< The action repeats while the button is held
+#define REMOTE_BINDING_RC5      (1 << 13)   ///< The code is ir_protocol_rc5, otherwise ir_protocol_nec
+#define REMOTE_BINDING_ACTION   REMOTE_ACTION_MAX   ///< The mask of the action
+/** @} */
+
 /**
  * Remote task is the task that monitors the IR remote control signals.
  * It can "learn" remote control codes by typing "learn" into the UART0 terminal.
  * Thereafter, if a user enters a 2-digit number through a remote control, then
  * your function handleUserEntry() is called where you can take an action.
+ *
+ * Any other button of a universal remote is bound to an action by 'learn <action> [repeat]', and
+ * then the button is sent to remote_action_channel, where the task of your project receives it.
+ * The codes are in a hash table of REMOTE_CODE_SLOTS, so the lookup takes the same time for
+ * hundreds of codes as for the ten digits.  The table is disk telemetry, so the learned codes
+ * are kept across power-cycles.
  */
 class remoteTask : public scheduler_task
 {
@@ -87,15 +177,33 @@ class remoteTask : public scheduler_task
     private:
         /** This function is called when a 2-digit number is decoded */
         void handleUserEntry(int num);
-        
+
         /**
-         * @param code  The IR code
-         * @param num   The matched number 0-9 that mapped the IR code.
-         * @returns true if the code has been successfully mapped to the num
+         * @param ir       The IR code
+         * @param binding  The binding of the code (@see REMOTE_BINDING_USED)
+         * @returns true if the code has been learned
          */
-        bool getNumberFromCode(uint32_t code, uint32_t& num);
+        bool getBindingFromCode(const ir_code_t& ir, uint16_t& binding);
+
+        /** @{ The operations of the hash table of the learned codes */
+        int findSlot(uint32_t code, uint8_t protocol);        ///< @returns the slot of the code, or -1 if not learned
+        bool bindCode(const ir_code_t& ir, uint16_t action, bool repeat);
+        void forgetSlot(unsigned int slot);
+        unsigned int forgetAction(uint16_t action);         ///< @returns the number of codes that were forgotten
+        void listCodes(void);
+        /** @} */
 
-        uint32_t mNumCodes[10];      ///< IR Number codes
+        /// Learns the buttons 0-9, or the request of the 'learn' command
+        void learn(const remote_learn_t *pReq);
+
+        /**
+         * The hash table of the learned codes, which are disk telemetry variables.  A slot is used
+         * if its binding has REMOTE_BINDING_USED, and a code is at its hash slot or at the next used
+         * slots (linear probing).  The slots are saved as they are, so the table is not rebuilt.
+         */
+        uint32_t mIrCodes[REMOTE_CODE_SLOTS];
+        uint16_t mIrBindings[REMOTE_CODE_SLOTS];    ///< The bindings of mIrCodes[] (@see REMOTE_BINDING_USED)
+        uint16_t mCodeCount;         ///< The number of learned codes
         uint32_t mIrNumber;          ///< Current IR number we're decoding
         SemaphoreHandle_t mLearnSem; ///< Semaphore to enable IR code learning
         SoftTimer mIrNumTimer;       ///< Time-out for user entry for 1st and 2nd digit
@@ -103,7 +211,8 @@ class remoteTask : public scheduler_task
 
 /**
  * Nordic wireless task to participate in the mesh network and handle retry logic
- * such that packets are resent if an ACK has not been received
+ * such that packets are resent if an ACK has not been received.
+ * This should run at a lower priority than the wirelessRadioTask.
  */
 class wirelessTask : public scheduler_task
 {
@@ -121,6 +230,26 @@ class wirelessTask : public scheduler_task
         }
 };
 
+/**
+ * Nordic radio task that only moves the received frames from the radio to the wirelessTask,
+ * such that the radio FIFO doesn't overflow while the wirelessTask runs at a lower priority.
+ */
+class wirelessRadioTask : public scheduler_task
+{
+    public:
+        wirelessRadioTask(uint8_t priority) :
+            scheduler_task("radio", 256, priority)
+        {
+            /* Nothing to init */
+        }
+
+        bool run(void *p)
+        {
+            wireless_radio_service(); ///< Blocks until the radio interrupt
+            return true;
+        }
+};
+
 
 
 #endif /* TASKS_HPP_ */
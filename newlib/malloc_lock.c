@@ -16,8 +16,12 @@
  *          p r e e t . w i k i @ g m a i l . c o m
  */
  
+#include <stdbool.h>
+
 #include "FreeRTOS.h"
 #include "task.h"
+#include "os_lock_stats.h"
+#include "LPC17xx.h"    // SCB->ICSR
 
 
 
@@ -26,14 +30,52 @@
  * @brief This file defines the GCC functions for malloc lock and unlock.
  *        These are mainly needed when using FreeRTOS, and are harmless if FreeRTOS is not running.
  *        GCC calls these functions before and after calling the malloc() functions.
+ *
+ *        With configMALLOC_LOCK_SCHEDULER, the lock suspends the scheduler instead of masking the
+ *        interrupts, so the interrupt latency does not depend on the heap walk of malloc().  The
+ *        interrupts can then run while a task is in malloc(), so an ISR must not use malloc() or
+ *        free(); the lock of an ISR still masks the interrupts, which only protects it from other ISRs.
+ *        The code that allocates often can use the allocators of mem_arena.h that need no lock.
+ */
+
+/**
+ * The lock cannot be contended, so the statistics are the hold times, which are the time that
+ * malloc() keeps the scheduler suspended (or the interrupts masked).  The lock is nested by the
+ * malloc functions.
  */
+static os_lock_stats_t g_malloc_lock_stats = OS_LOCK_STATS_INIT("malloc");
+static uint32_t g_malloc_lock_depth = 0;
+
+/// @returns true if the lock masks the interrupts rather than suspending the scheduler
+static inline bool malloc_lock_masks_intr(void)
+{
+    return (!configMALLOC_LOCK_SCHEDULER || 0 != (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk));
+}
 
 __attribute__ ((used)) void __malloc_lock( void *_r )
 {
-    vPortEnterCritical();
+    if (malloc_lock_masks_intr()) {
+        vPortEnterCritical();
+    }
+    else {
+        vTaskSuspendAll();
+    }
+
+    if (0 == g_malloc_lock_depth++) {
+        os_lock_acquired(&g_malloc_lock_stats, os_lock_wait_start(), false);
+    }
 }
 
 __attribute__ ((used)) void __malloc_unlock( void *_r )
 {
-    vPortExitCritical();
+    if (0 == --g_malloc_lock_depth) {
+        os_lock_released(&g_malloc_lock_stats);
+    }
+
+    if (malloc_lock_masks_intr()) {
+        vPortExitCritical();
+    }
+    else {
+        (void) xTaskResumeAll();
+    }
 }
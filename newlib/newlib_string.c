@@ -0,0 +1,152 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief This file replaces the memcpy(), memset() and memcmp() of the C library, which are byte loops
+ *        when newlib is optimized for size.  Every queued message, packet and sector buffer is copied
+ *        by these, so they move the words once the pointers are aligned, and the 32 byte blocks using
+ *        LDM and STM, which take one cycle per word after the first one.
+ *
+ * The source word of memcpy() and the words of memcmp() do not need the same alignment as the
+ * destination because the Cortex-M3 supports the unaligned LDR (but not the unaligned LDM).
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "newlib_string.h"
+
+/* The compiler must not turn the loops below into the calls to themselves */
+#pragma GCC optimize ("no-tree-loop-distribute-patterns")
+
+
+
+/// The aligned word type, which may alias any type
+typedef uint32_t __attribute__((may_alias)) mem_aligned_t;
+
+/// Copies 32 bytes from the aligned s to the aligned d, and advances both of them
+#if defined(__ARM_ARCH_7M__)
+#define MEM_COPY_BLOCK(d, s)                                \
+    __asm__ volatile ("ldmia %[src]!, {r3, r4, r5, r6}\n\t" \
+                      "stmia %[dst]!, {r3, r4, r5, r6}\n\t" \
+                      "ldmia %[src]!, {r3, r4, r5, r6}\n\t" \
+                      "stmia %[dst]!, {r3, r4, r5, r6}\n\t" \
+                      : [dst] "+r" (d), [src] "+r" (s) : : "r3", "r4", "r5", "r6", "memory")
+#else
+#define MEM_COPY_BLOCK(d, s)                                \
+    do { d[0] = s[0]; d[1] = s[1]; d[2] = s[2]; d[3] = s[3];  \
+         d[4] = s[4]; d[5] = s[5]; d[6] = s[6]; d[7] = s[7];  \
+         d += 8; s += 8; } while (0)
+#endif
+
+
+
+void *memcpy(void *dst, const void *src, size_t n)
+{
+    uint8_t *d = (uint8_t*) dst;
+    const uint8_t *s = (const uint8_t*) src;
+
+    if (n >= sizeof(uint32_t))
+    {
+        /* Align the destination, which is usually aligned already */
+        while ((uintptr_t) d & 3) {
+            *d++ = *s++;
+            --n;
+        }
+
+        mem_aligned_t *dw = (mem_aligned_t*) d;
+        if (0 == ((uintptr_t) s & 3)) {
+            const mem_aligned_t *sw = (const mem_aligned_t*) s;
+            for ( ; n >= 32; n -= 32) {
+                MEM_COPY_BLOCK(dw, sw);
+            }
+            for ( ; n >= sizeof(uint32_t); n -= sizeof(uint32_t)) {
+                *dw++ = *sw++;
+            }
+            s = (const uint8_t*) sw;
+        }
+        else {
+            for ( ; n >= sizeof(uint32_t); n -= sizeof(uint32_t), s += sizeof(uint32_t)) {
+                *dw++ = ((const mem_word_t*) s)->w;
+            }
+        }
+        d = (uint8_t*) dw;
+    }
+
+    while (n--) {
+        *d++ = *s++;
+    }
+    return dst;
+}
+
+void *memset(void *dst, int c, size_t n)
+{
+    uint8_t *d = (uint8_t*) dst;
+
+    if (n >= sizeof(uint32_t))
+    {
+        while ((uintptr_t) d & 3) {
+            *d++ = (uint8_t) c;
+            --n;
+        }
+
+        const uint32_t word = (uint8_t) c * UINT32_C(0x01010101);
+        mem_aligned_t *dw = (mem_aligned_t*) d;
+    #if defined(__ARM_ARCH_7M__)
+        register uint32_t w0 __asm__("r3") = word;
+        register uint32_t w1 __asm__("r4") = word;
+        register uint32_t w2 __asm__("r5") = word;
+        register uint32_t w3 __asm__("r6") = word;
+        for ( ; n >= 32; n -= 32) {
+            __asm__ volatile ("stmia %[dst]!, {r3, r4, r5, r6}\n\t"
+                              "stmia %[dst]!, {r3, r4, r5, r6}\n\t"
+                              : [dst] "+r" (dw) : "r" (w0), "r" (w1), "r" (w2), "r" (w3) : "memory");
+        }
+    #endif
+        for ( ; n >= sizeof(uint32_t); n -= sizeof(uint32_t)) {
+            *dw++ = word;
+        }
+        d = (uint8_t*) dw;
+    }
+
+    while (n--) {
+        *d++ = (uint8_t) c;
+    }
+    return dst;
+}
+
+int memcmp(const void *a, const void *b, size_t n)
+{
+    const uint8_t *p = (const uint8_t*) a;
+    const uint8_t *q = (const uint8_t*) b;
+
+    /* Skip the equal words, and then find the first different byte */
+    for ( ; n >= sizeof(uint32_t); n -= sizeof(uint32_t), p += sizeof(uint32_t), q += sizeof(uint32_t)) {
+        if (((const mem_word_t*) p)->w != ((const mem_word_t*) q)->w) {
+            break;
+        }
+    }
+
+    for ( ; n > 0; --n, ++p, ++q) {
+        if (*p != *q) {
+            return (int) *p - (int) *q;
+        }
+    }
+    return 0;
+}
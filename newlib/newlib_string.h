@@ -0,0 +1,72 @@
+/*
+ *     SocialLedge.com - Copyright (C) 2013
+ *
+ *     This file is part of free software framework for embedded processors.
+ *     You can use it and/or distribute it as long as this copyright header
+ *     remains unmodified.  The code is free for personal use and requires
+ *     permission to use in a commercial product.
+ *
+ *      THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+ *      OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ *      MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+ *      I SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR
+ *      CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ *     You can reach the author of this software at :
+ *          p r e e t . w i k i @ g m a i l . c o m
+ */
+
+/**
+ * @file
+ * @brief This file provides the inline copies of the small fixed-size blocks, such as the 8 byte CAN data
+ *        or the 16 byte can_msg_t.  The memcpy(), memset() and memcmp() of the C library are replaced by
+ *        the Cortex-M3 versions of newlib_string.c, which copy the aligned blocks using LDM and STM.
+ */
+#ifndef NEWLIB_STRING_H__
+#define NEWLIB_STRING_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+
+
+/// The word type of the copies, which may be unaligned (Cortex-M3 LDR and STR support it) and may alias any type
+typedef struct { uint32_t w; } __attribute__((packed, may_alias)) mem_word_t;
+
+/**
+ * Copies the memory like memcpy(), but the copy of 8, 16 or 32 bytes is inline using word loads and stores.
+ * The size should be a constant, such as sizeof(), in which case the other sizes are just a call to memcpy().
+ * @note The memory of the source and the destination must not overlap.
+ */
+static inline __attribute__((always_inline)) void *mem_copy(void *dst, const void *src, const size_t n)
+{
+    mem_word_t *d = (mem_word_t*) dst;
+    const mem_word_t *s = (const mem_word_t*) src;
+
+    if (8 == n || 16 == n || 32 == n) {
+        /* Loads before stores, so the compiler can use LDM and STM when the pointers are aligned */
+        const uint32_t w0 = s[0].w, w1 = s[1].w;
+        if (n >= 16) {
+            const uint32_t w2 = s[2].w, w3 = s[3].w;
+            if (32 == n) {
+                const uint32_t w4 = s[4].w, w5 = s[5].w, w6 = s[6].w, w7 = s[7].w;
+                d[4].w = w4; d[5].w = w5; d[6].w = w6; d[7].w = w7;
+            }
+            d[2].w = w2; d[3].w = w3;
+        }
+        d[0].w = w0; d[1].w = w1;
+        return dst;
+    }
+
+    return memcpy(dst, src, n);
+}
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* NEWLIB_STRING_H__ */
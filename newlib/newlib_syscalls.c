@@ -68,6 +68,171 @@ void sys_set_inchar_func(char_func_t func)
     g_input_dev_fptr = func;
 }
 
+
+
+/// The buffered output state of stdout or stderr
+typedef struct {
+    sys_out_policy_t policy;    ///< The policy when the output is full
+    unsigned int timeout_ms;    ///< The timeout of the sys_out_wait policy
+    sys_out_stats_t stats;      ///< The counters of this stream
+} sys_out_stream_t;
+
+/// The incomplete line of a task, which is written out as one block when it is complete
+typedef struct {
+    TaskHandle_t owner;         ///< The task that owns this buffer, or NULL if the buffer is free
+    sys_out_stream_t *stream;   ///< The stream the line belongs to
+    uint16_t len;               ///< The length of the line
+    char line[SYS_CFG_STDOUT_LINE_SIZE];
+} sys_out_line_t;
+
+static block_func_t g_output_block_fptr = 0; ///< Function pointer for block output function
+static sys_out_stream_t g_out_streams[2] = {
+    { sys_out_wait,  SYS_CFG_STDOUT_TIMEOUT_MS, { 0 } },  ///< stdout
+    { sys_out_block, SYS_CFG_STDOUT_TIMEOUT_MS, { 0 } },  ///< stderr
+};
+static sys_out_line_t g_out_lines[SYS_CFG_STDOUT_LINE_BUFFERS];
+
+/// @returns the stream of stderr for STDERR_FILENO, or the stream of stdout otherwise
+static sys_out_stream_t* sys_out_get_stream(int fd)
+{
+    return &g_out_streams[(STDERR_FILENO == fd) ? 1 : 0];
+}
+
+/// Writes a block to the output function according to the policy of the stream
+static void sys_out_send(sys_out_stream_t *stream, const char *ptr, int len)
+{
+    int sent = 0;
+
+    if (len > 0) {
+        switch (stream->policy) {
+            case sys_out_drop:  sent = g_output_block_fptr(ptr, len, 0);                  break;
+            case sys_out_block: sent = g_output_block_fptr(ptr, len, portMAX_DELAY);      break;
+            default:            sent = g_output_block_fptr(ptr, len, stream->timeout_ms); break;
+        }
+        if (sent < 0) {
+            sent = 0;
+        }
+        stream->stats.bytes_written += sent;
+        stream->stats.bytes_dropped += (len - sent);
+    }
+}
+
+/// @returns the line buffer of the calling task for the stream, or a free one, or NULL if all are in use
+static sys_out_line_t* sys_out_get_line(sys_out_stream_t *stream, bool claim)
+{
+    const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    sys_out_line_t *line = NULL;
+    int i = 0;
+
+    /* Only the owner of a line buffer writes to it, so a critical section is only needed to claim one */
+    for (i = 0; i < SYS_CFG_STDOUT_LINE_BUFFERS; i++) {
+        if (task == g_out_lines[i].owner && stream == g_out_lines[i].stream) {
+            return &g_out_lines[i];
+        }
+    }
+
+    if (claim) {
+        taskENTER_CRITICAL();
+        for (i = 0; i < SYS_CFG_STDOUT_LINE_BUFFERS; i++) {
+            if (NULL == g_out_lines[i].owner) {
+                line = &g_out_lines[i];
+                line->owner = task;
+                line->stream = stream;
+                line->len = 0;
+                break;
+            }
+        }
+        taskEXIT_CRITICAL();
+    }
+
+    return line;
+}
+
+/// Writes out the line, and frees the line buffer
+static void sys_out_flush_line(sys_out_line_t *line)
+{
+    sys_out_send(line->stream, line->line, line->len);
+    line->len = 0;
+    line->stream = NULL;
+    line->owner = NULL;
+}
+
+/// @returns true if the output of the caller is written through the block output function
+static bool sys_out_is_buffered(void)
+{
+    const bool in_isr = !!(SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk);
+    return (g_output_block_fptr && !in_isr && taskSCHEDULER_RUNNING == xTaskGetSchedulerState());
+}
+
+/**
+ * Writes the output of a task.  Complete lines are written as blocks, and the incomplete line at the
+ * end is kept in the line buffer of the task until the rest of the line is written.
+ */
+static void sys_out_write(int fd, const char *ptr, int len)
+{
+    sys_out_stream_t *stream = sys_out_get_stream(fd);
+    sys_out_line_t *line = sys_out_get_line(stream, false);
+
+    while (len > 0)
+    {
+        if (!line) {
+            /* Write the complete lines without copying them, and buffer the incomplete line at the end */
+            int complete = len;
+            while (complete > 0 && '\n' != ptr[complete - 1]) {
+                complete--;
+            }
+            sys_out_send(stream, ptr, complete);
+            ptr += complete;
+            len -= complete;
+
+            if (len > 0 && !(line = sys_out_get_line(stream, true))) {
+                stream->stats.unbuffered++;
+                sys_out_send(stream, ptr, len);
+                break;
+            }
+            continue;
+        }
+
+        /* Copy to the line buffer until the line is complete or the buffer is full */
+        line->line[line->len] = *ptr++;
+        len--;
+        if ('\n' == line->line[line->len++] || line->len >= sizeof(line->line)) {
+            sys_out_flush_line(line);
+            line = NULL;
+        }
+    }
+}
+
+void sys_set_outblock_func(block_func_t func)
+{
+    g_output_block_fptr = func;
+}
+
+void sys_set_out_policy(int fd, sys_out_policy_t policy, unsigned int timeout_ms)
+{
+    sys_out_stream_t *stream = sys_out_get_stream(fd);
+    stream->policy = policy;
+    stream->timeout_ms = timeout_ms;
+}
+
+sys_out_stats_t sys_get_out_stats(int fd)
+{
+    return sys_out_get_stream(fd)->stats;
+}
+
+void sys_out_flush(void)
+{
+    unsigned int i = 0;
+    if (sys_out_is_buffered()) {
+        for (i = 0; i < sizeof(g_out_streams) / sizeof(g_out_streams[0]); i++) {
+            sys_out_line_t *line = sys_out_get_line(&g_out_streams[i], false);
+            if (line) {
+                sys_out_flush_line(line);
+            }
+        }
+    }
+}
+
 int _kill(int pid __attribute__ ((unused)), int sig __attribute__ ((unused)))
 {
     puts("Unexpected call to kill()");
@@ -88,7 +253,11 @@ int _init(void) {   return 1;   }
 int _write(int fd, const char *ptr, int len)
 {
     int i = 0;
-    if (g_output_dev_fptr)
+    if (sys_out_is_buffered())
+    {
+        sys_out_write(fd, ptr, len);
+    }
+    else if (g_output_dev_fptr)
     {
         for (i = 0; i < len; i++)
         {
@@ -100,6 +269,7 @@ int _write(int fd, const char *ptr, int len)
 int _read(int fd, char *ptr, int len)
 {
     int i = 0;
+    sys_out_flush();
     if (g_input_dev_fptr)
     {
         for (i = 0; i < len; i++)
@@ -391,6 +561,7 @@ int _read(int fd, char *ptr, int len)
     {
         case MONITOR_STDIN:
         {
+            sys_out_flush();
             if (g_input_dev_fptr)
             {
                 for (i = 0; i < len; i++)
@@ -503,7 +674,12 @@ int _write(int fd, const char *ptr, int len)
         case MONITOR_STDOUT:
         case MONITOR_STDERR:
         {
-            if (g_output_dev_fptr)
+            if (sys_out_is_buffered())
+            {
+                sys_out_write((MONITOR_STDERR == fh) ? STDERR_FILENO : STDOUT_FILENO, ptr, len);
+                i = len;
+            }
+            else if (g_output_dev_fptr)
             {
                 for (i = 0; i < len; i++)
                 {
@@ -42,14 +42,47 @@ extern "C" {
 #define WIRELESS_AIR_DATARATE_KBPS      2000   ///< Air data rate, can only be 250, 1000, or 2000 kbps
 #define WIRELESS_NODE_NAME             "node"  ///< Wireless node name (ping response contains this name)
 #define WIRELESS_RX_QUEUE_SIZE          3      ///< Number of payloads we can queue
+#define WIRELESS_PKT_POOL_SIZE          8      ///< Received packet buffers shared by the RX queue and the application
+#define WIRELESS_RADIO_RX_BYTES         256    ///< Bytes of the frames the radio task can queue for wireless_service() (power of two)
+#define WIRELESS_SERVICE_BUDGET_MS      4      ///< wireless_service() yields the CPU after handling the frames for this long
 #define WIRELESS_NODE_ADDR_FILE         "naddr"///< Node address can be read from this file and this can override WIRELESS_NODE_ADDR
+#define WIRELESS_BATCH_WINDOW_MS        5      ///< wireless_send_batched() messages to a node within this time share one packet
+#define WIRELESS_BATCH_SLOTS            4      ///< Number of destinations that can have a batch open at a time
+#define WIRELESS_BULK_WINDOW            16     ///< Packets in flight of wireless_bulk_send() (1-32)
+#define WIRELESS_BULK_RX_BUFFER         1024   ///< Bytes buffered for wireless_bulk_recv() (power of 2)
+#define WIRELESS_MCAST_MAX_BYTES        (224 * 1024) ///< Largest file of wireless_mcast_send(), its bitmap uses 1 bit per 19 bytes
+#define WIRELESS_MCAST_POLL_MS          200    ///< Time the multicast sender waits for the missing blocks after each poll
+#define WIRELESS_HW_ACK                 1      ///< ACK packets to a direct neighbor use the radio's hardware ACK
+#define WIRELESS_DYN_PAYLOAD            1      ///< Packets are only as long as their data (radio's dynamic payload), same at every node
+#define WIRELESS_LINK_RATE              0      ///< Hardware ACK packets to a neighbor use a faster air data rate if the link allows it
+#define WIRELESS_TX_BURST_SIZE          3      ///< Packets sent back to back by wireless_tx_burst_end() (receiver has 3-level RX FIFO)
+#define WIRELESS_CCA_TRIES              3      ///< Random backoffs while the channel is busy before we send anyway, 0 to disable
+#define WIRELESS_CHANNEL_HOPPING        0      ///< All nodes move to a better channel of WIRELESS_HOP_CHANNELS if the channel is bad
+#define WIRELESS_HOP_CHANNELS           { WIRELESS_CHANNEL_NUM, 2490, 2480, 2475 } ///< First must be WIRELESS_CHANNEL_NUM (Wi-Fi is up to 2472 MHz)
+#define WIRELESS_HOP_BAD_PERCENT        30     ///< Percentage of busy or lost transmissions of a bad channel
+#define WIRELESS_TIME_BEACON_MS         1000   ///< Period of the time beacons of the network time
+#define WIRELESS_TIME_MAX_STRATUM       2      ///< Nodes this many hops from the time master do not relay the time
+#define WIRELESS_CAN_BATCH_MS           10     ///< CAN frames of the gateway to a node within this time share one packet
+#define WIRELESS_CAN_MAX_ROUTES         8      ///< Routes of the CAN gateway, @see wireless_can.h
+#define WIRELESS_LPL                    0      ///< Nodes of a class with an interval power down their radio between wake-ups, same at every node
+#define WIRELESS_LPL_CLASS              0      ///< Our class of WIRELESS_LPL_INTERVALS_MS, 0 is always on such as the routers
+#define WIRELESS_LPL_INTERVALS_MS       { 0, 100, 1000 } ///< Wake-up interval of each class, which is the latency of a hop to the node (each a multiple of the previous)
 /** @} */
 
 
 
 #define TERMINAL_USE_NRF_WIRELESS       0             ///< Terminal command can be sent through nordic wireless
+#define TERMINAL_NRF_STREAM_WINDOW      1            ///< Payloads in flight of the nordic terminal (1 - NRF_STREAM_WINDOW_MAX), same at every node
+#define TERMINAL_NRF_STREAM_IDLE_MS     20           ///< Nordic terminal output is sent once idle for this time, 0 to only send full payloads
+#define TERMINAL_NRF_STREAM_NEWLINE     0            ///< Nordic terminal output is sent after each newline
+#define TERMINAL_USE_WIFI_MUX           0             ///< Terminal command can be sent through the wifiTask gateway, see WIFI_MUX_ENABLE
 #define TERMINAL_END_CHARS              {3, 3, 4, 4}  ///< The last characters sent after processing a terminal command
+#define TERMINAL_STR_ARENA_BYTES        512           ///< Memory for temporary str objects of a terminal command, 0 to disable
+#define TERMINAL_MAX_JOBS               2             ///< Commands that can run in the background ('cmd &'), 0 to disable
+#define TERMINAL_JOB_OUT_BYTES          512           ///< The output buffer of each background command
 #define TERMINAL_USE_CAN_BUS_HANDLER    0             ///< CAN bus terminal command
+#define TERMINAL_CAN_ISOTP_DATA_ID      0x7E0         ///< CAN ID of the ISO-TP file data of 'canbus sendfile' to 'file can'
+#define TERMINAL_CAN_ISOTP_FC_ID        0x7E8         ///< CAN ID of the ISO-TP flow control of the file receiver
 
 
 
@@ -61,11 +94,15 @@ extern "C" {
 //#define SYS_CFG_LOG_BOOT_INFO_FILENAME        "boot.csv"
 
 #define SYS_CFG_STARTUP_DELAY_MS        2000        ///< Start-up delay in milliseconds
-#define SYS_CFG_CRASH_STARTUP_DELAY_MS  5000        ///< Start-up delay in milliseconds if a crash occurred previously.
+#define SYS_CFG_BOOT_TASKS              0           ///< If non-zero, the boot stages that do not block the OS run in this many tasks (@see high_level_init.cpp)
 #define SYS_CFG_INITIALIZE_LOGGER       1           ///< If non-zero, the logger is initialized (@see file_logger.h)
 #define SYS_CFG_LOGGER_TASK_PRIORITY    1           ///< The priority of the logger task (do not use 0, logger will run into issues while writing the file)
+#define SYS_CFG_LOG_MIN_LEVEL           0           ///< Minimum severity of the LOG macros that are compiled in: 0=debug, 1=info, 2=warn, 3=error, 4=none
+#define SYS_CFG_DISK_IO_TASK_PRIORITY   3           ///< If non-zero, disk requests are queued to the disk I/O task at this priority (@see disk_async.h)
 #define SYS_CFG_ENABLE_TLM              0           ///< Enable telemetry system. C_FILE_IO forced enabled if enabled
 #define SYS_CFG_DISK_TLM_NAME           "disk"      ///< Filename to save "disk" telemetry variables
+#define SYS_CFG_DISK_TLM_JOURNAL_BYTES  (4 * 1024)  ///< The changes appended to the "disk" telemetry file are compacted to one snapshot past this size
+#define SYS_CFG_DISK_TLM_MIN_SAVE_MS    (5 * 60 * 1000) ///< Minimum time between two saves of the changed "disk" telemetry
 #define SYS_CFG_DEBUG_TLM_NAME          "debug"     ///< Name of the debug telemetry component
 #define SYS_CFG_ENABLE_CFILE_IO         0           ///< Allow stdio fopen() fclose() to redirect to ff.h
 #define SYS_CFG_MAX_FILES_OPENED        3           ///< Maximum files that can be opened at once
@@ -77,10 +114,23 @@ extern "C" {
  * lpc_sys_get_uptime_ms(), lpc_sys_get_uptime_us() and periodically resets the watchdog timer
  * along with running the mesh networking task if FreeRTOS is running.
  *
- * Timer 1 is required if you wish to have an operational IR remote control decoding.
+ * The IR receiver is tied to the capture pin of Timer 1, so if another timer is used, the IR sensor
+ * runs Timer 1 by itself (unless it is SYS_CFG_STEPPER_TIMER).
  */
 #define SYS_CFG_SYS_TIMER               1
 
+/// The timer that generates the step pulses of the stepper engine (@see stepper.h)
+#define SYS_CFG_STEPPER_TIMER           2
+
+/// The timer of the microsecond timer service (@see hw_timer.h), which also debounces the port pin interrupts
+#define SYS_CFG_HW_TIMER                3
+
+/**
+ * The timer whose match output triggers the conversions of adc0_timed_start() (@see adc0.h).
+ * The ADC can only be triggered by MAT0.1 of Timer 0 or MAT1.0 of Timer 1, so this must be 0 or 1.
+ */
+#define SYS_CFG_ADC_TIMER               0
+
 /**
  * Watchdog timeout in milliseconds
  * Value cannot be greater than 1,000,000 which is too large of a value
@@ -88,6 +138,57 @@ extern "C" {
  */
 #define SYS_CFG_WATCHDOG_TIMEOUT_MS     (3 * 1000)
 
+/**
+ * If non-zero, FreeRTOS stops its tick interrupt while all tasks are blocked and the CPU
+ * sleeps until the next task timeout or an interrupt.  This saves power on boards that
+ * mostly wait for wireless packets.  @see configUSE_TICKLESS_IDLE
+ */
+#define SYS_CFG_TICKLESS_IDLE           1
+
+/**
+ * The number of 8-byte records of the OS trace recorder, which records the task switches, interrupts
+ * and queue operations to be summarised or dumped by the 'trace' command.  @see os_trace.h
+ * Set to 0 to remove the recorder and its hooks.
+ */
+#define SYS_CFG_TRACE_RECORDS           512
+
+/**
+ * The number of code sites whose longest time with the interrupts masked is recorded, such as the
+ * callers of taskENTER_CRITICAL() and of the FromISR API.  The 'health' command prints the sites
+ * that masked the interrupts the longest.  @see os_latency.h
+ * Set to 0 to remove the timing of the critical sections.  Only the non-MPU port is timed.
+ */
+#define SYS_CFG_LATENCY_SITES           16
+
+/**
+ * If non-zero, the RIT interrupts every 10 milliseconds to measure the interrupt entry latency, which is
+ * printed by the 'health' command.  Set to 0 to free the RIT for rit_enable().
+ */
+#define SYS_CFG_LATENCY_PROBE           1
+
+/**
+ * If non-zero, the shared locks count their acquisitions, contentions, wait and hold times, such as
+ * spi1_lock(), the ADC and I2C mutexes, and the malloc() lock.  The 'health' command prints the locks
+ * that waited the longest.  @see os_lock_stats.h
+ */
+#define SYS_CFG_LOCK_STATS              1
+
+/**
+ * If non-zero, the malloc() lock suspends the scheduler instead of masking the interrupts, so the
+ * interrupts are not delayed by the allocations of the tasks, but an ISR must not use malloc().
+ * @see mem_arena.h for the allocators of the hot paths that need no lock
+ */
+#define SYS_CFG_MALLOC_LOCK_SCHEDULER   1
+
+/**
+ * If non-zero, an MPU region makes the bottom 32 bytes of the stack of the running task read-only,
+ * so a task that overflows its stack faults right away, and its name is reported by the stack
+ * overflow hook.  The region is moved at each context switch, and replaces the stack pattern
+ * check of configCHECK_FOR_STACK_OVERFLOW.  Each task loses up to 64 bytes of its stack to the guard.
+ * Use 'info stacks' to see how much stack each task has left.
+ */
+#define SYS_CFG_STACK_GUARD             1
+
 /**
  * @returns actual System clock as calculated from PLL and Oscillator selection
  * @note The SYS_CFG_DESIRED_CPU_CLK macro defines "Desired" CPU clock, and doesn't guarantee
@@ -107,18 +208,21 @@ unsigned int sys_get_cpu_clock();
  * RTC PLL setting may delay your startup time so be patient.
  * 36864000 (36.864Mhz) is a good frequency to derive from RTC PLL since it
  * offers a perfect UART divider.
+ *
+ * If the external crystal does not start, the internal oscillator is used instead.
+ * Use sys_clock_set_cpu_scale() to lower the CPU clock at runtime.
  */
 #define CLOCK_SOURCE_INTERNAL   0                       ///< Just a constant, do not change
 #define CLOCK_SOURCE_EXTERNAL   1                       ///< Just a constant, do not change
 #define CLOCK_SOURCE_RTC        2                       ///< Just a constant, do not change
-#define SYS_CFG_CLOCK_SOURCE    CLOCK_SOURCE_INTERNAL   ///< Select the clock source from above
+#define SYS_CFG_CLOCK_SOURCE    CLOCK_SOURCE_EXTERNAL   ///< Select the clock source from above
 /** @} */
 
 #define INTERNAL_CLOCK		    (4  * 1000 * 1000UL)    ///< Do not change, this is the same on all LPC17XX
 #define EXTERNAL_CLOCK          (12 * 1000 * 1000UL)    ///< Change according to your board specification
 #define RTC_CLOCK               (32768UL)               ///< Do not change, this is the typical RTC crystal value
 
-#define SYS_CFG_DESIRED_CPU_CLK	(48 * 1000 * 1000UL)    ///< Define the CPU speed you desire, must be between 1-100Mhz
+#define SYS_CFG_DESIRED_CPU_CLK	(100 * 1000 * 1000UL)   ///< Define the CPU speed you desire, must be between 1-100Mhz
 #define SYS_CFG_DEFAULT_CPU_CLK (24 * 1000 * 1000UL)    ///< Do not change.  This is the fall-back CPU speed if SYS_CFG_DESIRED_CPU_CLK cannot be attained
 
 
@@ -133,6 +237,19 @@ unsigned int sys_get_cpu_clock();
 #define SYS_CFG_REDUCED_PRINTF      0     ///< If non-zero, floating-point printf() and scanf() is not supported
 #define SYS_CFG_UART0_BPS           38400 ///< UART0 is configured at this BPS by start-up code - before main()
 #define SYS_CFG_UART0_TXQ_SIZE      256   ///< UART0 transmit queue size before blocking starts to occur
+#define SYS_CFG_UART0_RXQ_SIZE      128   ///< UART0 receive queue size, which limits the pipelined command frames
+/** @} */
+
+/**
+ * @{ Buffered output of printf() from the tasks (@see sys_set_out_policy())
+ * Each task collects its output into a line buffer, and complete lines are written as one block,
+ * so the lines of different tasks do not mix.  If all line buffers are in use, the output is
+ * written without buffering.  The default policy of stdout waits up to SYS_CFG_STDOUT_TIMEOUT_MS
+ * for space in the UART0 transmit queue and then drops the rest, and stderr never drops its output.
+ */
+#define SYS_CFG_STDOUT_LINE_BUFFERS 4     ///< The number of tasks that can have an incomplete line at once
+#define SYS_CFG_STDOUT_LINE_SIZE    128   ///< The size of each line buffer
+#define SYS_CFG_STDOUT_TIMEOUT_MS   10    ///< The default timeout of stdout output
 /** @} */
 
 